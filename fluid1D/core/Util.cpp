@@ -258,6 +258,8 @@ namespace Citations
 	//If getCitationList is non-null, retrieve the list
 	void manage(std::pair<string,string>* addCitation=0, std::list<std::pair<string,string>>* getCitationList=0)
 	{	static std::list<std::pair<string,string>> citationList; //pair.first = paper, pair.second = reason
+		static std::mutex m; //fluids may be constructed concurrently (see solveBatch)
+		std::lock_guard<std::mutex> lock(m);
 		if(addCitation)
 		{	auto iter=citationList.begin();
 			bool foundPrev = false, duplicate = false;
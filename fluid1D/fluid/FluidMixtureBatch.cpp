@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of Fluid1D.
+
+Fluid1D is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fluid1D is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fluid1D.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#include <fluid/FluidMixtureBatch.h>
+#include <core/Thread.h>
+
+//Shared job queue of solveBatch:
+struct FluidBatchQueue
+{	const GridInfo& gInfo;
+	const std::vector<FluidStatePoint>& points;
+	const FluidStateSolver& solve;
+	const MinimizeParams& mp;
+	std::vector<double> results;
+	size_t iNext; //next point to be solved
+	std::mutex m; //protects iNext and writes to globalLog
+	
+	FluidBatchQueue(const GridInfo& gInfo, const std::vector<FluidStatePoint>& points, const FluidStateSolver& solve, const MinimizeParams& mp)
+	: gInfo(gInfo), points(points), solve(solve), mp(mp), results(points.size()), iNext(0) {}
+	
+	//Solve points from the queue till it is empty (run by each thread)
+	void process()
+	{	while(true)
+		{	m.lock();
+			size_t iPoint = iNext++;
+			m.unlock();
+			if(iPoint >= points.size()) break;
+			const FluidStatePoint& point = points[iPoint];
+			//Buffer minimizer log of this point:
+			char* logBuf = 0; size_t logLen = 0;
+			FILE* fpLog = open_memstream(&logBuf, &logLen);
+			if(!fpLog) die("Could not create log buffer for state point %lu.\n", iPoint);
+			MinimizeParams mpPoint = mp;
+			mpPoint.fpLog = fpLog;
+			double startTime = clock_us();
+			results[iPoint] = solve(gInfo, point, mpPoint);
+			fclose(fpLog);
+			//Write the log:
+			m.lock();
+			logPrintf("\n---- State point %lu of %lu: T = %lg K, P = %lg bar ----\n",
+				iPoint+1, points.size(), point.T/Kelvin, point.P/Bar);
+			fwrite(logBuf, 1, logLen, globalLog);
+			logPrintf("---- Result: %.15lg (%.2lf s) ----\n", results[iPoint], 1e-6*(clock_us()-startTime));
+			logFlush();
+			m.unlock();
+			free(logBuf);
+		}
+	}
+	
+	static void thread(int iThread, int nThreads, FluidBatchQueue* queue)
+	{	queue->process();
+	}
+};
+
+std::vector<double> solveBatch(const GridInfo& gInfo, const std::vector<FluidStatePoint>& points,
+	const FluidStateSolver& solve, const MinimizeParams& mp, int nConcurrent)
+{	if(nConcurrent <= 0) nConcurrent = nProcsAvailable;
+	nConcurrent = std::max(1, std::min(nConcurrent, int(points.size())));
+	logPrintf("Solving %lu state points with %d concurrent threads.\n", points.size(), nConcurrent); logFlush();
+	FluidBatchQueue queue(gInfo, points, solve, mp);
+	if(nConcurrent > 1) suspendOperatorThreading();
+	threadLaunch(nConcurrent, FluidBatchQueue::thread, 0, &queue);
+	if(nConcurrent > 1) resumeOperatorThreading();
+	return queue.results;
+}
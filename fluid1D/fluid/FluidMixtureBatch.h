@@ -0,0 +1,56 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of Fluid1D.
+
+Fluid1D is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fluid1D is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fluid1D.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#ifndef FLUID1D_FLUID1D_FLUIDMIXTUREBATCH_H
+#define FLUID1D_FLUID1D_FLUIDMIXTUREBATCH_H
+
+//! @file FluidMixtureBatch.h
+//! Concurrent solution of many state points of a fluid on a shared grid (eg. for functional fits)
+
+#include <core/GridInfo.h>
+#include <core/MinimizeParams.h>
+#include <core/Units.h>
+#include <functional>
+#include <vector>
+
+//! One state point of a parameter sweep
+struct FluidStatePoint
+{	double T; //!< temperature
+	double P; //!< pressure (interpretation up to the solver, eg. 0 for the boiling pressure at T)
+	std::vector<double> x; //!< composition (eg. mole fractions of the components)
+	std::vector<double> params; //!< any other parameters (eg. strength and range of a wall potential)
+	
+	FluidStatePoint(double T=298*Kelvin, double P=0., std::vector<double> x=std::vector<double>(), std::vector<double> params=std::vector<double>())
+	: T(T), P(P), x(x), params(params) {}
+};
+
+//! Solve one state point: construct the fluid mixture on gInfo for point, minimize it using mp
+//! (whose fpLog and linePrefix are set up per state point) and return the quantity of interest.
+//! Objects that are const after construction (GridInfo, SO3quad, TranslationOperator) may be shared by all the points.
+typedef std::function<double(const GridInfo& gInfo, const FluidStatePoint& point, MinimizeParams& mp)> FluidStateSolver;
+
+//! Solve all points using nConcurrent threads (0 => nProcsAvailable) that each pick up the next unsolved point.
+//! Operators within the solves run single-threaded while more than one point is solved at a time.
+//! The minimizer log of each point is buffered and written to globalLog in one piece once that point completes.
+//! @return result of solve for each point, in the same order as points
+std::vector<double> solveBatch(const GridInfo& gInfo, const std::vector<FluidStatePoint>& points,
+	const FluidStateSolver& solve, const MinimizeParams& mp, int nConcurrent=0);
+
+#endif // FLUID1D_FLUID1D_FLUIDMIXTUREBATCH_H
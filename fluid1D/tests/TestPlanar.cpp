@@ -25,6 +25,7 @@ along with Fluid1D.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/Fex_H2O_FittedCorrelations.h>
 #include <fluid/Fex_H2O_ScalarEOS.h>
 #include <fluid/Fex_H2O_BondedVoids.h>
+#include <fluid/FluidMixtureBatch.h>
 
 //#define TDEP
 #define ChosenFex ScalarEOS
@@ -40,18 +41,9 @@ string fexName = FEX_NAME(ChosenFex);
 
 
 //Return planar liquid-vapor surface energy (and optionally plot density profiles)
-double testPlanar(double T, double sigmaTarget=0., bool plotDensities=false)
+double testPlanar(const GridInfo& gInfo, const SO3quad& quad, const TranslationOperator& trans,
+	double T, MinimizeParams mp, double sigmaTarget=0., bool plotDensities=false)
 {
-	//Setup simulation grid:
-	GridInfo gInfo(GridInfo::Planar, 768, 0.125);
-	
-	//----- Setup quadrature for angular integration -----
-	const int Zn = 2; //Water molecule has Z2 symmetry about dipole axis
-	SO3quad quad(QuadEuler, Zn, 20, 1); //Force nAlpha = 1
-
-	//----- Translation operator -----
-	TranslationOperatorLspline trans(gInfo);
-	
 	FluidMixture fluidMixture(gInfo, T);
 
 	//----- Excess functional -----
@@ -73,14 +65,7 @@ double testPlanar(double T, double sigmaTarget=0., bool plotDensities=false)
 	for(int i=0; i<gInfo.S; i++) //no potential, only initial state difference:
 		psiOdata[i] = gInfo.r[i]<rWall ? psiVap : 0.;
 	
-	//----- FDtest and CG parameters -----
-	MinimizeParams mp;
-	mp.alphaTstart = 3e4;
 	mp.nDim = gInfo.S * fluidMixture.get_nIndep();
-	mp.energyLabel = "sigma";
-	mp.nIterations = 100;
-	mp.energyDiffThreshold=1e-11;
-	
 	fluidMixture.minimize(mp);
 		
 	ScalarFieldCollection N;
@@ -105,18 +90,43 @@ double testPlanar(double T, double sigmaTarget=0., bool plotDensities=false)
 
 int main(int argc, char** argv)
 {	initSystem(argc, argv);
+	
+	//Setup simulation grid:
+	GridInfo gInfo(GridInfo::Planar, 768, 0.125);
+	
+	//----- Setup quadrature for angular integration -----
+	const int Zn = 2; //Water molecule has Z2 symmetry about dipole axis
+	SO3quad quad(QuadEuler, Zn, 20, 1); //Force nAlpha = 1
+
+	//----- Translation operator -----
+	TranslationOperatorLspline trans(gInfo);
+	
+	//----- FDtest and CG parameters -----
+	MinimizeParams mp;
+	mp.alphaTstart = 3e4;
+	mp.energyLabel = "sigma";
+	mp.nIterations = 100;
+	mp.energyDiffThreshold=1e-11;
 
 	#ifdef TDEP
-		FILE* fp = fopen((fexName+"/sigmavsT").c_str(), "w");
+		//Solve all temperatures concurrently, sharing the grid, quadrature and translation operator:
+		std::vector<FluidStatePoint> points;
 		for(double Tcel=0.0; Tcel<105.0; Tcel+=10.0)
-		{	double T = (Tcel+273.16)*Kelvin;
-			double sigmaSI = testPlanar(T) / (1e-3*Newton/meter);
+			points.push_back(FluidStatePoint((Tcel+273.16)*Kelvin));
+		std::vector<double> sigma = solveBatch(gInfo, points,
+			[&](const GridInfo& gInfo, const FluidStatePoint& point, MinimizeParams& mpPoint)
+			{	return testPlanar(gInfo, quad, trans, point.T, mpPoint);
+			}, mp);
+		FILE* fp = fopen((fexName+"/sigmavsT").c_str(), "w");
+		for(size_t i=0; i<points.size(); i++)
+		{	double Tcel = points[i].T/Kelvin - 273.16;
+			double sigmaSI = sigma[i] / (1e-3*Newton/meter);
 			logPrintf("\n------------ T = %lf C, sigma = %le mN/m ---------------\n\n", Tcel, sigmaSI);
 			fprintf(fp, "%lf %le\n", Tcel, sigmaSI);
 		}
 		fclose(fp);
 	#else
-		testPlanar(298*Kelvin, 71.98e-3 * Newton/meter, true);
+		testPlanar(gInfo, quad, trans, 298*Kelvin, mp, 71.98e-3 * Newton/meter, true);
 	#endif
 	return 0.;
 }
@@ -24,6 +24,17 @@ if(FFTW3_MPI_REQUIRED)
 	endif()
 endif()
 
+if(FFTW3_SINGLE_REQUIRED)
+	find_library(FFTW3F_LIBRARY NAMES fftw3f PATHS ${FFTW3_PATH} ${FFTW3_PATH}/lib ${FFTW3_PATH}/lib64 NO_DEFAULT_PATH)
+	find_library(FFTW3F_LIBRARY NAMES fftw3f)
+	find_library(FFTW3F_THREADS_LIBRARY NAMES fftw3f_threads PATHS ${FFTW3_PATH} ${FFTW3_PATH}/lib ${FFTW3_PATH}/lib64 NO_DEFAULT_PATH)
+	find_library(FFTW3F_THREADS_LIBRARY NAMES fftw3f_threads)
+	if(FFTW3_FIND_REQUIRED AND ((NOT FFTW3F_LIBRARY) OR (NOT FFTW3F_THREADS_LIBRARY)))
+		set(FFTW3_FOUND FALSE)
+		message(FATAL_ERROR "Could not find single-precision FFTW3 libraries fftw3f and fftw3f_threads (Add -D FFTW3_PATH=<path> to the cmake commandline for a non-standard installation)")
+	endif()
+endif()
+
 if(FFTW3_FOUND)
 	if(NOT FFTW3_FIND_QUIETLY)
 		message(STATUS "Found FFTW3: ${FFTW3_MPI_LIBRARY} ${FFTW3_THREADS_LIBRARY} ${FFTW3_LIBRARY}")
@@ -0,0 +1,291 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
+#include <electronic/SpeciesInfo.h>
+#include <electronic/ExCorr.h>
+#include <fluid/TranslationOperator.h>
+#include <fluid/FluidMixture.h>
+#include <fluid/IdealGas.h>
+#include <core/Units.h>
+#include <commands/parser.h>
+#include <core/Operators.h>
+#include <core/Random.h>
+#include <cstdarg>
+#include <ctime>
+#ifdef GPU_ENABLED
+#include <core/GpuUtil.h>
+#endif
+
+//Microbenchmarks of core kernels, with results written in the JSON layout of Google Benchmark
+//(so that its comparison tools can be used to track performance regressions between versions)
+
+inline void printUsageExit()
+{	logPrintf("\nUsage: Benchmarks [<outFile>] [<minTime>]\n\n");
+	logPrintf("Time core JDFTx kernels (FFTs, ColumnBundle operations, projectors,\n");
+	logPrintf("exchange-correlation, translations, diagonalization and a water classical-DFT\n");
+	logPrintf("evaluation, with its CPU-GPU data moves per evaluation) and write results\n");
+	logPrintf("in Google-Benchmark JSON format to <outFile> (default: benchmarks.json).\n");
+	logPrintf("  <minTime>: minimum total time in seconds per measurement (default: 0.2)\n\n");
+	exit(0);
+}
+
+inline void sync()
+{
+	#ifdef GPU_ENABLED
+	cudaDeviceSynchronize();
+	#endif
+}
+
+class BenchmarkSuite
+{
+	struct Result
+	{	std::string name;
+		long nIterations;
+		double tMean; //!< mean time per iteration in microseconds (over repetitions)
+		double tStd; //!< standard deviation of tMean over repetitions
+		std::vector<std::pair<string,double>> counters; //!< additional per-benchmark counters (Google Benchmark user counters)
+	};
+	std::vector<Result> results;
+	double tMin; //!< minimum total time per repetition in microseconds
+	static const int nRepetitions = 3;
+
+	//Time nIterations calls of func, in microseconds:
+	template<typename Func> static double timeLoop(const Func& func, long nIterations)
+	{	sync();
+		double t = clock_us();
+		for(long i=0; i<nIterations; i++) func();
+		sync();
+		return clock_us() - t;
+	}
+
+public:
+	BenchmarkSuite(double tMinSec) : tMin(tMinSec*1e6) {}
+
+	//! Run benchmark named nameFormat (printf-style) of func, which should perform one complete operation per call
+	template<typename Func> void run(const Func& func, const char* nameFormat, ...)
+	{	char name[256];
+		va_list args; va_start(args, nameFormat);
+		vsnprintf(name, sizeof(name), nameFormat, args);
+		va_end(args);
+		logPrintf("%-40s ", name); logFlush();
+		//Warm up and calibrate number of iterations:
+		func();
+		long nIterations = 1;
+		while(true)
+		{	double t = timeLoop(func, nIterations);
+			if(t >= tMin or nIterations >= (1L<<30)) break;
+			nIterations = std::min(1L<<30, long(ceil(nIterations * std::min(10., 1.4*tMin/std::max(t,1.)))));
+		}
+		//Repeat measurement:
+		double tSum = 0., tSqSum = 0.;
+		for(int iRep=0; iRep<nRepetitions; iRep++)
+		{	double t = timeLoop(func, nIterations) / nIterations;
+			tSum += t;
+			tSqSum += t*t;
+		}
+		Result result;
+		result.name = name;
+		result.nIterations = nIterations;
+		result.tMean = tSum / nRepetitions;
+		result.tStd = sqrt(std::max(0., tSqSum/nRepetitions - std::pow(result.tMean,2)));
+		results.push_back(result);
+		logPrintf("%12.3lf us  +/- %8.3lf us  (%ld iterations)\n", result.tMean, result.tStd, nIterations);
+		logFlush();
+	}
+
+	//! Attach a named counter to the most recent benchmark result
+	void addCounter(const char* name, double value)
+	{	assert(results.size());
+		results.back().counters.push_back(std::make_pair(string(name), value));
+	}
+
+	//! Write results in Google Benchmark JSON format
+	void write(FILE* fp, const char* executable) const
+	{	char dateStr[64];
+		time_t now = time(0);
+		strftime(dateStr, sizeof(dateStr), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+		fprintf(fp, "{\n  \"context\": {\n");
+		fprintf(fp, "    \"date\": \"%s\",\n", dateStr);
+		fprintf(fp, "    \"executable\": \"%s\",\n", executable);
+		fprintf(fp, "    \"num_cpus\": %d,\n", nProcsAvailable);
+		fprintf(fp, "    \"device\": \"%s\",\n", isGpuEnabled() ? "gpu" : "cpu");
+		#ifdef NDEBUG
+		fprintf(fp, "    \"library_build_type\": \"release\"\n");
+		#else
+		fprintf(fp, "    \"library_build_type\": \"debug\"\n");
+		#endif
+		fprintf(fp, "  },\n  \"benchmarks\": [\n");
+		for(size_t i=0; i<results.size(); i++)
+		{	const Result& r = results[i];
+			for(int iAgg=0; iAgg<2; iAgg++)
+			{	fprintf(fp, "    {\"name\": \"%s_%s\", \"run_name\": \"%s\", \"run_type\": \"aggregate\", \"aggregate_name\": \"%s\", "
+					"\"repetitions\": %d, \"iterations\": %ld, \"real_time\": %.6le, \"cpu_time\": %.6le, \"time_unit\": \"us\"",
+					r.name.c_str(), iAgg ? "stddev" : "mean", r.name.c_str(), iAgg ? "stddev" : "mean",
+					nRepetitions, r.nIterations, iAgg ? r.tStd : r.tMean, iAgg ? r.tStd : r.tMean);
+				for(const auto& counter: r.counters)
+					fprintf(fp, ", \"%s\": %.6le", counter.first.c_str(), iAgg ? 0. : counter.second);
+				fprintf(fp, "}%s\n", (i+1==results.size() && iAgg) ? "" : ",");
+			}
+		}
+		fprintf(fp, "  ]\n}\n");
+	}
+};
+
+//FFTs on cubic grids of various sizes:
+void benchmarkFFTs(BenchmarkSuite& bs)
+{	for(int S: {32, 48, 64, 96, 128})
+	{	GridInfo gInfo;
+		gInfo.S = vector3<int>(S, S, S);
+		gInfo.R = matrix3<>(1,1,1) * (0.2*S); //typical resolution
+		gInfo.initialize();
+		ScalarField r; nullToZero(r, gInfo); initRandom(r);
+		ScalarFieldTilde g = J(r);
+		bs.run([&](){ I(g); }, "I/%d", S);
+		bs.run([&](){ J(r); }, "J/%d", S);
+		bs.run([&](){ Idag(r); }, "Idag/%d", S);
+		bs.run([&](){ Jdag(g); }, "Jdag/%d", S);
+		//Translation operators:
+		TranslationOperatorSpline transLinear(gInfo, TranslationOperatorSpline::Linear);
+		ScalarField y; nullToZero(y, gInfo);
+		vector3<> t = gInfo.R * vector3<>(0.123, 0.456, 0.789);
+		bs.run([&](){ transLinear.taxpy(t, 1., r, y); }, "taxpy_linear/%d", S);
+	}
+}
+
+//Operations on wavefunctions, projectors and exchange-correlation in a small silicon system:
+void benchmarkSystem(BenchmarkSuite& bs)
+{	typedef std::pair<string,string> stringPair;
+	std::vector<stringPair> input;
+	input.push_back(stringPair("lattice", "Cubic 10.26"));
+	input.push_back(stringPair("ion-species", "GBRV/$ID_pbe.uspp"));
+	input.push_back(stringPair("elec-cutoff", "20"));
+	input.push_back(stringPair("elec-n-bands", "64"));
+	input.push_back(stringPair("kpoint-folding", "1 1 1"));
+	input.push_back(stringPair("cache-projectors", "no"));
+	input.push_back(stringPair("wavefunction", "random"));
+	input.push_back(stringPair("dump", "End None"));
+	const char* ionpos[8] = { "0.00 0.00 0.00", "0.00 0.50 0.50", "0.50 0.00 0.50", "0.50 0.50 0.00",
+		"0.25 0.25 0.25", "0.25 0.75 0.75", "0.75 0.25 0.75", "0.75 0.75 0.25" };
+	for(const char* pos: ionpos)
+		input.push_back(stringPair("ion", string("Si ") + pos + " 0"));
+	Everything e;
+	parse(input, e);
+	e.setup();
+	const GridInfo& gInfo = e.gInfo;
+	const ColumnBundle& C = e.eVars.C[0];
+	int nBands = C.nCols();
+	logPrintf("\nSystem benchmarks with nbasis = %lu, nBands = %d and grid ", C.colLength(), nBands);
+	gInfo.S.print(globalLog, " %d ");
+
+	//ColumnBundle operations:
+	ScalarFieldArray V(1); nullToZero(V, gInfo); initRandom(V[0]);
+	diagMatrix F(nBands, 1.);
+	bs.run([&](){ Idag_DiagV_I(C, V); }, "Idag_DiagV_I/%d", nBands);
+	bs.run([&](){ diagouterI(F, C, 1, &gInfo); }, "diagouterI/%d", nBands);
+	bs.run([&](){ C^C; }, "ColumnBundle_dot/%d", nBands);
+
+	//Projectors:
+	const SpeciesInfo& sp = *(e.iInfo.species[0]);
+	bs.run([&](){ sp.getV(C); }, "getV/%d", sp.nProjectors());
+	std::shared_ptr<ColumnBundle> Vnl = sp.getV(C);
+	bs.run([&](){ (*Vnl)^C; }, "getV_projection/%d", nBands);
+
+	//Exchange-correlation:
+	ScalarFieldArray n = diagouterI(F, C, 1, &gInfo);
+	ScalarFieldArray tau = e.eVars.KEdensity();
+	ScalarFieldArray Vxc, Vtau;
+	bs.run([&](){ e.exCorr(n, &Vxc); }, "ExCorr_GGA_PBE/%d", gInfo.S[0]);
+	ExCorr exCorrTPSS(ExCorrMGGA_TPSS);
+	exCorrTPSS.setup(e);
+	bs.run([&](){ exCorrTPSS(n, &Vxc, IncludeTXC(), &tau, &Vtau); }, "ExCorr_mGGA_TPSS/%d", gInfo.S[0]);
+}
+
+//Classical-DFT free energy and gradient of water, along with the number of CPU-GPU data moves per evaluation,
+//which should be zero on GPUs where the entire evaluation stays resident on the device:
+void benchmarkFluid(BenchmarkSuite& bs)
+{	GridInfo gInfo;
+	int S = 48;
+	gInfo.S = vector3<int>(S, S, S);
+	gInfo.R = matrix3<>(1,1,1) * (0.375*S); //typical fluid resolution
+	gInfo.initialize();
+	double T = 298*Kelvin;
+	for(FluidComponent::Functional functional: { FluidComponent::ScalarEOS, FluidComponent::FittedCorrelations })
+	{	const char* functionalName = (functional==FluidComponent::ScalarEOS) ? "ScalarEOS" : "FittedCorrelations";
+		FluidComponent component(FluidComponent::H2O, T, functional);
+		FluidMixture fluidMixture(gInfo, T);
+		component.addToFluidMixture(&fluidMixture);
+		fluidMixture.initialize(1.01325*Bar);
+		//Weak random external potential on the oxygen site:
+		nullToZero(component.idealGas->V, gInfo, fluidMixture.get_nDensities());
+		initRandom(component.idealGas->V[0], 3.);
+		component.idealGas->V[0] *= 1e-3;
+		fluidMixture.initState(0.05);
+		ScalarFieldArray grad;
+		bs.run([&](){ fluidMixture.compute(&grad, 0); }, "FluidMixture_H2O_%s/%d", functionalName, S);
+		//Count data moves over a few evaluations:
+		const int nEvals = 3;
+		ManagedMemoryBase::TransferStats stats0 = ManagedMemoryBase::transferStats;
+		for(int iEval=0; iEval<nEvals; iEval++) fluidMixture.compute(&grad, 0);
+		const ManagedMemoryBase::TransferStats& stats = ManagedMemoryBase::transferStats;
+		double nTransfers = double((stats.nToCpu - stats0.nToCpu) + (stats.nToGpu - stats0.nToGpu)) / nEvals;
+		double bytesTransferred = ((stats.bytesToCpu - stats0.bytesToCpu) + (stats.bytesToGpu - stats0.bytesToGpu)) / nEvals;
+		bs.addCounter("transfers_per_eval", nTransfers);
+		bs.addCounter("transfer_bytes_per_eval", bytesTransferred);
+		logPrintf("%-40s %12.1lf toCpu/toGpu moves (%.3lf MB) per evaluation\n", "", nTransfers, bytesTransferred/(1024.*1024.));
+		logFlush();
+	}
+}
+
+//Dense hermitian diagonalization:
+void benchmarkDiagonalize(BenchmarkSuite& bs)
+{	for(int N: {64, 128, 256, 512})
+	{	matrix A(N, N); randomize(A);
+		A = dagger_symmetrize(A);
+		matrix evecs; diagMatrix eigs;
+		bs.run([&](){ A.diagonalize(evecs, eigs); }, "diagonalize/%d", N);
+	}
+}
+
+int main(int argc, char** argv)
+{	if(argc > 3) printUsageExit();
+	if(argc > 1 and (string(argv[1])=="-h" or string(argv[1])=="--help")) printUsageExit();
+	double tMinSec = 0.2;
+	if(argc > 2 and ((sscanf(argv[2], "%lf", &tMinSec) != 1) or (tMinSec <= 0.))) printUsageExit();
+	initSystem(argc, argv);
+
+	BenchmarkSuite bs(tMinSec);
+	benchmarkFFTs(bs);
+	benchmarkDiagonalize(bs);
+	benchmarkSystem(bs);
+	benchmarkFluid(bs);
+
+	//Write results:
+	if(mpiWorld->isHead())
+	{	const char* fname = (argc > 1) ? argv[1] : "benchmarks.json";
+		FILE* fp = fopen(fname, "w");
+		if(!fp) die_alone("Could not open '%s' for writing.\n", fname);
+		bs.write(fp, argv[0]);
+		fclose(fp);
+		logPrintf("\nWrote benchmark results to '%s'.\n", fname);
+	}
+	finalizeSystem();
+	return 0;
+}
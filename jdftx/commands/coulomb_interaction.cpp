@@ -18,6 +18,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 -------------------------------------------------------------------*/
 
 #include <commands/command.h>
+#include <core/CoulombKernel.h>
 #include <electronic/Everything.h>
 
 EnumStringMap<CoulombParams::ExchangeRegularization> exRegMethodMap
@@ -155,6 +156,50 @@ struct CommandCoulombTruncationEmbed : public Command
 commandCoulombTruncationEmbed;
 
 
+struct CommandCoulombTruncationCenter : public Command
+{
+	CommandCoulombTruncationCenter() : Command("coulomb-truncation-center", "jdftx/Coulomb interactions")
+	{
+		format = "<c0> <c1> <c2>";
+		comments =
+			"Specify the center of the system for translationally-invariant truncated\n"
+			"Coulomb interactions, without embedding in a double-sized box. This is only\n"
+			"needed with an electric-field component along truncated directions, whose\n"
+			"ramp potential is discontinuous on the Wigner-Seitz cell boundary about this\n"
+			"center. The field is then applied on the original grid with the usual\n"
+			"L/2 localization constraint, avoiding the cost of the doubled box of\n"
+			"coulomb-truncation-embed. Ions must remain at least the distance set by\n"
+			"coulomb-truncation-ion-margin from the ramp discontinuity.\n"
+			"\n"
+			"Coordinate system for center (<c0> <c1> <c2>) is as specified by coords-type.\n"
+			"\n"
+			"Default: origin of the lattice coordinates";
+		
+		hasDefault = false;
+		require("coulomb-interaction");
+		forbid("coulomb-truncation-embed");
+		//Dependencies due to coordinate system option:
+		require("latt-scale");
+		require("coords-type");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	vector3<>& c = e.coulombParams.embedCenter;
+		pl.get(c[0], 0., "c0", true);
+		pl.get(c[1], 0., "c1", true);
+		pl.get(c[2], 0., "c2", true);
+		if(e.iInfo.coordsType==CoordsCartesian) c = inv(e.gInfo.R) * c; //Transform coordinates if necessary
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	vector3<> c = e.coulombParams.embedCenter;
+		if(e.iInfo.coordsType==CoordsCartesian) c = e.gInfo.R * c; //Print in coordinate system chosen by user
+		logPrintf("%lg %lg %lg", c[0], c[1], c[2]);
+	}
+}
+commandCoulombTruncationCenter;
+
+
 struct CommandCoulombTruncationIonMargin : public Command
 {
 	CommandCoulombTruncationIonMargin() : Command("coulomb-truncation-ion-margin", "jdftx/Coulomb interactions")
@@ -181,11 +226,71 @@ struct CommandCoulombTruncationIonMargin : public Command
 commandCoulombTruncationIonMargin;
 
 
+struct CommandCoulombKernelCache : public Command
+{
+	CommandCoulombKernelCache() : Command("coulomb-kernel-cache", "jdftx/Coulomb interactions")
+	{
+		format = "<directory>";
+		comments =
+			"Save Wigner-Seitz truncated Coulomb kernels (used in Isolated and Wire geometries,\n"
+			"and for exchange with WignerSeitzTruncated regularization) to <directory>, and reuse\n"
+			"them in subsequent calculations with identical lattice vectors, grids, truncation\n"
+			"and screening parameters. This can save minutes of setup in reruns and parameter\n"
+			"scans that do not change the geometry of the unit cell. Files are named by a hash\n"
+			"of the kernel parameters, and the directory must already exist.";
+		hasDefault = false;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(CoulombKernel::cacheDir, string(), "directory", true);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", CoulombKernel::cacheDir.c_str());
+	}
+}
+commandCoulombKernelCache;
+
+
+struct CommandCoulombEwaldMesh : public Command
+{
+	CommandCoulombEwaldMesh() : Command("coulomb-ewald-mesh", "jdftx/Coulomb interactions")
+	{
+		format = "<splineOrder>=8";
+		comments =
+			"Compute the ion-ion Ewald sum using the smooth particle-mesh Ewald method,\n"
+			"interpolating the ionic charges onto the FFT grid with B-splines of order\n"
+			"<splineOrder> (between 3 and 12). The gaussian width is set by the grid\n"
+			"resolution, leaving a short-ranged real space sum, so that the cost scales\n"
+			"as N log N with number of atoms N, instead of N^2 for the analytic sum.\n"
+			"Energies, forces and stresses are consistent with each other, with relative\n"
+			"errors ~ 1e-8 for the default order, which decrease with increasing order.\n"
+			"Recommended for large cells with many atoms, such as molecular dynamics of\n"
+			"liquids. Only available for <geometry> = Periodic in coulomb-interaction.";
+		hasDefault = false;
+		require("coulomb-interaction");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.coulombParams.ewaldSplineOrder, 8, "splineOrder");
+		if(e.coulombParams.ewaldSplineOrder<3 || e.coulombParams.ewaldSplineOrder>12)
+			throw string("<splineOrder> must be between 3 and 12");
+		if(e.coulombParams.geometry != CoulombParams::Periodic)
+			throw string("Particle-mesh Ewald sums are only supported for periodic geometry");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.coulombParams.ewaldSplineOrder);
+	}
+}
+commandCoulombEwaldMesh;
+
+
 struct CommandExchangeRegularization : public Command
 {
 	CommandExchangeRegularization() : Command("exchange-regularization", "jdftx/Coulomb interactions")
 	{
-		format = "<method>=" + exRegMethodMap.optionList();
+		format = "<method>=" + exRegMethodMap.optionList() + " [<kernelTableMB>=0]";
 		comments =
 			"Regularization / singularity correction method for exact exchange.\n"
 			"The allowed methods and defaults depend on the setting of <geometry>\n"
@@ -210,7 +315,15 @@ struct CommandExchangeRegularization : public Command
 			"\n+ WignerSeitzTruncated\n\n"
 			"    Truncate exchange kernel on the Wigner-Seitz cell of the k-point\n"
 			"    sampled supercell, as in Ref. \\cite TruncatedEXX.\n"
-			"    Default for any (partially) periodic <geometry>.";
+			"    Default for any (partially) periodic <geometry>.\n"
+			"\n"
+			"Optionally, <kernelTableMB> sets a per-process memory budget (in MB) for\n"
+			"tabulating the analytic kernels (None, AuxiliaryFunction, ProbeChargeEwald\n"
+			"and SphericalTruncated) for each k-point difference on first use, instead\n"
+			"of re-evaluating them for every pair density. Tables reside on the GPU when\n"
+			"enabled, and let exact exchange apply the kernel to a whole batch of pair\n"
+			"densities at once. Kernels beyond the budget are evaluated on the fly.\n"
+			"WignerSeitzTruncated kernels are always tabulated, so this has no effect there.";
 		hasDefault = true;
 		require("coulomb-interaction");
 	};
@@ -228,15 +341,57 @@ struct CommandExchangeRegularization : public Command
 		if(isIsolated && cp.exchangeRegularization!=CoulombParams::None)
 			throw string("exchange-regularization <method> must be None for non-periodic"
 				" coulomb-interaction <geometry> = Spherical or Isolated");
+		pl.get(cp.exchangeKernelTableMB, 0., "kernelTableMB");
+		if(cp.exchangeKernelTableMB < 0.)
+			throw string("<kernelTableMB> must be non-negative");
 	}
 	
 	void printStatus(Everything& e, int iRep)
-	{	logPrintf("%s", exRegMethodMap.getString(e.coulombParams.exchangeRegularization));
+	{	logPrintf("%s %lg", exRegMethodMap.getString(e.coulombParams.exchangeRegularization), e.coulombParams.exchangeKernelTableMB);
 	}
 }
 commandExchangeRegularization;
 
 
+struct CommandExchangeQdownsample : public Command
+{
+	CommandExchangeQdownsample() : Command("exchange-q-downsample", "jdftx/Coulomb interactions")
+	{
+		format = "<d0> <d1> <d2>";
+		comments =
+			"Evaluate exact exchange on a q-mesh coarser than the k-point mesh, analogous to nqx in QE.\n"
+			"Each k-point then only pairs with k-points that differ from it by a point of the q-mesh,\n"
+			"which is the k-point mesh downsampled by integer factors <d0>, <d1> and <d2> along each\n"
+			"supercell lattice vector (printed during setup; these are the lattice vectors scaled by the\n"
+			"fold counts for Gamma-centered kpoint-folding). Each factor must divide the corresponding\n"
+			"number of k-points, and the resulting q-mesh must retain the symmetries of the k-point mesh.\n"
+			"\n"
+			"This reduces the cost of exact exchange by <d0>*<d1>*<d2>, while the exchange regularization\n"
+			"is computed for the correspondingly smaller supercell. The resulting error in energies is\n"
+			"usually much smaller than the k-point sampling error of the same coarse mesh, but should be\n"
+			"checked against a calculation without downsampling for the system at hand.\n"
+			"Not supported for polarizability and electron-scattering, which use the full mesh.\n"
+			"(Default: 1 1 1, which pairs all k-points.)";
+		hasDefault = false;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	vector3<int>& d = e.coulombParams.exchangeDownsample;
+		const char* dirName[3] = { "d0", "d1", "d2" };
+		for(int k=0; k<3; k++)
+		{	pl.get(d[k], 1, dirName[k], true);
+			if(d[k] < 1) throw string("Downsampling factors must be positive");
+		}
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	const vector3<int>& d = e.coulombParams.exchangeDownsample;
+		logPrintf("%d %d %d", d[0], d[1], d[2]);
+	}
+}
+commandExchangeQdownsample;
+
+
 enum ExchangeParamsMember
 {	EPM_blockSize,
 	EPM_nOuterVxx,
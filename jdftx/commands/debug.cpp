@@ -136,3 +136,117 @@ struct CommandForcesOutputCoords : public Command
 	}
 }
 commandForcesOutputCoords;
+
+
+struct CommandProfileOutput : public Command
+{
+	CommandProfileOutput() : Command("profile-output", "jdftx/Output")
+	{
+		format = "<filename>";
+		comments =
+			"Record a hierarchical profile of the run (available in all builds, without EnableProfiling).\n"
+			"All timed regions (as well as FFTs and each minimize / SCF iteration) are recorded\n"
+			"per thread with their nesting and estimated bytes moved (for FFTs and wavefunction BLAS3).\n"
+			"At the end of the run, the regions are written to <filename> as a Chrome trace\n"
+			"(JSON; open in chrome://tracing or ui.perfetto.dev), and a call-tree summary is logged.\n"
+			"In MPI runs, each process writes <filename>.<rank>, with its rank as the trace pid.\n"
+			"In GPU builds, each region boundary synchronizes the device, which perturbs concurrency.\n"
+			"\n"
+			"The phases Setup, DensityBuild, Hamiltonian, SubspaceLinalg, FluidSolve and Dump\n"
+			"additionally record the energy consumed, from CPU package RAPL counters (readable\n"
+			"/sys/class/powercap/intel-rapl:*/energy_uj) and, in CUDA builds, the NVML energy\n"
+			"counter of the GPU in use (libnvidia-ml loaded at runtime, Volta or newer).\n"
+			"These are reported in Joules in the call tree, trace and a per-phase PROFILE-ENERGY\n"
+			"summary. Note that package counters are shared by all processes on a node, and that\n"
+			"phases running concurrently on different threads are each charged the full interval.";
+		hasDefault = false;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(filename, string(), "filename", true);
+		Profiler::start(filename);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", filename.c_str());
+	}
+	
+	string filename;
+}
+commandProfileOutput;
+
+
+struct CommandEventLog : public Command
+{
+	CommandEventLog() : Command("event-log", "jdftx/Output")
+	{
+		format = "<filename>";
+		comments =
+			"Write a machine-readable stream of iteration reports to <filename>, for monitoring\n"
+			"convergence from workflow tools. Each line is one JSON object (NDJSON), with fields:\n"
+			"+ type: minimize (CG / L-BFGS iterations), pulay (SCF cycles), dynamics (MD steps) or end\n"
+			"+ prefix: line prefix of the corresponding log output, eg. ElecMinimize or IonicMinimize\n"
+			"+ iter, energy (labelled by energyLabel) and convergence measures such as gradK, alpha,\n"
+			"   linmin and cgtest (minimize), dE, residual and extra criteria (pulay),\n"
+			"   or PE, KE, T_K, P_Bar and tMD_fs (dynamics)\n"
+			"+ t: wall time in seconds, and maxRSS_MB: peak resident memory of the head process.\n"
+			"Each line is flushed when written. Non-finite values are written as null.";
+		hasDefault = false;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(filename, string(), "filename", true);
+		EventLog::start(filename);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", filename.c_str());
+	}
+	
+	string filename;
+}
+commandEventLog;
+
+
+EnumStringMap<bool> onExceedMap(false, "warn", true, "abort");
+
+struct CommandMemoryMonitor : public Command
+{
+	CommandMemoryMonitor() : Command("memory-monitor", "jdftx/Output")
+	{
+		format = "<filename> [<budgetMB>=0] [<onExceed>=warn] [<nSites>=0]";
+		comments =
+			"Monitor managed memory usage per category (available in all builds, without EnableProfiling).\n"
+			"At every dump-frequency point (each electronic, ionic, fluid step etc., regardless of dump-interval),\n"
+			"each process appends one JSON object per line to <filename> (<filename>.<rank> in MPI runs) with\n"
+			"the current and recent-peak (since previous point) usage in total and per category, along with\n"
+			"the peak resident memory of the process.\n"
+			"+ <budgetMB>: per-process budget for managed memory in MB (default 0 = none). Exceeding it logs\n"
+			"   the per-category usage (and traced allocation sites) at the point of the offending allocation.\n"
+			"+ <onExceed>: warn (default) to continue, or abort to stop the run when the budget is exceeded.\n"
+			"+ <nSites>: if positive, trace the call stack of every allocation and report the <nSites> sites\n"
+			"   with largest peak usage at the end of the run (at additional overhead per allocation).\n"
+			"   Function names in the stacks require linking with -rdynamic, as for stack traces.";
+		hasDefault = false;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(filename, string(), "filename", true);
+		pl.get(budgetMB, 0., "budgetMB");
+		if(budgetMB < 0.) throw string("<budgetMB> must be non-negative");
+		pl.get(abortOnBudget, false, onExceedMap, "onExceed");
+		pl.get(nSites, 0, "nSites");
+		if(nSites < 0) throw string("<nSites> must be non-negative");
+		MemoryMonitor::start(filename, budgetMB, abortOnBudget, nSites);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %lg %s %d", filename.c_str(), budgetMB, onExceedMap.getString(abortOnBudget), nSites);
+	}
+	
+	string filename;
+	double budgetMB;
+	bool abortOnBudget;
+	int nSites;
+}
+commandMemoryMonitor;
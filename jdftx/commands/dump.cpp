@@ -25,6 +25,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Vibrations.h>
 #include <electronic/Dump_internal.h>
 #include <electronic/DumpBGW_internal.h>
+#include <electronic/DumpAnalysis.h>
 #include <core/Units.h>
 
 struct CommandDumpOnly : public Command
@@ -112,6 +113,8 @@ EnumStringMap<DumpVariable> varMap
 	DumpQMC, "QMC",
 	DumpOcean, "Ocean",
 	DumpBGW, "BGW",
+	DumpCheckpoint, "Checkpoint",
+	DumpTrajectory, "Trajectory",
 	DumpRealSpaceWfns, "RealSpaceWfns",
 	DumpFluidDebug, "FluidDebug",
 	DumpSlabEpsilon, "SlabEpsilon",
@@ -166,6 +169,8 @@ EnumStringMap<DumpVariable> varDescMap
 	DumpQMC,            "Blip'd orbitals and potential for CASINO \\cite Katie-QMC",
 	DumpOcean,          "Wave functions for Ocean code",
 	DumpBGW,            "G-space wavefunctions, density and potential for Berkeley GW (requires HDF5 support)",
+	DumpCheckpoint,     "Single HDF5 file with wavefunctions, fillings, eigenvalues, densities, potentials and fluid state for restart (requires HDF5 support; see initial-checkpoint)",
+	DumpTrajectory,     "Append a frame (energies, lattice, stress, positions, velocities and forces) to a binary trajectory with fixed-size frames (see script trajectoryToXYZ)",
 	DumpRealSpaceWfns,  "Real-space wavefunctions (one column per file)",
 	DumpExcCompare,     "Energies for other exchange-correlation functionals (see command elec-ex-corr-compare)",
 	DumpFluidDebug,     "Fluid specific debug output if any ",
@@ -179,7 +184,7 @@ EnumStringMap<DumpVariable> varDescMap
 	DumpExcitations,    "Dumps dipole moments and transition strength (electric-dipole) of excitations",
 	DumpFCI,            "Output Coulomb matrix elements in FCIDUMP format",
 	DumpSpin,           "Spin matrix elements from non-collinear calculations in a binary file (indices outer to inner: state, cartesian direction, band1, band2)",
-	DumpMomenta,        "Momentum matrix elements in a binary file (indices outer to inner: state, cartesian direction, band1, band2)",
+	DumpMomenta,        "Momentum matrix elements in a binary file (indices outer to inner: state, cartesian direction, band1, band2; see dump-band-window)",
 	DumpVelocities,     "Diagonal momentum/velocity matrix elements in a binary file  (indices outer to inner: state, band, cartesian direction)",
 	DumpFermiVelocity,  "Fermi velocity, density of states at Fermi level and related quantities",
 	DumpSymmetries,     "List of symmetry matrices (in covariant lattice coordinates)",
@@ -224,6 +229,7 @@ struct CommandDump : public Command
 			//Check for unsupported features:
 			#ifndef HDF5_ENABLED
 			if(var==DumpBGW) throw string("BerkeleyGW interface requires HDF5 support (CMake option EnableHDF5)\n");
+			if(var==DumpCheckpoint) throw string("Checkpoint output requires HDF5 support (CMake option EnableHDF5)\n");
 			#endif
 		}
 	}
@@ -246,6 +252,56 @@ struct CommandDump : public Command
 commandDump;
 
 
+struct CommandDumpAnalysis : public Command
+{
+	CommandDumpAnalysis() : Command("dump-analysis", "jdftx/Output")
+	{
+		format = "<freq> <name> <name> ...";
+		comments =
+			"Run in-situ analyses <name> at dump frequency <freq> (see command dump; subject to\n"
+			"dump-interval), appending their compact results to a text file named as in dump,\n"
+			"with variable name analysis.<name>, instead of dumping full fields for post-processing.\n"
+			"Each result is preceded by a line '# <freq> <iter>'. Built-in analyses are:\n"
+			"\n+ PlanarAverage: planar averages of the total electron density perpendicular to\n"
+			"   each lattice direction (lines n_avg0, n_avg1 and n_avg2).\n"
+			"\n+ BandStats: for each spin channel, the number of electrons and holes, and the\n"
+			"   filling-weighted centers and widths of the occupied and unoccupied bands.\n"
+			"\nFurther analyses can be added in C++ by deriving from DumpAnalysis (see DumpAnalysis.h).\n"
+			"Multiple instances of this command accumulate analyses for each <freq>.";
+		allowMultiple = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	DumpFrequency freq;
+		pl.get(freq, DumpFreq_Delim, freqMap, "freq", true);
+		const std::map<string,DumpAnalysis*>& analysisMap = getDumpAnalysisMap();
+		while(true)
+		{	string name;
+			pl.get(name, string(), "name");
+			if(!name.length()) break;
+			if(analysisMap.find(name) == analysisMap.end())
+			{	string names;
+				for(const auto& entry: analysisMap) names += " " + entry.first;
+				throw "Unknown analysis '" + name + "': must be one of" + names;
+			}
+			e.dump.analyses.insert(std::make_pair(freq, name));
+		}
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	//Group analyses by frequency, one command per frequency:
+		int iDump = 0;
+		for(auto i=e.dump.analyses.begin(); i!=e.dump.analyses.end(); iDump++)
+		{	DumpFrequency freq = i->first;
+			if(iDump==iRep) logPrintf("%s", freqMap.getString(freq));
+			for(; i!=e.dump.analyses.end() and i->first==freq; i++)
+				if(iDump==iRep) logPrintf(" %s", i->second.c_str());
+		}
+	}
+}
+commandDumpAnalysis;
+
+
 struct CommandDumpInterval : public Command
 {
 	CommandDumpInterval() : Command("dump-interval", "jdftx/Output")
@@ -366,6 +422,9 @@ enum ElectronScatteringMember
 	ESM_slabResponse,
 	ESM_EcutTransverse,
 	ESM_computeRange,
+	ESM_transformCacheSize,
+	ESM_qGroups,
+	ESM_nEigs,
 	ESM_delim
 };
 EnumStringMap<ElectronScatteringMember> esmMap
@@ -376,7 +435,10 @@ EnumStringMap<ElectronScatteringMember> esmMap
 	ESM_RPA, "RPA",
 	ESM_slabResponse, "slabResponse",
 	ESM_EcutTransverse, "EcutTransverse",
-	ESM_computeRange, "computeRange"
+	ESM_computeRange, "computeRange",
+	ESM_transformCacheSize, "transformCacheSize",
+	ESM_qGroups, "qGroups",
+	ESM_nEigs, "nEigs"
 );
 
 struct CommandElectronScattering : public Command
@@ -415,7 +477,24 @@ struct CommandElectronScattering : public Command
 			"   If specified, only calculate momentum transfers in range [iqStart , iqStop] in\n"
 			"   the current run, in order to split the overall calculation into smaller jobs.\n"
 			"   Note that the indices are 1-based, and the range includes both end-points.\n"
-			"   To combine the final results, perform a final run without computeRange specified.";
+			"   To combine the final results, perform a final run without computeRange specified.\n"
+			"\n+ transformCacheSize <MB>\n\n"
+			"   If specified, cache at most <MB> megabytes per process of the wavefunction transforms\n"
+			"   from the reduced to the full k-mesh (least recently used released first), instead of\n"
+			"   retaining transforms for every k-point reached. Useful for dense k and q meshes.\n"
+			"\n+ qGroups <nGroups>\n\n"
+			"   Divide processes into <nGroups> groups that compute different momentum transfers\n"
+			"   concurrently, distributing k-points only within each group. This replaces most\n"
+			"   of the per-q global reductions by reductions within smaller groups, at the cost of\n"
+			"   each group holding its own polarizability matrices. Each group writes the check-point\n"
+			"   file ImSigma_ee.<iq> of its momentum transfers, so interrupted runs resume as usual.\n"
+			"   (default: 1)\n"
+			"\n+ nEigs <nEigs>\n\n"
+			"   If positive, represent the dielectric response at each momentum transfer in the\n"
+			"   subspace of the <nEigs> dominant eigenvectors of the static Kohn-Sham susceptibility,\n"
+			"   reducing the frequency-dependent matrices from nbasis^2 to <nEigs>^2 in size and the\n"
+			"   inversions to <nEigs>^3 cost. The fraction of the static chi_KS trace retained is\n"
+			"   reported for each momentum transfer. (default: 0, use the full plane-wave basis)";
 			
 		require("coulomb-interaction");
 		forbid("polarizability"); //both are major operations that are given permission to destroy Everything if necessary
@@ -444,6 +523,18 @@ struct CommandElectronScattering : public Command
 					es.iqStart -= 1; //convert to 0-based index. Note that iqStop becomes a non-included 0-based index without change
 					break;
 				}
+				case ESM_transformCacheSize:
+					pl.get(es.transformCacheSize, 0., "MB", true);
+					if(es.transformCacheSize <= 0.) throw string("<MB> must be positive");
+					break;
+				case ESM_qGroups:
+					pl.get(es.nqGroups, 1, "nGroups", true);
+					if(es.nqGroups < 1) throw string("<nGroups> must be at least 1");
+					break;
+				case ESM_nEigs:
+					pl.get(es.nEigs, 0, "nEigs", true);
+					if(es.nEigs < 0) throw string("<nEigs> must be non-negative");
+					break;
 				case ESM_delim: break; //never encountered; to suppress compiler warning
 			}
 		}
@@ -467,6 +558,9 @@ struct CommandElectronScattering : public Command
 		logPrintf(" \\\n\tslabResponse %s", boolMap.getString(es.slabResponse));
 		if(es.slabResponse) logPrintf(" \\\n\tEcutTransverse %lg", es.EcutTransverse);
 		if(es.computeRange)  logPrintf(" \\\n\tcomputeRange %lu %lu", es.iqStart+1, es.iqStop);
+		if(es.transformCacheSize) logPrintf(" \\\n\ttransformCacheSize %lg", es.transformCacheSize);
+		if(es.nqGroups > 1) logPrintf(" \\\n\tqGroups  %d", es.nqGroups);
+		if(es.nEigs) logPrintf(" \\\n\tnEigs    %d", es.nEigs);
 	}
 }
 commandElectronScattering;
@@ -586,6 +680,8 @@ enum VibrationsMember
 	VM_omegaMin,
 	VM_T,
 	VM_omegaResolution,
+	VM_nJobs,
+	VM_iJob,
 	VM_Delim
 };
 
@@ -597,7 +693,9 @@ EnumStringMap<VibrationsMember> vibMap
 	VM_rotationSym, "rotationSym",
 	VM_omegaMin, "omegaMin",
 	VM_T, "T",
-	VM_omegaResolution, "omegaResolution"
+	VM_omegaResolution, "omegaResolution",
+	VM_nJobs, "nJobs",
+	VM_iJob, "iJob"
 );
 
 struct CommandVibrations : public Command
@@ -624,6 +722,16 @@ struct CommandVibrations : public Command
 			"+ T <T>: temperature (in Kelvin) for free energy calculation (default: 298)\n"
 			"+ omegaResolution <omegaResolution>: resolution for detecting and reporting degeneracies\n"
 			"   in modes (default: 1e-4). Does not affect free energies and all modes are still printed.\n"
+			"+ nJobs <nJobs>: divide the displacements between <nJobs> independent runs (default: 1),\n"
+			"   which may run concurrently on separate resources in the same directory.\n"
+			"+ iJob <iJob>: which of the nJobs runs this is (1 to nJobs, default: 1); each job computes\n"
+			"   every nJobs'th displacement starting at iJob, and stops before the mode analysis.\n"
+			"\n"
+			"Forces and dipole moments of each displacement are saved to the vibrations.<iDisp>\n"
+			"dump file as it completes, and read back (instead of recomputed) by later runs.\n"
+			"This allows preempted runs to resume, and results of all jobs to be collected:\n"
+			"after the nJobs runs complete, rerun with nJobs 1 to perform the mode analysis.\n"
+			"Each displacement is warm-started from the wavefunctions of the reference configuration.\n"
 			"\n"
 			"Note that for a periodic system with k-points, wave functions may be incompatible\n"
 			"with and without the vibrations command due to symmetry-breaking by the perturbations.\n"
@@ -648,7 +756,18 @@ struct CommandVibrations : public Command
 				case VM_omegaMin: pl.get(e.vibrations->omegaMin, 2e-4, "omegaMin", true); break;
 				case VM_T: pl.get(e.vibrations->T, 298., "T", true); e.vibrations->T *= Kelvin; break;
 				case VM_omegaResolution: pl.get(e.vibrations->omegaResolution, 1e-4, "omegaResolution", true); break;
-				case VM_Delim: return; //end of input
+				case VM_nJobs:
+					pl.get(e.vibrations->nJobs, 1, "nJobs", true);
+					if(e.vibrations->nJobs <= 0) throw string("<nJobs> must be positive");
+					break;
+				case VM_iJob:
+					pl.get(e.vibrations->iJob, 1, "iJob", true);
+					if(e.vibrations->iJob <= 0) throw string("<iJob> must be positive");
+					e.vibrations->iJob--; //store 0-based
+					break;
+				case VM_Delim:
+					if(e.vibrations->iJob >= e.vibrations->nJobs) throw string("<iJob> must not exceed <nJobs>");
+					return; //end of input
 			}
 		}
 		
@@ -663,6 +782,8 @@ struct CommandVibrations : public Command
 		logPrintf("\\\n\tomegaMin %g", e.vibrations->omegaMin);
 		logPrintf("\\\n\tT %g", e.vibrations->T/Kelvin);
 		logPrintf("\\\n\tomegaResolution %g", e.vibrations->omegaResolution);
+		logPrintf("\\\n\tnJobs %d", e.vibrations->nJobs);
+		logPrintf("\\\n\tiJob %d", e.vibrations->iJob+1);
 	}
 }
 commandVibrations;
@@ -886,6 +1007,33 @@ struct CommandChargedDefect : public Command
 }
 commandChargedDefect;
 
+struct CommandChargedDefectCache : public Command
+{
+	CommandChargedDefectCache() : Command("charged-defect-cache", "jdftx/Output")
+	{
+		format = "<directory>";
+		comments =
+			"Save the model-charge solution of charged-defect-correction (the dielectric-profile\n"
+			"solve, model potential and self-energies) to <directory>, and reuse it for subsequent\n"
+			"defect calculations with the same host lattice, grid, dielectric model and model-charge\n"
+			"positions and widths. Since the model problem is linear, all charge states of a defect\n"
+			"share one solution, so that each further correction only requires the alignment step.\n"
+			"Files are named by a hash of these parameters, and the directory must already exist.\n"
+			"(Not used for surface defects in a fluid, whose cavity depends on the defect calculation.)";
+		
+		require("charged-defect-correction");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.chargedDefect->cacheDir, string(), "directory", true);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", e.dump.chargedDefect->cacheDir.c_str());
+	}
+}
+commandChargedDefectCache;
+
 struct CommandPotentialSubtraction : public Command
 {
 	CommandPotentialSubtraction() : Command("potential-subtraction", "jdftx/Output")
@@ -906,6 +1054,175 @@ struct CommandPotentialSubtraction : public Command
 commandPotentialSubtraction;
 
 
+EnumStringMap<bool> wfnsPrecisionMap(false, "double", true, "single");
+
+struct CommandDumpWfnsPrecision : public Command
+{
+	CommandDumpWfnsPrecision() : Command("dump-wfns-precision", "jdftx/Output")
+	{	format = "<precision>=double|single";
+		comments =
+			"Precision of the wavefunctions written in State dumps. Single precision halves\n"
+			"the size of wfns files, and is detected automatically (from the file length) when\n"
+			"they are read back, eg. by initial-state or wavefunction read. The resulting error\n"
+			"(~1e-7 relative) is corrected by the first electronic step upon restart, but may\n"
+			"need to be accounted for in post-processing without further minimization.\n"
+			"Default: double.";
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.wfnsSinglePrecision, false, wfnsPrecisionMap, "precision");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", wfnsPrecisionMap.getString(e.dump.wfnsSinglePrecision));
+	}
+}
+commandDumpWfnsPrecision;
+
+
+struct CommandDumpAsync : public Command
+{
+	CommandDumpAsync() : Command("dump-async", "jdftx/Output")
+	{	format = "<async>=yes|no";
+		comments =
+			"Whether to write wavefunctions of intermediate State dumps (at Electronic, Ionic\n"
+			"and other non-End frequencies) in the background, while the calculation proceeds.\n"
+			"The wavefunctions are copied to host memory, requiring one extra copy of the local\n"
+			"wavefunctions per process, and written by a separate thread; the next dump waits for\n"
+			"any pending write to complete. Dumps at End are always synchronous. Default: no.\n"
+			"(Has no effect in builds with the CMake option MPISafeWrite.)";
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.asyncState, false, boolMap, "async");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.dump.asyncState));
+	}
+}
+commandDumpAsync;
+
+
+EnumStringMap<VisualizationFormat> visualizationFormatMap
+(	VisualizationVTI, "VTI",
+	VisualizationXSF, "XSF"
+);
+
+struct CommandDumpVisualization : public Command
+{
+	CommandDumpVisualization() : Command("dump-visualization", "jdftx/Output")
+	{	format = "<format1> [<format2>]";
+		comments =
+			"Also write each dumped scalar field (densities, potentials etc.) in the listed\n"
+			"visualization formats, to the dump filename with the format suffix appended:\n"
+			"+ VTI: VTK XML image data with raw binary values, readable directly by ParaView\n"
+			"   and VisIt (grid axes along the lattice vectors, which needs VTK 9 or newer\n"
+			"   for non-orthogonal cells).\n"
+			"+ XSF: XCrySDen structure file with the lattice, atoms and the values as text\n"
+			"   (formatted in parallel, but still much larger than the binary output).\n"
+			"This avoids post-processing with createXSF for large grids.";
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	e.dump.visualizationFormats.clear();
+		while(true)
+		{	VisualizationFormat vf; string key;
+			pl.get(key, string(), "format" + string(e.dump.visualizationFormats.size() ? "N" : "1"), !e.dump.visualizationFormats.size());
+			if(!key.length()) break;
+			if(!visualizationFormatMap.getEnum(key.c_str(), vf))
+				throw "<format>=" + key + " must be one of " + visualizationFormatMap.optionList();
+			e.dump.visualizationFormats.insert(vf);
+		}
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	for(VisualizationFormat vf: e.dump.visualizationFormats)
+			logPrintf(" %s", visualizationFormatMap.getString(vf));
+	}
+}
+commandDumpVisualization;
+
+
+struct CommandDumpBandWindow : public Command
+{
+	CommandDumpBandWindow() : Command("dump-band-window", "jdftx/Output")
+	{	format = "<Emin> <Emax>";
+		comments =
+			"Restrict the band pairs in Momenta and Excitations output to an energy window\n"
+			"[Emin,Emax] (in Eh), reducing their cost and size for calculations with many bands.\n"
+			"Momenta then contains the range of bands with eigenvalues within the window in any\n"
+			"state (logged as [bStart,bStop), with records of size (bStop-bStart)^2 x 3), and\n"
+			"Excitations only includes transitions from occupied bands above Emin to unoccupied\n"
+			"bands below Emax. Velocities and FermiVelocity always use all bands.\n"
+			"Default: all bands.";
+		hasDefault = false;
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.bandWindowMin, 0., "Emin", true);
+		pl.get(e.dump.bandWindowMax, 0., "Emax", true);
+		if(e.dump.bandWindowMin >= e.dump.bandWindowMax) throw string("Emin must be < Emax");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg %lg", e.dump.bandWindowMin, e.dump.bandWindowMax);
+	}
+}
+commandDumpBandWindow;
+
+
+struct CommandDumpPairScreening : public Command
+{
+	CommandDumpPairScreening() : Command("dump-pair-screening", "jdftx/Output")
+	{	format = "<threshold> [<omegaMax>=0]";
+		comments =
+			"Skip occupied-unoccupied pairs (i,j) whose response weight |fi - fj| / |Ej - Ei - omega|\n"
+			"(maximized over frequencies 0 <= omega <= <omegaMax>, in Eh) is below <threshold>,\n"
+			"before computing any of their pair densities. This applies to the sums over pairs in\n"
+			"Polarizability, ElectronScattering and Excitations output, and the fraction of pairs\n"
+			"retained is logged for each. ElectronScattering uses the maximum frequency of its own\n"
+			"grid instead of <omegaMax>. (BGW output does not sum over pairs: BerkeleyGW does that.)\n"
+			"Default: all pairs (threshold 0).";
+		hasDefault = false;
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.pairScreening.threshold, 0., "threshold", true);
+		pl.get(e.dump.pairScreening.omegaMax, 0., "omegaMax");
+		if(e.dump.pairScreening.threshold < 0.) throw string("<threshold> must be non-negative");
+		if(e.dump.pairScreening.omegaMax < 0.) throw string("<omegaMax> must be non-negative");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg %lg", e.dump.pairScreening.threshold, e.dump.pairScreening.omegaMax);
+	}
+}
+commandDumpPairScreening;
+
+
+struct CommandCheckpointCompression : public Command
+{
+	CommandCheckpointCompression() : Command("checkpoint-compression", "jdftx/Output")
+	{	format = "<level>=0";
+		comments =
+			"Deflate compression level (0 to 9) of the wavefunction and density datasets\n"
+			"in checkpoint output (dump variable Checkpoint). Default 0 => no compression.";
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.dump.checkpointCompression, 0, "level");
+		if(e.dump.checkpointCompression<0 || e.dump.checkpointCompression>9)
+			throw string("<level> must be between 0 and 9");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.dump.checkpointCompression);
+	}
+}
+commandCheckpointCompression;
+
+
 struct CommandBandUnfold : public Command
 {
 	CommandBandUnfold() : Command("band-unfold", "jdftx/Output")
@@ -936,10 +1253,20 @@ struct CommandBandUnfold : public Command
 commandBandUnfold;
 
 
+EnumStringMap<BGWparams::DenseSolver> bgwDenseSolverMap
+(	BGWparams::DenseScaLAPACK, "ScaLAPACK",
+	BGWparams::DenseLOBPCG, "LOBPCG"
+);
+
 enum BGWparamsMember
 {	BGWpm_nBandsDense,
 	BGWpm_blockSize,
 	BGWpm_clusterSize,
+	BGWpm_denseSolver,
+	BGWpm_iterBlockSize,
+	BGWpm_iterTol,
+	BGWpm_iterTolHigh,
+	BGWpm_iterMax,
 	BGWpm_EcutChiFluid,
 	BGWpm_elecOnly,
 	BGWpm_q0,
@@ -949,12 +1276,18 @@ enum BGWparamsMember
 	BGWpm_freqNimag,
 	BGWpm_freqPlasma,
 	BGWpm_Ecut_rALDA,
+	BGWpm_resume,
 	BGWpm_Delim
 };
 EnumStringMap<BGWparamsMember> bgwpmMap
 (	BGWpm_nBandsDense, "nBandsDense",
 	BGWpm_blockSize, "blockSize",
 	BGWpm_clusterSize, "clusterSize",
+	BGWpm_denseSolver, "denseSolver",
+	BGWpm_iterBlockSize, "iterBlockSize",
+	BGWpm_iterTol, "iterTol",
+	BGWpm_iterTolHigh, "iterTolHigh",
+	BGWpm_iterMax, "iterMax",
 	BGWpm_EcutChiFluid, "EcutChiFluid",
 	BGWpm_elecOnly, "elecOnly",
 	BGWpm_q0, "q0",
@@ -963,12 +1296,20 @@ EnumStringMap<BGWparamsMember> bgwpmMap
 	BGWpm_freqBroaden_eV, "freqBroaden_eV",
 	BGWpm_freqNimag, "freqNimag",
 	BGWpm_freqPlasma, "freqPlasma",
-	BGWpm_Ecut_rALDA, "Ecut_rALDA"
+	BGWpm_Ecut_rALDA, "Ecut_rALDA",
+	BGWpm_resume, "resume"
 );
 EnumStringMap<BGWparamsMember> bgwpmDescMap
-(	BGWpm_nBandsDense, "If non-zero, use a dense ScaLAPACK solver to calculate more bands",
+(	BGWpm_nBandsDense, "If non-zero, calculate this many bands for BGW output using denseSolver",
 	BGWpm_blockSize, "Block size for ScaLAPACK diagonalization (default: 32)",
 	BGWpm_clusterSize, "Maximum eigenvalue cluster size to allocate extra ScaLAPACK workspace for (default: 10)",
+	BGWpm_denseSolver, bgwDenseSolverMap.optionList() + ": solver for nBandsDense bands (default: ScaLAPACK). LOBPCG converges\n"
+		"   blocks of iterBlockSize bands iteratively, each deflated against all lower bands, with\n"
+		"   states distributed over processes as usual; it needs neither ScaLAPACK nor the full Hamiltonian",
+	BGWpm_iterBlockSize, "Number of bands converged together by the LOBPCG dense solver (default: 64)",
+	BGWpm_iterTol, "Residual norm threshold in Eh for the bands of the DFT calculation in the LOBPCG dense solver (default: 1e-6)",
+	BGWpm_iterTolHigh, "Residual norm threshold in Eh for the highest band (geometrically interpolated in between; default: 1e-4)",
+	BGWpm_iterMax, "Maximum iterations per block in the LOBPCG dense solver (default: 100)",
 	BGWpm_EcutChiFluid, "KE cutoff in hartrees for fluid polarizability output (default: 0; set non-zero to enable)",
 	BGWpm_elecOnly, "Whether fluid polarizability output should only include electronic response (default: true)",
 	BGWpm_q0, "Zero wavevector replacement to be used for polarizability output (default: (0,0,0))",
@@ -977,7 +1318,8 @@ EnumStringMap<BGWparamsMember> bgwpmDescMap
 	BGWpm_freqBroaden_eV, "Broadening (imaginary part) of real frequency grid in eV (default: 0.1)",
 	BGWpm_freqNimag, "Number of imaginary frequencies (default: 25)",
 	BGWpm_freqPlasma, "Plasma frequency in Hartrees used in GW imaginary frequency grid (default: 1.), set to zero for RPA frequency grid",
-	BGWpm_Ecut_rALDA, "KE cutoff in hartrees for rALDA polarizability output (default: 0; set non-zero to enable)"
+	BGWpm_Ecut_rALDA, "KE cutoff in hartrees for rALDA polarizability output (default: 0; set non-zero to enable)",
+	BGWpm_resume, "Whether to skip outputs completed by a previous interrupted run, as recorded in bgw.manifest (default: no)"
 );
 
 struct CommandBGWparams : public Command
@@ -1005,6 +1347,13 @@ struct CommandBGWparams : public Command
 			{	READ_AND_CHECK(nBandsDense, >=, 0)
 				READ_AND_CHECK(blockSize, >, 0)
 				READ_AND_CHECK(clusterSize, >, 0)
+				case BGWpm_denseSolver:
+					pl.get(bgwp.denseSolver, BGWparams::DenseScaLAPACK, bgwDenseSolverMap, "denseSolver", true);
+					break;
+				READ_AND_CHECK(iterBlockSize, >, 0)
+				READ_AND_CHECK(iterTol, >, 0.)
+				READ_AND_CHECK(iterTolHigh, >, 0.)
+				READ_AND_CHECK(iterMax, >, 0)
 				READ_AND_CHECK(EcutChiFluid, >=, 0.)
 				case BGWpm_elecOnly:
 					pl.get(bgwp.elecOnly, true, boolMap, "elecOnly", true);
@@ -1019,6 +1368,9 @@ struct CommandBGWparams : public Command
 				READ_AND_CHECK(freqNimag, >, 0)
 				READ_AND_CHECK(freqPlasma, >=, 0.)
 				READ_AND_CHECK(Ecut_rALDA, >=, 0.)
+				case BGWpm_resume:
+					pl.get(bgwp.resume, false, boolMap, "resume", true);
+					break;
 				case BGWpm_Delim: return; //end of input
 			}
 			#undef READ_AND_CHECK
@@ -1032,6 +1384,11 @@ struct CommandBGWparams : public Command
 		PRINT(nBandsDense, "%d")
 		PRINT(blockSize, "%d")
 		PRINT(clusterSize, "%d")
+		logPrintf(" \\\n\tdenseSolver %s", bgwDenseSolverMap.getString(bgwp.denseSolver));
+		PRINT(iterBlockSize, "%d")
+		PRINT(iterTol, "%lg")
+		PRINT(iterTolHigh, "%lg")
+		PRINT(iterMax, "%d")
 		PRINT(EcutChiFluid, "%lg")
 		logPrintf(" \\\n\telecOnly %s", boolMap.getString(bgwp.elecOnly));
 		logPrintf(" \\\n\tq0 %lg %lg %lg", bgwp.q0[0], bgwp.q0[1], bgwp.q0[2]);
@@ -1041,6 +1398,7 @@ struct CommandBGWparams : public Command
 		PRINT(freqNimag, "%d")
 		PRINT(freqPlasma, "%lg")
 		PRINT(Ecut_rALDA, "%lg")
+		logPrintf(" \\\n\tresume %s", boolMap.getString(bgwp.resume));
 		#undef PRINT
 	}
 }
@@ -34,6 +34,7 @@ EnumStringMap<ExCorrType> exCorrTypeMap(
 	ExCorrGGA_PW91, "gga-PW91",
 	ExCorrMGGA_TPSS, "mgga-TPSS",
 	ExCorrMGGA_revTPSS, "mgga-revTPSS",
+	ExCorrMGGA_r2SCAN, "mgga-r2SCAN",
 	ExCorrORB_GLLBsc, "orb-GLLBsc",
 	ExCorrPOT_LB94, "pot-LB94",
 	ExCorrHYB_PBE0, "hyb-PBE0",
@@ -53,6 +54,7 @@ EnumStringMap<ExCorrType> exCorrDescriptionMap(
 	ExCorrGGA_PW91, "Perdew-Wang GGA",
 	ExCorrMGGA_TPSS, "Tao-Perdew-Staroverov-Scuseria meta GGA",
 	ExCorrMGGA_revTPSS, "revised Tao-Perdew-Staroverov-Scuseria meta GGA",
+	ExCorrMGGA_r2SCAN, "regularized-restored strongly constrained and appropriately normed (r2SCAN) meta GGA",
 	ExCorrORB_GLLBsc, "Orbital-dependent GLLB-sc potential (no total energy)",
 	ExCorrPOT_LB94, "van Leeuwen-Baerends model potential (no total energy)",
 	ExCorrHYB_PBE0, "Hybrid PBE with 1/4 exact exchange",
@@ -388,3 +390,65 @@ struct CommandExchangeOuterLoop : public Command
 	}
 }
 commandExchangeOuterLoop;
+
+
+struct CommandExchangeAceUpdate : public Command
+{
+	CommandExchangeAceUpdate() : Command("exchange-ace-update", "jdftx/Electronic/Functional")
+	{
+		format = "<threshold> [<reuse>=" + boolMap.optionList() + "]";
+		comments =
+			"Control updates of the ACE (adaptively compressed exchange) operator in the\n"
+			"outer loop of hybrid functional calculations.\n"
+			"\n"
+			"If <threshold> is non-zero, ACE projectors are only recomputed for states whose\n"
+			"wavefunctions changed by more than <threshold> (measured as the RMS component of the\n"
+			"current orbitals outside the span of the orbitals used for the previous projectors),\n"
+			"skipping the exchange pairs that would only update the remaining states.\n"
+			"Note that all states still contribute to the refreshed projectors.\n"
+			"\n"
+			"If <reuse>=yes, the SCF of each ionic / dynamics step starts from the ACE operator\n"
+			"of the previous step instead of rebuilding it up front, and the outer loop then performs\n"
+			"at least one update as a correction. (Default: rebuild ACE fully, no reuse)";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.aceUpdateThreshold, 0., "threshold", true);
+		pl.get(e.cntrl.aceReuse, false, boolMap, "reuse");
+		if(e.cntrl.aceUpdateThreshold < 0.) throw string("<threshold> must be >= 0");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg %s", e.cntrl.aceUpdateThreshold, boolMap.getString(e.cntrl.aceReuse));
+	}
+}
+commandExchangeAceUpdate;
+
+
+struct CommandExchangeScreening : public Command
+{
+	CommandExchangeScreening() : Command("exchange-screening", "jdftx/Electronic/Functional")
+	{
+		format = "<threshold>";
+		comments =
+			"Screen exact-exchange pairs of localized orbitals in insulators.\n"
+			"The occupied orbitals of each state are localized by SCDM (selected columns of\n"
+			"the density matrix), which leaves the exchange operator unchanged for integer\n"
+			"occupations, and pairs whose bound on the overlap density integral |psi_i psi_j|\n"
+			"is below <threshold> are skipped. The cost then grows nearly linearly with system\n"
+			"size for large-gap systems. The error is reported once against the full evaluation.\n"
+			"Only applicable with a single k-point (eg. Gamma-point supercells) and integer\n"
+			"occupations; all pairs are computed otherwise, and for lattice gradients.\n"
+			"Typical thresholds are 1e-3 to 1e-2 (default 0 = no screening).";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.exxScreenThreshold, 0., "threshold", true);
+		if(e.cntrl.exxScreenThreshold < 0.) throw string("<threshold> must be >= 0");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.cntrl.exxScreenThreshold);
+	}
+}
+commandExchangeScreening;
@@ -103,7 +103,10 @@ struct CommandTargetMu : public Command
 			"Setting <outerLoop>=yes instead performs a sequence of conventional fixed-charge\n"
 			"optimizations, adjusting mu in an outer loop using the secant method.\n"
 			"This is usually much slower, and is only recommended if the default\n"
-			"direct grand canonical method fails.";
+			"direct grand canonical method fails.\n"
+			"\n"
+			"With electronic-scf, key mixNelectrons=yes instead mixes the electron count\n"
+			"along with the density in a single SCF loop (overriding <outerLoop>).";
 
 		require("fluid-cation");
 		require("fluid-anion");
@@ -126,6 +129,59 @@ commandTargetMu;
 
 //-------------------------------------------------------------------------------------------------
 
+EnumStringMap<bool> scanVariableMap
+(	false, "mu",
+	true, "charge"
+);
+
+struct CommandElectrodeScan : public Command
+{
+	CommandElectrodeScan() : Command("electrode-scan", "jdftx/Electronic/Parameters")
+	{
+		format = "<variable>=" + scanVariableMap.optionList() + " <value1> [<value2> ...]";
+		comments =
+			"After the main calculation, converge the electronic and fluid state at each of\n"
+			"the listed values of <variable> in turn, at the final ionic positions, to obtain\n"
+			"a charge-potential curve in one run without repeating setup:\n"
+			"\n+ mu: target chemical potentials in Hartrees (requires target-mu for the main calculation)\n"
+			"\n+ charge: net excess electrons compared to a neutral system (requires fixed charge)\n"
+			"\n"
+			"Each point starts from the wavefunctions, auxiliary Hamiltonian, electron count and\n"
+			"(linear) fluid state of the previous point, extrapolated linearly from the previous two.\n"
+			"Each point is dumped at End with $INPUT = <input>.scan<index>, and mu, electron count,\n"
+			"free energy and differential capacitance at all points are summarized at the end.";
+		
+		require("elec-smearing");
+		forbid("ionic-dynamics");
+		forbid("lattice-minimize");
+		forbid("vibrations");
+		forbid("nudged-elastic-band");
+		forbid("solvation-batch");
+		forbid("fix-electron-density");
+		forbid("fix-electron-potential");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.eInfo.scanCharge, false, scanVariableMap, "variable", true);
+		e.eInfo.scanValues.clear();
+		while(true)
+		{	double value = NAN;
+			pl.get(value, double(NAN), "value");
+			if(std::isnan(value)) break;
+			e.eInfo.scanValues.push_back(value);
+		}
+		if(!e.eInfo.scanValues.size()) throw string("At least one <value> must be specified");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", scanVariableMap.getString(e.eInfo.scanCharge));
+		for(double value: e.eInfo.scanValues) logPrintf(" %lg", value);
+	}
+}
+commandElectrodeScan;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandTargetBz : public Command
 {
 	CommandTargetBz() : Command("target-Bz", "jdftx/Electronic/Parameters")
@@ -223,6 +279,8 @@ struct CommandElecInitialFillings : public Command
 			"  Default: 0 => fillings file has same number of bands as this run.";
 		
 		forbid("initial-state");
+		forbid("initial-checkpoint");
+		forbid("state-store");
 	}
 
 	void process(ParamList& pl, Everything& e)
@@ -248,6 +306,7 @@ struct CommandElecInitialEigenvals : public Command
 		comments = "Read the initial eigenvalues for variable fillings (default: derive from subspace hamiltonian)\n";
 		
 		forbid("initial-state");
+		forbid("initial-checkpoint");
 	}
 
 	void process(ParamList& pl, Everything& e)
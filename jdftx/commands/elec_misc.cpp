@@ -19,6 +19,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <commands/command.h>
 #include <electronic/Everything.h>
+#include <electronic/Checkpoint.h>
 
 //! @file elec_misc.cpp Miscellaneous properties of the electronic system
 
@@ -49,6 +50,48 @@ commandElecCutoff;
 
 //-------------------------------------------------------------------------------------------------
 
+struct CommandElecCutoffLadder : public Command
+{
+	CommandElecCutoffLadder() : Command("elec-cutoff-ladder", "jdftx/Electronic/Parameters")
+	{
+		format = "<Ecut1> [<Ecut2> ...]";
+		comments = "Converge the electronic state first at each of a list of increasing cutoffs (in Hartree)\n"
+			"below <Ecut> of elec-cutoff, before continuing the calculation at <Ecut>.\n"
+			"All rungs use the grids set up for <Ecut> / <EcutRho>. Between rungs, the wavefunctions\n"
+			"are expanded in memory to the next basis by mapping coefficients by G-vector, so that\n"
+			"each rung starts from the converged state of the previous one.\n"
+			"After each rung, the end-of-run outputs (see dump) are written with $INPUT replaced\n"
+			"by $INPUT.Ecut<Ecut>, caching results for an Ecut convergence study in one run.\n"
+			"Not supported with exact exchange or band-streaming.";
+		require("elec-cutoff");
+		forbid("fix-electron-density");
+		forbid("fix-electron-potential");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	std::vector<double>& ladder = e.cntrl.EcutLadder;
+		ladder.clear();
+		while(true)
+		{	double Ecut = 0.;
+			pl.get(Ecut, 0., "Ecut" + string(std::to_string(ladder.size()+1).c_str()), !ladder.size());
+			if(!Ecut) break;
+			if(Ecut <= 0. || Ecut >= e.cntrl.Ecut)
+				throw string("Cutoffs in the ladder must be positive and less than <Ecut> of elec-cutoff");
+			if(ladder.size() && Ecut <= ladder.back())
+				throw string("Cutoffs in the ladder must be in increasing order");
+			ladder.push_back(Ecut);
+		}
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	for(double Ecut: e.cntrl.EcutLadder)
+			logPrintf(" %lg", Ecut);
+	}
+}
+commandElecCutoffLadder;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandFftbox : public Command
 {
 	CommandFftbox() : Command("fftbox", "jdftx/Electronic/Parameters")
@@ -72,6 +115,34 @@ commandFftbox;
 
 //-------------------------------------------------------------------------------------------------
 
+struct CommandFftboxTune : public Command
+{
+	CommandFftboxTune() : Command("fftbox-tune", "jdftx/Electronic/Parameters")
+	{
+		format = "[<maxExcess>=0.25]";
+		comments = "Time candidate FFT box sizes at startup and use the fastest, instead of the smallest.\n"
+			"Candidates are the FFT-suitable, symmetry-compatible boxes with up to a fraction\n"
+			"<maxExcess> more grid points than the smallest one, since a slightly larger box\n"
+			"with only small prime factors is often faster (especially with cuFFT).\n"
+			"The timings and choice are logged, and timings are cached for this machine\n"
+			"(see <cacheFile> of performance-profile), so that later runs skip the measurement.\n"
+			"Also applies to the tighter wavefunction grid, if any.";
+		forbid("fftbox");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.gInfo.fftBoxTuneExcess, 0.25, "maxExcess");
+		if(e.gInfo.fftBoxTuneExcess <= 0.) throw string("<maxExcess> must be positive");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.gInfo.fftBoxTuneExcess);
+	}
+}
+commandFftboxTune;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandElecNbands : public Command
 {
 	CommandElecNbands() : Command("elec-n-bands", "jdftx/Electronic/Parameters")
@@ -122,6 +193,68 @@ commandDavidsonBandRatio;
 
 //-------------------------------------------------------------------------------------------------
 
+struct CommandElecPartialBandTolerance : public Command
+{
+	CommandElecPartialBandTolerance() : Command("elec-partial-band-tolerance", "jdftx/Electronic/Optimization")
+	{
+		format = "<fThreshold> [<tolScale>=100]";
+		comments =
+			"In SCF calculations, converge bands whose fillings (in the range [0,1], from the\n"
+			"previous SCF iteration) are below <fThreshold> with a residual threshold looser by\n"
+			"a factor of <tolScale> in the Davidson and LOBPCG eigensolvers. These bands lock\n"
+			"early and drop out of subspace expansions and Hamiltonian applications, while the\n"
+			"occupied manifold is converged as tightly as before. Any extra Davidson working\n"
+			"bands are treated as empty.\n"
+			"\n"
+			"This mainly helps metals with large smearing widths, which need many nearly-empty\n"
+			"bands to cover the smearing tail. Bands that become occupied over the SCF cycle are\n"
+			"tightened automatically in the next cycle, so that the converged SCF is unaffected\n"
+			"for <fThreshold> well below the fillings that matter (eg. 1e-6 to 1e-3).";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.partialBandThreshold, 0., "fThreshold", true);
+		pl.get(e.cntrl.partialBandTolScale, 100., "tolScale");
+		if(e.cntrl.partialBandThreshold < 0. or e.cntrl.partialBandThreshold > 1.)
+			throw string("<fThreshold> must be in [0,1]");
+		if(e.cntrl.partialBandTolScale < 1.)
+			throw string("<tolScale> must be at least 1");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg %lg", e.cntrl.partialBandThreshold, e.cntrl.partialBandTolScale);
+	}
+}
+commandElecPartialBandTolerance;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandChebyshevFilterDegree : public Command
+{
+	CommandChebyshevFilterDegree() : Command("chebyshev-filter-degree", "jdftx/Electronic/Optimization")
+	{
+		format = "[<degree>=10]";
+		comments =
+			"Degree of the Chebyshev polynomial filter applied per iteration of\n"
+			"elec-eigen-algo Chebyshev. Higher degrees converge in fewer iterations\n"
+			"(and Rayleigh-Ritz steps) at the cost of more Hamiltonian applications each.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.chebyshevDegree, 10, "degree");
+		if(e.cntrl.chebyshevDegree < 1)
+			throw string("<degree> must be at least 1");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.cntrl.chebyshevDegree);
+	}
+}
+commandChebyshevFilterDegree;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandLcaoParams : public Command
 {
 	CommandLcaoParams() : Command("lcao-params", "jdftx/Initialization")
@@ -196,6 +329,7 @@ struct CommandFixElectronHamiltonian : public Command
 			"(or spin " + name + ") read from the specified <filenamePattern>.\n"
 			"This pattern must include $VAR which will be replaced by the appropriate\n"
 			"variable names accounting for spin-polarization (same as used for dump).\n"
+			"Alternately, specify a checkpoint file (with .h5 extension) written by dump variable Checkpoint.\n"
 			"Meta-GGA calculations will also require the corresponding kinetic " + name + ".";
 		
 		require("spintype");
@@ -209,8 +343,14 @@ struct CommandFixElectronHamiltonian : public Command
 
 	void processCommon(ParamList& pl, Everything& e, string& targetFilenamePattern)
 	{	pl.get(targetFilenamePattern, string(), "filenamePattern", true);
-		if(targetFilenamePattern.find("$VAR") == string::npos)
-			throw string("<filenamePattern> must contain $VAR");
+		if(Checkpoint::isCheckpointFile(targetFilenamePattern))
+		{
+			#ifndef HDF5_ENABLED
+			throw string("Reading checkpoint files requires HDF5 support (CMake option EnableHDF5)");
+			#endif
+		}
+		else if(targetFilenamePattern.find("$VAR") == string::npos)
+			throw string("<filenamePattern> must contain $VAR or be a checkpoint file (.h5)");
 		e.cntrl.fixed_H = true;
 	}
 
@@ -235,6 +375,46 @@ commandFixElectronPotential;
 
 //-------------------------------------------------------------------------------------------------
 
+struct CommandHarrisFoulkes : public Command
+{
+	CommandHarrisFoulkes() : Command("harris-foulkes", "jdftx/Electronic/Optimization")
+	{
+		format = "[<densityPattern>]";
+		comments =
+			"Bypass self-consistency and ionic minimization: perform a single band structure\n"
+			"solve in the Hamiltonian of an input density, and report the Harris-Foulkes energy\n"
+			"and (approximate) forces, eg. for cheap pre-screening of many configurations.\n"
+			"The input density is the superposition of atomic densities by default, or is read\n"
+			"from <densityPattern> specified as for fix-electron-density (containing $VAR, or a\n"
+			"checkpoint file). The error in the energy is second order in the input density error.\n"
+			"Requires a density-only functional (no exact exchange, meta-GGA or DFT+U).";
+		
+		forbid("fix-electron-density");
+		forbid("fix-electron-potential");
+		forbid("dump-only");
+		forbid("ionic-dynamics");
+		forbid("lattice-minimize");
+		forbid("vibrations");
+		forbid("nudged-elastic-band");
+		forbid("electrode-scan");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	string& pattern = e.cntrl.harrisDensityPattern;
+		pl.get(pattern, string(), "densityPattern");
+		if(pattern.length() && !Checkpoint::isCheckpointFile(pattern) && pattern.find("$VAR")==string::npos)
+			throw string("<densityPattern> must contain $VAR or be a checkpoint file (.h5)");
+		e.cntrl.harrisFoulkes = true;
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", e.cntrl.harrisDensityPattern.c_str());
+	}
+}
+commandHarrisFoulkes;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandConvergeEmptyStates : public Command
 {
 	CommandConvergeEmptyStates() : Command("converge-empty-states", "jdftx/Electronic/Optimization")
@@ -280,27 +460,406 @@ commandWavefunctionDrag;
 
 //-------------------------------------------------------------------------------------------------
 
+static EnumStringMap<WfnsExtrapolation> wfnsExtrapolationMap
+(	WfnsExtrapolationNone, "none",
+	WfnsExtrapolationLinear, "linear",
+	WfnsExtrapolationQuadratic, "quadratic",
+	WfnsExtrapolationASPC, "ASPC"
+);
+
+struct CommandWavefunctionExtrapolation : public Command
+{
+	CommandWavefunctionExtrapolation() : Command("wavefunction-extrapolation", "jdftx/Ionic/Optimization")
+	{
+		format = "<scheme>=" + wfnsExtrapolationMap.optionList();
+		comments =
+			"Extrapolate wavefunctions from converged results at previous ionic steps\n"
+			"(with subspace alignment), replacing wavefunction-drag once two previous\n"
+			"steps are available. The density follows from the extrapolated wavefunctions.\n"
+			"+ none: no extrapolation (default).\n"
+			"+ linear: first order, scaled by the projection of the new ionic step on the previous one.\n"
+			"+ quadratic: second order, in ionic dynamics only (equal time steps).\n"
+			"+ ASPC: always-stable predictor coefficients of Kolafa (2.5, -2, 0.5), in ionic dynamics only.\n"
+			"Quadratic and ASPC fall back to linear during minimization (unequal steps).\n"
+			"Each previous step retained costs memory equal to that of the wavefunctions.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.wfnsExtrapolation, WfnsExtrapolationNone, wfnsExtrapolationMap, "scheme");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", wfnsExtrapolationMap.getString(e.cntrl.wfnsExtrapolation));
+	}
+}
+commandWavefunctionExtrapolation;
+
+//-------------------------------------------------------------------------------------------------
+
+static EnumStringMap<IonicPreconditioner> ionicPreconditionerMap
+(	IonicPreconditionerNone, "none",
+	IonicPreconditionerExp, "exponential"
+);
+
+struct CommandIonicPreconditioner : public Command
+{
+	CommandIonicPreconditioner() : Command("ionic-preconditioner", "jdftx/Ionic/Optimization")
+	{
+		format = "<type>=" + ionicPreconditionerMap.optionList() + " [<A>=3] [<rCut>=2]";
+		comments =
+			"Precondition ionic minimization with a model Hessian built from interatomic distances:\n"
+			"+ none: only the per-atom move scale factors (default).\n"
+			"+ exponential: the exponential preconditioner of Packwood et al. (J. Chem. Phys. 144, 164109 (2016)),\n"
+			"   which couples atoms i and j within <rCut> nearest-neighbour distances r_nn by exp(-<A> (r_ij/r_nn - 1)),\n"
+			"   normalized to unit mean diagonal, so that step sizes remain comparable to the default.\n"
+			"The exponential preconditioner speeds up relaxations dominated by soft, collective\n"
+			"modes (such as floppy adsorbates or molecules) which the default treats like stiff bonds.\n"
+			"It is rebuilt when atoms move by more than 0.1 r_nn, and does not apply to ionic dynamics.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.ionicPreconditioner, IonicPreconditionerNone, ionicPreconditionerMap, "type");
+		pl.get(e.cntrl.ionicPrecondA, 3., "A");
+		pl.get(e.cntrl.ionicPrecondRcut, 2., "rCut");
+		if(e.cntrl.ionicPrecondA <= 0.) throw string("<A> must be positive");
+		if(e.cntrl.ionicPrecondRcut < 1.) throw string("<rCut> must be at least 1 (nearest-neighbour distance)");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %lg %lg", ionicPreconditionerMap.getString(e.cntrl.ionicPreconditioner),
+			e.cntrl.ionicPrecondA, e.cntrl.ionicPrecondRcut);
+	}
+}
+commandIonicPreconditioner;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandIonicHistoryFile : public Command
+{
+	CommandIonicHistoryFile() : Command("ionic-history-file", "jdftx/Ionic/Optimization")
+	{
+		format = "<filename>";
+		comments =
+			"Persist the L-BFGS history of ionic minimization (ionic-minimize dirUpdateScheme L-BFGS)\n"
+			"in <filename>, which is rewritten after every ionic step. If present with the same number\n"
+			"of atoms at the start of ionic minimization, the history is restored, so that a relaxation\n"
+			"restarted from its latest positions continues with the curvature information accumulated\n"
+			"so far, instead of starting over along the gradient.";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.ionicHistoryFile, string(), "filename", true);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", e.cntrl.ionicHistoryFile.c_str());
+	}
+}
+commandIonicHistoryFile;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandIonicAdaptiveElecThreshold : public Command
+{
+	CommandIonicAdaptiveElecThreshold() : Command("ionic-adaptive-elec-threshold", "jdftx/Ionic/Optimization")
+	{
+		format = "<forceFraction> [<maxThreshold>=1e-4]";
+		comments =
+			"Converge electrons less tightly at the early steps of ionic or lattice minimization,\n"
+			"where forces are large. Each step uses an electronic energy threshold (the energyDiffThreshold\n"
+			"of electronic-minimize, or of electronic-scf for SCF, which also scales residualThreshold)\n"
+			"for which the estimated force error, sqrt(threshold * 1 Eh/a0^2), is <forceFraction> of the\n"
+			"largest force at the previous step, capped at <maxThreshold> Eh.\n"
+			"The threshold never drops below the specified one, which is hence recovered automatically\n"
+			"as forces approach convergence, leaving the final geometry unchanged.\n"
+			"A <forceFraction> of 0.1 typically saves a third or more of the electronic iterations of\n"
+			"a relaxation. Does not apply to ionic dynamics.";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.adaptiveElecForceFraction, 0., "forceFraction", true);
+		pl.get(e.cntrl.adaptiveElecThresholdMax, 1e-4, "maxThreshold");
+		if(e.cntrl.adaptiveElecForceFraction <= 0.) throw string("<forceFraction> must be positive");
+		if(e.cntrl.adaptiveElecThresholdMax <= 0.) throw string("<maxThreshold> must be positive");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg %lg", e.cntrl.adaptiveElecForceFraction, e.cntrl.adaptiveElecThresholdMax);
+	}
+}
+commandIonicAdaptiveElecThreshold;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandCacheProjectors : public Command
 {
 	CommandCacheProjectors() : Command("cache-projectors", "jdftx/Miscellaneous")
 	{
-		format = "yes|no";
+		format = "yes|no [<maxMB>=0]";
 		comments =
-			"Cache nonlocal-pseudopotential projectors (yes by default); turn off to save memory.";
+			"Cache nonlocal-pseudopotential projectors (yes by default); turn off to save memory.\n"
+			"Optionally, <maxMB> limits the memory (per process) used by the cache:\n"
+			"the least-recently used projectors are evicted beyond this budget, and\n"
+			"recomputed on the fly when next needed. The default 0 leaves it unlimited.";
 	}
 
 	void process(ParamList& pl, Everything& e)
 	{	pl.get(e.cntrl.cacheProjectors, true, boolMap, "shouldCache", true);
+		pl.get(e.cntrl.projectorCacheMB, 0., "maxMB");
+		if(e.cntrl.projectorCacheMB < 0.) throw string("<maxMB> must be non-negative");
 	}
 
 	void printStatus(Everything& e, int iRep)
-	{	logPrintf("%s", boolMap.getString(e.cntrl.cacheProjectors));
+	{	logPrintf("%s %lg", boolMap.getString(e.cntrl.cacheProjectors), e.cntrl.projectorCacheMB);
 	}
 }
 commandCacheProjectors;
 
 //-------------------------------------------------------------------------------------------------
 
+struct CommandRealSpaceProjectors : public Command
+{
+	CommandRealSpaceProjectors() : Command("real-space-projectors", "jdftx/Miscellaneous")
+	{
+		format = "<rCut>";
+		comments =
+			"Apply nonlocal-pseudopotential projectors to wavefunctions in real space,\n"
+			"truncating the projectors of each atom to a sphere of radius <rCut> bohrs.\n"
+			"The cost of projection then scales as the number of atoms times the number\n"
+			"of grid points per sphere, rather than the full basis, at the expense of\n"
+			"one additional pair of wavefunction FFTs per projection. This pays off\n"
+			"for large cells (hundreds of atoms), where it is recommended.\n"
+			"The fraction of the projector norm captured within the spheres is reported\n"
+			"for each species, and should be close to 1 (increase <rCut> otherwise).\n"
+			"Forces and stresses still use reciprocal-space projector derivatives.\n"
+			"The default 0 keeps the projections in reciprocal space.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.realSpaceProjectorRadius, 0., "rCut");
+		if(e.cntrl.realSpaceProjectorRadius < 0.) throw string("<rCut> must be non-negative");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.cntrl.realSpaceProjectorRadius);
+	}
+}
+commandRealSpaceProjectors;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandFftBatchSize : public Command
+{
+	CommandFftBatchSize() : Command("fft-batch-size", "jdftx/Miscellaneous")
+	{
+		format = "<nBands>";
+		comments =
+			"Number of bands transformed together using batched FFT plans in\n"
+			"wavefunction operations (applying local potentials and computing densities).\n"
+			"Larger values reduce per-transform overhead, which is especially\n"
+			"important on GPUs, at the expense of greater memory requirements.\n"
+			"A value of 0 selects 8 on GPUs and 1 (unbatched) on CPUs. (Default: 0)";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.fftBatchSize, 0, "nBands", true);
+		if(e.cntrl.fftBatchSize < 0) throw string("<nBands> must be >= 0");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.cntrl.fftBatchSize);
+	}
+}
+commandFftBatchSize;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandFftSinglePrecision : public Command
+{
+	CommandFftSinglePrecision() : Command("fft-single-precision", "jdftx/Miscellaneous")
+	{
+		format = "<dEthreshold>";
+		comments =
+			"Perform wavefunction FFTs (applying local potentials and computing densities)\n"
+			"in single precision during early electronic iterations, and switch to double precision\n"
+			"for the rest of the run once the free energy changes by less than <dEthreshold>\n"
+			"(in Hartrees) between successive electronic minimize / SCF iterations.\n"
+			"Should be well above the final energy convergence threshold (eg. 1e-4).\n"
+			"Requires a build with EnableSinglePrecisionFFT, and is currently CPU only.";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.fftSinglePrecisionThreshold, 0., "dEthreshold", true);
+		if(e.cntrl.fftSinglePrecisionThreshold <= 0.) throw string("<dEthreshold> must be positive");
+		#if !defined(FFTW_SINGLE_ENABLED) || defined(GPU_ENABLED)
+		throw string("single-precision FFTs require a CPU build with EnableSinglePrecisionFFT");
+		#endif
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.cntrl.fftSinglePrecisionThreshold);
+	}
+}
+commandFftSinglePrecision;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandFftPruning : public Command
+{
+	CommandFftPruning() : Command("fft-pruning", "jdftx/Miscellaneous")
+	{
+		format = "<enable>=" + boolMap.optionList();
+		comments =
+			"Whether wavefunction FFTs (applying local potentials and computing densities)\n"
+			"skip the lines and planes of the FFT box that contain no basis G-vectors,\n"
+			"transforming only the sticks within the wavefunction cutoff sphere in the first pass.\n"
+			"Gamma-point calculations continue to pair real wavefunctions in unbatched transforms instead.\n"
+			"Currently CPU only, and not combined with single-precision FFTs. (Default: yes)";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.fftPruning, true, boolMap, "enable");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.cntrl.fftPruning));
+	}
+}
+commandFftPruning;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandHamiltonianBlockSize : public Command
+{
+	CommandHamiltonianBlockSize() : Command("hamiltonian-block-size", "jdftx/Miscellaneous")
+	{
+		format = "<nBands>";
+		comments =
+			"Apply the local potential, kinetic and nonlocal pseudopotential terms of the\n"
+			"Hamiltonian to blocks of <nBands> bands at a time (projectors are shared by all blocks).\n"
+			"Smaller blocks keep each block's wavefunctions and gradients in cache across these terms,\n"
+			"and reduce temporary memory, but should be at least the number of threads (or\n"
+			"a multiple of fft-batch-size) for efficient threading. A value of 0 applies\n"
+			"each term to all bands at once. (Default: 0)";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.hamiltonianBlockSize, 0, "nBands", true);
+		if(e.cntrl.hamiltonianBlockSize < 0) throw string("<nBands> must be >= 0");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.cntrl.hamiltonianBlockSize);
+	}
+}
+commandHamiltonianBlockSize;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandKpointBatchSize : public Command
+{
+	CommandKpointBatchSize() : Command("kpoint-batch-size", "jdftx/Miscellaneous")
+	{
+		format = "<nStates>";
+		comments =
+			"Apply the local potential to the wavefunctions of <nStates> k-points / spin states\n"
+			"of each process together, with bands of all these states filling each batch of\n"
+			"fft-batch-size transforms. Useful on GPUs for small cells with many k-points, where\n"
+			"the bands of a single state underfill the batched FFTs; set fft-batch-size to about\n"
+			"<nStates> times the number of bands in that case. Kinetic and nonlocal terms are\n"
+			"still applied state by state. Not used for noncollinear magnetism. (Default: 1)";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.kpointBatchSize, 1, "nStates", true);
+		if(e.cntrl.kpointBatchSize < 1) throw string("<nStates> must be >= 1");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%d", e.cntrl.kpointBatchSize);
+	}
+}
+commandKpointBatchSize;
+
+//-------------------------------------------------------------------------------------------------
+
+struct CommandBandStreaming : public Command
+{
+	CommandBandStreaming() : Command("band-streaming", "jdftx/Electronic/Optimization")
+	{
+		format = "<yes|no>";
+		comments =
+			"In fixed-Hamiltonian (band structure) calculations, process one k-point / spin state\n"
+			"at a time: initialize its wavefunctions, converge them, write them to the wfns\n"
+			"output (if the State is dumped at End) and free them along with their projectors\n"
+			"before moving on to the next state. Memory for wavefunctions is then independent\n"
+			"of the number of k-points, which is useful for band paths and unfolding meshes\n"
+			"with thousands of k-points (only eigenvalues are retained for all states).\n"
+			"\n"
+			"Wavefunctions are initialized from the lowest subspace eigenvectors of the atomic\n"
+			"orbitals (random if wavefunction random is specified), since wavefunctions are\n"
+			"not read in. Requires fix-electron-density or fix-electron-potential, and not\n"
+			"exact exchange. End dumps that require wavefunctions (band projections, momenta etc.)\n"
+			"are not available in this mode. (Default: no)";
+		forbid("vibrations");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.bandStreaming, false, boolMap, "yes|no");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.cntrl.bandStreaming));
+	}
+}
+commandBandStreaming;
+
+//-------------------------------------------------------------------------------------------------
+
+static EnumStringMap<ManagedMemoryBase::Tier> residencyTierMap
+(	ManagedMemoryBase::TierDevice, "device",
+	ManagedMemoryBase::TierHost, "host",
+	ManagedMemoryBase::TierDisk, "disk"
+);
+static EnumStringMap<ManagedMemoryBase::Tier> residencyTierDescMap
+(	ManagedMemoryBase::TierDevice, "keep wavefunctions where they were last used (default)",
+	ManagedMemoryBase::TierHost, "move wavefunctions and their gradients out of GPU memory to host memory between uses (no effect on CPU runs)",
+	ManagedMemoryBase::TierDisk, "write wavefunctions and their gradients to scratch files in <spillDir> between uses, freeing them from GPU and host memory"
+);
+
+struct CommandWavefunctionResidency : public Command
+{
+	CommandWavefunctionResidency() : Command("wavefunction-residency", "jdftx/Electronic/Optimization")
+	{
+		format = "<tier>=" + residencyTierMap.optionList() + " [<spillDir>=.]";
+		comments =
+			"Select where the wavefunctions of each k-point / spin state (and the corresponding\n"
+			"minimizer gradients and search directions) live while other states are being processed:"
+			+ addDescriptions(residencyTierMap.optionList(), linkDescription(residencyTierMap, residencyTierDescMap))
+			+ "\n\nEvicted states are restored automatically when next used, so that only the state being\n"
+			"processed needs to fit in GPU memory with host, and also in host memory with disk.\n"
+			"This allows GPU runs with many more k-points per GPU, at the cost of the transfers\n"
+			"(two round trips per state per electronic iteration). Preferably, <spillDir> should be\n"
+			"on fast node-local storage (such as NVMe); scratch files are removed automatically.";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(ManagedMemoryBase::evictionTier, ManagedMemoryBase::TierDevice, residencyTierMap, "tier");
+		pl.get(ManagedMemoryBase::spillDir, string("."), "spillDir");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %s", residencyTierMap.getString(ManagedMemoryBase::evictionTier), ManagedMemoryBase::spillDir.c_str());
+	}
+}
+commandWavefunctionResidency;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandBasis : public Command
 {
 	CommandBasis() : Command("basis", "jdftx/Electronic/Parameters")
@@ -323,14 +882,21 @@ commandBasis;
 
 //-------------------------------------------------------------------------------------------------
 
-static EnumStringMap<ElecEigenAlgo> elecEigenMap(ElecEigenCG, "CG", ElecEigenDavidson, "Davidson");
+static EnumStringMap<ElecEigenAlgo> elecEigenMap(ElecEigenCG, "CG", ElecEigenDavidson, "Davidson", ElecEigenLOBPCG, "LOBPCG", ElecEigenChebyshev, "Chebyshev");
 
 struct CommandElecEigenAlgo : public Command
 {
     CommandElecEigenAlgo() : Command("elec-eigen-algo", "jdftx/Electronic/Optimization")
 	{
 		format = "<algo>=" + elecEigenMap.optionList();
-		comments = "Selects eigenvalue algorithm for band-structure calculations or inner loop of SCF.";
+		comments = "Selects eigenvalue algorithm for band-structure calculations or inner loop of SCF.\n"
+			"+ CG: conjugate-gradients band minimizer.\n"
+			"+ Davidson: block Davidson (default; requires nBasis > 2 x nBands x davidsonBandRatio).\n"
+			"+ LOBPCG: locally-optimal block preconditioned CG with soft-locking of converged bands,\n"
+			"  which does not need the enlarged working set of Davidson.\n"
+			"+ Chebyshev: Chebyshev-filtered subspace iteration (see chebyshev-filter-degree),\n"
+			"  using only block Hamiltonian applications and one Rayleigh-Ritz step per iteration;\n"
+			"  best suited to SCF on large (metallic) systems with many bands.";
 		hasDefault = true;
 	}
 
@@ -346,6 +912,35 @@ commandElecEigenAlgo;
 
 //-------------------------------------------------------------------------------------------------
 
+static EnumStringMap<SubspaceOrtho> subspaceOrthoMap(SubspaceOrthoLowdin, "Lowdin", SubspaceOrthoCholesky, "Cholesky");
+
+struct CommandSubspaceOrthonormalization : public Command
+{
+	CommandSubspaceOrthonormalization() : Command("subspace-orthonormalization", "jdftx/Electronic/Optimization")
+	{
+		format = "<method>=" + subspaceOrthoMap.optionList();
+		comments = "Orthonormalization used where only the span of the result matters: the Rayleigh-Ritz\n"
+			"steps of the Davidson, LOBPCG and Chebyshev eigensolvers, and the ACE exact-exchange construction.\n"
+			"+ Lowdin: symmetric orthonormalization via diagonalization of the overlap (default).\n"
+			"+ Cholesky: Cholesky-QR via the inverse Cholesky factor of the overlap, repeated once (CholQR2)\n"
+			"  for ill-conditioned overlaps, and falling back to Lowdin for nearly linearly-dependent ones.\n"
+			"  Cholesky factorization is several times cheaper than diagonalization, especially on GPUs.\n"
+			"Orthonormalization in the total-energy minimizer is always Lowdin, since it depends on the gauge.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.subspaceOrtho, SubspaceOrthoLowdin, subspaceOrthoMap, "method");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	fputs(subspaceOrthoMap.getString(e.cntrl.subspaceOrtho), globalLog);
+	}
+}
+commandSubspaceOrthonormalization;
+
+//-------------------------------------------------------------------------------------------------
+
 struct CommandRhoExternal : public Command
 {
 	CommandRhoExternal() : Command("rhoExternal", "jdftx/Coulomb interactions")
@@ -449,7 +1044,9 @@ struct CommandElectricField : public Command
 			"In truncated directions, the field will be applied as a ramp potential,\n"
 			"and for periodic directions, it will be applied as a plane wave with\n"
 			"the smallest commensurate wave vector and amplitude set by peak field.\n\n"
-			"Coulomb truncation, if any, must be in embedded mode (command coulomb-truncation-embed).\n"
+			"With Coulomb truncation, the ramp is centered on the point specified by either\n"
+			"coulomb-truncation-embed (double-sized box) or coulomb-truncation-center\n"
+			"(original box, with the usual L/2 localization constraint).\n"
 			"Symmetries will be automatically reduced to account for this field.";
 	}
 
@@ -141,6 +141,95 @@ struct CommandFluidSolveFrequency : public Command
 commandFluidSolveFrequency;
 
 
+struct CommandFluidInnerAdaptive : public Command
+{
+	CommandFluidInnerAdaptive() : Command("fluid-inner-adaptive", "jdftx/Fluid/Optimization")
+	{
+		format = "[<tolFactor>=0.1] [<nRecycle>=4]";
+		comments =
+			"Reduce the cost of fluid solves performed every electronic step (see fluid-solve-frequency):\n"
+			"+ <tolFactor>: loosen the fluid convergence threshold so that the estimated fluid free-energy\n"
+			"   error is at most this fraction of the latest electronic (or SCF) energy change;\n"
+			"   the thresholds in fluid-minimize remain the tightest used. Set to 0 to disable.\n"
+			"+ <nRecycle>: number of previous LinearPCM / SaLSA solutions used to extrapolate\n"
+			"   the initial guess of each new solve. Set to 0 to disable.";
+		
+		require("fluid");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	FluidSolverParams& fsp = e.eVars.fluidParams;
+		pl.get(fsp.adaptiveTolFactor, 0.1, "tolFactor");
+		pl.get(fsp.nRecycle, 4, "nRecycle");
+		if(fsp.adaptiveTolFactor < 0.) throw string("<tolFactor> must be non-negative");
+		if(fsp.nRecycle < 0) throw string("<nRecycle> must be non-negative");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	const FluidSolverParams& fsp = e.eVars.fluidParams;
+		logPrintf("%lg %d", fsp.adaptiveTolFactor, fsp.nRecycle);
+	}
+}
+commandFluidInnerAdaptive;
+
+
+struct CommandFluidEcut : public Command
+{
+	CommandFluidEcut() : Command("fluid-ecut", "jdftx/Fluid/Parameters")
+	{
+		format = "<EcutFluid>";
+		comments =
+			"Solve the fluid on a separate grid that is coarser than the electronic charge-density grid,\n"
+			"with the fftbox chosen to inscribe a charge-density cutoff of <EcutFluid> Hartrees.\n"
+			"The explicit charge and cavity-determining densities are Fourier-restricted to this grid,\n"
+			"and the fluid potentials are Fourier-interpolated back to the electronic grid.\n"
+			"The coarse grid is disabled if it would not be smaller than the electronic grid.";
+		
+		require("fluid");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	FluidSolverParams& fsp = e.eVars.fluidParams;
+		pl.get(fsp.gridEcut, 0., "EcutFluid", true);
+		if(fsp.gridEcut <= 0.) throw string("<EcutFluid> must be positive");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.eVars.fluidParams.gridEcut);
+	}
+}
+commandFluidEcut;
+
+
+struct CommandFluidMemoryBudget : public Command
+{
+	CommandFluidMemoryBudget() : Command("fluid-memory-budget", "jdftx/Fluid/Parameters")
+	{
+		format = "<budgetMB>";
+		comments =
+			"Memory budget per process, in MB, for free-energy evaluations of classical-DFT fluids.\n"
+			"The peak memory of the default evaluation is estimated at startup (and logged), and if it\n"
+			"exceeds <budgetMB>, a memory-lean mode is used instead, which allocates site-density gradients\n"
+			"only when first needed and evaluates the hard-sphere (FMT) terms incrementally, recomputing\n"
+			"real-space weighted densities rather than holding all of them with their gradients at once.\n"
+			"Results are identical; the lean mode is somewhat slower. Ignored for non-classical-DFT fluids.";
+		
+		require("fluid");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	FluidSolverParams& fsp = e.eVars.fluidParams;
+		pl.get(fsp.memoryBudgetMB, 0., "budgetMB", true);
+		if(fsp.memoryBudgetMB <= 0.) throw string("<budgetMB> must be positive");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.eVars.fluidParams.memoryBudgetMB);
+	}
+}
+commandFluidMemoryBudget;
+
+
 struct CommandFluidInitialState : public Command
 {
 	CommandFluidInitialState() : Command("fluid-initial-state", "jdftx/Initialization")
@@ -149,6 +238,8 @@ struct CommandFluidInitialState : public Command
 		comments = "Read initial state of a fluid (compatible with *.fluidState from dump End State)";
 		
 		forbid("initial-state");
+		forbid("initial-checkpoint");
+		forbid("state-store");
 	}
 
 	void process(ParamList& pl, Everything& e)
@@ -162,6 +253,43 @@ struct CommandFluidInitialState : public Command
 commandFluidInitialState;
 
 
+struct CommandSolvationBatch : public Command
+{
+	CommandSolvationBatch() : Command("solvation-batch", "jdftx/Fluid/Optimization")
+	{
+		format = "<variantFile>";
+		comments = "After the calculation specified by this input file (the reference state, eg. in vacuum),\n"
+			"repeat the electronic and fluid minimization for a fluid variant specified by <variantFile>,\n"
+			"without repeating setup. The variant file may contain only fluid commands (eg. fluid,\n"
+			"fluid-solvent, pcm-variant, pcm-params), which replace all commands of the same name in this\n"
+			"input file; other fluid commands are retained. Specify this command multiple times to screen\n"
+			"several variants in the order listed. Each variant starts from the wavefunctions of the previous\n"
+			"one (and from its fluid state for linear solvers on the same grid), is dumped at End with\n"
+			"$INPUT = <input>.<variant> (basename of <variantFile>), and the free energy of each variant\n"
+			"relative to the reference state is summarized at the end.";
+		allowMultiple = true;
+		
+		forbid("ionic-dynamics");
+		forbid("lattice-minimize");
+		forbid("vibrations");
+		forbid("nudged-elastic-band");
+		forbid("fix-electron-density");
+		forbid("fix-electron-potential");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	string filename;
+		pl.get(filename, string(), "variantFile", true);
+		e.eVars.solvationBatch.push_back(filename);
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", e.eVars.solvationBatch[iRep].c_str());
+	}
+}
+commandSolvationBatch;
+
+
 struct CommandFluidVdwScale : public Command
 {
 	CommandFluidVdwScale() : Command("fluid-vdwScale", "jdftx/Fluid/Parameters")
@@ -239,7 +367,8 @@ EnumStringMap<FluidComponent::TranslationMode> translationModeMap
 EnumStringMap<FluidComponent::Representation> representationMap
 (	FluidComponent::MuEps, "MuEps",
 	FluidComponent::Pomega, "Pomega",
-	FluidComponent::PsiAlpha, "PsiAlpha"
+	FluidComponent::PsiAlpha, "PsiAlpha",
+	FluidComponent::Ylm, "Ylm"
 );
 
 const EnumStringMap<S2quadType>& s2quadTypeMap = S2quadTypeMap;
@@ -258,6 +387,7 @@ enum FluidComponentMember
 	//Extras for ClassicalDFT:
 	FCM_epsLJ, //!< Lennard-Jones well depth for Mean-Field LJ excess functional
 	FCM_representation, //!< ideal gas representation
+	FCM_lmax, //!< angular momentum cutoff for Ylm representation
 	FCM_s2quadType, //!< orientation quadrature type
 	FCM_quad_nBeta, //!< number of beta samples for Euler quadrature
 	FCM_quad_nAlpha, //!< number of alpha samples for Euler quadrature
@@ -279,6 +409,7 @@ EnumStringMap<FluidComponentMember> fcmMap
 	FCM_poleEl,        "poleEl",
 	FCM_epsLJ,          "epsLJ",
 	FCM_representation, "representation",
+	FCM_lmax,           "lmax",
 	FCM_s2quadType,     "s2quadType",
 	FCM_quad_nBeta,     "quad_nBeta",
 	FCM_quad_nAlpha,    "quad_nAlpha",
@@ -298,6 +429,7 @@ EnumStringMap<FluidComponentMember> fcmDescMap
 	FCM_poleEl, "electronic response Lorentz poles with parameters ( omega0[eV] gamma0[eV] A0 ). [specify multiple times for several poles, with A0 adding up to 1]",
 	FCM_epsLJ, "Lennard-Jones well depth for Mean-Field LJ excess functional",
 	FCM_representation, "ideal gas representation: " + addDescriptions(representationMap.optionList(), nullDescription, "\n   - "),
+	FCM_lmax, "angular momentum cutoff (at most 6) for the site translations in the Ylm representation",
 	FCM_s2quadType, "orientation quadrature type:" + addDescriptions(s2quadTypeMap.optionList(), nullDescription, "\n   - "),
 	FCM_quad_nBeta, "number of beta samples for Euler quadrature",
 	FCM_quad_nAlpha, "number of alpha samples for Euler quadrature",
@@ -398,6 +530,7 @@ public:
 				}
 				READ_AND_CHECK(epsLJ, >, 0.)
 				READ_ENUM(representation, FluidComponent::MuEps)
+				READ_AND_CHECK(lmax, <=, 6u)
 				READ_ENUM(s2quadType, QuadOctahedron)
 				READ_AND_CHECK(quad_nBeta, >, 0u)
 				READ_AND_CHECK(quad_nAlpha, >=, 0u)
@@ -435,6 +568,7 @@ public:
 		if(e.eVars.fluidParams.fluidType == FluidClassicalDFT)
 		{	PRINT(epsLJ)
 			PRINT_ENUM(representation)
+			PRINT_UINT(lmax)
 			PRINT_ENUM(s2quadType)
 			PRINT_UINT(quad_nBeta)
 			PRINT_UINT(quad_nAlpha)
@@ -20,6 +20,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <commands/command.h>
 #include <electronic/Everything.h>
 #include <electronic/ColumnBundle.h>
+#include <electronic/Checkpoint.h>
+#include <electronic/StateStore.h>
 
 struct CommandInitialState : public Command
 {
@@ -42,6 +44,8 @@ struct CommandInitialState : public Command
 		forbid("elec-initial-fillings");
 		forbid("elec-initial-eigenvals");
 		forbid("fluid-initial-state");
+		forbid("initial-checkpoint");
+		forbid("state-store");
 	}
 
 	void process(ParamList& pl, Everything& e)
@@ -81,6 +85,93 @@ void setAvailableFilenames(string filenamePattern, Everything& e)
 
 //-----------------------------------------------------------------------
 
+struct CommandInitialCheckpoint : public Command
+{
+	CommandInitialCheckpoint() : Command("initial-checkpoint", "jdftx/Initialization")
+	{
+		format = "<filename>";
+		comments = "Initialize state from an HDF5 checkpoint (.h5) written by dump variable Checkpoint.\n"
+			"This reads the wavefunctions, fillings, eigenvalues and fluid state from\n"
+			"the sections present in the file, and is otherwise analogous to initial-state.\n"
+			"The number of bands may differ from the current calculation (extra bands are\n"
+			"discarded and missing ones randomized), but the k-points and plane-wave basis\n"
+			"must match (use initial-state with separate files to change Ecut or lattice).\n"
+			"Requires HDF5 support (CMake option EnableHDF5).";
+		
+		forbid("initial-state");
+		forbid("wavefunction");
+		forbid("elec-initial-fillings");
+		forbid("elec-initial-eigenvals");
+		forbid("fluid-initial-state");
+		forbid("state-store");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(filename, string(), "filename", true);
+		#ifndef HDF5_ENABLED
+		throw string("Reading checkpoint files requires HDF5 support (CMake option EnableHDF5)");
+		#endif
+		if(!Checkpoint::isCheckpointFile(filename)) throw string("<filename> must have the extension .h5");
+		if(!isReadable(filename)) throw string("Checkpoint file '" + filename + "' is not readable");
+		std::set<string> sections = Checkpoint::contents(filename);
+		if(sections.count("wfns")) e.eVars.wfnsFilename = filename;
+		if(sections.count("fillings"))
+		{	e.eInfo.initialFillingsFilename = filename;
+			e.eInfo.nBandsOld = Checkpoint::nBands(filename);
+		}
+		if(sections.count("eigenvals")) e.eVars.eigsFilename = filename;
+		if(sections.count("fluidState")) e.eVars.fluidInitialStateFilename = filename;
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	fputs(filename.c_str(), globalLog);
+	}
+
+private:
+	string filename;
+}
+commandInitialCheckpoint;
+
+//-----------------------------------------------------------------------
+
+struct CommandStateStore : public Command
+{
+	CommandStateStore() : Command("state-store", "jdftx/Initialization")
+	{
+		format = "<directory> [<maxDisplacement>=0.5]";
+		comments = "Share converged states between calculations of related structures through <directory>,\n"
+			"which must exist and may be shared by many jobs (e.g. of a high-throughput screening).\n"
+			"At startup, the index in <directory> is searched for states of the same species, atom counts\n"
+			"and lattice vectors, with the same k-points, symmetries and spin type, and the one with the\n"
+			"smallest RMS atomic displacement (in bohrs, at most <maxDisplacement>) initializes the\n"
+			"wavefunctions, fillings and (if on the same grid) fluid state, as with initial-state.\n"
+			"The stored number of bands and cutoff may differ from the current calculation,\n"
+			"and are converted as with the <nBandsOld> and <EcutOld> options of wavefunction read.\n"
+			"At the end of the calculation, the converged state is added to <directory> and its index\n"
+			"(except for dump-only, fixed-Hamiltonian and band-streaming calculations).";
+		
+		forbid("initial-state");
+		forbid("initial-checkpoint");
+		forbid("wavefunction");
+		forbid("elec-initial-fillings");
+		forbid("fluid-initial-state");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	e.stateStore = std::make_shared<StateStore>();
+		pl.get(e.stateStore->directory, string(), "directory", true);
+		pl.get(e.stateStore->maxDisplacement, 0.5, "maxDisplacement");
+		if(e.stateStore->maxDisplacement < 0.) throw string("<maxDisplacement> must be non-negative");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %lg", e.stateStore->directory.c_str(), e.stateStore->maxDisplacement);
+	}
+}
+commandStateStore;
+
+//-----------------------------------------------------------------------
+
 enum WfnsInit { WfnsLCAO, WfnsRandom, WfnsRead, WfnsReadRS };
 
 EnumStringMap<WfnsInit> wfnsInitMap(
@@ -89,6 +180,31 @@ EnumStringMap<WfnsInit> wfnsInitMap(
 	WfnsRead, "read",
 	WfnsReadRS, "read-rs" );
 
+struct CommandReadAggregate : public Command
+{
+	CommandReadAggregate() : Command("read-aggregate", "jdftx/Initialization")
+	{
+		format = "<yes|no>";
+		comments =
+			"Read wavefunctions (see wavefunction read and initial-state) through one reader per node:\n"
+			"the first process of each node opens the file and reads the contiguous data of all\n"
+			"processes on that node, and sends it to them over MPI. This avoids every process\n"
+			"opening and seeking in the same file, which can overwhelm the metadata servers of\n"
+			"parallel filesystems at large process counts. Each process on a node needs a buffer\n"
+			"of the size of its own stored wavefunctions during the read. (Default: no)";
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.readAggregate, false, boolMap, "yes|no");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.cntrl.readAggregate));
+	}
+}
+commandReadAggregate;
+
+
 struct CommandWavefunction : public Command
 {
 	CommandWavefunction() : Command("wavefunction", "jdftx/Initialization")
@@ -118,6 +234,8 @@ struct CommandWavefunction : public Command
 		hasDefault = false;
 		
 		forbid("initial-state");
+		forbid("initial-checkpoint");
+		forbid("state-store");
 	}
 
 	void process(ParamList& pl, Everything& e)
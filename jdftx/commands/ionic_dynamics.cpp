@@ -21,13 +21,15 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <commands/ParamList.h>
 #include <electronic/Everything.h>
 #include <electronic/IonicDynamicsParams.h>
+#include <electronic/IpiDriver.h>
 #include <core/Units.h>
 
 
 EnumStringMap<IonicDynamicsParams::StatMethod> statMethodMap
 (	IonicDynamicsParams::StatNone, "None",
 	IonicDynamicsParams::Berendsen, "Berendsen",
-	IonicDynamicsParams::NoseHoover, "NoseHoover"
+	IonicDynamicsParams::NoseHoover, "NoseHoover",
+	IonicDynamicsParams::Langevin, "Langevin"
 );
 
 //An enum entry for each configurable option of IonicDynamicsParams
@@ -43,6 +45,11 @@ enum IonicDynamicsParamsMember
 	IDPM_chainLengthT,
 	IDPM_chainLengthP,
 	IDPM_B0,
+	IDPM_nInnerSteps,
+	IDPM_surrogateThreshold,
+	IDPM_surrogateRcut,
+	IDPM_surrogateNradial,
+	IDPM_surrogateMaxSteps,
 	IDPM_Delim //!< delimiter to detect end of input
 };
 
@@ -57,7 +64,12 @@ EnumStringMap<IonicDynamicsParamsMember> idpmMap
 	IDPM_tDampP, "tDampP",
 	IDPM_chainLengthT, "chainLengthT",
 	IDPM_chainLengthP, "chainLengthP",
-	IDPM_B0, "B0"
+	IDPM_B0, "B0",
+	IDPM_nInnerSteps, "nInnerSteps",
+	IDPM_surrogateThreshold, "surrogateThreshold",
+	IDPM_surrogateRcut, "surrogateRcut",
+	IDPM_surrogateNradial, "surrogateNradial",
+	IDPM_surrogateMaxSteps, "surrogateMaxSteps"
 );
 
 EnumStringMap<IonicDynamicsParamsMember> idpmDescMap
@@ -71,7 +83,12 @@ EnumStringMap<IonicDynamicsParamsMember> idpmDescMap
 	IDPM_tDampP, "barostat damping time [fs]",
 	IDPM_chainLengthT, "Nose-Hoover chain length for thermostat",
 	IDPM_chainLengthP, "Nose-Hoover chain length for barostat",
-	IDPM_B0, "Characteristic bulk modulus [bar] for Berendsen barostat (damping ~ B0 * tDampP)"
+	IDPM_B0, "Characteristic bulk modulus [bar] for Berendsen barostat (damping ~ B0 * tDampP)",
+	IDPM_nInnerSteps, "number of substeps with pair-potential forces per time step (default: 1 => single time step)",
+	IDPM_surrogateThreshold, "force uncertainty [Eh/a0] below which a fitted surrogate replaces DFT steps (default: 0 => no surrogate)",
+	IDPM_surrogateRcut, "cutoff radius [bohrs] of surrogate descriptors (default: 10)",
+	IDPM_surrogateNradial, "number of radial functions per neighbor species in surrogate descriptors (default: 8)",
+	IDPM_surrogateMaxSteps, "maximum consecutive surrogate steps before a DFT step (default: 20)"
 );
 
 struct CommandIonicDynamics : public Command
@@ -89,7 +106,17 @@ struct CommandIonicDynamics : public Command
 		+ addDescriptions(idpmMap.optionList(), linkDescription(idpmMap, idpmDescMap))
 		+ "\n\nAny number of these key-value pairs may be specified in any order.\n\n"
 			"Note that nSteps must be non-zero to activate dynamics.\n"
-			"Default mode is NVE; specify statMethod to add a thermostat or barostat";
+			"Default mode is NVE; specify statMethod to add a thermostat or barostat.\n"
+			"Langevin selects the BAOAB Langevin integrator with friction 1/tDampT (thermostat only).\n"
+			"With nInnerSteps > 1, the pair-potential forces are integrated on the inner time step\n"
+			"(reversible RESPA), so that dt may be set by the slower DFT forces alone.\n"
+			"Barostats are only supported with nInnerSteps = 1 and statMethod Berendsen or NoseHoover.\n"
+			"\n"
+			"With surrogateThreshold > 0, a linear model in local radial descriptors is fit on the fly\n"
+			"to the DFT energies and forces of the trajectory, and replaces the DFT calculation at steps\n"
+			"where its estimated force uncertainty is below surrogateThreshold (after at least 3 DFT steps,\n"
+			"and at most surrogateMaxSteps in a row). DFT steps are added to the training set.\n"
+			"The surrogate is not supported with barostats.";
 	}
 
 	void process(ParamList& pl, Everything& e)
@@ -122,9 +149,34 @@ struct CommandIonicDynamics : public Command
 				case IDPM_chainLengthT: pl.get(idp.chainLengthT, 3, "chainLengthT", true); break;
 				case IDPM_chainLengthP: pl.get(idp.chainLengthP, 3, "chainLengthP", true); break;
 				case IDPM_B0: pl.get(idp.B0, nanVal, "B0", true); idp.B0 *= Bar; break;
+				case IDPM_nInnerSteps:
+					pl.get(idp.nInnerSteps, 1, "nInnerSteps", true);
+					if(idp.nInnerSteps < 1) throw(string("nInnerSteps must be at least 1"));
+					break;
+				case IDPM_surrogateThreshold:
+					pl.get(idp.surrogateThreshold, 0., "surrogateThreshold", true);
+					if(idp.surrogateThreshold < 0.) throw(string("surrogateThreshold must be non-negative"));
+					break;
+				case IDPM_surrogateRcut:
+					pl.get(idp.surrogateRcut, 10., "surrogateRcut", true);
+					if(idp.surrogateRcut <= 0.) throw(string("surrogateRcut must be positive"));
+					break;
+				case IDPM_surrogateNradial:
+					pl.get(idp.surrogateNradial, 8, "surrogateNradial", true);
+					if(idp.surrogateNradial < 1) throw(string("surrogateNradial must be at least 1"));
+					break;
+				case IDPM_surrogateMaxSteps:
+					pl.get(idp.surrogateMaxSteps, 20, "surrogateMaxSteps", true);
+					if(idp.surrogateMaxSteps < 1) throw(string("surrogateMaxSteps must be at least 1"));
+					break;
 				case IDPM_Delim: 
 					if((not std::isnan(idp.P0)) and (not std::isnan(trace(idp.stress0))))
 						throw(string("Cannot specify both P0 (hydrostatic) and stress0 (anisotropic) barostats"));
+					if(((not std::isnan(idp.P0)) or (not std::isnan(trace(idp.stress0))))
+						and (idp.statMethod==IonicDynamicsParams::Langevin or idp.nInnerSteps>1))
+						throw(string("Barostats require statMethod Berendsen or NoseHoover, with nInnerSteps = 1"));
+					if(((not std::isnan(idp.P0)) or (not std::isnan(trace(idp.stress0)))) and idp.surrogateThreshold)
+						throw(string("Surrogate potential (surrogateThreshold > 0) is not supported with barostats"));
 					return; //end of input
 			}
 		}
@@ -145,6 +197,11 @@ struct CommandIonicDynamics : public Command
 		logPrintf(" \\\n\tchainLengthT %d", idp.chainLengthT);
 		logPrintf(" \\\n\tchainLengthP %d", idp.chainLengthP);
 		logPrintf(" \\\n\tB0           %lg", idp.B0/Bar);
+		logPrintf(" \\\n\tnInnerSteps  %d", idp.nInnerSteps);
+		logPrintf(" \\\n\tsurrogateThreshold %lg", idp.surrogateThreshold);
+		logPrintf(" \\\n\tsurrogateRcut      %lg", idp.surrogateRcut);
+		logPrintf(" \\\n\tsurrogateNradial   %d", idp.surrogateNradial);
+		logPrintf(" \\\n\tsurrogateMaxSteps  %d", idp.surrogateMaxSteps);
 	}
 }
 commandIonicDynamics;
@@ -174,6 +231,44 @@ struct CommandLjOverride : public Command
 }
 commandLjOverride;
 
+
+struct CommandIpiDriver : public Command
+{
+	CommandIpiDriver() : Command("ipi-driver", "jdftx/Ionic/Optimization")
+	{
+		format = "<address> [<port>=0]";
+		comments =
+			"Run as a persistent force engine for an external code speaking the i-PI socket protocol,\n"
+			"such as i-PI itself or ASE's SocketIOCalculator, instead of ionic minimization or dynamics.\n"
+			"JDFTx connects as a client to the server at <address>:<port>, or to the UNIX socket\n"
+			"/tmp/ipi_<address> if <port> = 0, and evaluates energy, forces and virial at each set of\n"
+			"lattice vectors and positions it receives, till the server sends EXIT.\n"
+			"\n"
+			"The calculation is set up only once, and each configuration starts from the converged\n"
+			"wavefunctions of the previous one, dragged to the new positions and lattice (see wavefunction-drag\n"
+			"and wavefunction-extrapolation), which avoids process start-up and LCAO at each step.\n"
+			"The server must send atoms in the order of the ion commands in the input file.\n"
+			"Symmetries are disabled since the server may move atoms arbitrarily,\n"
+			"and stress is always computed for the virial.";
+		
+		forbid("ionic-dynamics");
+		forbid("lattice-minimize");
+		forbid("vibrations");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	e.ipiDriver = std::make_shared<IpiDriver>();
+		pl.get(e.ipiDriver->address, string(), "address", true);
+		pl.get(e.ipiDriver->port, 0, "port");
+		if(e.ipiDriver->port < 0) throw(string("<port> must be non-negative"));
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %d", e.ipiDriver->address.c_str(), e.ipiDriver->port);
+	}
+}
+commandIpiDriver;
+
 //---- Thermostat / barostat velocities ----
 struct CommandStatVelocity : public Command
 {
@@ -230,6 +230,33 @@ struct CommandLattMoveScale : public Command
 }
 commandLattMoveScale;
 
+struct CommandStrainPredictor : public Command
+{
+	CommandStrainPredictor() : Command("strain-predictor", "jdftx/Ionic/Optimization")
+	{
+		format = "yes|no";
+		comments =
+			"Predict wavefunctions at each new lattice of a lattice minimization (or barostatted\n"
+			"dynamics) by linear extrapolation from those converged at the two previous lattices\n"
+			"(with subspace alignment), instead of dragging them with atomic orbitals (no by default).\n"
+			"Wavefunction coefficients are stored on the fixed reciprocal lattice basis, so a previous\n"
+			"result carries over to the new lattice by rescaling the basis with the strain; the\n"
+			"extrapolation coefficient is set by the projection of the new step in strain and ionic\n"
+			"positions on the previous one. The two retained steps cost memory equal to twice that\n"
+			"of the wavefunctions.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.strainPredictor, false, boolMap, "enable");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.cntrl.strainPredictor));
+	}
+}
+commandStrainPredictor;
+
 EnumStringMap<CoordsType> coordsMap(
 	CoordsLattice, "Lattice",
 	CoordsCartesian, "Cartesian" );
@@ -27,6 +27,12 @@ EnumStringMap<MinimizeParams::DirectionUpdateScheme> dirUpdateMap
 	MinimizeParams::SteepestDescent, "SteepestDescent"
 );
 
+EnumStringMap<MinimizeParams::HistoryStorage> historyStorageMap
+(	MinimizeParams::HistoryFull, "Full",
+	MinimizeParams::HistoryHost, "Host",
+	MinimizeParams::HistoryHostSingle, "HostSingle"
+);
+
 EnumStringMap<MinimizeParams::LinminMethod> linminMap
 (	MinimizeParams::DirUpdateRecommended, "DirUpdateRecommended",
 	MinimizeParams::Relax, "Relax",
@@ -40,6 +46,8 @@ enum MinimizeParamsMember
 	MPM_linminMethod,
 	MPM_nIterations,
 	MPM_history,
+	MPM_historyStorage,
+	MPM_nRecycle,
 	MPM_knormThreshold,
 	MPM_energyDiffThreshold,
 	MPM_nEnergyDiff,
@@ -60,6 +68,8 @@ EnumStringMap<MinimizeParamsMember> mpmMap
 	MPM_linminMethod, "linminMethod",
 	MPM_nIterations, "nIterations",
 	MPM_history, "history",
+	MPM_historyStorage, "historyStorage",
+	MPM_nRecycle, "nRecycle",
 	MPM_knormThreshold, "knormThreshold",
 	MPM_energyDiffThreshold, "energyDiffThreshold",
 	MPM_nEnergyDiff, "nEnergyDiff",
@@ -78,6 +88,8 @@ EnumStringMap<MinimizeParamsMember> mpmDescMap
 	MPM_linminMethod, linminMap.optionList() + " (line minimization method)",
 	MPM_nIterations, "maximum iterations (single point calculation if 0)",
 	MPM_history, "number of past states and gradients retained for L-BFGS",
+	MPM_historyStorage, historyStorageMap.optionList() + " (L-BFGS history with the variables, or in host memory in double / single precision: electronic minimization only)",
+	MPM_nRecycle, "number of lowest Ritz vectors recycled between successive linear solves to deflate CG (linear fluid solvers only)",
 	MPM_knormThreshold, "convergence threshold for gradient (preconditioned) norm",
 	MPM_energyDiffThreshold, "convergence threshold for energy difference between successive iterations",
 	MPM_nEnergyDiff, "number of iteration pairs that must satisfy energyDiffThreshold",
@@ -112,6 +124,8 @@ void CommandMinimize::process(ParamList& pl, Everything& e)
 			case MPM_linminMethod: pl.get(mp.linminMethod, MinimizeParams::Quad, linminMap, "linminMethod", true); break;
 			case MPM_nIterations: pl.get(mp.nIterations, 0, "nIterations", true); break;
 			case MPM_history: pl.get(mp.history, 0, "history", true); break;
+			case MPM_historyStorage: pl.get(mp.historyStorage, MinimizeParams::HistoryFull, historyStorageMap, "historyStorage", true); break;
+			case MPM_nRecycle: pl.get(mp.nRecycle, 0, "nRecycle", true); break;
 			case MPM_knormThreshold: pl.get(mp.knormThreshold, 0., "knormThreshold", true); break;
 			case MPM_energyDiffThreshold: pl.get(mp.energyDiffThreshold, 0., "energyDiffThreshold", true); break;
 			case MPM_nEnergyDiff: pl.get(mp.nEnergyDiff, 0, "nEnergyDiff", true); break;
@@ -135,6 +149,8 @@ void CommandMinimize::printStatus(Everything& e, int iRep)
 	logPrintf(" \\\n\tlinminMethod         %s", linminMap.getString(mp.linminMethod));
 	logPrintf(" \\\n\tnIterations          %d", mp.nIterations);
 	logPrintf(" \\\n\thistory              %d", mp.history);
+	logPrintf(" \\\n\thistoryStorage       %s", historyStorageMap.getString(mp.historyStorage));
+	logPrintf(" \\\n\tnRecycle             %d", mp.nRecycle);
 	logPrintf(" \\\n\tknormThreshold       %lg", mp.knormThreshold);
 	logPrintf(" \\\n\tenergyDiffThreshold  %lg", mp.energyDiffThreshold);
 	logPrintf(" \\\n\tnEnergyDiff          %d", mp.nEnergyDiff);
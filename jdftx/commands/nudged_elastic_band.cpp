@@ -0,0 +1,120 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <commands/command.h>
+#include <commands/ParamList.h>
+#include <electronic/Everything.h>
+#include <electronic/NudgedElasticBandParams.h>
+
+//An enum entry for each configurable option of NudgedElasticBandParams
+enum NudgedElasticBandParamsMember
+{	NEBPM_nImages,
+	NEBPM_finalIons,
+	NEBPM_springK,
+	NEBPM_climbing,
+	NEBPM_nIterations,
+	NEBPM_fMax,
+	NEBPM_maxStep,
+	NEBPM_Delim //!< delimiter to detect end of input
+};
+
+EnumStringMap<NudgedElasticBandParamsMember> nebpmMap
+(	NEBPM_nImages, "nImages",
+	NEBPM_finalIons, "finalIons",
+	NEBPM_springK, "springK",
+	NEBPM_climbing, "climbing",
+	NEBPM_nIterations, "nIterations",
+	NEBPM_fMax, "fMax",
+	NEBPM_maxStep, "maxStep"
+);
+
+EnumStringMap<NudgedElasticBandParamsMember> nebpmDescMap
+(	NEBPM_nImages, "number of intermediate images between initial and final states (0 => no NEB calculation)",
+	NEBPM_finalIons, "file containing ion commands for the final state (eg. ionpos dumped from a relaxation)",
+	NEBPM_springK, "spring constant between adjacent images [Eh/a0^2]",
+	NEBPM_climbing, "yes/no: whether the highest energy image climbs to the saddle point (CI-NEB)",
+	NEBPM_nIterations, "maximum number of band optimization steps",
+	NEBPM_fMax, "convergence threshold on maximum NEB force per atom [Eh/a0]",
+	NEBPM_maxStep, "maximum displacement of any atom per step [a0]"
+);
+
+struct CommandNudgedElasticBand : public Command
+{
+	CommandNudgedElasticBand() : Command("nudged-elastic-band", "jdftx/Ionic/Optimization")
+	{	format = "<key1> <value1> <key2> <value2> ...";
+		comments = "Find the minimum energy path between the initial state (ion commands of this input file)\n"
+			"and a final state using the nudged elastic band method, controlled by keys:"
+		+ addDescriptions(nebpmMap.optionList(), linkDescription(nebpmMap, nebpmDescMap))
+		+ "\n\nAny number of these key-value pairs may be specified in any order.\n\n"
+			"Note that nImages and finalIons must be specified to activate NEB.\n"
+			"Processes are divided into groups that compute different images concurrently,\n"
+			"with each image logged to <input>.image<i>.out and dumped with $INPUT = <input>.image<i>.\n"
+			"The band is optimized using FIRE, with wavefunctions of each image dragged between steps.\n"
+			"The final state must contain the same species and number of atoms in the same order,\n"
+			"and symmetries must be turned off (symmetries none).";
+		require("ion");
+		forbid("ionic-dynamics");
+		forbid("lattice-minimize");
+		forbid("vibrations");
+		forbid("fix-electron-density");
+		forbid("fix-electron-potential");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	NudgedElasticBandParams& nebp = e.nebParams;
+		while(true)
+		{	NudgedElasticBandParamsMember key;
+			pl.get(key, NEBPM_Delim, nebpmMap, "key");
+			switch(key)
+			{	case NEBPM_nImages:
+					pl.get(nebp.nImages, 0, "nImages", true);
+					if(nebp.nImages < 0) throw(string("nImages must be non-negative"));
+					break;
+				case NEBPM_finalIons: pl.get(nebp.finalIons, string(), "finalIons", true); break;
+				case NEBPM_springK:
+					pl.get(nebp.springK, 0.005, "springK", true);
+					if(nebp.springK <= 0.) throw(string("springK must be positive"));
+					break;
+				case NEBPM_climbing: pl.get(nebp.climbing, true, boolMap, "climbing", true); break;
+				case NEBPM_nIterations: pl.get(nebp.nIterations, 100, "nIterations", true); break;
+				case NEBPM_fMax: pl.get(nebp.fMax, 1e-3, "fMax", true); break;
+				case NEBPM_maxStep:
+					pl.get(nebp.maxStep, 0.2, "maxStep", true);
+					if(nebp.maxStep <= 0.) throw(string("maxStep must be positive"));
+					break;
+				case NEBPM_Delim:
+					if(nebp.nImages and (not nebp.finalIons.length()))
+						throw(string("finalIons must be specified for a NEB calculation"));
+					return; //end of input
+			}
+		}
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	const NudgedElasticBandParams& nebp = e.nebParams;
+		logPrintf(" \\\n\tnImages     %d", nebp.nImages);
+		logPrintf(" \\\n\tfinalIons   %s", nebp.finalIons.c_str());
+		logPrintf(" \\\n\tspringK     %lg", nebp.springK);
+		logPrintf(" \\\n\tclimbing    %s", boolMap.getString(nebp.climbing));
+		logPrintf(" \\\n\tnIterations %d", nebp.nIterations);
+		logPrintf(" \\\n\tfMax        %lg", nebp.fMax);
+		logPrintf(" \\\n\tmaxStep     %lg", nebp.maxStep);
+	}
+}
+commandNudgedElasticBand;
@@ -259,6 +259,35 @@ struct CommandPcmNonlinearDebug : public Command
 commandPcmNonlinearDebug;
 
 
+struct CommandPcmCavityReuse : public Command
+{
+	CommandPcmCavityReuse() : Command("pcm-cavity-reuse", "jdftx/Fluid/Optimization")
+	{
+		format = "<threshold>";
+		comments =
+			"Reuse the previously computed PCM cavity (shape functions and cavitation energy) while the\n"
+			"cavity-determining electron density (and the solute charge density, for CANDLE) differ from\n"
+			"those used to compute it by less than <threshold> electrons/bohr^3 at every grid point.\n"
+			"Dispersion terms are still recomputed at each call since they depend on atomic positions.\n"
+			"The cavity is always recomputed for stress calculations, and is unaffected for\n"
+			"SoftSphere and FixedCavity variants, which do not depend on the electron density.";
+		
+		require("fluid");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	FluidSolverParams& fsp = e.eVars.fluidParams;
+		pl.get(fsp.cavityReuseThreshold, 0., "threshold", true);
+		if(fsp.cavityReuseThreshold < 0.) throw string("<threshold> must be non-negative");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%lg", e.eVars.fluidParams.cavityReuseThreshold);
+	}
+}
+commandPcmCavityReuse;
+
+
 
 struct CommandIonWidth : public Command
 {
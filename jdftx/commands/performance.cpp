@@ -0,0 +1,67 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <commands/command.h>
+#include <electronic/Everything.h>
+
+EnumStringMap<PerformanceProfile> performanceProfileMap
+(	PerformanceDefault, "default",
+	PerformanceThroughput, "throughput",
+	PerformanceMemoryLean, "memory-lean",
+	PerformanceLatency, "latency"
+);
+EnumStringMap<PerformanceProfile> performanceProfileDescMap
+(	PerformanceDefault, "no preset: individual settings alone (default)",
+	PerformanceThroughput, "larger FFT batches (fft-batch-size 4, or 16 on GPUs), kpoint-batch-size 4 on GPUs and exchange-block-size 32",
+	PerformanceMemoryLean, "fft-batch-size 1, hamiltonian-block-size 32, exchange-block-size 8, davidson-band-ratio 1, a 256 MB projector cache and SCF history 5",
+	PerformanceLatency, "davidson-band-ratio 1.5 and SCF history 15, for fewer iterations in small calculations"
+);
+
+struct CommandPerformanceProfile : public Command
+{
+	CommandPerformanceProfile() : Command("performance-profile", "jdftx/Miscellaneous")
+	{
+		format = "<profile>=" + performanceProfileMap.optionList() + " [<autoTune>=no] [<cacheFile>]";
+		comments =
+			"Select a preset of performance-related settings, one of:"
+			+ addDescriptions(performanceProfileMap.optionList(), linkDescription(performanceProfileMap, performanceProfileDescMap))
+			+ "\n\nPresets only change settings left at their defaults, so any of them can still be\n"
+			"overridden by the corresponding command, and they never change convergence thresholds.\n"
+			"The settings changed are listed in the log.\n"
+			"\n"
+			"If <autoTune>=yes, time trial values of fft-batch-size and hamiltonian-block-size\n"
+			"(whichever are not set explicitly) on the wavefunction grid at startup and use the fastest.\n"
+			"Results are cached in <cacheFile> (default: ~/.jdftx-tuning), keyed by host name,\n"
+			"device, thread count, FFT box, basis size and band count, and reused by later runs\n"
+			"of the same size on the same machine.";
+		hasDefault = true;
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.cntrl.perfProfile, PerformanceDefault, performanceProfileMap, "profile");
+		pl.get(e.cntrl.perfAutoTune, false, boolMap, "autoTune");
+		pl.get(e.cntrl.perfTuneFile, string(), "cacheFile");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s %s", performanceProfileMap.getString(e.cntrl.perfProfile), boolMap.getString(e.cntrl.perfAutoTune));
+		if(e.cntrl.perfTuneFile.length()) logPrintf(" %s", e.cntrl.perfTuneFile.c_str());
+	}
+}
+commandPerformanceProfile;
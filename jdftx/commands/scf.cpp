@@ -28,7 +28,9 @@ enum PulayParamsMember
 	PPM_residualThreshold,
 	PPM_mixFraction,
 	PPM_qMetric,
-	PPM_history
+	PPM_history,
+	PPM_mixingScheme,
+	PPM_historyPruneFactor
 };
 
 EnumStringMap<PulayParamsMember> pulayParamsMap
@@ -37,7 +39,9 @@ EnumStringMap<PulayParamsMember> pulayParamsMap
 	PPM_residualThreshold, "residualThreshold",
 	PPM_mixFraction, "mixFraction",
 	PPM_qMetric, "qMetric",
-	PPM_history, "history"
+	PPM_history, "history",
+	PPM_mixingScheme, "mixingScheme",
+	PPM_historyPruneFactor, "historyPruneFactor"
 );
 
 EnumStringMap<PulayParamsMember> pulayParamsDescMap
@@ -46,7 +50,14 @@ EnumStringMap<PulayParamsMember> pulayParamsDescMap
 	PPM_residualThreshold, "convergence threshold for the residual in the mixed variable",
 	PPM_mixFraction, "mix fraction (default 0.5)",
 	PPM_qMetric, "wavevector controlling the metric for overlaps (default: 0.8 bohr^-1)",
-	PPM_history, "number of past residuals that are cached and used for mixing"
+	PPM_history, "number of past residuals that are cached and used for mixing",
+	PPM_mixingScheme, "Pulay (default) or Broyden (Johnson's modified Broyden, weighted towards recent iterations)",
+	PPM_historyPruneFactor, "discard past entries whose residual norm exceeds this multiple of the latest one (default: 0 = never)"
+);
+
+EnumStringMap<PulayParams::MixingScheme> mixingSchemeMap
+(	PulayParams::MixingPulay, "Pulay",
+	PulayParams::MixingBroyden, "Broyden"
 );
 
 //Base class for pulay-mixing commands
@@ -74,6 +85,8 @@ protected:
 					case PPM_mixFraction: pl.get(pp.mixFraction, 0.5, "mixFraction", true); break;
 					case PPM_qMetric: pl.get(pp.qMetric, 0.8, "qMetric", true); break;
 					case PPM_history: pl.get(pp.history, 10, "history", true); if(pp.history<1) throw string("<history> must be >= 1"); break;
+					case PPM_mixingScheme: pl.get(pp.mixingScheme, PulayParams::MixingPulay, mixingSchemeMap, "mixingScheme", true); break;
+					case PPM_historyPruneFactor: pl.get(pp.historyPruneFactor, 0., "historyPruneFactor", true); if(pp.historyPruneFactor<0.) throw string("<historyPruneFactor> must be >= 0"); break;
 				}
 			}
 			else process_sub(keyStr, pl, e);
@@ -89,6 +102,8 @@ protected:
 		PRINT(mixFraction, %lg)
 		PRINT(qMetric, %lg)
 		PRINT(history, %d)
+		logPrintf(" \\\n\tmixingScheme\t%s", mixingSchemeMap.getString(pp.mixingScheme));
+		PRINT(historyPruneFactor, %lg)
 		#undef PRINT
 	}
 	
@@ -105,8 +120,10 @@ enum SCFparamsMember
 	SCFpm_mixedVariable,
 	SCFpm_qKerker,
 	SCFpm_qKappa,
+	SCFpm_epsResta,
 	SCFpm_verbose,
-	SCFpm_mixFractionMag
+	SCFpm_mixFractionMag,
+	SCFpm_mixNelectrons
 };
 
 EnumStringMap<SCFparamsMember> scfParamsMap
@@ -115,8 +132,10 @@ EnumStringMap<SCFparamsMember> scfParamsMap
 	SCFpm_mixedVariable, "mixedVariable",
 	SCFpm_qKerker, "qKerker",
 	SCFpm_qKappa, "qKappa",
+	SCFpm_epsResta, "epsResta",
 	SCFpm_verbose, "verbose",
-	SCFpm_mixFractionMag, "mixFractionMag"
+	SCFpm_mixFractionMag, "mixFractionMag",
+	SCFpm_mixNelectrons, "mixNelectrons"
 );
 EnumStringMap<SCFparamsMember> scfParamsDescMap
 (	SCFpm_nEigSteps, "number of eigenvalue steps per iteration (if 0, limited by electronic-minimize nIterations)",
@@ -124,8 +143,10 @@ EnumStringMap<SCFparamsMember> scfParamsDescMap
 	SCFpm_mixedVariable, "whether density or potential will be mixed at each step",
 	SCFpm_qKerker, "wavevector controlling Kerker preconditioning (default: 0.8 bohr^-1)",
 	SCFpm_qKappa, "wavevector for long-range damping. If negative (default), set to zero or fluid Debye wavevector as appropriate",
+	SCFpm_epsResta, "if > 1, dielectric constant for Resta-model preconditioning with screening wavevector qKerker, suited to semiconducting / insulating systems (default: 0 = Kerker)",
 	SCFpm_verbose, "whether the inner eigenvalue solver will print or not",
-	SCFpm_mixFractionMag, "mix fraction for magnetization density / potential (default 1.5)"
+	SCFpm_mixFractionMag, "mix fraction for magnetization density / potential (default 1.5)",
+	SCFpm_mixNelectrons, "with target-mu, mix the electron count along with the density, preconditioned by the fluid capacitance (default: no)"
 );
 
 EnumStringMap<SCFparams::MixedVariable> scfMixing
@@ -166,8 +187,10 @@ struct CommandElectronicScf: public CommandPulay
 				case SCFpm_mixedVariable: pl.get(sp.mixedVariable, SCFparams::MV_Density, scfMixing, "mixedVariable", true); break;
 				case SCFpm_qKerker: pl.get(sp.qKerker, 0.8, "qKerker", true); break;
 				case SCFpm_qKappa: pl.get(sp.qKappa, -1., "qKappa", true); break;
+				case SCFpm_epsResta: pl.get(sp.epsResta, 0., "epsResta", true); if(sp.epsResta && sp.epsResta<=1.) throw string("<epsResta> must be > 1 (or 0 to disable)"); break;
 				case SCFpm_verbose: pl.get(sp.verbose, false, boolMap, "verbose", true); break;
 				case SCFpm_mixFractionMag: pl.get(sp.mixFractionMag, 1.5, "mixFractionMag", true); break;
+				case SCFpm_mixNelectrons: pl.get(sp.mixNelectrons, false, boolMap, "mixNelectrons", true); break;
 			}
 		}
 		else throw string("Parameter <key> must be one of " + pulayParamsMap.optionList() + "|" + scfParamsMap.optionList());
@@ -182,8 +205,10 @@ struct CommandElectronicScf: public CommandPulay
 		logPrintf(" \\\n\tmixedVariable\t%s", scfMixing.getString(sp.mixedVariable));
 		PRINT(qKerker, %lg)
 		PRINT(qKappa, %lg)
+		PRINT(epsResta, %lg)
 		logPrintf(" \\\n\tverbose\t%s", boolMap.getString(sp.verbose));
 		PRINT(mixFractionMag, %lg)
+		logPrintf(" \\\n\tmixNelectrons\t%s", boolMap.getString(sp.mixNelectrons));
 		#undef PRINT
 	}
 }
@@ -222,3 +247,43 @@ struct CommandPcmNonlinearScf: public CommandPulay
 	}
 }
 commandPcmNonlinearScf;
+
+
+struct CommandPcmNonlinearNewton: public Command
+{
+	CommandPcmNonlinearNewton() : Command("pcm-nonlinear-newton", "jdftx/Fluid/Optimization")
+	{	
+		format = "[<nIterations>=20] [<threshold>=1e-8] [<nKrylov>=10] [<nInner>=10]";
+		comments =
+			"Optimize nonlinear PCM fluids using inexact Newton-Krylov steps on the electrostatic potential.\n"
+			"Each Newton step is solved by flexible GMRES, preconditioned by approximate solves of the\n"
+			"LinearPCM with the dielectric and screening response at the current potential.\n"
+			"+ <nIterations>: maximum number of Newton steps.\n"
+			"+ <threshold>: convergence threshold on the norm of the nonlinear Poisson residual relative to that of the explicit charge.\n"
+			"+ <nKrylov>: maximum GMRES subspace dimension per Newton step.\n"
+			"+ <nInner>: number of LinearPCM conjugate-gradient iterations per preconditioner application.\n"
+			"This uses the same setup as pcm-nonlinear-scf, and overrides its Pulay-mixing iterations.";
+		hasDefault = false;
+	}
+	
+	void process(ParamList& pl, Everything& e)
+	{	FluidSolverParams& fsp = e.eVars.fluidParams;
+		fsp.nonlinearSCF = true;
+		fsp.nonlinearNewton = true;
+		fsp.scfParams.fpLog = globalLog;
+		pl.get(fsp.newtonIterations, 20, "nIterations");
+		pl.get(fsp.newtonThreshold, 1e-8, "threshold");
+		pl.get(fsp.newtonKrylovDim, 10, "nKrylov");
+		pl.get(fsp.newtonInnerIterations, 10, "nInner");
+		if(fsp.newtonIterations < 0) throw string("<nIterations> must be non-negative");
+		if(fsp.newtonThreshold <= 0.) throw string("<threshold> must be positive");
+		if(fsp.newtonKrylovDim < 1) throw string("<nKrylov> must be positive");
+		if(fsp.newtonInnerIterations < 1) throw string("<nInner> must be positive");
+	}
+	
+	void printStatus(Everything& e, int iRep)
+	{	const FluidSolverParams& fsp = e.eVars.fluidParams;
+		logPrintf("%d %lg %d %d", fsp.newtonIterations, fsp.newtonThreshold, fsp.newtonKrylovDim, fsp.newtonInnerIterations);
+	}
+}
+commandPcmNonlinearNewton;
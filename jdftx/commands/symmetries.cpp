@@ -110,6 +110,31 @@ struct CommandSymmetryThreshold : public Command
 }
 commandSymmetryThreshold;
 
+
+struct CommandSymmetryIrreducibleGrid : public Command
+{
+	CommandSymmetryIrreducibleGrid() : Command("symmetry-irreducible-grid", "jdftx/Miscellaneous")
+	{
+		format = "<enable>=" + boolMap.optionList();
+		comments = "Evaluate the exchange-correlation functional only once per orbit of symmetry-equivalent\n"
+			"real-space grid points, and copy the results to the rest of each orbit. This reduces\n"
+			"the cost of the functional evaluation by up to the number of symmetries in high-symmetry\n"
+			"cells. It is disabled automatically if the fractional translations are not commensurate\n"
+			"with the FFT box.";
+		hasDefault = true;
+		require("symmetries");
+	}
+
+	void process(ParamList& pl, Everything& e)
+	{	pl.get(e.symm.irreducibleGrid, false, boolMap, "enable");
+	}
+
+	void printStatus(Everything& e, int iRep)
+	{	logPrintf("%s", boolMap.getString(e.symm.irreducibleGrid));
+	}
+}
+commandSymmetryIrreducibleGrid;
+
 struct CommandKpointReduceInversion : public Command
 {
 	CommandKpointReduceInversion() : Command("kpoint-reduce-inversion", "jdftx/Electronic/Parameters")
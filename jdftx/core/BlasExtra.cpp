@@ -85,6 +85,207 @@ void eblas_zgemm(
 	#endif
 }
 
+//------------------------------ Vectorized kernels ---------------------------------
+//Explicit SIMD versions of the complex elementwise products and scatter / gather-axpy, which compilers fail to
+//auto-vectorize because of the interleaved complex layout and the indexed access. On x86-64, AVX2 and AVX-512
+//versions are selected at runtime by function multiversioning (one binary for all CPUs of a cluster);
+//elsewhere, and on older x86 CPUs, the generic "default" loops are used. Kernels process n contiguous
+//elements; callers offset the pointers for each thread's range (indices in scatter / gather must be < 2^30).
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__INTEL_COMPILER)
+	#define SIMD_MULTIVERSION
+	#include <immintrin.h>
+	#define SIMD_DEFAULT __attribute__((target("default")))
+	#define SIMD_AVX2 __attribute__((target("avx2,fma")))
+	#define SIMD_AVX512 __attribute__((target("avx512f")))
+#else
+	#define SIMD_DEFAULT
+#endif
+
+//Resolve the (conjugated and weighted) source term of scatter / gather, x -> x*w with conjugations as in Conjugator
+inline complex sparseTerm(complex x, bool conjx, const complex* w, size_t iw, bool conjw)
+{	if(conjx) x = x.conj();
+	if(w) x *= (conjw ? w[iw].conj() : w[iw]);
+	return x;
+}
+
+//y[i] *= x[i] (or conj(x[i]) if conjx)
+SIMD_DEFAULT void zmulSimd(size_t n, const complex* x, complex* y, bool conjx)
+{	if(conjx) for(size_t i=0; i<n; i++) y[i] *= x[i].conj();
+	else for(size_t i=0; i<n; i++) y[i] *= x[i];
+}
+//y[i] *= x[i] for real x
+SIMD_DEFAULT void zmuldSimd(size_t n, const double* x, complex* y)
+{	for(size_t i=0; i<n; i++) y[i] *= x[i];
+}
+//y[i] += a * (x[index[i]] conjugated / weighted by w[i] as in Conjugator)
+SIMD_DEFAULT void gatherSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	for(size_t i=0; i<n; i++) y[i] += a * sparseTerm(x[index[i]], conjx, w, i, conjw);
+}
+//y[index[i]] += a * (x[i] conjugated / weighted by w[i] as in Conjugator)
+SIMD_DEFAULT void scatterSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	for(size_t i=0; i<n; i++) y[index[i]] += a * sparseTerm(x[i], conjx, w, i, conjw);
+}
+
+#ifdef SIMD_MULTIVERSION
+//---- AVX2: two complex numbers per register ----
+
+SIMD_AVX2 inline __m256d cmul_avx2(__m256d a, __m256d b) //a*b
+{	__m256d bRe = _mm256_movedup_pd(b), bIm = _mm256_permute_pd(b, 0xF), aSwap = _mm256_permute_pd(a, 0x5);
+	return _mm256_fmaddsub_pd(a, bRe, _mm256_mul_pd(aSwap, bIm));
+}
+SIMD_AVX2 inline __m256d cmulc_avx2(__m256d a, __m256d b) //a*conj(b)
+{	__m256d bRe = _mm256_movedup_pd(b), bIm = _mm256_permute_pd(b, 0xF), aSwap = _mm256_permute_pd(a, 0x5);
+	return _mm256_fmsubadd_pd(a, bRe, _mm256_mul_pd(aSwap, bIm));
+}
+SIMD_AVX2 inline __m256d conj_avx2(__m256d a)
+{	return _mm256_xor_pd(a, _mm256_setr_pd(0., -0., 0., -0.));
+}
+//a * (x conjugated / weighted by w as in Conjugator), for a pair of entries
+SIMD_AVX2 inline __m256d sparseTerm_avx2(__m256d x, complex a, bool conjx, const complex* w, bool conjw)
+{	if(conjx) x = conj_avx2(x);
+	if(w)
+	{	__m256d wv = _mm256_loadu_pd((const double*)w);
+		x = conjw ? cmulc_avx2(x, wv) : cmul_avx2(x, wv);
+	}
+	return a.imag() ? cmul_avx2(x, _mm256_setr_pd(a.real(), a.imag(), a.real(), a.imag())) : _mm256_mul_pd(x, _mm256_set1_pd(a.real()));
+}
+
+SIMD_AVX2 void zmulSimd(size_t n, const complex* x, complex* y, bool conjx)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	if(conjx) for(; i+2<=n; i+=2) _mm256_storeu_pd(yd+2*i, cmulc_avx2(_mm256_loadu_pd(yd+2*i), _mm256_loadu_pd(xd+2*i)));
+	else for(; i+2<=n; i+=2) _mm256_storeu_pd(yd+2*i, cmul_avx2(_mm256_loadu_pd(yd+2*i), _mm256_loadu_pd(xd+2*i)));
+	for(; i<n; i++) y[i] *= (conjx ? x[i].conj() : x[i]);
+}
+SIMD_AVX2 void zmuldSimd(size_t n, const double* x, complex* y)
+{	double* yd = (double*)y;
+	size_t i = 0;
+	for(; i+4<=n; i+=4)
+	{	__m256d xv = _mm256_loadu_pd(x+i);
+		_mm256_storeu_pd(yd+2*i, _mm256_mul_pd(_mm256_loadu_pd(yd+2*i), _mm256_permute4x64_pd(xv, 0x50))); //x0 x0 x1 x1
+		_mm256_storeu_pd(yd+2*i+4, _mm256_mul_pd(_mm256_loadu_pd(yd+2*i+4), _mm256_permute4x64_pd(xv, 0xFA))); //x2 x2 x3 x3
+	}
+	for(; i<n; i++) y[i] *= x[i];
+}
+SIMD_AVX2 void gatherSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	for(; i+2<=n; i+=2)
+	{	__m256d xv = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(xd+2*index[i])), _mm_loadu_pd(xd+2*index[i+1]), 1);
+		_mm256_storeu_pd(yd+2*i, _mm256_add_pd(_mm256_loadu_pd(yd+2*i), sparseTerm_avx2(xv, a, conjx, w ? w+i : 0, conjw)));
+	}
+	for(; i<n; i++) y[i] += a * sparseTerm(x[index[i]], conjx, w, i, conjw);
+}
+SIMD_AVX2 void scatterSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	for(; i+2<=n; i+=2)
+	{	__m256d v = sparseTerm_avx2(_mm256_loadu_pd(xd+2*i), a, conjx, w ? w+i : 0, conjw);
+		//Accumulate one entry at a time (correct even if indices repeat):
+		double* y0 = yd+2*index[i]; _mm_storeu_pd(y0, _mm_add_pd(_mm_loadu_pd(y0), _mm256_castpd256_pd128(v)));
+		double* y1 = yd+2*index[i+1]; _mm_storeu_pd(y1, _mm_add_pd(_mm_loadu_pd(y1), _mm256_extractf128_pd(v, 1)));
+	}
+	for(; i<n; i++) y[index[i]] += a * sparseTerm(x[i], conjx, w, i, conjw);
+}
+
+//---- AVX-512: four complex numbers per register ----
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" //spurious warnings from the AVX-512 intrinsic headers of some GCC versions
+
+SIMD_AVX512 inline __m512d cmul_avx512(__m512d a, __m512d b) //a*b
+{	__m512d bRe = _mm512_unpacklo_pd(b, b), bIm = _mm512_unpackhi_pd(b, b), aSwap = _mm512_shuffle_pd(a, a, 0x55);
+	return _mm512_fmaddsub_pd(a, bRe, _mm512_mul_pd(aSwap, bIm));
+}
+SIMD_AVX512 inline __m512d cmulc_avx512(__m512d a, __m512d b) //a*conj(b)
+{	__m512d bRe = _mm512_unpacklo_pd(b, b), bIm = _mm512_unpackhi_pd(b, b), aSwap = _mm512_shuffle_pd(a, a, 0x55);
+	return _mm512_fmsubadd_pd(a, bRe, _mm512_mul_pd(aSwap, bIm));
+}
+SIMD_AVX512 inline __m512d conj_avx512(__m512d a) //(integer xor, since the floating-point one requires AVX512DQ)
+{	const __m512i signImag = _mm512_set4_epi64(0x8000000000000000LL, 0, 0x8000000000000000LL, 0); //sign bits of imaginary parts
+	return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), signImag));
+}
+//a * (x conjugated / weighted by w as in Conjugator), for four entries
+SIMD_AVX512 inline __m512d sparseTerm_avx512(__m512d x, complex a, bool conjx, const complex* w, bool conjw)
+{	if(conjx) x = conj_avx512(x);
+	if(w)
+	{	__m512d wv = _mm512_loadu_pd((const double*)w);
+		x = conjw ? cmulc_avx512(x, wv) : cmul_avx512(x, wv);
+	}
+	return a.imag()
+		? cmul_avx512(x, _mm512_setr_pd(a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag()))
+		: _mm512_mul_pd(x, _mm512_set1_pd(a.real()));
+}
+//Gather four complex numbers at index[0:4] of x:
+SIMD_AVX512 inline __m512d gather4_avx512(const double* xd, const int* index)
+{	__m256i iPairs = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)index)), _mm256_setr_epi32(0,0,1,1,2,2,3,3));
+	__m256i iDoubles = _mm256_add_epi32(_mm256_slli_epi32(iPairs, 1), _mm256_setr_epi32(0,1,0,1,0,1,0,1)); //real and imaginary parts
+	return _mm512_i32gather_pd(iDoubles, xd, 8);
+}
+
+SIMD_AVX512 void zmulSimd(size_t n, const complex* x, complex* y, bool conjx)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	if(conjx) for(; i+4<=n; i+=4) _mm512_storeu_pd(yd+2*i, cmulc_avx512(_mm512_loadu_pd(yd+2*i), _mm512_loadu_pd(xd+2*i)));
+	else for(; i+4<=n; i+=4) _mm512_storeu_pd(yd+2*i, cmul_avx512(_mm512_loadu_pd(yd+2*i), _mm512_loadu_pd(xd+2*i)));
+	for(; i<n; i++) y[i] *= (conjx ? x[i].conj() : x[i]);
+}
+SIMD_AVX512 void zmuldSimd(size_t n, const double* x, complex* y)
+{	double* yd = (double*)y;
+	const __m512i iDup = _mm512_setr_epi64(0,0,1,1,2,2,3,3);
+	size_t i = 0;
+	for(; i+4<=n; i+=4)
+		_mm512_storeu_pd(yd+2*i, _mm512_mul_pd(_mm512_loadu_pd(yd+2*i), _mm512_permutexvar_pd(iDup, _mm512_castpd256_pd512(_mm256_loadu_pd(x+i)))));
+	for(; i<n; i++) y[i] *= x[i];
+}
+SIMD_AVX512 void gatherSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	for(; i+4<=n; i+=4)
+		_mm512_storeu_pd(yd+2*i, _mm512_add_pd(_mm512_loadu_pd(yd+2*i), sparseTerm_avx512(gather4_avx512(xd, index+i), a, conjx, w ? w+i : 0, conjw)));
+	for(; i<n; i++) y[i] += a * sparseTerm(x[index[i]], conjx, w, i, conjw);
+}
+SIMD_AVX512 void scatterSimd(size_t n, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	const double* xd = (const double*)x; double* yd = (double*)y;
+	size_t i = 0;
+	for(; i+4<=n; i+=4)
+	{	__m512d v = sparseTerm_avx512(_mm512_loadu_pd(xd+2*i), a, conjx, w ? w+i : 0, conjw);
+		//Accumulate one entry at a time (correct even if indices repeat):
+		__m256d v01 = _mm512_castpd512_pd256(v), v23 = _mm512_extractf64x4_pd(v, 1);
+		double* y0 = yd+2*index[i]; _mm_storeu_pd(y0, _mm_add_pd(_mm_loadu_pd(y0), _mm256_castpd256_pd128(v01)));
+		double* y1 = yd+2*index[i+1]; _mm_storeu_pd(y1, _mm_add_pd(_mm_loadu_pd(y1), _mm256_extractf128_pd(v01, 1)));
+		double* y2 = yd+2*index[i+2]; _mm_storeu_pd(y2, _mm_add_pd(_mm_loadu_pd(y2), _mm256_castpd256_pd128(v23)));
+		double* y3 = yd+2*index[i+3]; _mm_storeu_pd(y3, _mm_add_pd(_mm_loadu_pd(y3), _mm256_extractf128_pd(v23, 1)));
+	}
+	for(; i<n; i++) y[index[i]] += a * sparseTerm(x[i], conjx, w, i, conjw);
+}
+#pragma GCC diagnostic pop
+#endif //SIMD_MULTIVERSION
+
+
+void eblas_zmul_sub(size_t iMin, size_t iMax, const complex* X, complex* Y, bool conjX)
+{	zmulSimd(iMax-iMin, X+iMin, Y+iMin, conjX);
+}
+void eblas_zmul(const int N, const complex* X, const int incX, complex* Y, const int incY)
+{	if(incX!=1 || incY!=1) { eblas_mul(N, X, incX, Y, incY); return; } //strided: generic version
+	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_zmul_sub, N, X, Y, false);
+}
+void eblas_zmulc(const int N, const complex* X, const int incX, complex* Y, const int incY)
+{	if(incY==0) die("incY cannot be = 0")
+	if(incX!=1 || incY!=1) { for(int i=0; i<N; i++) Y[incY*i] *= X[incX*i].conj(); return; }
+	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_zmul_sub, N, X, Y, true);
+}
+void eblas_zmuld_sub(size_t iMin, size_t iMax, const double* X, complex* Y)
+{	zmuldSimd(iMax-iMin, X+iMin, Y+iMin);
+}
+void eblas_zmuld(const int N, const double* X, const int incX, complex* Y, const int incY)
+{	if(incX!=1 || incY!=1) { eblas_mul(N, X, incX, Y, incY); return; } //strided: generic version
+	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_zmuld_sub, N, X, Y);
+}
+
 template<typename scalar, typename scalar2, typename Conjugator>
 void eblas_scatter_axpy_sub(size_t iStart, size_t iStop, scalar2 a, const int* index, const scalar* x, scalar* y, const scalar* w, const Conjugator& conjugator)
 {	for(size_t i=iStart; i<iStop; i++) y[index[i]] += a * conjugator(x,i, w,i);
@@ -100,6 +301,21 @@ void eblas_gather_axpy_sub(size_t iStart, size_t iStop, scalar2 a, const int* in
 	}
 DEFINE_SPARSE_AXPY_CPU_LAUNCHER(scatter)
 DEFINE_SPARSE_AXPY_CPU_LAUNCHER(gather)
+//--- complex versions using the vectorized kernels (selected over the generic ones above by overload resolution):
+void eblas_scatter_simd_sub(size_t iStart, size_t iStop, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	scatterSimd(iStop-iStart, a, index+iStart, x+iStart, y, conjx, w ? w+iStart : 0, conjw);
+}
+void eblas_gather_simd_sub(size_t iStart, size_t iStop, complex a, const int* index, const complex* x, complex* y, bool conjx, const complex* w, bool conjw)
+{	gatherSimd(iStop-iStart, a, index+iStart, x, y+iStart, conjx, w ? w+iStart : 0, conjw);
+}
+#define DEFINE_SPARSE_AXPY_CPU_SIMD_LAUNCHER(type) \
+	template<typename scalar2, bool conjx, bool havew, bool conjw> \
+	void eblas_##type##_axpy(const int Nindex, scalar2 a, const int* index, const complex* x, complex* y, const complex* w, const Conjugator<complex,conjx,havew,conjw>& conjugator) \
+	{	threadLaunch((Nindex<100000) ? 1 : 0, eblas_##type##_simd_sub, Nindex, complex(a), index, x, y, conjx, (havew ? w : 0), conjw); \
+	}
+DEFINE_SPARSE_AXPY_CPU_SIMD_LAUNCHER(scatter)
+DEFINE_SPARSE_AXPY_CPU_SIMD_LAUNCHER(gather)
+#undef DEFINE_SPARSE_AXPY_CPU_SIMD_LAUNCHER
 DEFINE_SPARSE_AXPY(scatter,)
 DEFINE_SPARSE_AXPY(gather,)
 
@@ -124,6 +340,40 @@ void eblas_accumProd(int N, const double& a, const complex* xU, const complex* x
 		eblas_accumProd_sub, N, a, xU, xC, yRe, yIm);
 }
 
+void eblas_accumSpinorDensity_sub(size_t iStart, size_t iStop, const double& a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn)
+{	for(size_t i=iStart; i<iStop; i++)
+	{	complex up = xUp[i], dn = xDn[i];
+		complex z = a * up * dn.conj();
+		yUpUp[i] += a * up.norm();
+		yDnDn[i] += a * dn.norm();
+		yReUpDn[i] += z.real();
+		yImUpDn[i] += z.imag();
+	}
+}
+void eblas_accumSpinorDensity(int N, const double& a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn)
+{	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_accumSpinorDensity_sub, N, a, xUp, xDn, yUpUp, yDnDn, yReUpDn, yImUpDn);
+}
+
+template<typename scalar> void eblas_spinorMul_sub(size_t iStart, size_t iStop, const scalar* Vup, const scalar* Vdn,
+	const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	for(size_t i=iStart; i<iStop; i++)
+	{	complex up = xUp[i], dn = xDn[i];
+		xUp[i] = Vup[i]*up + VupDn[i]*dn;
+		xDn[i] = VdnUp[i]*up + Vdn[i]*dn;
+	}
+}
+void eblas_spinorMul(int N, const double* Vup, const double* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_spinorMul_sub<double>, N, Vup, Vdn, VupDn, VdnUp, xUp, xDn);
+}
+void eblas_spinorMul(int N, const complex* Vup, const complex* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_spinorMul_sub<complex>, N, Vup, Vdn, VupDn, VdnUp, xUp, xDn);
+}
+
 
 template<typename scalar> void eblas_symmetrize_sub(size_t iStart, size_t iStop, int n, const int* symmIndex, scalar* x)
 {	double nInv = 1./n;
@@ -147,6 +397,17 @@ void eblas_symmetrize(int N, int n, const int* symmIndex, const int* symmMult, c
 		eblas_symmetrize_phase_sub, N, n, symmIndex, symmMult, phase, x);
 }
 
+void eblas_symmetrize_phase_batch_sub(size_t iStart, size_t iStop, int n, const int* symmIndex, const int* symmMult, const complex* phase, int nArrays, array<complex*,4> x)
+{	for(size_t i=iStart; i<iStop; i++)
+		eblas_symmetrize_phase_batch_calc(i, n, symmIndex, symmMult, phase, nArrays, x);
+}
+void eblas_symmetrize(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, std::vector<complex*> x)
+{	int nArrays = x.size(); assert(nArrays <= 4);
+	x.resize(4, 0); //pad for array<complex*,4>
+	threadLaunch((N*n*nArrays<10000) ? 1 : 0, //force single threaded for small problem sizes
+		eblas_symmetrize_phase_batch_sub, N, n, symmIndex, symmMult, phase, nArrays, array<complex*,4>(x));
+}
+
 void eblas_symmetrize_phase_rot_sub(size_t iStart, size_t iStop, int n, const int* symmIndex, const int* symmMult, const complex* phase, const matrix3<>* rotSpin, complexPtr4 x)
 {	for(size_t i=iStart; i<iStop; i++)
 		eblas_symmetrize_phase_rot_calc(i, n, symmIndex, symmMult, phase, rotSpin, x);
@@ -20,7 +20,6 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/GpuKernelUtils.h>
 #include <core/BlasExtra_internal.h>
 #include <algorithm>
-#include <cublas_v2.h>
 #include <cfloat>
 #include <gsl/gsl_cblas.h>
 
@@ -39,6 +38,16 @@ void eblas_zmul_gpu(const int N, const complex* X, const int incX, complex* Y, c
 	eblas_mul_kernel<complex,complex><<<glc.nBlocks,glc.nPerBlock>>>(N, X,incX, Y,incY);
 	gpuErrorCheck();
 }
+__global__
+void eblas_zmulc_kernel(const int N, const complex* X, const int incX, complex* Y, const int incY)
+{	int i = kernelIndex1D();
+	if(i<N) Y[i*incY] *= X[i*incX].conj();
+}
+void eblas_zmulc_gpu(const int N, const complex* X, const int incX, complex* Y, const int incY)
+{	GpuLaunchConfig1D glc(eblas_zmulc_kernel, N);
+	eblas_zmulc_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, X,incX, Y,incY);
+	gpuErrorCheck();
+}
 void eblas_zmuld_gpu(const int N, const double* X, const int incX, complex* Y, const int incY)
 {	GpuLaunchConfig1D glc(eblas_mul_kernel<double,complex>, N);
 	eblas_mul_kernel<double,complex><<<glc.nBlocks,glc.nPerBlock>>>(N, X,incX, Y,incY);
@@ -78,6 +87,13 @@ void eblas_zgemm_gpu(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB, int M, int
 		(const double2*)&alpha, (const double2*)A, lda, (const double2*)B, ldb,
 		(const double2*)&beta, (double2*)C, ldc);
 }
+void eblas_zgemm_batched_gpu(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB, int M, int N, int K,
+	const complex& alpha, const complex* const* A, const int lda, const complex* const* B, const int ldb,
+	const complex& beta, complex* const* C, const int ldc, int batchCount)
+{	cublasZgemmBatched(cublasHandle, cublasTranspose(TransA), cublasTranspose(TransB), M, N, K,
+		(const double2*)&alpha, (const double2* const*)A, lda, (const double2* const*)B, ldb,
+		(const double2*)&beta, (double2* const*)C, ldc, batchCount);
+}
 
 template<typename scalar, typename scalar2, typename Conjugator> __global__ 
 void eblas_scatter_axpy_kernel(const int N, scalar2 a, const int* index, const scalar* x, scalar* y, const scalar* w, const Conjugator& conjugator)
@@ -128,6 +144,46 @@ void eblas_accumProd_gpu(int N, const double& a, const complex* xU, const comple
 	gpuErrorCheck();
 }
 
+__global__
+void eblas_accumSpinorDensity_kernel(int N, double a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn)
+{	int i = kernelIndex1D();
+	if(i<N)
+	{	complex up = xUp[i], dn = xDn[i];
+		complex z = a * up * dn.conj();
+		yUpUp[i] += a * norm(up);
+		yDnDn[i] += a * norm(dn);
+		yReUpDn[i] += z.real();
+		yImUpDn[i] += z.imag();
+	}
+}
+void eblas_accumSpinorDensity_gpu(int N, const double& a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn)
+{	GpuLaunchConfig1D glc(eblas_accumSpinorDensity_kernel, N);
+	eblas_accumSpinorDensity_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, a, xUp, xDn, yUpUp, yDnDn, yReUpDn, yImUpDn);
+	gpuErrorCheck();
+}
+
+template<typename scalar> __global__
+void eblas_spinorMul_kernel(int N, const scalar* Vup, const scalar* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	int i = kernelIndex1D();
+	if(i<N)
+	{	complex up = xUp[i], dn = xDn[i];
+		xUp[i] = Vup[i]*up + VupDn[i]*dn;
+		xDn[i] = VdnUp[i]*up + Vdn[i]*dn;
+	}
+}
+void eblas_spinorMul_gpu(int N, const double* Vup, const double* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	GpuLaunchConfig1D glc(eblas_spinorMul_kernel<double>, N);
+	eblas_spinorMul_kernel<double><<<glc.nBlocks,glc.nPerBlock>>>(N, Vup, Vdn, VupDn, VdnUp, xUp, xDn);
+	gpuErrorCheck();
+}
+void eblas_spinorMul_gpu(int N, const complex* Vup, const complex* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn)
+{	GpuLaunchConfig1D glc(eblas_spinorMul_kernel<complex>, N);
+	eblas_spinorMul_kernel<complex><<<glc.nBlocks,glc.nPerBlock>>>(N, Vup, Vdn, VupDn, VdnUp, xUp, xDn);
+	gpuErrorCheck();
+}
+
 template<typename scalar> __global__
 void eblas_symmetrize_kernel(int N, int n, const int* symmIndex, scalar* x, double nInv)
 {	int i=kernelIndex1D();
@@ -152,6 +208,19 @@ void eblas_symmetrize_gpu(int N, int n, const int* symmIndex, const int* symmMul
 	gpuErrorCheck();
 }
 
+__global__
+void eblas_symmetrize_phase_batch_kernel(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, int nArrays, array<complex*,4> x)
+{	int i=kernelIndex1D();
+	if(i<N) eblas_symmetrize_phase_batch_calc(i, n, symmIndex, symmMult, phase, nArrays, x);
+}
+void eblas_symmetrize_gpu(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, std::vector<complex*> x)
+{	int nArrays = x.size(); assert(nArrays <= 4);
+	x.resize(4, 0); //pad for array<complex*,4>
+	GpuLaunchConfig1D glc(eblas_symmetrize_phase_batch_kernel, N);
+	eblas_symmetrize_phase_batch_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, n, symmIndex, symmMult, phase, nArrays, array<complex*,4>(x));
+	gpuErrorCheck();
+}
+
 __global__
 void eblas_symmetrize_phase_rot_kernel(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, const matrix3<>* rotSpin, complexPtr4 x)
 {	int i=kernelIndex1D();
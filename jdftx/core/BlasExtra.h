@@ -35,8 +35,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Thread.h>
 
 #ifdef GPU_ENABLED
-#include <cublas_v2.h>
-#include <cuda_runtime.h>
+#include <core/GpuBackend.h>
 #endif
 
 /** @brief Templated elementwise multiply Y *= X for arrays X, Y
@@ -52,16 +51,20 @@ template<typename Ty, typename Tx> void eblas_mul(const int N, const Tx* X, cons
 
 //!@brief Specialization of eblas_mul() for double[] *= double[]
 inline void eblas_dmul(const int N, const double* X, const int incX, double* Y, const int incY) { eblas_mul(N,X,incX,Y,incY); }
-//!@brief Specialization of eblas_mul() for complex[] *= complex[]
-inline void eblas_zmul(const int N, const complex* X, const int incX, complex* Y, const int incY) { eblas_mul(N,X,incX,Y,incY); }
-//!@brief Specialization of eblas_mul() for complex[] *= double[]
-inline void eblas_zmuld(const int N, const double* X, const int incX, complex* Y, const int incY) { eblas_mul(N,X,incX,Y,incY); }
+//!@brief Specialization of eblas_mul() for complex[] *= complex[] (vectorized with runtime CPU dispatch for unit strides)
+void eblas_zmul(const int N, const complex* X, const int incX, complex* Y, const int incY);
+//!@brief Elementwise multiply Y *= conj(X) for complex arrays (vectorized with runtime CPU dispatch for unit strides)
+void eblas_zmulc(const int N, const complex* X, const int incX, complex* Y, const int incY);
+//!@brief Specialization of eblas_mul() for complex[] *= double[] (vectorized with runtime CPU dispatch for unit strides)
+void eblas_zmuld(const int N, const double* X, const int incX, complex* Y, const int incY);
 #ifdef GPU_ENABLED
 //GPU versions of the above functions implemented in BlasExtra.cu
 //!@brief Equivalent of eblas_dmul() for GPU data pointers
 void eblas_dmul_gpu(const int N, const double* X, const int incX, double* Y, const int incY);
 //!@brief Equivalent of eblas_zmul() for GPU data pointers
 void eblas_zmul_gpu(const int N, const complex* X, const int incX, complex* Y, const int incY);
+//!@brief Equivalent of eblas_zmulc() for GPU data pointers
+void eblas_zmulc_gpu(const int N, const complex* X, const int incX, complex* Y, const int incY);
 //!@brief Equivalent of eblas_zmuld() for GPU data pointers
 void eblas_zmuld_gpu(const int N, const double* X, const int incX, complex* Y, const int incY);
 #endif
@@ -140,6 +143,11 @@ void eblas_zgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB, int M, int N, i
 void eblas_zgemm_gpu(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB, int M, int N, int K,
 	const complex& alpha, const complex *A, const int lda, const complex *B, const int ldb,
 	const complex& beta, complex *C, const int ldc);
+//! @brief Wrap cublasZgemmBatched: eblas_zgemm_gpu() for each of batchCount sets of matrices,
+//! with A, B and C specified by device arrays of device pointers
+void eblas_zgemm_batched_gpu(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB, int M, int N, int K,
+	const complex& alpha, const complex* const* A, const int lda, const complex* const* B, const int ldb,
+	const complex& beta, complex* const* C, const int ldc, int batchCount);
 #endif
 
 //Sparse<->dense vector operations:
@@ -202,11 +210,42 @@ void eblas_accumNorm(int N, const double& a, const complex* x, double* y);
 //! @param yRe Ouput real-part data array
 //! @param yIm Ouput imaginary-part data array
 void eblas_accumProd(int N, const double& a, const complex* xU, const complex* xC, double* yRe, double* yIm);
+//! @brief Accumulate all four spin-density-matrix components of a spinor (xUp, xDn) in one pass:
+//! yUpUp += a |xUp|^2, yDnDn += a |xDn|^2 and (yReUpDn + i yImUpDn) += a xUp conj(xDn)
+//! @param N Length of arrays
+//! @param a scale factor
+//! @param xUp Up component of spinor
+//! @param xDn Down component of spinor
+//! @param yUpUp Output UpUp density
+//! @param yDnDn Output DnDn density
+//! @param yReUpDn Output real part of UpDn density
+//! @param yImUpDn Output imaginary part of UpDn density
+void eblas_accumSpinorDensity(int N, const double& a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn);
+//! @brief Apply a 2x2 spin-matrix potential to a spinor in place in one pass:
+//! (xUp, xDn) <- (Vup xUp + VupDn xDn, VdnUp xUp + Vdn xDn)
+//! @param N Length of arrays
+//! @param Vup UpUp potential
+//! @param Vdn DnDn potential
+//! @param VupDn UpDn potential
+//! @param VdnUp DnUp potential
+//! @param xUp Up component of spinor (overwritten)
+//! @param xDn Down component of spinor (overwritten)
+void eblas_spinorMul(int N, const double* Vup, const double* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn);
+//! @brief Equivalent of eblas_spinorMul() for complex diagonal potentials
+void eblas_spinorMul(int N, const complex* Vup, const complex* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn);
 #ifdef GPU_ENABLED
 //! @brief Equivalent of eblas_accumNorm() for GPU data pointers
 void eblas_accumNorm_gpu(int N, const double& a, const complex* x, double* y);
 //! @brief Equivalent of eblas_accumProd() for GPU data pointers
 void eblas_accumProd_gpu(int N, const double& a, const complex* xU, const complex* xC, double* yRe, double* yIm);
+//! @brief Equivalent of eblas_accumSpinorDensity() for GPU data pointers
+void eblas_accumSpinorDensity_gpu(int N, const double& a, const complex* xUp, const complex* xDn,
+	double* yUpUp, double* yDnDn, double* yReUpDn, double* yImUpDn);
+//! @brief Equivalent of eblas_spinorMul() for GPU data pointers
+void eblas_spinorMul_gpu(int N, const double* Vup, const double* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn);
+//! @brief Equivalent of eblas_spinorMul() for GPU data pointers
+void eblas_spinorMul_gpu(int N, const complex* Vup, const complex* Vdn, const complex* VupDn, const complex* VdnUp, complex* xUp, complex* xDn);
 #endif
 
 //! @brief Symmetrize an array x, using N n-fold equivalence classes in symmIndex
@@ -238,6 +277,20 @@ void eblas_symmetrize(int N, int n, const int* symmIndex, const int* symmMult, c
 void eblas_symmetrize_gpu(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, complex* x);
 #endif
 
+//! @brief Symmetrize upto four complex arrays independently with phase factors, in a single pass over the N n-fold equivalence classes in symmIndex
+//! (useful for symmetrizing all components of collinear spin densities together)
+//! @param N Length of arrays in x
+//! @param n Length of symmetry equivalence classes
+//! @param symmIndex Every consecutive set of n indices in this array forms an equivalence class
+//! @param symmMult Multiplicity per equivalence class (number of repetitions of each element in orbit)
+//! @param phase Phase factors corresponding to each entry in symmIndex
+//! @param x Data arrays to be symmetrized in place (at most 4)
+void eblas_symmetrize(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, std::vector<complex*> x);
+#ifdef GPU_ENABLED
+//! @brief Equivalent of eblas_symmetrize() for complex GPU data pointers
+void eblas_symmetrize_gpu(int N, int n, const int* symmIndex, const int* symmMult, const complex* phase, std::vector<complex*> x);
+#endif
+
 //! @brief Symmetrize a quadruplet of complex arrays with phase factors, using N n-fold equivalence classes in symmIndex
 //! (useful for space group symmetrization of spin density matrices in reciprocal space)
 //! @param N Length of array x
@@ -84,6 +84,11 @@ __hostanddev__ void eblas_symmetrize_phase_calc(size_t i, int n, const int* symm
 		x[symmIndex[n*i+j]] += xSum * phase[n*i+j].conj();
 }
 
+__hostanddev__ void eblas_symmetrize_phase_batch_calc(size_t i, int n, const int* symmIndex, const int* symmMult, const complex* phase, int nArrays, array<complex*,4> x)
+{	for(int iArr=0; iArr<nArrays; iArr++)
+		eblas_symmetrize_phase_calc(i, n, symmIndex, symmMult, phase, x[iArr]);
+}
+
 //! Quadruplet of complex arrays corresponding to spin density matrix channels
 class complexPtr4
 {	complex *up, *dn, *re, *im; //!< UpUp, DnDn, Re(UpDn), Im(UpDn) components respectively
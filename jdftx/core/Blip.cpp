@@ -154,135 +154,72 @@ complexScalarField BlipResampler::operator()(const complexScalarFieldTilde& in)
 
 
 //---------------------------------------------------------------------------
-//---------- Analytical integration via orthogonal polynomials --------------
+//---------- Exact integration via Gauss-Legendre quadrature ----------------
 //---------------------------------------------------------------------------
 
-//coefficients of the tricubic polynomial in each cell expressed in Legendre polynomials
-template<typename scalar> struct TriCubic
-{	scalar c[4][4][4];
-
-	//convert 1d blip coeffs to legendre coefficients (in-place)
-	static inline void convert1d(scalar& coeff0, scalar& coeff1, scalar& coeff2, scalar& coeff3)
-	{
-		scalar a=coeff0, b=coeff1, c=coeff2, d=coeff3;
-		coeff0 = (1.0/16)*(a+d) + (11.0/16)*(b+c);
-		coeff1 = (9.0/80)*(d-a) + (33.0/80)*(c-b);
-		coeff2 = (1.0/16)*(a+d-b-c);
-		coeff3 = (1.0/80)*(d-a) + (3.0/80)*(b-c);
-	}
-
-	TriCubic(const scalar* v, const vector3<int>& S, int i0, int i1, int i2)
-	{	//Load coefficients:
-		int j0[4], j1[4], j2[4];
-		#define WrapIndex(d) j##d[k]=i##d+k; if(j##d[k]>=S[d]) j##d[k] -= S[d];
-		for(int k=0; k<4; k++)
-		{	WrapIndex(0);
-			WrapIndex(1);
-			WrapIndex(2);
+//Within each cell, blips are cubic along each direction, so that V|phi|^2 (degree 9) and |grad phi|^2 (degree 6)
+//are integrated exactly by 5-point Gauss-Legendre quadrature per direction. The (separable) evaluation at the
+//quadrature points is tiled over lines of cells along the inner dimension: the outer two dimensions are contracted
+//once per line for all cells (contiguous, vectorizable along the line), leaving a short contraction per cell.
+namespace BlipQuadrature
+{
+	const int nQ = 5; //quadrature points per dimension
+	
+	//Blip basis functions and derivatives at the quadrature points in [0,1], and the quadrature weights
+	struct Weights
+	{	double B[4][nQ], dB[4][nQ], w[nQ];
+		Weights()
+		{	const double x[nQ] = { -0.9061798459386640, -0.5384693101056831, 0., 0.5384693101056831, 0.9061798459386640 };
+			const double wx[nQ] = { 0.2369268850561891, 0.4786286704993665, 0.5688888888888889, 0.4786286704993665, 0.2369268850561891 };
+			for(int q=0; q<nQ; q++)
+			{	double t = 0.5*(1.+x[q]), tc = 1.-t; //point in unit cell
+				w[q] = 0.5*wx[q];
+				//Same cubic polynomial per cell as BlipPrivate::blip (coefficients k=0 to 3 starting at the cell):
+				B[0][q] = 0.25*tc*tc*tc;
+				B[1][q] = 0.25*(4. - 6.*t*t + 3.*t*t*t);
+				B[2][q] = 0.25*(1. + 3.*t + 3.*t*t - 3.*t*t*t);
+				B[3][q] = 0.25*t*t*t;
+				dB[0][q] = -0.75*tc*tc;
+				dB[1][q] = 0.25*(-12.*t + 9.*t*t);
+				dB[2][q] = 0.25*(3. + 6.*t - 9.*t*t);
+				dB[3][q] = 0.75*t*t;
+			}
 		}
-		#undef WrapIndex
+	};
+	const Weights& weights() { static const Weights W; return W; }
+	
+	//Contract blip coefficients c over the outer two dimensions for the line of cells (i0,i1,*) with basis values B0 and B1:
+	//P[(q0*nQ+q1)*S[2] + j2] = sum_{k0,k1} B0[k0][q0] B1[k1][q1] c[i0+k0, i1+k1, j2]
+	template<typename scalar> void contractLine(const scalar* c, const vector3<int>& S, int i0, int i1,
+		const double (*B0)[nQ], const double (*B1)[nQ], scalar* P)
+	{	std::fill(P, P+nQ*nQ*S[2], scalar(0.));
 		for(int k0=0; k0<4; k0++)
-		{
-			int offs0 = j0[k0]*S[1];
+		{	int j0 = (i0+k0) % S[0];
 			for(int k1=0; k1<4; k1++)
-			{
-				int offs01 = (offs0+j1[k1])*S[2];
-				for(int k2=0; k2<4; k2++)
-					c[k0][k1][k2] = v[offs01+j2[k2]];
+			{	int j1 = (i1+k1) % S[1];
+				const scalar* cLine = c + S[2]*(j1 + S[1]*j0);
+				for(int q0=0; q0<nQ; q0++)
+				for(int q1=0; q1<nQ; q1++)
+				{	double b = B0[k0][q0] * B1[k1][q1];
+					scalar* Pq = P + (q0*nQ+q1)*S[2];
+					for(int j2=0; j2<S[2]; j2++)
+						Pq[j2] += b * cLine[j2];
+				}
 			}
 		}
-		//Recombine into Legendre coefficients
-		for(int i0=0; i0<4; i0++) for(int i1=0; i1<4; i1++) convert1d(c[i0][i1][0], c[i0][i1][1], c[i0][i1][2], c[i0][i1][3]);
-		for(int i0=0; i0<4; i0++) for(int i2=0; i2<4; i2++) convert1d(c[i0][0][i2], c[i0][1][i2], c[i0][2][i2], c[i0][3][i2]);
-		for(int i1=0; i1<4; i1++) for(int i2=0; i2<4; i2++) convert1d(c[0][i1][i2], c[1][i1][i2], c[2][i1][i2], c[3][i1][i2]);
 	}
-};
-
-inline double Tcell(const TriCubic<complex>& phi, const matrix3<>* Tmat)
-{
-	double T00=0, T11=0, T22=0; //diagonal terms in oblique laplacian
-	complex T01=0, T12=0, T20=0; //off-diagonal terms in oblique laplacian
-
-	static const double w[4] = {1.0, 1.0/3, 1.0/5, 1.0/7}; //weights when no derivatives
-
-	//00 term:
-	for(int i1=0; i1<4; i1++)
-		for(int i2=0; i2<4; i2++)
-			T00 += w[i1]*w[i2]*
-				( 4.0*norm(phi.c[1][i1][i2]+phi.c[3][i1][i2])
-				+ 12.0*norm(phi.c[2][i1][i2])
-				+ 20.0*norm(phi.c[3][i1][i2]) );
-	//11 term:
-	for(int i0=0; i0<4; i0++)
-		for(int i2=0; i2<4; i2++)
-			T11 += w[i0]*w[i2]*
-				( 4.0*norm(phi.c[i0][1][i2]+phi.c[i0][3][i2])
-				+ 12.0*norm(phi.c[i0][2][i2])
-				+ 20.0*norm(phi.c[i0][3][i2]) );
-	//22 term:
-	for(int i0=0; i0<4; i0++)
-		for(int i1=0; i1<4; i1++)
-			T11 += w[i0]*w[i1]*
-				( 4.0*norm(phi.c[i0][i1][1]+phi.c[i0][i1][3])
-				+ 12.0*norm(phi.c[i0][i1][2])
-				+ 20.0*norm(phi.c[i0][i1][3]) );
-
-	static const int ja[4] = {1,2,3,3};
-	static const int jb[4] = {0,1,2,0};
-	for(int i0=0; i0<4; i0++)
-		for(int i1=0; i1<4; i1++)
-			for(int i2=0; i2<4; i2++)
-			{
-				T12 += 4.0*w[i0]*conj(phi.c[i0][ja[i1]][jb[i2]])*phi.c[i0][jb[i1]][ja[i2]];
-				T20 += 4.0*w[i1]*conj(phi.c[ja[i0]][i1][jb[i2]])*phi.c[jb[i0]][i1][ja[i2]];
-				T01 += 4.0*w[i2]*conj(phi.c[ja[i0]][jb[i1]][i2])*phi.c[jb[i0]][ja[i1]][i2];
-			}
-
-	return (*Tmat)(0,0)*T00 + (*Tmat)(1,1)*T11 + (*Tmat)(2,2)*T22
-		+ 2*( (*Tmat)(1,2)*T12.real() + (*Tmat)(2,0)*T20.real() + (*Tmat)(0,1)*T01.real() );
-}
-
-
-struct SparseTensorElem
-{
-	int a,b,c;
-	double w;
-
-	SparseTensorElem(int a1, int b1, int c1, double w)
-	:a(a1-1),b(b1-1),c(c1-1),w(w) //shifting from 1-based indices (from Mathematica)
-	{}
-};
-
-inline double Vcell(const TriCubic<complex>& phi, const TriCubic<double>& V)
-{
-	static const int nSparse=15;
-	static const SparseTensorElem s[nSparse] =
-	{
-		{1,1,1, 1.0},
-		{1,2,2, 1.0/3},
-		{1,3,3, 1.0/5},
-		{1,4,4, 1.0/7},
-		{2,2,1, 2.0/3},
-		{2,3,2, 4.0/15},
-		{2,4,3, 6.0/35},
-		{3,2,2, 2.0/15},
-		{3,3,1, 2.0/5},
-		{3,3,3, 2.0/35},
-		{3,4,2, 6.0/35},
-		{3,4,4, 4.0/105},
-		{4,3,2, 6.0/35},
-		{4,4,1, 2.0/7},
-		{4,4,3, 8.0/105}
-	};
-	complex result=0.0;
-	for(int i0=0; i0<nSparse; i0++)
-		for(int i1=0; i1<nSparse; i1++)
-			for(int i2=0; i2<nSparse; i2++)
-				result += s[i0].w * s[i1].w * s[i2].w
-					* V.c[s[i0].a][s[i1].a][s[i2].a]
-					* phi.c[s[i0].b][s[i1].b][s[i2].b]
-					* conj(phi.c[s[i0].c][s[i1].c][s[i2].c]);
-	return result.real();
+	
+	//Complete the evaluation at the quadrature points of cell i2 of the line (out[(q0*nQ+q1)*nQ+q2]) with basis values B2
+	template<typename scalar> void evalCell(const scalar* P, int S2, int i2, const double (*B2)[nQ], scalar* out)
+	{	int j2[4];
+		for(int k2=0; k2<4; k2++) j2[k2] = (i2+k2) % S2;
+		for(int q01=0; q01<nQ*nQ; q01++)
+		{	const scalar* Pq = P + q01*S2;
+			scalar p0 = Pq[j2[0]], p1 = Pq[j2[1]], p2 = Pq[j2[2]], p3 = Pq[j2[3]];
+			for(int q2=0; q2<nQ; q2++)
+				out[q01*nQ+q2] = B2[0][q2]*p0 + B2[1][q2]*p1 + B2[2][q2]*p2 + B2[3][q2]*p3;
+		}
+	}
 }
 
 
@@ -292,11 +229,28 @@ inline double Vcell(const TriCubic<complex>& phi, const TriCubic<double>& V)
 
 //Local potential energy for one slice (to be threaded over slices)
 double Vblip_sub(int i0, const vector3<int> S, const complex* phi, const double* V)
-{
+{	using namespace BlipQuadrature;
+	const Weights& W = weights();
+	std::vector<complex> Pphi(nQ*nQ*S[2]); std::vector<double> PV(nQ*nQ*S[2]);
+	complex phiQ[nQ*nQ*nQ]; double VQ[nQ*nQ*nQ];
 	double res=0.0;
 	for(int i1=0; i1<S[1]; i1++)
+	{	contractLine(phi, S, i0, i1, W.B, W.B, Pphi.data());
+		contractLine(V, S, i0, i1, W.B, W.B, PV.data());
 		for(int i2=0; i2<S[2]; i2++)
-			res += Vcell(TriCubic<complex>(phi, S, i0, i1, i2), TriCubic<double>(V, S, i0, i1, i2));
+		{	evalCell(Pphi.data(), S[2], i2, W.B, phiQ);
+			evalCell(PV.data(), S[2], i2, W.B, VQ);
+			int q = 0;
+			for(int q0=0; q0<nQ; q0++)
+			for(int q1=0; q1<nQ; q1++)
+			{	double w01 = W.w[q0]*W.w[q1];
+				for(int q2=0; q2<nQ; q2++)
+				{	res += w01*W.w[q2] * VQ[q] * norm(phiQ[q]);
+					q++;
+				}
+			}
+		}
+	}
 	return res;
 }
 
@@ -311,15 +265,37 @@ double Vblip(const complexScalarField& phi, const ScalarField& V)
 //Kinetic energy for one slice (to be threaded over slices)
 double Tblip_sub(int i0, const vector3<int> S, const complex* phi, const matrix3<>* Tmat,
 	double* tMaxPtr, int* i0maxPtr, int* i1maxPtr, int* i2maxPtr, std::mutex* m)
-{
+{	using namespace BlipQuadrature;
+	const Weights& W = weights();
+	std::vector<complex> P0(nQ*nQ*S[2]), P1(nQ*nQ*S[2]), P2(nQ*nQ*S[2]); //line contractions for each gradient component
+	complex g0[nQ*nQ*nQ], g1[nQ*nQ*nQ], g2[nQ*nQ*nQ]; //mesh-coordinate gradient at quadrature points
+	const matrix3<>& T = *Tmat;
 	double res=0.0;
 	double tMax=0.0; int i0max=0, i1max=0, i2max=0;
 	for(int i1=0; i1<S[1]; i1++)
+	{	contractLine(phi, S, i0, i1, W.dB, W.B, P0.data());
+		contractLine(phi, S, i0, i1, W.B, W.dB, P1.data());
+		contractLine(phi, S, i0, i1, W.B, W.B, P2.data());
 		for(int i2=0; i2<S[2]; i2++)
-		{	double t = Tcell(TriCubic<complex>(phi, S, i0, i1, i2), Tmat);
+		{	evalCell(P0.data(), S[2], i2, W.B, g0);
+			evalCell(P1.data(), S[2], i2, W.B, g1);
+			evalCell(P2.data(), S[2], i2, W.dB, g2);
+			double t = 0.;
+			int q = 0;
+			for(int q0=0; q0<nQ; q0++)
+			for(int q1=0; q1<nQ; q1++)
+			{	double w01 = W.w[q0]*W.w[q1];
+				for(int q2=0; q2<nQ; q2++)
+				{	t += w01*W.w[q2] *
+						( T(0,0)*norm(g0[q]) + T(1,1)*norm(g1[q]) + T(2,2)*norm(g2[q])
+						+ 2*( T(1,2)*(g1[q].conj()*g2[q]).real() + T(2,0)*(g2[q].conj()*g0[q]).real() + T(0,1)*(g0[q].conj()*g1[q]).real() ) );
+					q++;
+				}
+			}
 			res += t;
 			if(t>tMax) { tMax=t; i0max=i0; i1max=i1; i2max=i2; }
 		}
+	}
 	m->lock();
 	if(tMaxPtr && tMax>*tMaxPtr)
 	{	*tMaxPtr=tMax;
@@ -29,7 +29,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Operators.h>
 #include "LatticeUtils.h"
 
-CoulombParams::CoulombParams() : ionMargin(5.), embed(false), embedFluidMode(false), computeStress(false)
+CoulombParams::CoulombParams() : ionMargin(5.), embed(false), embedFluidMode(false), ewaldSplineOrder(0), exchangeDownsample(1,1,1), exchangeKernelTableMB(0.), computeStress(false)
 {
 }
 
@@ -246,6 +246,13 @@ matrix3<> Coulomb::latticeGradient(const complexScalarFieldTilde& X, vector3< do
 	return exEvalOmega->second->latticeGradient(params.embed ? embedExpand(X) : X, kDiff);
 }
 
+bool Coulomb::applyExchangeBatch(complex* data, int howMany, vector3<> kDiff, double omega, double* nKn) const
+{	if(params.embed) return false; //kernels live on the embedding grid
+	auto exEvalOmega = exchangeEval.find(omega);
+	assert(exEvalOmega != exchangeEval.end());
+	return exEvalOmega->second->applyBatch(data, howMany, kDiff, nKn);
+}
+
 
 double Coulomb::energyAndGrad(std::vector<Atom>& atoms, matrix3<>* E_RRT) const
 {	if(!ewald) ((Coulomb*)this)->ewald = createEwald(gInfo.R, atoms.size());
@@ -299,9 +306,18 @@ double Coulomb::energyAndGrad(std::vector<Atom>& atoms, matrix3<>* E_RRT) const
 	if(params.Efield.length_squared())
 	{	vector3<> RT_Efield_ramp, RT_Efield_wave;
 		params.splitEfield(gInfoOrig.R, RT_Efield_ramp, RT_Efield_wave);
+		matrix3<> invR = inv(gInfoOrig.R);
 		for(unsigned i=0; i<atoms.size(); i++)
 		{	Atom& a = atoms[i];
 			vector3<> x = a.pos - xCenter;
+			if(!params.embed && RT_Efield_ramp.length_squared())
+			{	//Ramp is discontinuous on the Wigner-Seitz boundary about xCenter: keep ions (and their electrons) away from it
+				x = wsOrig->restrict(x);
+				for(int k=0; k<3; k++)
+					if(RT_Efield_ramp[k] && (0.5-fabs(x[k]))/invR.row(k).length() < params.ionMargin)
+						die("Atom %d lies within the margin of %lg bohrs from the electric field ramp discontinuity.\n"
+							"Move coulomb-truncation-center, or use coulomb-truncation-embed.\n" ionMarginMessage, i+1, params.ionMargin);
+			}
 			for(int k=0; k<3; k++)
 			{	//note that Z is negative of nuclear charge in present sign convention
 				Eewald += a.Z * (RT_Efield_ramp[k]*x[k] + RT_Efield_wave[k]*sin(2*M_PI*x[k])/(2*M_PI));
@@ -453,9 +469,13 @@ Coulomb::Coulomb(const GridInfo& gInfoOrig, const CoulombParams& params)
 	if(params.Efield.length_squared())
 	{	vector3<> RT_Efield_ramp, RT_Efield_wave;
 		params.splitEfield(gInfoOrig.R, RT_Efield_ramp, RT_Efield_wave);
-		if(RT_Efield_ramp.length_squared() && !params.embed)
-			die("Electric field with component along truncated direction requires coulomb-truncation-embed.");
 		if(!wsOrig) wsOrig = new WignerSeitz(gInfoOrig.R);
+		if(RT_Efield_ramp.length_squared() && !params.embed)
+		{	//Translationally-invariant truncated kernels on the original grid, with the ramp centered on xCenter:
+			logPrintf("Applying electric field along truncated directions without embedding, centered at lattice coordinates");
+			xCenter.print(globalLog, " %lg ");
+			logPrintf("   (charge must remain localized to half the cell about this center; see coulomb-truncation-center)\n");
+		}
 	}
 }
 
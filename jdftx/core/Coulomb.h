@@ -48,11 +48,13 @@ struct CoulombParams
 	double ionMargin; //!< margin around ions when checking localization constraints
 	
 	bool embed; //!< whether to embed in double-sized box (along truncated directions) to compute Coulomb interactions
-	vector3<> embedCenter; //!< 'center' of the system, when it is embedded into the larger box (in lattice coordinates)
+	vector3<> embedCenter; //!< 'center' of the system, when it is embedded into the larger box, or of the Efield ramp without embedding (in lattice coordinates)
 	bool embedFluidMode; //!< if true, don't truncate, just evaluate coulomb interactions in the larger box (fluid screening does the image separation instead)
 	
 	vector3<> Efield; //!< electric field (in Cartesian coordinates, atomic units [Eh/e/a0])
 	
+	int ewaldSplineOrder; //!< B-spline order for particle-mesh Ewald sums on the FFT grid (0 => analytic Ewald sum; Periodic geometry only)
+	
 	//Parameters for computing exchange integrals:
 	//! Regularization method for G=0 singularities in exchange
 	enum ExchangeRegularization
@@ -65,6 +67,8 @@ struct CoulombParams
 	ExchangeRegularization exchangeRegularization; //!< exchange regularization method
 	std::set<double> omegaSet; //!< set of exchange erf-screening parameters
 	std::shared_ptr<struct Supercell> supercell; //!< Description of k-point supercell for exchange
+	vector3<int> exchangeDownsample; //!< factors by which the q-points of exchange are downsampled from the k-point supercell, along each supercell lattice vector (1,1,1 => full k-mesh)
+	double exchangeKernelTableMB; //!< memory budget (per process) for tabulating analytic exchange kernels by k-point difference (0 => evaluate on the fly)
 	bool computeStress; //!< Whether stress calculation will be required (Isolated and Wire need extra initialization)
 	
 	CoulombParams();
@@ -142,11 +146,11 @@ public:
 	matrix3<> latticeGradient(const ScalarFieldTilde& X, const ScalarFieldTilde& Y, PointChargeMode pointChargeMode=PointChargeNone) const;
 	
 	//! Create the appropriate Ewald class, if required, and call Ewald::energyAndGrad
-	//! Includes interaction with Efield, if present (Requires embedded truncation)
+	//! Includes interaction with Efield, if present (ramp centered on params.embedCenter, with or without embedding)
 	//!If E_RRT is non-null, accumulate contrbutions to the symmetric lattice derivative (stress * volume)
 	double energyAndGrad(std::vector<Atom>& atoms, matrix3<>* E_RRT=0) const; 
 
-	//! Generate the potential due to the Efield (if any) (Requires embedded truncation)
+	//! Generate the potential due to the Efield (if any), with ramp discontinuity on the Wigner-Seitz boundary about params.embedCenter
 	ScalarField getEfieldPotential() const;
 	
 	//! Apply regularized coulomb kernel for exchange integral with k-point difference kDiff
@@ -159,6 +163,11 @@ public:
 
 	//! Return the lattice gradient of exchange integral dot(X, O(coulomb(X)) for given k-point difference and screening parameter
 	matrix3<> latticeGradient(const complexScalarFieldTilde& X, vector3<> kDiff, double omega) const;
+	
+	//! Replace each of howMany consecutive reciprocal-space pair densities n in data with O(K n) using a tabulated exchange kernel K,
+	//! and set nKn[i] = dot(n, O(K n)) for each. Returns false without changing data if no table is available for kDiff
+	//! (analytic kernel outside exchangeKernelTableMB, or embedded truncation), in which case use operator() instead.
+	bool applyExchangeBatch(complex* data, int howMany, vector3<> kDiff, double omega, double* nKn) const;
 
 private:
 	const GridInfo& gInfoOrig; //!< original grid
@@ -26,6 +26,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <cfloat>
 
 const double CoulombKernel::nSigmasPerWidth = 1.+sqrt(-2.*log(DBL_EPSILON)); //gaussian negligible at double precision (+1 sigma for safety)
+string CoulombKernel::cacheDir;
 
 CoulombKernel::CoulombKernel(const matrix3<> R, const vector3<int> S, const vector3<bool> isTruncated, double omega)
 : R(R), S(S), isTruncated(isTruncated), omega(omega)
@@ -34,7 +35,8 @@ CoulombKernel::CoulombKernel(const matrix3<> R, const vector3<int> S, const vect
 
 
 void CoulombKernel::compute(double* data, const WignerSeitz& ws, symmetricMatrix3<>* data_RRT) const
-{	//Count number of truncated directions:
+{	if(cacheDir.length() && readCache(data, data_RRT)) return;
+	//Count number of truncated directions:
 	int nTruncated = 0;
 	for(int k=0; k<3; k++) if(isTruncated[k]) nTruncated++;
 	//Call appropriate routine:
@@ -43,6 +45,82 @@ void CoulombKernel::compute(double* data, const WignerSeitz& ws, symmetricMatrix
 		case 3: computeIsolated(data, ws, data_RRT); break;
 		default: assert(!"Invalid truncated direction count");
 	}
+	if(cacheDir.length()) writeCache(data, data_RRT);
+}
+
+//--------- Kernel cache ---------
+
+//Parameters that fully determine the kernel, as stored at the start of each cache file:
+struct CoulombKernelCacheHeader
+{	char magic[8];
+	double R[9], omega, nSigmasPerWidth;
+	int S[3], isTruncated[3], withRRT;
+	
+	CoulombKernelCacheHeader() { memset(this, 0, sizeof(CoulombKernelCacheHeader)); } //zero padding, so that the bytes are reproducible
+	CoulombKernelCacheHeader(const CoulombKernel& ck, bool withRRT) : CoulombKernelCacheHeader()
+	{	memcpy(magic, "JDFTxCK1", 8);
+		for(int i=0; i<3; i++)
+		{	for(int j=0; j<3; j++) R[3*i+j] = ck.R(i,j);
+			S[i] = ck.S[i];
+			isTruncated[i] = ck.isTruncated[i];
+		}
+		omega = ck.omega;
+		nSigmasPerWidth = CoulombKernel::nSigmasPerWidth;
+		this->withRRT = withRRT;
+	}
+};
+
+string CoulombKernel::cacheFilename(bool withRRT) const
+{	CoulombKernelCacheHeader header(*this, withRRT);
+	//FNV-1a hash of header (stable across runs and platforms, unlike std::hash):
+	uint64_t hash = 14695981039346656037ULL;
+	const unsigned char* bytes = (const unsigned char*)&header;
+	for(size_t i=0; i<sizeof(header); i++)
+	{	hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	char buf[32]; snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+	return cacheDir + "/coulombKernel-" + buf + ".bin";
+}
+
+bool CoulombKernel::readCache(double* data, symmetricMatrix3<>* data_RRT) const
+{	string fname = cacheFilename(data_RRT);
+	size_t nG = S[0]*(S[1]*size_t(1+S[2]/2));
+	CoulombKernelCacheHeader header(*this, data_RRT), headerIn;
+	off_t fsizeExpected = sizeof(header) + nG*sizeof(double) + (data_RRT ? nG*sizeof(symmetricMatrix3<>) : 0);
+	if(fileSize(fname.c_str()) != fsizeExpected) return false; //missing or incomplete
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp) return false;
+	bool ok = (fread(&headerIn, sizeof(headerIn), 1, fp) == 1)
+		&& (memcmp(&header, &headerIn, sizeof(header)) == 0) //guard against hash collisions
+		&& (freadLE(data, sizeof(double), nG, fp) == nG)
+		&& (!data_RRT || freadLE(data_RRT, sizeof(double), 6*nG, fp) == 6*nG);
+	fclose(fp);
+	if(ok) logPrintf("Read truncated coulomb kernel from '%s'.\n", fname.c_str());
+	return ok;
+}
+
+void CoulombKernel::writeCache(const double* data, const symmetricMatrix3<>* data_RRT) const
+{	if(!mpiWorld->isHead()) return;
+	string fname = cacheFilename(data_RRT);
+	string fnameTmp = fname + ".tmp"; //write to a temporary file and rename, so that partial files are never read
+	size_t nG = S[0]*(S[1]*size_t(1+S[2]/2));
+	CoulombKernelCacheHeader header(*this, data_RRT);
+	FILE* fp = fopen(fnameTmp.c_str(), "wb");
+	if(!fp)
+	{	logPrintf("WARNING: could not open '%s' to cache coulomb kernel.\n", fnameTmp.c_str());
+		return;
+	}
+	bool ok = (fwrite(&header, sizeof(header), 1, fp) == 1)
+		&& (fwriteLE(data, sizeof(double), nG, fp) == nG)
+		&& (!data_RRT || fwriteLE(data_RRT, sizeof(double), 6*nG, fp) == 6*nG);
+	ok = (fclose(fp)==0) && ok;
+	if(ok && rename(fnameTmp.c_str(), fname.c_str())==0)
+		logPrintf("Saved truncated coulomb kernel to '%s'.\n", fname.c_str());
+	else
+	{	logPrintf("WARNING: could not write coulomb kernel cache '%s'.\n", fname.c_str());
+		remove(fnameTmp.c_str());
+	}
 }
 
 //! Compute erfc(omega r)/r - erfc(a r)/r
@@ -63,6 +141,14 @@ inline double screenedPotentialPrime_by_r(double r, double a, double omega)
 
 namespace CoulombKernelIsolated
 {
+	//Index of the inversion image -iv of dense grid point iv, in an array of padded dimensions S
+	inline size_t mirrorIndex(const vector3<int>& iv, const vector3<int>& Sdense, const vector3<int>& S)
+	{	vector3<int> ivMirror;
+		for(int k=0; k<3; k++)
+			ivMirror[k] = iv[k] ? Sdense[k]-iv[k] : 0;
+		return ivMirror[2] + S[2]*size_t(ivMirror[1] + S[1]*ivMirror[0]);
+	}
+	
 	//Initialize the long range part of the kernel in real space with the minimum image convention:
 	inline void realSpace_thread(size_t iStart, size_t iStop, vector3<int> Sdense, matrix3<> R,
 		double* data, const WignerSeitz* ws, double sigma, double omega,
@@ -75,7 +161,10 @@ namespace CoulombKernelIsolated
 		int nArr = computeStress ? 7 : 1;
 		vector3<int> S = Sdense; S[2] = 2*(Sdense[2]/2+1); //padding for in-place r2c transform
 		THREAD_rLoop
-		(	if(iv[2]<Sdense[2]) 
+		(	if(iv[2]>=Sdense[2])
+			{	for(int iArr=0; iArr<nArr; iArr++) data[i+iArr*arrayStride] = 0.; //padded points
+			}
+			else if(mirrorIndex(iv, Sdense, S) >= i) //remaining points set from their inversion image by realSpaceMirror_thread
 			{	vector3<> x; for(int k=0; k<3; k++) x[k] = invSdense[k] * iv[k]; //lattice coordinates
 				x = ws->restrict(x); //minimum image convention
 				double r = sqrt(RTR.metric_length_squared(x)); //minimum image distance
@@ -89,7 +178,20 @@ namespace CoulombKernelIsolated
 							+ (iComp<3 ? data[i] : 0.); //contribution due to det(R) in dV
 				}
 			}
-			else for(int iArr=0; iArr<nArr; iArr++) data[i+iArr*arrayStride] = 0.; //padded points
+		)
+	}
+
+	//Copy the real space kernel to points whose inversion image was computed in realSpace_thread:
+	inline void realSpaceMirror_thread(size_t iStart, size_t iStop, vector3<int> Sdense, double* data, bool computeStress, size_t arrayStride)
+	{	int nArr = computeStress ? 7 : 1;
+		vector3<int> S = Sdense; S[2] = 2*(Sdense[2]/2+1); //padding for in-place r2c transform
+		THREAD_rLoop
+		(	if(iv[2]<Sdense[2])
+			{	size_t iMirror = mirrorIndex(iv, Sdense, S);
+				if(iMirror < i)
+					for(int iArr=0; iArr<nArr; iArr++)
+						data[i+iArr*arrayStride] = data[iMirror+iArr*arrayStride]; //kernel and its lattice derivative are even
+			}
 		)
 	}
 
@@ -160,6 +262,7 @@ void CoulombKernel::computeIsolated(double* data, const WignerSeitz& ws, symmetr
 	//Long-range part in real space
 	logPrintf("Computing truncated long-range part in real space ... "); logFlush();
 	threadLaunch(CoulombKernelIsolated::realSpace_thread, 2*nGdense, Sdense, R, denseRealArr, &ws, sigma, omega, data_RRT, arrayStrideReal);
+	threadLaunch(CoulombKernelIsolated::realSpaceMirror_thread, 2*nGdense, Sdense, denseRealArr, data_RRT, arrayStrideReal);
 	logPrintf("Done.\n");
 	
 	//Add short-ranged part in reciprocal space (and down-sample if required):
@@ -218,9 +321,13 @@ struct CoulombKernelWire
 		}
 		complex* denseArr = dense.data();
 		double* denseRealArr = (double*)denseArr; //in-place transform
+		auto mirrorIndex = [&](int ij, int ik) //index of inversion image of point (ij,ik) within plane
+		{	return (ik ? Sdense[kDir]-ik : 0) + jPitchDense * (ij ? Sdense[jDir]-ij : 0);
+		};
 		for(int ij=0; ij<Sdense[jDir]; ij++)
 			for(int ik=0; ik<Sdense[kDir]; ik++)
-			{	vector3<> x; //point in lattice coordinates
+			{	if(mirrorIndex(ij, ik) < ik + jPitchDense * ij) continue; //set from inversion image below
+				vector3<> x; //point in lattice coordinates
 				x[iDir] = 0.;
 				x[jDir] = invSjDense * ij;
 				x[kDir] = invSkDense * ik;
@@ -244,6 +351,16 @@ struct CoulombKernelWire
 							+ (iComp<3 ? term : 0.); //contribution via dV (writing dA as dV/L for simplicity)
 				}
 			}
+		//Set remaining points from their inversion images (kernel and its lattice derivative are even):
+		int nArr = Vc_RRT ? 7 : 1;
+		for(int ij=0; ij<Sdense[jDir]; ij++)
+			for(int ik=0; ik<Sdense[kDir]; ik++)
+			{	int iDense = ik + jPitchDense * ij;
+				int iMirror = mirrorIndex(ij, ik);
+				if(iMirror < iDense)
+					for(int iArr=0; iArr<nArr; iArr++)
+						denseRealArr[iDense+iArr*arrayStrideReal] = denseRealArr[iMirror+iArr*arrayStrideReal];
+			}
 		if(omega) delete cbar_k_screen;
 		if(Vc_RRT && iPlane)
 		{	delete minus_cbar_k_sigma_k;
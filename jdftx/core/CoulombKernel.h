@@ -43,11 +43,17 @@ struct CoulombKernel
 	//!      Supported modes include fully truncated (Isolated or Wigner-Seitz
 	//! truncated exchange kernel) and one direction periodic (Wire geometry).
 	//!      Optionally initialize lattice derivative if data_RRT is non-null
+	//!      Reuses a previously computed kernel from cacheDir when available
 	void compute(double* data, const WignerSeitz& ws, symmetricMatrix3<>* data_RRT=0) const;
 	
 	static const double nSigmasPerWidth; //!< number of sigmas at which gaussian is negligible at working precision
+	static string cacheDir; //!< if non-empty, directory in which computed kernels are saved for reuse by subsequent runs
 	
 private:
+	string cacheFilename(bool withRRT) const; //!< filename in cacheDir identifying this kernel's parameters
+	bool readCache(double* data, symmetricMatrix3<>* data_RRT) const; //!< read kernel from cache, returning false if unavailable
+	void writeCache(const double* data, const symmetricMatrix3<>* data_RRT) const; //!< save kernel to cache (from head)
+	
 	//Various indiviudally optimized cases of computeKernel:
 	void computeIsolated(double* data, const WignerSeitz& ws, symmetricMatrix3<>* data_RRT) const; //!< Fully truncated
 	void computeWire(double* data, const WignerSeitz& ws, symmetricMatrix3<>* data_RRT) const; //!< 1 periodic direction
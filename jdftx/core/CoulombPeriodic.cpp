@@ -21,13 +21,16 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Coulomb_internal.h>
 #include <core/CoulombKernel.h>
 #include <core/BlasExtra.h>
+#include <core/NeighborList.h>
+#include <core/LoopMacros.h>
+#include <core/Operators.h>
 
 //! Standard 3D Ewald sum
 class EwaldPeriodic : public Ewald
 {
 	matrix3<> R, G, RTR, GGT; //!< Lattice vectors, reciprocal lattice vectors and corresponding metrics
 	double sigma; //!< gaussian width for Ewald sums
-	vector3<int> Nreal; //!< max unit cell indices for real-space sum
+	double rCut; //!< cutoff for real-space sum
 	vector3<int> Nrecip; //!< max unit cell indices for reciprocal-space sum
 
 public:
@@ -47,18 +50,17 @@ public:
 		
 		//Carry real space sums to Rmax = 10 sigma and Gmax = 10/sigma
 		//This leads to relative errors ~ 1e-22 in both sums, well within double precision limits
+		rCut = CoulombKernel::nSigmasPerWidth * sigma;
 		for(int k=0; k<3; k++)
-		{	Nreal[k] = 1+ceil(CoulombKernel::nSigmasPerWidth * G.row(k).length() * sigma / (2*M_PI));
 			Nrecip[k] = 1+ceil(CoulombKernel::nSigmasPerWidth * R.column(k).length() / (2*M_PI*sigma));
-		}
-		logPrintf("Real space sum over %d unit cells with max indices ", (2*Nreal[0]+1)*(2*Nreal[1]+1)*(2*Nreal[2]+1));
-		Nreal.print(globalLog, " %d ");
+		logPrintf("Real space sum over neighbors within %lf bohr.\n", rCut);
 		logPrintf("Reciprocal space sum over %d terms with max indices ", (2*Nrecip[0]+1)*(2*Nrecip[1]+1)*(2*Nrecip[2]+1));
 		Nrecip.print(globalLog, " %d ");
 	}
 
 	double energyAndGrad(std::vector<Atom>& atoms, matrix3<>* E_RRTptr) const
-	{	double eta = sqrt(0.5)/sigma, etaSq=eta*eta;
+	{	static StopWatch watch("EwaldPeriodic::energyAndGrad"); watch.start();
+		double eta = sqrt(0.5)/sigma, etaSq=eta*eta;
 		double sigmaSq = sigma * sigma;
 		double detR = fabs(det(R)); //cell volume
 		matrix3<> E_RRT; //stress * volume (computed if E_RRTptr non-null)
@@ -79,28 +81,32 @@ public:
 		for(Atom& a: atoms)
 			for(int k=0; k<3; k++)
 				a.pos[k] -= floor(0.5 + a.pos[k]);
-		if(not ZsqTot) return 0.;
-		
-		//Real space sum:
-		vector3<int> iR; //integer cell number
-		for(const Atom& a2: atoms)
-			for(Atom& a1: atoms)
-				for(iR[0]=-Nreal[0]; iR[0]<=Nreal[0]; iR[0]++)
-					for(iR[1]=-Nreal[1]; iR[1]<=Nreal[1]; iR[1]++)
-						for(iR[2]=-Nreal[2]; iR[2]<=Nreal[2]; iR[2]++)
-						{	vector3<> x = iR + (a1.pos - a2.pos);
-							double rSq = RTR.metric_length_squared(x);
-							if(!rSq) continue; //exclude self-interaction
-							double r = sqrt(rSq);
-							E += 0.5 * a1.Z * a2.Z * erfc(eta*r)/r;
-							double minus_E_r_by_r = a1.Z * a2.Z * (erfc(eta*r)/r + (2./sqrt(M_PI))*eta*exp(-etaSq*rSq))/rSq;
-							a1.force += (RTR * x) * minus_E_r_by_r;
-							if(E_RRTptr)
-							{	vector3<> rVec = R * x;
-								E_RRT -= (0.5*minus_E_r_by_r) * outer(rVec,rVec);
-							}
-						}
+		if(not ZsqTot) { watch.stop(); return 0.; }
 		
+		//Real space sum (over neighbors within cutoff, divided over threads):
+		//--- not divided over processes, since this may be called on a subset of them (eg. exchange regularization)
+		std::vector<vector3<>> pos(atoms.size());
+		for(size_t c=0; c<atoms.size(); c++)
+			pos[c] = atoms[c].pos;
+		NeighborList neighbors(R, vector3<bool>(false,false,false), pos, rCut, false);
+		NeighborList::PairSum real = neighbors.accumulatePairs(atoms.size(),
+			[&](NeighborList::PairSum& sum, int c1, int c2, const vector3<>& x, double rSq)
+		{	double r = sqrt(rSq);
+			double Z12 = atoms[c1].Z * atoms[c2].Z;
+			sum.E += Z12 * erfc(eta*r)/r;
+			double minus_E_r_by_r = Z12 * (erfc(eta*r)/r + (2./sqrt(M_PI))*eta*exp(-etaSq*rSq))/rSq;
+			vector3<> minus_E_x = (RTR * x) * minus_E_r_by_r;
+			sum.forces[c1] += minus_E_x;
+			sum.forces[c2] -= minus_E_x;
+			if(E_RRTptr)
+			{	vector3<> rVec = R * x;
+				sum.E_RRT -= minus_E_r_by_r * outer(rVec,rVec);
+			}
+		});
+		E += real.E;
+		for(size_t c=0; c<atoms.size(); c++)
+			atoms[c].force += real.forces[c];
+		E_RRT += real.E_RRT;
 		
 		//Reciprocal space sum:
 		vector3<int> iG; //integer reciprocal cell number
@@ -128,6 +134,189 @@ public:
 				}
 		
 		if(E_RRTptr) *E_RRTptr += E_RRT;
+		watch.stop();
+		return E;
+	}
+};
+
+
+//! Smooth particle-mesh Ewald sum (Essmann et al., J. Chem. Phys. 103, 8577 (1995)) on the FFT grid
+class EwaldPeriodicMesh : public Ewald
+{
+	const GridInfo& gInfo;
+	int order; //!< B-spline interpolation order
+	double sigma; //!< gaussian width for Ewald sums
+	double rCut; //!< cutoff for real space sum
+	std::vector<double> Bsq[3]; //!< euler exponential spline modulus factors |b(m)|^2 along each direction
+	
+	//! Cardinal B-splines M_order(w + j) and their derivatives for j = 0 to order-1, and w in [0,1)
+	void bSpline(double w, double* M, double* M_w) const
+	{	M[0] = 1.; //order 1
+		for(int k=2; k<=order; k++)
+		{	if(k==order) //derivatives from order-1 splines:
+				for(int j=0; j<k; j++)
+					M_w[j] = (j<k-1 ? M[j] : 0.) - (j ? M[j-1] : 0.);
+			M[k-1] = 0.;
+			for(int j=k-1; j>=0; j--)
+				M[j] = ((w+j) * M[j] + (j ? (k-w-j)*M[j-1] : 0.)) / (k-1);
+		}
+	}
+
+public:
+	EwaldPeriodicMesh(const GridInfo& gInfo, int order) : gInfo(gInfo), order(order)
+	{	logPrintf("\n---------- Setting up particle-mesh ewald sum ----------\n");
+		//Determine gaussian width resolvable on the FFT grid:
+		double Gnyquist = DBL_MAX;
+		for(int k=0; k<3; k++)
+			Gnyquist = std::min(Gnyquist, 0.5*gInfo.S[k]*gInfo.G.row(k).length());
+		sigma = CoulombKernel::nSigmasPerWidth / Gnyquist;
+		rCut = CoulombKernel::nSigmasPerWidth * sigma;
+		logPrintf("Gaussian width for ewald sums = %lf bohr (real space cutoff %lf bohr).\n", sigma, rCut);
+		logPrintf("Interpolating charges with order %d B-splines on FFT grid ", order);
+		gInfo.S.print(globalLog, " %d ");
+		
+		//Initialize the spline modulus factors:
+		std::vector<double> M(order), M_w(order);
+		bSpline(0., M.data(), M_w.data());
+		for(int k=0; k<3; k++)
+		{	int Sk = gInfo.S[k];
+			Bsq[k].resize(Sk);
+			for(int m=0; m<Sk; m++)
+			{	complex den = 0.;
+				for(int j=0; j<order-1; j++)
+					den += M[j+1] * cis((2*M_PI*m*j)/Sk);
+				Bsq[k][m] = (den.norm() < 1e-10) ? 0. : 1./den.norm(); //drop Nyquist component for odd orders
+			}
+		}
+	}
+	
+	double energyAndGrad(std::vector<Atom>& atoms, matrix3<>* E_RRTptr) const
+	{	static StopWatch watch("EwaldPeriodicMesh::energyAndGrad"); watch.start();
+		double eta = sqrt(0.5)/sigma, etaSq=eta*eta;
+		double sigmaSq = sigma * sigma;
+		double detR = gInfo.detR; //cell volume
+		const vector3<int>& S = gInfo.S;
+		matrix3<> E_RRT; //stress * volume (computed if E_RRTptr non-null)
+		
+		//Position independent terms:
+		double Ztot = 0., ZsqTot = 0.;
+		for(const Atom& a: atoms)
+		{	Ztot += a.Z;
+			ZsqTot += a.Z * a.Z;
+		}
+		double E
+			= 0.5 * 4*M_PI * Ztot*Ztot * (-0.5*sigmaSq) / detR //G=0 correction
+			- 0.5 * ZsqTot * eta * (2./sqrt(M_PI)); //Self-energy correction
+		if(E_RRTptr)
+			E_RRT = (-0.5 * 4*M_PI * Ztot*Ztot * (-0.5*sigmaSq) / detR) * matrix3<>(1,1,1);
+		
+		//Reduce positions to first centered unit cell:
+		for(Atom& a: atoms)
+			for(int k=0; k<3; k++)
+				a.pos[k] -= floor(0.5 + a.pos[k]);
+		if(not ZsqTot) { watch.stop(); return E; }
+		
+		//Real space sum (over neighbors within cutoff, divided over processes and threads):
+		std::vector<vector3<>> pos(atoms.size());
+		for(size_t c=0; c<atoms.size(); c++)
+			pos[c] = atoms[c].pos;
+		NeighborList neighbors(gInfo.R, vector3<bool>(false,false,false), pos, rCut);
+		NeighborList::PairSum real = neighbors.accumulatePairs(atoms.size(),
+			[&](NeighborList::PairSum& sum, int c1, int c2, const vector3<>& x, double rSq)
+		{	double r = sqrt(rSq);
+			double Z12 = atoms[c1].Z * atoms[c2].Z;
+			sum.E += Z12 * erfc(eta*r)/r;
+			double minus_E_r_by_r = Z12 * (erfc(eta*r)/r + (2./sqrt(M_PI))*eta*exp(-etaSq*rSq))/rSq;
+			vector3<> minus_E_x = (gInfo.RTR * x) * minus_E_r_by_r;
+			sum.forces[c1] += minus_E_x;
+			sum.forces[c2] -= minus_E_x;
+			if(E_RRTptr)
+			{	vector3<> rVec = gInfo.R * x;
+				sum.E_RRT -= minus_E_r_by_r * outer(rVec,rVec);
+			}
+		});
+		mpiWorld->allReduce(real.E, MPIUtil::ReduceSum);
+		mpiWorld->allReduceData(real.forces, MPIUtil::ReduceSum);
+		E += real.E;
+		for(size_t c=0; c<atoms.size(); c++)
+			atoms[c].force += real.forces[c];
+		if(E_RRTptr)
+		{	mpiWorld->allReduce(real.E_RRT, MPIUtil::ReduceSum);
+			E_RRT += real.E_RRT;
+		}
+		
+		//Interpolate charges onto grid:
+		ScalarField Q; nullToZero(Q, gInfo);
+		double* Qdata = Q->data();
+		std::vector<double> M[3], M_w[3];
+		std::vector<int> iGrid[3];
+		for(int k=0; k<3; k++) { M[k].resize(order); M_w[k].resize(order); iGrid[k].resize(order); }
+		auto initSplines = [&](const Atom& a)
+		{	for(int k=0; k<3; k++)
+			{	double u = (a.pos[k] - floor(a.pos[k])) * S[k];
+				int uFloor = int(floor(u));
+				bSpline(u - uFloor, M[k].data(), M_w[k].data());
+				for(int j=0; j<order; j++)
+					iGrid[k][j] = positiveRemainder(uFloor - j, S[k]);
+			}
+		};
+		for(const Atom& a: atoms)
+		{	initSplines(a);
+			for(int j0=0; j0<order; j0++)
+			for(int j1=0; j1<order; j1++)
+			{	double w01 = a.Z * M[0][j0] * M[1][j1];
+				double* Qrow = Qdata + S[2]*(iGrid[1][j1] + S[1]*iGrid[0][j0]);
+				for(int j2=0; j2<order; j2++)
+					Qrow[iGrid[2][j2]] += w01 * M[2][j2];
+			}
+		}
+		
+		//Reciprocal space sum:
+		ScalarFieldTilde FQ = Idag(Q); //unnormalized forward transform
+		complex* FQdata = FQ->data();
+		double Erecip = 0.;
+		size_t iStart = 0, iStop = gInfo.nG;
+		THREAD_halfGspaceLoop
+		(	double Gsq = gInfo.GGT.metric_length_squared(iG);
+			if(!Gsq) { FQdata[i] = 0.; }
+			else
+			{	double weight = (iG[2]==0 || 2*iG[2]==S[2]) ? 1. : 2.; //account for the other half of G-space
+				double B = Bsq[0][positiveRemainder(iG[0],S[0])] * Bsq[1][positiveRemainder(iG[1],S[1])] * Bsq[2][iG[2]];
+				double eG = 4*M_PI * exp(-0.5*sigmaSq*Gsq)/(Gsq * detR);
+				double SGsq = B * FQdata[i].norm(); //interpolated |structure factor|^2
+				Erecip += 0.5 * weight * eG * SGsq;
+				if(E_RRTptr)
+				{	vector3<> Gcart = iG * gInfo.G;
+					double minus_eGprime_by_G = eG * (sigmaSq + 2./Gsq);
+					E_RRT += (0.5 * weight * SGsq) * (minus_eGprime_by_G * outer(Gcart,Gcart) - eG*matrix3<>(1,1,1));
+				}
+				FQdata[i] *= eG * B;
+			}
+		)
+		E += Erecip;
+		
+		//Forces from the reciprocal space potential on the grid:
+		ScalarField phi = I(FQ);
+		const double* phiData = phi->data();
+		for(Atom& a: atoms)
+		{	initSplines(a);
+			vector3<> E_u; //derivative w.r.t grid coordinates
+			for(int j0=0; j0<order; j0++)
+			for(int j1=0; j1<order; j1++)
+			{	const double* phiRow = phiData + S[2]*(iGrid[1][j1] + S[1]*iGrid[0][j0]);
+				for(int j2=0; j2<order; j2++)
+				{	double phiCur = phiRow[iGrid[2][j2]];
+					E_u[0] += phiCur * M_w[0][j0] * M[1][j1] * M[2][j2];
+					E_u[1] += phiCur * M[0][j0] * M_w[1][j1] * M[2][j2];
+					E_u[2] += phiCur * M[0][j0] * M[1][j1] * M_w[2][j2];
+				}
+			}
+			for(int k=0; k<3; k++)
+				a.force[k] -= a.Z * S[k] * E_u[k];
+		}
+		
+		if(E_RRTptr) *E_RRTptr += E_RRT;
+		watch.stop();
 		return E;
 	}
 };
@@ -147,7 +336,9 @@ ScalarFieldTilde CoulombPeriodic::apply(ScalarFieldTilde&& in) const
 }
 
 std::shared_ptr<Ewald> CoulombPeriodic::createEwald(matrix3<> R, size_t nAtoms) const
-{	return std::make_shared<EwaldPeriodic>(R, nAtoms);
+{	if(params.ewaldSplineOrder && R==gInfo.R) //mesh method only for the unit cell (not exchange supercells)
+		return std::make_shared<EwaldPeriodicMesh>(gInfo, params.ewaldSplineOrder);
+	return std::make_shared<EwaldPeriodic>(R, nAtoms);
 }
 
 matrix3<> CoulombPeriodic::getLatticeGradient(const ScalarFieldTilde& X, const ScalarFieldTilde& Y) const
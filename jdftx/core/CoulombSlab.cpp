@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Coulomb_internal.h>
 #include <core/CoulombKernel.h>
 #include <core/BlasExtra.h>
+#include <core/NeighborList.h>
 
 //! 2D Ewald sum
 class EwaldSlab : public Ewald
@@ -29,7 +30,7 @@ class EwaldSlab : public Ewald
 	int iDir; //!< truncated direction
 	double ionMargin; //!< Safety-margin around ions
 	double sigma; //!< gaussian width for Ewald sums
-	vector3<int> Nreal; //!< max unit cell indices for real-space sum
+	double rCut; //!< cutoff for real-space sum
 	vector3<int> Nrecip; //!< max unit cell indices for reciprocal-space sum
 
 public:
@@ -49,12 +50,10 @@ public:
 		
 		//Carry real space sums to Rmax = 10 sigma and Gmax = 10/sigma
 		//This leads to relative errors ~ 1e-22 in both sums, well within double precision limits
+		rCut = CoulombKernel::nSigmasPerWidth * sigma;
 		for(int k=0; k<3; k++)
-		{	Nreal[k]  = (k==iDir) ? 0 : 1+ceil(CoulombKernel::nSigmasPerWidth * G.row(k).length() * sigma / (2*M_PI));
 			Nrecip[k] = (k==iDir) ? 0 : 1+ceil(CoulombKernel::nSigmasPerWidth * R.column(k).length() / (2*M_PI*sigma));
-		}
-		logPrintf("Real space sums over %d unit cells with max indices ", (2*Nreal[0]+1)*(2*Nreal[1]+1)*(2*Nreal[2]+1));
-		Nreal.print(globalLog, " %d ");
+		logPrintf("Real space sums over neighbors within %lf bohr.\n", rCut);
 		logPrintf("Reciprocal space sums over %d terms with max indices ", (2*Nrecip[0]+1)*(2*Nrecip[1]+1)*(2*Nrecip[2]+1));
 		Nrecip.print(globalLog, " %d ");
 	}
@@ -83,25 +82,30 @@ public:
 				a.pos[k] -= floor(0.5 + a.pos[k] - pos0[k]);
 		if(not ZsqTot) return 0.;
 		
-		//Real space sum:
-		vector3<int> iR; //integer cell number
-		for(const Atom& a2: atoms)
-			for(Atom& a1: atoms)
-				for(iR[0]=-Nreal[0]; iR[0]<=Nreal[0]; iR[0]++)
-					for(iR[1]=-Nreal[1]; iR[1]<=Nreal[1]; iR[1]++)
-						for(iR[2]=-Nreal[2]; iR[2]<=Nreal[2]; iR[2]++)
-						{	vector3<> x = iR + (a1.pos - a2.pos);
-							double rSq = RTR.metric_length_squared(x);
-							if(!rSq) continue; //exclude self-interaction
-							double r = sqrt(rSq);
-							E += 0.5 * a1.Z * a2.Z * erfc(eta*r)/r;
-							double minus_E_r_by_r = a1.Z * a2.Z * (erfc(eta*r)/r + (2./sqrt(M_PI))*eta*exp(-etaSq*rSq))/rSq;
-							a1.force += (RTR * x) * minus_E_r_by_r;
-							if(E_RRTptr)
-							{	vector3<> rVec = R * x;
-								E_RRT -= (0.5*minus_E_r_by_r) * outer(rVec,rVec);
-							}
-						}
+		//Real space sum (over neighbors within cutoff, divided over threads):
+		std::vector<vector3<>> pos(atoms.size());
+		for(size_t c=0; c<atoms.size(); c++)
+			pos[c] = atoms[c].pos;
+		vector3<bool> isTruncated(false,false,false); isTruncated[iDir] = true;
+		NeighborList neighbors(R, isTruncated, pos, rCut, false); //not divided over processes (see EwaldPeriodic)
+		NeighborList::PairSum real = neighbors.accumulatePairs(atoms.size(),
+			[&](NeighborList::PairSum& sum, int c1, int c2, const vector3<>& x, double rSq)
+		{	double r = sqrt(rSq);
+			double Z12 = atoms[c1].Z * atoms[c2].Z;
+			sum.E += Z12 * erfc(eta*r)/r;
+			double minus_E_r_by_r = Z12 * (erfc(eta*r)/r + (2./sqrt(M_PI))*eta*exp(-etaSq*rSq))/rSq;
+			vector3<> minus_E_x = (RTR * x) * minus_E_r_by_r;
+			sum.forces[c1] += minus_E_x;
+			sum.forces[c2] -= minus_E_x;
+			if(E_RRTptr)
+			{	vector3<> rVec = R * x;
+				sum.E_RRT -= minus_E_r_by_r * outer(rVec,rVec);
+			}
+		});
+		E += real.E;
+		for(size_t c=0; c<atoms.size(); c++)
+			atoms[c].force += real.forces[c];
+		E_RRT += real.E_RRT;
 		
 		//Reciprocal space sum:
 		double L = sqrt(RTR(iDir,iDir)); //length of truncated direction
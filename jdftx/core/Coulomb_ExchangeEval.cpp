@@ -227,11 +227,15 @@ ExchangeEval::ExchangeEval(const GridInfo& gInfo, const CoulombParams& params, c
 {
 	if(!omega) logPrintf("\n-------- Setting up exchange kernel --------\n");
 	else logPrintf("\n--- Setting up screened exchange kernel (omega = %lg) ---\n", omega);
+	nTablesMax = size_t(params.exchangeKernelTableMB * (1<<20) / (gInfo.nr * sizeof(double)));
 	
-	//Obtain supercell parameters, and adjust for mesh embedding where necessary:
+	//Obtain supercell parameters (of the downsampled q-mesh, if any), and adjust for mesh embedding where necessary:
 	assert(params.supercell);
-	const matrix3<int>& super = params.supercell->super;
-	const std::vector< vector3<> >& kmesh = params.supercell->kmesh;
+	matrix3<int> super;
+	std::vector< vector3<> > kmesh;
+	params.supercell->getDownsampledMesh(params.exchangeDownsample, super, kmesh);
+	if(kmesh.size() != params.supercell->kmesh.size())
+		logPrintf("Using downsampled q-mesh with %lu of %lu k-point differences.\n", kmesh.size(), params.supercell->kmesh.size());
 	matrix3<> Rsuper = gInfo.R * super; //this could differ from supercell->Rsuper, because the embedding gInfo.R is scaled up from the original gInfo.R
 	
 	//Check supercell:
@@ -540,6 +544,7 @@ ExchangeEval::ExchangeEval(const GridInfo& gInfo, const CoulombParams& params, c
 				for(int k=0; k<3; k++) dk[k] -= floor(dk[k] + 0.5); //reduce to fundamental zone:
 				 dkArr.push_back(dk);
 			}
+			dkLookup = std::make_shared<PeriodicLookup< vector3<> > >(dkArr, gInfo.GGT);
 			
 			//Split supercell kernel into one for each k-point difference:
 			logPrintf("Splitting supercell kernel to unit-cell with k-points ... "); logFlush();
@@ -567,17 +572,98 @@ ExchangeEval::~ExchangeEval()
 }
 
 
+void multTransformedKernel(const GridInfo& gInfo, complex* data, const double* kernel, const vector3<int>& offset)
+{	if(!offset.length_squared())
+		callPref(eblas_zmuld)(gInfo.nr, kernel, 1, data, 1);
+	else
+		callPref(multTransformedKernel)(gInfo.S, kernel, data, offset);
+}
 void multTransformedKernel(complexScalarFieldTilde& X, const double* kernel, const vector3<int>& offset)
 {	assert(X);
-	if(!offset.length_squared())
-		callPref(eblas_zmuld)(X->gInfo.nr, kernel, 1, X->dataPref(false), 1);
-	else
-		callPref(multTransformedKernel)(X->gInfo.S, kernel, X->dataPref(false), offset);
+	multTransformedKernel(X->gInfo, X->dataPref(false), kernel, offset);
+}
+
+size_t ExchangeEval::findKdiff(const vector3<>& kDiff, vector3<int>& offset) const
+{	size_t ik = dkLookup->find(kDiff);
+	if(ik == string::npos) die("Encountered invalid kDiff [ %lg %lg %lg ] in exchange kernel.\n", kDiff[0], kDiff[1], kDiff[2]);
+	//Find the integer offset, if any:
+	double err;
+	offset = round(dkArr[ik] - kDiff, &err);
+	assert(err < symmThreshold);
+	return ik;
+}
+
+const double* ExchangeEval::getKernel(vector3<> kDiff, vector3<int>& offset) const
+{	offset = vector3<int>();
+	switch(kernelMode)
+	{	case NumericalKernel:
+		{	//Find the appropriate kDiff:
+			size_t ik = findKdiff(kDiff, offset);
+			return kernelData.dataPref() + gInfo.nr * ik;
+		}
+		case PeriodicKernel:
+		case SphericalKernel:
+		case SlabKernel:
+		{	//Look up previously tabulated kernels:
+			for(unsigned ik=0; ik<dkTable.size(); ik++)
+				if((dkTable[ik] - kDiff).length_squared() < symmThresholdSq)
+					return kernelTable[ik]->dataPref();
+			if(dkTable.size() >= nTablesMax) return 0; //out of budget (or tables disabled)
+			//Tabulate by applying the kernel to a constant:
+			ManagedArray<complex> ones(std::vector<complex>(gInfo.nr, 1.));
+			complex* onesData = ones.dataPref();
+			#define CALL_exchangeAnalytic(calc) callPref(exchangeAnalytic)(gInfo.S, gInfo.GGT, calc, onesData, kDiff, Vzero, symmThresholdSq)
+			if(kernelMode == PeriodicKernel)
+			{	if(omega) CALL_exchangeAnalytic(ExchangePeriodicScreened_calc(omega));
+				else CALL_exchangeAnalytic(ExchangePeriodic_calc());
+			}
+			else if(kernelMode == SphericalKernel)
+			{	if(omega) CALL_exchangeAnalytic(sphericalScreenedCalc);
+				else CALL_exchangeAnalytic(ExchangeSpherical_calc(Rc));
+			}
+			else CALL_exchangeAnalytic(slabCalc);
+			#undef CALL_exchangeAnalytic
+			std::shared_ptr<ManagedArray<double>> kernel = std::make_shared<ManagedArray<double>>();
+			kernel->init(gInfo.nr, isGpuEnabled());
+			kernel->zero();
+			callPref(eblas_daxpy)(gInfo.nr, 1., (const double*)onesData, 2, kernel->dataPref(), 1); //kernel is real
+			dkTable.push_back(kDiff);
+			kernelTable.push_back(kernel);
+			return kernel->dataPref();
+		}
+		default: return 0; //WignerSeitzGammaKernel uses a half-space real kernel instead
+	}
+}
+
+bool ExchangeEval::applyBatch(complex* data, int howMany, vector3<> kDiff, double* nKn) const
+{	vector3<int> offset;
+	const double* kernel = getKernel(kDiff, offset);
+	if(!kernel) return false;
+	int nr = gInfo.nr;
+	ManagedArray<complex> Kn; Kn.init(nr, isGpuEnabled());
+	complex* KnData = Kn.dataPref();
+	for(int i=0; i<howMany; i++)
+	{	complex* nData = data + size_t(i)*nr;
+		callPref(eblas_copy)(KnData, nData, nr);
+		multTransformedKernel(gInfo, KnData, kernel, offset);
+		nKn[i] = gInfo.detR * callPref(eblas_zdotc)(nr, nData, 1, KnData, 1).real();
+		callPref(eblas_zero)(nr, nData);
+		callPref(eblas_zaxpy)(nr, gInfo.detR, KnData, 1, nData, 1); //O(K n) in place of n
+	}
+	return true;
 }
 
 
 complexScalarFieldTilde ExchangeEval::operator()(complexScalarFieldTilde&& in, vector3<> kDiff) const
-{
+{	//Use tabulated kernel if available:
+	if(nTablesMax and kernelMode!=NumericalKernel)
+	{	vector3<int> offset;
+		const double* kernel = getKernel(kDiff, offset);
+		if(kernel)
+		{	multTransformedKernel(in, kernel, offset);
+			return in;
+		}
+	}
 	#define CALL_exchangeAnalytic(calc) callPref(exchangeAnalytic)(gInfo.S, gInfo.GGT, calc, in->dataPref(false), kDiff, Vzero, symmThresholdSq)
 	switch(kernelMode)
 	{	case PeriodicKernel:
@@ -600,20 +686,9 @@ complexScalarFieldTilde ExchangeEval::operator()(complexScalarFieldTilde&& in, v
 			break;
 		}
 		case NumericalKernel:
-		{	//Find the appropriate kDiff:
-			bool kDiffFound = false;
-			for(unsigned ik=0; ik<dkArr.size(); ik++)
-				if(circDistanceSquared(dkArr[ik], kDiff) < symmThresholdSq)
-				{	//Find the integer offset, if any:
-					double err;
-					vector3<int> offset = round(dkArr[ik] - kDiff, &err);
-					assert(err < symmThreshold);
-					//Multiply kernel:
-					multTransformedKernel(in, kernelData.dataPref() + gInfo.nr * ik, offset);
-					kDiffFound = true;
-					break;
-				}
-			assert(kDiffFound);
+		{	vector3<int> offset;
+			const double* kernel = getKernel(kDiff, offset);
+			multTransformedKernel(in, kernel, offset);
 			break;
 		}
 	}
@@ -650,20 +725,13 @@ matrix3<> ExchangeEval::latticeGradient(const complexScalarFieldTilde& X, vector
 		}
 		case NumericalKernel:
 		{	//Find kernel with the appropriate kDiff:
-			for(unsigned ik=0; ik<dkArr.size(); ik++)
-				if(circDistanceSquared(dkArr[ik], kDiff) < symmThresholdSq)
-				{	//Find the integer offset, if any:
-					double err;
-					vector3<int> offset = round(dkArr[ik] - kDiff, &err);
-					assert(err < symmThreshold);
-					//Compute stress:
-					ManagedArray<symmetricMatrix3<>> result; result.init(gInfo.nr, isGpuEnabled());
-					callPref(transformedKernelStress)(gInfo.S, kernelData_RRT.dataPref() + gInfo.nr * ik, X->dataPref(), result.dataPref(), offset);
-					matrix3<> resultSum = callPref(eblas_sum)(gInfo.nr, result.dataPref());
-					return gInfo.detR * resultSum;
-				}
-			assert(!"Encountered invalid kDiff");
-			return matrix3<>();
+			vector3<int> offset;
+			size_t ik = findKdiff(kDiff, offset);
+			//Compute stress:
+			ManagedArray<symmetricMatrix3<>> result; result.init(gInfo.nr, isGpuEnabled());
+			callPref(transformedKernelStress)(gInfo.S, kernelData_RRT.dataPref() + gInfo.nr * ik, X->dataPref(), result.dataPref(), offset);
+			matrix3<> resultSum = callPref(eblas_sum)(gInfo.nr, result.dataPref());
+			return gInfo.detR * resultSum;
 		}
 		default:
 			die_alone("Lattice gradient not yet implemented for this kernel mode.");
@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/Coulomb.h>
 #include <core/Coulomb_internal.h>
+#include <core/LatticeUtils.h>
 
 //! @addtogroup LongRange
 //! @{
@@ -35,11 +36,18 @@ struct ExchangeEval
 
 	//! Return the lattice gradient of exchange integral dot(X, O(coulomb(X)) for given k-point difference
 	matrix3<> latticeGradient(const complexScalarFieldTilde& X, vector3<> kDiff) const;
+	
+	//! Batched kernel application with energies (see Coulomb::applyExchangeBatch)
+	bool applyBatch(complex* data, int howMany, vector3<> kDiff, double* nKn) const;
 
 private:
 	const GridInfo& gInfo;
 	double omega;
 	
+	//! Get tabulated kernel (with integer offset of kDiff from the tabulated one) if available, or null otherwise.
+	//! Numerical kernels are always tabulated; analytic ones are tabulated on first use within the memory budget.
+	const double* getKernel(vector3<> kDiff, vector3<int>& offset) const;
+	
 	//Shorthand for combinations of regularization method and geometry
 	enum KernelMode
 	{	PeriodicKernel, //regularization = None/AuxiliaryFunction/ProbeChargeEwald, with geometry = Periodic
@@ -64,8 +72,14 @@ private:
 	ManagedArray<symmetricMatrix3<>>* VcGamma_RRT; //corresponding lattice derivative
 	//For precomputed numerical kernel mode:
 	std::vector< vector3<> > dkArr; //list of allowed k-point differences (modulo integer offsets)
+	std::shared_ptr<PeriodicLookup< vector3<> > > dkLookup; //O(1) lookup into dkArr
+	size_t findKdiff(const vector3<>& kDiff, vector3<int>& offset) const; //index into dkArr and offset from kDiff to it
 	ManagedArray<double> kernelData; //data for all the kernels
 	ManagedArray<symmetricMatrix3<>> kernelData_RRT; //lattice derivative data for all the kernels
+	//Tables of analytic kernels (by exact k-point difference, since analytic kernels need not be periodic in kDiff):
+	size_t nTablesMax; //maximum number of tables within CoulombParams::exchangeKernelTableMB
+	mutable std::vector< vector3<> > dkTable; //k-point differences tabulated so far
+	mutable std::vector< std::shared_ptr<ManagedArray<double>> > kernelTable; //corresponding kernels (on the GPU when enabled)
 };
 
 //! @}
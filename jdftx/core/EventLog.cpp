@@ -0,0 +1,106 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <core/Util.h>
+#include <sys/resource.h>
+#include <cmath>
+#include <mutex>
+
+namespace EventLog
+{
+	bool active = false;
+	static FILE* fp = 0;
+	static std::mutex lock;
+	
+	void start(string filename)
+	{	if(!mpiWorld->isHead()) return;
+		fp = fopen(filename.c_str(), "w");
+		if(!fp) die_alone("Could not open event log '%s' for writing.\n", filename.c_str());
+		active = true;
+	}
+	
+	void finish()
+	{	if(!active) return;
+		{	Event event("end");
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		active = false;
+		fclose(fp);
+		fp = 0;
+	}
+	
+	//Quote string for JSON output
+	static string jsonString(const char* s)
+	{	string out("\"");
+		for(; *s; s++)
+		{	char c = *s;
+			if(c=='"' || c=='\\') out.push_back('\\');
+			if(c=='\t' || c=='\n') c = ' ';
+			out.push_back(c);
+		}
+		out.push_back('"');
+		return out;
+	}
+	
+	Event::Event(const char* type, const char* prefix)
+	{	if(!active) return;
+		oss << "{\"type\":" << jsonString(type);
+		if(prefix)
+		{	string prefixTrimmed(prefix); //drop trailing spaces and colon of log line prefix
+			while(prefixTrimmed.length() && (isspace(prefixTrimmed.back()) || prefixTrimmed.back()==':'))
+				prefixTrimmed.pop_back();
+			oss << ",\"prefix\":" << jsonString(prefixTrimmed.c_str());
+		}
+	}
+	
+	Event::~Event()
+	{	if(!active) return;
+		struct rusage usage; getrusage(RUSAGE_SELF, &usage);
+		add("t", clock_sec());
+		add("maxRSS_MB", usage.ru_maxrss/1024.); //ru_maxrss is in kB on Linux
+		oss << "}\n";
+		std::lock_guard<std::mutex> guard(lock);
+		if(!fp) return;
+		fputs(oss.str().c_str(), fp);
+		fflush(fp); //for real-time monitoring
+	}
+	
+	Event& Event::add(const char* key, double value)
+	{	if(!active) return *this;
+		oss << ',' << jsonString(key) << ':';
+		if(std::isfinite(value))
+		{	char buf[32]; snprintf(buf, sizeof(buf), "%.15lg", value);
+			oss << buf;
+		}
+		else oss << "null";
+		return *this;
+	}
+	
+	Event& Event::add(const char* key, int value)
+	{	if(!active) return *this;
+		oss << ',' << jsonString(key) << ':' << value;
+		return *this;
+	}
+	
+	Event& Event::add(const char* key, const char* value)
+	{	if(!active) return *this;
+		oss << ',' << jsonString(key) << ':' << jsonString(value);
+		return *this;
+	}
+}
@@ -0,0 +1,167 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_CORE_GPUBACKEND_H
+#define JDFTX_CORE_GPUBACKEND_H
+
+//! @addtogroup Utilities
+//! @{
+
+//! @file GpuBackend.h
+//! @brief Runtime, BLAS, FFT and solver headers of the GPU backend
+//!
+//! All GPU code is written against the CUDA runtime, cuBLAS, cuFFT and cuSolverDn APIs.
+//! With HIP_ENABLED (AMD GPUs), this header instead includes the HIP runtime, hipBLAS, hipFFT
+//! and hipSOLVER, and maps the subset of CUDA names used in JDFTx to their HIP equivalents,
+//! so that the same .cu kernels (compiled by hipcc) and callPref() dispatch points serve both.
+//! Include this header instead of any vendor GPU header; names used in new GPU code must be added below.
+
+#ifdef HIP_ENABLED
+
+#define HIPBLAS_V2 //use hipDoubleComplex (= double2) in the hipBLAS interface, as cuBLAS does
+#include <hip/hip_runtime.h>
+#include <hipblas/hipblas.h>
+#include <hipfft/hipfft.h>
+#ifdef CUSOLVER_ENABLED
+#include <hipsolver/hipsolver.h>
+#endif
+
+#define GPU_BACKEND_NAME "HIP" //!< name of GPU backend in error messages
+
+//Runtime:
+#define cudaError_t hipError_t
+#define cudaSuccess hipSuccess
+#define cudaGetLastError hipGetLastError
+#define cudaGetErrorString hipGetErrorString
+#define cudaDeviceProp hipDeviceProp_t
+#define cudaGetDeviceCount hipGetDeviceCount
+#define cudaGetDeviceProperties hipGetDeviceProperties
+#define cudaGetDevice hipGetDevice
+#define cudaSetDevice hipSetDevice
+#define cudaDeviceSynchronize hipDeviceSynchronize
+#define cudaFuncAttributes hipFuncAttributes
+#define cudaFuncGetAttributes hipFuncGetAttributes
+#define cudaMalloc hipMalloc
+#define cudaFree hipFree
+#define cudaMallocHost hipHostMalloc
+#define cudaHostAlloc hipHostMalloc
+#define cudaHostAllocDefault hipHostMallocDefault
+#define cudaFreeHost hipHostFree
+#define cudaMemset hipMemset
+#define cudaMemcpy hipMemcpy
+#define cudaMemcpyAsync hipMemcpyAsync
+#define cudaMemcpyKind hipMemcpyKind
+#define cudaMemcpyHostToDevice hipMemcpyHostToDevice
+#define cudaMemcpyDeviceToHost hipMemcpyDeviceToHost
+#define cudaMemcpyDeviceToDevice hipMemcpyDeviceToDevice
+#define cudaStream_t hipStream_t
+#define cudaStreamNonBlocking hipStreamNonBlocking
+#define cudaStreamCreateWithFlags hipStreamCreateWithFlags
+#define cudaStreamSynchronize hipStreamSynchronize
+#define cudaStreamWaitEvent hipStreamWaitEvent
+#define cudaEvent_t hipEvent_t
+#define cudaEventDisableTiming hipEventDisableTiming
+#define cudaEventCreateWithFlags hipEventCreateWithFlags
+#define cudaEventRecord hipEventRecord
+#define cudaEventSynchronize hipEventSynchronize
+
+//BLAS:
+#define cublasHandle_t hipblasHandle_t
+#define cublasCreate hipblasCreate
+#define cublasOperation_t hipblasOperation_t
+#define CUBLAS_OP_N HIPBLAS_OP_N
+#define CUBLAS_OP_T HIPBLAS_OP_T
+#define CUBLAS_OP_C HIPBLAS_OP_C
+#define cublasZgemm hipblasZgemm
+#define cublasZgemmBatched hipblasZgemmBatched
+#define cublasDasum hipblasDasum
+#define cublasDaxpy_v2 hipblasDaxpy
+#define cublasZaxpy_v2 hipblasZaxpy
+#define cublasDdot_v2 hipblasDdot
+#define cublasZdotc_v2 hipblasZdotc
+#define cublasDnrm2_v2 hipblasDnrm2
+#define cublasDznrm2_v2 hipblasDznrm2
+#define cublasDscal_v2 hipblasDscal
+#define cublasZdscal_v2 hipblasZdscal
+#define cublasZscal_v2 hipblasZscal
+
+//FFT:
+#define cufftHandle hipfftHandle
+#define cufftDoubleComplex hipfftDoubleComplex
+#define CUFFT_FORWARD HIPFFT_FORWARD
+#define CUFFT_INVERSE HIPFFT_BACKWARD
+#define CUFFT_Z2Z HIPFFT_Z2Z
+#define CUFFT_D2Z HIPFFT_D2Z
+#define CUFFT_Z2D HIPFFT_Z2D
+#define cufftPlan3d hipfftPlan3d
+#define cufftPlanMany hipfftPlanMany
+#define cufftDestroy hipfftDestroy
+#define cufftExecZ2Z hipfftExecZ2Z
+#define cufftExecD2Z hipfftExecD2Z
+#define cufftExecZ2D hipfftExecZ2D
+
+//Dense solvers:
+#ifdef CUSOLVER_ENABLED
+#define cusolverDnHandle_t hipsolverDnHandle_t
+#define cusolverDnCreate hipsolverDnCreate
+#define cusolverEigMode_t hipsolverEigMode_t
+#define CUSOLVER_EIG_MODE_VECTOR HIPSOLVER_EIG_MODE_VECTOR
+#define CUSOLVER_OP_N HIPSOLVER_OP_N
+#define cublasFillMode_t hipsolverFillMode_t
+#define CUBLAS_FILL_MODE_UPPER HIPSOLVER_FILL_MODE_UPPER
+#define syevjInfo_t hipsolverSyevjInfo_t
+#define gesvdjInfo_t hipsolverGesvdjInfo_t
+#define cusolverDnCreateSyevjInfo hipsolverDnCreateSyevjInfo
+#define cusolverDnDestroySyevjInfo hipsolverDnDestroySyevjInfo
+#define cusolverDnCreateGesvdjInfo hipsolverDnCreateGesvdjInfo
+#define cusolverDnDestroyGesvdjInfo hipsolverDnDestroyGesvdjInfo
+#define cusolverDnZpotrf_bufferSize hipsolverDnZpotrf_bufferSize
+#define cusolverDnZpotrf hipsolverDnZpotrf
+#define cusolverDnZpotrs hipsolverDnZpotrs
+#define cusolverDnZgetrf_bufferSize hipsolverDnZgetrf_bufferSize
+#define cusolverDnZgetrf hipsolverDnZgetrf
+#define cusolverDnZgetrs hipsolverDnZgetrs
+#define cusolverDnZheevj_bufferSize hipsolverDnZheevj_bufferSize
+#define cusolverDnZheevj hipsolverDnZheevj
+#define cusolverDnZheevjBatched_bufferSize hipsolverDnZheevjBatched_bufferSize
+#define cusolverDnZheevjBatched hipsolverDnZheevjBatched
+#define cusolverDnZgesvdj_bufferSize hipsolverDnZgesvdj_bufferSize
+#define cusolverDnZgesvdj hipsolverDnZgesvdj
+#define cusolverDnZgesvdjBatched_bufferSize hipsolverDnZgesvdjBatched_bufferSize
+#define cusolverDnZgesvdjBatched hipsolverDnZgesvdjBatched
+#endif
+
+#else //CUDA
+
+#include <cuda_runtime.h>
+#include <driver_types.h>
+#include <vector_types.h>
+#include <cublas_v2.h>
+#include <cufft.h>
+#ifdef CUSOLVER_ENABLED
+#include <cusolverDn.h>
+#define CUSOLVER_OP_N CUBLAS_OP_N //!< transpose flag for cuSolver (which shares cuBLAS types)
+#endif
+
+#define GPU_BACKEND_NAME "CUDA" //!< name of GPU backend in error messages
+
+#endif //HIP_ENABLED
+
+//! @}
+#endif // JDFTX_CORE_GPUBACKEND_H
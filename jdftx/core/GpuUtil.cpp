@@ -25,9 +25,11 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <utility>
 #include <cstdlib>
 #include <algorithm>
+#include <cstring>
 
 cudaDeviceProp cudaDevProps; //cached properties of currently running device
 cublasHandle_t cublasHandle;
+cudaStream_t gpuCopyStream;
 #ifdef CUSOLVER_ENABLED
 cusolverDnHandle_t cusolverHandle;
 #endif
@@ -54,7 +56,7 @@ bool gpuInit(FILE* fpLog, const MPIUtil* mpiHostGpu, double* nGPUs)
 			&& computeCap >= std::make_pair(1,3) //compute capability >= 1.3 for double precision
 			&& !prop.integrated) //reject on-board devices
 		{
-			fprintf(fpLog, "gpuInit: Found compatible cuda device %d '%s'\n", device, prop.name);
+			fprintf(fpLog, "gpuInit: Found compatible " GPU_BACKEND_NAME " device %d '%s'\n", device, prop.name);
 			compatibleDevices.push_back(device);
 			if(prop.totalGlobalMem > maxGlobalMem)
 			{	maxGlobalMem = prop.totalGlobalMem;
@@ -79,9 +81,19 @@ bool gpuInit(FILE* fpLog, const MPIUtil* mpiHostGpu, double* nGPUs)
 	cudaSetDevice(selectedDevice);
 	cudaGetDeviceProperties(&cudaDevProps, selectedDevice);
 	cublasCreate(&cublasHandle);
+	cudaStreamCreateWithFlags(&gpuCopyStream, cudaStreamNonBlocking);
 	#ifdef CUSOLVER_ENABLED
 	cusolverDnCreate(&cusolverHandle);
 	#endif
+	
+	#ifdef NCCL_ENABLED
+	//Use NCCL for collectives on GPU data if every process has its own GPU (on all hosts):
+	bool gpuExclusive = (!mpiHostGpu) || (mpiHostGpu->nProcesses() <= int(compatibleDevices.size()));
+	mpiWorld->allReduce(gpuExclusive, MPIUtil::ReduceLAnd);
+	MPIUtil::ncclActive = gpuExclusive and (mpiWorld->nProcesses() > 1);
+	if(MPIUtil::ncclActive) fprintf(fpLog, "gpuInit: Using NCCL for collectives on GPU data\n");
+	else if(mpiWorld->nProcesses() > 1) fprintf(fpLog, "gpuInit: Not using NCCL since GPUs are shared between processes\n");
+	#endif
 	return true;
 }
 
@@ -93,9 +105,69 @@ void gpuErrorCheck()
 {	//cudaDeviceSynchronize(); //NOTE: Uncomment this when trying to debug GPU kernel launches
 	cudaError_t err = cudaGetLastError();
 	if(err != cudaSuccess)
-	{	fprintf(stderr, "CUDA Error: %s\n", cudaGetErrorString(err));
+	{	fprintf(stderr, GPU_BACKEND_NAME " Error: %s\n", cudaGetErrorString(err));
 		stackTraceExit(1);
 	}
 }
 
+//Pair of pinned host buffers used alternately by gpuMemcpyStaged (allocated on first use, never freed):
+struct PinnedHostMemory
+{	static const size_t chunkSize = size_t(4)<<20; //bytes per staging buffer
+	char* buf[2];
+	cudaEvent_t done[2]; //completion of the last transfer using each buffer
+	cudaEvent_t ready; //completion of prior work on the default stream
+	PinnedHostMemory()
+	{	for(int i=0; i<2; i++)
+		{	cudaHostAlloc((void**)&buf[i], chunkSize, cudaHostAllocDefault);
+			cudaEventCreateWithFlags(&done[i], cudaEventDisableTiming);
+		}
+		cudaEventCreateWithFlags(&ready, cudaEventDisableTiming);
+		gpuErrorCheck();
+	}
+};
+
+void gpuMemcpyStaged(void* dest, const void* src, size_t nBytes, cudaMemcpyKind kind)
+{	assert(kind==cudaMemcpyHostToDevice || kind==cudaMemcpyDeviceToHost);
+	if(nBytes <= PinnedHostMemory::chunkSize) //no pipelining possible: plain copy
+	{	cudaMemcpy(dest, src, nBytes, kind);
+		gpuErrorCheck();
+		return;
+	}
+	static PinnedHostMemory* pinned = new PinnedHostMemory;
+	const size_t chunkSize = PinnedHostMemory::chunkSize;
+	size_t nChunks = (nBytes + chunkSize - 1) / chunkSize;
+	//Order the transfers after work already queued on the default stream (which gpuCopyStream does not wait for implicitly):
+	cudaEventRecord(pinned->ready, 0);
+	cudaStreamWaitEvent(gpuCopyStream, pinned->ready, 0);
+	if(kind == cudaMemcpyHostToDevice)
+	{	for(size_t iChunk=0; iChunk<nChunks; iChunk++)
+		{	int b = iChunk % 2;
+			size_t offset = iChunk*chunkSize, n = std::min(chunkSize, nBytes-offset);
+			cudaEventSynchronize(pinned->done[b]); //previous transfer from this buffer complete
+			memcpy(pinned->buf[b], ((const char*)src)+offset, n);
+			cudaMemcpyAsync(((char*)dest)+offset, pinned->buf[b], n, kind, gpuCopyStream);
+			cudaEventRecord(pinned->done[b], gpuCopyStream);
+		}
+	}
+	else //cudaMemcpyDeviceToHost
+	{	//Keep one chunk in flight while copying the previous one out of the pinned buffer:
+		for(size_t iChunk=0; iChunk<=nChunks; iChunk++)
+		{	if(iChunk < nChunks)
+			{	int b = iChunk % 2;
+				size_t offset = iChunk*chunkSize, n = std::min(chunkSize, nBytes-offset);
+				cudaMemcpyAsync(pinned->buf[b], ((const char*)src)+offset, n, kind, gpuCopyStream);
+				cudaEventRecord(pinned->done[b], gpuCopyStream);
+			}
+			if(iChunk)
+			{	size_t iPrev = iChunk-1; int b = iPrev % 2;
+				size_t offset = iPrev*chunkSize, n = std::min(chunkSize, nBytes-offset);
+				cudaEventSynchronize(pinned->done[b]);
+				memcpy(((char*)dest)+offset, pinned->buf[b], n);
+			}
+		}
+	}
+	cudaStreamSynchronize(gpuCopyStream);
+	gpuErrorCheck();
+}
+
 #endif //GPU_ENABLED
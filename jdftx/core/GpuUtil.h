@@ -23,9 +23,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef GPU_ENABLED
 
 #include <cstdio>
-#include <cuda_runtime.h>
-#include <cublas_v2.h>
-#include <cufft.h>
+#include <core/GpuBackend.h>
 #include <vector>
 
 //! @addtogroup Utilities
@@ -35,7 +33,6 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 extern cublasHandle_t cublasHandle; //!< global handle to cublas (defined in GpuUtil.cpp)
 #ifdef CUSOLVER_ENABLED
-#include <cusolverDn.h>
 extern cusolverDnHandle_t cusolverHandle;  //!< global handle to cusolverDn (defined in GpuUtil.cpp)
 #endif
 
@@ -52,6 +49,14 @@ bool isGpuMine();
 //! Check for gpu errors, and if any, abort with a useful messsage
 extern void gpuErrorCheck();
 
+extern cudaStream_t gpuCopyStream; //!< non-blocking stream for host-device transfers (created in gpuInit)
+
+//! Copy nBytes between pageable host memory and the GPU (kind = cudaMemcpyHostToDevice or cudaMemcpyDeviceToHost),
+//! staged through pinned host buffers on gpuCopyStream so that the PCIe transfer of each chunk overlaps
+//! the host-side copy of the previous one. Ordered after all work already queued on the default stream;
+//! returns after the copy completes (drop-in replacement for a synchronous cudaMemcpy).
+void gpuMemcpyStaged(void* dest, const void* src, size_t nBytes, cudaMemcpyKind kind);
+
 #endif //GPU_ENABLED
 
 
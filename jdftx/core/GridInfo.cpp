@@ -23,6 +23,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Operators.h>
 #include <core/LatticeUtils.h>
 #include <algorithm>
+#include <cfloat>
+#include <unistd.h>
 
 #ifdef MKL_PROVIDES_FFT
 #include <fftw3_mkl.h>
@@ -30,7 +32,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 const double GridInfo::maxAllowedStrain = 0.35;
 
-GridInfo::GridInfo():Gmax(0),GmaxRho(0),nr(0),initialized(false)
+GridInfo::GridInfo():Gmax(0),GmaxRho(0),fftBoxTuneExcess(0.),nr(0),fftBatchSize(1),fftSinglePrecision(false),fftPruning(false),initialized(false)
 {
 }
 
@@ -40,11 +42,19 @@ GridInfo::~GridInfo()
 	{	//Destroy cached FFTW plans, if any:
 		for(auto entry: planCache)
 			fftw_destroy_plan(entry.second);
+		for(auto entry: planPrunedCache)
+			fftw_destroy_plan(entry.second);
+		#ifdef FFTW_SINGLE_ENABLED
+		for(auto entry: planSingleCache)
+			fftwf_destroy_plan(entry.second);
+		#endif
 		//Destroy GPU plans, if any:
 		#ifdef GPU_ENABLED
 		cufftDestroy(planZ2Z);
 		cufftDestroy(planD2Z);
 		cufftDestroy(planZ2D);
+		for(auto entry: planZ2ZmanyCache)
+			cufftDestroy(entry.second);
 		#endif
 	}
 }
@@ -188,6 +198,9 @@ void processSb(vector3<int>& Sb, int j, const matrix3<int>& ratios, vector3<bool
 		}
 }
 
+//Pick the fastest of candidate fft boxes (timed on head, or looked up in cacheFile if non-empty) and log timings:
+vector3<int> tuneFftBox(const std::vector<vector3<int>>& candidates, string cacheFile);
+
 void GridInfo::initialize(bool skipHeader, const std::vector<SpaceGroupOp> sym)
 {
 	this->~GridInfo(); //cleanup previously initialized quantities
@@ -218,6 +231,7 @@ void GridInfo::initialize(bool skipHeader, const std::vector<SpaceGroupOp> sym)
 						ratios(j,k) = gcd(ratios(j,k), abs(op.rot(j,k)));
 		//Construct integer basis of S's that satisfy these constraints:
 		S = vector3<int>(0,0,0);
+		std::vector<vector3<int>> Sbasis; std::vector<std::vector<int>> scaleCandidates; //for fft box tuning
 		vector3<bool> dimsDone(false,false,false); //dimensions yet to be covered by Sbasis
 		for(int j=0; j<3; j++) if(!dimsDone[j])
 		{	vector3<int> Sb; Sb[j] = 1;
@@ -237,9 +251,33 @@ void GridInfo::initialize(bool skipHeader, const std::vector<SpaceGroupOp> sym)
 				if(s > scaleSb) scaleSb = s;
 			}
 			while(!fftSuitable(scaleSb)) scaleSb += 2; //move through even numbers
+			if(fftBoxTuneExcess > 0.)
+			{	//Collect larger FFT-suitable scale factors for this basis entry within the allowed excess:
+				std::vector<int> scales(1, scaleSb);
+				for(int s=scaleSb+2; s<=scaleSb*(1.+fftBoxTuneExcess) && scales.size()<4; s+=2)
+					if(fftSuitable(s)) scales.push_back(s);
+				Sbasis.push_back(Sb);
+				scaleCandidates.push_back(scales);
+			}
 			Sb *= scaleSb;
 			S += Sb;
 		}
+		if(fftBoxTuneExcess > 0.)
+		{	//Enumerate symmetry-compatible candidate boxes (combinations of scale factors) within the allowed excess:
+			std::vector<vector3<int>> candidates;
+			double nrMax = double(S[0])*S[1]*S[2] * (1.+fftBoxTuneExcess);
+			std::vector<size_t> iScale(Sbasis.size(), 0);
+			while(true)
+			{	vector3<int> Scand(0,0,0);
+				for(size_t j=0; j<Sbasis.size(); j++) Scand += Sbasis[j] * scaleCandidates[j][iScale[j]];
+				if(double(Scand[0])*Scand[1]*Scand[2] <= nrMax) candidates.push_back(Scand);
+				//Advance to next combination:
+				size_t j = 0;
+				while(j<Sbasis.size() && (++iScale[j] == scaleCandidates[j].size())) iScale[j++] = 0;
+				if(j == Sbasis.size()) break;
+			}
+			if(candidates.size() > 1) S = tuneFftBox(candidates, fftBoxTuneFile);
+		}
 	}
 	else //Manually-specified sample count, only check validity:
 	{	for(int k=0; k<3; k++)
@@ -272,9 +310,147 @@ void GridInfo::initialize(bool skipHeader, const std::vector<SpaceGroupOp> sym)
 
 std::mutex GridInfo::planLock;
 
-fftw_plan GridInfo::getPlan(GridInfo::PlanType planType, int nThreads) const
-{	//Return cached plan if available:
-	auto key = std::make_pair(planType, nThreads);
+//FFTW planning options selected by environment variables (initialized on first use, from getPlan with planLock held):
+//--- JDFTX_FFTW_PLANNER = estimate | measure (default) | patient | exhaustive
+//--- JDFTX_FFTW_WISDOM = filename to import wisdom from at startup, and export updated wisdom to after each new plan
+struct FftwPlanOptions
+{	unsigned flags; //planner flags
+	string wisdomFile; //wisdom cache filename (empty if none)
+	
+	FftwPlanOptions() : flags(FFTW_MEASURE)
+	{	const char* plannerStr = getenv("JDFTX_FFTW_PLANNER");
+		if(plannerStr)
+		{	string planner(plannerStr);
+			if(planner == "estimate") flags = FFTW_ESTIMATE;
+			else if(planner == "measure") flags = FFTW_MEASURE;
+			else if(planner == "patient") flags = FFTW_PATIENT;
+			else if(planner == "exhaustive") flags = FFTW_EXHAUSTIVE;
+			else logPrintf("WARNING: ignoring unrecognized JDFTX_FFTW_PLANNER=\"%s\".\n", plannerStr);
+		}
+		const char* wisdomStr = getenv("JDFTX_FFTW_WISDOM");
+		if(wisdomStr) wisdomFile = wisdomStr;
+		fftw_import_system_wisdom();
+		#ifndef MKL_PROVIDES_FFT //wisdom is not supported by the MKL FFTW wrappers
+		if(wisdomFile.length())
+		{	if(fftw_import_wisdom_from_filename(wisdomFile.c_str()))
+				logPrintf("Imported FFTW wisdom from '%s'.\n", wisdomFile.c_str());
+			else
+				logPrintf("Could not import FFTW wisdom from '%s'; it will be created when plans are first made.\n", wisdomFile.c_str());
+		}
+		#endif
+	}
+	
+	//Save wisdom including any newly created plans (atomically, so that concurrent jobs may share the file):
+	void exportWisdom() const
+	{
+		#ifndef MKL_PROVIDES_FFT
+		if(!wisdomFile.length()) return;
+		if(mpiWorld && !mpiWorld->isHead()) return; //wisdom accumulated on head alone suffices for repeated runs
+		ostringstream ossTmp; ossTmp << wisdomFile << ".tmp" << getpid();
+		string wisdomFileTmp = ossTmp.str();
+		if(fftw_export_wisdom_to_filename(wisdomFileTmp.c_str()))
+			rename(wisdomFileTmp.c_str(), wisdomFile.c_str());
+		else
+			logPrintf("WARNING: could not export FFTW wisdom to '%s'.\n", wisdomFile.c_str());
+		#endif
+	}
+};
+
+static FftwPlanOptions& fftwPlanOptions()
+{	static FftwPlanOptions options;
+	return options;
+}
+
+//Minimum time in seconds for a forward in-place complex transform of one box of size S, over a few repetitions:
+double GridInfo::timeFftBox(const vector3<int>& S)
+{	size_t nr = size_t(S[0])*S[1]*S[2];
+	double tMin = DBL_MAX;
+	#ifdef GPU_ENABLED
+	cufftHandle plan;
+	cufftPlan3d(&plan, S[0], S[1], S[2], CUFFT_Z2Z);
+	cufftDoubleComplex* data; cudaMalloc(&data, nr*sizeof(cufftDoubleComplex));
+	cudaMemset(data, 0, nr*sizeof(cufftDoubleComplex));
+	for(int iRep=0; iRep<4; iRep++)
+	{	double t = clock_us();
+		cufftExecZ2Z(plan, data, data, CUFFT_FORWARD);
+		cudaDeviceSynchronize();
+		if(iRep) tMin = std::min(tMin, clock_us()-t); //first call is warm-up
+	}
+	cudaFree(data);
+	cufftDestroy(plan);
+	gpuErrorCheck();
+	#else
+	fftw_complex* data = (fftw_complex*)fftw_malloc(nr*sizeof(fftw_complex));
+	fftw_plan plan;
+	{	std::lock_guard<std::mutex> guard(GridInfo::planLock);
+		fftw_plan_with_nthreads(nProcsAvailable);
+		plan = fftw_plan_dft_3d(S[0], S[1], S[2], data, data, FFTW_FORWARD, fftwPlanOptions().flags);
+		fftwPlanOptions().exportWisdom(); //benchmarked plans for the chosen box are then reused without re-planning
+	}
+	memset(data, 0, nr*sizeof(fftw_complex)); //planning may overwrite data
+	for(int iRep=0; iRep<4; iRep++)
+	{	double t = clock_us();
+		fftw_execute(plan);
+		if(iRep) tMin = std::min(tMin, clock_us()-t); //first call is warm-up
+	}
+	{	std::lock_guard<std::mutex> guard(GridInfo::planLock);
+		fftw_destroy_plan(plan);
+	}
+	fftw_free(data);
+	#endif
+	return tMin * 1e-6;
+}
+
+vector3<int> tuneFftBox(const std::vector<vector3<int>>& candidates, string cacheFile)
+{	logPrintf("Timing %d candidate fftbox sizes:\n", int(candidates.size()));
+	char hostname[256];
+	gethostname(hostname, sizeof(hostname)); hostname[sizeof(hostname)-1] = 0;
+	const char* device = isGpuEnabled() ? "gpu" : "cpu";
+	std::vector<double> times(candidates.size(), 0.);
+	if(mpiWorld->isHead())
+	{	//Look up cached timings:
+		std::map<std::tuple<int,int,int>,double> cached;
+		FILE* fp = cacheFile.length() ? fopen(cacheFile.c_str(), "r") : 0;
+		if(fp)
+		{	char buf[1024];
+			while(fgets(buf, sizeof(buf), fp))
+			{	char hostEntry[256], deviceEntry[16]; int nThreads, S0, S1, S2; double t;
+				if(sscanf(buf, "fftbox %255s %15s %d %d %d %d %lg", hostEntry, deviceEntry, &nThreads, &S0, &S1, &S2, &t) == 7
+					and !strcmp(hostEntry, hostname) and !strcmp(deviceEntry, device) and nThreads==nProcsAvailable)
+					cached[std::make_tuple(S0,S1,S2)] = t;
+			}
+			fclose(fp);
+		}
+		//Time candidates not in cache:
+		FILE* fpOut = 0;
+		for(size_t i=0; i<candidates.size(); i++)
+		{	const vector3<int>& Sc = candidates[i];
+			auto iter = cached.find(std::make_tuple(Sc[0], Sc[1], Sc[2]));
+			if(iter != cached.end()) times[i] = iter->second;
+			else
+			{	times[i] = GridInfo::timeFftBox(Sc);
+				if(!fpOut && cacheFile.length()) fpOut = fopen(cacheFile.c_str(), "a");
+				if(fpOut) fprintf(fpOut, "fftbox %s %s %d %d %d %d %.6le\n", hostname, device, nProcsAvailable, Sc[0], Sc[1], Sc[2], times[i]);
+			}
+		}
+		if(fpOut) fclose(fpOut);
+	}
+	mpiWorld->bcastData(times); //choose consistently on all processes based on head's timings
+	//Report and select:
+	size_t iBest = std::min_element(times.begin(), times.end()) - times.begin();
+	for(size_t i=0; i<candidates.size(); i++)
+	{	const vector3<int>& Sc = candidates[i];
+		logPrintf("\tS = [ %4d %4d %4d ]  nr = %10d  t[ms] = %9.3lf%s\n", Sc[0], Sc[1], Sc[2],
+			Sc[0]*Sc[1]*Sc[2], times[i]*1e3, (i==iBest ? "  <-- fastest" : ""));
+	}
+	if(cacheFile.length()) logPrintf("(Timings cached in '%s'.)\n", cacheFile.c_str());
+	return candidates[iBest];
+}
+
+fftw_plan GridInfo::getPlan(GridInfo::PlanType planType, int nThreads, int howMany) const
+{	assert(howMany >= 1);
+	//Return cached plan if available:
+	auto key = std::make_tuple(planType, nThreads, howMany);
 	planLock.lock();
 	auto iter = planCache.find(key);
 	if(iter != planCache.end())
@@ -282,8 +458,8 @@ fftw_plan GridInfo::getPlan(GridInfo::PlanType planType, int nThreads) const
 		return iter->second;
 	}
 	//Create plan:
-	//--- import wisdom if available:
-	fftw_import_system_wisdom();
+	//--- import wisdom if available (first time only):
+	FftwPlanOptions& options = fftwPlanOptions();
 	//--- setup threading:
 	#ifdef MKL_PROVIDES_FFT
 	fftw3_mkl.number_of_user_threads = ceildiv(nProcsAvailable, nThreads); //maximum number of user threads from which plan could be called simultaneously
@@ -293,17 +469,31 @@ fftw_plan GridInfo::getPlan(GridInfo::PlanType planType, int nThreads) const
 	//--- temp data for planning:
 	bool inPlace = (planType==PlanForwardInPlace) || (planType==PlanInverseInPlace);
 	ManagedArray<fftw_complex> testMem, testMem2;
-	testMem.init(nr);
+	testMem.init(size_t(nr)*howMany);
 	fftw_complex* testData = testMem.data();
 	fftw_complex* testData2 = 0;
 	if(!inPlace)
-	{	testMem2.init(nr);
+	{	testMem2.init(size_t(nr)*howMany);
 		testData2 = testMem2.data();
 	}
 	//--- plan:
-	#define PLANNER_FLAGS FFTW_MEASURE
+	#define PLANNER_FLAGS options.flags
 	fftw_plan plan = 0;
-	switch(planType)
+	if(howMany > 1)
+	{	if(planType==PlanRtoC)
+			plan = fftw_plan_many_dft_r2c(3, &S[0], howMany,
+				(double*)testData, 0, 1, nr, testData2, 0, 1, nG, PLANNER_FLAGS);
+		else if(planType==PlanCtoR)
+			plan = fftw_plan_many_dft_c2r(3, &S[0], howMany,
+				testData, 0, 1, nG, (double*)testData2, 0, 1, nr, PLANNER_FLAGS);
+		else
+		{	bool forward = (planType==PlanForward) || (planType==PlanForwardInPlace);
+			plan = fftw_plan_many_dft(3, &S[0], howMany,
+				testData, 0, 1, nr, (inPlace ? testData : testData2), 0, 1, nr,
+				(forward ? FFTW_FORWARD : FFTW_BACKWARD), PLANNER_FLAGS);
+		}
+	}
+	else switch(planType)
 	{	case PlanInverse:        plan = fftw_plan_dft_3d(S[0], S[1], S[2], testData, testData2, FFTW_BACKWARD, PLANNER_FLAGS); break;
 		case PlanForward:        plan = fftw_plan_dft_3d(S[0], S[1], S[2], testData, testData2, FFTW_FORWARD, PLANNER_FLAGS); break;
 		case PlanInverseInPlace: plan = fftw_plan_dft_3d(S[0], S[1], S[2], testData, testData, FFTW_BACKWARD, PLANNER_FLAGS); break;
@@ -312,8 +502,69 @@ fftw_plan GridInfo::getPlan(GridInfo::PlanType planType, int nThreads) const
 		case PlanCtoR:           plan = fftw_plan_dft_c2r_3d(S[0], S[1], S[2], testData, (double*)testData2, PLANNER_FLAGS); break;
 	}
 	if(!plan) die("Failed to create FFT plan with %d threads",  nThreads);
+	options.exportWisdom();
 	//--- cache and return plan:
 	((GridInfo*)this)->planCache.insert(std::make_pair(key, plan));
 	planLock.unlock();
 	return plan;
 }
+
+fftw_plan GridInfo::getPlanPruned(int dim, bool forward) const
+{	assert(dim>=0 && dim<3);
+	std::lock_guard<std::mutex> guard(planLock);
+	auto key = std::make_pair(dim, forward);
+	auto iter = planPrunedCache.find(key);
+	if(iter != planPrunedCache.end()) return iter->second;
+	FftwPlanOptions& options = fftwPlanOptions();
+	#ifdef MKL_PROVIDES_FFT
+	fftw3_mkl.number_of_user_threads = nProcsAvailable; //executed from within threads over grids
+	#endif
+	fftw_init_threads();
+	fftw_plan_with_nthreads(1);
+	//Transforms along dim for all indices of the later dimensions at fixed earlier ones
+	//(i.e. a single line along dim 2, a plane for dim 1 and the whole grid for dim 0):
+	int stride = 1;
+	for(int k=dim+1; k<3; k++) stride *= S[k];
+	ManagedArray<fftw_complex> testMem; testMem.init(nr);
+	fftw_complex* testData = testMem.data();
+	fftw_plan plan = fftw_plan_many_dft(1, &S[dim], stride,
+		testData, 0, stride, 1, testData, 0, stride, 1,
+		(forward ? FFTW_FORWARD : FFTW_BACKWARD), options.flags | FFTW_UNALIGNED);
+	if(!plan) die("Failed to create pruned FFT plan along dimension %d", dim);
+	options.exportWisdom();
+	((GridInfo*)this)->planPrunedCache[key] = plan;
+	return plan;
+}
+
+#ifdef FFTW_SINGLE_ENABLED
+fftwf_plan GridInfo::getPlanSingle(bool forward, int nThreads, int howMany) const
+{	assert(howMany >= 1);
+	std::lock_guard<std::mutex> guard(planLock);
+	auto key = std::make_tuple(forward, nThreads, howMany);
+	auto iter = planSingleCache.find(key);
+	if(iter != planSingleCache.end()) return iter->second;
+	fftwf_init_threads();
+	fftwf_plan_with_nthreads(nThreads);
+	fftwf_complex* testData = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*size_t(nr)*howMany);
+	fftwf_plan plan = fftwf_plan_many_dft(3, &S[0], howMany, testData, 0, 1, nr, testData, 0, 1, nr,
+		(forward ? FFTW_FORWARD : FFTW_BACKWARD), fftwPlanOptions().flags); //note: wisdom import/export covers double-precision plans alone
+	fftwf_free(testData);
+	if(!plan) die("Failed to create single-precision FFT plan with %d threads",  nThreads);
+	((GridInfo*)this)->planSingleCache[key] = plan;
+	return plan;
+}
+#endif
+
+#ifdef GPU_ENABLED
+cufftHandle GridInfo::getPlanZ2Zmany(int howMany) const
+{	if(howMany == 1) return planZ2Z;
+	std::lock_guard<std::mutex> guard(planLock);
+	auto iter = planZ2ZmanyCache.find(howMany);
+	if(iter != planZ2ZmanyCache.end()) return iter->second;
+	cufftHandle plan;
+	cufftPlanMany(&plan, 3, (int*)&S[0], 0, 1, nr, 0, 1, nr, CUFFT_Z2Z, howMany);
+	gpuErrorCheck();
+	((GridInfo*)this)->planZ2ZmanyCache[howMany] = plan;
+	return plan;
+}
+#endif
@@ -24,12 +24,14 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 //! @{
 
 #include <core/matrix3.h>
+#include <core/string.h>
 #include <core/GpuUtil.h>
 #include <fftw3.h>
 #include <stdint.h>
 #include <cstdio>
 #include <mutex>
 #include <map>
+#include <tuple>
 
 /** @brief Simulation grid descriptor
 
@@ -81,6 +83,8 @@ public:
 	double Gmax; //!< radius of wavefunction G-sphere, whole density sphere (double the radius) must be inscribable within the FFT box
 	double GmaxRho; //!< if non-zero, override the FFT box inscribable sphere radius
 	vector3<int> S; //!< sample points in each dimension (if 0, will be determined automatically based on Gmax)
+	double fftBoxTuneExcess; //!< if positive (and S is determined automatically), time candidate boxes with up to this fractional excess in nr over the smallest, and pick the fastest
+	string fftBoxTuneFile; //!< file in which fft box timings are cached for reuse by later runs on the same machine (none if empty)
 
 	//! Initialize the dependent quantities below.
 	//! If S is specified and is too small for the given Gmax, the call will abort.
@@ -118,11 +122,19 @@ public:
 		PlanRtoC, //!< Real to complex transform
 		PlanCtoR, //!< Complex to real transform
 	};
-	fftw_plan getPlan(PlanType planType, int nThreads) const; //get an FFTW plan of specified type with specified thread count
+	fftw_plan getPlan(PlanType planType, int nThreads, int howMany=1) const; //get an FFTW plan of specified type with specified thread count (batched over howMany contiguous grids if > 1, with stride nr for real and nG for half-reduced complex data in r2c/c2r)
 	#ifdef GPU_ENABLED
 	cufftHandle planZ2Z; //!< CUFFT plan for all the complex transforms
 	cufftHandle planD2Z; //!< CUFFT plan for R -> G
 	cufftHandle planZ2D; //!< CUFFT plan for G -> R
+	cufftHandle getPlanZ2Zmany(int howMany) const; //!< CUFFT plan for howMany contiguous complex transforms (created on demand and cached)
+	#endif
+	int fftBatchSize; //!< number of columns transformed together in batched ColumnBundle operations such as Idag_DiagV_I and diagouterI (1 => one transform per column)
+	bool fftSinglePrecision; //!< whether batched ColumnBundle transforms (Idag_DiagV_I and diagouterI) currently use single precision
+	bool fftPruning; //!< whether batched ColumnBundle transforms skip lines and planes of the FFT box that contain no basis G-vectors (CPU only)
+	fftw_plan getPlanPruned(int dim, bool forward) const; //!< single-threaded, unaligned in-place 1D complex plan along dimension dim of one grid (for pruned transforms, see fftBatch)
+	#ifdef FFTW_SINGLE_ENABLED
+	fftwf_plan getPlanSingle(bool forward, int nThreads, int howMany=1) const; //!< single-precision in-place complex plan (batched over howMany contiguous grids), for fftwf_malloc'd data
 	#endif
 
 	//Indexing utilities (inlined for efficiency)
@@ -148,9 +160,18 @@ private:
 	bool initialized; //!< keep track of whether initialize() has been called
 	void updateSdependent();
 	
-	//FFTW plans by thread count and type:
-	std::map<std::pair<PlanType,int>,fftw_plan> planCache;
+	//FFTW plans by type, thread count and batch size:
+	std::map<std::tuple<PlanType,int,int>,fftw_plan> planCache;
+	std::map<std::pair<int,bool>,fftw_plan> planPrunedCache; //1D plans for pruned transforms by dimension and direction
+	#ifdef FFTW_SINGLE_ENABLED
+	std::map<std::tuple<bool,int,int>,fftwf_plan> planSingleCache; //single-precision plans by direction, thread count and batch size
+	#endif
+	#ifdef GPU_ENABLED
+	std::map<int,cufftHandle> planZ2ZmanyCache; //batched CUFFT plans by batch size
+	#endif
 	static std::mutex planLock; //Global lock since planner routines are not thread safe
+	static double timeFftBox(const vector3<int>& S); //!< time in seconds for one forward complex transform of box size S (used by fftbox-tune)
+	friend vector3<int> tuneFftBox(const std::vector<vector3<int>>& candidates, string cacheFile);
 };
 
 //! @}
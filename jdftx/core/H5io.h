@@ -38,6 +38,14 @@ template<typename T> void h5writeScalar(hid_t fid, const char* dname, const T& d
 template<typename T> void h5writeVector(hid_t fid, const char* dname, const std::vector<T>& data); //Collectively write contiguous array to a 1D dataset when all the data is available on all the processes
 template<typename T> void h5writeVector(hid_t fid, const char* dname, const T* data, hsize_t nData); //Collectively write contiguous array to a 1D dataset when all the data is available on all the processes
 template<typename T> void h5writeVector(hid_t fid, const char* dname, const T* data, const hsize_t* dims, hsize_t rank); //Collectively write contiguous array to a nD dataset when all the data is available on all the processes
+inline hid_t h5openFile(string fname, bool write, bool collective=true); //Create (write=true) or open for reading an HDF5 file, with MPI access across all processes if collective
+inline bool h5exists(hid_t parent, const char* name); //Check whether a dataset or group exists (without triggering HDF5 error messages)
+inline hid_t h5createDataset(hid_t parent, const char* dname, hid_t dataType, const hsize_t* dims, int rank, const hsize_t* chunkDims=0, int compressLevel=0); //Create an nD dataset, optionally chunked and deflate-compressed (collective)
+inline std::vector<hsize_t> h5getDims(hid_t did); //Get the dimensions of a dataset
+template<typename T> void h5writeSlab(hid_t did, const T* data, hsize_t start, hsize_t stop); //Collectively write rows [start,stop) along the first dimension of a dataset (empty range on some processes is allowed)
+template<typename T> void h5readSlab(hid_t did, T* data, hsize_t start, hsize_t stop); //Collectively read rows [start,stop) along the first dimension of a dataset (empty range on some processes is allowed)
+template<typename T> void h5readScalar(hid_t fid, const char* dname, T& data); //Read rank-0 dataset on all processes
+template<typename T> void h5readVector(hid_t fid, const char* dname, std::vector<T>& data); //Read an entire dataset (flattened) on all processes
 
 //! @}
 
@@ -47,6 +55,7 @@ template<typename T> void h5writeVector(hid_t fid, const char* dname, const T* d
 template<typename T> struct h5type;
 template<> struct h5type<int> { static hid_t get() { return H5T_NATIVE_INT; } };
 template<> struct h5type<double> { static hid_t get() { return H5T_NATIVE_DOUBLE; } };
+template<> struct h5type<unsigned char> { static hid_t get() { return H5T_NATIVE_UCHAR; } };
 
 inline hid_t h5createGroup(hid_t parent, const char* name)
 {	hid_t gid = H5Gcreate(parent, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -90,6 +99,98 @@ template<typename T> void h5writeVector(hid_t fid, const char* dname, const T* d
 	H5Pclose(plid);
 }
 
+inline hid_t h5openFile(string fname, bool write, bool collective)
+{	hid_t plid = H5Pcreate(H5P_FILE_ACCESS);
+	if(collective) H5Pset_fapl_mpio(plid, MPI_COMM_WORLD, MPI_INFO_NULL);
+	hid_t fid = write
+		? H5Fcreate(fname.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, plid)
+		: H5Fopen(fname.c_str(), H5F_ACC_RDONLY, plid);
+	H5Pclose(plid);
+	if(fid<0) die("Could not %s HDF5 file '%s'\n", write ? "create" : "open", fname.c_str());
+	return fid;
+}
+
+inline bool h5exists(hid_t parent, const char* name)
+{	return H5Lexists(parent, name, H5P_DEFAULT) > 0;
+}
+
+inline hid_t h5createDataset(hid_t parent, const char* dname, hid_t dataType, const hsize_t* dims, int rank, const hsize_t* chunkDims, int compressLevel)
+{	hid_t sid = H5Screate_simple(rank, dims, NULL);
+	hid_t plid = H5Pcreate(H5P_DATASET_CREATE);
+	if(chunkDims)
+	{	H5Pset_chunk(plid, rank, chunkDims);
+		if(compressLevel > 0) H5Pset_deflate(plid, compressLevel);
+	}
+	hid_t did = H5Dcreate(parent, dname, dataType, sid, H5P_DEFAULT, plid, H5P_DEFAULT);
+	H5Pclose(plid);
+	H5Sclose(sid);
+	if(did<0) die("Could not create dataset '%s' in HDF5 file.\n", dname);
+	return did;
+}
+
+inline std::vector<hsize_t> h5getDims(hid_t did)
+{	hid_t sid = H5Dget_space(did);
+	std::vector<hsize_t> dims(H5Sget_simple_extent_ndims(sid));
+	H5Sget_simple_extent_dims(sid, dims.data(), NULL);
+	H5Sclose(sid);
+	return dims;
+}
+
+//Select rows [start,stop) along the first dimension in file and memory dataspaces:
+inline void h5selectSlab(hid_t did, hsize_t start, hsize_t stop, hid_t& sid, hid_t& sidMem)
+{	std::vector<hsize_t> dims = h5getDims(did);
+	assert(dims.size() && stop <= dims[0]);
+	std::vector<hsize_t> offset(dims.size(), 0), count(dims);
+	offset[0] = start;
+	count[0] = stop-start;
+	sid = H5Dget_space(did);
+	if(count[0])
+	{	H5Sselect_hyperslab(sid, H5S_SELECT_SET, offset.data(), NULL, count.data(), NULL);
+		sidMem = H5Screate_simple(count.size(), count.data(), NULL);
+	}
+	else
+	{	H5Sselect_none(sid);
+		sidMem = H5Scopy(sid);
+	}
+}
+
+template<typename T> void h5writeSlab(hid_t did, const T* data, hsize_t start, hsize_t stop)
+{	hid_t sid, sidMem; h5selectSlab(did, start, stop, sid, sidMem);
+	hid_t plid = H5Pcreate(H5P_DATASET_XFER);
+	H5Pset_dxpl_mpio(plid, H5FD_MPIO_COLLECTIVE); //collective, as required for writing compressed datasets in parallel
+	H5Dwrite(did, h5type<T>::get(), sidMem, sid, plid, data);
+	H5Pclose(plid);
+	H5Sclose(sidMem);
+	H5Sclose(sid);
+}
+
+template<typename T> void h5readSlab(hid_t did, T* data, hsize_t start, hsize_t stop)
+{	hid_t sid, sidMem; h5selectSlab(did, start, stop, sid, sidMem);
+	hid_t plid = H5Pcreate(H5P_DATASET_XFER);
+	H5Pset_dxpl_mpio(plid, H5FD_MPIO_COLLECTIVE);
+	H5Dread(did, h5type<T>::get(), sidMem, sid, plid, data);
+	H5Pclose(plid);
+	H5Sclose(sidMem);
+	H5Sclose(sid);
+}
+
+template<typename T> void h5readScalar(hid_t fid, const char* dname, T& data)
+{	hid_t did = H5Dopen(fid, dname, H5P_DEFAULT);
+	if(did<0) die("Could not open dataset '%s' in HDF5 file.\n", dname);
+	H5Dread(did, h5type<T>::get(), H5S_ALL, H5S_ALL, H5P_DEFAULT, &data);
+	H5Dclose(did);
+}
+
+template<typename T> void h5readVector(hid_t fid, const char* dname, std::vector<T>& data)
+{	hid_t did = H5Dopen(fid, dname, H5P_DEFAULT);
+	if(did<0) die("Could not open dataset '%s' in HDF5 file.\n", dname);
+	hsize_t nData = 1;
+	for(hsize_t dim: h5getDims(did)) nData *= dim;
+	data.resize(nData);
+	H5Dread(did, h5type<T>::get(), H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
+	H5Dclose(did);
+}
+
 //!@endcond
 #endif //HDF5_ENABLED
 #endif //JDFTX_CORE_H5IO_H
@@ -111,7 +111,8 @@ Supercell::Supercell(const GridInfo& gInfo,
 	logPrintf("\n----- Initializing Supercell corresponding to k-point mesh -----\n");
 
 	//Compute kmesh = closure of kmeshReduced under symmetry group, sym:
-	PeriodicLookup< vector3<> > plook(kmesh, gInfo.GGT, kmeshReduced.size()*sym.size()); //look-up table for O(1) fuzzy searching
+	kmeshLookup = std::make_shared<PeriodicLookup<vector3<>>>(kmesh, gInfo.GGT, kmeshReduced.size()*sym.size()); //look-up table for O(1) fuzzy searching
+	PeriodicLookup< vector3<> >& plook = *kmeshLookup; //retained for findKpoint
 	for(int invert: invertList)
 		for(unsigned iReduced=0; iReduced<kmeshReduced.size(); iReduced++)
 		{	const vector3<>& kOrig = kmeshReduced[iReduced];
@@ -252,6 +253,39 @@ Supercell::Supercell(const GridInfo& gInfo,
 }
 
 
+size_t Supercell::findKpoint(const vector3<>& k, KmeshTransform* kTransform) const
+{	size_t ik = kmeshLookup->find(k);
+	if(kTransform and ik != string::npos)
+	{	double offsetErr;
+		*kTransform = kmeshTransform[ik];
+		kTransform->offset += round(k - kmesh[ik], &offsetErr);
+		assert(offsetErr < symmThreshold);
+	}
+	return ik;
+}
+
+bool Supercell::isOnDownsampledMesh(const vector3<>& dk, const vector3<int>& qDownsample) const
+{	vector3<int> dkSuper = round(dk * super); //integer for any difference of kmesh points
+	for(int j=0; j<3; j++)
+		if(dkSuper[j] % qDownsample[j])
+			return false;
+	return true;
+}
+
+void Supercell::getDownsampledMesh(const vector3<int>& qDownsample, matrix3<int>& superQ, std::vector<vector3<>>& qmesh) const
+{	superQ = super;
+	for(int j=0; j<3; j++)
+		for(int i=0; i<3; i++)
+		{	if(super(i,j) % qDownsample[j])
+				die("Exchange q-mesh downsampling factor %d does not divide supercell lattice vector %d.\n", qDownsample[j], j);
+			superQ(i,j) /= qDownsample[j];
+		}
+	qmesh.clear();
+	for(const vector3<>& k: kmesh)
+		if(isOnDownsampledMesh(k - kmesh.front(), qDownsample))
+			qmesh.push_back(k);
+}
+
 std::map<vector3<int>, matrix> getCellMap(const matrix3<>& R, const matrix3<>& Rsup, const vector3<bool>& isTruncated,
 	const std::vector<vector3<>>& x1, const std::vector<vector3<>>& x2, double rSmooth, string fname)
 {
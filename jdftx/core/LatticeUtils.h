@@ -27,6 +27,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/GridInfo.h>
 #include <core/Util.h>
+#include <memory>
 
 //! Relative threshold for symmetry detection
 extern double symmThreshold, symmThresholdSq;
@@ -47,6 +48,8 @@ std::vector<matrix3<int>> getSymmetries(const matrix3<>& R,
 	vector3<bool> isTruncated=vector3<bool>(false,false,false),
 	matrix3<>* Rreduced=0, matrix3<int>* transmission=0, matrix3<int>* invTransmission=0);
 
+template<typename T> class PeriodicLookup;
+
 //! Supercell corresponding to a given k-point mesh
 struct Supercell
 {
@@ -70,6 +73,21 @@ struct Supercell
 	Supercell(const GridInfo& gInfo,
 		const std::vector<vector3<>>& kmeshReduced,
 		const std::vector<SpaceGroupOp>& sym, const std::vector<int>& invertList);
+	
+	//! Find k (modulo reciprocal lattice vectors) in kmesh in O(1), returning its index (string::npos if absent),
+	//! and optionally the transformation from the reduced mesh to k itself (including the integer offset)
+	size_t findKpoint(const vector3<>& k, KmeshTransform* kTransform=0) const;
+	
+	//! Whether k-point difference dk lies on the q-mesh obtained by downsampling kmesh by
+	//! integer factors qDownsample along each supercell lattice vector
+	bool isOnDownsampledMesh(const vector3<>& dk, const vector3<int>& qDownsample) const;
+	
+	//! Get the supercell (superQ, in the convention of super) and the subset of kmesh (qmesh, including kmesh[0])
+	//! for the q-mesh downsampled by qDownsample; each factor must divide the corresponding column of super
+	void getDownsampledMesh(const vector3<int>& qDownsample, matrix3<int>& superQ, std::vector<vector3<>>& qmesh) const;
+
+private:
+	std::shared_ptr<PeriodicLookup<vector3<>>> kmeshLookup; //!< hash-grid lookup into kmesh
 };
 
 //! Get a list of unit cells in a supercell, with padding at the boundaries to maintain a Wigner-Seitz
@@ -56,6 +56,9 @@ MPIUtil::MPIUtil(int argc, char** argv, ProcDivision procDivision)
 
 	MPI_Comm_size(comm, &nProcs);
 	MPI_Comm_rank(comm, &iProc);
+	#ifdef NCCL_ENABLED
+	ncclComm = 0;
+	#endif
 
 	#else
 	//No MPI:
@@ -82,6 +85,9 @@ MPIUtil::MPIUtil(const MPIUtil* mpiUtil, std::vector<int> ranks)
 	//Get rank and count within it:
 	MPI_Comm_size(comm, &nProcs);
 	MPI_Comm_rank(comm, &iProc);
+	#ifdef NCCL_ENABLED
+	ncclComm = 0;
+	#endif
 	#else
 	//No MPI:
 	assert(ranks.size()==1 && ranks[0]==0);
@@ -90,6 +96,26 @@ MPIUtil::MPIUtil(const MPIUtil* mpiUtil, std::vector<int> ranks)
 	#endif
 }
 
+MPIUtil::MPIUtil(const MPIUtil* mpiUtil, SplitType splitType)
+{	assert(splitType == SplitNode);
+	#ifdef MPI_ENABLED
+	#if MPI_VERSION >= 3
+	MPI_Comm_split_type(mpiUtil->comm, MPI_COMM_TYPE_SHARED, mpiUtil->iProcess(), MPI_INFO_NULL, &comm);
+	#else
+	MPI_Comm_split(mpiUtil->comm, mpiUtil->iProcess(), 0, &comm); //no shared memory support: each process on its own
+	#endif
+	MPI_Comm_size(comm, &nProcs);
+	MPI_Comm_rank(comm, &iProc);
+	#ifdef NCCL_ENABLED
+	ncclComm = 0;
+	#endif
+	#else
+	//No MPI:
+	nProcs = 1;
+	iProc = 0;
+	#endif
+}
+
 MPIUtil::~MPIUtil()
 {
 	#ifdef MPI_ENABLED
@@ -97,6 +123,9 @@ MPIUtil::~MPIUtil()
 	int finalized;
 	MPI_Finalized(&finalized);
 	if(finalized) return; //to prevent double-free type errors
+	#ifdef NCCL_ENABLED
+	if(ncclComm) ncclCommDestroy(ncclComm);
+	#endif
 	//Finalize communicators or MPI as appropriate:
 	if(comm == MPI_COMM_WORLD)
 		MPI_Finalize();
@@ -105,6 +134,32 @@ MPIUtil::~MPIUtil()
 	#endif
 }
 
+bool MPIUtil::ncclActive = false;
+
+bool MPIUtil::deviceCollectives()
+{
+	#if defined(GPU_ENABLED) && defined(CUDA_AWARE_MPI)
+	return true;
+	#else
+	return ncclActive;
+	#endif
+}
+
+#ifdef NCCL_ENABLED
+ncclComm_t MPIUtil::getNcclComm() const
+{	if(!ncclComm)
+	{	ncclUniqueId id;
+		if(isHead()) ncclGetUniqueId(&id);
+		MPI_Bcast(&id, sizeof(id), MPI_BYTE, 0, comm);
+		if(ncclCommInitRank(&ncclComm, nProcs, id, iProc) != ncclSuccess)
+		{	fprintf(stderr, "Failed to initialize NCCL communicator.\n");
+			exit(1);
+		}
+	}
+	return ncclComm;
+}
+#endif
+
 void MPIUtil::exit(int errCode) const
 {
 	#ifdef MPI_ENABLED
@@ -155,6 +210,17 @@ void MPIUtil::waitAll(const std::vector<Request>& requests)
 #endif
 }
 
+int MPIUtil::waitAny(std::vector<Request>& requests)
+{
+#ifdef MPI_ENABLED
+	int index = 0;
+	MPI_Waitany(requests.size(), requests.data(), &index, MPI_STATUS_IGNORE);
+	return index;
+#else
+	return 0;
+#endif
+}
+
 
 //----------------------- Point-to-point routines -------------------------------
 
@@ -349,6 +415,75 @@ void MPIUtil::fwrite(const void *ptr, size_t size, size_t nmemb, File fp) const
 	#endif
 }
 
+void MPIUtil::writeOrdered(const char* fname, const string& data) const
+{
+#if MPI_SAFE_WRITE
+	//Safe mode / write from head:
+	if(isHead())
+	{	FILE* fp = ::fopen(fname, "wb");
+		if(!fp) die_alone("Error opening file '%s' for writing.\n", fname);
+		::fwrite(data.data(), 1, data.size(), fp);
+		for(int jProcess=1; jProcess<nProcesses(); jProcess++)
+		{	string dataOther;
+			recv(dataOther, jProcess, 0);
+			::fwrite(dataOther.data(), 1, dataOther.size(), fp);
+		}
+		::fclose(fp);
+	}
+	else send(data, 0, 0);
+#else
+	//Compute offset of current process:
+	std::vector<long> nBytes(nProcesses(), 0);
+	nBytes[iProcess()] = data.size();
+	allReduceData(nBytes, ReduceSum);
+	long offset = 0;
+	for(int jProcess=0; jProcess<iProcess(); jProcess++)
+		offset += nBytes[jProcess];
+	//Write to file:
+	File fp; fopenWrite(fp, fname);
+	fseek(fp, offset, SEEK_SET);
+	fwrite(data.data(), 1, data.size(), fp);
+	fclose(fp);
+#endif
+}
+
+//------- class MPISharedWindow ---------
+
+MPISharedWindow::MPISharedWindow(const MPIUtil* mpiNode, size_t nBytes)
+: mpiNode(mpiNode), segments(mpiNode->nProcesses())
+{
+	#if defined(MPI_ENABLED) && MPI_VERSION >= 3
+	char* myData;
+	MPI_Win_allocate_shared(nBytes, 1, MPI_INFO_NULL, mpiNode->communicator(), &myData, &win);
+	for(int iPeer=0; iPeer<mpiNode->nProcesses(); iPeer++)
+	{	MPI_Aint size; int dispUnit;
+		MPI_Win_shared_query(win, iPeer, &size, &dispUnit, &segments[iPeer]);
+	}
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, win); //passive target epoch for direct loads and stores (synchronized by sync())
+	#else
+	assert(mpiNode->nProcesses() == 1);
+	localData.resize(std::max(nBytes, size_t(1)));
+	segments[0] = localData.data();
+	#endif
+}
+
+MPISharedWindow::~MPISharedWindow()
+{
+	#if defined(MPI_ENABLED) && MPI_VERSION >= 3
+	MPI_Win_unlock_all(win);
+	MPI_Win_free(&win);
+	#endif
+}
+
+void MPISharedWindow::sync() const
+{
+	#if defined(MPI_ENABLED) && MPI_VERSION >= 3
+	MPI_Win_sync(win);
+	MPI_Barrier(mpiNode->communicator());
+	MPI_Win_sync(win);
+	#endif
+}
+
 //------- class TaskDivision ---------
 
 TaskDivision::TaskDivision(size_t nTasks, const MPIUtil* mpiUtil)
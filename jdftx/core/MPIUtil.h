@@ -30,6 +30,16 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef MPI_ENABLED
 #include <mpi.h>
 #endif
+#if defined(NCCL_ENABLED) && !defined(GPU_ENABLED)
+#undef NCCL_ENABLED //NCCL collectives are only used in the GPU versions of the library and executables
+#endif
+#ifdef NCCL_ENABLED
+#ifdef HIP_ENABLED
+#include <rccl/rccl.h> //RCCL provides the NCCL interface on AMD GPUs
+#else
+#include <nccl.h>
+#endif
+#endif
 
 //! @addtogroup Utilities
 //! @{
@@ -45,6 +55,14 @@ class MPIUtil
 	#ifdef MPI_ENABLED
 	MPI_Comm comm;
 	#endif
+	#ifdef NCCL_ENABLED
+	mutable ncclComm_t ncclComm; //!< NCCL communicator over the same processes (created by the first device collective)
+	ncclComm_t getNcclComm() const; //!< get NCCL communicator, creating it if needed (collective)
+	//Device-resident collectives on GPU data, ordered on the default stream (used by the ManagedMemory functions when available):
+	template<typename T> void ncclBcast(T* dataGpu, size_t nData, int root) const;
+	template<typename T> void ncclAllReduce(T* dataGpu, size_t nData, ReduceOp op, bool safeMode) const;
+	template<typename T> void ncclReduce(T* dataGpu, size_t nData, ReduceOp op, int root) const;
+	#endif
 public:
 	int iProcess() const { return iProc; } //!< rank of current process
 	int nProcesses() const { return nProcs; }  //!< number of processes
@@ -68,14 +86,20 @@ public:
 
 	MPIUtil(int argc, char** argv, ProcDivision procDivision=ProcDivision());
 	MPIUtil(const MPIUtil* mpiUtil, std::vector<int> ranks); //!< create a sub-communicator from listed ranks in parent communicator
+	enum SplitType { SplitNode }; //!< ways of splitting a communicator by hardware locality
+	MPIUtil(const MPIUtil* mpiUtil, SplitType splitType); //!< create sub-communicators of processes in parent communicator that share memory (SplitNode)
 	~MPIUtil();
 	void exit(int errCode) const; //!< global exit (kill other MPI processes as well)
 
 	void checkErrors(const ostringstream&) const; //!< collect error messages from all processes; if any, display them and quit
 	
+	static bool ncclActive; //!< whether ManagedMemory broadcasts and reductions use NCCL directly on GPU data (set by gpuInit when every process has its own GPU)
+	static bool deviceCollectives(); //!< whether ManagedMemory broadcasts and reductions operate on GPU data without host staging (NCCL or CUDA-aware MPI)
+	
 	//Asynchronous support functions (any function below with Request* is async if this parameter is non-null):
 	static void wait(Request request); //!< wait till request finishes
 	static void waitAll(const std::vector<Request>& requests); //!< wait till all requests finish
+	static int waitAny(std::vector<Request>& requests); //!< wait till any one of the requests finishes and return its index
 	
 	//Point-to-point functions:
 	template<typename T> void sendData(const ManagedMemory<T>& v, int dest, int tag, Request* request=0) const; //!< managed memory send
@@ -133,6 +157,27 @@ public:
 	template<typename T> void freadData(std::vector<T>& v, File fp) const;
 	template<typename T> void fwriteData(const ManagedMemory<T>& v, File fp) const;
 	template<typename T> void fwriteData(const std::vector<T>& v, File fp) const;
+	void writeOrdered(const char* fname, const string& data) const; //!< collectively write data from each process to a new file, concatenated in process order
+};
+
+
+//! Memory that the processes of a node-local communicator (see MPIUtil::SplitNode) can all access directly (MPI-3 shared window).
+//! Each process contributes a segment of nBytes (possibly zero) and can read and write the segments of all its node peers.
+//! Construction and destruction are collective over the node communicator; call sync() between writes and reads by different processes.
+//! (Without MPI-3 shared memory support, each process only accesses its own segment, as if it were alone on its node.)
+class MPISharedWindow
+{	const MPIUtil* mpiNode;
+	std::vector<char*> segments; //!< start of each peer's segment
+	#if defined(MPI_ENABLED) && MPI_VERSION >= 3
+	MPI_Win win;
+	#else
+	std::vector<char> localData; //!< storage of this process's segment without shared memory
+	#endif
+public:
+	MPISharedWindow(const MPIUtil* mpiNode, size_t nBytes);
+	~MPISharedWindow();
+	char* segment(int iPeer) const { return segments[iPeer]; } //!< segment contributed by process iPeer of mpiNode
+	void sync() const; //!< make writes by all processes in the node visible to all (collective)
 };
 
 
@@ -234,6 +279,46 @@ namespace MPIUtilPrivate
 			default: return 0;
 		}
 	}
+	
+	#ifdef NCCL_ENABLED
+	//Data types supported by NCCL (nElem = 0 for unsupported types):
+	template<typename T> struct NcclDataType
+	{	static const int nElem = 0;
+		static ncclDataType_t get() { return ncclChar; }
+	};
+	#define DECLARE_NcclDataType(cName, ncclName, n) \
+		template<> struct NcclDataType<cName> \
+		{	static const int nElem = n; \
+			static ncclDataType_t get() { return ncclName; } \
+		};
+	DECLARE_NcclDataType(int, ncclInt32, 1)
+	DECLARE_NcclDataType(unsigned int, ncclUint32, 1)
+	DECLARE_NcclDataType(long, ncclInt64, 1)
+	DECLARE_NcclDataType(unsigned long, ncclUint64, 1)
+	DECLARE_NcclDataType(float, ncclFloat32, 1)
+	DECLARE_NcclDataType(double, ncclFloat64, 1)
+	DECLARE_NcclDataType(complex, ncclFloat64, 2) //sum-reductions and broadcasts alone
+	#undef DECLARE_NcclDataType
+	
+	//Map reduction operation to NCCL, returning false if not supported:
+	static inline bool ncclOp(MPIUtil::ReduceOp op, ncclRedOp_t& result)
+	{	switch(op)
+		{	case MPIUtil::ReduceMax: result = ncclMax; return true;
+			case MPIUtil::ReduceMin: result = ncclMin; return true;
+			case MPIUtil::ReduceSum: result = ncclSum; return true;
+			case MPIUtil::ReduceProd: result = ncclProd; return true;
+			default: return false;
+		}
+	}
+	
+	//Whether a reduction (or broadcast if op is null) of type T can be performed with NCCL:
+	template<typename T> bool ncclSupported(const MPIUtil::ReduceOp* op=0)
+	{	if(!(MPIUtil::ncclActive and NcclDataType<T>::nElem)) return false;
+		if(!op) return true;
+		ncclRedOp_t ncclRedOp;
+		return ncclOp(*op, ncclRedOp) and (NcclDataType<T>::nElem==1 or *op==MPIUtil::ReduceSum);
+	}
+	#endif
 #endif
 }
 
@@ -379,5 +464,32 @@ template<typename T> void MPIUtil::fwriteData(const std::vector<T>& v, File fp)
 {	fwrite(v.data(), sizeof(T), v.size(), fp);
 }
 
+#ifdef NCCL_ENABLED
+template<typename T> void MPIUtil::ncclBcast(T* dataGpu, size_t nData, int root) const
+{	using namespace MPIUtilPrivate;
+	if(nProcs>1)
+		::ncclBroadcast(dataGpu, dataGpu, NcclDataType<T>::nElem*nData, NcclDataType<T>::get(), root, getNcclComm(), 0);
+}
+template<typename T> void MPIUtil::ncclAllReduce(T* dataGpu, size_t nData, MPIUtil::ReduceOp op, bool safeMode) const
+{	using namespace MPIUtilPrivate;
+	if(nProcs>1)
+	{	ncclRedOp_t ncclRedOp; ncclOp(op, ncclRedOp);
+		if(safeMode) //Reduce to root and then broadcast result (to ensure identical values)
+		{	::ncclReduce(dataGpu, dataGpu, NcclDataType<T>::nElem*nData, NcclDataType<T>::get(), ncclRedOp, 0, getNcclComm(), 0);
+			ncclBcast(dataGpu, nData, 0);
+		}
+		else
+			::ncclAllReduce(dataGpu, dataGpu, NcclDataType<T>::nElem*nData, NcclDataType<T>::get(), ncclRedOp, getNcclComm(), 0);
+	}
+}
+template<typename T> void MPIUtil::ncclReduce(T* dataGpu, size_t nData, MPIUtil::ReduceOp op, int root) const
+{	using namespace MPIUtilPrivate;
+	if(nProcs>1)
+	{	ncclRedOp_t ncclRedOp; ncclOp(op, ncclRedOp);
+		::ncclReduce(dataGpu, dataGpu, NcclDataType<T>::nElem*nData, NcclDataType<T>::get(), ncclRedOp, root, getNcclComm(), 0);
+	}
+}
+#endif
+
 //!@endcond
 #endif // JDFTX_CORE_MPIUTIL_H
@@ -19,78 +19,271 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/ManagedMemory.h>
 #include <core/GpuUtil.h>
+#include <core/Thread.h>
 #include <fftw3.h>
 #include <mutex>
 #include <map>
 #include <set>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <execinfo.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-//-------- Memory usage profiler ---------
+//-------- Memory usage profiler and monitor ---------
+
+namespace MemoryMonitor
+{	bool active = false;
+}
 
 namespace MemUsageReport
 {
-	enum Mode { Add, Remove, Print };
+	struct Usage
+	{	size_t current, peak; //!< current and peak memory usage (in bytes)
+		size_t peakRecent; //!< peak since the previous timeline snapshot
+		Usage() : current(0), peak(0), peakRecent(0) {}
+		
+		Usage& operator+=(size_t n)
+		{	current += n;
+			if(current > peak) peak = current;
+			if(current > peakRecent) peakRecent = current;
+			return *this;
+		}
+		
+		Usage& operator-=(size_t n)
+		{	current -= std::min(n, current); //allocations made before monitoring started are not counted
+			return *this;
+		}
+	};
 	
-	//Add, remove or retrieve memory report based on mode
-	void manager(Mode mode, string category=string(), size_t nBytes=0)
-	{	
+	//! Allocation site identified by its call stack (used only when tracing)
+	struct Site
+	{	Usage usage;
+		size_t nAllocs;
+		Site() : nAllocs(0) {}
+	};
+	typedef std::vector<void*> CallStack;
+	static const int siteSkip = 2; //frames within memory management to exclude from call stacks
+	static const int siteDepth = 8; //frames retained per call stack
+	
+	struct State
+	{	std::map<string, Usage> usageMap;
+		Usage usageTotal;
+		std::mutex lock;
+		//Monitor settings:
+		FILE* fp;
+		size_t budget; //per-process budget in bytes (0 => none)
+		bool abortOnBudget;
+		bool overBudget; //whether currently over budget (so as to warn once per excursion)
+		int nSites; //number of top allocation sites to report (0 => no tracing)
+		std::map<CallStack, Site> sites;
+		std::unordered_map<const void*, Site*> siteOf; //site of each traced allocation
+		State() : fp(0), budget(0), abortOnBudget(false), overBudget(false), nSites(0) {}
+	};
+	static State& state() { static State s; return s; }
+	static const double bytesToGB = 1./pow(1024.,3);
+	static const double bytesToMB = 1./pow(1024.,2);
+	
+	inline bool enabled()
+	{
 		#ifdef ENABLE_PROFILING
-		struct Usage
-		{	size_t current, peak; //!< current and peak memory usage (in unit of complex numbers i.e. 16 bytes)
-			Usage() : current(0), peak(0) {}
-			
-			Usage& operator+=(size_t n)
-			{	current += n;
-				if(current > peak)
-					peak = current;
-				return *this;
+		return true;
+		#else
+		return MemoryMonitor::active;
+		#endif
+	}
+	
+	//Largest allocation sites by peak usage (call with lock held)
+	std::vector<const std::pair<const CallStack,Site>*> topSites(const State& s)
+	{	std::vector<std::pair<size_t,const std::pair<const CallStack,Site>*>> peaks;
+		for(const auto& entry: s.sites)
+			peaks.push_back(std::make_pair(entry.second.usage.peak, &entry));
+		std::sort(peaks.begin(), peaks.end(), [](const std::pair<size_t,const std::pair<const CallStack,Site>*>& a,
+			const std::pair<size_t,const std::pair<const CallStack,Site>*>& b) { return a.first > b.first; });
+		if(int(peaks.size()) > s.nSites) peaks.resize(s.nSites);
+		std::vector<const std::pair<const CallStack,Site>*> result;
+		for(const auto& peak: peaks) result.push_back(peak.second);
+		return result;
+	}
+	
+	//Log the largest allocation sites by peak usage (call with lock held)
+	void printSites(FILE* fpOut, const State& s)
+	{	std::vector<const std::pair<const CallStack,Site>*> sitesTop = topSites(s);
+		for(size_t iSite=0; iSite<sitesTop.size(); iSite++)
+		{	const CallStack& stack = sitesTop[iSite]->first;
+			const Site& site = sitesTop[iSite]->second;
+			fprintf(fpOut, "MEMSITE: %2lu: peak %12.3lf MB, current %12.3lf MB, %8lu allocations from:\n",
+				iSite+1, site.usage.peak*bytesToMB, site.usage.current*bytesToMB, site.nAllocs);
+			char** funcNames = backtrace_symbols(stack.data(), stack.size());
+			for(size_t j=0; j<stack.size(); j++)
+				fprintf(fpOut, "MEMSITE:        %s\n", funcNames[j]);
+			free(funcNames);
+		}
+	}
+	
+	//Report exceeded budget, aborting if required (call with lock released)
+	void reportBudget(const string& category, size_t nBytes, size_t total)
+	{	State& s = state();
+		const char* action = s.abortOnBudget ? "Aborting" : "Warning";
+		fprintf(stderr, "MEMMONITOR: %s: process %d exceeded memory budget %.1lf MB with %.1lf MB (allocating %.3lf MB of %s)\n",
+			action, mpiWorld->iProcess(), s.budget*bytesToMB, total*bytesToMB, nBytes*bytesToMB, category.c_str());
+		logPrintf("\nMEMMONITOR: %s: exceeded memory budget %.1lf MB with %.1lf MB (allocating %.3lf MB of %s)\n",
+			action, s.budget*bytesToMB, total*bytesToMB, nBytes*bytesToMB, category.c_str());
+		{	std::lock_guard<std::mutex> guard(s.lock);
+			for(auto entry: s.usageMap)
+				logPrintf("MEMMONITOR: %30s %12.3lf MB current %12.3lf MB peak\n", entry.first.c_str(),
+					entry.second.current*bytesToMB, entry.second.peak*bytesToMB);
+			if(s.nSites) printSites(globalLog, s);
+			logFlush();
+			if(s.fp)
+			{	fprintf(s.fp, "{\"type\":\"budget\",\"t\":%.3lf,\"currentMB\":%.3lf,\"budgetMB\":%.3lf,\"category\":\"%s\"}\n",
+					clock_sec(), total*bytesToMB, s.budget*bytesToMB, category.c_str());
+				fflush(s.fp);
+				if(s.abortOnBudget) { fclose(s.fp); s.fp = 0; }
 			}
-			
-			Usage& operator-=(size_t n)
-			{	current -= n;
-				return *this;
+		}
+		if(s.abortOnBudget) mpiWorld->exit(1); //with lock released, since exit handlers may free memory
+	}
+	
+	void add(const string& category, size_t nBytes, const void* ptr)
+	{	if(!enabled()) return;
+		assert(category.length());
+		State& s = state();
+		s.lock.lock();
+		/*
+		//DEBUG: Uncomment and tweak this block to trace execution point of highest memory of a given category
+		//NOTE: Avoid commiting changes to this block during memory optimization;
+		//restore it to this state and remember to comment it out before commiting!
+		if(category=="ColumnBundle"
+			&& (s.usageMap[category].current+nBytes > s.usageMap[category].peak) )
+		{	printStack(true);
+			logPrintf("MEMUSAGE: %30s %12.6lf GB\n", category.c_str(), (s.usageMap[category].current+nBytes)*bytesToGB);
+			logFlush();
+		}
+		*/
+		s.usageMap[category] += nBytes;
+		s.usageTotal += nBytes;
+		if(s.nSites && ptr)
+		{	void* frames[siteSkip+siteDepth];
+			int nFrames = backtrace(frames, siteSkip+siteDepth);
+			CallStack stack(frames+std::min(siteSkip,nFrames), frames+nFrames);
+			Site& site = s.sites[stack];
+			site.usage += nBytes;
+			site.nAllocs++;
+			s.siteOf[ptr] = &site;
+		}
+		bool exceeded = s.budget && (s.usageTotal.current > s.budget) && (!s.overBudget);
+		if(exceeded) s.overBudget = true;
+		size_t total = s.usageTotal.current;
+		s.lock.unlock();
+		if(exceeded) reportBudget(category, nBytes, total);
+	}
+	
+	void remove(const string& category, size_t nBytes, const void* ptr)
+	{	if(!enabled()) return;
+		assert(category.length());
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		s.usageMap[category] -= nBytes;
+		s.usageTotal -= nBytes;
+		if(s.nSites && ptr)
+		{	auto iter = s.siteOf.find(ptr);
+			if(iter != s.siteOf.end())
+			{	iter->second->usage -= nBytes;
+				s.siteOf.erase(iter);
 			}
-		};
-		static std::map<string, Usage> usageMap;
-		static Usage usageTotal;
-		static std::mutex usageLock;
-		static const double bytesToGB = 1./pow(1024.,3);
-		
-		switch(mode)
-		{	case Add:
-			{	usageLock.lock();
-				/*
-				//DEBUG: Uncomment and tweak this block to trace execution point of highest memory of a given category
-				//NOTE: Avoid commiting changes to this block during memory optimization;
-				//restore it to this state and remember to comment it out before commiting!
-				if(category=="ColumnBundle"
-					&& (usageMap[category].current+nBytes > usageMap[category].peak) )
-				{	printStack(true);
-					logPrintf("MEMUSAGE: %30s %12.6lf GB\n", category.c_str(), (usageMap[category].current+nBytes)*bytesToGB);
-					logFlush();
+		}
+		if(s.overBudget && (s.usageTotal.current <= s.budget)) s.overBudget = false; //re-arm warning
+	}
+	
+	void print()
+	{	if(!enabled()) return;
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		for(auto entry: s.usageMap)
+			logPrintf("MEMUSAGE: %30s %12.6lf GB\n", entry.first.c_str(), entry.second.peak * bytesToGB);
+		logPrintf("MEMUSAGE: %30s %12.6lf GB\n", "Total", s.usageTotal.peak * bytesToGB);
+	}
+}
+
+namespace MemoryMonitor
+{	using namespace MemUsageReport;
+	
+	void start(string filename, double budgetMB, bool abortOnBudget, int nSites)
+	{	if(mpiWorld->nProcesses() > 1)
+		{	ostringstream oss; oss << '.' << mpiWorld->iProcess();
+			filename += oss.str();
+		}
+		FILE* fp = fopen(filename.c_str(), "w");
+		if(!fp) die_alone("Could not open memory monitor output '%s' for writing.\n", filename.c_str());
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		s.fp = fp;
+		s.budget = size_t(budgetMB / bytesToMB);
+		s.abortOnBudget = abortOnBudget;
+		s.nSites = nSites;
+		active = true;
+	}
+	
+	//Write one timeline entry (call with lock held)
+	static void writeEntry(State& s, const char* type, const char* point, int iter)
+	{	struct rusage usage; getrusage(RUSAGE_SELF, &usage);
+		fprintf(s.fp, "{\"type\":\"%s\",\"t\":%.3lf", type, clock_sec());
+		if(point) fprintf(s.fp, ",\"point\":\"%s\",\"iter\":%d", point, iter);
+		fprintf(s.fp, ",\"currentMB\":%.3lf,\"peakRecentMB\":%.3lf,\"peakMB\":%.3lf,\"maxRSS_MB\":%.3lf,\"categories\":{",
+			s.usageTotal.current*bytesToMB, s.usageTotal.peakRecent*bytesToMB, s.usageTotal.peak*bytesToMB, usage.ru_maxrss/1024.);
+		const char* sep = "";
+		for(auto& entry: s.usageMap)
+		{	fprintf(s.fp, "%s\"%s\":{\"currentMB\":%.3lf,\"peakRecentMB\":%.3lf}", sep, entry.first.c_str(),
+				entry.second.current*bytesToMB, entry.second.peakRecent*bytesToMB);
+			entry.second.peakRecent = entry.second.current;
+			sep = ",";
+		}
+		fprintf(s.fp, "}}\n");
+		fflush(s.fp); //for real-time monitoring
+		s.usageTotal.peakRecent = s.usageTotal.current;
+	}
+	
+	void snapshot(const char* point, int iter)
+	{	if(!active) return;
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		if(s.fp) writeEntry(s, "snapshot", point, iter);
+	}
+	
+	void finish()
+	{	if(!active) return;
+		State& s = state();
+		std::lock_guard<std::mutex> guard(s.lock);
+		if(s.fp)
+		{	writeEntry(s, "end", 0, 0);
+			for(const auto* entry: topSites(s))
+			{	const CallStack& stack = entry->first;
+				fprintf(s.fp, "{\"type\":\"site\",\"peakMB\":%.3lf,\"nAllocs\":%lu,\"stack\":[",
+					entry->second.usage.peak*bytesToMB, entry->second.nAllocs);
+				char** funcNames = backtrace_symbols(stack.data(), stack.size());
+				for(size_t j=0; j<stack.size(); j++)
+				{	fprintf(s.fp, "%s\"", j ? "," : "");
+					for(const char* c=funcNames[j]; *c; c++)
+					{	if(*c=='"' || *c=='\\') fputc('\\', s.fp);
+						fputc(*c, s.fp);
+					}
+					fputc('"', s.fp);
 				}
-				*/
-				usageMap[category] += nBytes;
-				usageTotal += nBytes;
-				usageLock.unlock();
-				assert(category.length());
-				break;
-			}
-			case Remove:
-			{	usageLock.lock();
-				usageMap[category] -= nBytes;
-				usageTotal -= nBytes;
-				usageLock.unlock();
-				assert(category.length());
-				break;
-			}
-			case Print:
-			{	for(auto entry: usageMap)
-					logPrintf("MEMUSAGE: %30s %12.6lf GB\n", entry.first.c_str(), entry.second.peak * bytesToGB);
-				logPrintf("MEMUSAGE: %30s %12.6lf GB\n", "Total", usageTotal.peak * bytesToGB);
-				break;
+				free(funcNames);
+				fprintf(s.fp, "]}\n");
 			}
+			fclose(s.fp);
+			s.fp = 0;
+		}
+		if(s.nSites)
+		{	logPrintf("\nLargest allocation sites by peak usage:\n");
+			printSites(globalLog, s);
+			logPrintf("\n");
 		}
-		#endif //ENABLE_PROFILING
 	}
 }
 
@@ -170,6 +363,11 @@ namespace MemPool
 		{	if(pool) MemSpace::free(pool);
 		}
 		void* alloc(size_t sizeRequested)
+		{	void* ptr = tryAlloc(sizeRequested);
+			if(!ptr) MemSpace::outOfMemory();
+			return ptr;
+		}
+		void* tryAlloc(size_t sizeRequested) //same as alloc, but returns 0 instead of exiting when out of memory
 		{	if(!mempoolSize) return MemSpace::alloc(sizeRequested); //pool not in use
 			lock.lock();
 			//Find size adjusted to chunk size:
@@ -181,9 +379,7 @@ namespace MemPool
 			if(ubound == holesBySize.end())
 			{	//No hole big enough left, so allocate externally:
 				lock.unlock();
-				void* ptr = MemSpace::alloc(sizeRequested);
-				if(!ptr) MemSpace::outOfMemory();
-				return ptr;
+				return MemSpace::alloc(sizeRequested);
 			}
 			else
 			{	//Hole found, so allocate from it:
@@ -228,8 +424,35 @@ namespace MemPool
 		static void outOfMemory() die_alone("Host memory allocation failed (out of pinned memory)\n");
 	};
 	#else
+	//Place a fresh host block for NUMA locality and TLB efficiency (see memHugePages and memFirstTouch):
+	void prepareHostBlock(void* ptr, size_t size)
+	{	const size_t hugePageSize = size_t(1) << 21;
+		if(size < hugePageSize) return; //small blocks: leave to the system allocator
+		#ifdef MADV_HUGEPAGE
+		if(memHugePages) //advise on the huge-page-aligned interior of the block
+		{	size_t start = (size_t(ptr) + hugePageSize-1) & ~(hugePageSize-1);
+			size_t stop = (size_t(ptr) + size) & ~(hugePageSize-1);
+			if(stop > start) madvise((void*)start, stop-start, MADV_HUGEPAGE);
+		}
+		#endif
+		if(memFirstTouch) //touch pages with the same even partition over threads used by threadLaunch on the data
+		{	const size_t pageSize = 4096;
+			size_t nPages = (size + pageSize-1) / pageSize;
+			auto touch = [&](size_t pageStart, size_t pageStop)
+			{	size_t start = pageStart*pageSize;
+				size_t stop = std::min(pageStop*pageSize, size);
+				memset((uint8_t*)ptr + start, 0, stop-start);
+			};
+			threadLaunch(&touch, nPages);
+		}
+	}
+	
 	struct MemSpaceCPU
-	{	static void* alloc(size_t size) { return fftw_malloc(size); }
+	{	static void* alloc(size_t size)
+		{	void* ptr = fftw_malloc(size);
+			if(ptr && (memFirstTouch || memHugePages)) prepareHostBlock(ptr, size);
+			return ptr;
+		}
 		static void free(void* ptr) { fftw_free(ptr); }
 		static void outOfMemory() die_alone("Memory allocation failed (out of memory)\n");
 	};
@@ -255,28 +478,150 @@ namespace MemPool
 	#ifdef GPU_ENABLED
 	MemPool<MemSpaceGPU>& GPU() { static MemPool<MemSpaceGPU> pool; return pool; }
 	#endif
+	
+	//Cache freed blocks by category and size class for reuse by subsequent allocations,
+	//bypassing the underlying pool / system allocator for repeatedly created temporaries.
+	//The total size of cached blocks is bounded by memcacheSize (cache disabled if zero).
+	template<typename MemSpace> class MemCache
+	{	MemPool<MemSpace>& pool;
+		std::mutex lock; //for thread safety
+		std::map<string, std::map<size_t, std::vector<void*>>> freeLists; //category -> size class -> cached blocks
+		size_t nBytesCached; //total size of blocks in freeLists
+		std::unordered_set<void*> owned; //blocks allocated with size-class padding (only these may be cached)
+		struct Stats
+		{	size_t nHits, nMisses;
+			Stats() : nHits(0), nMisses(0) {}
+		};
+		std::map<string, Stats> stats; //hit and miss counts by category
+		
+		//Round up to size class with at most 12.5% wastage:
+		static size_t sizeClass(size_t nBytes)
+		{	const size_t minSize = 256;
+			if(nBytes <= minSize) return minSize;
+			int shift = 0; while((nBytes >> shift) >= 16) shift++; //granularity = 1/8 to 1/16 of size
+			size_t mask = (size_t(1) << shift) - 1;
+			return (nBytes + mask) & (~mask);
+		}
+		
+		//Return all cached blocks to the pool (must be called with lock held)
+		void flush()
+		{	for(auto& catEntry: freeLists)
+				for(auto& sizeEntry: catEntry.second)
+					for(void* ptr: sizeEntry.second)
+					{	owned.erase(ptr);
+						pool.free(ptr);
+					}
+			freeLists.clear();
+			nBytesCached = 0;
+		}
+		
+	public:
+		MemCache(MemPool<MemSpace>& pool) : pool(pool), nBytesCached(0) {}
+		~MemCache() { flush(); }
+		
+		void* alloc(const string& category, size_t nBytes)
+		{	if(!memcacheSize) return pool.alloc(nBytes); //cache not in use
+			size_t size = sizeClass(nBytes);
+			std::lock_guard<std::mutex> guard(lock);
+			Stats& catStats = stats[category];
+			std::vector<void*>& freeList = freeLists[category][size];
+			if(freeList.size())
+			{	catStats.nHits++;
+				void* ptr = freeList.back();
+				freeList.pop_back();
+				nBytesCached -= size;
+				return ptr;
+			}
+			catStats.nMisses++;
+			void* ptr = pool.tryAlloc(size);
+			if(!ptr && nBytesCached) //release cache and retry before giving up
+			{	flush();
+				ptr = pool.tryAlloc(size);
+			}
+			if(!ptr) MemSpace::outOfMemory();
+			owned.insert(ptr);
+			return ptr;
+		}
+		
+		void free(const string& category, void* ptr, size_t nBytes)
+		{	if(!memcacheSize) return pool.free(ptr); //cache not in use
+			size_t size = sizeClass(nBytes);
+			std::lock_guard<std::mutex> guard(lock);
+			auto ownedIter = owned.find(ptr);
+			if(ownedIter == owned.end()) pool.free(ptr); //allocated before cache was enabled
+			else if(nBytesCached + size > memcacheSize) //cache full
+			{	owned.erase(ownedIter);
+				pool.free(ptr);
+			}
+			else
+			{	freeLists[category][size].push_back(ptr);
+				nBytesCached += size;
+			}
+		}
+		
+		void print(const char* spaceName)
+		{	if(!memcacheSize) return;
+			std::lock_guard<std::mutex> guard(lock);
+			Stats total;
+			for(auto entry: stats)
+			{	logPrintf("MEMCACHE(%s): %30s %12lu hits %12lu misses\n", spaceName, entry.first.c_str(), entry.second.nHits, entry.second.nMisses);
+				total.nHits += entry.second.nHits;
+				total.nMisses += entry.second.nMisses;
+			}
+			logPrintf("MEMCACHE(%s): %30s %12lu hits %12lu misses\n", spaceName, "Total", total.nHits, total.nMisses);
+		}
+	};
+	
+	//Cache accessor functions (constructed after, and hence destroyed before, the corresponding pools):
+	MemCache<MemSpaceCPU>& cacheCPU() { static MemCache<MemSpaceCPU> cache(CPU()); return cache; }
+	#ifdef GPU_ENABLED
+	MemCache<MemSpaceGPU>& cacheGPU() { static MemCache<MemSpaceGPU> cache(GPU()); return cache; }
+	#endif
 }
 
 
 //---------- class ManagedMemoryBase -----------
 
 void ManagedMemoryBase::reportUsage()
-{	MemUsageReport::manager(MemUsageReport::Print);
+{	MemUsageReport::print();
+	MemPool::cacheCPU().print("CPU");
+	#ifdef GPU_ENABLED
+	MemPool::cacheGPU().print("GPU");
+	#endif
 }
 
+ManagedMemoryBase::Tier ManagedMemoryBase::evictionTier = ManagedMemoryBase::TierDevice;
+string ManagedMemoryBase::spillDir = ".";
+ManagedMemoryBase::TransferStats ManagedMemoryBase::transferStats = { 0, 0, 0., 0. };
+
 //Free memory
 void ManagedMemoryBase::memFree()
-{	if(!nBytes) return; //nothing to free
+{	if(borrowed) //externally owned: only forget it
+	{	borrowed = false;
+		c = 0;
+		nBytes = 0;
+		category.clear();
+		return;
+	}
+	if(spillFd >= 0) //evicted to disk: only the scratch file remains
+	{	close(spillFd);
+		spillFd = -1;
+		onGpu = false;
+		nBytes = 0;
+		category.clear();
+		return;
+	}
+	if(!nBytes) return; //nothing to free
 	if(onGpu)
 	{
 		#ifdef GPU_ENABLED
-		MemPool::GPU().free(c);
+		MemPool::cacheGPU().free(category, c, nBytes);
 		#else
 		assert(!"onGpu=true without GPU_ENABLED"); //Should never get here!
 		#endif
 	}
-	else MemPool::CPU().free(c);
-	MemUsageReport::manager(MemUsageReport::Remove, category, nBytes);
+	else MemPool::cacheCPU().free(category, c, nBytes);
+	MemUsageReport::remove(category, nBytes, c);
 	onGpu = false;
 	c = 0;
 	nBytes = 0;
@@ -285,7 +630,7 @@ void ManagedMemoryBase::memFree()
 
 //Allocate memory
 void ManagedMemoryBase::memInit(string category, size_t nBytes, bool onGpu)
-{	if(category==this->category && nBytes==this->nBytes && onGpu==this->onGpu) return; //already in required state
+{	if(category==this->category && nBytes==this->nBytes && onGpu==this->onGpu && !borrowed) return; //already in required state
 	memFree();
 	this->category = category;
 	this->nBytes = nBytes;
@@ -293,13 +638,13 @@ void ManagedMemoryBase::memInit(string category, size_t nBytes, bool onGpu)
 	if(onGpu)
 	{
 		#ifdef GPU_ENABLED
-		c = MemPool::GPU().alloc(nBytes);
+		c = MemPool::cacheGPU().alloc(category, nBytes);
 		#else
 		assert(!"onGpu=true without GPU_ENABLED");
 		#endif
 	}
-	else c = MemPool::CPU().alloc(nBytes);
-	MemUsageReport::manager(MemUsageReport::Add, category, nBytes);
+	else c = MemPool::cacheCPU().alloc(category, nBytes);
+	MemUsageReport::add(category, nBytes, c);
 }
 
 void ManagedMemoryBase::memMove(ManagedMemoryBase&& mOther)
@@ -307,39 +652,100 @@ void ManagedMemoryBase::memMove(ManagedMemoryBase&& mOther)
 	std::swap(nBytes, mOther.nBytes);
 	std::swap(onGpu, mOther.onGpu);
 	std::swap(c, mOther.c);
+	std::swap(spillFd, mOther.spillFd);
+	std::swap(borrowed, mOther.borrowed);
 	//Now mOther will be empty, while *this will have all its contents
 }
 
+void ManagedMemoryBase::memBorrow(string category, void* data, size_t nBytes)
+{	memFree();
+	this->category = category;
+	this->nBytes = nBytes;
+	this->onGpu = false;
+	c = data;
+	borrowed = true;
+}
+
 //Move data to CPU
 void ManagedMemoryBase::toCpu() const
-{	if(!onGpu || !c) return; //already on cpu, or no data
+{	if(spillFd >= 0) { restore(); return; } //evicted to disk (restored to cpu)
+	if(!onGpu || !c) return; //already on cpu, or no data
 #ifdef GPU_ENABLED
 	assert(isGpuMine());
 	ManagedMemoryBase& me = *((ManagedMemoryBase*)this);
-	void* cCpu = MemPool::CPU().alloc(nBytes);
-	cudaMemcpy(cCpu, me.c, nBytes, cudaMemcpyDeviceToHost);
-	MemPool::GPU().free(me.c); //Free GPU mem
+	void* cCpu = MemPool::cacheCPU().alloc(category, nBytes);
+	gpuMemcpyStaged(cCpu, me.c, nBytes, cudaMemcpyDeviceToHost);
+	MemPool::cacheGPU().free(category, me.c, nBytes); //Free GPU mem
 	me.c = cCpu; //Make c a cpu pointer
 	me.onGpu = false;
+	transferStats.nToCpu++;
+	transferStats.bytesToCpu += nBytes;
 #endif
 }
 
 // Move data to GPU
 void ManagedMemoryBase::toGpu() const
-{	if(onGpu || !c) return; //already on gpu, or no data
+{	if(spillFd >= 0) restore(); //evicted to disk (restored to cpu, and moved to gpu below)
+	if(onGpu || !c) return; //already on gpu, or no data
 #ifdef GPU_ENABLED
 	assert(isGpuMine());
+	assert(!borrowed); //externally owned memory stays on the CPU
 	ManagedMemoryBase& me = *((ManagedMemoryBase*)this);
-	void* cGpu = MemPool::GPU().alloc(nBytes);
-	cudaMemcpy(cGpu, me.c, nBytes, cudaMemcpyHostToDevice);
-	MemPool::CPU().free(me.c); //Free CPU mem
+	void* cGpu = MemPool::cacheGPU().alloc(category, nBytes);
+	gpuMemcpyStaged(cGpu, me.c, nBytes, cudaMemcpyHostToDevice);
+	MemPool::cacheCPU().free(category, me.c, nBytes); //Free CPU mem
 	me.c = cGpu; //Make c a gpu pointer
 	me.onGpu = true;
+	transferStats.nToGpu++;
+	transferStats.bytesToGpu += nBytes;
 #else
 	assert(!"toGpu() called without GPU_ENABLED");
 #endif
 }
 
+//Move data to evictionTier
+void ManagedMemoryBase::evict() const
+{	if(evictionTier==TierDevice || !c || borrowed) return; //eviction disabled, no data (including already evicted to disk), or externally owned
+	toCpu(); //TierHost ends here (no-op for cpu data)
+	if(evictionTier==TierHost) return;
+	//Write to an anonymous scratch file (unlinked right away, so that it is removed when closed or at exit):
+	std::vector<char> fname(spillDir.begin(), spillDir.end());
+	const char* suffix = "/jdftx-spill-XXXXXX";
+	fname.insert(fname.end(), suffix, suffix+strlen(suffix)+1);
+	int fd = mkstemp(fname.data());
+	if(fd < 0) die_alone("Could not create scratch file in '%s' to evict %s data to disk.\n", spillDir.c_str(), category.c_str());
+	unlink(fname.data());
+	const char* ptr = (const char*)c;
+	for(size_t nDone=0; nDone<nBytes; )
+	{	ssize_t nWritten = write(fd, ptr+nDone, nBytes-nDone);
+		if(nWritten <= 0) die_alone("Error writing %s data to scratch file in '%s' (disk full?).\n", category.c_str(), spillDir.c_str());
+		nDone += nWritten;
+	}
+	//Release memory, retaining size and category for restore():
+	ManagedMemoryBase& me = *((ManagedMemoryBase*)this);
+	MemPool::cacheCPU().free(category, me.c, nBytes);
+	MemUsageReport::remove(category, nBytes, c);
+	me.c = 0;
+	me.spillFd = fd;
+}
+
+//Read data evicted to disk back into CPU memory
+void ManagedMemoryBase::restore() const
+{	assert(spillFd >= 0);
+	ManagedMemoryBase& me = *((ManagedMemoryBase*)this);
+	me.c = MemPool::cacheCPU().alloc(category, nBytes);
+	MemUsageReport::add(category, nBytes, c);
+	char* ptr = (char*)me.c;
+	for(size_t nDone=0; nDone<nBytes; )
+	{	ssize_t nRead = pread(spillFd, ptr+nDone, nBytes-nDone, nDone);
+		if(nRead <= 0) die_alone("Error reading %s data back from scratch file in '%s'.\n", category.c_str(), spillDir.c_str());
+		nDone += nRead;
+	}
+	close(spillFd);
+	me.spillFd = -1;
+	me.onGpu = false;
+}
+
 //--------- ManagedMemory<complex> and ManagedMemory<double> operators ------
 
 void scale(double alpha, ManagedMemory<double>& y)
@@ -30,19 +30,53 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 //! @file ManagedMemory.h Base class and operators for managed-memory objects
 
+/** @brief Runtime memory monitor (see command memory-monitor).
+When active, managed memory usage is tracked per category in all builds (not only with EnableProfiling).
+Each process writes a timeline of its usage (one JSON object per line) at every dump-frequency point,
+optionally traces the call stacks of the largest allocation sites, and warns or aborts when its
+total managed memory exceeds a per-process budget.
+*/
+namespace MemoryMonitor
+{	extern bool active; //!< whether memory usage is being monitored (use start() to set)
+	//! Start monitoring: write timeline to filename (".<rank>" appended when running on several processes),
+	//! with a per-process budget in MB (0 => none) that aborts the run if abortOnBudget (else warns),
+	//! and with the nSites largest allocation call stacks traced and reported (0 => no tracing)
+	void start(string filename, double budgetMB, bool abortOnBudget, int nSites);
+	void snapshot(const char* point, int iter); //!< record current and recent-peak usage at a named point of the calculation
+	void finish(); //!< write final peaks and allocation sites, and stop (called by finalizeSystem)
+}
+
 //! Base class for managed-memory objects (that could potentially live on GPUs as well) with unspecified data type
 class ManagedMemoryBase
 {
 public:
 	static void reportUsage(); //!< print memory usage report
 
+	//! Memory tier that data is moved to by evict() until its next access (see command wavefunction-residency)
+	enum Tier
+	{	TierDevice, //!< no eviction: data stays where it was last used
+		TierHost, //!< data on the GPU is moved to host memory (pinned, if enabled)
+		TierDisk //!< data is written to a scratch file in spillDir and freed from memory
+	};
+	static Tier evictionTier; //!< tier used by evict() (default: TierDevice)
+	static string spillDir; //!< directory for scratch files of TierDisk (preferably on node-local storage)
+	
+	//! Moves of data between CPU and GPU by toCpu() and toGpu() (always zero without GPU_ENABLED),
+	//! used to check that GPU-resident code paths do not migrate data (see aux/Benchmarks.cpp)
+	struct TransferStats
+	{	size_t nToCpu, nToGpu; //!< number of moves in each direction
+		double bytesToCpu, bytesToGpu; //!< total bytes moved in each direction
+	};
+	static TransferStats transferStats;
+
 protected:
-	ManagedMemoryBase(): nBytes(0),c(0),onGpu(false) {} //!< Initialize a valid state, but don't allocate anything
+	ManagedMemoryBase(): nBytes(0),c(0),onGpu(false),spillFd(-1),borrowed(false) {} //!< Initialize a valid state, but don't allocate anything
 	~ManagedMemoryBase() { memFree(); }
 
 	void memFree(); //!< Free memory
 	void memInit(string category, size_t nBytes, bool onGpu=false); //!< Allocate memory
 	void memMove(ManagedMemoryBase&&); //!< Steal the other object's data (used for move constructors/assignment)
+	void memBorrow(string category, void* data, size_t nBytes); //!< Refer to externally owned CPU memory (eg. node-shared), which is never freed, moved to the GPU or evicted
 
 	string category; //!< category of managed memory objects to report memory usage under
 	size_t nBytes; //!< Size of stored data
@@ -50,6 +84,11 @@ protected:
 	bool onGpu; //!< For reduced \#ifdef's, this flag is retained even in the absence of gpu support
 	void toCpu() const; //!< move data to the CPU (does nothing without GPU_ENABLED); logically const, but data location may change
 	void toGpu() const; //!< move data to the GPU (does nothing without GPU_ENABLED); logically const, but data location may change
+	void evict() const; //!< move data to evictionTier, from where the next access restores it; logically const, but data location may change
+private:
+	int spillFd; //!< scratch file holding the data while evicted to disk (-1 if not evicted to disk)
+	bool borrowed; //!< whether c is externally owned (see memBorrow)
+	void restore() const; //!< read data evicted to disk back into CPU memory
 };
 
 //! Base class for managed memory of a specified data type
@@ -62,6 +101,7 @@ protected:
 	void memFree(); //!< Free memory
 	void memInit(string category, size_t nElem, bool onGpu=false); //!< Allocate memory
 	void memMove(ManagedMemory<T>&&); //!< Steal the other object's data (used for move constructors/assignment)
+	void memBorrow(string category, T* data, size_t nElem); //!< Refer to externally owned CPU memory (see ManagedMemoryBase::memBorrow)
 
 private:
 	size_t nElem;
@@ -89,6 +129,11 @@ public:
 	size_t nData() const { return nElem; } //!< number of data points
 	bool isOnGpu() const { return onGpu; } //!< Check where the data is (for \#ifdef simplicity exposed even when no GPU_ENABLED)
 
+	//! @brief Move data out of device (and optionally host) memory till its next access, as selected by ManagedMemoryBase::evictionTier.
+	//! Use between uses of large per-state data (such as wavefunctions) to bound the memory held on the GPU or host;
+	//! the same GPU ownership considerations as data() apply.
+	void evict() const { ManagedMemoryBase::evict(); }
+
 	//Iterator access on CPU:
 	T* begin() { return data(); } //!< pointer to start of array
 	const T* begin() const { return data(); } //!< const pointer to start of array
@@ -172,6 +217,11 @@ template<typename T> void ManagedMemory<T>::memInit(string category, size_t nEle
 	ManagedMemoryBase::memInit(category, nElem*sizeof(T), onGpu);
 }
 
+template<typename T> void ManagedMemory<T>::memBorrow(string category, T* data, size_t nElem)
+{	this->nElem = nElem;
+	ManagedMemoryBase::memBorrow(category, data, nElem*sizeof(T));
+}
+
 template<typename T> void ManagedMemory<T>::memMove(ManagedMemory<T>&& mOther)
 {	ManagedMemoryBase::memMove((ManagedMemoryBase&&)mOther); //first invoke base class version
 	std::swap(nElem, mOther.nElem);
@@ -273,15 +323,31 @@ template<typename T> void MPIUtil::sendData(const ManagedMemory<T>& v, int dest,
 template<typename T> void MPIUtil::recvData(ManagedMemory<T>& v, int dest, int tag, Request* request) const
 {	recv(v.dataMPI(), v.nData(), dest, tag, request);
 }
+//With NCCL, collectives are enqueued on the default stream instead: they complete before any subsequent
+//access to the data (kernels on that stream or transfers to the host), so requests complete immediately.
+#ifdef NCCL_ENABLED
+#define NCCL_COLLECTIVE(ncclCall, opPtr) \
+	if(MPIUtilPrivate::ncclSupported<T>(opPtr)) \
+	{	ncclCall; \
+		if(request) *request = MPI_REQUEST_NULL; \
+		return; \
+	}
+#else
+#define NCCL_COLLECTIVE(ncclCall, opPtr)
+#endif
 template<typename T> void MPIUtil::bcastData(ManagedMemory<T>& v, int root, Request* request) const
-{	bcast(v.dataMPI(), v.nData(), root, request);
+{	NCCL_COLLECTIVE(ncclBcast(v.dataGpu(), v.nData(), root), 0)
+	bcast(v.dataMPI(), v.nData(), root, request);
 }
 template<typename T> void MPIUtil::allReduceData(ManagedMemory<T>& v, MPIUtil::ReduceOp op, bool safeMode, Request* request) const
-{	allReduce(v.dataMPI(), v.nData(), op, safeMode, request);
+{	NCCL_COLLECTIVE(ncclAllReduce(v.dataGpu(), v.nData(), op, safeMode), &op)
+	allReduce(v.dataMPI(), v.nData(), op, safeMode, request);
 }
 template<typename T> void MPIUtil::reduceData(ManagedMemory<T>& v, MPIUtil::ReduceOp op, int root, Request* request) const
-{	reduce(v.dataMPI(), v.nData(), op, root, request);
+{	NCCL_COLLECTIVE(ncclReduce(v.dataGpu(), v.nData(), op, root), &op)
+	reduce(v.dataMPI(), v.nData(), op, root, request);
 }
+#undef NCCL_COLLECTIVE
 template<typename T> void MPIUtil::freadData(ManagedMemory<T>& v, File fp) const
 {	fread(v.data(), sizeof(T), v.nData(), fp);
 }
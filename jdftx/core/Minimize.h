@@ -23,6 +23,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/MinimizeParams.h>
 #include <core/Util.h>
 #include <deque>
+#include <vector>
 #include <cmath>
 #include <cfloat>
 #include <algorithm>
@@ -35,6 +36,21 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 @brief Nonlinear minimization and linear solve templates
 */
 
+//! Copy X into Y. Vector types whose copy-assignment is deep and reuses existing storage
+//! (eg. ColumnBundle) overload this so that the algorithms below can recycle work vectors.
+template<typename Vector> void cloneInto(const Vector& X, Vector& Y) { Y = clone(X); }
+
+//! Storage of one vector of the L-BFGS history. The default keeps the vector as is;
+//! specialize for vector types that support more compact storage (see MinimizeParams::historyStorage).
+template<typename Vector> struct LBFGSHistoryStore
+{	//! Take over the contents of x (which is left with unspecified, possibly reusable storage)
+	void store(Vector& x, const MinimizeParams& p) { std::swap(x, this->x); }
+	//! Access the stored vector, expanding it into work if necessary
+	const Vector& load(Vector& work) const { return x; }
+private:
+	Vector x;
+};
+
 /** Interface (abstract base class) for the minimization algorithm template
 	@tparam Vector A data type that represents a direction in the tangent space of the parameter manifold,
 	which must have the following functions/operators defined: \n
@@ -42,7 +58,9 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 		- void axpy(double alpha, const Vector& X, Vector& Y); (accumulate operation: Y += alpha*X) \n
 		- double dot(const Vector& X, const Vector& Y); (inner product) \n
 		- Vector clone(const Vector& X); (create a copy) \n
-		- void randomize(Vector&); (initialize with random numbers, used for auto-fdtests)
+		- void randomize(Vector&); (initialize with random numbers, used for auto-fdtests) \n
+	and may optionally overload: \n
+		- void cloneInto(const Vector& X, Vector& Y); (copy X into Y reusing the storage of Y, see below)
 */
 template<typename Vector> struct Minimizable
 {
@@ -65,6 +83,16 @@ template<typename Vector> struct Minimizable
 	//! Override to return maximum safe step size along a given direction. Steps can be arbitrarily large by default.
 	virtual double safeStepSize(const Vector& dir) const { return DBL_MAX; }
 	
+	//! Override to persist the L-BFGS history (changes in variable s and preconditioned residual Ky, rho = 1/dot(s,y)
+	//! for each entry, oldest first, along with the scaling gamma) for restarts; called after each history update if persistLBFGS()
+	virtual void saveLBFGS(const std::vector<Vector>& s, const std::vector<Vector>& Ky, const std::vector<double>& rho, double gamma) const {}
+	
+	//! Override to restore a history saved by saveLBFGS() at the start of L-BFGS, returning whether one was restored
+	virtual bool loadLBFGS(std::vector<Vector>& s, std::vector<Vector>& Ky, std::vector<double>& rho, double& gamma) { return false; }
+	
+	//! Override to return whether saveLBFGS() should be called
+	virtual bool persistLBFGS() const { return false; }
+	
 	//! Minimize this objective function with algorithm controlled by params and return the minimized value
 	double minimize(const MinimizeParams& params);
 	
@@ -90,15 +118,37 @@ template<typename Vector> struct LinearSolvable
 	//! Return vector multiplied by the hessian of the objective function
 	virtual Vector hessian(const Vector&) const=0;
 	
+	//! Return a block of vectors multiplied by the hessian (used by solveBlock).
+	//! Override to share work such as FFTs between the vectors; the default applies hessian() to each in turn.
+	virtual std::vector<Vector> hessianBlock(const std::vector<Vector>& v) const
+	{	std::vector<Vector> result; result.reserve(v.size());
+		for(const Vector& vi: v) result.push_back(hessian(vi));
+		return result;
+	}
+	
 	//! Override to enable preconditioning: return the preconditioned vector, given a vector
 	virtual Vector precondition(const Vector& v) const { return clone(v); }
 	
 	//! Override to synchronize scalars over MPI processes (if the same minimization is happening in sync over many processes)
 	virtual double sync(double x) const { return x; }
 	
-	//! Solve the linear system hessian * state == rhs using conjugate gradients:
+	//! Solve the linear system hessian * state == rhs using conjugate gradients,
+	//! deflated by the subspace recycled from previous solves if params.nRecycle > 0:
 	//! @return the number of iterations taken to achieve target tolerance
 	int solve(const Vector& rhs, const MinimizeParams& params);
+	
+	//! Solve hessian * X[j] == rhs[j] for several right-hand sides together using block conjugate gradients,
+	//! which shares the search space between them and applies the hessian to a block at a time (see hessianBlock).
+	//! X contains the initial guesses on input (start from zero if its size differs from rhs), and the solutions on output;
+	//! state is not used. Convergence requires all right-hand sides to satisfy params.knormThreshold.
+	//! @return the number of iterations taken to achieve target tolerance
+	int solveBlock(const std::vector<Vector>& rhs, std::vector<Vector>& X, const MinimizeParams& params);
+	
+	std::vector<Vector> recycleW; //!< deflation subspace: Ritz vectors for the lowest eigenvalues of the hessian from previous solves
+	
+private:
+	//! Replace recycleW by the nRecycle lowest Ritz vectors of the hessian within span(G), given AG = hessian(G)
+	void updateRecycleSpace(const std::vector<Vector>& G, const std::vector<Vector>& AG, int nRecycle);
 };
 
 
@@ -117,6 +167,7 @@ public:
 
 #include <core/Minimize_linmin.h>
 #include <core/Minimize_lBFGS.h>
+#include <core/matrix.h>
 
 template<typename Vector> double Minimizable<Vector>::minimize(const MinimizeParams& p)
 {	if(p.fdTest) fdTest(p); // finite difference test
@@ -152,6 +203,7 @@ template<typename Vector> double Minimizable<Vector>::minimize(const MinimizePar
 	int iter=0;
 	for(iter=0; !killFlag; iter++)
 	{
+		ProfileRegion iterRegion(p.linePrefix); //one runtime-profiler region per iteration
 		if(report(iter)) //optional reporting/processing
 		{	E = sync(compute(&g, &Kg)); //update energy and gradient if state was modified
 			fprintf(p.fpLog, "%s\tState modified externally: resetting search direction.\n", p.linePrefix);
@@ -166,13 +218,17 @@ template<typename Vector> double Minimizable<Vector>::minimize(const MinimizePar
 
 		//Print prev step stats and set CG direction parameter if necessary
 		beta = 0.0;
+		double linminTest = NAN, cgTest = NAN; //for event log
 		if(!forceGradDirection)
 		{	double dotgd = sync(dot(g,d));
 			double dotgPrevKg = gPrevUsed ? sync(dot(gPrev, Kg)) : 0.;
 
-			fprintf(p.fpLog, "  linmin: %10.3le", dotgd/sqrt(sync(dot(g,g))*sync(dot(d,d))));
+			linminTest = dotgd/sqrt(sync(dot(g,g))*sync(dot(d,d)));
+			fprintf(p.fpLog, "  linmin: %10.3le", linminTest);
 			if(gPrevUsed)
-				fprintf(p.fpLog, "  cgtest: %10.3le", dotgPrevKg/sqrt(gKNorm*gKNormPrev));
+			{	cgTest = dotgPrevKg/sqrt(gKNorm*gKNormPrev);
+				fprintf(p.fpLog, "  cgtest: %10.3le", cgTest);
+			}
 			fprintf(p.fpLog, "  t[s]: %9.2lf", clock_sec());
 
 			//Update beta:
@@ -190,6 +246,9 @@ template<typename Vector> double Minimizable<Vector>::minimize(const MinimizePar
 		}
 		forceGradDirection = false;
 		fprintf(p.fpLog, "\n"); fflush(p.fpLog);
+		if(EventLog::active)
+			EventLog::Event("minimize", p.linePrefix).add("iter", iter).add("energyLabel", p.energyLabel).add("energy", E)
+				.add("gradK", sqrt(gKNorm/p.nDim)).add("alpha", alpha).add("linmin", linminTest).add("cgtest", cgTest);
 		if(sqrt(gKNorm/p.nDim) < p.knormThreshold)
 		{	fprintf(p.fpLog, "%sConverged (|grad|_K<%le).\n", p.linePrefix, p.knormThreshold);
 			fflush(p.fpLog); return E;
@@ -304,27 +363,70 @@ template<typename Vector> typename Minimizable<Vector>::Linmin Minimizable<Vecto
 
 
 template<typename Vector> int LinearSolvable<Vector>::solve(const Vector& rhs, const MinimizeParams& p)
-{	//Initialize:
+{	//Recycled deflation subspace W, with its image under the current hessian (which may have changed since the last solve):
+	if(int(recycleW.size()) > p.nRecycle) recycleW.resize(p.nRecycle);
+	const std::vector<Vector>& W = recycleW;
+	int nW = W.size();
+	std::vector<Vector> AW(nW);
+	matrix Einv; //inverse of W^ A W
+	if(nW)
+	{	matrix E(nW, nW);
+		for(int i=0; i<nW; i++)
+		{	AW[i] = hessian(W[i]);
+			for(int j=0; j<=i; j++)
+			{	double Eij = sync(0.5*(dot(W[i], AW[j]) + dot(W[j], AW[i])));
+				E.set(i,j, Eij); E.set(j,i, Eij);
+			}
+		}
+		Einv = inv(E);
+	}
+	auto deflationCoeffs = [&](const std::vector<Vector>& X, const Vector& v) //Einv * X^v
+	{	matrix Xv(nW, 1);
+		for(int i=0; i<nW; i++) Xv.set(i,0, sync(dot(X[i], v)));
+		return Einv * Xv;
+	};
+	
+	//Initialize:
 	Vector r = clone(rhs); axpy(-1.0, hessian(state), r); //residual r = rhs - A.state;
+	if(nW) //Galerkin correction of initial guess within W, so that W^r = 0 from here on
+	{	matrix mu = deflationCoeffs(W, r);
+		for(int i=0; i<nW; i++)
+		{	axpy(mu(i,0).real(), W[i], state);
+			axpy(-mu(i,0).real(), AW[i], r);
+		}
+	}
 	Vector z = precondition(r), d = r; //the preconditioned residual and search direction
 	double beta=0.0, rdotzPrev=0.0, rdotz = sync(dot(r, z));
+	std::vector<Vector> P, AP; //leading search directions and their hessian images, for updating the recycled subspace
+	int nHarvest = 2*p.nRecycle;
 
 	//Check initial residual
 	double rzNorm = sqrt(fabs(rdotz)/p.nDim);
+	if(nW) fprintf(p.fpLog, "%sDeflating with %d recycled vectors.\n", p.linePrefix, nW);
 	fprintf(p.fpLog, "%sInitial:  sqrt(|r.z|): %12.6le\n", p.linePrefix, rzNorm); fflush(p.fpLog);
 	if(rzNorm<p.knormThreshold) { fprintf(p.fpLog, "%sConverged sqrt(r.z)<%le\n", p.linePrefix, p.knormThreshold); fflush(p.fpLog); return 0; }
 
 	//Main loop:
 	int iter;
+	bool converged = false;
 	for(iter=0; iter<p.nIterations && !killFlag; iter++)
-	{	//Update search direction:
+	{	ProfileRegion iterRegion(p.linePrefix); //one runtime-profiler region per iteration
+		//Update search direction:
 		if(rdotzPrev)
 		{	beta = rdotz/rdotzPrev;
 			d *= beta; axpy(1.0, z, d); // d = z + beta*d
 		}
 		else d = clone(z); //fresh search direction (along gradient)
+		if(nW) //keep search direction A-orthogonal to W:
+		{	matrix mu = deflationCoeffs(AW, z);
+			for(int i=0; i<nW; i++) axpy(-mu(i,0).real(), W[i], d);
+		}
 		//Step:
 		Vector w = hessian(d);
+		if(int(P.size()) < nHarvest)
+		{	P.push_back(clone(d));
+			AP.push_back(clone(w));
+		}
 		double alpha = rdotz/sync(dot(w,d));
 		axpy(alpha, d, state);
 		axpy(-alpha, w, r);
@@ -336,12 +438,138 @@ template<typename Vector> int LinearSolvable<Vector>::solve(const Vector& rhs, c
 		fprintf(p.fpLog, "%sIter: %3d  sqrt(|r.z|): %12.6le  alpha: %12.6le  beta: %13.6le  t[s]: %9.2lf\n",
 			p.linePrefix, iter, rzNorm, alpha, beta, clock_sec()); fflush(p.fpLog);
 		//Check convergence:
-		if(rzNorm<p.knormThreshold) { fprintf(p.fpLog, "%sConverged sqrt(r.z)<%le\n", p.linePrefix, p.knormThreshold); fflush(p.fpLog); return iter; }
+		if(rzNorm<p.knormThreshold) { fprintf(p.fpLog, "%sConverged sqrt(r.z)<%le\n", p.linePrefix, p.knormThreshold); fflush(p.fpLog); converged = true; break; }
+	}
+	if(!converged) { fprintf(p.fpLog, "%sGradient did not converge within threshold in %d iterations\n", p.linePrefix, iter); fflush(p.fpLog); }
+	//Update recycled subspace for the next solve from span(W, P):
+	if(p.nRecycle && P.size())
+	{	std::vector<Vector> G(W), AG(AW);
+		G.insert(G.end(), P.begin(), P.end());
+		AG.insert(AG.end(), AP.begin(), AP.end());
+		updateRecycleSpace(G, AG, p.nRecycle);
 	}
-	fprintf(p.fpLog, "%sGradient did not converge within threshold in %d iterations\n", p.linePrefix, iter); fflush(p.fpLog);
 	return iter;
 }
 
+template<typename Vector> int LinearSolvable<Vector>::solveBlock(const std::vector<Vector>& rhs, std::vector<Vector>& X, const MinimizeParams& p)
+{	int nRHS = rhs.size();
+	if(!nRHS) return 0;
+	if(int(X.size()) != nRHS) //start from zero
+	{	X.resize(nRHS);
+		for(int j=0; j<nRHS; j++) { X[j] = clone(rhs[j]); X[j] *= 0.; }
+	}
+	//Initialize:
+	std::vector<Vector> R = hessianBlock(X); //residuals R = rhs - A.X
+	for(int j=0; j<nRHS; j++) { R[j] *= -1.; axpy(1.0, rhs[j], R[j]); }
+	std::vector<Vector> Z(nRHS), P, Q; //preconditioned residuals, and A-orthonormal search block with its hessian image
+	auto updateZ = [&]() //update preconditioned residuals and return the largest residual norm
+	{	double rzNormMax = 0.;
+		for(int j=0; j<nRHS; j++)
+		{	Z[j] = precondition(R[j]);
+			rzNormMax = std::max(rzNormMax, sqrt(fabs(sync(dot(R[j], Z[j])))/p.nDim));
+		}
+		return rzNormMax;
+	};
+	const double dependenceThreshold = 1e-10; //relative A-norm below which a new search direction is considered linearly dependent
+
+	//Check initial residual
+	double rzNorm = updateZ();
+	fprintf(p.fpLog, "%sInitial:  max sqrt(|r.z|): %12.6le  nRHS: %d\n", p.linePrefix, rzNorm, nRHS); fflush(p.fpLog);
+	if(rzNorm<p.knormThreshold) { fprintf(p.fpLog, "%sConverged sqrt(r.z)<%le\n", p.linePrefix, p.knormThreshold); fflush(p.fpLog); return 0; }
+
+	//Main loop:
+	int iter;
+	bool converged = false;
+	for(iter=0; iter<p.nIterations && !killFlag; iter++)
+	{	ProfileRegion iterRegion(p.linePrefix); //one runtime-profiler region per iteration
+		//New search block: preconditioned residuals, A-orthogonalized against the previous block:
+		std::vector<Vector> Pnew(nRHS);
+		for(int j=0; j<nRHS; j++)
+		{	Pnew[j] = clone(Z[j]);
+			for(size_t i=0; i<P.size(); i++)
+				axpy(-sync(dot(Q[i], Z[j])), P[i], Pnew[j]);
+		}
+		std::vector<Vector> Qnew = hessianBlock(Pnew);
+		//A-orthonormalize within the block (modified Gram-Schmidt), dropping linearly-dependent directions:
+		P.clear(); Q.clear();
+		for(int j=0; j<nRHS; j++)
+		{	double normSq0 = sync(dot(Pnew[j], Qnew[j]));
+			for(size_t i=0; i<P.size(); i++)
+			{	double c = sync(dot(Q[i], Pnew[j]));
+				axpy(-c, P[i], Pnew[j]);
+				axpy(-c, Q[i], Qnew[j]);
+			}
+			double normSq = sync(dot(Pnew[j], Qnew[j]));
+			if(normSq <= dependenceThreshold * normSq0) continue;
+			Pnew[j] *= 1./sqrt(normSq);
+			Qnew[j] *= 1./sqrt(normSq);
+			P.push_back(Pnew[j]);
+			Q.push_back(Qnew[j]);
+		}
+		if(!P.size()) { fprintf(p.fpLog, "%sSearch block became linearly dependent.\n", p.linePrefix); fflush(p.fpLog); break; }
+		//Step along each search direction for all right-hand sides:
+		for(size_t i=0; i<P.size(); i++)
+			for(int j=0; j<nRHS; j++)
+			{	double alpha = sync(dot(P[i], R[j]));
+				axpy(alpha, P[i], X[j]);
+				axpy(-alpha, Q[i], R[j]);
+			}
+		rzNorm = updateZ();
+		//Print info:
+		fprintf(p.fpLog, "%sIter: %3d  max sqrt(|r.z|): %12.6le  nDirections: %d  t[s]: %9.2lf\n",
+			p.linePrefix, iter, rzNorm, int(P.size()), clock_sec()); fflush(p.fpLog);
+		//Check convergence:
+		if(rzNorm<p.knormThreshold) { fprintf(p.fpLog, "%sConverged sqrt(r.z)<%le\n", p.linePrefix, p.knormThreshold); fflush(p.fpLog); converged = true; break; }
+	}
+	if(!converged) { fprintf(p.fpLog, "%sGradient did not converge within threshold in %d iterations\n", p.linePrefix, iter); fflush(p.fpLog); }
+	return iter;
+}
+
+template<typename Vector> void LinearSolvable<Vector>::updateRecycleSpace(const std::vector<Vector>& G, const std::vector<Vector>& AG, int nRecycle)
+{	//Overlap and hessian within span(G):
+	int nG = G.size();
+	matrix S(nG, nG), F(nG, nG);
+	for(int i=0; i<nG; i++)
+		for(int j=0; j<=i; j++)
+		{	double Sij = sync(dot(G[i], G[j]));
+			double Fij = sync(0.5*(dot(G[i], AG[j]) + dot(G[j], AG[i])));
+			S.set(i,j, Sij); S.set(j,i, Sij);
+			F.set(i,j, Fij); F.set(j,i, Fij);
+		}
+	//Orthonormalize, dropping (nearly) linearly-dependent directions:
+	matrix Sevecs; diagMatrix Seigs;
+	S.diagonalize(Sevecs, Seigs);
+	double SeigMax = *std::max_element(Seigs.begin(), Seigs.end());
+	std::vector<int> iKeep;
+	for(int i=0; i<nG; i++)
+		if(Seigs[i] > 1e-10*SeigMax)
+			iKeep.push_back(i);
+	int nKeep = iKeep.size();
+	if(!nKeep) return;
+	matrix U(nG, nKeep);
+	for(int k=0; k<nKeep; k++)
+		for(int i=0; i<nG; i++)
+			U.set(i,k, Sevecs(i,iKeep[k]) * (1./sqrt(Seigs[iKeep[k]])));
+	//Rayleigh-Ritz: lowest eigenvectors of the hessian in this basis (eigenvalues in ascending order):
+	matrix Fevecs; diagMatrix Feigs;
+	(dagger(U) * F * U).diagonalize(Fevecs, Feigs);
+	matrix Y = U * Fevecs;
+	int nNew = std::min(nRecycle, nKeep);
+	std::vector<Vector> Wnew(nNew);
+	for(int j=0; j<nNew; j++)
+	{	//Fix the arbitrary phase of the eigenvector, so that the coefficients are real:
+		int iMax = 0;
+		for(int i=1; i<nG; i++)
+			if(Y(i,j).abs() > Y(iMax,j).abs())
+				iMax = i;
+		complex phase = Y(iMax,j).conj() * (1./Y(iMax,j).abs());
+		Wnew[j] = clone(G[0]); Wnew[j] *= (Y(0,j)*phase).real();
+		for(int i=1; i<nG; i++)
+			axpy((Y(i,j)*phase).real(), G[i], Wnew[j]);
+	}
+	std::swap(recycleW, Wnew);
+}
+
 //--- Implementation of EdiffCheck ---
 inline EdiffCheck::EdiffCheck(unsigned nDiff, double threshold) : nDiff(nDiff), threshold(fabs(threshold)) {}
 inline bool EdiffCheck::checkConvergence(double E)
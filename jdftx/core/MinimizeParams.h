@@ -44,10 +44,18 @@ struct MinimizeParams
 		Quad, //!< use the energy at a test step location to find the minimum along the line (default)
 		CubicWolfe //!< Cubic line search terminated by Wolfe conditions, possibly without a test step
 	} linminMethod;
+	
+	//! Storage of the L-BFGS history (see LBFGSHistoryStore; vector types without a compact store always use HistoryFull)
+	enum HistoryStorage
+	{	HistoryFull, //!< full copies alongside the variables, on the same device (default)
+		HistoryHost, //!< double precision in host memory, copied back one entry at a time when used
+		HistoryHostSingle //!< single precision in host memory (halves the memory of HistoryHost)
+	} historyStorage;
 
 	int nIterations; //!< Maximum number of iterations (default 100)
 	int nDim; //!< Dimension of optimization space; used only for knormThreshold (default 1)
 	int history; //!< Number of past variables and residuals to store (BFGS only)
+	int nRecycle; //!< Number of Ritz vectors recycled between successive linear solves to deflate CG (LinearSolvable only, default: 0 = disabled)
 	FILE* fpLog; //!< Stream to log iterations to
 	const char* linePrefix; //!< prefix for each output line of minimizer, useful for nested minimizations (default "CG\t")
 	const char* energyLabel; //!< Label for the minimized quantity (default "E")
@@ -71,8 +79,8 @@ struct MinimizeParams
 	
 	//! Set the default values
 	MinimizeParams() 
-	: dirUpdateScheme(PolakRibiere), linminMethod(DirUpdateRecommended),
-		nIterations(100), nDim(1), history(15), fpLog(stdout),
+	: dirUpdateScheme(PolakRibiere), linminMethod(DirUpdateRecommended), historyStorage(HistoryFull),
+		nIterations(100), nDim(1), history(15), nRecycle(0), fpLog(stdout),
 		linePrefix("CG\t"), energyLabel("E"), energyFormat("%22.15le"),
 		knormThreshold(0), energyDiffThreshold(0), nEnergyDiff(2),
 		alphaTstart(1.0), alphaTmin(1e-10), updateTestStepSize(true),
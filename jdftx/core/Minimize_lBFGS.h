@@ -40,12 +40,40 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 	
 	//History of variable and residual changes:
 	struct History
-	{	Vector s; //change in variable (= alpha d)
-		Vector Ky; //change in preconditioned residual (= Kg - KgPrev)
+	{	LBFGSHistoryStore<Vector> s; //change in variable (= alpha d)
+		LBFGSHistoryStore<Vector> Ky; //change in preconditioned residual (= Kg - KgPrev)
 		double rho; //= 1/dot(s,y)
 	};
 	std::list< std::shared_ptr<History> > history;
 	double gamma = 0.; //scaling: set to dot(s,y)/dot(y,Ky) each iteration
+	Vector y, Ky; //changes in residual and preconditioned residual (storage reused across iterations)
+	Vector work; //expansion buffer for compactly stored history entries (unused otherwise)
+	
+	//Restore history saved by a previous run, if available:
+	{	std::vector<Vector> sSaved, KySaved; std::vector<double> rhoSaved;
+		if(loadLBFGS(sSaved, KySaved, rhoSaved, gamma))
+		{	for(size_t j=std::max(0, int(sSaved.size())-p.history); j<sSaved.size(); j++)
+			{	std::shared_ptr<History> h = std::make_shared<History>();
+				h->rho = rhoSaved[j];
+				h->s.store(sSaved[j], p);
+				h->Ky.store(KySaved[j], p);
+				history.push_back(h);
+			}
+			fprintf(p.fpLog, "%s\tRestored %d history entries from a previous run.\n", p.linePrefix, int(history.size()));
+			fflush(p.fpLog);
+		}
+	}
+	//Persist history for restarts, if supported:
+	auto saveHistory = [&]()
+	{	if(!persistLBFGS()) return;
+		std::vector<Vector> sArr, KyArr; std::vector<double> rhoArr;
+		for(const std::shared_ptr<History>& h: history)
+		{	sArr.push_back(clone(h->s.load(work)));
+			KyArr.push_back(clone(h->Ky.load(work)));
+			rhoArr.push_back(h->rho);
+		}
+		saveLBFGS(sArr, KyArr, rhoArr, gamma);
+	};
 	
 	//Select the linmin method:
 	Linmin linmin = getLinmin(p);
@@ -53,12 +81,14 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 	//Iterate until convergence, max iteration count or kill signal
 	int iter=0;
 	for(iter=0; !killFlag; iter++)
-	{	
+	{
+		ProfileRegion iterRegion(p.linePrefix); //one runtime-profiler region per iteration
 		if(report(iter)) //optional reporting/processing
 		{	E = sync(compute(&g, &Kg)); //update energy and gradient if state was modified
 			fprintf(p.fpLog, "%s\tState modified externally: resetting history.\n", p.linePrefix);
 			fflush(p.fpLog);
 			history.clear();
+			saveHistory();
 		}
 		
 		double gKnorm = sync(dot(g,Kg));
@@ -71,6 +101,9 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 		
 		//Check stopping conditions:
 		fprintf(p.fpLog, "\n"); fflush(p.fpLog);
+		if(EventLog::active)
+			EventLog::Event("minimize", p.linePrefix).add("iter", iter).add("energyLabel", p.energyLabel).add("energy", E)
+				.add("gradK", sqrt(gKnorm/p.nDim)).add("alpha", alpha).add("linmin", linminTest ? linminTest : NAN);
 		if(sqrt(gKnorm/p.nDim) < p.knormThreshold)
 		{	fprintf(p.fpLog, "%sConverged (|grad|_K<%le).\n", p.linePrefix, p.knormThreshold);
 			fflush(p.fpLog); return E;
@@ -90,29 +123,29 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 		}
 		if(iter>=p.nIterations) break;
 		
-		//Prepare container that will be committed to history below: (and avoid copies)
-		auto h = std::make_shared<History>();
-		Vector& d = h->s;
-		
 		//Compute search direction:
-		d = clone(Kg);
+		Vector d = clone(Kg);
 		std::stack<double> a; //alpha in the reference renamed to 'a' here to not clash with step size
 		for(auto h=history.rbegin(); h!=history.rend(); h++)
-		{	a.push( (*h)->rho * sync(dot((*h)->s, d)) );
-			axpy(-a.top(), (*h)->Ky, d);
+		{	a.push( (*h)->rho * sync(dot((*h)->s.load(work), d)) );
+			axpy(-a.top(), (*h)->Ky.load(work), d);
 		}
 		if(gamma) d *= gamma; //scaling (available after first iteration)
 		for(auto h=history.begin(); h!=history.end(); h++)
-		{	double b = (*h)->rho * sync(dot((*h)->Ky, d));
-			axpy(a.top()-b, (*h)->s, d);
+		{	double b = (*h)->rho * sync(dot((*h)->Ky.load(work), d));
+			axpy(a.top()-b, (*h)->s.load(work), d);
 			a.pop();
 		}
 		d *= -1;
-		if((int)history.size() == p.history) history.pop_front(); //if full, make room for the upcoming history entry (do this here to free memory earlier)
+		
+		//Prepare container that will be committed to history below (recycling the oldest entry if full):
+		std::shared_ptr<History> h;
+		if((int)history.size() == p.history) { h = history.front(); history.pop_front(); }
+		else h = std::make_shared<History>();
 		constrain(d); //restrict search direction to allowed subspace
 		
 		//Line minimization
-		Vector y = clone(g); h->Ky = clone(Kg); //store previous gradients before linmin changes it (these will later be converted to y = g-gPrev)
+		cloneInto(g, y); cloneInto(Kg, Ky); //store previous gradients before linmin changes it (these will later be converted to y = g-gPrev)
 		double alphaT = std::min(p.alphaTstart, safeStepSize(d));
 		if(!linmin(*this, p, d, alphaT, alpha, E, g, Kg))
 		{	//linmin failed:
@@ -126,6 +159,7 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 				history.clear();
 				gamma = 0.;
 				linminTest = 0.;
+				saveHistory();
 				continue;
 			}
 			else
@@ -139,13 +173,16 @@ template<typename Vector> double Minimizable<Vector>::lBFGS(const MinimizeParams
 		
 		//Update history:
 		linminTest = sync(dot(g,d))/sqrt(sync(dot(g,g))*sync(dot(d,d)));
-		d *= alpha; //d -> alpha * d, which is change of state, and it resides in h->s
-		h->Ky *= -1; axpy(1., Kg, h->Ky); //Ky = K(g-gPrev)
+		d *= alpha; //d -> alpha * d, which is change of state
+		Ky *= -1; axpy(1., Kg, Ky); //Ky = K(g-gPrev)
 		y *= -1; axpy(1., g, y); //y = g-gPrev
-		double ydots = sync(dot(y, h->s));
+		double ydots = sync(dot(y, d));
 		h->rho = 1./ydots;
-		gamma = ydots / sync(dot(y, h->Ky));
+		gamma = ydots / sync(dot(y, Ky));
+		h->s.store(d, p);
+		h->Ky.store(Ky, p);
 		history.push_back(h);
+		saveHistory();
 	}
 	fprintf(p.fpLog, "%sNone of the convergence criteria satisfied after %d iterations.\n", p.linePrefix, iter);
 	return E;
@@ -0,0 +1,88 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <core/NeighborList.h>
+#include <core/Util.h>
+#include <cmath>
+#include <algorithm>
+
+NeighborList::NeighborList(const matrix3<>& R, const vector3<bool>& isTruncated, const std::vector<vector3<>>& pos, double rCut, bool divideOverProcesses)
+: RTR((~R)*R), rCutSq(rCut*rCut), posWrapped(pos)
+{
+	//Choose bins of width ~ rCut/3 along periodic directions:
+	const int binsPerCut = 3;
+	matrix3<> invR = inv(R);
+	vector3<double> rCutFrac; //cutoff in fractional coordinates along each direction (using perpendicular widths of cell)
+	for(int k=0; k<3; k++)
+	{	rCutFrac[k] = rCut * sqrt(invR.row(k).length_squared()); //rCut / perpendicular width
+		nBins[k] = isTruncated[k] ? 1 : std::max(1, int(floor(binsPerCut / rCutFrac[k])));
+	}
+	//--- limit total bins to number of atoms (avoid visiting many empty bins in sparse cells):
+	while(nBins[0]*nBins[1]*nBins[2] > std::max(1, int(pos.size())))
+	{	int kMax = 0;
+		for(int k=1; k<3; k++) if(nBins[k] > nBins[kMax]) kMax = k;
+		nBins[kMax]--;
+	}
+	//--- range of bin offsets that could contain pairs within rCut:
+	for(int k=0; k<3; k++)
+		nOffsets[k] = isTruncated[k] ? 0 : int(ceil(rCutFrac[k] * nBins[k])) + 1;
+	
+	//Bin atoms:
+	binAtoms.resize(nBins[0]*nBins[1]*nBins[2]);
+	for(size_t c=0; c<pos.size(); c++)
+	{	vector3<int> b;
+		for(int k=0; k<3; k++)
+			if(!isTruncated[k])
+			{	posWrapped[c][k] -= floor(posWrapped[c][k]);
+				b[k] = std::min(nBins[k]-1, int(posWrapped[c][k] * nBins[k]));
+			}
+		binAtoms[binIndex(b)].push_back(c);
+	}
+	
+	nAtomsCum.assign(binAtoms.size()+1, 0);
+	for(size_t iBin=0; iBin<binAtoms.size(); iBin++)
+		nAtomsCum[iBin+1] = nAtomsCum[iBin] + binAtoms[iBin].size();
+	
+	//Divide bins over processes:
+	if(divideOverProcesses)
+		TaskDivision(binAtoms.size(), mpiWorld).myRange(iBinStart, iBinStop);
+	else
+	{	iBinStart = 0;
+		iBinStop = binAtoms.size();
+	}
+}
+
+int NeighborList::nThreads()
+{	return shouldThreadOperators() ? nProcsAvailable : 1;
+}
+
+size_t NeighborList::threadBinBoundary(int iThread, int nThreads) const
+{	if(iThread >= nThreads) return iBinStop;
+	//Bin boundary closest to an equal share of atoms (the cost of each bin is roughly proportional to its atoms):
+	size_t nAtomsStart = nAtomsCum[iBinStart], nAtomsStop = nAtomsCum[iBinStop];
+	size_t nAtomsTarget = nAtomsStart + ((nAtomsStop - nAtomsStart) * iThread) / nThreads;
+	return std::lower_bound(nAtomsCum.begin()+iBinStart, nAtomsCum.begin()+iBinStop, nAtomsTarget) - nAtomsCum.begin();
+}
+
+void NeighborList::PairSum::operator+=(const NeighborList::PairSum& other)
+{	E += other.E;
+	for(size_t c=0; c<forces.size(); c++)
+		forces[c] += other.forces[c];
+	E_RRT += other.E_RRT;
+}
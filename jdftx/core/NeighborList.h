@@ -0,0 +1,147 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_CORE_NEIGHBORLIST_H
+#define JDFTX_CORE_NEIGHBORLIST_H
+
+#include <core/matrix3.h>
+#include <core/Thread.h>
+#include <vector>
+
+//! @addtogroup LongRange
+//! @{
+//! @file NeighborList.h Cell-list enumeration of atom pairs within a cutoff, including periodic images
+
+/** Cell-list enumeration of atom pairs within a cutoff, including periodic images.
+Atoms are binned into a grid of cells of width ~ rCut/3 (but at least one cell per lattice direction),
+so that only bins that could contain pairs within rCut are visited, instead of all atoms in all
+periodic images of the unit cell within a bounding box. Pairs are enumerated on the fly (not stored),
+since pair-potential cutoffs (eg. 200 bohrs for dispersion) imply too many pairs to store.
+The bins are divided over MPI processes (unless disabled in the constructor): quantities accumulated
+in forEachPair must then be summed over processes. The bins of each process are further divided over
+threads, balancing atom counts, in forEachPairThreaded and accumulatePairs.
+*/
+class NeighborList
+{
+public:
+	//! Bin atoms at lattice coordinates pos, for lattice vectors R.
+	//! Lattice directions with isTruncated are treated as non-periodic (no images included).
+	//! If divideOverProcesses is false, every process visits all pairs (no MPI reduction needed).
+	NeighborList(const matrix3<>& R, const vector3<bool>& isTruncated, const std::vector<vector3<>>& pos, double rCut, bool divideOverProcesses=true);
+	
+	//! Call f(c1, c2, x, rSq) once for each distinct pair of atom c1 and an image of atom c2 with 0 < |r| <= rCut,
+	//! where x is the separation (atom c1 - image of c2) in lattice coordinates and rSq its square length.
+	//! Each pair is visited once, with c1 <= c2 (and c1 == c2 only for the distinct images of an atom).
+	template<typename Func> void forEachPair(const Func& f) const;
+	
+	//! Same as forEachPair, but divided over nThreads() threads, calling f(iThread, c1, c2, x, rSq).
+	//! f must only accumulate into storage private to iThread, except for quantities indexed by c1 alone
+	//! (all pairs of a given c1 are visited by the same thread).
+	template<typename Func> void forEachPairThreaded(const Func& f) const;
+	static int nThreads(); //!< number of threads used by forEachPairThreaded (out of threaded regions: nProcsAvailable)
+	
+	//! Energy, forces (per atom) and lattice derivative E_R.R^T accumulated by pair potentials
+	struct PairSum
+	{	double E;
+		std::vector<vector3<>> forces;
+		matrix3<> E_RRT;
+		PairSum(size_t nAtoms=0) : E(0.), forces(nAtoms) {}
+		void operator+=(const PairSum& other);
+	};
+	
+	//! Accumulate a pair potential with f(PairSum& sum, c1, c2, x, rSq) (arguments as in forEachPair)
+	//! over threads, each with its own PairSum, and return their total (for this process alone)
+	template<typename Func> PairSum accumulatePairs(size_t nAtoms, const Func& f) const;
+	
+private:
+	matrix3<> RTR; //!< metric
+	double rCutSq; //!< square of cutoff radius
+	vector3<int> nBins; //!< number of bins along each lattice direction
+	vector3<int> nOffsets; //!< range of bin offsets to visit along each lattice direction
+	std::vector<vector3<>> posWrapped; //!< positions wrapped to [0,1) along periodic directions
+	std::vector<std::vector<int>> binAtoms; //!< atoms in each bin
+	std::vector<size_t> nAtomsCum; //!< cumulative number of atoms in bins before each bin (for thread division)
+	size_t iBinStart, iBinStop; //!< MPI division of bins
+	
+	inline size_t binIndex(const vector3<int>& b) const { return b[2] + nBins[2]*size_t(b[1] + nBins[1]*b[0]); }
+	size_t threadBinBoundary(int iThread, int nThreads) const; //!< start of bins of iThread (of nThreads) within this process's bins
+	template<typename Func> void forEachPairInBins(size_t binStart, size_t binStop, const Func& f) const;
+};
+
+//! @}
+
+//---------------------- Template implementations ---------------------------
+//!@cond
+
+template<typename Func> void NeighborList::forEachPair(const Func& f) const
+{	forEachPairInBins(iBinStart, iBinStop, f);
+}
+
+template<typename Func> void NeighborList::forEachPairThreaded(const Func& f) const
+{	int nThreadsCur = nThreads();
+	auto sub = [&](size_t tStart, size_t tStop)
+	{	for(size_t t=tStart; t<tStop; t++)
+			forEachPairInBins(threadBinBoundary(t, nThreadsCur), threadBinBoundary(t+1, nThreadsCur),
+				[&](int c1, int c2, const vector3<>& x, double rSq) { f(int(t), c1, c2, x, rSq); });
+	};
+	threadLaunch(nThreadsCur, &sub, nThreadsCur);
+}
+
+template<typename Func> NeighborList::PairSum NeighborList::accumulatePairs(size_t nAtoms, const Func& f) const
+{	std::vector<PairSum> sums(nThreads(), PairSum(nAtoms));
+	forEachPairThreaded([&](int iThread, int c1, int c2, const vector3<>& x, double rSq)
+	{	f(sums[iThread], c1, c2, x, rSq);
+	});
+	for(size_t t=1; t<sums.size(); t++)
+		sums[0] += sums[t];
+	return sums[0];
+}
+
+template<typename Func> void NeighborList::forEachPairInBins(size_t binStart, size_t binStop, const Func& f) const
+{	for(size_t iBin=binStart; iBin<binStop; iBin++)
+	{	const std::vector<int>& atoms1 = binAtoms[iBin];
+		if(!atoms1.size()) continue;
+		vector3<int> b1(iBin/(nBins[1]*nBins[2]), (iBin/nBins[2])%nBins[1], iBin%nBins[2]);
+		vector3<int> o; //bin offset
+		for(o[0]=-nOffsets[0]; o[0]<=nOffsets[0]; o[0]++)
+		for(o[1]=-nOffsets[1]; o[1]<=nOffsets[1]; o[1]++)
+		for(o[2]=-nOffsets[2]; o[2]<=nOffsets[2]; o[2]++)
+		{	//Determine bin and image of second atom:
+			vector3<int> b2, t; //bin of second atom, and lattice vector of its image
+			for(int k=0; k<3; k++)
+			{	int b = b1[k] + o[k];
+				t[k] = (b>=0) ? b/nBins[k] : -((nBins[k]-1-b)/nBins[k]); //floor division
+				b2[k] = b - t[k]*nBins[k];
+			}
+			bool tPositive = (t[0] ? t[0]>0 : (t[1] ? t[1]>0 : t[2]>0)); //lexicographically positive image
+			vector3<> tReal(t[0], t[1], t[2]);
+			const std::vector<int>& atoms2 = binAtoms[binIndex(b2)];
+			for(int c1: atoms1)
+				for(int c2: atoms2)
+				{	if(c1>c2 || (c1==c2 && !tPositive)) continue; //each distinct pair counted once
+					vector3<> x = posWrapped[c1] - posWrapped[c2] - tReal;
+					double rSq = RTR.metric_length_squared(x);
+					if(rSq and rSq<=rCutSq) f(c1, c2, x, rSq);
+				}
+		}
+	}
+}
+
+//!@endcond
+#endif // JDFTX_CORE_NEIGHBORLIST_H
@@ -124,10 +124,17 @@ complexScalarFieldTilde O(const complexScalarFieldTilde& in) { return in * in->g
 complexScalarFieldTilde O(complexScalarFieldTilde&& in) { return in *= in->gInfo.detR; }
 
 
+//Runtime profiler region for FFTs, with memory traffic estimated as one pass over input and output:
+inline int fftProfileId() { static int id = Profiler::registerName("FFT"); return id; }
+template<typename Tin, typename Tout> size_t fftBytes(const Tin& in, const Tout& out)
+{	return in->nElem * sizeof(typename Tin::element_type::DataType) + out->nElem * sizeof(typename Tout::element_type::DataType);
+}
+
 //Forward transform
 ScalarField I(ScalarFieldTilde&& in, int nThreads)
 {	//c2r transforms may destroy input, but this input can be destroyed
 	ScalarField out(ScalarFieldData::alloc(in->gInfo, isGpuEnabled()));
+	ProfileRegion profile(fftProfileId(), fftBytes(in, out));
 	#ifdef GPU_ENABLED
 	cufftExecZ2D(in->gInfo.planZ2D, (double2*)in->dataGpu(false), out->dataGpu(false));
 	#else
@@ -144,6 +151,7 @@ ScalarField I(const ScalarFieldTilde& in, int nThreads)
 }
 complexScalarField I(const complexScalarFieldTilde& in, int nThreads)
 {	complexScalarField out(complexScalarFieldData::alloc(in->gInfo, isGpuEnabled()));
+	ProfileRegion profile(fftProfileId(), fftBytes(in, out));
 	#ifdef GPU_ENABLED
 	cufftExecZ2Z(in->gInfo.planZ2Z, (double2*)in->dataGpu(false), (double2*)out->dataGpu(false), CUFFT_INVERSE);
 	#else
@@ -156,6 +164,7 @@ complexScalarField I(const complexScalarFieldTilde& in, int nThreads)
 }
 complexScalarField I(complexScalarFieldTilde&& in, int nThreads)
 {	//Destructible input (transform in place):
+	ProfileRegion profile(fftProfileId(), fftBytes(in, in));
 	#ifdef GPU_ENABLED
 	cufftExecZ2Z(in->gInfo.planZ2Z, (double2*)in->dataGpu(false), (double2*)in->dataGpu(false), CUFFT_INVERSE);
 	#else
@@ -170,6 +179,7 @@ complexScalarField I(complexScalarFieldTilde&& in, int nThreads)
 ScalarFieldTilde Idag(const ScalarField& in, int nThreads)
 {	//r2c transform does not destroy input (no backing up needed)
 	ScalarFieldTilde out(ScalarFieldTildeData::alloc(in->gInfo, isGpuEnabled()));
+	ProfileRegion profile(fftProfileId(), fftBytes(in, out));
 	#ifdef GPU_ENABLED
 	cufftExecD2Z(in->gInfo.planD2Z, in->dataGpu(false), (double2*)out->dataGpu(false));
 	#else
@@ -182,6 +192,7 @@ ScalarFieldTilde Idag(const ScalarField& in, int nThreads)
 }
 complexScalarFieldTilde Idag(const complexScalarField& in, int nThreads)
 {	complexScalarFieldTilde out(complexScalarFieldTildeData::alloc(in->gInfo, isGpuEnabled()));
+	ProfileRegion profile(fftProfileId(), fftBytes(in, out));
 	#ifdef GPU_ENABLED
 	cufftExecZ2Z(in->gInfo.planZ2Z, (double2*)in->dataGpu(false), (double2*)out->dataGpu(false), CUFFT_FORWARD);
 	#else
@@ -194,6 +205,7 @@ complexScalarFieldTilde Idag(const complexScalarField& in, int nThreads)
 }
 complexScalarFieldTilde Idag(complexScalarField&& in, int nThreads)
 {	//Destructible input (transform in place):
+	ProfileRegion profile(fftProfileId(), fftBytes(in, in));
 	#ifdef GPU_ENABLED
 	cufftExecZ2Z(in->gInfo.planZ2Z, (double2*)in->dataGpu(false), (double2*)in->dataGpu(false), CUFFT_FORWARD);
 	#else
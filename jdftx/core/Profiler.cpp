@@ -0,0 +1,368 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <core/Util.h>
+#include <core/GpuUtil.h>
+#include <mutex>
+#include <algorithm>
+#include <dlfcn.h>
+
+namespace Profiler
+{
+	bool active = false;
+
+	//Completed region, as written to the trace:
+	struct Event
+	{	int id;
+		double tStart, duration; //in microseconds
+		size_t nBytes;
+		double energyCPU, energyGPU; //in Joules (phases only)
+	};
+
+	//Call-tree node, accumulating all calls to a region along a specific path:
+	struct Node
+	{	int id, parent;
+		std::map<int,int> children; //index of child nodes by region id
+		double tTot; int nCalls; size_t nBytes;
+		double energyCPU, energyGPU; //in Joules (phases only)
+		Node(int id=-1, int parent=-1) : id(id), parent(parent), tTot(0.), nCalls(0), nBytes(0), energyCPU(0.), energyGPU(0.) {}
+	};
+
+	//Profile data for one thread (only ever accessed by its own thread, until finish):
+	struct ThreadRecord
+	{	int iThread;
+		std::vector<Event> events;
+		std::vector<Node> nodes; //call tree, with root at index 0
+		struct OpenRegion { int id, node; double tStart; size_t nBytes; double eCPU, eGPU; }; //energy counters at start (phases only)
+		std::vector<OpenRegion> stack;
+		size_t nDropped; //number of events not recorded due to maxEvents
+		ThreadRecord(int iThread) : iThread(iThread), nodes(1), nDropped(0) {}
+	};
+
+	const size_t maxEvents = size_t(1)<<20; //cap on trace events per thread (call tree is still updated after this)
+
+	//Process-wide state (heap allocated and never freed, since regions may be registered during exit):
+	struct State
+	{	std::mutex lock;
+		std::vector<string> names;
+		std::map<string,int> ids;
+		std::vector<ThreadRecord*> threads;
+		string filename;
+	};
+	static State& state()
+	{	static State* s = new State;
+		return *s;
+	}
+	
+	//Cumulative energy counters of CPU packages (RAPL via powercap) and of the process's GPU (NVML, loaded at runtime):
+	struct EnergyMeter
+	{	std::mutex lock;
+		std::vector<string> raplFiles; //energy_uj of each package
+		std::vector<double> raplPrev, raplRange; //previous raw reading and wraparound range (in uJ)
+		double raplTotal; //accumulated package energy (in J)
+		typedef int (*NvmlGetEnergy)(void*, unsigned long long*);
+		NvmlGetEnergy nvmlGetEnergy; void* nvmlDevice; //null if unavailable
+		double tStart, eCPUstart, eGPUstart; //readings at start of recording
+		
+		EnergyMeter() : raplTotal(0.), nvmlGetEnergy(0), nvmlDevice(0) {}
+		bool available() const { return raplFiles.size() || nvmlGetEnergy; }
+		
+		static bool readValue(const string& fname, double& value)
+		{	FILE* fp = fopen(fname.c_str(), "r");
+			if(!fp) return false;
+			bool ok = (fscanf(fp, "%lf", &value) == 1);
+			fclose(fp);
+			return ok;
+		}
+		
+		void init()
+		{	//CPU packages (top-level powercap zones only, whose subzones are contained in them):
+			for(int iPkg=0; ; iPkg++)
+			{	ostringstream oss; oss << "/sys/class/powercap/intel-rapl:" << iPkg << "/";
+				string dir = oss.str();
+				double value, range;
+				if(!readValue(dir+"energy_uj", value)) break;
+				if(!readValue(dir+"max_energy_range_uj", range)) range = 0.;
+				raplFiles.push_back(dir+"energy_uj");
+				raplPrev.push_back(value);
+				raplRange.push_back(range);
+			}
+			#if defined(GPU_ENABLED) && !defined(HIP_ENABLED)
+			//GPU of this process:
+			void* lib = dlopen("libnvidia-ml.so.1", RTLD_LAZY);
+			if(lib)
+			{	typedef int (*NvmlInit)();
+				typedef int (*NvmlGetHandle)(const char*, void**);
+				NvmlInit nvmlInit = (NvmlInit)dlsym(lib, "nvmlInit_v2");
+				NvmlGetHandle nvmlGetHandle = (NvmlGetHandle)dlsym(lib, "nvmlDeviceGetHandleByPciBusId_v2");
+				NvmlGetEnergy getEnergy = (NvmlGetEnergy)dlsym(lib, "nvmlDeviceGetTotalEnergyConsumption");
+				int iDevice; char busId[32]; unsigned long long mJ;
+				if(nvmlInit && nvmlGetHandle && getEnergy && nvmlInit()==0
+					&& cudaGetDevice(&iDevice)==cudaSuccess && cudaDeviceGetPCIBusId(busId, sizeof(busId), iDevice)==cudaSuccess
+					&& nvmlGetHandle(busId, &nvmlDevice)==0 && getEnergy(nvmlDevice, &mJ)==0)
+					nvmlGetEnergy = getEnergy;
+			}
+			#endif
+		}
+		
+		//Current cumulative energies in Joules (thread-safe):
+		void sample(double& eCPU, double& eGPU)
+		{	std::lock_guard<std::mutex> guard(lock);
+			for(size_t i=0; i<raplFiles.size(); i++)
+			{	double value;
+				if(!readValue(raplFiles[i], value)) continue;
+				double delta = value - raplPrev[i];
+				if(delta < 0.) delta += raplRange[i]; //counter wrapped around
+				raplTotal += 1e-6*delta;
+				raplPrev[i] = value;
+			}
+			eCPU = raplTotal;
+			unsigned long long mJ = 0;
+			eGPU = (nvmlGetEnergy && nvmlGetEnergy(nvmlDevice, &mJ)==0) ? 1e-3*mJ : 0.;
+		}
+	};
+	static EnergyMeter& energyMeter()
+	{	static EnergyMeter* m = new EnergyMeter;
+		return *m;
+	}
+
+	static thread_local ThreadRecord* myRecord = 0;
+	inline ThreadRecord& record()
+	{	if(!myRecord)
+		{	State& s = state();
+			std::lock_guard<std::mutex> lock(s.lock);
+			myRecord = new ThreadRecord(s.threads.size());
+			s.threads.push_back(myRecord);
+		}
+		return *myRecord;
+	}
+
+	inline double now()
+	{
+		#ifdef GPU_ENABLED
+		cudaDeviceSynchronize(); //attribute GPU time to the region that launched it
+		#endif
+		return clock_us();
+	}
+
+	int registerName(const string& nameIn)
+	{	string name = nameIn;
+		while(name.length() && (isspace(name.back()) || name.back()==':'))
+			name.pop_back();
+		State& s = state();
+		std::lock_guard<std::mutex> lock(s.lock);
+		auto iter = s.ids.find(name);
+		if(iter != s.ids.end()) return iter->second;
+		int id = s.names.size();
+		s.names.push_back(name);
+		s.ids[name] = id;
+		return id;
+	}
+
+	void begin(int id, bool phase)
+	{	ThreadRecord& r = record();
+		int parent = r.stack.size() ? r.stack.back().node : 0;
+		auto iter = r.nodes[parent].children.find(id);
+		int node;
+		if(iter == r.nodes[parent].children.end())
+		{	node = r.nodes.size();
+			r.nodes[parent].children[id] = node;
+			r.nodes.push_back(Node(id, parent));
+		}
+		else node = iter->second;
+		ThreadRecord::OpenRegion region = { id, node, now(), 0, NAN, NAN };
+		if(phase && energyMeter().available()) energyMeter().sample(region.eCPU, region.eGPU);
+		r.stack.push_back(region);
+	}
+
+	void end(int id)
+	{	ThreadRecord& r = record();
+		//Find matching region (regions opened inside and never closed are closed along with it):
+		int iStack = int(r.stack.size())-1;
+		while(iStack>=0 && r.stack[iStack].id != id) iStack--;
+		if(iStack<0) return; //opened before profiler started: ignore
+		double tStop = now();
+		double eCPUstop = NAN, eGPUstop = NAN; //sampled only if closing a phase
+		for(int i=iStack; i<int(r.stack.size()); i++)
+			if(!std::isnan(r.stack[i].eCPU))
+			{	energyMeter().sample(eCPUstop, eGPUstop);
+				break;
+			}
+		while(int(r.stack.size()) > iStack)
+		{	const ThreadRecord::OpenRegion& region = r.stack.back();
+			double duration = tStop - region.tStart;
+			double energyCPU = std::isnan(region.eCPU) ? 0. : eCPUstop - region.eCPU;
+			double energyGPU = std::isnan(region.eGPU) ? 0. : eGPUstop - region.eGPU;
+			Node& node = r.nodes[region.node];
+			node.tTot += duration;
+			node.nCalls++;
+			node.nBytes += region.nBytes;
+			node.energyCPU += energyCPU;
+			node.energyGPU += energyGPU;
+			if(r.events.size() < maxEvents)
+			{	Event event = { region.id, region.tStart, duration, region.nBytes, energyCPU, energyGPU };
+				r.events.push_back(event);
+			}
+			else r.nDropped++;
+			size_t nBytes = region.nBytes;
+			r.stack.pop_back();
+			if(r.stack.size()) r.stack.back().nBytes += nBytes; //bytes are inclusive of nested regions
+		}
+	}
+
+	void addBytes(size_t nBytes)
+	{	ThreadRecord& r = record();
+		if(r.stack.size()) r.stack.back().nBytes += nBytes;
+	}
+
+	void start(string filename)
+	{	if(mpiWorld->nProcesses() > 1)
+		{	ostringstream oss; oss << '.' << mpiWorld->iProcess();
+			filename += oss.str();
+		}
+		state().filename = filename;
+		//Energy counters:
+		EnergyMeter& m = energyMeter();
+		m.init();
+		if(m.available())
+		{	logPrintf("Profiler: recording phase energies from %d CPU package counter(s)%s.\n",
+				int(m.raplFiles.size()), (m.nvmlGetEnergy ? " and the GPU energy counter" : ""));
+			m.sample(m.eCPUstart, m.eGPUstart);
+		}
+		else logPrintf("Profiler: no readable RAPL / NVML energy counters; phase energies will not be reported.\n");
+		m.tStart = clock_us();
+		active = true;
+	}
+
+	//Name with special characters escaped for JSON output
+	string jsonEscape(const string& s)
+	{	string out;
+		for(char c: s)
+		{	if(c=='"' || c=='\\') out.push_back('\\');
+			if(c=='\t' || c=='\n') c = ' ';
+			out.push_back(c);
+		}
+		return out;
+	}
+
+	//Merge call tree of thread record r below node iSrc into combined tree below iDest
+	void mergeTree(const ThreadRecord& r, int iSrc, std::vector<Node>& tree, int iDest)
+	{	for(const auto& child: r.nodes[iSrc].children)
+		{	int iChild;
+			auto iter = tree[iDest].children.find(child.first);
+			if(iter == tree[iDest].children.end())
+			{	iChild = tree.size();
+				tree[iDest].children[child.first] = iChild;
+				tree.push_back(Node(child.first, iDest));
+			}
+			else iChild = iter->second;
+			const Node& src = r.nodes[child.second];
+			tree[iChild].tTot += src.tTot;
+			tree[iChild].nCalls += src.nCalls;
+			tree[iChild].nBytes += src.nBytes;
+			tree[iChild].energyCPU += src.energyCPU;
+			tree[iChild].energyGPU += src.energyGPU;
+			mergeTree(r, child.second, tree, iChild);
+		}
+	}
+
+	//Print call tree below node i, with children sorted by decreasing time
+	void printTree(const std::vector<Node>& tree, int i, int depth, double tMin)
+	{	const State& s = state();
+		std::vector<std::pair<double,int>> children;
+		for(const auto& child: tree[i].children)
+			children.push_back(std::make_pair(-tree[child.second].tTot, child.second));
+		std::sort(children.begin(), children.end());
+		for(const auto& child: children)
+		{	const Node& node = tree[child.second];
+			if(node.tTot < tMin) continue;
+			string label = string(2*depth, ' ') + s.names[node.id];
+			logPrintf("PROFILE-TREE: %-50s %13.6lf s %9d calls", label.c_str(), node.tTot*1e-6, node.nCalls);
+			if(node.nBytes) logPrintf(" %10.3lf GB", node.nBytes*1e-9);
+			if(node.energyCPU || node.energyGPU) logPrintf(" %12.3lf J CPU %12.3lf J GPU", node.energyCPU, node.energyGPU);
+			logPrintf("\n");
+			printTree(tree, child.second, depth+1, tMin);
+		}
+	}
+
+	void finish()
+	{	if(!active) return;
+		active = false;
+		State& s = state();
+		//Write the trace file:
+		FILE* fp = fopen(s.filename.c_str(), "w");
+		if(!fp) logPrintf("WARNING: could not open '%s' for writing the profile trace.\n", s.filename.c_str());
+		else
+		{	int pid = mpiWorld->iProcess();
+			fprintf(fp, "{\"traceEvents\":[\n");
+			fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", pid, pid);
+			for(const ThreadRecord* r: s.threads)
+				for(const Event& event: r->events)
+				{	fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"jdftx\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3lf,\"dur\":%.3lf",
+						jsonEscape(s.names[event.id]).c_str(), pid, r->iThread, event.tStart, event.duration);
+					if(event.nBytes || event.energyCPU || event.energyGPU)
+					{	fprintf(fp, ",\"args\":{");
+						const char* sep = "";
+						if(event.nBytes) { fprintf(fp, "\"bytes\":%zu", event.nBytes); sep = ","; }
+						if(event.energyCPU) { fprintf(fp, "%s\"joulesCPU\":%.6lf", sep, event.energyCPU); sep = ","; }
+						if(event.energyGPU) fprintf(fp, "%s\"joulesGPU\":%.6lf", sep, event.energyGPU);
+						fprintf(fp, "}");
+					}
+					fprintf(fp, "}");
+				}
+			fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+			fclose(fp);
+			logPrintf("Wrote profile trace to '%s'.\n", s.filename.c_str());
+		}
+		//Log the combined call tree of all threads:
+		std::vector<Node> tree(1);
+		size_t nDropped = 0;
+		for(const ThreadRecord* r: s.threads)
+		{	mergeTree(*r, 0, tree, 0);
+			nDropped += r->nDropped;
+		}
+		double tTot = 0.;
+		for(const auto& child: tree[0].children)
+			tTot = std::max(tTot, tree[child.second].tTot);
+		logPrintf("\nPROFILE-TREE: call tree of StopWatch / ProfileRegion times (inclusive, summed over threads; regions below 0.01%% omitted):\n");
+		printTree(tree, 0, 0, 1e-4*tTot);
+		//Energy totals by phase (inclusive of nested phases, from counters shared by all processes on a node):
+		EnergyMeter& m = energyMeter();
+		if(m.available())
+		{	std::map<int, std::vector<double>> phaseTotals; //time, CPU and GPU energy by region id
+			for(const Node& node: tree)
+				if(node.id>=0 && (node.energyCPU || node.energyGPU))
+				{	std::vector<double>& totals = phaseTotals[node.id];
+					totals.resize(3, 0.);
+					totals[0] += node.tTot*1e-6; totals[1] += node.energyCPU; totals[2] += node.energyGPU;
+				}
+			double eCPU, eGPU; m.sample(eCPU, eGPU);
+			double tRun = 1e-6*(clock_us() - m.tStart);
+			eCPU -= m.eCPUstart; eGPU -= m.eGPUstart;
+			logPrintf("\nPROFILE-ENERGY: %-30s %13s %14s %14s\n", "phase", "time [s]", "CPU pkg [J]", "GPU [J]");
+			for(const auto& entry: phaseTotals)
+				logPrintf("PROFILE-ENERGY: %-30s %13.6lf %14.3lf %14.3lf\n", s.names[entry.first].c_str(), entry.second[0], entry.second[1], entry.second[2]);
+			logPrintf("PROFILE-ENERGY: %-30s %13.6lf %14.3lf %14.3lf   (average power %.1lf W CPU, %.1lf W GPU)\n",
+				"total", tRun, eCPU, eGPU, eCPU/tRun, eGPU/tRun);
+		}
+		if(nDropped)
+			logPrintf("PROFILE-TREE: trace events per thread capped at %zu; %zu events omitted from '%s'.\n", maxEvents, nDropped, s.filename.c_str());
+		logPrintf("\n");
+	}
+}
@@ -28,7 +28,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 //! @addtogroup Algorithms
 //! @{
 
-//! @brief Pulay mixing to optimize self-consistent field optimization
+//! @brief Pulay (or modified Broyden) mixing to optimize self-consistent field optimization
 //! @
 template<typename Variable> class Pulay
 {
@@ -129,6 +129,7 @@ template<typename Variable> double Pulay<Variable>::minimize(double Eprev, std::
 
 	for(int iter=0; iter<pp.nIterations; iter++)
 	{
+		ProfileRegion iterRegion(pp.linePrefix); //one runtime-profiler region per iteration
 		//If history is full, remove oldest member
 		assert(pastResiduals.size() == pastVariables.size());
 		if((int)pastResiduals.size() >= pp.history)
@@ -164,6 +165,12 @@ template<typename Variable> double Pulay<Variable>::minimize(double Eprev, std::
 			fprintf(pp.fpLog, "   |%s|: %.3e", extraNames[iExtra].c_str(), extraValues[iExtra]);
 		fprintf(pp.fpLog, "  t[s]: %9.2lf", clock_sec());
 		fprintf(pp.fpLog, "\n"); fflush(pp.fpLog);
+		if(EventLog::active)
+		{	EventLog::Event event("pulay", pp.linePrefix);
+			event.add("iter", iter).add("energyLabel", pp.energyLabel).add("energy", E).add("dE", dE).add("residual", residualNorm);
+			for(size_t iExtra=0; iExtra<extraNames.size(); iExtra++)
+				event.add(extraNames[iExtra].c_str(), extraValues[iExtra]);
+		}
 		
 		//Optional reporting:
 		report(iter);
@@ -192,7 +199,7 @@ template<typename Variable> double Pulay<Variable>::minimize(double Eprev, std::
 		fflush(pp.fpLog);
 		if(converged || killFlag) break; //converged or manually interrupted
 		
-		//---- DIIS/Pulay mixing -----
+		//---- DIIS/Pulay or Broyden mixing -----
 			
 		//Update the overlap matrix
 		size_t ndim = pastResiduals.size();
@@ -203,22 +210,77 @@ template<typename Variable> double Pulay<Variable>::minimize(double Eprev, std::
 			overlap.set(ndim-1, j, thisOverlap);
 		}
 		
-		//Invert the residual overlap matrix to get the minimum of residual
-		matrix cOverlap(ndim+1, ndim+1); //Add row and column to enforce normalization constraint
-		cOverlap.set(0, ndim, 0, ndim, overlap(0, ndim, 0, ndim));
-		for(size_t j=0; j<ndim; j++)
-		{	cOverlap.set(j, ndim, 1);
-			cOverlap.set(ndim, j, 1);
+		//Adaptively prune history entries whose residuals are much larger than the latest one:
+		if(pp.historyPruneFactor > 0.)
+		{	double thresholdSq = pow(pp.historyPruneFactor,2) * overlap(ndim-1,ndim-1).real();
+			std::vector<size_t> iKeep;
+			for(size_t j=0; j+1<ndim; j++)
+				if(overlap(j,j).real() <= thresholdSq)
+					iKeep.push_back(j);
+			iKeep.push_back(ndim-1);
+			if(iKeep.size() < ndim)
+			{	fprintf(pp.fpLog, "%sPruned %lu of %lu history entries.\n", pp.linePrefix, ndim-iKeep.size(), ndim);
+				matrix overlapPrev = overlap;
+				for(size_t i=0; i<iKeep.size(); i++)
+				{	pastVariables[i] = pastVariables[iKeep[i]];
+					pastResiduals[i] = pastResiduals[iKeep[i]];
+					for(size_t j=0; j<iKeep.size(); j++)
+						overlap.set(i,j, overlapPrev(iKeep[i],iKeep[j]));
+				}
+				ndim = iKeep.size();
+				pastVariables.resize(ndim);
+				pastResiduals.resize(ndim);
+			}
+		}
+		
+		//Determine the weights of each past variable (and its preconditioned residual) in the update:
+		std::vector<double> alpha(ndim, 0.);
+		if(pp.mixingScheme==PulayParams::MixingBroyden && ndim>1)
+		{	//Johnson's modified Broyden: secant updates from successive differences,
+			//weighted towards the more recent (smaller residual) iterations
+			size_t m = ndim-1; //number of difference pairs
+			const double w0 = 0.01; //regularization of the inverse Jacobian update
+			std::vector<double> dFnorm(m), w(m);
+			for(size_t k=0; k<m; k++)
+			{	double dFnormSq = overlap(k+1,k+1).real() - 2.*overlap(k+1,k).real() + overlap(k,k).real();
+				dFnorm[k] = sqrt(std::max(dFnormSq, DBL_MIN));
+				w[k] = std::min(1., sqrt(overlap(m,m).real() / overlap(k+1,k+1).real()));
+			}
+			matrix A(m,m), b(m,1);
+			for(size_t k=0; k<m; k++)
+			{	for(size_t l=0; l<m; l++)
+				{	double dFdF = overlap(k+1,l+1).real() - overlap(k+1,l).real() - overlap(k,l+1).real() + overlap(k,l).real();
+					A.set(k,l, w[k]*w[l]*dFdF/(dFnorm[k]*dFnorm[l]) + (k==l ? w0*w0 : 0.));
+				}
+				b.set(k,0, w[k]*(overlap(k+1,m).real() - overlap(k,m).real())/dFnorm[k]);
+			}
+			matrix gamma = inv(A) * b;
+			alpha[m] = 1.;
+			for(size_t k=0; k<m; k++)
+			{	double g = w[k] * gamma(k,0).real() / dFnorm[k];
+				alpha[k+1] -= g;
+				alpha[k] += g;
+			}
+		}
+		else
+		{	//Invert the residual overlap matrix to get the minimum of residual
+			matrix cOverlap(ndim+1, ndim+1); //Add row and column to enforce normalization constraint
+			cOverlap.set(0, ndim, 0, ndim, overlap(0, ndim, 0, ndim));
+			for(size_t j=0; j<ndim; j++)
+			{	cOverlap.set(j, ndim, 1);
+				cOverlap.set(ndim, j, 1);
+			}
+			cOverlap.set(ndim, ndim, 0);
+			matrix cOverlap_inv = inv(cOverlap);
+			for(size_t j=0; j<ndim; j++)
+				alpha[j] = cOverlap_inv(j, ndim).real();
 		}
-		cOverlap.set(ndim, ndim, 0);
-		matrix cOverlap_inv = inv(cOverlap);
 		
 		//Update variable:
 		Variable v;
 		for(size_t j=0; j<ndim; j++)
-		{	double alpha = cOverlap_inv.data()[cOverlap_inv.index(j, ndim)].real();
-			axpy(alpha, pastVariables[j], v);
-			axpy(alpha, precondition(pastResiduals[j]), v);
+		{	axpy(alpha[j], pastVariables[j], v);
+			axpy(alpha[j], precondition(pastResiduals[j]), v);
 		}
 		setVariable(v);
 	}
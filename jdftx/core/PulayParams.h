@@ -41,10 +41,19 @@ struct PulayParams
 	double mixFraction;  //!< Mixing fraction for total density / potential
 	double qMetric; //!< Wavevector controlling the metric for overlaps
 	
+	//! Scheme used to combine the history into the next variable
+	enum MixingScheme
+	{	MixingPulay, //!< Pulay / DIIS: minimize the norm of the linearly-combined residual
+		MixingBroyden //!< Johnson's modified Broyden: weighted secant updates of the inverse Jacobian
+	}
+	mixingScheme;
+	double historyPruneFactor; //!< drop history entries with residual norm exceeding this multiple of the latest one (disabled if 0)
+	
 	PulayParams()
 	: fpLog(stdout), linePrefix("Pulay: "), energyLabel("E"), energyFormat("%22.15le"),
 		nIterations(50), energyDiffThreshold(1e-8), residualThreshold(1e-7),
-		history(10), mixFraction(0.5), qMetric(0.8)
+		history(10), mixFraction(0.5), qMetric(0.8),
+		mixingScheme(MixingPulay), historyPruneFactor(0.)
 	{
 	}
 };
@@ -158,23 +158,95 @@ double RadialFunctionR::transform(int l, double G) const
 	return (4*M_PI/3) * sum;
 }
 
-static void RadialFunction_transform_sub(int iMineStart, int iMineStop, int iGstart, int l, double dG, const RadialFunctionR* rFunc, double* fTilde)
-{	for(int iG=iGstart+iMineStart; iG<iGstart+iMineStop; iG++)
-		fTilde[iG] = rFunc->transform(l, iG*dG);
-}
-
 // Initialize a uniform G radial function from the log-grid function
 void RadialFunctionR::transform(int l, double dG, int nGrid, RadialFunctionG& func) const
+{	transform(std::vector<const RadialFunctionR*>(1, this), std::vector<int>(1, l), dG, nGrid, std::vector<RadialFunctionG*>(1, &func));
+}
+
+//Functions of a given l on a common radial grid, with their samples pre-multiplied by the integration weights:
+struct RadialTransformBatch
+{	int l;
+	const std::vector<double>* r; //longest radial grid of the batch
+	std::vector<int> iFunc; //indices into the transform's function list
+	std::vector<std::vector<double>> fWeighted; //samples times weights (of length dependent on each function's grid)
+};
+
+static void RadialFunction_transform_sub(size_t iGstart, size_t iGstop, int iGoffset, double dG, const RadialTransformBatch* batch, int nGrid, double* fTilde)
+{	int nr = batch->r->size();
+	const double* r = batch->r->data();
+	std::vector<double> jl(nr);
+	for(size_t iG=iGoffset+iGstart; iG<iGoffset+iGstop; iG++)
+	{	//Bessel functions at this G, shared by all functions of batch:
+		double G = iG*dG;
+		for(int i=0; i<nr; i++) jl[i] = bessel_jl(batch->l, G*r[i]);
+		//Integrate each function:
+		for(size_t k=0; k<batch->iFunc.size(); k++)
+		{	const std::vector<double>& fw = batch->fWeighted[k];
+			double sum = 0.;
+			for(size_t i=0; i<fw.size(); i++)
+				sum += fw[i] * jl[i];
+			fTilde[batch->iFunc[k]*nGrid + iG] = (4*M_PI/3) * sum;
+		}
+	}
+}
+
+void RadialFunctionR::transform(const std::vector<const RadialFunctionR*>& rFuncs, const std::vector<int>& l,
+	double dG, int nGrid, const std::vector<RadialFunctionG*>& funcs)
 {	static StopWatch watch("RadialFunctionR::transform"); watch.start();
-	std::vector<double> fTilde(nGrid, 0.);
+	int nFuncs = rFuncs.size();
+	assert(int(l.size()) == nFuncs);
+	assert(int(funcs.size()) == nFuncs);
+	
+	//Group functions into batches of same l on a common grid:
+	std::vector<RadialTransformBatch> batches;
+	for(int iFunc=0; iFunc<nFuncs; iFunc++)
+	{	const RadialFunctionR& rFunc = *(rFuncs[iFunc]);
+		RadialTransformBatch* batch = 0;
+		for(RadialTransformBatch& b: batches)
+		{	if(b.l != l[iFunc]) continue;
+			//Check for a common grid (one being a prefix of the other):
+			const std::vector<double>& rShort = (rFunc.r.size() < b.r->size()) ? rFunc.r : *(b.r);
+			const std::vector<double>& rLong = (rFunc.r.size() < b.r->size()) ? *(b.r) : rFunc.r;
+			if(std::equal(rShort.begin(), rShort.end(), rLong.begin()))
+			{	batch = &b;
+				if(rFunc.r.size() > b.r->size()) b.r = &rFunc.r;
+				break;
+			}
+		}
+		if(!batch)
+		{	batches.push_back(RadialTransformBatch());
+			batch = &batches.back();
+			batch->l = l[iFunc];
+			batch->r = &rFunc.r;
+		}
+		//Samples times weights for Simpson's 1/3 rule on the log-grid:
+		int Nhlf = (rFunc.f.size()-1)/2; //half the sample points
+		std::vector<double> fw(2*Nhlf+1);
+		for(int i=0; i<=2*Nhlf; i++)
+			fw[i] = rFunc.f[i]
+				* (rFunc.dr[i] * rFunc.r[i]*rFunc.r[i]) //weight for radial spherical integration
+				* ( (i==0 || i==2*Nhlf) ? 1 : 2*((i%2)+1) ); //simpson integration factor
+		batch->iFunc.push_back(iFunc);
+		batch->fWeighted.push_back(fw);
+	}
+	
+	//Transform each batch, over this process's share of the G grid:
+	std::vector<double> fTilde(nFuncs*nGrid, 0.);
 	int iGstart, iGstop; TaskDivision(nGrid, mpiWorld).myRange(iGstart, iGstop);
 	int nGridMine = iGstop-iGstart;
 	if(nGridMine)
-		threadLaunch(RadialFunction_transform_sub, nGridMine, iGstart, l, dG, this, fTilde.data());
+		for(const RadialTransformBatch& batch: batches)
+			threadLaunch(RadialFunction_transform_sub, nGridMine, iGstart, dG, &batch, nGrid, fTilde.data());
 	mpiWorld->allReduceData(fTilde, MPIUtil::ReduceSum);
-	func.free(this!=func.rFunc);
-	func.init(l, fTilde, dG);
-	if(this!=func.rFunc) func.rFunc = new RadialFunctionR(*this);
+	
+	//Initialize the uniform grid functions:
+	for(int iFunc=0; iFunc<nFuncs; iFunc++)
+	{	const RadialFunctionR* rFunc = rFuncs[iFunc];
+		RadialFunctionG& func = *(funcs[iFunc]);
+		func.free(rFunc!=func.rFunc);
+		func.init(l[iFunc], std::vector<double>(fTilde.begin()+iFunc*nGrid, fTilde.begin()+(iFunc+1)*nGrid), dG);
+		if(rFunc!=func.rFunc) func.rFunc = new RadialFunctionR(*rFunc);
+	}
 	watch.stop();
 }
 
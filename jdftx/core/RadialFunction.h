@@ -128,6 +128,12 @@ struct RadialFunctionR
 	//! Initialize a uniform G radial function from the logPrintf grid function according to
 	//! @$ func(G) = \int dr 4\pi r^2 j_l(G r) f(r) @$
 	void transform(int l, double dG, int nGrid, RadialFunctionG& func) const;
+	
+	//! Batched version of the above: initialize funcs[i] from rFuncs[i] with order l[i] (all on the same uniform G grid).
+	//! Functions on a common radial grid (allowing truncation, i.e. each r a prefix of the longest) share the Bessel
+	//! function evaluations at each G between them, which dominate the cost when transforming many channels of a species.
+	static void transform(const std::vector<const RadialFunctionR*>& rFuncs, const std::vector<int>& l,
+		double dG, int nGrid, const std::vector<RadialFunctionG*>& funcs);
 };
 
 //! @}
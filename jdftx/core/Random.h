@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_CORE_RANDOM_H
 
 #include <core/scalar.h>
+#include <stdint.h>
 
 //! @addtogroup Utilities
 //! @{
@@ -33,6 +34,39 @@ namespace Random
 	int uniformInt(int end); //!< uniform integer in [0,end)
 	double normal(double mean=0.0, double sigma=1.0, double cap=0.0); //!< normal random numbers with mean, sigma and an optional cap if non-zero
 	complex normalComplex(double sigma=1.0); //!< normal complex number with mean 0 and deviation sigma
+	
+	//! Philox4x32-10 counter-based generator: maps a 128-bit counter (in place) and 64-bit key to 128 random bits.
+	//! Results depend only on (counter, key), and not on call order, so they are reproducible for any thread / process layout.
+	__hostanddev__ void philox4x32(uint32_t* ctr, uint32_t key0, uint32_t key1)
+	{	for(int round=0; round<10; round++)
+		{	if(round) { key0 += 0x9E3779B9; key1 += 0xBB67AE85; }
+			uint64_t p0 = uint64_t(0xD2511F53) * ctr[0];
+			uint64_t p1 = uint64_t(0xCD9E8D57) * ctr[2];
+			uint32_t c0 = uint32_t(p1>>32) ^ ctr[1] ^ key0;
+			uint32_t c2 = uint32_t(p0>>32) ^ ctr[3] ^ key1;
+			ctr[0] = c0; ctr[1] = uint32_t(p1);
+			ctr[2] = c2; ctr[3] = uint32_t(p0);
+		}
+	}
+	
+	//! Normal complex number with mean 0 and deviation sigma (per component) for given counter and key (see philox4x32)
+	__hostanddev__ complex normalComplexCounter(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t key0, uint32_t key1, double sigma=1.0)
+	{	uint32_t ctr[4] = { c0, c1, c2, c3 };
+		philox4x32(ctr, key0, key1);
+		const double scale = 1./9007199254740992.; //2^-53
+		double u1 = ((((uint64_t(ctr[0])<<32) | ctr[1]) >> 11) + 0.5) * scale; //in (0,1)
+		double u2 = ((((uint64_t(ctr[2])<<32) | ctr[3]) >> 11) + 0.5) * scale;
+		double r = sigma * sqrt(-2.*log(u1)); //Box-Muller
+		return complex(r*cos(2*M_PI*u2), r*sin(2*M_PI*u2));
+	}
+	
+	//! Combine x into the 64-bit hash h (splitmix64 finalizer), used to construct keys for the counter-based generator
+	inline uint64_t hashCombine(uint64_t h, uint64_t x)
+	{	uint64_t z = h ^ (x + 0x9E3779B97F4A7C15ULL + (h<<6) + (h>>2));
+		z = (z ^ (z>>30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z>>27)) * 0x94D049BB133111EBULL;
+		return z ^ (z>>31);
+	}
 }
 
 //! @}
@@ -36,6 +36,12 @@ ScalarField ScalarFieldData::clone() const
 	return copy;
 }
 ScalarField ScalarFieldData::alloc(const GridInfo& gInfo, bool onGpu) { return std::make_shared<ScalarFieldData>(gInfo, onGpu, PrivateTag()); }
+
+ScalarFieldData::ScalarFieldData(const GridInfo& gInfo, double* data, PrivateTag)
+: FieldData<double>(gInfo, "ScalarField", gInfo.nr, data)
+{
+}
+ScalarField ScalarFieldData::borrow(const GridInfo& gInfo, double* data) { return std::make_shared<ScalarFieldData>(gInfo, data, PrivateTag()); }
  
 matrix ScalarFieldData::toMatrix() const
 {
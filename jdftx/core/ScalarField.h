@@ -55,6 +55,7 @@ template<typename T> struct FieldData : private ManagedMemory<T>
 	const GridInfo& gInfo; //!< simulation grid info
 
 	FieldData(const GridInfo& gInfo, string category, int nElem, bool onGpu=false);
+	FieldData(const GridInfo& gInfo, string category, int nElem, T* borrowedData); //!< refer to externally owned CPU data (see ManagedMemory::memBorrow)
 	void copyData(const FieldData<T>& other); //!< Copy data and scale (used by clone())
 	void absorbScale() const; //!< Absorb scale factor into data
 	
@@ -103,6 +104,8 @@ struct ScalarFieldData : public FieldData<double>
 	ScalarField clone() const; //!< clone the data (NOTE: assigning ScalarField's makes a new reference to the same data)
 	static ScalarField alloc(const GridInfo& gInfo, bool onGpu=false); //!< Create real space data
 	ScalarFieldData(const GridInfo& gInfo, bool onGpu, PrivateTag); //!< called only by ScalarFieldData::alloc()
+	static ScalarField borrow(const GridInfo& gInfo, double* data); //!< Wrap externally owned CPU data (eg. of a host code in library mode) without copying; data must outlive the result
+	ScalarFieldData(const GridInfo& gInfo, double* data, PrivateTag); //!< called only by ScalarFieldData::borrow()
 	matrix toMatrix() const; //!<convert to (complex) matrix
 };
 
@@ -171,6 +174,12 @@ template<typename T> FieldData<T>::FieldData(const GridInfo& gInfo, string categ
 	ManagedMemory<T>::memInit(category, nElem, onGpu);
 }
 
+template<typename T> FieldData<T>::FieldData(const GridInfo& gInfo, string category, int nElem, T* borrowedData)
+: nElem(nElem), scale(1.), gInfo(gInfo)
+{
+	ManagedMemory<T>::memBorrow(category, borrowedData, nElem);
+}
+
 template<typename T> void FieldData<T>::copyData(const FieldData<T>& other)
 {	scale = other.scale;
 	memcpy((ManagedMemory<T>&)(*this), other);
@@ -150,6 +150,28 @@ template<typename T> void nullToZero(TptrCollection& x, const GridInfo& gInfo, i
 	for(unsigned i=0; i<x.size(); i++) nullToZero(x[i], gInfo);
 }
 
+//! Reduce all (non-null) fields of a collection over mpiUtil with a single collective, packed into one buffer.
+//! The buffer is on the GPU in GPU builds, so that with device collectives (see MPIUtil::deviceCollectives)
+//! the fields are reduced without any host round trip, and with one message in place of one per field.
+template<typename T> void allReduceDataPacked(TptrCollection& x, const MPIUtil* mpiUtil, MPIUtil::ReduceOp op)
+{	if(mpiUtil->nProcesses() == 1) return;
+	typedef typename T::DataType DataType;
+	size_t nTot = 0;
+	for(const auto& xs: x) if(xs) nTot += xs->nElem;
+	ManagedArray<DataType> buf; buf.init(nTot, isGpuEnabled());
+	DataType* bufData = buf.dataPref();
+	for(const auto& xs: x) if(xs)
+	{	callPref(eblas_copy)(bufData, xs->dataPref(), xs->nElem);
+		bufData += xs->nElem;
+	}
+	mpiUtil->allReduceData(buf, op);
+	bufData = buf.dataPref();
+	for(auto& xs: x) if(xs)
+	{	callPref(eblas_copy)(xs->dataPref(false), bufData, xs->nElem);
+		bufData += xs->nElem;
+	}
+}
+
 //! Initialize to random numbers (uniform on 0 to 1)
 template<typename T> void initRandomFlat(TptrCollection& x)
 {	for(unsigned i=0; i<x.size(); i++) initRandomFlat(x[i]);
@@ -0,0 +1,201 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_CORE_SCALARFIELDEXPR_H
+#define JDFTX_CORE_SCALARFIELDEXPR_H
+
+/** @file ScalarFieldExpr.h
+@brief Fused (lazily evaluated) elementwise expressions of ScalarField's and related types
+
+The usual operators on #ScalarField etc. evaluate eagerly: an expression like a*b + 2.*c*d
+makes one pass over memory and allocates one temporary per operator.
+Wrapping the operands with lazy() instead builds a light-weight expression tree, which
+is evaluated in a single threaded pass by eval(), assign() or accumulate():
+
+	ScalarField e = eval(lazy(a)*lazy(b) + 2.*lazy(c)*lazy(d));
+	accumulate(E_n, -0.5, lazy(n)*lazy(phi)); // E_n -= 0.5*n*phi
+
+Pending scale factors of the operands are folded into the pass, so no separate scaling pass is needed.
+All operands of an expression must be of the same field type, on the same grid.
+In GPU builds, the fused pass is a single kernel when the evaluation is called from a .cu file;
+from .cpp files, the expression falls back to the usual (eager) operators (same results and cost as before).
+The operands are referenced, not copied, and must outlive the expression (so don't store expressions).
+*/
+
+#include <core/ScalarField.h>
+#include <core/Operators.h>
+#include <core/Thread.h>
+#ifdef GPU_ENABLED
+#include <core/GpuKernelUtils.h>
+#endif
+
+//! @addtogroup Operators
+//! @{
+
+//! Lazy expression tree nodes (use lazy() and the operators below rather than these directly)
+namespace FieldExpr
+{
+	//! Leaf node referencing a field, with its pending scale factor
+	template<typename T> struct Leaf
+	{	typedef T FieldType;
+		typedef typename T::DataType DataType;
+		const DataType* data; //!< unscaled data (CPU or GPU as per preferred data location)
+		double scale; //!< pending scale factor of field
+		const std::shared_ptr<T>* X; //!< referenced field (host-side only; used for eager fallback)
+		Leaf(const std::shared_ptr<T>& X) : data(X->dataPref(false)), scale(X->scale), X(&X) {}
+		__hostanddev__ DataType operator()(int i) const { return scale * data[i]; }
+		std::shared_ptr<T> eager() const { return *X; }
+		const std::shared_ptr<T>& field() const { return *X; } //!< a representative field (for grid and size)
+	};
+
+	//! Scale an expression by a constant
+	template<typename E> struct Scale
+	{	typedef typename E::FieldType FieldType;
+		typedef typename E::DataType DataType;
+		E e; double alpha;
+		Scale(const E& e, double alpha) : e(e), alpha(alpha) {}
+		__hostanddev__ DataType operator()(int i) const { return alpha * e(i); }
+		std::shared_ptr<FieldType> eager() const { return alpha * e.eager(); }
+		const std::shared_ptr<FieldType>& field() const { return e.field(); }
+	};
+
+	//! Shift an expression by a constant (only supported for real data)
+	template<typename E> struct Shift
+	{	typedef typename E::FieldType FieldType;
+		typedef typename E::DataType DataType;
+		E e; double c;
+		Shift(const E& e, double c) : e(e), c(c) {}
+		__hostanddev__ DataType operator()(int i) const { return e(i) + c; }
+		std::shared_ptr<FieldType> eager() const { return e.eager() + c; }
+		const std::shared_ptr<FieldType>& field() const { return e.field(); }
+	};
+
+	//! Elementwise binary operations between expressions
+	#define DECLARE_FieldExpr_Binary(Name, op) \
+		template<typename E1, typename E2> struct Name \
+		{	typedef typename E1::FieldType FieldType; \
+			typedef typename E1::DataType DataType; \
+			E1 e1; E2 e2; \
+			Name(const E1& e1, const E2& e2) : e1(e1), e2(e2) \
+			{	assert(e1.field()->nElem == e2.field()->nElem); \
+				assert(&(e1.field()->gInfo) == &(e2.field()->gInfo)); \
+			} \
+			__hostanddev__ DataType operator()(int i) const { return e1(i) op e2(i); } \
+			std::shared_ptr<FieldType> eager() const { return e1.eager() op e2.eager(); } \
+			const std::shared_ptr<FieldType>& field() const { return e1.field(); } \
+		};
+	DECLARE_FieldExpr_Binary(Sum, +)
+	DECLARE_FieldExpr_Binary(Diff, -)
+	DECLARE_FieldExpr_Binary(Prod, *)
+	#undef DECLARE_FieldExpr_Binary
+
+	//! Trait to restrict the operators below to expression nodes
+	template<typename E> struct IsExpr { static const bool value = false; };
+	template<typename T> struct IsExpr< Leaf<T> > { static const bool value = true; };
+	template<typename E> struct IsExpr< Scale<E> > { static const bool value = true; };
+	template<typename E> struct IsExpr< Shift<E> > { static const bool value = true; };
+	template<typename E1, typename E2> struct IsExpr< Sum<E1,E2> > { static const bool value = true; };
+	template<typename E1, typename E2> struct IsExpr< Diff<E1,E2> > { static const bool value = true; };
+	template<typename E1, typename E2> struct IsExpr< Prod<E1,E2> > { static const bool value = true; };
+
+	//! Check that E1 and E2 are expressions on the same field type, and alias result type R
+	template<typename E1, typename E2, typename R, bool = IsExpr<E1>::value && IsExpr<E2>::value> struct EnableIf2 {};
+	template<typename E1, typename E2, typename R> struct EnableIf2<E1,E2,R,true>
+		: public std::enable_if<std::is_same<typename E1::FieldType, typename E2::FieldType>::value, R> {};
+	template<typename E, typename R> struct EnableIf1 : public std::enable_if<IsExpr<E>::value, R> {};
+
+	//CPU evaluation: out = (alpha ? out + alpha*e : e)
+	template<typename E> void eval_sub(size_t iStart, size_t iStop, const E* e, double alpha, typename E::DataType* out)
+	{	if(alpha) for(size_t i=iStart; i<iStop; i++) out[i] += alpha * (*e)(i);
+		else for(size_t i=iStart; i<iStop; i++) out[i] = (*e)(i);
+	}
+	template<typename E> void eval_cpu(int N, const E& e, double alpha, typename E::DataType* out)
+	{	threadLaunch((N<100000) ? 1 : 0, //force single threaded for small problem sizes
+			eval_sub<E>, N, &e, alpha, out);
+	}
+
+	#ifdef __in_a_cu_file__
+	template<typename E> __global__ void eval_kernel(int N, const E e, double alpha, typename E::DataType* out)
+	{	int i = kernelIndex1D();
+		if(i<N) out[i] = alpha ? out[i] + alpha*e(i) : e(i);
+	}
+	template<typename E> void eval_gpu(int N, const E& e, double alpha, typename E::DataType* out)
+	{	GpuLaunchConfig1D glc(eval_kernel<E>, N);
+		eval_kernel<E><<<glc.nBlocks,glc.nPerBlock>>>(N, e, alpha, out);
+		gpuErrorCheck();
+	}
+	#endif
+}
+
+//! Start a lazy expression from a field (see ScalarFieldExpr.h)
+template<typename T> FieldExpr::Leaf<T> lazy(const std::shared_ptr<T>& X) { assert(X); return FieldExpr::Leaf<T>(X); }
+
+template<typename E1, typename E2> typename FieldExpr::EnableIf2<E1,E2,FieldExpr::Sum<E1,E2>>::type operator+(const E1& e1, const E2& e2) { return FieldExpr::Sum<E1,E2>(e1, e2); } //!< Lazy add
+template<typename E1, typename E2> typename FieldExpr::EnableIf2<E1,E2,FieldExpr::Diff<E1,E2>>::type operator-(const E1& e1, const E2& e2) { return FieldExpr::Diff<E1,E2>(e1, e2); } //!< Lazy subtract
+template<typename E1, typename E2> typename FieldExpr::EnableIf2<E1,E2,FieldExpr::Prod<E1,E2>>::type operator*(const E1& e1, const E2& e2) { return FieldExpr::Prod<E1,E2>(e1, e2); } //!< Lazy elementwise multiply
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Scale<E>>::type operator*(double alpha, const E& e) { return FieldExpr::Scale<E>(e, alpha); } //!< Lazy scale
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Scale<E>>::type operator*(const E& e, double alpha) { return FieldExpr::Scale<E>(e, alpha); } //!< Lazy scale
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Scale<E>>::type operator-(const E& e) { return FieldExpr::Scale<E>(e, -1.); } //!< Lazy negate
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Shift<E>>::type operator+(const E& e, double c) { return FieldExpr::Shift<E>(e, c); } //!< Lazy add scalar (real data only)
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Shift<E>>::type operator+(double c, const E& e) { return FieldExpr::Shift<E>(e, c); } //!< Lazy add scalar (real data only)
+template<typename E> typename FieldExpr::EnableIf1<E,FieldExpr::Shift<E>>::type operator-(const E& e, double c) { return FieldExpr::Shift<E>(e, -c); } //!< Lazy subtract scalar (real data only)
+
+//! Evaluate a lazy expression into its target Y in a single pass (Y may be one of the operands; a null Y is allocated).
+//! Note that Y is overwritten in place (as with operator*= etc.), which affects all references to it.
+template<typename E> void assign(std::shared_ptr<typename E::FieldType>& Y, const E& e)
+{	const auto& X = e.field();
+	#if defined(GPU_ENABLED) && !defined(__in_a_cu_file__)
+	Y = e.eager(); //no fused kernel available from .cpp files
+	#else
+	if(Y) assert(Y->nElem == X->nElem);
+	else Y = E::FieldType::alloc(X->gInfo, isGpuEnabled());
+	Y->scale = 1.;
+	#ifdef GPU_ENABLED
+	FieldExpr::eval_gpu(X->nElem, e, 0., Y->dataGpu(false));
+	#else
+	FieldExpr::eval_cpu(X->nElem, e, 0., Y->data(false));
+	#endif
+	#endif
+}
+
+//! Evaluate a lazy expression into a new field in a single pass
+template<typename E> std::shared_ptr<typename E::FieldType> eval(const E& e)
+{	std::shared_ptr<typename E::FieldType> Y;
+	assign(Y, e);
+	return Y;
+}
+
+//! Fused linear combine of a lazy expression: Y += alpha * e, in a single pass (Note: null Y is treated as zero, like axpy)
+template<typename E> void accumulate(std::shared_ptr<typename E::FieldType>& Y, double alpha, const E& e)
+{	if(!alpha) return;
+	if(!Y || Y->scale==0.) { assign(Y, alpha*e); return; }
+	#if defined(GPU_ENABLED) && !defined(__in_a_cu_file__)
+	axpy(alpha, e.eager(), Y); //no fused kernel available from .cpp files
+	#else
+	assert(Y->nElem == e.field()->nElem);
+	#ifdef GPU_ENABLED
+	FieldExpr::eval_gpu(Y->nElem, e, alpha/Y->scale, Y->dataGpu(false));
+	#else
+	FieldExpr::eval_cpu(Y->nElem, e, alpha/Y->scale, Y->data(false));
+	#endif
+	#endif
+}
+
+//! @}
+#endif // JDFTX_CORE_SCALARFIELDEXPR_H
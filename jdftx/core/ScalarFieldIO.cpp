@@ -21,8 +21,11 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/GridInfo.h>
 #include <core/Operators.h>
 #include <core/WignerSeitz.h>
+#include <core/Thread.h>
+#include <core/Units.h>
 #include <string.h>
 #include <algorithm>
+#include <mutex>
 
 
 void saveDX(const ScalarField& X, const char* filenamePrefix)
@@ -66,21 +69,199 @@ void saveDX(const ScalarField& X, const char* filenamePrefix)
 	fclose(fp);
 }
 
+//Write nLines lines of text produced by formatLine(iLine, buf), which appends line iLine to buf.
+//Blocks of lines are formatted on threads into separate buffers, which are then written in order.
+template<typename FormatLine> void writeFormatted(FILE* fp, size_t nLines, const FormatLine& formatLine)
+{	const size_t nLinesPerBlock = 64;
+	size_t nBlocks = (nLines + nLinesPerBlock - 1) / nLinesPerBlock;
+	std::vector<std::string> buf(4*nProcsAvailable); //blocks formatted together (limits memory use)
+	for(size_t blockStart=0; blockStart<nBlocks; blockStart+=buf.size())
+	{	size_t nBlocksCur = std::min(buf.size(), nBlocks-blockStart);
+		auto formatBlocks = [&](size_t iStart, size_t iStop)
+		{	for(size_t i=iStart; i<iStop; i++)
+			{	std::string& bufCur = buf[i]; bufCur.clear();
+				size_t lineStart = (blockStart+i)*nLinesPerBlock;
+				size_t lineStop = std::min(lineStart+nLinesPerBlock, nLines);
+				for(size_t iLine=lineStart; iLine<lineStop; iLine++)
+					formatLine(iLine, bufCur);
+			}
+		};
+		threadLaunch(&formatBlocks, nBlocksCur);
+		for(size_t i=0; i<nBlocksCur; i++)
+			fwrite(buf[i].data(), 1, buf[i].size(), fp);
+	}
+}
 
-std::vector< std::vector<double> > sphericalize(const ScalarField* dataR, int nColumns, double drFac, vector3< double >* center)
+void saveVTI(const ScalarField& X, const char* filename, const char* varName)
+{	const GridInfo& g = X->gInfo;
+	const vector3<int>& S = g.S;
+	FILE* fp = fopen(filename, "wb");
+	if(!fp) die("Error opening %s for writing.\n", filename);
+	//Header (grid axes along lattice vectors):
+	vector3<> spacing; matrix3<> direction;
+	for(int k=0; k<3; k++)
+	{	vector3<> Rk = g.R.column(k);
+		spacing[k] = Rk.length() / S[k];
+		direction.set_col(k, Rk * (1./Rk.length()));
+	}
+	fprintf(fp, "<?xml version=\"1.0\"?>\n");
+	fprintf(fp, "<VTKFile type=\"ImageData\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">\n");
+	fprintf(fp, "  <ImageData WholeExtent=\"0 %d 0 %d 0 %d\" Origin=\"0 0 0\" Spacing=\"%.15lg %.15lg %.15lg\" Direction=\"",
+		S[0]-1, S[1]-1, S[2]-1, spacing[0], spacing[1], spacing[2]);
+	for(int i=0; i<3; i++) for(int j=0; j<3; j++) fprintf(fp, (i||j) ? " %.15lg" : "%.15lg", direction(i,j));
+	fprintf(fp, "\">\n");
+	fprintf(fp, "    <Piece Extent=\"0 %d 0 %d 0 %d\">\n", S[0]-1, S[1]-1, S[2]-1);
+	fprintf(fp, "      <PointData Scalars=\"%s\">\n", varName);
+	fprintf(fp, "        <DataArray type=\"Float64\" Name=\"%s\" format=\"appended\" offset=\"0\"/>\n", varName);
+	fprintf(fp, "      </PointData>\n");
+	fprintf(fp, "    </Piece>\n");
+	fprintf(fp, "  </ImageData>\n");
+	fprintf(fp, "  <AppendedData encoding=\"raw\">\n_");
+	//Data (transposed to first index fastest, as VTK expects):
+	uint64_t nBytes = g.nr * sizeof(double);
+	fwriteLE(&nBytes, sizeof(uint64_t), 1, fp);
+	std::vector<double> buf(g.nr);
+	const double* Xdata = X->data();
+	auto transpose = [&](size_t i2start, size_t i2stop)
+	{	for(size_t i2=i2start; i2<i2stop; i2++)
+			for(int i1=0; i1<S[1]; i1++)
+				for(int i0=0; i0<S[0]; i0++)
+					buf[i0 + S[0]*(i1 + S[1]*i2)] = Xdata[i2 + S[2]*(i1 + S[1]*i0)];
+	};
+	threadLaunch(&transpose, S[2]);
+	fwriteLE(buf.data(), sizeof(double), buf.size(), fp);
+	fprintf(fp, "\n  </AppendedData>\n");
+	fprintf(fp, "</VTKFile>\n");
+	fclose(fp);
+}
+
+void saveXSF(const ScalarField& X, const char* filename, const char* varName, const std::vector<std::pair<int,vector3<>>>& atoms)
+{	const GridInfo& g = X->gInfo;
+	const vector3<int>& S = g.S;
+	FILE* fp = fopen(filename, "w");
+	if(!fp) die("Error opening %s for writing.\n", filename);
+	//Structure (in Angstroms):
+	fprintf(fp, "CRYSTAL\nPRIMVEC\n");
+	for(int k=0; k<3; k++)
+	{	vector3<> Rk = g.R.column(k) / Angstrom;
+		fprintf(fp, "%.12lf %.12lf %.12lf\n", Rk[0], Rk[1], Rk[2]);
+	}
+	fprintf(fp, "PRIMCOORD\n%d 1\n", int(atoms.size()));
+	for(const auto& atom: atoms)
+	{	vector3<> pos = atom.second / Angstrom;
+		fprintf(fp, "%d %.12lf %.12lf %.12lf\n", atom.first, pos[0], pos[1], pos[2]);
+	}
+	//Datagrid header (general grid including periodic images at the far faces):
+	fprintf(fp, "BEGIN_BLOCK_DATAGRID_3D\n%s\nBEGIN_DATAGRID_3D_%s\n", varName, varName);
+	fprintf(fp, "%d %d %d\n0 0 0\n", S[0]+1, S[1]+1, S[2]+1);
+	for(int k=0; k<3; k++)
+	{	vector3<> Rk = g.R.column(k) / Angstrom;
+		fprintf(fp, "%.12lf %.12lf %.12lf\n", Rk[0], Rk[1], Rk[2]);
+	}
+	//Data: one line per (i1,i2), with first index fastest:
+	const double* Xdata = X->data();
+	writeFormatted(fp, (S[1]+1)*(S[2]+1), [&](size_t iLine, std::string& buf)
+	{	int i1 = iLine % (S[1]+1), i2 = iLine / (S[1]+1);
+		size_t offset = (i2 % S[2]) + S[2]*(i1 % S[1]);
+		char numBuf[32];
+		for(int i0=0; i0<=S[0]; i0++)
+		{	int len = snprintf(numBuf, sizeof(numBuf), "%.8le ", Xdata[offset + S[2]*S[1]*(i0 % S[0])]);
+			buf.append(numBuf, len);
+		}
+		buf.push_back('\n');
+	});
+	fprintf(fp, "END_DATAGRID_3D\nEND_BLOCK_DATAGRID_3D\n");
+	fclose(fp);
+}
+
+
+//Accumulate radial histograms of grid points [iStart,iStop) about each center (lattice coordinates xCenters) into
+//hist[(iCenter*(nColumns+1) + c)*nRadial + iRadial], where c=nColumns holds the weights.
+//Each thread bins into its own histogram, which is added to the total once at the end:
+void sphericalize_sub(size_t iStart, size_t iStop, const GridInfo* gInfo, const WignerSeitz* ws,
+	const std::vector<vector3<>>* xCenters, const std::vector<const double*>* data, size_t iOffset,
+	double drInv, int nRadial, double* histTot, std::mutex* lock)
+{	int nColumns = data->size();
+	int nCenters = xCenters->size();
+	size_t histStride = nColumns+1;
+	std::vector<double> hist(nCenters*histStride*nRadial, 0.);
+	std::vector<double> val(nColumns);
+	const vector3<int>& S = gInfo->S;
+	vector3<> invS(1./S[0], 1./S[1], 1./S[2]);
+	iStart += iOffset; iStop += iOffset; //offset to this process's range
+	vector3<int> iv(0, 0, iStart % S[2]);
+	iv[1] = (iStart / S[2]) % S[1];
+	iv[0] = iStart / (S[2]*size_t(S[1]));
+	for(size_t i=iStart; i<iStop; i++)
+	{	vector3<> x(iv[0]*invS[0], iv[1]*invS[1], iv[2]*invS[2]);
+		for(int c=0; c<nColumns; c++) val[c] = (*data)[c][i];
+		for(int iCenter=0; iCenter<nCenters; iCenter++)
+		{	double rRel = (gInfo->R * ws->restrict(x - (*xCenters)[iCenter])).length() * drInv;
+			int iRadial = int(floor(rRel));
+			if(iRadial >= nRadial) continue;
+			double wRight = (rRel*rRel - iRadial*iRadial)/(2*iRadial+1);
+			double wLeft = 1.0 - wRight;
+			double* histCenter = hist.data() + iCenter*histStride*nRadial;
+			if(wLeft)
+			{	histCenter[nColumns*nRadial + iRadial] += wLeft;
+				for(int c=0; c<nColumns; c++)
+					histCenter[c*nRadial + iRadial] += wLeft * val[c];
+			}
+			if(wRight && iRadial+1<nRadial)
+			{	histCenter[nColumns*nRadial + iRadial+1] += wRight;
+				for(int c=0; c<nColumns; c++)
+					histCenter[c*nRadial + iRadial+1] += wRight * val[c];
+			}
+		}
+		//Next grid point:
+		if(++iv[2] == S[2]) { iv[2] = 0; if(++iv[1] == S[1]) { iv[1] = 0; iv[0]++; } }
+	}
+	//Accumulate over threads (need sync):
+	lock->lock();
+	for(size_t k=0; k<hist.size(); k++) histTot[k] += hist[k];
+	lock->unlock();
+}
+
+//Convert weighted sums to means and interpolate rows of zero weight (in output of sphericalize)
+void sphericalizeFinalize(std::vector< std::vector<double> >& out)
+{	int nColumns = out.size()-2;
+	int nRadial = out[0].size();
+	const std::vector<double>& weight = out[nColumns+1];
+	for(int c=0; c<nColumns; c++)
+		eblas_ddiv(nRadial, weight.data(),1, out[c+1].data(),1); //convert from sum to mean
+	//Fix rows of zero weight:
+	for(int i=0; i<nRadial; i++) if(!weight[i])
+	{	int iLeft=i-1; while(iLeft>=0 && !weight[iLeft]) iLeft--;
+		int iRight=i+1; while(iRight<nRadial && !weight[iRight]) iRight++;
+		if(iLeft>=0 && iRight<nRadial)
+		{	double wLeft = (iRight-i)*1./(iRight-iLeft);
+			for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iLeft]*wLeft + out[c+1][iRight]*(1.-wLeft);
+		}
+		else if(iLeft>=0 && iRight>=nRadial)
+		{	for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iLeft];
+		}
+		else if(iLeft<0 && iRight<nRadial)
+		{	for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iRight];
+		}
+		else assert("!All rows have zero weight!\n");
+	}
+}
+
+std::vector< std::vector< std::vector<double> > > sphericalize(const ScalarField* dataR, int nColumns,
+	const std::vector< vector3<> >& centers, double drFac, double rMax)
 {	assert(nColumns > 0); assert(dataR[0]);
 	const GridInfo& gInfo = dataR[0]->gInfo;
 	
-	//Determine the center for sphericalizaion:
-	vector3<> xCenter;
-	if(center) xCenter = inv(gInfo.R) * (*center); //to lattice coordinates
-	else xCenter = vector3<>(0.5,0.5,0.5);
+	//Centers for sphericalization in lattice coordinates:
+	std::vector< vector3<> > xCenters(centers.size());
+	for(size_t iCenter=0; iCenter<centers.size(); iCenter++)
+		xCenters[iCenter] = inv(gInfo.R) * centers[iCenter];
 
 	//Calculate the Wigner-Seitz cell:
 	logSuspend();
 	WignerSeitz ws(gInfo.R);
 	logResume();
-	double rMax = ws.circumRadius();
+	if(!rMax) rMax = ws.circumRadius();
 	
 	//Determine the diameter of the mesh parellelopiped:
 	double dr = 0.0;
@@ -93,59 +274,39 @@ std::vector< std::vector<double> > sphericalize(const ScalarField* dataR, int nC
 	dr *= (2.0*drFac);
 	double drInv = 1.0/dr;
 	
-	//Histogram:
+	//Histograms of all centers in one pass over the grid (divided over processes and threads):
 	int nRadial = int(ceil(rMax/dr));
-	std::vector< std::vector<double> > out(nColumns+2, std::vector<double>(nRadial,0.));
-	std::vector<double>& rGrid = out[0];
-	std::vector<double>& weight = out[nColumns+1];
-	for(int i=0; i<nRadial; i++)
-		rGrid[i] = i*dr;
-	std::vector<double*> data(nColumns);
+	std::vector<const double*> data(nColumns);
 	for(int c=0; c<nColumns; c++)
 		data[c] = dataR[c]->data();
 	size_t iStart, iStop;
 	TaskDivision(gInfo.nr, mpiWorld).myRange(iStart, iStop);
-	const vector3<int> &S = gInfo.S;
-	matrix3<> invS = inv(Diag(vector3<>(S)));
-	THREAD_rLoop
-	(	 //not actually threaded, but works just as well for MPI division
-		double rRel = (gInfo.R * ws.restrict(invS * iv - xCenter)).length() * drInv;
-		int iRadial = int(floor(rRel));
-		double wRight = (pow(rRel,2) - pow(iRadial,2))/(2*iRadial+1);
-		double wLeft = 1.0 - wRight;
-		if(wLeft && iRadial<nRadial)
-		{	weight[iRadial] += wLeft;
-			for(int c=0; c<nColumns; c++)
-				out[c+1][iRadial] += wLeft * data[c][i];
-		}
-		if(wRight && iRadial+1<nRadial)
-		{	weight[iRadial+1] += wRight;
-			for(int c=0; c<nColumns; c++)
-				out[c+1][iRadial+1] += wRight * data[c][i];
-		}
-	)
-	mpiWorld->allReduceData(weight, MPIUtil::ReduceSum);
-	for(int c=0; c<nColumns; c++)
-	{	mpiWorld->allReduceData(out[c+1], MPIUtil::ReduceSum);
-		eblas_ddiv(nRadial, weight.data(),1, out[c+1].data(),1); //convert from sum to mean
-	}
-	//Fix rows of zero weight:
-	for(int i=0; i<nRadial; i++) if(!weight[i])
-	{	int iLeft=i-1; while(iLeft>=0 && !weight[iLeft]) iLeft--;
-		int iRight=i+1; while(iRight<nRadial && !weight[iRight]) iRight++;
-		if(iLeft>=0 && iRight<nRadial)
-		{	double wLeft = (iRight-i)*1./(iRight-iLeft);
-			for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iLeft]*wLeft + out[c+1][iRight]*(1.-wLeft);
-		}
-		else if(iLeft>=0 && iRight>=nRadial)
-		{	for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iLeft];
-		}
-		else if(iLeft<0 && iRight<nRadial)
-		{	for(int c=0; c<nColumns; c++) out[c+1][i] = out[c+1][iRight];
+	std::vector<double> hist(centers.size()*(nColumns+1)*nRadial, 0.);
+	std::mutex lock;
+	threadLaunch(sphericalize_sub, iStop-iStart, &gInfo, &ws, &xCenters, &data, iStart, drInv, nRadial, hist.data(), &lock);
+	mpiWorld->allReduceData(hist, MPIUtil::ReduceSum);
+	
+	//Unpack per center:
+	std::vector< std::vector< std::vector<double> > > result(centers.size());
+	const double* histPtr = hist.data();
+	for(std::vector< std::vector<double> >& out: result)
+	{	out.assign(nColumns+2, std::vector<double>(nRadial,0.));
+		for(int i=0; i<nRadial; i++)
+			out[0][i] = i*dr;
+		for(int c=0; c<=nColumns; c++) //data columns followed by weight
+		{	std::copy(histPtr, histPtr+nRadial, out[c+1].begin());
+			histPtr += nRadial;
 		}
-		else assert("!All rows have zero weight!\n");
+		sphericalizeFinalize(out);
 	}
-	return out;
+	return result;
+}
+
+std::vector< std::vector<double> > sphericalize(const ScalarField* dataR, int nColumns, double drFac, vector3< double >* center)
+{	assert(nColumns > 0); assert(dataR[0]);
+	const GridInfo& gInfo = dataR[0]->gInfo;
+	vector3<> rCenter = center ? *center : gInfo.R * vector3<>(0.5,0.5,0.5); //default: center of box
+	return sphericalize(dataR, nColumns, std::vector< vector3<> >(1, rCenter), drFac)[0];
 }
 
 
@@ -165,6 +326,34 @@ void saveSphericalized(const ScalarField* dataR, int nColumns, const char* filen
 	fclose(fp);
 }
 
+//Accumulate radial histograms of |data| for reciprocal lattice points [iStart,iStop) into hist[c*nRadial + iRadial],
+//where c=nColumns holds the weights (per-thread histograms added to the total at the end, as in sphericalize_sub)
+void sphericalizeG_sub(size_t iStart, size_t iStop, const vector3<int> S, const matrix3<> GGT,
+	const std::vector<const complex*>* data, double dGinv, int nRadial, double* histTot, std::mutex* lock)
+{	int nColumns = data->size();
+	std::vector<double> hist((nColumns+1)*nRadial, 0.);
+	double* weight = hist.data() + nColumns*nRadial;
+	THREAD_halfGspaceLoop(
+		double Grel = sqrt(GGT.metric_length_squared(iG)) * dGinv;
+		int iRadial = int(floor(Grel));
+		double wRight = (Grel*Grel - iRadial*iRadial)/(2*iRadial+1);
+		double wLeft = 1.0 - wRight;
+		if(wLeft && iRadial<nRadial)
+		{	weight[iRadial] += wLeft;
+			for(int c=0; c<nColumns; c++)
+				hist[c*nRadial+iRadial] += wLeft * abs((*data)[c][i]);
+		}
+		if(wRight && iRadial+1<nRadial)
+		{	weight[iRadial+1] += wRight;
+			for(int c=0; c<nColumns; c++)
+				hist[c*nRadial+iRadial+1] += wRight * abs((*data)[c][i]);
+		}
+	)
+	lock->lock();
+	for(size_t k=0; k<hist.size(); k++) histTot[k] += hist[k];
+	lock->unlock();
+}
+
 void saveSphericalized(const ScalarFieldTilde* dataG, int nColumns, const char* filename, double dGFac)
 {	const GridInfo& g = dataG[0]->gInfo;
 	size_t iStart=0, iStop=g.nG; const vector3<int>& S=g.S; const matrix3<>& GGT=g.GGT;
@@ -184,33 +373,19 @@ void saveSphericalized(const ScalarFieldTilde* dataG, int nColumns, const char*
 	dG *= dGFac;
 	double dGinv = 1.0/dG;
 
-	//Sphericalize!
+	//Sphericalize all columns in one threaded pass over the reciprocal lattice points:
 	int nRadial = int(ceil(Gmax/dG));
-	double** mean = new double*[nColumns];
-	double* weight = new double[nRadial];
+	std::vector<const complex*> data(nColumns);
 	for(int c=0; c<nColumns; c++)
-	{	mean[c] = new double[nRadial];
-		memset(weight, 0, nRadial*sizeof(double));
-		memset(mean[c], 0, nRadial*sizeof(double));
-		complex* curData = dataG[c]->data();
-		//Loop over all the reciprocal lattice points and accumulate the above sums:
-		THREAD_halfGspaceLoop(
-			double Grel = sqrt(GGT.metric_length_squared(iG)) * dGinv;
-			int iRadial = int(floor(Grel));
-			double wRight = (pow(Grel,2) - pow(iRadial,2))/(2*iRadial+1);
-			double wLeft = 1.0 - wRight;
-			if(wLeft && iRadial<nRadial)
-			{	weight[iRadial] += wLeft;
-				mean[c][iRadial] += wLeft * abs(curData[i]);
-			}
-			if(wRight && iRadial+1<nRadial)
-			{	weight[iRadial+1] += wRight;
-				mean[c][iRadial+1] += wRight * abs(curData[i]);
-			}
-		)
-		//Calculate mean
-		for(int i=0; i<nRadial; i++) mean[c][i] /= weight[i];
-	}
+		data[c] = dataG[c]->data();
+	std::vector<double> hist((nColumns+1)*nRadial, 0.); //sums for each column, followed by weights
+	std::mutex lock;
+	threadLaunch(sphericalizeG_sub, g.nG, S, GGT, &data, dGinv, nRadial, hist.data(), &lock);
+	std::vector< std::vector<double> > mean(nColumns, std::vector<double>(nRadial));
+	const double* weight = hist.data() + nColumns*nRadial;
+	for(int c=0; c<nColumns; c++)
+		for(int i=0; i<nRadial; i++)
+			mean[c][i] = hist[c*nRadial+i] / weight[i];
 
 	//Output data:
 	FILE* fp = fopen(filename, "w");
@@ -221,9 +396,4 @@ void saveSphericalized(const ScalarFieldTilde* dataG, int nColumns, const char*
 		fprintf(fp, "\n");
 	}
 	fclose(fp);
-
-	//Cleanup:
-	for(int c=0; c<nColumns; c++) delete[] mean[c];
-	delete[] mean;
-	delete[] weight;
 }
@@ -44,6 +44,22 @@ template<typename T> void saveRawBinary(const Tptr& X, const char* filename)
 	fclose(fp);
 }
 
+//! Save the data in raw binary format to file collectively, with each process writing a slab of its (identical) copy of X
+template<typename T> void saveRawBinaryCollective(const Tptr& X, const char* filename)
+{
+#if MPI_SAFE_WRITE
+	if(mpiWorld->isHead()) saveRawBinary(X, filename);
+#else
+	typedef typename T::DataType DataType;
+	TaskDivision slabDiv(X->nElem, mpiWorld);
+	size_t iStart, iStop; slabDiv.myRange(iStart, iStop);
+	MPIUtil::File fp; mpiWorld->fopenWrite(fp, filename);
+	mpiWorld->fseek(fp, iStart*sizeof(DataType), SEEK_SET);
+	mpiWorld->fwrite(X->data()+iStart, sizeof(DataType), iStop-iStart, fp);
+	mpiWorld->fclose(fp);
+#endif
+}
+
 //! Load the data in raw binary format from stream
 template<typename T> void loadRawBinary(Tptr& X, FILE* fp)
 {	int nRead = freadLE(X->data(), sizeof(typename T::DataType), X->nElem, fp);
@@ -73,6 +89,21 @@ template<typename T> void loadRawBinary(Tptr& X, const char* filename)
 */
 void saveDX(const ScalarField&, const char* filenamePrefix);
 
+/** Save data to a VTK XML image data file (readable by ParaView, VisIt etc.) with the values in raw binary
+@param filename Output file, conventionally with extension .vti
+@param varName Name of the scalar field within the file
+The lattice vectors set the orientation of the grid axes (Direction attribute), which requires VTK 9 or newer for non-orthogonal cells.
+*/
+void saveVTI(const ScalarField&, const char* filename, const char* varName);
+
+/** Save data to an XCrySDen structure file, along with the lattice and atoms (if any).
+The (text) values are formatted in blocks on several threads and written out in large blocks.
+@param filename Output file, conventionally with extension .xsf
+@param varName Name of the datagrid within the file
+@param atoms Atomic number and Cartesian position (in bohrs) of each atom
+*/
+void saveXSF(const ScalarField&, const char* filename, const char* varName, const std::vector<std::pair<int,vector3<>>>& atoms=std::vector<std::pair<int,vector3<>>>());
+
 /** Spherically average scalar fields about an arbitrary center (with Wigner-Seitz wrapping)
 @param dataR The data to sphericalize and save
 @param nColumns Number of ScalarField's in dataR[]
@@ -82,6 +113,17 @@ void saveDX(const ScalarField&, const char* filenamePrefix);
 */
 std::vector< std::vector<double> > sphericalize(const ScalarField* dataR, int nColumns, double drFac=1.0, vector3<>* center=0);
 
+/** Spherically average scalar fields about several centers (eg. atoms) in a single pass over the grid
+@param dataR The data to sphericalize
+@param nColumns Number of ScalarField's in dataR[]
+@param centers Origins for spherical coordinates in Cartesian coordinates
+@param drFac is the spacing in radius as a fraction of the diameter of the sample box (see sphericalize above)
+@param rMax Maximum radius of the output (default = circumradius of the Wigner-Seitz cell if 0)
+@return Output of sphericalize above for each center
+*/
+std::vector< std::vector< std::vector<double> > > sphericalize(const ScalarField* dataR, int nColumns,
+	const std::vector< vector3<> >& centers, double drFac=1.0, double rMax=0.);
+
 /** Saves an array of real space data pointers to a multicolumn 1D 'sphericalized' file (for gnuplot)
 @param dataR The data to sphericalize and save
 @param nColumns Number of ScalarField's in dataR[]
@@ -0,0 +1,70 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#include <core/TaskGraph.h>
+#include <core/MPIUtil.h>
+#include <core/GpuUtil.h>
+
+int TaskGraph::add(const std::function<void()>& work, const std::vector<int>& deps, bool logs)
+{	int iTask = tasks.size();
+	for(int dep: deps) assert(dep>=0 && dep<iTask); //dependencies must be added before (so the graph is acyclic)
+	Task task;
+	task.work = work;
+	task.deps = deps;
+	task.logs = logs;
+	tasks.push_back(task);
+	return iTask;
+}
+
+bool TaskGraph::concurrent()
+{	return threadPoolNested && shouldThreadOperators() && !isGpuEnabled() && mpiWorld->nProcesses()==1;
+}
+
+void TaskGraph::run()
+{	if(!concurrent())
+	{	for(Task& task: tasks) task.work(); //serial in order of addition
+	}
+	else
+	{	std::vector<bool> done(tasks.size(), false);
+		size_t nDone = 0;
+		while(nDone < tasks.size())
+		{	//Collect tasks whose dependencies are all complete:
+			std::vector<int> ready;
+			for(size_t iTask=0; iTask<tasks.size(); iTask++)
+				if(!done[iTask])
+				{	bool isReady = true;
+					for(int dep: tasks[iTask].deps)
+						if(!done[dep]) { isReady = false; break; }
+					if(isReady) ready.push_back(iTask);
+				}
+			assert(ready.size());
+			//Execute them concurrently, except those that log, which run alone (to avoid interleaved output):
+			std::vector<int> quiet;
+			for(int iTask: ready)
+			{	if(tasks[iTask].logs) tasks[iTask].work();
+				else quiet.push_back(iTask);
+			}
+			if(quiet.size()==1) tasks[quiet[0]].work();
+			else if(quiet.size()) threadPoolRun(quiet.size(), [&](int i) { tasks[quiet[i]].work(); });
+			for(int iTask: ready) done[iTask] = true;
+			nDone += ready.size();
+		}
+	}
+}
@@ -0,0 +1,69 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#ifndef JDFTX_CORE_TASKGRAPH_H
+#define JDFTX_CORE_TASKGRAPH_H
+
+//! @addtogroup Utilities
+//! @{
+
+//! @file TaskGraph.h Dependency graph of tasks executed concurrently on the thread pool
+
+#include <core/Thread.h>
+#include <vector>
+
+/**
+@brief Lightweight task-graph runtime on the persistent thread pool
+
+Add tasks along with the tasks they depend on, then run() the graph: tasks whose
+dependencies have completed are executed concurrently on the pool (using threadPoolRun),
+in waves, until all tasks are done. Tasks must not call MPI collectives in
+process-dependent order and must not write any shared state that other concurrently
+ready tasks access: accumulate results in task-local variables and combine them after run().
+Tasks that write to the log must be added with logs = true: they always run alone,
+so that their output is not interleaved with that of other tasks.
+
+Tasks run concurrently only when that cannot compete with threading within operators
+or with MPI / GPU ordering: on CPU, in a single process, and with nested threading enabled
+(JDFTX_NESTED_THREADS, so that operators within each task still share the pool).
+Otherwise, run() executes the tasks serially in the order they were added
+(which is always a valid order since dependencies must be added first).
+*/
+class TaskGraph
+{
+public:
+	//! Add a task that may start only after the listed tasks complete, and return its index (for use in later dependencies).
+	//! Set logs = true if the task may write to the log, so that it is never run concurrently with other tasks.
+	int add(const std::function<void()>& work, const std::vector<int>& deps=std::vector<int>(), bool logs=false);
+	
+	void run(); //!< execute all tasks (see class description), and return after all are complete
+	static bool concurrent(); //!< whether run() currently executes independent tasks concurrently
+
+private:
+	struct Task
+	{	std::function<void()> work;
+		std::vector<int> deps;
+		bool logs; //!< whether task writes to the log (and must therefore run alone)
+	};
+	std::vector<Task> tasks;
+};
+
+//! @}
+#endif // JDFTX_CORE_TASKGRAPH_H
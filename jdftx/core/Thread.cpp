@@ -22,6 +22,11 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <float.h>
 #include <string.h>
 #include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
 
 #if defined(MKL_PROVIDES_BLAS) || defined(MKL_PROVIDES_FFT)
 #include <mkl.h>
@@ -39,6 +44,8 @@ int getPhysicalCores()
 }
 
 int nProcsAvailable = getPhysicalCores();
+bool threadPoolPinned = false;
+bool threadPoolNested = false;
 bool threadOperators = true;
 
 bool shouldThreadOperators()
@@ -62,3 +69,106 @@ void resumeOperatorThreading()
 	#endif
 	#endif
 }
+
+
+//------------- Persistent thread pool -------------
+
+//A set of tasks submitted by one call to threadPoolRun
+struct ThreadPoolJob
+{	const std::function<void(int)>* task;
+	int nTasks; //total number of tasks
+	int nClaimed; //number of tasks claimed by some thread so far
+	int nDone; //number of tasks completed
+	std::vector<bool> claimed; //which tasks have been claimed (only used for affine claiming when threadPoolPinned)
+};
+
+//Persistent pool of worker threads. Note that this is never destroyed: the workers
+//idle on the condition variable till process exit, which may be initiated from any thread.
+class ThreadPool
+{
+public:
+	void run(int nTasks, const std::function<void(int)>& task)
+	{	ThreadPoolJob job = { &task, nTasks, 0, 0 };
+		if(threadPoolPinned) job.claimed.assign(nTasks, false);
+		std::unique_lock<std::mutex> lock(m);
+		grow(std::min(nTasks, nProcsAvailable) - 1);
+		jobs.push_back(&job);
+		cv.notify_all();
+		//Help execute tasks (starting with own) until the job completes:
+		while(job.nDone < job.nTasks)
+		{	ThreadPoolJob* jobNext = (job.nClaimed < job.nTasks) ? &job : (threadPoolNested ? claimable() : 0);
+			if(jobNext) execute(jobNext, lock, 0);
+			else cv.wait(lock);
+		}
+	}
+	
+private:
+	std::vector<std::thread> workers;
+	std::deque<ThreadPoolJob*> jobs; //jobs with unclaimed tasks, in order of submission
+	std::mutex m; //guards all of the above as well as the task counts in each job
+	std::condition_variable cv; //signalled on submission and completion of jobs
+	
+	//Grow pool to at least nWorkers threads (must be called with lock held)
+	void grow(int nWorkers)
+	{	while(int(workers.size()) < nWorkers)
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this, int(workers.size())));
+	}
+	
+	//First job with an unclaimed task, if any (must be called with lock held)
+	ThreadPoolJob* claimable()
+	{	return jobs.size() ? jobs.front() : 0;
+	}
+	
+	//Claim and execute one task of job, releasing the lock during execution
+	//When claiming affinely, task iPreferred is claimed if available, else the first unclaimed one
+	void execute(ThreadPoolJob* job, std::unique_lock<std::mutex>& lock, int iPreferred)
+	{	int iTask = job->nClaimed++;
+		if(job->claimed.size())
+		{	iTask = iPreferred;
+			if(iTask >= job->nTasks || job->claimed[iTask])
+				iTask = std::find(job->claimed.begin(), job->claimed.end(), false) - job->claimed.begin();
+			job->claimed[iTask] = true;
+		}
+		if(job->nClaimed == job->nTasks) //all tasks claimed: remove from pending list
+			for(auto iter=jobs.begin(); iter!=jobs.end(); iter++)
+				if(*iter == job) { jobs.erase(iter); break; }
+		const std::function<void(int)>& task = *(job->task);
+		lock.unlock();
+		task(iTask);
+		lock.lock();
+		job->nDone++; //job may be destroyed by its submitter once this is complete and lock is released
+		if(job->nDone == job->nTasks) cv.notify_all();
+	}
+	
+	void workerLoop(int iWorker)
+	{	if(threadPoolPinned) pinCurrentThread(iWorker+1); //offset by one to leave the first core to the main thread
+		std::unique_lock<std::mutex> lock(m);
+		while(true)
+		{	ThreadPoolJob* job = claimable();
+			if(job) execute(job, lock, iWorker+1);
+			else cv.wait(lock);
+		}
+	}
+};
+
+void pinCurrentThread(int iCore)
+{	//Cores available to the process, captured on first call (before any thread, including main, is pinned):
+	static cpu_set_t cpuSet;
+	static bool cpuSetValid = !sched_getaffinity(0, sizeof(cpu_set_t), &cpuSet);
+	if(!cpuSetValid) return;
+	int nCores = CPU_COUNT(&cpuSet);
+	if(!nCores) return;
+	iCore = iCore % nCores;
+	for(int cpu=0; cpu<CPU_SETSIZE; cpu++)
+		if(CPU_ISSET(cpu, &cpuSet) && !(iCore--))
+		{	cpu_set_t cpuSetPin; CPU_ZERO(&cpuSetPin); CPU_SET(cpu, &cpuSetPin);
+			pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSetPin);
+			return;
+		}
+}
+
+void threadPoolRun(int nTasks, const std::function<void(int)>& task)
+{	static ThreadPool* pool = new ThreadPool;
+	if(nTasks <= 0) return;
+	pool->run(nTasks, task);
+}
@@ -28,9 +28,19 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Util.h>
 #include <thread>
 #include <mutex>
+#include <functional>
+#include <algorithm>
 #include <unistd.h>
 
 extern int nProcsAvailable; //!< number of available processors (initialized to number of online processors, can be overriden)
+extern bool threadPoolPinned; //!< whether persistent pool threads are pinned to cores (set by environment variable JDFTX_THREAD_PIN)
+extern bool threadPoolNested; //!< whether operators may use the pool from within threaded sections (set by environment variable JDFTX_NESTED_THREADS)
+
+//! Pin calling thread to the iCore'th processor (cyclically) of those available to this process.
+//! When threadPoolPinned, the main thread is pinned to core 0 and pool worker i to core i+1,
+//! and task i of each threadLaunch is preferentially run on core i, so that data partitioned
+//! the same way in successive threaded loops stays local to the same core (and NUMA node).
+void pinCurrentThread(int iCore);
 
 /**
 Operators should run multithreaded if this returns true,
@@ -47,6 +57,21 @@ bool shouldThreadOperators();
 void suspendOperatorThreading(); //!< call from multi-threaded top-level code to disable threading within operators called from a parallel section
 void resumeOperatorThreading(); //!< call after a parallel section in top-level code to resume threading within subsequent operator calls
 
+/**
+@brief Execute tasks on the persistent thread pool
+
+Invokes task(iTask) for each 0 <= iTask < nTasks using the persistent pool of worker threads,
+which are created on first use (and grown as needed up to nProcsAvailable) instead of being
+launched and joined for every threaded section. The calling thread participates in executing
+the tasks, and idle threads (including callers waiting on their own tasks to complete)
+claim tasks from any pending job, so that nested submissions never deadlock.
+Returns only after all nTasks have completed.
+
+@param nTasks Number of tasks to execute
+@param task Function invoked once per task index
+*/
+void threadPoolRun(int nTasks, const std::function<void(int)>& task);
+
 
 /**
 @brief A simple utility for running muliple threads
@@ -75,6 +100,24 @@ with nThreads = number of online processors.
 template<typename Callable,typename ... Args>
 void threadLaunch(Callable* func, size_t nJobs, Args... args);
 
+/**
+@brief Thread launcher with chunked dynamic scheduling
+
+Same as threadLaunch(int nThreads, Callable* func, size_t nJobs, Args... args), except that the
+nJobs jobs are split into chunks of chunkSize, which are claimed dynamically by the threads.
+func(iMin, iMax, args) is therefore invoked once per chunk rather than once per thread,
+which balances the load when the cost per job is uneven. Only use this when the jobs
+are fully independent (func must not rely on the chunk boundaries or thread count).
+
+@param nThreads Maximum number of threads to use (if <=0, as many as processors on system)
+@param func The function / object with operator() to invoke in a multithreaded fashion
+@param nJobs The number of jobs to be split between the various func calls (must be > 0)
+@param chunkSize Number of jobs per chunk (if 0, chosen automatically to yield a few chunks per thread)
+@param args Arguments to pass to func
+*/
+template<typename Callable,typename ... Args>
+void threadLaunchDynamic(int nThreads, Callable* func, size_t nJobs, size_t chunkSize, Args... args);
+
 
 /**
 @brief A parallelized loop
@@ -117,20 +160,18 @@ double threadedAccumulate(Callable* func, size_t nIter, Args... args);
 template<typename Callable,typename ... Args>
 void threadLaunch(int nThreads, Callable* func, size_t nJobs, Args... args)
 {	if(nThreads<=0) nThreads = shouldThreadOperators() ? nProcsAvailable : 1;
-	if(nThreads>1) suspendOperatorThreading(); //Prevent func and anything it calls from launching nested threads
-	std::thread** tArr = new std::thread*[nThreads-1];
-	for(int t=0; t<nThreads; t++)
+	if(nThreads==1)
+	{	(*func)(0, (nJobs>0 ? nJobs : 1), args...);
+		return;
+	}
+	bool guard = !threadPoolNested;
+	if(guard) suspendOperatorThreading(); //Prevent func and anything it calls from launching nested threads
+	threadPoolRun(nThreads, [&](int t)
 	{	size_t i1 = (nJobs>0 ? (  t   * nJobs)/nThreads : t);
 		size_t i2 = (nJobs>0 ? ((t+1) * nJobs)/nThreads : nThreads);
-		if(t<nThreads-1) tArr[t] = new std::thread(func, i1, i2, args...);
-		else (*func)(i1, i2, args...);
-	}
-	for(int t=0; t<nThreads-1; t++)
-	{	tArr[t]->join();
-		delete tArr[t];
-	}
-	delete[] tArr;
-	if(nThreads>1) resumeOperatorThreading(); //End nested threading guard section
+		(*func)(i1, i2, args...);
+	});
+	if(guard) resumeOperatorThreading(); //End nested threading guard section
 }
 
 template<typename Callable,typename ... Args>
@@ -138,6 +179,26 @@ void threadLaunch(Callable* func, size_t nJobs, Args... args)
 {	threadLaunch(0, func, nJobs, args...);
 }
 
+template<typename Callable,typename ... Args>
+void threadLaunchDynamic(int nThreads, Callable* func, size_t nJobs, size_t chunkSize, Args... args)
+{	assert(nJobs > 0);
+	if(nThreads<=0) nThreads = shouldThreadOperators() ? nProcsAvailable : 1;
+	if(nThreads==1)
+	{	(*func)(0, nJobs, args...);
+		return;
+	}
+	if(!chunkSize) chunkSize = std::max(size_t(1), nJobs/(4*nThreads)); //a few chunks per thread by default
+	int nChunks = (nJobs + chunkSize - 1) / chunkSize;
+	bool guard = !threadPoolNested;
+	if(guard) suspendOperatorThreading(); //Prevent func and anything it calls from launching nested threads
+	threadPoolRun(nChunks, [&](int iChunk)
+	{	size_t i1 = iChunk * chunkSize;
+		size_t i2 = std::min(i1 + chunkSize, nJobs);
+		(*func)(i1, i2, args...);
+	});
+	if(guard) resumeOperatorThreading(); //End nested threading guard section
+}
+
 
 template<typename Callable,typename ... Args>
 void threadedLoop_sub(size_t iMin, size_t iMax, Callable* func, Args... args)
@@ -35,7 +35,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <config.h> //This file is generated during build based on Git hash etc.
 
 InitParams::InitParams(const char* description, class Everything* e)
-: description(description), e(e), packageName(0), versionString(0), versionHash(0)
+: description(description), e(e), nEnsembleGroups(0), packageName(0), versionString(0), versionHash(0)
 {
 }
 
@@ -70,9 +70,10 @@ void printUsage(const char *name, const InitParams& ip)
 	logPrintf("\t-t --template           print an input file template\n");
 	logPrintf("\t-m --mpi-debug-log      write output from secondary MPI processes to jdftx.<proc>.mpiDebugLog (instead of /dev/null)\n");
 	logPrintf("\t-n --dry-run            quit after initialization (to verify commands and other input files)\n");
-	logPrintf("\t-c --cores              number of cores per process (ignored when launched using SLURM)\n");
+	logPrintf("\t-c --cores <n>[,pin]    number of cores per process (ignored when launched using SLURM); pin => pin threads to cores\n");
 	logPrintf("\t-G --nGroups            number of MPI process groups (default or 0 => each process in own group of size 1)\n");
 	logPrintf("\t-s --skip-defaults      skip printing status of default commands issued automatically.\n");
+	logPrintf("\t-e --ensemble <nGroups> run each input file listed in the input file in one of nGroups process groups (jdftx only)\n");
 	logPrintf("\n");
 }
 
@@ -152,6 +153,9 @@ MPIUtil* mpiGroupHead = 0;
 bool mpiDebugLog = false;
 bool manualThreadCount = false;
 size_t mempoolSize = 0;
+size_t memcacheSize = 0;
+bool memFirstTouch = false;
+bool memHugePages = false;
 static double startTime_us; //Time at which system was initialized in microseconds
 const char* argv0 = 0;
 uint32_t crc32(const string& s); //CRC32 checksum for a string (implemented below)
@@ -273,6 +277,21 @@ void initSystem(int argc, char** argv, const InitParams* ip)
 	}
 	resumeOperatorThreading(); //if necessary, this informs MKL of the thread count
 	
+	//Thread pool options:
+	const char* envThreadPin = getenv("JDFTX_THREAD_PIN");
+	if(envThreadPin && atoi(envThreadPin)) threadPoolPinned = true;
+	if(threadPoolPinned)
+	{	const char* envFirstTouch = getenv("JDFTX_FIRST_TOUCH");
+		memFirstTouch = !(envFirstTouch && !atoi(envFirstTouch)); //on by default with pinned threads
+		pinCurrentThread(0);
+		logPrintf("Threads pinned to cores%s.\n", memFirstTouch ? " with first-touch placement of large buffers" : "");
+	}
+	const char* envNestedThreads = getenv("JDFTX_NESTED_THREADS");
+	if(envNestedThreads && atoi(envNestedThreads))
+	{	threadPoolNested = true;
+		logPrintf("Nested threading enabled: operators called from threaded sections will share the thread pool.\n");
+	}
+	
 	//Print total resources used by run:
 	{	int nProcsTot = nProcsAvailable; mpiWorld->allReduce(nProcsTot, MPIUtil::ReduceSum);
 		double nGPUsTot = nGPUs; mpiWorld->allReduce(nGPUsTot, MPIUtil::ReduceSum);
@@ -292,19 +311,50 @@ void initSystem(int argc, char** argv, const InitParams* ip)
 			logPrintf("Could not determine memory pool size from JDFTX_MEMPOOL_SIZE=\"%s\".\n", mempoolSizeStr);
 	}
 	
+	//Huge pages:
+	const char* envHugePages = getenv("JDFTX_HUGEPAGES");
+	if(envHugePages && atoi(envHugePages))
+	{	memHugePages = true;
+		logPrintf("Transparent huge pages requested for large host buffers.\n");
+	}
+	
+	//Memory cache size:
+	const char* memcacheSizeStr = getenv("JDFTX_MEMCACHE_SIZE");
+	if(memcacheSizeStr)
+	{	int memcacheSizeMB;
+		if(sscanf(memcacheSizeStr, "%d", &memcacheSizeMB)==1 && memcacheSizeMB>=0)
+		{	memcacheSize = ((size_t)memcacheSizeMB) << 20; //convert to bytes
+			logPrintf("Memory cache size: %d MB (per process and memory space)\n", memcacheSizeMB);
+		}
+		else
+			logPrintf("Could not determine memory cache size from JDFTX_MEMCACHE_SIZE=\"%s\".\n", memcacheSizeStr);
+	}
+	
 	//Add citations to the code for all calculations:
 	Citations::add("Software package",
 		"R. Sundararaman, K. Letchworth-Weaver, K.A. Schwarz, D. Gunceler, Y. Ozhabes and T.A. Arias, "
 		"'JDFTx: software for joint density-functional theory', SoftwareX 6, 278 (2017)");
 }
 
+void setInputBasename(const string& inputFilename)
+{	inputBasename = inputFilename;
+	//Remove extension:
+	size_t lastDot = inputBasename.find_last_of(".");
+	if(lastDot != string::npos)
+		inputBasename = inputBasename.substr(0, lastDot); //Remove extension
+	//Remove leading path:
+	size_t lastSlash = inputBasename.find_last_of("\\/");
+	if(lastSlash != string::npos)
+		inputBasename = inputBasename.substr(lastSlash+1);
+}
+
 void initSystemCmdline(int argc, char** argv, InitParams& ip)
 {
 	mpiWorld = new MPIUtil(argc, argv);
 	
 	//Parse command line:
 	string logFilename; bool appendOutput=true;
-	ip.dryRun=false; ip.printDefaults=true;
+	ip.dryRun=false; ip.printDefaults=true; ip.nEnsembleGroups=0;
 	option long_options[] =
 		{	{"help", no_argument, 0, 'h'},
 			{"version", no_argument, 0, 'v'},
@@ -318,10 +368,11 @@ void initSystemCmdline(int argc, char** argv, InitParams& ip)
 			{"nGroups", required_argument, 0, 'G'},
 			{"skip-defaults", no_argument, 0, 's'},
 			{"write-manual", required_argument, 0, 'w'},
+			{"ensemble", required_argument, 0, 'e'},
 			{0, 0, 0, 0}
 		};
 	while (1)
-	{	int c = getopt_long(argc, argv, "hvi:o:dtmnc:G:sw:", long_options, 0);
+	{	int c = getopt_long(argc, argv, "hvi:o:dtmnc:G:sw:e:", long_options, 0);
 		if (c == -1) break; //end of options
 		#define RUN_HEAD(code) if(mpiWorld->isHead()) { code } delete mpiWorld;
 		switch (c)
@@ -339,6 +390,8 @@ void initSystemCmdline(int argc, char** argv, InitParams& ip)
 				{	nProcsAvailable=nCores;
 					manualThreadCount =true;
 				}
+				const char* comma = strchr(optarg, ',');
+				if(comma && !strcasecmp(comma+1, "pin")) threadPoolPinned = true;
 				break;
 			}
 			case 'G':
@@ -352,6 +405,16 @@ void initSystemCmdline(int argc, char** argv, InitParams& ip)
 				break;
 			}
 			case 's': ip.printDefaults=false; break;
+			case 'e':
+			{	if(!(sscanf(optarg, "%d", &ip.nEnsembleGroups)==1 && ip.nEnsembleGroups>0))
+				{	RUN_HEAD(
+						printf("\nOption -e (--ensemble) must be a positive integer.\n");
+						printUsage(argv[0], ip);
+					)
+					exit(1);
+				}
+				break;
+			}
 			case 'w': RUN_HEAD( if(ip.e) writeCommandManual(*ip.e, optarg); ) exit(0);
 			default: RUN_HEAD( printUsage(argv[0], ip); ) exit(1);
 		}
@@ -369,16 +432,7 @@ void initSystemCmdline(int argc, char** argv, InitParams& ip)
 	
 	//Set input base name if necessary:
 	if(ip.inputFilename.length())
-	{	inputBasename = ip.inputFilename;
-		//Remove extension:
-		size_t lastDot = inputBasename.find_last_of(".");
-		if(lastDot != string::npos)
-			inputBasename = inputBasename.substr(0, lastDot); //Remove extension
-		//Remove leading path:
-		size_t lastSlash = inputBasename.find_last_of("\\/");
-		if(lastSlash != string::npos)
-			inputBasename = inputBasename.substr(lastSlash+1);
-	}
+		setInputBasename(ip.inputFilename);
 	
 	//Print banners, setup threads, GPUs and signal handlers
 	initSystem(argc, argv, &ip);
@@ -418,8 +472,11 @@ void finalizeSystem(bool successful)
 	#ifdef ENABLE_PROFILING
 	stopWatchManager();
 	logPrintf("\n");
-	ManagedMemoryBase::reportUsage();
 	#endif
+	Profiler::finish(); //hierarchical profile (if active)
+	EventLog::finish(); //machine-readable event stream (if active)
+	MemoryMonitor::finish(); //memory timeline and allocation sites (if active)
+	ManagedMemoryBase::reportUsage(); //memory usage (if profiling) and cache statistics (if enabled)
 	
 	if(!mpiWorld->isHead())
 	{	if(mpiDebugLog) fclose(globalLog);
@@ -451,21 +508,32 @@ double clock_sec()
 
 
 #ifdef ENABLE_PROFILING
-StopWatch::StopWatch(string name) : Ttot(0), TsqTot(0), nT(0), name(name) { stopWatchManager(this, &name); }
+//Start times of the StopWatches currently running on the calling thread:
+static std::map<const StopWatch*,double>& stopWatchStartTimes()
+{	static thread_local std::map<const StopWatch*,double> tStart;
+	return tStart;
+}
+static std::mutex stopWatchLock; //guards statistics of all StopWatches
+
+StopWatch::StopWatch(string name) : profileId(Profiler::registerName(name)), Ttot(0), TsqTot(0), nT(0), name(name) { stopWatchManager(this, &name); }
 void StopWatch::start()
 {
 	#ifdef GPU_ENABLED
 	cudaDeviceSynchronize();
 	#endif
-	tPrev = clock_us();
+	stopWatchStartTimes()[this] = clock_us();
+	if(Profiler::active) Profiler::begin(profileId);
 }
 void StopWatch::stop()
 {
 	#ifdef GPU_ENABLED
 	cudaDeviceSynchronize();
 	#endif
-	double T = clock_us()-tPrev;
-	Ttot+=T; TsqTot+=T*T; nT++;
+	double T = clock_us() - stopWatchStartTimes()[this];
+	{	std::lock_guard<std::mutex> lock(stopWatchLock);
+		Ttot+=T; TsqTot+=T*T; nT++;
+	}
+	if(Profiler::active) Profiler::end(profileId);
 }
 void StopWatch::print() const
 {	if(nT)
@@ -475,6 +543,8 @@ void StopWatch::print() const
 			name.c_str(), meanT*1e-6, sigmaT*1e-6, nT, Ttot*1e-6);
 	}
 }
+#else
+StopWatch::StopWatch(string name) : profileId(Profiler::registerName(name)) {}
 #endif //ENABLE_PROFILING
 
 
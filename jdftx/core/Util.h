@@ -45,6 +45,9 @@ extern MPIUtil* mpiGroup; //!< MPI within current group of processes
 extern MPIUtil* mpiGroupHead; //!< MPI across equal ranks in each group
 extern bool mpiDebugLog; //!< If true, all processes output to seperate debug log files, otherwise only head process outputs (set before calling initSystem())
 extern size_t mempoolSize; //!< If non-zero, size of memory pool managed internally by JDFTx
+extern size_t memcacheSize; //!< If non-zero, maximum total size of freed blocks cached by category and size for reuse by ManagedMemory
+extern bool memFirstTouch; //!< If true, fresh large host allocations are first touched by the threads (and with the partition) of threadLaunch
+extern bool memHugePages; //!< If true, fresh large host allocations are advised to be backed by transparent huge pages
 
 //! Parameters used for common initialization functions
 struct InitParams
@@ -56,6 +59,7 @@ struct InitParams
 	string inputFilename; //!< name of input file
 	bool dryRun; //!< whether this is a dry run
 	bool printDefaults; //!< whether to print default commands
+	int nEnsembleGroups; //!< if non-zero, inputFilename lists input files to run concurrently in these many process groups (jdftx executable only)
 	//Optional parameters useful when calling from outside JDFTx:
 	const char* packageName; //!< package name dispalyed in banner
 	const char* versionString; //!< version string displayed in banner
@@ -64,6 +68,7 @@ struct InitParams
 void printVersionBanner(const InitParams* ip=0); //!< Print package name, version, revision etc. to log
 void initSystem(int argc, char** argv, const InitParams* ip=0); //!< Init MPI (if not already done), print banner, set up threads (play nice with job schedulers), GPU and signal handlers
 void initSystemCmdline(int argc, char** argv, InitParams& ip); //!< initSystem along with commandline options
+void setInputBasename(const string& inputFilename); //!< set inputBasename from inputFilename (without path and extension)
 void finalizeSystem(bool successful=true); //!< Clean-up corresponding to initSystem(), final messages (depending on successful) and clean-up MPI
 
 //----------------- Profiling --------------------------
@@ -84,32 +89,88 @@ Code must be self-contained as a scope, as it will be surrounded by { }, and sho
 	fprintf(fp, "%s took %.2le s.\n", title, runTime*1e-6); \
 }
 
+/** @brief Runtime hierarchical profiler, independent of the ENABLE_PROFILING build option.
+When active (see command profile-output), every StopWatch and ProfileRegion records a nested
+region per thread, which is written as a Chrome trace (JSON, viewable in chrome://tracing or Perfetto)
+along with a call-tree summary in the log. When inactive, the overhead is a single flag check per region.
+Regions opened as phases using ProfilePhase (setup, density, Hamiltonian, subspace linear algebra, fluid, dump) additionally
+sample CPU package (RAPL) and GPU (NVML) energy counters at their boundaries, when these are readable,
+and report the energy consumed within each phase along with its time.
+*/
+namespace Profiler
+{	extern bool active; //!< whether regions are being recorded (use start() to set)
+	int registerName(const string& name); //!< unique id for a region name (trailing whitespace and ':' trimmed), thread-safe
+	void begin(int id, bool phase=false); //!< open region id on the calling thread (sampling energy counters at its boundaries if phase)
+	void end(int id); //!< close region id on the calling thread
+	void addBytes(size_t nBytes); //!< attribute memory traffic to the innermost open region of the calling thread
+	void start(string filename); //!< start recording (".<rank>" appended to filename when running on several processes)
+	void finish(); //!< stop recording, write the trace file and log the call-tree summary (called by finalizeSystem)
+}
+
+/** @brief Machine-readable event stream (see command event-log).
+When active, the head process writes one JSON object per line (NDJSON) for each iteration report
+of Minimizable::minimize, Pulay::minimize and IonicDynamics, containing the step type, line prefix,
+iteration number, energies and residuals, wall time and peak resident memory of the process.
+*/
+namespace EventLog
+{	extern bool active; //!< whether events are being written (use start() to set)
+	void start(string filename); //!< start writing events to filename (from head process only)
+	void finish(); //!< close the event stream (called by finalizeSystem)
+	
+	//! One event, built up using add() and written on destruction (if active)
+	class Event
+	{	ostringstream oss;
+	public:
+		Event(const char* type, const char* prefix=0); //!< event of specified type, with optional line prefix of corresponding log output
+		~Event();
+		Event& add(const char* key, double value); //!< add a floating-point field (non-finite values written as null)
+		Event& add(const char* key, int value); //!< add an integer field
+		Event& add(const char* key, const char* value); //!< add a string field
+	};
+}
+
+//! Scoped region for the runtime profiler alone (without the PROFILER timing statistics of StopWatch)
+class ProfileRegion
+{	int id; //!< region id (or -1 if profiler inactive at construction)
+public:
+	ProfileRegion(int id, size_t nBytes=0) : id(Profiler::active ? id : -1) { if(this->id>=0) { Profiler::begin(id); if(nBytes) Profiler::addBytes(nBytes); } }
+	ProfileRegion(const string& name) : id(Profiler::active ? Profiler::registerName(name) : -1) { if(id>=0) Profiler::begin(id); }
+	~ProfileRegion() { if(id>=0) Profiler::end(id); }
+};
+
+//! Profiled region that is also a phase for energy telemetry, eg. static const int id = Profiler::registerName("Hamiltonian"); ProfilePhase phase(id);
+class ProfilePhase
+{	int id; //!< region id (or -1 if profiler inactive at construction)
+public:
+	ProfilePhase(int id) : id(Profiler::active ? id : -1) { if(this->id>=0) Profiler::begin(id, true); }
+	~ProfilePhase() { if(id>=0) Profiler::end(id); }
+};
+
 //! Quick drop-in profiler for any function. Usage:
 //! * Create a static object of this class in the function
 //! * Call start and stop before and after the section to be timed
-//! * Timing statistics of the code block will be printed on exit
-#ifdef ENABLE_PROFILING
+//! * Timing statistics of the code block will be printed on exit (if built with ENABLE_PROFILING)
+//! * The section is recorded by the runtime profiler (if active) in all builds
+//! * Sections may be timed concurrently from several threads (eg. by TaskGraph tasks)
 class StopWatch
 {
 public:
 	StopWatch(string name);
+	#ifdef ENABLE_PROFILING
 	void start();
 	void stop();
 	void print() const;
+	#else
+	void start() { if(Profiler::active) Profiler::begin(profileId); }
+	void stop() { if(Profiler::active) Profiler::end(profileId); }
+	#endif
 private:
-	double tPrev, Ttot, TsqTot; int nT;
+	int profileId; //!< region id in runtime profiler
+	#ifdef ENABLE_PROFILING
+	double Ttot, TsqTot; int nT; //!< statistics, updated from all threads (start times are per thread)
 	string name;
+	#endif
 };
-#else //ENABLE_PROFILING
-//Version which does no profiling for release versions
-class StopWatch
-{
-public:
-	StopWatch(string name) {}
-	void start() {}
-	void stop() {}
-};
-#endif //ENABLE_PROFILING
 
 
 
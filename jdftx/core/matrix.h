@@ -95,6 +95,7 @@ public:
 	void print_real(FILE* fp, const char* fmt="%lg\t") const; //!< print (ascii) real parts to stream
 	
 	void diagonalize(matrix& evecs, diagMatrix& eigs) const; //!< diagonalize a hermitian matrix
+	void diagonalize(matrix& evecs, diagMatrix& eigs, const MPIUtil* mpiUtil, int root) const; //!< diagonalize a hermitian matrix (on root) collectively over mpiUtil (ScaLAPACK if available), with results on root alone
 	void diagonalize(matrix& levecs, std::vector<complex>& eigs, matrix& revecs) const; //!< diagonalize an arbitrary matrix
 	void svd(matrix& U, diagMatrix& S, matrix& Vdag) const; //!< singular value decomposition (for dimensions of this: MxN, on output U: MxM, S: min(M,N), Vdag: NxN)
 	
@@ -197,6 +198,11 @@ diagMatrix diagDot(const matrix& X, const matrix& Y); //!< Compute diag(dagger(X
 
 //------- Nonlinear matrix functions and their gradients ---------
 
+//! Compute the inverse of the upper-triangular Cholesky factor R of a hermitian positive-definite A = dagger(R) * R,
+//! so that dagger(result) * A * result = 1 (an orthonormalizing transformation like invsqrt(A), but not symmetric).
+//! If isSingular is provided, function will set it to true and return rather than stack-tracing if A is not positive-definite.
+matrix invCholesky(const matrix& A, bool* isSingular=0);
+
 //! Compute inverse of an arbitrary matrix A (via LU decomposition)
 matrix inv(const matrix& A); //!< inverse of matrix
 diagMatrix inv(const diagMatrix& A); //!< inverse of diagonal matrix
@@ -233,6 +239,24 @@ matrix sqrt_grad(const matrix& grad_sqrtA, const matrix& Aevecs, const diagMatri
 //! Return gradient w.r.t A given gradient w.r.t cis(A) and A's eigensystem
 matrix cis_grad(const matrix& grad_cisA, const matrix& Aevecs, const diagMatrix& Aeigs);
 
+//------------ Batched operations on several small matrices --------------
+//These process the non-null entries of vectors of matrices (such as per-state subspace matrices) together:
+//matrices of equal dimensions are handled in one batched cuSolver / cuBLAS call on GPUs (where cuSolver
+//is used for small matrices up to 32 x 32), and threaded over the batch with LAPACK on CPUs.
+//Entries of the outputs corresponding to null inputs are left unchanged.
+
+//! Diagonalize hermitian matrices A[i], with results as in matrix::diagonalize
+void diagonalize(const std::vector<matrix>& A, std::vector<matrix>& evecs, std::vector<diagMatrix>& eigs);
+
+//! Singular value decompositions of matrices A[i], with results as in matrix::svd
+void svd(const std::vector<matrix>& A, std::vector<matrix>& U, std::vector<diagMatrix>& S, std::vector<matrix>& Vdag);
+
+//! Products op(A[i]) * op(B[i]) (null if either is null)
+std::vector<matrix> multiply(const std::vector<matrix>& A, const std::vector<matrix>& B, CBLAS_TRANSPOSE opA=CblasNoTrans, CBLAS_TRANSPOSE opB=CblasNoTrans);
+
+//! Batched version of invsqrt(const matrix&,matrix*,diagMatrix*,bool*)
+std::vector<matrix> invsqrt(const std::vector<matrix>& A, std::vector<matrix>* Aevecs=0, std::vector<diagMatrix>* Aeigs=0, bool* isSingular=0);
+
 
 //------------ Misc matrix functions --------------
 complex trace(const matrix &m); //!< trace of matrix
@@ -19,11 +19,13 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/matrix.h>
 #include <core/GpuUtil.h>
+#include <core/Thread.h>
+#include <map>
 
 #if defined(GPU_ENABLED) and defined(CUSOLVER_ENABLED)
 	#define USE_CUSOLVER
 	#define NcutCuSolver 32  //minimum matrix dimension for which to use CuSolver (CPU LAPACK faster for small matrices)
-	#include <cusolverDn.h>
+	#include <core/GpuBackend.h>
 #endif
 
 //Lapack forward declarations
@@ -44,8 +46,27 @@ extern "C"
 	void zgetrf_(int* M, int* N, complex* A, int* LDA, int* IPIV, int* INFO);
 	void zgetri_(int* N, complex* A, int* LDA, int* IPIV, complex* WORK, int* LWORK, int* INFO);
 	void zposv_(char* UPLO, int* N, int* NRHS, complex* A, int* LDA, complex* B, int* LDB, int* INFO);
+	void zpotrf_(char* UPLO, int* N, complex* A, int* LDA, int* INFO);
+	void ztrtri_(char* UPLO, char* DIAG, int* N, complex* A, int* LDA, int* INFO);
 }
 
+#ifdef SCALAPACK_ENABLED
+//ScaLAPACK / BLACS forward declarations
+extern "C"
+{	int Csys2blacs_handle(MPI_Comm comm);
+	void blacs_gridinit_(const int* icontxt, const char* layout, const int* nprow, const int* npcol);
+	void blacs_gridinfo_(const int* icontxt, int* nprow, int* npcol, int* myprow, int* mypcol);
+	void blacs_gridexit_(const int* icontxt);
+	void descinit_(int* desc, const int* m, const int* n, const int* mb, const int* nb,
+		const int* irsrc, const int* icsrc, const int* ictxt, const int* lld, int* info);
+	int numroc_(const int* n, const int* nb, const int* iproc, const int* srcproc, const int* nprocs);
+	void pzheevd_(const char* jobz, const char* uplo, const int* n, complex* a, const int* ia, const int* ja, const int* desca,
+		double* w, complex* z, const int* iz, const int* jz, const int* descz,
+		complex* work, const int* lwork, double* rwork, const int* lrwork, int* iwork, const int* liwork, int* info);
+}
+#define NcutScaLAPACK 256 //minimum matrix dimension for which to use distributed diagonalization
+#endif
+
 //------------------------- Eigensystem -----------------------------------
 
 #ifdef GPU_ENABLED
@@ -53,6 +74,40 @@ double relativeHermiticityError_gpu(int N, const complex* data); //implemented i
 #endif
 double relativeHermiticityError(int N, const complex* data); //implemented in matrixOperators.cpp
 
+//CPU LAPACK diagonalization of hermitian N x N matrix A (used by matrix::diagonalize and the batched version)
+static void diagonalizeLAPACK(const matrix& A, matrix& evecs, diagMatrix& eigs)
+{	int N = A.nRows();
+	char jobz = 'V'; //compute eigenvectors and eigenvalues
+	char range = 'A'; //compute all eigenvalues
+	char uplo = 'U'; //use upper-triangular part
+	matrix Acopy = A; //copy input matrix (zheevr destroys input matrix)
+	double eigMin = 0., eigMax = 0.; //eigenvalue range (not used for range-type 'A')
+	int indexMin = 0, indexMax = 0; //eignevalue index range (not used for range-type 'A')
+	double absTol = 0.; int nEigsFound;
+	eigs.resize(N);
+	evecs.init(N, N);
+	std::vector<int> iSuppz(2*N);
+	int lwork = (64+1)*N; std::vector<complex> work(lwork); //Magic number 64 obtained by running ILAENV as suggested in doc of zheevr (and taking the max over all N)
+	int lrwork = 24*N; std::vector<double> rwork(lrwork); //from doc of zheevr
+	int liwork = 10*N; std::vector<int> iwork(liwork); //from doc of zheevr
+	int info=0;
+	zheevr_(&jobz, &range, &uplo, &N, Acopy.data(), &N,
+		&eigMin, &eigMax, &indexMin, &indexMax, &absTol, &nEigsFound,
+		eigs.data(), evecs.data(), &N, iSuppz.data(), work.data(), &lwork,
+		rwork.data(), &lrwork, iwork.data(), &liwork, &info);
+	if(info<0) { logPrintf("Argument# %d to LAPACK eigenvalue routine ZHEEVR is invalid.\n", -info); stackTraceExit(1); }
+	if(info>0) { logPrintf("Error code %d in LAPACK eigenvalue routine ZHEEVR.\n", info); stackTraceExit(1); }
+}
+
+//Check hermiticity of N x N matrix A before diagonalization
+static void checkHermiticity(const matrix& A)
+{	const double hermErr = callPref(relativeHermiticityError)(A.nRows(), A.dataPref());
+	if(hermErr > 1e-10)
+	{	logPrintf("Relative hermiticity error of %le (>1e-10) encountered in diagonalize\n", hermErr);
+		stackTraceExit(1);
+	}
+}
+
 void matrix::diagonalize(matrix& evecs, diagMatrix& eigs) const
 {	static StopWatch watch("matrix::diagonalize");
 	watch.start();
@@ -61,12 +116,7 @@ void matrix::diagonalize(matrix& evecs, diagMatrix& eigs) const
 	int N = nRows();
 	assert(N > 0);
 	
-	//Check hermiticity
-	const double hermErr = callPref(relativeHermiticityError)(N, dataPref());
-	if(hermErr > 1e-10)
-	{	logPrintf("Relative hermiticity error of %le (>1e-10) encountered in diagonalize\n", hermErr);
-		stackTraceExit(1);
-	}
+	checkHermiticity(*this);
 	
 #ifdef USE_CUSOLVER
 	if(N >= NcutCuSolver)
@@ -95,29 +145,79 @@ void matrix::diagonalize(matrix& evecs, diagMatrix& eigs) const
 		if(info>0) logPrintf("WARNING: %d elements failed to converge in cusolverDn eigenvalue routine Zheevj; falling back to CPU LAPACK.\n", info);
 	}
 #endif
-	char jobz = 'V'; //compute eigenvectors and eigenvalues
-	char range = 'A'; //compute all eigenvalues
-	char uplo = 'U'; //use upper-triangular part
-	matrix A = *this; //copy input matrix (zheevr destroys input matrix)
-	double eigMin = 0., eigMax = 0.; //eigenvalue range (not used for range-type 'A')
-	int indexMin = 0, indexMax = 0; //eignevalue index range (not used for range-type 'A')
-	double absTol = 0.; int nEigsFound;
-	eigs.resize(N);
-	evecs.init(N, N);
-	std::vector<int> iSuppz(2*N);
-	int lwork = (64+1)*N; std::vector<complex> work(lwork); //Magic number 64 obtained by running ILAENV as suggested in doc of zheevr (and taking the max over all N)
-	int lrwork = 24*N; std::vector<double> rwork(lrwork); //from doc of zheevr
-	int liwork = 10*N; std::vector<int> iwork(liwork); //from doc of zheevr
-	int info=0;
-	zheevr_(&jobz, &range, &uplo, &N, A.data(), &N,
-		&eigMin, &eigMax, &indexMin, &indexMax, &absTol, &nEigsFound,
-		eigs.data(), evecs.data(), &N, iSuppz.data(), work.data(), &lwork,
-		rwork.data(), &lrwork, iwork.data(), &liwork, &info);
-	if(info<0) { logPrintf("Argument# %d to LAPACK eigenvalue routine ZHEEVR is invalid.\n", -info); stackTraceExit(1); }
-	if(info>0) { logPrintf("Error code %d in LAPACK eigenvalue routine ZHEEVR.\n", info); stackTraceExit(1); }
+	diagonalizeLAPACK(*this, evecs, eigs);
 	watch.stop();
 }
 
+#ifdef SCALAPACK_ENABLED
+//Global indices in one dimension that belong to process iProcDim in a block-cyclic distribution
+static std::vector<int> blockCyclicIndices(int nTotal, int blockSize, int iProcDim, int nProcsDim)
+{	std::vector<int> indices;
+	for(int iStart=iProcDim*blockSize; iStart<nTotal; iStart+=blockSize*nProcsDim)
+		for(int i=iStart; i<std::min(iStart+blockSize, nTotal); i++)
+			indices.push_back(i);
+	return indices;
+}
+#endif
+
+void matrix::diagonalize(matrix& evecs, diagMatrix& eigs, const MPIUtil* mpiUtil, int root) const
+{	int N = (mpiUtil->iProcess()==root) ? nRows() : 0;
+	mpiUtil->bcast(N, root);
+#ifdef SCALAPACK_ENABLED
+	if(N >= NcutScaLAPACK && mpiUtil->nProcesses() > 1)
+	{	static StopWatch watch("matrix::diagonalizeScaLAPACK");
+		watch.start();
+		if(mpiUtil->iProcess()==root) assert(nCols()==N);
+		//Squarest possible process grid:
+		int nProcesses = mpiUtil->nProcesses();
+		int nProcsRow = int(round(sqrt(nProcesses)));
+		while(nProcesses % nProcsRow) nProcsRow--;
+		int nProcsCol = nProcesses / nProcsRow;
+		int blacsContext = Csys2blacs_handle(mpiUtil->communicator()), iProcRow, iProcCol;
+		blacs_gridinit_(&blacsContext, "Row-major", &nProcsRow, &nProcsCol);
+		blacs_gridinfo_(&blacsContext, &nProcsRow, &nProcsCol, &iProcRow, &iProcCol);
+		//Distribute matrix (block-cyclic in both dimensions):
+		matrix A = (mpiUtil->iProcess()==root) ? *this : matrix(N, N);
+		mpiUtil->bcastData(A, root);
+		const int blockSize = 32, zero = 0, one = 1;
+		std::vector<int> iRows = blockCyclicIndices(N, blockSize, iProcRow, nProcsRow);
+		std::vector<int> iCols = blockCyclicIndices(N, blockSize, iProcCol, nProcsCol);
+		int nRowsMine = iRows.size(), nColsMine = iCols.size(), lld = std::max(1, nRowsMine), info = 0;
+		assert(nRowsMine == numroc_(&N, &blockSize, &iProcRow, &zero, &nProcsRow));
+		int desc[9]; descinit_(desc, &N, &N, &blockSize, &blockSize, &zero, &zero, &blacsContext, &lld, &info);
+		std::vector<complex> Amine(lld * nColsMine), Zmine(lld * nColsMine);
+		const complex* Adata = A.data();
+		for(int j=0; j<nColsMine; j++)
+			for(int i=0; i<nRowsMine; i++)
+				Amine[i+lld*j] = Adata[A.index(iRows[i], iCols[j])];
+		//Workspace query and diagonalization:
+		eigs.resize(N);
+		int lwork=-1, lrwork=-1, liwork=-1;
+		complex workQuery; double rworkQuery; int iworkQuery;
+		pzheevd_("V", "U", &N, Amine.data(), &one, &one, desc, eigs.data(), Zmine.data(), &one, &one, desc,
+			&workQuery, &lwork, &rworkQuery, &lrwork, &iworkQuery, &liwork, &info);
+		lwork = int(workQuery.real()); lrwork = int(rworkQuery); liwork = iworkQuery;
+		std::vector<complex> work(lwork); std::vector<double> rwork(lrwork); std::vector<int> iwork(liwork);
+		pzheevd_("V", "U", &N, Amine.data(), &one, &one, desc, eigs.data(), Zmine.data(), &one, &one, desc,
+			work.data(), &lwork, rwork.data(), &lrwork, iwork.data(), &liwork, &info);
+		if(info<0) { logPrintf("Argument# %d to ScaLAPACK eigenvalue routine PZHEEVD is invalid.\n", -info); stackTraceExit(1); }
+		if(info>0) { logPrintf("Error code %d in ScaLAPACK eigenvalue routine PZHEEVD.\n", info); stackTraceExit(1); }
+		blacs_gridexit_(&blacsContext);
+		//Collect eigenvectors on root:
+		evecs = zeroes(N, N);
+		complex* evecsData = evecs.data();
+		for(int j=0; j<nColsMine; j++)
+			for(int i=0; i<nRowsMine; i++)
+				evecsData[evecs.index(iRows[i], iCols[j])] = Zmine[i+lld*j];
+		mpiUtil->reduceData(evecs, MPIUtil::ReduceSum, root);
+		if(mpiUtil->iProcess()!=root) { evecs = matrix(); eigs.clear(); }
+		watch.stop();
+		return;
+	}
+#endif
+	if(mpiUtil->iProcess()==root) diagonalize(evecs, eigs);
+}
+
 void matrix::diagonalize(matrix& levecs, std::vector<complex>& eigs, matrix& revecs) const
 {	static StopWatch watch("matrix::diagonalizeNH");
 	watch.start();
@@ -144,6 +244,32 @@ void matrix::diagonalize(matrix& levecs, std::vector<complex>& eigs, matrix& rev
 	watch.stop();
 }
 
+//CPU LAPACK singular value decomposition (used by matrix::svd and the batched version; outputs must be initialized)
+static void svdLAPACK(const matrix& Ain, matrix& U, diagMatrix& S, matrix& Vdag)
+{	int M = Ain.nRows();
+	int N = Ain.nCols();
+	//Initialize temporaries:
+	matrix A = Ain; //destructible copy
+	char jobz = 'A'; //full SVD (return complete unitary matrices)
+	int lwork = 2*(M*N + M + N);
+	std::vector<complex> work(lwork);
+	std::vector<double> rwork(S.nRows() * std::max(5*S.nRows()+7, 2*(M+N)+1));
+	std::vector<int> iwork(8*S.nRows());
+	//Call LAPACK and check errors:
+	int info=0;
+	zgesdd_(&jobz, &M, &N, A.data(), &M, S.data(), U.data(), &M, Vdag.data(), &N,
+		work.data(), &lwork, rwork.data(), iwork.data(), &info);
+	if(info>0) //convergence failure; try the slower stabler version
+	{	int info=0;
+		matrix A = Ain; //destructible copy
+		zgesvd_(&jobz, &jobz, &M, &N, A.data(), &M, S.data(), U.data(), &M, Vdag.data(), &N,
+			work.data(), &lwork, rwork.data(), &info);
+		if(info<0) { logPrintf("Argument# %d to LAPACK SVD routine ZGESVD is invalid.\n", -info); stackTraceExit(1); }
+		if(info>0) { logPrintf("Error code %d in LAPACK SVD routine ZGESVD.\n", info); stackTraceExit(1); }
+	}
+	if(info<0) { logPrintf("Argument# %d to LAPACK SVD routine ZGESDD is invalid.\n", -info); stackTraceExit(1); }
+}
+
 void matrix::svd(matrix& U, diagMatrix& S, matrix& Vdag) const
 {	static StopWatch watch("matrix::svd");
 	watch.start();
@@ -185,26 +311,7 @@ void matrix::svd(matrix& U, diagMatrix& S, matrix& Vdag) const
 		if(info>0) logPrintf("WARNING: %d elements did not converge in CuSolver SVD routine Zgesvd; falling back to CPU LAPACK.\n", info);
 	}
 #endif
-	//Initialize temporaries:
-	matrix A = *this; //destructible copy
-	char jobz = 'A'; //full SVD (return complete unitary matrices)
-	int lwork = 2*(M*N + M + N);
-	std::vector<complex> work(lwork);
-	std::vector<double> rwork(S.nRows() * std::max(5*S.nRows()+7, 2*(M+N)+1));
-	std::vector<int> iwork(8*S.nRows());
-	//Call LAPACK and check errors:
-	int info=0;
-	zgesdd_(&jobz, &M, &N, A.data(), &M, S.data(), U.data(), &M, Vdag.data(), &N,
-		work.data(), &lwork, rwork.data(), iwork.data(), &info);
-	if(info>0) //convergence failure; try the slower stabler version
-	{	int info=0;
-		matrix A = *this; //destructible copy
-		zgesvd_(&jobz, &jobz, &M, &N, A.data(), &M, S.data(), U.data(), &M, Vdag.data(), &N,
-			work.data(), &lwork, rwork.data(), &info);
-		if(info<0) { logPrintf("Argument# %d to LAPACK SVD routine ZGESVD is invalid.\n", -info); stackTraceExit(1); }
-		if(info>0) { logPrintf("Error code %d in LAPACK SVD routine ZGESVD.\n", info); stackTraceExit(1); }
-	}
-	if(info<0) { logPrintf("Argument# %d to LAPACK SVD routine ZGESDD is invalid.\n", -info); stackTraceExit(1); }
+	svdLAPACK(*this, U, S, Vdag);
 	watch.stop();
 }
 
@@ -339,7 +446,7 @@ matrix invOrLU(const matrix& A, bool calcInv)
 		if(info>0) { logPrintf("CuSolver LU decomposition routine Zgetrf found input matrix to be singular at the %d'th step.\n", info); stackTraceExit(1); }
 		//Calculate inverse:
 		matrix result(eye(N)); //will contain inv(A) on output
-		cusolverDnZgetrs(cusolverHandle, CUBLAS_OP_N, N, N, (double2*)LU.dataPref(), N,
+		cusolverDnZgetrs(cusolverHandle, CUSOLVER_OP_N, N, N, (double2*)LU.dataPref(), N,
            iPivot.dataPref(), (double2*)result.dataPref(), N, infoArr.dataPref());
 		info = infoArr.data()[0];
 		if(info<0) { logPrintf("Argument# %d to CuSolver linear solve routine Zgetrs is invalid.\n", -info); stackTraceExit(1); }
@@ -384,6 +491,67 @@ diagMatrix inv(const diagMatrix& A)
 	return invA;
 }
 
+matrix invCholesky(const matrix& A, bool* isSingular)
+{	static StopWatch watch("invCholesky(matrix)");
+	watch.start();
+	assert(A.nCols()==A.nRows());
+	int N = A.nRows();
+	assert(N > 0);
+	if(isSingular) *isSingular = false;
+	matrix R = A; //destructible copy; factorized in place
+	int info = 0;
+#ifdef USE_CUSOLVER
+	if(N > NcutCuSolver)
+	{	//Cholesky factorization:
+		cublasFillMode_t uplo = CUBLAS_FILL_MODE_UPPER;
+		int lwork = 0;
+		cusolverDnZpotrf_bufferSize(cusolverHandle, uplo, N, (double2*)R.dataPref(), N, &lwork);
+		ManagedArray<double2> work; work.init(lwork, true);
+		ManagedArray<int> infoArr; infoArr.init(1, true);
+		cusolverDnZpotrf(cusolverHandle, uplo, N, (double2*)R.dataPref(), N, work.dataPref(), lwork, infoArr.dataPref());
+		info = infoArr.data()[0];
+		if(info<0) { logPrintf("Argument# %d to CuSolver Cholesky routine Zpotrf is invalid.\n", -info); stackTraceExit(1); }
+		if(info==0)
+		{	//Inverse factor as inv(A) * dagger(R) = inv(R), using the triangular solves of Zpotrs:
+			complex* Rdata = R.data();
+			for(int j=0; j<N; j++)
+				for(int i=j+1; i<N; i++)
+					Rdata[R.index(i,j)] = 0.; //clear lower triangle left over from A
+			matrix Rinv = dagger(R);
+			cusolverDnZpotrs(cusolverHandle, uplo, N, N, (double2*)R.dataPref(), N, (double2*)Rinv.dataPref(), N, infoArr.dataPref());
+			info = infoArr.data()[0];
+			if(info<0) { logPrintf("Argument# %d to CuSolver solver routine Zpotrs is invalid.\n", -info); stackTraceExit(1); }
+			watch.stop();
+			return Rinv;
+		}
+	}
+	else
+#endif
+	{	char uplo = 'U', diag = 'N';
+		zpotrf_(&uplo, &N, R.data(), &N, &info);
+		if(info<0) { logPrintf("Argument# %d to LAPACK Cholesky routine ZPOTRF is invalid.\n", -info); stackTraceExit(1); }
+		if(info==0)
+		{	ztrtri_(&uplo, &diag, &N, R.data(), &N, &info);
+			if(info<0) { logPrintf("Argument# %d to LAPACK triangular inverse routine ZTRTRI is invalid.\n", -info); stackTraceExit(1); }
+			complex* Rdata = R.data();
+			for(int j=0; j<N; j++)
+				for(int i=j+1; i<N; i++)
+					Rdata[R.index(i,j)] = 0.; //clear lower triangle left over from A
+		}
+	}
+	if(info>0)
+	{	if(isSingular)
+		{	*isSingular = true;
+			watch.stop();
+			return matrix();
+		}
+		logPrintf("Matrix not positive-definite at leading minor# %d in Cholesky factorization.\n", info);
+		stackTraceExit(1);
+	}
+	watch.stop();
+	return R;
+}
+
 matrix invApply(const matrix& A, const matrix& b)
 {	static StopWatch watch("invApply(matrix)");
 	watch.start();
@@ -436,3 +604,212 @@ matrix invApply(const matrix& A, const matrix& b)
 	watch.stop();
 	return x;
 }
+
+
+//------------- Batched operations on several matrices ---------------
+
+//Indices of non-null entries of A grouped by dimensions (so that each group can be processed in one batch):
+static std::map<std::pair<int,int>, std::vector<int>> batchGroups(const std::vector<matrix>& A)
+{	std::map<std::pair<int,int>, std::vector<int>> groups;
+	for(int i=0; i<int(A.size()); i++)
+		if(A[i]) groups[std::make_pair(A[i].nRows(), A[i].nCols())].push_back(i);
+	return groups;
+}
+
+void diagonalize(const std::vector<matrix>& A, std::vector<matrix>& evecs, std::vector<diagMatrix>& eigs)
+{	static StopWatch watch("diagonalizeBatched");
+	watch.start();
+	if(evecs.size() < A.size()) evecs.resize(A.size());
+	if(eigs.size() < A.size()) eigs.resize(A.size());
+	for(const auto& group: batchGroups(A))
+	{	int N = group.first.first;
+		assert(group.first.second == N);
+		const std::vector<int>& iArr = group.second;
+		int nBatch = iArr.size();
+		for(int i: iArr) checkHermiticity(A[i]);
+#ifdef USE_CUSOLVER
+		if(N <= NcutCuSolver and nBatch > 1) //small matrices: one batched Jacobi call (cuSolver supports up to 32 x 32)
+		{	int NN = N*N;
+			ManagedArray<complex> Abatch; Abatch.init(NN*nBatch, true);
+			for(int b=0; b<nBatch; b++)
+				eblas_copy_gpu(Abatch.dataGpu()+b*NN, A[iArr[b]].dataGpu(), NN);
+			ManagedArray<double> eigsManaged; eigsManaged.init(N*nBatch, true);
+			ManagedArray<int> infoArr; infoArr.init(nBatch, true);
+			cusolverEigMode_t jobz = CUSOLVER_EIG_MODE_VECTOR;
+			cublasFillMode_t uplo = CUBLAS_FILL_MODE_UPPER;
+			syevjInfo_t params; cusolverDnCreateSyevjInfo(&params);
+			int lwork = 0;
+			cusolverDnZheevjBatched_bufferSize(cusolverHandle, jobz, uplo, N, (const double2*)Abatch.dataGpu(), N,
+				eigsManaged.dataGpu(), &lwork, params, nBatch);
+			ManagedArray<double2> work; work.init(lwork, true);
+			cusolverDnZheevjBatched(cusolverHandle, jobz, uplo, N, (double2*)Abatch.dataGpu(), N,
+				eigsManaged.dataGpu(), work.dataGpu(), lwork, infoArr.dataGpu(), params, nBatch);
+			cusolverDnDestroySyevjInfo(params);
+			gpuErrorCheck();
+			const int* info = infoArr.data();
+			const double* eigsData = eigsManaged.data();
+			for(int b=0; b<nBatch; b++)
+			{	int i = iArr[b];
+				if(info[b])
+				{	logPrintf("WARNING: Error code %d for matrix# %d in cusolverDn batched eigenvalue routine ZheevjBatched; falling back to CPU LAPACK.\n", info[b], b);
+					diagonalizeLAPACK(A[i], evecs[i], eigs[i]);
+					continue;
+				}
+				evecs[i].init(N, N, true);
+				eblas_copy_gpu(evecs[i].dataGpu(), Abatch.dataGpu()+b*NN, NN); //eigenvectors generated in place
+				eigs[i].assign(eigsData+b*N, eigsData+(b+1)*N);
+			}
+			continue;
+		}
+		if(N >= NcutCuSolver) //large matrices on GPU: one at a time
+		{	for(int i: iArr) A[i].diagonalize(evecs[i], eigs[i]);
+			continue;
+		}
+#endif
+		//CPU LAPACK, threaded over the batch (only from the GPU owner thread in GPU builds, hence unthreaded there):
+		auto diagonalizeSub = [&](size_t bStart, size_t bStop)
+		{	for(size_t b=bStart; b<bStop; b++)
+			{	int i = iArr[b];
+				diagonalizeLAPACK(A[i], evecs[i], eigs[i]);
+			}
+		};
+		threadLaunch(isGpuEnabled() ? 1 : 0, &diagonalizeSub, nBatch);
+	}
+	watch.stop();
+}
+
+void svd(const std::vector<matrix>& A, std::vector<matrix>& U, std::vector<diagMatrix>& S, std::vector<matrix>& Vdag)
+{	static StopWatch watch("svdBatched");
+	watch.start();
+	if(U.size() < A.size()) U.resize(A.size());
+	if(S.size() < A.size()) S.resize(A.size());
+	if(Vdag.size() < A.size()) Vdag.resize(A.size());
+	for(const auto& group: batchGroups(A))
+	{	int M = group.first.first;
+		int N = group.first.second;
+		int K = std::min(M, N);
+		const std::vector<int>& iArr = group.second;
+		int nBatch = iArr.size();
+#ifdef USE_CUSOLVER
+		if(M <= NcutCuSolver and N <= NcutCuSolver and nBatch > 1) //small matrices: one batched Jacobi call (cuSolver supports up to 32 x 32)
+		{	int MN = M*N, MM = M*M, NN = N*N;
+			ManagedArray<complex> Abatch; Abatch.init(MN*nBatch, true);
+			for(int b=0; b<nBatch; b++)
+				eblas_copy_gpu(Abatch.dataGpu()+b*MN, A[iArr[b]].dataGpu(), MN);
+			ManagedArray<double> Smanaged; Smanaged.init(K*nBatch, true);
+			ManagedArray<complex> Ubatch; Ubatch.init(MM*nBatch, true);
+			ManagedArray<complex> Vbatch; Vbatch.init(NN*nBatch, true);
+			ManagedArray<int> infoArr; infoArr.init(nBatch, true);
+			cusolverEigMode_t jobz = CUSOLVER_EIG_MODE_VECTOR;
+			gesvdjInfo_t params; cusolverDnCreateGesvdjInfo(&params);
+			int lwork = 0;
+			cusolverDnZgesvdjBatched_bufferSize(cusolverHandle, jobz, M, N, (const double2*)Abatch.dataGpu(), M,
+				Smanaged.dataGpu(), (const double2*)Ubatch.dataGpu(), M, (const double2*)Vbatch.dataGpu(), N, &lwork, params, nBatch);
+			ManagedArray<double2> work; work.init(lwork, true);
+			cusolverDnZgesvdjBatched(cusolverHandle, jobz, M, N, (double2*)Abatch.dataGpu(), M,
+				Smanaged.dataGpu(), (double2*)Ubatch.dataGpu(), M, (double2*)Vbatch.dataGpu(), N,
+				work.dataGpu(), lwork, infoArr.dataGpu(), params, nBatch);
+			cusolverDnDestroyGesvdjInfo(params);
+			gpuErrorCheck();
+			const int* info = infoArr.data();
+			const double* Sdata = Smanaged.data();
+			for(int b=0; b<nBatch; b++)
+			{	int i = iArr[b];
+				if(info[b])
+				{	logPrintf("WARNING: Error code %d for matrix# %d in CuSolver batched SVD routine ZgesvdjBatched; falling back to CPU LAPACK.\n", info[b], b);
+					U[i].init(M, M); S[i].resize(K); Vdag[i].init(N, N);
+					svdLAPACK(A[i], U[i], S[i], Vdag[i]);
+					continue;
+				}
+				U[i].init(M, M, true);
+				eblas_copy_gpu(U[i].dataGpu(), Ubatch.dataGpu()+b*MM, MM);
+				matrix V(N, N, true);
+				eblas_copy_gpu(V.dataGpu(), Vbatch.dataGpu()+b*NN, NN);
+				Vdag[i] = dagger(V);
+				S[i].assign(Sdata+b*K, Sdata+(b+1)*K);
+			}
+			continue;
+		}
+		if(M >= N and M > NcutCuSolver) //large matrices on GPU: one at a time
+		{	for(int i: iArr) A[i].svd(U[i], S[i], Vdag[i]);
+			continue;
+		}
+#endif
+		//CPU LAPACK, threaded over the batch (only from the GPU owner thread in GPU builds, hence unthreaded there):
+		for(int i: iArr) { U[i].init(M, M); S[i].resize(K); Vdag[i].init(N, N); }
+		auto svdSub = [&](size_t bStart, size_t bStop)
+		{	for(size_t b=bStart; b<bStop; b++)
+			{	int i = iArr[b];
+				svdLAPACK(A[i], U[i], S[i], Vdag[i]);
+			}
+		};
+		threadLaunch(isGpuEnabled() ? 1 : 0, &svdSub, nBatch);
+	}
+	watch.stop();
+}
+
+std::vector<matrix> multiply(const std::vector<matrix>& A, const std::vector<matrix>& B, CBLAS_TRANSPOSE opA, CBLAS_TRANSPOSE opB)
+{	assert(A.size() == B.size());
+	std::vector<matrix> result(A.size());
+	//Group by dimensions of both operands:
+	std::map<std::vector<int>, std::vector<int>> groups;
+	for(int i=0; i<int(A.size()); i++)
+		if(A[i] and B[i])
+			groups[std::vector<int>({A[i].nRows(), A[i].nCols(), B[i].nRows(), B[i].nCols()})].push_back(i);
+	for(const auto& group: groups)
+	{	const std::vector<int>& dims = group.first;
+		const std::vector<int>& iArr = group.second;
+		int M = (opA==CblasNoTrans) ? dims[0] : dims[1];
+		int K = (opA==CblasNoTrans) ? dims[1] : dims[0];
+		int N = (opB==CblasNoTrans) ? dims[3] : dims[2];
+		assert(K == ((opB==CblasNoTrans) ? dims[2] : dims[3]));
+		for(int i: iArr) result[i].init(M, N, isGpuEnabled());
+#ifdef GPU_ENABLED
+		if(iArr.size() > 1) //one batched GEMM (with device arrays of device pointers)
+		{	int nBatch = iArr.size();
+			ManagedArray<const complex*> Aptr, Bptr; Aptr.init(nBatch); Bptr.init(nBatch);
+			ManagedArray<complex*> Cptr; Cptr.init(nBatch);
+			for(int b=0; b<nBatch; b++)
+			{	int i = iArr[b];
+				Aptr.data()[b] = A[i].dataGpu();
+				Bptr.data()[b] = B[i].dataGpu();
+				Cptr.data()[b] = result[i].dataGpu();
+			}
+			eblas_zgemm_batched_gpu(opA, opB, M, N, K, 1., Aptr.dataGpu(), dims[0], Bptr.dataGpu(), dims[2],
+				0., Cptr.dataGpu(), M, nBatch);
+			continue;
+		}
+#endif
+		for(int i: iArr)
+			callPref(eblas_zgemm)(opA, opB, M, N, K, 1., A[i].dataPref(), dims[0], B[i].dataPref(), dims[2],
+				0., result[i].dataPref(), M);
+	}
+	return result;
+}
+
+std::vector<matrix> invsqrt(const std::vector<matrix>& A, std::vector<matrix>* Aevecs, std::vector<diagMatrix>* Aeigs, bool* isSingular)
+{	if(isSingular) *isSingular = false;
+	std::vector<matrix> evecs; std::vector<diagMatrix> eigs;
+	diagonalize(A, evecs, eigs);
+	//Scale eigenvectors by eigenvalues^-0.25, so that the result is the product of the scaled eigenvectors with their adjoints:
+	std::vector<matrix> evecsScaled(A.size());
+	for(size_t i=0; i<A.size(); i++)
+		if(A[i])
+		{	diagMatrix eigOut(eigs[i].size());
+			for(int j=0; j<eigs[i].nRows(); j++)
+			{	if(eigs[i][j] <= 0.)
+				{	if(isSingular)
+						*isSingular = true; //project out current eigenvalue; calling function will handle if needed
+					else //Unhandled: print stack-trace
+					{	logPrintf("Eigenvalue# %d is non-positive (%le) in batched invsqrt of matrix# %lu\n", j, eigs[i][j], i);
+						stackTraceExit(1);
+					}
+				}
+				else eigOut[j] = pow(eigs[i][j], -0.25);
+			}
+			evecsScaled[i] = evecs[i] * eigOut;
+		}
+	if(Aevecs) *Aevecs = evecs;
+	if(Aeigs) *Aeigs = eigs;
+	return multiply(evecsScaled, evecsScaled, CblasNoTrans, CblasConjTrans);
+}
@@ -0,0 +1,146 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/BandChebyshev.h>
+#include <electronic/BandDavidson.h>
+#include <electronic/Everything.h>
+
+BandChebyshev::BandChebyshev(Everything& e, int q): e(e), eVars(e.eVars), eInfo(e.eInfo), q(q)
+{	assert(e.cntrl.fixed_H); // Check whether the electron Hamiltonian is fixed
+}
+
+ColumnBundle BandChebyshev::applyH(ColumnBundle& Y)
+{	std::vector<matrix> VdagY;
+	e.iInfo.project(Y, VdagY);
+	ColumnBundle HY;
+	matrix HsubY; diagMatrix HsubY_eigs;
+	Energies ener; //not really used here
+	#define SWAP_C_Y \
+		std::swap(eVars.C[q], Y); \
+		std::swap(eVars.VdagC[q], VdagY); \
+		std::swap(eVars.Hsub[q], HsubY); \
+		std::swap(eVars.Hsub_eigs[q], HsubY_eigs);
+	SWAP_C_Y //Temporarily swap C and Y
+	eVars.applyHamiltonian(q, eye(eVars.C[q].nCols()), HY, ener, true, false); //Hamiltonian always operates on C, where we put Y
+	SWAP_C_Y //Restore C and Y to correct places
+	#undef SWAP_C_Y
+	HY *= 1./e.gInfo.detR; //overlap operator O = detR for norm-conserving pseudopotentials
+	return HY;
+}
+
+double BandChebyshev::upperBound()
+{	const int nSteps = 8; //Lanczos steps
+	ColumnBundle v = eVars.C[q].similar(1), vPrev;
+	randomize(v);
+	v *= 1./sqrt(trace(v^v).real());
+	matrix T = zeroes(nSteps, nSteps);
+	double beta = 0.;
+	for(int j=0; j<nSteps; j++)
+	{	ColumnBundle f = applyH(v);
+		if(vPrev) f -= beta * vPrev;
+		double alpha = trace(v^f).real();
+		f -= alpha * v;
+		beta = sqrt(trace(f^f).real());
+		T.set(j,j, alpha);
+		if(j+1 < nSteps)
+		{	T.set(j,j+1, beta);
+			T.set(j+1,j, beta);
+		}
+		vPrev = v;
+		v = f * (1./beta);
+	}
+	matrix Tevecs; diagMatrix Teigs;
+	T.diagonalize(Tevecs, Teigs);
+	return Teigs.back() + beta; //safeguarded by the last residual norm
+}
+
+void BandChebyshev::minimize()
+{	for(const auto& sp: e.iInfo.species)
+		if(sp->isUltrasoft())
+		{	logPrintf("WARNING: Chebyshev filtering not supported for ultrasoft pseudopotentials; using Davidson.\n");
+			BandDavidson(e, q).minimize();
+			return;
+		}
+	//Use the same working set as the CG minimizer:
+	ColumnBundle& C = eVars.C[q];
+	std::vector<matrix>& VdagC = eVars.VdagC[q];
+	matrix& Hsub = eVars.Hsub[q];
+	matrix& Hsub_evecs = eVars.Hsub_evecs[q];
+	diagMatrix& Hsub_eigs = eVars.Hsub_eigs[q];
+	const QuantumNumber& qnum = eInfo.qnums[q];
+	int nBands = eInfo.nBands;
+	int degree = e.cntrl.chebyshevDegree;
+	
+	//Initial subspace eigenvalue problem:
+	ColumnBundle HC;
+	diagMatrix I = eye(nBands);
+	Energies ener; //not really used here
+	eVars.applyHamiltonian(q, I, HC, ener, true); //also diagonalizes Hsub
+	double Eband = qnum.weight * trace(Hsub_eigs);
+	logPrintf("BandChebyshev: Iter: %3d  Eband: %+.15lf\n", 0, Eband); fflush(globalLog);
+	HC.free();
+	
+	const MinimizeParams& mp = e.elecMinParams;
+	double Emax = upperBound();
+	int iter=1;
+	for(; iter<=mp.nIterations; iter++)
+	{	//Filter interval [Ecut, Emax] to be damped, and lowest Ritz value Emin for scaling:
+		double Emin = Hsub_eigs.front(), Ecut = Hsub_eigs.back();
+		if(Emax <= Ecut) Emax = Ecut + std::max(1., fabs(Ecut)); //guard against a poor Lanczos estimate
+		double halfWidth = 0.5*(Emax - Ecut), center = 0.5*(Emax + Ecut);
+		double sigma = halfWidth / (Emin - center), tau = 2./sigma;
+		//Scaled three-term Chebyshev recurrence (scaled to avoid overflow of the low-lying components):
+		ColumnBundle Yprev = C;
+		ColumnBundle Y = applyH(Yprev); Y -= center * Yprev;
+		Y *= sigma/halfWidth;
+		for(int k=2; k<=degree; k++)
+		{	double sigmaNext = 1./(tau - sigma);
+			ColumnBundle Ynext = applyH(Y); Ynext -= center * Y;
+			Ynext *= 2.*sigmaNext/halfWidth;
+			Ynext -= (sigma*sigmaNext) * Yprev;
+			Yprev = std::move(Y);
+			Y = std::move(Ynext);
+			sigma = sigmaNext;
+		}
+		Yprev.free();
+		//Orthonormalize and Rayleigh-Ritz:
+		C = std::move(Y);
+		eVars.orthonormalize(q, 0, true); //only the span matters before Rayleigh-Ritz
+		eVars.applyHamiltonian(q, I, HC, ener, true);
+		C = C * Hsub_evecs;
+		e.iInfo.project(C, VdagC, &Hsub_evecs);
+		HC.free();
+		//Print and test convergence
+		double EbandPrev = Eband;
+		Eband = qnum.weight * trace(Hsub_eigs);
+		double dEband = Eband - EbandPrev;
+		logPrintf("BandChebyshev: Iter: %3d  Eband: %+.15lf  dEband: %le  t[s]: %9.2lf\n", iter, Eband, dEband, clock_sec()); fflush(globalLog);
+		if(dEband<0 and fabs(dEband)<mp.energyDiffThreshold)
+		{	logPrintf("BandChebyshev: Converged (dEband<%le)\n", mp.energyDiffThreshold);
+			break;
+		}
+	}
+	if(iter>mp.nIterations)
+		logPrintf("BandChebyshev: None of the convergence criteria satisfied after %d iterations.\n", mp.nIterations);
+	fflush(globalLog);
+	
+	//Update final quantities:
+	Hsub = Hsub_eigs;
+	Hsub_evecs = I;
+}
@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#ifndef JDFTX_ELECTRONIC_BANDCHEBYSHEV_H
+#define JDFTX_ELECTRONIC_BANDCHEBYSHEV_H
+
+#include <core/Minimize.h>
+#include <electronic/ColumnBundle.h>
+
+class Everything;
+
+//! @addtogroup ElecSystem
+//! @{
+
+//! Chebyshev-filtered subspace iteration (CheFSI) eigensolver.
+//! Each iteration applies a Chebyshev polynomial of the Hamiltonian that damps the spectrum above
+//! the current highest Ritz value, followed by a single Rayleigh-Ritz step. Needs only block
+//! Hamiltonian applications, and works best when started from a nearby subspace (eg. within SCF).
+class BandChebyshev
+{
+public:
+	BandChebyshev(Everything& e, int q); //!< Construct Chebyshev-filtered eigenvalue solver for quantum number q
+	void minimize(); //!< Converge eigenproblem with tolerance set by e.elecMinParams
+	
+private:
+	Everything& e;
+	class ElecVars& eVars;
+	const class ElecInfo& eInfo;
+	int q;  //!< Current quantum number
+	
+	ColumnBundle applyH(ColumnBundle& Y); //!< return O^-1 H Y (O is a constant for norm-conserving pseudopotentials)
+	double upperBound(); //!< estimate upper bound of the Hamiltonian spectrum using a few Lanczos steps
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_BANDCHEBYSHEV_H
@@ -58,16 +58,40 @@ void BandDavidson::minimize()
 	for(; iter<=mp.nIterations; iter++)
 	{	int nBands = C.nCols();
 		//Compute subspace expansion:
-		diagMatrix KEref = (-0.5) * diagDot(C, L(C)); //Update reference KE for preconditioning:
 		ColumnBundle Cexp = HC; Cexp -= O(C) * Hsub_eigs; //Calculate residual of current eigenvector guesses
-		precond_inv_kinetic_band(Cexp, KEref); //Davidson approximate inverse (using KE as the diagonal)
-		//Drop converged eigenpairs and approximately normalize subspace expansion (for avoiding roundoff issues only):
-		diagMatrix CexpNorm = diagDot(Cexp, Cexp);
 		double CexpNormCut = std::max(mp.energyDiffThreshold/nBands, 1e-15*Cexp.colLength());
-		{	//Drop columns whose norm falls below above cutoff
+		diagMatrix bandCutScale = eVars.bandResidualScale(q, nBands); //looser thresholds for nearly-empty bands, if enabled
+		int nActive = nBands; //number of leading columns of Cexp in use
+		{	//Lock converged bands: the preconditioner only reduces norms, so these would be dropped below anyway
+			diagMatrix residualNorm = diagDot(Cexp, Cexp);
+			std::vector<int> active; //unconverged bands
+			for(int b=0; b<nBands; b++)
+				if(residualNorm[b] >= CexpNormCut*bandCutScale[b]) active.push_back(b);
+			nActive = active.size();
+			if(!nActive)
+			{	logPrintf("BandDavidson: Converged (dEband<%le)\n", mp.energyDiffThreshold);
+				break;
+			}
+			diagMatrix KEref; //reference KE for preconditioning
+			if(nActive<nBands)
+			{	ColumnBundle Cactive = C.similar(nActive); //current guesses for the unconverged bands
+				complex* CexpData = Cexp.dataPref();
+				for(int j=0; j<nActive; j++)
+				{	int b = active[j];
+					callPref(eblas_copy)(Cactive.dataPref()+Cactive.index(j,0), C.dataPref()+C.index(b,0), C.colLength());
+					if(j<b) callPref(eblas_copy)(CexpData+Cexp.index(j,0), CexpData+Cexp.index(b,0), Cexp.colLength());
+				}
+				KEref = (-0.5) * diagDot(Cactive, L(Cactive));
+			}
+			else KEref = (-0.5) * diagDot(C, L(C));
+			precond_inv_kinetic_band(ColumnBundleView(Cexp,0,nActive), KEref); //Davidson approximate inverse (using KE as the diagonal)
+		}
+		//Drop converged eigenpairs and approximately normalize subspace expansion (for avoiding roundoff issues only):
+		diagMatrix CexpNorm = diagDot(ColumnBundleView(Cexp,0,nActive), ColumnBundleView(Cexp,0,nActive));
+		{	//Drop columns whose norm falls below above cutoff (truncating the locked ones along with them in one copy)
 			complex* CexpData = Cexp.dataPref();
 			int bOut = 0;
-			for(int b=0; b<nBands; b++)
+			for(int b=0; b<nActive; b++)
 			{	if(CexpNorm[b]<CexpNormCut) continue;
 				CexpNorm[bOut] = 1/sqrt(CexpNorm[b]);
 				if(bOut<b) callPref(eblas_copy)(CexpData+Cexp.index(bOut,0), CexpData+Cexp.index(b,0), Cexp.colLength());
@@ -77,7 +101,7 @@ void BandDavidson::minimize()
 			{	logPrintf("BandDavidson: Converged (dEband<%le)\n", mp.energyDiffThreshold);
 				break;
 			}
-			if(bOut<nBands)
+			if(bOut<Cexp.nCols())
 			{	Cexp = Cexp.getSub(0,bOut);
 				CexpNorm = CexpNorm(0,bOut);
 			}
@@ -116,8 +140,8 @@ void BandDavidson::minimize()
 			bigHsub.set(nBands,nBandsBig, 0,nBands, dagger(CdagHCexp));
 		}
 		//Solve expanded subspace generalized eigenvalue problem:
-		matrix bigU = invsqrt(bigOsub);
-		bigHsub = dagger_symmetrize(dagger(bigU) * bigHsub * bigU); //switch to the symmetrically-orthonormalized basis
+		matrix bigU = eVars.orthoMatrix(bigOsub);
+		bigHsub = dagger_symmetrize(dagger(bigU) * bigHsub * bigU); //switch to an orthonormalized basis
 		matrix bigHsub_evecs; diagMatrix bigHsub_eigs;
 		bigHsub.diagonalize(bigHsub_evecs, bigHsub_eigs);
 		matrix rot = bigU * bigHsub_evecs; //rotation from [C,Cexp] to the expanded subspace eigenbasis
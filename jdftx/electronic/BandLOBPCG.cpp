@@ -0,0 +1,234 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/BandLOBPCG.h>
+#include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
+
+BandLOBPCG::BandLOBPCG(Everything& e, int q): e(e), eVars(e.eVars), eInfo(e.eInfo), q(q)
+{	assert(e.cntrl.fixed_H); // Check whether the electron Hamiltonian is fixed
+}
+
+//Gather / scatter selected columns (used to restrict the updates to the active block):
+static ColumnBundle getCols(const ColumnBundle& Y, const std::vector<int>& cols)
+{	ColumnBundle Ysub = Y.similar(cols.size());
+	for(size_t j=0; j<cols.size(); j++)
+		callPref(eblas_copy)(Ysub.dataPref()+Ysub.index(j,0), Y.dataPref()+Y.index(cols[j],0), Y.colLength());
+	return Ysub;
+}
+static void setCols(ColumnBundle& Y, const std::vector<int>& cols, const ColumnBundle& Ysub)
+{	for(size_t j=0; j<cols.size(); j++)
+		callPref(eblas_copy)(Y.dataPref()+Y.index(cols[j],0), Ysub.dataPref()+Ysub.index(j,0), Y.colLength());
+}
+static matrix getCols(const matrix& M, const std::vector<int>& cols)
+{	matrix Msub(M.nRows(), cols.size());
+	for(size_t j=0; j<cols.size(); j++)
+		callPref(eblas_copy)(Msub.dataPref()+Msub.index(0,j), M.dataPref()+M.index(0,cols[j]), M.nRows());
+	return Msub;
+}
+static void setCols(matrix& M, const std::vector<int>& cols, const matrix& Msub)
+{	for(size_t j=0; j<cols.size(); j++)
+		callPref(eblas_copy)(M.dataPref()+M.index(0,cols[j]), Msub.dataPref()+Msub.index(0,j), M.nRows());
+}
+
+//Indices of columns of Y with squared norm above normSqCut, and their inverse norms
+static std::vector<int> selectNormalizable(const ColumnBundle& Y, double normSqCut, diagMatrix& invNorm)
+{	diagMatrix normSq = diagDot(Y, Y);
+	std::vector<int> cols; invNorm.clear();
+	for(int b=0; b<Y.nCols(); b++)
+		if(normSq[b] > normSqCut)
+		{	cols.push_back(b);
+			invNorm.push_back(1./sqrt(normSq[b]));
+		}
+	return cols;
+}
+
+void BandLOBPCG::minimize()
+{	//Use the same working set as the CG minimizer:
+	ColumnBundle& C = eVars.C[q];
+	std::vector<matrix>& VdagC = eVars.VdagC[q];
+	matrix& Hsub = eVars.Hsub[q];
+	matrix& Hsub_evecs = eVars.Hsub_evecs[q];
+	diagMatrix& Hsub_eigs = eVars.Hsub_eigs[q];
+	const QuantumNumber& qnum = eInfo.qnums[q];
+	int nBands = eInfo.nBands;
+	
+	//Initial subspace eigenvalue problem:
+	ColumnBundle HC;
+	diagMatrix I = eye(nBands);
+	Energies ener; //not really used here
+	eVars.applyHamiltonian(q, I, HC, ener, true); //also diagonalizes Hsub
+	//--- switch C to subspace eigenbasis:
+	C = C * Hsub_evecs;
+	HC = HC * Hsub_evecs;
+	e.iInfo.project(C, VdagC, &Hsub_evecs);
+	double Eband = qnum.weight * trace(Hsub_eigs);
+	logPrintf("BandLOBPCG: Iter: %3d  Eband: %+.15lf\n", 0, Eband); fflush(globalLog);
+	
+	ColumnBundle P, HP; std::vector<matrix> VdagP; //previous search directions (none in first iteration)
+	const MinimizeParams& mp = e.elecMinParams;
+	int iter=1;
+	for(; iter<=mp.nIterations; iter++)
+	{	//Residuals and soft-locking of converged bands:
+		ColumnBundle OC = O(C);
+		ColumnBundle W = HC; W -= OC * Hsub_eigs;
+		diagMatrix Wnorm = diagDot(W, W);
+		double WnormCut = std::max(mp.energyDiffThreshold/nBands, 1e-15*W.colLength());
+		diagMatrix bandCutScale = eVars.bandResidualScale(q, nBands); //looser thresholds for nearly-empty bands, if enabled
+		std::vector<int> active; //bands that are not yet converged
+		for(int b=0; b<nBands; b++)
+			if(Wnorm[b] >= WnormCut*bandCutScale[b]) active.push_back(b);
+		if(!active.size())
+		{	logPrintf("BandLOBPCG: Converged (all residuals below threshold)\n");
+			break;
+		}
+		int nActive = active.size();
+		ColumnBundle Ca = getCols(C, active), HCa = getCols(HC, active);
+		diagMatrix eigsA(nActive);
+		for(int j=0; j<nActive; j++) eigsA[j] = Hsub_eigs[active[j]];
+		//Preconditioned residuals of active bands (Davidson approximate inverse with KE as the diagonal):
+		W = getCols(W, active);
+		precond_inv_kinetic_band(W, (-0.5) * diagDot(Ca, L(Ca)));
+		//O-orthogonalize expansion directions against all current bands (keeps locked bands out of Rayleigh-Ritz):
+		W -= C * (OC ^ W);
+		if(P)
+		{	matrix OCdagP = OC ^ P;
+			P -= C * OCdagP;
+			HP -= HC * OCdagP;
+			for(size_t sp=0; sp<VdagP.size(); sp++) if(VdagP[sp]) VdagP[sp] -= VdagC[sp] * OCdagP;
+		}
+		OC.free();
+		//Normalize expansion directions, dropping negligible ones (for avoiding roundoff issues only):
+		diagMatrix invNorm;
+		std::vector<int> cols = selectNormalizable(W, 1e-15*W.colLength(), invNorm);
+		if(!cols.size()) //This is unlikely, but just in case (to avoid zero column matrices below)
+		{	logPrintf("BandLOBPCG: Converged (no remaining search directions)\n");
+			break;
+		}
+		W = getCols(W, cols) * invNorm;
+		if(P)
+		{	cols = selectNormalizable(P, 1e-15*P.colLength(), invNorm);
+			if(cols.size())
+			{	P = getCols(P, cols) * invNorm;
+				HP = getCols(HP, cols) * invNorm;
+				for(size_t sp=0; sp<VdagP.size(); sp++) if(VdagP[sp]) VdagP[sp] = getCols(VdagP[sp], cols) * invNorm;
+			}
+			else { P.free(); HP.free(); VdagP.clear(); }
+		}
+		int nW = W.nCols(), nP = P.nCols();
+		int nS = nActive + nW + nP; //dimension of Rayleigh-Ritz basis [Ca, W, P]
+		//Hamiltonian on new directions:
+		std::vector<matrix> VdagW;
+		ColumnBundle OW = O(W, &VdagW);
+		{	matrix rotExisting = eye(nW);
+			e.iInfo.project(W, VdagW, &rotExisting);
+		}
+		ColumnBundle HW;
+		matrix HsubW;
+		{	diagMatrix HsubW_eigs;
+			#define SWAP_C_W \
+				std::swap(C, W); \
+				std::swap(VdagC, VdagW); \
+				std::swap(Hsub, HsubW); \
+				std::swap(Hsub_eigs, HsubW_eigs);
+			SWAP_C_W //Temporarily swap C and W
+			eVars.applyHamiltonian(q, eye(nW), HW, ener, true, false); //Hamiltonian always operates on C, where we put W
+			SWAP_C_W //Restore C and W to correct places
+			#undef SWAP_C_W
+		}
+		//Subspace overlap and Hamiltonian (Ca is orthonormal and O-orthogonal to W and P):
+		matrix Os = zeroes(nS, nS), Hs = zeroes(nS, nS);
+		Os.set(0,nActive, 0,nActive, eye(nActive));
+		Os.set(nActive,nActive+nW, nActive,nActive+nW, W ^ OW);
+		OW.free();
+		matrix CadagHW = Ca ^ HW;
+		Hs.set(0,nActive, 0,nActive, eigsA);
+		Hs.set(0,nActive, nActive,nActive+nW, CadagHW);
+		Hs.set(nActive,nActive+nW, 0,nActive, dagger(CadagHW));
+		Hs.set(nActive,nActive+nW, nActive,nActive+nW, HsubW);
+		if(nP)
+		{	ColumnBundle OP = O(P, &VdagP);
+			matrix WdagOP = W ^ OP, CadagHP = Ca ^ HP, WdagHP = W ^ HP;
+			Os.set(nActive,nActive+nW, nActive+nW,nS, WdagOP);
+			Os.set(nActive+nW,nS, nActive,nActive+nW, dagger(WdagOP));
+			Os.set(nActive+nW,nS, nActive+nW,nS, P ^ OP);
+			Hs.set(0,nActive, nActive+nW,nS, CadagHP);
+			Hs.set(nActive+nW,nS, 0,nActive, dagger(CadagHP));
+			Hs.set(nActive,nActive+nW, nActive+nW,nS, WdagHP);
+			Hs.set(nActive+nW,nS, nActive,nActive+nW, dagger(WdagHP));
+			Hs.set(nActive+nW,nS, nActive+nW,nS, P ^ HP);
+			//Restart without P if it has become nearly linearly dependent on [Ca,W]:
+			matrix Os_evecs; diagMatrix Os_eigs;
+			Os.diagonalize(Os_evecs, Os_eigs);
+			if(Os_eigs.front() < 1e-10*Os_eigs.back())
+			{	nS -= nP; nP = 0;
+				Os = Os(0,nS, 0,nS);
+				Hs = Hs(0,nS, 0,nS);
+				P.free(); HP.free(); VdagP.clear();
+			}
+		}
+		//Rayleigh-Ritz on the active block:
+		matrix U = eVars.orthoMatrix(Os);
+		Hs = dagger_symmetrize(dagger(U) * Hs * U); //switch to an orthonormalized basis
+		matrix Hs_evecs; diagMatrix Hs_eigs;
+		Hs.diagonalize(Hs_evecs, Hs_eigs);
+		matrix rot = U * Hs_evecs(0,nS, 0,nActive); //rotation from [Ca,W,P] to the lowest nActive Ritz vectors
+		matrix rotC = rot(0,nActive, 0,nActive), rotW = rot(nActive,nActive+nW, 0,nActive);
+		//--- new search directions: component of the update from [W,P]
+		ColumnBundle Pnew = W * rotW, HPnew = HW * rotW;
+		std::vector<matrix> VdagPnew(VdagW.size());
+		for(size_t sp=0; sp<VdagW.size(); sp++) if(VdagW[sp]) VdagPnew[sp] = VdagW[sp] * rotW;
+		if(nP)
+		{	matrix rotP = rot(nActive+nW,nS, 0,nActive);
+			Pnew += P * rotP;
+			HPnew += HP * rotP;
+			for(size_t sp=0; sp<VdagP.size(); sp++) if(VdagP[sp]) VdagPnew[sp] += VdagP[sp] * rotP;
+		}
+		//--- update active bands:
+		{	ColumnBundle CaNew = Pnew; CaNew += Ca * rotC; setCols(C, active, CaNew);
+			ColumnBundle HCaNew = HPnew; HCaNew += HCa * rotC; setCols(HC, active, HCaNew);
+			for(size_t sp=0; sp<VdagC.size(); sp++) if(VdagC[sp])
+				setCols(VdagC[sp], active, getCols(VdagC[sp], active) * rotC + VdagPnew[sp]);
+			for(int j=0; j<nActive; j++) Hsub_eigs[active[j]] = Hs_eigs[j];
+		}
+		std::swap(P, Pnew);
+		std::swap(HP, HPnew);
+		std::swap(VdagP, VdagPnew);
+		//Print and test convergence
+		double EbandPrev = Eband;
+		Eband = qnum.weight * trace(Hsub_eigs);
+		double dEband = Eband - EbandPrev;
+		logPrintf("BandLOBPCG: Iter: %3d  Eband: %+.15lf  dEband: %le  nActive: %d  t[s]: %9.2lf\n", iter, Eband, dEband, nActive, clock_sec()); fflush(globalLog);
+		if(dEband<0 and fabs(dEband)<mp.energyDiffThreshold)
+		{	logPrintf("BandLOBPCG: Converged (dEband<%le)\n", mp.energyDiffThreshold);
+			break;
+		}
+	}
+	if(iter>mp.nIterations)
+		logPrintf("BandLOBPCG: None of the convergence criteria satisfied after %d iterations.\n", mp.nIterations);
+	fflush(globalLog);
+	
+	//Final Rayleigh-Ritz over all bands (removes residual couplings between locked and active bands):
+	Hsub = dagger_symmetrize(C ^ HC);
+	Hsub.diagonalize(Hsub_evecs, Hsub_eigs);
+	C = C * Hsub_evecs;
+	e.iInfo.project(C, VdagC, &Hsub_evecs);
+	Hsub = Hsub_eigs;
+	Hsub_evecs = I;
+}
@@ -0,0 +1,48 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#ifndef JDFTX_ELECTRONIC_BANDLOBPCG_H
+#define JDFTX_ELECTRONIC_BANDLOBPCG_H
+
+#include <core/Minimize.h>
+
+class Everything;
+
+//! @addtogroup ElecSystem
+//! @{
+
+//! Locally-optimal block preconditioned conjugate gradient (LOBPCG) eigensolver.
+//! Bands whose residuals have converged are soft-locked: they are excluded from the
+//! expansion and the Rayleigh-Ritz step, which then only involves the active block.
+class BandLOBPCG
+{
+public:
+	BandLOBPCG(Everything& e, int q); //!< Construct LOBPCG eigenvalue solver for quantum number q
+	void minimize(); //!< Converge eigenproblem with tolerance set by e.elecMinParams
+	
+private:
+	Everything& e;
+	class ElecVars& eVars;
+	const class ElecInfo& eInfo;
+	int q;  //!< Current quantum number
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_BANDLOBPCG_H
@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Everything.h>
 #include <cstdio>
 #include <cmath>
+#include <set>
 
 #ifdef GPU_ENABLED
 #include <core/GpuUtil.h>
@@ -42,6 +43,8 @@ Basis& Basis::operator=(const Basis& basis)
 	iGarr = basis.iGarr;
 	index = basis.index;
 	head = basis.head;
+	fftSticks = basis.fftSticks;
+	fftPlanes = basis.fftPlanes;
 	return *this;
 }
 
@@ -86,6 +89,25 @@ void Basis::setup(const GridInfo& gInfo, const IonInfo& iInfo, const std::vector
 
 
 
+size_t Basis::hash() const
+{	size_t result = nbasis; //FNV-1a over the FFT-box indices (which determine the G-vectors)
+	for(int i: index)
+	{	result ^= size_t(i);
+		result *= 1099511628211UL;
+	}
+	return result;
+}
+
+bool Basis::share(const Basis& other)
+{	if(index.sharedWith(other.index)) return true; //already shared
+	if(gInfo!=other.gInfo || nbasis!=other.nbasis) return false;
+	if(memcmp(index.data(), other.index.data(), sizeof(int)*nbasis)) return false;
+	iGarr = other.iGarr;
+	index = other.index;
+	return true;
+}
+
+
 void Basis::setup(const GridInfo& gInfo, const IonInfo& iInfo,
 	const std::vector<int>& indexVec, const std::vector< vector3<int> >& iGvec)
 {
@@ -103,5 +125,16 @@ void Basis::setup(const GridInfo& gInfo, const IonInfo& iInfo,
 	for(size_t n=0; n<nbasis; n++)
 		if(iGvec[n].length_squared() < 4) //selects 27 entries (basically [-1,+1]^3)
 			head.push_back(n);
+	
+	//Initialize FFT sticks and planes:
+	int stride1 = gInfo.S[2];
+	int stride0 = gInfo.S[1] * stride1;
+	std::set<int> stickSet, planeSet;
+	for(int i: indexVec)
+	{	stickSet.insert(i / stride1);
+		planeSet.insert(i / stride0);
+	}
+	fftSticks.assign(stickSet.begin(), stickSet.end());
+	fftPlanes.assign(planeSet.begin(), planeSet.end());
 }
 
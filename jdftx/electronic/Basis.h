@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_ELECTRONIC_BASIS_H
 
 #include <core/ManagedMemory.h>
+#include <memory>
 
 class GridInfo;
 class IonInfo;
@@ -29,6 +30,27 @@ class IonInfo;
 //! @addtogroup ElecSystem
 //! @{
 
+//! Reference-counted handle to an index array of a Basis, so that copies of a basis
+//! and bases with identical G-vector sets (eg. of different spin channels) share one copy
+template<typename T, typename ArrayType> class BasisArray
+{	std::shared_ptr<ArrayType> array;
+public:
+	void init(size_t nData) { array = std::make_shared<ArrayType>(); array->init(nData); } //!< allocate a new (unshared) array
+	size_t nData() const { return array ? array->nData() : 0; } //!< number of entries
+	bool sharedWith(const BasisArray& other) const { return array == other.array; } //!< whether this refers to the same data as other
+	const void* id() const { return array.get(); } //!< identity of the underlying data (equal for all sharers)
+	T* data() { return array->data(); } //!< CPU data pointer
+	const T* data() const { return ((const ArrayType&)*array).data(); } //!< const CPU data pointer
+	T* dataPref() { return array->dataPref(); } //!< preferred (GPU if enabled) data pointer
+	const T* dataPref() const { return ((const ArrayType&)*array).dataPref(); } //!< const preferred (GPU if enabled) data pointer
+	#ifdef GPU_ENABLED
+	T* dataGpu() { return array->dataGpu(); } //!< GPU data pointer
+	const T* dataGpu() const { return ((const ArrayType&)*array).dataGpu(); } //!< const GPU data pointer
+	#endif
+	const T* begin() const { return data(); } //!< const pointer to start of array
+	const T* end() const { return data()+nData(); } //!< const pointer just past end of array
+};
+
 //! Wavefunction basis
 class Basis
 {
@@ -37,9 +59,11 @@ public:
 	const IonInfo* iInfo; //!< pointer to the ion information (basis is conceptually ultrasoft-pseudopotential dependent)
 	
 	size_t nbasis; //!< number of basis elements (i.e. G-vectors)
-	IndexVecArray iGarr;
-	IndexArray index;
+	BasisArray<vector3<int>,IndexVecArray> iGarr; //!< integer G-vectors (reciprocal lattice coordinates)
+	BasisArray<int,IndexArray> index; //!< indices of the G-vectors in the full FFT box
 	std::vector<int> head; //!< short list of low G basis locations (used for phase fixing)
+	std::vector<int> fftSticks; //!< distinct lines i1+S1*i0 along the contiguous FFT dimension that contain basis G-vectors (for pruned transforms)
+	std::vector<int> fftPlanes; //!< distinct planes i0 of the FFT box that contain basis G-vectors (for pruned transforms)
 	
 	Basis();
 	Basis(const Basis&); //!< copy by reference
@@ -51,6 +75,16 @@ public:
 	//! Create a custom basis with an arbitrary indexing scheme
 	void setup(const GridInfo& gInfo, const IonInfo& iInfo, const std::vector<int>& indexVec);
 	
+	size_t hash() const; //!< hash of the G-vector set (equal for bases that could share index arrays)
+	
+	//! Switch to the index arrays of other if it has an identical G-vector set on the same grid,
+	//! freeing the ones of this basis (returns whether shared)
+	bool share(const Basis& other);
+	
+	//! Identity of the G-vector set, equal for copies and for bases that share index arrays (see share()),
+	//! so that caches keyed by it (eg. projectors in SpeciesInfo) hold one copy for all such bases
+	const void* id() const { return index.id(); }
+	
 private:
 	void setup(const GridInfo& gInfo, const IonInfo& iInfo,
 		const std::vector<int>& indexVec,
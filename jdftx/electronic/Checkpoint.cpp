@@ -0,0 +1,318 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/Checkpoint.h>
+#include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
+#include <fluid/FluidSolver.h>
+#include <core/H5io.h>
+#include <cstdio>
+
+namespace Checkpoint
+{
+	bool isCheckpointFile(const string& fname)
+	{	return fname.length()>3 && fname.compare(fname.length()-3, 3, ".h5")==0;
+	}
+
+#ifdef HDF5_ENABLED
+
+	const int formatVersion = 1;
+	const char* sectionNames[] = { "fillings", "eigenvals", "wfns", "density", "fluidState" };
+
+	std::set<string> contents(const string& fname)
+	{	hid_t fid = h5openFile(fname, false, false); //independent read-only access, since this is called during command processing
+		std::set<string> result;
+		for(const char* name: sectionNames)
+			if(h5exists(fid, name)) result.insert(name);
+		H5Fclose(fid);
+		return result;
+	}
+
+	int nBands(const string& fname)
+	{	hid_t fid = h5openFile(fname, false, false);
+		int nBands; h5readScalar(fid, "header/nBands", nBands);
+		H5Fclose(fid);
+		return nBands;
+	}
+
+	//Dataset name for wavefunctions / basis of quantum number q
+	inline string qName(const char* prefix, int q)
+	{	ostringstream oss; oss << prefix << q;
+		return oss.str();
+	}
+
+	//Write state-distributed diagonal matrices (fillings / eigenvalues) with one row per state:
+	void writeDiag(hid_t fid, const char* name, const ElecInfo& eInfo, const std::vector<diagMatrix>& M, double scale)
+	{	hsize_t dims[2] = { hsize_t(eInfo.nStates), hsize_t(eInfo.nBands) };
+		hid_t did = h5createDataset(fid, name, H5T_NATIVE_DOUBLE, dims, 2);
+		std::vector<double> buf; buf.reserve((eInfo.qStop-eInfo.qStart)*eInfo.nBands);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			for(int b=0; b<eInfo.nBands; b++)
+				buf.push_back(scale * M[q][b]);
+		h5writeSlab(did, buf.data(), eInfo.qStart, eInfo.qStop);
+		H5Dclose(did);
+	}
+
+	//Write a (spin) density / potential array as a [nComponents,S0,S1,S2] dataset (data replicated on all processes):
+	void writeArray(hid_t gid, const char* name, const ScalarFieldArray& X, const GridInfo& gInfo, int compressLevel)
+	{	if(!X.size()) return;
+		hsize_t dims[4] = { hsize_t(X.size()), hsize_t(gInfo.S[0]), hsize_t(gInfo.S[1]), hsize_t(gInfo.S[2]) };
+		hsize_t chunk[4] = { 1, dims[1], dims[2], dims[3] };
+		if(gInfo.nr > (1<<26)) chunk[1] = 1; //keep chunks well below the 4GB limit
+		hid_t did = h5createDataset(gid, name, H5T_NATIVE_DOUBLE, dims, 4, chunk, compressLevel);
+		for(size_t s=0; s<X.size(); s++)
+			h5writeSlab(did, X[s]->data(), s, mpiWorld->isHead() ? s+1 : s);
+		H5Dclose(did);
+	}
+
+	//Write matrices (replicated on all processes) flattened to a single 1D dataset:
+	void writeMatrices(hid_t gid, const char* name, const std::vector<matrix>& M)
+	{	std::vector<complex> buf;
+		for(const matrix& m: M) buf.insert(buf.end(), m.data(), m.data()+m.nData());
+		hsize_t nData = 2*buf.size();
+		hid_t did = h5createDataset(gid, name, H5T_NATIVE_DOUBLE, &nData, 1);
+		h5writeSlab(did, (const double*)buf.data(), 0, mpiWorld->isHead() ? nData : 0);
+		H5Dclose(did);
+	}
+
+	void write(const Everything& e, string fname, int compressLevel)
+	{	const ElecInfo& eInfo = e.eInfo;
+		const ElecVars& eVars = e.eVars;
+		const GridInfo& gInfo = e.gInfo;
+		hid_t fid = h5openFile(fname, true);
+
+		//Header (everything needed to interpret and validate the rest on restart):
+		hid_t gidHeader = h5createGroup(fid, "header");
+		h5writeScalar(gidHeader, "version", formatVersion);
+		h5writeScalar(gidHeader, "nStates", eInfo.nStates);
+		h5writeScalar(gidHeader, "nBands", eInfo.nBands);
+		h5writeScalar(gidHeader, "nSpinor", eInfo.spinorLength());
+		h5writeScalar(gidHeader, "spinType", int(eInfo.spinType));
+		h5writeScalar(gidHeader, "nDensities", eInfo.nDensities);
+		h5writeScalar(gidHeader, "Ecut", e.cntrl.Ecut);
+		h5writeScalar(gidHeader, "mu", eInfo.mu); //NaN unless at fixed potential
+		hsize_t dims33[2] = { 3, 3 };
+		h5writeVector(gidHeader, "R", &gInfo.R(0,0), dims33, 2); //lattice vectors in columns
+		h5writeVector(gidHeader, "S", &gInfo.S[0], 3);
+		std::vector<vector3<>> k(eInfo.nStates);
+		std::vector<double> weights(eInfo.nStates);
+		std::vector<int> nBasis(eInfo.nStates);
+		for(int q=0; q<eInfo.nStates; q++)
+		{	k[q] = eInfo.qnums[q].k;
+			weights[q] = eInfo.qnums[q].weight;
+			nBasis[q] = e.basis[q].nbasis;
+		}
+		hsize_t dimsK[2] = { hsize_t(eInfo.nStates), 3 };
+		h5writeVector(gidHeader, "k", &k[0][0], dimsK, 2);
+		h5writeVector(gidHeader, "weights", weights);
+		h5writeVector(gidHeader, "nBasis", nBasis);
+		H5Gclose(gidHeader);
+
+		//Fillings (in the same 0 to 2 convention for SpinNone as the fillings file) and eigenvalues:
+		writeDiag(fid, "fillings", eInfo, eVars.F, eInfo.spinType==SpinNone ? 2. : 1.);
+		bool haveEigs = true;
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			if(int(eVars.Hsub_eigs[q].size()) != eInfo.nBands) haveEigs = false;
+		mpiWorld->allReduce(haveEigs, MPIUtil::ReduceLAnd);
+		if(haveEigs) writeDiag(fid, "eigenvals", eInfo, eVars.Hsub_eigs, 1.);
+
+		//Wavefunctions and their G-vector indices, one dataset per state, chunked by bands:
+		hid_t gidWfns = h5createGroup(fid, "wfns");
+		for(int q=0; q<eInfo.nStates; q++)
+		{	const Basis& basis = e.basis[q];
+			hsize_t dimsG[2] = { hsize_t(basis.nbasis), 3 };
+			hid_t didG = h5createDataset(gidWfns, qName("iG", q).c_str(), H5T_NATIVE_INT, dimsG, 2);
+			h5writeSlab(didG, &basis.iGarr.data()[0][0], 0, mpiWorld->isHead() ? basis.nbasis : 0);
+			H5Dclose(didG);
+			hsize_t dims[3] = { hsize_t(eInfo.nBands), hsize_t(basis.nbasis*eInfo.spinorLength()), 2 };
+			hsize_t chunk[3] = { std::min(dims[0], hsize_t(16)), dims[1], 2 };
+			hid_t did = h5createDataset(gidWfns, qName("C", q).c_str(), H5T_NATIVE_DOUBLE, dims, 3, chunk, compressLevel);
+			bool mine = eInfo.isMine(q);
+			h5writeSlab(did, mine ? (const double*)eVars.C[q].data() : (const double*)0, 0, mine ? dims[0] : 0);
+			H5Dclose(did);
+		}
+		H5Gclose(gidWfns);
+
+		//Densities and potentials:
+		hid_t gidDensity = h5createGroup(fid, "density");
+		writeArray(gidDensity, "n", eVars.n, gInfo, compressLevel);
+		writeArray(gidDensity, "tau", eVars.tau, gInfo, compressLevel);
+		writeArray(gidDensity, "Vscloc", eVars.Vscloc, gInfo, compressLevel);
+		writeArray(gidDensity, "Vtau", eVars.Vtau, gInfo, compressLevel);
+		if(eInfo.hasU)
+		{	writeMatrices(gidDensity, "rhoAtom", eVars.rhoAtom);
+			writeMatrices(gidDensity, "U_rhoAtom", eVars.U_rhoAtom);
+		}
+		H5Gclose(gidDensity);
+
+		//Fluid state (opaque, in the fluid solver's own saveState format):
+		if(eVars.fluidSolver)
+		{	std::vector<unsigned char> buf;
+			if(mpiWorld->isHead())
+			{	string tmpName = fname + ".fluidState.tmp";
+				eVars.fluidSolver->saveState(tmpName.c_str());
+				FILE* fp = fopen(tmpName.c_str(), "rb");
+				if(fp)
+				{	fseek(fp, 0, SEEK_END); buf.resize(ftell(fp));
+					fseek(fp, 0, SEEK_SET);
+					if(fread(buf.data(), 1, buf.size(), fp) != buf.size()) buf.clear();
+					fclose(fp);
+				}
+				remove(tmpName.c_str());
+			}
+			size_t nBytes = buf.size();
+			mpiWorld->bcast(nBytes);
+			if(nBytes)
+			{	hsize_t dims[1] = { nBytes };
+				hid_t did = h5createDataset(fid, "fluidState", H5T_NATIVE_UCHAR, dims, 1);
+				h5writeSlab(did, buf.data(), 0, mpiWorld->isHead() ? nBytes : 0);
+				H5Dclose(did);
+			}
+		}
+		H5Fclose(fid);
+	}
+
+	//Open checkpoint for collective reading and check compatibility with current calculation:
+	hid_t openAndCheck(const Everything& e, const string& fname)
+	{	hid_t fid = h5openFile(fname, false);
+		int version, nStates;
+		h5readScalar(fid, "header/version", version);
+		if(version > formatVersion)
+			die("Checkpoint '%s' has format version %d, but this build only supports up to %d.\n", fname.c_str(), version, formatVersion);
+		h5readScalar(fid, "header/nStates", nStates);
+		if(nStates != e.eInfo.nStates)
+			die("Checkpoint '%s' has %d states, but the current calculation has %d.\n", fname.c_str(), nStates, e.eInfo.nStates);
+		return fid;
+	}
+
+	hid_t openDataset(hid_t fid, const string& name, const string& fname)
+	{	hid_t did = h5exists(fid, name.c_str()) ? H5Dopen(fid, name.c_str(), H5P_DEFAULT) : -1;
+		if(did<0) die("Checkpoint '%s' does not contain '%s'.\n", fname.c_str(), name.c_str());
+		return did;
+	}
+
+	void read(const Everything& e, string fname, string name, std::vector<diagMatrix>& M, int nRows)
+	{	const ElecInfo& eInfo = e.eInfo;
+		hid_t fid = openAndCheck(e, fname);
+		hid_t did = openDataset(fid, name, fname);
+		int nBandsIn = h5getDims(did)[1];
+		std::vector<double> buf((eInfo.qStop-eInfo.qStart)*nBandsIn);
+		h5readSlab(did, buf.data(), eInfo.qStart, eInfo.qStop);
+		H5Dclose(did);
+		H5Fclose(fid);
+		M.resize(eInfo.nStates);
+		const double* bufData = buf.data();
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	M[q].assign(nRows, 0.);
+			std::copy(bufData, bufData+std::min(nRows,nBandsIn), M[q].begin());
+			bufData += nBandsIn;
+		}
+	}
+
+	int read(const Everything& e, string fname, std::vector<ColumnBundle>& C)
+	{	const ElecInfo& eInfo = e.eInfo;
+		hid_t fid = openAndCheck(e, fname);
+		int nBandsIn, nSpinorIn; std::vector<int> nBasisIn;
+		h5readScalar(fid, "header/nBands", nBandsIn);
+		h5readScalar(fid, "header/nSpinor", nSpinorIn);
+		h5readVector(fid, "header/nBasis", nBasisIn);
+		if(nSpinorIn != eInfo.spinorLength())
+			die("Checkpoint '%s' has %d spinor components, but the current calculation has %d.\n", fname.c_str(), nSpinorIn, eInfo.spinorLength());
+		for(int q=0; q<eInfo.nStates; q++) //check all states before any collective read
+			if(nBasisIn[q] != int(e.basis[q].nbasis))
+				die("Checkpoint '%s' has %d basis functions for state %d, but the current calculation has %d.\n"
+					"Use 'wavefunction read' with <EcutOld> on a wfns file to change cutoffs or lattice.\n",
+					fname.c_str(), nBasisIn[q], q, int(e.basis[q].nbasis));
+		int nBandsRead = std::min(nBandsIn, eInfo.nBands);
+		for(int q=0; q<eInfo.nStates; q++)
+		{	hid_t did = openDataset(fid, "wfns/"+qName("C", q), fname);
+			bool mine = eInfo.isMine(q);
+			h5readSlab(did, mine ? (double*)C[q].data() : (double*)0, 0, mine ? nBandsRead : 0);
+			H5Dclose(did);
+		}
+		H5Fclose(fid);
+		return nBandsRead;
+	}
+
+	void read(const Everything& e, string fname, string name, ScalarFieldArray& X)
+	{	const GridInfo& gInfo = e.gInfo;
+		hid_t fid = openAndCheck(e, fname);
+		hid_t did = openDataset(fid, "density/"+name, fname);
+		std::vector<hsize_t> dims = h5getDims(did);
+		if(int(dims[0]) != e.eInfo.nDensities)
+			die("Checkpoint '%s' has %d components of %s, but the current calculation needs %d.\n", fname.c_str(), int(dims[0]), name.c_str(), e.eInfo.nDensities);
+		for(int k=0; k<3; k++)
+			if(int(dims[k+1]) != gInfo.S[k])
+				die("Checkpoint '%s' has %s on a %dx%dx%d grid, but the current grid is %dx%dx%d.\n", fname.c_str(), name.c_str(),
+					int(dims[1]), int(dims[2]), int(dims[3]), gInfo.S[0], gInfo.S[1], gInfo.S[2]);
+		X.resize(dims[0]);
+		for(size_t s=0; s<X.size(); s++)
+		{	X[s] = ScalarFieldData::alloc(gInfo);
+			h5readSlab(did, X[s]->data(), s, s+1);
+		}
+		H5Dclose(did);
+		H5Fclose(fid);
+	}
+
+	void read(const Everything& e, string fname, string name, std::vector<matrix>& M)
+	{	hid_t fid = openAndCheck(e, fname);
+		std::vector<double> buf; h5readVector(fid, ("density/"+name).c_str(), buf);
+		H5Fclose(fid);
+		size_t nData = 0;
+		for(const matrix& m: M) nData += m.nData();
+		if(buf.size() != 2*nData)
+			die("Checkpoint '%s' has %zu entries in %s, but %zu were expected.\n", fname.c_str(), buf.size()/2, name.c_str(), nData);
+		const complex* bufData = (const complex*)buf.data();
+		for(matrix& m: M)
+		{	std::copy(bufData, bufData+m.nData(), m.data());
+			bufData += m.nData();
+		}
+	}
+
+	void read(const Everything& e, string fname, FluidSolver& fluidSolver)
+	{	hid_t fid = openAndCheck(e, fname);
+		std::vector<unsigned char> buf; h5readVector(fid, "fluidState", buf);
+		H5Fclose(fid);
+		//Pass through a process-specific temporary file in the fluid solver's own format:
+		ostringstream oss; oss << fname << ".fluidState.tmp" << mpiWorld->iProcess();
+		string tmpName = oss.str();
+		FILE* fp = fopen(tmpName.c_str(), "wb");
+		if(!fp || fwrite(buf.data(), 1, buf.size(), fp) != buf.size())
+			die_alone("Error writing temporary file '%s' for fluid state.\n", tmpName.c_str());
+		fclose(fp);
+		fluidSolver.loadState(tmpName.c_str());
+		remove(tmpName.c_str());
+	}
+
+#else //HDF5_ENABLED
+
+	//Commands prevent checkpoint use without HDF5, so these are never called:
+	#define NO_HDF5 die("Checkpoint files require HDF5 support (CMake option EnableHDF5).\n");
+	std::set<string> contents(const string& fname) { NO_HDF5 }
+	int nBands(const string& fname) { NO_HDF5 }
+	void write(const Everything& e, string fname, int compressLevel) { NO_HDF5 }
+	void read(const Everything& e, string fname, string name, std::vector<diagMatrix>& M, int nRows) { NO_HDF5 }
+	int read(const Everything& e, string fname, std::vector<ColumnBundle>& C) { NO_HDF5 }
+	void read(const Everything& e, string fname, string name, ScalarFieldArray& X) { NO_HDF5 }
+	void read(const Everything& e, string fname, string name, std::vector<matrix>& M) { NO_HDF5 }
+	void read(const Everything& e, string fname, FluidSolver& fluidSolver) { NO_HDF5 }
+	#undef NO_HDF5
+
+#endif //HDF5_ENABLED
+}
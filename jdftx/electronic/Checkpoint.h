@@ -0,0 +1,61 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_CHECKPOINT_H
+#define JDFTX_ELECTRONIC_CHECKPOINT_H
+
+//! @addtogroup Output
+//! @{
+
+/** @file Checkpoint.h
+@brief Self-describing HDF5 checkpoint of the electronic and fluid state
+
+A single file contains a header (lattice, FFT grid, cutoff, k-points and basis sizes),
+the wavefunctions, fillings, eigenvalues, densities and potentials, and the fluid state.
+Each section is read back at the same place in setup as the corresponding raw-binary file,
+whenever the corresponding filename is a checkpoint (see isCheckpointFile).
+Requires HDF5 support (CMake option EnableHDF5).
+*/
+
+#include <core/ScalarFieldArray.h>
+#include <core/matrix.h>
+#include <set>
+
+class Everything;
+class ColumnBundle;
+struct FluidSolver;
+
+namespace Checkpoint
+{
+	bool isCheckpointFile(const string& fname); //!< whether fname refers to a checkpoint (by its .h5 extension)
+	std::set<string> contents(const string& fname); //!< top-level sections present in a checkpoint (called during command processing)
+	int nBands(const string& fname); //!< number of bands stored in a checkpoint (called during command processing)
+
+	//! Write checkpoint collectively from all processes, with optional deflate compression (level 0-9) of the large datasets
+	void write(const Everything& e, string fname, int compressLevel=0);
+
+	void read(const Everything& e, string fname, string name, std::vector<diagMatrix>& M, int nRows); //!< read fillings / eigenvalues (padded with zeroes / truncated to nRows)
+	int read(const Everything& e, string fname, std::vector<ColumnBundle>& C); //!< read wavefunctions into initialized C, and return number of bands read
+	void read(const Everything& e, string fname, string name, ScalarFieldArray& X); //!< read a (spin) density or potential array
+	void read(const Everything& e, string fname, string name, std::vector<matrix>& M); //!< read matrices with pre-initialized dimensions (eg. rhoAtom)
+	void read(const Everything& e, string fname, FluidSolver& fluidSolver); //!< load the fluid state
+}
+
+//! @}
+#endif // JDFTX_ELECTRONIC_CHECKPOINT_H
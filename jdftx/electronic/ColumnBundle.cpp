@@ -19,6 +19,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <electronic/Everything.h>
 #include <electronic/ColumnBundle.h>
+#include <electronic/ColumnBundleOperators_internal.h>
 #include <core/matrix.h>
 #include <core/vector3.h>
 #include <core/Random.h>
@@ -39,6 +40,16 @@ void ColumnBundle::init(int nc, size_t len, const Basis *b, const QuantumNumber*
 	memInit("ColumnBundle", nCols()*colLength(), onGpu); //in base class ManagedMemory
 }
 
+void ColumnBundle::initBorrowed(int nc, size_t len, const Basis *b, const QuantumNumber* q, complex* data)
+{
+	ncols = nc;
+	col_length = len;
+	basis = b;
+	qnum = q;
+	assert(nCols()*colLength() != 0);
+	memBorrow("ColumnBundle", data, nCols()*colLength()); //in base class ManagedMemory
+}
+
 void ColumnBundle::free()
 {	ncols = 0;
 	col_length = 0;
@@ -88,9 +99,16 @@ ColumnBundle& ColumnBundle::operator=(ColumnBundle&& Y)
 ColumnBundle clone(const ColumnBundle& Y)
 {	return Y;
 }
+void cloneInto(const ColumnBundle& X, ColumnBundle& Y)
+{	Y = X; //copy-assignment reuses existing storage of the same size
+}
+
+//Stream counter for the randomize() overloads used by the minimizers, so that successive calls are independent
+//(starts after the stream used for initial wavefunctions):
+static int randomizeStream = 0;
 
 void randomize(ColumnBundle& x)
-{	x.randomize(0, x.nCols());
+{	x.randomize(0, x.nCols(), ++randomizeStream);
 }
 
 double dot(const ColumnBundle& x, const ColumnBundle& y)
@@ -157,47 +175,148 @@ void init(std::vector<ColumnBundle>& Y, int nbundles, int ncols, const Basis* ba
 
 
 // Randomize with a high frequency cutoff of 0.75 hartrees
-void ColumnBundle::randomize(int colStart, int colStop)
+#ifdef GPU_ENABLED
+void randomize_gpu(int nbasis, int colStart, int colStop, int nSpinor, complex* Y,
+	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR, uint32_t key0, uint32_t key1);
+#endif
+void ColumnBundle::randomize(int colStart, int colStop, int stream)
 {	static StopWatch watch("ColumnBundle::randomize"); watch.start();
 	assert(basis->nbasis==colLength() || 2*basis->nbasis==colLength());
-	complex* thisData = data(); //currently only on cpu
 	int nSpinor = colLength()/basis->nbasis;
-	size_t j=0; //basis index
-	for(const vector3<int>& iG: basis->iGarr)
-	{	vector3<> kplusG = iG + qnum->k;
-		double KE = 0.5*dot(kplusG, basis->gInfo->GGT*kplusG);
-		double t = KE/0.75;
-		double sigma = 1.0/((1.0+t*t*t*t*t*t) * basis->gInfo->detR);
-		for(int s=0; s<nSpinor; s++)
-			for(int i=colStart; i<colStop; i++)
-				thisData[index(i,j+s*basis->nbasis)] = Random::normalComplex(sigma);
-		j++;
-	}
+	//Key from state (k-point quantized to make it robust to round-off, and spin) and stream:
+	uint64_t key = Random::hashCombine(0, uint64_t(stream));
+	for(int iDir=0; iDir<3; iDir++)
+		key = Random::hashCombine(key, uint64_t(int64_t(round(qnum->k[iDir] * (1<<30)))));
+	key = Random::hashCombine(key, uint64_t(int64_t(qnum->spin)));
+	uint32_t key0 = uint32_t(key), key1 = uint32_t(key>>32);
+	#ifdef GPU_ENABLED
+	randomize_gpu(basis->nbasis, colStart, colStop, nSpinor, dataGpu(), basis->gInfo->GGT, basis->iGarr.dataGpu(), qnum->k, basis->gInfo->detR, key0, key1);
+	#else
+	threadedLoop(randomize_calc, basis->nbasis,
+		basis->nbasis, colStart, colStop, nSpinor, data(), basis->gInfo->GGT, basis->iGarr.data(), qnum->k, basis->gInfo->detR, key0, key1);
+	#endif
 	watch.stop();
 }
 void randomize(std::vector<ColumnBundle>& Y, const ElecInfo& eInfo)
-{	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-		if(Y[q]) Y[q].randomize(0, Y[q].nCols());
+{	int stream = ++randomizeStream;
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		if(Y[q]) Y[q].randomize(0, Y[q].nCols(), stream);
 }
 
 //--------- Read/write an array of ColumnBundles from/to a file --------------
 
-void ElecInfo::write(const std::vector<ColumnBundle>& Y, const char* fname) const
-{
+//Convert wavefunction data to single precision (real and imaginary parts interleaved) for reduced-precision output
+static std::vector<float> toSinglePrecision(const complex* data, size_t nData)
+{	std::vector<float> out(2*nData);
+	for(size_t i=0; i<nData; i++)
+	{	out[2*i] = float(data[i].real());
+		out[2*i+1] = float(data[i].imag());
+	}
+	return out;
+}
+
+//Source of the stored wavefunctions of the current process in ElecInfo::read: either the file opened
+//collectively by all processes, or a buffer read on its behalf by the aggregator (first process) of its node
+struct WfnsReadSource
+{	bool aggregated;
+	MPIUtil::File fp; //file (if not aggregated)
+	std::vector<char> buf; size_t pos; //data of this process (if aggregated)
+	
+	WfnsReadSource(const char* fname, size_t fsize, long offset, const std::vector<long>& nBytes, bool aggregate, const char* fsizeErrMsg)
+	: aggregated(aggregate and mpiWorld->nProcesses()>1), pos(0)
+	{	if(!aggregated)
+		{	mpiWorld->fopenRead(fp, fname, fsize, fsizeErrMsg);
+			mpiWorld->fseek(fp, offset, SEEK_SET);
+			return;
+		}
+		MPIUtil mpiNode(mpiWorld, MPIUtil::SplitNode);
+		std::vector<int> worldRank(mpiNode.nProcesses(), 0); //world rank of each process on this node
+		worldRank[mpiNode.iProcess()] = mpiWorld->iProcess();
+		mpiNode.allReduceData(worldRank, MPIUtil::ReduceSum);
+		//Check file size from aggregators alone:
+		bool sizeOK = true;
+		if(mpiNode.isHead() and fsize)
+			sizeOK = (fileSize(fname) == off_t(fsize));
+		mpiWorld->allReduce(sizeOK, MPIUtil::ReduceLAnd);
+		if(!sizeOK) die("Length of '%s' does not match the expected %zu bytes (or it could not be opened).\n%s\n", fname, fsize, fsizeErrMsg ? fsizeErrMsg : "");
+		//Aggregator reads the data of each process on its node and sends it over:
+		const size_t blockSize = 1<<30; //limit size of each message
+		buf.resize(nBytes[mpiWorld->iProcess()]);
+		if(mpiNode.isHead())
+		{	std::vector<long> offsets(nBytes.size(), 0); //offset of each process's data in the file
+			for(size_t iProc=1; iProc<nBytes.size(); iProc++)
+				offsets[iProc] = offsets[iProc-1] + nBytes[iProc-1];
+			FILE* fpNode = fopen(fname, "rb");
+			if(!fpNode) die_alone("Error opening file '%s' for reading.\n", fname);
+			std::vector<char> bufOther;
+			for(int iNode=0; iNode<mpiNode.nProcesses(); iNode++)
+			{	int iProc = worldRank[iNode];
+				std::vector<char>& bufCur = iNode ? bufOther : buf;
+				bufCur.resize(nBytes[iProc]);
+				fseek(fpNode, offsets[iProc], SEEK_SET);
+				if(fread(bufCur.data(), 1, bufCur.size(), fpNode) != bufCur.size())
+					die_alone("Error reading file '%s'.\n", fname);
+				if(iNode)
+					for(size_t start=0; start<bufCur.size(); start+=blockSize)
+						mpiNode.send((const char*)bufCur.data()+start, std::min(blockSize, bufCur.size()-start), iNode, 0);
+			}
+			fclose(fpNode);
+		}
+		else
+			for(size_t start=0; start<buf.size(); start+=blockSize)
+				mpiNode.recv(buf.data()+start, std::min(blockSize, buf.size()-start), 0, 0);
+	}
+	
+	void read(void* ptr, size_t size, size_t nmemb)
+	{	if(!aggregated) { mpiWorld->fread(ptr, size, nmemb, fp); return; }
+		assert(pos + size*nmemb <= buf.size());
+		memcpy(ptr, buf.data()+pos, size*nmemb);
+		convertFromLE(ptr, size, nmemb);
+		pos += size*nmemb;
+	}
+	
+	void skip(long nBytesSkip)
+	{	if(aggregated) pos += nBytesSkip;
+		else mpiWorld->fseek(fp, nBytesSkip, SEEK_CUR);
+	}
+	
+	~WfnsReadSource()
+	{	if(!aggregated) mpiWorld->fclose(fp);
+	}
+};
+
+//Read data of Y, stored in double or single precision
+static void freadData(ColumnBundle& Y, WfnsReadSource& src, bool singlePrecision)
+{	if(!singlePrecision) { src.read(Y.data(), sizeof(complex), Y.nData()); return; }
+	std::vector<float> buf(2*Y.nData());
+	src.read(buf.data(), sizeof(float), buf.size());
+	complex* Ydata = Y.data();
+	for(size_t i=0; i<Y.nData(); i++)
+		Ydata[i] = complex(buf[2*i], buf[2*i+1]);
+}
+
+void ElecInfo::write(const std::vector<ColumnBundle>& Y, const char* fname, bool singlePrecision) const
+{	size_t bytesPerEntry = singlePrecision ? 2*sizeof(float) : sizeof(complex);
 #if MPI_SAFE_WRITE
 	//Safe mode / write from head:
 	if(mpiWorld->isHead())
 	{	FILE* fp = fopen(fname, "w");
 		if(!fp) die_alone("Error opening file '%s' for writing.\n", fname);
 		for(int q=0; q<nStates; q++)
-		{	if(!isMine(q))
-			{	size_t nData = 0;
-				mpiWorld->recv(nData, whose(q), q);
-				ManagedArray<complex> buf; buf.init(nData);
+		{	ManagedArray<complex> buf;
+			const complex* data = 0; size_t nData = 0;
+			if(!isMine(q))
+			{	mpiWorld->recv(nData, whose(q), q);
+				buf.init(nData);
 				mpiWorld->recvData(buf, whose(q), q);
-				buf.write(fp);
+				data = buf.data();
 			}
-			else Y[q].write(fp);
+			else { data = Y[q].data(); nData = Y[q].nData(); }
+			if(singlePrecision)
+			{	std::vector<float> bufSingle = toSinglePrecision(data, nData);
+				fwriteLE(bufSingle.data(), sizeof(float), bufSingle.size(), fp);
+			}
+			else fwriteLE(data, sizeof(complex), nData, fp);
 		}
 		fclose(fp);
 	}
@@ -210,7 +329,7 @@ void ElecInfo::write(const std::vector<ColumnBundle>& Y, const char* fname) cons
 	//Compute output length from each process:
 	std::vector<long> nBytes(mpiWorld->nProcesses(), 0); //total bytes to be written on each process
 	for(int q=qStart; q<qStop; q++)
-		nBytes[mpiWorld->iProcess()] += Y[q].nData()*sizeof(complex);
+		nBytes[mpiWorld->iProcess()] += Y[q].nData()*bytesPerEntry;
 	//Sync nBytes across processes:
 	if(mpiWorld->nProcesses()>1)
 		for(int iSrc=0; iSrc<mpiWorld->nProcesses(); iSrc++)
@@ -225,7 +344,9 @@ void ElecInfo::write(const std::vector<ColumnBundle>& Y, const char* fname) cons
 	MPIUtil::File fp; mpiWorld->fopenWrite(fp, fname);
 	mpiWorld->fseek(fp, offset, SEEK_SET);
 	for(int q=qStart; q<qStop; q++)
-		mpiWorld->fwriteData(Y[q], fp);
+	{	if(singlePrecision) mpiWorld->fwriteData(toSinglePrecision(Y[q].data(), Y[q].nData()), fp);
+		else mpiWorld->fwriteData(Y[q], fp);
+	}
 	mpiWorld->fclose(fp);
 #endif
 }
@@ -263,31 +384,26 @@ void ElecInfo::read(std::vector<ColumnBundle>& Y, const char *fname, const Colum
 		}
 	}
 	else
-	{	//Check if a conversion is actually needed:
-		std::vector<ColumnBundle> Ytmp(qStop);
+	{	//Determine stored layout and whether a conversion is needed:
+		//(temporaries are created one k-point at a time during the read, to limit memory usage in post-processing)
+		std::vector<int> nColsIn(qStop);
 		std::vector<Basis> basisTmp(qStop);
 		std::vector<long> nBytes(mpiWorld->nProcesses(), 0); //total bytes to be read on each process
 		for(int q=qStart; q<qStop; q++)
-		{	bool needTmp = false, customBasis = false;
-			int nCols = Y[q].nCols();
+		{	nColsIn[q] = Y[q].nCols();
+			bool customBasis = false;
 			if(conversion)
-			{	if(conversion->nBandsOld && conversion->nBandsOld!=nCols)
-				{	nCols = conversion->nBandsOld;
-					needTmp = true;
-				}
+			{	if(conversion->nBandsOld) nColsIn[q] = conversion->nBandsOld;
 				double EcutOld = conversion->EcutOld ? conversion->EcutOld : conversion->Ecut;
 				customBasis = (EcutOld!=conversion->Ecut);
 				if(customBasis)
-				{	needTmp = true;
-					logSuspend();
+				{	logSuspend();
 					basisTmp[q].setup(*(Y[q].basis->gInfo), *(Y[q].basis->iInfo), EcutOld, Y[q].qnum->k);
 					logResume();
 				}
 			}
 			const Basis* basis = customBasis ? &basisTmp[q] : Y[q].basis;
-			int nSpinor = Y[q].spinorLength();
-			if(needTmp) Ytmp[q].init(nCols, basis->nbasis*nSpinor, basis, Y[q].qnum);
-			nBytes[mpiWorld->iProcess()] += nCols * basis->nbasis*nSpinor * sizeof(complex);
+			nBytes[mpiWorld->iProcess()] += nColsIn[q] * basis->nbasis*Y[q].spinorLength() * sizeof(complex);
 		}
 		//Sync nBytes:
 		if(mpiWorld->nProcesses()>1)
@@ -299,30 +415,42 @@ void ElecInfo::read(std::vector<ColumnBundle>& Y, const char *fname, const Colum
 		{	if(iSrc<mpiWorld->iProcess()) offset += nBytes[iSrc];
 			fsize += nBytes[iSrc];
 		}
-		//Read data into Ytmp or Y as appropriate, and convert if necessary:
-		MPIUtil::File fp; mpiWorld->fopenRead(fp, fname, fsize,
+		//Detect single-precision files (see write) by their length:
+		bool singlePrecision = false;
+		if(fsize)
+		{	off_t fsizeActual = mpiWorld->isHead() ? fileSize(fname) : 0;
+			mpiWorld->bcast(fsizeActual);
+			if(fsizeActual == fsize/2)
+			{	singlePrecision = true;
+				fsize /= 2; offset /= 2;
+				for(long& n: nBytes) n /= 2;
+				logPrintf("(single precision) "); logFlush();
+			}
+		}
+		//Read data into Y directly or via a temporary, and convert if necessary:
+		WfnsReadSource src(fname, fsize, offset, nBytes, e->cntrl.readAggregate,
 			(e->vibrations and qnums.size()>1)
 			? "Hint: Vibrations requires wavefunctions without symmetries:\n"
 				"either don't read in state, or consider using phonon instead.\n"
 			: "Hint: Did you specify the correct nBandsOld, EcutOld and kdepOld?\n");
-		mpiWorld->fseek(fp, offset, SEEK_SET);
 		for(int q=qStart; q<qStop; q++)
-		{	ColumnBundle& Ycur = Ytmp[q] ? Ytmp[q] : Y[q];
-			mpiWorld->freadData(Ycur, fp);
-			if(Ytmp[q]) //apply conversions:
-			{	if(Ytmp[q].basis!=Y[q].basis)
-				{	int nSpinor = Y[q].spinorLength();
-					for(int b=0; b<std::min(Y[q].nCols(), Ytmp[q].nCols()); b++)
-						for(int s=0; s<nSpinor; s++)
-							Y[q].setColumn(b,s, Ytmp[q].getColumn(b,s)); //convert using the full G-space as an intermediate
-				}
-				else
-				{	if(Ytmp[q].nCols()<Y[q].nCols()) Y[q].setSub(0, Ytmp[q]);
-					else Y[q] = Ytmp[q].getSub(0, Y[q].nCols());
-				}
-				Ytmp[q].free();
+		{	if(!basisTmp[q].nbasis && nColsIn[q]>=Y[q].nCols())
+			{	//Same basis, and at least as many bands: read leading bands directly, and skip the rest
+				freadData(Y[q], src, singlePrecision);
+				long nBytesSkip = (nColsIn[q]-Y[q].nCols()) * Y[q].colLength() * (singlePrecision ? 2*sizeof(float) : sizeof(complex));
+				if(nBytesSkip) src.skip(nBytesSkip);
+				continue;
+			}
+			const Basis* basis = basisTmp[q].nbasis ? &basisTmp[q] : Y[q].basis;
+			int nSpinor = Y[q].spinorLength();
+			ColumnBundle Ytmp(nColsIn[q], basis->nbasis*nSpinor, basis, Y[q].qnum);
+			freadData(Ytmp, src, singlePrecision);
+			//Apply conversions:
+			if(Ytmp.basis!=Y[q].basis)
+			{	if(Ytmp.nCols() > Y[q].nCols()) Ytmp = Ytmp.getSub(0, Y[q].nCols()); //drop unused bands before conversion
+				Y[q].setSub(0, switchBasis(Ytmp, *Y[q].basis)); //map by G-vector on the same grid (else via full G-space)
 			}
+			else Y[q].setSub(0, Ytmp); //fewer bands in file (more bands handled above)
 		}
-		mpiWorld->fclose(fp);
 	}
 }
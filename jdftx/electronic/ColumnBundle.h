@@ -54,6 +54,7 @@ public:
 	const Basis *basis;
 
 	void init(int nc, size_t len, const Basis* b, const QuantumNumber* q, bool onGpu=false); //!< constructor helper
+	void initBorrowed(int nc, size_t len, const Basis* b, const QuantumNumber* q, complex* data); //!< refer to externally owned CPU data (eg. node-shared memory, see ManagedMemory::memBorrow) which must outlive this
 	void free(); //!< Force cleanup
 	ColumnBundle(int nc=0, size_t len=0, const Basis* b=NULL, const QuantumNumber* q=NULL, bool onGpu=false);
 	ColumnBundle(const ColumnBundle&); //!< copy constructor
@@ -74,17 +75,39 @@ public:
 	void setColumn(int i, int s, const complexScalarFieldTilde&); //!< Redeuce a full G-space vector and store it as the i'th column and s'th spinor component
 	void accumColumn(int i, int s, const complexScalarFieldTilde&); //!< Redeuce a full G-space vector and accumulate onto the i'th column and s'th spinor component
 	
-	void randomize(int colStart, int colStop); //!< randomize a selected range of columns
+	//! Randomize a selected range of columns using a counter-based generator keyed by (k, spin, stream, column, G-vector),
+	//! so that the result is independent of the thread, GPU and MPI layout; use distinct stream for independent draws
+	void randomize(int colStart, int colStop, int stream=0);
+};
+
+//! Non-owning view of the contiguous columns [colStart,colStop) of a ColumnBundle, to operate on part of a bundle
+//! (eg. blocks of bands) without the copies and allocations of getSub / setSub. The bundle must outlive the view
+//! and must not be reallocated while the view is in use; views of const bundles must only be read from.
+class ColumnBundleView
+{	ColumnBundle* Y;
+	int colStart, ncols;
+public:
+	ColumnBundleView(const ColumnBundle& Y, int colStart, int colStop);
+	explicit ColumnBundleView(const ColumnBundle& Y); //!< view of all columns
+	
+	int nCols() const { return ncols; } //!< number of columns in the view
+	int colOffset() const { return colStart; } //!< index of the first viewed column in the bundle
+	size_t colLength() const { return Y->colLength(); } //!< column length accessor
+	const ColumnBundle& bundle() const { return *Y; } //!< the viewed bundle (for basis, qnum etc.)
+	complex* data() const { return Y->data() + Y->index(colStart,0); } //!< CPU data pointer to the first viewed column
+	complex* dataPref() const { return Y->dataPref() + Y->index(colStart,0); } //!< preferred data pointer to the first viewed column
+	ColumnBundle copy() const { return Y->getSub(colStart, colStart+ncols); } //!< copy of the viewed columns as a ColumnBundle
 };
 
 //! Initialize an array of column bundles (with appropriate wavefunction sizes if ncols, basis, qnum and eInfo are all non-zero)
 void init(std::vector<ColumnBundle>&, int nbundles, int ncols=0, const Basis* basis=0, const ElecInfo* eInfo=0);
 
-void randomize(std::vector<ColumnBundle>&, const ElecInfo& eInfo); //!< randomize an array of columnbundles
+void randomize(std::vector<ColumnBundle>&, const ElecInfo& eInfo); //!< randomize an array of columnbundles (a new stream for each call, which must be made on all processes)
 
 // Used in the CG template Minimize.h
 ColumnBundle clone(const ColumnBundle&);  //! Copies the input
-void randomize(ColumnBundle& x); //!< Initialize to random numbers
+void cloneInto(const ColumnBundle& X, ColumnBundle& Y); //!< Copies X into Y, reusing the storage of Y if it has the right size
+void randomize(ColumnBundle& x); //!< Initialize to random numbers (a new stream for each call)
 double dot(const ColumnBundle& x, const ColumnBundle& y); //!< inner product
 
 
@@ -107,7 +130,7 @@ ColumnBundle operator*(const ColumnBundle &Y, complex s);
 
 //!ColumnBundle with a pending matrix multiply (on the right side)
 struct ColumnBundleMatrixProduct
-{	const ColumnBundle& Y; //!< the ColumnBundle in the product
+{	ColumnBundleView Y; //!< the ColumnBundle (or range of its columns) in the product
 	const matrixScaledTransOp& Mst; //!< the matrix in the product (along with scale and transpose operations, if any)
 	double scale; //!< additional scale factor
 	
@@ -121,10 +144,12 @@ struct ColumnBundleMatrixProduct
 
 	operator ColumnBundle() const; //!apply pending operation and convert to a ColumnBundle
 	void scaleAccumulate(double alpha, double beta, ColumnBundle& YM) const; //!< Perform YM = alpha*this + beta*YM. If empty, YM will be initialized only if beta=0.
+	void scaleAccumulate(double alpha, double beta, const ColumnBundleView& YM) const; //!< Perform YM = alpha*this + beta*YM on viewed columns of matching shape
 private:
 	//! Private constructor: to be used only from specific member and friend functions
-	ColumnBundleMatrixProduct(const ColumnBundle& Y, const matrixScaledTransOp& Mst, double scale=1.) : Y(Y), Mst(Mst), scale(scale) {}
+	ColumnBundleMatrixProduct(const ColumnBundleView& Y, const matrixScaledTransOp& Mst, double scale=1.) : Y(Y), Mst(Mst), scale(scale) {}
 	friend ColumnBundleMatrixProduct operator*(const scaled<ColumnBundle>& sY, const matrixScaledTransOp& Mst);
+	friend ColumnBundleMatrixProduct operator*(const ColumnBundleView& Y, const matrixScaledTransOp& Mst);
 };
 
 //Delay ColumnBundle * matrix and combine it with ColumnBundle accumulate operations when possible:
@@ -135,9 +160,18 @@ ColumnBundle operator+(const ColumnBundleMatrixProduct &XM1, const ColumnBundleM
 ColumnBundle operator-(const ColumnBundleMatrixProduct &XM1, const ColumnBundleMatrixProduct &XM2);
 
 ColumnBundle operator*(const scaled<ColumnBundle>&, const diagMatrix&);
+ColumnBundle& operator*=(ColumnBundle&, const diagMatrix&); //!< in-place column-wise scaling
 matrix operator^(const scaled<ColumnBundle>&, const scaled<ColumnBundle>&); //!< inner product
 vector3<matrix> spinOverlap(const scaled<ColumnBundle> &sY); //!< spin-resolved inner product for a spinorial ColumnBundle
 
+//Operators on ranges of columns (see ColumnBundleView):
+ColumnBundleMatrixProduct operator*(const ColumnBundleView& Y, const matrixScaledTransOp& Mst); //!< pending product of viewed columns with a matrix
+const ColumnBundleView& operator+=(const ColumnBundleView& Y, const ColumnBundleMatrixProduct& XM); //!< accumulate a pending product onto viewed columns
+const ColumnBundleView& operator+=(const ColumnBundleView& Y, const scaled<ColumnBundle>& X); //!< accumulate onto viewed columns
+matrix operator^(const ColumnBundleView&, const ColumnBundleView&); //!< inner product of viewed columns (of equal column lengths)
+matrix operator^(const ColumnBundle&, const ColumnBundleView&); //!< inner product with viewed columns (of equal column lengths)
+matrix operator^(const ColumnBundleView&, const ColumnBundle&); //!< inner product of viewed columns (of equal column lengths)
+
 //------------------------------ Other operators ---------------------------------
 
 //! Return Idag V .* I C (evaluated columnwise)
@@ -145,7 +179,15 @@ vector3<matrix> spinOverlap(const scaled<ColumnBundle> &sY); //!< spin-resolved
 ColumnBundle Idag_DiagV_I(const ColumnBundle& C, const ScalarFieldArray& V);
 ColumnBundle Idag_DiagV_I(const ColumnBundle& C, const std::vector<complexScalarField>& V); //!< Same as above for complex potentials
 
+//! Accumulate Idag V .* I C[i] to VC[i] for several ColumnBundles (eg. k-points) on the same wavefunction grid,
+//! with columns from all of them filling each batch of fftBatchSize transforms (V.size() must be 1 or 2)
+void Idag_DiagV_I_accum(const std::vector<const ColumnBundle*>& C, const ScalarFieldArray& V, const std::vector<ColumnBundle*>& VC);
+
+//! Accumulate Idag V .* I C onto the same columns of VC for the viewed columns of C (VC must be similar to C's bundle)
+void Idag_DiagV_I_accum(const ColumnBundleView& C, const ScalarFieldArray& V, ColumnBundle& VC);
+
 ColumnBundle L(const ColumnBundle &Y); //!< Apply Laplacian
+ColumnBundle L(const ColumnBundleView &Y); //!< Apply Laplacian to viewed columns
 ColumnBundle Linv(const ColumnBundle &Y); //!< Apply Laplacian inverse
 matrix3<> Lstress(const ColumnBundle &Y, const diagMatrix& F); //!< Compute lattice vector derivative of Tr[Y^LYF] (used for KE stress calculation)
 ColumnBundle O(const ColumnBundle &Y, std::vector<matrix>* VdagY=0); //!< Apply overlap (and optionally retrieve pseudopotential projections for later reuse)
@@ -156,7 +198,9 @@ ColumnBundle DD(const ColumnBundle &Y, int iDir, int jDir); //!< Compute second
 void precond_inv_kinetic(ColumnBundle &Y, double KErollover); 
 
 diagMatrix diagDot(const ColumnBundle& X, const ColumnBundle& Y); //!< compute diag(X^Y) efficiently (avoid the off-diagonals)
+diagMatrix diagDot(const ColumnBundleView& X, const ColumnBundleView& Y); //!< diagDot() of viewed columns
 void precond_inv_kinetic_band(ColumnBundle& Y, const diagMatrix& KEref); //!< In-place inverse kinetic preconditioner with band-by-band KE reference (Used by BandDavidson)
+void precond_inv_kinetic_band(const ColumnBundleView& Y, const diagMatrix& KEref); //!< precond_inv_kinetic_band() in-place on viewed columns
 
 ColumnBundle translate(ColumnBundle&&, vector3<> dr); //!< translate a column-bundle by dr in lattice coordinates (destructible input)
 ColumnBundle translate(const ColumnBundle&, vector3<> dr); //!< translate a column-bundle by dr in lattice coordinates (preserve input)
@@ -164,10 +208,25 @@ void translateColumns(ColumnBundle&, const vector3<>* dr); //!< translate each c
 
 ColumnBundle switchBasis(const ColumnBundle&, const Basis&); //!< return wavefunction projected to a different basis
 
+//! In-place complex transforms of howMany contiguous grids of gInfo using batched FFT plans (inverse=true for I, false for Idag).
+//! If bases is specified, grid i holds a wavefunction in basis bases[i], and when GridInfo::fftPruning is set, the transforms
+//! skip lines and planes of the box without basis G-vectors: inverse input must then be zero outside the basis,
+//! and forward output is only valid at the basis G-vectors (as needed for gathering back to the basis).
+void fftBatch(const GridInfo& gInfo, complex* data, int howMany, bool inverse, int nThreads=0, const Basis* const* bases=0);
+
+//! Transform columns [colStart,colStop) of C (all spinor components) to real space together using batched FFTs.
+//! Returns the real-space wavefunctions as contiguous grids, with spinor index varying fastest (i.e. grid (col-colStart)*nSpinor+s).
+ManagedArray<complex> I_batch(const ColumnBundle& C, int colStart, int colStop, int nThreads=0);
+
+//! Transform a batch of real-space grids in the layout returned by I_batch back to reciprocal space (destroying psi)
+//! and accumulate them onto columns [colStart,colStop) of C (i.e. batched version of C.accumColumn(col,s, Idag(psi)))
+void Idag_accum_batch(ManagedArray<complex>& psi, int colStart, int colStop, ColumnBundle& C, int nThreads=0);
+
 //------------------------------ Reductions ---------------------------------
 
 //! Return trace(F*X^Y)
 complex traceinner(const diagMatrix &F, const ColumnBundle &X,const ColumnBundle &Y);
+complex traceinner(const diagMatrix &F, const ColumnBundleView &X, const ColumnBundle &Y); //!< Return trace(F*X^Y) for viewed columns of X
 
 //! Returns diag((I*X)*F*(I*X)^) (Compute density from an orthonormal wavefunction ColumnBundle with some fillings F).
 //! nDensities is the number of scalar field in the output and controls how spin/spinors are handled:
@@ -177,5 +236,8 @@ complex traceinner(const diagMatrix &F, const ColumnBundle &X,const ColumnBundle
 //! If gInfoOut is specified, function ensures that the output is changed to that grid (in case tighter wfns grid is in use)
 ScalarFieldArray diagouterI(const diagMatrix &F,const ColumnBundle &X, int nDensities, const GridInfo* gInfoOut=0);
 
+//! Same as above, but for several sets of weights F at once (sharing the transforms of X), returning one density per set of weights
+std::vector<ScalarFieldArray> diagouterI(const std::vector<const diagMatrix*>& F, const ColumnBundle &X, int nDensities, const GridInfo* gInfoOut=0);
+
 //! @}
 #endif // JDFTX_ELECTRONIC_COLUMNBUNDLE_H
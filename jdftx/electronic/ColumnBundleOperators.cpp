@@ -48,6 +48,19 @@ ColumnBundle& operator*=(ColumnBundle& X, complex s) { scale(s, X); return X; }
 ColumnBundle operator*(complex s, const ColumnBundle &Y) { ColumnBundle sY(Y); sY *= s; return sY; }
 ColumnBundle operator*(const ColumnBundle &Y, complex s) { ColumnBundle sY(Y); sY *= s; return sY; }
 
+//------------------------ Views of column ranges --------------------
+
+ColumnBundleView::ColumnBundleView(const ColumnBundle& Y, int colStart, int colStop)
+: Y((ColumnBundle*)&Y), colStart(colStart), ncols(colStop-colStart)
+{	assert(colStart>=0);
+	assert(colStop<=Y.nCols());
+	assert(ncols>=0);
+}
+
+ColumnBundleView::ColumnBundleView(const ColumnBundle& Y) : ColumnBundleView(Y, 0, Y.nCols())
+{
+}
+
 ColumnBundleMatrixProduct::operator ColumnBundle() const
 {	ColumnBundle YM;
 	scaleAccumulate(1., 0., YM);
@@ -55,6 +68,18 @@ ColumnBundleMatrixProduct::operator ColumnBundle() const
 }
 
 void ColumnBundleMatrixProduct::scaleAccumulate(double alpha, double beta, ColumnBundle& YM) const
+{	const ColumnBundle& Yb = Y.bundle();
+	bool spinorMode = (2*Y.nCols() == Mst.nRows()); //output has twice the column length (see below)
+	if(beta) assert(YM);
+	else //initialize result (note init reuses the existing storage of YM if it has the right size)
+	{	assert(&YM != &Yb); //product cannot be computed in-place
+		if(spinorMode) { assert(!Yb.isSpinor()); YM.init(Mst.nCols(), Y.colLength()*2, Yb.basis, Yb.qnum, isGpuEnabled()); }
+		else YM.init(Mst.nCols(), Y.colLength(), Yb.basis, Yb.qnum, Yb.isOnGpu());
+	}
+	scaleAccumulate(alpha, beta, ColumnBundleView(YM)); //note that beta=0 ignores the uninitialized contents of YM
+}
+
+void ColumnBundleMatrixProduct::scaleAccumulate(double alpha, double beta, const ColumnBundleView& YM) const
 {	static StopWatch watch("Y*M");
 	watch.start();
 	double scaleFac = alpha * scale * Mst.scale;
@@ -73,26 +98,38 @@ void ColumnBundleMatrixProduct::scaleAccumulate(double alpha, double beta, Colum
 		Mdata = Mtmp.dataPref();
 		ldM = Mtmp.nRows();
 		nColsOut = Mtmp.nCols();
-		assert(!Y.isSpinor());
-		if(beta) { assert(YM); assert(YM.nCols()==mIn.nCols()); assert(YM.colLength()==Y.colLength()*2); }
-		else YM.init(mIn.nCols(), Y.colLength()*2, Y.basis, Y.qnum, isGpuEnabled());
+		assert(!Y.bundle().isSpinor());
+		assert(YM.nCols()==mIn.nCols()); assert(YM.colLength()==Y.colLength()*2);
 	}
 	else
 	{	Mop = Mst.op;
 		Mdata = Mst.mat.dataPref() + Mst.index(0,0);
 		ldM = Mst.mat.nRows();
 		nColsOut = Mst.nCols();
-		if(beta) { assert(YM); assert(YM.nCols()==nColsOut); assert(YM.colLength()==Y.colLength()); }
-		else YM = Y.similar(nColsOut);
+		assert(YM.nCols()==nColsOut); assert(YM.colLength()==Y.colLength());
 	}
 	callPref(eblas_zgemm)(CblasNoTrans, Mop, Y.colLength(), nColsOut, Y.nCols(),
 		scaleFac, Y.dataPref(), Y.colLength(), Mdata, ldM,
 		beta, YM.dataPref(), Y.colLength());
+	if(Profiler::active) Profiler::addBytes(sizeof(complex) * (size_t(Y.colLength())*(Y.nCols() + (beta ? 2 : 1)*nColsOut) + size_t(Y.nCols())*nColsOut));
 	watch.stop();
 }
 
 ColumnBundleMatrixProduct operator*(const scaled<ColumnBundle>& sY, const matrixScaledTransOp& Mst)
-{	return ColumnBundleMatrixProduct(sY.data, Mst, sY.scale);
+{	return ColumnBundleMatrixProduct(ColumnBundleView(sY.data), Mst, sY.scale);
+}
+ColumnBundleMatrixProduct operator*(const ColumnBundleView& Y, const matrixScaledTransOp& Mst)
+{	return ColumnBundleMatrixProduct(Y, Mst);
+}
+const ColumnBundleView& operator+=(const ColumnBundleView& Y, const ColumnBundleMatrixProduct& XM)
+{	XM.scaleAccumulate(+1.,1.,Y);
+	return Y;
+}
+const ColumnBundleView& operator+=(const ColumnBundleView& Y, const scaled<ColumnBundle>& X)
+{	assert(X.data.nCols()==Y.nCols());
+	assert(X.data.colLength()==Y.colLength());
+	callPref(eblas_zaxpy)(Y.nCols()*Y.colLength(), X.scale, X.data.dataPref(),1, Y.dataPref(),1);
+	return Y;
 }
 ColumnBundle& operator+=(ColumnBundle& Y, const ColumnBundleMatrixProduct &XM)
 {	XM.scaleAccumulate(+1.,1.,Y);
@@ -121,6 +158,13 @@ ColumnBundle operator*(const scaled<ColumnBundle> &sY, const diagMatrix& d)
 		callPref(eblas_zscal)(Yd.colLength(), sY.scale*d[i], YdData+Yd.index(i,0), 1);
 	return Yd;
 }
+ColumnBundle& operator*=(ColumnBundle& Y, const diagMatrix& d)
+{	assert(Y.nCols()==d.nRows());
+	complex* Ydata = Y.dataPref();
+	for(int i=0; i<d.nCols(); i++)
+		callPref(eblas_zscal)(Y.colLength(), d[i], Ydata+Y.index(i,0), 1);
+	return Y;
+}
 
 matrix operator^(const scaled<ColumnBundle> &sY1, const scaled<ColumnBundle> &sY2)
 {	static StopWatch watch("Y1^Y2");
@@ -147,6 +191,7 @@ matrix operator^(const scaled<ColumnBundle> &sY1, const scaled<ColumnBundle> &sY
 	callPref(eblas_zgemm)(CblasConjTrans, CblasNoTrans, nCols1, nCols2, colLength,
 		scaleFac, Y1.dataPref(), colLength, Y2.dataPref(), colLength,
 		0.0, Y1dY2.dataPref(), Y1dY2.nRows());
+	if(Profiler::active) Profiler::addBytes(sizeof(complex) * (size_t(colLength)*(nCols1 + nCols2) + size_t(nCols1)*nCols2));
 	watch.stop();
 	//If one of the columnbundles was spinor, shape the matrix as if the non-spinor columnbundle had consecutive spinor columns with identical pure up and down spinors
 	if(Y1.nCols() != nCols1) //Y1 is spinor, so double the dimension of output along Y2
@@ -164,6 +209,22 @@ matrix operator^(const scaled<ColumnBundle> &sY1, const scaled<ColumnBundle> &sY
 	else return Y1dY2; //normal mode (neither is a spinor)
 }
 
+matrix operator^(const ColumnBundleView& Y1, const ColumnBundleView& Y2)
+{	static StopWatch watch("Y1^Y2");
+	watch.start();
+	assert(Y1.colLength() == Y2.colLength());
+	size_t colLength = Y1.colLength();
+	matrix Y1dY2(Y1.nCols(), Y2.nCols(), isGpuEnabled());
+	callPref(eblas_zgemm)(CblasConjTrans, CblasNoTrans, Y1.nCols(), Y2.nCols(), colLength,
+		1., Y1.dataPref(), colLength, Y2.dataPref(), colLength,
+		0.0, Y1dY2.dataPref(), Y1dY2.nRows());
+	if(Profiler::active) Profiler::addBytes(sizeof(complex) * (colLength*(Y1.nCols() + Y2.nCols()) + size_t(Y1.nCols())*Y2.nCols()));
+	watch.stop();
+	return Y1dY2;
+}
+matrix operator^(const ColumnBundle& Y1, const ColumnBundleView& Y2) { return ColumnBundleView(Y1) ^ Y2; }
+matrix operator^(const ColumnBundleView& Y1, const ColumnBundle& Y2) { return Y1 ^ ColumnBundleView(Y2); }
+
 vector3<matrix> spinOverlap(const scaled<ColumnBundle> &sY)
 {	const ColumnBundle& Y = sY.data;
 	double scaleFac = std::pow(sY.scale, 2) * Y.basis->gInfo->detR; //norm conserving part of O
@@ -193,28 +254,156 @@ vector3<matrix> spinOverlap(const scaled<ColumnBundle> &sY)
 }
 
 
+//------------------------------ Batched transforms ---------------------------------
+
+#ifndef GPU_ENABLED
+//In-place complex transform of one grid holding a wavefunction in basis, as a sequence of 1D transforms that skip
+//lines along dimension 2 and planes along dimension 1 without basis G-vectors (QE-style 'sticks').
+//The inverse requires data to be zero outside the basis, and the forward is only valid at the basis G-vectors.
+void fftPruned(const Basis& basis, complex* data, bool inverse)
+{	const GridInfo& gInfo = *(basis.gInfo);
+	const vector3<int>& S = gInfo.S;
+	size_t stride0 = size_t(S[1])*S[2];
+	fftw_complex* fData = (fftw_complex*)data;
+	fftw_plan plan2 = gInfo.getPlanPruned(2, !inverse);
+	fftw_plan plan1 = gInfo.getPlanPruned(1, !inverse);
+	fftw_plan plan0 = gInfo.getPlanPruned(0, !inverse);
+	if(inverse) //sticks, then planes, then the whole grid:
+	{	for(int stick: basis.fftSticks) fftw_execute_dft(plan2, fData+size_t(stick)*S[2], fData+size_t(stick)*S[2]);
+		for(int plane: basis.fftPlanes) fftw_execute_dft(plan1, fData+plane*stride0, fData+plane*stride0);
+		fftw_execute_dft(plan0, fData, fData);
+	}
+	else //reverse order, computing only the lines that contribute to the basis:
+	{	fftw_execute_dft(plan0, fData, fData);
+		for(int plane: basis.fftPlanes) fftw_execute_dft(plan1, fData+plane*stride0, fData+plane*stride0);
+		for(int stick: basis.fftSticks) fftw_execute_dft(plan2, fData+size_t(stick)*S[2], fData+size_t(stick)*S[2]);
+	}
+}
+void fftPruned_sub(size_t iStart, size_t iStop, const Basis* const* bases, complex* data, bool inverse)
+{	for(size_t i=iStart; i<iStop; i++)
+		fftPruned(*bases[i], data+i*bases[i]->gInfo->nr, inverse);
+}
+#endif
+
+//In-place complex transforms of howMany contiguous grids, using batched FFT plans:
+void fftBatch(const GridInfo& gInfo, complex* data, int howMany, bool inverse, int nThreads, const Basis* const* bases)
+{	static int profileId = Profiler::registerName("FFT");
+	ProfileRegion profile(profileId, 2*sizeof(complex)*size_t(howMany)*gInfo.nr);
+	#ifdef GPU_ENABLED
+	cufftExecZ2Z(gInfo.getPlanZ2Zmany(howMany), (double2*)data, (double2*)data, inverse ? CUFFT_INVERSE : CUFFT_FORWARD);
+	#else
+	if(!nThreads) nThreads = shouldThreadOperators() ? nProcsAvailable : 1;
+	if(bases && gInfo.fftPruning && !gInfo.fftSinglePrecision) //pruned transforms, threaded over grids:
+	{	if(nThreads > 1 && howMany > 1) threadLaunch(std::min(nThreads, howMany), fftPruned_sub, howMany, bases, data, inverse);
+		else fftPruned_sub(0, howMany, bases, data, inverse);
+		return;
+	}
+	#ifdef FFTW_SINGLE_ENABLED
+	if(gInfo.fftSinglePrecision) //round to single precision, transform and convert back:
+	{	size_t N = size_t(howMany)*gInfo.nr;
+		fftwf_complex* dataSingle = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*N);
+		const double* in = (const double*)data;
+		for(size_t i=0; i<2*N; i++) ((float*)dataSingle)[i] = float(in[i]);
+		fftwf_execute_dft(gInfo.getPlanSingle(!inverse, nThreads, howMany), dataSingle, dataSingle);
+		double* out = (double*)data;
+		for(size_t i=0; i<2*N; i++) out[i] = ((const float*)dataSingle)[i];
+		fftwf_free(dataSingle);
+		return;
+	}
+	#endif
+	fftw_execute_dft(gInfo.getPlan(inverse ? GridInfo::PlanInverseInPlace : GridInfo::PlanForwardInPlace, nThreads, howMany),
+		(fftw_complex*)data, (fftw_complex*)data);
+	#endif
+}
+
+ManagedArray<complex> I_batch(const ColumnBundle& C, int colStart, int colStop, int nThreads)
+{	const Basis& basis = *(C.basis);
+	const GridInfo& gInfo = *(basis.gInfo);
+	int nSpinor = C.spinorLength();
+	int howMany = (colStop-colStart)*nSpinor;
+	ManagedArray<complex> psi; psi.init(size_t(howMany)*gInfo.nr, isGpuEnabled());
+	psi.zero();
+	complex* psiData = psi.dataPref();
+	for(int col=colStart; col<colStop; col++)
+		for(int s=0; s<nSpinor; s++)
+			callPref(eblas_scatter_zdaxpy)(basis.nbasis, 1., basis.index.dataPref(), C.dataPref()+C.index(col,s*basis.nbasis),
+				psiData + size_t((col-colStart)*nSpinor+s)*gInfo.nr);
+	std::vector<const Basis*> bases(howMany, &basis);
+	fftBatch(gInfo, psiData, howMany, true, nThreads, bases.data());
+	return psi;
+}
+
+void Idag_accum_batch(ManagedArray<complex>& psi, int colStart, int colStop, ColumnBundle& C, int nThreads)
+{	const Basis& basis = *(C.basis);
+	const GridInfo& gInfo = *(basis.gInfo);
+	int nSpinor = C.spinorLength();
+	int howMany = (colStop-colStart)*nSpinor;
+	assert(psi.nData() == size_t(howMany)*gInfo.nr);
+	complex* psiData = psi.dataPref();
+	std::vector<const Basis*> bases(howMany, &basis);
+	fftBatch(gInfo, psiData, howMany, false, nThreads, bases.data());
+	for(int col=colStart; col<colStop; col++)
+		for(int s=0; s<nSpinor; s++)
+			callPref(eblas_gather_zdaxpy)(basis.nbasis, 1., basis.index.dataPref(),
+				psiData + size_t((col-colStart)*nSpinor+s)*gInfo.nr, C.dataPref()+C.index(col,s*basis.nbasis));
+}
+
+//Multiply each of the grids in a batch by a potential:
+inline void mulBatch(const ScalarField& V, ManagedArray<complex>& psi)
+{	int nr = V->gInfo.nr;
+	for(size_t offset=0; offset<psi.nData(); offset+=nr)
+		callPref(eblas_zmuld)(nr, V->dataPref(), 1, psi.dataPref()+offset, 1);
+}
+inline void mulBatch(const complexScalarField& V, ManagedArray<complex>& psi)
+{	int nr = V->gInfo.nr;
+	for(size_t offset=0; offset<psi.nData(); offset+=nr)
+		callPref(eblas_zmul)(nr, V->dataPref(), 1, psi.dataPref()+offset, 1);
+}
+
 //------------------------------ Other operators ---------------------------------
 
 template<typename ScalarFieldType> //templated over ScalarField and complexScalarField
-void Idag_DiagV_I_sub(int colStart, int colEnd, const ColumnBundle* C, const std::vector<ScalarFieldType>* V, ColumnBundle* VC)
-{	const ScalarFieldType& Vs = V->at(V->size()==1 ? 0 : C->qnum->index());
+void Idag_DiagV_I_sub(int colStart, int colEnd, int colOffset, const ColumnBundle* C, const std::vector<ScalarFieldType>* V, ColumnBundle* VC)
+{	colStart += colOffset; colEnd += colOffset; //column range relative to the bundle
+	const ScalarFieldType& Vs = V->at(V->size()==1 ? 0 : C->qnum->index());
 	int nSpinor = VC->spinorLength();
+	const GridInfo& gInfo = *(C->basis->gInfo);
+	int batchSize = gInfo.fftBatchSize;
+	if(batchSize > 1 || gInfo.fftSinglePrecision //single-precision transforms are only implemented in the batched path
+		|| gInfo.fftPruning) //as are pruned transforms
+	{	for(int colBatch=colStart; colBatch<colEnd; colBatch+=batchSize)
+		{	int colBatchEnd = std::min(colBatch+batchSize, colEnd);
+			ManagedArray<complex> psi = I_batch(*C, colBatch, colBatchEnd);
+			mulBatch(Vs, psi);
+			Idag_accum_batch(psi, colBatch, colBatchEnd, *VC); //accumulates onto VC
+		}
+		return;
+	}
 	for(int col=colStart; col<colEnd; col++)
 		for(int s=0; s<nSpinor; s++)
-			VC->accumColumn(col,s, Idag(Vs * I(C->getColumn(col,s)))); //note VC is zero'd just before
+			VC->accumColumn(col,s, Idag(Vs * I(C->getColumn(col,s)))); //accumulates onto VC
 }
 
-//Noncollinear version of above (with the preprocessing of complex off-diagonal potentials done in calling function)
+//Noncollinear version of above (with the preprocessing of complex off-diagonal potentials done in calling function).
+//Both spinor components of a batch of columns are transformed together, and the 2x2 potential is applied in one pass per column.
 template<typename ScalarFieldType> //templated over ScalarField and complexScalarField
-void Idag_DiagVmat_I_sub(int colStart, int colEnd, const ColumnBundle* C,
+void Idag_DiagVmat_I_sub(int colStart, int colEnd, int colOffset, const ColumnBundle* C,
 	const ScalarFieldType* Vup, const ScalarFieldType* Vdn, //typically real, complex only for finite q uses
 	const complexScalarField* VupDn, const complexScalarField* VdnUp, //always complex
 	ColumnBundle* VC)
-{	for(int col=colStart; col<colEnd; col++)
-	{	complexScalarField ICup = I(C->getColumn(col,0));
-		complexScalarField ICdn = I(C->getColumn(col,1));
-		VC->accumColumn(col,0, Idag((*Vup)*ICup + (*VupDn)*ICdn));
-		VC->accumColumn(col,1, Idag((*Vdn)*ICdn + (*VdnUp)*ICup));
+{	colStart += colOffset; colEnd += colOffset; //column range relative to the bundle
+	const GridInfo& gInfo = *(C->basis->gInfo);
+	int nr = gInfo.nr;
+	int batchSize = std::max(1, gInfo.fftBatchSize);
+	for(int colBatch=colStart; colBatch<colEnd; colBatch+=batchSize)
+	{	int colBatchEnd = std::min(colBatch+batchSize, colEnd);
+		ManagedArray<complex> psi = I_batch(*C, colBatch, colBatchEnd); //up and down grids of each column are adjacent
+		complex* psiData = psi.dataPref();
+		for(int col=colBatch; col<colBatchEnd; col++)
+		{	complex* psiUp = psiData + size_t(2*(col-colBatch))*nr;
+			callPref(eblas_spinorMul)(nr, (*Vup)->dataPref(), (*Vdn)->dataPref(), (*VupDn)->dataPref(), (*VdnUp)->dataPref(), psiUp, psiUp+nr);
+		}
+		Idag_accum_batch(psi, colBatch, colBatchEnd, *VC); //accumulates onto VC
 	}
 }
 
@@ -230,10 +419,12 @@ inline void getVupDn(const complexScalarField& Vre, const complexScalarField& Vi
 	VdnUp = 0.5*Complex(reVre+imVim, imVre-reVim); //note not conj(VupDn) because Vre and Vim are each complex
 }
 
+//Accumulate Idag V .* I C onto VC for columns [colStart,colStop) of C:
 template<typename ScalarFieldType> //templated over ScalarField and complexScalarField
-ColumnBundle Idag_DiagV_I_apply(const ColumnBundle& C, const std::vector<ScalarFieldType>& V)
+void Idag_DiagV_I_apply(const ColumnBundle& C, int colStart, int colStop, const std::vector<ScalarFieldType>& V, ColumnBundle& VC)
 {	static StopWatch watch("Idag_DiagV_I"); watch.start();
-	ColumnBundle VC = C.similar(); VC.zero();
+	assert(VC.nCols()==C.nCols() && VC.colLength()==C.colLength());
+	int nCols = colStop - colStart;
 	//Convert V to wfns grid if necessary:
 	const GridInfo& gInfoWfns = *(C.basis->gInfo);
 	std::vector<ScalarFieldType> Vtmp;
@@ -244,23 +435,101 @@ ColumnBundle Idag_DiagV_I_apply(const ColumnBundle& C, const std::vector<ScalarF
 	assert(Vwfns.size()==1 || Vwfns.size()==2 || Vwfns.size()==4);
 	if(Vwfns.size()==2) assert(!C.isSpinor());
 	if(Vwfns.size()==1 || Vwfns.size()==2)
-	{	threadLaunch(isGpuEnabled()?1:0, Idag_DiagV_I_sub<ScalarFieldType>, C.nCols(), &C, &Vwfns, &VC);
+	{	for(const ScalarFieldType& Vs: Vwfns) Vs->dataPref(); //absorb scale factors before threads access the data
+		int chunkSize = std::max(1, gInfoWfns.fftBatchSize);
+		threadLaunchDynamic(isGpuEnabled()?1:0, Idag_DiagV_I_sub<ScalarFieldType>, nCols, chunkSize, colStart, &C, &Vwfns, &VC);
 	}
 	else //Vwfns.size()==4
 	{	assert(C.isSpinor());
 		complexScalarField VupDn, VdnUp;
 		getVupDn(Vwfns[2], Vwfns[3], VupDn, VdnUp);
-		threadLaunch(isGpuEnabled()?1:0, Idag_DiagVmat_I_sub<ScalarFieldType>, C.nCols(), &C, &Vwfns[0], &Vwfns[1], &VupDn, &VdnUp, &VC);
+		Vwfns[0]->dataPref(); Vwfns[1]->dataPref(); //absorb scale factors before threads access the data
+		VupDn->dataPref(); VdnUp->dataPref();
+		int chunkSize = std::max(1, gInfoWfns.fftBatchSize);
+		threadLaunchDynamic(isGpuEnabled()?1:0, Idag_DiagVmat_I_sub<ScalarFieldType>, nCols, chunkSize, colStart, &C, &Vwfns[0], &Vwfns[1], &VupDn, &VdnUp, &VC);
 	}
 	watch.stop();
-	return VC;
 }
 //Specialize template above for the two allowed cases:
 ColumnBundle Idag_DiagV_I(const ColumnBundle& C, const ScalarFieldArray& V)
-{	return Idag_DiagV_I_apply<ScalarField>(C, V); 
+{	ColumnBundle VC = C.similar(); VC.zero();
+	Idag_DiagV_I_apply<ScalarField>(C, 0, C.nCols(), V, VC);
+	return VC;
 }
 ColumnBundle Idag_DiagV_I(const ColumnBundle& C, const std::vector<complexScalarField>& V)
-{	return Idag_DiagV_I_apply<complexScalarField>(C, V);
+{	ColumnBundle VC = C.similar(); VC.zero();
+	Idag_DiagV_I_apply<complexScalarField>(C, 0, C.nCols(), V, VC);
+	return VC;
+}
+void Idag_DiagV_I_accum(const ColumnBundleView& C, const ScalarFieldArray& V, ColumnBundle& VC)
+{	if(C.nCols()) Idag_DiagV_I_apply<ScalarField>(C.bundle(), C.colOffset(), C.colOffset()+C.nCols(), V, VC);
+}
+
+void Idag_DiagV_I_accum(const std::vector<const ColumnBundle*>& C, const ScalarFieldArray& V, const std::vector<ColumnBundle*>& VC)
+{	static StopWatch watch("Idag_DiagV_I_accum"); watch.start();
+	assert(C.size() == VC.size());
+	if(!C.size()) { watch.stop(); return; }
+	//Convert V to wfns grid if necessary:
+	const GridInfo& gInfoWfns = *(C[0]->basis->gInfo);
+	ScalarFieldArray Vtmp;
+	if(&(V[0]->gInfo) != &gInfoWfns)
+		for(const ScalarField& Vs: V)
+			Vtmp.push_back(Jdag(changeGrid(Idag(Vs), gInfoWfns), true));
+	const ScalarFieldArray& Vwfns = Vtmp.size() ? Vtmp : V;
+	assert(Vwfns.size()==1 || Vwfns.size()==2);
+	//Flatten (bundle, column) pairs over all bundles:
+	std::vector< std::pair<int,int> > cols;
+	for(size_t i=0; i<C.size(); i++)
+	{	assert(C[i]->basis->gInfo == &gInfoWfns);
+		assert(!(Vwfns.size()==2 && C[i]->isSpinor()));
+		if(!*VC[i]) { *VC[i] = C[i]->similar(); VC[i]->zero(); }
+		for(int col=0; col<C[i]->nCols(); col++)
+			cols.push_back(std::make_pair(int(i), col));
+	}
+	//Process in batches of transforms spanning bundles:
+	int nr = gInfoWfns.nr;
+	int batchSize = std::max(1, gInfoWfns.fftBatchSize);
+	for(size_t batchStart=0; batchStart<cols.size(); batchStart+=batchSize)
+	{	size_t batchStop = std::min(batchStart+batchSize, cols.size());
+		int howMany = 0;
+		for(size_t b=batchStart; b<batchStop; b++)
+			howMany += C[cols[b].first]->spinorLength();
+		ManagedArray<complex> psi; psi.init(size_t(howMany)*nr, isGpuEnabled());
+		psi.zero();
+		complex* psiData = psi.dataPref();
+		//Scatter and transform to real space:
+		int iGrid = 0;
+		std::vector<const Basis*> bases(howMany);
+		for(size_t b=batchStart; b<batchStop; b++)
+		{	const ColumnBundle& Ci = *C[cols[b].first];
+			const Basis& basis = *(Ci.basis);
+			for(int s=0; s<Ci.spinorLength(); s++)
+			{	bases[iGrid] = &basis;
+				callPref(eblas_scatter_zdaxpy)(basis.nbasis, 1., basis.index.dataPref(), Ci.dataPref()+Ci.index(cols[b].second,s*basis.nbasis),
+					psiData + size_t(iGrid++)*nr);
+			}
+		}
+		fftBatch(gInfoWfns, psiData, howMany, true, 0, bases.data());
+		//Multiply by the potential for each grid's spin channel:
+		iGrid = 0;
+		for(size_t b=batchStart; b<batchStop; b++)
+		{	const ColumnBundle& Ci = *C[cols[b].first];
+			const ScalarField& Vs = Vwfns[Vwfns.size()==1 ? 0 : Ci.qnum->index()];
+			for(int s=0; s<Ci.spinorLength(); s++)
+				callPref(eblas_zmuld)(nr, Vs->dataPref(), 1, psiData + size_t(iGrid++)*nr, 1);
+		}
+		//Transform back and gather to each bundle's basis:
+		fftBatch(gInfoWfns, psiData, howMany, false, 0, bases.data());
+		iGrid = 0;
+		for(size_t b=batchStart; b<batchStop; b++)
+		{	ColumnBundle& VCi = *VC[cols[b].first];
+			const Basis& basis = *(VCi.basis);
+			for(int s=0; s<VCi.spinorLength(); s++)
+				callPref(eblas_gather_zdaxpy)(basis.nbasis, 1., basis.index.dataPref(),
+					psiData + size_t(iGrid++)*nr, VCi.dataPref()+VCi.index(cols[b].second,s*basis.nbasis));
+		}
+	}
+	watch.stop();
 }
 
 
@@ -270,16 +539,20 @@ void reducedL_gpu(int nbasis, int ncols, const complex* Y, complex* LY,
 	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR);
 #endif
 ColumnBundle L(const ColumnBundle &Y)
-{	ColumnBundle LY = Y.similar();
+{	return L(ColumnBundleView(Y));
+}
+ColumnBundle L(const ColumnBundleView &Yv)
+{	const ColumnBundle& Y = Yv.bundle();
+	ColumnBundle LY = Y.similar(Yv.nCols());
 	assert(Y.basis);
 	const Basis& basis = *(Y.basis);
 	const matrix3<>& GGT = basis.gInfo->GGT;
 	int nSpinor = Y.spinorLength();
 	#ifdef GPU_ENABLED
-	reducedL_gpu(basis.nbasis, Y.nCols()*nSpinor, Y.dataGpu(), LY.dataGpu(), GGT, basis.iGarr.dataGpu(), Y.qnum->k, basis.gInfo->detR);
+	reducedL_gpu(basis.nbasis, Yv.nCols()*nSpinor, Yv.dataPref(), LY.dataGpu(), GGT, basis.iGarr.dataGpu(), Y.qnum->k, basis.gInfo->detR);
 	#else
 	threadedLoop(reducedL_calc, basis.nbasis,
-		basis.nbasis, Y.nCols()*nSpinor, Y.data(), LY.data(), GGT, basis.iGarr.data(), Y.qnum->k, basis.gInfo->detR);
+		basis.nbasis, Yv.nCols()*nSpinor, Yv.data(), LY.data(), GGT, basis.iGarr.data(), Y.qnum->k, basis.gInfo->detR);
 	#endif
 	return LY;
 }
@@ -409,13 +682,17 @@ void precond_inv_kinetic(ColumnBundle &Y, double KErollover)
 }
 
 diagMatrix diagDot(const ColumnBundle& X, const ColumnBundle& Y)
+{	assert(X.basis==Y.basis);
+	return diagDot(ColumnBundleView(X), ColumnBundleView(Y));
+}
+diagMatrix diagDot(const ColumnBundleView& X, const ColumnBundleView& Y)
 {	assert(X.nCols()==Y.nCols());
-	assert(X.basis==Y.basis);
+	assert(X.colLength()==Y.colLength());
 	diagMatrix ret(X.nCols());
 	const complex* Xdata = X.dataPref();
 	const complex* Ydata = Y.dataPref();
 	for(size_t b=0; b<ret.size(); b++)
-		ret[b] = callPref(eblas_zdotc)(X.colLength(), Xdata+X.index(b,0),1, Ydata+Y.index(b,0),1).real();
+		ret[b] = callPref(eblas_zdotc)(X.colLength(), Xdata+b*X.colLength(),1, Ydata+b*Y.colLength(),1).real();
 	return ret;
 }
 
@@ -427,15 +704,19 @@ void precond_inv_kinetic_band(int nbasis, int ncols, complex* Ydata, const doubl
 void precond_inv_kinetic_band_gpu(int nbasis, int ncols, complex* Ydata, const double* KEref,
 	const matrix3<>& GGT, const vector3<int>* iGarr, const vector3<>& k);
 #endif
-void precond_inv_kinetic_band(ColumnBundle& Y, const diagMatrix& KErefIn)
-{	assert(Y.basis);
+void precond_inv_kinetic_band(ColumnBundle& Y, const diagMatrix& KEref)
+{	precond_inv_kinetic_band(ColumnBundleView(Y), KEref);
+}
+void precond_inv_kinetic_band(const ColumnBundleView& Yv, const diagMatrix& KErefIn)
+{	const ColumnBundle& Y = Yv.bundle();
+	assert(Y.basis);
 	const Basis& basis = *Y.basis;
-	assert(Y.nCols()==KErefIn.nCols());
+	assert(Yv.nCols()==KErefIn.nCols());
 	int nSpinor = Y.spinorLength();
 	//Adapt KEref array for spinors:
 	diagMatrix KEtmp;
 	if(nSpinor > 1)
-	{	KEtmp.reserve(Y.nCols()*nSpinor);
+	{	KEtmp.reserve(Yv.nCols()*nSpinor);
 		for(const double& KE: KErefIn)
 			KEtmp.insert(KEtmp.end(), nSpinor, KE);
 	}
@@ -447,7 +728,7 @@ void precond_inv_kinetic_band(ColumnBundle& Y, const diagMatrix& KErefIn)
 	#else
 	const double* KErefData = KEref.data();
 	#endif
-	callPref(precond_inv_kinetic_band)(basis.nbasis, Y.nCols()*nSpinor, Y.dataPref(), KErefData,
+	callPref(precond_inv_kinetic_band)(basis.nbasis, Yv.nCols()*nSpinor, Yv.dataPref(), KErefData,
 		basis.gInfo->GGT, basis.iGarr.dataPref(), Y.qnum->k);
 }
 
@@ -488,11 +769,41 @@ void translateColumns(ColumnBundle& Y, const vector3<>* dr)
 
 ColumnBundle switchBasis(const ColumnBundle& in, const Basis& basisOut)
 {	if(in.basis == &basisOut) return in; //no basis change required
+	static StopWatch watch("switchBasis"); watch.start();
+	const Basis& basisIn = *(in.basis);
 	int nSpinor = in.spinorLength();
-	ColumnBundle out(in.nCols(), basisOut.nbasis*nSpinor, &basisOut, 0, isGpuEnabled());
-	for(int b=0; b<in.nCols(); b++)
-		for(int s=0; s<nSpinor; s++)
-			out.setColumn(b,s, in.getColumn(b,s)); //convert using the full G-space as an intermediate
+	ColumnBundle out(in.nCols(), basisOut.nbasis*nSpinor, &basisOut, in.qnum, isGpuEnabled());
+	out.zero();
+	//On the same grid, map coefficients by G-vector index when one basis contains the other (eg. bases differing only in cutoff):
+	bool mapped = false;
+	if(basisIn.gInfo == basisOut.gInfo)
+	{	const Basis& basisSmall = (basisIn.nbasis <= basisOut.nbasis) ? basisIn : basisOut;
+		const Basis& basisLarge = (basisIn.nbasis <= basisOut.nbasis) ? basisOut : basisIn;
+		std::vector<int> largeIndex(basisLarge.gInfo->nr, -1); //position in basisLarge of each FFT-box index
+		const int* indexLarge = basisLarge.index.data();
+		for(size_t j=0; j<basisLarge.nbasis; j++) largeIndex[indexLarge[j]] = j;
+		IndexArray map; map.init(basisSmall.nbasis);
+		int* mapData = map.data();
+		mapped = true;
+		const int* indexSmall = basisSmall.index.data();
+		for(size_t j=0; j<basisSmall.nbasis; j++)
+			if((mapData[j] = largeIndex[indexSmall[j]]) < 0) { mapped = false; break; } //not a subset
+		if(mapped)
+		{	int nColsTot = in.nCols()*nSpinor; //spinor components are stored as consecutive columns of length nbasis
+			for(int c=0; c<nColsTot; c++)
+			{	const complex* inCol = in.dataPref() + c*basisIn.nbasis;
+				complex* outCol = out.dataPref() + c*basisOut.nbasis;
+				if(&basisSmall == &basisIn) callPref(eblas_scatter_zdaxpy)(map.nData(), 1., map.dataPref(), inCol, outCol); //expand
+				else callPref(eblas_gather_zdaxpy)(map.nData(), 1., map.dataPref(), inCol, outCol); //truncate
+			}
+		}
+	}
+	if(!mapped)
+	{	for(int b=0; b<in.nCols(); b++)
+			for(int s=0; s<nSpinor; s++)
+				out.setColumn(b,s, in.getColumn(b,s)); //convert using the full G-space as an intermediate
+	}
+	watch.stop();
 	return out;
 }
 
@@ -508,9 +819,20 @@ complex traceinner(const diagMatrix &F, const ColumnBundle &X, const ColumnBundl
 		result += F[i] * callPref(eblas_zdotc)(X.colLength(), X.dataPref()+X.index(i,0), 1, Y.dataPref()+Y.index(i,0), 1);
 	return result;
 }
+complex traceinner(const diagMatrix &F, const ColumnBundleView &X, const ColumnBundle &Y)
+{	assert(X.colLength()==Y.colLength());
+	assert(X.nCols()==Y.nCols());
+	assert(X.nCols()==F.nRows());
+	complex result = 0.0;
+	const complex* Xdata = X.dataPref();
+	for (int i=0; i < X.nCols(); i++)
+		result += F[i] * callPref(eblas_zdotc)(X.colLength(), Xdata+i*X.colLength(), 1, Y.dataPref()+Y.index(i,0), 1);
+	return result;
+}
 
-// Compute the density from a subset of columns of a ColumnBundle
-void diagouterI_sub(int iThread, int nThreads, const diagMatrix *F, const ColumnBundle *X, std::vector<ScalarFieldArray>* nSub)
+// Compute the densities (one per set of weights F) from a subset of columns of a ColumnBundle
+// nSub[iThread] contains nComponents fields for each set of weights consecutively
+void diagouterI_sub(int iThread, int nThreads, const std::vector<const diagMatrix*>* F, const ColumnBundle *X, std::vector<ScalarFieldArray>* nSub)
 {
 	//Determine column range:
 	int colStart = (( iThread ) * X->nCols())/nThreads;
@@ -518,20 +840,42 @@ void diagouterI_sub(int iThread, int nThreads, const diagMatrix *F, const Column
 	
 	ScalarFieldArray& nLocal = (*nSub)[iThread];
 	nullToZero(nLocal, *(X->basis->gInfo)); //sets to zero
-	int nDensities = nLocal.size();
-	if(nDensities==1) //Note that nDensities==2 below will also enter this branch sinc eonly one component is non-zero
-	{	int nSpinor = X->spinorLength();
-		for(int i=colStart; i<colStop; i++)
-			for(int s=0; s<nSpinor; s++)
-				callPref(eblas_accumNorm)(X->basis->gInfo->nr, (*F)[i], I(X->getColumn(i,s))->dataPref(), nLocal[0]->dataPref());
+	int nWeights = F->size();
+	int nDensities = nLocal.size() / nWeights;
+	int batchSize = std::max(1, X->basis->gInfo->fftBatchSize);
+	if(batchSize > 1 || X->basis->gInfo->fftSinglePrecision //single-precision transforms are only implemented in the batched path
+		|| X->basis->gInfo->fftPruning //as are pruned transforms
+		|| X->isSpinor()) //and spinor transforms (both components transformed together)
+	{	int nr = X->basis->gInfo->nr;
+		int nSpinor = X->spinorLength();
+		for(int iBatch=colStart; iBatch<colStop; iBatch+=batchSize)
+		{	int iBatchStop = std::min(iBatch+batchSize, colStop);
+			ManagedArray<complex> psi = I_batch(*X, iBatch, iBatchStop);
+			const complex* psiData = psi.dataPref();
+			for(int i=iBatch; i<iBatchStop; i++)
+			{	const complex* psi_i = psiData + size_t((i-iBatch)*nSpinor)*nr;
+				for(int w=0; w<nWeights; w++)
+				{	double Fi = (*(*F)[w])[i];
+					if(!Fi) continue;
+					ScalarField* nw = &nLocal[w*nDensities];
+					if(nDensities==1)
+					{	for(int s=0; s<nSpinor; s++)
+							callPref(eblas_accumNorm)(nr, Fi, psi_i+s*nr, nw[0]->dataPref());
+					}
+					else //nDensities==4: UpUp, DnDn and Re and Im parts of UpDn in one pass
+						callPref(eblas_accumSpinorDensity)(nr, Fi, psi_i, psi_i+nr,
+							nw[0]->dataPref(), nw[1]->dataPref(), nw[2]->dataPref(), nw[3]->dataPref());
+				}
+			}
+		}
+		return;
 	}
-	else //nDensities==4 (ensured by assertions in launching function below)
-	{	for(int i=colStart; i<colStop; i++)
-		{	complexScalarField psiUp = I(X->getColumn(i,0));
-			complexScalarField psiDn = I(X->getColumn(i,1));
-			callPref(eblas_accumNorm)(X->basis->gInfo->nr, (*F)[i], psiUp->dataPref(), nLocal[0]->dataPref()); //UpUp
-			callPref(eblas_accumNorm)(X->basis->gInfo->nr, (*F)[i], psiDn->dataPref(), nLocal[1]->dataPref()); //DnDn
-			callPref(eblas_accumProd)(X->basis->gInfo->nr, (*F)[i], psiUp->dataPref(), psiDn->dataPref(), nLocal[2]->dataPref(), nLocal[3]->dataPref()); //Re and Im parts of UpDn
+	//Collinear only (spinors always take the batched path above); note that nDensities==2 also enters here since only one component is non-zero
+	{	int nr = X->basis->gInfo->nr;
+		for(int i=colStart; i<colStop; i++)
+		{	complexScalarField psi = I(X->getColumn(i,0));
+			for(int w=0; w<nWeights; w++)
+				callPref(eblas_accumNorm)(nr, (*(*F)[w])[i], psi->dataPref(), nLocal[w]->dataPref());
 		}
 	}
 }
@@ -552,33 +896,43 @@ void diagouterI_collect(size_t iStart, size_t iStop, std::vector<ScalarFieldArra
 	}
 }
 
-// Returns diag((I*X)*F*(I*X)^) where X^ is the hermetian adjoint of X.
-ScalarFieldArray diagouterI(const diagMatrix &F,const ColumnBundle &X,  int nDensities, const GridInfo* gInfoOut)
+std::vector<ScalarFieldArray> diagouterI(const std::vector<const diagMatrix*>& F, const ColumnBundle &X, int nDensities, const GridInfo* gInfoOut)
 {	static StopWatch watch("diagouterI"); watch.start();
 	//Check sizes:
-	assert(F.nRows()==X.nCols());
+	for(const diagMatrix* Fw: F) { assert(Fw->nRows()==X.nCols()); }
 	assert(nDensities==1 || nDensities==2 || nDensities==4);
 	if(nDensities==2) assert(!X.isSpinor());
 	if(nDensities==4) assert(X.isSpinor());
 	
 	//Collect the contributions for different sets of columns in separate scalar fields (one per thread):
 	int nThreads = isGpuEnabled() ? 1: nProcsAvailable;
-	std::vector<ScalarFieldArray> nSub(nThreads, ScalarFieldArray(nDensities==2 ? 1 : nDensities)); //collinear spin-polarized will have only one non-zero output channel
+	int nComponents = (nDensities==2 ? 1 : nDensities); //collinear spin-polarized will have only one non-zero output channel
+	int nWeights = F.size();
+	std::vector<ScalarFieldArray> nSub(nThreads, ScalarFieldArray(nWeights*nComponents));
 	threadLaunch(nThreads, diagouterI_sub, 0, &F, &X, &nSub);
 
 	//If more than one thread, accumulate all vectors in nSub into the first:
 	if(nThreads>1) threadLaunch(diagouterI_collect, X.basis->gInfo->nr, &nSub);
 	watch.stop();
 	
-	//Change grid if necessary:
-	if(gInfoOut && (X.basis->gInfo!=gInfoOut))
-		for(ScalarField& nSub0s: nSub[0])
-			nSub0s = changeGrid(nSub0s, *gInfoOut);
-	
-	//Correct the location of the single non-zero channel of collinear spin-polarized densities:
-	if(nDensities==2)
-	{	nSub[0].resize(2);
-		if(X.qnum->index()==1) std::swap(nSub[0][0], nSub[0][1]);
+	//Separate outputs for each set of weights, changing grid if necessary:
+	std::vector<ScalarFieldArray> result(nWeights);
+	for(int w=0; w<nWeights; w++)
+	{	ScalarFieldArray& nw = result[w];
+		nw.assign(nSub[0].begin()+w*nComponents, nSub[0].begin()+(w+1)*nComponents);
+		if(gInfoOut && (X.basis->gInfo!=gInfoOut))
+			for(ScalarField& nws: nw)
+				nws = changeGrid(nws, *gInfoOut);
+		//Correct the location of the single non-zero channel of collinear spin-polarized densities:
+		if(nDensities==2)
+		{	nw.resize(2);
+			if(X.qnum->index()==1) std::swap(nw[0], nw[1]);
+		}
 	}
-	return nSub[0]; //rest cleaned up destructor
+	return result; //rest cleaned up destructor
+}
+
+// Returns diag((I*X)*F*(I*X)^) where X^ is the hermetian adjoint of X.
+ScalarFieldArray diagouterI(const diagMatrix &F,const ColumnBundle &X,  int nDensities, const GridInfo* gInfoOut)
+{	return diagouterI(std::vector<const diagMatrix*>(1, &F), X, nDensities, gInfoOut)[0];
 }
@@ -34,6 +34,19 @@ void reducedL_gpu(int nbasis, int ncols, const complex* Y, complex* LY,
 	gpuErrorCheck();
 }
 
+__global__
+void randomize_kernel(int nbasis, int colStart, int colStop, int nSpinor, complex* Y,
+	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR, uint32_t key0, uint32_t key1)
+{	int j = kernelIndex1D();
+	if(j<nbasis) randomize_calc(j, nbasis, colStart, colStop, nSpinor, Y, GGT, iGarr, k, detR, key0, key1);
+}
+void randomize_gpu(int nbasis, int colStart, int colStop, int nSpinor, complex* Y,
+	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR, uint32_t key0, uint32_t key1)
+{	GpuLaunchConfig1D glc(randomize_kernel, nbasis);
+	randomize_kernel<<<glc.nBlocks,glc.nPerBlock>>>(nbasis, colStart, colStop, nSpinor, Y, GGT, iGarr, k, detR, key0, key1);
+	gpuErrorCheck();
+}
+
 __global__
 void reducedLinv_kernel(int nbasis, int ncols, const complex* Y, complex* LinvY,
 	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR)
@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_ELECTRONIC_COLUMNBUNDLEOPERATORS_INTERNAL_H
 
 #include <core/matrix3.h>
+#include <core/Random.h>
 
 //! @cond
 
@@ -71,6 +72,21 @@ __hostanddev__ void precond_inv_kinetic_band_calc(int j, int nbasis, int ncols,
 	}
 }
 
+//Random wavefunction coefficients with a high frequency cutoff of 0.75 hartrees,
+//from the counter-based generator keyed by (state, column, G-vector, spinor component):
+__hostanddev__ void randomize_calc(int j, int nbasis, int colStart, int colStop, int nSpinor, complex* Y,
+	const matrix3<> GGT, const vector3<int>* iGarr, const vector3<> k, double detR, uint32_t key0, uint32_t key1)
+{	const vector3<int>& iG = iGarr[j];
+	double KE = 0.5*GGT.metric_length_squared(iG+k);
+	double t = KE/0.75;
+	double sigma = 1.0/((1.0+t*t*t*t*t*t) * detR);
+	int colLength = nbasis*nSpinor;
+	for(int s=0; s<nSpinor; s++)
+		for(int i=colStart; i<colStop; i++)
+			Y[colLength*i+s*nbasis+j] = Random::normalComplexCounter(uint32_t(i), uint32_t(iG[0]), uint32_t(iG[1]),
+				(uint32_t(iG[2])<<1) | uint32_t(s), key0, key1, sigma);
+}
+
 __hostanddev__
 void translate_calc(int j, int nbasis, int ncols, complex* Y, const vector3<int>* iGarr, const vector3<>& k, const vector3<>& dr)
 {	complex tFactor = cis(-2*M_PI*dot(iGarr[j]+k,dr));
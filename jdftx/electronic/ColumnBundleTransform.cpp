@@ -115,12 +115,57 @@ void ColumnBundleTransform::gatherAxpy(complex alpha, const ColumnBundle& C_D, i
 				phase.dataPref(), true);
 }
 
+//Batched versions below fetch the (device-resident) index map, phases and spinor factors once for all columns,
+//and skip spinor components that do not mix (eg. all off-diagonal ones in the absence of spinor rotations):
 void ColumnBundleTransform::scatterAxpy(complex alpha, const ColumnBundle& C_C, ColumnBundle& C_D, int bDstart, int bDstep) const
-{	for(int bC=0; bC<C_C.nCols(); bC++) scatterAxpy(alpha, C_C,bC, C_D,bDstart+bDstep*bC);
+{	//Check inputs:
+	int nCols = C_C.nCols();
+	if(!nCols) return;
+	assert(C_C.colLength() == nSpinor*basisC.nbasis);
+	assert(C_D.colLength() == nSpinor*basisD.nbasis);
+	assert(bDstart >= 0 && bDstart < C_D.nCols());
+	assert(bDstart+bDstep*(nCols-1) >= 0 && bDstart+bDstep*(nCols-1) < C_D.nCols());
+	//Scatter:
+	const int* indexPtr = index.dataPref();
+	const complex* phasePtr = phase.dataPref();
+	const complex* CCdata = C_C.dataPref();
+	complex* CDdata = C_D.dataPref();
+	for(int sD=0; sD<nSpinor; sD++)
+		for(int sC=0; sC<nSpinor; sC++)
+		{	complex alphaRot = alpha*spinorRot(sD,sC);
+			if(!alphaRot.norm()) continue;
+			for(int bC=0; bC<nCols; bC++)
+				callPref(eblas_scatter_zaxpy)(index.nData(), alphaRot, indexPtr,
+					CCdata + C_C.index(bC, sC*C_C.basis->nbasis),
+					CDdata + C_D.index(bDstart+bDstep*bC, sD*C_D.basis->nbasis), invert<0,
+					phasePtr, invert<0);
+		}
 }
 
 void ColumnBundleTransform::gatherAxpy(complex alpha, const ColumnBundle& C_D, int bDstart, int bDstep, ColumnBundle& C_C) const
-{	for(int bC=0; bC<C_C.nCols(); bC++) gatherAxpy(alpha, C_D,bDstart+bDstep*bC, C_C,bC);
+{	//Check inputs:
+	int nCols = C_C.nCols();
+	if(!nCols) return;
+	assert(C_C.colLength() == nSpinor*basisC.nbasis);
+	assert(C_D.colLength() == nSpinor*basisD.nbasis);
+	assert(bDstart >= 0 && bDstart < C_D.nCols());
+	assert(bDstart+bDstep*(nCols-1) >= 0 && bDstart+bDstep*(nCols-1) < C_D.nCols());
+	//Gather:
+	matrix spinorRotInv = (invert<0) ? transpose(spinorRot) : dagger(spinorRot);
+	const int* indexPtr = index.dataPref();
+	const complex* phasePtr = phase.dataPref();
+	const complex* CDdata = C_D.dataPref();
+	complex* CCdata = C_C.dataPref();
+	for(int sD=0; sD<nSpinor; sD++)
+		for(int sC=0; sC<nSpinor; sC++)
+		{	complex alphaRot = alpha*spinorRotInv(sC,sD);
+			if(!alphaRot.norm()) continue;
+			for(int bC=0; bC<nCols; bC++)
+				callPref(eblas_gather_zaxpy)(index.nData(), alphaRot, indexPtr,
+					CDdata + C_D.index(bDstart+bDstep*bC, sD*C_D.basis->nbasis),
+					CCdata + C_C.index(bC, sC*C_C.basis->nbasis), invert<0,
+					phasePtr, true);
+		}
 }
 
 std::vector<matrix> ColumnBundleTransform::transformVdagC(const std::vector<matrix>& VdagC_C, int iSym) const
@@ -178,3 +223,68 @@ std::vector<matrix> ColumnBundleTransform::transformVdagC(const std::vector<matr
 	}
 	return VdagC_D;
 }
+
+size_t ColumnBundleTransform::nBytes() const
+{	return index.nData()*sizeof(int) + phase.nData()*sizeof(complex);
+}
+
+//---------- class ColumnBundleTransformCache ----------
+
+ColumnBundleTransformCache::ColumnBundleTransformCache(double budgetMB) : bytes(0)
+{	setBudget(budgetMB);
+}
+
+void ColumnBundleTransformCache::setBudget(double budgetMB)
+{	std::lock_guard<std::mutex> guard(lock);
+	budget = (budgetMB > 0.) ? size_t(budgetMB * (1<<20)) : 0;
+	enforceBudget();
+}
+
+std::shared_ptr<ColumnBundleTransform> ColumnBundleTransformCache::get(const vector3<>& kC, const Basis& basisC, const vector3<>& kD,
+	const ColumnBundleTransform::BasisWrapper& basisDwrapper, int nSpinor, const SpaceGroupOp& sym, int invert, const matrix3<int>& super)
+{	Key key = { kC, kD, &basisC, &basisDwrapper, nSpinor, invert, &sym, super };
+	std::lock_guard<std::mutex> guard(lock);
+	auto iter = cache.find(key);
+	if(iter != cache.end())
+	{	lru.splice(lru.begin(), lru, iter->second); //mark as most recently used
+		return iter->second->second;
+	}
+	//Create and cache new transform:
+	auto transform = std::make_shared<ColumnBundleTransform>(kC, basisC, kD, basisDwrapper, nSpinor, sym, invert, super);
+	lru.push_front(std::make_pair(key, transform));
+	cache[key] = lru.begin();
+	bytes += transform->nBytes();
+	enforceBudget();
+	return transform;
+}
+
+void ColumnBundleTransformCache::clear()
+{	std::lock_guard<std::mutex> guard(lock);
+	lru.clear();
+	cache.clear();
+	bytes = 0;
+}
+
+void ColumnBundleTransformCache::enforceBudget()
+{	if(!budget) return;
+	while(bytes > budget and lru.size() > 1) //always retain most recently used
+	{	bytes -= lru.back().second->nBytes();
+		cache.erase(lru.back().first);
+		lru.pop_back();
+	}
+}
+
+bool ColumnBundleTransformCache::Key::operator<(const ColumnBundleTransformCache::Key& other) const
+{	if(basisC != other.basisC) return basisC < other.basisC;
+	if(basisDwrapper != other.basisDwrapper) return basisDwrapper < other.basisDwrapper;
+	if(sym != other.sym) return sym < other.sym;
+	if(nSpinor != other.nSpinor) return nSpinor < other.nSpinor;
+	if(invert != other.invert) return invert < other.invert;
+	if(not (kC == other.kC)) return kC < other.kC;
+	if(not (kD == other.kD)) return kD < other.kD;
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+			if(super(i,j) != other.super(i,j))
+				return super(i,j) < other.super(i,j);
+	return false;
+}
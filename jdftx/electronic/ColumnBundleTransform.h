@@ -20,10 +20,12 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef JDFTX_ELECTRONIC_COLUMNBUNDLETRANSFORM_H
 #define JDFTX_ELECTRONIC_COLUMNBUNDLETRANSFORM_H
 
-#include <electronic/Basis.h>
+#include <electronic/ColumnBundle.h>
 #include <core/matrix.h>
-
-class ColumnBundle;
+#include <memory>
+#include <list>
+#include <map>
+#include <mutex>
 
 //! @addtogroup Operators
 //! @{
@@ -70,6 +72,8 @@ public:
 	//! Does not support supercell transformations.
 	std::vector<matrix> transformVdagC(const std::vector<matrix>& VdagC_C, int iSym) const; 
 	
+	size_t nBytes() const; //!< memory used by index map and phases
+	
 private:
 	const Basis& basisC;
 	const Basis& basisD;
@@ -85,5 +89,93 @@ private:
 	friend class WannierMinimizer;
 };
 
+//! Cache of ColumnBundleTransforms shared between callers, optionally within a memory budget.
+//! Transforms are keyed by all the constructor arguments, with the bases, basis wrapper and symmetry
+//! operation identified by address (so these must outlive the cache, as they must for the transforms).
+//! When over budget, the least-recently used transforms are released; those still held by callers
+//! remain valid since they are returned as shared pointers. The index maps and phases are stored in
+//! managed memory, and therefore remain resident on the GPU between uses when GPU is enabled.
+class ColumnBundleTransformCache
+{
+public:
+	ColumnBundleTransformCache(double budgetMB=0.); //!< cache at most budgetMB megabytes of transforms (unlimited if non-positive)
+	void setBudget(double budgetMB); //!< change budget (releasing least-recently used transforms if necessary)
+	
+	//! Get transform with specified parameters (see ColumnBundleTransform constructor), creating it if not cached
+	std::shared_ptr<ColumnBundleTransform> get(const vector3<>& kC, const Basis& basisC, const vector3<>& kD,
+		const ColumnBundleTransform::BasisWrapper& basisDwrapper, int nSpinor, const SpaceGroupOp& sym, int invert,
+		const matrix3<int>& super = matrix3<int>(1,1,1));
+	
+	void clear(); //!< release all cached transforms
+	size_t nBytes() const { return bytes; } //!< memory currently used by cached transforms
+	size_t size() const { return cache.size(); } //!< number of currently cached transforms
+	
+private:
+	struct Key
+	{	vector3<> kC, kD;
+		const Basis* basisC;
+		const ColumnBundleTransform::BasisWrapper* basisDwrapper;
+		int nSpinor, invert;
+		const SpaceGroupOp* sym;
+		matrix3<int> super;
+		bool operator<(const Key& other) const;
+	};
+	typedef std::list<std::pair<Key, std::shared_ptr<ColumnBundleTransform>>> List;
+	List lru; //!< cached transforms, most recently used first
+	std::map<Key, List::iterator> cache; //!< look-up into lru by key
+	size_t budget, bytes; //!< memory budget (0 => unlimited) and current usage in bytes
+	std::mutex lock; //!< for thread safety
+	void enforceBudget(); //!< release least-recently used transforms till within budget
+};
+
+//! Least-recently-used cache of a few wavefunctions unfolded from the reduced k-point set to the full mesh
+//! (along with their projections), for loops that revisit full-mesh k-points in nearby iterations,
+//! such as over neighbours on a k-mesh. Each such view is then unfolded once while it remains in use,
+//! and memory stays bounded by capacity states instead of growing with the full mesh.
+//! Key identifies the unfolded state (eg. full-mesh k-point and spin) and must be ordered by operator<.
+template<typename Key> class UnfoldedWfnsCache
+{
+public:
+	struct Entry
+	{	ColumnBundle C; //!< unfolded wavefunctions
+		std::vector<matrix> VdagC; //!< corresponding projections (if computed by the unfold function)
+	};
+	
+	UnfoldedWfnsCache(size_t capacity) : capacity(std::max(capacity, size_t(1))), nHits(0), nMisses(0) {}
+	
+	//! Get unfolded state for key, calling unfold(Entry&) to compute it if not cached.
+	//! The result remains valid while held, even if subsequently evicted from the cache.
+	template<typename Unfold> std::shared_ptr<const Entry> get(const Key& key, const Unfold& unfold)
+	{	std::lock_guard<std::mutex> guard(lock);
+		auto iter = cache.find(key);
+		if(iter != cache.end())
+		{	lru.splice(lru.begin(), lru, iter->second); //mark as most recently used
+			nHits++;
+			return iter->second->second;
+		}
+		nMisses++;
+		auto entry = std::make_shared<Entry>();
+		unfold(*entry);
+		lru.push_front(std::make_pair(key, entry));
+		cache[key] = lru.begin();
+		if(lru.size() > capacity)
+		{	cache.erase(lru.back().first);
+			lru.pop_back();
+		}
+		return entry;
+	}
+	
+	void clear() { std::lock_guard<std::mutex> guard(lock); lru.clear(); cache.clear(); } //!< release all cached states
+	size_t hits() const { return nHits; } //!< number of accesses served from cache
+	size_t misses() const { return nMisses; } //!< number of accesses that required unfolding
+	
+private:
+	typedef std::list<std::pair<Key, std::shared_ptr<const Entry>>> List;
+	List lru; //!< cached states, most recently used first
+	std::map<Key, typename List::iterator> cache; //!< look-up into lru by key
+	size_t capacity, nHits, nMisses;
+	std::mutex lock; //!< for thread safety
+};
+
 //! @}
 #endif //JDFTX_ELECTRONIC_COLUMNBUNDLETRANSFORM_H
@@ -32,7 +32,24 @@ enum BasisKdep { BasisKpointDep, BasisKpointIndep } ;
 static EnumStringMap<BasisKdep> kdepMap(BasisKpointDep, "kpoint-dependent", BasisKpointIndep, "single" );
 
 //! Electronic eigenvalue method
-enum ElecEigenAlgo { ElecEigenCG, ElecEigenDavidson };
+enum ElecEigenAlgo { ElecEigenCG, ElecEigenDavidson, ElecEigenLOBPCG, ElecEigenChebyshev };
+
+//! Orthonormalization of subspaces where only the span matters (see subspace-orthonormalization)
+enum SubspaceOrtho { SubspaceOrthoLowdin, SubspaceOrthoCholesky };
+
+//! Extrapolation of wavefunctions across ionic steps
+enum WfnsExtrapolation { WfnsExtrapolationNone, WfnsExtrapolationLinear, WfnsExtrapolationQuadratic, WfnsExtrapolationASPC };
+
+//! Model-Hessian preconditioner for ionic minimization
+enum IonicPreconditioner { IonicPreconditionerNone, IonicPreconditionerExp };
+
+//! Preset of performance-related settings (see PerformanceProfile.h)
+enum PerformanceProfile
+{	PerformanceDefault, //!< no preset: individual settings alone
+	PerformanceThroughput, //!< larger FFT batches and blocks for maximum throughput
+	PerformanceMemoryLean, //!< smaller working sets, caches and histories to minimize memory
+	PerformanceLatency //!< larger eigensolver and mixing subspaces for fewer iterations in small calculations
+};
 
 //! Miscellaneous flags controlling electronic DFT
 class Control
@@ -40,16 +57,39 @@ class Control
 public:
 	bool fixed_H; //!< fixed Hamiltonian (band structure) mode for electronic sector
 	bool cacheProjectors; //!< whether to cache nonlocal projectors
+	double projectorCacheMB; //!< memory budget for cached projectors in MB, evicting least-recently used ones beyond it (0 => unlimited)
+	double realSpaceProjectorRadius; //!< if non-zero, apply nonlocal projectors in real space, truncated to spheres of this radius (in bohrs)
 	double davidsonBandRatio; //!< ratio of number of Davidson working bands to actual bands in system (>= 1)
+	int chebyshevDegree; //!< polynomial degree of the filter in Chebyshev-filtered subspace iteration
 	int exxBlockSize; //!< number of bands per FFT block used in exact exchange
+	int fftBatchSize; //!< number of bands per batched FFT in wavefunction operators (0 => automatic)
+	int kpointBatchSize; //!< number of states whose local potential term is applied together in batched FFTs (1 => one state at a time)
+	int hamiltonianBlockSize; //!< number of bands per block when applying the local, kinetic and nonlocal Hamiltonian terms (0 => all bands at once)
+	double fftSinglePrecisionThreshold; //!< energy change per iteration below which wavefunction FFTs switch from single to double precision (0 => double throughout)
+	bool fftPruning; //!< whether wavefunction FFTs skip lines and planes of the FFT box outside the basis (CPU only)
 	int nOuterVxx; //!< number of outer loop iterations used to converge ACE representation of exact exchange operator
+	double aceUpdateThreshold; //!< if non-zero, only rebuild ACE projectors of states whose wavefunctions changed by more than this
+	double exxScreenThreshold; //!< if non-zero, skip exchange pairs of localized orbitals whose overlap-density bound is below this
+	bool aceReuse; //!< whether to start the SCF of each ionic step from the previous ACE exchange operator
+	double partialBandThreshold; //!< fillings below which bands are converged with a looser residual threshold in SCF eigensolvers (0 => disabled)
+	double partialBandTolScale; //!< factor loosening the residual threshold of bands with fillings below partialBandThreshold
 	
 	ElecEigenAlgo elecEigenAlgo; //!< Eigenvalue algorithm
+	SubspaceOrtho subspaceOrtho; //!< orthonormalization in eigensolvers and ACE construction, where the result matters only up to a unitary gauge
 	BasisKdep basisKdep; //!< k-dependence of basis
 	double Ecut, EcutRho; //!< energy cutoff for electrons and charge density grid (EcutRho=0 => EcutRho = 4 Ecut)
+	std::vector<double> EcutLadder; //!< lower cutoffs (increasing) at which to converge first on the grids of Ecut (see elec-cutoff-ladder)
 	
 	bool dragWavefunctions; //!< whether to drag wavefunctions using atomic orbital projections on ionic steps
+	WfnsExtrapolation wfnsExtrapolation; //!< extrapolation of wavefunctions from previous ionic steps (replaces drag once enough history is available)
+	IonicPreconditioner ionicPreconditioner; //!< model-Hessian preconditioner for ionic minimization
+	double ionicPrecondA; //!< decay exponent of the exponential ionic preconditioner
+	double ionicPrecondRcut; //!< cutoff of the exponential ionic preconditioner in units of the nearest-neighbour distance
+	string ionicHistoryFile; //!< file persisting the L-BFGS history of ionic minimization across runs (none if empty)
+	double adaptiveElecForceFraction; //!< if non-zero, electronic thresholds of each ionic step allow force errors of this fraction of the previous max force
+	double adaptiveElecThresholdMax; //!< upper bound on the adaptive electronic energy threshold
 	vector3<> lattMoveScale; //!< preconditioning factor for each lattice vector during lattice minimization
+	bool strainPredictor; //!< extrapolate wavefunctions across lattice steps from those converged at previous lattices (replaces drag once enough history is available)
 	
 	int fluidGummel_nIterations; //!< max iterations of the fluid<->electron self-consistency loop
 	double fluidGummel_Atol; //!< stopping free-energy tolerance for the fluid<->electron self-consistency loop
@@ -65,14 +105,26 @@ public:
 	bool scf; //!< whether SCF iteration or total energy minimizer will be called
 	bool convergeEmptyStates; //!< whether to converge empty states after every electronic minimization
 	bool dumpOnly; //!< run a single-electronic-point energy evaluation and process the end dump
+	bool harrisFoulkes; //!< run a single band solve at an input density and evaluate the Harris-Foulkes energy and forces (see HarrisFoulkes.h)
+	string harrisDensityPattern; //!< input density pattern for Harris-Foulkes mode (superposition of atomic densities if empty)
+	bool bandStreaming; //!< in fixed-Hamiltonian calculations, initialize, converge, write and free the wavefunctions of one state at a time
+	bool readAggregate; //!< whether wavefunction reads go through one reader process per node, instead of all processes opening the file
+	
+	PerformanceProfile perfProfile; //!< preset applied to performance settings left at their defaults
+	bool perfAutoTune; //!< whether to time trial FFT batch and Hamiltonian block sizes at startup
+	string perfTuneFile; //!< file caching auto-tuned settings per machine and problem size (empty => ~/.jdftx-tuning)
 	
 	Control()
 	:	fixed_H(false),
-		cacheProjectors(true), davidsonBandRatio(1.1), exxBlockSize(16), nOuterVxx(20),
-		elecEigenAlgo(ElecEigenDavidson), basisKdep(BasisKpointDep), Ecut(0), EcutRho(0), dragWavefunctions(true),
+		cacheProjectors(true), projectorCacheMB(0.), realSpaceProjectorRadius(0.), davidsonBandRatio(1.1), chebyshevDegree(10), exxBlockSize(16), fftBatchSize(0), kpointBatchSize(1), hamiltonianBlockSize(0), fftSinglePrecisionThreshold(0.), fftPruning(true), nOuterVxx(20), aceUpdateThreshold(0.), exxScreenThreshold(0.), aceReuse(false),
+		partialBandThreshold(0.), partialBandTolScale(100.),
+		elecEigenAlgo(ElecEigenDavidson), subspaceOrtho(SubspaceOrthoLowdin), basisKdep(BasisKpointDep), Ecut(0), EcutRho(0), dragWavefunctions(true), wfnsExtrapolation(WfnsExtrapolationNone),
+		ionicPreconditioner(IonicPreconditionerNone), ionicPrecondA(3.), ionicPrecondRcut(2.),
+		adaptiveElecForceFraction(0.), adaptiveElecThresholdMax(1e-4), strainPredictor(false),
 		fluidGummel_nIterations(10), fluidGummel_Atol(1e-5),
 		shouldPrintEigsFillings(false), shouldPrintEcomponents(false), shouldPrintMuSearch(false), shouldPrintKpointsBasis(false),
-		subspaceRotationFactor(1.), subspaceRotationAdjust(true), scf(false), convergeEmptyStates(false), dumpOnly(false)
+		subspaceRotationFactor(1.), subspaceRotationAdjust(true), scf(false), convergeEmptyStates(false), dumpOnly(false), harrisFoulkes(false), bandStreaming(false), readAggregate(false),
+		perfProfile(PerformanceDefault), perfAutoTune(false)
 	{
 	}
 };
@@ -27,13 +27,17 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Polarizability.h>
 #include <electronic/ElectronScattering.h>
 #include <electronic/LatticeMinimizer.h>
+#include <electronic/Checkpoint.h>
 #include <fluid/FluidSolver.h>
 #include <core/VectorField.h>
 #include <core/ScalarFieldIO.h>
 #include <ctime>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 
 Dump::Dump()
-: potentialSubtraction(true), Munfold(1,1,1), curIter(0)
+: potentialSubtraction(true), Munfold(1,1,1), checkpointCompression(0), wfnsSinglePrecision(false), asyncState(false), bandWindowMin(0.), bandWindowMax(0.), curIter(0)
 {
 }
 
@@ -61,13 +65,37 @@ void Dump::setup(const Everything& everything)
 			}
 			default:; //No action necessary (needed only to suppress compiler warnings)
 		}
+	
+	//Band-streaming frees wavefunctions as states converge, so End dumps must not need them:
+	if(everything.cntrl.bandStreaming)
+		for(auto dumpPair: *this)
+			if(dumpPair.first==DumpFreq_End)
+				switch(dumpPair.second)
+				{	case DumpNone: case DumpState: case DumpIonicPositions: case DumpForces: case DumpLattice:
+					case DumpIonicDensity: case DumpElecDensity: case DumpCoreDensity: case DumpFluidDensity:
+					case DumpDvac: case DumpDfluid: case DumpDtot: case DumpVcavity: case DumpVfluidTot:
+					case DumpVlocps: case DumpVscloc: case DumpBandEigs: case DumpEigStats: case DumpFillings:
+					case DumpEcomponents: case DumpSymmetries: case DumpKpoints: case DumpGvectors: case DumpTrajectory: case DumpDelim:
+						break;
+					default:
+						die("\nband-streaming frees wavefunctions as each state converges, and only supports End dumps of\n"
+							"State, BandEigs, EigStats, Fillings, Ecomponents, Kpoints, Gvectors, Symmetries, geometry,\n"
+							"densities and potentials (which do not require wavefunctions).\n\n");
+				}
 }
 
 
 void Dump::operator()(DumpFrequency freq, int iter)
 {
+	static const int phaseId = Profiler::registerName("Dump"); ProfilePhase phase(phaseId);
+	if(MemoryMonitor::active)
+	{	static const char* freqNames[DumpFreq_Delim] = { "End", "Init", "Electronic", "Fluid", "Ionic", "Gummel" };
+		MemoryMonitor::snapshot(freqNames[freq], iter); //timeline of memory usage at every dump point (regardless of interval)
+	}
+	if(freq==DumpFreq_End) waitAsync(); //complete any background output before the final dump
 	if(!checkInterval(freq, iter)) return; // => don't dump this time
 	curIter = iter; curFreq = freq; //used by getFilename()
+	runAnalyses(freq, iter);
 	
 	bool foundVars = false; //whether any variables are to be dumped at this frequency
 	for(auto entry: *this)
@@ -98,7 +126,8 @@ void Dump::operator()(DumpFrequency freq, int iter)
 
 	#define DUMP_nocheck(object, prefix) \
 		{	StartDump(prefix) \
-			if(mpiWorld->isHead()) saveRawBinary(object, fname.c_str()); \
+			saveRawBinaryCollective(object, fname.c_str()); \
+			if(visualizationFormats.size() && mpiWorld->isHead()) saveVisualization(object, fname); \
 			EndDump \
 		}
 	
@@ -140,9 +169,22 @@ void Dump::operator()(DumpFrequency freq, int iter)
 	if(ShouldDump(State))
 	{
 		//Dump wave functions
-		StartDump("wfns")
-		eInfo.write(eVars.C, fname.c_str());
-		EndDump
+		if(e->cntrl.bandStreaming)
+			logPrintf("Skipping 'wfns': already written state by state during band-streaming.\n");
+		else
+		{	StartDump("wfns")
+			#if !MPI_SAFE_WRITE
+			if(asyncState && freq!=DumpFreq_End)
+			{	writeWfnsAsync(fname);
+				logPrintf("writing in background\n"); logFlush();
+			}
+			else
+			#endif
+			{	waitAsync(); //may be writing to the same file
+				eInfo.write(eVars.C, fname.c_str(), wfnsSinglePrecision);
+				EndDump
+			}
+		}
 		
 		if(hasFluid)
 		{	//Dump state of fluid:
@@ -151,6 +193,12 @@ void Dump::operator()(DumpFrequency freq, int iter)
 			EndDump
 		}
 	}
+	
+	if(ShouldDump(Checkpoint))
+	{	StartDump("checkpoint.h5")
+		Checkpoint::write(*e, fname, checkpointCompression);
+		EndDump
+	}
 
 	if(ShouldDump(IonicPositions)
 		|| (ShouldDump(State)
@@ -190,6 +238,12 @@ void Dump::operator()(DumpFrequency freq, int iter)
 		}
 		EndDump
 	}
+	if(ShouldDump(Trajectory))
+	{	StartDump("traj")
+		if(!trajectory || trajectory->fname != fname) trajectory = std::make_shared<TrajectoryWriter>(*e, fname);
+		trajectory->append(iter);
+		EndDump
+	}
 	DUMP(I(iInfo.rhoIon), "Nion", IonicDensity)
 	
 	if(ShouldDump(ElecDensity))
@@ -268,47 +322,37 @@ void Dump::operator()(DumpFrequency freq, int iter)
 	
 	if(ShouldDump(BandProjections) && isCevec)
 	{	StartDump("bandProjections")
-		FILE* fp = 0;
+		ostringstream oss; //output of this process (header on head, followed by local k-points)
+		char buf[32];
 		if(mpiWorld->isHead())
-		{	fp = fopen(fname.c_str(), "w");
-			//Write header:
-			fprintf(fp, "%d states, %d bands, %d orbital-projections, %lu species\n",
-				eInfo.nStates, eInfo.nBands, iInfo.nAtomicOrbitals(), iInfo.species.size());
-			fprintf(fp, "# Symbol nAtoms nOrbitalsPerAtom lMax nShells(l=0) ... nShells(l=lMax)\n");
+		{	//Write header:
+			oss << eInfo.nStates << " states, " << eInfo.nBands << " bands, " << iInfo.nAtomicOrbitals()
+				<< " orbital-projections, " << iInfo.species.size() << " species\n";
+			oss << "# Symbol nAtoms nOrbitalsPerAtom lMax nShells(l=0) ... nShells(l=lMax)\n";
 			for(const auto& sp: iInfo.species)
 			{	int nAtoms = sp->atpos.size();
 				int nOrbitalsPerAtom = sp->nAtomicOrbitals() / nAtoms;
 				int lMax = sp->lMaxAtomicOrbitals();
-				fprintf(fp, "%s %d %d %d", sp->name.c_str(), nAtoms, nOrbitalsPerAtom, lMax);
+				oss << sp->name << ' ' << nAtoms << ' ' << nOrbitalsPerAtom << ' ' << lMax;
 				for(int l=0; l<=lMax; l++)
-					fprintf(fp, " %d", sp->nAtomicOrbitals(l));
-				fprintf(fp, "\n");
+					oss << ' ' << sp->nAtomicOrbitals(l);
+				oss << '\n';
 			}
 		}
-		for(int q=0; q<eInfo.nStates; q++)
-		{	matrix proj; //orbitals: nOrbitals x nBands
-			if(eInfo.isMine(q))
-			{	proj = iInfo.getAtomicOrbitals(q, true) ^ eVars.C[q]; //dagger(Opsi).Cq
-				if(not mpiWorld->isHead()) mpiWorld->sendData(proj, 0, q); //send to head for writing
-			}
-			if(mpiWorld->isHead())
-			{	if(not eInfo.isMine(q)) //recv from process that stored q
-				{	proj.init(iInfo.nAtomicOrbitals(), eInfo.nBands);
-					mpiWorld->recvData(proj, eInfo.whose(q), q);
-				}
-				//Write projections:
-				fprintf(fp, "# ");
-				eInfo.kpointPrint(fp, q, true);
-				fprintf(fp, "; lines per band, with |projection|^2 per orbital:\n");
-				complex* projData = proj.data();
-				for(int b=0; b<proj.nCols(); b++) //bands
-				{	for(int a=0; a<proj.nRows(); a++) //orbitals
-						fprintf(fp, "%9.7lf ", (projData++)->norm()); //write |projection|^2
-					fprintf(fp, "\n");
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	matrix proj = iInfo.getAtomicOrbitals(q, true) ^ eVars.C[q]; //dagger(Opsi).Cq (orbitals: nOrbitals x nBands)
+			//Write projections:
+			oss << "# " << eInfo.kpointString(q, true) << "; lines per band, with |projection|^2 per orbital:\n";
+			const complex* projData = proj.data();
+			for(int b=0; b<proj.nCols(); b++) //bands
+			{	for(int a=0; a<proj.nRows(); a++) //orbitals
+				{	snprintf(buf, sizeof(buf), "%9.7lf ", (projData++)->norm()); //write |projection|^2
+					oss << buf;
 				}
+				oss << '\n';
 			}
 		}
-		if(mpiWorld->isHead()) fclose(fp);
+		mpiWorld->writeOrdered(fname.c_str(), oss.str()); //each process writes its own k-points (q ranges are in process order)
 		EndDump
 	}
 	
@@ -528,45 +572,49 @@ void Dump::operator()(DumpFrequency freq, int iter)
 	
 	if(ShouldDump(Momenta) or ShouldDump(Velocities) or ShouldDump(FermiVelocity))
 	{
-		//Common code: compute matrix elements:
-		std::vector<matrix> momenta(eInfo.nStates); //full matrices
-		std::vector<std::vector<vector3<>>> v(eInfo.nStates, std::vector<vector3<>>(eInfo.nBands)); //diagonal parts
-		bool needFull = ShouldDump(Momenta); //whether full matrices are needed
+		//Common code: compute matrix elements, streaming full matrices and diagonal parts to file per k-point:
+		std::shared_ptr<StateRecordWriter> momentaWriter, velocitiesWriter;
+		int bStart = 0, bStop = eInfo.nBands; //band range of momenta output
+		if(ShouldDump(Momenta))
+		{	getBandWindow(bStart, bStop);
+			if(bandWindowSet()) logPrintf("Momenta restricted to bands [%d,%d) within the band window.\n", bStart, bStop);
+			int nBandsOut = bStop - bStart;
+			momentaWriter = std::make_shared<StateRecordWriter>(eInfo, getFilename("momenta"), nBandsOut*nBandsOut*3*sizeof(complex));
+		}
+		bool needDiagonal = ShouldDump(Velocities) or ShouldDump(FermiVelocity);
+		if(ShouldDump(Velocities))
+			velocitiesWriter = std::make_shared<StateRecordWriter>(eInfo, getFilename("velocities"), eInfo.nBands*sizeof(vector3<>));
+		std::vector<std::vector<vector3<>>> v(eInfo.nStates); //diagonal parts (local states only)
 		for(int q=eInfo.qStart; q<eInfo.qStop; q++) //kpoint/spin
-		{	if(needFull) momenta[q] = zeroes(eInfo.nBands, eInfo.nBands*3);
+		{	//Compute only within the output band range, unless diagonal parts are needed for all bands:
+			int b0 = needDiagonal ? 0 : bStart, b1 = needDiagonal ? eInfo.nBands : bStop;
+			ColumnBundle Csub; if(b0 || b1<eInfo.nBands) Csub = eVars.C[q].getSub(b0, b1);
+			const ColumnBundle& Cq = Csub ? Csub : eVars.C[q];
+			int nBandsOut = bStop - bStart;
+			matrix momentaq; //output matrix (only if needed)
+			if(momentaWriter) momentaq = zeroes(nBandsOut, nBandsOut*3);
+			v[q].resize(eInfo.nBands);
+			if(b1 > b0)
 			for(int iDir=0; iDir<3; iDir++) //cartesian direction
-			{	matrix Pqk = complex(0,-1) * iInfo.rHcommutator(eVars.C[q], iDir, eVars.Hsub_eigs[q]);
-				if(needFull)
-					momenta[q].set(0,eInfo.nBands, eInfo.nBands*iDir,eInfo.nBands*(iDir+1), Pqk);
-				for(int b=0; b<eInfo.nBands; b++)
-					v[q][b][iDir] = Pqk(b,b).real();
+			{	matrix Pqk = complex(0,-1) * iInfo.rHcommutator(Cq, iDir, eVars.Hsub_eigs[q](b0, b1));
+				if(momentaWriter)
+					momentaq.set(0,nBandsOut, nBandsOut*iDir,nBandsOut*(iDir+1),
+						Pqk(bStart-b0,bStop-b0, bStart-b0,bStop-b0));
+				if(needDiagonal)
+					for(int b=0; b<eInfo.nBands; b++)
+						v[q][b][iDir] = Pqk(b,b).real();
 			}
+			if(momentaWriter) momentaWriter->write(q, momentaq);
+			if(velocitiesWriter) velocitiesWriter->write(q, v[q].data(), sizeof(double), 3*eInfo.nBands);
 		}
-		
-		//Output full momentum matrix elements:
-		if(ShouldDump(Momenta))
+		if(momentaWriter)
 		{	StartDump("momenta")
-			eInfo.write(momenta, fname.c_str(), eInfo.nBands, eInfo.nBands*3);
+			momentaWriter = 0; //close file
 			EndDump
 		}
-		
-		//Output diagonal band-velocity matrix elements:
-		if(ShouldDump(Velocities))
+		if(velocitiesWriter)
 		{	StartDump("velocities")
-			FILE* fp;
-			if(mpiWorld->isHead())
-			{	fp = fopen(fname.c_str(), "w");
-				if(!fp) die_alone("Error opening %s for writing.\n", fname.c_str());
-				for(int q=0; q<eInfo.nStates; q++)
-				{	if(not eInfo.isMine(q)) mpiWorld->recvData(v[q], eInfo.whose(q), q);
-					fwrite(v[q].data(), sizeof(vector3<>), eInfo.nBands, fp);
-				}
-				fclose(fp);
-			}
-			else
-			{	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-					mpiWorld->sendData(v[q], 0, q);
-			} 
+			velocitiesWriter = 0; //close file
 			EndDump
 		}
 		
@@ -728,43 +776,50 @@ void Dump::operator()(DumpFrequency freq, int iter)
 		ScalarFieldArray sVh = XC_Analysis::sHartree(*e); DUMP_spinCollection(sVh, "sHartree");
 	}
 
-	if(ShouldDump(EresolvedDensity))
-	{	std::vector<diagMatrix>& F = ((ElecVars&)e->eVars).F;
-		std::vector<diagMatrix> Forig = F; //backup fillings
-		int iRange=0;
-		for(const auto& Erange: densityErange)
-		{	//Set fillings based on current energy range:
-			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-				for(int b=0; b<eInfo.nBands; b++)
-				{	double e_qb = eVars.Hsub_eigs[q][b];
-					F[q][b] = (e_qb >= Erange.first && e_qb <= Erange.second) ? 1. : 0.;
+	if(ShouldDump(EresolvedDensity) || ShouldDump(FermiDensity))
+	{	//Collect the fillings for all requested densities, so that each band is transformed only once:
+		std::vector<std::vector<diagMatrix>> Fsets;
+		std::vector<string> names;
+		if(ShouldDump(EresolvedDensity))
+		{	int iRange=0;
+			for(const auto& Erange: densityErange)
+			{	//Fillings based on current energy range:
+				std::vector<diagMatrix> F(eInfo.nStates);
+				for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+				{	F[q].resize(eInfo.nBands);
+					for(int b=0; b<eInfo.nBands; b++)
+					{	double e_qb = eVars.Hsub_eigs[q][b];
+						F[q][b] = (e_qb >= Erange.first && e_qb <= Erange.second) ? 1. : 0.;
+					}
+				}
+				Fsets.push_back(F);
+				ostringstream oss; oss << "EresolvedDensity." << iRange; iRange++;
+				names.push_back(oss.str());
+			}
+		}
+		if(ShouldDump(FermiDensity))
+		{	int iRange=0;
+			for(const auto& muLevel: fermiDensityLevels)
+			{	//Fillings based on derivative of smearing function evaluated at muLevel
+				double muF, Bz;
+				//calculate mu if not set
+				muF = ( !std::isnan(muLevel) ? muLevel : eInfo.findMu(eVars.Hsub_eigs,eInfo.nElectrons,Bz) );
+				std::vector<diagMatrix> F(eInfo.nStates);
+				for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+				{	F[q].resize(eInfo.nBands);
+					for(int b=0; b<eInfo.nBands; b++)
+						F[q][b] = -eInfo.smearPrime(muF,eVars.Hsub_eigs[q][b]);
 				}
-			//Calculate and dump density:
-			ScalarFieldArray density = eVars.calcDensity();
-			ostringstream oss; oss << "EresolvedDensity." << iRange; iRange++;
-			DUMP_spinCollection(density, oss.str())
-		}
-		F = Forig; //restore fillings
-	}
-	
-	if(ShouldDump(FermiDensity)) 
-	{	std::vector<diagMatrix>& F = ((ElecVars&)e->eVars).F;
-		std::vector<diagMatrix> Forig = F; //backup fillings
-		int iRange=0;
-		for(const auto& muLevel: fermiDensityLevels)
-		{	//Set fillings based on derivative of smearing function evaluated at muLevel
-			double muF, Bz;
-			//calculate mu if not set
-			muF = ( !std::isnan(muLevel) ? muLevel : eInfo.findMu(eVars.Hsub_eigs,eInfo.nElectrons,Bz) );
-			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-				for(int b=0; b<eInfo.nBands; b++)
-					F[q][b] = -eInfo.smearPrime(muF,eVars.Hsub_eigs[q][b]);
-			//Calculate and dump density
-			ScalarFieldArray density = eVars.calcDensity();
-			ostringstream oss; oss << "FermiDensity." << iRange; iRange++;
-			DUMP_spinCollection(density, oss.str())
-		}
-		F = Forig; //restore fillings
+				Fsets.push_back(F);
+				ostringstream oss; oss << "FermiDensity." << iRange; iRange++;
+				names.push_back(oss.str());
+			}
+		}
+		//Calculate and dump densities:
+		std::vector<ScalarFieldArray> densities = eVars.calcDensities(Fsets);
+		for(size_t iSet=0; iSet<densities.size(); iSet++)
+		{	DUMP_spinCollection(densities[iSet], names[iSet])
+		}
 	}
 	
 	//----------------------------------------------------------------------
@@ -787,6 +842,39 @@ bool Dump::checkInterval(DumpFrequency freq, int iter) const
 		|| ((iter+1) % intervalFreq->second == 0)); //or iteration number is divisible by it
 }
 
+void Dump::getBandWindow(int& bStart, int& bStop) const
+{	const ElecInfo& eInfo = e->eInfo;
+	bStart = 0; bStop = eInfo.nBands;
+	if(!bandWindowSet()) return;
+	bStart = eInfo.nBands; bStop = 0;
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		for(int b=0; b<eInfo.nBands; b++)
+		{	double E = e->eVars.Hsub_eigs[q][b];
+			if(E >= bandWindowMin && E <= bandWindowMax)
+			{	bStart = std::min(bStart, b);
+				bStop = std::max(bStop, b+1);
+			}
+		}
+	mpiWorld->allReduce(bStart, MPIUtil::ReduceMin);
+	mpiWorld->allReduce(bStop, MPIUtil::ReduceMax);
+	if(bStart >= bStop)
+	{	logPrintf("WARNING: no bands within band window [%lg,%lg].\n", bandWindowMin, bandWindowMax);
+		bStart = 0; bStop = 0;
+	}
+}
+
+void PairScreening::report(const char* name, const MPIUtil* mpiUtil) const
+{	if(threshold)
+	{	size_t counts[2] = { nTotal, nKept };
+		if(mpiUtil) mpiUtil->allReduce(counts, 2, MPIUtil::ReduceSum);
+		if(counts[0])
+			logPrintf("\t%s: pair screening retained %lu of %lu pairs (pruned %.1lf%%).\n",
+				name, counts[1], counts[0], (counts[0]-counts[1])*100./counts[0]);
+	}
+	nTotal = 0;
+	nKept = 0;
+}
+
 string Dump::getFilename(string varName) const
 {	//Create a map of substitutions:
 	std::map<string,string> subMap;
@@ -814,3 +902,187 @@ string Dump::getFilename(string varName) const
 	}
 	return fname;
 }
+
+//Host snapshot of the local wavefunctions, written out by a separate thread:
+struct AsyncWrite
+{	std::thread thread;
+	std::vector<std::vector<char>> buf; //snapshot in output precision and little-endian byte order
+	string fname, error;
+	long offset, fsize; //offset of this process's data, and total file size
+	
+	~AsyncWrite() { if(thread.joinable()) thread.join(); }
+	
+	//Run in the writer thread: no MPI calls allowed here
+	void run()
+	{	int fd = open(fname.c_str(), O_WRONLY|O_CREAT, 0644);
+		if(fd<0) { error = "Error opening file '" + fname + "' for writing.\n"; return; }
+		if(mpiWorld->isHead() && ftruncate(fd, fsize)!=0) //discard stale contents beyond current length
+			error = "Error resizing file '" + fname + "'.\n";
+		for(const std::vector<char>& b: buf)
+		{	const char* ptr = b.data();
+			size_t nBytes = b.size();
+			while(nBytes && !error.length())
+			{	ssize_t nWritten = pwrite(fd, ptr, nBytes, offset);
+				if(nWritten<=0) error = "Error writing to file '" + fname + "'.\n";
+				else { ptr += nWritten; nBytes -= nWritten; offset += nWritten; }
+			}
+		}
+		if(close(fd)!=0 && !error.length())
+			error = "Error closing file '" + fname + "'.\n";
+	}
+};
+
+//Same file layout as ElecInfo::write, but staged to host memory and written using positioned POSIX I/O from a
+//writer thread, so that the next step can proceed without waiting for the file system (and without MPI_THREAD_MULTIPLE)
+void Dump::writeWfnsAsync(string fname)
+{	static StopWatch watch("Dump::writeWfnsAsync"); watch.start();
+	waitAsync(); //at most one snapshot in memory at a time
+	const ElecInfo& eInfo = e->eInfo;
+	const std::vector<ColumnBundle>& C = e->eVars.C;
+	asyncWrite = std::make_shared<AsyncWrite>();
+	AsyncWrite& aw = *asyncWrite;
+	aw.fname = fname;
+	//Compute offset and file length collectively (same as ElecInfo::write):
+	size_t bytesPerEntry = wfnsSinglePrecision ? 2*sizeof(float) : sizeof(complex);
+	std::vector<long> nBytes(mpiWorld->nProcesses(), 0);
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		nBytes[mpiWorld->iProcess()] += C[q].nData()*bytesPerEntry;
+	if(mpiWorld->nProcesses()>1)
+		for(int iSrc=0; iSrc<mpiWorld->nProcesses(); iSrc++)
+			mpiWorld->bcast(nBytes[iSrc], iSrc);
+	aw.offset = 0; aw.fsize = 0;
+	for(int iSrc=0; iSrc<mpiWorld->nProcesses(); iSrc++)
+	{	if(iSrc<mpiWorld->iProcess()) aw.offset += nBytes[iSrc];
+		aw.fsize += nBytes[iSrc];
+	}
+	//Snapshot (includes GPU to host copy, if necessary):
+	aw.buf.resize(eInfo.qStop-eInfo.qStart);
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+	{	std::vector<char>& b = aw.buf[q-eInfo.qStart];
+		b.resize(C[q].nData()*bytesPerEntry);
+		const complex* Cdata = C[q].data();
+		if(wfnsSinglePrecision)
+		{	float* bData = (float*)b.data();
+			for(size_t i=0; i<C[q].nData(); i++)
+			{	bData[2*i] = float(Cdata[i].real());
+				bData[2*i+1] = float(Cdata[i].imag());
+			}
+			convertToLE(bData, sizeof(float), 2*C[q].nData());
+		}
+		else
+		{	memcpy(b.data(), Cdata, b.size());
+			convertToLE(b.data(), sizeof(complex), C[q].nData());
+		}
+	}
+	aw.thread = std::thread(&AsyncWrite::run, &aw);
+	watch.stop();
+}
+
+void Dump::waitAsync()
+{	if(!asyncWrite) return;
+	static StopWatch watch("Dump::waitAsync"); watch.start();
+	asyncWrite->thread.join();
+	string error = asyncWrite->error;
+	asyncWrite = 0;
+	watch.stop();
+	if(error.length()) die_alone("%s", error.c_str());
+}
+
+void Dump::streamWfnsStart()
+{	if(!count(std::make_pair(DumpFreq_End, DumpState))) return;
+	const ElecInfo& eInfo = e->eInfo;
+	curIter = 0; curFreq = DumpFreq_End; //used by getFilename()
+	size_t bytesPerEntry = wfnsSinglePrecision ? 2*sizeof(float) : sizeof(complex);
+	std::vector<size_t> recordSizes(eInfo.nStates); //same layout as ElecInfo::write
+	for(int q=0; q<eInfo.nStates; q++)
+		recordSizes[q] = e->basis[q].nbasis * eInfo.spinorLength() * eInfo.nBands * bytesPerEntry;
+	string fname = getFilename("wfns");
+	logPrintf("Wavefunctions will be written to '%s' as each state converges.\n", fname.c_str());
+	wfnsStream = std::make_shared<StateRecordWriter>(eInfo, fname, recordSizes);
+}
+
+void Dump::streamWfns(int q)
+{	if(!wfnsStream) return;
+	const ColumnBundle& Cq = e->eVars.C[q];
+	if(wfnsSinglePrecision)
+	{	std::vector<float> buf(2*Cq.nData());
+		const complex* Cdata = Cq.data();
+		for(size_t i=0; i<Cq.nData(); i++)
+		{	buf[2*i] = float(Cdata[i].real());
+			buf[2*i+1] = float(Cdata[i].imag());
+		}
+		wfnsStream->write(q, buf.data(), sizeof(float), buf.size());
+	}
+	else wfnsStream->write(q, Cq);
+}
+
+void Dump::streamWfnsFinish()
+{	wfnsStream = 0;
+}
+
+//------------------------ class StateRecordWriter ---------------------------------
+
+void Dump::saveVisualization(const ScalarField& X, string fname) const
+{	if(visualizationFormats.count(VisualizationVTI))
+		saveVTI(X, (fname+".vti").c_str(), "data");
+	if(visualizationFormats.count(VisualizationXSF))
+	{	std::vector<std::pair<int,vector3<>>> atoms;
+		for(const auto& sp: e->iInfo.species)
+			for(const vector3<>& pos: sp->atpos)
+				atoms.push_back(std::make_pair(sp->atomicNumber, e->gInfo.R * pos));
+		saveXSF(X, (fname+".xsf").c_str(), "data", atoms);
+	}
+}
+
+StateRecordWriter::StateRecordWriter(const ElecInfo& eInfo, string fname, size_t recordSize)
+: StateRecordWriter(eInfo, fname, std::vector<size_t>(eInfo.nStates, recordSize))
+{
+}
+
+StateRecordWriter::StateRecordWriter(const ElecInfo& eInfo, string fname, const std::vector<size_t>& recordSizes)
+: eInfo(eInfo), fname(fname), recordSizes(recordSizes), offsets(eInfo.nStates, 0)
+{	assert(int(recordSizes.size()) == eInfo.nStates);
+	for(int q=1; q<eInfo.nStates; q++)
+		offsets[q] = offsets[q-1] + recordSizes[q-1];
+	#if !MPI_SAFE_WRITE
+	mpiWorld->fopenWrite(fp, fname.c_str());
+	#endif
+}
+
+StateRecordWriter::~StateRecordWriter()
+{
+	#if MPI_SAFE_WRITE
+	if(mpiWorld->isHead())
+	{	FILE* fpOut = fopen(fname.c_str(), "w");
+		if(!fpOut) die_alone("Error opening file '%s' for writing.\n", fname.c_str());
+		std::vector<char> buf;
+		for(int q=0; q<eInfo.nStates; q++)
+		{	if(eInfo.isMine(q)) fwrite(records[q].data(), 1, recordSizes[q], fpOut);
+			else
+			{	buf.resize(recordSizes[q]);
+				mpiWorld->recvData(buf, eInfo.whose(q), q);
+				fwrite(buf.data(), 1, recordSizes[q], fpOut);
+			}
+		}
+		fclose(fpOut);
+	}
+	else
+		for(const auto& record: records)
+			mpiWorld->sendData(record.second, 0, record.first);
+	#else
+	mpiWorld->fclose(fp);
+	#endif
+}
+
+void StateRecordWriter::write(int q, const void* data, size_t size, size_t nmemb)
+{	assert(eInfo.isMine(q));
+	assert(size*nmemb == recordSizes[q]);
+	#if MPI_SAFE_WRITE
+	std::vector<char>& record = records[q];
+	record.assign((const char*)data, (const char*)data + recordSizes[q]);
+	convertToLE(record.data(), size, nmemb);
+	#else
+	mpiWorld->fseek(fp, offsets[q], SEEK_SET);
+	mpiWorld->fwrite(data, size, nmemb, fp);
+	#endif
+}
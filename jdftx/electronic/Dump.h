@@ -53,10 +53,45 @@ enum DumpVariable { DumpNone, DumpState, //None or exactly those required to res
 	DumpDOS, DumpPolarizability, DumpElectronScattering, DumpSIC, DumpDipole, DumpStress, DumpExcitations, DumpFCI, DumpSpin,
 	DumpMomenta, DumpVelocities, DumpFermiVelocity,
 	DumpSymmetries, DumpKpoints, DumpGvectors, DumpOrbitalDep, DumpXCanalysis, DumpEresolvedDensity, DumpFermiDensity,
+	DumpCheckpoint, //single-file HDF5 checkpoint of the state (see Checkpoint.h)
+	DumpTrajectory, //append-only binary trajectory (see TrajectoryWriter in Dump_internal.h)
 	DumpDelim, //special value used as a delimiter during command processing
 };
 
 
+//! Visualization formats written alongside the raw binary output of scalar fields:
+enum VisualizationFormat
+{	VisualizationVTI, //!< VTK XML image data with raw binary values (see saveVTI)
+	VisualizationXSF //!< XCrySDen structure file with the lattice and atoms (see saveXSF)
+};
+
+//! Screening of occupied-unoccupied pairs in response outputs (Polarizability, ElectronScattering, Excitations)
+//! by their weight |fi - fj| / |Ej - Ei -/+ omega|, maximized over frequencies omega in [0,omegaMax]
+struct PairScreening
+{	double threshold; //!< drop pairs whose weight is below this before computing pair densities (0 => keep all pairs)
+	double omegaMax; //!< maximum frequency of interest (Eh), used where the output does not have its own frequency grid
+	
+	PairScreening() : threshold(0.), omegaMax(0.), nTotal(0), nKept(0) {}
+	
+	//! Whether a pair with fillings fi, fj and energies Ei, Ej is needed, for frequencies up to omegaMaxCur
+	//! (this->omegaMax if negative); also counts pairs for report()
+	bool operator()(double fi, double fj, double Ei, double Ej, double omegaMaxCur=-1.) const
+	{	nTotal++;
+		if(threshold)
+		{	double dEmin = std::max(0., fabs(Ej-Ei) - (omegaMaxCur<0. ? omegaMax : omegaMaxCur)); //closest approach to pole
+			if(!(fabs(fi-fj) > threshold*dEmin)) return false;
+		}
+		nKept++;
+		return true;
+	}
+	
+	//! Log fraction of pairs retained since last report (collectively over mpiUtil if non-null) and reset counts
+	void report(const char* name, const class MPIUtil* mpiUtil=0) const;
+	
+private:
+	mutable size_t nTotal, nKept; //!< pair counts since last report
+};
+
 //! Stores list of what to output and when, and implements functions to do so
 class Dump : public std::set<std::pair<DumpFrequency,DumpVariable> >
 {
@@ -85,6 +120,20 @@ public:
 	std::shared_ptr<struct BGWparams> bgwParams; //!< parameters for BGW claculation if any
 	bool potentialSubtraction; //!< whether to subtract neutral-atom potentials in Dvac and Dtot output
 	matrix3<int> Munfold; //!< transformation matrix for band structure unfolding
+	int checkpointCompression; //!< deflate compression level (0-9, 0 = none) for the large datasets in checkpoint output
+	bool wfnsSinglePrecision; //!< whether to store wavefunctions in single precision in state dumps
+	bool asyncState; //!< whether to write wavefunctions of intermediate (non-End) state dumps in the background
+	std::set<VisualizationFormat> visualizationFormats; //!< visualization files to write alongside each scalar field dump (see dump-visualization)
+	double bandWindowMin, bandWindowMax; //!< energy window restricting bands in Momenta and Excitations output (all bands if empty)
+	bool bandWindowSet() const { return bandWindowMin < bandWindowMax; } //!< whether a band window has been specified
+	void getBandWindow(int& bStart, int& bStop) const; //!< range of bands with any eigenvalue within the band window over all states (collective)
+	PairScreening pairScreening; //!< screening of pairs in Polarizability, ElectronScattering and Excitations output
+	std::set<std::pair<DumpFrequency,string> > analyses; //!< in-situ analyses (see DumpAnalysis.h) to run at each frequency
+	
+	//Wavefunction output during band-streaming (see Control::bandStreaming), replacing that of the State dump at End:
+	void streamWfnsStart(); //!< collectively open the End wfns file (if State is dumped at End) with a record for each state
+	void streamWfns(int q); //!< write wavefunctions of local state q (once converged, before they are freed)
+	void streamWfnsFinish(); //!< collectively close the End wfns file
 private:
 	const Everything* e;
 	string format; //!< Filename format containing $VAR, $STAMP, $FREQ etc.
@@ -92,6 +141,10 @@ private:
 	int curIter; DumpFrequency curFreq; //!< iteration number and dump-frequency of most recent operator() call
 	std::map<DumpFrequency,int> interval; //!< for each frequency, dump every interval times
 	std::map<DumpFrequency,string> formatFreq; //!< frequency-dependent format override
+	std::shared_ptr<struct AsyncWrite> asyncWrite; //!< pending background write of wavefunctions, if any
+	std::shared_ptr<class StateRecordWriter> wfnsStream; //!< End wfns file written state by state during band-streaming
+	std::shared_ptr<class TrajectoryWriter> trajectory; //!< open binary trajectory, kept between dumps to append frames
+	void saveVisualization(const ScalarField& X, string fname) const; //!< write visualizationFormats versions of X dumped to fname (head only)
 	friend class Phonon;
 	friend class DefectSupercell;
 	friend struct CommandDump;
@@ -102,6 +155,9 @@ private:
 	void dumpBGW(); //!< BerkeleyGW code export implemented in DumpBGW.cpp
 	void dumpRsol(ScalarField nbound, string fname);
 	void dumpUnfold();
+	void runAnalyses(DumpFrequency freq, int iter); //!< run in-situ analyses selected for freq (implemented in DumpAnalysis.cpp)
+	void writeWfnsAsync(string fname); //!< snapshot wavefunctions and write them to fname in the background
+	void waitAsync(); //!< wait for completion of pending background write, if any
 };
 
 //! @}
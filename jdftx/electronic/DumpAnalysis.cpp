@@ -0,0 +1,121 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/DumpAnalysis.h>
+#include <electronic/Everything.h>
+
+static std::map<string,DumpAnalysis*>& updateDumpAnalysisMap(DumpAnalysis* analysis=0)
+{	static std::map<string,DumpAnalysis*> analysisMap; //make this local static for correct initialization order
+	if(analysis) analysisMap[analysis->name] = analysis;
+	return analysisMap;
+}
+
+std::map<string,DumpAnalysis*>& getDumpAnalysisMap()
+{	return updateDumpAnalysisMap();
+}
+
+DumpAnalysis::DumpAnalysis(string name) : name(name)
+{	updateDumpAnalysisMap(this);
+}
+
+void Dump::runAnalyses(DumpFrequency freq, int iter)
+{	static const char* freqNames[DumpFreq_Delim] = { "End", "Init", "Electronic", "Fluid", "Ionic", "Gummel" };
+	const std::map<string,DumpAnalysis*>& analysisMap = getDumpAnalysisMap();
+	for(const auto& entry: analyses)
+		if(entry.first == freq)
+		{	auto iter_analysis = analysisMap.find(entry.second);
+			assert(iter_analysis != analysisMap.end()); //checked by command dump-analysis
+			string fname = getFilename("analysis." + entry.second);
+			logPrintf("Appending analysis '%s' to '%s' ... ", entry.second.c_str(), fname.c_str()); logFlush();
+			FILE* fp = 0;
+			if(mpiWorld->isHead())
+			{	fp = fopen(fname.c_str(), "a");
+				if(!fp) die_alone("Error opening %s for appending.\n", fname.c_str());
+				fprintf(fp, "# %s %d\n", freqNames[freq], iter);
+			}
+			(*(iter_analysis->second))(*e, freq, iter, fp);
+			if(fp) fclose(fp);
+			logPrintf("done\n"); logFlush();
+		}
+}
+
+
+//---------------------- Built-in analyses -----------------------------------------
+
+//Planar averages of the total electron density perpendicular to each lattice direction
+struct DumpAnalysisPlanarAverage : public DumpAnalysis
+{	DumpAnalysisPlanarAverage() : DumpAnalysis("PlanarAverage") {}
+	
+	void operator()(const Everything& e, DumpFrequency freq, int iter, FILE* fp) const
+	{	if(!fp) return; //grid quantities are available on all processes
+		ScalarField nTot = e.eVars.get_nTot();
+		const vector3<int>& S = e.gInfo.S;
+		const double* nData = nTot->data();
+		for(int dir=0; dir<3; dir++)
+		{	std::vector<double> avg(S[dir], 0.);
+			vector3<int> iv; size_t i = 0;
+			for(iv[0]=0; iv[0]<S[0]; iv[0]++)
+			for(iv[1]=0; iv[1]<S[1]; iv[1]++)
+			for(iv[2]=0; iv[2]<S[2]; iv[2]++)
+				avg[iv[dir]] += nData[i++];
+			double norm = double(S[dir]) / e.gInfo.nr;
+			fprintf(fp, "n_avg%d", dir);
+			for(double a: avg) fprintf(fp, " %.10le", a*norm);
+			fprintf(fp, "\n");
+		}
+	}
+}
+dumpAnalysisPlanarAverage;
+
+//Filling-weighted centers and widths of the occupied and unoccupied bands of each spin channel
+struct DumpAnalysisBandStats : public DumpAnalysis
+{	DumpAnalysisBandStats() : DumpAnalysis("BandStats") {}
+	
+	void operator()(const Everything& e, DumpFrequency freq, int iter, FILE* fp) const
+	{	const ElecInfo& eInfo = e.eInfo;
+		const ElecVars& eVars = e.eVars;
+		int nSpins = eInfo.nSpins();
+		//Moments (weight, weight*E, weight*E^2) of occupied and unoccupied weights per spin:
+		std::vector<double> moments(nSpins*6, 0.);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	double* m = moments.data() + 6*eInfo.qnums[q].index();
+			for(int b=0; b<eInfo.nBands; b++)
+			{	double E = eVars.Hsub_eigs[q][b];
+				double wOcc = eInfo.qnums[q].weight * eVars.F[q][b];
+				double wUnocc = eInfo.qnums[q].weight * (1.-eVars.F[q][b]);
+				m[0] += wOcc; m[1] += wOcc*E; m[2] += wOcc*E*E;
+				m[3] += wUnocc; m[4] += wUnocc*E; m[5] += wUnocc*E*E;
+			}
+		}
+		mpiWorld->allReduceData(moments, MPIUtil::ReduceSum);
+		if(!fp) return;
+		fprintf(fp, "#spin  nOcc  Eocc_center Eocc_width  nUnocc  Eunocc_center Eunocc_width\n");
+		for(int s=0; s<nSpins; s++)
+		{	fprintf(fp, "%d", s);
+			for(int j=0; j<2; j++)
+			{	const double* m = moments.data() + 6*s + 3*j;
+				double center = m[0] ? m[1]/m[0] : 0.;
+				double width = m[0] ? sqrt(std::max(0., m[2]/m[0] - center*center)) : 0.;
+				fprintf(fp, "  %.10lf %.10lf %.10lf", m[0], center, width);
+			}
+			fprintf(fp, "\n");
+		}
+	}
+}
+dumpAnalysisBandStats;
@@ -0,0 +1,60 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_DUMPANALYSIS_H
+#define JDFTX_ELECTRONIC_DUMPANALYSIS_H
+
+#include <electronic/Dump.h>
+#include <core/string.h>
+#include <map>
+
+class Everything;
+
+//! @addtogroup Output
+//! @{
+
+/** @file DumpAnalysis.h
+@brief In-situ analyses run at dump points (command dump-analysis)
+
+An analysis computes a few compact results (scalars, planar averages, statistics)
+from the current state with read access to Everything, and appends them to a text
+file, instead of dumping full scalar fields or wavefunctions for post-processing.
+To add an analysis, derive from DumpAnalysis and define a static instance of it in
+any source file linked into the executable: it registers itself by name (the same
+way as commands), and then becomes available to dump-analysis.
+*/
+
+//! Base class for in-situ analyses
+class DumpAnalysis
+{
+public:
+	string name; //!< name used in dump-analysis and in the output filename
+	
+	DumpAnalysis(string name); //!< register this analysis by name (construct static instances only)
+	virtual ~DumpAnalysis() {}
+	
+	//! Perform the analysis for dump frequency freq at iteration iter. Called on all processes,
+	//! so that it may use collective operations; fp is the output file on the head process and null on others.
+	virtual void operator()(const Everything& e, DumpFrequency freq, int iter, FILE* fp) const = 0;
+};
+
+std::map<string,DumpAnalysis*>& getDumpAnalysisMap(); //!< map from names to analyses registered during static initialization
+
+//! @}
+#endif // JDFTX_ELECTRONIC_DUMPANALYSIS_H
@@ -31,16 +31,58 @@ void Dump::dumpBGW()
 void Dump::dumpBGW()
 {	if(!bgwParams) bgwParams = std::make_shared<BGWparams>(); //default parameters
 	BGW bgw(*e, *bgwParams);
-	bgw.writeWfn();
-	bgw.writeVxc();
+	
+	//Manifest of completed outputs, so that an interrupted export can be resumed:
+	string manifestFname = getFilename("bgw.manifest");
+	std::set<string> completed;
+	if(mpiWorld->isHead())
+	{	if(bgwParams->resume)
+		{	std::ifstream ifs(manifestFname.c_str());
+			string name;
+			while(ifs >> name) completed.insert(name);
+		}
+		else fclose(fopen(manifestFname.c_str(), "w")); //start new manifest
+	}
+	string completedStr; //space separated list for broadcast
+	for(const string& name: completed) completedStr += name + " ";
+	mpiWorld->bcast(completedStr);
+	{	istringstream iss(completedStr);
+		string name;
+		while(iss >> name) completed.insert(name);
+	}
+	auto isComplete = [&](string name)
+	{	bool result = completed.count(name);
+		if(result) logPrintf("Skipping BGW output '%s' (completed in previous run).\n", name.c_str());
+		return result;
+	};
+	auto markComplete = [&](string name)
+	{	if(mpiWorld->isHead())
+		{	FILE* fp = fopen(manifestFname.c_str(), "a");
+			if(fp) { fprintf(fp, "%s\n", name.c_str()); fclose(fp); }
+		}
+	};
+	#define BGW_STEP(name, code) \
+		if(!isComplete(name)) \
+		{	code; \
+			markComplete(name); \
+		}
+	
+	//With a dense solve, Vxc depends on results (bands) computed along with the wavefunctions:
+	if(bgwParams->nBandsDense && !(completed.count("wfn") && completed.count("vxc")))
+	{	completed.erase("wfn");
+		completed.erase("vxc");
+	}
+	BGW_STEP("wfn", bgw.writeWfn())
+	BGW_STEP("vxc", bgw.writeVxc())
 	if(e->eVars.fluidSolver and bgwParams->EcutChiFluid)
-	{	bgw.writeChiFluid(true); //write q0
-		bgw.writeChiFluid(false); //write q != q0
+	{	BGW_STEP("chiFluid0", bgw.writeChiFluid(true)) //write q0
+		BGW_STEP("chiFluid", bgw.writeChiFluid(false)) //write q != q0
 	}
 	if(bgwParams->Ecut_rALDA)
-	{	bgw.write_rALDA(true); //write q0
-		bgw.write_rALDA(false); //write q != q0
+	{	BGW_STEP("rALDA0", bgw.write_rALDA(true)) //write q0
+		BGW_STEP("rALDA", bgw.write_rALDA(false)) //write q != q0
 	}
+	#undef BGW_STEP
 }
 
 
@@ -110,46 +152,14 @@ void BGW::writeWfn() const
 	h5writeVector(gidWfns, "gvecs", &iGarr[0][0], dimsGwfns, 2);
 	//--- Coefficients:
 	if(bgwp.nBandsDense)
-	{	//Write results of a ScaLAPACK solve:
-		((BGW*)this)->denseWriteWfn(gidWfns);
+	{	//Write results of a ScaLAPACK or iterative solve:
+		if(bgwp.denseSolver == BGWparams::DenseLOBPCG)
+			((BGW*)this)->iterativeWriteWfn(gidWfns);
+		else
+			((BGW*)this)->denseWriteWfn(gidWfns);
 	}
 	else //Default output of bands from usual totalE / bandstructure calculation
-	{	//Create dataset (must happen on all processes together):
-		hsize_t dims[4] = { hsize_t(nBands), hsize_t(nSpins*nSpinor), iGarr.size(), 2 };
-		hid_t sid = H5Screate_simple(4, dims, NULL);
-		hid_t did = H5Dcreate(gidWfns, "coeffs", H5T_NATIVE_DOUBLE, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-		hid_t plid = H5Pcreate(H5P_DATASET_XFER);
-		H5Sclose(sid);
-		//Loop over k, bands and spin/spinors:
-		hsize_t offset[4] = { 0, 0, 0, 0 };
-		hsize_t count[4] = { 1, 1, 1, 2 };
-		std::vector<complex> buffer(*std::max_element(nBasis.begin(), nBasis.end()));
-		double volScaleFac = sqrt(gInfo.detR);
-		for(int iSpin=0; iSpin<nSpins; iSpin++)
-		for(int iSpinor=0; iSpinor<nSpinor; iSpinor++)
-		{	offset[1] = iSpin*nSpinor + iSpinor;
-			for(int ik=0; ik<nReducedKpts; ik++)
-			{	int q=iSpin*nReducedKpts+ik;
-				if(!eInfo.isMine(q)) continue;
-				count[2] = nBasis[ik];
-				offset[2] = nBasisPrev[ik];
-				hid_t sidMem = H5Screate_simple(4, count, NULL);
-				for(int b=0; b<nBands; b++)
-				{	offset[0] = b;
-					sid = H5Dget_space(did);
-					H5Sselect_hyperslab(sid, H5S_SELECT_SET, offset, NULL, count, NULL);
-					//Copy to buffer and scale:
-					eblas_copy(buffer.data(), eVars.C[q].data()+eVars.C[q].index(b, iSpinor*nBasis[ik]), nBasis[ik]);
-					eblas_zdscal(nBasis[ik], volScaleFac, buffer.data(), 1);
-					//Write buffer to HDF5:
-					H5Dwrite(did, H5T_NATIVE_DOUBLE, sidMem, sid, plid, buffer.data());
-				}
-				H5Sclose(sidMem);
-			}
-		}
-		H5Pclose(plid);
-		H5Dclose(did);
-	}
+		writeCoeffs(gidWfns, eVars.C);
 	H5Gclose(gidWfns);
 	
 	//Write common header at end (so as to use updated eigenvalues and fillings from scalapack solve, if any)
@@ -161,6 +171,62 @@ void BGW::writeWfn() const
 }
 
 
+//Write nBands wavefunctions of each state to dataset coeffs:
+void BGW::writeCoeffs(hid_t gidWfns, const std::vector<ColumnBundle>& C) const
+{	//Create dataset (must happen on all processes together):
+	hsize_t nGtot = nBasisPrev.back() + nBasis.back();
+	hsize_t dims[4] = { hsize_t(nBands), hsize_t(nSpins*nSpinor), nGtot, 2 };
+	hid_t sid = H5Screate_simple(4, dims, NULL);
+	hid_t did = H5Dcreate(gidWfns, "coeffs", H5T_NATIVE_DOUBLE, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	hid_t plid = H5Pcreate(H5P_DATASET_XFER);
+	H5Sclose(sid);
+	//Loop over k, bands and spin/spinors:
+	hsize_t offset[4] = { 0, 0, 0, 0 };
+	hsize_t count[4] = { 1, 1, 1, 2 };
+	std::vector<complex> buffer(*std::max_element(nBasis.begin(), nBasis.end()));
+	double volScaleFac = sqrt(gInfo.detR);
+	for(int iSpin=0; iSpin<nSpins; iSpin++)
+	for(int iSpinor=0; iSpinor<nSpinor; iSpinor++)
+	{	offset[1] = iSpin*nSpinor + iSpinor;
+		for(int ik=0; ik<nReducedKpts; ik++)
+		{	int q=iSpin*nReducedKpts+ik;
+			if(!eInfo.isMine(q)) continue;
+			count[2] = nBasis[ik];
+			offset[2] = nBasisPrev[ik];
+			hid_t sidMem = H5Screate_simple(4, count, NULL);
+			for(int b=0; b<nBands; b++)
+			{	offset[0] = b;
+				sid = H5Dget_space(did);
+				H5Sselect_hyperslab(sid, H5S_SELECT_SET, offset, NULL, count, NULL);
+				//Copy to buffer and scale:
+				eblas_copy(buffer.data(), C[q].data()+C[q].index(b, iSpinor*nBasis[ik]), nBasis[ik]);
+				eblas_zdscal(nBasis[ik], volScaleFac, buffer.data(), 1);
+				//Write buffer to HDF5:
+				H5Dwrite(did, H5T_NATIVE_DOUBLE, sidMem, sid, plid, buffer.data());
+			}
+			H5Sclose(sidMem);
+		}
+	}
+	H5Pclose(plid);
+	H5Dclose(did);
+}
+
+
+//Exchange-correlation matrix elements between bands Cq of state q:
+matrix BGW::getVxcSub(int q, const ColumnBundle& Cq) const
+{	ColumnBundle HCq = gInfo.dV * Idag_DiagV_I(Cq, eVars.Vxc);
+	if(e.exCorr.needsKEdensity() && eVars.Vtau[eInfo.qnums[q].index()]) //metaGGA KE potential
+	{	for(int iDir=0; iDir<3; iDir++)
+			HCq -= (0.5*gInfo.dV) * D(Idag_DiagV_I(D(Cq,iDir), eVars.Vtau), iDir);
+	}
+	if(e.eInfo.hasU) //Contribution via atomic density matrix projections (DFT+U)
+		e.iInfo.rhoAtom_grad(Cq, eVars.U_rhoAtom, HCq);
+	if(e.exCorr.exxFactor()) //Exact-exchange contributions:
+		e.exx->applyHamiltonian(e.exCorr.exxFactor(), e.exCorr.exxRange(), q, diagMatrix(Cq.nCols(), 0.), Cq, HCq);
+	return Cq ^ HCq;
+}
+
+
 //Write exchange-correlation matrix elements for BGW
 void BGW::writeVxc() const
 {
@@ -173,16 +239,7 @@ void BGW::writeVxc() const
 	if(e.exCorr.exxFactor()) e.exx->prepareHamiltonian(e.exCorr.exxRange(), e.eVars.F, e.eVars.C);
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
 	{	if(VxcSub[q]) continue; //already calculated (dense version)
-		ColumnBundle HCq = gInfo.dV * Idag_DiagV_I(eVars.C[q], eVars.Vxc);
-		if(e.exCorr.needsKEdensity() && eVars.Vtau[eInfo.qnums[q].index()]) //metaGGA KE potential
-		{	for(int iDir=0; iDir<3; iDir++)
-				HCq -= (0.5*gInfo.dV) * D(Idag_DiagV_I(D(eVars.C[q],iDir), eVars.Vtau), iDir);
-		}
-		if(e.eInfo.hasU) //Contribution via atomic density matrix projections (DFT+U)
-			e.iInfo.rhoAtom_grad(eVars.C[q], eVars.U_rhoAtom, HCq);
-		if(e.exCorr.exxFactor()) //Exact-exchange contributions:
-			e.exx->applyHamiltonian(e.exCorr.exxFactor(), e.exCorr.exxRange(), q, eVars.F[q], eVars.C[q], HCq);
-		VxcSub[q] = eVars.C[q] ^ HCq;
+		VxcSub[q] = getVxcSub(q, eVars.C[q]);
 	}
 	
 	//Output from head
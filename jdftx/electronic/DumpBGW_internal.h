@@ -28,10 +28,20 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 //! Parameters for BGW output
 struct BGWparams
-{	int nBandsDense; //!< if non-zero, use a dense ScaLAPACK solver to calculate more bands
+{	int nBandsDense; //!< if non-zero, calculate this many bands using denseSolver
 	int blockSize; //!< block size for ScaLAPACK diagonalization
 	int clusterSize; //!< maximum eigenvalue cluster size to allocate extra ScaLAPACK workspace for
 	
+	//! Solver for the nBandsDense bands
+	enum DenseSolver
+	{	DenseScaLAPACK, //!< full plane-wave Hamiltonian diagonalized using ScaLAPACK
+		DenseLOBPCG //!< iterative, in blocks of iterBlockSize bands, each deflated against all lower bands
+	} denseSolver;
+	int iterBlockSize; //!< number of bands converged together by the iterative solver
+	double iterTol; //!< residual norm (in Eh) threshold for the bands of the DFT calculation in the iterative solver
+	double iterTolHigh; //!< residual norm threshold for the highest band (geometrically interpolated in between)
+	int iterMax; //!< maximum iterations per block of the iterative solver
+	
 	double EcutChiFluid; //!< KE cutoff for fluid polarizability output (enabled if non-zero)
 	bool elecOnly; //!< whether to only output electronic polarizability of fluid (default: true)
 	vector3<> q0; //!< zero wavevector replacement used for polarizability output
@@ -43,10 +53,13 @@ struct BGWparams
 	
 	double Ecut_rALDA; //!< KE cutoff (in Eh) for rALDA output (enabled if non-zero)
 	
+	bool resume; //!< whether to skip outputs recorded as complete in the manifest of a previous (interrupted) run
+	
 	BGWparams() : nBandsDense(0), blockSize(32), clusterSize(10),
+		denseSolver(DenseScaLAPACK), iterBlockSize(64), iterTol(1e-6), iterTolHigh(1e-4), iterMax(100),
 		EcutChiFluid(0.), elecOnly(true),
 		freqReMax_eV(30.), freqReStep_eV(1.), freqBroaden_eV(0.1),
-		freqNimag(25), freqPlasma(1.), Ecut_rALDA(0.)
+		freqNimag(25), freqPlasma(1.), Ecut_rALDA(0.), resume(false)
 	{}
 };
 
@@ -86,6 +99,8 @@ class BGW
 		std::vector<vector3<>>& q, std::vector<complex>& freq,
 		std::vector<std::vector<vector3<int>>>& iGarr,
 		std::vector<int>& nBasis, int& nBasisMax) const; //!< Initialize header for polarizabilities, along with q and G-space quantities
+	void writeCoeffs(hid_t gidWfns, const std::vector<ColumnBundle>& C) const; //!< Write nBands wavefunctions of each state (O-normalized) to dataset coeffs
+	matrix getVxcSub(int q, const ColumnBundle& Cq) const; //!< Exchange-correlation matrix elements between the bands Cq of state q (EXX must be prepared)
 
 public:
 	BGW(const Everything& e, const BGWparams& bgwp);
@@ -95,6 +110,9 @@ public:
 	//Implemented in DumpBGW_dense.cpp
 	void denseWriteWfn(hid_t gidWfns); //!< Solve and output wavefunctions using ScaLAPACK
 	
+	//Implemented in DumpBGW_iterative.cpp
+	void iterativeWriteWfn(hid_t gidWfns); //!< Solve and output wavefunctions using block LOBPCG
+	
 	//Implemented in DumpBGW_fluid.cpp
 	void writeChiFluid(bool write_q0) const; //!< Write fluid polarizability (for q0 or for q != q0 depending on write_q0)
 	
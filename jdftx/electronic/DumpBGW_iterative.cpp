@@ -0,0 +1,215 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifdef HDF5_ENABLED //BGW output requires HDF5
+
+#include <electronic/DumpBGW_internal.h>
+#include <electronic/ColumnBundle.h>
+#include <electronic/ExactExchange.h>
+
+//Apply Hamiltonian of state q to Y, divided by the constant overlap of norm-conserving pseudopotentials
+//(swaps Y into eVars.C[q] temporarily, as in BandChebyshev::applyH):
+static ColumnBundle applyH(Everything& e, int q, ColumnBundle& Y)
+{	ElecVars& eVars = e.eVars;
+	std::vector<matrix> VdagY;
+	e.iInfo.project(Y, VdagY);
+	ColumnBundle HY;
+	matrix HsubY; diagMatrix HsubY_eigs;
+	Energies ener; //not really used here
+	#define SWAP_C_Y \
+		std::swap(eVars.C[q], Y); \
+		std::swap(eVars.VdagC[q], VdagY); \
+		std::swap(eVars.Hsub[q], HsubY); \
+		std::swap(eVars.Hsub_eigs[q], HsubY_eigs);
+	SWAP_C_Y //Temporarily swap C and Y
+	eVars.applyHamiltonian(q, eye(eVars.C[q].nCols()), HY, ener, true, false); //Hamiltonian always operates on C, where we put Y
+	SWAP_C_Y //Restore C and Y to correct places
+	#undef SWAP_C_Y
+	HY *= 1./e.gInfo.detR;
+	return HY;
+}
+
+//Project the first nX (orthonormal) columns of X out of Y:
+static void deflate(const ColumnBundle& X, int nX, ColumnBundle& Y)
+{	if(!nX) return;
+	ColumnBundleView Xv(X, 0, nX);
+	for(int pass=0; pass<2; pass++) //twice for numerical stability
+		Y -= Xv * (Xv ^ Y);
+}
+
+//Normalize columns of Y (and apply the same scaling to HY, if non-null):
+static void normalizeCols(ColumnBundle& Y, ColumnBundle* HY=0)
+{	diagMatrix invNorm = diagDot(Y, Y);
+	for(double& x: invNorm) x = 1./sqrt(std::max(x, 1e-30));
+	Y *= invNorm;
+	if(HY) *HY *= invNorm;
+}
+
+//Solve and write wavefunctions using block LOBPCG:
+void BGW::iterativeWriteWfn(hid_t gidWfns)
+{	static StopWatch watchSolve("bgwIterativeSolve");
+	logPrintf("\n");
+	nBands = bgwp.nBandsDense;
+	for(const auto& sp: e.iInfo.species)
+		if(sp->isUltrasoft())
+			 die("\nIterative solve for extra bands not supported for ultrasoft pseudopotentials.\n");
+	Everything& eMod = (Everything&)e; //Hamiltonian application swaps trial vectors into eVars.C temporarily
+	if(e.exCorr.exxFactor()) e.exx->prepareHamiltonian(e.exCorr.exxRange(), eVars.F, eVars.C);
+	const int nBandsDFT = eInfo.nBands;
+	const int nBlock = bgwp.iterBlockSize;
+	const int nGuard = std::max(4, nBlock/8); //extra bands in each block that improve convergence of its highest bands
+	
+	std::vector<ColumnBundle> Cdense(eInfo.nStates);
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+	{	const ColumnBundle& C = eVars.C[q];
+		logPrintf("\tSolving state ");
+		eInfo.kpointPrint(globalLog, q, true);
+		logPrintf(" with dimension %lu\n", C.colLength()); logFlush();
+		if(size_t(nBands + nGuard) > C.colLength())
+			die("\tnBandsDense = %d (plus %d guard bands) exceeds basis dimension %lu.\n", nBands, nGuard, C.colLength());
+		watchSolve.start();
+		ColumnBundle& X = Cdense[q];
+		X = C.similar(nBands); //converged bands (orthonormal)
+		diagMatrix eigs(nBands);
+		ColumnBundle Yguard; //guard bands of previous block, used as initial guess for the next one
+		for(int bStart=0; bStart<nBands; bStart+=nBlock)
+		{	int bStop = std::min(bStart+nBlock, nBands);
+			int nLock = bStop - bStart; //bands converged and retained from this block
+			int nY = nLock + nGuard;
+			//Residual thresholds: iterTol for DFT bands, geometrically increasing to iterTolHigh for the highest band
+			std::vector<double> tol(nLock);
+			for(int j=0; j<nLock; j++)
+			{	int b = bStart + j;
+				double t = (b < nBandsDFT || nBands == nBandsDFT) ? 0. : double(b - nBandsDFT) / (nBands - nBandsDFT);
+				tol[j] = bgwp.iterTol * pow(bgwp.iterTolHigh / bgwp.iterTol, t);
+			}
+			//Initial guess: DFT bands, then guard bands from the previous block, then random:
+			ColumnBundle Y = C.similar(nY);
+			Y.randomize(0, nY, bStart); //distinct stream for each block
+			if(Yguard) Y.setSub(0, Yguard.getSub(0, std::min(Yguard.nCols(), nY)));
+			if(bStart < C.nCols()) Y.setSub(0, C.getSub(bStart, std::min(bStart+nY, C.nCols())));
+			Yguard.free();
+			deflate(X, bStart, Y);
+			Y = Y * invsqrt(Y ^ Y);
+			//Initial Rayleigh-Ritz:
+			ColumnBundle HY = applyH(eMod, q, Y);
+			diagMatrix eigsY;
+			{	matrix Hs = dagger_symmetrize(Y ^ HY), Hs_evecs;
+				Hs.diagonalize(Hs_evecs, eigsY);
+				Y = Y * Hs_evecs;
+				HY = HY * Hs_evecs;
+			}
+			ColumnBundle P, HP; //previous search directions
+			int iter=0; double residualRatio = 0.; //worst ratio of residual to threshold amongst the retained bands
+			for(iter=0; iter<bgwp.iterMax; iter++)
+			{	//Residuals and convergence check:
+				ColumnBundle W = HY; W -= Y * eigsY;
+				diagMatrix Rsq = diagDot(W, W);
+				residualRatio = 0.;
+				for(int j=0; j<nLock; j++)
+					residualRatio = std::max(residualRatio, sqrt(Rsq[j]) / tol[j]);
+				if(residualRatio < 1.) break;
+				//Preconditioned expansion directions, orthogonal to converged and current bands:
+				precond_inv_kinetic_band(W, (-0.5) * diagDot(Y, L(Y)));
+				deflate(X, bStart, W);
+				W -= Y * (Y ^ W);
+				normalizeCols(W);
+				ColumnBundle HW = applyH(eMod, q, W);
+				if(P)
+				{	matrix YdagP = Y ^ P; //orthogonal to X already (combination of previous W)
+					P -= Y * YdagP;
+					HP -= HY * YdagP;
+					normalizeCols(P, &HP);
+				}
+				int nW = W.nCols(), nP = P.nCols();
+				int nS = nY + nW + nP; //dimension of Rayleigh-Ritz basis [Y, W, P]
+				matrix Os = zeroes(nS, nS), Hs = zeroes(nS, nS);
+				Os.set(0,nY, 0,nY, eye(nY));
+				Os.set(nY,nY+nW, nY,nY+nW, W ^ W);
+				matrix YdagHW = Y ^ HW;
+				Hs.set(0,nY, 0,nY, eigsY);
+				Hs.set(0,nY, nY,nY+nW, YdagHW);
+				Hs.set(nY,nY+nW, 0,nY, dagger(YdagHW));
+				Hs.set(nY,nY+nW, nY,nY+nW, W ^ HW);
+				if(nP)
+				{	matrix WdagP = W ^ P, YdagHP = Y ^ HP, WdagHP = W ^ HP;
+					Os.set(nY,nY+nW, nY+nW,nS, WdagP);
+					Os.set(nY+nW,nS, nY,nY+nW, dagger(WdagP));
+					Os.set(nY+nW,nS, nY+nW,nS, P ^ P);
+					Hs.set(0,nY, nY+nW,nS, YdagHP);
+					Hs.set(nY+nW,nS, 0,nY, dagger(YdagHP));
+					Hs.set(nY,nY+nW, nY+nW,nS, WdagHP);
+					Hs.set(nY+nW,nS, nY,nY+nW, dagger(WdagHP));
+					Hs.set(nY+nW,nS, nY+nW,nS, P ^ HP);
+					//Restart without P if it has become nearly linearly dependent on [Y,W]:
+					matrix Os_evecs; diagMatrix Os_eigs;
+					Os.diagonalize(Os_evecs, Os_eigs);
+					if(Os_eigs.front() < 1e-10*Os_eigs.back())
+					{	nS -= nP; nP = 0;
+						Os = Os(0,nS, 0,nS);
+						Hs = Hs(0,nS, 0,nS);
+						P.free(); HP.free();
+					}
+				}
+				//Rayleigh-Ritz:
+				matrix U = invsqrt(Os);
+				Hs = dagger_symmetrize(dagger(U) * Hs * U);
+				matrix Hs_evecs; diagMatrix Hs_eigs;
+				Hs.diagonalize(Hs_evecs, Hs_eigs);
+				matrix rot = U * Hs_evecs(0,nS, 0,nY); //rotation from [Y,W,P] to the lowest nY Ritz vectors
+				matrix rotY = rot(0,nY, 0,nY), rotW = rot(nY,nY+nW, 0,nY);
+				ColumnBundle Pnew = W * rotW, HPnew = HW * rotW;
+				if(nP)
+				{	matrix rotP = rot(nY+nW,nS, 0,nY);
+					Pnew += P * rotP;
+					HPnew += HP * rotP;
+				}
+				Y = Y * rotY; Y += Pnew;
+				HY = HY * rotY; HY += HPnew;
+				std::swap(P, Pnew);
+				std::swap(HP, HPnew);
+				eigsY = Hs_eigs; eigsY.resize(nY);
+			}
+			logPrintf("\t\tBands %4d to %4d: %s after %3d iterations (residual/threshold: %.2lf)  t[s]: %9.2lf\n",
+				bStart+1, bStop, residualRatio<1. ? "converged" : "not converged", iter, residualRatio, clock_sec());
+			logFlush();
+			//Retain lowest nLock bands, and carry guard bands on to next block:
+			X.setSub(bStart, Y.getSub(0, nLock));
+			std::copy(eigsY.begin(), eigsY.begin()+nLock, eigs.begin()+bStart);
+			Yguard = Y.getSub(nLock, nY);
+		}
+		X *= 1./sqrt(gInfo.detR); //O-normalize
+		watchSolve.stop();
+		E[q] = eigs;
+		F[q].resize(nBands, 0.); //update to nBandsDense (padded with zeroes)
+		VxcSub[q] = getVxcSub(q, X);
+	}
+	writeCoeffs(gidWfns, Cdense);
+	
+	//Update fillings if necessary:
+	if(eInfo.fillingsUpdate == ElecInfo::FillingsHsub)
+	{	double Bz, mu = eInfo.findMu(E, eInfo.nElectrons, Bz);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			F[q] = eInfo.smear(eInfo.muEff(mu,Bz,q), E[q]);
+		logPrintf("\t"); eInfo.smearReport();
+	}
+	logPrintf("\t");
+}
+
+#endif //HDF5_ENABLED
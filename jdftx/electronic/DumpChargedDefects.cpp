@@ -282,35 +282,10 @@ struct CylindricalPoisson
 };
 
 
-void ChargedDefect::dump(const Everything& e, ScalarField d_tot) const
-{	logPrintf("Calculating charged defect correction:\n"); logFlush();
-	if(!center.size())
-		die("\tNo model charges specified (using command charged-defect).\n");
-	
-	//Construct model charge on plane-wave grid:
-	ScalarFieldTilde rhoModel;
-	double qTot = 0.;
-	for(const Center& cdc: center)
-	{	ScalarFieldTilde trans(ScalarFieldTildeData::alloc(e.gInfo));
-		initTranslation(trans, e.gInfo.R * cdc.pos);
-		rhoModel += gaussConvolve((cdc.q/e.gInfo.detR)*trans, cdc.sigma);
-		qTot += cdc.q;
-	}
-	
-	//Find center of defects for alignment calculations:
-	logSuspend(); WignerSeitz ws(e.gInfo.R); logResume();
-	vector3<> pos0 = geometry==CoulombParams::Periodic ? center[0].pos : e.coulomb->xCenter;
-	vector3<> posMean = pos0;
-	for(const Center& cdc: center)
-		posMean += (1./center.size()) * ws.restrict(cdc.pos - pos0);
-	
-	//Read reference Dtot and calculate electrostatic potential difference within DFT:
-	ScalarField d_totRef(ScalarFieldData::alloc(e.gInfo));
-	loadRawBinary(d_totRef, dtotFname.c_str());
-	ScalarField Vdft = d_tot - d_totRef; //electrostatic potential of defect from DFT
-	
-	//Calculate isolated and periodic self-energy (and potential) of model charge
-	ScalarField Vmodel; double Emodel=0., EmodelIsolated=0.;
+//Model potential and periodic / isolated self-energies of rhoModel (the expensive part of the correction)
+void ChargedDefect::solveModel(const Everything& e, ScalarFieldTilde rhoModel, const WignerSeitz& ws,
+	ScalarField& Vmodel, double& Emodel, double& EmodelIsolated) const
+{	Emodel = 0.; EmodelIsolated = 0.;
 	switch(geometry)
 	{	case CoulombParams::Periodic: //Bulk defect
 		{	//Periodic potential and energy:
@@ -440,6 +415,151 @@ void ChargedDefect::dump(const Everything& e, ScalarField d_tot) const
 		}
 		default: die("\tCoulomb-interaction geometry must be either slab or periodic for charged-defect correction.\n");
 	}
+}
+
+//Key identifying the model solution per unit net charge: host lattice, grid, dielectric model and model-charge shapes.
+//(The model problem is linear, so all charge states of a defect with the same model-charge shape share it.)
+std::vector<double> ChargedDefect::cacheKey(const Everything& e, double qTot) const
+{	std::vector<double> key;
+	for(int i=0; i<3; i++)
+	{	for(int j=0; j<3; j++) key.push_back(e.gInfo.R(i,j));
+		key.push_back(e.gInfo.S[i]);
+		key.push_back(e.coulombParams.embedCenter[i]);
+		key.push_back(e.coulomb->xCenter[i]);
+	}
+	key.push_back(geometry);
+	key.push_back(e.coulombParams.geometry);
+	key.push_back(e.coulombParams.embed);
+	key.push_back(e.coulombParams.embedFluidMode);
+	key.push_back(iDir);
+	if(geometry == CoulombParams::Slab)
+	{	//FNV-1a hash of dielectric profile file contents:
+		uint64_t hash = 14695981039346656037ULL;
+		FILE* fp = fopen(slabEpsFname.c_str(), "rb");
+		if(fp)
+		{	int c;
+			while((c = fgetc(fp)) != EOF)
+			{	hash ^= (unsigned char)c;
+				hash *= 1099511628211ULL;
+			}
+			fclose(fp);
+		}
+		key.push_back(double(hash >> 32));
+		key.push_back(double(hash & 0xFFFFFFFFULL));
+	}
+	else key.push_back(bulkEps);
+	for(const Center& cdc: center)
+	{	for(int k=0; k<3; k++) key.push_back(cdc.pos[k]);
+		key.push_back(cdc.sigma);
+		key.push_back(cdc.q / qTot); //relative charges only
+	}
+	return key;
+}
+
+string ChargedDefect::cacheFilename(const Everything& e, double qTot) const
+{	std::vector<double> key = cacheKey(e, qTot);
+	//FNV-1a hash of key (stable across runs and platforms, unlike std::hash):
+	uint64_t hash = 14695981039346656037ULL;
+	const unsigned char* bytes = (const unsigned char*)key.data();
+	for(size_t i=0; i<key.size()*sizeof(double); i++)
+	{	hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	char buf[32]; snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+	return cacheDir + "/chargedDefectModel-" + buf + ".bin";
+}
+
+//Cache file layout: key length, key, unit-charge isolated and periodic energies, unit-charge potential on the full grid
+bool ChargedDefect::readCache(const Everything& e, string fname, double qTot, ScalarField& Vmodel, double& Emodel, double& EmodelIsolated) const
+{	std::vector<double> key = cacheKey(e, qTot);
+	size_t nKey = key.size();
+	off_t fsizeExpected = sizeof(double) * (1 + nKey + 2 + e.gInfo.nr);
+	if(fileSize(fname.c_str()) != fsizeExpected) return false; //missing or incomplete
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp) return false;
+	std::vector<double> header(1 + nKey + 2);
+	nullToZero(Vmodel, e.gInfo);
+	bool ok = (freadLE(header.data(), sizeof(double), header.size(), fp) == header.size())
+		&& (header[0] == nKey)
+		&& std::equal(key.begin(), key.end(), header.begin()+1) //guard against hash collisions
+		&& (freadLE(Vmodel->data(), sizeof(double), e.gInfo.nr, fp) == size_t(e.gInfo.nr));
+	fclose(fp);
+	if(!ok)
+	{	Vmodel = 0;
+		return false;
+	}
+	EmodelIsolated = header[1+nKey] * qTot*qTot;
+	Emodel = header[2+nKey] * qTot*qTot;
+	Vmodel *= qTot;
+	logPrintf("\tReused model solution (scaled to net charge %lg) from '%s'.\n", qTot, fname.c_str());
+	return true;
+}
+
+void ChargedDefect::writeCache(const Everything& e, string fname, double qTot, const ScalarField& Vmodel, double Emodel, double EmodelIsolated) const
+{	if(!mpiWorld->isHead()) return;
+	std::vector<double> key = cacheKey(e, qTot);
+	std::vector<double> header; header.push_back(key.size());
+	header.insert(header.end(), key.begin(), key.end());
+	header.push_back(EmodelIsolated / (qTot*qTot));
+	header.push_back(Emodel / (qTot*qTot));
+	ScalarField Vunit = (1./qTot) * Vmodel;
+	string fnameTmp = fname + ".tmp"; //write to a temporary file and rename, so that partial files are never read
+	FILE* fp = fopen(fnameTmp.c_str(), "wb");
+	if(!fp)
+	{	logPrintf("\tWARNING: could not open '%s' to cache model solution.\n", fnameTmp.c_str());
+		return;
+	}
+	bool ok = (fwriteLE(header.data(), sizeof(double), header.size(), fp) == header.size())
+		&& (fwriteLE(Vunit->data(), sizeof(double), e.gInfo.nr, fp) == size_t(e.gInfo.nr));
+	ok = (fclose(fp)==0) && ok;
+	if(ok && rename(fnameTmp.c_str(), fname.c_str())==0)
+		logPrintf("\tSaved model solution to '%s' for reuse by other defects on this host.\n", fname.c_str());
+	else
+	{	logPrintf("\tWARNING: could not write model solution cache '%s'.\n", fname.c_str());
+		remove(fnameTmp.c_str());
+	}
+}
+
+void ChargedDefect::dump(const Everything& e, ScalarField d_tot) const
+{	logPrintf("Calculating charged defect correction:\n"); logFlush();
+	if(!center.size())
+		die("\tNo model charges specified (using command charged-defect).\n");
+	
+	//Construct model charge on plane-wave grid:
+	ScalarFieldTilde rhoModel;
+	double qTot = 0.;
+	for(const Center& cdc: center)
+	{	ScalarFieldTilde trans(ScalarFieldTildeData::alloc(e.gInfo));
+		initTranslation(trans, e.gInfo.R * cdc.pos);
+		rhoModel += gaussConvolve((cdc.q/e.gInfo.detR)*trans, cdc.sigma);
+		qTot += cdc.q;
+	}
+	
+	//Find center of defects for alignment calculations:
+	logSuspend(); WignerSeitz ws(e.gInfo.R); logResume();
+	vector3<> pos0 = geometry==CoulombParams::Periodic ? center[0].pos : e.coulomb->xCenter;
+	vector3<> posMean = pos0;
+	for(const Center& cdc: center)
+		posMean += (1./center.size()) * ws.restrict(cdc.pos - pos0);
+	
+	//Read reference Dtot and calculate electrostatic potential difference within DFT:
+	ScalarField d_totRef(ScalarFieldData::alloc(e.gInfo));
+	loadRawBinary(d_totRef, dtotFname.c_str());
+	ScalarField Vdft = d_tot - d_totRef; //electrostatic potential of defect from DFT
+	
+	//Calculate isolated and periodic self-energy (and potential) of model charge,
+	//reusing the solution for a previous defect on the same host (scaled by net charge) if available:
+	ScalarField Vmodel; double Emodel=0., EmodelIsolated=0.;
+	bool useCache = cacheDir.length() && qTot;
+	if(useCache && geometry==CoulombParams::Slab && e.eVars.fluidSolver)
+	{	logPrintf("\tNot caching model solution, since the fluid cavity depends on the defect calculation.\n");
+		useCache = false;
+	}
+	string cacheFname = useCache ? cacheFilename(e, qTot) : string();
+	if(!(useCache && readCache(e, cacheFname, qTot, Vmodel, Emodel, EmodelIsolated)))
+	{	solveModel(e, rhoModel, ws, Vmodel, Emodel, EmodelIsolated);
+		if(useCache) writeCache(e, cacheFname, qTot, Vmodel, Emodel, EmodelIsolated);
+	}
 	logPrintf("\tEmodelIsolated: %.8lf\n", EmodelIsolated);
 	logPrintf("\tEmodelPeriodic: %.8lf\n", Emodel);
 	
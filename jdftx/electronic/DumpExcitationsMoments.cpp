@@ -82,7 +82,11 @@ void dumpExcitations(const Everything& e, const char* filename)
 		}
 	}
 	
-	//Find and cache all excitations in system (between same qnums)
+	//Find and cache all excitations in system (between same qnums), optionally restricted to the band window.
+	//Unoccupied orbitals are transformed to real space in blocks, and each occupied orbital (times r)
+	//once per block, instead of transforming both orbitals for every pair and direction:
+	const int uBlockSize = 32;
+	const Dump& dump = e.dump;
 	bool insufficientBands = false;
 	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
 	{	//Find local HOMO and check band sufficiency:
@@ -93,21 +97,49 @@ void dumpExcitations(const Everything& e, const char* filename)
 		if(eigs[q][HOMO]   > maxHOMO) { maxHOMOq = q; maxHOMOn = HOMO;   maxHOMO = eigs[q][HOMO];   }
 		if(eigs[q][HOMO+1] < minLUMO) { minLUMOq = q; minLUMOn = HOMO+1; minLUMO = eigs[q][HOMO+1]; }
 		
-		for(int o=HOMO; o>=0; o--)
-		{	for(int u=(HOMO+1); u<e.eInfo.nBands; u++)
-			{	vector3<> dreal, dimag, dnorm;
+		//Band ranges of occupied [oStart,HOMO] and unoccupied [HOMO+1,uStop) orbitals:
+		int oStart = 0, uStop = e.eInfo.nBands;
+		if(dump.bandWindowSet())
+		{	while(oStart<=HOMO && eigs[q][oStart] < dump.bandWindowMin) oStart++;
+			while(uStop>HOMO+1 && eigs[q][uStop-1] > dump.bandWindowMax) uStop--;
+		}
+		const ColumnBundle& Cq = e.eVars.C[q];
+		const diagMatrix& Fq = e.eVars.F[q];
+		for(int uStart=HOMO+1; uStart<uStop; uStart+=uBlockSize)
+		{	int uBlockStop = std::min(uStart+uBlockSize, uStop);
+			//Screen pairs before any transforms:
+			std::vector<std::vector<bool>> needPair(HOMO+1-oStart, std::vector<bool>(uBlockStop-uStart));
+			std::vector<bool> needO(HOMO+1-oStart, false), needU(uBlockStop-uStart, false);
+			for(int o=oStart; o<=HOMO; o++)
+				for(int u=uStart; u<uBlockStop; u++)
+					if(dump.pairScreening(Fq[o], Fq[u], eigs[q][o], eigs[q][u]))
+						needPair[o-oStart][u-uStart] = needO[o-oStart] = needU[u-uStart] = true;
+			std::vector<complexScalarField> Iu(uBlockStop-uStart);
+			for(int u=uStart; u<uBlockStop; u++)
+				if(needU[u-uStart]) Iu[u-uStart] = I(Cq.getColumn(u,0));
+			for(int o=HOMO; o>=oStart; o--)
+			{	if(!needO[o-oStart]) continue;
+				complexScalarField Io = I(Cq.getColumn(o,0));
+				std::vector<complexScalarField> rIo(3);
 				for(int iDir=0; iDir<3; iDir++)
-				{	complex xi = integral(I(e.eVars.C[q].getColumn(u,0)) * r[iDir] * I(e.eVars.C[q].getColumn(o,0)));
-					dreal[iDir] = xi.real();
-					dimag[iDir] = xi.imag();
-					dnorm[iDir] = xi.abs();
+					rIo[iDir] = r[iDir] * Io;
+				for(int u=uStart; u<uBlockStop; u++)
+				{	if(!needPair[o-oStart][u-uStart]) continue;
+					vector3<> dreal, dimag, dnorm;
+					for(int iDir=0; iDir<3; iDir++)
+					{	complex xi = integral(Iu[u-uStart] * rIo[iDir]);
+						dreal[iDir] = xi.real();
+						dimag[iDir] = xi.imag();
+						dnorm[iDir] = xi.abs();
+					}
+					double dE = eigs[q][u]-eigs[q][o]; //Excitation energy
+					excitations.push_back(excitation(q, o, u, dE, dreal.length_squared(), dimag.length_squared(), dnorm.length_squared()));
 				}
-				double dE = eigs[q][u]-eigs[q][o]; //Excitation energy
-				excitations.push_back(excitation(q, o, u, dE, dreal.length_squared(), dimag.length_squared(), dnorm.length_squared()));
 			}
 		}
 	}
 	mpiWorld->allReduce(insufficientBands, MPIUtil::ReduceLOr);
+	dump.pairScreening.report("Excitations", mpiWorld);
 	if(insufficientBands)
 	{	logPrintf("Insufficient bands to calculate excited states!\n");
 		logPrintf("Increase the number of bands (elec-n-bands) and try again!\n");
@@ -162,6 +194,10 @@ void dumpExcitations(const Everything& e, const char* filename)
 
 	//Process and print excitations:
 	if(!mpiWorld->isHead()) return;
+	if(!excitations.size())
+	{	logPrintf("No excitations within the band window.\n");
+		return;
+	}
 	
 	FILE* fp = fopen(filename, "w");
 	if(!fp) die_alone("Error opening %s for writing.\n", filename);
@@ -610,27 +646,35 @@ void Dump::dumpUnfold()
 	fname = getFilename("bandUnfold");
 	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
 	std::vector<diagMatrix> unitWeights(eInfo.nStates);
+	int nSpinor = eInfo.spinorLength();
+	const int blockSize = 64; //number of bands gathered together
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-	{	unitWeights[q].reserve(nUnits * eInfo.nBands);
-		for(const vector3<>& k: kUnit[q])
-		{	//Create basis and qnum for unit cell k:
-			Basis basisUnit;
-			logSuspend();
-			basisUnit.setup(gInfoUnit, e->iInfo, e->cntrl.Ecut, k);
-			logResume();
-			QuantumNumber qnumUnit; qnumUnit.k = k;
-			//Setup wave function transformation:
-			int nSpinor = eInfo.spinorLength();
-			ColumnBundleTransform cbt(k, basisUnit, eInfo.qnums[q].k, e->basis[q], nSpinor, SpaceGroupOp(), +1, M);
-			//Extract unit cell wavefunctions:
-			const ColumnBundle& C = e->eVars.C[q];
-			ColumnBundle OC = O(C);
-			ColumnBundle Cunit(1, basisUnit.nbasis*nSpinor, &basisUnit, &qnumUnit, isGpuEnabled());
-			ColumnBundle OCunit = Cunit.similar();
-			for(int b=0; b<eInfo.nBands; b++)
-			{	Cunit.zero(); cbt.gatherAxpy(1., C,b, Cunit,0);
-				OCunit.zero(); cbt.gatherAxpy(1., OC,b, OCunit,0);
-				unitWeights[q].push_back(trace(Cunit^OCunit).real());
+	{	unitWeights[q].resize(nUnits * eInfo.nBands);
+		//G-vector mapping tables from this supercell k to each unit cell k, shared by all bands:
+		int nUnits_q = kUnit[q].size();
+		std::vector<Basis> basisUnit(nUnits_q);
+		std::vector<QuantumNumber> qnumUnit(nUnits_q);
+		std::vector<std::shared_ptr<ColumnBundleTransform>> cbt(nUnits_q);
+		logSuspend();
+		for(int iUnit=0; iUnit<nUnits_q; iUnit++)
+		{	const vector3<>& k = kUnit[q][iUnit];
+			basisUnit[iUnit].setup(gInfoUnit, e->iInfo, e->cntrl.Ecut, k);
+			qnumUnit[iUnit].k = k;
+			cbt[iUnit] = std::make_shared<ColumnBundleTransform>(k, basisUnit[iUnit], eInfo.qnums[q].k, e->basis[q], nSpinor, SpaceGroupOp(), +1, M);
+		}
+		logResume();
+		//Weights of each unit cell k, one gather and one norm reduction per block of bands:
+		const ColumnBundle& C = e->eVars.C[q];
+		ColumnBundle OC = O(C);
+		for(int bStart=0; bStart<eInfo.nBands; bStart+=blockSize)
+		{	int bStop = std::min(bStart+blockSize, eInfo.nBands);
+			for(int iUnit=0; iUnit<nUnits_q; iUnit++)
+			{	ColumnBundle Cunit(bStop-bStart, basisUnit[iUnit].nbasis*nSpinor, &basisUnit[iUnit], &qnumUnit[iUnit], isGpuEnabled());
+				ColumnBundle OCunit = Cunit.similar();
+				Cunit.zero(); cbt[iUnit]->gatherAxpy(1., C, bStart, 1, Cunit);
+				OCunit.zero(); cbt[iUnit]->gatherAxpy(1., OC, bStart, 1, OCunit);
+				diagMatrix w = diagDot(Cunit, OCunit);
+				std::copy(w.begin(), w.end(), unitWeights[q].begin() + iUnit*eInfo.nBands + bStart);
 			}
 		}
 	}
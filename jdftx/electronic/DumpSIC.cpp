@@ -38,13 +38,16 @@ double DumpSelfInteractionCorrection::operator()(std::vector<diagMatrix>* correc
 				DC[iDir] = D(e.eVars.C[q], iDir);
 		if(e.eInfo.isMine(q) && correctedEigenvalues)
 			(*correctedEigenvalues)[q].resize(e.eInfo.nBands);
-		for(int n=0; n<e.eInfo.nBands; n++)
-		{	double selfInteractionError = calcSelfInteractionError(q,n);
+		for(int bStart=0; bStart<e.eInfo.nBands; bStart+=blockSize)
+		{	int bStop = std::min(bStart+blockSize, e.eInfo.nBands);
+			std::vector<double> selfInteractionErrors = calcSelfInteractionErrors(q, bStart, bStop);
 			if(e.eInfo.isMine(q))
-			{	if(correctedEigenvalues)
-					(*correctedEigenvalues)[q][n] = e.eVars.Hsub_eigs[q][n] - selfInteractionError;
-				selfInteractionEnergy += e.eVars.F[q][n]*e.eInfo.qnums[q].weight*selfInteractionError;
-			}
+				for(int n=bStart; n<bStop; n++)
+				{	double selfInteractionError = selfInteractionErrors[n-bStart];
+					if(correctedEigenvalues)
+						(*correctedEigenvalues)[q][n] = e.eVars.Hsub_eigs[q][n] - selfInteractionError;
+					selfInteractionEnergy += e.eVars.F[q][n]*e.eInfo.qnums[q].weight*selfInteractionError;
+				}
 		}
 	}
 	DC.clear();
@@ -53,40 +56,81 @@ double DumpSelfInteractionCorrection::operator()(std::vector<diagMatrix>* correc
 	
 }
 
-double DumpSelfInteractionCorrection::calcSelfInteractionError(int q, int n)
+std::vector<double> DumpSelfInteractionCorrection::calcSelfInteractionErrors(int q, int bStart, int bStop)
 {
-	// Get the real-space orbital density
-	ScalarFieldArray orbitalDensity; nullToZero(orbitalDensity, e.gInfo, 2);
+	int nOrbitals = bStop - bStart;
+	bool needsKE = e.exCorr.needsKEdensity();
+	
+	// Get the real-space orbital densities (and KE densities if needed) of the block on the owner of q
+	ScalarFieldArray orbitalDensities(nOrbitals), KEdensities(needsKE ? nOrbitals : 0);
 	if(e.eInfo.isMine(q))
 	{	QuantumNumber qnum; qnum.weight = 1.;
 		diagMatrix Fqn = eye(1);
-		ColumnBundle Cqn = e.eVars.C[q].getSub(n,n+1);
-		std::vector<matrix> VdagCqn;
-		for(const matrix& m: e.eVars.VdagC[q])
-			VdagCqn.push_back(m ? matrix(m(0, m.nRows(), n, n+1)) : m);
-		orbitalDensity[0] = diagouterI(Fqn, Cqn, 1, &e.gInfo)[0];
-		e.iInfo.augmentDensityInit();
-		e.iInfo.augmentDensitySpherical(qnum, Fqn, VdagCqn); //pseudopotential contribution
-		e.iInfo.augmentDensityGrid(orbitalDensity);
+		for(int n=bStart; n<bStop; n++)
+		{	ColumnBundle Cqn = e.eVars.C[q].getSub(n,n+1);
+			std::vector<matrix> VdagCqn;
+			for(const matrix& m: e.eVars.VdagC[q])
+				VdagCqn.push_back(m ? matrix(m(0, m.nRows(), n, n+1)) : m);
+			ScalarFieldArray orbitalDensity(1);
+			orbitalDensity[0] = diagouterI(Fqn, Cqn, 1, &e.gInfo)[0];
+			e.iInfo.augmentDensityInit();
+			e.iInfo.augmentDensitySpherical(qnum, Fqn, VdagCqn); //pseudopotential contribution
+			e.iInfo.augmentDensityGrid(orbitalDensity);
+			orbitalDensities[n-bStart] = orbitalDensity[0];
+			if(needsKE)
+			{	ScalarField& KEdensity = KEdensities[n-bStart];
+				for(int iDir=0; iDir<3; iDir++)
+					KEdensity += 0.5 * diagouterI(Fqn, DC[iDir].getSub(n,n+1), 1, &e.gInfo)[0];
+			}
+		}
 	}
-	orbitalDensity[0]->bcastData(mpiWorld, e.eInfo.whose(q));
-	ScalarFieldTilde orbitalDensityTilde = J(orbitalDensity[0]);
 	
-	// Calculate the Coulomb energy
-	ScalarFieldTilde VorbitalTilde = (*e.coulomb)(orbitalDensityTilde);
-	double coulombEnergy = 0.5*dot(orbitalDensityTilde, O(VorbitalTilde));
+	// Broadcast the block in a single message
+	int nFields = nOrbitals * (needsKE ? 2 : 1);
+	size_t nr = e.gInfo.nr;
+	ManagedArray<double> buf; buf.init(nFields*nr);
+	if(e.eInfo.isMine(q))
+	{	for(int j=0; j<nOrbitals; j++)
+		{	eblas_copy(buf.data()+j*nr, orbitalDensities[j]->data(), nr);
+			if(needsKE) eblas_copy(buf.data()+(nOrbitals+j)*nr, KEdensities[j]->data(), nr);
+		}
+	}
+	mpiWorld->bcastData(buf, e.eInfo.whose(q));
+	if(!e.eInfo.isMine(q))
+	{	nullToZero(orbitalDensities, e.gInfo);
+		if(needsKE) nullToZero(KEdensities, e.gInfo);
+		for(int j=0; j<nOrbitals; j++)
+		{	eblas_copy(orbitalDensities[j]->data(), buf.data()+j*nr, nr);
+			if(needsKE) eblas_copy(KEdensities[j]->data(), buf.data()+(nOrbitals+j)*nr, nr);
+		}
+	}
+	buf.free();
 	
-	// Calculate the orbital KE if needed
-	ScalarFieldArray KEdensity(2);
-	if(e.exCorr.needsKEdensity())
-	{	nullToZero(KEdensity, e.gInfo);
-		if(e.eInfo.isMine(q))
-			for(int iDir=0; iDir<3; iDir++)
-				KEdensity[0] += 0.5 * diagouterI(eye(1), DC[iDir].getSub(n,n+1), 1, &e.gInfo)[0];
-		KEdensity[0]->bcastData(mpiWorld, e.eInfo.whose(q));
+	// Calculate the Coulomb energies, distributing orbitals over processes
+	std::vector<double> selfInteractionErrors(nOrbitals, 0.);
+	TaskDivision orbitalDivision(nOrbitals, mpiWorld);
+	int jStart, jStop; orbitalDivision.myRange(jStart, jStop);
+	ScalarFieldArray myDensities(orbitalDensities.begin()+jStart, orbitalDensities.begin()+jStop);
+	ScalarFieldTildeArray myDensitiesTilde = J(myDensities); //batched over orbitals
+	for(int j=jStart; j<jStop; j++)
+	{	const ScalarFieldTilde& orbitalDensityTilde = myDensitiesTilde[j-jStart];
+		ScalarFieldTilde VorbitalTilde = (*e.coulomb)(orbitalDensityTilde);
+		selfInteractionErrors[j] = 0.5*dot(orbitalDensityTilde, O(VorbitalTilde));
+	}
+	mpiWorld->allReduceData(selfInteractionErrors, MPIUtil::ReduceSum);
+	
+	// Calculate the XC energies (collective, since ExCorr is MPI parallelized over the grid)
+	for(int j=0; j<nOrbitals; j++)
+	{	ScalarFieldArray orbitalDensity(2), KEdensity(2);
+		orbitalDensity[0] = orbitalDensities[j];
+		nullToZero(orbitalDensity, e.gInfo);
+		if(needsKE)
+		{	KEdensity[0] = KEdensities[j];
+			nullToZero(KEdensity, e.gInfo);
+		}
+		selfInteractionErrors[j] += e.exCorr(orbitalDensity, 0, IncludeTXC(), &KEdensity, 0);
 	}
-	double xcEnergy = e.exCorr(orbitalDensity, 0, IncludeTXC(), &KEdensity, 0);
-	return coulombEnergy + xcEnergy;
+	return selfInteractionErrors;
 }
 
 void DumpSelfInteractionCorrection::dump(const char* filename)
@@ -0,0 +1,125 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/Dump_internal.h>
+#include <electronic/Everything.h>
+#include <electronic/IonicMinimizer.h>
+#include <unistd.h>
+
+//Append the little-endian representation of value to buf:
+template<typename T> void pushLE(std::vector<char>& buf, T value)
+{	convertToLE(&value, sizeof(T), 1);
+	const char* p = (const char*)&value;
+	buf.insert(buf.end(), p, p+sizeof(T));
+}
+
+TrajectoryWriter::TrajectoryWriter(const Everything& e, string fname) : fname(fname), e(e), fp(0), nFrames(0)
+{	const IonInfo& iInfo = e.iInfo;
+	int nAtoms = 0;
+	for(const auto& sp: iInfo.species) nAtoms += sp->atpos.size();
+	nFrameDoubles = 22 + 9*nAtoms; //iter, t, E, KE, R, stress; and positions, velocities, forces
+	//Header (fixed size, so that frame i is at offset headerBytes + i*frameBytes):
+	const int32_t version = 1;
+	const int64_t headerBytes = 32 + 20*iInfo.species.size();
+	header.assign(magic, magic+8);
+	pushLE(header, version);
+	pushLE(header, int32_t(iInfo.species.size()));
+	pushLE(header, int32_t(nAtoms));
+	pushLE(header, int32_t(nFrameDoubles));
+	pushLE(header, headerBytes);
+	for(const auto& sp: iInfo.species)
+	{	char name[16] = {0};
+		strncpy(name, sp->name.c_str(), 15);
+		header.insert(header.end(), name, name+16);
+		pushLE(header, int32_t(sp->atpos.size()));
+	}
+	assert(int64_t(header.size()) == headerBytes);
+	size_t frameBytes = nFrameDoubles * sizeof(double);
+	
+	//Continue an existing trajectory of the same system, or start a new one:
+	if(mpiWorld->isHead())
+	{	FILE* fpIn = fopen(fname.c_str(), "rb");
+		if(fpIn)
+		{	std::vector<char> headerIn(header.size());
+			bool match = (fread(headerIn.data(), 1, headerIn.size(), fpIn) == headerIn.size()) and (headerIn == header);
+			fseek(fpIn, 0, SEEK_END);
+			off_t fsize = ftell(fpIn);
+			fclose(fpIn);
+			if(match)
+			{	nFrames = (fsize - header.size()) / frameBytes;
+				//Discard any incomplete frame (interrupted write) and append:
+				if(truncate(fname.c_str(), header.size() + nFrames*frameBytes) != 0)
+					die_alone("Error truncating trajectory file '%s'.\n", fname.c_str());
+				fp = fopen(fname.c_str(), "ab");
+			}
+		}
+		if(!fp)
+		{	fp = fopen(fname.c_str(), "wb");
+			if(fp) fwrite(header.data(), 1, header.size(), fp);
+		}
+		if(!fp) die_alone("Error opening trajectory file '%s' for writing.\n", fname.c_str());
+	}
+	mpiWorld->bcast(nFrames);
+	if(nFrames) logPrintf("(appending to %lu existing frames) ", nFrames);
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{	if(fp) fclose(fp);
+}
+
+void TrajectoryWriter::append(int iter)
+{	const IonInfo& iInfo = e.iInfo;
+	const matrix3<>& R = e.gInfo.R;
+	std::vector<double> frame; frame.reserve(nFrameDoubles);
+	auto push3 = [&](const vector3<>& v) { for(int k=0; k<3; k++) frame.push_back(v[k]); };
+	//Scalars and cell:
+	double t = e.ionicDynParams.nSteps ? iter*e.ionicDynParams.dt : NAN;
+	double KE = 0.;
+	for(const auto& sp: iInfo.species)
+		for(const vector3<>& vel: sp->velocities)
+			KE += (0.5 * sp->mass*amu) * e.gInfo.RTR.metric_length_squared(vel); //NAN unless running MD
+	if(!iInfo.species.size() or !iInfo.species[0]->velocities.size()) KE = NAN;
+	frame.push_back(iter);
+	frame.push_back(t);
+	frame.push_back(relevantFreeEnergy(e));
+	frame.push_back(KE);
+	for(int i=0; i<3; i++) for(int j=0; j<3; j++) frame.push_back(R(i,j));
+	for(int i=0; i<3; i++) for(int j=0; j<3; j++) frame.push_back(iInfo.computeStress ? iInfo.stress(i,j) : NAN);
+	//Per-atom Cartesian positions, velocities and forces (each in species order):
+	for(const auto& sp: iInfo.species)
+		for(const vector3<>& pos: sp->atpos)
+			push3(R*pos);
+	for(const auto& sp: iInfo.species)
+		for(size_t at=0; at<sp->atpos.size(); at++)
+			push3(at<sp->velocities.size() ? R*sp->velocities[at] : vector3<>(NAN,NAN,NAN));
+	bool hasForces = (iInfo.forces.size() == iInfo.species.size());
+	for(size_t sp=0; sp<iInfo.species.size(); sp++)
+		for(size_t at=0; at<iInfo.species[sp]->atpos.size(); at++)
+			push3(hasForces ? e.gInfo.invRT * iInfo.forces[sp][at] : vector3<>(NAN,NAN,NAN));
+	assert(frame.size() == nFrameDoubles);
+	//Write (and flush, so that the trajectory is readable while the calculation runs):
+	if(mpiWorld->isHead())
+	{	if(fwriteLE(frame.data(), sizeof(double), frame.size(), fp) != frame.size())
+			die_alone("Error writing frame %lu to trajectory file '%s'.\n", nFrames, fname.c_str());
+		fflush(fp);
+	}
+	nFrames++;
+}
+
+const char TrajectoryWriter::magic[8] = { 'J','D','F','T','X','T','R','J' };
@@ -25,11 +25,67 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 class Everything;
 class ColumnBundle;
+class ElecInfo;
 
 //! @addtogroup Output
 //! @{
 //! @file Dump_internal.h Implementation internals for output modules
 
+//-------------------- Implemented in Dump.cpp ---------------------------
+
+//! Collective output of records per k-point / spin state, in order of state index (at offset q*recordSize for fixed-size records).
+//! Each process writes its records as soon as they are computed, so that neither the head
+//! nor any other process holds the complete output, and readers can seek directly to any state.
+class StateRecordWriter
+{
+public:
+	StateRecordWriter(const ElecInfo& eInfo, string fname, size_t recordSize); //!< collectively create file with records of recordSize bytes
+	StateRecordWriter(const ElecInfo& eInfo, string fname, const std::vector<size_t>& recordSizes); //!< collectively create file with records of specified size for each state
+	~StateRecordWriter(); //!< collectively close file (in MPISafeWrite mode, gathers and writes all records from head)
+	void write(int q, const void* data, size_t size, size_t nmemb); //!< write record for state q (must be local) consisting of nmemb elements of size bytes
+	template<typename T> void write(int q, const ManagedMemory<T>& M) { write(q, M.data(), sizeof(T), M.nData()); } //!< write data of M as record q
+private:
+	const ElecInfo& eInfo;
+	string fname;
+	std::vector<size_t> recordSizes; //!< size of record of each state in bytes
+	std::vector<size_t> offsets; //!< offset of record of each state in bytes
+	#if MPI_SAFE_WRITE
+	std::map<int,std::vector<char>> records; //!< buffered little-endian records of local states (written by head on close)
+	#else
+	MPIUtil::File fp;
+	#endif
+};
+
+//-------------------- Implemented in DumpTrajectory.cpp ---------------------------
+
+/** Append-only binary trajectory (dump variable Trajectory), with one fixed-size frame per dump.
+All data is little-endian. The header consists of the 8 characters JDFTXTRJ, int32 version (=1),
+int32 nSpecies, int32 nAtoms, int32 nFrameDoubles, int64 headerBytes, and for each species the name
+(char[16], null-padded) and int32 number of atoms. Each frame then consists of nFrameDoubles doubles:
+iteration, MD time (NAN unless running MD), relevant free energy, ionic kinetic energy (NAN unless running MD),
+lattice vectors R (3x3, row-major with lattice vectors in columns), stress (3x3 in Eh/a0^3 excluding kinetic
+contributions, NAN unless computed), followed by Cartesian positions, velocities and forces (nAtoms x 3 each,
+in species order) in atomic units. Frame i is therefore at offset headerBytes + i*nFrameDoubles*8, so that
+readers can seek to any frame directly (see script trajectoryToXYZ).
+An existing file with the same header (eg. from an interrupted run being continued) is appended to,
+after discarding any incomplete frame at its end.
+*/
+class TrajectoryWriter
+{
+public:
+	TrajectoryWriter(const Everything& e, string fname); //!< open fname to continue an existing trajectory of the same system, or create it
+	~TrajectoryWriter();
+	void append(int iter); //!< append a frame for the current state (call from all processes, head writes)
+	const string fname; //!< trajectory filename
+private:
+	const Everything& e;
+	FILE* fp; //!< open file (head only)
+	std::vector<char> header; //!< serialized header
+	size_t nFrameDoubles; //!< number of doubles per frame
+	size_t nFrames; //!< number of frames in file so far
+	static const char magic[8]; //!< file type identifier at start of header
+};
+
 //-------------------- Implemented in DumpSIC.cpp ---------------------------
 
 //! Output self-interaction correction for the KS eigenvalues
@@ -42,7 +98,11 @@ public:
 	bool needsTau;  //!< The kinetic energy density is needed for meta-gga functionals.
 private:
 	const Everything& e;
-	double calcSelfInteractionError(int q, int n); //!< Calculates the self-interaction error of the KS orbital atthe n'th band at q'th quantum number
+	//! Calculate the self-interaction errors of KS orbitals bStart to bStop-1 at the q'th quantum number (collective over all processes).
+	//! Orbital densities of the block are broadcast together, their Hartree terms are distributed over processes and
+	//! the XC terms are evaluated together since ExCorr is itself MPI-parallelized over the grid.
+	std::vector<double> calcSelfInteractionErrors(int q, int bStart, int bStop);
+	static const int blockSize = 32; //!< number of orbitals processed together
 	std::vector<ColumnBundle> DC; //!< ColumnBundle for the derivative of the wavefunctions in each cartesian direction
 };
 
@@ -103,7 +163,16 @@ struct ChargedDefect
 	double rMin; //!< Minimum distance from defect used for calculating alignment
 	double rSigma; //!< Turn-on width of region used for calculating alignment
 	
+	string cacheDir; //!< if non-empty, directory in which model solutions are saved for reuse by other defects on the same host
+	
 	void dump(const Everything& e, ScalarField d_tot) const;
+private:
+	void solveModel(const Everything& e, ScalarFieldTilde rhoModel, const class WignerSeitz& ws,
+		ScalarField& Vmodel, double& Emodel, double& EmodelIsolated) const; //!< model potential and periodic / isolated self-energies
+	std::vector<double> cacheKey(const Everything& e, double qTot) const; //!< parameters identifying the model solution per unit net charge
+	string cacheFilename(const Everything& e, double qTot) const; //!< filename in cacheDir identifying cacheKey
+	bool readCache(const Everything& e, string fname, double qTot, ScalarField& Vmodel, double& Emodel, double& EmodelIsolated) const; //!< read and scale cached model solution if available
+	void writeCache(const Everything& e, string fname, double qTot, const ScalarField& Vmodel, double Emodel, double EmodelIsolated) const; //!< save unit-charge model solution
 };
 
 //! @}
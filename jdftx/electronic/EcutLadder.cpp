@@ -0,0 +1,57 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/EcutLadder.h>
+#include <electronic/Everything.h>
+#include <electronic/ElecMinimizer.h>
+#include <electronic/Dump.h>
+#include <core/Units.h>
+
+void runEcutLadder(Everything& e)
+{	const std::vector<double> ladder = e.cntrl.EcutLadder;
+	double EcutFinal = e.cntrl.Ecut;
+	const char* Aname = relevantFreeEnergyName(e);
+	std::vector<double> A(ladder.size());
+	string basenameRef = inputBasename;
+	for(size_t iRung=0; iRung<ladder.size(); iRung++)
+	{	double Ecut = ladder[iRung];
+		logPrintf("\n---------- Cutoff ladder rung %d of %d: Ecut = %lg Eh ----------\n", int(iRung+1), int(ladder.size()), Ecut);
+		e.switchCutoff(Ecut);
+		logFlush();
+		
+		elecFluidMinimize(e);
+		A[iRung] = relevantFreeEnergy(e);
+		logPrintf("# Energy components:\n"); e.ener.print(); logPrintf("\n");
+		std::ostringstream oss; oss << ".Ecut" << Ecut;
+		inputBasename = basenameRef + oss.str().c_str();
+		e.dump(DumpFreq_End, 0);
+		inputBasename = basenameRef;
+	}
+	
+	//Summary:
+	logPrintf("\n# Cutoff ladder: %s at each rung and its change from the previous one:\n", Aname);
+	logPrintf("# %12s %20s %14s %14s\n", "Ecut [Eh]", (string(Aname)+" [Eh]").c_str(), "Delta [Eh]", "Delta [kcal/mol]");
+	for(size_t iRung=0; iRung<ladder.size(); iRung++)
+	{	double dA = iRung ? A[iRung] - A[iRung-1] : 0.;
+		logPrintf("  %12lg %+20.12lf %+14.8lf %+14.4lf\n", ladder[iRung], A[iRung], dA, dA/(Kcal/mol));
+	}
+	logPrintf("(Continuing at the final cutoff Ecut = %lg Eh.)\n", EcutFinal);
+	logFlush();
+	e.switchCutoff(EcutFinal);
+}
@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_ECUTLADDER_H
+#define JDFTX_ELECTRONIC_ECUTLADDER_H
+
+class Everything;
+
+//! @addtogroup ElectronicDFT
+//! @{
+//! @file EcutLadder.h Cutoff ladder (command elec-cutoff-ladder)
+
+/** Converge the electronic state at each of the increasing cutoffs in Control::EcutLadder,
+on the grids set up for the final cutoff, expanding the wavefunctions in memory between rungs.
+Each rung is dumped with $INPUT replaced by $INPUT.Ecut<Ecut>, and the state is left at the
+final cutoff (set up by Everything::setup), ready for the main calculation.
+*/
+void runEcutLadder(Everything& e);
+
+//! @}
+#endif // JDFTX_ELECTRONIC_ECUTLADDER_H
@@ -20,6 +20,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/ElecInfo.h>
 #include <electronic/Everything.h>
 #include <electronic/SpeciesInfo.h>
+#include <electronic/Checkpoint.h>
 #include <core/matrix.h>
 #include <fluid/Euler.h>
 #include <algorithm>
@@ -34,10 +35,10 @@ int ElecInfo::findHOMO(int q) const
 }
 
 ElecInfo::ElecInfo()
-: nBands(0), nStates(0), qStart(0), qStop(0), spinType(SpinNone), nElectrons(0), 
+: nBands(0), nStates(0), qStart(0), qStop(0), qBand(0), spinType(SpinNone), nElectrons(0), 
 fillingsUpdate(FillingsConst), scalarFillings(true),
 smearingType(SmearingFermi), smearingWidth(1e-3),
-mu(NAN), Bz(NAN), muLoop(false),
+mu(NAN), Bz(NAN), muLoop(false), scanCharge(false),
 hasU(false), nBandsOld(0),
 Qinitial(0.), Minitial(0.)
 {
@@ -62,6 +63,15 @@ void ElecInfo::setup(const Everything &everything, std::vector<diagMatrix>& F, E
 	//Determine distribution amongst processes:
 	qDivision.init(nStates, mpiWorld);
 	qDivision.myRange(qStart, qStop);
+	if(mpiWorld->nProcesses() > nStates)
+	{	//Each process owns at most one state: group processes without states with the owner of the next state
+		qBand = (qStop>qStart) ? qStart : qStop;
+		mpiBand = std::make_shared<MPIUtil>(0, (char**)0, MPIUtil::ProcDivision(mpiWorld, 0, qBand));
+		if(mpiBand->nProcesses() > 1)
+			logPrintf("Sharing bands of each state over groups of %d-%d processes for density calculation.\n",
+				mpiWorld->nProcesses()/nStates, ceildiv(mpiWorld->nProcesses(),nStates));
+		else mpiBand.reset();
+	}
 	
 	//Allocate the fillings matrices.
 	F.resize(nStates);
@@ -114,7 +124,9 @@ void ElecInfo::setup(const Everything &everything, std::vector<diagMatrix>& F, E
 	else
 	{	logPrintf("Reading initial fillings from file %s.\n", initialFillingsFilename.c_str());
 		if(nBandsOld <= 0) nBandsOld=nBands;
-		read(F, initialFillingsFilename.c_str(), nBandsOld);
+		if(Checkpoint::isCheckpointFile(initialFillingsFilename))
+			Checkpoint::read(*e, initialFillingsFilename, "fillings", F, nBandsOld);
+		else read(F, initialFillingsFilename.c_str(), nBandsOld);
 		
 		for(int q=qStart; q<qStop; q++)
 		{	F[q] *= wInv; //NOTE: fillings are always 0 to 1 internally, but read/write 0 to 2 for SpinNone
@@ -350,73 +362,119 @@ matrix ElecInfo::smearGrad(double mu, const diagMatrix& eps, const matrix& gradF
 }
 
 
-//Number of electrons and magnetization in a fermi distribution of given mu, Bz and eigenvalues:
-double ElecInfo::magnetizationCalc(double mu, double Bz, const std::vector<diagMatrix>& eps, double& N) const
-{	N = 0.;
-	double M = 0.;
+//Number of electrons, magnetization and their derivatives in a fermi distribution of given mu, Bz and eigenvalues:
+ElecInfo::FillingMoments ElecInfo::fillingMoments(double mu, double Bz, const std::vector<diagMatrix>& eps) const
+{	double buf[5] = {0., 0., 0., 0., 0.}; //N, M, dN/dmu, dN/dBz (= dM/dmu), dM/dBz
 	for(int q=qStart; q<qStop; q++)
 	{	double s = qnums[q].spin;
 		double muEff = this->muEff(mu, Bz, q);
 		for(double epsCur: eps[q])
 		{	double wf = qnums[q].weight * smear(muEff, epsCur);
-			N += wf;
-			M += s * wf;
+			double wfPrime = -qnums[q].weight * smearPrime(muEff, epsCur); //derivative w.r.t muEff
+			buf[0] += wf;
+			buf[1] += s * wf;
+			buf[2] += wfPrime;
+			buf[3] += s * wfPrime;
+			buf[4] += s * s * wfPrime;
 		}
 	}
-	mpiWorld->allReduce(N, MPIUtil::ReduceSum, true);
-	mpiWorld->allReduce(M, MPIUtil::ReduceSum, true);
-	return M;
+	mpiWorld->allReduce(buf, 5, MPIUtil::ReduceSum, true); //single reduction for all moments
+	FillingMoments fm;
+	fm.N = buf[0]; fm.M = buf[1];
+	fm.dNdmu = buf[2]; fm.dNdBz = buf[3]; fm.dMdBz = buf[4];
+	return fm;
 }
 
-//Calculate nElectrons at given mu, bisecting on Bz if M is constrained
-double ElecInfo::nElectronsCalc(double mu, const std::vector< diagMatrix >& eps, double& Bz) const
-{	double N = 0.;
-	Bz = this->Bz; //target value or NAN
-	if(std::isnan(Bz)) //Fixed magnetization
+//Safeguarded Newton solve of f(x) = target for f non-decreasing in x, with eval(x, f, fPrime).
+//Newton steps are taken while they stay within the bracket established so far (and fPrime > 0);
+//otherwise bisect within the bracket, or step outward with doubling steps until the target is bracketed.
+template<typename Eval> double solveNewtonSafe(const Eval& eval, double target, double x, double xStep,
+	double fTol, double xTol, const char* name, bool verbose)
+{	double xLo = -INFINITY, xHi = +INFINITY;
+	const int nIterMax = 200;
+	for(int iter=0; iter<nIterMax; iter++)
+	{	double f, fPrime;
+		eval(x, f, fPrime);
+		double df = f - target;
+		double dx = (fPrime > 0.) ? -df/fPrime : NAN; //Newton step
+		if(verbose) logPrintf("%sNEWTON: %s = %.15le  bracket = [ %.15le %.15le ]  residual = %le\n", name, name, x, xLo, xHi, df);
+		if(fabs(df) <= fTol && fabs(dx) <= xTol) return x + dx; //converged (quadratically, so this step is well within tolerance)
+		if(df == 0.) return x;
+		if(df < 0.) xLo = x; else xHi = x;
+		if(xHi - xLo < xTol) return 0.5*(xLo + xHi);
+		double xNew = x + dx;
+		if(std::isfinite(xLo) && std::isfinite(xHi))
+		{	if(!(xNew > xLo && xNew < xHi)) xNew = 0.5*(xLo + xHi); //bisect
+		}
+		else
+		{	double xLimit = (df < 0.) ? x + xStep : x - xStep; //outward step towards the unbracketed side
+			if(!std::isfinite(dx) || fabs(dx) > xStep) { xNew = xLimit; xStep *= 2.; }
+			if(std::isfinite(xLo) && xNew <= xLo) xNew = 0.5*(xLo + x);
+			if(std::isfinite(xHi) && xNew >= xHi) xNew = 0.5*(xHi + x);
+		}
+		x = xNew;
+	}
+	logPrintf("WARNING: %s search did not converge in %d iterations.\n", name, nIterMax);
+	return (std::isfinite(xLo) && std::isfinite(xHi)) ? 0.5*(xLo + xHi) : x;
+}
+
+//Calculate nElectrons and its derivative w.r.t mu at given mu, solving for Bz (starting from the input value) if M is constrained
+double ElecInfo::nElectronsCalc(double mu, const std::vector<diagMatrix>& eps, double& Bz, double& dNdmu) const
+{	FillingMoments fm;
+	if(std::isnan(this->Bz)) //Fixed magnetization
 	{	const bool& verbose = e->cntrl.shouldPrintMuSearch;
-		if(verbose) logPrintf("\nBisecting to find Bz(M=%5lf)\n", Minitial);
-		//Find a range which is known to bracket the result:
+		if(verbose) logPrintf("\nSearching for Bz(M=%5lf)\n", Minitial);
 		const double absTol = 1e-10, relTol = 1e-14;
 		double Mtol = std::max(absTol, relTol*fabs(Minitial));
-		double BzMin=-0.1, BzMax=+0.1;
-		while(magnetizationCalc(mu,BzMin,eps,N)>=Minitial+Mtol) BzMin-=(BzMax-BzMin);
-		while(magnetizationCalc(mu,BzMax,eps,N)<=Minitial-Mtol) BzMax+=(BzMax-BzMin);
-		//Bisect:
-		double BzTol = std::max(absTol*smearingWidth, relTol*std::max(fabs(BzMin),fabs(BzMax)));
-		while(BzMax-BzMin>=BzTol)
-		{	double Bz = 0.5*(BzMin + BzMax);
-			double M = magnetizationCalc(mu, Bz, eps, N);
-			if(verbose) logPrintf("BzBISECT: Bz = [ %.15le %.15le %.15le ]  M = %le\n", BzMin, Bz, BzMax, M);
-			if(M>Minitial) BzMax = Bz;
-			else BzMin = Bz;
-		}
-		Bz = 0.5*(BzMin + BzMax);
+		double BzTol = std::max(absTol*smearingWidth, relTol*fabs(Bz));
+		auto evalM = [&](double BzCur, double& M, double& dMdBz)
+		{	fm = fillingMoments(mu, BzCur, eps);
+			M = fm.M;
+			dMdBz = fm.dMdBz;
+		};
+		Bz = solveNewtonSafe(evalM, Minitial, Bz, 0.1, Mtol, BzTol, "Bz", verbose);
+		fm = fillingMoments(mu, Bz, eps);
+		//Derivative at constant M, with Bz implicitly adjusting (dM/dmu = dN/dBz):
+		dNdmu = fm.dNdmu - (fm.dMdBz > 0. ? fm.dNdBz*fm.dNdBz/fm.dMdBz : 0.);
+	}
+	else
+	{	Bz = this->Bz;
+		fm = fillingMoments(mu, Bz, eps);
+		dNdmu = fm.dNdmu;
 	}
-	magnetizationCalc(mu, Bz, eps, N);
-	return N;
+	return fm.N;
+}
+
+double ElecInfo::nElectronsCalc(double mu, const std::vector< diagMatrix >& eps, double& Bz) const
+{	double dNdmu;
+	Bz = 0.; //starting guess if M is constrained
+	return nElectronsCalc(mu, eps, Bz, dNdmu);
 }
 
 
-//Return the mu that would match Ntarget at the current eigenvalues (bisection method)
+//Return the mu that would match Ntarget at the current eigenvalues (safeguarded Newton method)
 double ElecInfo::findMu(const std::vector<diagMatrix>& eps, double nElectrons, double& Bz) const
 {	const bool& verbose = e->cntrl.shouldPrintMuSearch;
-	if(verbose) logPrintf("\nBisecting to find mu(nElectrons=%.15le)\n", nElectrons);
-	//Find a range which is known to bracket the result:
+	if(verbose) logPrintf("\nSearching for mu(nElectrons=%.15le)\n", nElectrons);
 	const double absTol = 1e-10, relTol = 1e-14;
 	double nTol = std::max(absTol, relTol*fabs(nElectrons));
-	double muMin=-0.1, muMax=+0.0;
-	while(nElectronsCalc(muMin,eps,Bz)>=nElectrons+nTol) muMin-=(muMax-muMin);
-	while(nElectronsCalc(muMax,eps,Bz)<=nElectrons-nTol) muMax+=(muMax-muMin);
-	//Bisect:
-	double muTol = std::max(absTol*smearingWidth, relTol*std::max(fabs(muMin),fabs(muMax)));
-	while(muMax-muMin>=muTol)
-	{	double mu = 0.5*(muMin + muMax);
-		double N = nElectronsCalc(mu, eps, Bz);
-		if(verbose) logPrintf("MUBISECT: mu = [ %.15le %.15le %.15le ]  N = %le\n", muMin, mu, muMax, N);
-		if(N>nElectrons) muMax = mu;
-		else muMin = mu;
-	}
-	return 0.5*(muMin + muMax);
+	//Start from the middle of the eigenvalue range (the result lies within it unless nearly all states are empty or full):
+	double epsMin = +INFINITY, epsMax = -INFINITY;
+	for(int q=qStart; q<qStop; q++)
+		for(double epsCur: eps[q])
+		{	epsMin = std::min(epsMin, epsCur);
+			epsMax = std::max(epsMax, epsCur);
+		}
+	mpiWorld->allReduce(epsMin, MPIUtil::ReduceMin);
+	mpiWorld->allReduce(epsMax, MPIUtil::ReduceMax);
+	double mu0 = std::isfinite(epsMin+epsMax) ? 0.5*(epsMin+epsMax) : 0.;
+	double muStep = std::isfinite(epsMax-epsMin) ? std::max(0.5*(epsMax-epsMin), 0.1) : 0.1;
+	double muTol = std::max(absTol*smearingWidth, relTol*fabs(mu0));
+	Bz = 0.; //starting guess, warm-started across mu iterations when M is constrained
+	auto evalN = [&](double mu, double& N, double& dNdmu) { N = nElectronsCalc(mu, eps, Bz, dNdmu); };
+	double mu = solveNewtonSafe(evalN, nElectrons, mu0, muStep, nTol, muTol, "mu", verbose);
+	if(std::isnan(this->Bz)) { double dNdmu; nElectronsCalc(mu, eps, Bz, dNdmu); } //Bz consistent with final mu
+	return mu;
 }
 
 
@@ -498,8 +556,14 @@ void ElecInfo::kpointsPrint(FILE* fp, bool printSpin) const
 }
 
 void ElecInfo::kpointPrint(FILE* fp, int q, bool printSpin) const
-{	fprintf(fp, "%5d  [ %+.7f %+.7f %+.7f ]  %.9f", q, qnums[q].k[0], qnums[q].k[1], qnums[q].k[2], qnums[q].weight);
-	if(printSpin && qnums[q].spin) fprintf(fp, "  spin %+d", qnums[q].spin); //only for spin-polarized calculations
+{	fputs(kpointString(q, printSpin).c_str(), fp);
+}
+
+string ElecInfo::kpointString(int q, bool printSpin) const
+{	char buf[256];
+	int len = snprintf(buf, sizeof(buf), "%5d  [ %+.7f %+.7f %+.7f ]  %.9f", q, qnums[q].k[0], qnums[q].k[1], qnums[q].k[2], qnums[q].weight);
+	if(printSpin && qnums[q].spin) snprintf(buf+len, sizeof(buf)-len, "  spin %+d", qnums[q].spin); //only for spin-polarized calculations
+	return string(buf);
 }
 
 
@@ -23,6 +23,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/vector3.h>
 #include <core/MPIUtil.h>
+#include <memory>
 
 class matrix;
 class diagMatrix;
@@ -68,6 +69,10 @@ public:
 	int qStartOther(int iProc) const { return qDivision.start(iProc); } //!< find out qStart for another process
 	int qStopOther(int iProc) const { return qDivision.stop(iProc); } //!< find out qStop for another process
 	
+	//Band groups: with more processes than states, processes that own no state share the band work of the next state
+	std::shared_ptr<MPIUtil> mpiBand; //!< processes sharing the bands of state qBand, with its owner as the last rank (null if not sharing)
+	int qBand; //!< state whose bands are shared within mpiBand
+	
 	SpinType spinType; //!< type of spin treatment
 	double nElectrons; //!< the number of electrons = Sum w Tr[F]
 	std::vector<QuantumNumber> qnums; //!< k-points, spins and weights for each state
@@ -97,6 +102,8 @@ public:
 	double mu; //!< If NaN, fix nElectrons, otherwise fix/target chemical potential to this
 	double Bz; //!< If NaN, fix magnetization, otherwise fix/target magnetic field to this value
 	bool muLoop; //!< Whether to optimize mu in an outer loop over fixed charge calculations
+	std::vector<double> scanValues; //!< Electrode scan: target mu (or net excess electrons if scanCharge) to converge in turn after the main calculation
+	bool scanCharge; //!< Whether scanValues are net excess electron counts instead of chemical potentials
 	
 	bool hasU; //! Flag to check whether the calculation has a DFT+U self-interaction correction
 
@@ -121,7 +128,7 @@ public:
 	matrix smearGrad(double mu, const diagMatrix& eps, const matrix& gradF) const;
 
 	//! Compute number of electrons for the smearing function with specified eigenvalues
-	//! If magnetization is constrained, bisect on corresponding Lagrange multiplier Bz, and retrieve it too
+	//! If magnetization is constrained, solve for corresponding Lagrange multiplier Bz, and retrieve it too
 	double nElectronsCalc(double mu, const std::vector<diagMatrix>& eps, double& Bz) const; 
 	
 	//! Find the chemical potential for which the smearing function with specified eigenvalues adds up to nElectrons
@@ -130,6 +137,7 @@ public:
 	
 	void kpointsPrint(FILE* fp, bool printSpin=false) const; //!< Output k-points, weights and optionally spins
 	void kpointPrint(FILE* fp, int q, bool printSpin=false) const; //!< Output k-points, weights and optionally spins
+	string kpointString(int q, bool printSpin=false) const; //!< Same as kpointPrint, but to a string
 	
 	int findHOMO(int q) const; //!< Returns the band index of the Highest Occupied Kohn-Sham Orbital
 
@@ -148,7 +156,7 @@ public:
 		ColumnBundleReadConversion();
 	};
 	void read(std::vector<class ColumnBundle>&, const char *fname, const ColumnBundleReadConversion* conversion=0) const; //!< Read array of columnbundles, optionally with conversion
-	void write(const std::vector<class ColumnBundle>&, const char *fname) const; //!< write an array of columnbundles to file
+	void write(const std::vector<class ColumnBundle>&, const char *fname, bool singlePrecision=false) const; //!< write an array of columnbundles to file, optionally in single precision (detected automatically by read)
 
 private:
 	const Everything* e;
@@ -161,12 +169,21 @@ private:
 	friend struct CommandElecInitialCharge;
 	friend struct CommandElecInitialMagnetization;
 	friend struct CommandInitialState;
+	friend struct CommandInitialCheckpoint;
+	friend class StateStore;
 	friend class ElecVars;
 	friend struct LCAOminimizer;
 	friend void dumpFCI(const Everything& e, const char* filename);
 	
-	//!Calculate nElectrons and return magnetization at given mu, Bz and eigenvalues eps
-	double magnetizationCalc(double mu, double Bz, const std::vector<diagMatrix>& eps, double& nElectrons) const; 
+	//! Number of electrons, magnetization and their derivatives at given mu, Bz and eigenvalues eps
+	struct FillingMoments
+	{	double N, M; //!< number of electrons and magnetization
+		double dNdmu, dNdBz, dMdBz; //!< derivatives (dM/dmu = dN/dBz)
+	};
+	FillingMoments fillingMoments(double mu, double Bz, const std::vector<diagMatrix>& eps) const; //!< compute FillingMoments with a single reduction over processes
+	
+	//! Calculate nElectrons and its derivative w.r.t mu (at constant magnetization if constrained, solving for Bz starting from its input value)
+	double nElectronsCalc(double mu, const std::vector<diagMatrix>& eps, double& Bz, double& dNdmu) const;
 	
 	//k-points:
 	vector3<int> kfold; //!< kpoint fold vector
@@ -20,6 +20,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/ElecMinimizer.h>
 #include <electronic/BandMinimizer.h>
 #include <electronic/BandDavidson.h>
+#include <electronic/BandLOBPCG.h>
+#include <electronic/BandChebyshev.h>
 #include <electronic/ColumnBundle.h>
 #include <electronic/Everything.h>
 #include <electronic/ExactExchange.h>
@@ -38,7 +40,7 @@ void ElecGradient::init(const Everything& e)
 
 ElecGradient& ElecGradient::operator*=(double alpha)
 {	for(int q=eInfo->qStart; q<eInfo->qStop; q++)
-	{	if(C[q]) C[q] *= alpha;
+	{	if(C[q]) { C[q] *= alpha; C[q].evict(); }
 		if(Haux[q]) Haux[q] *= alpha;
 	}
 	return *this;
@@ -47,7 +49,7 @@ ElecGradient& ElecGradient::operator*=(double alpha)
 void axpy(double alpha, const ElecGradient& x, ElecGradient& y)
 {	assert(x.eInfo == y.eInfo);
 	for(int q=x.eInfo->qStart; q<x.eInfo->qStop; q++)
-	{	if(x.C[q]) { if(y.C[q]) axpy(alpha, x.C[q], y.C[q]); else y.C[q] = alpha*x.C[q]; }
+	{	if(x.C[q]) { if(y.C[q]) axpy(alpha, x.C[q], y.C[q]); else y.C[q] = alpha*x.C[q]; x.C[q].evict(); y.C[q].evict(); }
 		if(x.Haux[q]) { if(y.Haux[q]) axpy(alpha, x.Haux[q], y.Haux[q]); else y.Haux[q] = alpha*x.Haux[q]; }
 	}
 }
@@ -56,7 +58,7 @@ double dot(const ElecGradient& x, const ElecGradient& y, double* auxContrib)
 {	assert(x.eInfo == y.eInfo);
 	std::vector<double> result(2, 0.); //calculate wavefunction and auxiliary contributions separately
 	for(int q=x.eInfo->qStart; q<x.eInfo->qStop; q++)
-	{	if(x.C[q] && y.C[q]) result[0] += dotc(x.C[q], y.C[q]).real()*2.0;
+	{	if(x.C[q] && y.C[q]) { result[0] += dotc(x.C[q], y.C[q]).real()*2.0; x.C[q].evict(); y.C[q].evict(); }
 		if(x.Haux[q] && y.Haux[q]) result[1] += dotc(x.Haux[q], y.Haux[q]).real();
 	}
 	mpiWorld->allReduceData(result, MPIUtil::ReduceSum);
@@ -68,6 +70,10 @@ ElecGradient clone(const ElecGradient& x)
 {	return x;
 }
 
+void cloneInto(const ElecGradient& x, ElecGradient& y)
+{	y = x; //copy-assignment of ColumnBundle and matrix reuses existing storage of the same size
+}
+
 void randomize(ElecGradient& x)
 {	randomize(x.C, *x.eInfo);
 	for(int q=x.eInfo->qStart; q<x.eInfo->qStop; q++)
@@ -77,6 +83,63 @@ void randomize(ElecGradient& x)
 		}
 }
 
+void LBFGSHistoryStore<ElecGradient>::store(ElecGradient& x, const MinimizeParams& p)
+{	storage = p.historyStorage;
+	if(storage == MinimizeParams::HistoryFull) { std::swap(x, this->x); return; }
+	//Keep auxiliary Hamiltonian (small) as is, and wavefunctions on the host:
+	this->x.eInfo = x.eInfo;
+	this->x.C.clear();
+	std::swap(this->x.Haux, x.Haux);
+	size_t nStates = x.C.size();
+	shapes.assign(nStates, Shape{0, 0, 0, 0});
+	Chost.resize(nStates);
+	ChostSingle.resize(nStates);
+	for(int q=x.eInfo->qStart; q<x.eInfo->qStop; q++)
+	{	const ColumnBundle& Cq = x.C[q];
+		Chost[q].clear();
+		ChostSingle[q].clear();
+		if(!Cq) continue;
+		shapes[q] = Shape{Cq.nCols(), Cq.colLength(), Cq.basis, Cq.qnum};
+		const double* in = (const double*)Cq.data();
+		size_t n = 2*Cq.nData();
+		if(storage == MinimizeParams::HistoryHostSingle)
+			ChostSingle[q].assign(in, in+n);
+		else
+			Chost[q].assign(in, in+n);
+	}
+}
+
+const ElecGradient& LBFGSHistoryStore<ElecGradient>::load(ElecGradient& work) const
+{	if(storage == MinimizeParams::HistoryFull) return x;
+	work.eInfo = x.eInfo;
+	work.Haux = x.Haux;
+	work.C.resize(shapes.size());
+	for(int q=x.eInfo->qStart; q<x.eInfo->qStop; q++)
+	{	const Shape& shape = shapes[q];
+		ColumnBundle& Cq = work.C[q];
+		if(!shape.nCols) { Cq.free(); continue; }
+		if(Cq.nCols()!=shape.nCols || Cq.colLength()!=shape.colLength)
+			Cq.init(shape.nCols, shape.colLength, shape.basis, shape.qnum, isGpuEnabled());
+		Cq.basis = shape.basis;
+		Cq.qnum = shape.qnum;
+		bool single = (storage == MinimizeParams::HistoryHostSingle);
+		#ifdef GPU_ENABLED
+		if(Cq.isOnGpu())
+		{	//Convert on the host and copy to the GPU in one transfer:
+			std::vector<double> buf;
+			if(single) buf.assign(ChostSingle[q].begin(), ChostSingle[q].end());
+			const double* in = single ? buf.data() : Chost[q].data();
+			cudaMemcpy(Cq.dataGpu(), in, 2*Cq.nData()*sizeof(double), cudaMemcpyHostToDevice);
+			continue;
+		}
+		#endif
+		double* out = (double*)Cq.data();
+		if(single) std::copy(ChostSingle[q].begin(), ChostSingle[q].end(), out);
+		else std::copy(Chost[q].begin(), Chost[q].end(), out);
+	}
+	return work;
+}
+
 struct SubspaceRotationAdjust
 {
 	Everything& e;
@@ -143,7 +206,8 @@ struct SubspaceRotationAdjust
 
 
 ElecMinimizer::ElecMinimizer(Everything& e)
-: e(e), eVars(e.eVars), eInfo(e.eInfo), rotPrev(eInfo.nStates), rotPrevC(eInfo.nStates), rotPrevCinv(eInfo.nStates)
+: e(e), eVars(e.eVars), eInfo(e.eInfo), rotPrev(eInfo.nStates), rotPrevC(eInfo.nStates), rotPrevCinv(eInfo.nStates),
+	rotWork(std::make_shared<ColumnBundle>()), fftPrecision(e)
 {
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
 	{	rotPrev[q] = eye(eInfo.nBands);
@@ -151,6 +215,7 @@ ElecMinimizer::ElecMinimizer(Everything& e)
 		rotPrevCinv[q] = eye(eInfo.nBands);
 	}
 	rotExists = false; //rotation is identity
+	Eprev = NAN; dEprev = NAN; //no energy history yet
 	
 	//Initialize subspace rotation adjuster if required:
 	if(e.cntrl.subspaceRotationAdjust && ( eInfo.fillingsUpdate==ElecInfo::FillingsHsub || !eInfo.scalarFillings) )
@@ -159,8 +224,23 @@ ElecMinimizer::ElecMinimizer(Everything& e)
 
 void ElecMinimizer::step(const ElecGradient& dir, double alpha)
 {	assert(dir.eInfo == &eInfo);
+	//Haux fillings: rotations chosen to diagonalize the auxiliary matrices (all states together, batched):
+	std::vector<matrix> rotHaux;
+	if(eInfo.fillingsUpdate == ElecInfo::FillingsHsub)
+	{	std::vector<matrix> dirHaux = rotExists
+			? multiply(rotPrev, multiply(dir.Haux, rotPrev), CblasConjTrans)
+			: dir.Haux;
+		std::vector<matrix> Haux(eInfo.nStates);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	assert(dir.Haux[q]);
+			Haux[q] = eVars.Haux_eigs[q];
+			axpy(alpha, dirHaux[q], Haux[q]);
+		}
+		diagonalize(Haux, rotHaux, eVars.Haux_eigs);
+	}
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-	{	axpy(alpha, rotExists ? dir.C[q]*rotPrevC[q] : dir.C[q], eVars.C[q]);
+	{	if(rotExists) eVars.C[q] += (alpha*dir.C[q]) * rotPrevC[q]; //accumulated directly by the matrix multiply
+		else axpy(alpha, dir.C[q], eVars.C[q]);
 		if(eInfo.fillingsUpdate==ElecInfo::FillingsConst && eInfo.scalarFillings)
 		{	//Constant scalar fillings: no rotations required
 			eVars.orthonormalize(q);
@@ -170,10 +250,8 @@ void ElecMinimizer::step(const ElecGradient& dir, double alpha)
 			assert(dir.Haux[q]);
 			matrix rot;
 			if(eInfo.fillingsUpdate == ElecInfo::FillingsHsub)
-			{	//Haux fillings:
-				matrix Haux = eVars.Haux_eigs[q];
-				axpy(alpha, rotExists ? dagger(rotPrev[q])*dir.Haux[q]*rotPrev[q] : dir.Haux[q], Haux);
-				Haux.diagonalize(rot, eVars.Haux_eigs[q]); //rotation chosen to diagonalize auxiliary matrix
+			{	//Haux fillings (diagonalized above):
+				rot = rotHaux[q];
 			}
 			else
 			{	//Non-scalar fillings:
@@ -187,19 +265,22 @@ void ElecMinimizer::step(const ElecGradient& dir, double alpha)
 			rotPrevCinv[q] = inv(rotC) * rotPrevCinv[q];
 			rotExists = true; //rotation is no longer identity
 		}
+		eVars.C[q].evict(); dir.C[q].evict(); //move out of device memory till next use (if enabled)
 	}
 }
 
 double ElecMinimizer::compute(ElecGradient* grad, ElecGradient* Kgrad)
 {	if(grad) grad->init(e);
 	if(Kgrad) Kgrad->init(e);
+	if(eVars.fluidSolver) eVars.fluidSolver->electronicEnergyChange = fabs(dEprev); //loosens inner fluid solves far from convergence (if enabled)
 	double ener = e.eVars.elecEnergyAndGrad(e.ener, grad, Kgrad);
+	dEprev = ener - Eprev; Eprev = ener;
 	if(grad)
 	{	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
 		{	//Rotate wavefunction gradients if necessary:
 			if(rotExists)
-			{	grad->C[q] = grad->C[q] * rotPrevCinv[q];
-				Kgrad->C[q] = Kgrad->C[q] * rotPrevCinv[q];
+			{	(grad->C[q] * rotPrevCinv[q]).scaleAccumulate(1., 0., *rotWork); std::swap(grad->C[q], *rotWork);
+				(Kgrad->C[q] * rotPrevCinv[q]).scaleAccumulate(1., 0., *rotWork); std::swap(Kgrad->C[q], *rotWork);
 			}
 			//Subspace gradient handling depends on mode:
 			if(eInfo.fillingsUpdate == ElecInfo::FillingsHsub)
@@ -215,6 +296,7 @@ double ElecMinimizer::compute(ElecGradient* grad, ElecGradient* Kgrad)
 				Kgrad->Haux[q] = e.cntrl.subspaceRotationFactor * grad->Haux[q];
 			}
 			//else: constant scalar fillings (no subspace gradient)
+			grad->C[q].evict(); Kgrad->C[q].evict();
 		}
 		
 		//Cache gradient overlaps, if needed, for subspace rotation handling:
@@ -244,6 +326,8 @@ bool ElecMinimizer::report(int iter)
 	if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub)
 		eInfo.smearReport();
 	
+	fftPrecision.update();
+	
 	//Dump:
 	e.dump(DumpFreq_Electronic, iter);
 	
@@ -263,7 +347,9 @@ void ElecMinimizer::constrain(ElecGradient& dir)
 {	assert(dir.eInfo == &eInfo);
 	//Project component of search direction along current wavefunctions:
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-		dir.C[q] -= eVars.C[q] * (eVars.C[q]^O(dir.C[q]));
+	{	dir.C[q] -= eVars.C[q] * (eVars.C[q]^O(dir.C[q]));
+		eVars.C[q].evict(); dir.C[q].evict();
+	}
 }
 
 double ElecMinimizer::sync(double x) const
@@ -271,8 +357,51 @@ double ElecMinimizer::sync(double x) const
 	return x;
 }
 
+//Converge the bands of a single state q with the selected eigen-algorithm:
+static void bandMinimizeState(Everything& e, int q)
+{	logPrintf("\n---- Minimization of quantum number: "); e.eInfo.kpointPrint(globalLog, q, true); logPrintf(" ----\n");
+	switch(e.cntrl.elecEigenAlgo)
+	{	case ElecEigenCG: { BandMinimizer(e, q).minimize(e.elecMinParams); break; }
+		case ElecEigenDavidson: { BandDavidson(e, q).minimize(); break; }
+		case ElecEigenLOBPCG: { BandLOBPCG(e, q).minimize(); break; }
+		case ElecEigenChebyshev: { BandChebyshev(e, q).minimize(); break; }
+	}
+}
+
+//Band-streaming: initialize, converge, write and release the wavefunctions of one state at a time,
+//so that only one state's wavefunctions and projectors are held on each process at any time:
+static void bandMinimizeStreamed(Everything& e)
+{	ElecVars& eVars = e.eVars;
+	logPrintf("Minimization will be done one quantum number at a time (band-streaming).\n");
+	e.dump.streamWfnsStart();
+	e.ener.Eband = 0.;
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+	{	eVars.initStreamedWavefunctions(q);
+		bandMinimizeState(e, q);
+		e.ener.Eband += e.eInfo.qnums[q].weight * trace(eVars.Hsub_eigs[q]);
+		eVars.setEigenvectors(q);
+		e.dump.streamWfns(q);
+		//Release this state's wavefunctions, projections and projectors:
+		for(const auto& sp: e.iInfo.species) sp->releaseProjectors(eVars.C[q]);
+		eVars.C[q].free();
+		for(matrix& VdagCq_sp: eVars.VdagC[q]) VdagCq_sp = matrix();
+	}
+	mpiWorld->allReduce(e.ener.Eband, MPIUtil::ReduceSum);
+	e.dump.streamWfnsFinish();
+	if(e.cntrl.shouldPrintEigsFillings)
+	{	//Print the eigenvalues if requested
+		print_Hsub_eigs(e);
+		logPrintf("\n"); logFlush();
+	}
+}
+
 void bandMinimize(Everything& e, bool updateVxx)
 {	bool fixed_H = true; std::swap(fixed_H, e.cntrl.fixed_H); //remember fixed_H flag and temporarily set it to true
+	if(e.cntrl.bandStreaming and fixed_H)
+	{	bandMinimizeStreamed(e);
+		std::swap(fixed_H, e.cntrl.fixed_H); //restore fixed_H flag
+		return;
+	}
 	bool loopOuter = updateVxx and e.exCorr.exxFactor(); //whether an outer loop to converge VXX is required
 	int nOuter = loopOuter ? e.cntrl.nOuterVxx : 1;
 	double outerThreshold = e.elecMinParams.energyDiffThreshold;
@@ -284,12 +413,9 @@ void bandMinimize(Everything& e, bool updateVxx)
 	{	if(loopOuter) e.exx->prepareHamiltonian(e.exCorr.exxRange(), e.eVars.F, e.eVars.C);
 		e.ener.Eband = 0.;
 		for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
-		{	logPrintf("\n---- Minimization of quantum number: "); e.eInfo.kpointPrint(globalLog, q, true); logPrintf(" ----\n");
-			switch(e.cntrl.elecEigenAlgo)
-			{	case ElecEigenCG: { BandMinimizer(e, q).minimize(e.elecMinParams); break; }
-				case ElecEigenDavidson: { BandDavidson(e, q).minimize(); break; }
-			}
+		{	bandMinimizeState(e, q);
 			e.ener.Eband += e.eInfo.qnums[q].weight * trace(e.eVars.Hsub_eigs[q]);
+			e.eVars.C[q].evict();
 		}
 		mpiWorld->allReduce(e.ener.Eband, MPIUtil::ReduceSum);
 		//Check convergence of outer loop:
@@ -368,7 +494,7 @@ void muOuterLoop(Everything& e)
 
 void elecMinimize(Everything& e)
 {	
-	if(!std::isnan(e.eInfo.mu) && e.eInfo.muLoop)
+	if(!std::isnan(e.eInfo.mu) && e.eInfo.muLoop && !(e.cntrl.scf && e.scfParams.mixNelectrons))
 	{	muOuterLoop(e); //Run a loop over fixed charge calculations to target mu
 	}
 	else if(e.cntrl.scf)
@@ -383,6 +509,7 @@ void elecMinimize(Everything& e)
 		emin.minimize(e.elecMinParams);
 		e.eVars.setEigenvectors();
 	}
+	if(e.eVars.fluidSolver) e.eVars.fluidSolver->electronicEnergyChange = NAN; //subsequent fluid solves at full accuracy
 	e.eVars.isRandom = false; //wavefunctions are no longer random
 	//Converge empty states if necessary:
 	if(e.cntrl.convergeEmptyStates and (not e.cntrl.fixed_H))
@@ -487,6 +614,22 @@ void elecFluidMinimize(Everything &e)
 		logPrintf("Single-point solvation energy estimate, Delta%s = %+.15f\n", relevantFreeEnergyName(e), relevantFreeEnergy(e)-Evac0);
 }
 
+FftPrecisionSwitch::FftPrecisionSwitch(Everything& e) : e(e), Eprev(NAN)
+{	e.gInfo.fftSinglePrecision = (e.cntrl.fftSinglePrecisionThreshold > 0.);
+	if(e.gInfoWfns) e.gInfoWfns->fftSinglePrecision = e.gInfo.fftSinglePrecision;
+}
+
+void FftPrecisionSwitch::update()
+{	if(!e.gInfo.fftSinglePrecision) return;
+	double E = relevantFreeEnergy(e);
+	if(fabs(E - Eprev) < e.cntrl.fftSinglePrecisionThreshold)
+	{	logPrintf("Energy change %le < %le: switching wavefunction FFTs to double precision.\n", fabs(E-Eprev), e.cntrl.fftSinglePrecisionThreshold);
+		e.gInfo.fftSinglePrecision = false;
+		if(e.gInfoWfns) e.gInfoWfns->fftSinglePrecision = false;
+	}
+	Eprev = E;
+}
+
 void convergeEmptyStates(Everything& e)
 {	logPrintf("Converging empty states (this may take a while): "); logFlush();
 	std::vector<diagMatrix> eigsPrev = e.eVars.Hsub_eigs;
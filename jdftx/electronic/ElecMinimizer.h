@@ -26,6 +26,8 @@ class Everything;
 class ElecInfo;
 class ColumnBundle;
 class matrix;
+class Basis;
+class QuantumNumber;
 
 //! @addtogroup ElecSystem
 //! @{
@@ -46,8 +48,34 @@ struct ElecGradient
 void axpy(double alpha, const ElecGradient& x, ElecGradient& y); //!< accumulate operation: y += alpha*x
 double dot(const ElecGradient& x, const ElecGradient& y, double* auxContrib=0); //!< inner product (optionally retrieve auxiliary contribution)
 ElecGradient clone(const ElecGradient& x); //!< create a copy
+void cloneInto(const ElecGradient& x, ElecGradient& y); //!< copy x into y, reusing the storage of y
 void randomize(ElecGradient& x); //!< Initialize to random numbers
 
+//! L-BFGS history entry for electronic minimization, optionally held in host memory and/or single precision
+template<> struct LBFGSHistoryStore<ElecGradient>
+{	void store(ElecGradient& x, const MinimizeParams& p); //!< take over (HistoryFull) or copy to host memory
+	const ElecGradient& load(ElecGradient& work) const; //!< stored vector, expanded into work unless HistoryFull
+private:
+	MinimizeParams::HistoryStorage storage;
+	ElecGradient x; //!< full vector (HistoryFull), or only its auxiliary Hamiltonian part otherwise
+	struct Shape { int nCols; size_t colLength; const Basis* basis; const QuantumNumber* qnum; };
+	std::vector<Shape> shapes; //!< dimensions of each wavefunction component stored on the host
+	std::vector<std::vector<double>> Chost; //!< wavefunction components in host memory (HistoryHost), as interleaved real and imaginary parts
+	std::vector<std::vector<float>> ChostSingle; //!< same in single precision (HistoryHostSingle)
+};
+
+//! Switches wavefunction FFTs to double precision once the energy change per iteration falls below cntrl.fftSinglePrecisionThreshold.
+//! Each electronic minimizer owns one, so that every minimization (eg. each ionic step or NEB image) starts afresh in single precision.
+class FftPrecisionSwitch
+{
+public:
+	FftPrecisionSwitch(Everything& e); //!< (re-)enable single-precision wavefunction FFTs if requested, with no energy history
+	void update(); //!< compare energy to that at the previous call and switch if converged enough (call each electronic iteration)
+private:
+	Everything& e;
+	double Eprev; //!< energy at previous update()
+};
+
 //! Variational total energy minimizer for electrons
 class ElecMinimizer : public Minimizable<ElecGradient>
 {
@@ -69,9 +97,12 @@ private:
 	std::vector<matrix> rotPrev; //!< cumulated unitary rotations of subspace
 	std::vector<matrix> rotPrevC; //!< cumulated transormation of wavefunctions (including non-unitary orthonormalization components)
 	std::vector<matrix> rotPrevCinv; //!< inverse of rotPrevC (which is not just dagger, since these are not exactly unitary)
+	std::shared_ptr<ColumnBundle> rotWork; //!< scratch space for rotating gradients (reused across states and iterations)
 	
 	bool rotExists; //!< whether rotPrev is non-trivial (not identity)
+	double Eprev, dEprev; //!< energy and energy change at previous compute() calls (for adaptive inner fluid tolerances)
 	std::shared_ptr<struct SubspaceRotationAdjust> sra; //!< Subspace rotation adjustment helper
+	FftPrecisionSwitch fftPrecision; //!< single to double precision FFT switching for this minimization
 };
 
 void bandMinimize(Everything& e, bool updateVxx=true); //!< band structure minimization. Update ACE representation of exact exchange operator Vxx if updateVxx = true.
@@ -23,10 +23,12 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/ColumnBundle.h>
 #include <electronic/ExCorr.h>
 #include <electronic/ExactExchange.h>
+#include <electronic/Checkpoint.h>
 #include <fluid/FluidSolver.h>
 #include <core/matrix.h>
 #include <core/Units.h>
 #include <core/ScalarFieldIO.h>
+#include <core/TaskGraph.h>
 #include <cstdio>
 #include <cmath>
 #include <limits.h>
@@ -54,7 +56,12 @@ void applyBoxPot(int i, vector3<> r, matrix3<>& R, const ElecVars::BoxPotential*
 
 //Helper function to read density (or potential) array
 void readDensityArray(ScalarFieldArray& var, string varName, string fnamePattern, const Everything* e)
-{
+{	if(Checkpoint::isCheckpointFile(fnamePattern))
+	{	logPrintf("Reading %s from checkpoint '%s' ... ", varName.c_str(), fnamePattern.c_str()); logFlush();
+		Checkpoint::read(*e, fnamePattern, varName, var);
+		logPrintf("done\n"); logFlush();
+		return;
+	}
 	#define READchannel(var, suffix) \
 	{	string fname = fnamePattern; \
 		size_t pos = fname.find("$VAR"); \
@@ -146,7 +153,9 @@ void ElecVars::setup(const Everything &everything)
 	if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub)
 		Haux_eigs.resize(eInfo.nStates);
 	if(eigsFilename.length())
-	{	eInfo.read(Hsub_eigs, eigsFilename.c_str());
+	{	if(Checkpoint::isCheckpointFile(eigsFilename))
+			Checkpoint::read(*e, eigsFilename, "eigenvals", Hsub_eigs, eInfo.nBands);
+		else eInfo.read(Hsub_eigs, eigsFilename.c_str());
 		if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub)
 		{	Haux_eigs = Hsub_eigs;
 			HauxInitialized = true;
@@ -156,16 +165,22 @@ void ElecVars::setup(const Everything &everything)
 	
 	//Read in electron (spin) density if needed
 	if(e->cntrl.fixed_H)
-	{	string fnamePattern = nFilenamePattern.length() ? nFilenamePattern : VFilenamePattern; //Command ensures that the pattern has a "$VAR" in it
+	{	string fnamePattern = nFilenamePattern.length() ? nFilenamePattern : VFilenamePattern; //Command ensures that the pattern has a "$VAR" in it, or is a checkpoint
 		#define READrhoAtom(var) \
-		{	string fname = fnamePattern; \
-			size_t pos = fname.find("$VAR"); \
-			assert(pos != string::npos); \
-			fname.replace(pos,4, #var); \
-			logPrintf("Reading " #var " from file '%s' ... ", fname.c_str()); logFlush(); \
-			FILE* fp = fopen(fname.c_str(), "r"); \
-			for(matrix& m: var) m.read(fp); \
-			fclose(fp); \
+		{	if(Checkpoint::isCheckpointFile(fnamePattern)) \
+			{	logPrintf("Reading " #var " from checkpoint '%s' ... ", fnamePattern.c_str()); logFlush(); \
+				Checkpoint::read(*e, fnamePattern, #var, var); \
+			} \
+			else \
+			{	string fname = fnamePattern; \
+				size_t pos = fname.find("$VAR"); \
+				assert(pos != string::npos); \
+				fname.replace(pos,4, #var); \
+				logPrintf("Reading " #var " from file '%s' ... ", fname.c_str()); logFlush(); \
+				FILE* fp = fopen(fname.c_str(), "r"); \
+				for(matrix& m: var) m.read(fp); \
+				fclose(fp); \
+			} \
 			logPrintf("done\n"); logFlush(); \
 		}
 		if(nFilenamePattern.length())
@@ -182,9 +197,15 @@ void ElecVars::setup(const Everything &everything)
 	}
 	
 	//Wavefunction initialiation (bypass in dry runs and phonon supercell calculations)
-	if(skipWfnsInit)
+	if(e->cntrl.bandStreaming)
+	{	if(!e->cntrl.fixed_H) die("\nband-streaming requires fix-electron-density or fix-electron-potential.\n\n");
+		if(e->exCorr.exxFactor()) die("\nband-streaming is not supported with exact exchange (which needs all wavefunctions at once).\n\n");
+		if(wfnsFilename.length()) die("\nband-streaming initializes wavefunctions state by state, and cannot read them in.\n\n");
+	}
+	if(skipWfnsInit || e->cntrl.bandStreaming)
 	{	C.resize(eInfo.nStates); //skip memory allocation, but initialize array
-		logPrintf("Skipped wave function initialization.\n");
+		if(skipWfnsInit) logPrintf("Skipped wave function initialization.\n");
+		else logPrintf("Wave functions will be initialized state by state during band-streaming.\n");
 	}
 	else
 	{
@@ -196,9 +217,13 @@ void ElecVars::setup(const Everything &everything)
 		int nBandsInited = 0;
 		if(wfnsFilename.length())
 		{	logPrintf("reading from '%s'\n", wfnsFilename.c_str()); logFlush();
-			if(readConversion) readConversion->Ecut = e->cntrl.Ecut;
-			eInfo.read(C, wfnsFilename.c_str(), readConversion.get());
-			nBandsInited = (readConversion && readConversion->nBandsOld) ? readConversion->nBandsOld : eInfo.nBands;
+			if(Checkpoint::isCheckpointFile(wfnsFilename))
+				nBandsInited = Checkpoint::read(*e, wfnsFilename, C);
+			else
+			{	if(readConversion) readConversion->Ecut = e->cntrl.Ecut;
+				eInfo.read(C, wfnsFilename.c_str(), readConversion.get());
+				nBandsInited = (readConversion && readConversion->nBandsOld) ? readConversion->nBandsOld : eInfo.nBands;
+			}
 			isRandom = false;
 		}
 		else if(initLCAO)
@@ -242,7 +267,9 @@ void ElecVars::setup(const Everything &everything)
 		if(!fluidSolver) die("Failed to create fluid solver.\n");
 		if(fluidInitialStateFilename.length())
 		{	logPrintf("Reading fluid state from '%s'\n", fluidInitialStateFilename.c_str()); logFlush();
-			fluidSolver->loadState(fluidInitialStateFilename.c_str());
+			if(Checkpoint::isCheckpointFile(fluidInitialStateFilename))
+				Checkpoint::read(*e, fluidInitialStateFilename, *fluidSolver);
+			else fluidSolver->loadState(fluidInitialStateFilename.c_str());
 		}
 	}
 	
@@ -278,29 +305,36 @@ void ElecVars::EdensityAndVscloc(Energies& ener, const ExCorr* alternateExCorr)
 	const IonInfo& iInfo = e->iInfo;
 	
 	ScalarFieldTilde nTilde = J(get_nTot());
+	const ExCorr& exCorr = alternateExCorr ? *alternateExCorr : e->exCorr;
+	if(not (exCorr.hasEnergy() or e->cntrl.scf or e->cntrl.fixed_H))
+		die("Potential functionals do not support total-energy minimization; use SCF or fixed-H calculations instead.\n")
 	
-	// Local part of pseudopotential:
-	ener.E["Eloc"] = dot(nTilde, O(iInfo.Vlocps));
-	ScalarFieldTilde VsclocTilde = clone(iInfo.Vlocps);
+	//Independent terms below run as tasks (concurrently when possible, see TaskGraph),
+	//each writing only its own results, which are combined into ener and Vscloc afterwards:
+	TaskGraph graph;
 	
-	// Hartree term:
-	ScalarFieldTilde dH = (*e->coulomb)(nTilde); //Note: external charge and nuclear charge contribute to d_vac as well (see below)
-	ener.E["EH"] = 0.5*dot(nTilde, O(dH));
-	VsclocTilde += dH;
+	// Local part of pseudopotential and Hartree term:
+	double Eloc = 0., EH = 0.;
+	ScalarFieldTilde dH; //Note: external charge and nuclear charge contribute to d_vac as well (see below)
+	graph.add([&]()
+	{	Eloc = dot(nTilde, O(iInfo.Vlocps));
+		dH = (*e->coulomb)(nTilde);
+		EH = 0.5*dot(nTilde, O(dH));
+	});
 
 	// External charge:
-	ener.E["Eexternal"] = 0.;
-	if(rhoExternal)
-	{	ScalarFieldTilde phiExternal = (*e->coulomb)(rhoExternal);
-		ener.E["Eexternal"] += dot(nTilde + iInfo.rhoIon, O(phiExternal));
+	double Eexternal = 0.;
+	ScalarFieldTilde phiExternal;
+	if(rhoExternal) graph.add([&]()
+	{	phiExternal = (*e->coulomb)(rhoExternal);
+		Eexternal += dot(nTilde + iInfo.rhoIon, O(phiExternal));
 		if(rhoExternalSelfEnergy)
-			ener.E["Eexternal"] += 0.5 * dot(rhoExternal, O(phiExternal));
-		VsclocTilde += phiExternal;
-	}
+			Eexternal += 0.5 * dot(rhoExternal, O(phiExternal));
+	});
 	
 	//Fluid contributions
-	ScalarFieldTilde VtauTilde;
-	if(fluidParams.fluidType != FluidNone)
+	double Adiel = 0., MuShift = 0., fluidGzero = 0.;
+	if(fluidParams.fluidType != FluidNone) graph.add([&]()
 	{	//Compute n considered for cavity formation (i.e-> include chargeball and partial cores)
 		ScalarFieldTilde nCavityTilde = clone(nTilde);
 		if(iInfo.nCore) nCavityTilde += J(iInfo.nCore);
@@ -312,29 +346,50 @@ void ElecVars::EdensityAndVscloc(Energies& ener, const ExCorr* alternateExCorr)
 		// If the fluid doesn't have a gummel loop, minimize it each time:
 		if(!fluidSolver->useGummel()) fluidSolver->minimizeFluid();
 		
-		// Compute the energy and accumulate gradients:
-		ener.E["A_diel"] = fluidSolver->get_Adiel_and_grad(&d_fluid, &V_cavity);
-		VsclocTilde += d_fluid;
-		VsclocTilde += V_cavity;
+		// Compute the energy and gradients:
+		Adiel = fluidSolver->get_Adiel_and_grad(&d_fluid, &V_cavity);
 
 		//Chemical-potential correction due to potential of electron in bulk fluid
 		double bulkPotential = fluidSolver->bulkPotential();
 		//Chemical-potential correction due to finite nuclear width in fluid interaction:
 		double muCorrection = fluidSolver->ionWidthMuCorrection();
-		ener.E["MuShift"] = (eInfo.nElectrons - iInfo.getZtot()) * (muCorrection - bulkPotential);
-		VsclocTilde->setGzero(muCorrection - bulkPotential + VsclocTilde->getGzero());
-	}
+		MuShift = (eInfo.nElectrons - iInfo.getZtot()) * (muCorrection - bulkPotential);
+		fluidGzero = muCorrection - bulkPotential;
+	}, std::vector<int>(), !fluidSolver->useGummel()); //minimizeFluid() logs its iterations
 
 	//Atomic density-matrix contributions: (DFT+U)
-	if(eInfo.hasU)
-		ener.E["U"] = iInfo.rhoAtom_computeU(rhoAtom, U_rhoAtom);
+	double Eu = 0.;
+	if(eInfo.hasU) graph.add([&]()
+	{	Eu = iInfo.rhoAtom_computeU(rhoAtom, U_rhoAtom);
+	});
 	
-	// Exchange and correlation, and store the real space Vscloc with the odd historic normalization factor of JdagOJ:
-	const ExCorr& exCorr = alternateExCorr ? *alternateExCorr : e->exCorr;
-	ener.E["Exc"] = exCorr(get_nXC(), &Vxc, false, &tau, &Vtau);
+	// Exchange and correlation:
+	double Exc = 0.;
+	graph.add([&]()
+	{	Exc = exCorr(get_nXC(), &Vxc, false, &tau, &Vtau);
+	});
 	
-	if(not (exCorr.hasEnergy() or e->cntrl.scf or e->cntrl.fixed_H))
-		die("Potential functionals do not support total-energy minimization; use SCF or fixed-H calculations instead.\n")
+	graph.run();
+	
+	//Combine results:
+	ener.E["Eloc"] = Eloc;
+	ener.E["EH"] = EH;
+	ener.E["Eexternal"] = Eexternal;
+	ScalarFieldTilde VsclocTilde = clone(iInfo.Vlocps);
+	VsclocTilde += dH;
+	if(phiExternal) VsclocTilde += phiExternal;
+	ScalarFieldTilde VtauTilde;
+	if(fluidParams.fluidType != FluidNone)
+	{	ener.E["A_diel"] = Adiel;
+		VsclocTilde += d_fluid;
+		VsclocTilde += V_cavity;
+		ener.E["MuShift"] = MuShift;
+		VsclocTilde->setGzero(fluidGzero + VsclocTilde->getGzero());
+	}
+	if(eInfo.hasU) ener.E["U"] = Eu;
+	
+	//Store the real space Vscloc with the odd historic normalization factor of JdagOJ:
+	ener.E["Exc"] = Exc;
 	if(exCorr.orbitalDep)
 	{	if(!e->cntrl.scf)
 		{	if(e->cntrl.fixed_H) die("Orbital-dependent potential functionals do not support fix-density; use fix-potential instead.\n")
@@ -410,20 +465,37 @@ double ElecVars::elecEnergyAndGrad(Energies& ener, ElecGradient* grad, ElecGradi
 	//Do the single-particle contributions one state at a time to save memory (and for better cache warmth):
 	ener.E["KE"] = 0.;
 	ener.E["Enl"] = 0.;
+	bool batchLocal = need_Hsub && e->cntrl.kpointBatchSize>1 && Vscloc.size()<=2; //apply Vscloc to several states at once
 	for(int q=eInfo.qStart; q<e->eInfo.qStop; q++)
-	{	double KEq = applyHamiltonian(q, F[q], HC[q], ener, need_Hsub);
+	{	if(batchLocal && (q-eInfo.qStart) % e->cntrl.kpointBatchSize == 0)
+		{	std::vector<const ColumnBundle*> Cbatch; std::vector<ColumnBundle*> HCbatch;
+			for(int q2=q; q2<std::min(q+e->cntrl.kpointBatchSize, eInfo.qStop); q2++)
+			{	Cbatch.push_back(&C[q2]);
+				HCbatch.push_back(&HC[q2]);
+			}
+			Idag_DiagV_I_accum(Cbatch, Vscloc, HCbatch);
+		}
+		double KEq = applyHamiltonian(q, F[q], HC[q], ener, need_Hsub, false, !batchLocal); //Hsub diagonalized below
 		if(grad) //Calculate wavefunction gradients:
 		{	const QuantumNumber& qnum = eInfo.qnums[q];
 			HC[q] -= O(C[q]) * Hsub[q]; //Include orthonormality contribution
-			grad->C[q] = HC[q] * (F[q]*qnum.weight);
+			cloneInto(HC[q], grad->C[q]); grad->C[q] *= (F[q]*qnum.weight); //reuses storage from previous gradient
 			if(Kgrad)
 			{	double Nq = qnum.weight*trace(F[q]);
 				double KErollover = 2. * (Nq>1e-3 ? KEq/Nq : 1.);
 				precond_inv_kinetic(HC[q], KErollover); //apply preconditioner
 				std::swap(Kgrad->C[q], HC[q]); //this frees HC[q]
+				Kgrad->C[q].evict();
 			}
+			grad->C[q].evict();
 		}
+		C[q].evict(); //move out of device memory till next use (if enabled by wavefunction-residency)
+	}
+	if(need_Hsub and eInfo.mpiBand) //subspace diagonalization of each state distributed over its band group
+	{	int q = eInfo.qBand;
+		Hsub[q].diagonalize(Hsub_evecs[q], Hsub_eigs[q], eInfo.mpiBand.get(), eInfo.mpiBand->nProcesses()-1);
 	}
+	else if(need_Hsub) diagonalize(Hsub, Hsub_evecs, Hsub_eigs); //subspace diagonalization of all states together (batched)
 	mpiWorld->allReduce(ener.E["KE"], MPIUtil::ReduceSum);
 	mpiWorld->allReduce(ener.E["Enl"], MPIUtil::ReduceSum);
 	
@@ -578,36 +650,162 @@ void fixPhase(matrix& evecs, const diagMatrix& eigs, const ColumnBundle& C)
 	evecs = evecs*phaseFix;
 }
 
+diagMatrix ElecVars::bandResidualScale(int q, int nBands) const
+{	diagMatrix scale(nBands, 1.);
+	const Control& cntrl = e->cntrl;
+	if(!(cntrl.scf and cntrl.partialBandThreshold)) return scale;
+	const diagMatrix& Fq = F[q];
+	for(int b=0; b<nBands; b++)
+		if(b >= Fq.nRows() or Fq[b] < cntrl.partialBandThreshold) //extra working bands count as empty
+			scale[b] = cntrl.partialBandTolScale;
+	return scale;
+}
+
 void ElecVars::setEigenvectors()
 {	const ElecInfo& eInfo = e->eInfo;
 	logPrintf("Setting wave functions to eigenvectors of Hamiltonian\n"); logFlush();
 	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-	{
-		fixPhase(Hsub_evecs[q], Hsub_eigs[q], C[q]);
-		C[q] = C[q] * Hsub_evecs[q];
-		for(matrix& VdagCq_sp: VdagC[q])
-			if(VdagCq_sp) VdagCq_sp = VdagCq_sp * Hsub_evecs[q];
-		
-		if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub && !e->cntrl.scf)
-			Haux_eigs[q] = Hsub_eigs[q];
-		
-		//Apply corresponding changes to Hsub:
-		Hsub[q] = Hsub_eigs[q]; //now diagonal
-		Hsub_evecs[q] = eye(eInfo.nBands);
+		if(C[q]) setEigenvectors(q); //skip states already freed by band-streaming
+}
+
+void ElecVars::setEigenvectors(int q)
+{	static const int phaseId = Profiler::registerName("SubspaceLinalg"); ProfilePhase phase(phaseId);
+	const ElecInfo& eInfo = e->eInfo;
+	fixPhase(Hsub_evecs[q], Hsub_eigs[q], C[q]);
+	C[q] = C[q] * Hsub_evecs[q];
+	for(matrix& VdagCq_sp: VdagC[q])
+		if(VdagCq_sp) VdagCq_sp = VdagCq_sp * Hsub_evecs[q];
+	
+	if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub && !e->cntrl.scf)
+		Haux_eigs[q] = Hsub_eigs[q];
+	
+	//Apply corresponding changes to Hsub:
+	Hsub[q] = Hsub_eigs[q]; //now diagonal
+	Hsub_evecs[q] = eye(eInfo.nBands);
+}
+
+void ElecVars::initStreamedWavefunctions(int q)
+{	const ElecInfo& eInfo = e->eInfo;
+	int nAtomic = e->iInfo.nAtomicOrbitals();
+	if(initLCAO && nAtomic)
+	{	//Lowest eigenvectors of the Hamiltonian in the atomic-orbital subspace (padded with random columns if needed):
+		int nCols = std::max(nAtomic, eInfo.nBands);
+		C[q] = e->iInfo.getAtomicOrbitals(q, false, nCols-nAtomic);
+		if(nCols > nAtomic) C[q].randomize(nAtomic, nCols);
+		orthonormalize(q);
+		ColumnBundle HCq; Energies ener;
+		applyHamiltonian(q, diagMatrix(nCols, 0.), HCq, ener, true);
+		C[q] = C[q] * Hsub_evecs[q](0,nCols, 0,eInfo.nBands);
 	}
+	else
+	{	C[q].init(eInfo.nBands, e->basis[q].nbasis * eInfo.spinorLength(), &e->basis[q], &eInfo.qnums[q], isGpuEnabled());
+		C[q].randomize(0, eInfo.nBands);
+	}
+	orthonormalize(q);
+}
+
+//Sum partial densities over processes and symmetrize them, using nonblocking reductions per spin channel:
+//start(s) launches the reductions of channels up to s as soon as their local contributions are complete,
+//and finish() symmetrizes each collinear channel as soon as it arrives, while later ones are still in flight.
+//With device collectives, all channels are instead reduced together on the GPU in one collective.
+class DensityReduction
+{	ScalarFieldArray& x;
+	const GridInfo& gInfo;
+	const Symmetries& symm;
+	bool packed; //whether to reduce all channels together in finish() (device collectives)
+	std::vector<MPIUtil::Request> requests; //one per started channel, if more than one process
+	unsigned nStarted; //number of channels whose reduction has been started
+public:
+	DensityReduction(ScalarFieldArray& x, const GridInfo& gInfo, const Symmetries& symm)
+	: x(x), gInfo(gInfo), symm(symm), packed(isGpuEnabled() and MPIUtil::deviceCollectives()), nStarted(0)
+	{	requests.reserve(x.size()); //keeps request addresses fixed while in flight
+	}
+	
+	//Start the reductions of all channels up to and including s (default: all channels);
+	//channels are always started in order so that the collectives match on all processes
+	void start(int s=-1)
+	{	if(packed) return;
+		unsigned sStop = (s<0) ? x.size() : s+1;
+		for(; nStarted<sStop; nStarted++)
+		{	ScalarField& xs = x[nStarted];
+			nullToZero(xs, gInfo);
+			if(mpiWorld->nProcesses() > 1)
+			{	requests.push_back(MPIUtil::Request());
+				xs->allReduceData(mpiWorld, MPIUtil::ReduceSum, false, &requests.back());
+			}
+		}
+	}
+	
+	//Complete all reductions and symmetrize:
+	void finish()
+	{	if(packed)
+		{	nullToZero(x, gInfo);
+			allReduceDataPacked(x, mpiWorld, MPIUtil::ReduceSum);
+			symm.symmetrize(x);
+			return;
+		}
+		start();
+		if(x.size() > 2) //vector-spin: channels are symmetrized together
+		{	if(requests.size()) MPIUtil::waitAll(requests);
+			symm.symmetrize(x);
+			return;
+		}
+		for(unsigned s=0; s<x.size(); s++)
+		{	if(requests.size()) MPIUtil::wait(requests[s]);
+			symm.symmetrize(x[s]);
+		}
+	}
+};
+
+//Whether channel s of a collinear spin-polarized density (nDensities=2) is complete on this process after
+//adding the contribution of state q, so that its reduction can start early (states are ordered by spin):
+inline bool spinChannelDone(const ElecInfo& eInfo, int q, int nDensities)
+{	return nDensities==2 and (q+1==eInfo.qStop or eInfo.qnums[q+1].index()!=eInfo.qnums[q].index());
+}
+
+//Get the fillings and wavefunctions of the bands of state eInfo.qBand handled by the current process
+//within band group eInfo.mpiBand (the state owner broadcasts the full state to the group).
+//The band count is taken from the owner, so that this also works with extra bands (eg. during LCAO).
+void getBandSlice(const ElecInfo& eInfo, const std::vector<Basis>& basis,
+	const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, diagMatrix& Fsub, ColumnBundle& Csub, ColumnBundle* Cfull)
+{	static StopWatch watch("getBandSlice"); watch.start();
+	const MPIUtil* mpiBand = eInfo.mpiBand.get();
+	int q = eInfo.qBand, iOwner = mpiBand->nProcesses()-1;
+	bool mine = eInfo.isMine(q);
+	int nBandsq = mine ? C[q].nCols() : 0;
+	mpiBand->bcast(nBandsq, iOwner);
+	diagMatrix Fq = mine ? F[q] : diagMatrix(nBandsq);
+	mpiBand->bcastData(Fq, iOwner);
+	ColumnBundle Cbuf;
+	if(!mine) Cbuf.init(nBandsq, basis[q].nbasis * eInfo.spinorLength(), &basis[q], &eInfo.qnums[q], isGpuEnabled());
+	const ColumnBundle& Cq = mine ? C[q] : Cbuf;
+	mpiBand->bcastData((ManagedMemory<complex>&)Cq, iOwner); //not modified on the owner (root)
+	int bStart, bStop;
+	TaskDivision(Cq.nCols(), mpiBand).myRange(bStart, bStop);
+	Fsub = Fq(bStart, bStop);
+	Csub = Cq.getSub(bStart, bStop);
+	if(Cfull) *Cfull = Cq;
+	watch.stop();
 }
 
 ScalarFieldArray ElecVars::KEdensity() const
 {	ScalarFieldArray tau(n.size());
+	DensityReduction reduction(tau, e->gInfo, e->symm);
 	//Compute KE density from valence electrons:
-	for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
-		for(int iDir=0; iDir<3; iDir++)
+	if(e->eInfo.mpiBand)
+	{	diagMatrix Fsub; ColumnBundle Csub;
+		getBandSlice(e->eInfo, e->basis, F, C, Fsub, Csub);
+		if(Fsub.size())
+			for(int iDir=0; iDir<3; iDir++)
+				tau += (0.5*Csub.qnum->weight) * diagouterI(Fsub, D(Csub,iDir), tau.size(), &e->gInfo);
+	}
+	else for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
+	{	for(int iDir=0; iDir<3; iDir++)
 			tau += (0.5*C[q].qnum->weight) * diagouterI(F[q], D(C[q],iDir), tau.size(), &e->gInfo);
-	for(ScalarField& tau_s: tau)
-	{	nullToZero(tau_s, e->gInfo);
-		tau_s->allReduceData(mpiWorld, MPIUtil::ReduceSum);
+		C[q].evict();
+		if(spinChannelDone(e->eInfo, q, tau.size())) reduction.start(C[q].qnum->index()); //overlap with remaining states
 	}
-	e->symm.symmetrize(tau); //Symmetrize
+	reduction.finish(); //sum over processes and symmetrize
 	//Add core KE density model:
 	if(e->iInfo.tauCore)
 	{	int nSpins = std::min(2, int(tau.size())); //don't add to Re/Im(UpDn) in vector-spin mode
@@ -618,40 +816,134 @@ ScalarFieldArray ElecVars::KEdensity() const
 }
 
 ScalarFieldArray ElecVars::calcDensity() const
-{	ScalarFieldArray density(n.size());
+{	static const int phaseId = Profiler::registerName("DensityBuild"); ProfilePhase phase(phaseId);
+	ScalarFieldArray density(n.size());
+	DensityReduction reduction(density, e->gInfo, e->symm);
+	//Ultrasoft augmentation is added to all channels after the loop (split over processes), so reduce early only without it:
+	bool earlyStart = !e->eInfo.mpiBand;
+	for(const auto& sp: e->iInfo.species) if(sp->isUltrasoft()) earlyStart = false;
+	//Accumulate the orbital-dependent potential's weighted densities in the same transforms, if supported
+	//(not with ultrasoft augmentation, which accumulates one density at a time, or band parallelization):
+	const ExCorr::OrbitalDep* orbitalDep = e->exCorr.orbitalDep.get();
+	bool accumOrbitalDep = orbitalDep && earlyStart && orbitalDep->initDensityWeights(); //earlyStart excludes both cases
+	ScalarFieldArray Vorbital(accumOrbitalDep ? n.size() : 0);
 	//Runs over all states and accumulates density to the corresponding spin channel of the total density
 	e->iInfo.augmentDensityInit();
 	for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
-	{	density += e->eInfo.qnums[q].weight * diagouterI(F[q], C[q], density.size(), &e->gInfo);
+	{	if(accumOrbitalDep)
+		{	std::vector<const diagMatrix*> weights = { &F[q], &orbitalDep->densityWeights(q) };
+			std::vector<ScalarFieldArray> densities = diagouterI(weights, C[q], density.size(), &e->gInfo);
+			density += e->eInfo.qnums[q].weight * densities[0];
+			Vorbital += e->eInfo.qnums[q].weight * densities[1];
+			C[q].evict();
+		}
+		else if(!e->eInfo.mpiBand) { density += e->eInfo.qnums[q].weight * diagouterI(F[q], C[q], density.size(), &e->gInfo); C[q].evict(); }
 		e->iInfo.augmentDensitySpherical(e->eInfo.qnums[q], F[q], VdagC[q]); //pseudopotential contribution
+		if(earlyStart and spinChannelDone(e->eInfo, q, density.size())) reduction.start(e->eInfo.qnums[q].index()); //overlap with remaining states
 	}
-	e->iInfo.augmentDensityGrid(density);
-	for(ScalarField& ns: density)
-	{	nullToZero(ns, e->gInfo);
-		ns->allReduceData(mpiWorld, MPIUtil::ReduceSum);
+	if(e->eInfo.mpiBand) //band-parallel contribution of the shared state (summed over processes below)
+	{	diagMatrix Fsub; ColumnBundle Csub;
+		getBandSlice(e->eInfo, e->basis, F, C, Fsub, Csub);
+		if(Fsub.size()) density += Csub.qnum->weight * diagouterI(Fsub, Csub, density.size(), &e->gInfo);
 	}
-	e->symm.symmetrize(density);
+	e->iInfo.augmentDensityGrid(density);
+	reduction.finish(); //sum over processes and symmetrize
+	if(accumOrbitalDep) orbitalDep->setAccumulated(Vorbital);
 	return density;
 }
 
-void ElecVars::orthonormalize(int q, matrix* extraRotation)
-{	assert(e->eInfo.isMine(q));
+std::vector<ScalarFieldArray> ElecVars::calcDensities(const std::vector<std::vector<diagMatrix>>& Fsets) const
+{	static StopWatch watch("calcDensities"); watch.start();
+	int nSets = Fsets.size();
+	std::vector<ScalarFieldArray> densities(nSets, ScalarFieldArray(n.size()));
+	std::vector<const diagMatrix*> weights(nSets);
+	//Transform each state once, scattering into all sets of fillings together:
+	if(!e->eInfo.mpiBand)
+	{	for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
+		{	for(int s=0; s<nSets; s++) weights[s] = &Fsets[s][q];
+			std::vector<ScalarFieldArray> densities_q = diagouterI(weights, C[q], n.size(), &e->gInfo);
+			for(int s=0; s<nSets; s++) densities[s] += e->eInfo.qnums[q].weight * densities_q[s];
+			C[q].evict();
+		}
+	}
+	else //band-parallel contribution of the shared state (summed over processes below)
+	{	const MPIUtil* mpiBand = e->eInfo.mpiBand.get();
+		int q = e->eInfo.qBand, iOwner = mpiBand->nProcesses()-1;
+		std::vector<diagMatrix> Fsub(nSets); ColumnBundle Csub, Cfull;
+		getBandSlice(e->eInfo, e->basis, Fsets[0], C, Fsub[0], Csub, &Cfull);
+		int bStart, bStop;
+		TaskDivision(Cfull.nCols(), mpiBand).myRange(bStart, bStop);
+		for(int s=1; s<nSets; s++) //remaining fillings from the state owner (wavefunctions already shared above)
+		{	diagMatrix Fq = e->eInfo.isMine(q) ? Fsets[s][q] : diagMatrix(Cfull.nCols());
+			mpiBand->bcastData(Fq, iOwner);
+			Fsub[s] = Fq(bStart, bStop);
+		}
+		for(int s=0; s<nSets; s++) weights[s] = &Fsub[s];
+		if(Csub.nCols())
+		{	std::vector<ScalarFieldArray> densities_q = diagouterI(weights, Csub, n.size(), &e->gInfo);
+			for(int s=0; s<nSets; s++) densities[s] += Csub.qnum->weight * densities_q[s];
+		}
+	}
+	//Ultrasoft augmentation (no wavefunction transforms) and reduction, one set at a time:
+	for(int s=0; s<nSets; s++)
+	{	e->iInfo.augmentDensityInit();
+		for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
+			e->iInfo.augmentDensitySpherical(e->eInfo.qnums[q], Fsets[s][q], VdagC[q]);
+		e->iInfo.augmentDensityGrid(densities[s]);
+		DensityReduction(densities[s], e->gInfo, e->symm).finish(); //sum over processes and symmetrize
+	}
+	watch.stop();
+	return densities;
+}
+
+void ElecVars::orthonormalize(int q, matrix* extraRotation, bool gaugeFree)
+{	static const int phaseId = Profiler::registerName("SubspaceLinalg"); ProfilePhase phase(phaseId);
+	assert(e->eInfo.isMine(q));
 	VdagC[q].clear();
+	if(gaugeFree && e->cntrl.subspaceOrtho==SubspaceOrthoCholesky)
+	{	assert(!extraRotation);
+		//Cholesky-QR, with a second pass (CholQR2) if the overlap was too ill-conditioned for one:
+		for(int pass=0; pass<2; pass++)
+		{	bool isSingular = false;
+			matrix rot = invCholesky(C[q]^O(C[q], &VdagC[q]), &isSingular);
+			if(isSingular) { VdagC[q].clear(); break; } //nearly linearly dependent: symmetric orthonormalization below
+			C[q] = C[q] * rot;
+			e->iInfo.project(C[q], VdagC[q], &rot); //update the atomic projections
+			//Condition number of overlap estimated from the diagonal of its Cholesky factor (inverse of that of rot):
+			diagMatrix rotDiag = diag(rot);
+			double condEst = std::pow(*std::max_element(rotDiag.begin(), rotDiag.end()) / *std::min_element(rotDiag.begin(), rotDiag.end()), 2);
+			if(condEst < 1e4 || pass) return;
+			VdagC[q].clear();
+		}
+	}
 	matrix rot = invsqrt(C[q]^O(C[q], &VdagC[q])); //Compute U:
 	if(extraRotation) *extraRotation = (rot = rot * (*extraRotation)); //set rot and extraRotation to the net transformation
 	C[q] = C[q] * rot;
 	e->iInfo.project(C[q], VdagC[q], &rot); //update the atomic projections
 }
 
-double ElecVars::applyHamiltonian(int q, const diagMatrix& Fq, ColumnBundle& HCq, Energies& ener, bool need_Hsub)
-{	assert(C[q]); //make sure wavefunction is available for this state
+matrix ElecVars::orthoMatrix(const matrix& S, bool* isSingular) const
+{	if(e->cntrl.subspaceOrtho==SubspaceOrthoCholesky)
+	{	bool isSingularChol = false;
+		matrix U = invCholesky(S, &isSingularChol);
+		if(!isSingularChol)
+		{	if(isSingular) *isSingular = false;
+			return U;
+		}
+	}
+	return invsqrt(S, 0, 0, isSingular);
+}
+
+double ElecVars::applyHamiltonian(int q, const diagMatrix& Fq, ColumnBundle& HCq, Energies& ener, bool need_Hsub, bool diagonalizeHsub, bool includeVscloc)
+{	static const int phaseId = Profiler::registerName("Hamiltonian"); ProfilePhase phase(phaseId);
+	assert(C[q]); //make sure wavefunction is available for this state
 	const QuantumNumber& qnum = e->eInfo.qnums[q];
-	std::vector<matrix> HVdagCq(e->iInfo.species.size());
+	const std::vector< std::shared_ptr<SpeciesInfo> >& species = e->iInfo.species;
+	std::vector<matrix> HVdagCq(species.size());
 	
-	//Propagate grad_n (Vscloc) to HCq (which is grad_Cq upto weights and fillings) if required
+	//Terms that act on the whole bundle at once:
 	if(need_Hsub)
-	{	HCq += Idag_DiagV_I(C[q], Vscloc); //Accumulate Idag Diag(Vscloc) I C
-		e->iInfo.augmentDensitySphericalGrad(qnum, VdagC[q], HVdagCq); //Contribution via pseudopotential density augmentation
+	{	e->iInfo.augmentDensitySphericalGrad(qnum, VdagC[q], HVdagCq); //Contribution via pseudopotential density augmentation
 		if(e->exCorr.needsKEdensity() && Vtau[qnum.index()]) //Contribution via orbital KE:
 		{	for(int iDir=0; iDir<3; iDir++)
 				HCq -= (0.5*e->gInfo.dV) * D(Idag_DiagV_I(D(C[q],iDir), Vtau), iDir);
@@ -667,23 +959,43 @@ double ElecVars::applyHamiltonian(int q, const diagMatrix& Fq, ColumnBundle& HCq
 			e->exx->applyHamiltonian(aXX, omega, q, Fq, C[q], HCq);
 		}
 	}
-
-	//Kinetic energy:
-	double KEq;
-	{	ColumnBundle LCq = L(C[q]);
-		if(HCq) HCq += (-0.5) * LCq;
-		KEq = qnum.weight * (-0.5) * traceinner(Fq, C[q], LCq).real();
-		ener.E["KE"] += KEq;
-	}
 	
-	//Nonlocal pseudopotentials:
+	//Nonlocal pseudopotential energy and its gradient w.r.t projections:
 	ener.E["Enl"] += qnum.weight * e->iInfo.EnlAndGrad(qnum, Fq, VdagC[q], HVdagCq);
-	if(HCq) e->iInfo.projectGrad(HVdagCq, C[q], HCq);
+	
+	//Local potential, kinetic and nonlocal projection terms, pipelined over blocks of bands
+	//(keeps each block of HCq in cache across the terms; whole bundle at once if hamiltonianBlockSize is 0):
+	int nCols = C[q].nCols();
+	int blockSize = e->cntrl.hamiltonianBlockSize ? std::min(e->cntrl.hamiltonianBlockSize, nCols) : nCols;
+	std::vector< std::shared_ptr<ColumnBundle> > V(species.size()); //projectors, computed once for all blocks
+	if(HCq || need_Hsub)
+		for(unsigned sp=0; sp<species.size(); sp++)
+			if(HVdagCq[sp]) V[sp] = species[sp]->getV(C[q]);
+	double KEq = 0.;
+	if(need_Hsub && !HCq) { HCq = C[q].similar(); HCq.zero(); }
+	for(int colStart=0; colStart<nCols; colStart+=blockSize)
+	{	int colStop = std::min(colStart+blockSize, nCols);
+		ColumnBundleView Cb(C[q], colStart, colStop); //operate in-place on the blocks of C[q] and HCq
+		//Propagate grad_n (Vscloc) to HCq (which is grad_Cq upto weights and fillings) if required
+		if(need_Hsub && includeVscloc) Idag_DiagV_I_accum(Cb, Vscloc, HCq); //Accumulate Idag Diag(Vscloc) I C
+		//Kinetic energy:
+		{	ColumnBundle LCb = L(Cb);
+			if(HCq) ColumnBundleView(HCq, colStart, colStop) += (-0.5) * LCb;
+			KEq += qnum.weight * (-0.5) * traceinner(Fq(colStart,colStop), Cb, LCb).real();
+		}
+		//Nonlocal pseudopotentials:
+		if(HCq)
+		{	ColumnBundleView HCb(HCq, colStart, colStop);
+			for(unsigned sp=0; sp<species.size(); sp++)
+				if(V[sp]) HCb += (*V[sp]) * (colStop-colStart==nCols ? HVdagCq[sp] : matrix(HVdagCq[sp](0,HVdagCq[sp].nRows(), colStart,colStop)));
+		}
+	}
+	ener.E["KE"] += KEq;
 	
 	//Compute subspace hamiltonian if needed:
 	if(need_Hsub)
 	{	Hsub[q] = C[q] ^ HCq;
-		Hsub[q].diagonalize(Hsub_evecs[q], Hsub_eigs[q]);
+		if(diagonalizeHsub) Hsub[q].diagonalize(Hsub_evecs[q], Hsub_eigs[q]);
 	}
 	return KEq;
 }
@@ -79,6 +79,7 @@ public:
 	FluidSolverParams fluidParams;
 	std::shared_ptr<struct FluidSolver> fluidSolver;
 	string fluidInitialStateFilename;
+	std::vector<string> solvationBatch; //!< fluid variant input files for solvation batch mode (see SolvationBatch)
 
 	//Wavefunction initialization:
 	string wfnsFilename; //!< file to read wavefunctions from
@@ -111,6 +112,11 @@ public:
 	
 	//! Set C to eigenvectors of the subspace hamiltonian
 	void setEigenvectors(); 
+	void setEigenvectors(int q); //!< Set C to eigenvectors of the subspace hamiltonian for a single state q
+	
+	//! Initialize wavefunctions of state q alone (used by band-streaming, where setup skips wavefunction initialization):
+	//! lowest subspace eigenvectors of the atomic orbitals if initLCAO, bandwidth-limited random numbers otherwise
+	void initStreamedWavefunctions(int q);
 	
 	//! Compute the kinetic energy density
 	ScalarFieldArray KEdensity() const;
@@ -118,14 +124,31 @@ public:
 	//! Calculate density using current orthonormal wavefunctions (C)
 	ScalarFieldArray calcDensity() const;
 	
+	//! Calculate densities for several sets of fillings (each indexed by state like F) in one pass,
+	//! transforming each band only once (used for energy-resolved and Fermi-level density dumps)
+	std::vector<ScalarFieldArray> calcDensities(const std::vector<std::vector<diagMatrix>>& Fsets) const;
+	
 	//! Orthonormalise wavefunctions, with an optional extra rotation
 	//! If extraRotation is present, it is applied after symmetric orthononormalization,
 	//! and on output extraRotation contains the net transformation applied to the wavefunctions.
-	void orthonormalize(int q, matrix* extraRotation=0);
+	//! If gaugeFree, the caller needs only an orthonormal basis of the same span (and no extraRotation),
+	//! which allows Cholesky-QR instead of symmetric orthonormalization (see orthoMatrix).
+	void orthonormalize(int q, matrix* extraRotation=0, bool gaugeFree=false);
+	
+	//! Matrix U with dagger(U) * S * U = 1 for a subspace overlap S, where only the span of the result matters:
+	//! invCholesky(S) with Control::subspaceOrtho = Cholesky (falling back to invsqrt if S is not numerically
+	//! positive-definite), and invsqrt(S) otherwise. isSingular is as in invsqrt.
+	matrix orthoMatrix(const matrix& S, bool* isSingular=0) const;
+	
+	//! Factors scaling the residual threshold of each of nBands (eigenvalue-ordered) bands of state q in iterative eigensolvers:
+	//! Control::partialBandTolScale for bands with fillings below Control::partialBandThreshold in SCF, and 1 otherwise
+	diagMatrix bandResidualScale(int q, int nBands) const;
 	
 	//! Applies the Kohn-Sham Hamiltonian on the orthonormal wavefunctions C, and computes Hsub if necessary, for a single quantum number
 	//! Returns the Kinetic energy contribution from q, which can be used for the inverse kinetic preconditioner
-	double applyHamiltonian(int q, const diagMatrix& Fq, ColumnBundle& HCq, Energies& ener, bool need_Hsub = false);
+	//! If diagonalizeHsub is false, Hsub is computed but its eigensystem is left to the caller
+	//! If includeVscloc is false, the local potential term must already be accumulated in HCq (eg. by k-point batching)
+	double applyHamiltonian(int q, const diagMatrix& Fq, ColumnBundle& HCq, Energies& ener, bool need_Hsub = false, bool diagonalizeHsub = true, bool includeVscloc = true);
 	
 private:
 	const Everything* e;
@@ -144,5 +167,10 @@ private:
 	friend class Dump;
 };
 
+//! Get the fillings and wavefunctions of the bands of state eInfo.qBand handled by the current process within band group eInfo.mpiBand.
+//! Collective over eInfo.mpiBand; optionally also return the full state (broadcast from its owner) in Cfull.
+void getBandSlice(const ElecInfo& eInfo, const std::vector<Basis>& basis,
+	const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, diagMatrix& Fsub, ColumnBundle& Csub, ColumnBundle* Cfull=0);
+
 //! @}
 #endif // JDFTX_ELECTRONIC_ELECVARS_H
@@ -44,6 +44,44 @@ struct LCAOminimizer : Minimizable<ElecGradient> //Uses only the Haux entries of
 	{
 	}
 	
+	//Subspace Hamiltonian C^(Idag Diag(Vscloc) I C + HC) for each state on this process, given all other terms HC (freed on output).
+	//For the state shared by a band group (eInfo.mpiBand), the local potential (the FFT-dominated part) is applied
+	//to a slice of its columns on each process of the group, and the result is collected on the owner of the state.
+	std::vector<matrix> subspaceHamiltonian(std::vector<ColumnBundle>& HC) const
+	{	static StopWatch watch("LCAOminimizer::subspaceHamiltonian"); watch.start();
+		std::vector<matrix> Hsub(eInfo.nStates);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	if(!eInfo.mpiBand) HC[q] += Idag_DiagV_I(eVars.C[q], eVars.Vscloc);
+			Hsub[q] = eVars.C[q] ^ HC[q];
+			HC[q].free();
+		}
+		if(eInfo.mpiBand)
+		{	const MPIUtil* mpiBand = eInfo.mpiBand.get();
+			int q = eInfo.qBand, iOwner = mpiBand->nProcesses()-1;
+			diagMatrix Fsub; ColumnBundle Csub, Cq;
+			getBandSlice(eInfo, e.basis, eVars.F, eVars.C, Fsub, Csub, &Cq);
+			int nBandsq = Cq.nCols(), bStart, bStop;
+			TaskDivision(nBandsq, mpiBand).myRange(bStart, bStop);
+			matrix HlocSub = zeroes(nBandsq, nBandsq);
+			if(bStop > bStart) HlocSub.set(0,nBandsq, bStart,bStop, Cq ^ Idag_DiagV_I(Csub, eVars.Vscloc));
+			mpiBand->reduceData(HlocSub, MPIUtil::ReduceSum, iOwner);
+			if(eInfo.isMine(q)) Hsub[q] += HlocSub;
+		}
+		watch.stop();
+		return Hsub;
+	}
+	
+	//Diagonalize eVars.Hsub for each state on this process (collectively over the band group for a shared state)
+	void diagonalizeHsub() const
+	{	if(eInfo.mpiBand)
+		{	int q = eInfo.qBand;
+			eVars.Hsub[q].diagonalize(eVars.Hsub_evecs[q], eVars.Hsub_eigs[q], eInfo.mpiBand.get(), eInfo.mpiBand->nProcesses()-1);
+		}
+		else
+			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+				eVars.Hsub[q].diagonalize(eVars.Hsub_evecs[q], eVars.Hsub_eigs[q]);
+	}
+	
 	void step(const ElecGradient& dir, double alpha)
 	{	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
 		{	assert(dir.Haux[q]);
@@ -81,23 +119,34 @@ struct LCAOminimizer : Minimizable<ElecGradient> //Uses only the Haux entries of
 		
 		//Wavefunction dependent parts:
 		ener.E["NI"] = 0.;
+		std::vector<matrix> HniRot(eInfo.nStates);
+		std::vector<ColumnBundle> HC(eInfo.nStates);
 		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
 		{	const QuantumNumber& qnum = eInfo.qnums[q];
 			
 			//KE and Nonlocal pseudopotential from precomputed subspace matrix:
-			matrix HniRot = dagger(rotPrev[q]) * HniSub[q] * rotPrev[q];
-			ener.E["NI"] += qnum.weight * trace(eVars.F[q] * HniRot).real();
+			HniRot[q] = dagger(rotPrev[q]) * HniSub[q] * rotPrev[q];
+			ener.E["NI"] += qnum.weight * trace(eVars.F[q] * HniRot[q]).real();
 		
-			//Gradient and subspace Hamiltonian:
+			//Terms of the subspace Hamiltonian other than the local potential:
 			if(grad)
-			{	ColumnBundle HCq = Idag_DiagV_I(eVars.C[q], eVars.Vscloc); //Accumulate Idag Diag(Vscloc) I C
-				if(eInfo.hasU) e.iInfo.rhoAtom_grad(eVars.C[q], eVars.U_rhoAtom, HCq); //Contribution via atomic density matrices (DFT+U)
+			{	HC[q] = eVars.C[q].similar(); HC[q].zero();
+				if(eInfo.hasU) e.iInfo.rhoAtom_grad(eVars.C[q], eVars.U_rhoAtom, HC[q]); //Contribution via atomic density matrices (DFT+U)
 				std::vector<matrix> HVdagCq(e.iInfo.species.size());
 				e.iInfo.augmentDensitySphericalGrad(qnum, eVars.VdagC[q], HVdagCq); //Contribution via pseudopotential density augmentation
-				e.iInfo.projectGrad(HVdagCq, eVars.C[q], HCq);
-				eVars.Hsub[q] = HniRot + (eVars.C[q]^HCq);
-				eVars.Hsub[q].diagonalize(eVars.Hsub_evecs[q], eVars.Hsub_eigs[q]);
-				//N/M constraint contributions to gradient:
+				e.iInfo.projectGrad(HVdagCq, eVars.C[q], HC[q]);
+			}
+		}
+		mpiWorld->allReduce(ener.E["NI"], MPIUtil::ReduceSum);
+		
+		//Subspace Hamiltonian and gradient contributions:
+		if(grad)
+		{	std::vector<matrix> HlocSub = subspaceHamiltonian(HC);
+			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+				eVars.Hsub[q] = HniRot[q] + HlocSub[q];
+			diagonalizeHsub();
+			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			{	//N/M constraint contributions to gradient:
 				diagMatrix fprime = eInfo.smearPrime(eInfo.muEff(mu,Bz,q), eVars.Haux_eigs[q]);
 				double w = eInfo.qnums[q].weight;
 				int sIndex = eInfo.qnums[q].index();
@@ -105,7 +154,6 @@ struct LCAOminimizer : Minimizable<ElecGradient> //Uses only the Haux entries of
 				dmuDen[sIndex] += w * trace(fprime);
 			}
 		}
-		mpiWorld->allReduce(ener.E["NI"], MPIUtil::ReduceSum);
 		
 		//Final gradient propagation to auxiliary Hamiltonian:
 		if(grad) 
@@ -226,18 +274,22 @@ int ElecVars::LCAO()
 		iInfo.augmentDensityInit();
 		iInfo.augmentDensityGridGrad(Vscloc); //Update Vscloc projections on ultrasoft pseudopotentials
 		
+		//Calculate subspace Hamiltonian:
+		std::vector<ColumnBundle> HC(eInfo.nStates);
 		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-		{
-			//Calculate subspace Hamiltonian:
-			ColumnBundle HCq = Idag_DiagV_I(C[q], Vscloc); //local self-consistent potential
+		{	HC[q] = C[q].similar(); HC[q].zero();
 			std::vector<matrix> HVdagCq(iInfo.species.size());
 			iInfo.augmentDensitySphericalGrad(eInfo.qnums[q], VdagC[q], HVdagCq); //ultrasoft augmentation
-			iInfo.projectGrad(HVdagCq, C[q], HCq);
-			Hsub[q] = dagger(lcao.rotPrev[q]) * lcao.HniSub[q] * lcao.rotPrev[q] + (C[q]^HCq);
-			
-			//Switch to eigenvectors of Hsub:
-			Hsub[q].diagonalize(Hsub_evecs[q], Hsub_eigs[q]);
-			C[q] = C[q] * Hsub_evecs[q];
+			iInfo.projectGrad(HVdagCq, C[q], HC[q]);
+		}
+		std::vector<matrix> HlocSub = lcao.subspaceHamiltonian(HC); //local self-consistent potential added here
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			Hsub[q] = dagger(lcao.rotPrev[q]) * lcao.HniSub[q] * lcao.rotPrev[q] + HlocSub[q];
+		lcao.diagonalizeHsub();
+		
+		//Switch to eigenvectors of Hsub:
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		{	C[q] = C[q] * Hsub_evecs[q];
 			for(unsigned sp=0; sp<iInfo.species.size(); sp++)
 				if(VdagC[q][sp]) VdagC[q][sp] = VdagC[q][sp] * Hsub_evecs[q]; 
 			lcao.rotPrev[q] = lcao.rotPrev[q] * Hsub_evecs[q];
@@ -0,0 +1,116 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/ElectrodeScan.h>
+#include <electronic/Everything.h>
+#include <electronic/ElecMinimizer.h>
+#include <electronic/Dump.h>
+#include <fluid/FluidSolver.h>
+#include <core/Minimize.h>
+#include <core/Units.h>
+
+//Linear fluid solver whose state can be extrapolated, if any
+//(only when on the main grid, since a coarse fluid grid is owned by the solver)
+inline LinearSolvable<ScalarFieldTilde>* linearFluid(Everything& e)
+{	auto linearSolver = dynamic_cast<LinearSolvable<ScalarFieldTilde>*>(e.eVars.fluidSolver.get());
+	if(linearSolver && linearSolver->state && !e.eVars.fluidSolver->gInfoFluid) return linearSolver;
+	return 0;
+}
+
+void runElectrodeScan(Everything& e)
+{	ElecInfo& eInfo = e.eInfo;
+	ElecVars& eVars = e.eVars;
+	const bool scanCharge = eInfo.scanCharge;
+	if(scanCharge != std::isnan(eInfo.mu))
+		die(scanCharge
+			? "Electrode charge scan requires fixed electron count (remove target-mu).\n\n"
+			: "Electrode potential scan requires target-mu for the main calculation.\n\n");
+	
+	//Neutral electron count (to report net charges):
+	double nNeutral = 0.;
+	for(const auto& sp: e.iInfo.species)
+		nNeutral += sp->Z * sp->atpos.size();
+	
+	//Converged points, starting with the main calculation:
+	struct Point { double x, mu, nElectrons, A; };
+	auto currentPoint = [&](double x)
+	{	double Bz, mu = std::isnan(eInfo.mu) ? eInfo.findMu(eVars.Haux_eigs, eInfo.nElectrons, Bz) : eInfo.mu;
+		return Point({ x, mu, eInfo.nElectrons, relevantFreeEnergy(e) });
+	};
+	std::vector<Point> points(1, currentPoint(scanCharge ? eInfo.nElectrons-nNeutral : eInfo.mu));
+	const char* Aname = relevantFreeEnergyName(e);
+	
+	std::vector<ColumnBundle> Cprev; std::vector<diagMatrix> HauxPrev; ScalarFieldTilde fluidPrev; //state at previous point
+	string basenameRef = inputBasename;
+	const std::vector<double>& values = eInfo.scanValues;
+	for(size_t iPoint=0; iPoint<values.size(); iPoint++)
+	{	double x = values[iPoint];
+		logPrintf("\n---------- Electrode scan point %d of %d: %s = %lg ----------\n",
+			int(iPoint+1), int(values.size()), (scanCharge ? "QNet" : "mu"), x);
+		const Point& cur = points.back();
+		
+		//Extrapolate state linearly in the scanned variable from the last two points:
+		std::vector<ColumnBundle> Ccur = eVars.C;
+		std::vector<diagMatrix> HauxCur = eVars.Haux_eigs;
+		LinearSolvable<ScalarFieldTilde>* fluid = linearFluid(e);
+		ScalarFieldTilde fluidCur = fluid ? clone(fluid->state) : 0;
+		double nElectronsNext = scanCharge ? nNeutral+x : cur.nElectrons;
+		if(Cprev.size())
+		{	const Point& prev = points[points.size()-2];
+			double dxPrev = cur.x - prev.x;
+			double r = dxPrev ? std::max(0., std::min(2., (x - cur.x)/dxPrev)) : 0.; //extrapolate forwards, by at most twice the previous step
+			logPrintf("Extrapolating state from previous two points with ratio %lg.\n", r);
+			for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			{	matrix M = Cprev[q] ^ Ccur[q];
+				matrix U = M * invsqrt(dagger(M) * M); //unitary rotation that best maps Cprev onto Ccur
+				eVars.C[q] = Ccur[q] * (1.+r);
+				eVars.C[q] += (Cprev[q] * U) * (-r);
+				eVars.orthonormalize(q);
+				eVars.Haux_eigs[q] = HauxCur[q]*(1.+r) - HauxPrev[q]*r;
+			}
+			if(fluid && fluidPrev) fluid->state = fluidCur*(1.+r) - fluidPrev*r;
+			if(!scanCharge) nElectronsNext = cur.nElectrons + r*(cur.nElectrons - prev.nElectrons); //Haux is shifted to match in elecFluidMinimize
+		}
+		Cprev = Ccur; HauxPrev = HauxCur; fluidPrev = fluidCur;
+		Ccur.clear(); HauxCur.clear(); fluidCur = 0;
+		
+		//Converge at this point:
+		eInfo.nElectrons = nElectronsNext;
+		if(!scanCharge) eInfo.mu = x;
+		logFlush();
+		elecFluidMinimize(e);
+		points.push_back(currentPoint(x));
+		logPrintf("# Energy components:\n"); e.ener.print(); logPrintf("\n");
+		std::ostringstream oss; oss << ".scan" << iPoint+1;
+		inputBasename = basenameRef + oss.str().c_str();
+		e.dump(DumpFreq_End, 0);
+		inputBasename = basenameRef;
+	}
+	
+	//Summary:
+	logPrintf("\n# Electrode scan: mu, electron count and %s at each point (0 = main calculation),\n"
+		"# with the differential capacitance dN/dmu from the previous point:\n", Aname);
+	logPrintf("# %5s %16s %16s %12s %20s %14s\n", "Point", "mu [Eh]", "nElectrons", "QNet", (string(Aname)+" [Eh]").c_str(), "Cdiff [e/V]");
+	for(size_t iPoint=0; iPoint<points.size(); iPoint++)
+	{	const Point& p = points[iPoint];
+		double Cdiff = iPoint ? (p.nElectrons - points[iPoint-1].nElectrons) / ((p.mu - points[iPoint-1].mu)/eV) : NAN;
+		logPrintf("  %5d %+16.9lf %16.9lf %+12.6lf %+20.12lf %14.6lf\n", int(iPoint), p.mu, p.nElectrons, p.nElectrons-nNeutral, p.A, Cdiff);
+	}
+	logFlush();
+}
@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_ELECTRODESCAN_H
+#define JDFTX_ELECTRONIC_ELECTRODESCAN_H
+
+class Everything;
+
+//! @addtogroup ElectronicDFT
+//! @{
+//! @file ElectrodeScan.h Electrode potential / charge scan (command electrode-scan)
+
+/** Converge the electronic and fluid state at each of the target mu (or net electron counts) in
+ElecInfo::scanValues in turn, at the final ionic positions of the main calculation, without repeating setup.
+Each point is warm-started from the previous one, with the wavefunctions, auxiliary Hamiltonian,
+electron count and linear fluid state extrapolated linearly in the scanned variable from the last two points.
+Each point is dumped with $INPUT replaced by $INPUT.scan<index>, and the charge-potential curve is summarized at the end.
+*/
+void runElectrodeScan(Everything& e);
+
+//! @}
+#endif // JDFTX_ELECTRONIC_ELECTRODESCAN_H
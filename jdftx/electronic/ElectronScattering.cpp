@@ -45,7 +45,7 @@ double regularizedDelta(double omega, double omega0, double etaInv)
 
 ElectronScattering::ElectronScattering()
 : eta(0.), Ecut(0.), fCut(1e-6), omegaMax(0.), RPA(false), slabResponse(false), EcutTransverse(0.),
-	computeRange(false), iqStart(0), iqStop(0)
+	computeRange(false), iqStart(0), iqStop(0), transformCacheSize(0.), nqGroups(1), nEigs(0)
 {
 }
 
@@ -126,21 +126,23 @@ void ElectronScattering::dump(const Everything& everything)
 	E.resize(e.eInfo.nStates);
 	F.resize(e.eInfo.nStates);
 	VdagC.resize(e.eInfo.nStates);
+	bool shareC = !isGpuEnabled(); //node-shared wavefunctions (CPU only, since borrowed memory cannot move to the GPU)
+	if(shareC) shareWavefunctions(e);
 	for(int q=0; q<e.eInfo.nStates; q++)
 	{	int procSrc = e.eInfo.whose(q);
 		if(e.eInfo.isMine(q))
-		{	std::swap(C[q], e.eVars.C[q]);
+		{	if(!shareC) std::swap(C[q], e.eVars.C[q]);
 			std::swap(E[q], e.eVars.Hsub_eigs[q]);
 			std::swap(F[q], e.eVars.F[q]);
 			std::swap(VdagC[q], e.eVars.VdagC[q]);
 		}
 		else
-		{	C[q].init(nBands, e.basis[q].nbasis * nSpinor, &e.basis[q], &e.eInfo.qnums[q]);
+		{	if(!shareC) C[q].init(nBands, e.basis[q].nbasis * nSpinor, &e.basis[q], &e.eInfo.qnums[q]);
 			E[q].resize(nBands);
 			F[q].resize(nBands);
 			VdagC[q].resize(e.iInfo.species.size());
 		}
-		mpiWorld->bcastData(C[q], procSrc);
+		if(!shareC) mpiWorld->bcastData(C[q], procSrc);
 		mpiWorld->bcastData(E[q], procSrc);
 		mpiWorld->bcastData(F[q], procSrc);
 		for(unsigned iSp=0; iSp<e.iInfo.species.size(); iSp++)
@@ -208,6 +210,21 @@ void ElectronScattering::dump(const Everything& everything)
 	}
 	else { iqStart = 0; iqStop = qmesh.size(); }
 	
+	//Divide momentum transfers over process groups, and k-points over processes within each group:
+	int nGroups = std::min(nqGroups, mpiWorld->nProcesses());
+	std::shared_ptr<MPIUtil> mpiGroupPtr;
+	const MPIUtil* mpi = mpiWorld; //communicator for work on each momentum transfer
+	int iGroup = 0;
+	if(nGroups > 1)
+	{	mpiGroupPtr = std::make_shared<MPIUtil>(0, (char**)0, MPIUtil::ProcDivision(mpiWorld, nGroups));
+		mpi = mpiGroupPtr.get();
+		iGroup = mpi->procDivision.iGroup;
+		logPrintf("Dividing momentum transfers over %d process groups (log shows those of the first group).\n", nGroups);
+	}
+	TaskDivision(supercell->kmesh.size(), mpi).myRange(ikStart, ikStop);
+	omegaDiv.init(omegaGrid.size(), mpi);
+	omegaDiv.myRange(iOmegaStart, iOmegaStop);
+	
 	//Initialize polarizability/dielectric bases corresponding to qmesh:
 	logPrintf("Setting up reduced polarizability bases at Ecut = %lg: ", Ecut); logFlush();
 	basisChi.resize(qmesh.size());
@@ -222,8 +239,8 @@ void ElectronScattering::dump(const Everything& everything)
 	logPrintf("nbasis = %.2lf average, %.2lf ideal\n", avg_nbasis, pow(sqrt(2*Ecut),3)*(e.gInfo.detR/(6*M_PI*M_PI)));
 	logFlush();
 
-	//Initialize common wavefunction basis and ColumnBundle transforms for full k-mesh:
-	logPrintf("Setting up k-mesh wavefunction transforms ... "); logFlush();
+	//Initialize common wavefunction basis and quantum numbers for full k-mesh (transforms created on demand):
+	logPrintf("Setting up k-mesh wavefunction basis ... "); logFlush();
 	double kMaxSq = 0;
 	for(const vector3<>& k: supercell->kmesh)
 	{	kMaxSq = std::max(kMaxSq, e.gInfo.GGT.metric_length_squared(k));
@@ -236,23 +253,17 @@ void ElectronScattering::dump(const Everything& everything)
 	logSuspend();
 	basis.setup(gInfoBasis, e.iInfo, EcutEff, vector3<>());
 	logResume();
-	ColumnBundleTransform::BasisWrapper basisWrapper(basis);
-	std::vector<SpaceGroupOp> sym = e.symm.getMatrices();
+	basisWrapper = std::make_shared<ColumnBundleTransform::BasisWrapper>(basis);
+	transformCache.setBudget(transformCacheSize);
 	for(size_t ik=ikStart; ik<ikStop; ik++)
 	{	const vector3<>& k = supercell->kmesh[ik];
 		for(const QuantumNumber& qnum: qmesh)
 		{	vector3<> k2 = k + qnum.k; double roundErr;
 			vector3<int> k2sup = round((k2 - supercell->kmesh[0]) * supercell->super, &roundErr);
 			assert(roundErr < symmThreshold);
-			auto iter = transform.find(k2sup);
-			if(iter == transform.end())
-			{	size_t ik2 = plook->find(k2); assert(ik2 != string::npos);
-				const Supercell::KmeshTransform& kTransform = supercell->kmeshTransform[ik2];
-				const Basis& basisC = e.basis[kTransform.iReduced];
-				const vector3<>& kC = e.eInfo.qnums[kTransform.iReduced].k;
-				transform[k2sup] = std::make_shared<ColumnBundleTransform>(kC, basisC, k2, basisWrapper,
-					nSpinor, sym[kTransform.iSym], kTransform.invert);
-				//Initialize corresponding quantum number:
+			auto iter = qnumMesh.find(k2sup);
+			if(iter == qnumMesh.end())
+			{	//Initialize corresponding quantum number:
 				QuantumNumber qnum;
 				qnum.k = k2;
 				qnum.spin = 0;
@@ -266,7 +277,8 @@ void ElectronScattering::dump(const Everything& everything)
 	//Main loop over momentum transfers:
 	std::vector<diagMatrix> ImSigma(e.eInfo.nStates, diagMatrix(nBands,0.));
 	for(size_t iq=iqStart; iq<iqStop; iq++)
-	{	logPrintf("\nMomentum transfer %d of %d: q = ", int(iq+1), int(qmesh.size()));
+	{	if(int((iq-iqStart) % nGroups) != iGroup) continue; //handled by another process group
+		logPrintf("\nMomentum transfer %d of %d: q = ", int(iq+1), int(qmesh.size()));
 		qmesh[iq].k.print(globalLog, " %+.5lf ");
 		
 		//Check if momentum transfer computed previously:
@@ -274,13 +286,16 @@ void ElectronScattering::dump(const Everything& everything)
 		string fnameImSigmaCur = e.dump.getFilename("ImSigma_ee"+ossSuffix.str());
 		if(isReadable(fnameImSigmaCur))
 		{	logPrintf("\tReading %s ... ", fnameImSigmaCur.c_str()); logFlush();
-			std::vector<diagMatrix> ImSigmaCur; 
-			e.eInfo.read(ImSigmaCur, fnameImSigmaCur.c_str());
+			//Read independently on each process of group (not collectively, since other groups are elsewhere in the loop):
+			FILE* fp = fopen(fnameImSigmaCur.c_str(), "rb");
+			if(!fp) die_alone("Error opening '%s' for reading.\n", fnameImSigmaCur.c_str());
 			for(int q=0; q<e.eInfo.nStates; q++) 
-			{	if(not e.eInfo.isMine(q)) ImSigmaCur[q].assign(nBands, 0.);
-				mpiWorld->allReduceData(ImSigmaCur[q], MPIUtil::ReduceSum);
-				ImSigma[q] += ImSigmaCur[q]; //accumulate pre-computed contributions for this iq
+			{	diagMatrix ImSigmaCur(nBands);
+				if(freadLE(ImSigmaCur.data(), sizeof(double), nBands, fp) < size_t(nBands))
+					die_alone("Error reading '%s': file too short.\n", fnameImSigmaCur.c_str());
+				ImSigma[q] += ImSigmaCur; //accumulate pre-computed contributions for this iq
 			}
+			fclose(fp);
 			logPrintf("done.\n\n");
 			continue;
 		}
@@ -290,13 +305,47 @@ void ElectronScattering::dump(const Everything& everything)
 		nAugRhoAtomInit(iq);
 		
 		//Construct XC and Coulomb operators (regularizes G=0 using the tricks developed for EXX):
-		matrix Kxc, invKq = inv(coulombMatrix(iq, Kxc));
+		matrix Kxc, Kq = coulombMatrix(iq, Kxc);
+		bool lowRank = (nEigs > 0) and (nEigs < nbasis);
+		int nResponse = lowRank ? nEigs : nbasis; //dimension of response matrices below
+		matrix invKq = lowRank ? matrix() : inv(Kq);
+		size_t nkMine = ikStop-ikStart;
+		int ikInterval = std::max(1, int(round(nkMine/20.))); //interval for reporting progress
+		
+		//Determine low-rank subspace from dominant eigenvectors of static chi_KS, if needed:
+		matrix Q, KQ; //orthonormal subspace basis, and Coulomb kernel applied to it
+		if(lowRank)
+		{	logPrintf("\tComputing static chi_KS subspace ... "); logFlush();
+			matrix chiStatic = zeroes(nbasis, nbasis);
+			for(size_t ik=ikStart; ik<ikStop; ik++)
+			for(int iSpin=0; iSpin<nSpins; iSpin++)
+			{	size_t jk; matrix nij;
+				std::vector<Event> events = getEvents(true, iSpin, ik, iq, jk, nij);
+				if(!events.size()) continue;
+				std::vector<complex> Xks; Xks.reserve(events.size());
+				for(const Event& event: events)
+					Xks.push_back(-e.gInfo.detR * kWeight * event.fWeight *
+						( regularizedPole(0., -event.Eji, etaInv)
+						- regularizedPole(0., +event.Eji, etaInv) ) );
+				chiStatic += (nij * Xks) * dagger(nij);
+			}
+			mpi->allReduceData(chiStatic, MPIUtil::ReduceSum);
+			matrix evecs; diagMatrix eigs;
+			dagger_symmetrize(chiStatic).diagonalize(evecs, eigs); //most negative (dominant) eigenvalues first
+			Q = evecs(0,nbasis, 0,nEigs);
+			KQ = Kq * Q;
+			double eigSum = 0., eigSumKept = 0.;
+			for(int i=0; i<nbasis; i++)
+			{	eigSum += eigs[i];
+				if(i < nEigs) eigSumKept += eigs[i];
+			}
+			logPrintf("done. Retained %d of %d eigenvectors with %.4lf of the trace.\n", nEigs, nbasis, eigSumKept/eigSum);
+			logFlush();
+		}
 		
-		//Calculate chi_KS:
+		//Calculate chi_KS (projected to low-rank subspace if needed):
 		std::vector<matrix> chiKS(omegaGrid.nRows());
 		logPrintf("\tComputing chi_KS ...  "); logFlush(); 
-		size_t nkMine = ikStop-ikStart;
-		int ikInterval = std::max(1, int(round(nkMine/20.))); //interval for reporting progress
 		for(size_t ik=ikStart; ik<ikStop; ik++)
 		for(int iSpin=0; iSpin<nSpins; iSpin++)
 		{	//Report progress:
@@ -309,6 +358,7 @@ void ElectronScattering::dump(const Everything& everything)
 			size_t jk; matrix nij;
 			std::vector<Event> events = getEvents(true, iSpin, ik, iq, jk, nij);
 			if(!events.size()) continue;
+			if(lowRank) nij = dagger(Q) * nij;
 			//Collect contributions for each frequency:
 			for(int iOmega=0; iOmega<omegaGrid.nRows(); iOmega++)
 			{	double omega = omegaGrid[iOmega];
@@ -321,10 +371,12 @@ void ElectronScattering::dump(const Everything& everything)
 			}
 		}
 		for(int iOmega=0; iOmega<omegaGrid.nRows(); iOmega++)
-		{	mpiWorld->allReduceData(chiKS[iOmega], MPIUtil::ReduceSum);
+		{	mpi->allReduceData(chiKS[iOmega], MPIUtil::ReduceSum);
 			if(!omegaDiv.isMine(iOmega)) chiKS[iOmega] = 0; //no longer needed on this process
 		}
-		logPrintf("done.\n"); logFlush();
+		logPrintf("done.\n");
+		e.dump.pairScreening.report("chi_KS", mpi);
+		logFlush();
 		
 		//Figure out head entry index:
 		int iHead = 0;
@@ -337,18 +389,28 @@ void ElectronScattering::dump(const Everything& everything)
 		//Calculate Im(screened Coulomb operator):
 		logPrintf("\tComputing Im(Kscreened) ... "); logFlush();
 		std::vector<matrix> ImKscr(omegaGrid.nRows());
+		matrix KqSub, KxcSub; //kernels within low-rank subspace
+		if(lowRank)
+		{	KqSub = dagger(Q) * KQ;
+			if(!RPA) KxcSub = dagger(Q) * Kxc * Q;
+			Kxc = 0; Kq = 0; //free memory; no longer needed
+		}
+		const matrix& KxcResp = lowRank ? KxcSub : Kxc;
 		for(int iOmega=iOmegaStart; iOmega<iOmegaStop; iOmega++)
 		{	matrix chi0 = RPA
 				? chiKS[iOmega]
-				: inv(eye(nbasis) - chiKS[iOmega] * Kxc) * chiKS[iOmega];
+				: inv(eye(nResponse) - chiKS[iOmega] * KxcResp) * chiKS[iOmega];
 			chiKS[iOmega] = 0; //free to save memory
-			ImKscr[iOmega] = Im(inv(invKq - chi0));
+			if(lowRank) //Woodbury: inv(invK - Q chi0 Q^) = K + KQ inv(1 - chi0 KqSub) chi0 (KQ)^, where Im(K) = 0
+				ImKscr[iOmega] = Im(inv(eye(nEigs) - chi0 * KqSub) * chi0); //sandwiched between KQ below
+			else
+				ImKscr[iOmega] = Im(inv(invKq - chi0));
 			chi0 = 0; //free to save memory
 		}
 		chiKS.clear(); //free memory; no longer needed
 		for(int iOmega=0; iOmega<omegaGrid.nRows(); iOmega++)
-		{	if(!omegaDiv.isMine(iOmega)) ImKscr[iOmega] = zeroes(nbasis,nbasis);
-			mpiWorld->bcastData(ImKscr[iOmega], omegaDiv.whose(iOmega));
+		{	if(!omegaDiv.isMine(iOmega)) ImKscr[iOmega] = zeroes(nResponse,nResponse);
+			mpi->bcastData(ImKscr[iOmega], omegaDiv.whose(iOmega));
 		}
 		logPrintf("done.\n"); logFlush();
 		
@@ -367,6 +429,7 @@ void ElectronScattering::dump(const Everything& everything)
 			size_t jk; matrix nij;
 			std::vector<Event> events = getEvents(false, iSpin, ik, iq, jk, nij);
 			if(!events.size()) continue;
+			if(lowRank) nij = dagger(KQ) * nij; //so that <nij|ImW|nij> = nij^ ImKscr nij below
 			//Integrate over frequency for event contributions to linewidth:
 			diagMatrix eventContrib(events.size(), 0);
 			for(size_t iEvent=0; iEvent<events.size(); iEvent++)
@@ -405,17 +468,31 @@ void ElectronScattering::dump(const Everything& everything)
 
 		//Accumulate contributions from this momentum transfer and write them to a file (for check-pointing):
 		for(int q=0; q<e.eInfo.nStates; q++)
-		{	mpiWorld->allReduceData(ImSigmaCur[q], MPIUtil::ReduceSum);
+		{	mpi->allReduceData(ImSigmaCur[q], MPIUtil::ReduceSum);
 			ImSigma[q] += ImSigmaCur[q];
 		}
 		logPrintf("\tDumping %s ... ", fnameImSigmaCur.c_str()); logFlush();
-		e.eInfo.write(ImSigmaCur, fnameImSigmaCur.c_str());
+		if(mpi->isHead()) //same format as ElecInfo::write, but from the group head alone
+		{	FILE* fp = fopen(fnameImSigmaCur.c_str(), "wb");
+			if(!fp) die_alone("Error opening '%s' for writing.\n", fnameImSigmaCur.c_str());
+			for(int q=0; q<e.eInfo.nStates; q++)
+				fwriteLE(ImSigmaCur[q].data(), sizeof(double), nBands, fp);
+			fclose(fp);
+		}
 		logPrintf("done.\n");
 	}
 	logPrintf("\n");
 	
+	//Collect contributions from all process groups (each present on all processes of its group):
+	if(nGroups > 1)
+		for(int q=0; q<e.eInfo.nStates; q++)
+		{	if(not mpi->isHead()) ImSigma[q].assign(nBands, 0.);
+			mpiWorld->allReduceData(ImSigma[q], MPIUtil::ReduceSum);
+		}
+	
 	if(computeRange)
 	{	logPrintf("Perform a run without 'computeRange' to collect final results after calculating all momentum transfers.\n\n");
+		releaseShared();
 		return;
 	}
 	
@@ -432,9 +509,66 @@ void ElectronScattering::dump(const Everything& everything)
 	e.eInfo.write(ImSigma, fname.c_str());
 	logPrintf("done.\n");
 	
+	releaseShared();
 	logPrintf("\n"); logFlush();
 }
 
+void ElectronScattering::shareWavefunctions(Everything& e)
+{	const ElecInfo& eInfo = e.eInfo;
+	int nProcs = mpiWorld->nProcesses();
+	mpiNode = std::make_shared<MPIUtil>(mpiWorld, MPIUtil::SplitNode);
+	
+	//Identify the first process (leader) of each node:
+	std::vector<int> leaderOf(nProcs, 0); //world rank of leader of each process's node
+	int myLeader = mpiWorld->iProcess();
+	mpiNode->bcast(myLeader);
+	leaderOf[mpiWorld->iProcess()] = myLeader;
+	mpiWorld->allReduceData(leaderOf, MPIUtil::ReduceSum);
+	std::vector<int> leaders; //world ranks of leaders (ascending, which is their rank in mpiLeaders)
+	for(int iProc=0; iProc<nProcs; iProc++)
+		if(leaderOf[iProc] == iProc)
+			leaders.push_back(iProc);
+	if(mpiNode->isHead())
+		mpiLeaders = std::make_shared<MPIUtil>(mpiWorld, leaders);
+	
+	//Allocate one copy of all wavefunctions per node, owned by the leader:
+	std::vector<size_t> offset(eInfo.nStates+1, 0);
+	for(int q=0; q<eInfo.nStates; q++)
+		offset[q+1] = offset[q] + nBands * e.basis[q].nbasis * nSpinor;
+	Cwindow = std::make_shared<MPISharedWindow>(mpiNode.get(), mpiNode->isHead() ? offset.back()*sizeof(complex) : 0);
+	complex* Cnode = (complex*)Cwindow->segment(0);
+	logPrintf("Sharing wavefunctions within %d node(s): %.1lf MB per node.\n",
+		int(leaders.size()), offset.back()*sizeof(complex)/pow(1024.,2)); logFlush();
+	
+	//Copy own states into the node copy:
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+	{	eblas_copy(Cnode+offset[q], e.eVars.C[q].data(), offset[q+1]-offset[q]);
+		e.eVars.C[q].free(); //only the node copy is needed from here on
+	}
+	Cwindow->sync();
+	
+	//Exchange states between nodes (only leaders communicate):
+	if(mpiLeaders && mpiLeaders->nProcesses()>1)
+		for(int q=0; q<eInfo.nStates; q++)
+		{	int root = std::lower_bound(leaders.begin(), leaders.end(), leaderOf[eInfo.whose(q)]) - leaders.begin();
+			mpiLeaders->bcast(Cnode+offset[q], offset[q+1]-offset[q], root);
+		}
+	Cwindow->sync();
+	
+	//Refer to node copy from all processes:
+	C.resize(eInfo.nStates);
+	for(int q=0; q<eInfo.nStates; q++)
+		C[q].initBorrowed(nBands, e.basis[q].nbasis * nSpinor, &e.basis[q], &eInfo.qnums[q], Cnode+offset[q]);
+}
+
+void ElectronScattering::releaseShared()
+{	if(!Cwindow) return;
+	C.clear(); //borrowed from Cwindow
+	Cwindow = 0;
+	mpiLeaders = 0;
+	mpiNode = 0;
+}
+
 std::vector<ElectronScattering::Event> ElectronScattering::getEvents(bool chiMode, int iSpin, size_t ik, size_t iq, size_t& jk, matrix& nij) const
 {	static StopWatch watchI("ElectronScattering::getEventsI"), watchJ("ElectronScattering::getEventsJ"), watchAug("ElectronScattering::nAug");
 	//Find target k-point:
@@ -466,7 +600,8 @@ std::vector<ElectronScattering::Event> ElectronScattering::getEvents(bool chiMod
 		event.Eji = Ejj - Eii;
 		if(chiMode)
 		{	event.fWeight = 0.5*(Fi[event.i] - Fj[event.j]);
-			needEvent = (fabs(event.fWeight) > fCut);
+			needEvent = (fabs(event.fWeight) > fCut)
+				and e->dump.pairScreening(Fi[event.i], Fj[event.j], Eii, Ejj, omegaMax);
 		}
 		else
 		{	event.fWeight = Fj[event.j];
@@ -560,8 +695,10 @@ ColumnBundle ElectronScattering::getWfns(size_t ik, int iSpin, const vector3<>&
 	assert(roundErr < symmThreshold);
 	ColumnBundle result(nBands, basis.nbasis * nSpinor, &basis, &qnumMesh.find(kSup)->second, isGpuEnabled());
 	result.zero();
-	const ColumnBundleTransform& cbt = *(transform.find(kSup)->second);
 	const Supercell::KmeshTransform& kmt = supercell->kmeshTransform[ik];
+	std::shared_ptr<ColumnBundleTransform> cbtPtr = transformCache.get(e->eInfo.qnums[kmt.iReduced].k, e->basis[kmt.iReduced], k,
+		*basisWrapper, nSpinor, e->symm.getMatrices()[kmt.iSym], kmt.invert);
+	const ColumnBundleTransform& cbt = *cbtPtr;
 	cbt.scatterAxpy(1., C[kmt.iReduced+iSpin*qCount], result,0,1);
 	if(VdagCi) *VdagCi = cbt.transformVdagC(VdagC[kmt.iReduced+iSpin*qCount], kmt.iSym);
 	watch.stop();
@@ -744,7 +881,9 @@ void ElectronScattering::dumpSlabResponse(Everything& e, const diagMatrix& omega
 	{	mpiWorld->allReduceData(chiKS[iOmega], MPIUtil::ReduceSum);
 		if(!omegaDiv.isMine(iOmega)) chiKS[iOmega] = 0; //no longer needed on this process
 	}
-	logPrintf("done.\n"); logFlush();
+	logPrintf("done.\n");
+	e.dump.pairScreening.report("chi_KS", mpiWorld);
+	logFlush();
 
 	//Output result:
 	string fname = e.dump.getFilename("slabResponse");
@@ -21,12 +21,14 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_ELECTRONIC_ELECTRONSCATTERING_H
 
 #include <electronic/Basis.h>
+#include <electronic/ColumnBundleTransform.h>
 #include <core/LatticeUtils.h>
 #include <memory>
 
 class ColumnBundle;
 class diagMatrix;
 class QuantumNumber;
+class MPISharedWindow;
 
 //! @addtogroup Output
 //! @{
@@ -46,6 +48,9 @@ struct ElectronScattering
 	
 	bool computeRange; //!< only compute a subset of momentum transfers
 	size_t iqStart, iqStop; //!< range of q to compute in the current run
+	double transformCacheSize; //!< if positive, memory budget in MB for cached k-mesh wavefunction transforms (else unlimited)
+	int nqGroups; //!< number of process groups that work on different momentum transfers concurrently
+	int nEigs; //!< if positive, represent response matrices in the subspace of this many dominant eigenvectors of the static chi_KS
 	
 	ElectronScattering();
 	void dump(const Everything& e); //!< compute and dump Im(Sigma_ee) for each eigenstate
@@ -55,6 +60,10 @@ private:
 	int nBands, nSpinor, nSpins, qCount;
 	double Emin, Emax; //!< energy range that contributes to transitions less than omegaMax
 	std::vector<ColumnBundle> C; //wavefunctions, made available on all processes
+	std::shared_ptr<MPIUtil> mpiNode, mpiLeaders; //processes sharing memory on this node, and first process of each node (null on others)
+	std::shared_ptr<MPISharedWindow> Cwindow; //node-shared storage of C on CPU (one copy per node, instead of one per process)
+	void shareWavefunctions(Everything& e); //make C available on all processes with one copy per node in Cwindow
+	void releaseShared(); //release C and Cwindow (collective; must happen before MPI is finalized)
 	std::vector<diagMatrix> E, F; //energies and fillings, available on all processes
 	std::vector<std::vector<matrix>> VdagC; //pseudopotential projections
 	std::shared_ptr<const Supercell> supercell; //contains transformations between full and reduced k-mesh
@@ -62,7 +71,8 @@ private:
 	std::vector<QuantumNumber> qmesh; //reduced momentum-transfer mesh
 	std::vector<Basis> basisChi; //polarizability bases for qmesh
 	Basis basis; //common wavefunction  basis
-	std::map< vector3<int>, std::shared_ptr<class ColumnBundleTransform> > transform; //k-mesh transformations
+	std::shared_ptr<ColumnBundleTransform::BasisWrapper> basisWrapper; //look-up table for transforms to common basis
+	mutable ColumnBundleTransformCache transformCache; //k-mesh transformations (created on demand within transformCacheSize)
 	std::map< vector3<int>, QuantumNumber > qnumMesh; //equivalent of eInfo.qnums for entire k-mesh
 	std::vector<matrix> nAugRhoAtom; //augmentation pair densities per atomic density-matrix element for each species
 	
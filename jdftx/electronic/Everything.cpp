@@ -22,27 +22,40 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/VanDerWaalsD3.h>
 #include <electronic/Vibrations.h>
 #include <electronic/DOS.h>
+#include <electronic/PerformanceProfile.h>
+#include <electronic/ColumnBundle.h>
+#include <electronic/StateStore.h>
 #include <core/LatticeUtils.h>
 #include <fluid/FluidSolver.h>
 
 void Everything::setup()
 {
+	static const int phaseId = Profiler::registerName("Setup"); ProfilePhase phase(phaseId);
+	applyPerformanceProfile(*this); //presets for performance settings left at their defaults
+	
 	//Symmetries (phase 1: lattice+basis dependent)
 	if(vibrations)
 	{	symmUnperturbed = symm;
 		symm.mode = SymmetriesNone; //disable symmetries in remainder of calculation
 		symmUnperturbed.setup(*this); //calculate symmetries of unperturbed system for optimizing force matrix calculation
 	}
+	if(ipiDriver and symm.mode != SymmetriesNone)
+	{	logPrintf("Disabling symmetries since positions and lattice are set by the ipi-driver server.\n");
+		symm.mode = SymmetriesNone;
+	}
 	symm.setup(*this);
 	
 	//Initialize the grid:
 	gInfo.Gmax = sqrt(2*cntrl.Ecut); //Ecut = 0.5 Gmax^2
 	gInfo.GmaxRho = sqrt(2*cntrl.EcutRho); //Ecut = 0.5 Gmax^2
+	if(gInfo.fftBoxTuneExcess > 0.) gInfo.fftBoxTuneFile = perfTuneFilename(cntrl);
 	gInfo.initialize(false, vibrations ? symmUnperturbed.getMatrices() : symm.getMatrices());
 	if(cntrl.EcutRho && cntrl.EcutRho>4*cntrl.Ecut)
 	{	gInfoWfns = std::make_shared<GridInfo>();
 		gInfoWfns->R = gInfo.R;
 		gInfoWfns->Gmax = gInfo.Gmax;
+		gInfoWfns->fftBoxTuneExcess = gInfo.fftBoxTuneExcess;
+		gInfoWfns->fftBoxTuneFile = gInfo.fftBoxTuneFile;
 		logPrintf("\n---------- Initializing tighter grid for wavefunction operations ----------\n");
 		gInfoWfns->initialize(true, vibrations ? symmUnperturbed.getMatrices() : symm.getMatrices());
 		if(gInfoWfns->S == gInfo.S)
@@ -50,6 +63,12 @@ void Everything::setup()
 			gInfoWfns = 0;
 		}
 	}
+	gInfo.fftBatchSize = cntrl.fftBatchSize ? cntrl.fftBatchSize : (isGpuEnabled() ? 8 : 1);
+	if(gInfoWfns) gInfoWfns->fftBatchSize = gInfo.fftBatchSize;
+	gInfo.fftSinglePrecision = (cntrl.fftSinglePrecisionThreshold > 0.);
+	if(gInfoWfns) gInfoWfns->fftSinglePrecision = gInfo.fftSinglePrecision;
+	gInfo.fftPruning = cntrl.fftPruning && !isGpuEnabled();
+	if(gInfoWfns) gInfoWfns->fftPruning = gInfo.fftPruning;
 
 	//Exchange correlation setup
 	logPrintf("\n---------- Exchange Correlation functional ----------\n");
@@ -67,31 +86,13 @@ void Everything::setup()
 	eInfo.kpointsFold();
 	symm.setupMesh();
 	if(vibrations) symmUnperturbed.setupMesh();
+	if(stateStore) stateStore->lookup(*this); //sets initial-state filenames, so needed before reading fillings below
 	
 	//Set up k-points, bands and fillings
 	eInfo.setup(*this, eVars.F, ener);
 
-	//Set up the reduced bases for wavefunctions:
-	logPrintf("\n----- Setting up reduced wavefunction bases (%s) -----\n",
-		(cntrl.basisKdep==BasisKpointIndep) ? "single at Gamma point" :  "one per k-point");
-	basis.resize(eInfo.nStates);
-	double avg_nbasis = 0.;
-	const GridInfo& gInfoBasis = gInfoWfns ? *gInfoWfns : gInfo;
-	if(!cntrl.shouldPrintKpointsBasis) logSuspend();
-	for(int q=0; q<eInfo.nStates; q++)
-	{	if(cntrl.basisKdep==BasisKpointDep)
-			basis[q].setup(gInfoBasis, iInfo, cntrl.Ecut, eInfo.qnums[q].k);
-		else
-		{	if(q==0) basis[q].setup(gInfoBasis, iInfo, cntrl.Ecut, vector3<>(0,0,0));
-			else basis[q] = basis[0];
-		}
-		avg_nbasis += eInfo.qnums[q].weight * basis[q].nbasis;
-	}
-	avg_nbasis /= eInfo.qWeightSum;
-	if(!cntrl.shouldPrintKpointsBasis) logResume();
-	logPrintf("average nbasis = %7.3lf , ideal nbasis = %7.3lf\n", avg_nbasis,
-		pow(sqrt(2*cntrl.Ecut),3)*(gInfo.detR/(6*M_PI*M_PI)));
-	logFlush();
+	setupBasis();
+	autoTunePerformance(*this);
 
 	//Check if DOS calculator is needed:
 	if(!dump.dos)
@@ -111,6 +112,8 @@ void Everything::setup()
 	bool exxPresent = coulombParams.omegaSet.size();
 	if(dump.polarizability || dump.electronScattering) coulombParams.omegaSet.insert(0.); //These are not EXX, but they use Coulomb_ExchangeEval
 	for(const auto& entry: dump) if(entry.second==DumpFCI) coulombParams.omegaSet.insert(0.); //DumpFCI also uses Coulomb_ExchangeEval
+	if((dump.polarizability || dump.electronScattering) and not (coulombParams.exchangeDownsample == vector3<int>(1,1,1)))
+		die("exchange-q-downsample is not supported for polarizability and electron-scattering.\n\n");
 	
 	//Coulomb-interaction setup (with knowledge of exact-exchange requirements):
 	updateSupercell();
@@ -130,12 +133,7 @@ void Everything::setup()
 		}
 	}
 	//--- for fluid (must be D2):
-	if(eVars.fluidParams.needsVDW())
-	{	if(iInfo.vdWenable and (iInfo.vdWstyle == VDW_D2))
-			vanDerWaalsFluid = std::static_pointer_cast<VanDerWaalsD2>(vanDerWaals); //reuse D2 created above
-		else
-			vanDerWaalsFluid = std::make_shared<VanDerWaalsD2>(*this, "fluid / solvation");
-	}
+	setupFluidVDW();
 	if(iInfo.ljOverride) eVars.skipWfnsInit = true; //don't need electronic degrees of freedom
 	
 	//Setup wavefunctions, densities, fluid, output module etc:
@@ -147,13 +145,7 @@ void Everything::setup()
 	if(vibrations) vibrations->setup(this);
 	
 	//Setup electronic minimization parameters:
-	elecMinParams.nDim = 0;
-	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
-	{	elecMinParams.nDim += 2 * basis[q].nbasis * eInfo.nBands;
-		if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub)
-			elecMinParams.nDim += eInfo.nBands * eInfo.nBands;
-	}
-	mpiWorld->allReduce(elecMinParams.nDim, MPIUtil::ReduceSum);
+	setupElecMinDim();
 	elecMinParams.fpLog = globalLog;
 	elecMinParams.linePrefix = "ElecMinimize: ";
 	elecMinParams.energyLabel = relevantFreeEnergyName(*this);
@@ -171,13 +163,122 @@ void Everything::setup()
 	ionicMinParams.energyFormat = "%+.15lf";
 	
 	//Setup fluid minimization parameters:
+	setupFluidMinParams();
+	
+	//Setup lattice minimization parameters:
+	latticeMinParams.fpLog = globalLog;
+	latticeMinParams.linePrefix = "LatticeMinimize: ";
+	latticeMinParams.energyLabel = relevantFreeEnergyName(*this);
+	latticeMinParams.energyFormat = "%+.15lf";
+
+	logPrintf("\n"); logFlush();
+}
+
+
+void Everything::resetFluid(const FluidSolverParams& fsp, const MinimizeParams& fluidMinParams)
+{	eVars.fluidSolver = 0; //free previous solver first
+	eVars.d_fluid = 0;
+	eVars.V_cavity = 0;
+	ener.E.erase("A_diel");
+	ener.E.erase("MuShift");
+	eVars.fluidParams = fsp;
+	this->fluidMinParams = fluidMinParams;
+	setupFluidVDW();
+	if(eVars.fluidParams.fluidType != FluidNone)
+	{	logPrintf("----- createFluidSolver() ----- (Fluid-side solver setup)\n");
+		eVars.fluidSolver = std::shared_ptr<FluidSolver>(createFluidSolver(*this, eVars.fluidParams));
+		if(!eVars.fluidSolver) die("Failed to create fluid solver.\n");
+	}
+	setupFluidMinParams();
+	logPrintf("\n"); logFlush();
+}
+
+void Everything::setupBasis()
+{	//Set up the reduced bases for wavefunctions:
+	logPrintf("\n----- Setting up reduced wavefunction bases (%s) -----\n",
+		(cntrl.basisKdep==BasisKpointIndep) ? "single at Gamma point" :  "one per k-point");
+	basis.resize(eInfo.nStates);
+	double avg_nbasis = 0.;
+	const GridInfo& gInfoBasis = gInfoWfns ? *gInfoWfns : gInfo;
+	std::multimap<size_t,int> qByHash; //bases set up so far that own their index arrays, by G-vector set hash
+	int nShared = 0;
+	if(!cntrl.shouldPrintKpointsBasis) logSuspend();
+	for(int q=0; q<eInfo.nStates; q++)
+	{	if(cntrl.basisKdep==BasisKpointDep)
+		{	basis[q].setup(gInfoBasis, iInfo, cntrl.Ecut, eInfo.qnums[q].k);
+			//Share index arrays with an earlier basis with the identical G-vector set (eg. other spin channel), if any:
+			size_t hash = basis[q].hash();
+			bool shared = false;
+			auto range = qByHash.equal_range(hash);
+			for(auto iter=range.first; iter!=range.second; iter++)
+				if((shared = basis[q].share(basis[iter->second])))
+					break;
+			if(shared) nShared++;
+			else qByHash.insert(std::make_pair(hash, q));
+		}
+		else
+		{	if(q==0) basis[q].setup(gInfoBasis, iInfo, cntrl.Ecut, vector3<>(0,0,0));
+			else basis[q] = basis[0];
+		}
+		avg_nbasis += eInfo.qnums[q].weight * basis[q].nbasis;
+	}
+	avg_nbasis /= eInfo.qWeightSum;
+	if(!cntrl.shouldPrintKpointsBasis) logResume();
+	if(nShared) logPrintf("Sharing G-vector index arrays of %d of %d bases with identical G-vector sets.\n", nShared, eInfo.nStates);
+	logPrintf("average nbasis = %7.3lf , ideal nbasis = %7.3lf\n", avg_nbasis,
+		pow(sqrt(2*cntrl.Ecut),3)*(gInfo.detR/(6*M_PI*M_PI)));
+	logFlush();
+}
+
+void Everything::setupElecMinDim()
+{	elecMinParams.nDim = 0;
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+	{	elecMinParams.nDim += 2 * basis[q].nbasis * eInfo.nBands;
+		if(eInfo.fillingsUpdate==ElecInfo::FillingsHsub)
+			elecMinParams.nDim += eInfo.nBands * eInfo.nBands;
+	}
+	mpiWorld->allReduce(elecMinParams.nDim, MPIUtil::ReduceSum);
+}
+
+void Everything::switchCutoff(double Ecut)
+{	if(Ecut == cntrl.Ecut) return;
+	if(exx) die("Changing the wavefunction cutoff in place is not supported with exact exchange.\n");
+	if(cntrl.bandStreaming) die("Changing the wavefunction cutoff in place is not supported with band-streaming.\n");
+	logPrintf("\nSwitching wavefunction cutoff from %lg to %lg Eh (on the existing grids).\n", cntrl.Ecut, Ecut);
+	//Keep the current bases alive for the transfer (copies share their index arrays, which setup replaces):
+	std::vector<Basis> basisOld = basis;
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		if(eVars.C[q]) eVars.C[q].basis = &basisOld[q];
+	cntrl.Ecut = Ecut;
+	setupBasis();
+	for(auto sp: iInfo.species) sp->clearProjectorCache(); //cached by basis pointer, whose contents changed
+	//Map wavefunction coefficients by G-vector and re-orthonormalize:
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		if(eVars.C[q])
+		{	eVars.C[q] = switchBasis(eVars.C[q], basis[q]);
+			eVars.orthonormalize(q);
+		}
+	setupElecMinDim();
+}
+
+void Everything::setupFluidVDW()
+{	if(eVars.fluidParams.needsVDW() and (not vanDerWaalsFluid))
+	{	if(iInfo.vdWenable and (iInfo.vdWstyle == VDW_D2))
+			vanDerWaalsFluid = std::static_pointer_cast<VanDerWaalsD2>(vanDerWaals); //reuse D2 created for electronic system
+		else
+			vanDerWaalsFluid = std::make_shared<VanDerWaalsD2>(*this, "fluid / solvation");
+	}
+}
+
+void Everything::setupFluidMinParams()
+{	int nrFluid = (eVars.fluidSolver && eVars.fluidSolver->gInfoFluid) ? eVars.fluidSolver->gInfoFluid->nr : gInfo.nr; //sample count of coarse fluid grid, if any
 	switch(eVars.fluidParams.fluidType)
 	{	case FluidLinearPCM:
 		case FluidSaLSA:
-			fluidMinParams.nDim = gInfo.nr; break;
-		case FluidNonlinearPCM: fluidMinParams.nDim = 4 * gInfo.nr; break;
+			fluidMinParams.nDim = nrFluid; break;
+		case FluidNonlinearPCM: fluidMinParams.nDim = 4 * nrFluid; break;
 		case FluidClassicalDFT:
-			fluidMinParams.nDim = 4 * gInfo.nr; 
+			fluidMinParams.nDim = 4 * nrFluid; 
 			break;
 		default:
 			fluidMinParams.nDim = 0;
@@ -198,17 +299,8 @@ void Everything::setup()
 			 || eVars.fluidParams.fluidType==FluidSaLSA) )
 			fluidMinParams.fpLog = nullLog;
 	}
-	
-	//Setup lattice minimization parameters:
-	latticeMinParams.fpLog = globalLog;
-	latticeMinParams.linePrefix = "LatticeMinimize: ";
-	latticeMinParams.energyLabel = relevantFreeEnergyName(*this);
-	latticeMinParams.energyFormat = "%+.15lf";
-
-	logPrintf("\n"); logFlush();
 }
 
-
 void Everything::updateSupercell(bool force)
 {	if(force || coulombParams.omegaSet.size() || dump.dos || dump.electronScattering)
 	{	//Initialize k-point sampled supercell:
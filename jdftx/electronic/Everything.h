@@ -36,6 +36,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Dump.h>
 #include <electronic/SCFparams.h>
 #include <electronic/IonicDynamicsParams.h>
+#include <electronic/NudgedElasticBandParams.h>
 #include <memory>
 
 //! @addtogroup ElectronicDFT
@@ -66,6 +67,7 @@ public:
 	MinimizeParams latticeMinParams; //!< lattice minimization parameters
 	MinimizeParams inverseKSminParams; //!< Inverse Kohn-sham minimization parameters
 	IonicDynamicsParams ionicDynParams; //!< Molecular dynamics parameters
+	NudgedElasticBandParams nebParams; //!< Nudged elastic band parameters
 	SCFparams scfParams; //!< Self-consistent field mixing parameters
 	
 	CoulombParams coulombParams; //!< Coulomb truncation parameters
@@ -75,10 +77,19 @@ public:
 	std::shared_ptr<VanDerWaals> vanDerWaals; //! vdw correction calculator for electronic system
 	std::shared_ptr<VanDerWaalsD2> vanDerWaalsFluid; //!< vdW correction calculation for fluid coupling / solvation
 	std::shared_ptr<class Vibrations> vibrations; //! Vibrational mode calculator
+	std::shared_ptr<class IpiDriver> ipiDriver; //!< socket driver for energy and force evaluations requested by an external code
+	std::shared_ptr<class StateStore> stateStore; //!< database of converged states for initialization of nearby structures
 
 	//! Call the setup/initialize routines of all the above in the necessray order
 	void setup();
 	void updateSupercell(bool force=false); //!< (re-)initialize coulombParams.supercell if necessary (or if forced)
+	void resetFluid(const FluidSolverParams& fsp, const MinimizeParams& fluidMinParams); //!< replace fluid and fluid-minimize parameters, and recreate the fluid solver after setup (used by SolvationBatch)
+	void switchCutoff(double Ecut); //!< change the wavefunction cutoff on the existing grids after setup, mapping the wavefunctions by G-vector (used by elec-cutoff-ladder)
+private:
+	void setupBasis(); //!< (re-)initialize the wavefunction bases for cntrl.Ecut
+	void setupElecMinDim(); //!< set elecMinParams.nDim for the current bases
+	void setupFluidVDW(); //!< create vdW calculator for the fluid, if needed by eVars.fluidParams
+	void setupFluidMinParams(); //!< set dimensions and logging of fluidMinParams for the current fluid solver
 };
 
 //! @}
@@ -95,6 +95,21 @@ void FunctionalLDA::evaluate(int N, std::vector<const double*> n, std::vector<co
 	callPref(LDA)(variant, N, n, E, E_n, scaleFac);
 }
 
+template<LDA_Variant variant, int nCount>
+void LDA_second(int N, const double* n, double* E_nn, double scaleFac)
+{	threadedLoop(LDA_calc2<variant,nCount>::compute, N, n, E_nn, scaleFac);
+}
+void LDA_second(LDA_Variant variant, int N, const double* n, double* E_nn, double scaleFac)
+{	SwitchTemplate_LDA(variant, 1, LDA_second, (N, n, E_nn, scaleFac) )
+}
+#ifdef GPU_ENABLED
+void LDA_second_gpu(LDA_Variant variant, int N, const double* n, double* E_nn, double scaleFac);
+#endif
+
+void FunctionalLDA::evaluateSecondDerivatives(int N, const double* n, double* E_nn) const
+{	callPref(LDA_second)(variant, N, n, E_nn, scaleFac);
+}
+
 //---------------- GGA thread launcher / gpu switch --------------------
 
 FunctionalGGA::FunctionalGGA(GGA_Variant variant, double scaleFac) : Functional(scaleFac), variant(variant)
@@ -145,6 +160,8 @@ FunctionalMGGA::FunctionalMGGA(mGGA_Variant variant, double scaleFac) : Function
 		case mGGA_C_TPSS: logPrintf("Initalized TPSS mGGA correlation.\n"); break;
 		case mGGA_X_revTPSS: logPrintf("Initalized revTPSS mGGA exchange.\n"); break;
 		case mGGA_C_revTPSS: logPrintf("Initalized revTPSS mGGA correlation.\n"); break;
+		case mGGA_X_r2SCAN: logPrintf("Initalized r2SCAN mGGA exchange.\n"); break;
+		case mGGA_C_r2SCAN: logPrintf("Initalized r2SCAN mGGA correlation.\n"); break;
 	}
 }
 
@@ -185,6 +202,14 @@ void FunctionalMGGA::evaluate(int N, std::vector<const double*> n, std::vector<c
 #ifdef LIBXC_ENABLED
 #include <xc.h>
 
+#if defined(GPU_ENABLED) && defined(LIBXC_CUDA)
+#define LIBXC_ON_GPU //LibXC's CUDA build evaluates functionals directly on device data
+//Conversion to / from LibXC's spin-interleaved layout on the GPU (implemented in ExCorr.cu):
+void libxcPack_gpu(int N, int nComp, int c, const double* in, double* buf);
+void libxcUnpack_gpu(int N, const double* nTot, int nComp, int c, const double* buf, double* out); //accumulate where nTot >= nCutoff
+void libxcFixTau_gpu(int N, int nCount, double* n, const double* sigma, double* tau);
+#endif
+
 #if XC_MAJOR_VERSION >= 4
 //Provide wrapper emulating libxc v3's interface to get XC reference:
 char const* xc_func_info_get_ref(const xc_func_info_type *info, int number)
@@ -206,6 +231,7 @@ public:
 	bool hasEnergy() const { return (funcUnpolarized.info->flags & XC_FLAGS_HAVE_EXC); }
 	double exxScale() const { return funcUnpolarized.cam_omega>0 ? funcUnpolarized.cam_beta : funcUnpolarized.cam_alpha; }
 	double exxOmega() const { return funcUnpolarized.cam_omega; }
+	bool hasSecondDerivatives() const { return (funcUnpolarized.info->flags & XC_FLAGS_HAVE_FXC) && !needsTau(); } //!< analytic fxc available (LDAs and GGAs)
 	
 	FunctionalLibXC(int xcCode, const char* typeName)
 	{	if(xc_func_init(&funcUnpolarized, xcCode, XC_UNPOLARIZED) != 0)
@@ -243,62 +269,14 @@ public:
 		std::vector<double> E_sigmaTemp(E_n && needsSigma() ? Nsigma : 0);
 		std::vector<double> E_lapTemp(E_n && needsLap() ? Nn : 0);
 		std::vector<double> E_tauTemp(E_n && needsTau() ? Nn : 0);
-		//Invoke appropriate LibXC function in scratch space:
+		//Project out problematic mGGA points (not handled correctly by LibXC 4):
+		#if XC_MAJOR_VERSION >= 4
 		if(needsTau())
-		{	//Project out problematic mGGA points (not handled correctly by LibXC 4:
-			#if XC_MAJOR_VERSION >= 4
 			for(int i=0; i<N; i++)
-			{	double* nPtr = (double*)(n + i*nCount);
-				double* tauPtr = (double*)(tau + i*nCount);
-				double nTot = nCount==1 ? *nPtr : (*nPtr + *(nPtr+1));
-				double tauTot = nCount==1 ? *tauPtr : (*tauPtr + *(tauPtr+1));
-				double sigmaTot = nCount==1 ? sigma[i] : sigma[3*i]+2*sigma[3*i+1]+sigma[3*i+2];
-				bool zOffRange = 0.125*sigmaTot > (nTot * tauTot);
-				if(tauTot < tauCutoff) //Small tau
-				{	if(nCount==1)
-					{	*nPtr = 0.;
-						*tauPtr = 0.;
-					}
-					else
-					{	*nPtr = *(nPtr+1) = 0.;
-						*tauPtr = *(tauPtr+1) = 0.;
-					}
-				}
-				else if(zOffRange && nTot>nCutoff) //tauVW/tau ratio out of range
-				{	double tauTotNew = 0.125*sigmaTot/nTot; //von-Weisacker value
-					if(nCount==1)
-						*tauPtr = tauTotNew;
-					else
-					{	double tauScale = tauTotNew/tauTot;
-						*tauPtr *= tauScale;
-						*(tauPtr+1) *= tauScale;
-					}
-				}
-			}
-			#endif
-			if(E_n) //need gradient
-			{	if(hasEnergy())
-					xc_mgga_exc_vxc(&func, N, n, sigma, lap, tau,
-						&eTemp[0], &E_nTemp[0], &E_sigmaTemp[0], &E_lapTemp[0], &E_tauTemp[0]);
-				else
-					xc_mgga_vxc(&func, N, n, sigma, lap, tau, &E_nTemp[0], &E_sigmaTemp[0], &E_lapTemp[0], &E_tauTemp[0]);
-			}
-			else if(hasEnergy()) xc_mgga_exc(&func, N, n, sigma, lap, tau, &eTemp[0]);
-		}
-		else if(needsSigma())
-		{	if(E_n) //need gradient
-			{	if(hasEnergy()) xc_gga_exc_vxc(&func, N, n, sigma, &eTemp[0], &E_nTemp[0], &E_sigmaTemp[0]);
-				else xc_gga_vxc(&func, N, n, sigma, &E_nTemp[0], &E_sigmaTemp[0]);
-			}
-			else if(hasEnergy()) xc_gga_exc(&func, N, n, sigma, &eTemp[0]);
-		}
-		else
-		{	if(E_n) //need gradient
-			{	if(hasEnergy()) xc_lda_exc_vxc(&func, N, n, &eTemp[0], &E_nTemp[0]);
-				else xc_lda_vxc(&func, N, n, &E_nTemp[0]);
-			}
-			else if(hasEnergy()) xc_lda_exc(&func, N, n, &eTemp[0]);
-		}
+				libxcFixTau_calc(i, nCount, (double*)n, sigma, (double*)tau);
+		#endif
+		//Invoke appropriate LibXC function in scratch space:
+		compute(func, N, n, sigma, lap, tau, eTemp.data(), E_nTemp.data(), E_sigmaTemp.data(), E_lapTemp.data(), E_tauTemp.data());
 		//Accumulate onto final results
 		eblas_daxpy(N, 1., &eTemp[0], 1, e, 1);
 		if(E_nTemp.size()) eblas_daxpy(Nn, 1., &E_nTemp[0], 1, E_n, 1);
@@ -307,54 +285,217 @@ public:
 		if(E_tauTemp.size()) eblas_daxpy(Nn, 1., &E_tauTemp[0], 1, E_tau, 1);
 	}
 	
-	static void evaluate_thread(int iStart, int iStop, const FunctionalLibXC* func, int iOffset,
-		int nCount, const double* n, const double* sigma, const double* lap, const double* tau,
-		double* e, double* E_n, double* E_sigma, double* E_lap, double* E_tau)
+	#ifdef LIBXC_ON_GPU
+	//! Like evaluate, but with all data on the GPU
+	void evaluateGpu(int nCount, int N,
+		const double* n, const double* sigma, const double* lap, const double* tau,
+		double* e, double* E_n, double* E_sigma, double* E_lap, double* E_tau) const
 	{
-		int offs_e = (iOffset+iStart);
-		int offs_n = offs_e * nCount;
-		int offs_sigma = offs_e * (2*nCount-1);
-		int N = iStop-iStart; if(!N) return;
-		#define OFFSET(ptr,offset) ((ptr) ? ((ptr)+(offset)) : 0)
-		func->evaluate(nCount, N, OFFSET(n,offs_n), OFFSET(sigma,offs_sigma), OFFSET(lap,offs_n), OFFSET(tau,offs_n),
-			OFFSET(e,offs_e), OFFSET(E_n,offs_n), OFFSET(E_sigma,offs_sigma), OFFSET(E_lap,offs_n), OFFSET(E_tau,offs_n) );
-		#undef OFFSET
+		assert(nCount==1 || nCount==2);
+		const xc_func_type& func = (nCount==1) ? funcUnpolarized : funcPolarized;
+		int sigmaCount = 2*nCount-1; //1 for unpolarized, 3 for polarized
+		int Nn = N * nCount;
+		int Nsigma = N * sigmaCount;
+		//Allocate temporaries on the GPU:
+		ManagedArray<double> eTemp, E_nTemp, E_sigmaTemp, E_lapTemp, E_tauTemp;
+		auto alloc = [](ManagedArray<double>& arr, int size)
+		{	if(!size) return (double*)0;
+			arr.init(size, true);
+			return arr.dataGpu();
+		};
+		double* eData = alloc(eTemp, N); eTemp.zero(); //left untouched by functionals without energy
+		double* E_nData = alloc(E_nTemp, E_n ? Nn : 0);
+		double* E_sigmaData = alloc(E_sigmaTemp, E_n && needsSigma() ? Nsigma : 0);
+		double* E_lapData = alloc(E_lapTemp, E_n && needsLap() ? Nn : 0);
+		double* E_tauData = alloc(E_tauTemp, E_n && needsTau() ? Nn : 0);
+		#if XC_MAJOR_VERSION >= 4
+		if(needsTau()) libxcFixTau_gpu(N, nCount, (double*)n, sigma, (double*)tau);
+		#endif
+		compute(func, N, n, sigma, lap, tau, eData, E_nData, E_sigmaData, E_lapData, E_tauData);
+		//Accumulate onto final results
+		eblas_daxpy_gpu(N, 1., eData, 1, e, 1);
+		if(E_nData) eblas_daxpy_gpu(Nn, 1., E_nData, 1, E_n, 1);
+		if(E_sigmaData) eblas_daxpy_gpu(Nsigma, 1., E_sigmaData, 1, E_sigma, 1);
+		if(E_lapData) eblas_daxpy_gpu(Nn, 1., E_lapData, 1, E_lap, 1);
+		if(E_tauData) eblas_daxpy_gpu(Nn, 1., E_tauData, 1, E_tau, 1);
 	}
+	#endif
 	
-	void evaluateSub(int nCount, int iStart, int iStop,
-		const double* n, const double* sigma, const double* lap, const double* tau,
+	//! Accumulate analytic second derivatives of the spin-unpolarized energy density (per volume) w.r.t n
+	//! and (for GGAs) sigma, using LibXC's fxc. Data must be on the GPU if LibXC is (LIBXC_ON_GPU).
+	void evaluateSecondDerivatives(int N, const double* n, const double* sigma,
+		double* E_nn, double* E_nsigma, double* E_sigmasigma) const
+	{	assert(hasSecondDerivatives());
+		std::vector<double*> out(1, E_nn);
+		if(needsSigma()) { out.push_back(E_nsigma); out.push_back(E_sigmasigma); }
+		//Compute into temporaries (LibXC overwrites outputs):
+		#ifdef LIBXC_ON_GPU
+		ManagedArray<double> buf; buf.init(N*out.size(), true);
+		double* temp = buf.dataGpu();
+		#else
+		std::vector<double> buf(N*out.size());
+		double* temp = buf.data();
+		#endif
+		if(needsSigma()) xc_gga_fxc(&funcUnpolarized, N, n, sigma, temp, temp+N, temp+2*N);
+		else xc_lda_fxc(&funcUnpolarized, N, n, temp);
+		//Accumulate onto final results:
+		for(unsigned c=0; c<out.size(); c++)
+		#ifdef LIBXC_ON_GPU
+			eblas_daxpy_gpu(N, 1., temp+c*N, 1, out[c], 1);
+		#else
+			eblas_daxpy(N, 1., temp+c*N, 1, out[c], 1);
+		#endif
+	}
+	
+	//! Spin-separated inputs and outputs for evaluateBlocked (same layout as for the internal functionals; unused ones empty)
+	struct BlockedArgs
+	{	int nCount; //!< number of spin components
+		std::vector<const FunctionalLibXC*> funcs; //!< functionals to evaluate together
+		std::vector<const double*> n, sigma, lap, tau; //!< inputs with nCount, 2*nCount-1, nCount and nCount components
+		double* e; //!< per-particle energy (accumulated)
+		std::vector<double*> E_n, E_sigma, E_lap, E_tau; //!< gradients (accumulated, empty if not needed)
+	};
+	
+	//! Evaluate args.funcs on points [iStart,iStop) in cache-sized blocks processed dynamically by the thread pool.
+	//! Each block is packed into spin-interleaved per-thread buffers (reused between blocks and calls) as needed by LibXC,
+	//! skipping points whose total density is below nCutoff (whose contributions vanish).
+	static void evaluateBlocked(int iStart, int iStop, const BlockedArgs& args)
+	{	const size_t blockSize = 1024;
+		if(iStop > iStart)
+			threadLaunchDynamic(0, evaluateBlock, iStop-iStart, blockSize, iStart, &args);
+	}
+	
+	#ifdef LIBXC_ON_GPU
+	//! Evaluate args.funcs on points [iStart,iStop) with all inputs and outputs on the GPU, packing them into
+	//! LibXC's spin-interleaved layout on the device, and accumulating only points with total density above nCutoff
+	static void evaluateGpu(int iStart, int iStop, const BlockedArgs& args)
+	{	int N = iStop - iStart;
+		if(N <= 0) return;
+		auto pack = [&](const std::vector<const double*>& in, ManagedArray<double>& buf)
+		{	int nComp = in.size();
+			if(!nComp) return (double*)0;
+			buf.init(N*nComp, true);
+			for(int c=0; c<nComp; c++)
+				libxcPack_gpu(N, nComp, c, in[c]+iStart, buf.dataGpu());
+			return buf.dataGpu();
+		};
+		auto zero = [&](const std::vector<double*>& out, ManagedArray<double>& buf)
+		{	if(!out.size()) return (double*)0;
+			buf.init(N*out.size(), true);
+			buf.zero();
+			return buf.dataGpu();
+		};
+		//Total density before evaluation (which may modify the packed inputs) selects points to accumulate:
+		ManagedArray<double> nTot; nTot.init(N, true); nTot.zero();
+		for(const double* nData: args.n)
+			eblas_daxpy_gpu(N, 1., nData+iStart, 1, nTot.dataGpu(), 1);
+		ManagedArray<double> nBuf, sigmaBuf, lapBuf, tauBuf, eBuf, E_nBuf, E_sigmaBuf, E_lapBuf, E_tauBuf;
+		double* nData = pack(args.n, nBuf);
+		double* sigmaData = pack(args.sigma, sigmaBuf);
+		double* lapData = pack(args.lap, lapBuf);
+		double* tauData = pack(args.tau, tauBuf);
+		double* eData = zero(std::vector<double*>(1, args.e), eBuf);
+		double* E_nData = zero(args.E_n, E_nBuf);
+		double* E_sigmaData = zero(args.E_sigma, E_sigmaBuf);
+		double* E_lapData = zero(args.E_lap, E_lapBuf);
+		double* E_tauData = zero(args.E_tau, E_tauBuf);
+		//Evaluate all functionals:
+		for(const FunctionalLibXC* func: args.funcs)
+			func->evaluateGpu(args.nCount, N, nData, sigmaData, lapData, tauData,
+				eData, E_nData, E_sigmaData, E_lapData, E_tauData);
+		//Unpack (accumulate) outputs:
+		auto unpack = [&](ManagedArray<double>& buf, const std::vector<double*>& out)
+		{	int nComp = out.size();
+			for(int c=0; c<nComp; c++)
+				libxcUnpack_gpu(N, nTot.dataGpu(), nComp, c, buf.dataGpu(), out[c]+iStart);
+		};
+		unpack(eBuf, std::vector<double*>(1, args.e));
+		unpack(E_nBuf, args.E_n);
+		unpack(E_sigmaBuf, args.E_sigma);
+		unpack(E_lapBuf, args.E_lap);
+		unpack(E_tauBuf, args.E_tau);
+	}
+	#endif
+	
+private:
+	//! Invoke the appropriate LibXC function on spin-interleaved data (outputs overwritten; e left untouched without energy)
+	void compute(const xc_func_type& func, int N, const double* n, const double* sigma, const double* lap, const double* tau,
 		double* e, double* E_n, double* E_sigma, double* E_lap, double* E_tau) const
-	{
-		int N = iStop-iStart; if(!N) return;
-		threadLaunch(FunctionalLibXC::evaluate_thread, N, this, iStart,
-			nCount, n, sigma, lap, tau, e, E_n, E_sigma, E_lap, E_tau);
+	{	if(needsTau())
+		{	if(E_n) //need gradient
+			{	if(hasEnergy()) xc_mgga_exc_vxc(&func, N, n, sigma, lap, tau, e, E_n, E_sigma, E_lap, E_tau);
+				else xc_mgga_vxc(&func, N, n, sigma, lap, tau, E_n, E_sigma, E_lap, E_tau);
+			}
+			else if(hasEnergy()) xc_mgga_exc(&func, N, n, sigma, lap, tau, e);
+		}
+		else if(needsSigma())
+		{	if(E_n) //need gradient
+			{	if(hasEnergy()) xc_gga_exc_vxc(&func, N, n, sigma, e, E_n, E_sigma);
+				else xc_gga_vxc(&func, N, n, sigma, E_n, E_sigma);
+			}
+			else if(hasEnergy()) xc_gga_exc(&func, N, n, sigma, e);
+		}
+		else
+		{	if(E_n) //need gradient
+			{	if(hasEnergy()) xc_lda_exc_vxc(&func, N, n, e, E_n);
+				else xc_lda_vxc(&func, N, n, E_n);
+			}
+			else if(hasEnergy()) xc_lda_exc(&func, N, n, e);
+		}
+	}
+	
+	static void evaluateBlock(size_t iStart, size_t iStop, int iOffset, const BlockedArgs* args)
+	{	thread_local std::vector<int> index;
+		thread_local std::vector<double> nBuf, sigmaBuf, lapBuf, tauBuf, eBuf, E_nBuf, E_sigmaBuf, E_lapBuf, E_tauBuf;
+		//Select points above density cutoff:
+		index.clear();
+		for(size_t i=iStart+iOffset; i<iStop+iOffset; i++)
+		{	double nTot = 0.;
+			for(const double* nData: args->n) nTot += nData[i];
+			if(nTot >= nCutoff) index.push_back(i);
+		}
+		int N = index.size(); if(!N) return;
+		//Pack inputs and zero outputs:
+		auto pack = [&](const std::vector<const double*>& in, std::vector<double>& buf)
+		{	int nComp = in.size();
+			buf.resize(N*nComp);
+			for(int c=0; c<nComp; c++)
+				for(int p=0; p<N; p++)
+					buf[p*nComp+c] = in[c][index[p]];
+			return nComp ? buf.data() : (double*)0;
+		};
+		auto zero = [&](const std::vector<double*>& out, std::vector<double>& buf)
+		{	buf.assign(N*out.size(), 0.);
+			return out.size() ? buf.data() : (double*)0;
+		};
+		double* nData = pack(args->n, nBuf);
+		double* sigmaData = pack(args->sigma, sigmaBuf);
+		double* lapData = pack(args->lap, lapBuf);
+		double* tauData = pack(args->tau, tauBuf);
+		eBuf.assign(N, 0.);
+		double* E_nData = zero(args->E_n, E_nBuf);
+		double* E_sigmaData = zero(args->E_sigma, E_sigmaBuf);
+		double* E_lapData = zero(args->E_lap, E_lapBuf);
+		double* E_tauData = zero(args->E_tau, E_tauBuf);
+		//Evaluate all functionals on this block:
+		for(const FunctionalLibXC* func: args->funcs)
+			func->evaluate(args->nCount, N, nData, sigmaData, lapData, tauData,
+				eBuf.data(), E_nData, E_sigmaData, E_lapData, E_tauData);
+		//Unpack (accumulate) outputs:
+		auto unpack = [&](const std::vector<double>& buf, const std::vector<double*>& out)
+		{	int nComp = out.size();
+			for(int c=0; c<nComp; c++)
+				for(int p=0; p<N; p++)
+					out[c][index[p]] += buf[p*nComp+c];
+		};
+		for(int p=0; p<N; p++) args->e[index[p]] += eBuf[p];
+		unpack(E_nBuf, args->E_n);
+		unpack(E_sigmaBuf, args->E_sigma);
+		unpack(E_lapBuf, args->E_lap);
+		unpack(E_tauBuf, args->E_tau);
 	}
 };
 
-//! Convert a collection of scalar fields into an interleaved vector field.
-//! result can be freed using delete[]
-template<unsigned M> double* transpose(const ScalarFieldArray& inVec)
-{	assert(inVec.size()==M);
-	const unsigned N = inVec[0]->nElem;
-	const double* in[M]; for(unsigned m=0; m<M; m++) in[m] = inVec[m]->data();
-	double *out = new double[M*N], *outPtr = out;
-	for(unsigned n=0; n<N; n++)
-		for(unsigned m=0; m<M; m++)
-			*(outPtr++) = in[m][n];
-	return out;
-}
-
-//! Convert an interleaved vector field to a collection of scalar fields
-template<unsigned M> void transpose(double* in, ScalarFieldArray& outVec)
-{	assert(outVec.size()==M);
-	const unsigned N = outVec[0]->nElem;
-	double* out[M]; for(unsigned m=0; m<M; m++) out[m] = outVec[m]->data();
-	double *inPtr = in;
-	for(unsigned n=0; n<N; n++)
-		for(unsigned m=0; m<M; m++)
-			out[m][n] = *(inPtr++);
-}
-
 #endif //LIBXC_ENABLED
 
 //----------------------- Functional List --------------------
@@ -472,6 +613,11 @@ void ExCorr::setup(const Everything& everything)
 			functionals->add(mGGA_C_revTPSS);
 			Citations::add(citeReason, "J.P. Perdew et al., Phys. Rev. Lett. 103, 026403 (2009)");
 			break;
+		case ExCorrMGGA_r2SCAN:
+			functionals->add(mGGA_X_r2SCAN);
+			functionals->add(mGGA_C_r2SCAN);
+			Citations::add(citeReason, "J.W. Furness, A.D. Kaplan, J. Ning, J.P. Perdew and J. Sun, J. Phys. Chem. Lett. 11, 8208 (2020)");
+			break;
 		case ExCorrORB_GLLBsc:
 			if(e->eInfo.spinType == SpinVector)
 				die("GLLLB-sc functional not implemented for noncollinear spin-polarized calculations.\n");
@@ -631,6 +777,62 @@ template<typename Func> bool shouldInclude(const std::shared_ptr<Func>& function
 	return hasNeeded;
 }
 
+//Inputs and outputs of pointwise functionals on the irreducible grid points of the current process (see Symmetries::gatherIrreducible),
+//or directly the full grid fields when symm is null. Outputs are accumulated to the full grid fields by finish().
+class IrreducibleArrays
+{	const Symmetries* symm;
+	std::vector<std::shared_ptr<ManagedArray<double>>> inputs;
+	std::vector<std::pair<ScalarField, std::shared_ptr<ManagedArray<double>>>> outputs;
+	
+	std::shared_ptr<ManagedArray<double>> allocate()
+	{	auto arr = std::make_shared<ManagedArray<double>>();
+		arr->init(symm->nIrreducible());
+		return arr;
+	}
+public:
+	IrreducibleArrays(const Symmetries* symm) : symm(symm) {}
+	
+	const double* input(const ScalarField& x, bool onCpu)
+	{	if(!x) return 0;
+		if(!symm) return onCpu ? x->data() : x->dataPref();
+		auto arr = allocate();
+		symm->gatherIrreducible(x->data(), arr->data());
+		inputs.push_back(arr);
+		return onCpu ? arr->data() : arr->dataPref();
+	}
+	
+	double* output(const ScalarField& x, bool onCpu)
+	{	if(!x) return 0;
+		if(!symm) return onCpu ? x->data() : x->dataPref();
+		auto arr = allocate();
+		arr->zero();
+		outputs.push_back(std::make_pair(x, arr));
+		return onCpu ? arr->data() : arr->dataPref();
+	}
+	
+	std::vector<const double*> input(const ScalarFieldArray& x, bool onCpu=false)
+	{	std::vector<const double*> xData;
+		for(const ScalarField& xs: x) xData.push_back(input(xs, onCpu));
+		return xData;
+	}
+	
+	std::vector<double*> output(const ScalarFieldArray& x, bool onCpu=false)
+	{	std::vector<double*> xData;
+		for(const ScalarField& xs: x) xData.push_back(output(xs, onCpu));
+		return xData;
+	}
+	
+	int iStart(const GridInfo& gInfo) const { return symm ? 0 : gInfo.irStart; }
+	int iStop(const GridInfo& gInfo) const { return symm ? int(symm->nIrreducible()) : gInfo.irStop; }
+	
+	void finish()
+	{	for(auto& out: outputs)
+			symm->scatterIrreducible(out.second->data(), out.first->data());
+		outputs.clear();
+		inputs.clear();
+	}
+};
+
 double ExCorr::operator()(const ScalarFieldArray& n, ScalarFieldArray* Vxc, IncludeTXC includeTXC,
 		const ScalarFieldArray* tauPtr, ScalarFieldArray* Vtau, matrix3<>* Exc_RRT) const
 {
@@ -741,6 +943,9 @@ double ExCorr::operator()(const ScalarFieldArray& n, ScalarFieldArray* Vxc, Incl
 	for(int s=0; s<nCount; s++)
 		callPref(eblas_capMinMax)(gInfo.nr, nCapped[s]->dataPref(), nMin, nMax, 0.);
 
+	//Optionally evaluate functionals once per orbit of symmetry-equivalent grid points:
+	const Symmetries* symmIrred = (e and (&gInfo == &(e->gInfo)) and e->symm.hasIrreducibleGrid()) ? &(e->symm) : 0;
+	
 	//Compute the required contractions for GGA:
 	ScalarFieldArray sigma(sigmaCount), E_sigma(sigmaCount);
 	if(needsSigma)
@@ -760,56 +965,46 @@ double ExCorr::operator()(const ScalarFieldArray& n, ScalarFieldArray* Vxc, Incl
 	#ifdef LIBXC_ENABLED
 	//------------------ Evaluate LibXC functionals ---------------
 	if(functionals->libXC.size())
-	{	//Prepare input/output data on the CPU in transposed order (spins contiguous)
-		double *eData = E->data(), *nData=0, *sigmaData=0, *lapData=0, *tauData=0;
-		double *E_nData=0, *E_sigmaData=0, *E_lapData=0, *E_tauData=0;
-		if(nCount == 1)
-		{	nData = nCapped[0]->data();
-			if(needsSigma) sigmaData = sigma[0]->data();
-			if(needsLap) lapData = lap[0]->data();
-			if(needsTau) tauData = tau[0]->data();
+	{	//Collect inputs and outputs on the CPU, or with LibXC's CUDA build on the GPU
+		//(packed into LibXC's spin-interleaved order block by block, or all at once on the GPU):
+		#ifdef LIBXC_ON_GPU
+		const bool onCpu = false;
+		#else
+		const bool onCpu = true;
+		#endif
+		FunctionalLibXC::BlockedArgs args;
+		args.nCount = nCount;
+		for(auto func: functionals->libXC)
+			if(shouldInclude(func, includeTXC))
+				args.funcs.push_back(func.get());
+		IrreducibleArrays irred(symmIrred);
+		for(int s=0; s<nCount; s++)
+		{	args.n.push_back(irred.input(nCapped[s], onCpu));
+			if(needsLap) args.lap.push_back(irred.input(lap[s], onCpu));
+			if(needsTau) args.tau.push_back(irred.input(tau[s], onCpu));
 			if(needGradients)
-			{	E_nData = E_n[0]->data();
-				if(needsSigma) E_sigmaData = E_sigma[0]->data();
-				if(needsLap) E_lapData = E_lap[0]->data();
-				if(needsTau) E_tauData = E_tau[0]->data();
+			{	args.E_n.push_back(irred.output(E_n[s], onCpu));
+				if(needsLap) args.E_lap.push_back(irred.output(E_lap[s], onCpu));
+				if(needsTau) args.E_tau.push_back(irred.output(E_tau[s], onCpu));
 			}
 		}
-		else //Need to interleave input spin-vector fields:
-		{	nData = transpose<2>(nCapped);
-			if(needsSigma) sigmaData = transpose<3>(sigma);
-			if(needsLap) lapData = transpose<2>(lap);
-			if(needsTau) tauData = transpose<2>(tau);
-			if(needGradients)
-			{	E_nData = new double[2*gInfo.nr]; eblas_zero(2*gInfo.nr, E_nData);
-				if(needsSigma) { E_sigmaData = new double[3*gInfo.nr]; eblas_zero(3*gInfo.nr, E_sigmaData); }
-				if(needsLap) { E_lapData = new double[2*gInfo.nr]; eblas_zero(2*gInfo.nr, E_lapData); }
-				if(needsTau) { E_tauData = new double[2*gInfo.nr]; eblas_zero(2*gInfo.nr, E_tauData); }
+		if(needsSigma)
+			for(int s=0; s<sigmaCount; s++)
+			{	args.sigma.push_back(irred.input(sigma[s], onCpu));
+				if(needGradients) args.E_sigma.push_back(irred.output(E_sigma[s], onCpu));
 			}
-		}
+		args.e = irred.output(E, onCpu);
 		
 		//Calculate all the required functionals:
 		watchFunc.start();
-		for(auto func: functionals->libXC)
-			if(shouldInclude(func, includeTXC))
-				func->evaluateSub(nCount, gInfo.irStart, gInfo.irStop, nData, sigmaData, lapData, tauData,
-					eData, E_nData, E_sigmaData, E_lapData, E_tauData);
+		#ifdef LIBXC_ON_GPU
+		FunctionalLibXC::evaluateGpu(irred.iStart(gInfo), irred.iStop(gInfo), args);
+		#else
+		FunctionalLibXC::evaluateBlocked(irred.iStart(gInfo), irred.iStop(gInfo), args);
+		#endif
+		irred.finish();
 		watchFunc.stop();
 		
-		//Uninterleave spin-vector field results:
-		if(nCount != 1)
-		{	delete[] nData;
-			if(needsSigma) delete[] sigmaData;
-			if(needsLap) delete[] lapData;
-			if(needsTau) delete[] tauData;
-			if(needGradients)
-			{	transpose<2>(E_nData, E_n); delete[] E_nData;
-				if(needsSigma) { transpose<3>(E_sigmaData, E_sigma); delete[] E_sigmaData; }
-				if(needsLap) { transpose<2>(E_lapData, E_lap); delete[] E_lapData; }
-				if(needsTau) { transpose<2>(E_tauData, E_tau); delete[] E_tauData; }
-			}
-		}
-	
 		//Convert per-particle energy to energy density per volume
 		E = E * (nCount==1 ? nCapped[0] : nCapped[0]+nCapped[1]);
 	}
@@ -817,11 +1012,16 @@ double ExCorr::operator()(const ScalarFieldArray& n, ScalarFieldArray* Vxc, Incl
 	
 	//---------------- Compute internal functionals ----------------
 	watchFunc.start();
-	for(auto func: functionals->internal)
-		if(shouldInclude(func, includeTXC))
-			func->evaluateSub(gInfo.irStart, gInfo.irStop,
-				constDataPref(nCapped), constDataPref(sigma), constDataPref(lap), constDataPref(tau),
-				E->dataPref(), dataPref(E_n), dataPref(E_sigma), dataPref(E_lap), dataPref(E_tau));
+	{	IrreducibleArrays irred(symmIrred);
+		std::vector<const double*> nData = irred.input(nCapped), sigmaData = irred.input(sigma), lapData = irred.input(lap), tauData = irred.input(tau);
+		double* EData = irred.output(E, false);
+		std::vector<double*> E_nData = irred.output(E_n), E_sigmaData = irred.output(E_sigma), E_lapData = irred.output(E_lap), E_tauData = irred.output(E_tau);
+		for(auto func: functionals->internal)
+			if(shouldInclude(func, includeTXC))
+				func->evaluateSub(irred.iStart(gInfo), irred.iStop(gInfo),
+					nData, sigmaData, lapData, tauData, EData, E_nData, E_sigmaData, E_lapData, E_tauData);
+		irred.finish();
+	}
 	watchFunc.stop();
 	
 	//Cleanup unneeded derived quantities (free memory before starting communications and gradient propagation)
@@ -952,13 +1152,14 @@ inline void setMask(size_t iStart, size_t iStop, const double* n, double* mask,
 
 void ExCorr::getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, ScalarField& e_sigma, ScalarField& e_nsigma, ScalarField& e_sigmasigma, double nCut) const
 {
-	//Check for GGAs and meta GGAs:
-	bool needsSigma = false, needsTau=false, needsLap=false;
+	//Check for GGAs and meta GGAs, and for functionals without analytic second derivatives:
+	bool needsSigma = false, needsTau=false, needsLap=false, needsFD=false;
 	for(auto func: functionals->internal)
 		if(!func->hasKinetic())
 		{	needsSigma |= func->needsSigma();
 			needsLap |= func->needsLap();
 			needsTau |= func->needsTau();
+			needsFD |= !func->hasSecondDerivatives();
 		}
 	#ifdef LIBXC_ENABLED
 	for(auto func: functionals->libXC)
@@ -966,6 +1167,7 @@ void ExCorr::getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, Scala
 		{	needsSigma |= func->needsSigma();
 			needsLap |= func->needsLap();
 			needsTau |= func->needsTau();
+			needsFD |= !func->hasSecondDerivatives();
 		}
 	#endif
 	
@@ -990,6 +1192,28 @@ void ExCorr::getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, Scala
 		sigmaMinus = scaleMinus * sigma;
 	}
 	
+	//Analytic second derivatives, where available:
+	ScalarField E_nn, E_nsigma, E_sigmasigma;
+	nullToZero(E_nn, gInfo);
+	if(needsSigma)
+	{	nullToZero(E_nsigma, gInfo);
+		nullToZero(E_sigmasigma, gInfo);
+	}
+	for(auto func: functionals->internal)
+		if(!func->hasKinetic() && func->hasSecondDerivatives())
+			func->evaluateSecondDerivatives(gInfo.nr, n->dataPref(), E_nn->dataPref());
+	#ifdef LIBXC_ENABLED
+	for(auto func: functionals->libXC)
+		if(!func->hasKinetic() && func->hasSecondDerivatives())
+		#ifdef LIBXC_ON_GPU
+			func->evaluateSecondDerivatives(gInfo.nr, n->dataGpu(), needsSigma ? sigma->dataGpu() : 0,
+				E_nn->dataGpu(), needsSigma ? E_nsigma->dataGpu() : 0, needsSigma ? E_sigmasigma->dataGpu() : 0);
+		#else
+			func->evaluateSecondDerivatives(gInfo.nr, n->data(), needsSigma ? sigma->data() : 0,
+				E_nn->data(), needsSigma ? E_nsigma->data() : 0, needsSigma ? E_sigmasigma->data() : 0);
+		#endif
+	#endif
+	
 	//Configurations of n and sigma, and the gradients w.r.t them:
 	struct Config
 	{	const ScalarField *n, *sigma;
@@ -1003,9 +1227,12 @@ void ExCorr::getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, Scala
 	configs[4].n = &n;      configs[4].sigma = &sigmaMinus; // - dsigma
 	
 	//Compute the gradients at all the configurations:
+	//(The original point is needed only for the analytic e_sigma and includes all functionals,
+	//while the remaining configurations only include those without analytic second derivatives.)
 	ScalarField eTmp; nullToZero(eTmp, gInfo); //temporary energy return value (ignored)
 	for(int i=0; i<(needsSigma ? 5 : 3); i++)
-	{	Config& c = configs[i];
+	{	if(i==0 ? !needsSigma : !needsFD) continue;
+		Config& c = configs[i];
 		std::vector<const double*> nData(1), sigmaData(1), lapData(1), tauData(1);
 		std::vector<double*> e_nData(1), e_sigmaData(1), e_lapData(1), e_tauData(1);
 		double* eData = eTmp->dataPref();
@@ -1020,25 +1247,38 @@ void ExCorr::getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, Scala
 		#ifdef LIBXC_ENABLED
 		//Compute LibXC functionals:
 		for(auto func: functionals->libXC)
-			if(!func->hasKinetic())
+			if(!func->hasKinetic() && (i==0 || !func->hasSecondDerivatives()))
+			#ifdef LIBXC_ON_GPU
+				func->evaluateGpu(1, gInfo.nr, nData[0], sigmaData[0], lapData[0], tauData[0],
+					eData, e_nData[0], e_sigmaData[0], e_lapData[0], e_tauData[0]);
+			#else
 				func->evaluate(1, gInfo.nr, nData[0], sigmaData[0], lapData[0], tauData[0],
 					eData, e_nData[0], e_sigmaData[0], e_lapData[0], e_tauData[0]);
+			#endif
 		#endif
 		//Compute internal functionals:
 		for(auto func: functionals->internal)
-			if(!func->hasKinetic())
+			if(!func->hasKinetic() && (i==0 || !func->hasSecondDerivatives()))
 				func->evaluate(gInfo.nr, nData, sigmaData, lapData, tauData,
 					eData, e_nData, e_sigmaData, e_lapData, e_tauData);
 	}
 	
-	//Compute finite difference derivatives:
-	ScalarField nDen = (0.5/eps) * inv(n) * mask;
-	e_nn = nDen * (configs[1].e_n - configs[2].e_n);
+	//Combine analytic and finite difference derivatives:
+	e_nn = E_nn * mask;
+	ScalarField nDen, sigmaDen;
+	if(needsFD)
+	{	nDen = (0.5/eps) * inv(n) * mask;
+		e_nn += nDen * (configs[1].e_n - configs[2].e_n);
+	}
 	if(needsSigma)
-	{	ScalarField sigmaDen = (0.5/eps) * inv(sigma) * mask;
-		e_sigma = configs[0].e_sigma*mask; //First derivative available analytically
-		e_nsigma = 0.5*(nDen * (configs[1].e_sigma - configs[2].e_sigma) + sigmaDen * (configs[3].e_n - configs[4].e_n));
-		e_sigmasigma = sigmaDen * (configs[3].e_sigma - configs[4].e_sigma);
+	{	e_sigma = configs[0].e_sigma*mask; //First derivative available analytically
+		e_nsigma = E_nsigma * mask;
+		e_sigmasigma = E_sigmasigma * mask;
+		if(needsFD)
+		{	sigmaDen = (0.5/eps) * inv(sigma) * mask;
+			e_nsigma += 0.5*(nDen * (configs[1].e_sigma - configs[2].e_sigma) + sigmaDen * (configs[3].e_n - configs[4].e_n));
+			e_sigmasigma += sigmaDen * (configs[3].e_sigma - configs[4].e_sigma);
+		}
 	}
 	else
 	{	e_sigma = 0;
@@ -47,6 +47,41 @@ void spinDiagonalizeGrad_gpu(int N, std::vector<const double*> n, std::vector<co
 	gpuErrorCheck();
 }
 
+//---------------- Spin-interleaved data layout for LibXC's CUDA build --------------------
+
+__global__
+void libxcPack_kernel(int N, int nComp, int c, const double* in, double* buf)
+{	int i = kernelIndex1D();
+	if(i<N) buf[i*nComp+c] = in[i];
+}
+void libxcPack_gpu(int N, int nComp, int c, const double* in, double* buf)
+{	GpuLaunchConfig1D glc(libxcPack_kernel, N);
+	libxcPack_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, nComp, c, in, buf);
+	gpuErrorCheck();
+}
+
+__global__
+void libxcUnpack_kernel(int N, const double* nTot, int nComp, int c, const double* buf, double* out)
+{	int i = kernelIndex1D();
+	if(i<N && nTot[i]>=nCutoff) out[i] += buf[i*nComp+c];
+}
+void libxcUnpack_gpu(int N, const double* nTot, int nComp, int c, const double* buf, double* out)
+{	GpuLaunchConfig1D glc(libxcUnpack_kernel, N);
+	libxcUnpack_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, nTot, nComp, c, buf, out);
+	gpuErrorCheck();
+}
+
+__global__
+void libxcFixTau_kernel(int N, int nCount, double* n, const double* sigma, double* tau)
+{	int i = kernelIndex1D();
+	if(i<N) libxcFixTau_calc(i, nCount, n, sigma, tau);
+}
+void libxcFixTau_gpu(int N, int nCount, double* n, const double* sigma, double* tau)
+{	GpuLaunchConfig1D glc(libxcFixTau_kernel, N);
+	libxcFixTau_kernel<<<glc.nBlocks,glc.nPerBlock>>>(N, nCount, n, sigma, tau);
+	gpuErrorCheck();
+}
+
 //-------------------------- LDA GPU launch mechanism ----------------------------
 
 template<LDA_Variant variant, int nCount> __global__
@@ -64,6 +99,21 @@ void LDA_gpu(LDA_Variant variant, int N, std::vector<const double*> n, double* E
 {	SwitchTemplate_spin(SwitchTemplate_LDA, variant, n.size(), LDA_gpu, (N, n, E, E_n, scaleFac) )
 }
 
+template<LDA_Variant variant, int nCount> __global__
+void LDA_second_kernel(int N, const double* n, double* E_nn, double scaleFac)
+{	int i = kernelIndex1D();
+	if(i<N) LDA_calc2<variant,nCount>::compute(i, n, E_nn, scaleFac);
+}
+template<LDA_Variant variant, int nCount>
+void LDA_second_gpu(int N, const double* n, double* E_nn, double scaleFac)
+{	GpuLaunchConfig1D glc(LDA_second_kernel<variant,nCount>, N);
+	LDA_second_kernel<variant,nCount><<<glc.nBlocks,glc.nPerBlock>>>(N, n, E_nn, scaleFac);
+	gpuErrorCheck();
+}
+void LDA_second_gpu(LDA_Variant variant, int N, const double* n, double* E_nn, double scaleFac)
+{	SwitchTemplate_LDA(variant, 1, LDA_second_gpu, (N, n, E_nn, scaleFac) )
+}
+
 //-------------------------- GGA GPU launch mechanism ----------------------------
 
 template<GGA_Variant variant, bool spinScaling, int nCount> __global__
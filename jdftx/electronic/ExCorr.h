@@ -39,6 +39,7 @@ enum ExCorrType
 	ExCorrGGA_PW91, //!< PW91 GGA functional
 	ExCorrMGGA_TPSS, //!< TPSS meta-GGA functional
 	ExCorrMGGA_revTPSS, //!< revised meta-GGA functional
+	ExCorrMGGA_r2SCAN, //!< regularized-restored SCAN meta-GGA functional
 #ifdef LIBXC_ENABLED
 	ExCorrLibXC,
 #endif
@@ -98,8 +99,8 @@ public:
 	bool needsKEdensity() const; //!< whether orbital KE density is required as an input (for meta GGAs)
 	bool hasEnergy() const; //!< whether functional supports a total energy (if not, only usable in SCF, and no forces)
 	
-	//!Compute second derivatives of energy density w.r.t n and sigma=|grad n|^2 
-	//! by finite difference (supported only for spin-unpolarized internal LDAs and GGAs).
+	//!Compute second derivatives of energy density w.r.t n and sigma=|grad n|^2 (supported only for spin-unpolarized LDAs and GGAs).
+	//! These are analytic for the internal LDAs and for LibXC functionals that provide fxc, and by finite difference otherwise.
 	//! All sigma derivatives will be null on output for LDAs.
 	//! The gradients will be set to zero for regions with n < nCut (useful to reduce numerical sensitivity in systems with empty space)
 	void getSecondDerivatives(const ScalarField& n, ScalarField& e_nn, ScalarField& e_sigma, ScalarField& e_nsigma, ScalarField& e_sigmasigma, double nCut=1e-4) const;
@@ -111,6 +112,11 @@ public:
 		virtual bool ignore_nCore() const=0; //!< Whether partial cores need to be ignored for this functional
 		virtual ScalarFieldArray getPotential() const=0; //!< Return orbital-dependent portion of potential (obtains any necessary electronic property directly from ElecVars / ElecInfo)
 		virtual void dump() const=0; //!< Dump any functional-specific quantities
+		
+		//Optional accumulation of orbital-weighted densities in the same transforms as the density (see ElecVars::calcDensity):
+		virtual bool initDensityWeights() const { return false; } //!< Prepare weights for the current orbitals (collective), and return whether accumulation is supported
+		virtual const diagMatrix& densityWeights(int q) const { assert(!"Unsupported"); static diagMatrix none; return none; } //!< Weights of orbital densities of state q (after initDensityWeights)
+		virtual void setAccumulated(const ScalarFieldArray& Vpartial) const {} //!< Weighted densities accumulated over the states of this process (without augmentation)
 	protected:
 		const Everything& e;
 	};
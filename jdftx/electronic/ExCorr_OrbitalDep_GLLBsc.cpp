@@ -67,10 +67,36 @@ std::vector<double> ExCorr_OrbitalDep_GLLBsc::getExtremalEnergy(bool HOMO) const
 ScalarFieldArray ExCorr_OrbitalDep_GLLBsc::getPotential() const
 {	int nSpins = e.eVars.n.size();
 	if(!e.eVars.Hsub_eigs[e.eInfo.qStart].size()) return ScalarFieldArray(nSpins); //no eigenvalues yet
+	//Reuse numerator accumulated with the density if the orbitals are unchanged since:
+	bool accumCurrent = Vaccum.size();
+	if(accumCurrent)
+		for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+			if(!(e.eVars.Hsub_eigs[q] == eigsAccum[q] && e.eVars.F[q] == Faccum[q]))
+				accumCurrent = false;
+	mpiWorld->allReduce(accumCurrent, MPIUtil::ReduceLAnd);
+	if(accumCurrent)
+	{	ScalarFieldArray V = clone(Vaccum);
+		return finishPotential(V);
+	}
 	std::vector<double> eHOMO = getExtremalEnergy(true);
 	return getPotential(eHOMO);
 }
 
+bool ExCorr_OrbitalDep_GLLBsc::initDensityWeights() const
+{	Vaccum.clear();
+	if(!e.eVars.Hsub_eigs[e.eInfo.qStart].size()) return false; //no eigenvalues yet
+	std::vector<double> eHOMO = getExtremalEnergy(true);
+	Feff.assign(e.eInfo.nStates, diagMatrix());
+	eigsAccum.assign(e.eInfo.nStates, diagMatrix());
+	Faccum.assign(e.eInfo.nStates, diagMatrix());
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+	{	Feff[q] = getWeights(q, eHOMO, 0);
+		eigsAccum[q] = e.eVars.Hsub_eigs[q];
+		Faccum[q] = e.eVars.F[q];
+	}
+	return true;
+}
+
 void ExCorr_OrbitalDep_GLLBsc::dump() const
 {	int nSpins = e.eVars.n.size();
 	if(!e.eVars.Hsub_eigs[e.eInfo.qStart].size()) return; //no eigenvalues yet
@@ -170,24 +196,34 @@ double smoothedSqrt(double de, double width)
 	else return sqrt(std::max(0., de));
 }
 
+diagMatrix ExCorr_OrbitalDep_GLLBsc::getWeights(int q, const std::vector<double>& eHOMO, const std::vector<double>* eLUMO) const
+{	const double Kx = 8*sqrt(2)/(3*M_PI*M_PI);
+	int s = e.eInfo.qnums[q].index();
+	diagMatrix Feff(e.eInfo.nBands);
+	for(int b=0; b<e.eInfo.nBands; b++)
+	{	double deTerm = smoothedSqrt(eHOMO[s]-e.eVars.Hsub_eigs[q][b], smearingWidth); //orbital-dep potential
+		if(eLUMO) deTerm = smoothedSqrt((*eLUMO)[s]-e.eVars.Hsub_eigs[q][b], smearingWidth) - deTerm; //convert to the discontinuity contribution
+		Feff[b] = e.eVars.F[q][b] * Kx * deTerm;
+	}
+	return Feff;
+}
+
 ScalarFieldArray ExCorr_OrbitalDep_GLLBsc::getPotential(std::vector<double> eHOMO, std::vector<double>* eLUMO) const
 {	int nSpins = eHOMO.size();
-	const double Kx = 8*sqrt(2)/(3*M_PI*M_PI);
 	ScalarFieldArray V(nSpins);
 	e.iInfo.augmentDensityInit();
 	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
 	{	const QuantumNumber& qnum = e.eInfo.qnums[q];
-		int s = qnum.index();
-		diagMatrix Feff(e.eInfo.nBands);
-		for(int b=0; b<e.eInfo.nBands; b++)
-		{	double deTerm = smoothedSqrt(eHOMO[s]-e.eVars.Hsub_eigs[q][b], smearingWidth); //orbital-dep potential
-			if(eLUMO) deTerm = smoothedSqrt((*eLUMO)[s]-e.eVars.Hsub_eigs[q][b], smearingWidth) - deTerm; //convert to the discontinuity contribution
-			Feff[b] = e.eVars.F[q][b] * Kx * deTerm;
-		}
+		diagMatrix Feff = getWeights(q, eHOMO, eLUMO);
 		V += qnum.weight * diagouterI(Feff, e.eVars.C[q], V.size(), &e.gInfo); //without the 1/n(r) denominator
 		e.iInfo.augmentDensitySpherical(qnum, Feff, e.eVars.VdagC[q]); //ultrasoft contribution
 	}
 	e.iInfo.augmentDensityGrid(V);
+	return finishPotential(V);
+}
+
+ScalarFieldArray ExCorr_OrbitalDep_GLLBsc::finishPotential(ScalarFieldArray& V) const
+{	int nSpins = V.size();
 	for(int s=0; s<nSpins; s++)
 	{	nullToZero(V[s], e.gInfo);
 		V[s]->allReduceData(mpiWorld, MPIUtil::ReduceSum);
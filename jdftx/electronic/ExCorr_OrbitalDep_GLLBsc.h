@@ -31,10 +31,19 @@ struct ExCorr_OrbitalDep_GLLBsc : public ExCorr::OrbitalDep
 	bool ignore_nCore() const { return true; }
 	ScalarFieldArray getPotential() const;
 	void dump() const;
+	bool initDensityWeights() const;
+	const diagMatrix& densityWeights(int q) const { return Feff[q]; }
+	void setAccumulated(const ScalarFieldArray& Vpartial) const { Vaccum = Vpartial; }
 private:
 	double smearingWidth; //smearing width
 	std::vector<double> getExtremalEnergy(bool HOMO) const; //!<  get HOMO or LUMO energy (depending on HOMO=true/false), optionally accounting for smearing (depending on T)
 	ScalarFieldArray getPotential(std::vector<double> eHOMO, std::vector<double>* eLUMO=0) const; //!< get the orbital dep potential (or discontinuity contribution if eLUMO is non-null)
+	diagMatrix getWeights(int q, const std::vector<double>& eHOMO, const std::vector<double>* eLUMO) const; //!< weights of orbital densities in the potential numerator
+	ScalarFieldArray finishPotential(ScalarFieldArray& V) const; //!< reduce numerator over processes, divide by density and symmetrize
+	
+	//Numerator accumulated along with the density, and the eigenvalues and fillings it corresponds to:
+	mutable std::vector<diagMatrix> Feff, eigsAccum, Faccum;
+	mutable ScalarFieldArray Vaccum;
 };
 
 //! @}
@@ -72,6 +72,13 @@ public:
 		double* E, std::vector<double*> E_n, std::vector<double*> E_sigma,
 		std::vector<double*> E_lap, std::vector<double*> E_tau) const=0;
 	
+	//! Whether analytic second derivatives are available from evaluateSecondDerivatives()
+	virtual bool hasSecondDerivatives() const { return false; }
+	
+	//! Accumulate the analytic second derivative of the energy density (per volume) w.r.t density,
+	//! for a spin-unpolarized density n, scaled by scaleFac (only called when hasSecondDerivatives())
+	virtual void evaluateSecondDerivatives(int N, const double* n, double* E_nn) const {}
+	
 	//!Call evaluate for a subset of data points:
 	void evaluateSub(int iStart, int iStop,
 		std::vector<const double*> n, std::vector<const double*> sigma,
@@ -83,6 +83,9 @@ public:
 		std::vector<const double*> lap, std::vector<const double*> tau,
 		double* E, std::vector<double*> E_n, std::vector<double*> E_sigma,
 		std::vector<double*> E_lap, std::vector<double*> E_tau) const;
+	
+	bool hasSecondDerivatives() const { return true; }
+	void evaluateSecondDerivatives(int N, const double* n, double* E_nn) const;
 
 private:
 	LDA_Variant variant;
@@ -135,6 +138,27 @@ template<LDA_Variant variant, int nCount> struct LDA_calc
 	}
 };
 
+//! LDA second-derivative inner layer (specialize for each functional written in terms of rs):
+//! Return spin-unpolarized energy per particle given rs and set its first and second derivatives w.r.t rs
+template<LDA_Variant variant> __hostanddev__
+double LDA_eval_unpolarized2(double rs, double& e_rs, double& e_rsrs);
+
+//! LDA second-derivative outer layer: Accumulate the second derivative of the spin-unpolarized
+//! energy density (per unit volume) w.r.t density, using template specializations of LDA_eval_unpolarized2
+//! (Input nCount is always 1; the template argument exists only for compatibility with SwitchTemplate_LDA)
+template<LDA_Variant variant, int nCount> struct LDA_calc2
+{	__hostanddev__ static
+	void compute(int i, const double* n, double* E_nn, double scaleFac)
+	{	double nTot = n[i];
+		if(nTot<nCutoff) return;
+		double rs = pow((4.*M_PI/3.)*nTot, (-1./3));
+		double e_rs, e_rsrs;
+		LDA_eval_unpolarized2<variant>(rs, e_rs, e_rsrs);
+		//E = n e(rs) with rs_n = -rs/(3n) => E_nn = (rs/9n) (rs e_rsrs - 2 e_rs)
+		E_nn[i] += scaleFac * (rs/(9.*nTot)) * (rs*e_rsrs - 2.*e_rs);
+	}
+};
+
 //! Specialization of LDA_calc for Thomas-Fermi kinetic energy (compute directly in n[s])
 template<int nCount> struct LDA_calc <LDA_KE_TF, nCount>
 {	__hostanddev__ static
@@ -151,6 +175,16 @@ template<int nCount> struct LDA_calc <LDA_KE_TF, nCount>
 	}
 };
 
+//! Specialization of LDA_calc2 for Thomas-Fermi kinetic energy
+template<int nCount> struct LDA_calc2 <LDA_KE_TF, nCount>
+{	__hostanddev__ static
+	void compute(int i, const double* n, double* E_nn, double scaleFac)
+	{	const double KEprefac = 0.3*pow(3*M_PI*M_PI, 2./3.);
+		if(n[i]<nCutoff) return;
+		E_nn[i] += scaleFac*( (KEprefac * 10./9.) / pow(n[i], 1./3) );
+	}
+};
+
 //! Specialization of LDA_calc for Slater exchange (compute directly in n[s]; zeta not required)
 template<int nCount> struct LDA_calc <LDA_X_Slater, nCount>
 {	__hostanddev__ static
@@ -167,6 +201,16 @@ template<int nCount> struct LDA_calc <LDA_X_Slater, nCount>
 	}
 };
 
+//! Specialization of LDA_calc2 for Slater exchange
+template<int nCount> struct LDA_calc2 <LDA_X_Slater, nCount>
+{	__hostanddev__ static
+	void compute(int i, const double* n, double* E_nn, double scaleFac)
+	{	const double Xprefac = -0.75 * pow(3./M_PI, 1./3);
+		if(n[i]<nCutoff) return;
+		E_nn[i] += scaleFac*( (Xprefac * 4./9.) / pow(n[i], 2./3) );
+	}
+};
+
 
 
 //! Functor for Perdew-Zunger correlation [Phys. Rev. B 23, 5048 (1981)]
@@ -191,12 +235,34 @@ template<bool para> struct LDA_eval_C_PZ
 			return gamma * denInv;
 		}
 	}
+	//! Also compute second derivative w.r.t rs
+	__hostanddev__ double operator()(double rs, double& e_rs, double& e_rsrs) const
+	{	if(rs<1.)
+		{	const double a     = para ?  0.0311 :  0.01555;
+			const double c     = para ?  0.0020 :  0.0007;
+			e_rsrs = (c - a/rs)/rs;
+		}
+		else
+		{	const double gamma = para ? -0.1423 : -0.0843;
+			const double beta1 = para ?  1.0529 :  1.3981;
+			const double beta2 = para ?  0.3334 :  0.2611;
+			double denInv = 1./(1. + beta1*sqrt(rs) + beta2*rs);
+			double denPrime = beta1/(2.*sqrt(rs)) + beta2;
+			double denPrime2 = -beta1/(4.*rs*sqrt(rs));
+			e_rsrs = gamma * denInv*denInv * (2.*denPrime*denPrime*denInv - denPrime2);
+		}
+		return (*this)(rs, e_rs);
+	}
 };
 //! Perdew-Zunger correlation
 template<> __hostanddev__
 double LDA_eval<LDA_C_PZ>(double rs, double zeta, double& e_rs, double& e_zeta)
 {	return spinInterpolate(rs, zeta, e_rs, e_zeta, LDA_eval_C_PZ<true>(), LDA_eval_C_PZ<false>());
 }
+template<> __hostanddev__
+double LDA_eval_unpolarized2<LDA_C_PZ>(double rs, double& e_rs, double& e_rsrs)
+{	return LDA_eval_C_PZ<true>()(rs, e_rs, e_rsrs);
+}
 
 //! Functor for Perdew-Wang correlation [JP Perdew and Y Wang, Phys. Rev. B 45, 13244 (1992)]
 //! @tparam spinID Compute paramagnetic for spinID=0, ferromagnetic for spinID=1 and spin-stiffness for spinID=2
@@ -224,6 +290,29 @@ template<int spinID, bool prec=true> struct LDA_eval_C_PW
 		e_rs = -(2*A) * (alpha * logTerm + (1+alpha*rs) * logTerm_rs);
 		return -(2*A) * (1+alpha*rs) * logTerm;
 	}
+	//! Also compute second derivative w.r.t rs
+	__hostanddev__ double operator()(double rs, double& e_rs, double& e_rsrs) const
+	{	const double A     = prec
+		                 ? ( (spinID==0) ? 0.0310907 : ((spinID==1) ? 0.01554535 : 0.0168869) )
+		                 : ( (spinID==0) ? 0.031091  : ((spinID==1) ? 0.015545   : 0.016887) );
+		const double alpha = (spinID==0) ? 0.21370   : ((spinID==1) ? 0.20548    : 0.11125);
+		const double beta1 = (spinID==0) ? 7.5957    : ((spinID==1) ? 14.1189    : 10.357);
+		const double beta2 = (spinID==0) ? 3.5876    : ((spinID==1) ? 6.1977     : 3.6231);
+		const double beta3 = (spinID==0) ? 1.6382    : ((spinID==1) ? 3.3662     : 0.88026);
+		const double beta4 = (spinID==0) ? 0.49294   : ((spinID==1) ? 0.62517    : 0.49671);
+		double x = sqrt(rs);
+		double den    = (2*A)*x*(beta1 + x*(beta2 + x*(beta3 + x*(beta4))));
+		double den_x  = (2*A)*(beta1 + x*(2*beta2 + x*(3*beta3 + x*(4*beta4))));
+		double den_xx = (2*A)*(2*beta2 + x*(6*beta3 + x*(12*beta4)));
+		double den_rs = den_x * 0.5/x;
+		double den_rsrs = (den_xx - den_x/x) * 0.25/rs;
+		double logTerm    = log(1.+1./den);
+		double logTerm_rs = -den_rs/(den*(1.+den));
+		double logTerm_rsrs = (den_rs*den_rs*(1.+2.*den)/(den*(1.+den)) - den_rsrs)/(den*(1.+den));
+		e_rsrs = -(2*A) * (2.*alpha * logTerm_rs + (1+alpha*rs) * logTerm_rsrs);
+		e_rs = -(2*A) * (alpha * logTerm + (1+alpha*rs) * logTerm_rs);
+		return -(2*A) * (1+alpha*rs) * logTerm;
+	}
 };
 //! Perdew-Wang correlation (original version, for numerical compatibility with LibXC's PW91)
 template<> __hostanddev__
@@ -238,6 +327,14 @@ double LDA_eval<LDA_C_PW_prec>(double rs, double zeta, double& e_rs, double& e_z
 {	return spinInterpolate(rs, zeta, e_rs, e_zeta,
 		LDA_eval_C_PW<0>(), LDA_eval_C_PW<1>(), LDA_eval_C_PW<2>()); //defaults are high-prec versions
 }
+template<> __hostanddev__
+double LDA_eval_unpolarized2<LDA_C_PW>(double rs, double& e_rs, double& e_rsrs)
+{	return LDA_eval_C_PW<0,false>()(rs, e_rs, e_rsrs);
+}
+template<> __hostanddev__
+double LDA_eval_unpolarized2<LDA_C_PW_prec>(double rs, double& e_rs, double& e_rsrs)
+{	return LDA_eval_C_PW<0>()(rs, e_rs, e_rsrs);
+}
 
 
 //! Functor for Vosko-Wilk-Nusair correlation [Can. J. Phys. 58, 1200 (1980)]
@@ -264,6 +361,26 @@ template<int spinID> struct LDA_eval_C_VWN
 		e_rs = e_x * 0.5/x; //propagate x derivative to rs derivative
 		return e;
 	}
+	//! Also compute second derivative w.r.t rs
+	__hostanddev__ double operator()(double rs, double& e_rs, double& e_rsrs) const
+	{	const double A  = (spinID==0) ? 0.0310907 : ((spinID==1) ? 0.01554535 :  1./(6.*M_PI*M_PI));
+		const double b  = (spinID==0) ? 3.72744   : ((spinID==1) ? 7.06042    : 1.13107);
+		const double c  = (spinID==0) ? 12.9352   : ((spinID==1) ? 18.0578    : 13.0045);
+		const double x0 = (spinID==0) ? -0.10498  : ((spinID==1) ? -0.32500   : -0.0047584);
+		const double X0 = c + x0*(b + x0);
+		const double Q = sqrt(4.*c - b*b);
+		double x = sqrt(rs);
+		double X = c + x*(b + x);
+		double X_x = 2*x + b;
+		double atanDen = Q*Q + X_x*X_x;
+		double atanTerm_x = -4./atanDen, atanTerm_xx = 16.*X_x/(atanDen*atanDen);
+		double logTerm1_x = 2./x - X_x/X, logTerm1_xx = -2./(x*x) - (2.*X - X_x*X_x)/(X*X);
+		double logTerm2_x = 2./(x-x0) - X_x/X, logTerm2_xx = -2./((x-x0)*(x-x0)) - (2.*X - X_x*X_x)/(X*X);
+		double e_x = A*(logTerm1_x + b * (atanTerm_x - (x0/X0)*(logTerm2_x + (b+2*x0) * atanTerm_x)));
+		double e_xx = A*(logTerm1_xx + b * (atanTerm_xx - (x0/X0)*(logTerm2_xx + (b+2*x0) * atanTerm_xx)));
+		e_rsrs = (e_xx - e_x/x) * 0.25/rs; //propagate x derivatives to rs
+		return (*this)(rs, e_rs);
+	}
 };
 //! Vosko-Wilk-Nusair correlation
 template<> __hostanddev__
@@ -271,6 +388,10 @@ double LDA_eval<LDA_C_VWN>(double rs, double zeta, double& e_rs, double& e_zeta)
 {	return spinInterpolate(rs, zeta, e_rs, e_zeta,
 		LDA_eval_C_VWN<0>(), LDA_eval_C_VWN<1>(), LDA_eval_C_VWN<2>());
 }
+template<> __hostanddev__
+double LDA_eval_unpolarized2<LDA_C_VWN>(double rs, double& e_rs, double& e_rsrs)
+{	return LDA_eval_C_VWN<0>()(rs, e_rs, e_rsrs);
+}
 
 
 //! Teter LSD exchange & correlation [Phys. Rev. B 54, 1703 (1996)]
@@ -304,6 +425,23 @@ double LDA_eval<LDA_XC_Teter>(double rs, double zeta, double& e_rs, double& e_ze
 	e_zeta = (num*den_f - den*num_f)*f_zeta/(den*den);
 	return -num/den;
 };
+//! Teter LSD exchange & correlation (unpolarized second derivative)
+template<> __hostanddev__
+double LDA_eval_unpolarized2<LDA_XC_Teter>(double rs, double& e_rs, double& e_rsrs)
+{	//Pade coefficients of the paramagnetic state:
+	const double a0 = 0.4581652932831429, a1 = 2.217058676663745, a2 = 0.7405551735357053, a3 = 0.01968227878617998;
+	const double b2 = 4.504130959426697, b3 = 1.110667363742916, b4 = 0.02359291751427506;
+	double num = a0 + rs*(a1 + rs*(a2 + rs*(a3)));
+	double den = rs*(1. + rs*(b2 + rs*(b3 + rs*(b4))));
+	double num_rs = a1 + rs*(2*a2 + rs*(3*a3));
+	double den_rs = 1. + rs*(2*b2 + rs*(3*b3 + rs*(4*b4)));
+	double num_rsrs = 2*a2 + rs*(6*a3);
+	double den_rsrs = 2*b2 + rs*(6*b3 + rs*(12*b4));
+	double numDen_rs = num_rs*den - num*den_rs;
+	e_rs = -numDen_rs/(den*den);
+	e_rsrs = (2.*numDen_rs*den_rs/den - (num_rsrs*den - num*den_rsrs))/(den*den);
+	return -num/den;
+}
 
 //! @}
 #endif // JDFTX_ELECTRONIC_EXCORR_INTERNAL_LDA_H
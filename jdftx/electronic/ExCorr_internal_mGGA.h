@@ -28,12 +28,34 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 static const double tauCutoff = 1e-8; //!< ignore densities below this value
 
+//! Project out mGGA point i that is problematic for LibXC 4 (small tau, or tauVW/tau ratio out of range),
+//! given LibXC's spin-interleaved data with nCount spin components (modifies n and tau in place)
+__hostanddev__ void libxcFixTau_calc(int i, int nCount, double* n, const double* sigma, double* tau)
+{	double* nPtr = n + i*nCount;
+	double* tauPtr = tau + i*nCount;
+	double nTot = nCount==1 ? *nPtr : (*nPtr + *(nPtr+1));
+	double tauTot = nCount==1 ? *tauPtr : (*tauPtr + *(tauPtr+1));
+	double sigmaTot = nCount==1 ? sigma[i] : sigma[3*i]+2*sigma[3*i+1]+sigma[3*i+2];
+	bool zOffRange = 0.125*sigmaTot > (nTot * tauTot);
+	if(tauTot < tauCutoff) //Small tau
+	{	for(int s=0; s<nCount; s++)
+			nPtr[s] = tauPtr[s] = 0.;
+	}
+	else if(zOffRange && nTot>nCutoff) //tauVW/tau ratio out of range
+	{	double tauScale = 0.125*sigmaTot/(nTot*tauTot); //scale to von-Weisacker value
+		for(int s=0; s<nCount; s++)
+			tauPtr[s] *= tauScale;
+	}
+}
+
 //! Available mGGA functionals 
 enum mGGA_Variant
 {	mGGA_X_TPSS, //!< TPSS mGGA exchange
 	mGGA_C_TPSS, //!< TPSS mGGA correlation
 	mGGA_X_revTPSS, //!< revTPSS mGGA exchange
-	mGGA_C_revTPSS //!< revTPSS mGGA correlation
+	mGGA_C_revTPSS, //!< revTPSS mGGA correlation
+	mGGA_X_r2SCAN, //!< r2SCAN mGGA exchange
+	mGGA_C_r2SCAN //!< r2SCAN mGGA correlation
 };
 
 //! Common interface to the compute kernels for mGGA-like functionals
@@ -48,6 +70,8 @@ public:
 			case mGGA_C_TPSS:
 			case mGGA_X_revTPSS:
 			case mGGA_C_revTPSS:
+			case mGGA_X_r2SCAN:
+			case mGGA_C_r2SCAN:
 				return false;
 			default:
 				return true;
@@ -58,6 +82,7 @@ public:
 	{	switch(variant)
 		{	case mGGA_X_TPSS:
 			case mGGA_X_revTPSS:
+			case mGGA_X_r2SCAN:
 				return true;
 			default:
 				return false;
@@ -67,6 +92,7 @@ public:
 	{	switch(variant)
 		{	case mGGA_C_TPSS:
 			case mGGA_C_revTPSS:
+			case mGGA_C_r2SCAN:
 				return true;
 			default:
 				return false;
@@ -98,6 +124,8 @@ private:
 		case mGGA_C_TPSS:    fTemplate< mGGA_C_TPSS,    false, nCount> argList; break; \
 		case mGGA_X_revTPSS: fTemplate< mGGA_X_revTPSS,  true, nCount> argList; break; \
 		case mGGA_C_revTPSS: fTemplate< mGGA_C_revTPSS, false, nCount> argList; break; \
+		case mGGA_X_r2SCAN:  fTemplate< mGGA_X_r2SCAN,   true, nCount> argList; break; \
+		case mGGA_C_r2SCAN:  fTemplate< mGGA_C_r2SCAN,  false, nCount> argList; break; \
 		default: break; \
 	}
 
@@ -193,6 +221,7 @@ struct mGGA_calc <variant, false, nCount>
 		//Compute dimensionless gradient squared t2 (and t2up/t2dn):
 		double t2_sigma = (pow(M_PI/3, 1./3)/16.) * pow(nTot,-7./3) / (g*g);
 		double sigmaTot = (nCount==1) ? sigma[0][i] : sigma[0][i]+2*sigma[1][i]+sigma[2][i];
+		if(sigmaTot < nCutoff) sigmaTot = nCutoff; //avoid 0/0 in tau/tauW based functionals (eg. r2SCAN)
 		double t2 = t2_sigma * sigmaTot;
 		double t2up_sigmaUp, t2dn_sigmaDn, t2up, t2dn;
 		if(nCount==1) t2up = t2dn = 2*t2;
@@ -338,6 +367,67 @@ template<> __hostanddev__ double mGGA_eval<mGGA_X_revTPSS>(double rs, double s2,
 {	return mGGA_TPSS_Exchange<true>(rs, s2, q, z, e_rs, e_s2, e_q, e_z);
 }
 
+//! Switching function f(alpha) of the r2SCAN exchange / correlation interpolation, and its derivative,
+//! with c[0..7] the coefficients of the polynomial for alpha <= 2.5, and c2, d for exponential form above it
+__hostanddev__ double r2SCAN_switch(double alpha, const double* c, double c2, double d, double& f_alpha)
+{	if(alpha <= 2.5)
+	{	double f = c[7];
+		f_alpha = 7*c[7];
+		for(int i=6; i>=1; i--)
+		{	f = c[i] + alpha*f;
+			f_alpha = i*c[i] + alpha*f_alpha;
+		}
+		f = c[0] + alpha*f;
+		return f;
+	}
+	else
+	{	double oneMalphaInv = 1./(1.-alpha);
+		double f = -d*exp(c2*oneMalphaInv);
+		f_alpha = f*c2*oneMalphaInv*oneMalphaInv;
+		return f;
+	}
+}
+
+//! r2SCAN Exchange: J.W. Furness et al, J. Phys. Chem. Lett. 11, 8208 (2020)
+template<> __hostanddev__ double mGGA_eval<mGGA_X_r2SCAN>(double rs, double s2, double q, double z,
+	double& e_rs, double& e_s2, double& e_q, double& e_z)
+{	const double eta = 0.001, k1 = 0.065, h0x = 1.174, a1 = 4.9479, dp2 = 0.361;
+	const double C2x = -0.16274221523404786; //= -sum_i i c_i (1-h0x) from coefficients below
+	const double cx[8] = { 1., -0.667, -0.4445555, -0.663086601049, 1.451297044490, -0.887998041597, 0.234528941479, -0.023185843322 };
+	//Regularized iso-orbital indicator, alphaBar = (tau - tauW) / (tauUnif + eta tauW):
+	double alphaDen = 1./(1. + (5./3)*eta*s2);
+	double alpha = (5./3)*s2*((1.-z)/z) * alphaDen;
+	double alpha_s2 = (5./3)*((1.-z)/z)*alphaDen - alpha*(5./3)*eta*alphaDen;
+	double alpha_z = -(5./3)*s2/(z*z) * alphaDen;
+	//Interpolation function:
+	double fx_alpha, fx = r2SCAN_switch(alpha, cx, 0.8, 1.24, fx_alpha);
+	//Single-orbital enhancement factor h1x (derivative regularized gradient expansion):
+	const double dp2_4 = dp2*dp2*dp2*dp2;
+	const double Ceta = 20./27 + (5./3)*eta;
+	double damp = exp(-s2*s2/dp2_4);
+	double x = (Ceta*C2x*damp + 10./81)*s2;
+	double x_s2 = Ceta*C2x*damp*(1. - 2.*s2*s2/dp2_4) + 10./81;
+	double h1x = 1.+k1 - k1/(1.+x/k1);
+	double h1x_x = 1./((1.+x/k1)*(1.+x/k1));
+	//Large gradient limit:
+	double s2qrtInv = pow(s2, -0.25);
+	double gxExp = exp(-a1*s2qrtInv);
+	double gx = 1. - gxExp;
+	double gx_s2 = -gxExp * a1 * 0.25*s2qrtInv/s2;
+	//Enhancement factor:
+	double Fx0 = h1x + fx*(h0x-h1x);
+	double F = Fx0 * gx;
+	double F_s2 = ((1.-fx)*h1x_x*x_s2 + fx_alpha*alpha_s2*(h0x-h1x)) * gx + Fx0 * gx_s2;
+	double F_z = fx_alpha*alpha_z*(h0x-h1x) * gx;
+	//Exchange energy per particle:
+	double eSlater_rs, eSlater = slaterExchange(rs, eSlater_rs);
+	e_rs = eSlater_rs * F;
+	e_s2 = eSlater * F_s2;
+	e_q = 0.;
+	e_z = eSlater * F_z;
+	return eSlater * F;
+}
+
 
 //-------------------- meta-GGA correlation implementations -------------------------
 
@@ -500,5 +590,122 @@ template<> __hostanddev__ double mGGA_eval<mGGA_C_revTPSS>(
 		e_rs, e_zeta, e_g, e_t2, e_t2up, e_t2dn, e_zi2, e_z);
 }
 
+//! r2SCAN Correlation: J.W. Furness et al, J. Phys. Chem. Lett. 11, 8208 (2020)
+template<> __hostanddev__ double mGGA_eval<mGGA_C_r2SCAN>(
+	double rs, double zeta, double g, double t2,
+	double t2up, double t2dn, double zi2, double z,
+	double& e_rs, double& e_zeta, double& e_g, double& e_t2,
+	double& e_t2up, double& e_t2dn, double& e_zi2, double& e_z)
+{	const double eta = 0.001, dp2 = 0.361;
+	const double b1c = 0.0285764, b2c = 0.0889, b3c = 0.125541, chiInf = 0.128026;
+	const double gamma = (1. - log(2.))/(M_PI*M_PI);
+	const double dFc2 = -0.7114023342889984; //= sum_i i c_i from coefficients below
+	const double cc[8] = { 1., -0.64, -0.4352, -1.535685604549, 3.061560252175, -1.915710236206, 0.516884468372, -0.051848879792 };
+	//Reduced density gradient p = s^2 (of the total density):
+	const double sFac = 0.6634364396064502; // = 4^(4/3) / (3 pi^2)^(2/3)
+	double s2 = sFac*g*g*rs*t2;
+	double s2_rs = s2/rs, s2_g = 2.*s2/g, s2_t2 = sFac*g*g*rs;
+	//Spin-scaling factors ds, dx and Gc:
+	double zetap = 1.+zeta, zetam = 1.-zeta;
+	double zetapCbrt = pow(zetap, 1./3), zetamCbrt = pow(zetam, 1./3);
+	double ds = 0.5*(zetap*zetapCbrt*zetapCbrt + zetam*zetamCbrt*zetamCbrt);
+	double ds_zeta = (5./6)*(zetapCbrt*zetapCbrt - zetamCbrt*zetamCbrt);
+	double dx = 0.5*(zetap*zetapCbrt + zetam*zetamCbrt);
+	double dx_zeta = (2./3)*(zetapCbrt - zetamCbrt);
+	double zeta12 = pow(zeta, 12), GcPoly = 1. - 2.3631*(dx-1.);
+	double Gc = GcPoly*(1.-zeta12);
+	double Gc_zeta = -2.3631*dx_zeta*(1.-zeta12) - GcPoly*(zeta ? 12.*zeta12/zeta : 0.);
+	//Regularized iso-orbital indicator, alphaBar = (tau - tauW) / (tauUnif + eta tauW):
+	double alphaDen = 1./(ds + (5./3)*eta*s2);
+	double alpha = (5./3)*s2*((1.-z)/z) * alphaDen;
+	double alpha_s2 = (5./3)*((1.-z)/z)*alphaDen - alpha*(5./3)*eta*alphaDen;
+	double alpha_z = -(5./3)*s2/(z*z) * alphaDen;
+	double alpha_zeta = -alpha*ds_zeta*alphaDen;
+	double fc_alpha, fc = r2SCAN_switch(alpha, cc, 1.5, 0.7, fc_alpha);
+	
+	//Single-orbital limit, ec0 = (ecLDA0 + H0) Gc:
+	double sqrtrs = sqrt(rs);
+	double lda0Den = 1. + b2c*sqrtrs + b3c*rs;
+	double lda0Den_rs = 0.5*b2c/sqrtrs + b3c;
+	double lda0Den_rsrs = -0.25*b2c/(sqrtrs*rs);
+	double ecLDA0 = -b1c/lda0Den;
+	double ecLDA0_rs = b1c*lda0Den_rs/(lda0Den*lda0Den);
+	double ecLDA0_rsrs = b1c*(lda0Den_rsrs - 2.*lda0Den_rs*lda0Den_rs/lda0Den)/(lda0Den*lda0Den);
+	double w0p1 = exp(-ecLDA0/b1c), w0 = w0p1 - 1.;
+	double w0_rs = -w0p1*ecLDA0_rs/b1c;
+	double gInfArg = 1./(1. + 4.*chiInf*s2);
+	double gInf = pow(gInfArg, 0.25);
+	double gInf_s2 = -chiInf*gInf*gInfArg;
+	double H0arg = 1. + w0*(1.-gInf);
+	double H0 = b1c*log(H0arg);
+	double H0_w0 = b1c*(1.-gInf)/H0arg;
+	double H0_gInf = -b1c*w0/H0arg;
+	double ec0 = (ecLDA0 + H0)*Gc;
+	double ec0_s2 = H0_gInf*gInf_s2*Gc;
+	double ec0_rs = (ecLDA0_rs + H0_w0*w0_rs)*Gc + ec0_s2*s2_rs;
+	double ec0_zeta = (ecLDA0 + H0)*Gc_zeta;
+	
+	//Slowly-varying limit, ec1 = ecLSDA1 + H1:
+	//--- PW92 LSDA and its mixed second derivatives (the latter by central difference in rs of the analytic first derivatives):
+	double ec1_rs, ec1_zeta, ecLSDA1 = LDA_eval<LDA_C_PW_prec>(rs, zeta, ec1_rs, ec1_zeta);
+	double ec1_rsrs, ec1_rszeta;
+	{	const double h = 1e-4;
+		double ePlus_rs, ePlus_zeta; LDA_eval<LDA_C_PW_prec>(rs*(1.+h), zeta, ePlus_rs, ePlus_zeta);
+		double eMinus_rs, eMinus_zeta; LDA_eval<LDA_C_PW_prec>(rs*(1.-h), zeta, eMinus_rs, eMinus_zeta);
+		ec1_rsrs = (ePlus_rs - eMinus_rs)/(2.*h*rs);
+		ec1_rszeta = (ePlus_zeta - eMinus_zeta)/(2.*h*rs);
+	}
+	//--- w1 and beta:
+	double g2 = g*g, g3 = g2*g;
+	double gammaPhi3 = gamma*g3;
+	double w1p1 = exp(-ecLSDA1/gammaPhi3), w1 = w1p1 - 1.;
+	double w1_ec1 = -w1p1/gammaPhi3;
+	double w1_g3 = w1p1*ecLSDA1/(gammaPhi3*g3);
+	double beta_rs, beta = betaTPSS<true>(rs, beta_rs);
+	double A = beta/(gamma*w1);
+	//--- gradient-expansion correction Delta y that removes the alpha-dependence of the second-order term:
+	const double dp2_4 = dp2*dp2*dp2*dp2;
+	double damp = exp(-s2*s2/dp2_4);
+	double Bterm = 20.*rs*(Gc*ecLDA0_rs - ec1_rs) - 45.*eta*(Gc*ecLDA0 - ecLSDA1);
+	double Bterm_rs = 20.*(Gc*ecLDA0_rs - ec1_rs) + 20.*rs*(Gc*ecLDA0_rsrs - ec1_rsrs) - 45.*eta*(Gc*ecLDA0_rs - ec1_rs);
+	double Bterm_zeta = 20.*rs*(Gc_zeta*ecLDA0_rs - ec1_rszeta) - 45.*eta*(Gc_zeta*ecLDA0 - ec1_zeta);
+	double K = dFc2/(27.*gammaPhi3*ds*w1);
+	double dy = K*Bterm*s2*damp;
+	double dy_Bterm = K*s2*damp;
+	double dy_s2 = K*Bterm*damp*(1. - 2.*s2*s2/dp2_4);
+	//--- H1:
+	double y = A*t2 - dy;
+	double yArg = 1. + 4.*y;
+	if(yArg < nCutoff) yArg = nCutoff; //guard against a large negative correction
+	double gy = pow(yArg, -0.25);
+	double gy_y = -gy/yArg;
+	double H1arg = 1. + w1*(1.-gy);
+	double H1 = gammaPhi3*log(H1arg);
+	double H1_y = -gammaPhi3*w1*gy_y/H1arg;
+	double H1_w1 = gammaPhi3*(1.-gy)/H1arg + H1_y*(-A*t2/w1 + dy/w1); //including w1 dependence of y
+	double H1_g3 = gamma*log(H1arg) + H1_y*(dy/g3);
+	double H1_s2 = -H1_y*dy_s2;
+	double ec1 = ecLSDA1 + H1;
+	double ec1tot_s2 = H1_s2;
+	double ec1tot_rs = ec1_rs + H1_w1*w1_ec1*ec1_rs + H1_y*(beta_rs*t2/(gamma*w1) - dy_Bterm*Bterm_rs) + ec1tot_s2*s2_rs;
+	double ec1tot_zeta = ec1_zeta + H1_w1*w1_ec1*ec1_zeta + H1_y*(-dy_Bterm*Bterm_zeta + dy*ds_zeta/ds);
+	double ec1tot_g = (H1_g3 + H1_w1*w1_g3)*3.*g2 + ec1tot_s2*s2_g;
+	double ec1tot_t2 = H1_y*A + ec1tot_s2*s2_t2;
+	
+	//Interpolate between the two limits:
+	double ecDiff = ec0 - ec1;
+	double e = ec1 + fc*ecDiff;
+	double e_s2Alpha = fc_alpha*ecDiff*alpha_s2; //contribution through alpha's s2 dependence
+	e_rs = (1.-fc)*ec1tot_rs + fc*ec0_rs + e_s2Alpha*s2_rs;
+	e_zeta = (1.-fc)*ec1tot_zeta + fc*ec0_zeta + fc_alpha*ecDiff*alpha_zeta;
+	e_g = (1.-fc)*ec1tot_g + fc*ec0_s2*s2_g + e_s2Alpha*s2_g;
+	e_t2 = (1.-fc)*ec1tot_t2 + fc*ec0_s2*s2_t2 + e_s2Alpha*s2_t2;
+	e_t2up = 0.;
+	e_t2dn = 0.;
+	e_zi2 = 0.;
+	e_z = fc_alpha*ecDiff*alpha_z;
+	return e;
+}
+
 //! @}
 #endif // JDFTX_ELECTRONIC_EXCORR_INTERNAL_MGGA_H
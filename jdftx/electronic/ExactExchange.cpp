@@ -56,13 +56,26 @@ public:
 	//! Calculate exchange operator and return energy
 	double compute(double aXX, double omega,
 		const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C,
-		std::vector<ColumnBundle>* HC=0, matrix3<>* EXX_RRT=0) const;
+		std::vector<ColumnBundle>* HC=0, matrix3<>* EXX_RRT=0, const std::vector<int>* qMask=0) const;
+	
+	//! Calculate exchange over all pairs (called by compute, after optional localization for screening)
+	double computeAll(double aXX, double omega,
+		const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C,
+		std::vector<ColumnBundle>* HC, matrix3<>* EXX_RRT, const std::vector<int>* qMask) const;
+	
+	//! Rotate occupied orbitals of each local state to SCDM-localized ones (C[q] * U[q]), if all states have
+	//! integer occupations (with occupied bands first) and a single k-point; return false if not applicable.
+	bool localize(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, std::vector<matrix>& U) const;
+	
+	//! Square root of the fraction of |psi|^2 in each box of a coarse partition of the unit cell (for pair screening)
+	std::vector<double> boxWeights(const std::vector<complexScalarField>& Ipsi) const;
 	
 	//! Calculate exchange contributions for one pair of transformed ik and untransformed iq.
 	//! Gradients are only accumulated to untransformed iq, taking advantage of Hermitian symmetry of exchange operator.
+	//! nFFTs is incremented by the number of (batched) pair-density transforms performed.
 	double computePair(int ikReduced, int iqReduced, size_t& progress, size_t& progressTarget, double aXX, double omega,
 		const diagMatrix& Fk, const ColumnBundle& CkRed, const diagMatrix& Fq, const ColumnBundle& Cq,
-		ColumnBundle* HCq, matrix3<>* EXX_RRT=0) const;
+		ColumnBundle* HCq, matrix3<>* EXX_RRT, size_t& nFFTs) const;
 	
 private:
 	friend class ExactExchange;
@@ -73,6 +86,8 @@ private:
 	const int blockSize; //!< number of bands FFT'd together
 	double omegaACE; //!< omega for which ACE has been initialized (NAN if none)
 	std::vector<ColumnBundle> psiACE; //!< projectors for ACE representation of exchange Hamiltonian
+	std::vector<ColumnBundle> Cace; //!< wavefunctions used to construct psiACE (only stored for incremental updates)
+	matrix3<> Race; //!< lattice vectors at which psiACE was constructed
 
 	//Local chunks of untransformed q-state wavefunctions used for re-organizing q-states for load balancing
 	struct LocalState
@@ -84,6 +99,10 @@ private:
 	std::vector<std::vector<LocalState>> localStates; //local state descriptions on each process
 	std::vector<LocalState>& localStatesMine; //reference to local state on this process
 	size_t progressMax, progressInterval; //for progress reporting in compute / computePair
+	const double screenThreshold; //!< threshold on pair-density overlap bound for screening localized pairs (0 => no screening)
+	mutable double pairThreshold; //!< screening threshold in effect for current computeAll (0 when not localized)
+	mutable size_t nPairsScreened, nPairsTotal; //!< screening statistics for the current computeAll
+	mutable bool screenErrorReported; //!< whether screening error has been compared against full evaluation
 };
 
 
@@ -124,18 +143,43 @@ double ExactExchange::operator()(double aXX, double omega,
 
 //Initialize the ACE (Adiabatic Compression of Exchange) representation in preparation for applyHamiltonian
 void ExactExchange::prepareHamiltonian(double omega, const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C)
-{	logPrintf("Constructing ACE exchange operator ... "); logFlush();
+{	//Determine states to update (all, unless incremental update requested and possible):
+	double threshold = e.cntrl.aceUpdateThreshold;
+	bool incremental = threshold and hasHamiltonian(omega) and eval->Cace.size();
+	std::vector<int> qMask(e.eInfo.nStates, 1);
+	if(incremental)
+	{	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+		{	const ColumnBundle& Cprev = eval->Cace[q];
+			if(Cprev and Cprev.nCols()==C[q].nCols() and Cprev.colLength()==C[q].colLength())
+			{	//RMS component of C[q] outside the span of Cprev:
+				double nrmSq = std::pow(nrm2(Cprev ^ O(C[q])), 2);
+				double change = sqrt(std::max(0., 1. - nrmSq/C[q].nCols()));
+				qMask[q] = (change > threshold);
+			}
+		}
+		mpiWorld->allReduceData(qMask, MPIUtil::ReduceMax);
+	}
+	int nUpdate = std::count(qMask.begin(), qMask.end(), 1);
+	if(nUpdate < e.eInfo.nStates)
+		logPrintf("Updating ACE exchange operator for %d of %d states ... ", nUpdate, e.eInfo.nStates);
+	else
+		logPrintf("Constructing ACE exchange operator ... ");
+	logFlush();
+	if(!nUpdate) { logPrintf("done.\n"); return; }
 	//Compute the full exchange operator evaluated on each orbital of C in W
 	std::vector<ColumnBundle> W(e.eInfo.nStates);
-	eval->compute(-1., omega, F, C, &W); //compute with aXX = 1; applyHamiltonian handles the overall scale factor aXX
+	eval->compute(-1., omega, F, C, &W, 0, incremental ? &qMask : 0); //compute with aXX = 1; applyHamiltonian handles the overall scale factor aXX
 	//Construct ACE representation:
-	eval->psiACE.assign(e.eInfo.nStates, ColumnBundle()); //clear any previous results
+	if(!incremental) eval->psiACE.assign(e.eInfo.nStates, ColumnBundle()); //clear any previous results
+	if(threshold) eval->Cace.resize(e.eInfo.nStates);
 	bool isSingularAny = false;
 	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
-	{	matrix M = C[q] ^ W[q]; //positive semi-definite matrix = dagger(C) * (-Vxx) * C (because aXX = -1 used above)
+	{	if(!qMask[q]) continue;
+		matrix M = C[q] ^ W[q]; //positive semi-definite matrix = dagger(C) * (-Vxx) * C (because aXX = -1 used above)
 		bool isSingular = false;
-		eval->psiACE[q] = W[q] * invsqrt(M, 0, 0, &isSingular); //Same effect as Cholesky factorization, but done via diagonalization
+		eval->psiACE[q] = W[q] * e.eVars.orthoMatrix(M, &isSingular); //any U with U dagger(U) = inv(M): Cholesky or via diagonalization
 		W[q].free(); //clear memory
+		if(threshold) eval->Cace[q] = C[q]; //remember orbitals for subsequent incremental updates
 		isSingularAny = isSingularAny or isSingular;
 	}
 	logPrintf("done.\n");
@@ -144,6 +188,11 @@ void ExactExchange::prepareHamiltonian(double omega, const std::vector<diagMatri
 	if(isSingularAny) logPrintf("WARNING: singularity encountered in constructing ACE representation.\n");
 	//Mark ACE ready at specified omega:
 	eval->omegaACE = omega;
+	eval->Race = e.gInfo.R;
+}
+
+bool ExactExchange::hasHamiltonian(double omega) const
+{	return (omega == eval->omegaACE) and (nrm2(e.gInfo.R - eval->Race) < symmThreshold * nrm2(e.gInfo.R));
 }
 
 //Apply Hamiltonian using ACE representation initialized previously
@@ -256,7 +305,9 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 	blockSize(e.cntrl.exxBlockSize),
 	omegaACE(NAN),
 	localStates(mpiWorld->nProcesses()),
-	localStatesMine(localStates[mpiWorld->iProcess()])
+	localStatesMine(localStates[mpiWorld->iProcess()]),
+	screenThreshold(e.cntrl.exxScreenThreshold), pairThreshold(0.),
+	nPairsScreened(0), nPairsTotal(0), screenErrorReported(false)
 {
 	//Find all symmtries relating each kmesh point to corresponding reduced point:
 	const Supercell& supercell = *(e.coulombParams.supercell);
@@ -267,7 +318,7 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 			return circDistanceSquared(sym.a, kt.sym.a) < symmThresholdSq;
 		}
 	};
-	struct KmeshEntry { int iReduced; std::vector<Ktransform> transform; };
+	struct KmeshEntry { int iReduced; vector3<int> qClass; std::vector<Ktransform> transform; }; //qClass: kmesh index modulo q-mesh downsampling
 	struct Kmesh : public std::vector<KmeshEntry>
 	{	int qCount;
 		Kmesh(size_t n, int qCount) : std::vector<KmeshEntry>(n), qCount(qCount) {}
@@ -279,7 +330,8 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 			{	const int iq = (*this)[ik].iReduced;
 				const Ktransform& kti = (*this)[ik].transform[choice[ik]];
 				for(size_t jk=0; jk<size(); jk++)
-				{	const int jq = (*this)[jk].iReduced;
+				{	if(not ((*this)[jk].qClass == (*this)[ik].qClass)) continue; //k-point difference not on q-mesh
+					const int jq = (*this)[jk].iReduced;
 					const Ktransform& ktj = (*this)[jk].transform[choice[jk]];
 					//Create net transform:
 					Ktransform kt;
@@ -305,9 +357,28 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 	}
 	kmesh(supercell.kmesh.size(), qCount);
 	
+	//Check downsampled q-mesh, if any:
+	const vector3<int>& qDownsample = e.coulombParams.exchangeDownsample;
+	std::vector<vector3<>> qmesh; matrix3<int> superQ;
+	supercell.getDownsampledMesh(qDownsample, superQ, qmesh);
+	size_t nqPerK = qmesh.size();
+	if(nqPerK < supercell.kmesh.size())
+	{	for(const vector3<>& q: qmesh)
+			for(int invert: invertList)
+				for(const SpaceGroupOp& op: sym)
+					if(not supercell.isOnDownsampledMesh(invert * op.applyRecip(q - qmesh.front()), qDownsample))
+						die("Exchange q-mesh downsampled by %d x %d x %d breaks the symmetries of the k-point mesh.\n",
+							qDownsample[0], qDownsample[1], qDownsample[2]);
+		logPrintf("Downsampled exchange q-mesh by %d x %d x %d: %lu of %lu q-points per k-point (%.1lfx fewer k-pairs).\n",
+			qDownsample[0], qDownsample[1], qDownsample[2], nqPerK, supercell.kmesh.size(), double(supercell.kmesh.size())/nqPerK);
+	}
+	
 	for(unsigned ik=0; ik<supercell.kmesh.size(); ik++)
 	{	KmeshEntry& ki = kmesh[ik];
 		ki.iReduced = supercell.kmeshTransform[ik].iReduced;
+		ki.qClass = round((supercell.kmesh[ik] - supercell.kmesh.front()) * supercell.super);
+		for(int j=0; j<3; j++)
+			ki.qClass[j] = positiveRemainder(ki.qClass[j], qDownsample[j]);
 		for(int invert: invertList)
 			for(const SpaceGroupOp& op: sym)
 			{	vector3<> k = invert * op.applyRecip(e.eInfo.qnums[ki.iReduced].k);
@@ -365,7 +436,7 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 			kpair.sym = kt.sym;
 			kpair.invert = kt.invert;
 			kpair.k = kpair.sym.applyRecip(e.eInfo.qnums[iq].k) * kpair.invert; 
-			kpair.weight = e.eInfo.spinWeight * pow(kmesh.size(),-2) * kt.multiplicity;
+			kpair.weight = e.eInfo.spinWeight * kt.multiplicity / (double(kmesh.size()) * nqPerK);
 			kpairs[iq][jq].push_back(kpair); //note that kpair setup is run below after determining load balancing
 		}
 		nTransformsMin = std::min(nTransformsMin, transforms[iq][jq].size());
@@ -373,7 +444,7 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 		jCost[jq] += transforms[iq][jq].size();
 	}
 	size_t nkPairs = bestScore;
-	logPrintf("Reduced %lu k-pairs to %lu under symmetries.\n", kmesh.size()*kmesh.size(), nkPairs);
+	logPrintf("Reduced %lu k-pairs to %lu under symmetries.\n", kmesh.size()*nqPerK, nkPairs);
 	logPrintf("Transforms per reduced k-pair: %lu min, %lu max, %.1lf mean.\n",
 		nTransformsMin, nTransformsMax, double(nkPairs)/(qCount*qCount));
 	
@@ -382,11 +453,13 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 	std::vector<int> bStartProc(mpiWorld->nProcesses()+1, 0);
 	if(mpiWorld->isHead())
 	{	//Determine cumulative cost estimate before a given band
+		//--- an empty q-band only pairs with occupied k-bands (see computePair), so weight bands by their partner count
+		int nOcc = std::min(e.eInfo.nBands, int(ceil(e.eInfo.nElectrons / (e.eInfo.spinWeight * nSpins))));
 		std::vector<size_t> jCostPrev(qCount*e.eInfo.nBands+1);
 		int jIndex = 0;
 		for(int jq=0; jq<qCount; jq++)
 			for(int bq=0; bq<e.eInfo.nBands; bq++)
-			{	jCostPrev[jIndex+1] = jCostPrev[jIndex] + jCost[jq];
+			{	jCostPrev[jIndex+1] = jCostPrev[jIndex] + jCost[jq] * (bq<nOcc ? e.eInfo.nBands : std::max(nOcc,1));
 				jIndex++;
 			}
 		//Determine start jIndex for each process:
@@ -434,13 +507,142 @@ ExactExchangeEval::ExactExchangeEval(const Everything& e)
 
 double ExactExchangeEval::compute(double aXX, double omega, 
 	const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C,
-	std::vector<ColumnBundle>* HC, matrix3<>* EXX_RRTptr) const
+	std::vector<ColumnBundle>* HC, matrix3<>* EXX_RRTptr, const std::vector<int>* qMask) const
+{
+	std::vector<matrix> U;
+	if((not screenThreshold) or EXX_RRTptr or (not localize(F, C, U)))
+		return computeAll(aXX, omega, F, C, HC, EXX_RRTptr, qMask);
+	//Compute in terms of localized orbitals with pair screening:
+	std::vector<ColumnBundle> Cloc(C.size()), HCloc;
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+		Cloc[q] = C[q] * U[q];
+	if(HC) HCloc.resize(C.size());
+	pairThreshold = screenThreshold;
+	nPairsScreened = nPairsTotal = 0;
+	double EXX = computeAll(aXX, omega, F, Cloc, HC ? &HCloc : 0, 0, qMask);
+	pairThreshold = 0.;
+	mpiWorld->allReduce(nPairsScreened, MPIUtil::ReduceSum);
+	mpiWorld->allReduce(nPairsTotal, MPIUtil::ReduceSum);
+	logPrintf("[screened %.1lf%% of pairs] ", nPairsScreened*100./std::max(nPairsTotal, size_t(1))); logFlush();
+	//Rotate gradients back to the original orbitals (operator is invariant to rotations within occupied subspace):
+	if(HC)
+		for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+			if(HCloc[q])
+			{	ColumnBundle& HCq = HC->at(q);
+				if(!HCq) { HCq = C[q].similar(); HCq.zero(); }
+				HCq += HCloc[q] * dagger(U[q]);
+			}
+	//Report screening error against full evaluation (once):
+	if(!screenErrorReported)
+	{	screenErrorReported = true;
+		logPrintf("\n\tComparing against unscreened exchange ... "); logFlush();
+		double EXXfull = computeAll(aXX, omega, F, C, 0, 0, qMask);
+		logPrintf("done. Screening error: %le Eh (relative %le)\n\t", EXX-EXXfull, fabs((EXX-EXXfull)/EXXfull)); logFlush();
+	}
+	return EXX;
+}
+
+bool ExactExchangeEval::localize(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, std::vector<matrix>& U) const
+{	//Check applicability:
+	bool applicable = (e.coulombParams.supercell->kmesh.size() == 1);
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+		for(int b=0; b<e.eInfo.nBands; b++)
+		{	double Fb = F[q][b], FbPrev = b ? F[q][b-1] : 1.;
+			if((fabs(Fb)>1e-12 and fabs(Fb-1.)>1e-12) or Fb>FbPrev+1e-12) applicable = false;
+		}
+	mpiWorld->allReduce(applicable, MPIUtil::ReduceLAnd);
+	if(!applicable)
+	{	if(!screenErrorReported)
+		{	logPrintf("[exchange screening requires a single k-point and integer occupations; computing all pairs] ");
+			screenErrorReported = true;
+		}
+		return false;
+	}
+	//SCDM: select one grid point per occupied orbital by greedy column-pivoted QR of the orbitals sampled on a sub-grid
+	U.assign(e.eInfo.nStates, matrix());
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+	{	const ColumnBundle& Cq = C[q];
+		const GridInfo& gInfoWfns = *(Cq.basis->gInfo);
+		int nOcc = 0; while(nOcc<Cq.nCols() and F[q][nOcc]>0.5) nOcc++;
+		U[q] = eye(Cq.nCols());
+		if(nOcc < 2) continue;
+		//Orbitals on sub-grid with about 64 points per orbital:
+		int stride = std::max(1, int(floor(cbrt(gInfoWfns.nr/(64.*nOcc)))));
+		std::vector<int> iSample;
+		{	const vector3<int>& S = gInfoWfns.S; vector3<int> iv;
+			for(iv[0]=0; iv[0]<S[0]; iv[0]+=stride)
+			for(iv[1]=0; iv[1]<S[1]; iv[1]+=stride)
+			for(iv[2]=0; iv[2]<S[2]; iv[2]+=stride)
+				iSample.push_back(iv[2] + S[2]*(iv[1] + S[1]*iv[0]));
+		}
+		int nSample = iSample.size() * nSpinor;
+		matrix Psi(nOcc, nSample); //orbital values at sample points (with spinor components as separate points)
+		complex* PsiData = Psi.data();
+		for(int b=0; b<nOcc; b++)
+			for(int s=0; s<nSpinor; s++)
+			{	complexScalarField psi = I(Cq.getColumn(b,s));
+				const complex* psiData = psi->data();
+				for(size_t j=0; j<iSample.size(); j++)
+					PsiData[Psi.index(b, s*iSample.size()+j)] = psiData[iSample[j]];
+			}
+		//Greedy pivoted Gram-Schmidt on columns:
+		std::vector<double> residualSq(nSample, 0.);
+		for(int j=0; j<nSample; j++)
+			for(int b=0; b<nOcc; b++)
+				residualSq[j] += norm(PsiData[Psi.index(b,j)]);
+		matrix Q = zeroes(nOcc, nOcc); //orthonormal basis of selected columns
+		matrix M(nOcc, nOcc); //conjugate orbital values at selected points
+		for(int iSel=0; iSel<nOcc; iSel++)
+		{	int jSel = std::max_element(residualSq.begin(), residualSq.end()) - residualSq.begin();
+			matrix col = Psi(0,nOcc, jSel,jSel+1);
+			M.set(0,nOcc, iSel,iSel+1, conj(col));
+			if(iSel) col -= Q(0,nOcc, 0,iSel) * (dagger(Q(0,nOcc, 0,iSel)) * col);
+			col *= 1./nrm2(col);
+			Q.set(0,nOcc, iSel,iSel+1, col);
+			matrix proj = dagger(col) * Psi; //1 x nSample
+			for(int j=0; j<nSample; j++)
+				residualSq[j] = std::max(0., residualSq[j] - norm(proj.data()[j]));
+			residualSq[jSel] = 0.;
+		}
+		//Lowdin-orthonormalized rotation within the occupied subspace:
+		U[q].set(0,nOcc, 0,nOcc, M * invsqrt(dagger(M) * M));
+	}
+	return true;
+}
+
+std::vector<double> ExactExchangeEval::boxWeights(const std::vector<complexScalarField>& Ipsi) const
+{	const int nBoxes1D = 8;
+	const GridInfo& gInfo = Ipsi[0]->gInfo;
+	const vector3<int>& S = gInfo.S;
+	std::vector<double> w(nBoxes1D*nBoxes1D*nBoxes1D, 0.);
+	double wTot = 0.;
+	for(const complexScalarField& psi: Ipsi)
+	{	if(!psi) continue;
+		const complex* psiData = psi->data();
+		vector3<int> iv; int i = 0;
+		for(iv[0]=0; iv[0]<S[0]; iv[0]++)
+		for(iv[1]=0; iv[1]<S[1]; iv[1]++)
+		for(iv[2]=0; iv[2]<S[2]; iv[2]++)
+		{	int iBox = ((iv[0]*nBoxes1D)/S[0]*nBoxes1D + (iv[1]*nBoxes1D)/S[1])*nBoxes1D + (iv[2]*nBoxes1D)/S[2];
+			double wi = norm(psiData[i++]);
+			w[iBox] += wi;
+			wTot += wi;
+		}
+	}
+	for(double& wBox: w) wBox = sqrt(wBox/wTot);
+	return w;
+}
+
+double ExactExchangeEval::computeAll(double aXX, double omega, 
+	const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C,
+	std::vector<ColumnBundle>* HC, matrix3<>* EXX_RRTptr, const std::vector<int>* qMask) const
 {
 	static StopWatch watch("ExactExchange"); watch.start();
 	
 	double EXX = 0.;
 	matrix3<> EXX_RRT; //computed only if EXX_RRTptr is non-null
 	size_t progress=0, progressTarget = progressInterval; //Current progress and next threshold before reporting
+	size_t nFFTs = 0; double tStart = clock_sec(); //for reporting the pair-density FFT throughput
 	
 	for(int iSpin=0; iSpin<nSpins; iSpin++)
 	{
@@ -481,25 +683,39 @@ double ExactExchangeEval::compute(double aXX, double omega,
 		}
 		mpiWorld->waitAll(requests); requests.clear();
 		
-		//Compute exchange for this spin channel:
+		//Compute exchange for this spin channel, broadcasting the next (reduced) k-state while processing the current one:
+		ColumnBundle CkTmp[2]; diagMatrix FkBuf[2]; //double buffers for the k-states
+		std::vector<MPIUtil::Request> kRequests[2];
+		auto postKstate = [&](int ikReduced, int iBuf)
+		{	int ikSrc = ikReduced + iSpin*qCount; //source state number
+			bool mine = e.eInfo.isMine(ikSrc);
+			if(mine)
+				FkBuf[iBuf] = F[ikSrc];
+			else
+			{	FkBuf[iBuf].resize(e.eInfo.nBands);
+				CkTmp[iBuf].init(e.eInfo.nBands, e.basis[ikSrc].nbasis*nSpinor, &(e.basis[ikSrc]), &(e.eInfo.qnums[ikSrc]), isGpuEnabled());
+			}
+			ColumnBundle& CkRed = mine ? (ColumnBundle&)(C[ikSrc]) : CkTmp[iBuf];
+			kRequests[iBuf].clear();
+			if(mpiWorld->nProcesses() > 1)
+			{	kRequests[iBuf].assign(2, MPIUtil::Request());
+				mpiWorld->bcastData(CkRed, e.eInfo.whose(ikSrc), &kRequests[iBuf][0]);
+				mpiWorld->bcastData(FkBuf[iBuf], e.eInfo.whose(ikSrc), &kRequests[iBuf][1]);
+			}
+		};
+		if(qCount) postKstate(0, 0);
 		for(int ikReduced=0; ikReduced<qCount; ikReduced++)
-		{
-			//Prepare (reduced) ik state on all processes:
+		{	int iBuf = ikReduced % 2;
+			mpiWorld->waitAll(kRequests[iBuf]);
+			if(ikReduced+1 < qCount) postKstate(ikReduced+1, 1-iBuf); //prefetch next k-state
 			int ikSrc = ikReduced + iSpin*qCount; //source state number
-			ColumnBundle CkTmp;
-			diagMatrix Fk(e.eInfo.nBands);
-			if(e.eInfo.isMine(ikSrc))
-				Fk = F[ikSrc];
-			else
-				CkTmp.init(e.eInfo.nBands, e.basis[ikSrc].nbasis*nSpinor, &(e.basis[ikSrc]), &(e.eInfo.qnums[ikSrc]), isGpuEnabled());
-			ColumnBundle& CkRed = e.eInfo.isMine(ikSrc) ? (ColumnBundle&)(C[ikSrc]) : CkTmp; 
-			mpiWorld->bcastData(CkRed, e.eInfo.whose(ikSrc));
-			mpiWorld->bcastData(Fk, e.eInfo.whose(ikSrc));
+			const ColumnBundle& CkRed = e.eInfo.isMine(ikSrc) ? C[ikSrc] : CkTmp[iBuf];
 			
 			//Calculate energy (and gradient):
 			for(LocalState& ls: localStatesMine)
-				EXX += computePair(ikReduced, ls.iqReduced, progress, progressTarget, aXX, omega,
-					Fk, CkRed, ls.Fq, ls.Cq, HC ? &(ls.HCq) : 0, EXX_RRTptr ? &EXX_RRT : 0);
+				if((not qMask) or qMask->at(ls.iqReduced + iSpin*qCount)) //skip q-states not being updated (if masked)
+					EXX += computePair(ikReduced, ls.iqReduced, progress, progressTarget, aXX, omega,
+						FkBuf[iBuf], CkRed, ls.Fq, ls.Cq, HC ? &(ls.HCq) : 0, EXX_RRTptr ? &EXX_RRT : 0, nFFTs);
 		}
 		
 		//Free local wavefunction chunks:
@@ -542,6 +758,13 @@ double ExactExchangeEval::compute(double aXX, double omega,
 		}
 	}
 	mpiWorld->allReduce(EXX, MPIUtil::ReduceSum, true);
+	//Report FFT throughput (5 N log2(N) flops per transform), to aid tuning of exchange-block-size:
+	{	const GridInfo& gInfoWfns = e.gInfoWfns ? *(e.gInfoWfns) : e.gInfo;
+		double nFlops = nFFTs * 5. * gInfoWfns.nr * log2(gInfoWfns.nr);
+		mpiWorld->allReduce(nFlops, MPIUtil::ReduceSum);
+		double tElapsed = clock_sec() - tStart;
+		logPrintf("[pair FFTs: %.1lf GFLOP/s] ", nFlops*1e-9/std::max(tElapsed, 1e-9)); logFlush();
+	}
 	if(EXX_RRTptr)
 	{	mpiWorld->allReduce(EXX_RRT, MPIUtil::ReduceSum, true);
 		*EXX_RRTptr += EXX_RRT;
@@ -552,8 +775,9 @@ double ExactExchangeEval::compute(double aXX, double omega,
 
 double ExactExchangeEval::computePair(int ikReduced, int iqReduced, size_t& progress, size_t& progressTarget, double aXX, double omega,
 	const diagMatrix& Fk, const ColumnBundle& CkRed, const diagMatrix& Fq, const ColumnBundle& Cq,
-	ColumnBundle* HCq, matrix3<>* EXX_RRT) const
-{
+	ColumnBundle* HCq, matrix3<>* EXX_RRT, size_t& nFFTs) const
+{	const GridInfo& gInfoWfns = *(Cq.basis->gInfo);
+	const int nr = gInfoWfns.nr;
 	const QuantumNumber& qnum_q = *(Cq.qnum);
 	if(CkRed.qnum->spin != qnum_q.spin) return 0.;
 	int nBlocks = ceildiv(Cq.nCols(), blockSize);
@@ -565,10 +789,12 @@ double ExactExchangeEval::computePair(int ikReduced, int iqReduced, size_t& prog
 		//Prepare q-states in real space:
 		std::vector<std::vector<complexScalarField>> Ipsiq(bqStop-bqStart), grad_Ipsiq;
 		if(HCq) grad_Ipsiq.assign(bqStop-bqStart, std::vector<complexScalarField>(nSpinor));
+		std::vector<std::vector<double>> boxq(bqStop-bqStart); //box weights for pair screening
 		for(int bq=bqStart; bq<bqStop; bq++)
 		{	Ipsiq[bq-bqStart].resize(nSpinor);
 			for(int s=0; s<nSpinor; s++)
 				Ipsiq[bq-bqStart][s] = I(Cq.getColumn(bq,s));
+			if(pairThreshold) boxq[bq-bqStart] = boxWeights(Ipsiq[bq-bqStart]);
 		}
 		//Loop over k-states:
 		for(int bk=0; bk<CkRed.nCols(); bk++)
@@ -586,22 +812,72 @@ double ExactExchangeEval::computePair(int ikReduced, int iqReduced, size_t& prog
 				for(int s=0; s<nSpinor; s++)
 					Ipsik[s] = I(Ck.getColumn(0,s));
 				double wFk = qnum_k.weight * Fk[bk];
-				//Loop over q-bands within block:
+				//Collect q-bands within block that pair with this k-state:
+				std::vector<int> bqPaired;
+				std::vector<double> boxk; if(pairThreshold) boxk = boxWeights(Ipsik);
 				for(int bq=bqStart; bq<bqStop; bq++)
 				{	double wFq = qnum_q.weight * Fq[bq];
 					if(!wFk && !wFq) continue; //at least one of the orbitals must be occupied
-					complexScalarField In; //state pair density
+					if(pairThreshold)
+					{	//Upper bound on integral of |psi_k psi_q| (Cauchy-Schwarz within each box):
+						double overlapBound = 0.;
+						for(size_t iBox=0; iBox<boxk.size(); iBox++)
+							overlapBound += boxk[iBox] * boxq[bq-bqStart][iBox];
+						nPairsTotal++;
+						if(overlapBound < pairThreshold) { nPairsScreened++; continue; }
+					}
+					bqPaired.push_back(bq);
+				}
+				if(!bqPaired.size()) continue;
+				//Form the batch of state pair densities and transform them together:
+				int howMany = bqPaired.size();
+				ManagedArray<complex> nBatch; nBatch.init(size_t(howMany)*nr, isGpuEnabled());
+				complex* nBatchData = nBatch.dataPref();
+				for(int iPair=0; iPair<howMany; iPair++)
+				{	complexScalarField In; //state pair density
 					for(int s=0; s<nSpinor; s++)
-						In += conj(Ipsik[s]) * Ipsiq[bq-bqStart][s];
-					complexScalarFieldTilde n = J(In);
+					{	complexScalarField Ins = clone(Ipsiq[bqPaired[iPair]-bqStart][s]);
+						Ins->scale *= Ipsik[s]->scale;
+						callPref(eblas_zmulc)(nr, Ipsik[s]->dataPref(false), 1, Ins->dataPref(false), 1); //conj(psi_k) psi_q without a conjugated copy
+						In += Ins;
+					}
+					callPref(eblas_zero)(nr, nBatchData+size_t(iPair)*nr); //in case In is null (all-zero spinor components)
+					if(In) callPref(eblas_zaxpy)(nr, In->scale/nr, In->dataPref(false),1, nBatchData+size_t(iPair)*nr,1); //include normalization of J
+				}
+				fftBatch(gInfoWfns, nBatchData, howMany, false); //J for all pairs
+				nFFTs += howMany;
+				//Apply the Coulomb kernel to each pair density:
+				std::vector<double> nKn(howMany);
+				if((not EXX_RRT) and e.coulombWfns->applyExchangeBatch(nBatchData, howMany, qnum_q.k-qnum_k.k, omega, nKn.data()))
+				{	//Tabulated kernel applied in place to the whole batch (stress needs the densities, so uses the per-pair path):
+					for(int iPair=0; iPair<howMany; iPair++)
+					{	double wFq = qnum_q.weight * Fq[bqPaired[iPair]];
+						EXX += (prefac*wFk*wFq) * nKn[iPair];
+					}
+					if(HCq) callPref(eblas_zdscal)(howMany*nr, 1./nr, nBatchData, 1); //include normalization of Jdag
+				}
+				else for(int iPair=0; iPair<howMany; iPair++)
+				{	double wFq = qnum_q.weight * Fq[bqPaired[iPair]];
+					complexScalarFieldTilde n; nullToZero(n, gInfoWfns);
+					callPref(eblas_copy)(n->dataPref(false), nBatchData+size_t(iPair)*nr, nr);
 					complexScalarFieldTilde Kn = O((*e.coulombWfns)(n, qnum_q.k-qnum_k.k, omega)); //Electrostatic potential due to n
 					EXX += (prefac*wFk*wFq) * dot(n,Kn).real();
-					if(HCq)
-					{	complexScalarField E_In = Jdag(Kn);
+					if(EXX_RRT) *EXX_RRT += (prefac*wFk*wFq) * e.coulombWfns->latticeGradient(n, qnum_q.k-qnum_k.k, omega); //Stress contribution
+					if(HCq) //store potential in place of the density for the batched inverse transform:
+					{	callPref(eblas_zero)(nr, nBatchData+size_t(iPair)*nr);
+						callPref(eblas_zaxpy)(nr, Kn->scale/nr, Kn->dataPref(false),1, nBatchData+size_t(iPair)*nr,1); //include normalization of Jdag
+					}
+				}
+				//Transform potentials back together and propagate to q-state gradients:
+				if(HCq)
+				{	fftBatch(gInfoWfns, nBatchData, howMany, true); //Jdag for all pairs
+					nFFTs += howMany;
+					for(int iPair=0; iPair<howMany; iPair++)
+					{	complexScalarField E_In; nullToZero(E_In, gInfoWfns);
+						callPref(eblas_copy)(E_In->dataPref(false), nBatchData+size_t(iPair)*nr, nr);
 						for(int s=0; s<nSpinor; s++)
-							grad_Ipsiq[bq-bqStart][s] += (2.*prefac*wFk) * E_In * Ipsik[s]; //factor of 2 to count grad_Ipsik using Hermitian symmetry
+							grad_Ipsiq[bqPaired[iPair]-bqStart][s] += (2.*prefac*wFk) * E_In * Ipsik[s]; //factor of 2 to count grad_Ipsik using Hermitian symmetry
 					}
-					if(EXX_RRT) *EXX_RRT += (prefac*wFk*wFq) * e.coulombWfns->latticeGradient(n, qnum_q.k-qnum_k.k, omega); //Stress contribution
 				}
 			}
 		}
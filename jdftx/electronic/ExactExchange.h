@@ -45,8 +45,12 @@ public:
 		std::vector<ColumnBundle>* HC=0, matrix3<>* EXX_RRT=0) const;
 	
 	//! Initialize the ACE (Adiabatic Compression of Exchange) representation in preparation for applyHamiltonian
+	//! With exchange-ace-update, only the projectors of states whose wavefunctions changed sufficiently are rebuilt.
 	void prepareHamiltonian(double omega, const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C);
 	
+	//! Whether an ACE representation is ready at omega (and compatible with the current lattice)
+	bool hasHamiltonian(double omega) const;
+	
 	//! Apply Hamiltonian using ACE representation initialized previously, and return the exchange energy contribution from current q.
 	//! Note that fillings Fq are only used for computing the energy, and do not impact the Hamiltonian which only depends on F used in prepareHamiltonian().
 	//! HCq must be allocated (non-null) in order to collect the Hamiltonian contribution, else only energy is returned.
@@ -0,0 +1,106 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/HarrisFoulkes.h>
+#include <electronic/Everything.h>
+#include <electronic/ElecMinimizer.h>
+#include <electronic/ExCorr.h>
+#include <fluid/FluidSolver.h>
+
+void readDensityArray(ScalarFieldArray& var, string varName, string fnamePattern, const Everything* e); //declared in ElecVars.cpp
+
+void runHarrisFoulkes(Everything& e)
+{	ElecVars& eVars = e.eVars;
+	ElecInfo& eInfo = e.eInfo;
+	IonInfo& iInfo = e.iInfo;
+	if(e.exCorr.exxFactor() || e.exCorr.orbitalDep || e.exCorr.needsKEdensity() || eInfo.hasU)
+		die("Harris-Foulkes energy requires a density-only functional (no exact exchange, meta-GGA, orbital-dependent potentials or DFT+U).\n\n");
+	
+	//Input density:
+	if(e.cntrl.harrisDensityPattern.length())
+	{	logPrintf("\n----------- Harris-Foulkes energy at input density -------------\n");
+		readDensityArray(eVars.n, "n", e.cntrl.harrisDensityPattern, &e);
+	}
+	else
+	{	logPrintf("\n----------- Harris-Foulkes energy at superposition of atomic densities -------------\n");
+		ScalarFieldTildeArray nTilde(eVars.n.size());
+		for(auto sp: iInfo.species)
+			if(sp->atpos.size()) // Check for unused species
+				sp->accumulateAtomicDensity(nTilde);
+		nullToZero(nTilde, e.gInfo);
+		e.symm.symmetrize(nTilde);
+		for(unsigned s=0; s<eVars.n.size(); s++)
+			eVars.n[s] = I(nTilde[s]);
+	}
+	logFlush();
+	
+	//Hamiltonian of input density, and the density functional terms at the input density:
+	eVars.EdensityAndVscloc(e.ener);
+	if(eVars.fluidSolver && eVars.fluidSolver->useGummel())
+	{	//Relies on the gummel loop, so EdensityAndVscloc would not have invoked minimize
+		eVars.fluidSolver->minimizeFluid();
+		eVars.EdensityAndVscloc(e.ener); //update Vscloc
+	}
+	double EdoubleCount = 0.; //int Vscloc n_in (Vscloc includes the dV factor of JdagOJ)
+	for(unsigned s=0; s<eVars.n.size(); s++)
+		EdoubleCount += dot(eVars.n[s], eVars.Vscloc[s]);
+	Energies enerHarris = e.ener;
+	
+	//Single band solve:
+	iInfo.augmentDensityGridGrad(eVars.Vscloc); //update Vscloc atom projections for ultrasoft psp's
+	logPrintf("\n----------- Band structure minimization -------------\n"); logFlush();
+	bandMinimize(e);
+	
+	//Fillings from the output eigenvalues:
+	if(eInfo.fillingsUpdate == ElecInfo::FillingsHsub)
+	{	double Bz, mu = std::isnan(eInfo.mu) ? eInfo.findMu(eVars.Hsub_eigs, eInfo.nElectrons, Bz) : eInfo.mu;
+		if(!std::isnan(eInfo.mu)) eInfo.nElectrons = eInfo.nElectronsCalc(mu, eVars.Hsub_eigs, Bz);
+		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+			eVars.F[q] = eInfo.smear(eInfo.muEff(mu,Bz,q), eVars.Hsub_eigs[q]);
+		eInfo.updateFillingsEnergies(eVars.Hsub_eigs, enerHarris);
+		eVars.Haux_eigs = eVars.Hsub_eigs;
+		eInfo.smearReport();
+	}
+	double EbandSum = 0.; //sum_i f_i eps_i
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++)
+		for(int b=0; b<eInfo.nBands; b++)
+			EbandSum += eInfo.qnums[q].weight * eVars.F[q][b] * eVars.Hsub_eigs[q][b];
+	mpiWorld->allReduce(EbandSum, MPIUtil::ReduceSum);
+	
+	//Harris-Foulkes energy (replacing kinetic and nonlocal terms by the band sum and double-counting correction):
+	enerHarris.E["KE"] = 0.;
+	enerHarris.E["Enl"] = 0.;
+	enerHarris.E["Eband"] = EbandSum;
+	enerHarris.E["Edc"] = -EdoubleCount;
+	
+	//Output density and (approximate) forces:
+	eVars.n = eVars.calcDensity();
+	eVars.EdensityAndVscloc(e.ener);
+	iInfo.augmentDensityGridGrad(eVars.Vscloc);
+	iInfo.ionicEnergyAndGrad();
+	e.ener = enerHarris;
+	eVars.isRandom = false;
+	
+	logPrintf("\n");
+	iInfo.printPositions(globalLog);
+	iInfo.forces.print(e, globalLog);
+	logPrintf("# Energy components (Harris-Foulkes):\n"); e.ener.print(); logPrintf("\n");
+	logPrintf("Harris-Foulkes %s = %+.15lf\n", relevantFreeEnergyName(e), relevantFreeEnergy(e));
+	logFlush();
+}
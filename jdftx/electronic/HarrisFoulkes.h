@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_HARRISFOULKES_H
+#define JDFTX_ELECTRONIC_HARRISFOULKES_H
+
+class Everything;
+
+//! @addtogroup ElectronicDFT
+//! @{
+//! @file HarrisFoulkes.h Non-self-consistent Harris-Foulkes energy (command harris-foulkes-energy)
+
+/** Approximate energy and forces from a single band solve in the Hamiltonian of an input density:
+the superposition of atomic densities, or the density read from Control::harrisDensityPattern.
+The Harris-Foulkes functional, E = sum_i f_i eps_i - int Vscloc n_in + E_density[n_in] + E_ions,
+is stationary with respect to the input density, so that its error is second order in n_in - n_scf.
+Forces are evaluated at the output density of the band solve, and are therefore also approximate.
+*/
+void runHarrisFoulkes(Everything& e);
+
+//! @}
+#endif // JDFTX_ELECTRONIC_HARRISFOULKES_H
@@ -27,8 +27,10 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/FluidSolver.h>
 #include <core/SphericalHarmonics.h>
 #include <core/Units.h>
+#include <core/NeighborList.h>
 #include <cstdio>
 #include <cmath>
+#include <map>
 
 #define MIN_ION_DISTANCE 1e-10
 
@@ -86,6 +88,8 @@ void IonInfo::setup(const Everything &everything)
 		and ( (not (std::isnan)(e->ionicDynParams.P0))
 			or (not (std::isnan)(trace(e->ionicDynParams.stress0))) ) )
 		computeStress = true; //needed for ionic dynamics at constant pressure or stress
+	if(e->ipiDriver)
+		computeStress = true; //virial returned to the ipi-driver server
 	for(auto dumpPair: e->dump)
 		if(dumpPair.second == DumpStress)
 			computeStress = true; //needed for stress output
@@ -115,36 +119,73 @@ void IonInfo::printPositions(FILE* fp) const
 // Check for overlapping atoms, returns true if okay
 bool IonInfo::checkPositions() const
 {	bool okay = true;
-	double sizetest = 0;
-	vector3<> vtest[2];
-
-	for(auto sp: species)
-		for(unsigned n=0; n < sp->atpos.size(); n++)
-		{	if(sp->coreRadius == 0.) continue;
-			vtest[0] = sp->atpos[n];
-			for(auto sp1: species)
-			{	if(sp1->coreRadius == 0.) continue;
-				for (unsigned n1 = ((sp1==sp) ? (n+1) : 0); n1 < sp1->atpos.size(); n1++)
-				{	vtest[1] = vtest[0] - sp1->atpos[n1];
-					for(int i=0; i<3; i++) // Get periodic distance
-						vtest[1][i] = vtest[1][i] - floor(vtest[1][i] + 0.5);
-					sizetest = sqrt(dot(e->gInfo.R*vtest[1], e->gInfo.R*vtest[1]));
-					if (coreOverlapCondition==additive and (sizetest < (sp->coreRadius + sp1->coreRadius)))
-					{	logPrintf("\nWARNING: %s #%d and %s #%d are closer than the sum of their core radii.",
-							sp->name.c_str(), n, sp1->name.c_str(), n1);
-						okay = false;
-					}
-					else if (coreOverlapCondition==vector and (sizetest < sqrt(pow(sp->coreRadius, 2) + pow(sp1->coreRadius, 2))))
-					{	logPrintf("\nWARNING: %s #%d and %s #%d are closer than the vector-sum of their core radii.",
-							sp->name.c_str(), n, sp1->name.c_str(), n1);
-						okay = false;
-					}
-					else if(sizetest < MIN_ION_DISTANCE)
-					{	die("\nERROR: Ions %s #%d and %s #%d are on top of eachother.\n\n", sp->name.c_str(), n, sp1->name.c_str(), n1);
-					}
-				}
-			}
+	
+	//Collect atoms with non-zero core radii:
+	std::vector<vector3<>> pos;
+	std::vector<std::pair<int,int>> atomIndex; //species and atom index within species
+	double coreRadiusMax = 0.;
+	for(int sp=0; sp<int(species.size()); sp++)
+	{	if(species[sp]->coreRadius == 0.) continue;
+		coreRadiusMax = std::max(coreRadiusMax, species[sp]->coreRadius);
+		for(int n=0; n<int(species[sp]->atpos.size()); n++)
+		{	pos.push_back(species[sp]->atpos[n]);
+			atomIndex.push_back(std::make_pair(sp, n));
+		}
+	}
+	if(!pos.size()) return true;
+	
+	//Find minimum distance (over periodic images) of each pair within the largest possible overlap distance:
+	//--- every process checks all pairs (on fewer atoms than other pair terms), so that all of them agree
+	NeighborList neighbors(e->gInfo.R, e->coulombParams.isTruncated(), pos, 2*coreRadiusMax, false);
+	typedef std::map<std::pair<int,int>, double> PairDistances;
+	std::vector<PairDistances> closePairsThreads(NeighborList::nThreads()); //minimum distance of close pairs per thread
+	neighbors.forEachPairThreaded([&](int iThread, int c1, int c2, const vector3<>& x, double rSq)
+	{	if(c1 == c2) return; //images of the same atom
+		double r = sqrt(rSq);
+		double coreRadius1 = species[atomIndex[c1].first]->coreRadius;
+		double coreRadius2 = species[atomIndex[c2].first]->coreRadius;
+		if(r >= std::max(coreRadius1 + coreRadius2, MIN_ION_DISTANCE)) return; //cannot fail any check below
+		auto inserted = closePairsThreads[iThread].insert(std::make_pair(std::make_pair(c1, c2), r));
+		if(!inserted.second) inserted.first->second = std::min(inserted.first->second, r);
+	});
+	PairDistances closePairs;
+	//--- exactly coincident atoms (which neighbor lists exclude along with self-interactions):
+	const vector3<bool>& isTruncated = e->coulombParams.isTruncated();
+	std::map<std::vector<double>, int> wrappedPos;
+	for(int c=0; c<int(pos.size()); c++)
+	{	std::vector<double> key(3);
+		for(int k=0; k<3; k++)
+			key[k] = isTruncated[k] ? pos[c][k] : pos[c][k] - floor(pos[c][k]);
+		auto inserted = wrappedPos.insert(std::make_pair(key, c));
+		if(!inserted.second) closePairs[std::make_pair(inserted.first->second, c)] = 0.;
+	}
+	for(const PairDistances& closePairsThread: closePairsThreads)
+		for(const auto& entry: closePairsThread)
+		{	auto inserted = closePairs.insert(entry);
+			if(!inserted.second) inserted.first->second = std::min(inserted.first->second, entry.second);
+		}
+	
+	//Report overlaps in order:
+	for(const auto& entry: closePairs)
+	{	const SpeciesInfo& sp = *species[atomIndex[entry.first.first].first];
+		const SpeciesInfo& sp1 = *species[atomIndex[entry.first.second].first];
+		int n = atomIndex[entry.first.first].second;
+		int n1 = atomIndex[entry.first.second].second;
+		double sizetest = entry.second;
+		if (coreOverlapCondition==additive and (sizetest < (sp.coreRadius + sp1.coreRadius)))
+		{	logPrintf("\nWARNING: %s #%d and %s #%d are closer than the sum of their core radii.",
+				sp.name.c_str(), n, sp1.name.c_str(), n1);
+			okay = false;
+		}
+		else if (coreOverlapCondition==vector and (sizetest < sqrt(pow(sp.coreRadius, 2) + pow(sp1.coreRadius, 2))))
+		{	logPrintf("\nWARNING: %s #%d and %s #%d are closer than the vector-sum of their core radii.",
+				sp.name.c_str(), n, sp1.name.c_str(), n1);
+			okay = false;
 		}
+		else if(sizetest < MIN_ION_DISTANCE)
+		{	die("\nERROR: Ions %s #%d and %s #%d are on top of eachother.\n\n", sp.name.c_str(), n, sp1.name.c_str(), n1);
+		}
+	}
 		
 	if(not okay) // Add another line after printing core overlap warnings
 		logPrintf("\n");
@@ -357,20 +398,158 @@ void IonInfo::augmentDensitySphericalGrad(const QuantumNumber& qnum, const std::
 		species[sp]->augmentDensitySphericalGrad(qnum, VdagCq[sp], HVdagCq[sp]);
 }
 
+//Real-space projection of all species (see Control::realSpaceProjectorRadius): species[sp] with needed[sp] set are projected onto VdagCq[sp]
+static void projectRealSpace(const std::vector<std::shared_ptr<SpeciesInfo>>& species, const std::vector<bool>& needed, const ColumnBundle& Cq, std::vector<matrix>& VdagCq)
+{	std::vector<std::shared_ptr<SpeciesInfo::RealSpaceProjector>> Vr(species.size());
+	for(unsigned sp=0; sp<species.size(); sp++)
+		if(needed[sp])
+		{	Vr[sp] = species[sp]->getVr(Cq);
+			if(Vr[sp]) VdagCq[sp] = zeroes(Vr[sp]->index.size() * Vr[sp]->V[0].nCols() * Cq.spinorLength(), Cq.nCols());
+		}
+	const GridInfo& gInfo = *(Cq.basis->gInfo);
+	int nSpinor = Cq.spinorLength();
+	int batchSize = std::max(1, gInfo.fftBatchSize);
+	for(int colStart=0; colStart<Cq.nCols(); colStart+=batchSize)
+	{	int colStop = std::min(colStart+batchSize, Cq.nCols());
+		int nGrids = (colStop-colStart) * nSpinor;
+		ManagedArray<complex> psi = I_batch(Cq, colStart, colStop);
+		const complex* psiData = psi.data();
+		for(unsigned sp=0; sp<species.size(); sp++) if(Vr[sp])
+		{	complex* VdagCqData = VdagCq[sp].data();
+			for(unsigned atom=0; atom<Vr[sp]->index.size(); atom++)
+			{	const std::vector<int>& index = Vr[sp]->index[atom];
+				const matrix& Va = Vr[sp]->V[atom];
+				int nProj = Va.nCols();
+				//Gather wavefunctions within sphere and project:
+				matrix psiSphere(index.size(), nGrids);
+				complex* psiSphereData = psiSphere.data();
+				for(int g=0; g<nGrids; g++)
+					for(size_t i=0; i<index.size(); i++)
+						psiSphereData[psiSphere.index(i,g)] = psiData[size_t(g)*gInfo.nr + index[i]];
+				matrix VaDagPsi = (1./gInfo.nr) * (dagger(Va) * psiSphere); //Parseval for the unnormalized I
+				//Store with row order (atom, projector, spinor) and column order (band), as in the reciprocal-space V^Cq:
+				const complex* VaDagPsiData = VaDagPsi.data();
+				for(int b=colStart; b<colStop; b++)
+					for(int p=0; p<nProj; p++)
+						for(int s=0; s<nSpinor; s++)
+							VdagCqData[VdagCq[sp].index((atom*nProj+p)*nSpinor+s, b)] = VaDagPsiData[VaDagPsi.index(p, (b-colStart)*nSpinor+s)];
+			}
+		}
+	}
+}
+
+//Real-space gradient propagation corresponding to projectRealSpace
+static void projectGradRealSpace(const std::vector<std::shared_ptr<SpeciesInfo>>& species, const std::vector<matrix>& HVdagCq, const ColumnBundle& Cq, ColumnBundle& HCq)
+{	std::vector<std::shared_ptr<SpeciesInfo::RealSpaceProjector>> Vr(species.size());
+	for(unsigned sp=0; sp<species.size(); sp++)
+		if(HVdagCq[sp]) Vr[sp] = species[sp]->getVr(Cq);
+	const GridInfo& gInfo = *(Cq.basis->gInfo);
+	int nSpinor = Cq.spinorLength();
+	int batchSize = std::max(1, gInfo.fftBatchSize);
+	for(int colStart=0; colStart<Cq.nCols(); colStart+=batchSize)
+	{	int colStop = std::min(colStart+batchSize, Cq.nCols());
+		int nGrids = (colStop-colStart) * nSpinor;
+		ManagedArray<complex> psi; psi.init(size_t(nGrids)*gInfo.nr);
+		psi.zero();
+		complex* psiData = psi.data();
+		for(unsigned sp=0; sp<species.size(); sp++) if(Vr[sp])
+		{	const complex* HVdagCqData = HVdagCq[sp].data();
+			for(unsigned atom=0; atom<Vr[sp]->index.size(); atom++)
+			{	const std::vector<int>& index = Vr[sp]->index[atom];
+				const matrix& Va = Vr[sp]->V[atom];
+				int nProj = Va.nCols();
+				matrix M(nProj, nGrids);
+				complex* Mdata = M.data();
+				for(int b=colStart; b<colStop; b++)
+					for(int p=0; p<nProj; p++)
+						for(int s=0; s<nSpinor; s++)
+							Mdata[M.index(p, (b-colStart)*nSpinor+s)] = HVdagCqData[HVdagCq[sp].index((atom*nProj+p)*nSpinor+s, b)];
+				//Expand within sphere and scatter onto the grids:
+				matrix VaM = Va * M;
+				const complex* VaMdata = VaM.data();
+				for(int g=0; g<nGrids; g++)
+					for(size_t i=0; i<index.size(); i++)
+						psiData[size_t(g)*gInfo.nr + index[i]] += VaMdata[VaM.index(i,g)];
+			}
+		}
+		eblas_zdscal(psi.nData(), 1./gInfo.nr, psiData, 1); //Idag(I(V))/nr recovers V
+		Idag_accum_batch(psi, colStart, colStop, HCq);
+	}
+}
+
 void IonInfo::project(const ColumnBundle& Cq, std::vector<matrix>& VdagCq, matrix* rotExisting) const
 {	VdagCq.resize(species.size());
-	for(unsigned sp=0; sp<e->iInfo.species.size(); sp++)
+	if(e->cntrl.realSpaceProjectorRadius)
+	{	std::vector<bool> needed(species.size());
+		for(unsigned sp=0; sp<species.size(); sp++)
+		{	if(rotExisting && VdagCq[sp]) VdagCq[sp] = VdagCq[sp] * (*rotExisting); //rotate and keep the existing projections
+			else needed[sp] = species[sp]->nProjectors();
+		}
+		projectRealSpace(species, needed, Cq, VdagCq);
+		return;
+	}
+	//Collect projectors of species that need a fresh projection:
+	std::vector<std::shared_ptr<ColumnBundle>> V(species.size());
+	int nProjTot = 0, nSpProj = 0;
+	for(unsigned sp=0; sp<species.size(); sp++)
 	{	if(rotExisting && VdagCq[sp]) VdagCq[sp] = VdagCq[sp] * (*rotExisting); //rotate and keep the existing projections
 		else
-		{	auto V = e->iInfo.species[sp]->getV(Cq);
-			if(V) VdagCq[sp] = (*V) ^ Cq;
+		{	V[sp] = species[sp]->getV(Cq);
+			if(V[sp]) { nProjTot += V[sp]->nCols(); nSpProj++; }
 		}
 	}
+	if(nSpProj == 1) //single species: project directly
+	{	for(unsigned sp=0; sp<species.size(); sp++)
+			if(V[sp]) VdagCq[sp] = (*V[sp]) ^ Cq;
+	}
+	else if(nSpProj > 1) //combine projectors of all species into one bundle, so that projection is a single GEMM:
+	{	ColumnBundle Vall(nProjTot, Cq.basis->nbasis, Cq.basis, Cq.qnum, isGpuEnabled());
+		int iProj = 0;
+		for(unsigned sp=0; sp<species.size(); sp++)
+			if(V[sp]) { Vall.setSub(iProj, *V[sp]); iProj += V[sp]->nCols(); }
+		matrix VallDagCq = Vall ^ Cq;
+		int rowsPerProj = VallDagCq.nRows() / nProjTot; //2 for spinor Cq (consecutive rows per projector), else 1
+		int iRow = 0;
+		for(unsigned sp=0; sp<species.size(); sp++)
+			if(V[sp])
+			{	int nRows = rowsPerProj * V[sp]->nCols();
+				VdagCq[sp] = VallDagCq(iRow,iRow+nRows, 0,VallDagCq.nCols());
+				iRow += nRows;
+			}
+	}
 }
 
 void IonInfo::projectGrad(const std::vector<matrix>& HVdagCq, const ColumnBundle& Cq, ColumnBundle& HCq) const
-{	for(unsigned sp=0; sp<species.size(); sp++)
-		if(HVdagCq[sp]) HCq += *(species[sp]->getV(Cq)) * HVdagCq[sp];
+{	if(e->cntrl.realSpaceProjectorRadius)
+	{	projectGradRealSpace(species, HVdagCq, Cq, HCq);
+		return;
+	}
+	std::vector<std::shared_ptr<ColumnBundle>> V(species.size());
+	int nProjTot = 0, nRowsTot = 0, nSpProj = 0;
+	for(unsigned sp=0; sp<species.size(); sp++)
+		if(HVdagCq[sp])
+		{	V[sp] = species[sp]->getV(Cq);
+			nProjTot += V[sp]->nCols();
+			nRowsTot += HVdagCq[sp].nRows();
+			nSpProj++;
+		}
+	if(nSpProj == 1) //single species: propagate directly
+	{	for(unsigned sp=0; sp<species.size(); sp++)
+			if(HVdagCq[sp]) HCq += (*V[sp]) * HVdagCq[sp];
+	}
+	else if(nSpProj > 1) //stack projectors and projected gradients of all species for a single GEMM:
+	{	ColumnBundle Vall(nProjTot, Cq.basis->nbasis, Cq.basis, Cq.qnum, isGpuEnabled());
+		matrix HVallDagCq(nRowsTot, HCq.nCols());
+		int iProj = 0, iRow = 0;
+		for(unsigned sp=0; sp<species.size(); sp++)
+			if(HVdagCq[sp])
+			{	Vall.setSub(iProj, *V[sp]); iProj += V[sp]->nCols();
+				int nRows = HVdagCq[sp].nRows();
+				HVallDagCq.set(iRow,iRow+nRows, 0,HCq.nCols(), HVdagCq[sp]);
+				iRow += nRows;
+			}
+		HCq += Vall * HVallDagCq;
+	}
 }
 
 //----- DFT+U functions --------
@@ -391,11 +570,50 @@ void IonInfo::rhoAtom_initZero(std::vector<matrix>& rhoAtom) const
 	}
 }
 
+//Project Cq onto the (cached) Hubbard orbitals of all species with a single GEMM, analogous to IonInfo::project.
+//Rows of the result are ordered by species, and the corresponding stacked orbitals are optionally returned in OpsiAll.
+static matrix rhoAtom_project(const std::vector< std::shared_ptr<SpeciesInfo> >& species, const ColumnBundle& Cq,
+	std::vector<int>& rowStart, std::shared_ptr<ColumnBundle>* OpsiAll=0)
+{	static StopWatch watch("rhoAtom_project"); watch.start();
+	std::vector<std::shared_ptr<ColumnBundle>> Opsi(species.size());
+	rowStart.assign(species.size()+1, 0);
+	int nSpU = 0; unsigned spU = 0;
+	for(unsigned sp=0; sp<species.size(); sp++)
+	{	rowStart[sp+1] = rowStart[sp];
+		if(species[sp]->rhoAtom_nMatrices())
+		{	Opsi[sp] = species[sp]->rhoAtom_getOpsi(Cq);
+			rowStart[sp+1] += Opsi[sp]->nCols();
+			nSpU++; spU = sp;
+		}
+	}
+	std::shared_ptr<ColumnBundle> OpsiStack;
+	if(nSpU == 1) OpsiStack = Opsi[spU]; //single species: use directly
+	else if(nSpU > 1) //combine orbitals of all species into one bundle:
+	{	OpsiStack = std::make_shared<ColumnBundle>(Cq.similar(rowStart.back()));
+		for(unsigned sp=0; sp<species.size(); sp++)
+			if(Opsi[sp]) OpsiStack->setSub(rowStart[sp], *Opsi[sp]);
+	}
+	matrix OpsiDagCq = OpsiStack ? (*OpsiStack) ^ Cq : matrix();
+	if(OpsiAll) *OpsiAll = OpsiStack;
+	watch.stop();
+	return OpsiDagCq;
+}
+
 void IonInfo::rhoAtom_calc(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, std::vector<matrix>& rhoAtom) const
-{	matrix* rhoAtomPtr = rhoAtom.data();
-	for(const auto& sp: species)
-	{	sp->rhoAtom_calc(F, C, rhoAtomPtr);
-		rhoAtomPtr += sp->rhoAtom_nMatrices();
+{	//Projections for all species together:
+	std::vector<matrix> OpsiDagC(C.size());
+	std::vector<int> rowStart;
+	for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
+		OpsiDagC[q] = rhoAtom_project(species, C[q], rowStart);
+	//Density matrices per species:
+	matrix* rhoAtomPtr = rhoAtom.data();
+	for(unsigned sp=0; sp<species.size(); sp++)
+	{	if(!species[sp]->rhoAtom_nMatrices()) continue;
+		std::vector<matrix> OpsiDagC_sp(C.size());
+		for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
+			OpsiDagC_sp[q] = OpsiDagC[q](rowStart[sp],rowStart[sp+1], 0,OpsiDagC[q].nCols());
+		species[sp]->rhoAtom_calc(F, OpsiDagC_sp, rhoAtomPtr);
+		rhoAtomPtr += species[sp]->rhoAtom_nMatrices();
 	}
 }
 
@@ -412,11 +630,23 @@ double IonInfo::rhoAtom_computeU(const std::vector<matrix>& rhoAtom, std::vector
 }
 
 void IonInfo::rhoAtom_grad(const ColumnBundle& Cq, const std::vector<matrix>& U_rhoAtom, ColumnBundle& HCq) const
-{	const matrix* U_rhoAtomPtr = U_rhoAtom.data();
-	for(const auto& sp: species)
-	{	sp->rhoAtom_grad(Cq, U_rhoAtomPtr, HCq);
-		U_rhoAtomPtr += sp->rhoAtom_nMatrices();
+{	static StopWatch watch("rhoAtom_grad"); watch.start();
+	std::vector<int> rowStart;
+	std::shared_ptr<ColumnBundle> OpsiAll;
+	matrix OpsiDagCq = rhoAtom_project(species, Cq, rowStart, &OpsiAll);
+	if(!OpsiAll) { watch.stop(); return; }
+	//Collect gradient coefficients of all species, and propagate with a single GEMM:
+	matrix coeff(OpsiDagCq.nRows(), OpsiDagCq.nCols());
+	const matrix* U_rhoAtomPtr = U_rhoAtom.data();
+	for(unsigned sp=0; sp<species.size(); sp++)
+	{	if(!species[sp]->rhoAtom_nMatrices()) continue;
+		int nCols = OpsiDagCq.nCols();
+		coeff.set(rowStart[sp],rowStart[sp+1], 0,nCols,
+			species[sp]->rhoAtom_grad(*Cq.qnum, U_rhoAtomPtr, OpsiDagCq(rowStart[sp],rowStart[sp+1], 0,nCols)));
+		U_rhoAtomPtr += species[sp]->rhoAtom_nMatrices();
 	}
+	HCq += (*OpsiAll) * coeff;
+	watch.stop();
 }
 
 void IonInfo::rhoAtom_forces(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, const std::vector<matrix>& U_rhoAtom, IonicGradient& forces, matrix3<>* EU_RRT) const
@@ -141,6 +141,8 @@ private:
 	
 	//! Compute pulay contributions to energy and optionally stress
 	double calcEpulay(matrix3<>* E_RRT=0) const;
+	
+	friend class IonicDynamics; //uses pairPotentialsAndGrad alone for multiple time steps
 };
 
 //! @}
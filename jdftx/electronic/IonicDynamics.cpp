@@ -33,7 +33,8 @@ IonicDynamics::IonicDynamics(Everything& e)
 	statT(e.ionicDynParams.statMethod!=IonicDynamicsParams::StatNone),
 	statP(statT and (not (std::isnan)(e.ionicDynParams.P0))),
 	statStress(statT and (not (std::isnan)(trace(e.ionicDynParams.stress0)))),
-	lmin(LatticeMinimizer(e, true, statP, statStress)), nAccumNeeded(false)
+	lmin(LatticeMinimizer(e, true, statP, statStress)), nAccumNeeded(false),
+	nSurrogateSteps(0), usedSurrogate(false), sigmaF(NAN)
 {
 	logPrintf("---------- Ionic Dynamics -----------\n");
 	
@@ -63,6 +64,14 @@ IonicDynamics::IonicDynamics(Everything& e)
 	{	e.iInfo.thermostat.clear();
 		e.iInfo.barostat.clear();
 	}
+	if((idp.statMethod==IonicDynamicsParams::Langevin or idp.nInnerSteps>1) and (statP or statStress))
+		die("Barostats are only supported with statMethod Berendsen or NoseHoover, and nInnerSteps = 1.\n\n");
+	if(idp.nInnerSteps > 1)
+		logPrintf("Multiple time steps: pair potentials integrated with %d substeps of %lg fs.\n", idp.nInnerSteps, idp.dt/(idp.nInnerSteps*fs));
+	if(idp.surrogateThreshold)
+	{	if(statP or statStress) die("Surrogate potential is not supported with barostats.\n\n");
+		surrogate = std::make_shared<IonicSurrogate>(e);
+	}
 	if(statStress) stressTarget = idp.stress0;
 	if(statP) stressTarget = -idp.P0 * matrix3<>(1,1,1);
 	assert(not (statStress and statP));
@@ -175,12 +184,72 @@ void IonicDynamics::computeKE()
 
 LatticeGradient IonicDynamics::computePE()
 {	LatticeGradient gradUnused, accel; accel.init(e.iInfo);
+	//Use surrogate potential if available and confident:
+	usedSurrogate = false;
+	if(surrogate)
+	{	IonicGradient forces;
+		if(nSurrogateSteps < e.ionicDynParams.surrogateMaxSteps and surrogate->predict(PE, forces, sigmaF))
+		{	usedSurrogate = true;
+			nSurrogateSteps++;
+			//Convert to acceleration (as in IonicMinimizer::compute in dynamicsMode):
+			accel.ionic = forces;
+			for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+			{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+				for(size_t at=0; at<spInfo.atpos.size(); at++)
+					accel.ionic[sp][at] *= (spInfo.constraints[at].moveScale ? 1./(spInfo.mass*amu) : 0.);
+			}
+			lmin.constrain(accel);
+			return accel;
+		}
+		nSurrogateSteps = 0;
+	}
 	PE = lmin.compute(&gradUnused, &accel); //In dynamicsMode, Lattice/IonicMinimizer::compute replaces Kgrad with acceleration
 	if(std::isnan(PE))
 		die("\nIonicDynamics: step caused pseudopotential core overlap (try core-overlap-check none).\n\n");
+	if(surrogate) surrogate->train(PE, e.gInfo.invRT * e.iInfo.forces); //in Cartesian coordinates
+	return accel;
+}
+
+LatticeGradient IonicDynamics::computeFastAccel(const LatticeGradient& dpos)
+{	//Temporarily displace atoms (pair potentials depend only on atpos, so no electronic update needed):
+	std::vector<std::vector<vector3<>>> atposOrig;
+	for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+	{	SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+		atposOrig.push_back(spInfo.atpos);
+		for(size_t at=0; at<spInfo.atpos.size(); at++)
+			spInfo.atpos[at] += e.gInfo.invR * dpos.ionic[sp][at];
+	}
+	IonicGradient forces; forces.init(e.iInfo);
+	e.iInfo.pairPotentialsAndGrad(0, &forces);
+	for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+		e.iInfo.species[sp]->atpos = atposOrig[sp];
+	//Convert to Cartesian acceleration (as in IonicMinimizer::compute in dynamicsMode):
+	LatticeGradient accel; accel.init(e.iInfo);
+	accel.ionic = e.gInfo.invRT * forces;
+	for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+	{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+		for(size_t at=0; at<spInfo.atpos.size(); at++)
+			accel.ionic[sp][at] *= (spInfo.constraints[at].moveScale ? 1./(spInfo.mass*amu) : 0.);
+	}
+	lmin.constrain(accel);
 	return accel;
 }
 
+void IonicDynamics::langevinStep(LatticeGradient& vel, double dt)
+{	double c1 = exp(-dt/e.ionicDynParams.tDampT); //velocity decay factor
+	double c2 = sqrt(1. - c1*c1); //noise amplitude factor (fluctuation-dissipation)
+	LatticeGradient noise = vel;
+	randomize(noise.ionic); //unit normal distribution
+	for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+	{	mpiWorld->bcastData(noise.ionic[sp]); //identical noise on all processes
+		double sigmaV = c2 * sqrt(e.ionicDynParams.T0 / (e.iInfo.species[sp]->mass*amu)); //thermal velocity scale
+		for(vector3<>& v: noise.ionic[sp]) v *= sigmaV;
+	}
+	lmin.constrain(noise);
+	vel.ionic = vel.ionic * c1;
+	vel.ionic += noise.ionic;
+}
+
 LatticeGradient IonicDynamics::thermostat(const LatticeGradient& vel)
 {	const IonicDynamicsParams& idp = e.ionicDynParams;
 	//Update KE and pressure first:
@@ -233,6 +302,7 @@ LatticeGradient IonicDynamics::thermostat(const LatticeGradient& vel)
 				}
 				break;
 			}
+			case IonicDynamicsParams::Langevin: break; //friction and noise applied directly in langevinStep
 			case IonicDynamicsParams::StatNone: break; //Never reached (just to suppress compiler warning)
 		}
 		//Set atom velocity damping terms:
@@ -247,6 +317,12 @@ LatticeGradient IonicDynamics::thermostat(const LatticeGradient& vel)
 bool IonicDynamics::report(int iter, double t)
 {	logPrintf("\nIonicDynamics: Step: %3d  PE: %10.6lf  KE: %10.6lf  T[K]: %8.3lf  P[Bar]: %8.4le  tMD[fs]: %9.2lf  t[s]: %9.2lf\n",
 		iter, PE, KE, T/Kelvin, p/Bar, t/fs, clock_sec());
+	if(surrogate)
+		logPrintf("IonicDynamics: %s step (surrogate force uncertainty: %lg Eh/a0, training steps: %d)\n",
+			usedSurrogate ? "Surrogate" : "DFT", sigmaF, surrogate->nTrain());
+	if(EventLog::active)
+		EventLog::Event("dynamics", "IonicDynamics").add("iter", iter).add("PE", PE).add("KE", KE)
+			.add("T_K", T/Kelvin).add("P_Bar", p/Bar).add("tMD_fs", t/fs).add("surrogate", int(usedSurrogate));
 	if(e.iInfo.computeStress)
 	{	logPrintf("\n# Stress tensor including kinetic terms in Cartesian coordinates [Eh/a0^3]:\n");
 		stress.print(globalLog, "%12lg ", true, 1e-14);
@@ -254,34 +330,74 @@ bool IonicDynamics::report(int iter, double t)
 	return lmin.report(iter);
 }
 
+void IonicDynamics::stepMultiple(LatticeGradient& accelSlow, LatticeGradient& accelFast, LatticeGradient& accelV)
+{	const IonicDynamicsParams& idp = e.ionicDynParams;
+	bool respa = (idp.nInnerSteps > 1);
+	bool langevin = (idp.statMethod == IonicDynamicsParams::Langevin);
+	double dtInner = idp.dt / idp.nInnerSteps;
+	//--- outer velocity update: first half step with slow (DFT - pair potential) forces:
+	LatticeGradient vel = getVelocities();
+	axpy(0.5*idp.dt, accelSlow+accelV, vel);
+	//--- inner steps (B-A-O-A-B with pair potential forces), accumulating the displacement:
+	LatticeGradient dpos; dpos.init(e.iInfo);
+	for(int iInner=0; iInner<idp.nInnerSteps; iInner++)
+	{	if(respa) axpy(0.5*dtInner, accelFast, vel);
+		axpy(0.5*dtInner, vel.ionic, dpos.ionic);
+		if(langevin) langevinStep(vel, dtInner);
+		axpy(0.5*dtInner, vel.ionic, dpos.ionic);
+		if(respa)
+		{	accelFast = computeFastAccel(dpos);
+			axpy(0.5*dtInner, accelFast, vel);
+		}
+	}
+	//--- move atoms (with wavefunction drag / extrapolation) and update DFT forces:
+	lmin.step(dpos, 1.);
+	accelSlow = computePE();
+	if(respa) axpy(-1., accelFast, accelSlow); //pair-potential forces at the final positions were computed in the last substep
+	//--- outer velocity update: second half step (estimator-corrector for thermostat, as in velocity Verlet):
+	axpy(0.5*idp.dt, accelSlow+accelV, vel);
+	LatticeGradient accelVnew = thermostat(vel);
+	axpy(0.5*idp.dt, accelVnew-accelV, vel);
+	accelV = thermostat(vel); //also sets velocities to iInfo and updates KE, pressure
+}
+
 void IonicDynamics::run()
 {	const IonicDynamicsParams& idp = e.ionicDynParams;
+	bool multiStep = (idp.nInnerSteps > 1) or (idp.statMethod == IonicDynamicsParams::Langevin);
 	
 	//Initial energies and forces
 	if(nAccumNeeded) nullToZero(e.eVars.nAccum, e.gInfo);
 	LatticeGradient accel = computePE(), accelV = thermostat(getVelocities()); //in Cartesian coordinates
+	LatticeGradient accelFast; //pair-potential part of accel (for multiple time steps)
+	if(idp.nInnerSteps > 1)
+	{	LatticeGradient dposZero; dposZero.init(e.iInfo);
+		accelFast = computeFastAccel(dposZero);
+		axpy(-1., accelFast, accel); //slow part of acceleration
+	}
 	
 	for(int iter=0; iter<=idp.nSteps; iter++)
 	{	double t = iter*idp.dt;
 		report(iter, t);
 		if(iter==idp.nSteps) break;
 		
-		//Velocity Verlet step:
-		//--- velocity update: first half step
-		LatticeGradient vel = getVelocities();
-		axpy(0.5*idp.dt, accel+accelV, vel);
-		//--- position and position-dependent acceleration update:
-		lmin.step(vel, idp.dt);
-		accel = computePE();
-		//--- velocity update: second half step estimator
-		axpy(0.5*idp.dt, accel+accelV, vel); //note second-order error here due to first-order error in accelV
-		//--- velocity update: second half step corrector
-		LatticeGradient accelVnew = thermostat(vel);
-		axpy(0.5*idp.dt, accelVnew-accelV, vel); //corrects second-order error introduced in estimator step
-		accelV = thermostat(vel); //also sets velocities to iInfo and updates KE, pressure
+		if(multiStep) stepMultiple(accel, accelFast, accelV);
+		else //Velocity Verlet step:
+		{	//--- velocity update: first half step
+			LatticeGradient vel = getVelocities();
+			axpy(0.5*idp.dt, accel+accelV, vel);
+			//--- position and position-dependent acceleration update:
+			lmin.step(vel, idp.dt);
+			accel = computePE();
+			//--- velocity update: second half step estimator
+			axpy(0.5*idp.dt, accel+accelV, vel); //note second-order error here due to first-order error in accelV
+			//--- velocity update: second half step corrector
+			LatticeGradient accelVnew = thermostat(vel);
+			axpy(0.5*idp.dt, accelVnew-accelV, vel); //corrects second-order error introduced in estimator step
+			accelV = thermostat(vel); //also sets velocities to iInfo and updates KE, pressure
+		}
 		
 		//Accumulate the averaged electronic density over the trajectory
-		if(nAccumNeeded and (not e.iInfo.ljOverride))
+		if(nAccumNeeded and (not e.iInfo.ljOverride) and (not usedSurrogate))
 			for(unsigned s=0; s<e.eVars.nAccum.size(); s++)
 			{	double fracNew = idp.dt/(t+idp.dt);
 				e.eVars.nAccum[s] += fracNew*(e.eVars.n[s] - e.eVars.nAccum[s]);
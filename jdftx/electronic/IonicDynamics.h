@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_ELECTRONIC_IONICDYNAMICS_H
 
 #include <electronic/LatticeMinimizer.h>
+#include <electronic/IonicSurrogate.h>
 #include <core/matrix3.h>
 
 //! @addtogroup IonicSystem
@@ -43,6 +44,10 @@ private:
 	matrix3<> stressTarget; //!< target stress tensor (for both types of barostats)
 	LatticeMinimizer lmin; //!< Helper class for changing atomic positions / lattice vectors (doesn't minimize anything)
 	bool nAccumNeeded; //!< Whether accumulated electron density is needed
+	std::shared_ptr<IonicSurrogate> surrogate; //!< on-the-fly fitted surrogate potential (if any)
+	int nSurrogateSteps; //!< number of consecutive steps using the surrogate
+	bool usedSurrogate; //!< whether the surrogate computed the current PE and forces
+	double sigmaF; //!< predicted force uncertainty of the surrogate at the current step
 	
 	//Current thermodynamic properties:
 	double KE; //!< current kinetic energy
@@ -57,9 +62,12 @@ private:
 	void setVelocities(const LatticeGradient&); //!< Set SpeciesInfo velocities from Cartesian-coordinate version
 	void computePressure(); //!< Update pressure and stress
 	void computeKE(); //!< Update kinetic energy and temperature
-	LatticeGradient computePE(); //!< Update potential energy and return acceleration (due to potential forces)
+	LatticeGradient computePE(); //!< Update potential energy and return acceleration (due to potential forces), from the surrogate if confident
+	LatticeGradient computeFastAccel(const LatticeGradient& dpos); //!< Acceleration due to pair potentials alone, at Cartesian displacement dpos from current positions
+	void langevinStep(LatticeGradient& vel, double dt); //!< Exact Ornstein-Uhlenbeck (Langevin friction and noise) update of velocities over time dt
 	LatticeGradient thermostat(const LatticeGradient& vel); //!< Return velocity-dependent acceleration due to thermostat (calls setVelocities, computeKE and computePressure)
 	bool report(int iter, double t); //!< Report properties at current step
+	void stepMultiple(LatticeGradient& accelSlow, LatticeGradient& accelFast, LatticeGradient& accelV); //!< one RESPA and/or BAOAB step (no barostat)
 };
 
 //! @}
@@ -30,7 +30,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 struct IonicDynamicsParams
 {	double dt; //!< time step [Eh^-1]
 	int nSteps; //!< number of steps
-	enum StatMethod { StatNone, Berendsen, NoseHoover } statMethod; //!< Method for thermo- and/or baro-stat
+	enum StatMethod { StatNone, Berendsen, NoseHoover, Langevin } statMethod; //!< Method for thermo- and/or baro-stat (Langevin: thermostat only)
 	double T0; //!< initial temperature or set point temperature if StatMethod != StatNone [Eh]
 	double P0; //!< pressure set point [Eh/a0^3] (NAN if not barostatting (hydrostatic))
 	matrix3<> stress0; //!< stress set point [Eh/a0^3] (NAN if not barostatting (anisotropic))
@@ -39,11 +39,17 @@ struct IonicDynamicsParams
 	int chainLengthT; //!< Nose-Hoover chain length for thermostat
 	int chainLengthP; //!< Nose-Hoover chain length for barostat
 	double B0; //!< characteristic bulk modulus for Berendsen barostat (default: water bulk modulus)
+	int nInnerSteps; //!< number of multiple-time-step substeps per step using only pair-potential forces (1 => single time step)
+	double surrogateThreshold; //!< force uncertainty per atom [Eh/a0] below which an on-the-fly fitted surrogate replaces DFT steps (0 => no surrogate)
+	double surrogateRcut; //!< cutoff radius of surrogate descriptors [a0]
+	int surrogateNradial; //!< number of radial basis functions per neighbor species in surrogate descriptors
+	int surrogateMaxSteps; //!< maximum number of consecutive surrogate steps before a DFT step
 	
 	IonicDynamicsParams() : dt(1.*fs), nSteps(0), statMethod(StatNone),
 		T0(298*Kelvin), P0(NAN), stress0(NAN,NAN,NAN),
 		tDampT(50.*fs), tDampP(100.*fs),
-		chainLengthT(3), chainLengthP(3), B0(2.2E9*Pascal) {}
+		chainLengthT(3), chainLengthP(3), B0(2.2E9*Pascal), nInnerSteps(1),
+		surrogateThreshold(0.), surrogateRcut(10.), surrogateNradial(8), surrogateMaxSteps(20) {}
 };
 
 //! @}
@@ -26,6 +26,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Dump.h>
 #include <core/Random.h>
 #include <core/BlasExtra.h>
+#include <core/matrix.h>
+#include <cstdio>
 
 const double IonicMinimizer::maxAtomTestDisplacement = 0.1; //in bohrs
 const double IonicMinimizer::maxWfnsDragDisplacement = 0.02; //in bohrs
@@ -162,7 +164,7 @@ IonicGradient operator*(const matrix3<>& mat, const IonicGradient& x)
 
 
 IonicMinimizer::IonicMinimizer(Everything& e, bool dynamicsMode)
-: e(e), populationAnalysisPending(false), skipWfnsDrag(false), dynamicsMode(dynamicsMode)
+: e(e), skipWfnsUpdate(false), populationAnalysisPending(false), skipWfnsDrag(false), dynamicsMode(dynamicsMode), rNNprecond(0.), forceMaxPrev(NAN)
 {	//Check if any atoms constrained:
 	anyConstrained = false;
 	for(const auto sp: e.iInfo.species)
@@ -190,6 +192,10 @@ void IonicMinimizer::step(const IonicGradient& dir, double alpha)
 	
 	IonicGradient dpos = alpha * e.gInfo.invR * dir; //dir is in cartesian, atpos in lattice
 	
+	//Extrapolate wavefunctions from previous steps instead of dragging, when possible:
+	bool extrapolate = alpha and (posHistory.size() >= 2) and (not iInfo.ljOverride) and (not skipWfnsUpdate);
+	IonicGradient posNew; if(extrapolate) posNew = getPositions() + dpos;
+	
 	if((e.cntrl.dragWavefunctions or populationAnalysisPending) and (not iInfo.ljOverride))
 	{	//Check if atomic orbitals available and compile list of displacements for each orbital:
 		std::vector< vector3<> > drColumns;
@@ -224,7 +230,7 @@ void IonicMinimizer::step(const IonicGradient& dir, double alpha)
 					Rho[eInfo.qnums[q].index()] += eInfo.qnums[q].weight * (lowdin * eVars.F[q] * dagger(lowdin)); //density matrix contribution
 				}
 				
-				if(alpha && e.cntrl.dragWavefunctions && (!skipWfnsDrag)) //needed only if actually dragging wavefunctions
+				if(alpha && e.cntrl.dragWavefunctions && (!skipWfnsDrag) && (!extrapolate) && (!skipWfnsUpdate)) //needed only if actually dragging wavefunctions
 				{	matrix coeff = inv(psiDagOpsi) * psiDagOC;  //LCAO coefficients for best fit (minimize C0^OC0 where C0 is the remainder)
 					eVars.C[q] -= psi * coeff; //now contains the residual C0 mentioned above
 				
@@ -269,6 +275,8 @@ void IonicMinimizer::step(const IonicGradient& dir, double alpha)
 		spInfo.sync_atpos();
 	}
 	
+	if(extrapolate) extrapolateWavefunctions(posNew);
+	
 	//Orthonormalize wavefunctions: (must do this after updating atom positions, since O depends on atpos for ultrasoft)
 	if(not iInfo.ljOverride)
 		for(int q=eInfo.qStart; q<eInfo.qStop; q++)
@@ -289,16 +297,34 @@ double IonicMinimizer::compute(IonicGradient* grad, IonicGradient* Kgrad)
 
 	//Minimize the electronic system:
 	if(not e.iInfo.ljOverride)
-		elecFluidMinimize(e);
+		elecFluidMinimizeAdaptive();
+	
+	//Remember converged wavefunctions for extrapolation:
+	if(e.cntrl.wfnsExtrapolation!=WfnsExtrapolationNone and (not e.iInfo.ljOverride))
+	{	size_t nHistMax = (e.cntrl.wfnsExtrapolation==WfnsExtrapolationLinear) ? 2 : 3;
+		Chistory.push_front(e.eVars.C);
+		posHistory.push_front(getPositions());
+		if(Chistory.size() > nHistMax)
+		{	Chistory.pop_back();
+			posHistory.pop_back();
+		}
+	}
 	
 	//Calculate forces if needed:
 	if(grad)
 	{	e.iInfo.ionicEnergyAndGrad(); //compute forces in lattice coordinates
 		*grad = -e.gInfo.invRT * e.iInfo.forces; //gradient in cartesian coordinates (and negative of force)
+		forceMaxPrev = 0.;
+		for(unsigned sp=0; sp<grad->size(); sp++)
+			for(unsigned atom=0; atom<grad->at(sp).size(); atom++)
+				if(e.iInfo.species[sp]->constraints[atom].moveScale)
+					forceMaxPrev = std::max(forceMaxPrev, grad->at(sp)[atom].length());
 		
 		//Preconditioned gradient:
 		if(Kgrad)
 		{	*Kgrad = *grad;
+			if(e.cntrl.ionicPreconditioner!=IonicPreconditionerNone and (not dynamicsMode))
+				applyPreconditioner(*Kgrad);
 			//Apply scale factors:
 			for(unsigned sp=0; sp<Kgrad->size(); sp++)
 			{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
@@ -315,6 +341,214 @@ double IonicMinimizer::compute(IonicGradient* grad, IonicGradient* Kgrad)
 	return relevantFreeEnergy(e);
 }
 
+void IonicMinimizer::elecFluidMinimizeAdaptive()
+{	const double forceFraction = e.cntrl.adaptiveElecForceFraction;
+	if(dynamicsMode || !forceFraction || std::isnan(forceMaxPrev))
+	{	elecFluidMinimize(e); //fixed thresholds in dynamics, when disabled, or before any forces are known
+		return;
+	}
+	//Energy error that keeps the force error within forceFraction of the largest force,
+	//estimating forceError ~ sqrt(energyError * 1 Eh/a0^2) from the quadratic error of variational energies:
+	double& threshold = e.cntrl.scf ? e.scfParams.energyDiffThreshold : e.elecMinParams.energyDiffThreshold;
+	const double thresholdTarget = threshold; //final accuracy (restored below)
+	if(thresholdTarget <= 0.) { elecFluidMinimize(e); return; } //no energy criterion to adapt
+	const double residualTarget = e.scfParams.residualThreshold;
+	double thresholdAdaptive = std::pow(forceFraction * forceMaxPrev, 2);
+	threshold = std::max(thresholdTarget, std::min(e.cntrl.adaptiveElecThresholdMax, thresholdAdaptive));
+	if(e.cntrl.scf) e.scfParams.residualThreshold = residualTarget * sqrt(threshold / thresholdTarget); //residual ~ sqrt(energy error)
+	if(threshold > thresholdTarget)
+		logPrintf("Adaptive electronic energy threshold %le (target %le) for max force %le and force error %le.\n",
+			threshold, thresholdTarget, forceMaxPrev, sqrt(threshold));
+	elecFluidMinimize(e);
+	threshold = thresholdTarget;
+	e.scfParams.residualThreshold = residualTarget;
+}
+
+IonicGradient IonicMinimizer::getPositions() const
+{	IonicGradient pos;
+	for(const auto& sp: e.iInfo.species)
+		pos.push_back(sp->atpos);
+	return pos;
+}
+
+void IonicMinimizer::extrapolateWavefunctions(const IonicGradient& posNew)
+{	static StopWatch watch("WavefunctionExtrapolate"); watch.start();
+	//Determine coefficients of each previous step:
+	std::vector<double> B;
+	if(dynamicsMode and Chistory.size()>=3 and e.cntrl.wfnsExtrapolation==WfnsExtrapolationQuadratic)
+		B = { 3., -3., 1. };
+	else if(dynamicsMode and Chistory.size()>=3 and e.cntrl.wfnsExtrapolation==WfnsExtrapolationASPC)
+		B = { 2.5, -2., 0.5 };
+	else
+	{	//Linear, scaled by the projection of the new displacement on the previous one (for unequal steps):
+		IonicGradient dpos = e.gInfo.R * (posNew - posHistory[0]);
+		IonicGradient dposPrev = e.gInfo.R * (posHistory[0] - posHistory[1]);
+		double dposPrevSq = dot(dposPrev, dposPrev);
+		double r = dposPrevSq ? std::max(0., std::min(1., dot(dpos, dposPrev) / dposPrevSq)) : 0.;
+		B = { 1.+r, -r };
+	}
+	//Combine wavefunctions, aligning each previous subspace to the latest one:
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+	{	const ColumnBundle& C0 = Chistory[0][q];
+		ColumnBundle& C = e.eVars.C[q];
+		C = C0 * B[0];
+		for(size_t j=1; j<B.size(); j++)
+		{	matrix M = Chistory[j][q] ^ C0;
+			matrix U = M * invsqrt(dagger(M) * M); //unitary rotation that best maps Chistory[j] onto C0
+			C += (Chistory[j][q] * U) * B[j];
+		}
+	}
+	watch.stop();
+}
+
+void IonicMinimizer::applyPreconditioner(IonicGradient& Kgrad)
+{	static StopWatch watch("IonicPreconditioner"); watch.start();
+	const GridInfo& gInfo = e.gInfo;
+	IonicGradient pos = getPositions();
+	//Rebuild model Hessian if atoms have moved enough since the last build:
+	bool rebuild = !Kprecond.size();
+	if(!rebuild)
+	{	IonicGradient dpos = gInfo.R * (pos - posPrecond);
+		for(const auto& spArr: dpos)
+			for(const vector3<>& d: spArr)
+				if(d.length() > 0.1*rNNprecond) rebuild = true;
+	}
+	std::vector<vector3<>> r; //Cartesian positions of all atoms
+	for(const auto& spArr: pos)
+		for(const vector3<>& x: spArr)
+			r.push_back(gInfo.R * x);
+	int nAtoms = r.size();
+	if(rebuild)
+	{	posPrecond = pos;
+		//Loop over pairs of atoms and periodic images within rMax:
+		auto pairLoop = [&](double rMax, std::function<void(int,int,double)> process)
+		{	vector3<int> nImages;
+			for(int k=0; k<3; k++)
+				nImages[k] = e.coulombParams.isTruncated()[k] ? 0 : int(ceil(rMax * gInfo.G.row(k).length() / (2*M_PI)));
+			vector3<int> iR;
+			for(iR[0]=-nImages[0]; iR[0]<=nImages[0]; iR[0]++)
+			for(iR[1]=-nImages[1]; iR[1]<=nImages[1]; iR[1]++)
+			for(iR[2]=-nImages[2]; iR[2]<=nImages[2]; iR[2]++)
+			{	vector3<> t = gInfo.R * iR;
+				for(int i=0; i<nAtoms; i++)
+					for(int j=0; j<nAtoms; j++)
+						if(i!=j) //images of the same atom move together and do not couple
+						{	double rij = (r[j] + t - r[i]).length();
+							if(rij < rMax) process(i, j, rij);
+						}
+			}
+		};
+		//Nearest-neighbour distance (searching up to a typical bond length first):
+		rNNprecond = DBL_MAX;
+		for(double rSearch=6.; rNNprecond==DBL_MAX and rSearch<1e3; rSearch*=2)
+			pairLoop(rSearch, [&](int i, int j, double rij) { rNNprecond = std::min(rNNprecond, rij); });
+		if(rNNprecond==DBL_MAX) rNNprecond = 1.; //single atom without images: any scale works
+		//Model Hessian, with a stabilizing diagonal shift:
+		const double cStab = 0.1;
+		double A = e.cntrl.ionicPrecondA;
+		std::vector<double> P(nAtoms*nAtoms, 0.);
+		pairLoop(e.cntrl.ionicPrecondRcut * rNNprecond, [&](int i, int j, double rij)
+		{	double Pij = exp(-A*(rij/rNNprecond - 1.));
+			P[i+nAtoms*j] -= Pij;
+			P[i+nAtoms*i] += Pij;
+		});
+		double diagSum = 0.;
+		for(int i=0; i<nAtoms; i++) diagSum += (P[i+nAtoms*i] += cStab);
+		double scale = nAtoms / diagSum; //normalize to unit mean diagonal
+		matrix Pmat(nAtoms, nAtoms);
+		complex* PmatData = Pmat.data();
+		for(int ij=0; ij<nAtoms*nAtoms; ij++) PmatData[ij] = scale * P[ij];
+		matrix Kmat = inv(Pmat);
+		const complex* KmatData = Kmat.data();
+		Kprecond.resize(nAtoms*nAtoms);
+		for(int ij=0; ij<nAtoms*nAtoms; ij++) Kprecond[ij] = KmatData[ij].real();
+		logPrintf("IonicMinimize: Rebuilt exponential preconditioner with nearest-neighbour distance %lg bohrs.\n", rNNprecond);
+	}
+	//Apply (identically to each Cartesian direction):
+	std::vector<vector3<>> g;
+	for(const auto& spArr: Kgrad)
+		g.insert(g.end(), spArr.begin(), spArr.end());
+	int i = 0;
+	for(auto& spArr: Kgrad)
+		for(vector3<>& Kg: spArr)
+		{	Kg = vector3<>();
+			for(int j=0; j<nAtoms; j++)
+				Kg += Kprecond[i+nAtoms*j] * g[j];
+			i++;
+		}
+	watch.stop();
+}
+
+bool IonicMinimizer::persistLBFGS() const
+{	return e.cntrl.ionicHistoryFile.length() and (not dynamicsMode);
+}
+
+void IonicMinimizer::saveLBFGS(const std::vector<IonicGradient>& s, const std::vector<IonicGradient>& Ky, const std::vector<double>& rho, double gamma) const
+{	if(!mpiWorld->isHead()) return;
+	//Write to a temporary file and rename, so that an interrupted write does not destroy the previous history:
+	string fname = e.cntrl.ionicHistoryFile, fnameTmp = fname + ".tmp";
+	FILE* fp = fopen(fnameTmp.c_str(), "wb");
+	if(!fp)
+	{	logPrintf("WARNING: could not open '%s' to save ionic L-BFGS history.\n", fnameTmp.c_str());
+		return;
+	}
+	int header[2] = { int(s.size()), int(e.iInfo.species.size()) };
+	fwriteLE(header, sizeof(int), 2, fp);
+	for(const auto& sp: e.iInfo.species)
+	{	int nAtomsSp = sp->atpos.size();
+		fwriteLE(&nAtomsSp, sizeof(int), 1, fp);
+	}
+	fwriteLE(&gamma, sizeof(double), 1, fp);
+	for(size_t j=0; j<s.size(); j++)
+	{	fwriteLE(&rho[j], sizeof(double), 1, fp);
+		for(const IonicGradient* x: { &s[j], &Ky[j] })
+			for(const auto& spArr: *x)
+				fwriteLE(spArr.data(), sizeof(double), 3*spArr.size(), fp);
+	}
+	fclose(fp);
+	if(rename(fnameTmp.c_str(), fname.c_str()))
+		logPrintf("WARNING: could not rename '%s' to '%s'.\n", fnameTmp.c_str(), fname.c_str());
+}
+
+bool IonicMinimizer::loadLBFGS(std::vector<IonicGradient>& s, std::vector<IonicGradient>& Ky, std::vector<double>& rho, double& gamma)
+{	if(!persistLBFGS()) return false;
+	const char* fname = e.cntrl.ionicHistoryFile.c_str();
+	FILE* fp = fopen(fname, "rb");
+	if(!fp) return false; //no history yet
+	//Check compatibility:
+	int header[2];
+	bool compatible = (freadLE(header, sizeof(int), 2, fp) == 2) and (header[0] >= 0) and (header[1] == int(e.iInfo.species.size()));
+	if(compatible)
+		for(const auto& sp: e.iInfo.species)
+		{	int nAtomsSp;
+			if(freadLE(&nAtomsSp, sizeof(int), 1, fp) != 1 or nAtomsSp != int(sp->atpos.size()))
+			{	compatible = false;
+				break;
+			}
+		}
+	compatible = compatible and (freadLE(&gamma, sizeof(double), 1, fp) == 1);
+	//Read entries:
+	IonicGradient x; x.init(e.iInfo);
+	for(int j=0; compatible and j<header[0]; j++)
+	{	double rhoj;
+		compatible = (freadLE(&rhoj, sizeof(double), 1, fp) == 1);
+		rho.push_back(rhoj);
+		for(std::vector<IonicGradient>* arr: { &s, &Ky })
+		{	for(auto& spArr: x)
+				if(compatible and freadLE(spArr.data(), sizeof(double), 3*spArr.size(), fp) != 3*spArr.size())
+					compatible = false;
+			arr->push_back(x);
+		}
+	}
+	fclose(fp);
+	if(!compatible)
+	{	logPrintf("WARNING: ignoring ionic L-BFGS history in '%s', which is incomplete or for different atoms.\n", fname);
+		s.clear(); Ky.clear(); rho.clear(); gamma = 0.;
+		return false;
+	}
+	return true;
+}
+
 bool IonicMinimizer::report(int iter)
 {	if(e.iInfo.computeStress)
 	{	logPrintf("\n# Stress tensor in Cartesian coordinates [Eh/a0^3]:\n");
@@ -23,6 +23,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/RadialFunction.h>
 #include <core/Minimize.h>
 #include <core/matrix3.h>
+#include <electronic/ColumnBundle.h>
+#include <deque>
 
 //! @addtogroup IonicSystem
 //! @{
@@ -69,11 +71,31 @@ public:
 	double sync(double x) const; //!< All processes minimize together; make sure scalars are in sync to round-off error
 	
 	double minimize(const MinimizeParams& params); //!< minor addition to Minimizable::minimize to invoke charge analysis at final positions
+	IonicGradient getPositions() const; //!< current atomic positions (lattice coordinates)
+	
+	//L-BFGS history persistence (see command ionic-history-file):
+	void saveLBFGS(const std::vector<IonicGradient>& s, const std::vector<IonicGradient>& Ky, const std::vector<double>& rho, double gamma) const;
+	bool loadLBFGS(std::vector<IonicGradient>& s, std::vector<IonicGradient>& Ky, std::vector<double>& rho, double& gamma);
+	bool persistLBFGS() const;
+	
+	bool skipWfnsUpdate; //!< if set, step() moves atoms without dragging or extrapolating wavefunctions (which are then set by the caller)
 private:
 	bool populationAnalysisPending; //!< report() has requested a charge analysis output that is yet to be done
 	bool skipWfnsDrag; //!< whether to temprarily skip wavefunction dragging due to large steps
 	bool anyConstrained; //!< whether any atoms are constrained
 	bool dynamicsMode; //!< class used as a helper for IonicDynamics (changes Kgrad to be acceleration in compute)
+	
+	std::deque<std::vector<ColumnBundle>> Chistory; //!< converged wavefunctions at previous ionic steps (most recent first) for wfnsExtrapolation
+	std::deque<IonicGradient> posHistory; //!< atomic positions (lattice coordinates) corresponding to Chistory
+	void extrapolateWavefunctions(const IonicGradient& posNew); //!< set wavefunctions for positions posNew from Chistory
+	
+	std::vector<double> Kprecond; //!< inverse of the model Hessian (nAtoms x nAtoms, column-major) for ionic-preconditioner
+	IonicGradient posPrecond; //!< atomic positions (lattice coordinates) at which Kprecond was built
+	double rNNprecond; //!< nearest-neighbour distance at which Kprecond was built
+	void applyPreconditioner(IonicGradient& Kgrad); //!< apply the model-Hessian preconditioner (rebuilding it if atoms moved enough)
+	
+	double forceMaxPrev; //!< largest force on a movable atom at the previous compute (NAN if not yet available)
+	void elecFluidMinimizeAdaptive(); //!< elecFluidMinimize with electronic thresholds set from forceMaxPrev (see ionic-adaptive-elec-threshold)
 };
 
 //! @}
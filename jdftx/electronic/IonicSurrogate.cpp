@@ -0,0 +1,171 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/IonicSurrogate.h>
+#include <electronic/Everything.h>
+
+IonicSurrogate::IonicSurrogate(const Everything& e)
+: e(e), nSpecies(e.iInfo.species.size()), nRadial(e.ionicDynParams.surrogateNradial),
+	rCut(e.ionicDynParams.surrogateRcut), yy(0.), nRows(0), nSteps(0), noiseVar(0.)
+{
+	for(int sp=0; sp<nSpecies; sp++)
+		atomSpecies.insert(atomSpecies.end(), e.iInfo.species[sp]->atpos.size(), sp);
+	nAtoms = atomSpecies.size();
+	nFeatures = nSpecies * (2*nSpecies*nRadial + 1);
+	A = zeroes(nFeatures, nFeatures);
+	b = zeroes(nFeatures, 1);
+	logPrintf("Initialized surrogate potential with %d features (cutoff %lg bohrs) to replace DFT steps"
+		" with predicted force uncertainty < %lg Eh/a0.\n", nFeatures, rCut, e.ionicDynParams.surrogateThreshold);
+}
+
+void IonicSurrogate::train(double E, const IonicGradient& forces)
+{	matrix phiE, phiF;
+	getFeatures(phiE, phiF);
+	//Weighted rows and targets (energy per atom, and force components):
+	int nRowsCur = 1 + 3*nAtoms;
+	matrix phi(nRowsCur, nFeatures), y(nRowsCur, 1);
+	phi.set(0,1, 0,nFeatures, (1./nAtoms) * phiE);
+	phi.set(1,nRowsCur, 0,nFeatures, phiF);
+	y.set(0,0, E/nAtoms);
+	int iRow = 1;
+	for(const std::vector<vector3<>>& forcesSp: forces)
+		for(const vector3<>& f: forcesSp)
+			for(int dir=0; dir<3; dir++)
+				y.set(iRow++,0, f[dir]);
+	//Accumulate normal equations:
+	A += dagger(phi) * phi;
+	b += dagger(phi) * y;
+	yy += trace(dagger(y) * y).real();
+	nRows += nRowsCur;
+	nSteps++;
+	
+	//Refit with a small ridge regularization (features are not independent):
+	matrix Areg = A;
+	double lambda = 1e-8 * trace(A).real() / nFeatures;
+	for(int f=0; f<nFeatures; f++) Areg.data()[Areg.index(f,f)] += lambda;
+	Ainv = inv(Areg);
+	w = Ainv * b;
+	double rss = yy - 2.*trace(dagger(w)*b).real() + trace(dagger(w)*A*w).real();
+	noiseVar = std::max(rss, 0.) / nRows;
+	logPrintf("IonicSurrogate: fit to %d DFT steps with rms residual %lg.\n", nSteps, sqrt(noiseVar));
+}
+
+bool IonicSurrogate::predict(double& E, IonicGradient& forces, double& sigmaF) const
+{	static const int nTrainMin = 3; //minimum number of DFT steps before using surrogate
+	sigmaF = NAN;
+	if(nSteps < nTrainMin) return false;
+	matrix phiE, phiF;
+	getFeatures(phiE, phiF);
+	//Force uncertainty from posterior covariance:
+	matrix phiFAinv = phiF * Ainv;
+	sigmaF = 0.;
+	for(int atom=0; atom<nAtoms; atom++)
+	{	double varF = 0.;
+		for(int iRow=3*atom; iRow<3*(atom+1); iRow++)
+			for(int f=0; f<nFeatures; f++)
+				varF += (phiFAinv(iRow,f) * phiF(iRow,f)).real();
+		sigmaF = std::max(sigmaF, sqrt(noiseVar * std::max(varF, 0.)));
+	}
+	if(sigmaF > e.ionicDynParams.surrogateThreshold) return false;
+	//Predictions:
+	E = trace(phiE * w).real();
+	matrix F = phiF * w;
+	forces.init(e.iInfo);
+	int iRow = 0;
+	for(std::vector<vector3<>>& forcesSp: forces)
+		for(vector3<>& f: forcesSp)
+			for(int dir=0; dir<3; dir++)
+				f[dir] = F(iRow++,0).real();
+	return true;
+}
+
+void IonicSurrogate::getFeatures(matrix& phiE, matrix& phiF) const
+{	const matrix3<>& R = e.gInfo.R;
+	//Cartesian positions:
+	std::vector<vector3<>> pos;
+	for(const auto& sp: e.iInfo.species)
+		for(const vector3<>& x: sp->atpos)
+			pos.push_back(R * x);
+	//Range of periodic images within cutoff:
+	vector3<int> nImages;
+	for(int dir=0; dir<3; dir++)
+		nImages[dir] = e.coulombParams.isTruncated()[dir] ? 0 : int(ceil(rCut * e.gInfo.invR.row(dir).length()));
+	//Radial basis:
+	const double dMu = rCut / nRadial, invWidthSq = 1./(dMu*dMu);
+	auto radialBasis = [&](double r, std::vector<double>& g, std::vector<double>& g_r)
+	{	double fc = 0.5*(1. + cos(M_PI*r/rCut)), fc_r = -0.5*(M_PI/rCut) * sin(M_PI*r/rCut);
+		for(int k=0; k<nRadial; k++)
+		{	double dr = r - (k+0.5)*dMu;
+			double gauss = exp(-0.5*invWidthSq*dr*dr);
+			g[k] = gauss * fc;
+			g_r[k] = gauss * (fc_r - invWidthSq*dr*fc);
+		}
+	};
+	//Collect neighbor pairs and densities of each atom (per neighbor species and radial function):
+	struct Pair { int i, j; vector3<> rHat; std::vector<double> g_r; };
+	std::vector<Pair> pairs;
+	std::vector<double> rho(nAtoms*nSpecies*nRadial, 0.), g(nRadial);
+	vector3<int> t;
+	for(int i=0; i<nAtoms; i++)
+		for(int j=0; j<nAtoms; j++)
+			for(t[0]=-nImages[0]; t[0]<=nImages[0]; t[0]++)
+			for(t[1]=-nImages[1]; t[1]<=nImages[1]; t[1]++)
+			for(t[2]=-nImages[2]; t[2]<=nImages[2]; t[2]++)
+			{	if(i==j and (not t.length_squared())) continue;
+				vector3<> dx = pos[j] - pos[i] + R*t;
+				double r = dx.length();
+				if(r >= rCut) continue;
+				Pair pair; pair.i = i; pair.j = j; pair.rHat = dx/r; pair.g_r.resize(nRadial);
+				radialBasis(r, g, pair.g_r);
+				double* rhoCur = rho.data() + (i*nSpecies + atomSpecies[j])*nRadial;
+				for(int k=0; k<nRadial; k++) rhoCur[k] += g[k];
+				pairs.push_back(pair);
+			}
+	//Energy features:
+	const int offsetSq = nSpecies*nSpecies*nRadial, offsetConst = 2*offsetSq;
+	phiE = zeroes(1, nFeatures);
+	complex* phiEdata = phiE.data();
+	for(int i=0; i<nAtoms; i++)
+	{	int iFeature = atomSpecies[i]*nSpecies*nRadial; //start of features for center species
+		const double* rhoCur = rho.data() + i*nSpecies*nRadial;
+		for(int bk=0; bk<nSpecies*nRadial; bk++)
+		{	phiEdata[iFeature+bk] += rhoCur[bk];
+			phiEdata[offsetSq+iFeature+bk] += rhoCur[bk]*rhoCur[bk];
+		}
+		phiEdata[offsetConst+atomSpecies[i]] += 1.;
+	}
+	//Force features (negative derivatives of energy features):
+	phiF = zeroes(3*nAtoms, nFeatures);
+	complex* phiFdata = phiF.data();
+	for(const Pair& pair: pairs)
+	{	int bOffset = atomSpecies[pair.j]*nRadial;
+		int iFeature = atomSpecies[pair.i]*nSpecies*nRadial + bOffset;
+		const double* rhoCur = rho.data() + pair.i*nSpecies*nRadial + bOffset;
+		for(int k=0; k<nRadial; k++)
+			for(int dir=0; dir<3; dir++)
+			{	double rho_xj = pair.g_r[k] * pair.rHat[dir]; //derivative w.r.t position of j (and negative of that w.r.t i)
+				for(int iTerm=0; iTerm<2; iTerm++)
+				{	int f = iFeature+k + iTerm*offsetSq;
+					double phi_xj = iTerm ? 2.*rhoCur[k]*rho_xj : rho_xj;
+					phiFdata[phiF.index(3*pair.j+dir, f)] -= phi_xj;
+					phiFdata[phiF.index(3*pair.i+dir, f)] += phi_xj;
+				}
+			}
+	}
+}
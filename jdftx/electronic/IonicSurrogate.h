@@ -0,0 +1,79 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_IONICSURROGATE_H
+#define JDFTX_ELECTRONIC_IONICSURROGATE_H
+
+#include <electronic/IonicMinimizer.h>
+#include <core/matrix.h>
+
+//! @addtogroup IonicSystem
+//! @{
+
+/** @file IonicSurrogate.h
+@brief On-the-fly fitted surrogate potential for ionic dynamics (see ionic-dynamics key surrogateThreshold)
+
+The energy is a linear model in local descriptors of each atom: for each neighbor species,
+the densities rho_k = sum_j g_k(r_ij) of smooth-cutoff gaussian radial basis functions g_k
+within surrogateRcut, their squares (which provide embedded-atom-like many-body terms),
+and a per-species constant. The weights are fit by Bayesian linear regression to the DFT
+energies and forces of all steps computed so far, whose posterior covariance provides
+an uncertainty estimate of the predicted forces.
+*/
+
+//! Bayesian linear-regression surrogate for DFT energies and forces in IonicDynamics
+class IonicSurrogate
+{
+public:
+	IonicSurrogate(const Everything& e);
+	
+	//! Add the DFT energy and Cartesian forces at the current atomic positions to the training set and refit
+	void train(double E, const IonicGradient& forces);
+	
+	//! Predict the energy and Cartesian forces at the current atomic positions,
+	//! along with the largest force uncertainty on any atom (sigmaF).
+	//! Returns false if the model is not trained enough, or sigmaF exceeds the threshold.
+	bool predict(double& E, IonicGradient& forces, double& sigmaF) const;
+	
+	int nTrain() const { return nSteps; } //!< number of DFT steps in the training set
+
+private:
+	const Everything& e;
+	int nSpecies, nAtoms, nRadial, nFeatures;
+	double rCut;
+	std::vector<int> atomSpecies; //!< species index of each atom (in IonInfo order)
+	
+	//Training set, accumulated as normal equations:
+	matrix A; //!< sum of outer products of weighted feature rows
+	matrix b; //!< sum of feature rows times weighted targets
+	double yy; //!< sum of squared weighted targets
+	int nRows; //!< number of fitted data (energies and force components)
+	int nSteps; //!< number of DFT steps fitted
+	
+	//Current fit:
+	matrix w; //!< feature weights
+	matrix Ainv; //!< inverse of regularized A (posterior covariance up to noiseVar)
+	double noiseVar; //!< residual variance of the fit
+	
+	//! Compute features of the energy (phiE, 1 x nFeatures) and forces (phiF, 3nAtoms x nFeatures) at current positions
+	void getFeatures(matrix& phiE, matrix& phiF) const;
+};
+
+//! @}
+#endif //JDFTX_ELECTRONIC_IONICSURROGATE_H
@@ -0,0 +1,225 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/IpiDriver.h>
+#include <electronic/Everything.h>
+#include <electronic/LatticeMinimizer.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <unistd.h>
+
+IpiDriver::IpiDriver() : port(0)
+{
+}
+
+//Socket I/O on the head process, with i-PI's fixed-length message headers:
+class IpiSocket
+{	int fd;
+public:
+	static const int headerLength = 12;
+
+	IpiSocket(const string& address, int port)
+	{	if(port)
+		{	//TCP socket:
+			addrinfo hints, *res;
+			memset(&hints, 0, sizeof(hints));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			if(getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &res))
+				die("ipi-driver: could not resolve host '%s'.\n", address.c_str());
+			fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+			if(fd<0 or connect(fd, res->ai_addr, res->ai_addrlen))
+				die("ipi-driver: could not connect to %s:%d.\n", address.c_str(), port);
+			freeaddrinfo(res);
+		}
+		else
+		{	//UNIX socket (with the path convention of i-PI and ASE):
+			sockaddr_un addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			string path = "/tmp/ipi_" + address;
+			if(path.length() >= sizeof(addr.sun_path))
+				die("ipi-driver: UNIX socket path '%s' is too long.\n", path.c_str());
+			strcpy(addr.sun_path, path.c_str());
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if(fd<0 or connect(fd, (sockaddr*)&addr, sizeof(addr)))
+				die("ipi-driver: could not connect to UNIX socket '%s'.\n", path.c_str());
+		}
+	}
+	~IpiSocket() { close(fd); }
+
+	void read(void* data, size_t nBytes)
+	{	char* ptr = (char*)data;
+		while(nBytes)
+		{	ssize_t n = ::read(fd, ptr, nBytes);
+			if(n <= 0) die("ipi-driver: connection to server lost.\n");
+			ptr += n; nBytes -= n;
+		}
+	}
+	void write(const void* data, size_t nBytes)
+	{	const char* ptr = (const char*)data;
+		while(nBytes)
+		{	ssize_t n = ::write(fd, ptr, nBytes);
+			if(n <= 0) die("ipi-driver: connection to server lost.\n");
+			ptr += n; nBytes -= n;
+		}
+	}
+	template<typename T> T read() { T t; read(&t, sizeof(T)); return t; }
+	template<typename T> void write(const T& t) { write(&t, sizeof(T)); }
+
+	string readHeader()
+	{	char buf[headerLength+1];
+		read(buf, headerLength); buf[headerLength] = 0;
+		string header(buf);
+		return header.substr(0, header.find_last_not_of(' ')+1);
+	}
+	void writeHeader(const char* header)
+	{	char buf[headerLength+1];
+		snprintf(buf, headerLength+1, "%-12s", header);
+		write(buf, headerLength);
+	}
+};
+
+enum IpiMessage { IpiStatus, IpiInit, IpiPosData, IpiGetForce, IpiExit };
+
+void IpiDriver::run(Everything& e)
+{	IonInfo& iInfo = e.iInfo;
+	int nAtoms = 0;
+	for(const auto& sp: iInfo.species)
+		nAtoms += sp->atpos.size();
+	
+	std::shared_ptr<IpiSocket> sock;
+	if(mpiWorld->isHead())
+	{	logPrintf("\n--------- i-PI driver: connecting to %s", address.c_str());
+		if(port) logPrintf(":%d", port); else logPrintf(" (UNIX socket)");
+		logPrintf(" ---------\n"); logFlush();
+		sock = std::make_shared<IpiSocket>(address, port);
+	}
+	
+	LatticeMinimizer lmin(e, true, false, true); //dynamics mode with a variable lattice: drags wavefunctions with ions and lattice
+	bool initialized = false, haveData = false;
+	double energy = 0.;
+	std::vector<double> forceBuf(3*nAtoms);
+	matrix3<> virial;
+	int iStep = 0;
+	while(true)
+	{	//Receive next message on head and share with others:
+		int msg = IpiExit;
+		if(sock)
+		{	string header = sock->readHeader();
+			if(header == "STATUS") msg = IpiStatus;
+			else if(header == "INIT") msg = IpiInit;
+			else if(header == "POSDATA") msg = IpiPosData;
+			else if(header == "GETFORCE") msg = IpiGetForce;
+			else if(header == "EXIT") msg = IpiExit;
+			else die("ipi-driver: unexpected message '%s' from server.\n", header.c_str());
+		}
+		mpiWorld->bcast(msg);
+		
+		switch(msg)
+		{	case IpiStatus:
+			{	if(sock) sock->writeHeader(haveData ? "HAVEDATA" : (initialized ? "READY" : "NEEDINIT"));
+				break;
+			}
+			case IpiInit:
+			{	if(sock)
+				{	sock->read<int32_t>(); //bead index (unused)
+					int32_t len = sock->read<int32_t>();
+					string initString(len, ' ');
+					sock->read(&initString[0], len); //initialization string (unused)
+				}
+				initialized = true;
+				break;
+			}
+			case IpiPosData:
+			{	//Receive lattice vectors and cartesian positions:
+				matrix3<> Rnew;
+				std::vector<double> posBuf(3*nAtoms);
+				if(sock)
+				{	double buf[9];
+					sock->read(buf, sizeof(buf));
+					for(int i=0; i<3; i++)
+						for(int j=0; j<3; j++)
+							Rnew(i,j) = buf[3*i+j];
+					sock->read(buf, sizeof(buf)); //inverse lattice vectors (unused)
+					int32_t nAtomsIn = sock->read<int32_t>();
+					if(nAtomsIn != nAtoms)
+						die("ipi-driver: server sent %d atoms, but the calculation has %d.\n", nAtomsIn, nAtoms);
+					sock->read(posBuf.data(), sizeof(double)*posBuf.size());
+				}
+				mpiWorld->bcast(&Rnew(0,0), 9);
+				mpiWorld->bcastData(posBuf);
+				
+				//Step from the current configuration (lattice strain, and cartesian displacements at the current lattice):
+				const matrix3<> id(1,1,1);
+				LatticeGradient dir; dir.init(iInfo);
+				dir.lattice = Rnew * inv(e.gInfo.R) - id;
+				matrix3<> invRnew = inv(Rnew);
+				vector3<bool> isTruncated = e.coulombParams.isTruncated();
+				const double* pos = posBuf.data();
+				for(unsigned sp=0; sp<iInfo.species.size(); sp++)
+					for(unsigned atom=0; atom<iInfo.species[sp]->atpos.size(); atom++)
+					{	vector3<> dx = invRnew * vector3<>(pos[0], pos[1], pos[2]) - iInfo.species[sp]->atpos[atom];
+						for(int k=0; k<3; k++)
+							if(not isTruncated[k]) dx[k] -= floor(0.5 + dx[k]); //nearest periodic image
+						dir.ionic[sp][atom] = e.gInfo.R * dx;
+						pos += 3;
+					}
+				lmin.step(dir, 1.);
+				
+				//Converge and collect results:
+				LatticeGradient grad; grad.init(iInfo);
+				energy = lmin.compute(&grad, 0);
+				if(std::isnan(energy))
+					die("ipi-driver: could not evaluate the configuration received at step %d.\n", iStep);
+				double* force = forceBuf.data();
+				for(const std::vector<vector3<>>& spGrad: grad.ionic)
+					for(const vector3<>& g: spGrad)
+					{	for(int k=0; k<3; k++) force[k] = -g[k];
+						force += 3;
+					}
+				virial = (-e.gInfo.detR) * iInfo.stress;
+				lmin.report(iStep++);
+				haveData = true;
+				break;
+			}
+			case IpiGetForce:
+			{	if(sock)
+				{	sock->writeHeader("FORCEREADY");
+					sock->write<double>(energy);
+					sock->write<int32_t>(nAtoms);
+					sock->write(forceBuf.data(), sizeof(double)*forceBuf.size());
+					double buf[9];
+					for(int i=0; i<3; i++)
+						for(int j=0; j<3; j++)
+							buf[3*i+j] = virial(i,j);
+					sock->write(buf, sizeof(buf));
+					sock->write<int32_t>(0); //no extra data
+				}
+				haveData = false;
+				break;
+			}
+			case IpiExit:
+			{	logPrintf("\ni-PI driver: server requested exit after %d configurations.\n", iStep);
+				return;
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_IPIDRIVER_H
+#define JDFTX_ELECTRONIC_IPIDRIVER_H
+
+#include <core/string.h>
+
+class Everything;
+
+//! @addtogroup IonicSystem
+//! @{
+
+/** @file IpiDriver.h
+@brief Persistent force evaluations driven over a socket (command ipi-driver)
+
+JDFTx connects as a client to an i-PI compatible server (i-PI itself, or ASE's SocketIOCalculator),
+which sends lattice vectors and atomic positions and requests energy, forces and virial at each step.
+The calculation stays set up between steps, so that each configuration starts from the
+converged wavefunctions of the previous one (dragged to the new positions), as in ionic dynamics.
+*/
+
+//! i-PI socket client evaluating energy, forces and stress for successive configurations
+class IpiDriver
+{
+public:
+	string address; //!< host name for TCP sockets, or name of the UNIX socket /tmp/ipi_<address>
+	int port; //!< TCP port (0 => use a UNIX socket)
+	
+	IpiDriver();
+	void run(Everything& e); //!< connect and serve configurations till the server sends EXIT (call after setup)
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_IPIDRIVER_H
@@ -130,7 +130,7 @@ LatticeMinimizer::LatticeMinimizer(Everything& e, bool dynamicsMode, bool statP,
 }
 
 void LatticeMinimizer::step(const LatticeGradient& dir, double alpha)
-{	if(dynamicsMode and (not (statP or statStress)))
+{	if(dynamicsMode and ((not (statP or statStress)) or (not nrm2(alpha*dir.lattice))))
 	{	imin.step(dir.ionic, alpha); //since lattice constant, bypass more expensive processing below
 		return;
 	}
@@ -140,13 +140,19 @@ void LatticeMinimizer::step(const LatticeGradient& dir, double alpha)
 	if(nrm2(strain+alpha*dir.lattice) > GridInfo::maxAllowedStrain) //strain will become large
 		skipWfnsDrag = true; //skip wavefunction drag till a 'real' compute occurs at an acceptable strain
 	
+	//Predict wavefunctions from previous lattices instead of dragging, when possible:
+	bool predict = e.cntrl.strainPredictor and alpha and (Chistory.size() >= 2) and (not e.iInfo.ljOverride);
+	
 	//Update atomic positions first (with associated wavefunction drag, if any):
+	imin.skipWfnsUpdate = predict;
 	imin.step(dir.ionic, alpha);
+	imin.skipWfnsUpdate = false;
 	
 	//Project wavefunctions to atomic orbitals:
 	std::vector<matrix> coeff(e.eInfo.nStates); //best fit coefficients
 	int nAtomic = e.iInfo.nAtomicOrbitals();
-	if(e.cntrl.dragWavefunctions and nAtomic and (not skipWfnsDrag) and (not e.iInfo.ljOverride))
+	bool drag = e.cntrl.dragWavefunctions and nAtomic and (not skipWfnsDrag) and (not predict);
+	if(drag and (not e.iInfo.ljOverride))
 		for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
 		{	//Get atomic orbitals for old lattice:
 			ColumnBundle psi = e.iInfo.getAtomicOrbitals(q, false);
@@ -165,11 +171,12 @@ void LatticeMinimizer::step(const LatticeGradient& dir, double alpha)
 	bcast(e.gInfo.R); //ensure consistency to numerical precision
 	bcast(strain); //ensure consistency to numerical precision
 	updateLatticeDependent(e); // Updates lattice information
+	if(predict) predictWavefunctions();
 
 	if(not e.iInfo.ljOverride)
 		for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
 		{	//Restore wavefunctions from atomic orbitals:
-			if(e.cntrl.dragWavefunctions and nAtomic and (not skipWfnsDrag))
+			if(drag)
 			{	//Get atomic orbitals for new lattice:
 				ColumnBundle psi = e.iInfo.getAtomicOrbitals(q, false);
 				//Reconstitute wavefunctions:
@@ -197,6 +204,18 @@ double LatticeMinimizer::compute(LatticeGradient* grad, LatticeGradient* Kgrad)
 	//! Compute energy (and ionic gradients, stress if needed)
 	imin.compute(grad ? &grad->ionic : 0, Kgrad ? &Kgrad->ionic : 0);
 	
+	//Remember converged wavefunctions for the strain predictor:
+	if(e.cntrl.strainPredictor and (not e.iInfo.ljOverride))
+	{	Chistory.push_front(e.eVars.C);
+		strainHistory.push_front(strain);
+		posHistory.push_front(imin.getPositions());
+		if(Chistory.size() > 2)
+		{	Chistory.pop_back();
+			strainHistory.pop_back();
+			posHistory.pop_back();
+		}
+	}
+	
 	//! Calculate lattice gradients (from stress computed along with forces above) if necessary:
 	if(grad and (not dynamicsMode)) //stress handled directly by IonicDynamics
 	{	//Calculate grad->lattice (in Eh units):
@@ -212,6 +231,30 @@ double LatticeMinimizer::compute(LatticeGradient* grad, LatticeGradient* Kgrad)
 	return relevantFreeEnergy(e);
 }
 
+void LatticeMinimizer::predictWavefunctions()
+{	static StopWatch watch("WavefunctionStrainPredict"); watch.start();
+	//Linear extrapolation, scaled by the projection of the new step on the previous one in the combined
+	//coordinates of strain (times the mean lattice-vector length) and Cartesian atomic positions:
+	double L = std::pow(fabs(det(Rorig)), 1./3);
+	IonicGradient pos = imin.getPositions();
+	matrix3<> dStrain = strain - strainHistory[0], dStrainPrev = strainHistory[0] - strainHistory[1];
+	IonicGradient dpos = Rorig * (pos - posHistory[0]), dposPrev = Rorig * (posHistory[0] - posHistory[1]);
+	double dxDotPrev = L*L*dot(dStrain, dStrainPrev) + dot(dpos, dposPrev);
+	double dxPrevSq = L*L*dot(dStrainPrev, dStrainPrev) + dot(dposPrev, dposPrev);
+	double r = dxPrevSq ? std::max(0., std::min(1., dxDotPrev / dxPrevSq)) : 0.;
+	//Combine wavefunctions (coefficients on the fixed reciprocal lattice basis, i.e. rescaled with the lattice),
+	//aligning the previous subspace to the latest one:
+	for(int q=e.eInfo.qStart; q<e.eInfo.qStop; q++)
+	{	const ColumnBundle& C0 = Chistory[0][q];
+		const ColumnBundle& C1 = Chistory[1][q];
+		matrix M = C1 ^ C0;
+		matrix U = M * invsqrt(dagger(M) * M); //unitary rotation that best maps C1 onto C0
+		e.eVars.C[q] = C0 * (1.+r);
+		e.eVars.C[q] -= (C1 * U) * r;
+	}
+	watch.stop();
+}
+
 double LatticeMinimizer::minimize(const MinimizeParams& params)
 {	double result = Minimizable<LatticeGradient>::minimize(params);
 	LatticeGradient dir; dir.ionic = e.iInfo.forces; //just needs to be right size; values irrelevant since used with step size 0
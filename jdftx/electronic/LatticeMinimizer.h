@@ -75,6 +75,11 @@ private:
 	matrix3<> Pfree; //!< projection operator onto free directions (accounting for lattMoveScale and truncation)
 	double latticeK; //!< preconditioning factor for lattice degrees of freedom
 	
+	std::deque<std::vector<ColumnBundle>> Chistory; //!< converged wavefunctions at previous lattice steps (most recent first) for the strain predictor
+	std::deque<matrix3<>> strainHistory; //!< strain corresponding to Chistory
+	std::deque<IonicGradient> posHistory; //!< atomic positions (lattice coordinates) corresponding to Chistory
+	void predictWavefunctions(); //!< set wavefunctions at the current strain and positions by extrapolation from Chistory
+	
 	//! Updates lattice dependent quantities, but does not reconverge ionic positions or wavefunctions
 	static void updateLatticeDependent(Everything& e);
 };
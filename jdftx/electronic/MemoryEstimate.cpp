@@ -0,0 +1,159 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/MemoryEstimate.h>
+#include <electronic/Everything.h>
+#include <electronic/SpeciesInfo.h>
+#include <unistd.h>
+
+static const double bytesToMB = 1./pow(1024.,2);
+
+double MemoryEstimate::Component::bytes(int nStatesMine) const
+{	double result = shared + perState * nStatesMine;
+	return cap ? std::min(result, cap) : result;
+}
+
+void MemoryEstimate::add(const char* name, double perState, double shared, double cap)
+{	Component c;
+	c.name = name;
+	c.perState = perState;
+	c.shared = shared;
+	c.cap = cap;
+	components.push_back(c);
+}
+
+MemoryEstimate::MemoryEstimate(const Everything& e) : e(e)
+{	const ElecInfo& eInfo = e.eInfo;
+	const Control& cntrl = e.cntrl;
+	int nBands = eInfo.nBands;
+	int nSpinor = eInfo.spinorLength();
+
+	//Average and maximum wavefunction column sizes (over all states, for extrapolation to other layouts):
+	double nbasisAvg = 0.; size_t nbasisMax = 0;
+	for(int q=0; q<eInfo.nStates; q++)
+	{	nbasisAvg += e.basis[q].nbasis;
+		nbasisMax = std::max(nbasisMax, e.basis[q].nbasis);
+	}
+	nbasisAvg /= eInfo.nStates;
+	double colBytes = nbasisAvg * nSpinor * sizeof(complex);
+	double colBytesMax = nbasisMax * nSpinor * sizeof(complex);
+
+	//Wavefunctions and minimizer state:
+	if(cntrl.bandStreaming) add("Wavefunctions (band-streaming)", 0., nBands*colBytesMax); //one state at a time
+	else if(ManagedMemoryBase::evictionTier == ManagedMemoryBase::TierDisk)
+		add("Wavefunctions (evicted to disk)", 0., std::max(1, cntrl.kpointBatchSize)*nBands*colBytesMax); //states in use
+	else add("Wavefunctions", nBands*colBytes, 0.);
+	if(cntrl.scf || cntrl.fixed_H)
+	{	//Eigensolver working set for one batch of states at a time:
+		int nStatesBatch = std::max(1, cntrl.kpointBatchSize);
+		double nCols = 0.;
+		switch(cntrl.elecEigenAlgo)
+		{	case ElecEigenDavidson: nCols = 6 * ceil(cntrl.davidsonBandRatio * nBands); break; //C, HC, OC and their expansions
+			case ElecEigenLOBPCG: nCols = 9 * nBands; break; //X, R, P and their H, O products
+			case ElecEigenChebyshev: nCols = 4 * nBands; break; //filter recursion
+			case ElecEigenCG: nCols = 5 * nBands; break; //gradient, preconditioned gradient, direction, HC, OC
+		}
+		add("Eigensolver working set", 0., nStatesBatch * nCols * colBytesMax);
+	}
+	else if(ManagedMemoryBase::evictionTier == ManagedMemoryBase::TierDisk)
+		add("Minimizer (gradient, direction)", 0., 5*nBands*colBytesMax); //evicted to disk: current state's vectors and HC temporaries
+	else add("Minimizer (gradient, direction)", 3*nBands*colBytes, 2*nBands*colBytesMax); //per-state minimizer vectors and HC temporaries
+
+	//Cached projectors:
+	if(cntrl.cacheProjectors)
+	{	int nProj = 0;
+		for(const auto& sp: e.iInfo.species)
+			nProj += sp->nProjectors() / nSpinor;
+		if(cntrl.bandStreaming) add("Projector cache", 0., nProj * nbasisMax * sizeof(complex)); //released after each state
+		else add("Projector cache", nProj * nbasisAvg * sizeof(complex), 0., cntrl.projectorCacheMB/bytesToMB);
+	}
+
+	//Exact exchange:
+	if(e.exCorr.exxFactor())
+	{	int nACEcopies = cntrl.aceUpdateThreshold ? 2 : 1; //projectors, and the wavefunctions they were built from for incremental updates
+		add("Exact exchange (ACE)", nACEcopies*nBands*colBytes, 2*cntrl.exxBlockSize*colBytesMax);
+	}
+
+	//Grid quantities:
+	double fieldBytes = e.gInfo.nr * sizeof(double);
+	int nDensities = eInfo.nDensities;
+	int nFields = 4*nDensities + 4; //n, Vscloc, Vxc, VFilling per density; and d_vac, d_fluid, nCore, Vlocps
+	if(e.exCorr.needsKEdensity()) nFields += 3*nDensities; //tau, Vtau and its scloc version
+	add("Densities and potentials", 0., nFields * fieldBytes);
+	if(cntrl.scf)
+		add("SCF mixing history", 0., 2 * e.scfParams.history * nDensities * fieldBytes * (e.exCorr.needsKEdensity() ? 2 : 1));
+	int nFluidFields = 0;
+	switch(e.eVars.fluidParams.fluidType)
+	{	case FluidNone: break;
+		case FluidLinearPCM: nFluidFields = 12; break;
+		case FluidNonlinearPCM: nFluidFields = 24; break;
+		case FluidSaLSA: nFluidFields = 40; break;
+		case FluidClassicalDFT: nFluidFields = 60; break;
+	}
+	if(nFluidFields) add("Fluid", 0., nFluidFields * fieldBytes);
+
+	//FFT work buffers (per thread, batched input and output):
+	const GridInfo& gInfoWfns = *(e.basis[0].gInfo);
+	int fftBatch = std::max(1, gInfoWfns.fftBatchSize);
+	add("FFT work buffers", 0., nProcsAvailable * fftBatch * 2. * gInfoWfns.nr * sizeof(complex) * nSpinor);
+}
+
+double MemoryEstimate::bytesPerProcess(int nStatesMine) const
+{	double result = 0.;
+	for(const Component& c: components)
+		result += c.bytes(nStatesMine);
+	return result;
+}
+
+void MemoryEstimate::print() const
+{	const ElecInfo& eInfo = e.eInfo;
+	int nStatesMine = eInfo.qStop - eInfo.qStart;
+	logPrintf("\n---------- Memory estimate (per process, approximate) ----------\n");
+	logPrintf("%-32s %12s %12s\n", "Component", "Current[MB]", "1 proc[MB]");
+	for(const Component& c: components)
+		logPrintf("%-32s %12.1lf %12.1lf\n", c.name, c.bytes(nStatesMine)*bytesToMB, c.bytes(eInfo.nStates)*bytesToMB);
+	logPrintf("%-32s %12.1lf %12.1lf\n", "Total", bytesPerProcess(nStatesMine)*bytesToMB, bytesPerProcess(eInfo.nStates)*bytesToMB);
+	logPrintf("(Current: %d of %d states on this process with %d processes.)\n", nStatesMine, eInfo.nStates, mpiWorld->nProcesses());
+
+	//Recommend layouts for nodes like the current one:
+	double nodeBytes = double(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+	int nodeCores = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	const double usableFraction = 0.9; //leave room for MPI buffers, system and non-managed allocations
+	logPrintf("\nLayouts for nodes with %.1lf GB and %d cores (as on this node), using up to %.0lf%% of memory:\n",
+		nodeBytes*bytesToMB/1024., nodeCores, usableFraction*100);
+	logPrintf("%10s %14s %14s %10s %16s\n", "nProcs", "States/proc", "MB/proc", "nNodes", "procs x threads");
+	for(int nProcs=1; nProcs<=eInfo.nStates; nProcs++)
+	{	if(eInfo.nStates % nProcs) continue; //only layouts that divide states evenly
+		int nStatesProc = eInfo.nStates / nProcs;
+		double bytes = bytesPerProcess(nStatesProc);
+		int procsPerNode = std::min(nodeCores, int(floor(usableFraction*nodeBytes / bytes)));
+		if(procsPerNode < 1)
+		{	logPrintf("%10d %14d %14.1lf %10s %16s\n", nProcs, nStatesProc, bytes*bytesToMB, "-", "exceeds node");
+			continue;
+		}
+		procsPerNode = std::min(procsPerNode, nProcs);
+		int nNodes = (nProcs + procsPerNode - 1) / procsPerNode;
+		procsPerNode = (nProcs + nNodes - 1) / nNodes; //balance over the nodes
+		int nThreads = std::max(1, nodeCores / procsPerNode);
+		logPrintf("%10d %14d %14.1lf %10d %8d x %-6d\n", nProcs, nStatesProc, bytes*bytesToMB, nNodes, procsPerNode, nThreads);
+	}
+	logPrintf("(States are distributed over processes, so more than %d processes do not reduce memory per process;\n"
+		" use threads (-c) to occupy the remaining cores instead.)\n", eInfo.nStates);
+	logFlush();
+}
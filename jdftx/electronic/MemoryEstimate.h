@@ -0,0 +1,63 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_MEMORYESTIMATE_H
+#define JDFTX_ELECTRONIC_MEMORYESTIMATE_H
+
+//! @addtogroup Output
+//! @{
+
+/** @file MemoryEstimate.h
+@brief Estimate of peak memory per process, available after setup (including dry runs)
+
+Each component is split into a part that scales with the number of states on a process
+(wavefunctions, projector caches, ACE projectors) and a part that every process holds
+(grids, mixing history, fluid, FFT buffers and the one-state eigensolver working set),
+so that the estimate can be extrapolated to other process counts to recommend layouts.
+*/
+
+#include <core/Util.h>
+#include <vector>
+
+class Everything;
+
+//! Estimated peak memory of the subsequent calculation, by component
+class MemoryEstimate
+{
+public:
+	MemoryEstimate(const Everything& e);
+	double bytesPerProcess(int nStatesMine) const; //!< estimated peak bytes of a process handling nStatesMine states
+	void print() const; //!< log the breakdown for the current layout and recommended process x thread layouts
+
+private:
+	const Everything& e;
+	//! One contribution to the estimate
+	struct Component
+	{	const char* name;
+		double perState; //!< bytes per state handled by the process
+		double shared; //!< bytes independent of the number of states on the process
+		double cap; //!< limit on total bytes of this component (0 => none)
+		double bytes(int nStatesMine) const; //!< bytes for given number of states on the process
+	};
+	std::vector<Component> components;
+	void add(const char* name, double perState, double shared, double cap=0.);
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_MEMORYESTIMATE_H
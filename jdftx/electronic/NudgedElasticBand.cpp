@@ -0,0 +1,355 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/NudgedElasticBand.h>
+#include <electronic/Everything.h>
+#include <electronic/Dump.h>
+#include <commands/parser.h>
+#include <algorithm>
+
+NudgedElasticBand::NudgedElasticBand(const Everything& e, const std::vector<std::pair<string,string>>& commands, bool printDefaults)
+: nebp(e.nebParams), commands(commands), printDefaults(printDefaults), nImages(e.nebParams.nImages+2),
+	mpiNEB(mpiWorld), logNEB(globalLog), basenameNEB(inputBasename)
+{
+	logPrintf("\n---------- Setting up nudged elastic band ----------\n");
+	if(e.symm.mode != SymmetriesNone)
+		die("Nudged elastic band requires symmetries to be turned off (symmetries none),\n"
+			"since the images along the path generally have lower symmetry than the end points.\n\n");
+	R = e.gInfo.R;
+	
+	//Initial state positions:
+	pos.resize(nImages);
+	const IonInfo& iInfo = e.iInfo;
+	pos[0].init(iInfo);
+	for(size_t sp=0; sp<iInfo.species.size(); sp++)
+		pos[0][sp] = iInfo.species[sp]->atpos;
+	
+	//Final state positions: replace ion commands with those from finalIons
+	std::vector<std::pair<string,string>> commandsFinal;
+	for(const auto& cmd: commands)
+		if(cmd.first != "ion") commandsFinal.push_back(cmd);
+	int nIonsFinal = 0;
+	for(const auto& cmd: readInputFile(nebp.finalIons))
+		if(cmd.first == "ion")
+		{	commandsFinal.push_back(cmd);
+			nIonsFinal++;
+		}
+	logPrintf("Read %d ion commands for the final state from '%s'.\n", nIonsFinal, nebp.finalIons.c_str());
+	IonicGradient& posFinal = pos[nImages-1];
+	{	Everything eFinal;
+		FILE* logSave = globalLog; globalLog = nullLog; //final state commands already reported above
+		parse(commandsFinal, eFinal, false);
+		globalLog = logSave;
+		const IonInfo& iInfoFinal = eFinal.iInfo;
+		if(iInfoFinal.species.size() != iInfo.species.size())
+			die("Final state of nudged elastic band has a different number of species than the initial state.\n\n");
+		posFinal.init(iInfo);
+		for(size_t sp=0; sp<iInfo.species.size(); sp++)
+		{	if(iInfoFinal.species[sp]->atpos.size() != iInfo.species[sp]->atpos.size())
+				die("Final state of nudged elastic band has %d atoms of species %s, instead of %d in the initial state.\n\n",
+					int(iInfoFinal.species[sp]->atpos.size()), iInfo.species[sp]->name.c_str(), int(iInfo.species[sp]->atpos.size()));
+			posFinal[sp] = iInfoFinal.species[sp]->atpos;
+		}
+	}
+	
+	//Linearly interpolate intermediate images (using minimum-image displacements):
+	IonicGradient dPos = inv(R) * displacement(0, nImages-1);
+	for(int i=1; i+1<nImages; i++)
+		pos[i] = pos[0] + dPos * (double(i)/(nImages-1));
+	force.resize(nImages);
+	for(IonicGradient& f: force) f.init(iInfo);
+	E.assign(nImages, 0.);
+	
+	//Divide processes into groups, each computing one or more intermediate images:
+	int nProcs = mpiNEB->nProcesses();
+	nGroups = std::min(nebp.nImages, nProcs);
+	iGroup = (nGroups * (mpiNEB->iProcess()+1) - 1) / nProcs;
+	std::vector<int> ranks;
+	for(int iProc=(iGroup*nProcs)/nGroups; iProc<((iGroup+1)*nProcs)/nGroups; iProc++)
+		ranks.push_back(iProc);
+	logPrintf("Computing %d intermediate images in %d process groups (%d images per group at most).\n",
+		nebp.nImages, nGroups, ceildiv(nebp.nImages, nGroups));
+	logPrintf("Each image is logged to %s.image<i>.out, with i = 0 to %d including end points.\n", basenameNEB.c_str(), nImages-1);
+	logFlush();
+	mpiWorld = new MPIUtil(mpiNEB, ranks); //all image calculations use the group communicator
+}
+
+NudgedElasticBand::~NudgedElasticBand()
+{	images.clear();
+	deactivate();
+	delete mpiWorld;
+	mpiWorld = mpiNEB;
+}
+
+static inline void updateTangent(double wPlus, const IonicGradient& dPlus, double wMinus, const IonicGradient& dMinus, IonicGradient& tangent)
+{	tangent = dPlus * wPlus;
+	axpy(wMinus, dMinus, tangent);
+}
+
+void NudgedElasticBand::run()
+{	//End points (computed once, and freed before creating the intermediate images):
+	std::vector<int> endPoints = { 0, nImages-1 };
+	createImages(endPoints);
+	computeImages(endPoints);
+	destroyImages();
+	logPrintf("NEB: End point energies: initial  %.15lf  final  %.15lf\n", E[0], E[nImages-1]);
+	logFlush();
+	
+	//Intermediate images:
+	std::vector<int> intermediates;
+	for(int i=1; i+1<nImages; i++) intermediates.push_back(i);
+	createImages(intermediates);
+	
+	//FIRE optimization of the band:
+	const int nMin = 5; const double fInc = 1.1, fDec = 0.5, alphaStart = 0.1, fAlpha = 0.99;
+	const double dtStart = 1., dtMax = 10.; //time step in atomic units for unit mass (displacement per unit force per unit time squared)
+	double dt = dtStart, alpha = alphaStart; int nPositive = 0;
+	std::vector<IonicGradient> vel(nImages), Fneb(nImages);
+	for(int i: intermediates) vel[i] = force[i] * 0.;
+	for(int iter=0; ; iter++)
+	{	computeImages(intermediates);
+		
+		//Find climbing image:
+		int iClimb = 0;
+		if(nebp.climbing)
+		{	iClimb = 1;
+			for(int i: intermediates) if(E[i] > E[iClimb]) iClimb = i;
+		}
+		
+		//NEB forces:
+		double Fmax = 0.;
+		for(int i: intermediates)
+		{	//Improved tangent estimate (Henkelman and Jonsson, J. Chem. Phys. 113, 9978 (2000)):
+			IonicGradient dPlus = displacement(i, i+1);
+			IonicGradient dMinus = displacement(i-1, i);
+			double dEplus = E[i+1] - E[i];
+			double dEminus = E[i] - E[i-1];
+			IonicGradient tangent;
+			if(dEplus > 0. and dEminus > 0.) tangent = dPlus; //monotonically increasing
+			else if(dEplus < 0. and dEminus < 0.) tangent = dMinus; //monotonically decreasing
+			else
+			{	double dEmax = std::max(fabs(dEplus), fabs(dEminus));
+				double dEmin = std::min(fabs(dEplus), fabs(dEminus));
+				if(E[i+1] > E[i-1]) updateTangent(dEmax, dPlus, dEmin, dMinus, tangent);
+				else updateTangent(dEmin, dPlus, dEmax, dMinus, tangent);
+			}
+			tangent *= 1./sqrt(dot(tangent, tangent));
+			//Project forces:
+			double Fpar = dot(force[i], tangent);
+			Fneb[i] = clone(force[i]);
+			if(i == iClimb) axpy(-2.*Fpar, tangent, Fneb[i]); //climbing image: invert parallel force and no spring
+			else
+			{	axpy(-Fpar, tangent, Fneb[i]); //perpendicular component of true force
+				axpy(nebp.springK * (sqrt(dot(dPlus,dPlus)) - sqrt(dot(dMinus,dMinus))), tangent, Fneb[i]); //spring force
+			}
+			for(const auto& spArr: Fneb[i])
+				for(const vector3<>& f: spArr)
+					Fmax = std::max(Fmax, f.length());
+		}
+		
+		//Report:
+		logPrintf("NEB: Iter: %3d  Ebarrier: %+.6lf  FmaxNEB: %.3le  dt: %.3lf  t[s]: %9.2lf\n",
+			iter, *std::max_element(E.begin(), E.end()) - E[0], Fmax, dt, clock_sec());
+		logPrintf("NEB: E-E0:");
+		for(int i=0; i<nImages; i++) logPrintf(" %+.6lf", E[i]-E[0]);
+		logPrintf("\n");
+		logFlush();
+		if(Fmax < nebp.fMax)
+		{	logPrintf("NEB: Converged (FmaxNEB < %.3le).\n", nebp.fMax);
+			break;
+		}
+		if(iter == nebp.nIterations)
+		{	logPrintf("NEB: None of the convergence criteria satisfied after %d iterations.\n", iter);
+			break;
+		}
+		
+		//FIRE velocity update:
+		double P = 0., Fsq = 0., vSq = 0.;
+		for(int i: intermediates)
+		{	P += dot(Fneb[i], vel[i]);
+			Fsq += dot(Fneb[i], Fneb[i]);
+			vSq += dot(vel[i], vel[i]);
+		}
+		if(P > 0.)
+		{	double vByF = sqrt(vSq/Fsq);
+			for(int i: intermediates)
+			{	vel[i] *= (1.-alpha);
+				axpy(alpha*vByF, Fneb[i], vel[i]);
+			}
+			if(nPositive++ > nMin)
+			{	dt = std::min(dt*fInc, dtMax);
+				alpha *= fAlpha;
+			}
+		}
+		else if(P < 0.) //uphill (P = 0 only at rest, eg. on the first iteration, which needs no reset)
+		{	for(int i: intermediates) vel[i] *= 0.;
+			dt *= fDec;
+			alpha = alphaStart;
+			nPositive = 0;
+		}
+		//Euler step, with displacements limited to maxStep:
+		std::vector<IonicGradient> dx(nImages);
+		double dxMax = 0.;
+		for(int i: intermediates)
+		{	axpy(dt, Fneb[i], vel[i]);
+			dx[i] = vel[i] * dt;
+			for(const auto& spArr: dx[i])
+				for(const vector3<>& d: spArr)
+					dxMax = std::max(dxMax, d.length());
+		}
+		double scale = (dxMax > nebp.maxStep) ? nebp.maxStep/dxMax : 1.;
+		for(Image& image: images)
+		{	activate(image);
+			image.imin->constrain(dx[image.index]);
+			image.imin->step(dx[image.index], scale); //also drags wavefunctions of image
+			deactivate();
+		}
+	}
+	
+	//Write final path:
+	logPrintf("NEB: Final path (image, E-E0 [Eh], reaction coordinate [bohr]): \n");
+	double s = 0.;
+	for(int i=0; i<nImages; i++)
+	{	if(i)
+		{	IonicGradient d = displacement(i-1, i);
+			s += sqrt(dot(d, d));
+		}
+		logPrintf("NEB: %3d %+.9lf %.6lf\n", i, E[i]-E[0], s);
+	}
+	logFlush();
+	destroyImages();
+}
+
+int NudgedElasticBand::groupOf(int index) const
+{	if(index == 0) return 0;
+	if(index == nImages-1) return 1 % nGroups;
+	return (index-1) % nGroups;
+}
+
+void NudgedElasticBand::createImages(const std::vector<int>& indices)
+{	for(int index: indices) if(groupOf(index) == iGroup)
+	{	Image image;
+		image.index = index;
+		ostringstream oss; oss << basenameNEB << ".image" << index;
+		image.basename = oss.str();
+		image.log = nullLog;
+		if(mpiWorld->isHead())
+		{	string logFilename = image.basename + ".out";
+			image.log = fopen(logFilename.c_str(), "w");
+			if(!image.log) die_alone("Could not open log file '%s' for writing.\n", logFilename.c_str());
+		}
+		activate(image);
+		logPrintf("\nNudged elastic band image %d of %d (group %d of %d with %d processes).\n",
+			index, nImages-1, iGroup, nGroups, mpiWorld->nProcesses());
+		image.e = std::make_shared<Everything>();
+		Everything& e = *(image.e);
+		parse(commands, e, printDefaults);
+		for(size_t sp=0; sp<e.iInfo.species.size(); sp++)
+			e.iInfo.species[sp]->atpos = pos[index][sp];
+		e.setup();
+		e.dump(DumpFreq_Init, 0);
+		Citations::print();
+		logPrintf("Initialization completed successfully at t[s]: %9.2lf\n\n", clock_sec());
+		logFlush();
+		image.imin = std::make_shared<IonicMinimizer>(e);
+		deactivate();
+		images.push_back(image);
+	}
+}
+
+void NudgedElasticBand::destroyImages()
+{	for(Image& image: images)
+	{	activate(image);
+		image.e->dump(DumpFreq_End, 0);
+		image.imin = 0;
+		image.e = 0;
+		logFlush();
+		deactivate();
+		if(mpiWorld->isHead()) fclose(image.log);
+	}
+	images.clear();
+}
+
+void NudgedElasticBand::activate(const Image& image)
+{	globalLog = image.log;
+	inputBasename = image.basename;
+}
+
+void NudgedElasticBand::deactivate()
+{	globalLog = logNEB;
+	inputBasename = basenameNEB;
+}
+
+void NudgedElasticBand::computeImages(const std::vector<int>& indices)
+{	int nAtoms = 0;
+	for(const auto& spArr: pos[0]) nAtoms += spArr.size();
+	const int nPerImage = 1 + 6*nAtoms; //energy, force and position
+	std::vector<double> buf(nImages*nPerImage, 0.);
+	for(Image& image: images)
+		if(std::find(indices.begin(), indices.end(), image.index) != indices.end())
+		{	activate(image);
+			const Everything& e = *(image.e);
+			logPrintf("\n---------- Nudged elastic band image %d ----------\n", image.index);
+			IonicGradient grad, Kgrad;
+			double Eimage = image.imin->compute(&grad, &Kgrad); //Kgrad is the constrained gradient (with moveScale)
+			if(std::isnan(Eimage))
+				die("Nudged elastic band image %d has pseudopotential core overlaps.\n\n", image.index);
+			logPrintf("# Energy components:\n"); e.ener.print(); logPrintf("\n");
+			logFlush();
+			deactivate();
+			//Collect on group head:
+			if(mpiWorld->isHead())
+			{	double* bufImage = buf.data() + image.index*nPerImage;
+				*(bufImage++) = Eimage;
+				for(size_t sp=0; sp<Kgrad.size(); sp++)
+					for(size_t atom=0; atom<Kgrad[sp].size(); atom++)
+					{	const vector3<> f = -Kgrad[sp][atom];
+						const vector3<>& x = e.iInfo.species[sp]->atpos[atom];
+						for(int k=0; k<3; k++)
+						{	bufImage[k] = f[k];
+							bufImage[3*nAtoms+k] = x[k];
+						}
+						bufImage += 3;
+					}
+			}
+		}
+	mpiNEB->allReduceData(buf, MPIUtil::ReduceSum);
+	//Distribute to image properties:
+	for(int index: indices)
+	{	const double* bufImage = buf.data() + index*nPerImage;
+		E[index] = *(bufImage++);
+		for(size_t sp=0; sp<pos[index].size(); sp++)
+			for(size_t atom=0; atom<pos[index][sp].size(); atom++)
+			{	for(int k=0; k<3; k++)
+				{	force[index][sp][atom][k] = bufImage[k];
+					pos[index][sp][atom][k] = bufImage[3*nAtoms+k];
+				}
+				bufImage += 3;
+			}
+	}
+}
+
+IonicGradient NudgedElasticBand::displacement(int i, int j) const
+{	IonicGradient d = pos[j] - pos[i];
+	for(auto& spArr: d)
+		for(vector3<>& dAtom: spArr)
+			for(int k=0; k<3; k++)
+				dAtom[k] -= floor(0.5 + dAtom[k]);
+	return R * d;
+}
@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_NUDGEDELASTICBAND_H
+#define JDFTX_ELECTRONIC_NUDGEDELASTICBAND_H
+
+#include <electronic/IonicMinimizer.h>
+#include <electronic/NudgedElasticBandParams.h>
+#include <memory>
+
+//! @addtogroup IonicSystem
+//! @{
+//! @file NudgedElasticBand.h Class NudgedElasticBand
+
+/** Nudged elastic band (optionally climbing image) search for minimum energy paths.
+The initial state is specified by the input file and the final state by ion commands in NudgedElasticBandParams::finalIons.
+The processes are divided into groups which each hold a complete calculation (Everything) for one or more images,
+so that all images are evaluated concurrently, with wavefunctions dragged from the previous step of each image.
+The band itself is optimized using FIRE, replicated on all processes.
+*/
+class NudgedElasticBand
+{
+public:
+	//! Set up from input commands (end point and band parameters from e, which has been parsed but not setup)
+	NudgedElasticBand(const Everything& e, const std::vector<std::pair<string,string>>& commands, bool printDefaults);
+	~NudgedElasticBand();
+	void run(); //!< Optimize the band and dump final state of each image
+	
+private:
+	const NudgedElasticBandParams& nebp;
+	std::vector<std::pair<string,string>> commands; //!< input commands used to create each image
+	bool printDefaults; //!< whether to print default commands in image logs
+	int nImages; //!< total number of images including end points
+	matrix3<> R; //!< lattice vectors (common to all images)
+	std::vector<IonicGradient> pos; //!< positions (lattice coordinates) of all images (replicated)
+	std::vector<IonicGradient> force; //!< constrained forces (Cartesian) of all images (replicated)
+	std::vector<double> E; //!< energies of all images (replicated)
+	
+	//Process groups:
+	MPIUtil* mpiNEB; //!< communicator over all processes (mpiWorld is the group communicator while this object exists)
+	FILE* logNEB; //!< log for overall band progress
+	string basenameNEB; //!< input basename of overall calculation
+	int nGroups, iGroup; //!< number of process groups and index of current group
+	
+	//! Calculation for an image owned by the current group
+	struct Image
+	{	int index; //!< image index
+		string basename; //!< input basename used for log and dumps of this image
+		FILE* log; //!< log file of this image (nullLog except on group head)
+		std::shared_ptr<Everything> e;
+		std::shared_ptr<IonicMinimizer> imin;
+	};
+	std::vector<Image> images; //!< images owned by current group
+	
+	int groupOf(int index) const; //!< process group that computes a given image
+	void createImages(const std::vector<int>& indices); //!< create calculations for the images in list owned by current group (at current pos)
+	void destroyImages(); //!< dump final state and free calculations of current images
+	void activate(const Image& image); //!< switch log and input basename to image
+	void deactivate(); //!< switch log and input basename back to the overall calculation
+	void computeImages(const std::vector<int>& indices); //!< compute images in list (each on its group) and collect E, force and pos on all processes
+	IonicGradient displacement(int i, int j) const; //!< Cartesian minimum-image displacement from image i to image j
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_NUDGEDELASTICBAND_H
@@ -0,0 +1,43 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_NUDGEDELASTICBANDPARAMS_H
+#define JDFTX_ELECTRONIC_NUDGEDELASTICBANDPARAMS_H
+
+#include <core/string.h>
+
+//! @addtogroup IonicSystem
+//! @{
+//! @file NudgedElasticBandParams.h Struct NudgedElasticBandParams
+
+//! Parameters to control NudgedElasticBand
+struct NudgedElasticBandParams
+{	int nImages; //!< number of intermediate images (0 => no NEB calculation)
+	string finalIons; //!< file containing ion commands for the final state
+	double springK; //!< spring constant between images [Eh/a0^2]
+	bool climbing; //!< whether to use the climbing-image (CI-NEB) for the highest energy image
+	int nIterations; //!< maximum number of band optimization steps
+	double fMax; //!< convergence threshold on max (per-atom) NEB force [Eh/a0]
+	double maxStep; //!< maximum displacement of any atom in one step [a0]
+	
+	NudgedElasticBandParams() : nImages(0), springK(0.005), climbing(true), nIterations(100), fMax(1e-3), maxStep(0.2) {}
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_NUDGEDELASTICBANDPARAMS_H
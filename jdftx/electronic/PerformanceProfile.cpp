@@ -0,0 +1,211 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/PerformanceProfile.h>
+#include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
+#include <core/Operators.h>
+#include <cfloat>
+#include <unistd.h>
+#ifdef GPU_ENABLED
+#include <core/GpuUtil.h>
+#endif
+
+//Set param to value if it is still at its default, and log the change:
+template<typename T> void setIfDefault(T& param, const T& defaultValue, const T& value, const char* name)
+{	if(param == defaultValue and not (value == defaultValue))
+	{	param = value;
+		std::ostringstream oss; oss << value;
+		logPrintf("\t%s %s\n", name, oss.str().c_str());
+	}
+}
+
+void applyPerformanceProfile(Everything& e)
+{	Control& cntrl = e.cntrl;
+	if(cntrl.perfProfile == PerformanceDefault) return;
+	const Control defaults;
+	const SCFparams scfDefaults;
+	bool gpu = isGpuEnabled();
+	logPrintf("\nApplying performance profile to settings left at their defaults:\n");
+	switch(cntrl.perfProfile)
+	{	case PerformanceThroughput:
+		{	setIfDefault(cntrl.fftBatchSize, defaults.fftBatchSize, gpu ? 16 : 4, "fft-batch-size");
+			setIfDefault(cntrl.kpointBatchSize, defaults.kpointBatchSize, gpu ? 4 : 1, "kpoint-batch-size");
+			setIfDefault(cntrl.exxBlockSize, defaults.exxBlockSize, 32, "exchange-block-size");
+			break;
+		}
+		case PerformanceMemoryLean:
+		{	setIfDefault(cntrl.fftBatchSize, defaults.fftBatchSize, 1, "fft-batch-size");
+			setIfDefault(cntrl.hamiltonianBlockSize, defaults.hamiltonianBlockSize, 32, "hamiltonian-block-size");
+			setIfDefault(cntrl.exxBlockSize, defaults.exxBlockSize, 8, "exchange-block-size");
+			setIfDefault(cntrl.davidsonBandRatio, defaults.davidsonBandRatio, 1., "davidson-band-ratio");
+			if(cntrl.cacheProjectors)
+				setIfDefault(cntrl.projectorCacheMB, defaults.projectorCacheMB, 256., "cache-projectors yes");
+			setIfDefault(e.scfParams.history, scfDefaults.history, 5, "electronic-scf history");
+			break;
+		}
+		case PerformanceLatency:
+		{	setIfDefault(cntrl.davidsonBandRatio, defaults.davidsonBandRatio, 1.5, "davidson-band-ratio");
+			setIfDefault(e.scfParams.history, scfDefaults.history, 15, "electronic-scf history");
+			break;
+		}
+		case PerformanceDefault: break;
+	}
+	logFlush();
+}
+
+string perfTuneFilename(const Control& cntrl)
+{	if(cntrl.perfTuneFile.length()) return cntrl.perfTuneFile;
+	const char* home = getenv("HOME");
+	return home ? (string(home) + "/.jdftx-tuning") : string(".jdftx-tuning");
+}
+
+//Minimum time in seconds over a few repetitions of func, after a warm-up call (which also creates FFT plans):
+template<typename Func> double timeTrial(const Func& func)
+{	func();
+	double tMin = DBL_MAX;
+	for(int iRep=0; iRep<3; iRep++)
+	{	double t = clock_us();
+		func();
+		#ifdef GPU_ENABLED
+		cudaDeviceSynchronize();
+		#endif
+		tMin = std::min(tMin, clock_us() - t);
+	}
+	return tMin * 1e-6;
+}
+
+void autoTunePerformance(Everything& e)
+{	Control& cntrl = e.cntrl;
+	if(!cntrl.perfAutoTune) return;
+	logPrintf("\n---------- Performance auto-tuning ----------\n");
+	bool tuneBatch = !cntrl.fftBatchSize, tuneBlock = !cntrl.hamiltonianBlockSize;
+	if(!(tuneBatch or tuneBlock))
+	{	logPrintf("Skipped: fft-batch-size and hamiltonian-block-size are both set explicitly.\n");
+		return;
+	}
+	GridInfo& gInfoWfns = e.gInfoWfns ? *e.gInfoWfns : e.gInfo;
+	const Basis& basis = e.basis[0];
+	int nBands = e.eInfo.nBands;
+
+	//Identify machine and problem size:
+	char hostname[256];
+	gethostname(hostname, sizeof(hostname)); hostname[sizeof(hostname)-1] = 0;
+	const char* device = isGpuEnabled() ? "gpu" : "cpu";
+	const vector3<int>& S = gInfoWfns.S;
+	string fname = perfTuneFilename(cntrl);
+
+	//Look up cached settings:
+	int bestBatch = 0, bestBlock = 0;
+	bool found = false;
+	if(mpiWorld->isHead())
+	{	FILE* fp = fopen(fname.c_str(), "r");
+		if(fp)
+		{	char buf[1024];
+			while(!found and fgets(buf, sizeof(buf), fp))
+			{	char hostEntry[256], deviceEntry[16];
+				int nThreads, S0, S1, S2, nbasis, nBandsEntry, batch, block;
+				if(sscanf(buf, "%255s %15s %d %d %d %d %d %d %d %d", hostEntry, deviceEntry, &nThreads,
+						&S0, &S1, &S2, &nbasis, &nBandsEntry, &batch, &block) == 10
+					and !strcmp(hostEntry, hostname) and !strcmp(deviceEntry, device) and nThreads==nProcsAvailable
+					and S0==S[0] and S1==S[1] and S2==S[2] and nbasis==int(basis.nbasis) and nBandsEntry==nBands)
+				{	found = true;
+					bestBatch = batch;
+					bestBlock = block;
+				}
+			}
+			fclose(fp);
+		}
+	}
+	mpiWorld->bcast(found);
+	if(found)
+	{	mpiWorld->bcast(bestBatch);
+		mpiWorld->bcast(bestBlock);
+		logPrintf("Using settings cached in '%s' for this machine and problem size.\n", fname.c_str());
+	}
+	else
+	{	//Trial wavefunctions and potential:
+		ColumnBundle C(nBands, basis.nbasis * e.eInfo.spinorLength(), &basis, &e.eInfo.qnums[0], isGpuEnabled());
+		C.randomize(0, nBands);
+		ScalarFieldArray V(1); nullToZero(V, gInfoWfns); initRandom(V[0]);
+		int batchSave = gInfoWfns.fftBatchSize;
+
+		//FFT batch size, timing the local potential term:
+		bestBatch = gInfoWfns.fftBatchSize;
+		if(tuneBatch)
+		{	std::vector<int> candidates = isGpuEnabled() ? std::vector<int>({4, 8, 16, 32}) : std::vector<int>({1, 2, 4, 8});
+			double tBest = DBL_MAX;
+			for(int batch: candidates)
+			{	if(batch > nBands and batch != candidates[0]) break;
+				gInfoWfns.fftBatchSize = batch;
+				double t = timeTrial([&](){ Idag_DiagV_I(C, V); });
+				mpiWorld->bcast(t); //decide consistently based on head's timing
+				logPrintf("\tfft-batch-size %3d: %9.3lf ms\n", batch, t*1e3); logFlush();
+				if(t < tBest) { tBest = t; bestBatch = batch; }
+			}
+		}
+		gInfoWfns.fftBatchSize = bestBatch;
+
+		//Hamiltonian block size, timing the local and kinetic terms block-wise:
+		bestBlock = cntrl.hamiltonianBlockSize;
+		if(tuneBlock)
+		{	double tBest = DBL_MAX;
+			for(int block: {0, 16, 32, 64, 128})
+			{	if(block and (block >= nBands or block < bestBatch)) continue;
+				int blockSize = block ? block : nBands;
+				double t = timeTrial([&]()
+				{	ColumnBundle HC = C.similar(); HC.zero();
+					for(int colStart=0; colStart<nBands; colStart+=blockSize)
+					{	int colStop = std::min(colStart+blockSize, nBands);
+						ColumnBundleView Cb(C, colStart, colStop);
+						Idag_DiagV_I_accum(Cb, V, HC);
+						ColumnBundleView(HC, colStart, colStop) += (-0.5) * L(Cb);
+					}
+				});
+				mpiWorld->bcast(t);
+				logPrintf("\thamiltonian-block-size %3d: %9.3lf ms\n", block, t*1e3); logFlush();
+				if(t < tBest) { tBest = t; bestBlock = block; }
+			}
+		}
+		gInfoWfns.fftBatchSize = batchSave;
+
+		//Cache results:
+		if(mpiWorld->isHead())
+		{	FILE* fp = fopen(fname.c_str(), "a");
+			if(fp)
+			{	fprintf(fp, "%s %s %d %d %d %d %d %d %d %d\n", hostname, device, nProcsAvailable,
+					S[0], S[1], S[2], int(basis.nbasis), nBands, bestBatch, bestBlock);
+				fclose(fp);
+				logPrintf("Cached tuned settings in '%s'.\n", fname.c_str());
+			}
+			else logPrintf("WARNING: could not open '%s' to cache tuned settings.\n", fname.c_str());
+		}
+	}
+
+	//Apply chosen settings:
+	if(tuneBatch)
+	{	cntrl.fftBatchSize = bestBatch;
+		e.gInfo.fftBatchSize = bestBatch;
+		if(e.gInfoWfns) e.gInfoWfns->fftBatchSize = bestBatch;
+	}
+	if(tuneBlock) cntrl.hamiltonianBlockSize = bestBlock;
+	logPrintf("Auto-tuned settings: fft-batch-size %d  hamiltonian-block-size %d\n",
+		cntrl.fftBatchSize, cntrl.hamiltonianBlockSize);
+	logFlush();
+}
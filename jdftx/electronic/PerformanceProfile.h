@@ -0,0 +1,49 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_PERFORMANCEPROFILE_H
+#define JDFTX_ELECTRONIC_PERFORMANCEPROFILE_H
+
+//! @addtogroup ElectronicDFT
+//! @{
+
+/** @file PerformanceProfile.h
+@brief Performance presets and start-up auto-tuning (command performance-profile)
+
+Presets only change settings that are still at their defaults, so that any of them
+can be overridden by the corresponding command. They change performance and memory
+alone, not convergence thresholds, so results are unaffected up to those thresholds.
+*/
+
+#include <core/string.h>
+
+class Everything;
+
+//! Apply the preset selected by Control::perfProfile to settings left at their defaults (call at the start of setup)
+void applyPerformanceProfile(Everything& e);
+
+//! If Control::perfAutoTune, time trial FFT batch and Hamiltonian block sizes on the wavefunction grid
+//! (call after basis setup), reusing results cached for this machine and problem size when available
+void autoTunePerformance(Everything& e);
+
+//! Filename in which machine-specific tuning results are cached (Control::perfTuneFile, or ~/.jdftx-tuning by default)
+string perfTuneFilename(const class Control& cntrl);
+
+//! @}
+#endif // JDFTX_ELECTRONIC_PERFORMANCEPROFILE_H
@@ -33,6 +33,8 @@ Polarizability::Polarizability() : eigenBasis(NonInteracting), Ecut(0), nEigs(0)
 class PairDensityCalculator
 {
 	int nK;
+	int nV; //number of occupied bands
+	std::vector<std::pair<int,int>> pairs; //selected occupied-unoccupied pairs (v,c), ordered by v
 	
 	struct State
 	{	const ColumnBundle* C;
@@ -115,34 +117,38 @@ public:
 				e.dump.polarizability->dkFilename(ik,"eigenvals") );
 		}
 		else //get second state from current system's kmesh as well
-		{	bool foundk2 = false;
-			Supercell::KmeshTransform kTransform2 = {0, 0, 0, vector3<int>()};
-			for(unsigned ik2=0; ik2<kmesh.size(); ik2++)
-				if(circDistanceSquared(kmesh[ik2],k2) < symmThresholdSq)
-				{	double offsetErr;
-					kTransform2 = kmeshTransform[ik2];
-					kTransform2.offset += round(k2 - kmesh[ik2], &offsetErr);
-					foundk2 = true;
-					assert(offsetErr < symmThreshold);
-					break;
-				}
+		{	Supercell::KmeshTransform kTransform2 = {0, 0, 0, vector3<int>()};
+			bool foundk2 = (e.coulombParams.supercell->findKpoint(k2, &kTransform2) != string::npos);
 			assert(foundk2); //such a partner should always be found for a uniform kmesh
 			state2.setup(e, k2, kTransform2);
 		}
 	}
 
-	//Store resulting pair densities scaled by 2*invsqrt(eigenvalue differences) in rho,
+	//Select the occupied x unoccupied pairs to include (all nV x nC, less those dropped by pairScreening); return their count
+	int selectPairs(int nV, int nC, const PairScreening& pairScreening)
+	{	this->nV = nV;
+		pairs.clear();
+		for(int v=0; v<nV; v++)
+			for(int c=0; c<nC; c++)
+				if(pairScreening(1., 0., state1.eig->at(v), state2.eig->at(nV+c)))
+					pairs.push_back(std::make_pair(v,c));
+		return pairs.size();
+	}
+	
+	//Store resulting pair densities of selected pairs scaled by 2*invsqrt(eigenvalue differences) in rho,
 	//so that the non-interacting susceptibility is negative identity in this basis.
-	void compute(int nV, int nC, ColumnBundle& rho, int kOffset) const
-	{	threadLaunch(isGpuEnabled() ? 1 : 0, compute_thread, nV*nC, nV, nC, &rho, kOffset, this);
+	void compute(ColumnBundle& rho, int kOffset) const
+	{	threadLaunch(isGpuEnabled() ? 1 : 0, compute_thread, pairs.size(), &rho, kOffset, this);
 	}
 	
 	//Accumulate contribution from currentkpoint pair to negative of noninteracting susceptibility in plane-wave basis:
-	void accumMinusXniPW(int nV, int nC, const Basis& basis, matrix& minusXni)
+	void accumMinusXniPW(int nV, int nC, const Basis& basis, matrix& minusXni, const PairScreening& pairScreening)
 	{	assert(minusXni.nRows() == int(basis.nbasis));
 		assert(minusXni.nCols() == int(basis.nbasis));
-		ColumnBundle rho(nV*nC, basis.nbasis, &basis);
-		compute(nV, nC, rho, 0);
+		int nPairs = selectPairs(nV, nC, pairScreening);
+		if(!nPairs) return;
+		ColumnBundle rho(nPairs, basis.nbasis, &basis);
+		compute(rho, 0);
 		//Xni += (detR)*rho*dagger(rho):
 		callPref(eblas_zgemm)(CblasNoTrans, CblasConjTrans, basis.nbasis, basis.nbasis, rho.nCols(),
 			basis.gInfo->detR, rho.dataPref(), rho.colLength(), rho.dataPref(), rho.colLength(),
@@ -150,22 +156,18 @@ public:
 	}
 	
 private:
-	void compute_sub(int bStart, int bStop, int nV, int nC, ColumnBundle* rho, int kOffset) const
-	{	int b = bStart;
-		int v = b / nC;
-		int c = b - v*nC;
-		complexScalarField conjICv = conj(I(state1.getColumn(v)));
-		while(b<bStop)
-		{	double sqrtEigDen = sqrt(4./(nK * (state2.eig->at(nV+c) - state1.eig->at(v))));
+	void compute_sub(int bStart, int bStop, ColumnBundle* rho, int kOffset) const
+	{	int vPrev = -1;
+		complexScalarField conjICv;
+		for(int b=bStart; b<bStop; b++)
+		{	int v = pairs[b].first, c = pairs[b].second;
+			if(v != vPrev) { conjICv = conj(I(state1.getColumn(v))); vPrev = v; }
+			double sqrtEigDen = sqrt(4./(nK * (state2.eig->at(nV+c) - state1.eig->at(v))));
 			rho->setColumn(kOffset+b,0, sqrtEigDen * J(conjICv * I(state2.getColumn(nV+c))));
-			//Next cv pair:
-			b++; if(b==bStop) break;
-			c++;
-			if(c==nC) { c=0; v++; conjICv = conj(I(state1.getColumn(v))); }
 		}
 	}
-	static void compute_thread(int bStart, int bStop, int nV, int nC, ColumnBundle* rho, int kOffset, const PairDensityCalculator* pdc)
-	{	pdc->compute_sub(bStart, bStop, nV, nC, rho, kOffset);
+	static void compute_thread(int bStart, int bStop, ColumnBundle* rho, int kOffset, const PairDensityCalculator* pdc)
+	{	pdc->compute_sub(bStart, bStop, rho, kOffset);
 	}
 };
 
@@ -245,26 +247,31 @@ inline void exCorr_thread(int bStart, int bStop, const ScalarField* exc_nn, cons
 	}
 }
 
-matrix exCorrMatrix(const ColumnBundle& V, const Everything& e, const ScalarField& n, vector3<> dk)
-{	logPrintf("\tForming Exchange-Correlation matrix\n"); logFlush();
-	//Get second derivatives w.r.t density (and gradients)
-	ScalarField exc_nn, exc_sigma, exc_nsigma, exc_sigmasigma;
-	VectorField Dn;
+ExCorrKernel::ExCorrKernel(const Everything& e, const ScalarField& n, const GridInfo& gInfo)
+{	//Get second derivatives w.r.t density (and gradients)
 	e.exCorr.getSecondDerivatives(n, exc_nn, exc_sigma, exc_nsigma, exc_sigmasigma);
 	if(exc_sigma) Dn = gradient(n); //needed for GGAs
 	//Change grid if necessary:
-	if(&(n->gInfo) != V.basis->gInfo)
-	{	exc_nn = changeGrid(exc_nn, *(V.basis->gInfo));
+	if(&(n->gInfo) != &gInfo)
+	{	exc_nn = changeGrid(exc_nn, gInfo);
 		if(exc_sigma)
-		{	for(int k=0; k<3; k++) Dn[k] = changeGrid(Dn[k], *(V.basis->gInfo));
-			exc_sigma = changeGrid(exc_sigma, *(V.basis->gInfo));
-			exc_nsigma = changeGrid(exc_nsigma, *(V.basis->gInfo));
-			exc_sigmasigma = changeGrid(exc_sigmasigma, *(V.basis->gInfo));
+		{	for(int k=0; k<3; k++) Dn[k] = changeGrid(Dn[k], gInfo);
+			exc_sigma = changeGrid(exc_sigma, gInfo);
+			exc_nsigma = changeGrid(exc_nsigma, gInfo);
+			exc_sigmasigma = changeGrid(exc_sigmasigma, gInfo);
 		}
 	}
-	//Compute matrix:
-	ColumnBundle KXCV = V.similar();
-	threadLaunch(isGpuEnabled() ? 1 : 0, exCorr_thread, V.nCols(), &exc_nn, &Dn, &exc_sigma, &exc_nsigma, &exc_sigmasigma, &V, &KXCV);
+}
+
+ColumnBundle ExCorrKernel::operator()(const ColumnBundle& rho) const
+{	ColumnBundle KXCrho = rho.similar();
+	threadLaunch(isGpuEnabled() ? 1 : 0, exCorr_thread, rho.nCols(), &exc_nn, &Dn, &exc_sigma, &exc_nsigma, &exc_sigmasigma, &rho, &KXCrho);
+	return KXCrho;
+}
+
+matrix exCorrMatrix(const ColumnBundle& V, const Everything& e, const ScalarField& n, vector3<> dk)
+{	logPrintf("\tForming Exchange-Correlation matrix\n"); logFlush();
+	ColumnBundle KXCV = ExCorrKernel(e, n, *(V.basis->gInfo))(V);
 	return e.gInfo.detR * (V^KXCV);
 }
 
@@ -318,13 +325,25 @@ void Polarizability::dump(const Everything& e)
 		//Get the PW basis non-interacting susceptibility matrix:
 		matrix minusXni(nColumns, nColumns); minusXni.zero();
 		for(int ik=0; ik<nK; ik++)
-			PairDensityCalculator(e, dk, ik).accumMinusXniPW(nV, nC, basis, minusXni);
+			PairDensityCalculator(e, dk, ik).accumMinusXniPW(nV, nC, basis, minusXni, e.dump.pairScreening);
+		e.dump.pairScreening.report("Polarizability");
 		Xni = -minusXni;
 	}
 	else
 	{	logPrintf("\tComputing occupied x unoccupied (CV) pair-densities and NonInteracting polarizability\n"); logFlush();
+		int kOffset = 0;
 		for(int ik=0; ik<nK; ik++)
-			PairDensityCalculator(e, dk, ik).compute(nV, nC, V, ik*nV*nC);
+		{	PairDensityCalculator pdc(e, dk, ik);
+			int nPairs = pdc.selectPairs(nV, nC, e.dump.pairScreening);
+			pdc.compute(V, kOffset);
+			kOffset += nPairs;
+		}
+		e.dump.pairScreening.report("Polarizability");
+		if(!kOffset) die("\nAll pairs dropped by dump-pair-screening: reduce its threshold.\n");
+		if(kOffset < nColumns)
+		{	V = V.getSub(0, kOffset); //drop unused columns of screened pairs
+			nColumns = kOffset;
+		}
 		matrix invXni = -eye(nColumns); //inverse of non-interacting susceptibility
 		logPrintf("\tOrthonormalizing basis\n"); logFlush();
 		matrix Umhalf = invsqrt(e.gInfo.detR*(V^V));
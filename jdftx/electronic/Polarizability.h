@@ -22,6 +22,10 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/vector3.h>
 #include <core/string.h>
+#include <core/VectorField.h>
+
+class Everything;
+class ColumnBundle;
 
 //! @addtogroup Output
 //! @{
@@ -52,5 +56,17 @@ private:
 	friend class PairDensityCalculator;
 };
 
+//! Exchange-correlation kernel (second functional derivative) at a fixed density, applied to
+//! density perturbations stored as columns of a ColumnBundle (whose qnum->k is the perturbation wavevector)
+class ExCorrKernel
+{
+public:
+	ExCorrKernel(const Everything& e, const ScalarField& n, const GridInfo& gInfo); //!< compute second derivatives at n and map them to gInfo (of the perturbation basis)
+	ColumnBundle operator()(const ColumnBundle& rho) const; //!< return change in potential for each column of rho
+private:
+	ScalarField exc_nn, exc_sigma, exc_nsigma, exc_sigmasigma;
+	VectorField Dn; //!< density gradient (GGAs only)
+};
+
 //! @}
 #endif // JDFTX_ELECTRONIC_POLARIZABILITY_H
@@ -26,10 +26,15 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <queue>
 
 inline void setKernels(int i, double Gsq, double GminSq, bool mixDensity, double mixFraction,
-	double qKerkerSq, double qMetricSq, double kappaSq, double* kerkerMix, double* diisMetric)
+	double qKerkerSq, double qMetricSq, double kappaSq, double epsResta, double Rresta, double* kerkerMix, double* diisMetric)
 {
 	double GsqReg = kappaSq ? (Gsq + kappaSq) : std::max(Gsq, GminSq); //regularize to avoid G=0 issues (either by qKappa or Gmin)
 	double kerkerSat = qKerkerSq ? GsqReg/(GsqReg + qKerkerSq) : 1.; //Saturation function [0,infty)->[0,1) with qKerkerSq
+	if(epsResta && qKerkerSq)
+	{	//Inverse of Resta's model dielectric function (saturates to 1/epsResta at G=0 instead of vanishing):
+		double qR = sqrt(GsqReg) * Rresta;
+		kerkerSat = (GsqReg + qKerkerSq*sin(qR)/(epsResta*qR)) / (GsqReg + qKerkerSq);
+	}
 	double metricSat = qMetricSq ? GsqReg/(GsqReg + qMetricSq) : 1.; //Saturation function [0,infty)->[0,1) with qMetricSq
 	kerkerMix[i] = kerkerSat * mixFraction;
 	diisMetric[i] = mixDensity ? 1./metricSat : metricSat;
@@ -41,9 +46,11 @@ inline ScalarFieldArray operator*(const RealKernel& K, const ScalarFieldArray& x
 	return Kx;
 }
 
-SCF::SCF(Everything& e): Pulay<SCFvariable>(e.scfParams), e(e), kerkerMix(e.gInfo), diisMetric(e.gInfo)
+SCF::SCF(Everything& e): Pulay<SCFvariable>(e.scfParams), e(e), kerkerMix(e.gInfo), diisMetric(e.gInfo),
+	muTarget(NAN), nElectronsOut(e.eInfo.nElectrons), Cfluid(INFINITY), nMix(1.), nMetric(0.), fftPrecision(e)
 {	SCFparams& sp = e.scfParams;
 	mixTau = e.exCorr.needsKEdensity();
+	mixN = sp.mixNelectrons && (!std::isnan(e.eInfo.mu)) && (e.eInfo.fillingsUpdate==ElecInfo::FillingsHsub);
 	
 	//Determine minimum Gsq (used for preconditioning):
 	double GminSq = DBL_MAX;
@@ -59,8 +66,38 @@ SCF::SCF(Everything& e): Pulay<SCFvariable>(e.scfParams), e(e), kerkerMix(e.gInf
 	double qKappaSq = sp.qKappa >= 0.
 		? pow(sp.qKappa,2)
 		: (e.eVars.fluidSolver ? e.eVars.fluidSolver->k2factor / e.eVars.fluidSolver->epsBulk : 0.);
+	double Rresta = 0.; //Resta screening length, set by sinh(qKerker Rresta) / (qKerker Rresta) = epsResta
+	if(sp.epsResta && sp.qKerker)
+	{	double x = log(2.*sp.epsResta); //initial guess (asymptotically correct for large epsResta)
+		for(int iter=0; iter<50; iter++)
+		{	double f = sinh(x)/x - sp.epsResta;
+			double fPrime = (cosh(x) - sinh(x)/x)/x;
+			double dx = -f/fPrime;
+			x += dx;
+			if(fabs(dx) < 1e-12*x) break;
+		}
+		Rresta = x / sp.qKerker;
+		logPrintf("Resta preconditioner: epsResta = %lg, qKerker = %lg bohr^-1, screening length = %lg bohr.\n", sp.epsResta, sp.qKerker, Rresta);
+	}
 	applyFuncGsq(e.gInfo, setKernels, GminSq, sp.mixedVariable==SCFparams::MV_Density, sp.mixFraction,
-		pow(sp.qKerker,2), pow(sp.qMetric,2), qKappaSq, kerkerMix.data(), diisMetric.data());
+		pow(sp.qKerker,2), pow(sp.qMetric,2), qKappaSq, sp.epsResta, Rresta, kerkerMix.data(), diisMetric.data());
+	
+	//Electron count preconditioner and metric for grand-canonical SCF:
+	if(mixN)
+	{	//Electrostatic capacitance of the diffuse layer (Debye length) on both sides of the largest cell face:
+		const FluidSolver* fs = e.eVars.fluidSolver.get();
+		if(fs && fs->k2factor > 0.)
+		{	double Amax = 0.;
+			for(int k=0; k<3; k++)
+				Amax = std::max(Amax, cross(e.gInfo.R.column(k), e.gInfo.R.column((k+1)%3)).length());
+			Cfluid = 2. * Amax * sqrt(fs->epsBulk * fs->k2factor) / (4*M_PI);
+		}
+		//Weight equal to that of a uniform density change at the longest wavelength in the metric:
+		double GsqReg = qKappaSq ? qKappaSq : GminSq;
+		double metricSat = sp.qMetric ? GsqReg/(GsqReg + pow(sp.qMetric,2)) : 1.;
+		nMetric = 1./(e.gInfo.detR * metricSat);
+		logPrintf("Grand-canonical SCF: mixing electron count with fluid capacitance %lg per Hartree.\n", Cfluid);
+	}
 	
 	//Load history if available:
 	if(sp.historyFilename.length())
@@ -94,6 +131,15 @@ void SCF::minimize()
 	int eMinIterations = e.elecMinParams.nIterations;
 	std::vector<string> extraNames(1, "deigs");
 	std::vector<double> extraThresh(1, sp.eigDiffThreshold);
+	
+	//Switch to fixed-charge mode with the electron count mixed towards the target mu:
+	if(mixN)
+	{	std::swap(muTarget, e.eInfo.mu); //set ElecInfo::mu to NAN (fixed charge mode)
+		nElectronsOut = e.eInfo.nElectrons;
+		e.ener.E["minusMuN"] = -muTarget * e.eInfo.nElectrons;
+		extraNames.push_back("dmu");
+		extraThresh.push_back(e.elecMinParams.energyDiffThreshold);
+	}
 
 	//Single or multi Pulay loop depending on exact exchange:
 	if(e.exCorr.exxFactor())
@@ -101,7 +147,9 @@ void SCF::minimize()
 		double outerThreshold = sp.energyDiffThreshold;
 		if(outerThreshold <= 0.)
 			die("Convergence parameter energyDiffThreshold must be > 0 in exact exchange calculations.\n");
-		e.exx->prepareHamiltonian(e.exCorr.exxRange(), e.eVars.F, e.eVars.C); logPrintf("\n");
+		bool reuseACE = e.cntrl.aceReuse and e.exx->hasHamiltonian(e.exCorr.exxRange()); //start from previous ionic step's operator
+		if(reuseACE) logPrintf("Starting from ACE exchange operator of previous step.\n\n");
+		else { e.exx->prepareHamiltonian(e.exCorr.exxRange(), e.eVars.F, e.eVars.C); logPrintf("\n"); }
 		double Eprev = eVars.elecEnergyAndGrad(e.ener, 0, 0, true); mpiWorld->bcast(Eprev); //Initial energy
 		for(int iOuter=0; iOuter<e.cntrl.nOuterVxx; iOuter++)
 		{	Pulay<SCFvariable>::minimize(Eprev, extraNames, extraThresh); //Optimize using Pulay mixer
@@ -109,7 +157,7 @@ void SCF::minimize()
 			double dE = E - Eprev;
 			logPrintf("VxxLoop: Iter: %2i   %s: %+.15lf   d%s: %+.3e\n",
 				iOuter, sp.energyLabel, E, sp.energyLabel, dE);
-			if(fabs(dE) < outerThreshold) break;
+			if(fabs(dE) < outerThreshold and not (reuseACE and iOuter==0)) break; //always correct a reused operator at least once
 			//Update orbitals for next outer loop iteration:
 			e.exx->prepareHamiltonian(e.exCorr.exxRange(), e.eVars.F, e.eVars.C); logPrintf("\n");
 			Eprev = E;
@@ -130,6 +178,12 @@ void SCF::minimize()
 	
 	//Set auxiliary Hamiltonian equal to subspace Hamiltonian (used for fillings updates)
 	if(e.eInfo.fillingsUpdate == ElecInfo::FillingsHsub) eVars.Haux_eigs = eVars.Hsub_eigs;
+	
+	//Restore fixed-mu mode:
+	if(mixN)
+	{	std::swap(muTarget, e.eInfo.mu); //restore finite ElecInfo::mu
+		e.ener.E["minusMuN"] = 0.; e.ener.muN = e.eInfo.mu*e.eInfo.nElectrons; //restore normal storage of muN component
+	}
 }
 
 double SCF::sync(double x) const
@@ -151,12 +205,25 @@ double SCF::cycle(double dEprev, std::vector<double>& extraValues)
 	if(not sp.verbose) { logResume(); e.elecMinParams.fpLog = globalLog; }  // Resume output
 
 	//Compute new density and energy
+	if(e.eVars.fluidSolver) e.eVars.fluidSolver->electronicEnergyChange = fabs(dEprev); //loosens inner fluid solves far from convergence (if enabled)
 	e.ener.Eband = 0.; //only affects printing (if non-zero Energies::print assumes band structure calc)
 	if(e.eInfo.fillingsUpdate == ElecInfo::FillingsHsub) e.eVars.Haux_eigs = e.eVars.Hsub_eigs;
 	double E = e.eVars.elecEnergyAndGrad(e.ener); //updates fillings (if necessary), density and potential
 	mpiWorld->bcast(E); //ensure consistency to machine precision
 
 	extraValues[0] = eigDiffRMS(eigsPrev, e.eVars.Hsub_eigs);
+	
+	//Output electron count at target mu, and its preconditioner:
+	if(mixN)
+	{	const ElecInfo& eInfo = e.eInfo;
+		double Bz, mu = eInfo.findMu(e.eVars.Haux_eigs, eInfo.nElectrons, Bz);
+		nElectronsOut = eInfo.nElectronsCalc(muTarget, e.eVars.Haux_eigs, Bz);
+		//Bare (quantum) capacitance by finite difference, in series with the fluid capacitance:
+		double h = 0.5*eInfo.smearingWidth, BzPlus, BzMinus;
+		double Cq = (eInfo.nElectronsCalc(mu+h, e.eVars.Haux_eigs, BzPlus) - eInfo.nElectronsCalc(mu-h, e.eVars.Haux_eigs, BzMinus)) / (2*h);
+		nMix = std::isfinite(Cfluid) ? Cfluid/(std::max(Cq,1e-6) + Cfluid) : 1.;
+		extraValues[1] = fabs(mu - muTarget);
+	}
 	return E;
 }
 
@@ -166,6 +233,7 @@ void SCF::report(int iter)
 	if(e.cntrl.shouldPrintEcomponents) { logPrintf("\n"); e.ener.print(); logPrintf("\n"); }
 	logFlush();
 
+	fftPrecision.update();
 	e.dump(DumpFreq_Electronic, iter);
 	//--- write SCF history if dumping state:
 	if(e.dump.count(std::make_pair(DumpFreq_Electronic,DumpState)) && e.dump.checkInterval(DumpFreq_Electronic,iter))
@@ -192,6 +260,8 @@ void SCF::axpy(double alpha, const SCFvariable& X, SCFvariable& Y) const
 		for(size_t i=0; i<X.rhoAtom.size(); i++)
 			::axpy(alpha, X.rhoAtom[i], Y.rhoAtom[i]);
 	}
+	//Electron count:
+	if(mixN) Y.nElectrons += alpha * X.nElectrons;
 }
 
 double SCF::dot(const SCFvariable& X, const SCFvariable& Y) const
@@ -206,6 +276,9 @@ double SCF::dot(const SCFvariable& X, const SCFvariable& Y) const
 	{	for(size_t i=0; i<X.rhoAtom.size(); i++)
 			ret += dotc(X.rhoAtom[i],Y.rhoAtom[i]).real();
 	}
+	//Electron count:
+	if(mixN)
+		ret += X.nElectrons * Y.nElectrons / e.gInfo.detR; //as a uniform density change
 	return ret;
 }
 
@@ -216,6 +289,7 @@ size_t SCF::variableSize() const
 		e.iInfo.rhoAtom_initZero(rhoAtom);
 		for(const matrix& m: rhoAtom) nDoubles += 2*m.nData();
 	}
+	if(mixN) nDoubles++; //electron count
 	return nDoubles * sizeof(double);
 }
 
@@ -233,6 +307,9 @@ void SCF::readVariable(SCFvariable& v, FILE* fp) const
 	{	e.iInfo.rhoAtom_initZero(v.rhoAtom);
 		for(matrix& m: v.rhoAtom) m.read(fp);
 	}
+	//Electron count:
+	if(mixN && fread(&v.nElectrons, sizeof(double), 1, fp) != 1)
+		die("Error reading electron count from SCF history.\n");
 }
 
 void SCF::writeVariable(const SCFvariable& v, FILE* fp) const
@@ -246,6 +323,8 @@ void SCF::writeVariable(const SCFvariable& v, FILE* fp) const
 	if(e.eInfo.hasU)
 	{	for(const matrix& m: v.rhoAtom) m.write(fp);
 	}
+	//Electron count:
+	if(mixN) fwrite(&v.nElectrons, sizeof(double), 1, fp);
 }
 
 namespace Magnetization
@@ -293,6 +372,9 @@ SCFvariable SCF::getVariable() const
 	//Atomic density matrices:
 	if(e.eInfo.hasU)
 		v.rhoAtom = (mixDensity ? e.eVars.rhoAtom : e.eVars.U_rhoAtom);
+	//Electron count:
+	if(mixN)
+		v.nElectrons = nElectronsOut;
 	return v;
 }
 
@@ -306,6 +388,11 @@ void SCF::setVariable(const SCFvariable& v)
 	//Atomic density matrices:
 	if(e.eInfo.hasU)
 		(mixDensity ? e.eVars.rhoAtom : e.eVars.U_rhoAtom) = v.rhoAtom;
+	//Electron count:
+	if(mixN)
+	{	e.eInfo.nElectrons = nElectronsOut = v.nElectrons;
+		e.ener.E["minusMuN"] = -muTarget * v.nElectrons;
+	}
 	//Update precomputed quantities of one-particle Hamiltonian:
 	if(mixDensity) e.eVars.EdensityAndVscloc(e.ener); //Recompute Vscloc (Vtau) if mixing density
 	e.iInfo.augmentDensityGridGrad(e.eVars.Vscloc); //update Vscloc atom projections for ultrasoft psp's 
@@ -330,6 +417,9 @@ SCFvariable SCF::precondition(const SCFvariable& v) const
 		for(matrix& m: vOut.rhoAtom)
 			m *= e.scfParams.mixFraction;
 	}
+	//Electron count (optimal linear step from capacitance ratio, in place of Kerker which vanishes at G=0):
+	if(mixN)
+		vOut.nElectrons = nMix * v.nElectrons;
 	return vOut;
 }
 
@@ -343,6 +433,9 @@ SCFvariable SCF::applyMetric(const SCFvariable& v) const
 	//Atomic density matrices:
 	if(e.eInfo.hasU)
 		vOut.rhoAtom = v.rhoAtom;
+	//Electron count:
+	if(mixN)
+		vOut.nElectrons = nMetric * e.gInfo.detR * v.nElectrons; //dot() supplies the remaining 1/detR
 	return vOut;
 }
 
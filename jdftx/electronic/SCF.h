@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/Pulay.h>
 #include <core/ScalarFieldArray.h>
+#include <electronic/ElecMinimizer.h>
 
 //! @addtogroup ElecSystem
 //! @{
@@ -33,6 +34,9 @@ struct SCFvariable
 {	ScalarFieldArray n; //!< electron density (or potential)
 	ScalarFieldArray tau; //!< KE density (or potential) [mGGA only]
 	std::vector<matrix> rhoAtom; //!< atomic density matrices (or corresponding potential) [DFT+U only]
+	double nElectrons; //!< electron count [grand-canonical SCF only]
+	
+	SCFvariable() : nElectrons(0.) {}
 };
 
 //! @brief Self-Consistent Field method for converging electronic state
@@ -66,6 +70,15 @@ private:
 	bool mixTau; //!< whether KE needs to be mixed
 	RealKernel kerkerMix, diisMetric; //!< convolution kernels for kerker preconditioning and the DIIS overlap metric
 	
+	//Grand-canonical SCF (electron count mixed along with density at fixed mu):
+	bool mixN; //!< whether electron count is part of the mixed variable
+	double muTarget; //!< target chemical potential (ElecInfo::mu is set to NAN during the SCF)
+	double nElectronsOut; //!< electron count corresponding to the current state (output of cycle / input of setVariable)
+	double Cfluid; //!< electrostatic (double-layer) capacitance of the fluid
+	double nMix; //!< preconditioner for electron count: ratio of self-consistent to bare (quantum) capacitance
+	double nMetric; //!< weight of electron count in the DIIS overlap metric
+	FftPrecisionSwitch fftPrecision; //!< single to double precision FFT switching for this SCF
+	
 	double eigDiffRMS(const std::vector<diagMatrix>&, const std::vector<diagMatrix>&) const; //!< weighted RMS difference between two sets of eigenvalues
 };
 
@@ -42,9 +42,11 @@ struct SCFparams : public PulayParams
 	
 	double qKerker; //!< Wavevector controlling Kerker preconditioning
 	double qKappa; //!< wavevector controlling long-range damping (if negative, auto-set to zero or fluid Debye wave-vector as appropriate)
+	double epsResta; //!< if > 1, dielectric constant of Resta-model preconditioner (with Thomas-Fermi wavevector qKerker); Kerker otherwise
 	
 	bool verbose; //!< Whether the inner eigensolver will print progress
 	double mixFractionMag;  //!< Mixing fraction for magnetization density / potential
+	bool mixNelectrons; //!< In fixed-mu mode, mix the electron count along with the density (grand-canonical SCF)
 	
 	SCFparams()
 	{	nEigSteps = 2; //for Davidson; the default for CG is 40 (and set by the command)
@@ -52,8 +54,10 @@ struct SCFparams : public PulayParams
 		mixedVariable = MV_Density;
 		qKerker = 0.8;
 		qKappa = -1.;
+		epsResta = 0.;
 		verbose = false;
 		mixFractionMag = 1.5;
+		mixNelectrons = false;
 	}
 };
 
@@ -0,0 +1,116 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/SolvationBatch.h>
+#include <electronic/Everything.h>
+#include <electronic/ElecMinimizer.h>
+#include <electronic/Dump.h>
+#include <fluid/FluidSolver.h>
+#include <commands/command.h>
+#include <commands/parser.h>
+#include <core/Minimize.h>
+#include <core/Units.h>
+#include <set>
+
+SolvationBatch::SolvationBatch(const Everything& e, const std::vector<std::pair<string,string>>& commands)
+{	logPrintf("\n---------- Setting up solvation batch ----------\n");
+	const std::map<string,Command*>& cmap = getCommandMap();
+	for(const string& filename: e.eVars.solvationBatch)
+	{	//Read fluid commands of variant:
+		std::vector<std::pair<string,string>> commandsFluid = readInputFile(filename);
+		std::set<string> names;
+		for(const auto& cmd: commandsFluid)
+		{	auto iter = cmap.find(cmd.first);
+			if(iter==cmap.end() || iter->second->section.find("jdftx/Fluid")!=0 || cmd.first=="solvation-batch")
+				die("Solvation batch variant '%s' may only contain fluid commands (found '%s').\n\n", filename.c_str(), cmd.first.c_str());
+			names.insert(cmd.first);
+		}
+		//Replace same-named commands of the reference input:
+		std::vector<std::pair<string,string>> commandsVariant;
+		for(const auto& cmd: commands)
+			if(!names.count(cmd.first) && cmd.first!="solvation-batch")
+				commandsVariant.push_back(cmd);
+		commandsVariant.insert(commandsVariant.end(), commandsFluid.begin(), commandsFluid.end());
+		//Parse and retain the fluid parameters:
+		Variant variant;
+		variant.filename = filename;
+		{	Everything eVariant;
+			FILE* logSave = globalLog; globalLog = nullLog; //only the fluid commands are reported below
+			parse(commandsVariant, eVariant, false);
+			globalLog = logSave;
+			variant.fsp = eVariant.eVars.fluidParams;
+			variant.fluidMinParams = eVariant.fluidMinParams;
+		}
+		string basenameSave = inputBasename;
+		setInputBasename(filename);
+		variant.basename = basenameSave + "." + inputBasename;
+		inputBasename = basenameSave;
+		logPrintf("Variant '%s' (dumped with $INPUT = %s) replaces %d commands with:\n",
+			filename.c_str(), variant.basename.c_str(), int(names.size()));
+		for(const auto& cmd: commandsFluid)
+			logPrintf("\t%s %s\n", cmd.first.c_str(), cmd.second.c_str());
+		variants.push_back(variant);
+	}
+}
+
+//Linear fluid solver state that can seed the next variant, if any
+//(only when on the main grid, since a coarse fluid grid is owned by the solver)
+inline ScalarFieldTilde linearFluidState(const std::shared_ptr<FluidSolver>& fluidSolver)
+{	auto linearSolver = dynamic_cast<LinearSolvable<ScalarFieldTilde>*>(fluidSolver.get());
+	if(linearSolver && !fluidSolver->gInfoFluid) return linearSolver->state;
+	return ScalarFieldTilde();
+}
+
+void SolvationBatch::run(Everything& e)
+{	double Aref = relevantFreeEnergy(e);
+	const char* Aname = relevantFreeEnergyName(e);
+	std::vector<double> A(variants.size());
+	string basenameRef = inputBasename;
+	for(size_t iVariant=0; iVariant<variants.size(); iVariant++)
+	{	const Variant& variant = variants[iVariant];
+		logPrintf("\n---------- Solvation batch variant %d of %d: '%s' ----------\n",
+			int(iVariant+1), int(variants.size()), variant.filename.c_str());
+		ScalarFieldTilde statePrev = linearFluidState(e.eVars.fluidSolver);
+		e.resetFluid(variant.fsp, variant.fluidMinParams);
+		auto linearSolver = dynamic_cast<LinearSolvable<ScalarFieldTilde>*>(e.eVars.fluidSolver.get());
+		if(statePrev && linearFluidState(e.eVars.fluidSolver) && linearSolver)
+		{	logPrintf("Starting fluid from state of previous variant.\n");
+			linearSolver->state = statePrev;
+		}
+		statePrev = 0;
+		logFlush();
+		
+		elecFluidMinimize(e);
+		A[iVariant] = relevantFreeEnergy(e);
+		logPrintf("# Energy components:\n"); e.ener.print(); logPrintf("\n");
+		inputBasename = variant.basename;
+		e.dump(DumpFreq_End, 0);
+		inputBasename = basenameRef;
+	}
+	
+	//Summary:
+	logPrintf("\n# Solvation batch: %s of each variant and its change from reference state '%s':\n", Aname, basenameRef.c_str());
+	logPrintf("# %-30s %20s %14s %14s\n", "Variant", (string(Aname)+" [Eh]").c_str(), "Delta [Eh]", "Delta [kcal/mol]");
+	logPrintf("  %-30s %+20.12lf %+14.8lf %+14.4lf\n", basenameRef.c_str(), Aref, 0., 0.);
+	for(size_t iVariant=0; iVariant<variants.size(); iVariant++)
+	{	double dA = A[iVariant] - Aref;
+		logPrintf("  %-30s %+20.12lf %+14.8lf %+14.4lf\n", variants[iVariant].basename.c_str(), A[iVariant], dA, dA/(Kcal/mol));
+	}
+	logFlush();
+}
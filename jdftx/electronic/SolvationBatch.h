@@ -0,0 +1,58 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_SOLVATIONBATCH_H
+#define JDFTX_ELECTRONIC_SOLVATIONBATCH_H
+
+#include <fluid/FluidSolverParams.h>
+#include <core/MinimizeParams.h>
+
+class Everything;
+
+//! @addtogroup Fluid
+//! @{
+//! @file SolvationBatch.h Class SolvationBatch
+
+/** Solvation batch mode: after the calculation specified by the input file (the reference state),
+converge the same system in each of a list of fluid variants, without repeating setup.
+Each variant file contains only fluid commands, which replace the same-named commands of the input file.
+Each variant starts from the wavefunctions of the previous one, and from its fluid state
+when both are linear solvers (LinearPCM / SaLSA) on the same grid, so that only the
+electron-fluid coupling is re-converged.
+*/
+class SolvationBatch
+{
+public:
+	//! Parse the fluid variants listed in e.eVars.solvationBatch (e has been parsed but not setup)
+	SolvationBatch(const Everything& e, const std::vector<std::pair<string,string>>& commands);
+	void run(Everything& e); //!< Converge and dump each variant in turn starting from the current state of e, and report free energies relative to it
+	
+private:
+	//! Fluid variant of the reference calculation
+	struct Variant
+	{	string filename; //!< input file containing the fluid commands
+		string basename; //!< input basename used for dumps of this variant
+		FluidSolverParams fsp; //!< parsed fluid parameters
+		MinimizeParams fluidMinParams; //!< parsed fluid minimization parameters (whose defaults depend on fluid type)
+	};
+	std::vector<Variant> variants;
+};
+
+//! @}
+#endif // JDFTX_ELECTRONIC_SOLVATIONBATCH_H
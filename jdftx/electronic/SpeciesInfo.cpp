@@ -35,8 +35,14 @@ void SpeciesInfo::sync_atpos()
 {	if(!atpos.size()) return; //unused species
 	//Update managed version of atpos:
 	atposManaged = ManagedArray<vector3<>>(atpos); //it will get transferred to GPU if/when necessary
-	//Invalidate cached projectors:
-	cachedV.clear();
+	clearProjectorCache();
+	atomPhase.free(); //invalidate structure factor tables
+}
+
+void SpeciesInfo::clearProjectorCache()
+{	cachedV.clear();
+	cachedVr.clear();
+	cachedOpsiU.clear();
 }
 
 inline bool isParallel(vector3<> x, vector3<> y)
@@ -116,6 +122,7 @@ SpeciesInfo::SpeciesInfo()
 
 	nAug = 0;
 	E_nAug = 0;
+	VnlBatchNlm = 0;
 }
 
 SpeciesInfo::~SpeciesInfo()
@@ -141,16 +148,39 @@ void SpeciesInfo::setup(const Everything &everything)
 {	e = &everything;
 	if(!atpos.size()) return; //unused species
 	
-	//Read pseudopotential
-	ifstream ifs;
+	//Read pseudopotential (contents read once on head and broadcast, rather than by every process):
+	static std::map<string, std::pair<string,std::string>> potCache; //full filename and contents by potfilename, reused by subsequent calculations in this process (eg. ensemble runs)
 	const std::vector<string>& prefixes = getPseudopotentialPrefixes();
 	string potfilenameFull; //full filename with prefix (if any)
-	for(const string& prefix: prefixes)
-	{	potfilenameFull = prefix + potfilename;
-		ifs.open(potfilenameFull.c_str());
-		if(ifs.is_open()) break;
+	std::string potContents; //raw contents (std::string, since the USPP format is binary)
+	auto cached = potCache.find(potfilename);
+	if(cached != potCache.end()) //all processes of mpiWorld have run the same calculations, so caches are consistent
+	{	potfilenameFull = cached->second.first;
+		potContents = cached->second.second;
 	}
-	if(!ifs.is_open()) die("Can't open pseudopotential file '%s' for reading.\n", potfilename.c_str());
+	else
+	{	bool potFound = false;
+		if(mpiWorld->isHead())
+		{	for(const string& prefix: prefixes)
+			{	potfilenameFull = prefix + potfilename;
+				std::ifstream ifsFile(potfilenameFull.c_str(), std::ios::binary);
+				if(ifsFile.is_open())
+				{	potContents.assign(std::istreambuf_iterator<char>(ifsFile), std::istreambuf_iterator<char>());
+					potFound = true;
+					break;
+				}
+			}
+		}
+		mpiWorld->bcast(potFound);
+		if(!potFound) die("Can't open pseudopotential file '%s' for reading.\n", potfilename.c_str());
+		mpiWorld->bcast(potfilenameFull);
+		size_t potLength = potContents.length();
+		mpiWorld->bcast(potLength);
+		potContents.resize(potLength);
+		mpiWorld->bcast(&potContents[0], potLength);
+		potCache[potfilename] = std::make_pair(potfilenameFull, potContents);
+	}
+	std::istringstream ifs(potContents);
 	logPrintf("\nReading pseudopotential file '%s':\n",potfilenameFull.c_str());
 	switch(pspFormat)
 	{	case Fhi: readFhi(ifs); break;
@@ -254,6 +284,7 @@ void SpeciesInfo::setup(const Everything &everything)
 	sync_atpos();
 	
 	Rprev = e->gInfo.R; //remember initial lattice vectors, so that updateLatticeDependent can check if an update is necessary
+	nGridLocRadial = int(ceil(e->gInfo.GmaxGrid/e->gInfo.dGradial))+5; //extent of the local radial functions, as initialized by the pseudopotential readers
 }
 
 
@@ -391,33 +422,53 @@ void SpeciesInfo::updateLatticeDependent()
 	bool Rchanged = (Rprev != gInfo.R);
 	Rprev = gInfo.R;
 
-	//Change radial function extents if R has changed:
 	if(Rchanged)
-	{	int nGridLoc = int(ceil(gInfo.GmaxGrid/gInfo.dGradial))+5;
-		VlocRadial.updateGmax(0, nGridLoc);
-		nCoreRadial.updateGmax(0, nGridLoc);
-		tauCoreRadial.updateGmax(0, nGridLoc);
-		for(auto& Qijl: Qradial) Qijl.second.updateGmax(Qijl.first.l, nGridLoc);
+	{	//Extend radial function tables only if the density-grid Gmax now exceeds their range.
+		//When they do need regeneration, widen them to cover the allowed strain window (as for GmaxSphere),
+		//so that subsequent lattice steps of a variable-cell relaxation reuse the tables as is:
+		int nGridLoc = int(ceil(gInfo.GmaxGrid/gInfo.dGradial))+5;
+		if(nGridLoc > nGridLocRadial)
+		{	nGridLocRadial = int(ceil(gInfo.GmaxGrid*(1.+GridInfo::maxAllowedStrain)/gInfo.dGradial))+5;
+			VlocRadial.updateGmax(0, nGridLocRadial);
+			nCoreRadial.updateGmax(0, nGridLocRadial);
+			tauCoreRadial.updateGmax(0, nGridLocRadial);
+			//Augmentation channels together (sharing Bessel function evaluations):
+			std::vector<const RadialFunctionR*> Qfuncs; std::vector<int> Ql; std::vector<RadialFunctionG*> Qtargets;
+			for(auto& Qijl: Qradial)
+				if(Qijl.second.rFunc && Qijl.second.nCoeff < nGridLocRadial+4)
+				{	Qfuncs.push_back(Qijl.second.rFunc);
+					Ql.push_back(Qijl.first.l);
+					Qtargets.push_back(&Qijl.second);
+				}
+			if(Qfuncs.size()) RadialFunctionR::transform(Qfuncs, Ql, 1./Qtargets[0]->dGinv, nGridLocRadial, Qtargets);
+			QradialMat = matrix(); //packed copy of Qradial is now stale
+		}
 		cachedV.clear(); //clear any cached projectors
+		cachedVr.clear();
+		cachedOpsiU.clear();
 	}
 	
-	//Update Qradial indices, matrix and nagIndex if not previously init'd, or if R has changed:
-	if(Qint.size() && (Rchanged || !QradialMat))
+	if(Qint.size())
 	{	int nCoeffHlf = (Qradial.cbegin()->second.nCoeff+1)/2; //pack real radial functions into complex numbers
 		int nCoeff = 2*nCoeffHlf;
-		//Qradial:
-		QradialMat = zeroes(nCoeffHlf, Qradial.size());
-		double* QradialMatData = (double*)QradialMat.dataPref();
-		int index=0;
-		for(auto& Qijl: Qradial)
-		{	((QijIndex&)Qijl.first).index = index;
-			callPref(eblas_copy)(QradialMatData+index*nCoeff, Qijl.second.coeffPref(), Qijl.second.nCoeff);
-			index++;
+		//Qradial indices and matrix, only if not previously init'd or if the tables were regenerated:
+		if(!QradialMat)
+		{	QradialMat = zeroes(nCoeffHlf, Qradial.size());
+			double* QradialMatData = (double*)QradialMat.dataPref();
+			int index=0;
+			for(auto& Qijl: Qradial)
+			{	((QijIndex&)Qijl.first).index = index;
+				callPref(eblas_copy)(QradialMatData+index*nCoeff, Qijl.second.coeffPref(), Qijl.second.nCoeff);
+				index++;
+			}
+			setAugCoupling();
+		}
+		//nagIndex depends on the G-vector lengths, and so must be redone whenever R changes:
+		if(Rchanged || !nagIndexPtr.nData() || int(nagIndexPtr.nData()) != nCoeff+1)
+		{	nagIndex.init(gInfo.iGstop-gInfo.iGstart);
+			nagIndexPtr.init(nCoeff+1);
+			setNagIndex(gInfo.S, gInfo.G, gInfo.iGstart, gInfo.iGstop, nCoeff, 1./gInfo.dGradial, nagIndex.data(), nagIndexPtr.data());
 		}
-		//nagIndex:
-		nagIndex.init(gInfo.iGstop-gInfo.iGstart);
-		nagIndexPtr.init(nCoeff+1);
-		setNagIndex(gInfo.S, gInfo.G, gInfo.iGstart, gInfo.iGstop, nCoeff, 1./gInfo.dGradial, nagIndex.data(), nagIndexPtr.data());
 	}
 }
 
@@ -483,9 +534,11 @@ void SpeciesInfo::setPsi(std::vector<std::vector<RadialFunctionR> >& psiArr)
 	{	int nPsi_l = psiArr[l].size();
 		psiRadial[l].resize(nPsi_l);
 		OpsiRadial[l].resize(nPsi_l);
+		std::vector<RadialFunctionR> OpsiArr(nPsi_l);
+		std::vector<const RadialFunctionR*> rFuncs; std::vector<RadialFunctionG*> funcs; //to transform together below
 		for(int n=0; n<nPsi_l; n++)
 		{	RadialFunctionR& psi = psiArr[l][n];
-			RadialFunctionR Opsi = psi;
+			RadialFunctionR& Opsi = OpsiArr[n]; Opsi = psi;
 			//Apply augmentation to Opsi if needed:
 			if(Qint.size() && l<int(VnlRadial.size()))
 			{	std::vector<double> VdagPsi(VnlRadial[l].size());
@@ -505,10 +558,11 @@ void SpeciesInfo::setPsi(std::vector<std::vector<RadialFunctionR> >& psiArr)
 			double normFacPsi = normFacOpsi / e->gInfo.detR; //this makes psi^Opsi = 1 on the grid
 			for(double& f: psi.f) f *= normFacPsi;
 			for(double& f: Opsi.f) f *= normFacOpsi;
-			//Transform to reciprocal space:
-			psi.transform(l, dG, nGridNL, psiRadial[l][n]);
-			Opsi.transform(l, dG, nGridNL, OpsiRadial[l][n]);
+			rFuncs.push_back(&psi); funcs.push_back(&psiRadial[l][n]);
+			rFuncs.push_back(&Opsi); funcs.push_back(&OpsiRadial[l][n]);
 		}
+		//Transform to reciprocal space:
+		RadialFunctionR::transform(rFuncs, std::vector<int>(rFuncs.size(), l), dG, nGridNL, funcs);
 	}
 }
 
@@ -100,6 +100,25 @@ void nAugment_gpu(int Nlm, const vector3<int> S, const matrix3<>& G, int iGstart
 	SwitchTemplate_Nlm(Nlm, nAugment_gpu, (S, G, iGstart, iGstop, nCoeff, dGinv, nRadial, atpos, n) )
 }
 
+template<int Nlm> __global__ void nAugmentBatch_kernel(int zBlock, const vector3<int> S, const matrix3<> G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{	COMPUTE_halfGindices
+	if(i<iGstart || i>=iGstop) return;
+	nAugmentBatch_calc<Nlm>(i, iG, S, G, nCoeff, dGinv, nRadial, nAtoms, atomPhase, n);
+}
+template<int Nlm> void nAugmentBatch_gpu(const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{	GpuLaunchConfigHalf3D glc(nAugmentBatch_kernel<Nlm>, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		nAugmentBatch_kernel<Nlm><<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, G, iGstart, iGstop, nCoeff, dGinv, nRadial, nAtoms, atomPhase, n);
+	gpuErrorCheck();
+}
+void nAugmentBatch_gpu(int Nlm, const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{
+	SwitchTemplate_Nlm(Nlm, nAugmentBatch_gpu, (S, G, iGstart, iGstop, nCoeff, dGinv, nRadial, nAtoms, atomPhase, n) )
+}
+
 
 //Propagate gradients corresponding to above electron density augmentation
 template<int Nlm> __global__ void nAugmentGrad_kernel(const vector3<int> S, const matrix3<> G,
@@ -136,7 +155,7 @@ template<int Nlm> void nAugmentGrad_gpu(const vector3<int> S, const matrix3<>& G
 	//Allocate temporary memory:
 	int iDevice; cudaGetDevice(&iDevice);
 	cudaDeviceProp prop; cudaGetDeviceProperties(&prop, iDevice);
-	cudaFuncAttributes attr; cudaFuncGetAttributes(&attr, nAugmentGrad_kernel<Nlm>);
+	cudaFuncAttributes attr; cudaFuncGetAttributes(&attr, (const void*)nAugmentGrad_kernel<Nlm>);
 	int sharedMemPerThread = 6 * sizeof(double);
 	int nPerBlock = std::min(prop.warpSize, std::min(attr.maxThreadsPerBlock, int(prop.sharedMemPerBlock/sharedMemPerThread)));
 	int nBlocks = nCoeff;
@@ -50,6 +50,7 @@ public:
 	std::vector<vector3<> > velocities; //!< array of atomic velocities (NAN unless running MD) in lattice coordinates
 	ManagedArray<vector3<>> atposManaged; //!< managed copy of atpos accessed from operator code (for auto cpu/gpu transfers)
 	void sync_atpos(); //!< update changes in atpos; call whenever atpos is changed (this will update atposManaged and invalidate cached projectors, if any)
+	void clearProjectorCache(); //!< invalidate cached projectors (called by sync_atpos, and when the wavefunction bases change)
 	
 	double dE_dnG; //!< Derivative of [total energy per atom] w.r.t [nPlanewaves per unit volume] (for Pulay corrections)
 	double mass; //!< ionic mass (currently unused)	
@@ -93,6 +94,13 @@ public:
 	//! If derivDir is non-null, return the derivative with respct to Cartesian k direction *derivDir instead (never cached).
 	//! If stressDir is >=0, then calculate (i,j) component of dVnl/dR . RT where stressDir = 3*i+j
 	std::shared_ptr<ColumnBundle> getV(const ColumnBundle& Cq, const vector3<>* derivDir=0, const int stressDir=-1) const;
+	//! Nonlocal projectors of all atoms at one k-point, truncated to spheres of radius Control::realSpaceProjectorRadius on the wavefunction grid
+	struct RealSpaceProjector
+	{	std::vector<std::vector<int>> index; //!< grid point indices within the sphere, for each atom
+		std::vector<matrix> V; //!< projector values at those points (nPoints x nProj, periodic part as from I), for each atom
+	};
+	std::shared_ptr<RealSpaceProjector> getVr(const ColumnBundle& Cq) const; //!< Get real-space projectors with qnum and basis matching Cq (cached along with getV)
+	void releaseProjectors(const ColumnBundle& Cq) const; //!< Remove cached projectors (both kinds) with qnum and basis matching Cq (when that state will not be needed again)
 	int nProjectors() const { return MnlAll.nRows() * atpos.size(); } //!< total number of projectors for all atoms in this species (number of columns in result of getV)
 	
 	//! Return non-local energy for this species and quantum number q and optionally accumulate
@@ -121,9 +129,12 @@ public:
 	//The rhoAtom pointers point to the start of those relevant to this species (and ends at that pointer + rhoAtom_nMatrices())
 	size_t rhoAtom_nMatrices() const;
 	void rhoAtom_initZero(matrix* rhoAtomPtr) const;
-	void rhoAtom_calc(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, matrix* rhoAtomPtr) const;
+	//The projections OpsiDagC are rows of rhoAtom_getOpsi(C[q]) ^ C[q] (computed by IonInfo for all species together)
+	int rhoAtom_nOrbitals() const; //!< number of columns in rhoAtom_getOpsi() (Hubbard orbitals of all Uparams and atoms)
+	std::shared_ptr<ColumnBundle> rhoAtom_getOpsi(const ColumnBundle& Cq) const; //!< Hubbard orbitals with O applied, with basis matching Cq (cached along with getV)
+	void rhoAtom_calc(const std::vector<diagMatrix>& F, const std::vector<matrix>& OpsiDagC, matrix* rhoAtomPtr) const;
 	double rhoAtom_computeU(const matrix* rhoAtomPtr, matrix* U_rhoAtomPtr) const;
-	void rhoAtom_grad(const ColumnBundle& Cq, const matrix* U_rhoAtomPtr, ColumnBundle& HCq) const;
+	matrix rhoAtom_grad(const QuantumNumber& qnum, const matrix* U_rhoAtomPtr, const matrix& OpsiDagCq) const; //!< coefficients of rhoAtom_getOpsi() in the wavefunction gradient
 	void rhoAtom_forces(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, const matrix* U_rhoAtomPtr, std::vector<vector3<> >& forces, matrix3<>* EU_RRT) const;
 	void rhoAtom_getV(const ColumnBundle& Cq, const matrix* U_rhoAtomPtr, ColumnBundle& Opsi, matrix& M,
 		const vector3<>* derivDir=0, const int stressDir=-1) const; //get DFT+U Hamiltonian in the same format as the nonlocal pseudopotential (psi = atomic orbitals, M = matrix in that order)
@@ -163,6 +174,7 @@ public:
 	static matrix getYlmOverlapMatrix(int l, int j2); //!< Get the ((2l+1)*2)x((2l+1)*2) overlap matrix of the spin-spherical harmonics for total angular momentum j (note j2=2*j)
 private:
 	matrix3<> Rprev; void updateLatticeDependent(); //!< If Rprev differs from gInfo.R, update the lattice dependent quantities (such as the radial functions)
+	int nGridLocRadial; //!< number of samples currently available in the local radial functions (extended lazily by updateLatticeDependent)
 
 	RadialFunctionG VlocRadial; //!< local pseudopotential
 	RadialFunctionG nCoreRadial; //!< core density for partial core correction
@@ -175,7 +187,18 @@ private:
 	std::vector<matrix> Qint; //!< overlap augmentation matrix (indexed by l, empty if no augmentation)
 	matrix QintAll; //!< block matrix containing Qint for all l,m 
 	
-	std::map<std::pair<vector3<>,const Basis*>, std::shared_ptr<ColumnBundle> > cachedV; //cached projectors (identified by k-point and basis pointer)
+	struct CachedProjector
+	{	std::shared_ptr<ColumnBundle> V;
+		mutable unsigned long lastUse; //value of useCounter at last access (for least-recently-used eviction)
+	};
+	typedef std::pair<vector3<>,const void*> CacheKey; //k-point and Basis::id(), shared eg. by both spin channels at the same k
+	static CacheKey cacheKey(const ColumnBundle& Cq);
+	std::map<CacheKey, CachedProjector> cachedV; //cached projectors (identified by k-point and basis G-vector set)
+	static unsigned long useCounter; //global access counter for cachedV of all species
+	void trimProjectorCache() const; //evict least-recently-used projectors of all species until within Control::projectorCacheMB
+
+	std::map<CacheKey, std::shared_ptr<RealSpaceProjector> > cachedVr; //cached real-space projectors (same keys as cachedV)
+	std::map<CacheKey, std::shared_ptr<ColumnBundle> > cachedOpsiU; //cached Hubbard orbitals for DFT+U (same keys as cachedV)
 	
 	struct QijIndex
 	{	int l1, p1; //!< Angular momentum and projector index for channel i
@@ -191,6 +214,22 @@ private:
 	matrix nAug; //!< intermediate electron density augmentation in the basis of Qradial functions (Flat array indexed by spin, atom number and then Qradial index)
 	matrix E_nAug; //!< Gradient w.r.t nAug (same layout)
 	ManagedArray<uint64_t> nagIndex; ManagedArray<size_t> nagIndexPtr; //!< grid indices arranged by |G|, used for coordinating scattered accumulate in nAugmentGrad(_gpu)
+	ManagedArray<complex> atomPhase; //!< per-atom 1D structure-factor phase tables for batched augmentation, projectors and local terms (see initAtomPhase; reset by sync_atpos)
+	const ManagedArray<complex>& getAtomPhase() const; //!< get atomPhase, computing it if necessary (once per ionic step)
+	ManagedArray<double> VnlCoeff; //!< spline coefficients of all VnlRadial packed together for fused projector construction (VnlBatch), if compatible
+	IndexArray VnlProjIndex; //!< lm and VnlCoeff radial index of each projector for VnlBatch
+	int VnlBatchNlm; //!< Nlm for VnlBatch (0 if not yet initialized, -1 if not supported for this species)
+	bool initVnlBatch() const; //!< initialize the above if necessary and return whether VnlBatch can be used
+	//! One term of the expansion of projector pair (i1,i2) density matrix elements in the Qradial spherical functions
+	struct AugCoupling
+	{	int i1, i2; //!< projector indices (i2 <= i1; the rest follow by symmetry)
+		int qIndex; //!< index of radial function in Qradial
+		int lm; //!< spherical harmonic index l*(l+1)+m
+		double coeff; //!< Ylm product expansion coefficient
+		complex phase; //!< i^(l2-l1)
+	};
+	std::vector<AugCoupling> augCoupling; //!< flattened list of all projector pair to spherical function terms (set along with Qradial indices)
+	void setAugCoupling(); //!< initialize augCoupling
 
 	std::vector<std::vector<RadialFunctionG> > psiRadial; //!< radial part of the atomic orbitals (outer index l, inner index shell)
 	std::vector<std::vector<RadialFunctionG> > OpsiRadial; //!< O(psiRadial): includes Q contributions for ultrasoft pseudopotentials
@@ -134,33 +134,13 @@ void SpeciesInfo::augmentDensitySpherical(const QuantumNumber& qnum, const diagM
 		else std::swap(Rho[qnum.index()], RhoAll); //in this case each qnum contributes to a specific spin component
 		
 		//Calculate spherical function contributions from density matrix:
+		double prefac = qnum.weight / gInfo.detR;
 		for(size_t s=0; s<Rho.size(); s++) if(Rho[s])
 		{	int atomOffs = Nlm*(atom + s*atpos.size());
-			//Triple loop over first projector:
-			int i1 = 0;
-			for(int l1=0; l1<int(VnlRadial.size()); l1++)
-			for(int p1=0; p1<int(VnlRadial[l1].size()); p1++)
-			for(int m1=-l1; m1<=l1; m1++)
-			{	//Triple loop over second projector:
-				int i2 = 0;
-				for(int l2=0; l2<int(VnlRadial.size()); l2++)
-				for(int p2=0; p2<int(VnlRadial[l2].size()); p2++)
-				for(int m2=-l2; m2<=l2; m2++)
-				{	if(i2<=i1) //rest handled by i1<->i2 symmetry
-					{	std::vector<YlmProdTerm> terms = expandYlmProd(l1,m1, l2,m2);
-						double prefac = qnum.weight * ((i1==i2 ? 1 : 2)/gInfo.detR)
-									* (Rho[s].data()[Rho[s].index(i2,i1)] * cis(0.5*M_PI*(l2-l1))).real();
-						for(const YlmProdTerm& term: terms)
-						{	QijIndex qIndex = { l1, p1, l2, p2, term.l };
-							auto Qijl = Qradial.find(qIndex);
-							if(Qijl==Qradial.end()) continue; //no entry at this l
-							nAugData[nAug.index(Qijl->first.index, atomOffs + term.l*(term.l+1) + term.m)] += term.coeff * prefac;
-						}
-					}
-					i2++;
-				}
-				i1++;
-			}
+			const complex* RhoData = Rho[s].data();
+			for(const AugCoupling& c: augCoupling)
+				nAugData[nAug.index(c.qIndex, atomOffs + c.lm)] += (c.i1==c.i2 ? prefac : 2*prefac) * c.coeff
+					* (RhoData[Rho[s].index(c.i2,c.i1)] * c.phase).real();
 		}
 	}
 	watch.stop();
@@ -176,10 +156,8 @@ void SpeciesInfo::augmentDensityGrid(ScalarFieldArray& n) const
 	double* nAugRadialData = (double*)nAugRadial.dataPref();
 	for(unsigned s=0; s<n.size(); s++)
 	{	ScalarFieldTilde nAugTilde; nullToZero(nAugTilde, gInfo);
-		for(unsigned atom=0; atom<atpos.size(); atom++)
-		{	int atomOffs = nCoeff * Nlm * (atom + atpos.size()*s);
-			callPref(nAugment)(Nlm, gInfo.S, gInfo.G, gInfo.iGstart, gInfo.iGstop, nCoeff, dGinv, nAugRadialData+atomOffs, atpos[atom], nAugTilde->dataPref());
-		}
+		callPref(nAugmentBatch)(Nlm, gInfo.S, gInfo.G, gInfo.iGstart, gInfo.iGstop, nCoeff, dGinv,
+			nAugRadialData + nCoeff*Nlm*atpos.size()*s, atpos.size(), getAtomPhase().dataPref(), nAugTilde->dataPref());
 		n[s] += I(nAugTilde);
 	}
 	watch.stop();
@@ -201,8 +179,14 @@ void SpeciesInfo::augmentDensityGridGrad(const ScalarFieldArray& E_n, std::vecto
 	}
 	VectorFieldTilde E_atpos; if(forces) nullToZero(E_atpos, gInfo);
 	ScalarFieldTildeArray E_RRT(6); if(Eaug_RRT) nullToZero(E_RRT, gInfo);
+	bool batched = !(forces || Eaug_RRT || isGpuEnabled()); //batched version only for the radial-function gradient (SCF), and on CPUs
 	for(unsigned s=0; s<E_n.size(); s++)
 	{	ScalarFieldTilde ccE_n = Idag(E_n[s]);
+		if(batched)
+		{	nAugmentGradBatch(Nlm, gInfo.S, gInfo.G, nCoeff, dGinv, atpos.size(), getAtomPhase().data(), ccE_n->data(),
+				E_nAugRadialData + nCoeff*Nlm*atpos.size()*s, nagIndex.data(), nagIndexPtr.data());
+			continue;
+		}
 		for(unsigned atom=0; atom<atpos.size(); atom++)
 		{	int atomOffs = nCoeff * Nlm * (atom + atpos.size()*s);
 			if(forces) initZero(E_atpos);
@@ -247,32 +231,11 @@ void SpeciesInfo::augmentDensitySphericalGrad(const QuantumNumber& qnum, const m
 		//Propagate gradients from spherical functions to density matrix:
 		for(size_t s=0; s<E_Rho.size(); s++) if(E_Rho[s])
 		{	int atomOffs = Nlm*(atom + s*atpos.size());
-			//Triple loop over first projector:
-			int i1 = 0;
-			for(int l1=0; l1<int(VnlRadial.size()); l1++)
-			for(int p1=0; p1<int(VnlRadial[l1].size()); p1++)
-			for(int m1=-l1; m1<=l1; m1++)
-			{	//Triple loop over second projector:
-				int i2 = 0;
-				for(int l2=0; l2<int(VnlRadial.size()); l2++)
-				for(int p2=0; p2<int(VnlRadial[l2].size()); p2++)
-				for(int m2=-l2; m2<=l2; m2++)
-				{	if(i2<=i1) //rest handled by i1<->i2 symmetry 
-					{	std::vector<YlmProdTerm> terms = expandYlmProd(l1,m1, l2,m2);
-						double E_Rho_i1i2sum = 0.;
-						for(const YlmProdTerm& term: terms)
-						{	QijIndex qIndex = { l1, p1, l2, p2, term.l };
-							auto Qijl = Qradial.find(qIndex);
-							if(Qijl==Qradial.end()) continue; //no entry at this l
-							E_Rho_i1i2sum += term.coeff * E_nAugData[E_nAug.index(Qijl->first.index, atomOffs + term.l*(term.l+1) + term.m)].real();
-						}
-						complex E_Rho_i1i2 = E_Rho_i1i2sum * (1./gInfo.detR) * cis(0.5*M_PI*(l2-l1));
-						E_Rho[s].data()[E_Rho[s].index(i2,i1)] += E_Rho_i1i2.conj();
-						if(i1!=i2) E_Rho[s].data()[E_Rho[s].index(i1,i2)] += E_Rho_i1i2;
-					}
-					i2++;
-				}
-				i1++;
+			complex* E_RhoData = E_Rho[s].data();
+			for(const AugCoupling& c: augCoupling)
+			{	complex E_Rho_i1i2 = (c.coeff * (1./gInfo.detR) * E_nAugData[E_nAug.index(c.qIndex, atomOffs + c.lm)].real()) * c.phase;
+				E_RhoData[E_Rho[s].index(c.i2,c.i1)] += E_Rho_i1i2.conj();
+				if(c.i1!=c.i2) E_RhoData[E_Rho[s].index(c.i1,c.i2)] += E_Rho_i1i2;
 			}
 		}
 		
@@ -300,6 +263,44 @@ void SpeciesInfo::augmentDensitySphericalGrad(const QuantumNumber& qnum, const m
 }
 
 
+const ManagedArray<complex>& SpeciesInfo::getAtomPhase() const
+{	if(!atomPhase.nData())
+	{	const GridInfo& gInfo = e->gInfo;
+		ManagedArray<complex>& phase = ((SpeciesInfo*)this)->atomPhase;
+		phase.init(atpos.size() * (gInfo.S[0]+gInfo.S[1]+gInfo.S[2]));
+		initAtomPhase(gInfo.S, atpos.size(), atpos.data(), phase.data());
+	}
+	return atomPhase;
+}
+
+void SpeciesInfo::setAugCoupling()
+{	augCoupling.clear();
+	//Triple loop over first projector:
+	int i1 = 0;
+	for(int l1=0; l1<int(VnlRadial.size()); l1++)
+	for(int p1=0; p1<int(VnlRadial[l1].size()); p1++)
+	for(int m1=-l1; m1<=l1; m1++)
+	{	//Triple loop over second projector:
+		int i2 = 0;
+		for(int l2=0; l2<int(VnlRadial.size()); l2++)
+		for(int p2=0; p2<int(VnlRadial[l2].size()); p2++)
+		for(int m2=-l2; m2<=l2; m2++)
+		{	if(i2<=i1) //rest handled by i1<->i2 symmetry
+			{	for(const YlmProdTerm& term: expandYlmProd(l1,m1, l2,m2))
+				{	QijIndex qIndex = { l1, p1, l2, p2, term.l };
+					auto Qijl = Qradial.find(qIndex);
+					if(Qijl==Qradial.end()) continue; //no entry at this l
+					AugCoupling c = { i1, i2, Qijl->first.index, term.l*(term.l+1) + term.m, term.coeff, cis(0.5*M_PI*(l2-l1)) };
+					augCoupling.push_back(c);
+				}
+			}
+			i2++;
+		}
+		i1++;
+	}
+}
+
+
 bool SpeciesInfo::QijIndex::operator<(const SpeciesInfo::QijIndex& other) const
 {	//Bring both indices to the upper triangular part:
 	QijIndex q1 = *this; q1.sortIndices();
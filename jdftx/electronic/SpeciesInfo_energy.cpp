@@ -71,20 +71,44 @@ void SpeciesInfo::rhoAtom_initZero(matrix* rhoAtomPtr) const
 	)
 }
 
-void SpeciesInfo::rhoAtom_calc(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, matrix* rhoAtomPtr) const
+int SpeciesInfo::rhoAtom_nOrbitals() const
+{	int spinorLength = e->eInfo.spinorLength();
+	int matSizeTot = 0; UparamLOOP( matSizeTot += orbCount * atpos.size(); )
+	return matSizeTot;
+}
+
+std::shared_ptr<ColumnBundle> SpeciesInfo::rhoAtom_getOpsi(const ColumnBundle& Cq) const
+{	int matSizeTot = rhoAtom_nOrbitals();
+	if(!matSizeTot) return 0;
+	CacheKey key = cacheKey(Cq);
+	auto iter = cachedOpsiU.find(key);
+	if(iter != cachedOpsiU.end()) return iter->second; //found in cache
+	//Compute in the order of rhoAtom_getV:
+	int spinorLength = e->eInfo.spinorLength();
+	std::shared_ptr<ColumnBundle> Opsi = std::make_shared<ColumnBundle>(Cq.similar(matSizeTot));
+	int matSizePrev = 0;
+	UparamLOOP
+	(	setAtomicOrbitals(*Opsi, true, Uparams.n, Uparams.l, matSizePrev);
+		matSizePrev += orbCount * atpos.size();
+	)
+	if(e->cntrl.cacheProjectors) ((SpeciesInfo*)this)->cachedOpsiU[key] = Opsi;
+	return Opsi;
+}
+
+void SpeciesInfo::rhoAtom_calc(const std::vector<diagMatrix>& F, const std::vector<matrix>& OpsiDagC, matrix* rhoAtomPtr) const
 {	static StopWatch watch("rhoAtom_calc"); watch.start();
 	rhoAtom_COMMONinit
+	int matSizePrev = 0;
 	UparamLOOP
 	(	int matSize = orbCount * atpos.size();
 		std::vector<matrix> rho(nSpins);
 		for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
 		{	const QuantumNumber& qnum = e->eInfo.qnums[q];
 			int s = qnum.index();
-			ColumnBundle Opsi(C[q].similar(matSize));
-			setAtomicOrbitals(Opsi, true, Uparams.n, Uparams.l);
-			matrix psiOCdag = Opsi ^ C[q];
+			matrix psiOCdag = OpsiDagC[q](matSizePrev,matSizePrev+matSize, 0,OpsiDagC[q].nCols());
 			rho[s] += (qnum.weight/e->eInfo.spinWeight) * psiOCdag * F[q] * dagger(psiOCdag);
 		}
+		matSizePrev += matSize;
 		for(int s=0; s<nSpins; s++)
 		{	//Collect contributions from all processes:
 			if(!rho[s]) rho[s] = zeroes(matSize, matSize);
@@ -125,17 +149,18 @@ double SpeciesInfo::rhoAtom_computeU(const matrix* rhoAtomPtr, matrix* U_rhoAtom
 			U_rho[s].set(a*orbCount,(a+1)*orbCount, a*orbCount,(a+1)*orbCount, *(U_rhoAtomPtr++)); \
 	}
 
-void SpeciesInfo::rhoAtom_grad(const ColumnBundle& Cq, const matrix* U_rhoAtomPtr, ColumnBundle& HCq) const
-{	static StopWatch watch("rhoAtom_grad"); watch.start();
-	rhoAtom_COMMONinit
+matrix SpeciesInfo::rhoAtom_grad(const QuantumNumber& qnum, const matrix* U_rhoAtomPtr, const matrix& OpsiDagCq) const
+{	rhoAtom_COMMONinit
+	int s = qnum.index();
+	matrix result(OpsiDagCq.nRows(), OpsiDagCq.nCols());
+	int matSizePrev = 0;
 	UparamLOOP
 	(	U_rho_PACK
-		int s = Cq.qnum->index();
-		ColumnBundle Opsi(Cq.similar(matSize));
-		setAtomicOrbitals(Opsi, true, Uparams.n, Uparams.l);
-		HCq += (1./e->eInfo.spinWeight) * Opsi * (U_rho[s] * (Opsi ^ Cq)); //gradient upto state weight and fillings
+		result.set(matSizePrev,matSizePrev+matSize, 0,OpsiDagCq.nCols(), (1./e->eInfo.spinWeight) //gradient upto state weight and fillings
+			* (U_rho[s] * OpsiDagCq(matSizePrev,matSizePrev+matSize, 0,OpsiDagCq.nCols())));
+		matSizePrev += matSize;
 	)
-	watch.stop();
+	return result;
 }
 
 //Symmetric matrix indexing used for stress calculations
@@ -144,13 +169,13 @@ static const int RRTindex[6][2] = {{0,0}, {1,1}, {2,2}, {1,2}, {2,0}, {0,1}};
 void SpeciesInfo::rhoAtom_forces(const std::vector<diagMatrix>& F, const std::vector<ColumnBundle>& C, const matrix* U_rhoAtomPtr,
 	std::vector<vector3<> >& forces, matrix3<>* EU_RRT) const
 {	rhoAtom_COMMONinit
+	int matSizePrev = 0;
 	UparamLOOP
 	(	U_rho_PACK
 		for(int q=e->eInfo.qStart; q<e->eInfo.qStop; q++)
 		{	const QuantumNumber& qnum = e->eInfo.qnums[q];
 			int s = qnum.index();
-			ColumnBundle Opsi(C[q].similar(matSize));
-			setAtomicOrbitals(Opsi, true, Uparams.n, Uparams.l);
+			ColumnBundle Opsi = rhoAtom_getOpsi(C[q])->getSub(matSizePrev, matSizePrev+matSize);
 			matrix psiOCdag = Opsi ^ C[q];
 			diagMatrix fCartMat[3];
 			for(int k=0; k<3; k++)
@@ -174,6 +199,7 @@ void SpeciesInfo::rhoAtom_forces(const std::vector<diagMatrix>& F, const std::ve
 						(*EU_RRT)(jDir,iDir) += EU_RRT_ij;
 				}
 		}
+		matSizePrev += matSize;
 	)
 }
 
@@ -181,13 +207,15 @@ void SpeciesInfo::rhoAtom_getV(const ColumnBundle& Cq, const matrix* U_rhoAtomPt
 {	rhoAtom_COMMONinit
 	int matSizeTot = 0; UparamLOOP( matSizeTot += orbCount * atpos.size(); )
 	if(!matSizeTot) return;
-	Opsi = Cq.similar(matSizeTot);
+	bool useCache = (!derivDir) && (stressDir<0);
+	if(useCache) Opsi = *rhoAtom_getOpsi(Cq);
+	else Opsi = Cq.similar(matSizeTot);
 	M = zeroes(matSizeTot, matSizeTot);
 	int matSizePrev = 0;
 	UparamLOOP
 	(	U_rho_PACK
 		int s = Cq.qnum->index();
-		setAtomicOrbitals(Opsi, true, Uparams.n, Uparams.l, matSizePrev, 0, derivDir, stressDir);
+		if(!useCache) setAtomicOrbitals(Opsi, true, Uparams.n, Uparams.l, matSizePrev, 0, derivDir, stressDir);
 		M.set(matSizePrev,matSizePrev+matSize, matSizePrev,matSizePrev+matSize, (1./e->eInfo.spinWeight) * U_rho[s]);
 		matSizePrev += matSize;
 	)
@@ -210,10 +238,17 @@ void SpeciesInfo::updateLocal(ScalarFieldTilde& Vlocps, ScalarFieldTilde& rhoIon
 	
 	//Calculate in half G-space:
 	double invVol = 1.0/gInfo.detR;
-	callPref(::updateLocal)(gInfo.S, gInfo.GGT,
-		Vlocps->dataPref(), rhoIon->dataPref(), nChargeballData, nCoreData, tauCoreData,
-		atpos.size(), atposManaged.dataPref(), invVol, VlocRadial,
+	#ifdef GPU_ENABLED
+	updateLocal_gpu(gInfo.S, gInfo.GGT,
+		Vlocps->dataGpu(), rhoIon->dataGpu(), nChargeballData, nCoreData, tauCoreData,
+		atpos.size(), atposManaged.dataGpu(), invVol, VlocRadial,
+		Z, nCoreRadial, tauCoreRadial, Z_chargeball, std::pow(width_chargeball,2));
+	#else
+	::updateLocal(gInfo.S, gInfo.GGT,
+		Vlocps->data(), rhoIon->data(), nChargeballData, nCoreData, tauCoreData,
+		atpos.size(), getAtomPhase().data(), invVol, VlocRadial,
 		Z, nCoreRadial, tauCoreRadial, Z_chargeball, std::pow(width_chargeball,2));
+	#endif
 }
 
 
@@ -261,12 +296,19 @@ matrix3<> SpeciesInfo::getLocalStress(const ScalarFieldTilde& ccgrad_Vlocps,
 	complex* ccgrad_tauCoreData = (tauCoreRadial && ccgrad_tauCore) ? ccgrad_tauCore->dataPref() : 0;
 	
 	//Propagate ccgrad* to lattice derivative:
-	ManagedArray<symmetricMatrix3<>> result; result.init(gInfo.nG, isGpuEnabled());
-	callPref(gradLocalToStress)(gInfo.S, gInfo.GGT,
-		ccgrad_Vlocps->dataPref(), ccgrad_rhoIonData, ccgrad_nChargeballData,
-		ccgrad_nCoreData, ccgrad_tauCoreData, result.dataPref(), atpos.size(), atposManaged.dataPref(),
+	#ifdef GPU_ENABLED
+	ManagedArray<symmetricMatrix3<>> result; result.init(gInfo.nG, true);
+	gradLocalToStress_gpu(gInfo.S, gInfo.GGT,
+		ccgrad_Vlocps->dataGpu(), ccgrad_rhoIonData, ccgrad_nChargeballData,
+		ccgrad_nCoreData, ccgrad_tauCoreData, result.dataGpu(), atpos.size(), atposManaged.dataGpu(),
+		VlocRadial, Z, nCoreRadial, tauCoreRadial, Z_chargeball, std::pow(width_chargeball,2));
+	matrix3<> resultSum = eblas_sum_gpu(gInfo.nG, result.dataGpu());
+	#else
+	matrix3<> resultSum = gradLocalToStress(gInfo.S, gInfo.GGT, //summed over G within each thread
+		ccgrad_Vlocps->data(), ccgrad_rhoIonData, ccgrad_nChargeballData,
+		ccgrad_nCoreData, ccgrad_tauCoreData, atpos.size(), atposManaged.data(),
 		VlocRadial, Z, nCoreRadial, tauCoreRadial, Z_chargeball, std::pow(width_chargeball,2));
-	matrix3<> resultSum = callPref(eblas_sum)(gInfo.nG, result.dataPref());
+	#endif
 	return gInfo.GT * resultSum * gInfo.G;
 }
 
@@ -320,19 +362,35 @@ void SpeciesInfo::accumNonlocalForces(const ColumnBundle& Cq, const matrix& Vdag
 std::shared_ptr<ColumnBundle> SpeciesInfo::getV(const ColumnBundle& Cq, const vector3<>* derivDir, const int stressDir) const
 {	const QuantumNumber& qnum = *(Cq.qnum);
 	const Basis& basis = *(Cq.basis);
-	std::pair<vector3<>,const Basis*> cacheKey = std::make_pair(qnum.k, &basis);
+	CacheKey key = cacheKey(Cq);
 	int nProj = MnlAll.nRows() / e->eInfo.spinorLength();
 	if(!nProj) return 0; //purely local psp
 	//First check cache
 	if(e->cntrl.cacheProjectors && (!derivDir) && (!stressDir))
-	{	auto iter = cachedV.find(cacheKey);
+	{	auto iter = cachedV.find(key);
 		if(iter != cachedV.end()) //found
-			return iter->second; //return cached value
+		{	iter->second.lastUse = ++useCounter;
+			return iter->second.V; //return cached value
+		}
 	}
 	//No cache / not found in cache; compute:
 	std::shared_ptr<ColumnBundle> V = std::make_shared<ColumnBundle>(nProj*atpos.size(), basis.nbasis, &basis, &qnum, isGpuEnabled()); //not a spinor regardless of spin type
-	int iProj = 0;
-	for(int l=0; l<int(VnlRadial.size()); l++)
+	const vector3<int>& S = e->gInfo.S; //phase tables are on the density grid, which must contain the basis
+	bool basisInGrid = true;
+	for(int dir=0; dir<3; dir++) basisInGrid = basisInGrid && (basis.gInfo->S[dir] <= S[dir]);
+	if((!isGpuEnabled()) && (!derivDir) && (stressDir<0) && basisInGrid && initVnlBatch())
+	{	//Fused construction of all projectors, with structure factors composed from 1D phase tables (CPU only):
+		std::vector<complex> atomPhaseKvec(atpos.size());
+		for(size_t atom=0; atom<atpos.size(); atom++)
+			atomPhaseKvec[atom] = cis((-2*M_PI)*dot(atpos[atom], qnum.k));
+		ManagedArray<complex> atomPhaseK(atomPhaseKvec);
+		VnlBatch(VnlBatchNlm, basis.nbasis, nProj, VnlProjIndex.data(), atpos.size(), qnum.k, basis.iGarr.data(),
+			basis.gInfo->G, S, VnlRadial[0][0].nCoeff, VnlRadial[0][0].dGinv, VnlCoeff.data(),
+			getAtomPhase().data(), atomPhaseK.data(), V->data());
+	}
+	else
+	{	int iProj = 0;
+		for(int l=0; l<int(VnlRadial.size()); l++)
 		for(unsigned p=0; p<VnlRadial[l].size(); p++)
 			for(int m=-l; m<=l; m++)
 			{	size_t offs = iProj * basis.nbasis;
@@ -341,8 +399,147 @@ std::shared_ptr<ColumnBundle> SpeciesInfo::getV(const ColumnBundle& Cq, const ve
 					basis.gInfo->G, atposManaged.dataPref(), VnlRadial[l][p], V->dataPref()+offs, derivDir, stressDir);
 				iProj++;
 			}
+	}
 	//Add to cache if necessary:
 	if(e->cntrl.cacheProjectors && (!derivDir) && (!stressDir))
-		((SpeciesInfo*)this)->cachedV[cacheKey] = V;
+	{	CachedProjector& cp = ((SpeciesInfo*)this)->cachedV[key];
+		cp.V = V;
+		cp.lastUse = ++useCounter;
+		if(e->cntrl.projectorCacheMB) trimProjectorCache();
+	}
 	return V;
 }
+
+bool SpeciesInfo::initVnlBatch() const
+{	if(VnlBatchNlm) return VnlBatchNlm > 0;
+	SpeciesInfo& sp = *((SpeciesInfo*)this);
+	sp.VnlBatchNlm = -1;
+	//Check that all radial functions share a common spline grid, and that lMax is supported:
+	int lMax = int(VnlRadial.size()) - 1;
+	int Nlm = (lMax+1)*(lMax+1);
+	if(Nlm > 25) return false;
+	const RadialFunctionG* f0 = 0;
+	int nRadial = 0;
+	for(const auto& VnlRadial_l: VnlRadial)
+		for(const RadialFunctionG& f: VnlRadial_l)
+		{	if(!f0) f0 = &f;
+			if(f.nCoeff != f0->nCoeff || f.dGinv != f0->dGinv) return false;
+			nRadial++;
+		}
+	if(!f0) return false;
+	//Pack coefficients and projector indices (in the order of getV):
+	int nCoeff = f0->nCoeff;
+	std::vector<double> coeff(nRadial*nCoeff);
+	std::vector<int> projIndex;
+	int iRadial = 0;
+	for(int l=0; l<=lMax; l++)
+		for(const RadialFunctionG& f: VnlRadial[l])
+		{	std::copy(f.coeff.begin(), f.coeff.end(), coeff.begin()+iRadial*nCoeff);
+			for(int m=-l; m<=l; m++)
+			{	projIndex.push_back(l*(l+1)+m);
+				projIndex.push_back(iRadial);
+			}
+			iRadial++;
+		}
+	sp.VnlCoeff = ManagedArray<double>(coeff);
+	sp.VnlProjIndex.init(projIndex.size());
+	std::copy(projIndex.begin(), projIndex.end(), sp.VnlProjIndex.data());
+	sp.VnlBatchNlm = Nlm; //always a perfect square supported by SwitchTemplate_Nlm
+	return true;
+}
+
+void SpeciesInfo::releaseProjectors(const ColumnBundle& Cq) const
+{	CacheKey key = cacheKey(Cq);
+	((SpeciesInfo*)this)->cachedV.erase(key);
+	((SpeciesInfo*)this)->cachedVr.erase(key);
+	((SpeciesInfo*)this)->cachedOpsiU.erase(key);
+}
+
+std::shared_ptr<SpeciesInfo::RealSpaceProjector> SpeciesInfo::getVr(const ColumnBundle& Cq) const
+{	const Basis& basis = *(Cq.basis);
+	CacheKey key = cacheKey(Cq);
+	auto iter = cachedVr.find(key);
+	if(iter != cachedVr.end()) return iter->second;
+	std::shared_ptr<ColumnBundle> V = getV(Cq);
+	if(!V) return 0; //purely local psp
+	const GridInfo& gInfo = *(basis.gInfo);
+	const double rCut = e->cntrl.realSpaceProjectorRadius;
+	int nProj = MnlAll.nRows() / e->eInfo.spinorLength();
+	//Half-extent of bounding box of sphere in grid points (capped to the cell so that no point repeats):
+	vector3<int> nHalf;
+	for(int j=0; j<3; j++)
+		nHalf[j] = std::min(int(ceil(rCut * gInfo.G.row(j).length() * gInfo.S[j] / (2*M_PI))), (gInfo.S[j]-1)/2);
+	//Sample projectors of each atom within its sphere:
+	auto Vr = std::make_shared<RealSpaceProjector>();
+	Vr->index.resize(atpos.size());
+	Vr->V.resize(atpos.size());
+	double normTot = 0., normIn = 0.; size_t nPointsTot = 0;
+	for(unsigned atom=0; atom<atpos.size(); atom++)
+	{	std::vector<int>& index = Vr->index[atom];
+		vector3<int> iCenter, iv;
+		for(int j=0; j<3; j++) iCenter[j] = int(round(atpos[atom][j] * gInfo.S[j]));
+		for(iv[0]=iCenter[0]-nHalf[0]; iv[0]<=iCenter[0]+nHalf[0]; iv[0]++)
+		for(iv[1]=iCenter[1]-nHalf[1]; iv[1]<=iCenter[1]+nHalf[1]; iv[1]++)
+		for(iv[2]=iCenter[2]-nHalf[2]; iv[2]<=iCenter[2]+nHalf[2]; iv[2]++)
+		{	vector3<> dx; vector3<int> ivWrapped;
+			for(int j=0; j<3; j++)
+			{	dx[j] = iv[j]*(1./gInfo.S[j]) - atpos[atom][j];
+				ivWrapped[j] = positiveRemainder(iv[j], gInfo.S[j]);
+			}
+			if((gInfo.R*dx).length_squared() <= rCut*rCut)
+				index.push_back(gInfo.fullRindex(ivWrapped));
+		}
+		nPointsTot += index.size();
+		//Transform this atom's projectors to real space and extract values at the selected points:
+		ManagedArray<complex> Vatom = I_batch(*V, atom*nProj, (atom+1)*nProj);
+		const complex* VatomData = Vatom.data();
+		matrix& Va = Vr->V[atom];
+		Va.init(index.size(), nProj);
+		complex* VaData = Va.data();
+		for(int p=0; p<nProj; p++)
+		{	const complex* Vp = VatomData + size_t(p)*gInfo.nr;
+			for(int i=0; i<gInfo.nr; i++) normTot += Vp[i].norm();
+			for(size_t i=0; i<index.size(); i++)
+			{	VaData[Va.index(i,p)] = Vp[index[i]];
+				normIn += Vp[index[i]].norm();
+			}
+		}
+	}
+	if(cachedVr.empty()) //report truncation once per species per geometry
+		logPrintf("Real-space projectors for species %s: %.0lf grid points per atom within %lg bohrs, capturing %.6lf of the projector norm.\n",
+			name.c_str(), nPointsTot*1./atpos.size(), rCut, normIn/normTot);
+	if(e->cntrl.cacheProjectors)
+	{	((SpeciesInfo*)this)->cachedVr[key] = Vr;
+		((SpeciesInfo*)this)->cachedV.erase(key); //reciprocal-space version no longer needed for projections
+	}
+	return Vr;
+}
+
+SpeciesInfo::CacheKey SpeciesInfo::cacheKey(const ColumnBundle& Cq)
+{	return std::make_pair(Cq.qnum->k, Cq.basis->id());
+}
+
+unsigned long SpeciesInfo::useCounter = 0;
+
+void SpeciesInfo::trimProjectorCache() const
+{	const double budget = e->cntrl.projectorCacheMB * (1<<20); //in bytes
+	const std::vector< std::shared_ptr<SpeciesInfo> >& species = e->iInfo.species;
+	while(true)
+	{	//Find total cached size and the least-recently used entry (over all species):
+		double nBytes = 0.;
+		SpeciesInfo* spOldest = 0;
+		CacheKey keyOldest;
+		unsigned long useOldest = 0;
+		for(const auto& sp: species)
+			for(const auto& entry: sp->cachedV)
+			{	nBytes += entry.second.V->nData() * sizeof(complex);
+				if(!spOldest || entry.second.lastUse < useOldest)
+				{	spOldest = sp.get();
+					keyOldest = entry.first;
+					useOldest = entry.second.lastUse;
+				}
+			}
+		if(nBytes <= budget || useOldest == useCounter) return; //within budget, or only the entry just used remains
+		spOldest->cachedV.erase(keyOldest); //regenerated on the fly by getV when next needed
+	}
+}
@@ -123,6 +123,101 @@ void nAugmentGrad(int Nlm, const vector3<int> S, const matrix3<>& G,
 }
 
 
+//Batched versions of the above for all atoms of a species:
+void initAtomPhase(const vector3<int>& S, int nAtoms, const vector3<>* atpos, complex* atomPhase)
+{	for(int atom=0; atom<nAtoms; atom++)
+		for(int d=0; d<3; d++)
+			for(int iv=0; iv<S[d]; iv++)
+			{	int iG = (2*iv > S[d]) ? iv-S[d] : iv; //same convention as the half-G-space loops
+				*(atomPhase++) = cis((-2*M_PI)*atpos[atom][d]*iG);
+			}
+}
+
+template<int Nlm> void nAugmentBatch_sub(size_t diStart, size_t diStop, const vector3<int> S, const matrix3<>& G, int iGstart,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{	//Cache blocking: prepare atom-independent factors for a block of G-vectors, and then loop over atoms within the block
+	//(so that each atom's radial functions and phase tables are reused across the block)
+	const int blockSize = 64;
+	int nPhase = S[0]+S[1]+S[2];
+	std::vector<complex> Yphase(blockSize*Nlm), nBlock(blockSize);
+	std::vector<double> w(blockSize*6);
+	std::vector<int> jArr(blockSize);
+	std::vector<vector3<int>> iGarr(blockSize);
+	for(size_t iBlock=iGstart+diStart; iBlock<iGstart+diStop; iBlock+=blockSize)
+	{	size_t iStart = iBlock;
+		size_t iStop = std::min(iBlock+blockSize, iGstart+diStop);
+		THREAD_halfGspaceLoop(
+			int p = i-iStart;
+			jArr[p] = nAugmentBatch_prepare<Nlm>(iG, G, nCoeff, dGinv, Yphase.data()+p*Nlm, w.data()+p*6);
+			iGarr[p] = iG;
+			nBlock[p] = 0.;
+		)
+		int nPoints = iStop-iStart;
+		for(int atom=0; atom<nAtoms; atom++)
+		{	const double* nRadialAtom = nRadial + atom*Nlm*nCoeff;
+			const complex* atomPhaseAtom = atomPhase + atom*nPhase;
+			for(int p=0; p<nPoints; p++) if(jArr[p] >= 0)
+				nBlock[p] += nAugmentBatch_atom<Nlm>(Yphase.data()+p*Nlm, w.data()+p*6, jArr[p], nCoeff, nRadialAtom)
+					* atomPhase_calc(atomPhaseAtom, S, iGarr[p]);
+		}
+		for(int p=0; p<nPoints; p++) n[iStart+p] += nBlock[p];
+	}
+}
+template<int Nlm> void nAugmentBatch(const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{
+	threadLaunch(nAugmentBatch_sub<Nlm>, iGstop-iGstart, S, G, iGstart, nCoeff, dGinv, nRadial, nAtoms, atomPhase, n);
+}
+void nAugmentBatch(int Nlm, const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{	
+	SwitchTemplate_Nlm(Nlm, nAugmentBatch, (S, G, iGstart, iGstop, nCoeff, dGinv, nRadial, nAtoms, atomPhase, n) )
+}
+
+template<int Nlm> void nAugmentGradBatch_sub(int iStart, int iStop, const vector3<int> S, const matrix3<>& G,
+	int nCoeff, double dGinv, int nAtoms, const complex* atomPhase, const complex* ccE_n, double* E_nRadial,
+	const uint64_t* nagIndex, const size_t* nagIndexPtr, int pass)
+{
+	(pass ? iStart : iStop) = (iStart+iStop)/2; //do first and second halves of range in each pass (see nAugmentGrad_sub)
+	for(int iCoeff=iStart; iCoeff<iStop; iCoeff++)
+		for(size_t ptr=nagIndexPtr[iCoeff]; ptr<nagIndexPtr[iCoeff+1]; ptr++)
+			nAugmentGradBatch_calc<Nlm>(nagIndex[ptr], S, G, nCoeff, dGinv, nAtoms, atomPhase, ccE_n, E_nRadial);
+}
+template<int Nlm> void nAugmentGradBatch(const vector3<int> S, const matrix3<>& G,
+	int nCoeff, double dGinv, int nAtoms, const complex* atomPhase, const complex* ccE_n, double* E_nRadial,
+	const uint64_t* nagIndex, const size_t* nagIndexPtr)
+{	
+	int nThreads = std::min(nProcsAvailable, std::max(1,nCoeff/12)); //as in nAugmentGrad
+	for(int pass=0; pass<2; pass++) // two non-overlapping passes
+		threadLaunch(nThreads, nAugmentGradBatch_sub<Nlm>, nCoeff, S, G, nCoeff, dGinv, nAtoms, atomPhase, ccE_n, E_nRadial, nagIndex, nagIndexPtr, pass);
+}
+void nAugmentGradBatch(int Nlm, const vector3<int> S, const matrix3<>& G,
+	int nCoeff, double dGinv, int nAtoms, const complex* atomPhase, const complex* ccE_n, double* E_nRadial,
+	const uint64_t* nagIndex, const size_t* nagIndexPtr)
+{	
+	SwitchTemplate_Nlm(Nlm, nAugmentGradBatch, (S, G, nCoeff, dGinv, nAtoms, atomPhase, ccE_n, E_nRadial, nagIndex, nagIndexPtr) )
+}
+
+
+//Fused projectors
+template<int Nlm> void VnlBatch_sub(size_t nStart, size_t nStop, int nbasis, int nProj, const int* projIndex, int nAtoms,
+	const vector3<> k, const vector3<int>* iGarr, const matrix3<> G, const vector3<int> S, int nCoeff, double dGinv,
+	const double* VnlCoeff, const complex* atomPhase, const complex* atomPhaseK, complex* V)
+{	for(size_t n=nStart; n<nStop; n++)
+		VnlBatch_calc<Nlm>(n, nbasis, nProj, projIndex, nAtoms, k, iGarr, G, S, nCoeff, dGinv, VnlCoeff, atomPhase, atomPhaseK, V);
+}
+template<int Nlm> void VnlBatch(int nbasis, int nProj, const int* projIndex, int nAtoms, const vector3<> k, const vector3<int>* iGarr,
+	const matrix3<> G, const vector3<int> S, int nCoeff, double dGinv, const double* VnlCoeff,
+	const complex* atomPhase, const complex* atomPhaseK, complex* V)
+{	threadLaunch(VnlBatch_sub<Nlm>, nbasis, nbasis, nProj, projIndex, nAtoms, k, iGarr, G, S, nCoeff, dGinv, VnlCoeff, atomPhase, atomPhaseK, V);
+}
+void VnlBatch(int Nlm, int nbasis, int nProj, const int* projIndex, int nAtoms, const vector3<> k, const vector3<int>* iGarr,
+	const matrix3<> G, const vector3<int> S, int nCoeff, double dGinv, const double* VnlCoeff,
+	const complex* atomPhase, const complex* atomPhaseK, complex* V)
+{	SwitchTemplate_Nlm(Nlm, VnlBatch, (nbasis, nProj, projIndex, nAtoms, k, iGarr, G, S, nCoeff, dGinv, VnlCoeff, atomPhase, atomPhaseK, V) )
+}
+
+
 //Structure factor
 void getSG_sub(size_t iStart, size_t iStop, const vector3<int> S,
 	int nAtoms, const vector3<>* atpos, double invVol, complex* SG)
@@ -135,23 +230,26 @@ void getSG(const vector3<int> S, int nAtoms, const vector3<>* atpos, double invV
 //Local pseudopotential, ionic charge, chargeball and partial cores (CPU thread and launcher)
 void updateLocal_sub(size_t iStart, size_t iStop, const vector3<int> S, const matrix3<> GGT,
 	complex *Vlocps,  complex *rhoIon, complex *nChargeball, complex *nCore, complex* tauCore,
-	int nAtoms, const vector3<>* atpos, double invVol, const RadialFunctionG& VlocRadial,
+	int nAtoms, const complex* atomPhase, double invVol, const RadialFunctionG& VlocRadial,
 	double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq)
-{	THREAD_halfGspaceLoop(
-		updateLocal_calc(i, iG, GGT,
+{	int nPhase = S[0]+S[1]+S[2];
+	THREAD_halfGspaceLoop(
+		complex SG;
+		for(int atom=0; atom<nAtoms; atom++)
+			SG += atomPhase_calc(atomPhase+atom*nPhase, S, iG);
+		updateLocal_calc(i, GGT.metric_length_squared(iG), SG * invVol,
 			Vlocps, rhoIon, nChargeball, nCore, tauCore,
-			nAtoms, atpos, invVol, VlocRadial,
-			Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq); )
+			VlocRadial, Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq); )
 }
 void updateLocal(const vector3<int> S, const matrix3<> GGT,
 	complex *Vlocps,  complex *rhoIon, complex *nChargeball, complex *nCore, complex* tauCore,
-	int nAtoms, const vector3<>* atpos, double invVol, const RadialFunctionG& VlocRadial,
+	int nAtoms, const complex* atomPhase, double invVol, const RadialFunctionG& VlocRadial,
 	double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq)
 {	threadLaunch(updateLocal_sub, S[0]*S[1]*(S[2]/2+1), S, GGT,
 		Vlocps, rhoIon, nChargeball, nCore, tauCore,
-		nAtoms, atpos, invVol, VlocRadial,
+		nAtoms, atomPhase, invVol, VlocRadial,
 		Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq);
 }
 
@@ -193,24 +291,30 @@ void gradSGtoAtpos(const vector3<int> S, const vector3<> atpos,
 //Stress due to local pseudopotential, ionic charge, chargeball and partial cores
 void gradLocalToStress_sub(size_t iStart, size_t iStop, const vector3<int> S, const matrix3<> GGT,
 	const complex* ccgrad_Vlocps, const complex* ccgrad_rhoIon, const complex* ccgrad_nChargeball,
-	const complex* ccgrad_nCore, const complex* ccgrad_tauCore, symmetricMatrix3<>* grad_RRT,
-	int nAtoms, const vector3<>* atpos, const RadialFunctionG& VlocRadial, double Z,
-	const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
-	double Zchargeball, double wChargeballSq)
-{	THREAD_halfGspaceLoop(
-		gradLocalToStress_calc(i, iG, S, GGT,
+	const complex* ccgrad_nCore, const complex* ccgrad_tauCore,
+	int nAtoms, const vector3<>* atpos, const RadialFunctionG* VlocRadial, double Z,
+	const RadialFunctionG* nCoreRadial, const RadialFunctionG* tauCoreRadial,
+	double Zchargeball, double wChargeballSq, symmetricMatrix3<>* grad_RRT, std::mutex* lock)
+{	symmetricMatrix3<> grad_RRTsub;
+	THREAD_halfGspaceLoop(
+		grad_RRTsub += gradLocalToStress_term(i, iG, S, GGT,
 		ccgrad_Vlocps, ccgrad_rhoIon, ccgrad_nChargeball,
-		ccgrad_nCore, ccgrad_tauCore, grad_RRT, nAtoms, atpos, VlocRadial,
-		Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq); )
+		ccgrad_nCore, ccgrad_tauCore, nAtoms, atpos, *VlocRadial,
+		Z, *nCoreRadial, *tauCoreRadial, Zchargeball, wChargeballSq); )
+	std::lock_guard<std::mutex> guard(*lock);
+	*grad_RRT += grad_RRTsub;
 }
-void gradLocalToStress(const vector3<int> S, const matrix3<> GGT,
+symmetricMatrix3<> gradLocalToStress(const vector3<int> S, const matrix3<> GGT,
 	const complex* ccgrad_Vlocps, const complex* ccgrad_rhoIon, const complex* ccgrad_nChargeball,
-	const complex* ccgrad_nCore, const complex* ccgrad_tauCore, symmetricMatrix3<>* grad_RRT,
+	const complex* ccgrad_nCore, const complex* ccgrad_tauCore,
 	int nAtoms, const vector3<>* atpos, const RadialFunctionG& VlocRadial, double Z,
 	const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq)
-{	threadLaunch(gradLocalToStress_sub, S[0]*S[1]*(S[2]/2+1), S, GGT,
+{	symmetricMatrix3<> grad_RRT;
+	std::mutex lock;
+	threadLaunch(gradLocalToStress_sub, S[0]*S[1]*(S[2]/2+1), S, GGT,
 		ccgrad_Vlocps, ccgrad_rhoIon, ccgrad_nChargeball,
-		ccgrad_nCore, ccgrad_tauCore, grad_RRT, nAtoms, atpos, VlocRadial,
-		Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq);
+		ccgrad_nCore, ccgrad_tauCore, nAtoms, atpos, &VlocRadial,
+		Z, &nCoreRadial, &tauCoreRadial, Zchargeball, wChargeballSq, &grad_RRT, &lock);
+	return grad_RRT;
 }
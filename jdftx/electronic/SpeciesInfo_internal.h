@@ -265,6 +265,164 @@ void nAugmentGrad_gpu(int Nlm, const vector3<int> S, const matrix3<>& G,
 #endif
 
 
+//----- Batched versions of nAugment and nAugmentGrad, which process all atoms of a species together -----
+//Angular factors, spline weights and structure factors are computed once per G-vector and shared by all atoms,
+//with structure factors composed from per-atom 1D phase tables atomPhase (see initAtomPhase below).
+
+//! Initialize per-atom 1D structure-factor phase tables: for each atom, exp(-2 pi i x[d] iG[d])
+//! for each direction d and wrapped iG[d] in [0,S[d]), stored contiguously (stride S[0]+S[1]+S[2] per atom)
+void initAtomPhase(const vector3<int>& S, int nAtoms, const vector3<>* atpos, complex* atomPhase);
+
+//! Structure factor of one atom at iG (signed, as in the half-G-space loops) from its 1D phase tables
+__hostanddev__ complex atomPhase_calc(const complex* atomPhase, const vector3<int>& S, const vector3<int>& iG)
+{	int i0 = iG[0]<0 ? iG[0]+S[0] : iG[0];
+	int i1 = iG[1]<0 ? iG[1]+S[1] : iG[1];
+	int i2 = iG[2]<0 ? iG[2]+S[2] : iG[2];
+	return atomPhase[i0] * atomPhase[S[0]+i1] * atomPhase[S[0]+S[1]+i2];
+}
+
+//! Angular factors (-i)^l Ylm(qhat) for all lm < Nlm
+template<int Nlm> struct nAugmentAngularFunctor
+{	vector3<> qhat;
+	complex* Yphase;
+	__hostanddev__ nAugmentAngularFunctor(const vector3<>& qhat, complex* Yphase) : qhat(qhat), Yphase(Yphase) {}
+	template<int lm> __hostanddev__ void operator()(const StaticLoopYlmTag<lm>&)
+	{	complex mIota(0,-1), phase(1,0);
+		for(int l=0; l*(l+2) < lm; l++) phase *= mIota;
+		Yphase[lm] = phase * Ylm<lm>(qhat);
+	}
+};
+
+//! Prepare the atom-independent factors at G-vector iG: angular factors Yphase[Nlm] and spline weights w[6].
+//! Returns the spline coefficient offset, or -1 if qvec is beyond the range of the radial functions.
+template<int Nlm> __hostanddev__ int nAugmentBatch_prepare(const vector3<int>& iG, const matrix3<>& G,
+	int nCoeff, double dGinv, complex* Yphase, double* w)
+{	vector3<> qvec = iG*G;
+	double q = qvec.length();
+	double Gindex = q * dGinv;
+	if(Gindex >= nCoeff-5) return -1;
+	nAugmentAngularFunctor<Nlm> functor(qvec * (q ? 1.0/q : 0.0), Yphase);
+	staticLoopYlm<Nlm>(&functor);
+	double wLocal[6]; QuinticSpline::valueWeights(Gindex, wLocal);
+	for(int k=0; k<6; k++) w[k] = wLocal[k];
+	return int(Gindex);
+}
+
+//! Augmentation of one atom at one G-vector, given the factors from nAugmentBatch_prepare
+//! (nRadialAtom contains Nlm radial functions of nCoeff coefficients each)
+template<int Nlm> __hostanddev__ complex nAugmentBatch_atom(const complex* Yphase, const double* w, int j,
+	int nCoeff, const double* nRadialAtom)
+{	complex n;
+	for(int lm=0; lm<Nlm; lm++)
+	{	const double* c = nRadialAtom + lm*nCoeff + j;
+		n += Yphase[lm] * (w[0]*c[0] + w[1]*c[1] + w[2]*c[2] + w[3]*c[3] + w[4]*c[4] + w[5]*c[5]);
+	}
+	return n;
+}
+
+//! Batched nAugment_calc for all nAtoms atoms at one G-vector (atom stride Nlm*nCoeff in nRadial)
+template<int Nlm> __hostanddev__
+void nAugmentBatch_calc(int i, const vector3<int>& iG, const vector3<int>& S, const matrix3<>& G,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n)
+{	complex Yphase[Nlm]; double w[6];
+	int j = nAugmentBatch_prepare<Nlm>(iG, G, nCoeff, dGinv, Yphase, w);
+	if(j < 0) return;
+	int nPhase = S[0]+S[1]+S[2];
+	complex nSum;
+	for(int atom=0; atom<nAtoms; atom++)
+		nSum += nAugmentBatch_atom<Nlm>(Yphase, w, j, nCoeff, nRadial+atom*Nlm*nCoeff) * atomPhase_calc(atomPhase+atom*nPhase, S, iG);
+	n[i] += nSum;
+}
+void nAugmentBatch(int Nlm,
+	const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n);
+#ifdef GPU_ENABLED
+void nAugmentBatch_gpu(int Nlm,
+	const vector3<int> S, const matrix3<>& G, int iGstart, int iGstop,
+	int nCoeff, double dGinv, const double* nRadial, int nAtoms, const complex* atomPhase, complex* n);
+#endif
+
+//! Batched gradient propagation of nAugment to radial functions alone (no forces or stress), ordered by nagIndex as in nAugmentGrad (CPU only)
+template<int Nlm> __hostanddev__
+void nAugmentGradBatch_calc(uint64_t key, const vector3<int>& S, const matrix3<>& G,
+	int nCoeff, double dGinv, int nAtoms, const complex* atomPhase, const complex* ccE_n, double* E_nRadial)
+{	//Obtain 3D index iG and array offset i for this point (as in nAugmentGrad_calc)
+	vector3<int> iG;
+	iG[2] = int(0xFFFF & key); key >>= 16;
+	iG[1] = int(0xFFFF & key); key >>= 16;
+	iG[0] = int(0xFFFF & key);
+	size_t i = iG[2] + (S[2]/2+1)*size_t(iG[1] + S[1]*iG[0]);
+	for(int j=0; j<3; j++) if(2*iG[j]>S[j]) iG[j]-=S[j];
+	int dotPrefac = (iG[2]==0||2*iG[2]==S[2]) ? 1 : 2;
+	complex Yphase[Nlm]; double w[6];
+	int j = nAugmentBatch_prepare<Nlm>(iG, G, nCoeff, dGinv, Yphase, w);
+	if(j < 0) return;
+	int nPhase = S[0]+S[1]+S[2];
+	complex E_n = ccE_n[i].conj();
+	for(int atom=0; atom<nAtoms; atom++)
+	{	complex E_nAtom = E_n * atomPhase_calc(atomPhase+atom*nPhase, S, iG);
+		double* E_nRadialAtom = E_nRadial + atom*Nlm*nCoeff + j;
+		for(int lm=0; lm<Nlm; lm++)
+		{	double E_value = dotPrefac * (Yphase[lm] * E_nAtom).real();
+			double* E_c = E_nRadialAtom + lm*nCoeff;
+			for(int k=0; k<6; k++) E_c[k] += E_value * w[k];
+		}
+	}
+}
+void nAugmentGradBatch(int Nlm, const vector3<int> S, const matrix3<>& G,
+	int nCoeff, double dGinv, int nAtoms, const complex* atomPhase, const complex* ccE_n, double* E_nRadial,
+	const uint64_t* nagIndex, const size_t* nagIndexPtr);
+
+
+//----- Fused construction of all projectors of a species, sharing per-G factors between atoms and projectors -----
+//Angular factors and spline weights are computed once per basis function for all (l,p,m), and the structure
+//factors of all atoms are composed from their 1D phase tables (atomPhase above) and a per-atom k-phase,
+//instead of a separate Ylm, spline and sincos evaluation for every atom and projector as in Vnl_calc.
+
+//! Real spherical harmonics Ylm(qhat) for all lm < Nlm
+template<int Nlm> struct YlmBatchFunctor
+{	vector3<> qhat;
+	double* Y;
+	__hostanddev__ YlmBatchFunctor(const vector3<>& qhat, double* Y) : qhat(qhat), Y(Y) {}
+	template<int lm> __hostanddev__ void operator()(const StaticLoopYlmTag<lm>&) { Y[lm] = Ylm<lm>(qhat); }
+};
+
+//! All nProj projectors (lm index projIndex[2*iProj] and radial function projIndex[2*iProj+1] of nCoeff coefficients in VnlCoeff)
+//! of all atoms at basis function n, stored in V[(atom*nProj + iProj)*nbasis + n] (same layout as SpeciesInfo::getV).
+//! atomPhaseK contains exp(-2 pi i k.pos) for each atom.
+template<int Nlm> __hostanddev__
+void VnlBatch_calc(int n, int nbasis, int nProj, const int* projIndex, int nAtoms, const vector3<>& k, const vector3<int>* iGarr,
+	const matrix3<>& G, const vector3<int>& S, int nCoeff, double dGinv, const double* VnlCoeff,
+	const complex* atomPhase, const complex* atomPhaseK, complex* V)
+{	const vector3<int>& iG = iGarr[n];
+	vector3<> qvec = (k + iG) * G; //k+G in cartesian coordinates
+	double q = qvec.length();
+	double Y[Nlm];
+	YlmBatchFunctor<Nlm> functor(qvec * (q ? 1.0/q : 0.0), Y);
+	staticLoopYlm<Nlm>(&functor);
+	double Gindex = q * dGinv;
+	bool inRange = (Gindex < nCoeff-5); //beyond this, radial functions are zero (see RadialFunctionG::operator())
+	double w[6]; int j = int(Gindex);
+	if(inRange) QuinticSpline::valueWeights(Gindex, w);
+	int nPhase = S[0]+S[1]+S[2];
+	for(int atom=0; atom<nAtoms; atom++)
+	{	complex SG = atomPhaseK[atom] * atomPhase_calc(atomPhase+atom*nPhase, S, iG);
+		complex* Vatom = V + atom*nProj*nbasis + n;
+		for(int iProj=0; iProj<nProj; iProj++)
+		{	double prefac = 0.;
+			if(inRange)
+			{	const double* c = VnlCoeff + projIndex[2*iProj+1]*nCoeff + j;
+				prefac = Y[projIndex[2*iProj]] * (w[0]*c[0] + w[1]*c[1] + w[2]*c[2] + w[3]*c[3] + w[4]*c[4] + w[5]*c[5]);
+			}
+			Vatom[iProj*nbasis] = prefac * SG;
+		}
+	}
+}
+void VnlBatch(int Nlm, int nbasis, int nProj, const int* projIndex, int nAtoms, const vector3<> k, const vector3<int>* iGarr,
+	const matrix3<> G, const vector3<int> S, int nCoeff, double dGinv, const double* VnlCoeff,
+	const complex* atomPhase, const complex* atomPhaseK, complex* V); //CPU only: GPU builds use Vnl_gpu per projector
+
+
 //!Get structure factor for a specific iG, given a list of atoms
 __hostanddev__ complex getSG_calc(const vector3<int>& iG, const int& nAtoms, const vector3<>* atpos)
 {	complex SG = complex(0,0);
@@ -278,18 +436,12 @@ void getSG(const vector3<int> S, int nAtoms, const vector3<>* atpos, double invV
 void getSG_gpu(const vector3<int> S, int nAtoms, const vector3<>* atpos, double invVol, complex* SG);
 #endif
 
-//! Calculate local pseudopotential, ionic density and chargeball due to one species at a given G-vector
-__hostanddev__ void updateLocal_calc(int i, const vector3<int>& iG, const matrix3<>& GGT,
+//! Calculate local pseudopotential, ionic density and chargeball due to one species at a given G-vector, given its structure factor scaled by 1/detR
+__hostanddev__ void updateLocal_calc(int i, double Gsq, complex SGinvVol,
 	complex *Vlocps, complex *rhoIon, complex *nChargeball, complex* nCore, complex* tauCore,
-	int nAtoms, const vector3<>* atpos, double invVol, const RadialFunctionG& VlocRadial,
-	double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
+	const RadialFunctionG& VlocRadial, double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq)
 {
-	double Gsq = GGT.metric_length_squared(iG);
-
-	//Compute structure factor (scaled by 1/detR):
-	complex SGinvVol = getSG_calc(iG, nAtoms, atpos) * invVol;
-
 	//Short-ranged part of Local potential (long-ranged part added on later in IonInfo.cpp):
 	Vlocps[i] += SGinvVol * VlocRadial(sqrt(Gsq));
 
@@ -304,9 +456,19 @@ __hostanddev__ void updateLocal_calc(int i, const vector3<int>& iG, const matrix
 	if(nCore) nCore[i] += SGinvVol * nCoreRadial(sqrt(Gsq));
 	if(tauCore) tauCore[i] += SGinvVol * tauCoreRadial(sqrt(Gsq));
 }
+//! Same as above, with the structure factor computed directly from the atomic positions (GPU path)
+__hostanddev__ void updateLocal_calc(int i, const vector3<int>& iG, const matrix3<>& GGT,
+	complex *Vlocps, complex *rhoIon, complex *nChargeball, complex* nCore, complex* tauCore,
+	int nAtoms, const vector3<>* atpos, double invVol, const RadialFunctionG& VlocRadial,
+	double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
+	double Zchargeball, double wChargeballSq)
+{	updateLocal_calc(i, GGT.metric_length_squared(iG), getSG_calc(iG, nAtoms, atpos) * invVol,
+		Vlocps, rhoIon, nChargeball, nCore, tauCore, VlocRadial, Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq);
+}
+//! CPU version, with structure factors composed from the per-atom phase tables
 void updateLocal(const vector3<int> S, const matrix3<> GGT,
 	complex *Vlocps,  complex *rhoIon, complex *n_chargeball, complex* n_core, complex* tauCore,
-	int nAtoms, const vector3<>* atpos, double invVol, const RadialFunctionG& VlocRadial,
+	int nAtoms, const complex* atomPhase, double invVol, const RadialFunctionG& VlocRadial,
 	double Z, const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq);
 #ifdef GPU_ENABLED
@@ -379,10 +541,10 @@ void gradSGtoAtpos_gpu(const vector3<int> S, const vector3<> atpos,
 #endif
 
 
-//! Propagate (complex conjugates of) gradients w.r.t Vlocps, rhoIon etc to symmetric gradient w.r.t lattice vectors
-__hostanddev__ void gradLocalToStress_calc(int i, const vector3<int> iG, const vector3<int> S, const matrix3<> GGT,
+//! Propagate (complex conjugates of) gradients w.r.t Vlocps, rhoIon etc to symmetric gradient w.r.t lattice vectors (contribution of one G)
+__hostanddev__ symmetricMatrix3<> gradLocalToStress_term(int i, const vector3<int> iG, const vector3<int> S, const matrix3<> GGT,
 	const complex* ccgrad_Vlocps, const complex* ccgrad_rhoIon, const complex* ccgrad_nChargeball,
-	const complex* ccgrad_nCore, const complex* ccgrad_tauCore, symmetricMatrix3<>* grad_RRT,
+	const complex* ccgrad_nCore, const complex* ccgrad_tauCore,
 	int nAtoms, const vector3<>* atpos, const RadialFunctionG& VlocRadial, double Z,
 	const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq)
@@ -404,15 +566,25 @@ __hostanddev__ void gradLocalToStress_calc(int i, const vector3<int> iG, const v
 	//Compute structure factor:
 	complex SG = getSG_calc(iG, nAtoms, atpos);
 	
-	//Store result:
 	int weight = (((iG[2]==0) or (2*iG[2]==S[2])) ? 1 : 2); //weight factor for points in reduced reciprocal space of real scalar fields
-	grad_RRT[i] = (-weight * real(ccgradRadial.conj() * SG) * GmagInv) * outer(vector3<>(iG));
+	return (-weight * real(ccgradRadial.conj() * SG) * GmagInv) * outer(vector3<>(iG));
 }
-void gradLocalToStress(const vector3<int> S, const matrix3<> GGT,
+//! Store the contribution of each G to grad_RRT (GPU version, followed by a sum)
+__hostanddev__ void gradLocalToStress_calc(int i, const vector3<int> iG, const vector3<int> S, const matrix3<> GGT,
 	const complex* ccgrad_Vlocps, const complex* ccgrad_rhoIon, const complex* ccgrad_nChargeball,
 	const complex* ccgrad_nCore, const complex* ccgrad_tauCore, symmetricMatrix3<>* grad_RRT,
 	int nAtoms, const vector3<>* atpos, const RadialFunctionG& VlocRadial, double Z,
 	const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
+	double Zchargeball, double wChargeballSq)
+{	grad_RRT[i] = gradLocalToStress_term(i, iG, S, GGT, ccgrad_Vlocps, ccgrad_rhoIon, ccgrad_nChargeball,
+		ccgrad_nCore, ccgrad_tauCore, nAtoms, atpos, VlocRadial, Z, nCoreRadial, tauCoreRadial, Zchargeball, wChargeballSq);
+}
+//! CPU version, which accumulates the sum over G within each thread (instead of storing each G's contribution)
+symmetricMatrix3<> gradLocalToStress(const vector3<int> S, const matrix3<> GGT,
+	const complex* ccgrad_Vlocps, const complex* ccgrad_rhoIon, const complex* ccgrad_nChargeball,
+	const complex* ccgrad_nCore, const complex* ccgrad_tauCore,
+	int nAtoms, const vector3<>* atpos, const RadialFunctionG& VlocRadial, double Z,
+	const RadialFunctionG& nCoreRadial, const RadialFunctionG& tauCoreRadial,
 	double Zchargeball, double wChargeballSq);
 #ifdef GPU_ENABLED
 void gradLocalToStress_gpu(const vector3<int> S, const matrix3<> GGT,
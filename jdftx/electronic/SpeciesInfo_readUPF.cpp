@@ -341,7 +341,6 @@ void SpeciesInfo::readUPF(istream& is)
 					Vnl[iBeta].set(rGrid, drGrid);
 					for(int i=0; i<nGrid; i++)
 						Vnl[iBeta].f[i] *= (rGrid[i] ? 1./rGrid[i] : 0);
-					Vnl[iBeta].transform(l, dG, nGridNL, VnlRadial[l].back());
 					//Determine core radius:
 					for(int i=nGrid-1; i>=0; i--)
 						if(4*M_PI*rGrid[i]*rGrid[i]*drGrid[i] * fabs(D[iBeta][iBeta]) * Vnl[iBeta].f[i]*Vnl[iBeta].f[i] > 1e-3)
@@ -349,6 +348,16 @@ void SpeciesInfo::readUPF(istream& is)
 							break;
 						}
 				}
+				//Transform all projectors together (sharing Bessel function evaluations):
+				std::vector<const RadialFunctionR*> VnlFuncs; std::vector<int> VnlL; std::vector<RadialFunctionG*> VnlTargets;
+				std::vector<int> nProjL(lMax+1, 0);
+				for(int iBeta=0; iBeta<nBeta; iBeta++)
+				{	int l = lNL[iBeta];
+					VnlFuncs.push_back(&Vnl[iBeta]);
+					VnlL.push_back(l);
+					VnlTargets.push_back(&VnlRadial[l][nProjL[l]++]);
+				}
+				RadialFunctionR::transform(VnlFuncs, VnlL, dG, nGridNL, VnlTargets);
 				//Set Mnl:
 				Mnl.resize(lMax+1);
 				for(int l=0; l<=lMax; l++)
@@ -368,6 +377,8 @@ void SpeciesInfo::readUPF(istream& is)
 					Qint.resize(lMax+1);
 					for(int l=0; l<=lMax; l++) if(lBeta[l].size())
 						Qint[l] = zeroes(lBeta[l].size(), lBeta[l].size());
+					std::list<RadialFunctionR> Qlist; //radial functions to transform, collected for a batched transform below
+					std::vector<const RadialFunctionR*> Qfuncs; std::vector<int> Ql; std::vector<RadialFunctionG*> Qtargets;
 					for(int l1=0; l1<=lMax; l1++) for(int p1=0; p1<int(lBeta[l1].size()); p1++)
 					{	int iBeta = lBeta[l1][p1];
 						for(int l2=0; l2<=lMax; l2++) for(int p2=0; p2<int(lBeta[l2].size()); p2++)
@@ -402,7 +413,10 @@ void SpeciesInfo::readUPF(istream& is)
 									}
 									//Store in Qradial:
 									QijIndex qIndex = { l1, p1, l2, p2, l };
-									Qijl.transform(l, dG, nGridLoc, Qradial[qIndex]);
+									Qlist.push_back(Qijl);
+									Qfuncs.push_back(&Qlist.back());
+									Ql.push_back(l);
+									Qtargets.push_back(&Qradial[qIndex]);
 									//Store Qint = integral(Qradial) when relevant:
 									if(l1==l2 && !l)
 									{	double Qint_ij = Qijl.transform(0,0)/(4*M_PI);
@@ -413,6 +427,7 @@ void SpeciesInfo::readUPF(istream& is)
 							}
 						}
 					}
+					RadialFunctionR::transform(Qfuncs, Ql, dG, nGridLoc, Qtargets); //all augmentation channels together
 					if(!Qradial.size()) Qint.clear(); //Norm-conserving pseudopotentials that had been written in Ultrasoft format for some reason
 				}
 			}
@@ -0,0 +1,222 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <electronic/StateStore.h>
+#include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
+#include <fluid/FluidSolver.h>
+#include <commands/command.h>
+#include <fstream>
+#include <sstream>
+#include <cfloat>
+
+//64-bit FNV-1a hash of a string (stable across builds, unlike std::hash)
+inline uint64_t fnvHash(const std::string& s)
+{	uint64_t h = 14695981039346656037ULL;
+	for(unsigned char c: s)
+	{	h ^= c;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+StateStore::StateStore() : maxDisplacement(0.5), basisHash(0)
+{
+}
+
+void StateStore::lookup(Everything& e)
+{	logPrintf("\n---------- Searching state store ----------\n");
+	Entry current = fingerprint(e);
+	basisHash = current.basisHash; //reduced k-points are not available later, so remember for save()
+	
+	//Find nearest compatible entry:
+	std::ifstream ifs(indexFilename().c_str());
+	if(!ifs.is_open())
+	{	logPrintf("No index in '%s' yet: starting from scratch.\n", directory.c_str());
+		return;
+	}
+	Entry best;
+	double distBest = DBL_MAX;
+	int nEntries = 0, nCompatible = 0;
+	std::string line;
+	while(std::getline(ifs, line))
+	{	Entry entry;
+		if(!entry.fromString(line)) continue;
+		nEntries++;
+		if(!current.compatible(entry)) continue;
+		nCompatible++;
+		double dist = current.distance(entry);
+		if(dist < distBest)
+		{	distBest = dist;
+			best = entry;
+		}
+	}
+	logPrintf("Found %d compatible of %d entries in '%s'", nCompatible, nEntries, indexFilename().c_str());
+	if(!nCompatible or distBest > maxDisplacement)
+	{	if(nCompatible) logPrintf(", nearest at RMS displacement %lg bohrs exceeds %lg", distBest, maxDisplacement);
+		logPrintf(": starting from scratch.\n");
+		return;
+	}
+	logPrintf(".\nInitializing from entry '%s' at RMS displacement %lg bohrs (nBands: %d, Ecut: %lg).\n",
+		best.id.c_str(), distBest, best.nBands, best.Ecut);
+	
+	//Wavefunctions, converted to current bands and cutoff on read:
+	string wfnsFilename = stateFilename(best.id, "wfns");
+	if(isReadable(wfnsFilename))
+	{	e.eVars.wfnsFilename = wfnsFilename;
+		auto conversion = std::make_shared<ElecInfo::ColumnBundleReadConversion>();
+		conversion->nBandsOld = best.nBands;
+		conversion->EcutOld = best.Ecut;
+		e.eVars.readConversion = conversion;
+	}
+	//Fillings:
+	string fillingsFilename = stateFilename(best.id, "fillings");
+	if(isReadable(fillingsFilename))
+	{	e.eInfo.initialFillingsFilename = fillingsFilename;
+		e.eInfo.nBandsOld = best.nBands;
+	}
+	//Fluid state, only if stored on the same grid for the same fluid:
+	string fluidFilename = stateFilename(best.id, "fluidState");
+	if(best.fluidType!=FluidNone and best.fluidType==e.eVars.fluidParams.fluidType
+		and best.S==current.S and isReadable(fluidFilename))
+		e.eVars.fluidInitialStateFilename = fluidFilename;
+}
+
+void StateStore::save(const Everything& e) const
+{	Entry entry = fingerprint(e);
+	entry.basisHash = basisHash;
+	std::string line = entry.toString();
+	char id[32]; sprintf(id, "%016llx", (unsigned long long)fnvHash(line));
+	entry.id = id;
+	logPrintf("\nSaving state to store '%s' as entry '%s' ... ", directory.c_str(), id); logFlush();
+	
+	//Write state files (before index entry, so that readers only find complete entries):
+	const ElecInfo& eInfo = e.eInfo;
+	const ElecVars& eVars = e.eVars;
+	eInfo.write(eVars.C, stateFilename(entry.id, "wfns").c_str());
+	double wInv = eInfo.spinType==SpinNone ? 0.5 : 1.0; //normalization factor from external to internal fillings
+	std::vector<diagMatrix> F = eVars.F;
+	for(int q=eInfo.qStart; q<eInfo.qStop; q++) F[q] *= (1./wInv);
+	eInfo.write(F, stateFilename(entry.id, "fillings").c_str());
+	if(eVars.fluidSolver and mpiWorld->isHead())
+		eVars.fluidSolver->saveState(stateFilename(entry.id, "fluidState").c_str());
+	
+	//Append to index:
+	if(mpiWorld->isHead())
+	{	FILE* fp = fopen(indexFilename().c_str(), "a");
+		if(!fp) die("\nCould not open state store index '%s' for appending.\n", indexFilename().c_str());
+		fprintf(fp, "%s %s\n", id, line.c_str());
+		fclose(fp);
+	}
+	logPrintf("done.\n"); logFlush();
+}
+
+StateStore::Entry StateStore::fingerprint(const Everything& e) const
+{	Entry entry;
+	entry.fluidType = e.eVars.fluidParams.fluidType;
+	entry.S = e.gInfo.S;
+	entry.nBands = e.eInfo.nBands;
+	entry.Ecut = e.cntrl.Ecut;
+	entry.R = e.gInfo.R;
+	for(const auto& sp: e.iInfo.species)
+	{	entry.speciesNames.push_back(sp->name.c_str());
+		entry.atpos.push_back(sp->atpos);
+	}
+	//Hash of quantities that determine the reduced k-point set:
+	std::ostringstream oss;
+	oss.precision(12);
+	oss << e.eInfo.spinType;
+	for(const QuantumNumber& qnum: e.eInfo.qnums)
+		oss << ' ' << qnum.k[0] << ' ' << qnum.k[1] << ' ' << qnum.k[2] << ' ' << qnum.weight;
+	for(const SpaceGroupOp& op: e.symm.getMatrices())
+		for(int i=0; i<3; i++) for(int j=0; j<3; j++)
+			oss << ' ' << op.rot(i,j);
+	entry.basisHash = fnvHash(oss.str());
+	return entry;
+}
+
+string StateStore::indexFilename() const
+{	return directory + "/index";
+}
+
+string StateStore::stateFilename(const std::string& id, const char* varName) const
+{	return directory + "/" + id.c_str() + "." + varName;
+}
+
+//---------- StateStore::Entry ----------
+
+bool StateStore::Entry::compatible(const Entry& other) const
+{	if(basisHash != other.basisHash) return false;
+	if(speciesNames != other.speciesNames) return false;
+	for(size_t sp=0; sp<atpos.size(); sp++)
+		if(atpos[sp].size() != other.atpos[sp].size())
+			return false;
+	//Lattice must match for the stored G-sphere basis sizes to be valid:
+	const double tol = 1e-8;
+	return nrm2(R - other.R) <= tol * nrm2(R);
+}
+
+double StateStore::Entry::distance(const Entry& other) const
+{	double distSqSum = 0.; int nAtoms = 0;
+	for(size_t sp=0; sp<atpos.size(); sp++)
+		for(size_t at=0; at<atpos[sp].size(); at++)
+		{	vector3<> dx = atpos[sp][at] - other.atpos[sp][at];
+			for(int k=0; k<3; k++) dx[k] -= floor(0.5 + dx[k]); //minimum image
+			distSqSum += (R * dx).length_squared();
+			nAtoms++;
+		}
+	return nAtoms ? sqrt(distSqSum / nAtoms) : 0.;
+}
+
+std::string StateStore::Entry::toString() const
+{	std::ostringstream oss;
+	oss.precision(16);
+	oss << basisHash << ' ' << fluidType << ' ' << S[0] << ' ' << S[1] << ' ' << S[2]
+		<< ' ' << nBands << ' ' << Ecut;
+	for(int i=0; i<3; i++) for(int j=0; j<3; j++)
+		oss << ' ' << R(i,j);
+	oss << ' ' << speciesNames.size();
+	for(size_t sp=0; sp<speciesNames.size(); sp++)
+	{	oss << ' ' << speciesNames[sp] << ' ' << atpos[sp].size();
+		for(const vector3<>& x: atpos[sp])
+			oss << ' ' << x[0] << ' ' << x[1] << ' ' << x[2];
+	}
+	return oss.str();
+}
+
+bool StateStore::Entry::fromString(const std::string& line)
+{	std::istringstream iss(line);
+	iss >> id >> basisHash >> fluidType >> S[0] >> S[1] >> S[2] >> nBands >> Ecut;
+	for(int i=0; i<3; i++) for(int j=0; j<3; j++)
+		iss >> R(i,j);
+	size_t nSpecies = 0;
+	iss >> nSpecies;
+	if(iss.fail()) return false;
+	speciesNames.resize(nSpecies);
+	atpos.resize(nSpecies);
+	for(size_t sp=0; sp<nSpecies; sp++)
+	{	size_t nAtoms = 0;
+		iss >> speciesNames[sp] >> nAtoms;
+		if(iss.fail()) return false;
+		atpos[sp].resize(nAtoms);
+		for(vector3<>& x: atpos[sp])
+			iss >> x[0] >> x[1] >> x[2];
+	}
+	return !iss.fail();
+}
@@ -0,0 +1,85 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#ifndef JDFTX_ELECTRONIC_STATESTORE_H
+#define JDFTX_ELECTRONIC_STATESTORE_H
+
+#include <core/matrix3.h>
+#include <core/string.h>
+#include <cstdint>
+#include <vector>
+
+class Everything;
+
+//! @addtogroup ElecSystem
+//! @{
+
+/** @file StateStore.h
+@brief Directory of converged states keyed by structure, for warm starts across jobs (see command state-store)
+
+Each entry in the index file of the directory records the fingerprint of a converged calculation:
+species names and atom counts, lattice vectors and atomic positions, and a hash of the (folded)
+k-points, symmetries and spin type which together determine the reduced k-point set.
+Entries with the same species, lattice and hash are compatible, and the one with the
+smallest RMS atomic displacement (within maxDisplacement) initializes the new calculation.
+Differences in cutoff and number of bands are handled by the usual wavefunction read conversion.
+*/
+
+//! Database of converged electronic states used to initialize calculations of nearby structures
+class StateStore
+{
+public:
+	string directory; //!< directory containing the index and state files
+	double maxDisplacement; //!< maximum RMS atomic displacement (bohrs) for an entry to be used
+
+	StateStore();
+	
+	//! Initialize wavefunctions, fillings and fluid state from the nearest compatible entry, if any.
+	//! Must be called after k-point folding and symmetry setup, but before eInfo.setup.
+	void lookup(Everything& e);
+	
+	//! Save the current state to the directory and add its fingerprint to the index (collective)
+	void save(const Everything& e) const;
+	
+private:
+	struct Entry
+	{	std::string id; //!< prefix of state filenames within directory
+		uint64_t basisHash; //!< hash of folded k-points, symmetries and spin type
+		int fluidType; //!< fluid type of the stored fluid state (FluidNone if absent)
+		vector3<int> S; //!< charge-density grid dimensions
+		int nBands; //!< number of bands in stored wavefunctions
+		double Ecut; //!< wavefunction cutoff of stored wavefunctions
+		matrix3<> R; //!< lattice vectors
+		std::vector<std::string> speciesNames;
+		std::vector<std::vector<vector3<>>> atpos; //!< atomic positions (lattice coordinates) by species
+		
+		bool compatible(const Entry& other) const; //!< whether other can initialize a calculation with this fingerprint
+		double distance(const Entry& other) const; //!< RMS atomic displacement (bohrs) from other, with minimum-image convention
+		std::string toString() const; //!< single-line representation in the index (excluding id)
+		bool fromString(const std::string& line); //!< parse an index line, returning false if malformed
+	};
+	
+	Entry fingerprint(const Everything& e) const;
+	string indexFilename() const;
+	string stateFilename(const std::string& id, const char* varName) const;
+	uint64_t basisHash; //!< basis hash of the current calculation (set by lookup from the folded k-points)
+};
+
+//! @}
+#endif //JDFTX_ELECTRONIC_STATESTORE_H
@@ -31,7 +31,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 static const int lMaxSpherical = 3;
 
-Symmetries::Symmetries() : symSpherical(lMaxSpherical+1), symSpinAngle(lMaxSpherical+1), kReduceUseInversion(true), sup(vector3<int>(1,1,1)), isPertSup(false)
+Symmetries::Symmetries() : symSpherical(lMaxSpherical+1), symSpinAngle(lMaxSpherical+1), kReduceUseInversion(true), irreducibleGrid(false), iIrredStart(0), iIrredStop(0), sup(vector3<int>(1,1,1)), isPertSup(false)
 {	shouldPrintMatrices = false;
 }
 
@@ -60,6 +60,7 @@ void Symmetries::setup(const Everything& everything)
 void Symmetries::setupMesh()
 {	checkFFTbox(); //Check that the FFT box is commensurate with the symmetries and initialize mesh matrices
 	initSymmIndex(); //Initialize the equivalence classes for scalar field symmetrization (using mesh matrices)
+	if(irreducibleGrid) initIrreducibleGrid(); //Initialize real-space orbits for pointwise functionals
 }
 
 //Pack and unpack kpoint map entry to a single 64-bit integer
@@ -172,32 +173,29 @@ void Symmetries::symmetrize(complexScalarFieldTilde& x) const
 }
 void Symmetries::symmetrize(ScalarFieldArray& x) const
 {	if(sym.size()==1) return; // No symmetries, nothing to do
-	if(x.size()<=2) { for(ScalarField& x_s: x) symmetrize(x_s); } //everything but vector-spin mode
-	else
-	{	assert(x.size() == 4); //must be vector-spin
-		std::vector<complexScalarFieldTilde> xTilde(x.size());
-		for(unsigned s=0; s<x.size(); s++) xTilde[s] = J(Complex(x[s]));
-		symmetrize(xTilde);
-		for(unsigned s=0; s<x.size(); s++) x[s] = Real(I(xTilde[s]));
-	}
+	if(x.size()==1) { symmetrize(x[0]); return; }
+	//Symmetrize all spin components together in reciprocal space:
+	std::vector<complexScalarFieldTilde> xTilde(x.size());
+	for(unsigned s=0; s<x.size(); s++) xTilde[s] = J(Complex(x[s]));
+	symmetrize(xTilde);
+	for(unsigned s=0; s<x.size(); s++) x[s] = Real(I(xTilde[s]));
 }
 void Symmetries::symmetrize(ScalarFieldTildeArray& x) const
 {	if(sym.size()==1) return; // No symmetries, nothing to do
-	if(x.size()<=2) { for(ScalarFieldTilde& x_s: x) symmetrize(x_s); } //everything but vector-spin mode
-	else
-	{	assert(x.size() == 4); //must be vector-spin
-		std::vector<complexScalarFieldTilde> xComplex(x.size());
-		for(unsigned s=0; s<x.size(); s++) xComplex[s] = Complex(x[s]);
-		symmetrize(xComplex);
-		for(unsigned s=0; s<x.size(); s++) x[s] = Real(xComplex[s]);
-	}
+	if(x.size()==1) { symmetrize(x[0]); return; }
+	//Symmetrize all spin components together:
+	std::vector<complexScalarFieldTilde> xComplex(x.size());
+	for(unsigned s=0; s<x.size(); s++) xComplex[s] = Complex(x[s]);
+	symmetrize(xComplex);
+	for(unsigned s=0; s<x.size(); s++) x[s] = Real(xComplex[s]);
 }
 void Symmetries::symmetrize(std::vector<complexScalarFieldTilde>& x) const
 {	if(sym.size()==1) return; // No symmetries, nothing to do
-	if(x.size()<=2) { for(complexScalarFieldTilde& x_s: x) symmetrize(x_s); } //everything but vector-spin mode
+	int nSymmClasses = symmIndex.nData() / sym.size(); //number of equivalence classes
+	if(x.size()<=2) //everything but vector-spin mode: components symmetrize independently (in one pass)
+		callPref(eblas_symmetrize)(nSymmClasses, sym.size(), symmIndex.dataPref(), symmMult.dataPref(), symmIndexPhase.dataPref(), dataPref(x));
 	else
 	{	assert(x.size() == 4); //must be vector-spin
-		int nSymmClasses = symmIndex.nData() / sym.size(); //number of equivalence classes
 		callPref(eblas_symmetrize)(nSymmClasses, sym.size(), symmIndex.dataPref(), symmMult.dataPref(), symmIndexPhase.dataPref(), symmRotSpin.dataPref(), dataPref(x));
 	}
 }
@@ -241,18 +239,26 @@ void Symmetries::symmetrizeSpherical(matrix& X, const SpeciesInfo* specie) const
 	assert(X.nCols()==nTot);
 	if(!l || sym.size()==1) return; //symmetries do nothing
 	const std::vector<matrix>& sym_l = getSphericalMatrices(l, specie->isRelativistic());
-	matrix result;
+	//Split into blocks for each pair of atoms:
+	int nPairs = nAtoms*nAtoms;
+	std::vector<matrix> Xpair(nPairs), resultPair(nPairs);
+	for(int atom1=0; atom1<nAtoms; atom1++)
+		for(int atom2=0; atom2<nAtoms; atom2++)
+			Xpair[atom1*nAtoms+atom2] = X(atom1*orbCount,(atom1+1)*orbCount, atom2*orbCount,(atom2+1)*orbCount);
 	for(unsigned iRot=0; iRot<sym_l.size(); iRot++)
-	{	//Construct transformation matrix including atom maps:
-		matrix m = zeroes(nTot, nTot);
-		for(int atom=0; atom<nAtoms; atom++)
-		{	int atomOut = atomMap[sp][atom][iRot];
-			m.set(atomOut*orbCount,(atomOut+1)*orbCount, atom*orbCount,(atom+1)*orbCount, sym_l[iRot]);
-		}
-		//Apply
-		result += m * X * dagger(m);
+	{	//Rotate all blocks in batched small GEMMs (instead of applying a sparse nTot x nTot transformation):
+		std::vector<matrix> symPair(nPairs, sym_l[iRot]);
+		std::vector<matrix> XpairRot = multiply(multiply(symPair, Xpair), symPair, CblasNoTrans, CblasConjTrans);
+		//Accumulate to the block of the mapped pair of atoms:
+		for(int atom1=0; atom1<nAtoms; atom1++)
+			for(int atom2=0; atom2<nAtoms; atom2++)
+			{	int iPairOut = atomMap[sp][atom1][iRot]*nAtoms + atomMap[sp][atom2][iRot];
+				resultPair[iPairOut] += XpairRot[atom1*nAtoms+atom2];
+			}
 	}
-	X = (1./sym_l.size()) * result;
+	for(int atom1=0; atom1<nAtoms; atom1++)
+		for(int atom2=0; atom2<nAtoms; atom2++)
+			X.set(atom1*orbCount,(atom1+1)*orbCount, atom2*orbCount,(atom2+1)*orbCount, (1./sym_l.size()) * resultPair[atom1*nAtoms+atom2]);
 }
 
 
@@ -404,74 +410,70 @@ bool magMomEquivalent(const vector3<>& a, const vector3<>& b)
 
 std::vector<SpaceGroupOp> Symmetries::findSpaceGroup(const std::vector< matrix3<int> >& symLattice) const
 {	std::vector<SpaceGroupOp> spaceGroup;
+	const IonInfo& iInfo = e->iInfo;
+	const matrix3<> metric = (~e->gInfo.R) * e->gInfo.R;
+	const matrix3<> invSup = inv(Diag(vector3<>(sup)));
+	//Lookup tables for atom positions of each species (shared by all rotations and offsets):
+	std::vector<std::shared_ptr<PeriodicLookup<vector3<>>>> plook;
+	for(auto sp: iInfo.species)
+		plook.push_back(std::make_shared<PeriodicLookup<vector3<>>>(sp->atpos, metric));
+	//Pivot atom, whose images determine the candidate offsets (first atom of first non-empty species):
+	int spPivot = -1;
+	for(size_t sp=0; sp<iInfo.species.size(); sp++)
+		if(iInfo.species[sp]->atpos.size())
+		{	spPivot = sp;
+			break;
+		}
+	
 	//Loop over lattice symmetries:
 	for(const matrix3<int>& rot: symLattice)
 	{	matrix3<> rotCart = e->gInfo.R * rot * inv(e->gInfo.R); //cartesian rotation matrix
 		matrix3<> rotSpin = rotCart * (1./det(rotCart)); //spin is a pseudo-vector invariant under inversion
-		//Determine offsets after this rotation that map the structure onto itself 
-		std::vector<vector3<>> aArr; //list of candidates for the offset
-		bool firstAtom = true;
-		for(auto sp: e->iInfo.species)
-		{	const std::vector< vector3<> >* M = sp->initialMagneticMoments.size() ? &sp->initialMagneticMoments : 0;
-			for(size_t a1=0; a1<sp->atpos.size(); a1++)
-			{
-				//Generate list of offsets that would work for current atom by itself:
-				std::vector<vector3<>> aCur;
-				PeriodicLookup<vector3<>> plook(aCur, (~e->gInfo.R) * e->gInfo.R);
-				vector3<> pos1rot = rot*sp->atpos[a1]; //rotated version of a1 position
-				vector3<> M1rot; if(M) M1rot = (e->eInfo.spinType==SpinVector ? rotSpin*(*M)[a1] : (*M)[a1]); //original or rotated M[a1] depending on spin type
-				for(size_t a2=0; a2<sp->atpos.size(); a2++)
-					if( (!M) || magMomEquivalent(M1rot, (*M)[a2]) )
-					{	vector3<> dpos = Diag(sup) * (sp->atpos[a2] - pos1rot); //note in unit cell coordinates (matters if this is a phonon supercell)
-						for(int k=0; k<3; k++) dpos[k] -= floor(0.5+dpos[k]); //wrap offset to base cell
-						if(plook.find(dpos) == string::npos) //keep offsets unique modulo unit cell (rather than supercell in the phonon case)
-						{	plook.addPoint(aCur.size(), dpos);
-							aCur.push_back(dpos);
-						}
-					}
-				
-				//Intersect current candidates with global list:
-				if(firstAtom)
-				{	aArr = aCur; //no previous list; intersection = current
-					firstAtom = false;
-					continue;
-				}
-				std::vector<vector3<>> aNext; //intersection results
-				if(aCur.size())
-				{	for(vector3<> a: aArr)
-						if(plook.find(a) != string::npos)
-							aNext.push_back(a);
-				}
-				aArr = aNext;
-				
-				if(!aArr.size()) break;
-			}
-			if(!aArr.size()) break;
-		}
 		
 		//Special handling for system with no atoms:
-		if(firstAtom)
+		if(spPivot < 0)
 		{	spaceGroup.push_back(SpaceGroupOp(rot, vector3<>())); //space group = point group
 			continue;
 		}
 		
-		//Refine offsets:
-		for(vector3<>& a: aArr)
-		{	a = inv(Diag(vector3<>(sup))) * a; //switch offset back to current cell coordinates (matters if this is a phonon supercell)
-			vector3<> daSum; int nAtoms = 0.;
-			for(auto sp: e->iInfo.species) //For each species
-			{	PeriodicLookup< vector3<> > plook(sp->atpos, (~e->gInfo.R) * e->gInfo.R);
-				const std::vector< vector3<> >* M = sp->initialMagneticMoments.size() ? &sp->initialMagneticMoments : 0;
-				for(size_t a1=0; a1<sp->atpos.size(); a1++) //For each atom
-				{	vector3<> pos1rot = rot*sp->atpos[a1] + a; //now including offset
+		//Candidate offsets that map the pivot atom onto an equivalent atom:
+		std::vector<vector3<>> aArr;
+		{	const SpeciesInfo& sp = *(iInfo.species[spPivot]);
+			const std::vector< vector3<> >* M = sp.initialMagneticMoments.size() ? &sp.initialMagneticMoments : 0;
+			PeriodicLookup<vector3<>> plookA(aArr, metric, sp.atpos.size());
+			vector3<> pos1rot = rot*sp.atpos[0]; //rotated version of pivot position
+			vector3<> M1rot; if(M) M1rot = (e->eInfo.spinType==SpinVector ? rotSpin*(*M)[0] : (*M)[0]); //original or rotated M depending on spin type
+			for(size_t a2=0; a2<sp.atpos.size(); a2++)
+				if( (!M) || magMomEquivalent(M1rot, (*M)[a2]) )
+				{	vector3<> dpos = Diag(sup) * (sp.atpos[a2] - pos1rot); //note in unit cell coordinates (matters if this is a phonon supercell)
+					for(int k=0; k<3; k++) dpos[k] -= floor(0.5+dpos[k]); //wrap offset to base cell
+					if(plookA.find(dpos) == string::npos) //keep offsets unique modulo unit cell (rather than supercell in the phonon case)
+					{	plookA.addPoint(aArr.size(), dpos);
+						aArr.push_back(dpos);
+					}
+				}
+		}
+		
+		//Check each candidate against all atoms (most invalid candidates fail within the first few atoms),
+		//and refine the valid ones using the average mismatch of the mapped atoms:
+		for(vector3<> a: aArr)
+		{	a = invSup * a; //switch offset back to current cell coordinates (matters if this is a phonon supercell)
+			vector3<> daSum; int nAtoms = 0;
+			bool valid = true;
+			for(size_t sp=0; valid and sp<iInfo.species.size(); sp++) //For each species
+			{	const SpeciesInfo& spInfo = *(iInfo.species[sp]);
+				const std::vector< vector3<> >* M = spInfo.initialMagneticMoments.size() ? &spInfo.initialMagneticMoments : 0;
+				for(size_t a1=0; a1<spInfo.atpos.size(); a1++) //For each atom
+				{	vector3<> pos1rot = rot*spInfo.atpos[a1] + a; //now including offset
 					vector3<> M1rot; if(M) M1rot = (e->eInfo.spinType==SpinVector ? rotSpin*(*M)[a1] : (*M)[a1]); //original or rotated M[a1] depending on spin type
-					size_t a2 = plook.find(pos1rot, M1rot, M, magMomEquivalent); //match position and magentic moment
-					assert(a2 != string::npos); //the above algorithm should guarantee this
-					vector3<> da = sp->atpos[a2] - pos1rot;
+					size_t a2 = plook[sp]->find(pos1rot, M1rot, M, magMomEquivalent); //match position and magentic moment
+					if(a2 == string::npos) { valid = false; break; }
+					vector3<> da = spInfo.atpos[a2] - pos1rot;
 					for(int k=0; k<3; k++) da[k] -= floor(0.5+da[k]);
 					daSum += da; nAtoms++;
 				}
 			}
+			if(!valid) continue;
 			a += daSum / nAtoms;
 			spaceGroup.push_back(SpaceGroupOp(rot, a));
 		}
@@ -536,6 +538,73 @@ void Symmetries::initSymmIndex()
 	memcpy(symmRotSpin.data(), &symmRotSpinVec[0], sym.size()*sizeof(matrix3<>));
 }
 
+void Symmetries::initIrreducibleGrid()
+{	const GridInfo& gInfo = e->gInfo;
+	const vector3<int>& S = gInfo.S;
+	if(sym.size()==1) return;
+	
+	//Mesh rotations and translations (which must be commensurate for a real-space orbit map):
+	std::vector<matrix3<int>> mMesh(sym.size());
+	std::vector<vector3<int>> aMesh(sym.size());
+	for(unsigned iRot=0; iRot<sym.size(); iRot++)
+	{	mMesh[iRot] = Diag(S) * sym[iRot].rot;
+		for(int i=0; i<3; i++)
+			for(int j=0; j<3; j++)
+				mMesh[iRot](i,j) /= S[j]; //exact, as checked by checkFFTbox()
+		for(int k=0; k<3; k++)
+		{	double aS = sym[iRot].a[k] * S[k];
+			aMesh[iRot][k] = int(round(aS));
+			if(fabs(aS - aMesh[iRot][k]) > symmThreshold)
+			{	logPrintf("Irreducible grid disabled: translations are not commensurate with the FFT box.\n");
+				return;
+			}
+		}
+	}
+	
+	//Collect orbits of all grid points in order (representative first):
+	irredStart.clear(); irredIndex.clear();
+	irredStart.reserve(gInfo.nr / sym.size() + 1);
+	irredIndex.reserve(gInfo.nr);
+	std::vector<bool> done(gInfo.nr, false);
+	vector3<int> iv;
+	for(iv[0]=0; iv[0]<S[0]; iv[0]++)
+	for(iv[1]=0; iv[1]<S[1]; iv[1]++)
+	for(iv[2]=0; iv[2]<S[2]; iv[2]++)
+	{	int i = gInfo.fullRindex(iv);
+		if(done[i]) continue;
+		irredStart.push_back(irredIndex.size());
+		irredIndex.push_back(i); done[i] = true;
+		for(unsigned iRot=1; iRot<sym.size(); iRot++)
+		{	vector3<int> iv2 = mMesh[iRot] * iv + aMesh[iRot];
+			for(int k=0; k<3; k++)
+				iv2[k] = positiveRemainder(iv2[k], S[k]);
+			int i2 = gInfo.fullRindex(iv2);
+			if(!done[i2])
+			{	irredIndex.push_back(i2);
+				done[i2] = true;
+			}
+		}
+	}
+	size_t nOrbits = irredStart.size();
+	irredStart.push_back(irredIndex.size());
+	TaskDivision(nOrbits, mpiWorld).myRange(iIrredStart, iIrredStop);
+	logPrintf("Irreducible grid: %lu of %lu real-space points (reduction factor %.1lf) for pointwise functionals.\n",
+		nOrbits, irredIndex.size(), double(irredIndex.size())/nOrbits);
+}
+
+void Symmetries::gatherIrreducible(const double* in, double* out) const
+{	for(size_t iOrbit=iIrredStart; iOrbit<iIrredStop; iOrbit++)
+		*(out++) = in[irredIndex[irredStart[iOrbit]]];
+}
+
+void Symmetries::scatterIrreducible(const double* in, double* out) const
+{	for(size_t iOrbit=iIrredStart; iOrbit<iIrredStop; iOrbit++)
+	{	double inCur = *(in++);
+		for(int j=irredStart[iOrbit]; j<irredStart[iOrbit+1]; j++)
+			out[irredIndex[j]] += inCur;
+	}
+}
+
 void Symmetries::sortSymmetries()
 {	//Ensure first matrix is identity:
 	SpaceGroupOp id;
@@ -564,8 +633,10 @@ void Symmetries::checkFFTbox()
 				}
 	}
 	
-	//Check embedded truncation center:
-	if(e->coulombParams.embed)
+	//Check embedded truncation center (also the Efield ramp center without embedding):
+	vector3<> RT_Efield_ramp, RT_Efield_wave;
+	e->coulombParams.splitEfield(e->gInfo.R, RT_Efield_ramp, RT_Efield_wave);
+	if(e->coulombParams.embed || RT_Efield_ramp.length_squared())
 	{	const vector3<>& c = e->coulombParams.embedCenter;
 		for(const SpaceGroupOp& op: sym)
 		{	vector3<> cRot = op.rot*c + op.a;
@@ -60,6 +60,13 @@ public:
 	const std::vector<std::vector<std::vector<int> > >& getAtomMap() const; //!< direct access to mapping of each atom under each symmetry matrix (index order species, atom, symmetry)
 	void printKmap(FILE* fp) const; //!< print the k-point map (cached in kmap)
 	
+	//! Irreducible real-space grid points for evaluating pointwise functions of symmetric fields once per orbit.
+	//! Orbits are divided over processes in mpiWorld; all functions below act only on the local orbits.
+	bool hasIrreducibleGrid() const { return irredStart.size(); } //!< whether irreducible grid is available (enabled, with commensurate translations)
+	size_t nIrreducible() const { return iIrredStop - iIrredStart; } //!< number of irreducible points (orbits) on current process
+	void gatherIrreducible(const double* in, double* out) const; //!< collect values at local orbit representatives of full-grid in into compact out
+	void scatterIrreducible(const double* in, double* out) const; //!< accumulate compact in to all points of each local orbit in full-grid out
+	
 	static matrix getSpinorRotation(const matrix3<>& rot); //calculate spinor rotation from Cartesian rotation matrix
 private:
 	const Everything* e;
@@ -75,7 +82,10 @@ private:
 	friend struct CommandDebug;
 	friend struct CommandKpointReduceInversion;
 	
+	friend struct CommandSymmetryIrreducibleGrid;
+	
 	bool kReduceUseInversion; //!< whether to use inversion symmetry to reduce k-point mesh
+	bool irreducibleGrid; //!< whether to set up the irreducible real-space grid for pointwise functionals
 	bool shouldPrintMatrices;
 	
 	void calcSymmetries(); //!< Calculate symmetries of the entire system
@@ -94,6 +104,12 @@ private:
 	ManagedArray<matrix3<>> symmRotSpin; //nSym Cartesian (pseudo-vector) rotation matrices for spin-density symmetrization
 	void initSymmIndex();
 	
+	//Irreducible real-space grid (orbits of grid points under the space group):
+	std::vector<int> irredStart; //!< start of each orbit in irredIndex (one extra entry at end), with the representative first
+	std::vector<int> irredIndex; //!< full-grid indices of points in each orbit
+	size_t iIrredStart, iIrredStop; //!< range of orbits handled by current process
+	void initIrreducibleGrid();
+	
 	//Atom maps:
 	std::vector<std::vector<std::vector<int> > > atomMap;
 	void initAtomMaps();
@@ -20,6 +20,10 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/TetrahedralDOS.h>
 #include <core/LatticeUtils.h>
 #include <core/Util.h>
+#include <core/Thread.h>
+#include <core/ManagedMemory.h>
+#include <core/BlasExtra.h>
+#include <fftw3.h>
 #include <algorithm>
 #include <cfloat>
 #include <map>
@@ -117,9 +121,10 @@ void TetrahedralDOS::setWeights(int iWeight, const std::vector<diagMatrix>& weig
 
 //Replace clusters of eigenvalues that differ by less than Etol, to a single value
 void TetrahedralDOS::weldEigenvalues(double Etol)
-{	std::multimap<double,size_t> eigMap;
+{	std::vector<std::pair<double,size_t>> eigMap(eigs.size()); //eigenvalues with their indices, sorted below (cheaper than a multimap)
 	for(size_t i=0; i<eigs.size(); i++)
-		eigMap.insert(std::make_pair(eigs[i],i));
+		eigMap[i] = std::make_pair(eigs[i],i);
+	std::sort(eigMap.begin(), eigMap.end());
 	for(auto i=eigMap.begin(); i!=eigMap.end();)
 	{	auto j = i;
 		double ePrev = i->first;
@@ -139,8 +144,10 @@ void TetrahedralDOS::weldEigenvalues(double Etol)
 }
 
 //Apply gaussian smoothing of width Esigma
+//(by binning the linear spline on a fine uniform grid and convolving with the gaussian using FFTs)
 TetrahedralDOS::Lspline TetrahedralDOS::gaussSmooth(const Lspline& in, double Esigma) const
 {	assert(Esigma > 0.);
+	static StopWatch watch("TetrahedralDOS::gaussSmooth"); watch.start();
 	//Initialize uniform energy grid:
 	double Emin = in.front().first - 10*Esigma;
 	double Emax = in.back().first + 10*Esigma;
@@ -152,24 +159,62 @@ TetrahedralDOS::Lspline TetrahedralDOS::gaussSmooth(const Lspline& in, double Es
 		"         set it\n to zero (raw output of tetrahedron method).\n" );
 	Lspline out(nE, std::make_pair(0., std::vector<double>(nWeights, 0.)));
 	for(size_t iE=0; iE<nE; iE++) out[iE].first = Emin + iE*dE;
-	//Apply the gaussian smoothing to each channel:
-	const double EsigmaDen = 1./(Esigma*sqrt(2.));
+	
+	//Bin the linear spline on a finer grid (integrals against linear hat functions):
+	const int nSub = 4; //binning grid points per output grid point
+	const double h = dE/nSub, hInv = 1./h;
+	size_t N = 2*((nE*nSub+1)/2); //fine grid size (even, for the real FFT); the 10 sigma margins on either side prevent wrap-around
+	std::vector<std::vector<double>> bins(nWeights, std::vector<double>(N, 0.));
 	for(size_t iIn=0; iIn+1<in.size(); iIn++)
 	{	const double& E0 = in[ iIn ].first; const std::vector<double>& w0 = in[ iIn ].second;
 		const double& E1 = in[iIn+1].first; const std::vector<double>& w1 = in[iIn+1].second;
 		if(E1==E0) continue;
-		size_t iEstart = std::max(floor((E0-10*Esigma-Emin)/dE), 0.);
-		size_t iEstop = std::min(ceil((E1+10*Esigma-Emin)/dE), double(nE));
-		for(size_t iE=iEstart; iE<iEstop; iE++)
-		{	double E = out[iE].first;
-			double e0 = (E-E0)*EsigmaDen;
-			double e1 = (E1-E)*EsigmaDen;
-			double gaussTerm = (exp(-e0*e0) - exp(-e1*e1)) / (2*sqrt(M_PI) * (e0 + e1));
-			double erfTerm = (erf(e0) + erf(e1)) / (2 * (e0 + e1));
+		//Split interval at fine grid points, and integrate the linear spline times each hat exactly (Simpson's rule):
+		double slopeScale = 1./(E1-E0);
+		size_t jStart = floor((E0-Emin)*hInv);
+		for(size_t j=jStart; j+1<N; j++)
+		{	double Ej = Emin + j*h;
+			double x0 = std::max(E0, Ej), x1 = std::min(E1, Ej+h);
+			if(x0 >= E1) break;
+			if(x1 <= x0) continue;
+			double u[3] = { (x0-Ej)*hInv, (0.5*(x0+x1)-Ej)*hInv, (x1-Ej)*hInv }; //fractional position of ends and midpoint in cell
+			double t[3] = { (x0-E0)*slopeScale, (0.5*(x0+x1)-E0)*slopeScale, (x1-E0)*slopeScale }; //fractional position in spline interval
+			double quadW = (x1-x0)/6.;
 			for(int iW=0; iW<nWeights; iW++)
-				out[iE].second[iW] += gaussTerm*(w1[iW] - w0[iW]) + erfTerm*(e0*w1[iW] + e1*w0[iW]);
+			{	double wDiff = w1[iW] - w0[iW];
+				double f[3]; for(int k=0; k<3; k++) f[k] = w0[iW] + t[k]*wDiff;
+				double intU = quadW * (f[0]*u[0] + 4*f[1]*u[1] + f[2]*u[2]); //integral of spline times u
+				double intF = quadW * (f[0] + 4*f[1] + f[2]); //integral of spline
+				bins[iW][j] += intF - intU;
+				bins[iW][j+1] += intU;
+			}
 		}
 	}
+	
+	//Convolve with the gaussian in Fourier space:
+	ManagedArray<double> real; real.init(N);
+	ManagedArray<complex> recip; recip.init(N/2+1);
+	fftw_plan planForward = fftw_plan_dft_r2c_1d(N, real.data(), (fftw_complex*)recip.data(), FFTW_ESTIMATE);
+	fftw_plan planInverse = fftw_plan_dft_c2r_1d(N, (fftw_complex*)recip.data(), real.data(), FFTW_ESTIMATE);
+	std::vector<double> kernel(N/2+1); //fourier transform of the gaussian, including normalization of the FFT pair and the bins
+	double dk = (2*M_PI)/(N*h);
+	for(size_t m=0; m<=N/2; m++)
+	{	double sk = Esigma*dk*m;
+		kernel[m] = exp(-0.5*sk*sk) / (N*h);
+	}
+	for(int iW=0; iW<nWeights; iW++)
+	{	eblas_copy(real.data(), bins[iW].data(), N);
+		fftw_execute(planForward);
+		complex* recipData = recip.data();
+		for(size_t m=0; m<=N/2; m++) recipData[m] *= kernel[m];
+		fftw_execute(planInverse);
+		const double* realData = real.data();
+		for(size_t iE=0; iE<nE; iE++)
+			out[iE].second[iW] = realData[iE*nSub];
+	}
+	fftw_destroy_plan(planForward);
+	fftw_destroy_plan(planInverse);
+	watch.stop();
 	return out;
 }
 
@@ -510,26 +555,37 @@ TetrahedralDOS::Lspline TetrahedralDOS::mergeLsplines(const std::vector<Lspline>
 	return combined;
 }
 
+//Generate the density of states of a single band for a given state offset:
+TetrahedralDOS::Lspline TetrahedralDOS::getBandDOS(int iBand, int iSpin, double Etol) const
+{	Cspline wdos;
+	for(const Tetrahedron& t: tetrahedra)
+		accumTetrahedron(t, iBand, iSpin, wdos);
+	Lspline lspline;
+	if(wdos.size()==0 && wdos.deltas.size()==1) // band is a single delta function
+	{	double eDelta = wdos.deltas.begin()->first;
+		const std::vector<double>& wDelta = wdos.deltas.begin()->second;
+		lspline.resize(3, std::make_pair(eDelta, std::vector<double>(nWeights, 0.)));
+		lspline[0].first = eDelta-0.5*Etol;
+		lspline[2].first = eDelta+0.5*Etol;
+		for(int i=0; i<nWeights; i++)
+			lspline[1].second[i] = wDelta[i] * (2./Etol);
+	}
+	else
+	{	coalesceIntervals(wdos);
+		lspline = convertLspline(wdos);
+	}
+	return lspline;
+}
+
 //Generate the density of states for a given state offset:
 TetrahedralDOS::Lspline TetrahedralDOS::getDOS(int iSpin, double Etol) const
-{	std::vector<Lspline> lsplines(nBands);
-	for(int iBand=0; iBand<nBands; iBand++)
-	{	Cspline wdos;
-		for(const Tetrahedron& t: tetrahedra)
-			accumTetrahedron(t, iBand, iSpin, wdos);
-		if(wdos.size()==0 && wdos.deltas.size()==1) // band is a single delta function
-		{	double eDelta = wdos.deltas.begin()->first;
-			const std::vector<double>& wDelta = wdos.deltas.begin()->second;
-			lsplines[iBand].resize(3, std::make_pair(eDelta, std::vector<double>(nWeights, 0.)));
-			lsplines[iBand][0].first = eDelta-0.5*Etol;
-			lsplines[iBand][2].first = eDelta+0.5*Etol;
-			for(int i=0; i<nWeights; i++)
-				lsplines[iBand][1].second[i] = wDelta[i] * (2./Etol);
-		}
-		else
-		{	coalesceIntervals(wdos);
-			lsplines[iBand] = convertLspline(wdos);
-		}
-	}
+{	//Bands are independent until the final merge: process them in parallel
+	//(dynamically scheduled, since the spline sizes and hence costs vary between bands)
+	std::vector<Lspline> lsplines(nBands);
+	auto getBands = [&](size_t bStart, size_t bStop)
+	{	for(size_t iBand=bStart; iBand<bStop; iBand++)
+			lsplines[iBand] = getBandDOS(iBand, iSpin, Etol);
+	};
+	threadLaunchDynamic(0, &getBands, nBands, 1);
 	return mergeLsplines(lsplines);
 }
@@ -59,7 +59,7 @@ public:
 	typedef std::pair<double, std::vector<double> > LsplineElem; //!< Single rnergy and DOS values with all weights at that energy
 	typedef std::vector<LsplineElem> Lspline; //!< Set of all energy and DOS values as a linear spline
 
-	//! Generate the density of states for a given spin channel
+	//! Generate the density of states for a given spin channel (bands processed in parallel over threads).
 	//! Etol sets the width of the delta-function DOS of bands that are completely flat (potentially welded within Etol)
 	Lspline getDOS(int iSpin, double Etol) const;
 
@@ -91,6 +91,9 @@ private:
 	//! The Cspline object must be coalesced before passing to this function
 	Lspline convertLspline(const struct Cspline& cspline) const;
 
+	//! Density of states contribution of a single band (used by getDOS)
+	Lspline getBandDOS(int iBand, int iSpin, double Etol) const;
+
 	//! Collect contributions from multiple linear splines (one for each band)
 	Lspline mergeLsplines(const std::vector<Lspline>& lsplines) const;
 };
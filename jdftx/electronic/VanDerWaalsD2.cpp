@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/SpeciesInfo_internal.h>
 #include <core/VectorField.h>
 #include <core/Units.h>
+#include <core/NeighborList.h>
 
 const static int atomicNumberMaxGrimme = 54;
 const static int atomicNumberMax = 118;
@@ -171,52 +172,39 @@ double VanDerWaalsD2::energyAndGrad(std::vector<Atom>& atoms, const double scale
 
 	//Truncate summation at 1/r^6 < 10^-16 => r ~ 100 bohrs
 	const double rCut = e.iInfo.ljOverride ? e.iInfo.ljOverride : 200.;
-	vector3<bool> isTruncated = e.coulombParams.isTruncated();
-	vector3<int> S; //number of unit cells sampled in each direction
-	for(int k=0; k<3; k++)
-		S[k] = 1 + 2*(isTruncated[k] ? 0 : (int)ceil(rCut/e.gInfo.R.column(k).length()));
-	size_t nCellsHlf = S[0] * S[1] * (S[2]/2+1);; //similar to the half-G-space used for FFTs
-	size_t iStart, iStop; TaskDivision(nCellsHlf, mpiWorld).myRange(iStart, iStop);
+	std::vector<vector3<>> pos(atoms.size());
+	for(size_t c=0; c<atoms.size(); c++)
+		pos[c] = atoms[c].pos;
+	NeighborList neighbors(e.gInfo.R, e.coulombParams.isTruncated(), pos, rCut);
 	
-	double Etot = 0.;  //Total VDW Energy
-	std::vector<vector3<>> forces(atoms.size()); //VDW forces per atom
-	matrix3<> E_RRT; //Stress * volume (updated only if E_RRTptr is non-null)
-	for(int c1=0; c1<int(atoms.size()); c1++)
+	//Total VDW energy, forces per atom and stress * volume (updated only if E_RRTptr is non-null):
+	NeighborList::PairSum sum = neighbors.accumulatePairs(atoms.size(),
+		[&](NeighborList::PairSum& sum, int c1, int c2, const vector3<>& x, double rSq)
 	{	const AtomParams& c1params = getParams(atoms[c1].atomicNumber, atoms[c1].sp);
-		for(int c2=0; c2<int(atoms.size()); c2++)
-		{	const AtomParams& c2params = getParams(atoms[c2].atomicNumber, atoms[c2].sp);
-			double C6 = sqrt(c1params.C6 * c2params.C6);
-			double R0 = c1params.R0 + c2params.R0;
-			THREAD_halfGspaceLoop(
-				const vector3<int>& iR = iG;
-				vector3<> x = iR + (atoms[c1].pos - atoms[c2].pos);
-				double rSq = e.gInfo.RTR.metric_length_squared(x);
-				if(rSq)
-				{	double r = sqrt(rSq); double E_r = 0.;
-					double cellWeight = (iR[2] ? 1. : 0.5); //account for double-counting in half-space cut plane
-					Etot -= cellWeight * scaleFac * vdwPairEnergyAndGrad(r, C6, R0, E_r, e.iInfo.ljOverride);
-					vector3<> E_x = (cellWeight * scaleFac * E_r/r) * (e.gInfo.RTR * x); 
-					forces[c1] += E_x;
-					forces[c2] -= E_x;
-					if(E_RRTptr)
-					{	const vector3<> rVec = e.gInfo.R * x;
-						E_RRT -= (cellWeight * scaleFac * E_r/r) * outer(rVec, rVec);
-					}
-				}
-			)
+		const AtomParams& c2params = getParams(atoms[c2].atomicNumber, atoms[c2].sp);
+		double C6 = sqrt(c1params.C6 * c2params.C6);
+		double R0 = c1params.R0 + c2params.R0;
+		double r = sqrt(rSq); double E_r = 0.;
+		sum.E -= scaleFac * vdwPairEnergyAndGrad(r, C6, R0, E_r, e.iInfo.ljOverride);
+		vector3<> E_x = (scaleFac * E_r/r) * (e.gInfo.RTR * x); 
+		sum.forces[c1] += E_x;
+		sum.forces[c2] -= E_x;
+		if(E_RRTptr)
+		{	const vector3<> rVec = e.gInfo.R * x;
+			sum.E_RRT -= (scaleFac * E_r/r) * outer(rVec, rVec);
 		}
-	}
+	});
 	//Collect over MPI:
-	mpiWorld->allReduce(Etot, MPIUtil::ReduceSum, true);
-	mpiWorld->allReduceData(forces, MPIUtil::ReduceSum, true);
+	mpiWorld->allReduce(sum.E, MPIUtil::ReduceSum, true);
+	mpiWorld->allReduceData(sum.forces, MPIUtil::ReduceSum, true);
 	for(int c=0; c<int(atoms.size()); c++)
-		atoms[c].force += forces[c];
+		atoms[c].force += sum.forces[c];
 	if(E_RRTptr)
-	{	mpiWorld->allReduce(E_RRT, MPIUtil::ReduceSum, true);
-		*E_RRTptr += E_RRT;
+	{	mpiWorld->allReduce(sum.E_RRT, MPIUtil::ReduceSum, true);
+		*E_RRTptr += sum.E_RRT;
 	}
 	watch.stop();
-	return Etot;
+	return sum.E;
 }
 
 
@@ -140,73 +140,97 @@ template<int n, int alpha_n> double vdWpotential(double invr, double R0, double&
 }
 
 
+//Real part of dot product of row and column vectors a and b (stored as matrices)
+inline double dotReal(const matrix& a, const matrix& b)
+{	const complex* aData = a.data();
+	const complex* bData = b.data();
+	double result = 0.;
+	for(size_t j=0; j<a.nData(); j++)
+		result += (aData[j] * bData[j]).real();
+	return result;
+}
+
+
 double VanDerWaalsD3::energyAndGrad(std::vector<Atom>& atoms, const double scaleFac, matrix3<>* E_RRTptr) const
 {	static StopWatch watch("VanDerWaalsD3::energyAndGrad"); watch.start();
 	const double rCut = e.iInfo.ljOverride ? e.iInfo.ljOverride : 200.; //Truncate summation at 1/r^6 ~ 10^-16
-	const double rCutSq = rCut*rCut;
-	vector3<int> S; size_t iStart, iStop; //Number of unit cells in supercell to reach rCut and MPI division
-	setNeighborSampling(rCut, S, iStart, iStop);
+	const double rCutCN = 50.; //Damping factor in CN calculation drops off more quickly than dispersion term
+	const int nAtoms = atoms.size();
 	logPrintf("\nComputing DFT-D3 correction:\n");
 
 	//Get coordination numbers:
+	NeighborList neighborsCN = getNeighbors(atoms, rCutCN);
 	std::vector<double> CN;
-	computeCN(atoms, CN);
+	computeCN(neighborsCN, atoms, CN);
+	
+	//C6 interpolation weights per atom, and their contractions with C6 coefficients of each partner species:
+	int nSpecies = atomParams.size();
+	std::vector<matrix> L(nAtoms), Lprime(nAtoms);
+	std::vector<std::vector<matrix>> LC(nAtoms, std::vector<matrix>(nSpecies)), LprimeC = LC; //transpose(L or Lprime) * C6 (row vectors)
+	for(int c=0; c<nAtoms; c++)
+	{	L[c] = atomParams[atoms[c].sp].getL(CN[c], Lprime[c]);
+		for(int sp2=0; sp2<nSpecies; sp2++)
+		{	const matrix& C6sp = pairParams[atoms[c].sp][sp2].C6;
+			LC[c][sp2] = transpose(L[c]) * C6sp;
+			LprimeC[c][sp2] = transpose(Lprime[c]) * C6sp;
+		}
+	}
+	//C6 for each pair (symmetric):
+	std::vector<double> C6(nAtoms*nAtoms);
+	std::vector<double> diagC6(nAtoms); //diagonal C6 for reporting
+	for(int c1=0; c1<nAtoms; c1++)
+		for(int c2=0; c2<nAtoms; c2++)
+			C6[c1*nAtoms+c2] = dotReal(LC[c1][atoms[c2].sp], L[c2]);
+	for(int c=0; c<nAtoms; c++)
+		diagC6[c] = C6[c*nAtoms+c];
 	
 	//Compute energy and direct force/stress contributions :
-	double E6 = 0., E8 = 0.; //!< r^-6 and r^-8 energies
-	std::vector<double> E_CN(atoms.size()); //coordination number gradients
-	std::vector<vector3<>> forces(atoms.size()); //VDW forces per atom
-	matrix3<> E_RRT; //Stress * volume (updated only if E_RRTptr is non-null)
-	std::vector<double> diagC6(atoms.size()); //diagonal C6 for reporting
-	for(int c1=0; c1<int(atoms.size()); c1++)
-	{	const D3::AtomParams& ap1 = atomParams[atoms[c1].sp];
-		matrix L1prime, L1 = ap1.getL(CN[c1], L1prime); //C6 interpolation weights for atom 1
-
-		for(int c2=0; c2<int(atoms.size()); c2++)
-		{	const D3::AtomParams& ap2 = atomParams[atoms[c2].sp];
-			matrix L2prime, L2 = ap2.getL(CN[c2], L2prime); //C6 interpolation weights for atom 2
-
-			//Compute C6 and C8 for this pair:
-			const D3::PairParams& pp = pairParams[atoms[c1].sp][atoms[c2].sp];
-			double ratio8by6 = 3. * ap1.sqrtQ * ap2.sqrtQ;
-			double C6 = trace(transpose(L1) * pp.C6 * L2).real();
-			double C8 = C6 * ratio8by6;
-			if(c1 == c2) diagC6[c1] = C6; //only for reporting
-			
-			//Sum energy, force and stress contributions over periodic images:
-			double E12_C6 = 0., E12_C8 = 0.; //energy contributions upto C6 and C8 prefactors
-			THREAD_halfGspaceLoop(
-				const vector3<int>& iR = iG;
-				vector3<> x = iR + (atoms[c1].pos - atoms[c2].pos);
-				double rSq = e.gInfo.RTR.metric_length_squared(x);
-				if(rSq and rSq<=rCutSq)
-				{	double r = sqrt(rSq);
-					double invr = 1./r;
-					double cellWeight = (iR[2] ? 1. : 0.5); //account for double-counting in half-space cut plane
-					double term6_r; double term6 = (vdWpotential<6, D3::alpha6>(invr, sr6 * pp.R0, term6_r));
-					double term8_r; double term8 = (vdWpotential<8, D3::alpha8>(invr, sr8 * pp.R0, term8_r));
-					E12_C6 -= cellWeight * s6 * term6;
-					E12_C8 -= cellWeight * s8 * term8;
-					//Colect forces and/or stresses:
-					double E_r_by_r = (-invr * cellWeight) * (C6*s6*term6_r + C8*s8*term8_r);
-					vector3<> E_x = E_r_by_r * (e.gInfo.RTR * x); 
-					forces[c1] -= E_x;
-					forces[c2] += E_x;
-					if(E_RRTptr)
-					{	const vector3<> rVec = e.gInfo.R * x;
-						E_RRT += E_r_by_r * outer(rVec, rVec);
-					}
-				}
-			)
-			E6 += E12_C6 * C6;
-			E8 += E12_C8 * C8;
-			
-			//Propagate gradients to CN:
-			double E12_C6_tot = E12_C6 + E12_C8 * ratio8by6; //total derivative w.r.t C6
-			E_CN[c1] += E12_C6_tot * trace(transpose(L1prime) * pp.C6 * L2).real();
-			E_CN[c2] += E12_C6_tot * trace(transpose(L1) * pp.C6 * L2prime).real();
+	NeighborList neighbors = getNeighbors(atoms, rCut);
+	std::vector<double> E_C6(nAtoms*nAtoms); //total derivative w.r.t C6 of each pair (c1 <= c2): only written by the thread handling c1
+	int nThreads = NeighborList::nThreads();
+	std::vector<double> E8threads(nThreads); //!< r^-8 energies per thread (r^-6 energies in PairSum::E)
+	std::vector<NeighborList::PairSum> sums(nThreads, NeighborList::PairSum(nAtoms)); //forces and stress * volume per thread
+	neighbors.forEachPairThreaded([&](int iThread, int c1, int c2, const vector3<>& x, double rSq)
+	{	NeighborList::PairSum& sum = sums[iThread];
+		const D3::PairParams& pp = pairParams[atoms[c1].sp][atoms[c2].sp];
+		double ratio8by6 = 3. * atomParams[atoms[c1].sp].sqrtQ * atomParams[atoms[c2].sp].sqrtQ;
+		double C6cur = C6[c1*nAtoms+c2];
+		double C8cur = C6cur * ratio8by6;
+		double r = sqrt(rSq);
+		double invr = 1./r;
+		double term6_r; double term6 = (vdWpotential<6, D3::alpha6>(invr, sr6 * pp.R0, term6_r));
+		double term8_r; double term8 = (vdWpotential<8, D3::alpha8>(invr, sr8 * pp.R0, term8_r));
+		sum.E -= s6 * term6 * C6cur;
+		E8threads[iThread] -= s8 * term8 * C8cur;
+		E_C6[c1*nAtoms+c2] -= s6 * term6 + s8 * term8 * ratio8by6;
+		//Colect forces and/or stresses:
+		double E_r_by_r = (-invr) * (C6cur*s6*term6_r + C8cur*s8*term8_r);
+		vector3<> E_x = E_r_by_r * (e.gInfo.RTR * x); 
+		sum.forces[c1] -= E_x;
+		sum.forces[c2] += E_x;
+		if(E_RRTptr)
+		{	const vector3<> rVec = e.gInfo.R * x;
+			sum.E_RRT += E_r_by_r * outer(rVec, rVec);
 		}
+	});
+	double E8 = 0.;
+	for(int t=0; t<nThreads; t++)
+	{	if(t) sums[0] += sums[t];
+		E8 += E8threads[t];
 	}
+	double E6 = sums[0].E;
+	std::vector<vector3<>>& forces = sums[0].forces; //VDW forces per atom
+	matrix3<>& E_RRT = sums[0].E_RRT; //Stress * volume (updated only if E_RRTptr is non-null)
+	
+	//Propagate gradients to CN:
+	std::vector<double> E_CN(nAtoms); //coordination number gradients
+	for(int c1=0; c1<nAtoms; c1++)
+		for(int c2=c1; c2<nAtoms; c2++)
+		{	double E_C6cur = E_C6[c1*nAtoms+c2];
+			if(!E_C6cur) continue; //no pairs within range on this process
+			E_CN[c1] += E_C6cur * dotReal(LprimeC[c1][atoms[c2].sp], L[c2]);
+			E_CN[c2] += E_C6cur * dotReal(LC[c1][atoms[c2].sp], Lprime[c2]);
+		}
 	report(diagC6, "diagonal-C6", atoms, " %.2f");
 	mpiWorld->allReduce(E6, MPIUtil::ReduceSum);
 	mpiWorld->allReduce(E8, MPIUtil::ReduceSum);
@@ -215,11 +239,11 @@ double VanDerWaalsD3::energyAndGrad(std::vector<Atom>& atoms, const double scale
 	logPrintf("EvdW_8 = %11.6lf\n", E8);
 	
 	//Propagate gradients w.r.t CN to forces/stresses
-	propagateCNgradient(atoms, E_CN, forces, E_RRTptr ? &E_RRT : NULL);
+	propagateCNgradient(neighborsCN, atoms, E_CN, forces, E_RRTptr ? &E_RRT : NULL);
 
 	//Collect forces and stresses:
 	mpiWorld->allReduceData(forces, MPIUtil::ReduceSum, true);
-	for(int c=0; c<int(atoms.size()); c++)
+	for(int c=0; c<nAtoms; c++)
 		atoms[c].force += forces[c];
 	if(E_RRTptr)
 	{	mpiWorld->allReduce(E_RRT, MPIUtil::ReduceSum, true);
@@ -231,72 +255,49 @@ double VanDerWaalsD3::energyAndGrad(std::vector<Atom>& atoms, const double scale
 
 
 //Compute local coordination number
-void VanDerWaalsD3::computeCN(const std::vector<Atom>& atoms, std::vector<double>& CN) const
-{	const double rCut = 50., rCutSq=rCut*rCut; //Damping factor in CN calculation drops off more quickly than dispersion term
-	vector3<int> S; size_t iStart, iStop; //Number of unit cells in supercell to reach rCut and MPI division
-	setNeighborSampling(rCut, S, iStart, iStop);
+void VanDerWaalsD3::computeCN(const NeighborList& neighborsCN, const std::vector<Atom>& atoms, std::vector<double>& CN) const
+{	std::vector<std::vector<double>> CNthreads(NeighborList::nThreads(), std::vector<double>(atoms.size()));
+	neighborsCN.forEachPairThreaded([&](int iThread, int c1, int c2, const vector3<>& x, double rSq)
+	{	double k2RcovSum = atomParams[atoms[c1].sp].k2Rcov + atomParams[atoms[c2].sp].k2Rcov;
+		double r = sqrt(rSq);
+		double CNterm = 1./(1. + exp(-D3::k1*(k2RcovSum/r - 1.)));
+		CNthreads[iThread][c1] += CNterm;
+		CNthreads[iThread][c2] += CNterm;
+	});
 	CN.assign(atoms.size(), 0.);
-	for(int c1=0; c1<int(atoms.size()); c1++)
-	{	const D3::AtomParams& ap1 = atomParams[atoms[c1].sp];
-		for(int c2=0; c2<int(atoms.size()); c2++)
-		{	const D3::AtomParams& ap2 = atomParams[atoms[c2].sp];
-			double k2RcovSum = ap1.k2Rcov + ap2.k2Rcov;
-			THREAD_halfGspaceLoop(
-				const vector3<int>& iR = iG;
-				vector3<> x = iR + (atoms[c1].pos - atoms[c2].pos);
-				double rSq = e.gInfo.RTR.metric_length_squared(x);
-				if(rSq and rSq<=rCutSq)
-				{	double r = sqrt(rSq);
-					double cellWeight = (iR[2] ? 1. : 0.5); //account for double-counting in half-space cut plane
-					double CNterm = cellWeight/(1. + exp(-D3::k1*(k2RcovSum/r - 1.)));
-					CN[c1] += CNterm;
-					CN[c2] += CNterm;
-				}
-			)
-		}
-	}
+	for(const std::vector<double>& CNthread: CNthreads)
+		for(size_t c=0; c<atoms.size(); c++)
+			CN[c] += CNthread[c];
 	mpiWorld->allReduceData(CN, MPIUtil::ReduceSum);
 	report(CN, "coordination-number", atoms);
 }
 
 
 //Propagate coordination-number gradient to forces, and optionally, stresses:
-void VanDerWaalsD3::propagateCNgradient(const std::vector<Atom>& atoms, const std::vector<double>& E_CN,
+void VanDerWaalsD3::propagateCNgradient(const NeighborList& neighborsCN, const std::vector<Atom>& atoms, const std::vector<double>& E_CN,
 	std::vector<vector3<>>& forces, matrix3<>* E_RRT) const
-{	//Set up same neighbor cells as used in computeCN()
-	const double rCut = 50., rCutSq=rCut*rCut;
-	vector3<int> S; size_t iStart, iStop;
-	setNeighborSampling(rCut, S, iStart, iStop);
-	//Propagate gradients corresponding to computeCN()
-	for(int c1=0; c1<int(atoms.size()); c1++)
-	{	const D3::AtomParams& ap1 = atomParams[atoms[c1].sp];
-		for(int c2=0; c2<int(atoms.size()); c2++)
-		{	const D3::AtomParams& ap2 = atomParams[atoms[c2].sp];
-			double k2RcovSum = ap1.k2Rcov + ap2.k2Rcov;
-			THREAD_halfGspaceLoop(
-				const vector3<int>& iR = iG;
-				vector3<> x = iR + (atoms[c1].pos - atoms[c2].pos);
-				double rSq = e.gInfo.RTR.metric_length_squared(x);
-				if(rSq and rSq<=rCutSq)
-				{	double r = sqrt(rSq);
-					double invr = 1./r;
-					double cellWeight = (iR[2] ? 1. : 0.5); //account for double-counting in half-space cut plane
-					double E_CNterm = E_CN[c1] + E_CN[c2];
-					double expTerm = exp(-D3::k1*(k2RcovSum*invr - 1.));
-					double expTerm_r = expTerm * D3::k1 * (k2RcovSum * invr * invr);
-					double E_r_by_r = (-invr * E_CNterm * cellWeight * expTerm_r) / std::pow(1+expTerm, 2);
-					//Colect forces and/or stresses:
-					vector3<> E_x = E_r_by_r * (e.gInfo.RTR * x); 
-					forces[c1] -= E_x;
-					forces[c2] += E_x;
-					if(E_RRT)
-					{	const vector3<> rVec = e.gInfo.R * x;
-						*E_RRT += E_r_by_r * outer(rVec, rVec);
-					}
-				}
-			)
+{	//Propagate gradients corresponding to computeCN()
+	NeighborList::PairSum sum = neighborsCN.accumulatePairs(atoms.size(),
+		[&](NeighborList::PairSum& sum, int c1, int c2, const vector3<>& x, double rSq)
+	{	double k2RcovSum = atomParams[atoms[c1].sp].k2Rcov + atomParams[atoms[c2].sp].k2Rcov;
+		double r = sqrt(rSq);
+		double invr = 1./r;
+		double E_CNterm = E_CN[c1] + E_CN[c2];
+		double expTerm = exp(-D3::k1*(k2RcovSum*invr - 1.));
+		double expTerm_r = expTerm * D3::k1 * (k2RcovSum * invr * invr);
+		double E_r_by_r = (-invr * E_CNterm * expTerm_r) / std::pow(1+expTerm, 2);
+		//Colect forces and/or stresses:
+		vector3<> E_x = E_r_by_r * (e.gInfo.RTR * x); 
+		sum.forces[c1] -= E_x;
+		sum.forces[c2] += E_x;
+		if(E_RRT)
+		{	const vector3<> rVec = e.gInfo.R * x;
+			sum.E_RRT += E_r_by_r * outer(rVec, rVec);
 		}
-	}
+	});
+	for(size_t c=0; c<atoms.size(); c++)
+		forces[c] += sum.forces[c];
+	if(E_RRT) *E_RRT += sum.E_RRT;
 }
 
 
@@ -314,10 +315,9 @@ void VanDerWaalsD3::report(const std::vector<double>& result, string name, const
 }
 
 
-void VanDerWaalsD3::setNeighborSampling(double rCut, vector3<int>& S, size_t& iStart, size_t& iStop) const
-{	vector3<bool> isTruncated = e.coulombParams.isTruncated();
-	for(int k=0; k<3; k++)
-		S[k] = 1 + 2*(isTruncated[k] ? 0 : (int)ceil(rCut/e.gInfo.R.column(k).length()));
-	size_t nCellsHlf = S[0] * S[1] * (S[2]/2+1);; //similar to the half-G-space used for FFTs
-	TaskDivision(nCellsHlf, mpiWorld).myRange(iStart, iStop);
+NeighborList VanDerWaalsD3::getNeighbors(const std::vector<Atom>& atoms, double rCut) const
+{	std::vector<vector3<>> pos(atoms.size());
+	for(size_t c=0; c<atoms.size(); c++)
+		pos[c] = atoms[c].pos;
+	return NeighborList(e.gInfo.R, e.coulombParams.isTruncated(), pos, rCut);
 }
@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <electronic/VanDerWaals.h>
 #include <core/RadialFunction.h>
+#include <core/NeighborList.h>
 
 //! @addtogroup LongRange
 //! @{
@@ -63,13 +64,13 @@ private:
 	std::vector<D3::AtomParams> atomParams; //!< parameters per atom type
 	std::vector<std::vector<D3::PairParams>> pairParams; //!< parameters per pair of atom types
 	
-	void computeCN(const std::vector<Atom>& atoms, std::vector<double>& CN) const; //!< compute coordination numbers
-	void propagateCNgradient(const std::vector<Atom>& atoms, const std::vector<double>& E_CN,
+	void computeCN(const NeighborList& neighborsCN, const std::vector<Atom>& atoms, std::vector<double>& CN) const; //!< compute coordination numbers
+	void propagateCNgradient(const NeighborList& neighborsCN, const std::vector<Atom>& atoms, const std::vector<double>& E_CN,
 		std::vector<vector3<>>& forces, matrix3<>* E_RRT) const; //!< propagate CN gradient to forces and stresses
 
 	void report(const std::vector<double>& result, string name,
 		const std::vector<Atom>& atoms, const char* fmt=" %.3f") const; //!<report per-atom quantity
-	void setNeighborSampling(double rCut, vector3<int>& S, size_t& iStart, size_t& iStop) const; //!< get neighbor cells within rCut
+	NeighborList getNeighbors(const std::vector<Atom>& atoms, double rCut) const; //!< cell list of atoms for pairs within rCut
 };
 
 //! @}
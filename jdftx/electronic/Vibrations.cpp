@@ -20,11 +20,12 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/Vibrations.h>
 #include <electronic/IonicMinimizer.h>
 #include <electronic/Everything.h>
+#include <electronic/ColumnBundle.h>
 #include <core/LatticeUtils.h>
 #include <core/Units.h>
 
 Vibrations::Vibrations() : dr(0.01), centralDiff(false), useConstraints(false),
-translationSym(true), rotationSym(false), omegaMin(2e-4), T(298*Kelvin), omegaResolution(1e-4)
+translationSym(true), rotationSym(false), omegaMin(2e-4), T(298*Kelvin), omegaResolution(1e-4), nJobs(1), iJob(0)
 {
 }
 
@@ -38,6 +39,51 @@ void Vibrations::setup(Everything* e)
 	}
 }
 
+//Header identifying a displacement in its checkpoint file (to avoid reusing results from a different setup):
+inline std::vector<double> displacementHeader(double dr, unsigned s, unsigned a, const vector3<>& n, double sign)
+{	return std::vector<double>({ dr, double(s), double(a), n[0], n[1], n[2], sign });
+}
+
+//Read forces and electronic dipole moment of a displacement from its checkpoint file, if available and matching header:
+bool readDisplacement(string fname, const std::vector<double>& header, IonicGradient& grad, vector3<>& Pel)
+{	bool found = false;
+	if(mpiWorld->isHead())
+	{	FILE* fp = fopen(fname.c_str(), "rb");
+		if(fp)
+		{	std::vector<double> headerIn(header.size());
+			found = (freadLE(headerIn.data(), sizeof(double), headerIn.size(), fp) == headerIn.size());
+			for(size_t i=0; found and i<header.size(); i++)
+				if(fabs(headerIn[i] - header[i]) > symmThreshold) found = false;
+			for(std::vector<vector3<>>& gradSp: grad)
+				if(found and freadLE(gradSp.data(), sizeof(double), 3*gradSp.size(), fp) < 3*gradSp.size()) found = false;
+			if(found and freadLE(&Pel[0], sizeof(double), 3, fp) < 3) found = false;
+			fclose(fp);
+		}
+	}
+	mpiWorld->bcast(found);
+	if(found)
+	{	for(std::vector<vector3<>>& gradSp: grad)
+			mpiWorld->bcastData(gradSp);
+		mpiWorld->bcast(&Pel[0], 3);
+	}
+	return found;
+}
+
+//Write forces and electronic dipole moment of a displacement to its checkpoint file:
+void writeDisplacement(string fname, const std::vector<double>& header, const IonicGradient& grad, const vector3<>& Pel)
+{	if(!mpiWorld->isHead()) return;
+	FILE* fp = fopen(fname.c_str(), "wb");
+	if(!fp)
+	{	logPrintf("WARNING: could not open '%s' to checkpoint displacement.\n", fname.c_str());
+		return;
+	}
+	fwriteLE(header.data(), sizeof(double), header.size(), fp);
+	for(const std::vector<vector3<>>& gradSp: grad)
+		fwriteLE(gradSp.data(), sizeof(double), 3*gradSp.size(), fp);
+	fwriteLE(&Pel[0], sizeof(double), 3, fp);
+	fclose(fp);
+}
+
 inline void setPtest(size_t iStart, size_t iStop, const vector3<int>& S, std::vector<double*> Ptest, vector3<> split)
 {	vector3<> invS; for(int k=0; k<3; k++) invS[k] = 1./S[k];
 	THREAD_rLoop
@@ -160,43 +206,95 @@ void Vibrations::calculate()
 	threadLaunch(setPtest, e->gInfo.nr, e->gInfo.S, Ptest.data(), getSplit());
 
 	//Get forces in unperturbed configuration
-	int nConfigurations = 1 + nPrimary * (centralDiff ? 2 : 1);
-	int iConfiguration = 0;
-	IonicMinimizer imin(*e);
 	IonicGradient grad0;
-	imin.compute(&grad0, 0);
+	IonicMinimizer(*e).compute(&grad0, 0);
 	vector3<> Pel0 = getPel(); //electronic dipole moment
-	logPrintf("Completed %d of %d configurations.\n", ++iConfiguration, nConfigurations);
+	logPrintf("Completed reference configuration.\n");
+	
+	//Remember reference state, from which each displacement is warm-started:
+	std::vector< std::vector< vector3<> > > atpos0;
+	for(const auto& sp: species) atpos0.push_back(sp->atpos);
+	std::vector<ColumnBundle> C0 = e->eVars.C;
+	std::vector<diagMatrix> Haux0 = e->eVars.Haux_eigs;
+	auto restoreReference = [&]()
+	{	for(unsigned s=0; s<species.size(); s++)
+		{	species[s]->atpos = atpos0[s];
+			species[s]->sync_atpos();
+		}
+		e->eVars.C = C0;
+		e->eVars.Haux_eigs = Haux0;
+	};
+	
+	//Forces and dipole moments at each displacement (along symmetry-irreducible modes, both ways for central differences):
+	struct Displacement
+	{	const Mode* mode;
+		double sign;
+		IonicGradient grad;
+		vector3<> Pel;
+	};
+	std::vector<Displacement> displacements;
+	for(const Mode& mode: modes) if(mode.isPrimary)
+		for(double sign: (centralDiff ? std::vector<double>({+1.,-1.}) : std::vector<double>({+1.})))
+		{	Displacement disp;
+			disp.mode = &mode;
+			disp.sign = sign;
+			disp.grad.init(e->iInfo);
+			displacements.push_back(disp);
+		}
+	int nDisplacements = displacements.size();
+	int nLoaded = 0, nComputed = 0, nOtherJobs = 0;
+	if(nJobs > 1)
+		logPrintf("Computing every %d-th displacement starting at %d (job %d of %d).\n", nJobs, iJob+1, iJob+1, nJobs);
+	for(int iDisp=0; iDisp<nDisplacements; iDisp++)
+	{	Displacement& disp = displacements[iDisp];
+		const Mode& mode = *(disp.mode);
+		ostringstream oss; oss << "vibrations." << iDisp+1;
+		string fname = e->dump.getFilename(oss.str());
+		std::vector<double> header = displacementHeader(dr, mode.s, mode.a, mode.n, disp.sign);
+		//Reuse checkpointed results from a previous (or concurrent) run:
+		if(readDisplacement(fname, header, disp.grad, disp.Pel))
+		{	logPrintf("Read displacement %d of %d from '%s'.\n", iDisp+1, nDisplacements, fname.c_str());
+			nLoaded++;
+			continue;
+		}
+		if(iDisp % nJobs != iJob) { nOtherJobs++; continue; } //handled by another job
+		//Compute forces at displaced position, warm-started from the reference state:
+		restoreReference();
+		IonicGradient d; d.init(e->iInfo);
+		d[mode.s][mode.a] = disp.sign * mode.n; //all others zero
+		IonicMinimizer imin(*e); //fresh minimizer, so that wavefunctions are dragged from the reference rather than extrapolated
+		imin.step(d, dr);
+		imin.compute(&disp.grad, 0);
+		disp.Pel = getPel();
+		writeDisplacement(fname, header, disp.grad, disp.Pel);
+		logPrintf("Completed displacement %d of %d.\n", iDisp+1, nDisplacements);
+		nComputed++;
+	}
+	restoreReference(); //Restore original ionic positions and state
+	logPrintf("Displacements: %d computed, %d read from checkpoints, %d left to other jobs.\n", nComputed, nLoaded, nOtherJobs);
+	if(nOtherJobs)
+	{	logPrintf("After all jobs complete, rerun with nJobs 1 (default) in command vibrations to collect results.\n\n");
+		return;
+	}
 	
 	//Compute force matrix:
 	matrix K = zeroes(nModes, nModes);
 	matrix dP = zeroes(nModes, 3); //dipole derivative
 	{	diagMatrix mult(nModes, 0.); //multiplicity in entries due to symmetrization
-		IonicGradient dPrev; dPrev.init(e->iInfo); //previous displacement (initially zero)
 		complex *Kdata = K.data(), *dPdata = dP.data();
+		int iDisp = 0;
 		for(const Mode& mode: modes) if(mode.isPrimary) //Loop over modes in irredicuble wedge
-		{	//Create ionic gradient object corresponding to mode:
-			IonicGradient d; d.init(e->iInfo);
-			d[mode.s][mode.a] = mode.n; //all others zero
-			//Compute forces at perturbed position:
-			IonicGradient gradPlus, gradMinus, Kcur;
-			imin.step(d-dPrev, dr); dPrev=d;
-			imin.compute(&gradPlus, 0);
-			vector3<> PelPlus = getPel(), PelMinus, dPcur; //electronic dipole moment and derivative w.r.t mode
-			logPrintf("Completed %d of %d configurations.\n", ++iConfiguration, nConfigurations);
-	
+		{	IonicGradient Kcur;
+			vector3<> dPcur; //electronic dipole moment derivative w.r.t mode
+			const Displacement& dispPlus = displacements[iDisp++];
 			if(centralDiff)
-			{	d *= -1;
-				imin.step(d-dPrev, dr); dPrev=d;
-				imin.compute(&gradMinus, 0);
-				PelMinus = getPel();
-				logPrintf("Completed %d of %d configurations.\n", ++iConfiguration, nConfigurations);
-				Kcur = (gradPlus - gradMinus) * (0.5/dr);
-				dPcur = (PelPlus - PelMinus) * (0.5/dr);
+			{	const Displacement& dispMinus = displacements[iDisp++];
+				Kcur = (dispPlus.grad - dispMinus.grad) * (0.5/dr);
+				dPcur = (dispPlus.Pel - dispMinus.Pel) * (0.5/dr);
 			}
 			else
-			{	Kcur = (gradPlus - grad0) * (1./dr);
-				dPcur = (PelPlus - Pel0) * (1./dr);
+			{	Kcur = (dispPlus.grad - grad0) * (1./dr);
+				dPcur = (dispPlus.Pel - Pel0) * (1./dr);
 			}
 			dPcur -= species[mode.s]->Z * mode.n; //ionic contribution to dipole derivative
 			
@@ -225,8 +323,6 @@ void Vibrations::calculate()
 					}
 			}
 		}
-		IonicGradient d; d.init(e->iInfo); //all zeroes
-		imin.step(d-dPrev, dr); dPrev=d; //Restore original ionic positions
 		
 		//Invert multiplicity matrixZero out  modes to be set by translational symmetry:
 		for(int i=0; i<nModes; i++)
@@ -39,6 +39,8 @@ public:
 	double omegaMin; //!< frequency cutoff for free energy calculation and detailed mode print out
 	double T; //!< ionic temperature used for entropy and free energy estimation
 	double omegaResolution; //!< frequency resolution used for identifying and reporting degeneracies
+	int nJobs; //!< number of independent jobs that the displacements are divided between (results collected from checkpoints when 1)
+	int iJob; //!< index of current job (0-based) when nJobs > 1
 	
 	Vibrations();
 	void setup(Everything* e);
@@ -23,9 +23,11 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/Molecule.h>
 #include <core/ScalarFieldIO.h>
 #include <core/ScalarField.h>
+#include <core/LoopMacros.h>
+#include <core/Thread.h>
 
 ConvCoupling::ConvCoupling(FluidMixture* fluidMixture, const ExCorr& exCorr)
-: Fmix(fluidMixture), exCorr(exCorr), component(fluidMixture->getComponents())
+: Fmix(fluidMixture), exCorr(exCorr), component(fluidMixture->getComponents()), Phi_cavity(0.)
 {
 	Citations::add("Convolution-coupling for Joint Density Functional Theory",
 		"K. Letchworth-Weaver, R. Sundararaman and T.A. Arias, (under preparation)");
@@ -45,29 +47,66 @@ string ConvCoupling::getName() const
 
 void ConvCoupling::setExplicit(const ScalarFieldTilde& nCavityTilde)
 {	this->nCavity = I(nCavityTilde);
+	//The explicit-system term is unchanged over the fluid minimization that follows:
+	Vxc_cavity = 0;
+	Phi_cavity = exCorr(nCavity, &Vxc_cavity, true);
+	//Sites with electron kernels:
+	siteKernels.clear();
+	for(const FluidComponent* c: component)
+		for(unsigned i=0; i<c->molecule.sites.size(); i++)
+		{	const Molecule::Site& s = *(c->molecule.sites[i]);
+			if(s.elecKernel)
+				siteKernels.push_back(std::make_pair(c->offsetDensity+i, &s.elecKernel));
+		}
+}
+
+//Convolutions of all sites with their electron kernels in a single pass over reciprocal space:
+inline void convolveSites_sub(size_t iStart, size_t iStop, const vector3<int> S, const matrix3<> GGT,
+	const std::vector<const RadialFunctionG*>* kernels, const std::vector<const complex*>* N, complex* n)
+{	int nSites = kernels->size();
+	THREAD_halfGspaceLoop(
+		double G = sqrt(GGT.metric_length_squared(iG));
+		complex result(0,0);
+		for(int s=0; s<nSites; s++) result += (*kernels->at(s))(G) * N->at(s)[i];
+		n[i] = result;
+	)
+}
+inline void convolveSites_grad_sub(size_t iStart, size_t iStop, const vector3<int> S, const matrix3<> GGT,
+	const std::vector<const RadialFunctionG*>* kernels, const complex* Phi_n, const std::vector<complex*>* Phi_N)
+{	int nSites = kernels->size();
+	THREAD_halfGspaceLoop(
+		double G = sqrt(GGT.metric_length_squared(iG));
+		complex Phi_ni = Phi_n[i];
+		for(int s=0; s<nSites; s++) Phi_N->at(s)[i] += (*kernels->at(s))(G) * Phi_ni;
+	)
 }
 
 double ConvCoupling::energyAndGrad(const ScalarFieldTildeArray& Ntilde, ScalarFieldTildeArray* Phi_Ntilde, ScalarFieldTilde* Phi_nCavityTilde) const
-{
+{	const GridInfo& gInfo = nCavity->gInfo;
+	
 	//Compute model electron density of fluid:
 	ScalarFieldTilde nFluidTilde;
-	for(unsigned ic=0; ic<component.size(); ic++)
-	{	const FluidComponent& c = *component[ic];
-		for(unsigned i=0; i<c.molecule.sites.size(); i++)
-		{	const Molecule::Site& s = *(c.molecule.sites[i]);
-			if(s.elecKernel)
-				nFluidTilde += s.elecKernel * Ntilde[c.offsetDensity+i];
-		}
+	#ifdef GPU_ENABLED
+	for(const auto& sk: siteKernels)
+		nFluidTilde += (*sk.second) * Ntilde[sk.first];
+	#else
+	std::vector<const RadialFunctionG*> kernels; std::vector<const complex*> Ndata;
+	for(const auto& sk: siteKernels)
+	{	kernels.push_back(sk.second);
+		Ndata.push_back(Ntilde[sk.first]->data());
 	}
+	nFluidTilde = ScalarFieldTildeData::alloc(gInfo);
+	threadLaunch(convolveSites_sub, gInfo.nG, gInfo.S, gInfo.GGT, &kernels, &Ndata, nFluidTilde->data());
+	#endif
 	ScalarField nFluid = I(nFluidTilde);
 	
-	//Calculate exchange, correlation, and kinetic energy
+	//Calculate exchange, correlation, and kinetic energy (the explicit-system part is cached by setExplicit):
 	ScalarField nTot = nFluid + nCavity;
-	ScalarField Vxc_tot, Vxc_fluid, Vxc_cavity;
+	ScalarField Vxc_tot, Vxc_fluid;
 	double Phi =
 		+ exCorr(nTot, &Vxc_tot, true)
 		- exCorr(nFluid, &Vxc_fluid, true)
-		- exCorr(nCavity, &Vxc_cavity,  true);
+		- Phi_cavity;
 	
 	//Accumulate electronic-side gradient if required:
 	if(Phi_nCavityTilde)
@@ -77,14 +116,17 @@ double ConvCoupling::energyAndGrad(const ScalarFieldTildeArray& Ntilde, ScalarFi
 	if(Phi_Ntilde)
 	{	ScalarFieldTilde Phi_nFluidTilde = Idag(Vxc_tot - Vxc_fluid);
 		//Propagate to fluid densities:
-		for(unsigned ic=0; ic<component.size(); ic++)
-		{	const FluidComponent& c = *component[ic];
-			for(unsigned i=0; i<c.molecule.sites.size(); i++)
-			{	const Molecule::Site& s = *(c.molecule.sites[i]);
-				if(s.elecKernel)
-					Phi_Ntilde->at(c.offsetDensity+i) += s.elecKernel * Phi_nFluidTilde;
-			}
+		#ifdef GPU_ENABLED
+		for(const auto& sk: siteKernels)
+			Phi_Ntilde->at(sk.first) += (*sk.second) * Phi_nFluidTilde;
+		#else
+		std::vector<complex*> Phi_Ndata;
+		for(const auto& sk: siteKernels)
+		{	nullToZero(Phi_Ntilde->at(sk.first), gInfo);
+			Phi_Ndata.push_back(Phi_Ntilde->at(sk.first)->data());
 		}
+		threadLaunch(convolveSites_grad_sub, gInfo.nG, gInfo.S, gInfo.GGT, &kernels, Phi_nFluidTilde->data(), &Phi_Ndata);
+		#endif
 	}
 	
 	return Phi;
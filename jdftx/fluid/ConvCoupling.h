@@ -36,7 +36,7 @@ class ConvCoupling : public Fmix
 public:
 	ConvCoupling(FluidMixture* fluidMixture, const ExCorr& exCorr);
 	
-	//! Set explicit system properties
+	//! Set explicit system properties, and cache all quantities that depend only on them
 	//! @param nCavity "Cavity-effective" density of the explicit system (explicit electrons + chargeball)
 	void setExplicit(const ScalarFieldTilde& nCavityTilde);
 
@@ -53,6 +53,11 @@ public:
 private:
 	const std::vector<const FluidComponent*>& component;
 	ScalarField nCavity;
+	double Phi_cavity; //!< exchange-correlation energy of nCavity alone (cached by setExplicit)
+	ScalarField Vxc_cavity; //!< exchange-correlation potential of nCavity alone (cached by setExplicit)
+	
+	//! Fluid sites coupled to electrons: density index and electron kernel (collected by setExplicit)
+	std::vector<std::pair<int,const RadialFunctionG*>> siteKernels;
 };
 
 //! @}
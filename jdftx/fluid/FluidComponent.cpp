@@ -27,6 +27,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/IdealGasPsiAlpha.h>
 #include <fluid/IdealGasMuEps.h>
 #include <fluid/IdealGasPomega.h>
+#include <fluid/IdealGasYlm.h>
 #include <fluid/FluidMixture.h>
 
 //! Vapor pressure from the Antoine equation
@@ -134,7 +135,7 @@ double FluidComponent::pureNbulk(double T) const
 
 
 FluidComponent::FluidComponent(FluidComponent::Name name, double T, FluidComponent::Functional functional)
-: name(name), type(getType(name)), functional(functional), epsLJ(0.), representation(MuEps),
+: name(name), type(getType(name)), functional(functional), epsLJ(0.), representation(MuEps), lmax(4),
 s2quadType(Quad7design_24), quad_nBeta(0), quad_nAlpha(0), quad_nGamma(0), translationMode(LinearSpline),
 epsBulk(1.), Nbulk(pureNbulk(T)), pMol(0.), epsInf(1.), Pvap(0.), sigmaBulk(0.), Rvdw(0.), Res(0.),
 tauNuc(8.3e+3*fs), Nnorm(0), quad(0), trans(0), idealGas(0), fex(0), offsetIndep(0), offsetDensity(0)
@@ -593,6 +594,7 @@ void FluidComponent::addToFluidMixture(FluidMixture* fluidMixture)
 		{	case PsiAlpha: idealGas = std::make_shared<IdealGasPsiAlpha>(fluidMixture, this, *quad, *trans); break;
 			case Pomega: idealGas = std::make_shared<IdealGasPomega>(fluidMixture, this, *quad, *trans); break;
 			case MuEps: idealGas = std::make_shared<IdealGasMuEps>(fluidMixture, this, *quad, *trans); break;
+			case Ylm: idealGas = std::make_shared<IdealGasYlm>(fluidMixture, this, *quad, *trans, lmax); break;
 		}
 	}
 	
@@ -93,9 +93,11 @@ struct FluidComponent
 	enum Representation
 	{	Pomega, //!< directly work with orientation probability density
 		PsiAlpha, //!< site-potential representation
-		MuEps //!< multipole density representation truncated at l=1 (default)
+		MuEps, //!< multipole density representation truncated at l=1 (default)
+		Ylm //!< site-potential representation with site translations expanded in spherical harmonics up to lmax
 	}
 	representation;
+	unsigned lmax; //!< angular momentum cutoff of the Ylm representation (default: 4)
 	
 	S2quadType s2quadType; //!< Quadrature on S2 that generates the SO(3) quadrature (default: 7design24)
 	unsigned quad_nBeta, quad_nAlpha, quad_nGamma; //!< Subdivisions for euler angle outer-product quadrature
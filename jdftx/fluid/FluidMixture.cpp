@@ -24,7 +24,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 extern string rigidMoleculeCDFT_ScalarEOSpaper;
 
 FluidMixture::FluidMixture(const GridInfo& gInfo, const double T)
-: gInfo(gInfo), T(T), verboseLog(false), useMFKernel(false), Qtol(1e-12), nIndepIdgas(0), nDensities(0), polarizable(false)
+: gInfo(gInfo), T(T), verboseLog(false), memoryBudgetMB(0.), useMFKernel(false), Qtol(1e-12), nIndepIdgas(0), nDensities(0), polarizable(false), memoryLean(false)
 {
 	logPrintf("Initializing fluid mixture at T=%lf K ...\n", T/Kelvin);
 	Citations::add("Rigid-molecule density functional theory framework", rigidMoleculeCDFT_ScalarEOSpaper);
@@ -118,6 +118,24 @@ void FluidMixture::initialize(double p, double epsBulkOverride, double epsInfOve
 		if(pMolSq) c->idealGas->corrPrefac = (1./Crot-1.)*3*T/(pMolSq*c->idealGas->get_Nbulk());
 	}
 	
+	//Select evaluation mode within memory budget (estimated in units of grid-sized scalar fields):
+	if(memoryBudgetMB)
+	{	bool hardSpheres = false;
+		for(const FluidComponent* c: component)
+			for(const auto& s: c->molecule.sites)
+				if(s->Rhs) hardSpheres = true;
+		double fieldMB = gInfo.nr * sizeof(double) / pow(1024.,2);
+		double nBase = 3*nDensities + (polarizable ? 6 : 0); //site densities, gradients (lazily allocated in lean mode) and mean-field terms
+		double nFMT = hardSpheres ? 6 : 0; //reciprocal-space weighted densities
+		double peakDefault = fieldMB * (nBase + nFMT + (hardSpheres ? 45 : 0)); //fused FMT pipeline holds all weights in both spaces
+		double peakLean = fieldMB * (nBase - nDensities + nFMT + (hardSpheres ? 30 : 0)); //incremental FMT, intermediates freed before the gradient pass
+		memoryLean = (peakDefault > memoryBudgetMB);
+		logPrintf("   Estimated free-energy evaluation memory: %.0lf MB (default), %.0lf MB (lean); using %s mode.\n",
+			peakDefault, peakLean, memoryLean ? "memory-lean" : "default");
+		if(memoryLean and peakLean > memoryBudgetMB)
+			logPrintf("   WARNING: lean-mode estimate exceeds the fluid memory budget of %.0lf MB.\n", memoryBudgetMB);
+	}
+	
 	//Initialize preconditioners:
 	Kindep.resize(component.size());
 	for(unsigned ic=0; ic<component.size(); ic++)
@@ -38,6 +38,7 @@ public:
 	const GridInfo& gInfo;
 	const double T; //!< Temperature
 	bool verboseLog; //!< print energy components etc. if enabled (off by default)
+	double memoryBudgetMB; //!< if non-zero, memory budget for free-energy evaluations, which selects memory-lean evaluation when the default would exceed it (set before initialize())
 	vector3<> Eexternal; //!< External uniform electric field
 
 	FluidMixture(const GridInfo& gInfo, const double T=298*Kelvin);
@@ -118,6 +119,7 @@ private:
 	unsigned nIndepIdgas; //!< number of scalar fields used as independent variables for the component ideal gases
 	unsigned nDensities; //!< total number of site densities
 	bool polarizable;  //!< whether an additional vector field is required due to polarizable components
+	bool memoryLean; //!< whether free-energy evaluations trade recomputation for memory (selected by initialize() based on memoryBudgetMB)
 	double p;
 	double Crot, Cpol; //!< dielectric correlation prefactors (set by initialize())
 	
@@ -142,7 +142,7 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 
 	EnergyComponents Phi; //the grand free energy (with component information)
 	ScalarFieldTildeArray Phi_Ntilde(nDensities); //gradients (functional derivative) w.r.t reciprocal space site densities
-	nullToZero(Phi_Ntilde,gInfo);
+	if(!memoryLean) nullToZero(Phi_Ntilde,gInfo); //in memory-lean mode, each gradient is allocated when first accumulated
 	std::vector< vector3<> > Phi_P0(component.size()); //functional derivative w.r.t polarization density G=0
 	VectorFieldTilde Phi_epsMF; //functional derivative w.r.t mean field electric field
 	
@@ -156,7 +156,9 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 			  { 
 			    const Molecule::Site& s = *(c.molecule.sites[i]);
 			    Phi["Gzero"] += Qfixed*(Ntot_c[ic]/gInfo.detR-c.idealGas->Nbulk)*s.positions.size()*s.deltaS;
-			    Phi_Ntilde[c.offsetDensity+i]->data()[0] += (1.0/gInfo.dV) * (Qfixed*s.deltaS);
+			    ScalarFieldTilde& Phi_Ntilde_i = Phi_Ntilde[c.offsetDensity+i];
+			    nullToZero(Phi_Ntilde_i, gInfo);
+			    Phi_Ntilde_i->setGzero(Phi_Ntilde_i->getGzero() + (1.0/gInfo.dV) * (Qfixed*s.deltaS)); //stays on the GPU, if any
 			  }
 		}
 	}
@@ -287,14 +289,9 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 			for(unsigned i=0; i<c.molecule.sites.size(); i++)
 			{	const Molecule::Site& s = *(c.molecule.sites[i]);
 				if(s.Rhs)
-				{	const ScalarFieldTilde& Nsite = Ntilde[c.offsetDensity+i];
-					n0mult[ic] += s.positions.size();
-					n0molTilde += s.w0  * Nsite;
-					n1tilde    += s.w1  * Nsite;
-					n2tilde    += s.w2  * Nsite;
-					n3tilde    += s.w3  * Nsite;
-					n1vTilde   += s.w1v * Nsite;
-					n2mTilde   += s.w2m * Nsite;
+				{	n0mult[ic] += s.positions.size();
+					fmtWeightedDensities(s, Ntilde[c.offsetDensity+i],
+						n0molTilde, n1tilde, n2tilde, n3tilde, n1vTilde, n2mTilde);
 				}
 			}
 			if(n0molTilde) n0tilde += n0molTilde;
@@ -304,13 +301,25 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 			}
 		}
 		if(n0tilde) //at least one sphere in the mixture
-		{	ScalarField n0 = I(n0tilde); n0tilde=0;
-			ScalarField n1 = I(n1tilde); n1tilde=0;
-			ScalarField n2 = I(n2tilde); n2tilde=0;
-			ScalarField Phi_n0, Phi_n1, Phi_n2; ScalarFieldTilde Phi_n3tilde, Phi_n1vTilde, Phi_n2mTilde;
+		{	ScalarFieldTilde nTilde[6] = { n0tilde, n1tilde, n2tilde, n3tilde, n1vTilde, n2mTilde };
+			n0tilde=0; n1tilde=0; n2tilde=0; n3tilde=0; n1vTilde=0; n2mTilde=0;
+			ScalarFieldTilde Phi_nTilde[6];
+			ScalarField n2, Phi_n2; //real-space n2 and its gradient, needed only for bonding
 			//Compute the sphere mixture free energy:
-			Phi["MixedFMT"] += T * PhiFMT(n0, n1, n2, n3tilde, n1vTilde, n2mTilde,
-				Phi_n0, Phi_n1, Phi_n2, Phi_n3tilde, Phi_n1vTilde, Phi_n2mTilde);
+			if(memoryLean)
+			{	//Incremental: real-space weighted densities are created one at a time and freed before the gradient pass
+				ScalarField n0 = I(nTilde[0]); nTilde[0]=0;
+				ScalarField n1 = I(nTilde[1]); nTilde[1]=0;
+				n2 = I(nTilde[2]); nTilde[2]=0;
+				ScalarField Phi_n0, Phi_n1;
+				Phi["MixedFMT"] += T * PhiFMT(n0, n1, n2, nTilde[3], nTilde[4], nTilde[5],
+					Phi_n0, Phi_n1, Phi_n2, Phi_nTilde[3], Phi_nTilde[4], Phi_nTilde[5]);
+				n0=0; n1=0; nTilde[4]=0; nTilde[5]=0;
+				if(!bondsPresent) n2=0;
+				Phi_nTilde[0] = Idag(Phi_n0); Phi_n0=0;
+				Phi_nTilde[1] = Idag(Phi_n1); Phi_n1=0;
+			}
+			else Phi["MixedFMT"] += T * PhiFMTfused(nTilde, Phi_nTilde, bondsPresent ? &n2 : 0); //all weighted densities in one fused pass
 			//Bonding corrections if required
 			if(bondsPresent)
 			{	for(unsigned ic=0; ic<component.size(); ic++)
@@ -318,7 +327,7 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 					ScalarField Phi_n0mol;
 					for(const auto& b: bond[ic])
 						Phi["Bonding"] += T * PhiBond(b.first, b.second*1./n0mult[ic],
-							n0mol[ic], n2, n3tilde, Phi_n0mol, Phi_n2, Phi_n3tilde);
+							n0mol[ic], n2, nTilde[3], Phi_n0mol, Phi_n2, Phi_nTilde[3]);
 					if(Phi_n0mol)
 					{	//Propagate gradient w.r.t n0mol[ic] to the site densities:
 						ScalarFieldTilde Phi_n0molTilde = Idag(Phi_n0mol);
@@ -330,22 +339,15 @@ double FluidMixture::operator()(const ScalarFieldArray& indep, ScalarFieldArray&
 					}
 				}
 			}
+			n2=0; nTilde[3]=0;
+			if(Phi_n2) { Phi_nTilde[2] += Idag(Phi_n2); Phi_n2=0; }
 			//Accumulate gradients w.r.t weighted densities to site densities:
-			ScalarFieldTilde Phi_n0tilde = Idag(Phi_n0); Phi_n0=0;
-			ScalarFieldTilde Phi_n1tilde = Idag(Phi_n1); Phi_n1=0;
-			ScalarFieldTilde Phi_n2tilde = Idag(Phi_n2); Phi_n2=0;
 			for(const FluidComponent* c: component)
 			{	for(unsigned i=0; i<c->molecule.sites.size(); i++)
 				{	const Molecule::Site& s = *(c->molecule.sites[i]);
 					if(s.Rhs)
-					{	ScalarFieldTilde& Phi_Nsite = Phi_Ntilde[c->offsetDensity+i];
-						Phi_Nsite += T * (s.w0  * Phi_n0tilde);
-						Phi_Nsite += T * (s.w1  * Phi_n1tilde);
-						Phi_Nsite += T * (s.w2  * Phi_n2tilde);
-						Phi_Nsite += T * (s.w3  * Phi_n3tilde);
-						Phi_Nsite += T * (s.w1v * Phi_n1vTilde);
-						Phi_Nsite += T * (s.w2m * Phi_n2mTilde);
-					}
+						fmtWeightedDensities_grad(s, Phi_nTilde[0], Phi_nTilde[1], Phi_nTilde[2], Phi_nTilde[3], Phi_nTilde[4], Phi_nTilde[5],
+							T, Phi_Ntilde[c->offsetDensity+i]);
 				}
 			}
 		}
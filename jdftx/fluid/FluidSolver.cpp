@@ -78,6 +78,7 @@ public:
 		//Initialize fluid mixture:
 		fluidMixture = new FluidMixtureJDFT(e, gInfo, fsp.T);
 		fluidMixture->verboseLog = fsp.verboseLog;
+		fluidMixture->memoryBudgetMB = fsp.memoryBudgetMB;
 		
 		//Add the fluid components:
 		for(const auto& c: fsp.components)
@@ -236,7 +237,8 @@ public:
 	}
 
 	void minimizeFluid()
-	{	TIME("Fluid minimize", globalLog,
+	{	static const int phaseId = Profiler::registerName("FluidSolve"); ProfilePhase phase(phaseId);
+		TIME("Fluid minimize", globalLog,
 			fluidMixture->minimize(e.fluidMinParams);
 			updateCached();
 		)
@@ -266,8 +268,29 @@ public:
 //----------------  Interface to the electronic code ------------------
 //---------------------------------------------------------------------
 
+//Create a separate coarser grid for the fluid, if requested and smaller than the (embedded) electronic grid:
+static std::shared_ptr<GridInfo> createFluidGrid(const GridInfo& gInfoBase, const FluidSolverParams& fsp)
+{	if(!fsp.gridEcut) return 0;
+	logPrintf("\n---------- Initializing coarser grid for the fluid ----------\n");
+	std::shared_ptr<GridInfo> gInfoFluid = std::make_shared<GridInfo>();
+	gInfoFluid->R = gInfoBase.R;
+	gInfoFluid->GmaxRho = sqrt(2*fsp.gridEcut);
+	gInfoFluid->initialize(true);
+	for(int k=0; k<3; k++)
+		if(gInfoFluid->S[k] > gInfoBase.S[k])
+		{	logPrintf("Disabling coarse fluid grid as it would be finer than the electronic grid along direction %d.\n", k);
+			return 0;
+		}
+	if(gInfoFluid->S == gInfoBase.S)
+	{	logPrintf("Disabling coarse fluid grid as its sample count matches the electronic grid.\n");
+		return 0;
+	}
+	gInfoFluid->fftBatchSize = gInfoBase.fftBatchSize;
+	return gInfoFluid;
+}
+
 FluidSolver::FluidSolver(const Everything& e, const FluidSolverParams& fsp)
-: e(e), gInfo(e.coulomb->gInfo), fsp(fsp), atpos(e.iInfo.species.size())
+: e(e), gInfoFluid(createFluidGrid(e.coulomb->gInfo, fsp)), gInfo(gInfoFluid ? *gInfoFluid : e.coulomb->gInfo), fsp(fsp), atpos(e.iInfo.species.size()), electronicEnergyChange(NAN)
 {	//Initialize radial kernels in molecule sites:
 	for(const auto& c: fsp.components)
 		if(!c->molecule)
@@ -317,8 +340,31 @@ double FluidSolver::ionWidthMuCorrection() const
 {	return (4*M_PI/gInfo.detR) * (-0.5*pow(e.iInfo.ionWidth,2)) * e.iInfo.getZtot();
 }
 
+MinimizeParams FluidSolver::innerMinParams() const
+{	MinimizeParams mp = e.fluidMinParams;
+	if(fsp.adaptiveTolFactor and std::isfinite(electronicEnergyChange) and electronicEnergyChange>0.)
+	{	double dAtarget = fsp.adaptiveTolFactor * electronicEnergyChange; //tolerable error in fluid free energy
+		//Free energy error of an approximate linear solve ~ 0.5 detR r.K.r (with preconditioner K ~ inverse hessian):
+		if(mp.nDim) mp.knormThreshold = std::max(mp.knormThreshold, sqrt(2.*dAtarget/(gInfo.detR*mp.nDim)));
+		mp.energyDiffThreshold = std::max(mp.energyDiffThreshold, dAtarget);
+	}
+	return mp;
+}
+
+ScalarFieldTilde FluidSolver::toFluidGrid(const ScalarFieldTilde& x) const
+{	return gInfoFluid ? changeGrid(x, *gInfoFluid) : x;
+}
+
+ScalarFieldTilde FluidSolver::fromFluidGrid(const ScalarFieldTilde& x) const
+{	return gInfoFluid ? changeGrid(x, e.coulomb->gInfo) : x;
+}
+
 void FluidSolver::set(const ScalarFieldTilde& rhoExplicitTilde, const ScalarFieldTilde& nCavityTilde)
-{	for(unsigned iSp=0; iSp<atpos.size(); iSp++)
+{	if(gInfoFluid and not (gInfoFluid->R == e.coulomb->gInfo.R)) //lattice changed (eg. in lattice minimization)
+	{	gInfoFluid->R = e.coulomb->gInfo.R;
+		gInfoFluid->update();
+	}
+	for(unsigned iSp=0; iSp<atpos.size(); iSp++)
 		atpos[iSp] = e.iInfo.species[iSp]->atpos;
 	if(e.coulombParams.embed)
 	{	matrix3<> embedScaleMat = Diag(e.coulomb->embedScale); //lattice coordinate scale factor due to embedding
@@ -327,11 +373,11 @@ void FluidSolver::set(const ScalarFieldTilde& rhoExplicitTilde, const ScalarFiel
 				pos = embedScaleMat *  e.coulomb->wsOrig->restrict(pos - e.coulomb->xCenter);
 		ScalarFieldTilde rhoExplicitTildeExpand = e.coulomb->embedExpand(rhoExplicitTilde);
 		if(!k2factor) rhoExplicitTildeExpand->setGzero(0.); //No screening => apply neutralizing background charge
-		set_internal(rhoExplicitTildeExpand, e.coulomb->embedExpand(nCavityTilde));
+		set_internal(toFluidGrid(rhoExplicitTildeExpand), toFluidGrid(e.coulomb->embedExpand(nCavityTilde)));
 	}
 	else
 	{	if(!k2factor) ((ScalarFieldTilde&)rhoExplicitTilde)->setGzero(0.); //No screening => apply neutralizing background charge
-		set_internal(rhoExplicitTilde, nCavityTilde);
+		set_internal(toFluidGrid(rhoExplicitTilde), toFluidGrid(nCavityTilde));
 	}
 }
 
@@ -339,12 +385,20 @@ double FluidSolver::get_Adiel_and_grad(ScalarFieldTilde* Adiel_rhoExplicitTilde,
 {	if(e.coulombParams.embed)
 	{	ScalarFieldTilde Adiel_rho_big, Adiel_n_big;
 		double Adiel = get_Adiel_and_grad_internal(Adiel_rho_big, Adiel_n_big, extraForces, Adiel_RRT);
-		if(A_rhoNonES) ((FluidSolver*)this)->A_rhoNonES = e.coulomb->embedShrink(A_rhoNonES);
-		if(Adiel_rhoExplicitTilde) *Adiel_rhoExplicitTilde = e.coulomb->embedShrink(Adiel_rho_big);
-		if(Adiel_nCavityTilde) *Adiel_nCavityTilde = e.coulomb->embedShrink(Adiel_n_big);
+		if(A_rhoNonES) ((FluidSolver*)this)->A_rhoNonES = e.coulomb->embedShrink(fromFluidGrid(A_rhoNonES));
+		if(Adiel_rhoExplicitTilde) *Adiel_rhoExplicitTilde = e.coulomb->embedShrink(fromFluidGrid(Adiel_rho_big));
+		if(Adiel_nCavityTilde) *Adiel_nCavityTilde = e.coulomb->embedShrink(fromFluidGrid(Adiel_n_big));
 		if(extraForces) *extraForces = Diag(e.coulomb->embedScale) * (*extraForces); //transform to original contravariant lattice coordinates
 		return Adiel;
 	}
+	else if(gInfoFluid)
+	{	ScalarFieldTilde Adiel_rho_fluid, Adiel_n_fluid;
+		double Adiel = get_Adiel_and_grad_internal(Adiel_rho_fluid, Adiel_n_fluid, extraForces, Adiel_RRT);
+		if(A_rhoNonES) ((FluidSolver*)this)->A_rhoNonES = fromFluidGrid(A_rhoNonES);
+		if(Adiel_rhoExplicitTilde) *Adiel_rhoExplicitTilde = fromFluidGrid(Adiel_rho_fluid);
+		if(Adiel_nCavityTilde) *Adiel_nCavityTilde = fromFluidGrid(Adiel_n_fluid);
+		return Adiel;
+	}
 	else
 	{	ScalarFieldTilde Adiel_rho_temp, Adiel_n_temp;
 		return get_Adiel_and_grad_internal(
@@ -359,9 +413,9 @@ void FluidSolver::getSusceptibility(const std::vector<complex>& omega, std::vect
 	sTilde.clear();
 	for(const ScalarField& s: sArr)
 	{	if(e.coulombParams.embed)
-			sTilde.push_back(e.coulomb->embedShrink(J(s)));
+			sTilde.push_back(e.coulomb->embedShrink(fromFluidGrid(J(s))));
 		else
-			sTilde.push_back(J(s));
+			sTilde.push_back(fromFluidGrid(J(s)));
 	}
 }
 
@@ -32,18 +32,23 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 struct FluidSolver
 {
 	const Everything& e;
-	const GridInfo& gInfo; //relevant gInfo for fluid (uses embedded grid when coulomb truncation is enabled)
+	const std::shared_ptr<GridInfo> gInfoFluid; //!< separate coarser fluid grid (if fsp.gridEcut is set), null otherwise
+	const GridInfo& gInfo; //relevant gInfo for fluid (uses embedded grid when coulomb truncation is enabled, and gInfoFluid if present)
 	const FluidSolverParams& fsp;
 	double epsBulk, epsInf; //!< bulk dielectric constants of fluid
 	double k2factor; //!< prefactor to screening term (0 => no ionic screening)
 	std::vector<std::vector< vector3<> > > atpos; //!atomic positions per species in the relevant coordinate system (depending on embedding option)
 	ScalarFieldTilde A_rhoNonES; //!Any non-electrostatic contributions to A_rhoExplicitTilde (removed from dumped d_fluid / d_tot)
+	double electronicEnergyChange; //!< magnitude of the latest electronic energy change (set by SCF / ElecMinimizer, NAN if unavailable)
 	
 	//! Abstract base class constructor - do not use directly - see FluidSolver::createSolver
 	FluidSolver(const Everything &e, const FluidSolverParams& fsp);
 	virtual ~FluidSolver() {}
 
 	double ionWidthMuCorrection() const; //!< correction to electron chemical potential due to finite ion width in fluid interaction
+	
+	//! Convergence parameters for the fluid solve: fluidMinParams, loosened according to electronicEnergyChange if fsp.adaptiveTolFactor is set
+	MinimizeParams innerMinParams() const;
 
 	//Whether a gummel loop is in use
 	inline bool useGummel() const
@@ -103,6 +108,10 @@ struct FluidSolver
 	virtual void minimizeFluid()=0;
 	
 protected:
+	//! Fourier interpolate from the (embedded) electronic grid to the fluid grid, and back (identity without gInfoFluid)
+	ScalarFieldTilde toFluidGrid(const ScalarFieldTilde&) const;
+	ScalarFieldTilde fromFluidGrid(const ScalarFieldTilde&) const;
+	
 	//! Fluid-dependent implementation of set()
 	virtual void set_internal(const ScalarFieldTilde& rhoExplicitTilde, const ScalarFieldTilde& nCavityTilde)=0;
 
@@ -22,20 +22,20 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/Units.h>
 
 FluidSolverParams::FluidSolverParams()
-: T(298*Kelvin), P(1.01325*Bar), epsBulkOverride(0.), epsInfOverride(0.), verboseLog(false), solveFrequency(FluidFreqDefault),
-components(components_), solvents(solvents_), cations(cations_), anions(anions_),
+: T(298*Kelvin), P(1.01325*Bar), epsBulkOverride(0.), epsInfOverride(0.), verboseLog(false), solveFrequency(FluidFreqDefault), adaptiveTolFactor(0.), nRecycle(0), gridEcut(0.), memoryBudgetMB(0.), cavityReuseThreshold(0.),
 vdwScale(0.75), pCavity(0.), lMax(3), cavityScale(1.), ionSpacing(0.),
 zMask0(0.), zMaskH(0.), zMaskIonH(0.), zMaskSigma(0.5),
-linearDielectric(false), linearScreening(false), nonlinearSCF(false), screenOverride(0.)
+linearDielectric(false), linearScreening(false), nonlinearSCF(false),
+nonlinearNewton(false), newtonIterations(20), newtonKrylovDim(10), newtonInnerIterations(10), newtonThreshold(1e-8), screenOverride(0.)
 {
 }
 
 void FluidSolverParams::addComponent(const std::shared_ptr<FluidComponent>& component)
-{	components_.push_back(component);
+{	components.push_back(component);
 	switch(component->type)
-	{	case FluidComponent::Solvent: solvents_.push_back(component); break;
-		case FluidComponent::Cation: cations_.push_back(component); break;
-		case FluidComponent::Anion: anions_.push_back(component); break;
+	{	case FluidComponent::Solvent: solvents.push_back(component); break;
+		case FluidComponent::Cation: cations.push_back(component); break;
+		case FluidComponent::Anion: anions.push_back(component); break;
 	}
 }
 
@@ -104,11 +104,17 @@ struct FluidSolverParams
 	vector3<> epsBulkTensor; //!< Override default dielectric constants with a tensor if non-zero (assuming Cartesian coords are principal axes, LinearPCM only)
 	bool verboseLog; //!< whether iteration progress is printed for Linear PCM's, and whether sub-iteration progress is printed for others
 	FluidSolveFrequency solveFrequency;
+	double adaptiveTolFactor; //!< if non-zero, loosen inner fluid convergence so that its estimated free-energy error is at most this fraction of the latest electronic energy change
+	int nRecycle; //!< number of previous LinearPCM / SaLSA solutions used to extrapolate the initial guess of each new solve (0 to disable)
+	double gridEcut; //!< if non-zero, charge-density cutoff (in Hartrees) of a separate coarser grid for the fluid
+	double memoryBudgetMB; //!< if non-zero, memory budget (per process, in MB) for classical-DFT free-energy evaluations, which selects the memory-lean mode of FluidMixture when exceeded
+	double cavityReuseThreshold; //!< if non-zero, reuse the PCM cavity (and its cavitation energy) while the densities determining it change by less than this (max norm, in electrons/bohr^3)
 	
-	const std::vector< std::shared_ptr<FluidComponent> >& components; //!< list of all fluid components
-	const std::vector< std::shared_ptr<FluidComponent> >& solvents; //!< list of solvent components
-	const std::vector< std::shared_ptr<FluidComponent> >& cations; //!< list of cationic components
-	const std::vector< std::shared_ptr<FluidComponent> >& anions; //!< list of anionic components
+	//Component lists (modify only using addComponent; stored by value so that the parameters are copyable):
+	std::vector< std::shared_ptr<FluidComponent> > components; //!< list of all fluid components
+	std::vector< std::shared_ptr<FluidComponent> > solvents; //!< list of solvent components
+	std::vector< std::shared_ptr<FluidComponent> > cations; //!< list of cationic components
+	std::vector< std::shared_ptr<FluidComponent> > anions; //!< list of anionic components
 	
 	void addComponent(const std::shared_ptr<FluidComponent>& component); //!< Add component to the component list as well as one of solvents, anions or cations as appropriate
 	
@@ -150,6 +156,11 @@ struct FluidSolverParams
 	bool linearDielectric; //!< If true, work in the linear dielectric response limit
 	bool linearScreening; //!< If true, work in the linearized Poisson-Boltzman limit for the ions
 	bool nonlinearSCF; //!< whether to use an SCF method for nonlinear PCMs
+	bool nonlinearNewton; //!< whether to use the inexact Newton-Krylov method (preconditioned by LinearPCM solves) for nonlinear PCMs (requires nonlinearSCF)
+	int newtonIterations; //!< maximum number of outer Newton steps
+	int newtonKrylovDim; //!< maximum Krylov subspace dimension for each Newton step
+	int newtonInnerIterations; //!< number of LinearPCM conjugate-gradient iterations per preconditioner application
+	double newtonThreshold; //!< convergence threshold on the norm of the nonlinear Poisson residual relative to that of the explicit charge
 	double screenOverride; //! overrides screening factor with this value
 	PulayParams scfParams; //!< parameters controlling Pulay mixing for SCF version of nonlinear PCM
 	
@@ -164,8 +175,6 @@ struct FluidSolverParams
 	void setCDFTparams(); //!< Set predefined parameters for solventName (for a classical DFT model)
 	bool needsVDW() const; //!< whether pair-potential vdW corrections are required
 	bool ionicScreening() const; //!< whether list of fluid components includes ionic species for Debye screening
-private:
-	std::vector< std::shared_ptr<FluidComponent> > components_, solvents_, cations_, anions_; //internal mutable versions of the public component lists
 };
 
 //! @}
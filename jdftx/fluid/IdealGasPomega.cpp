@@ -30,6 +30,13 @@ string IdealGasPomega::representationName() const
 {	return "Pomega";
 }
 
+TranslationOperator::ShiftList IdealGasPomega::siteShifts(unsigned i, const matrix3<>& rot, int sign) const
+{	TranslationOperator::ShiftList shifts;
+	for(vector3<> pos: molecule.sites[i]->positions)
+		shifts.push_back(std::make_pair(sign * (rot*pos), 1.));
+	return shifts;
+}
+
 void IdealGasPomega::initState_o(int o, const matrix3<>& rot, double scale, const ScalarField& Eo, ScalarField* logPomega) const
 {	logPomega[o] += (-scale/T) * Eo;
 }
@@ -43,6 +50,58 @@ void IdealGasPomega::convertGradients_o(int o, const matrix3<>& rot, const Scala
 }
 
 
+PackedAllReduce::PackedAllReduce(const GridInfo& gInfo, const std::vector<ScalarField*>& fields, const std::vector<double*>& scalars)
+: gInfo(gInfo), fields(fields), scalars(scalars), pending(false)
+{	for(ScalarField* x: fields) nullToZero(*x, gInfo);
+	if(mpiWorld->nProcesses() == 1) return; //nothing to reduce
+	buf.init(fields.size()*gInfo.nr + scalars.size(), isGpuEnabled());
+	double* bufData = buf.dataPref();
+	for(ScalarField* x: fields) { callPref(eblas_copy)(bufData, (*x)->dataPref(), gInfo.nr); bufData += gInfo.nr; }
+	std::vector<double> scalarValues; for(double* v: scalars) scalarValues.push_back(*v);
+	if(scalars.size())
+	{
+		#ifdef GPU_ENABLED
+		cudaMemcpy(bufData, scalarValues.data(), sizeof(double)*scalars.size(), cudaMemcpyHostToDevice);
+		#else
+		eblas_copy(bufData, scalarValues.data(), scalars.size());
+		#endif
+	}
+	mpiWorld->allReduceData(buf, MPIUtil::ReduceSum, false, &request);
+	pending = true;
+}
+
+void PackedAllReduce::wait()
+{	if(!pending) return;
+	MPIUtil::wait(request);
+	pending = false;
+	const double* bufData = buf.dataPref();
+	for(ScalarField* x: fields) { callPref(eblas_copy)((*x)->dataPref(), bufData, gInfo.nr); bufData += gInfo.nr; }
+	std::vector<double> scalarValues(scalars.size());
+	if(scalars.size())
+	{
+		#ifdef GPU_ENABLED
+		cudaMemcpy(scalarValues.data(), bufData, sizeof(double)*scalars.size(), cudaMemcpyDeviceToHost);
+		#else
+		eblas_copy(scalarValues.data(), bufData, scalars.size());
+		#endif
+	}
+	for(size_t j=0; j<scalars.size(); j++) *(scalars[j]) = scalarValues[j];
+}
+
+//Run loop(oBegin, oEnd, iChunk) for each chunk iChunk of the orientations [oStart,oStop) of the current process:
+inline void orientationChunk_thread(size_t iStart, size_t iStop, int nChunks, int oStart, int oStop, const std::function<void(int,int,int)>* loop)
+{	for(size_t iChunk=iStart; iChunk<iStop; iChunk++)
+		(*loop)(oStart + (iChunk*(oStop-oStart))/nChunks, oStart + ((iChunk+1)*(oStop-oStart))/nChunks, iChunk);
+}
+
+int IdealGasPomega::nOrientationChunks() const
+{	return isGpuEnabled() ? 1 : std::max(1, std::min(nProcsAvailable, oStop-oStart));
+}
+
+void IdealGasPomega::orientationThreads(int nChunks, const std::function<void(int,int,int)>& loop) const
+{	threadLaunch(nChunks, orientationChunk_thread, nChunks, nChunks, oStart, oStop, &loop);
+}
+
 void IdealGasPomega::initState(const ScalarField* Vex, ScalarField* indep, double scale, double Elo, double Ehi) const
 {	for(int k=0; k<nIndep; k++) indep[k]=0;
 	ScalarFieldArray Veff(molecule.sites.size()); nullToZero(Veff, gInfo);
@@ -50,31 +109,44 @@ void IdealGasPomega::initState(const ScalarField* Vex, ScalarField* indep, doubl
 	{	Veff[i] += V[i];
 		Veff[i] += Vex[i];
 	}
+	//Orientation loop, with separate state accumulators and stats per thread:
+	int nChunks = nOrientationChunks();
+	std::vector<ScalarFieldArray> indepChunk(nChunks, ScalarFieldArray(nIndep));
+	std::vector<double> EminChunk(nChunks, +DBL_MAX), EmaxChunk(nChunks, -DBL_MAX), EmeanChunk(nChunks, 0.);
+	orientationThreads(nChunks, [&](int oBegin, int oEnd, int iChunk)
+	{	for(int o=oBegin; o<oEnd; o++)
+		{	matrix3<> rot = matrixFromEuler(quad.euler(o));
+			ScalarField Emolecule;
+			//Sum the potentials collected over sites for each orientation:
+			for(unsigned i=0; i<molecule.sites.size(); i++)
+				trans.taxpyMany(siteShifts(i, rot, -1), Veff[i], Emolecule);
+			//Accumulate stats and cap:
+			EmeanChunk[iChunk] += quad.weight(o) * sum(Emolecule)/gInfo.nr;
+			double Emin_o, Emax_o;
+			callPref(eblas_capMinMax)(gInfo.nr, Emolecule->dataPref(), Emin_o, Emax_o, Elo, Ehi);
+			if(Emin_o<EminChunk[iChunk]) EminChunk[iChunk]=Emin_o;
+			if(Emax_o>EmaxChunk[iChunk]) EmaxChunk[iChunk]=Emax_o;
+			//Set contributions to the state (with appropriate scale factor):
+			initState_o(o, rot, scale, Emolecule, indepChunk[iChunk].data());
+		}
+	});
+	//Collect over threads:
 	double Emin=+DBL_MAX, Emax=-DBL_MAX, Emean=0.0;
-	for(int o=oStart; o<oStop; o++)
-	{	matrix3<> rot = matrixFromEuler(quad.euler(o));
-		ScalarField Emolecule;
-		//Sum the potentials collected over sites for each orientation:
-		for(unsigned i=0; i<molecule.sites.size(); i++)
-			for(vector3<> pos: molecule.sites[i]->positions)
-				trans.taxpy(-(rot*pos), 1., Veff[i], Emolecule);
-		//Accumulate stats and cap:
-		Emean += quad.weight(o) * sum(Emolecule)/gInfo.nr;
-		double Emin_o, Emax_o;
-		callPref(eblas_capMinMax)(gInfo.nr, Emolecule->dataPref(), Emin_o, Emax_o, Elo, Ehi);
-		if(Emin_o<Emin) Emin=Emin_o;
-		if(Emax_o>Emax) Emax=Emax_o;
-		//Set contributions to the state (with appropriate scale factor):
-		initState_o(o, rot, scale, Emolecule, indep);
+	for(int iChunk=0; iChunk<nChunks; iChunk++)
+	{	for(int k=0; k<nIndep; k++)
+			if(indepChunk[iChunk][k]) indep[k] += indepChunk[iChunk][k];
+		Emin = std::min(Emin, EminChunk[iChunk]);
+		Emax = std::max(Emax, EmaxChunk[iChunk]);
+		Emean += EmeanChunk[iChunk];
 	}
-	//MPI collect:
-	for(int k=0; k<nIndep; k++)
-	{	nullToZero(indep[k],gInfo);
-		indep[k]->allReduceData(mpiWorld, MPIUtil::ReduceSum);
-	}
-	mpiWorld->allReduce(Emin, MPIUtil::ReduceMin);
-	mpiWorld->allReduce(Emax, MPIUtil::ReduceMax);
-	mpiWorld->allReduce(Emean, MPIUtil::ReduceSum);
+	indepChunk.clear();
+	//MPI collect (min/max stats reduced while the packed sum is in flight):
+	std::vector<ScalarField*> fields; for(int k=0; k<nIndep; k++) fields.push_back(&indep[k]);
+	PackedAllReduce reduction(gInfo, fields, {&Emean});
+	double Erange[2] = { Emin, -Emax };
+	mpiWorld->allReduce(Erange, 2, MPIUtil::ReduceMin);
+	Emin = Erange[0]; Emax = -Erange[1];
+	reduction.wait();
 	//Print stats:
 	logPrintf("\tIdealGas%s[%s] single molecule energy: min = %le, max = %le, mean = %le\n",
 		   representationName().c_str(), molecule.name.c_str(), Emin, Emax, Emean);
@@ -85,25 +157,44 @@ void IdealGasPomega::getDensities(const ScalarField* indep, ScalarField* N, vect
 	double& S = ((IdealGasPomega*)this)->S;
 	S=0.0;
 	VectorField P;
-	//Loop over orientations:
-	for(int o=oStart; o<oStop; o++)
-	{	matrix3<> rot = matrixFromEuler(quad.euler(o));
-		ScalarField logPomega_o; getDensities_o(o, rot, indep,logPomega_o);
-		ScalarField N_o = (quad.weight(o) * Nbulk) * exp(logPomega_o); //contribution form this orientation
-		//Accumulate N_o to each site density with appropriate translations:
-		for(unsigned i=0; i<molecule.sites.size(); i++)
-			for(vector3<> pos: molecule.sites[i]->positions)
-				trans.taxpy(rot*pos, 1., N_o, N[i]);
-		//Accumulate contributions to the entropy:
-		S += gInfo.dV*dot(N_o, logPomega_o);
-		//Accumulate the polarization density:
-		if(pMol.length_squared()) P += (rot * pMol) * N_o;
+	bool polar = pMol.length_squared();
+	//Loop over orientations, with separate density, entropy and polarization accumulators per thread:
+	int nChunks = nOrientationChunks();
+	std::vector<ScalarFieldArray> Nchunk(nChunks, ScalarFieldArray(molecule.sites.size()));
+	std::vector<double> Schunk(nChunks, 0.);
+	std::vector<VectorField> Pchunk(nChunks);
+	orientationThreads(nChunks, [&](int oBegin, int oEnd, int iChunk)
+	{	for(int o=oBegin; o<oEnd; o++)
+		{	matrix3<> rot = matrixFromEuler(quad.euler(o));
+			ScalarField logPomega_o; getDensities_o(o, rot, indep,logPomega_o);
+			ScalarField N_o = (quad.weight(o) * Nbulk) * exp(logPomega_o); //contribution form this orientation
+			//Accumulate N_o to each site density with appropriate translations:
+			for(unsigned i=0; i<molecule.sites.size(); i++)
+				trans.taxpyMany(siteShifts(i, rot, +1), N_o, Nchunk[iChunk][i]);
+			//Accumulate contributions to the entropy:
+			Schunk[iChunk] += gInfo.dV*dot(N_o, logPomega_o);
+			//Accumulate the polarization density:
+			if(polar) Pchunk[iChunk] += (rot * pMol) * N_o;
+		}
+	});
+	//Collect over threads:
+	for(int iChunk=0; iChunk<nChunks; iChunk++)
+	{	for(unsigned i=0; i<molecule.sites.size(); i++)
+			if(Nchunk[iChunk][i]) N[i] += Nchunk[iChunk][i];
+		S += Schunk[iChunk];
+		if(polar) for(int k=0; k<3; k++) if(Pchunk[iChunk][k]) P[k] += Pchunk[iChunk][k];
 	}
+	Nchunk.clear(); Pchunk.clear();
 	//MPI collect:
-	for(unsigned i=0; i<molecule.sites.size(); i++) { nullToZero(N[i],gInfo); N[i]->allReduceData(mpiWorld, MPIUtil::ReduceSum); }
-	mpiWorld->allReduce(S, MPIUtil::ReduceSum);
-	if(pMol.length_squared()) for(int k=0; k<3; k++) { nullToZero(P[k],gInfo); P[k]->allReduceData(mpiWorld, MPIUtil::ReduceSum); }
-	//Compute and cache dipole correlation correction:
+	std::vector<ScalarField*> fields;
+	for(unsigned i=0; i<molecule.sites.size(); i++) fields.push_back(&N[i]);
+	if(polar) for(int k=0; k<3; k++) fields.push_back(&P[k]);
+	PackedAllReduce(gInfo, fields, {&S}).wait();
+	setDipoleCorrection(P, P0);
+}
+
+void IdealGasPomega::setDipoleCorrection(const VectorField& P, vector3<>& P0) const
+{	//Compute and cache dipole correlation correction:
 	IdealGasPomega* cache = ((IdealGasPomega*)this);
 	if(pMol.length_squared())
 	{	P0 = sumComponents(P) / gInfo.nr;
@@ -137,23 +228,31 @@ double IdealGasPomega::compute(const ScalarField* indep, const ScalarField* N, S
 
 void IdealGasPomega::convertGradients(const ScalarField* indep, const ScalarField* N, const ScalarField* Phi_N, const vector3<>& Phi_P0, ScalarField* Phi_indep, const double Nscale) const
 {	for(int k=0; k<nIndep; k++) Phi_indep[k]=0;
-	//Loop over orientations:
-	for(int o=oStart; o<oStop; o++)
-	{	matrix3<> rot = matrixFromEuler(quad.euler(o));
-		ScalarField logPomega_o; getDensities_o(o, rot, indep, logPomega_o);
-		ScalarField N_o = (quad.weight(o) * Nbulk * Nscale) * exp(logPomega_o);
-		ScalarField Phi_N_o; //gradient w.r.t N_o (as calculated in getDensities)
-		//Collect the contributions from each Phi_N in Phi_N_o
-		for(unsigned i=0; i<molecule.sites.size(); i++)
-			for(vector3<> pos: molecule.sites[i]->positions)
-				trans.taxpy(-rot*pos, 1., Phi_N[i], Phi_N_o);
-		//Collect the contributions from the entropy:
-		Phi_N_o += T*logPomega_o;
-		//Collect the contribution from Phi_P0 and Ecorr_P:
-		if(pMol.length_squared()) Phi_N_o += dot(rot * pMol, Nscale*Ecorr_P) + dot(rot * pMol, Phi_P0);
-		//Propagate Phi_N_o to Phi_logPomega_o and then to Phi_indep:
-		convertGradients_o(o, rot, N_o*Phi_N_o, Phi_indep);
-	}
-	for(int k=0; k<nIndep; k++) { nullToZero(Phi_indep[k],gInfo); Phi_indep[k]->allReduceData(mpiWorld, MPIUtil::ReduceSum); }
+	//Loop over orientations, with separate gradient accumulators per thread:
+	int nChunks = nOrientationChunks();
+	std::vector<ScalarFieldArray> Phi_indepChunk(nChunks, ScalarFieldArray(nIndep));
+	orientationThreads(nChunks, [&](int oBegin, int oEnd, int iChunk)
+	{	for(int o=oBegin; o<oEnd; o++)
+		{	matrix3<> rot = matrixFromEuler(quad.euler(o));
+			ScalarField logPomega_o; getDensities_o(o, rot, indep, logPomega_o);
+			ScalarField N_o = (quad.weight(o) * Nbulk * Nscale) * exp(logPomega_o);
+			ScalarField Phi_N_o; //gradient w.r.t N_o (as calculated in getDensities)
+			//Collect the contributions from each Phi_N in Phi_N_o
+			for(unsigned i=0; i<molecule.sites.size(); i++)
+				trans.taxpyMany(siteShifts(i, rot, -1), Phi_N[i], Phi_N_o);
+			//Collect the contributions from the entropy:
+			Phi_N_o += T*logPomega_o;
+			//Collect the contribution from Phi_P0 and Ecorr_P:
+			if(pMol.length_squared()) Phi_N_o += dot(rot * pMol, Nscale*Ecorr_P) + dot(rot * pMol, Phi_P0);
+			//Propagate Phi_N_o to Phi_logPomega_o and then to Phi_indep:
+			convertGradients_o(o, rot, N_o*Phi_N_o, Phi_indepChunk[iChunk].data());
+		}
+	});
+	//Collect over threads and processes:
+	for(int iChunk=0; iChunk<nChunks; iChunk++)
+		for(int k=0; k<nIndep; k++)
+			if(Phi_indepChunk[iChunk][k]) Phi_indep[k] += Phi_indepChunk[iChunk][k];
+	Phi_indepChunk.clear();
+	std::vector<ScalarField*> fields; for(int k=0; k<nIndep; k++) fields.push_back(&Phi_indep[k]);
+	PackedAllReduce(gInfo, fields, {}).wait();
 }
-
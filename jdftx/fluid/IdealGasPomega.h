@@ -24,10 +24,27 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/SO3quad.h>
 #include <fluid/TranslationOperator.h>
 #include <core/VectorField.h>
+#include <functional>
 
 //! @addtogroup ClassicalDFT
 //! @{
 
+//! Sum fields and scalars over processes using a single non-blocking reduction of a packed buffer
+class PackedAllReduce
+{
+public:
+	PackedAllReduce(const GridInfo& gInfo, const std::vector<ScalarField*>& fields, const std::vector<double*>& scalars); //!< make fields non-null and start the reduction
+	void wait(); //!< complete the reduction and unpack the results
+	~PackedAllReduce() { wait(); }
+private:
+	const GridInfo& gInfo;
+	std::vector<ScalarField*> fields;
+	std::vector<double*> scalars;
+	ManagedArray<double> buf;
+	MPIUtil::Request request;
+	bool pending;
+};
+
 //! IdealGas for polyatomic molecules with the orientation densities 'P_omega' as independent variables
 //! This is also the base class for IdealGas's which used compressed representations of Pomega
 class IdealGasPomega : public IdealGas
@@ -50,14 +67,20 @@ protected:
 	
 	virtual string representationName() const;
 	
+	//! Translations (with unit weights) of all positions of site i in orientation rot, negated if sign<0
+	TranslationOperator::ShiftList siteShifts(unsigned i, const matrix3<>& rot, int sign) const;
+	
+	int nOrientationChunks() const; //!< number of chunks (one per thread, each with its own accumulators) to divide [oStart,oStop) into
+	void orientationThreads(int nChunks, const std::function<void(int,int,int)>& loop) const; //!< run loop(oStartChunk, oStopChunk, iChunk) in parallel over chunks of [oStart,oStop)
+	void setDipoleCorrection(const VectorField& P, vector3<>& P0) const; //!< compute P0 and cache Ecorr, Ecorr_P given the (process-reduced) polarization density P
+	
+	double S; //!< cache the entropy, because it is most efficiently computed during getDensities()
+	double Ecorr; VectorField Ecorr_P; //!< cache the correlation correction and its derivatives, since they are most efficiently computed during getDensities()
+	
 	//These functions are called once for each orientation:
 	virtual void initState_o(int o, const matrix3<>& rot, double scale, const ScalarField& Eo, ScalarField* state) const;
 	virtual void getDensities_o(int o, const matrix3<>& rot, const ScalarField* state, ScalarField& logPomega_o) const;
 	virtual void convertGradients_o(int o, const matrix3<>& rot, const ScalarField& Phi_logPomega_o, ScalarField* Phi_state) const;
-	
-private:
-	double S; //!< cache the entropy, because it is most efficiently computed during getDensities()
-	double Ecorr; VectorField Ecorr_P; //!< cache the correlation correction and its derivatives, since they are most efficiently computed during getDensities()
 };
 
 //! @}
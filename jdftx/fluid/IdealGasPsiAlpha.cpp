@@ -48,12 +48,10 @@ void IdealGasPsiAlpha::initState(const ScalarField* Vex, ScalarField* psi, doubl
 
 void IdealGasPsiAlpha::getDensities_o(int o, const matrix3<>& rot, const ScalarField* psi, ScalarField& logPomega_o) const
 {	for(unsigned i=0; i<molecule.sites.size(); i++)
-		for(vector3<> pos: molecule.sites[i]->positions)
-			trans.taxpy(-rot*pos, 1., psi[i], logPomega_o);
+		trans.taxpyMany(siteShifts(i, rot, -1), psi[i], logPomega_o);
 }
 
 void IdealGasPsiAlpha::convertGradients_o(int o, const matrix3<>& rot, const ScalarField& Phi_logPomega_o, ScalarField* Phi_psi) const
 {	for(unsigned i=0; i<molecule.sites.size(); i++)
-		for(vector3<> pos: molecule.sites[i]->positions)
-			trans.taxpy(rot*pos, 1., Phi_logPomega_o, Phi_psi[i]);
+		trans.taxpyMany(siteShifts(i, rot, +1), Phi_logPomega_o, Phi_psi[i]);
 }
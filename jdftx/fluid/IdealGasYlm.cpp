@@ -0,0 +1,211 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#include <fluid/IdealGasYlm.h>
+#include <fluid/FluidComponent.h>
+#include <fluid/Euler.h>
+#include <core/SphericalHarmonics.h>
+#include <core/ScalarFieldArray.h>
+
+//Radial part of the plane-wave expansion exp(i G.r) = 4 pi sum_lm i^l j_l(Gr) Y_lm(Ghat) Y_lm(rHat),
+//divided by G^l which is included in the (unnormalized) spherical harmonics of lGradient / lDivergence:
+inline double wTranslation_calc(double G, int l, double r)
+{	double x = G*r;
+	if(x == 0.)
+	{	double doubleFactorial = 1.; for(int i=3; i<=2*l+1; i+=2) doubleFactorial *= i;
+		return 4*M_PI * pow(r,l) / doubleFactorial;
+	}
+	return 4*M_PI * bessel_jl(l, x) * pow(r/x, l);
+}
+
+IdealGasYlm::IdealGasYlm(const FluidMixture* fluidMixture, const FluidComponent* comp, const SO3quad& quad, const TranslationOperator& trans, int lmax)
+: IdealGasPomega(fluidMixture, comp, quad, trans, comp->molecule.sites.size()), lmax(lmax), nCoeff(0)
+{	assert(lmax >= 0 && lmax <= 6);
+	//Enumerate site positions and initialize the radial parts of their expansion:
+	for(unsigned i=0; i<molecule.sites.size(); i++)
+		for(vector3<> pos: molecule.sites[i]->positions)
+		{	Position p;
+			p.iSite = i;
+			p.r = pos.length();
+			p.lmax = (p.r > 0.) ? lmax : 0; //only the isotropic term contributes at the origin
+			p.rHat = (p.lmax ? pos/p.r : vector3<>());
+			p.offset = nCoeff;
+			nCoeff += (p.lmax+1)*(p.lmax+1);
+			p.w.resize(p.lmax+1);
+			for(int l=0; l<=p.lmax; l++)
+				p.w[l].init(l, gInfo.dGradial, gInfo.GmaxGrid, wTranslation_calc, l, p.r);
+			positions.push_back(p);
+		}
+	//Spherical harmonics of the rotated site positions for each orientation on this process:
+	Yrot.assign(oStop-oStart, std::vector<double>(nCoeff));
+	for(int o=oStart; o<oStop; o++)
+	{	matrix3<> rot = matrixFromEuler(quad.euler(o));
+		for(const Position& p: positions)
+			for(int l=0; l<=p.lmax; l++)
+				for(int m=-l; m<=l; m++)
+					Yrot[o-oStart][p.offset + l*(l+1)+m] = Ylm(l, m, rot*p.rHat);
+	}
+	logPrintf("\tIdealGasYlm[%s]: expanding site translations up to lmax = %d in %d coefficient fields.\n",
+		molecule.name.c_str(), lmax, nCoeff);
+}
+
+IdealGasYlm::~IdealGasYlm()
+{	for(Position& p: positions)
+		for(RadialFunctionG& w: p.w)
+			w.free();
+}
+
+string IdealGasYlm::representationName() const
+{	return "Ylm";
+}
+
+void IdealGasYlm::expand(const ScalarField* x, ScalarFieldArray& xYlm) const
+{	xYlm.assign(nCoeff, ScalarField());
+	ScalarFieldTildeArray xTilde(molecule.sites.size());
+	for(const Position& p: positions)
+	{	if(!xTilde[p.iSite])
+		{	ScalarField xi = x[p.iSite]; nullToZero(xi, gInfo);
+			xTilde[p.iSite] = J(xi);
+		}
+		for(int l=0; l<=p.lmax; l++)
+		{	ScalarFieldTildeArray xlm = lGradient(p.w[l] * xTilde[p.iSite], l);
+			for(int m=-l; m<=l; m++)
+				xYlm[p.offset + l*(l+1)+m] = I(xlm[l+m]);
+		}
+	}
+}
+
+void IdealGasYlm::collect(const ScalarFieldArray& xYlm, ScalarField* y) const
+{	ScalarFieldTildeArray yTilde(molecule.sites.size());
+	for(const Position& p: positions)
+		for(int l=0; l<=p.lmax; l++)
+		{	ScalarFieldTildeArray xlm(2*l+1);
+			for(int m=-l; m<=l; m++)
+			{	ScalarField xYlm_lm = xYlm[p.offset + l*(l+1)+m]; nullToZero(xYlm_lm, gInfo);
+				xlm[l+m] = J(xYlm_lm);
+			}
+			//Adjoint of lGradient (i^l -> (-i)^l) is (-1)^l times lDivergence:
+			yTilde[p.iSite] += (l%2 ? -1. : +1.) * (p.w[l] * lDivergence(xlm, l));
+		}
+	for(unsigned i=0; i<molecule.sites.size(); i++)
+		if(yTilde[i]) y[i] += I(yTilde[i]);
+}
+
+ScalarField IdealGasYlm::combine(const std::vector<double>& Y, const ScalarFieldArray& xYlm) const
+{	ScalarField result;
+	for(int c=0; c<nCoeff; c++)
+		if(Y[c]) axpy(Y[c], xYlm[c], result);
+	return result;
+}
+
+
+void IdealGasYlm::initState(const ScalarField* Vex, ScalarField* psi, double scale, double Elo, double Ehi) const
+{	//Initialize the state (simply a constant factor times the potential, as in IdealGasPsiAlpha):
+	for(unsigned i=0; i<molecule.sites.size(); i++)
+	{	ScalarField Veff_i; nullToZero(Veff_i, gInfo);
+		Veff_i += V[i];
+		Veff_i += Vex[i];
+		psi[i] = (-scale/T)*Veff_i;
+	}
+}
+
+void IdealGasYlm::getDensities(const ScalarField* psi, ScalarField* N, vector3<>& P0) const
+{	ScalarFieldArray psiYlm; expand(psi, psiYlm);
+	bool polar = pMol.length_squared();
+	//Loop over orientations (local in real space), with separate projected density, entropy and polarization accumulators per thread:
+	int nChunks = nOrientationChunks();
+	std::vector<ScalarFieldArray> NYlmChunk(nChunks, ScalarFieldArray(nCoeff));
+	std::vector<double> Schunk(nChunks, 0.);
+	std::vector<VectorField> Pchunk(nChunks);
+	orientationThreads(nChunks, [&](int oBegin, int oEnd, int iChunk)
+	{	for(int o=oBegin; o<oEnd; o++)
+		{	const std::vector<double>& Y = Yrot[o-oStart];
+			ScalarField logPomega_o = combine(Y, psiYlm);
+			ScalarField N_o = (quad.weight(o) * Nbulk) * exp(logPomega_o); //contribution form this orientation
+			//Project N_o onto the harmonics of each rotated site position:
+			for(int c=0; c<nCoeff; c++)
+				if(Y[c]) axpy(Y[c], N_o, NYlmChunk[iChunk][c]);
+			//Accumulate contributions to the entropy:
+			Schunk[iChunk] += gInfo.dV*dot(N_o, logPomega_o);
+			//Accumulate the polarization density:
+			if(polar) Pchunk[iChunk] += (matrixFromEuler(quad.euler(o)) * pMol) * N_o;
+		}
+	});
+	psiYlm.clear();
+	//Collect over threads:
+	ScalarFieldArray NYlm(nCoeff);
+	double& S = ((IdealGasYlm*)this)->S;
+	S = 0.;
+	VectorField P;
+	for(int iChunk=0; iChunk<nChunks; iChunk++)
+	{	for(int c=0; c<nCoeff; c++)
+			if(NYlmChunk[iChunk][c]) NYlm[c] += NYlmChunk[iChunk][c];
+		S += Schunk[iChunk];
+		if(polar) for(int k=0; k<3; k++) if(Pchunk[iChunk][k]) P[k] += Pchunk[iChunk][k];
+	}
+	NYlmChunk.clear(); Pchunk.clear();
+	//Site densities (translation is linear, so apply before the MPI collect which then involves fewer fields):
+	for(unsigned i=0; i<molecule.sites.size(); i++) N[i]=0;
+	collect(NYlm, N);
+	NYlm.clear();
+	//MPI collect:
+	std::vector<ScalarField*> fields;
+	for(unsigned i=0; i<molecule.sites.size(); i++) fields.push_back(&N[i]);
+	if(polar) for(int k=0; k<3; k++) fields.push_back(&P[k]);
+	PackedAllReduce(gInfo, fields, {&S}).wait();
+	setDipoleCorrection(P, P0);
+}
+
+void IdealGasYlm::convertGradients(const ScalarField* psi, const ScalarField* N, const ScalarField* Phi_N, const vector3<>& Phi_P0, ScalarField* Phi_psi, const double Nscale) const
+{	ScalarFieldArray psiYlm; expand(psi, psiYlm);
+	ScalarFieldArray Phi_NYlm; expand(Phi_N, Phi_NYlm); //gradient w.r.t N_o, projected onto each (position,lm)
+	//Loop over orientations, with separate gradient accumulators per thread:
+	int nChunks = nOrientationChunks();
+	std::vector<ScalarFieldArray> Phi_psiYlmChunk(nChunks, ScalarFieldArray(nCoeff));
+	orientationThreads(nChunks, [&](int oBegin, int oEnd, int iChunk)
+	{	for(int o=oBegin; o<oEnd; o++)
+		{	const std::vector<double>& Y = Yrot[o-oStart];
+			ScalarField logPomega_o = combine(Y, psiYlm);
+			ScalarField N_o = (quad.weight(o) * Nbulk * Nscale) * exp(logPomega_o);
+			//Collect the contributions from each Phi_N, the entropy and dipole correction in Phi_N_o:
+			ScalarField Phi_N_o = combine(Y, Phi_NYlm);
+			Phi_N_o += T*logPomega_o;
+			if(pMol.length_squared())
+			{	vector3<> pVec = matrixFromEuler(quad.euler(o)) * pMol;
+				Phi_N_o += dot(pVec, Nscale*Ecorr_P) + dot(pVec, Phi_P0);
+			}
+			//Propagate Phi_N_o to Phi_logPomega_o and then to the projections of Phi_psi:
+			ScalarField Phi_logPomega_o = N_o*Phi_N_o;
+			for(int c=0; c<nCoeff; c++)
+				if(Y[c]) axpy(Y[c], Phi_logPomega_o, Phi_psiYlmChunk[iChunk][c]);
+		}
+	});
+	psiYlm.clear(); Phi_NYlm.clear();
+	//Collect over threads, translate back to sites and collect over processes:
+	ScalarFieldArray Phi_psiYlm(nCoeff);
+	for(int iChunk=0; iChunk<nChunks; iChunk++)
+		for(int c=0; c<nCoeff; c++)
+			if(Phi_psiYlmChunk[iChunk][c]) Phi_psiYlm[c] += Phi_psiYlmChunk[iChunk][c];
+	Phi_psiYlmChunk.clear();
+	for(unsigned i=0; i<molecule.sites.size(); i++) Phi_psi[i]=0;
+	collect(Phi_psiYlm, Phi_psi);
+	std::vector<ScalarField*> fields; for(unsigned i=0; i<molecule.sites.size(); i++) fields.push_back(&Phi_psi[i]);
+	PackedAllReduce(gInfo, fields, {}).wait();
+}
@@ -0,0 +1,76 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+
+#ifndef JDFTX_FLUID_IDEALGASYLM_H
+#define JDFTX_FLUID_IDEALGASYLM_H
+
+#include <fluid/IdealGasPomega.h>
+#include <core/RadialFunction.h>
+
+//! @addtogroup ClassicalDFT
+//! @{
+
+//! IdealGas for polyatomic molecules with site potentials 'psi_alpha' as independent variables (as in IdealGasPsiAlpha),
+//! but with the translations of each site position expanded in spherical harmonics of the rotated position up to lmax.
+//! The orientation dependence then enters only through the site-position harmonics, so that the orientation loop
+//! is purely local in real space, and all translations are applied once per coefficient field in reciprocal space.
+class IdealGasYlm : public IdealGasPomega
+{
+public:
+	//!Initialize and associate with excess functional fex (and its fluid mixture)
+	//!Also specify the orientation quadrature used for the orientation integrals and the angular momentum cutoff lmax (at most 6)
+	IdealGasYlm(const FluidMixture*, const FluidComponent*, const SO3quad& quad, const TranslationOperator& trans, int lmax);
+	~IdealGasYlm();
+
+	void initState(const ScalarField* Vex, ScalarField* psi, double scale, double Elo, double Ehi) const;
+	void getDensities(const ScalarField* psi, ScalarField* N, vector3<>& P0) const;
+	void convertGradients(const ScalarField* psi, const ScalarField* N, const ScalarField* Phi_N, const vector3<>& Phi_P0, ScalarField* Phi_psi, const double Nscale) const;
+
+protected:
+	string representationName() const;
+
+private:
+	const int lmax; //!< angular momentum cutoff of the expansion
+	
+	//! Site position in the molecule frame along with its expansion data
+	struct Position
+	{	unsigned iSite; //!< site index
+		double r; //!< distance from molecule origin
+		vector3<> rHat; //!< unit vector from molecule origin (zero when r=0)
+		int lmax; //!< angular momentum cutoff for this position (0 for positions at the origin)
+		int offset; //!< offset into the coefficient fields
+		std::vector<RadialFunctionG> w; //!< radial parts 4 pi j_l(Gr) / G^l of the plane-wave expansion for each l
+	};
+	std::vector<Position> positions;
+	int nCoeff; //!< total number of coefficient fields over all positions
+	std::vector<std::vector<double>> Yrot; //!< Y_lm(rot * rHat) for each orientation in [oStart,oStop) and coefficient
+	
+	//! Translate each site field x by minus the rotated site positions, projected onto each (position,lm): output has nCoeff fields
+	void expand(const ScalarField* x, ScalarFieldArray& xYlm) const;
+	
+	//! Accumulate the adjoint of expand (i.e. translations by plus the rotated positions) from xYlm into the site fields y
+	void collect(const ScalarFieldArray& xYlm, ScalarField* y) const;
+	
+	//! Combine coefficient fields xYlm with the harmonics Y of one orientation
+	ScalarField combine(const std::vector<double>& Y, const ScalarFieldArray& xYlm) const;
+};
+
+//! @}
+#endif // JDFTX_FLUID_IDEALGASYLM_H
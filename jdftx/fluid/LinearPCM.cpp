@@ -93,7 +93,8 @@ void LinearPCM::override(const ScalarField& epsilon, const ScalarField& kappaSq)
 }
 
 void LinearPCM::minimizeFluid()
-{	//Info:
+{	static const int phaseId = Profiler::registerName("FluidSolve"); ProfilePhase phase(phaseId);
+	//Info:
 	if(fsp.epsBulkTensor.length_squared())
 		logPrintf("\tLinear fluid (dielectric tensor: [ %g %g %g ]",
 			fsp.epsBulkTensor[0], fsp.epsBulkTensor[1], fsp.epsBulkTensor[2]);
@@ -102,8 +103,11 @@ void LinearPCM::minimizeFluid()
 	if(k2factor) logPrintf(", screening length: %g Bohr", sqrt(epsBulk/k2factor));
 	logPrintf(") occupying %lf of unit cell:", integral(shape[0])/gInfo.detR); logFlush();
 	//Minimize:
-	fprintf(e.fluidMinParams.fpLog, "\n\tWill stop at %d iterations, or sqrt(|r.z|)<%le\n", e.fluidMinParams.nIterations, e.fluidMinParams.knormThreshold);
-	int nIter = solve(rhoExplicitTilde, e.fluidMinParams);
+	MinimizeParams mp = innerMinParams();
+	fprintf(mp.fpLog, "\n\tWill stop at %d iterations, or sqrt(|r.z|)<%le\n", mp.nIterations, mp.knormThreshold);
+	recycleGuess(state, rhoExplicitTilde);
+	int nIter = solve(rhoExplicitTilde, mp);
+	recycleStore(state, rhoExplicitTilde);
 	logPrintf("\tCompleted after %d iterations at t[s]: %9.2lf\n", nIter, clock_sec());
 }
 
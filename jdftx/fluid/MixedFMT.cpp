@@ -62,6 +62,63 @@ ScalarFieldTilde tensorKernel_grad(const TensorFieldTilde& grad_mTilde)
 }
 
 
+//Weighted densities and their gradient propagation in a single pass over reciprocal space (threaded/gpu):
+inline FMTweights getFMTweights(const Molecule::Site& s)
+{	FMTweights fw;
+	fw.w[0] = s.w0; fw.w[1] = s.w1; fw.w[2] = s.w2;
+	fw.w[3] = s.w3; fw.w[4] = s.w1v; fw.w[5] = s.w2m;
+	return fw;
+}
+inline void fmtWeightedDensities_sub(size_t iStart, size_t iStop, vector3<int> S, const matrix3<> GGT,
+	const complex* N, const FMTweights& fw, array<complex*,6> n)
+{	THREAD_halfGspaceLoop( fmtWeightedDensities_calc(i, sqrt(GGT.metric_length_squared(iG)), N, fw, n); )
+}
+inline void fmtWeightedDensities_grad_sub(size_t iStart, size_t iStop, vector3<int> S, const matrix3<> GGT,
+	array<const complex*,6> Phi_n, const FMTweights& fw, double scale, complex* Phi_N)
+{	THREAD_halfGspaceLoop( fmtWeightedDensities_grad_calc(i, sqrt(GGT.metric_length_squared(iG)), Phi_n, fw, scale, Phi_N); )
+}
+#ifdef GPU_ENABLED
+void fmtWeightedDensities_gpu(vector3<int> S, const matrix3<> GGT,
+	const complex* N, const FMTweights& fw, array<complex*,6> n);
+void fmtWeightedDensities_grad_gpu(vector3<int> S, const matrix3<> GGT,
+	array<const complex*,6> Phi_n, const FMTweights& fw, double scale, complex* Phi_N);
+#endif
+
+void fmtWeightedDensities(const Molecule::Site& s, const ScalarFieldTilde& Nsite,
+	ScalarFieldTilde& n0tilde, ScalarFieldTilde& n1tilde, ScalarFieldTilde& n2tilde,
+	ScalarFieldTilde& n3tilde, ScalarFieldTilde& n1vTilde, ScalarFieldTilde& n2mTilde)
+{	const GridInfo& gInfo = Nsite->gInfo;
+	ScalarFieldTilde* n[6] = { &n0tilde, &n1tilde, &n2tilde, &n3tilde, &n1vTilde, &n2mTilde };
+	array<complex*,6> nData;
+	for(int k=0; k<6; k++)
+	{	nullToZero(*n[k], gInfo);
+		nData[k] = (*n[k])->dataPref();
+	}
+	FMTweights fw = getFMTweights(s);
+	#ifdef GPU_ENABLED
+	fmtWeightedDensities_gpu(gInfo.S, gInfo.GGT, Nsite->dataGpu(), fw, nData);
+	#else
+	threadLaunch(fmtWeightedDensities_sub, gInfo.nG, gInfo.S, gInfo.GGT, Nsite->data(), fw, nData);
+	#endif
+}
+
+void fmtWeightedDensities_grad(const Molecule::Site& s,
+	const ScalarFieldTilde& grad_n0tilde, const ScalarFieldTilde& grad_n1tilde, const ScalarFieldTilde& grad_n2tilde,
+	const ScalarFieldTilde& grad_n3tilde, const ScalarFieldTilde& grad_n1vTilde, const ScalarFieldTilde& grad_n2mTilde,
+	double scale, ScalarFieldTilde& grad_Nsite)
+{	const GridInfo& gInfo = grad_n0tilde->gInfo;
+	const ScalarFieldTilde* grad_n[6] = { &grad_n0tilde, &grad_n1tilde, &grad_n2tilde, &grad_n3tilde, &grad_n1vTilde, &grad_n2mTilde };
+	array<const complex*,6> grad_nData;
+	for(int k=0; k<6; k++) grad_nData[k] = (*grad_n[k])->dataPref();
+	nullToZero(grad_Nsite, gInfo);
+	FMTweights fw = getFMTweights(s);
+	#ifdef GPU_ENABLED
+	fmtWeightedDensities_grad_gpu(gInfo.S, gInfo.GGT, grad_nData, fw, scale, grad_Nsite->dataGpu());
+	#else
+	threadLaunch(fmtWeightedDensities_grad_sub, gInfo.nG, gInfo.S, gInfo.GGT, grad_nData, fw, scale, grad_Nsite->data());
+	#endif
+}
+
 #ifdef GPU_ENABLED
 void phiFMT_gpu(int N, double* phiArr,
 	const double *n0arr, const double *n1arr, const double *n2arr, const double *n3arr,
@@ -109,6 +166,95 @@ double PhiFMT(const ScalarField& n0, const ScalarField& n1, const ScalarField& n
 	return result;
 }
 
+//Expand / collect all the weighted densities in a single pass over reciprocal space (threaded/gpu):
+inline void fmtFusedExpand_sub(size_t iStart, size_t iStop, vector3<int> S, const matrix3<> G, size_t nG,
+	array<const complex*,6> n, complex* out)
+{	THREAD_halfGspaceLoop( fmtFusedExpand_calc(i, iG, IS_NYQUIST, G, nG, n, out); )
+}
+inline void fmtFusedExpand_grad_sub(size_t iStart, size_t iStop, vector3<int> S, const matrix3<> G, size_t nG,
+	const complex* grad_in, array<complex*,6> grad_n)
+{	THREAD_halfGspaceLoop( fmtFusedExpand_grad_calc(i, iG, IS_NYQUIST, G, nG, grad_in, grad_n); )
+}
+#ifdef GPU_ENABLED
+void fmtFusedExpand_gpu(vector3<int> S, const matrix3<> G, size_t nG, array<const complex*,6> n, complex* out);
+void fmtFusedExpand_grad_gpu(vector3<int> S, const matrix3<> G, size_t nG, const complex* grad_in, array<complex*,6> grad_n);
+#endif
+
+double PhiFMTfused(const ScalarFieldTilde nTilde[6], ScalarFieldTilde grad_nTilde[6], ScalarField* n2)
+{	static StopWatch watch("PhiFMTfused"); watch.start();
+	const GridInfo& gInfo = nTilde[0]->gInfo;
+	const size_t nr = gInfo.nr, nG = gInfo.nG;
+	bool onGpu = isGpuEnabled();
+	
+	//All weighted densities in reciprocal space in one pass:
+	ManagedArray<complex> bufTilde; bufTilde.init(nFMTfields*nG, onGpu);
+	array<const complex*,6> nData;
+	for(int k=0; k<6; k++) nData[k] = nTilde[k]->dataPref();
+	#ifdef GPU_ENABLED
+	fmtFusedExpand_gpu(gInfo.S, gInfo.G, nG, nData, bufTilde.dataGpu());
+	#else
+	threadLaunch(fmtFusedExpand_sub, nG, gInfo.S, gInfo.G, nG, nData, bufTilde.data());
+	#endif
+	
+	//Batched inverse FFT (destroys bufTilde, which is reused for the gradient below):
+	ManagedArray<double> buf; buf.init(nFMTfields*nr, onGpu);
+	#ifdef GPU_ENABLED
+	for(int k=0; k<nFMTfields; k++)
+		cufftExecZ2D(gInfo.planZ2D, (double2*)(bufTilde.dataGpu()+k*nG), buf.dataGpu()+k*nr);
+	#else
+	int nThreads = shouldThreadOperators() ? nProcsAvailable : 1;
+	fftw_execute_dft_c2r(gInfo.getPlan(GridInfo::PlanCtoR, nThreads, nFMTfields),
+		(fftw_complex*)bufTilde.data(), buf.data());
+	#endif
+	if(n2)
+	{	*n2 = ScalarFieldData::alloc(gInfo, onGpu);
+		callPref(eblas_copy)((*n2)->dataPref(), buf.dataPref()+2*nr, nr);
+	}
+	
+	//Pointwise free energy and gradients (in the same layout):
+	ManagedArray<double> grad_buf; grad_buf.init(nFMTfields*nr, onGpu);
+	callPref(eblas_zero)(nFMTfields*nr, grad_buf.dataPref());
+	const double* n = buf.dataPref(); double* g = grad_buf.dataPref();
+	vector3<const double*> n1v(n+4*nr, n+5*nr, n+6*nr), n2v(n+7*nr, n+8*nr, n+9*nr);
+	vector3<double*> grad_n1v(g+4*nr, g+5*nr, g+6*nr), grad_n2v(g+7*nr, g+8*nr, g+9*nr);
+	tensor3<const double*> n2m(n+10*nr, n+11*nr, n+12*nr, n+13*nr, n+14*nr);
+	tensor3<double*> grad_n2m(g+10*nr, g+11*nr, g+12*nr, g+13*nr, g+14*nr);
+	double result;
+	#ifdef GPU_ENABLED
+	{	ScalarField phiArr(ScalarFieldData::alloc(gInfo, true));
+		phiFMT_gpu(nr, phiArr->dataGpu(), n, n+nr, n+2*nr, n+3*nr, n1v, n2v, n2m,
+			g, g+nr, g+2*nr, g+3*nr, grad_n1v, grad_n2v, grad_n2m);
+		result = gInfo.dV * sum(phiArr);
+	}
+	#else
+	result = gInfo.dV*threadedAccumulate(phiFMT_calc, nr, n, n+nr, n+2*nr, n+3*nr, n1v, n2v, n2m,
+		g, g+nr, g+2*nr, g+3*nr, grad_n1v, grad_n2v, grad_n2m);
+	#endif
+	buf.free();
+	
+	//Mirrored path: batched forward FFT and one pass to the six reciprocal-space gradients:
+	#ifdef GPU_ENABLED
+	for(int k=0; k<nFMTfields; k++)
+		cufftExecD2Z(gInfo.planD2Z, grad_buf.dataGpu()+k*nr, (double2*)(bufTilde.dataGpu()+k*nG));
+	#else
+	fftw_execute_dft_r2c(gInfo.getPlan(GridInfo::PlanRtoC, nThreads, nFMTfields),
+		grad_buf.data(), (fftw_complex*)bufTilde.data());
+	#endif
+	grad_buf.free();
+	array<complex*,6> grad_nData;
+	for(int k=0; k<6; k++)
+	{	nullToZero(grad_nTilde[k], gInfo);
+		grad_nData[k] = grad_nTilde[k]->dataPref();
+	}
+	#ifdef GPU_ENABLED
+	fmtFusedExpand_grad_gpu(gInfo.S, gInfo.G, nG, bufTilde.dataGpu(), grad_nData);
+	#else
+	threadLaunch(fmtFusedExpand_grad_sub, nG, gInfo.S, gInfo.G, nG, bufTilde.data(), grad_nData);
+	#endif
+	watch.stop();
+	return result;
+}
+
 double phiFMTuniform(double n0, double n1, double n2, double n3,
 	double& grad_n0, double& grad_n1, double& grad_n2, double& grad_n3)
 {
@@ -33,6 +33,54 @@ void tensorKernel_gpu(const vector3<int> S, const matrix3<> G, const complex* nT
 	gpuErrorCheck();
 }
 
+__global__
+void fmtWeightedDensities_kernel(int zBlock, const vector3<int> S, const matrix3<> GGT, const complex* N, const FMTweights fw, array<complex*,6> n)
+{	COMPUTE_halfGindices
+	fmtWeightedDensities_calc(i, sqrt(GGT.metric_length_squared(iG)), N, fw, n);
+}
+void fmtWeightedDensities_gpu(const vector3<int> S, const matrix3<> GGT, const complex* N, const FMTweights& fw, array<complex*,6> n)
+{	GpuLaunchConfigHalf3D glc(fmtWeightedDensities_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		fmtWeightedDensities_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, GGT, N, fw, n);
+	gpuErrorCheck();
+}
+
+__global__
+void fmtWeightedDensities_grad_kernel(int zBlock, const vector3<int> S, const matrix3<> GGT, array<const complex*,6> Phi_n, const FMTweights fw, double scale, complex* Phi_N)
+{	COMPUTE_halfGindices
+	fmtWeightedDensities_grad_calc(i, sqrt(GGT.metric_length_squared(iG)), Phi_n, fw, scale, Phi_N);
+}
+void fmtWeightedDensities_grad_gpu(const vector3<int> S, const matrix3<> GGT, array<const complex*,6> Phi_n, const FMTweights& fw, double scale, complex* Phi_N)
+{	GpuLaunchConfigHalf3D glc(fmtWeightedDensities_grad_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		fmtWeightedDensities_grad_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, GGT, Phi_n, fw, scale, Phi_N);
+	gpuErrorCheck();
+}
+
+__global__
+void fmtFusedExpand_kernel(int zBlock, const vector3<int> S, const matrix3<> G, size_t nG, array<const complex*,6> n, complex* out)
+{	COMPUTE_halfGindices
+	fmtFusedExpand_calc(i, iG, IS_NYQUIST, G, nG, n, out);
+}
+void fmtFusedExpand_gpu(const vector3<int> S, const matrix3<> G, size_t nG, array<const complex*,6> n, complex* out)
+{	GpuLaunchConfigHalf3D glc(fmtFusedExpand_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		fmtFusedExpand_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, G, nG, n, out);
+	gpuErrorCheck();
+}
+
+__global__
+void fmtFusedExpand_grad_kernel(int zBlock, const vector3<int> S, const matrix3<> G, size_t nG, const complex* grad_in, array<complex*,6> grad_n)
+{	COMPUTE_halfGindices
+	fmtFusedExpand_grad_calc(i, iG, IS_NYQUIST, G, nG, grad_in, grad_n);
+}
+void fmtFusedExpand_grad_gpu(const vector3<int> S, const matrix3<> G, size_t nG, const complex* grad_in, array<complex*,6> grad_n)
+{	GpuLaunchConfigHalf3D glc(fmtFusedExpand_grad_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		fmtFusedExpand_grad_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, G, nG, grad_in, grad_n);
+	gpuErrorCheck();
+}
+
 __global__
 void tensorKernel_grad_kernel(int zBlock, const vector3<int> S, const matrix3<> G, tensor3<const complex*> grad_mTilde, complex* grad_nTilde)
 {	COMPUTE_halfGindices
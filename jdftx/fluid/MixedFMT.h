@@ -21,6 +21,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #define JDFTX_FLUID_MIXEDFMT_H
 
 #include <core/Operators.h>
+#include <fluid/Molecule.h>
 
 //! @addtogroup ClassicalDFT
 //! @{
@@ -38,12 +39,32 @@ double PhiFMT(const ScalarField& n0, const ScalarField& n1, const ScalarField& n
 	ScalarField& grad_n0, ScalarField& grad_n1, ScalarField& grad_n2,
 	ScalarFieldTilde& grad_n3tilde, ScalarFieldTilde& grad_n1vTilde, ScalarFieldTilde& grad_n2mTilde);
 
+//! Fused equivalent of PhiFMT() starting from the six reciprocal-space weighted densities nTilde
+//! accumulated by fmtWeightedDensities() (in the order n0, n1, n2, n3, n1v, n2m): all the scalar, vector and tensor
+//! weighted densities are expanded in one reciprocal-space pass and one batched inverse FFT, and the gradients
+//! return by the mirrored path (one batched forward FFT and one pass) to accumulate in grad_nTilde.
+//! If n2 is non-null, it is set to the real-space n2 (needed by PhiBond).
+double PhiFMTfused(const ScalarFieldTilde nTilde[6], ScalarFieldTilde grad_nTilde[6], ScalarField* n2=0);
+
 //! Returns the free energy density/T and accumulates derivatives
 //! corresponding to PhiFMT() for the uniform fluid
 double phiFMTuniform(double n0, double n1, double n2, double n3,
 	double& grad_n0, double& grad_n1, double& grad_n2, double& grad_n3);
 
 
+//! Accumulate the six weighted densities of hard-sphere site s with density Nsite (all in reciprocal space),
+//! evaluating all the weight functions in a single pass (instead of six separate convolutions and temporaries)
+void fmtWeightedDensities(const Molecule::Site& s, const ScalarFieldTilde& Nsite,
+	ScalarFieldTilde& n0tilde, ScalarFieldTilde& n1tilde, ScalarFieldTilde& n2tilde,
+	ScalarFieldTilde& n3tilde, ScalarFieldTilde& n1vTilde, ScalarFieldTilde& n2mTilde);
+
+//! Propagate gradients with respect to all six weighted densities to the site density in a single pass
+//! i.e. accumulate scale * (w0 * grad_n0tilde + ... + w2m * grad_n2mTilde) to grad_Nsite
+void fmtWeightedDensities_grad(const Molecule::Site& s,
+	const ScalarFieldTilde& grad_n0tilde, const ScalarFieldTilde& grad_n1tilde, const ScalarFieldTilde& grad_n2tilde,
+	const ScalarFieldTilde& grad_n3tilde, const ScalarFieldTilde& grad_n1vTilde, const ScalarFieldTilde& grad_n2mTilde,
+	double scale, ScalarFieldTilde& grad_Nsite);
+
 //! Bonding correction for tangentially bonded hard spheres
 //! Rhm = Ra Rb /(Ra+Rb) is the harmonic sum of the sphere radii
 //! scale is a scale factor for the correction (ratio of bond multiplicity to number of hard sphere sites in molecule)
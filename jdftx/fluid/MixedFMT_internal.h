@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/matrix3.h>
 #include <core/tensor3.h>
+#include <core/RadialFunction.h>
 
 //! @addtogroup ClassicalDFT
 //! @{
@@ -56,6 +57,73 @@ __hostanddev__ void tensorKernel_grad_calc(int i, const vector3<int> iG, bool ny
 	grad_nTilde[i] = -temp;
 }
 
+//! Hard sphere weight functions of one site (w0, w1, w2, w3, w1v, w2m), bundled for single-pass convolutions
+struct FMTweights
+{	RadialFunctionG w[6];
+};
+
+//! Accumulate all six weighted densities of one site density: n[k] += w[k] * N
+__hostanddev__ void fmtWeightedDensities_calc(int i, double G, const complex* N, const FMTweights& fw, array<complex*,6> n)
+{	complex Ni = N[i];
+	for(int k=0; k<6; k++) n[k][i] += fw.w[k](G) * Ni;
+}
+
+//! Propagate gradients with respect to all six weighted densities to a site density: Phi_N += scale * sum_k w[k] * Phi_n[k]
+__hostanddev__ void fmtWeightedDensities_grad_calc(int i, double G, array<const complex*,6> Phi_n, const FMTweights& fw, double scale, complex* Phi_N)
+{	complex temp = complex(0,0);
+	for(int k=0; k<6; k++) temp += fw.w[k](G) * Phi_n[k][i];
+	Phi_N[i] += scale * temp;
+}
+
+//! Number of real-space weighted densities in the fused FMT pipeline: n0, n1, n2, n3, n1v (3), n2v (3) and n2m (5)
+static const int nFMTfields = 15;
+
+//! Expand the six reciprocal-space weighted densities (n0, n1, n2, n3, n1v, n2m scalar kernels) into all
+//! nFMTfields scalar, vector and tensor weighted densities, stored contiguously with stride nG (for a batched inverse FFT)
+__hostanddev__ void fmtFusedExpand_calc(int i, const vector3<int> iG, bool nyq, const matrix3<> G, size_t nG,
+	array<const complex*,6> n, complex* out)
+{	for(int k=0; k<4; k++) out[k*nG+i] = n[k][i];
+	vector3<> Gvec = iG*G;
+	complex iota(0.0, nyq ? 0.0 : 1.0); //zero nyquist frequencies
+	complex n1v = iota * n[4][i]; //n1v = gradient(n1vTilde)
+	complex n2v = (-iota) * n[3][i]; //n2v = -gradient(n3tilde)
+	for(int j=0; j<3; j++)
+	{	out[(4+j)*nG+i] = Gvec[j] * n1v;
+		out[(7+j)*nG+i] = Gvec[j] * n2v;
+	}
+	complex minus_n2m = nyq ? complex(0,0) : -n[5][i]; //n2m = tensorKernel(n2mTilde)
+	double Gsq = Gvec.length_squared();
+	out[10*nG+i] = minus_n2m*Gvec.x()*Gvec.y();
+	out[11*nG+i] = minus_n2m*Gvec.y()*Gvec.z();
+	out[12*nG+i] = minus_n2m*Gvec.z()*Gvec.x();
+	out[13*nG+i] = minus_n2m*(Gvec.x()*Gvec.x() - (1.0/3)*Gsq);
+	out[14*nG+i] = minus_n2m*(Gvec.y()*Gvec.y() - (1.0/3)*Gsq);
+}
+
+//! Mirror of fmtFusedExpand_calc: accumulate gradients w.r.t all nFMTfields weighted densities (reciprocal space, stride nG)
+//! to gradients w.r.t the six reciprocal-space weighted densities
+__hostanddev__ void fmtFusedExpand_grad_calc(int i, const vector3<int> iG, bool nyq, const matrix3<> G, size_t nG,
+	const complex* grad_in, array<complex*,6> grad_n)
+{	for(int k=0; k<4; k++) grad_n[k][i] += grad_in[k*nG+i];
+	vector3<> Gvec = iG*G;
+	complex iota(0.0, nyq ? 0.0 : 1.0); //zero nyquist frequencies
+	complex div_n1v(0,0), div_n2v(0,0);
+	for(int j=0; j<3; j++)
+	{	div_n1v += Gvec[j] * grad_in[(4+j)*nG+i];
+		div_n2v += Gvec[j] * grad_in[(7+j)*nG+i];
+	}
+	grad_n[3][i] += iota * div_n2v;
+	grad_n[4][i] -= iota * div_n1v;
+	if(!nyq)
+	{	double Gsq = Gvec.length_squared();
+		grad_n[5][i] -= grad_in[10*nG+i]*Gvec.x()*Gvec.y()
+			+ grad_in[11*nG+i]*Gvec.y()*Gvec.z()
+			+ grad_in[12*nG+i]*Gvec.z()*Gvec.x()
+			+ grad_in[13*nG+i]*(Gvec.x()*Gvec.x() - (1.0/3)*Gsq)
+			+ grad_in[14*nG+i]*(Gvec.y()*Gvec.y() - (1.0/3)*Gsq);
+	}
+}
+
 //! Compute vT*m*v for a vector v and a symmetric traceless tensor m
 __hostanddev__ double mul_vTmv(const tensor3<>& m, const vector3<>& v)
 {	return 2*(m.xy()*v.x()*v.y() + m.yz()*v.y()*v.z() + m.zx()*v.z()*v.x())
@@ -21,6 +21,8 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/Molecule.h>
 #include <core/Operators.h>
 #include <electronic/ColumnBundle.h>
+#include <map>
+#include <sstream>
 
 Molecule::Site::Site(string name, int atomicNumber) : name(name), Rhs(0), atomicNumber(atomicNumber), Znuc(0), sigmaNuc(0), Zelec(0), aElec(0), Zsite(0), deltaS(0), sigmaElec(0), rcElec(0), alpha(0), aPol(0), initialized(false)
 {	
@@ -73,18 +75,75 @@ RadialFunctionR getLogGridKernel()
 	return KernelR;
 }
 
+//Spline coefficients of the kernels of a site, cached by site definition and radial grid, so that identically
+//defined sites set up again in the same process (e.g. by NEB images or solvation-batch variants) are not recomputed:
+struct SiteKernelTables
+{	std::vector<double> elec, charge, pol, w[6]; //quintic spline coefficients (empty if kernel not in use)
+	double deltaS; //change of deltaS during setup
+	double Znuc; //Znuc after setup (adjusted when electron densities are read from file)
+};
+static std::map<string,SiteKernelTables>& getSiteKernelCache()
+{	static std::map<string,SiteKernelTables> cache;
+	return cache;
+}
+
+inline std::vector<double> getCoeff(const RadialFunctionG& f)
+{	return f ? f.coeff : std::vector<double>();
+}
+inline void setCoeff(RadialFunctionG& f, const std::vector<double>& coeff, double dG)
+{	if(coeff.size()) f.set(coeff, 1./dG);
+}
+
 void Molecule::Site::setup(const GridInfo& gInfo)
 {	if(initialized) free();
 	double dG = gInfo.dGradial;
 	int nGridLoc = int(ceil(gInfo.GmaxGrid/dG))+5;
 	logPrintf("     Initializing site '%s'\n", name.c_str());
 	
-	//Initialize electron density kernel:
+	//Look up cached kernels:
+	ostringstream keyStream; keyStream.precision(17);
+	keyStream << Rhs << ' ' << Znuc << ' ' << sigmaNuc << ' ' << Zelec << ' ' << aElec << ' ' << Zsite << ' '
+		<< sigmaElec << ' ' << rcElec << ' ' << alpha << ' ' << aPol << ' ' << dG << ' ' << nGridLoc << ' '
+		<< elecFilename << '|' << elecFilenameG;
+	string key = keyStream.str();
+	std::map<string,SiteKernelTables>& cache = getSiteKernelCache();
+	auto iter = cache.find(key);
+	if(iter != cache.end())
+	{	const SiteKernelTables& t = iter->second;
+		logPrintf("       Radial kernels reused from an identical site set up earlier.\n");
+		setCoeff(elecKernel, t.elec, dG);
+		setCoeff(chargeKernel, t.charge, dG);
+		setCoeff(polKernel, t.pol, dG);
+		RadialFunctionG* w[6] = { &w0, &w1, &w2, &w3, &w1v, &w2m };
+		for(int k=0; k<6; k++) setCoeff(*w[k], t.w[k], dG);
+		deltaS += t.deltaS;
+		Znuc = t.Znuc;
+	}
+	else
+	{	double deltaSinit = deltaS;
+		initKernels(dG, nGridLoc, gInfo.GmaxGrid);
+		SiteKernelTables& t = cache[key];
+		t.elec = getCoeff(elecKernel);
+		t.charge = getCoeff(chargeKernel);
+		t.pol = getCoeff(polKernel);
+		const RadialFunctionG* w[6] = { &w0, &w1, &w2, &w3, &w1v, &w2m };
+		for(int k=0; k<6; k++) t.w[k] = getCoeff(*w[k]);
+		t.deltaS = deltaS - deltaSinit;
+		t.Znuc = Znuc;
+	}
+	
+	logPrintf("       Positions in reference frame:\n");
+	for(vector3<> r: positions) logPrintf("         [ %+.6lf %+.6lf %+.6lf ]\n", r[0], r[1], r[2]);
+	initialized = true;
+}
+
+void Molecule::Site::initKernels(double dG, int nGridLoc, double GmaxGrid)
+{	//Initialize electron density kernel:
 	if(elecFilename.length() || elecFilenameG.length() || Zelec)
 	{	logPrintf("       Electron density: ");
 		if(!Zelec || !sigmaElec)
 		{	logPrintf("cuspless exponential with width %lg and norm %lg\n", aElec, Zelec);
-			elecKernel.init(0, dG, gInfo.GmaxGrid, RadialFunctionG::cusplessExpTilde, Zelec, aElec);
+			elecKernel.init(0, dG, GmaxGrid, RadialFunctionG::cusplessExpTilde, Zelec, aElec);
 			deltaS -= 12.*M_PI*Zelec*pow(aElec,2);
 		}
 		else
@@ -215,7 +274,7 @@ void Molecule::Site::setup(const GridInfo& gInfo)
 	//Initialize polarizability kernel:
 	if(alpha)
 	{	logPrintf("       Polarizability: cuspless exponential with width %lg and norm %lg\n", aPol, alpha);
-		polKernel.init(0, dG, gInfo.GmaxGrid, RadialFunctionG::cusplessExpTilde, 1., aPol);
+		polKernel.init(0, dG, GmaxGrid, RadialFunctionG::cusplessExpTilde, 1., aPol);
 	}
 	
 	if(Rhs)
@@ -232,10 +291,6 @@ void Molecule::Site::setup(const GridInfo& gInfo)
 		this->w1v.init(0, w1v, dG);
 		this->w2m.init(0, w2m, dG);
 	}
-	
-	logPrintf("       Positions in reference frame:\n");
-	for(vector3<> r: positions) logPrintf("         [ %+.6lf %+.6lf %+.6lf ]\n", r[0], r[1], r[2]);
-	initialized = true;
 }
 
 Molecule::Molecule(string name) : name(name), initialized(false)
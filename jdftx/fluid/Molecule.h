@@ -57,6 +57,7 @@ struct Molecule
 	private:
 		bool initialized;
 		void free();
+		void initKernels(double dG, int nGridLoc, double GmaxGrid); //!< compute the radial kernels (called by setup when not cached)
 	};
 	std::vector< std::shared_ptr<Site> > sites;
 	RadialFunctionG mfKernel; //!< Mean field interaction kernel (with minimum Coulomb self energy while preserving intermolecular interactions)
@@ -22,6 +22,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/LinearPCM.h>
 #include <fluid/PCM_internal.h>
 #include <core/ScalarFieldIO.h>
+#include <core/ScalarFieldExpr.h>
 #include <core/Util.h>
 
 //Utility functions to extract/set the members of a MuEps
@@ -105,7 +106,7 @@ NonlinearPCM::NonlinearPCM(const Everything& e, const FluidSolverParams& fsp)
 		}
 		//--- Pulay metric
 		metric = std::make_shared<RealKernel>(gInfo);
-		applyFuncGsq(e.gInfo, setMetric, std::pow(fsp.scfParams.qMetric,2), metric->data());
+		applyFuncGsq(gInfo, setMetric, std::pow(fsp.scfParams.qMetric,2), metric->data());
 	}
 	else
 	{	//Initialize preconditioner (for mu channel):
@@ -158,9 +159,9 @@ void NonlinearPCM::set_internal(const ScalarFieldTilde& rhoExplicitTilde, const
 		else initZero(mu, gInfo); //initialization logic does not work well with hard sphere limit
 		//eps:
 		VectorField eps = (-pMol/fsp.T) * I(gradient(linearPCM->state));
-		ScalarField E = sqrt(eps[0]*eps[0] + eps[1]*eps[1] + eps[2]*eps[2]);
-		ScalarField Ecomb = 0.5*((dielectricEval->alpha-3.) + E);
-		ScalarField epsByE = inv(E) * (Ecomb + sqrt(Ecomb*Ecomb + 3.*E));
+		ScalarField E = sqrt(eval(lazy(eps[0])*lazy(eps[0]) + lazy(eps[1])*lazy(eps[1]) + lazy(eps[2])*lazy(eps[2])));
+		ScalarField Ecomb = eval(0.5*lazy(E) + 0.5*(dielectricEval->alpha-3.));
+		ScalarField epsByE = inv(E) * (Ecomb + sqrt(eval(lazy(Ecomb)*lazy(Ecomb) + 3.*lazy(E))));
 		eps *= epsByE; //enhancement due to correlations
 		//collect:
 		setMuEps(state, mu, clone(mu), eps);
@@ -273,12 +274,14 @@ double NonlinearPCM::operator()(const ScalarFieldMuEps& state, ScalarFieldMuEps&
 }
 
 void NonlinearPCM::minimizeFluid()
-{	if(fsp.nonlinearSCF)
+{	static const int phaseId = Profiler::registerName("FluidSolve"); ProfilePhase phase(phaseId);
+	if(fsp.nonlinearSCF)
 	{	clearState();
-		Pulay<ScalarFieldTilde>::minimize(compute(0,0));
+		if(fsp.nonlinearNewton) minimizeNewton();
+		else Pulay<ScalarFieldTilde>::minimize(compute(0,0));
 	}
 	else
-		Minimizable<ScalarFieldMuEps>::minimize(e.fluidMinParams);
+		Minimizable<ScalarFieldMuEps>::minimize(innerMinParams());
 }
 
 void NonlinearPCM::loadState(const char* filename)
@@ -419,3 +422,105 @@ void NonlinearPCM::phiToState(bool setState)
 	else
 		linearPCM->override(epsilon, kappaSq);
 }
+
+//--------- Inexact Newton-Krylov version ---------
+
+ScalarFieldTilde NonlinearPCM::residual(const ScalarFieldTilde& phi)
+{	linearPCM->state = phi;
+	phiToState(false); //set epsilon / kappaSq of linearPCM at this phi
+	return linearPCM->hessian(phi) - rhoExplicitTilde;
+}
+
+void NonlinearPCM::minimizeNewton()
+{	const char* linePrefix = useGummel() ? "NonlinearFluidNewton: " : "\tNonlinearFluidNewton: ";
+	FILE* fpLog = fsp.scfParams.fpLog;
+	//Preconditioner: fixed number of LinearPCM CG iterations with the linear response at the current phi
+	MinimizeParams innerParams = e.fluidMinParams;
+	innerParams.fpLog = nullLog;
+	innerParams.nIterations = fsp.newtonInnerIterations;
+	innerParams.knormThreshold = 0.;
+	const int nKrylov = fsp.newtonKrylovDim;
+	
+	double rhoNorm = sqrt(dot(rhoExplicitTilde, rhoExplicitTilde));
+	ScalarFieldTilde phi = clone(linearPCM->state);
+	ScalarFieldTilde R = residual(phi);
+	double Rnorm = sqrt(dot(R, R));
+	for(int iter=0; ; iter++)
+	{	fprintf(fpLog, "%sIter: %3d  |R|/|rho|: %12.6le  t[s]: %9.2lf\n", linePrefix, iter, Rnorm/rhoNorm, clock_sec()); fflush(fpLog);
+		if(Rnorm < fsp.newtonThreshold * rhoNorm)
+		{	fprintf(fpLog, "%sConverged |R|/|rho|<%le\n", linePrefix, fsp.newtonThreshold); fflush(fpLog);
+			break;
+		}
+		if(iter==fsp.newtonIterations || killFlag)
+		{	fprintf(fpLog, "%sNone of the convergence criteria satisfied after %d iterations.\n", linePrefix, iter); fflush(fpLog);
+			break;
+		}
+		//Flexible GMRES for J.dphi = -R (with Givens rotations), to relative tolerance eta:
+		double eta = std::min(0.1, Rnorm/rhoNorm); //forcing term: tighten as the outer iterations converge
+		ScalarField epsilon0 = linearPCM->epsilonOverride, kappaSq0 = linearPCM->kappaSqOverride; //linear response at phi
+		std::vector<ScalarFieldTilde> V(1, (-1./Rnorm) * R), Z; //Krylov basis and its preconditioned images
+		std::vector<std::vector<double>> H(nKrylov, std::vector<double>(nKrylov+1, 0.)); //Hessenberg matrix (by column)
+		std::vector<double> cs(nKrylov), sn(nKrylov), g(nKrylov+1, 0.); g[0] = Rnorm;
+		double phiNorm = sqrt(dot(phi, phi));
+		int k = 0;
+		while(k < nKrylov)
+		{	//Apply preconditioner:
+			if(k) linearPCM->override(epsilon0, kappaSq0); //restore response at phi
+			initZero(linearPCM->state, gInfo);
+			linearPCM->solve(V[k], innerParams);
+			Z.push_back(linearPCM->state);
+			//Jacobian-vector product by finite difference of the residual:
+			double h = 1e-7 * (1. + phiNorm) / sqrt(dot(Z[k], Z[k]));
+			ScalarFieldTilde w = (1./h) * (residual(phi + h*Z[k]) - R);
+			//Arnoldi step (modified Gram-Schmidt):
+			for(int i=0; i<=k; i++)
+			{	H[k][i] = dot(V[i], w);
+				::axpy(-H[k][i], V[i], w);
+			}
+			H[k][k+1] = sqrt(dot(w, w));
+			if(H[k][k+1]) V.push_back((1./H[k][k+1]) * w);
+			//Apply previous Givens rotations and compute the new one:
+			for(int i=0; i<k; i++)
+			{	double Hi = cs[i]*H[k][i] + sn[i]*H[k][i+1];
+				H[k][i+1] = cs[i]*H[k][i+1] - sn[i]*H[k][i];
+				H[k][i] = Hi;
+			}
+			double r = hypot(H[k][k], H[k][k+1]);
+			cs[k] = H[k][k]/r;
+			sn[k] = H[k][k+1]/r;
+			H[k][k] = r;
+			H[k][k+1] = 0.;
+			g[k+1] = -sn[k]*g[k];
+			g[k] *= cs[k];
+			k++;
+			if(fabs(g[k]) < eta*Rnorm || int(V.size())==k) break; //converged (or Krylov space exhausted)
+		}
+		//Back-substitute for the Krylov coefficients and form the step:
+		std::vector<double> y(k);
+		for(int i=k-1; i>=0; i--)
+		{	y[i] = g[i];
+			for(int j=i+1; j<k; j++) y[i] -= H[j][i]*y[j];
+			y[i] /= H[i][i];
+		}
+		ScalarFieldTilde dphi;
+		for(int i=0; i<k; i++) ::axpy(y[i], Z[i], dphi);
+		V.clear(); Z.clear();
+		//Backtracking line search on the residual norm:
+		double alpha = 1.;
+		ScalarFieldTilde phiNew, Rnew; double RnormNew;
+		for(int iLS=0; ; iLS++)
+		{	phiNew = phi + alpha*dphi;
+			Rnew = residual(phiNew);
+			RnormNew = sqrt(dot(Rnew, Rnew));
+			if(RnormNew < Rnorm || iLS==4) break;
+			alpha *= 0.5;
+		}
+		fprintf(fpLog, "%s\tGMRES steps: %d  alpha: %lg\n", linePrefix, k, alpha); fflush(fpLog);
+		phi = phiNew;
+		R = Rnew;
+		Rnorm = RnormNew;
+	}
+	//Update state from final phi (linearPCM is already at phi from the last residual):
+	phiToState(true);
+	fprintf(fpLog, "%sAdiel: %+.15lf\n", linePrefix, compute(0,0)); fflush(fpLog);
+}
@@ -49,7 +49,7 @@ public:
 	void loadState(const char* filename); //!< Load state from file
 	void saveState(const char* filename) const; //!< Save state to file
 	void dumpDensities(const char* filenamePattern) const;
-	void minimizeFluid(); //!< Converge using nonlinear conjugate gradients
+	void minimizeFluid(); //!< Converge using nonlinear conjugate gradients, Pulay-mixed SCF or inexact Newton-Krylov (based on fsp)
 
 	//! Compute gradient and free energy (with optional outputs)
 	double operator()(const ScalarFieldMuEps& state, ScalarFieldMuEps& Adiel_state,
@@ -86,6 +86,10 @@ protected:
 	ScalarFieldTilde applyMetric(const ScalarFieldTilde&) const;
 private:
 	void phiToState(bool setState); //!< update state if setState=true and epsilon/kappaSq in linearPCM if setState=false from the current phi
+	
+	//Inexact Newton-Krylov version:
+	void minimizeNewton(); //!< converge phi using Newton steps solved by flexible GMRES, right-preconditioned by LinearPCM solves
+	ScalarFieldTilde residual(const ScalarFieldTilde& phi); //!< nonlinear Poisson residual at phi (also sets the epsilon/kappaSq in linearPCM to those at phi)
 };
 
 //! @}
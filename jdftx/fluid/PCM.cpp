@@ -265,12 +265,38 @@ PCM::~PCM()
 	for(unsigned i=0; i<Sf.size(); i++) Sf[i].free();
 }
 
+//Maximum absolute value of a scalar field:
+inline double maxAbs(const ScalarField& x)
+{	const double* xData = x->data();
+	double result = 0.;
+	for(int i=0; i<x->gInfo.nr; i++)
+		result = std::max(result, fabs(xData[i]));
+	return result;
+}
+
+bool PCM::cavityReusable()
+{	if(!fsp.cavityReuseThreshold) return false;
+	if(nCavityRef && Rref==gInfo.R && (not e.iInfo.computeStress) //stress always recomputed since cavity lattice derivatives are not cached
+		&& maxAbs(nCavity - nCavityRef) < fsp.cavityReuseThreshold
+		&& (fsp.pcmVariant!=PCM_CANDLE || maxAbs(I(rhoExplicitTilde - rhoExplicitRef)) < fsp.cavityReuseThreshold))
+		return true;
+	//Cavity will be recomputed: update the reference inputs
+	nCavityRef = clone(nCavity);
+	if(fsp.pcmVariant==PCM_CANDLE) rhoExplicitRef = clone(rhoExplicitTilde);
+	Rref = gInfo.R;
+	return false;
+}
+
 void PCM::updateCavity()
 {
 	bool cavityChanged = true; //keep track of whether cavity is updated in code below (usually yes, except for SS)
 	
+	//Reuse previous cavity (nCavityEx, shape, shapeVdw and cavitation energy) if its inputs changed negligibly:
+	bool densityCavity = (fsp.pcmVariant!=PCM_SoftSphere) && (fsp.pcmVariant!=PCM_FixedCavity); //whether cavity depends on nCavity
+	if(densityCavity && cavityReusable())
+		cavityChanged = false;
 	//Cavities from expanded densities for SGA13 variant:
-	if(fsp.pcmVariant == PCM_SGA13)
+	else if(fsp.pcmVariant == PCM_SGA13)
 	{	ScalarField* shapeEx[2] = { &shape[0], &shapeVdw };
 		for(int i=0; i<2; i++)
 		{	ShapeFunctionSGA13::expandDensity(wExpand[i], Rex[i], nCavity, nCavityEx[i]);
@@ -332,20 +358,23 @@ void PCM::updateCavity()
 		{	//Select relevant shape function:
 			const ScalarFieldTilde sTilde = J(fsp.pcmVariant==PCM_SaLSA ? shape[0] : shapeVdw);
 			ScalarFieldTilde A_sTilde;
-			//Cavitation:
-			const double nlT = solvent->Nbulk * fsp.T;
-			const double Gamma = log(nlT/solvent->Pvap) - 1.;
-			const double Cp = 15. * (solvent->sigmaBulk/(2*solvent->Rvdw * nlT) - (1+Gamma)/6);
-			const double coeff2 = 1. + Cp - 2.*Gamma;
-			const double coeff3 = Gamma - 1. -2.*Cp;
-			ScalarField sbar = I(wCavity*sTilde);
-			Adiel["Cavitation"] = nlT * integral(sbar*(Gamma + sbar*(coeff2 + sbar*(coeff3 + sbar*Cp))));
-			{	ScalarFieldTilde A_sbar = Idag(nlT * (Gamma + sbar*(2.*coeff2 + sbar*(3.*coeff3 + sbar*(4.*Cp)))));
-				A_sTilde += wCavity*A_sbar;
+			//Cavitation (depends on shape alone, so reused along with a reused cavity):
+			if(cavityChanged || !Acavitation_sTilde)
+			{	const double nlT = solvent->Nbulk * fsp.T;
+				const double Gamma = log(nlT/solvent->Pvap) - 1.;
+				const double Cp = 15. * (solvent->sigmaBulk/(2*solvent->Rvdw * nlT) - (1+Gamma)/6);
+				const double coeff2 = 1. + Cp - 2.*Gamma;
+				const double coeff3 = Gamma - 1. -2.*Cp;
+				ScalarField sbar = I(wCavity*sTilde);
+				Adiel["Cavitation"] = nlT * integral(sbar*(Gamma + sbar*(coeff2 + sbar*(coeff3 + sbar*Cp))));
+				ScalarFieldTilde A_sbar = Idag(nlT * (Gamma + sbar*(2.*coeff2 + sbar*(3.*coeff3 + sbar*(4.*Cp)))));
+				Acavitation_sTilde = wCavity*A_sbar;
 				if(e.iInfo.computeStress)
-					Acavity_RRT = (1./gInfo.nr) * convolveStress(wCavity, A_sbar, sTilde) //through convolution
+					Acavitation_RRT = (1./gInfo.nr) * convolveStress(wCavity, A_sbar, sTilde) //through convolution
 						+ matrix3<>(1,1,1) * Adiel["Cavitation"]; //through volume factor in integral
 			}
+			A_sTilde = clone(Acavitation_sTilde);
+			if(e.iInfo.computeStress) Acavity_RRT = Acavitation_RRT;
 			//Dispersion:
 			ScalarFieldTildeArray Ntilde(Sf.size()), A_Ntilde(Sf.size()); //effective nuclear densities in spherical-averaged ansatz
 			for(unsigned i=0; i<Sf.size(); i++)
@@ -366,7 +395,8 @@ void PCM::updateCavity()
 		}
 		case PCM_GLSSA13:
 		case PCM_SoftSphere:
-		{	VectorField Dshape = gradient(shape[0]);
+		{	if(densityCavity && !cavityChanged) break; //reused cavity: cached tension and pressure terms still valid
+			VectorField Dshape = gradient(shape[0]);
 			ScalarField surfaceDensity = sqrt(lengthSquared(Dshape));
 			ScalarField invSurfaceDensity = inv(surfaceDensity);
 			A_tension = integral(surfaceDensity);
@@ -387,7 +417,8 @@ void PCM::updateCavity()
 		case PCM_LA12:
 			break; //no contribution
 		case_PCM_SCCS_any:
-		{	//Volume contribution:
+		{	if(!cavityChanged) break; //reused cavity: cached tension and pressure terms still valid
+			//Volume contribution:
 			Adiel["CavityPressure"] = fsp.cavityPressure * (gInfo.detR - integral(shape[0]));
 			if(e.iInfo.computeStress)
 				Acavity_RRT = matrix3<>(1,1,1) * Adiel["CavityPressure"];
@@ -548,6 +579,43 @@ ScalarFieldTilde PCM::getFullCore() const
 	}
 }
 
+void PCM::recycleGuess(ScalarFieldTilde& state, const ScalarFieldTilde& rhs) const
+{	int nDiff = int(recycleHistory.size()) - 1;
+	if(nDiff < 1) return;
+	//Least-squares fit of the rhs change in the span of previous rhs changes:
+	std::vector<ScalarFieldTilde> dRhs(nDiff);
+	for(int j=0; j<nDiff; j++)
+		dRhs[j] = recycleHistory[j+1].first - recycleHistory[j].first;
+	ScalarFieldTilde r0 = rhs - recycleHistory.back().first; //approximate residual of state (which solved the last rhs)
+	matrix M(nDiff, nDiff), v(nDiff, 1);
+	double Mtrace = 0.;
+	for(int i=0; i<nDiff; i++)
+	{	for(int j=0; j<=i; j++)
+		{	double Mij = dot(dRhs[i], dRhs[j]);
+			M.set(i,j, Mij);
+			M.set(j,i, Mij);
+		}
+		Mtrace += M(i,i).real();
+		v.set(i,0, dot(dRhs[i], r0));
+	}
+	if(!Mtrace) return;
+	for(int i=0; i<nDiff; i++) M.set(i,i, M(i,i) + 1e-12*Mtrace); //guard against linearly-dependent history
+	matrix c = invApply(M, v);
+	//Apply the same combination of solution changes:
+	for(int j=0; j<nDiff; j++)
+	{	double cj = c(j,0).real();
+		axpy(cj, recycleHistory[j+1].second, state);
+		axpy(-cj, recycleHistory[j].second, state);
+	}
+}
+
+void PCM::recycleStore(const ScalarFieldTilde& state, const ScalarFieldTilde& rhs)
+{	if(fsp.nRecycle <= 0) return;
+	recycleHistory.push_back(std::make_pair(clone(rhs), clone(state)));
+	while(int(recycleHistory.size()) > fsp.nRecycle+1)
+		recycleHistory.pop_front();
+}
+
 
 void PCM::dumpDensities(const char* filenamePattern) const
 {	string filename;
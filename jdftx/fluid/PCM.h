@@ -24,6 +24,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <core/RadialFunction.h>
 #include <core/EnergyComponents.h>
 #include <core/Coulomb.h>
+#include <deque>
 
 //! @addtogroup Solvation
 //! @{
@@ -57,7 +58,13 @@ protected:
 	void accumExtraForces(IonicGradient* forces, const ScalarFieldTilde& A_nCavityTilde) const;
 	
 	ScalarFieldTilde getFullCore() const; //!< get full core correction for PCM variants that need them
+	
+	//! Recycle previous linear solves (for LinearPCM and SaLSA, if fsp.nRecycle is set): fit the change in rhs
+	//! from the last solve within the span of previous right-hand-side changes, and step state by the same combination of solution changes
+	void recycleGuess(ScalarFieldTilde& state, const ScalarFieldTilde& rhs) const;
+	void recycleStore(const ScalarFieldTilde& state, const ScalarFieldTilde& rhs); //!< append a completed solve to the recycling history
 private:
+	std::deque<std::pair<ScalarFieldTilde,ScalarFieldTilde>> recycleHistory; //!< (rhs, solution) pairs of the most recent linear solves
 	ScalarField Acavity_shape, Acavity_shapeVdw; //!< Cached gradients of cavitation (and dispersion) energies w.r.t shape functions (assumed Acavity does not depend on ionic cavity)
 	matrix3<> Acavity_RRT; //!< Cached gradients of cavitation (and dispersion) energies w.r.t lattice vectors
 	double A_nc, A_tension, A_vdwScale, A_eta_wDiel, A_pCavity, A_cavityScale; //!< Cached derivatives w.r.t fit parameters (accessed via dumpDebug() for PCM fits)
@@ -71,6 +78,9 @@ private:
 	ScalarFieldArray zMask; //optional cavity mask function
 	int nShape; //natural number of shape functions of the solvation model (2 if ionspacing is used to make ionic cavity, else 1)
 	bool fixedCavityMasked; //!< whether mask has already been applied to fixed cavity
+	ScalarField nCavityRef; ScalarFieldTilde rhoExplicitRef; matrix3<> Rref; //!< inputs of the most recently computed cavity (for fsp.cavityReuseThreshold)
+	ScalarFieldTilde Acavitation_sTilde; matrix3<> Acavitation_RRT; //!< cached cavitation energy gradients for the most recently computed cavity
+	bool cavityReusable(); //!< whether the cavity inputs are within fsp.cavityReuseThreshold of those of the last computed cavity (updates the reference otherwise)
 protected:
 	std::vector<RadialFunctionG> Sf; //!< spherically-averaged structure factors for each solvent site
 	std::vector<int> atomicNumbers; //!< atomic number for each solvent site (for dispersion interactions)
@@ -187,12 +187,14 @@ SaLSA::~SaLSA()
 
 ScalarFieldTilde SaLSA::chi(const ScalarFieldTilde& phiTilde) const
 {	ScalarFieldTilde rhoTilde;
+	assert(int(Kresponse.size()) == rStop-rStart);
 	for(int r=rStart; r<rStop; r++)
 	{	const MultipoleResponse& resp = *response[r];
 		const ScalarField& s = resp.selectSite(shape, siteShape);
-		if(resp.l>6) die("Angular momenta l > 6 not supported.\n");
+		//Cached kernel Km applies V lGradient, and (-1)^l Km applies its adjoint V lDivergence:
 		double prefac = pow(-1,resp.l) * 4*M_PI/(2*resp.l+1);
-		rhoTilde -= prefac * (resp.V * lDivergence(J(s * I(lGradient(resp.V * phiTilde, resp.l))), resp.l));
+		for(const ScalarFieldTilde& Km: Kresponse[r-rStart])
+			rhoTilde -= prefac * (Km * J(s * I(Km * phiTilde)));
 	}
 	nullToZero(rhoTilde, gInfo); rhoTilde->allReduceData(mpiWorld, MPIUtil::ReduceSum);
 	return rhoTilde;
@@ -206,6 +208,17 @@ ScalarFieldTilde SaLSA::precondition(const ScalarFieldTilde& rTilde) const
 {	return Kkernel*(J(epsInv*I(Kkernel*rTilde)));
 }
 
+void SaLSA::updateResponseKernels()
+{	if(Kresponse.size()==size_t(rStop-rStart) and Kresponse_G==gInfo.G) return; //up to date
+	Kresponse.assign(rStop-rStart, ScalarFieldTildeArray());
+	for(int r=rStart; r<rStop; r++)
+	{	const MultipoleResponse& resp = *response[r];
+		if(resp.l>6) die("Angular momenta l > 6 not supported.\n");
+		Kresponse[r-rStart] = lGradient(radialFunctionG(gInfo, resp.V, vector3<>()), resp.l);
+	}
+	Kresponse_G = gInfo.G;
+}
+
 double SaLSA::sync(double x) const
 {	mpiWorld->bcast(x);
 	return x;
@@ -219,6 +232,7 @@ void SaLSA::set_internal(const ScalarFieldTilde& rhoExplicitTilde, const ScalarF
 	nCavityNetTilde = nCavityTilde + getFullCore();
 	nCavity = I(nFluid * nCavityNetTilde);
 	updateCavity();
+	updateResponseKernels();
 
 	//Compute site shape functions with the spherical ansatz:
 	const auto& solvent = fsp.solvents[0];
@@ -235,10 +249,14 @@ void SaLSA::set_internal(const ScalarFieldTilde& rhoExplicitTilde, const ScalarF
 
 void SaLSA::minimizeFluid()
 {
+	static const int phaseId = Profiler::registerName("FluidSolve"); ProfilePhase phase(phaseId);
 	logPrintf("\tSaLSA fluid occupying %lf of unit cell:", integral(shape[0])/gInfo.detR); logFlush();
-	fprintf(e.fluidMinParams.fpLog, "\n\tWill stop at %d iterations, or sqrt(|r.z|)<%le\n",
-		e.fluidMinParams.nIterations, e.fluidMinParams.knormThreshold);
-	int nIter = solve(rhoExplicitTilde, e.fluidMinParams);
+	MinimizeParams mp = innerMinParams();
+	fprintf(mp.fpLog, "\n\tWill stop at %d iterations, or sqrt(|r.z|)<%le\n",
+		mp.nIterations, mp.knormThreshold);
+	recycleGuess(state, rhoExplicitTilde);
+	int nIter = solve(rhoExplicitTilde, mp);
+	recycleStore(state, rhoExplicitTilde);
 	logPrintf("\tCompleted after %d iterations at t[s]: %9.2lf\n", nIter, clock_sec());
 }
 
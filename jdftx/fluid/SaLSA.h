@@ -52,6 +52,9 @@ protected:
 private:
 	std::vector< std::shared_ptr<struct MultipoleResponse> > response; //array of multipolar components in chi
 	int rStart, rStop; //MPI division of response array
+	std::vector<ScalarFieldTildeArray> Kresponse; //cached G-space kernels V(G) i^l G^l Ylm(Ghat) for each local response and m (GPU-resident when enabled)
+	matrix3<> Kresponse_G; //reciprocal lattice vectors for which Kresponse was computed
+	void updateResponseKernels(); //(re)compute Kresponse if lattice vectors have changed
 	RadialFunctionG nFluid; //electron density model for the fluid
 	RadialFunctionG Kkernel; ScalarField epsInv; //for preconditioner
 	ScalarFieldArray siteShape; //shape functions for sites
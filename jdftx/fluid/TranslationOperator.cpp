@@ -20,17 +20,55 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/TranslationOperator.h>
 #include <fluid/TranslationOperator_internal.h>
 #include <core/Operators.h>
+#include <core/ManagedMemory.h>
 
 
 TranslationOperator::TranslationOperator(const GridInfo& gInfo) : gInfo(gInfo)
 {
 }
 
+void TranslationOperator::taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const
+{	for(const auto& shift: shifts)
+		taxpy(shift.first, shift.second, x, y);
+}
+
 TranslationOperatorSpline::TranslationOperatorSpline(const GridInfo& gInfo, SplineType splineType)
 : TranslationOperator(gInfo), splineType(splineType)
 {
 }
 
+vector3<int> TranslationOperatorSpline::constantShift(const vector3<>& t) const
+{	//Perform a gather with the inverse translation (hence negate t),
+	//instead of scatter which is less efficient to parallelize
+	vector3<> Tfrac = Diag(gInfo.S) * inv(gInfo.R) * (-t); //now in grid point units
+	vector3<int> Tint;
+	for(int k=0; k<3; k++)
+	{	//round to nearest integer (and ensure symmetric rounding direction for transpose correctness):
+		Tint[k] = int(copysign(floor(fabs(Tfrac[k])+0.5), Tfrac[k]));
+		//reduce to positive first unit cell:
+		Tint[k] = Tint[k] % gInfo.S[k];
+		if(Tint[k]<0) Tint[k] += gInfo.S[k];
+	}
+	return Tint;
+}
+
+vector3<int> TranslationOperatorSpline::linearShift(const vector3<>& t, vector3<>& Tfrac) const
+{	//Perform a gather with the inverse translation (hence negate t),
+	//instead of scatter which is less efficient to parallelize
+	Tfrac = Diag(gInfo.S) * inv(gInfo.R) * (-t); //now in grid point units
+	vector3<int> Tint;
+	for(int k=0; k<3; k++)
+	{	//reduce to positive first unit cell:
+		Tfrac[k] = fmod(Tfrac[k], gInfo.S[k]);
+		if(Tfrac[k]<0) Tfrac[k] += gInfo.S[k];
+		//separate integral and fractional parts:
+		Tint[k] = int(floor(Tfrac[k]));
+		Tfrac[k] -= Tint[k];
+		Tint[k] = Tint[k] % gInfo.S[k];
+	}
+	return Tint;
+}
+
 void constantSplineTaxpy_sub(size_t iStart, size_t iStop, const vector3<int> S,
 	double alpha, const double* x, double* y, const vector3<int> Tint)
 {	THREAD_rLoop(constantSplineTaxpy_calc(i, iv, S, alpha, x, y, Tint);)
@@ -46,21 +84,11 @@ void linearSplineTaxpy_gpu(const vector3<int> S,
 	double alpha, const double* x, double* y, const vector3<int> Tint, const vector3<> Tfrac);
 #endif
 void TranslationOperatorSpline::taxpy(const vector3<>& t, double alpha, const ScalarField& x, ScalarField& y) const
-{	//Perform a gather with the inverse translation (hence negate t),
-	//instead of scatter which is less efficient to parallelize
-	vector3<> Tfrac = Diag(gInfo.S) * inv(gInfo.R) * (-t); //now in grid point units
-	vector3<int> Tint;
-	//Prepare output:
+{	//Prepare output:
 	nullToZero(y, gInfo);
 	switch(splineType)
 	{	case Constant:
-		{	for(int k=0; k<3; k++)
-			{	//round to nearest integer (and ensure symmetric rounding direction for transpose correctness):
-				Tint[k] = int(copysign(floor(fabs(Tfrac[k])+0.5), Tfrac[k]));
-				//reduce to positive first unit cell:
-				Tint[k] = Tint[k] % gInfo.S[k];
-				if(Tint[k]<0) Tint[k] += gInfo.S[k];
-			}
+		{	vector3<int> Tint = constantShift(t);
 			//Launch threads/gpu kernels:
 			#ifdef GPU_ENABLED
 			constantSplineTaxpy_gpu(gInfo.S, alpha*x->scale, x->dataGpu(false), y->dataGpu(), Tint);
@@ -70,15 +98,8 @@ void TranslationOperatorSpline::taxpy(const vector3<>& t, double alpha, const Sc
 			break;
 		}
 		case Linear:
-		{	for(int k=0; k<3; k++)
-			{	//reduce to positive first unit cell:
-				Tfrac[k] = fmod(Tfrac[k], gInfo.S[k]);
-				if(Tfrac[k]<0) Tfrac[k] += gInfo.S[k];
-				//separate integral and fractional parts:
-				Tint[k] = int(floor(Tfrac[k]));
-				Tfrac[k] -= Tint[k];
-				Tint[k] = Tint[k] % gInfo.S[k];
-			}
+		{	vector3<> Tfrac;
+			vector3<int> Tint = linearShift(t, Tfrac);
 			//Launch threads/gpu kernels:
 			#ifdef GPU_ENABLED
 			linearSplineTaxpy_gpu(gInfo.S, alpha*x->scale, x->dataGpu(false), y->dataGpu(), Tint, Tfrac);
@@ -90,6 +111,71 @@ void TranslationOperatorSpline::taxpy(const vector3<>& t, double alpha, const Sc
 	}
 }
 
+void constantSplineTaxpyMany_sub(size_t iStart, size_t iStop, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint)
+{	THREAD_rLoop(constantSplineTaxpyMany_calc(i, iv, S, nShifts, alpha, x, y, Tint);)
+}
+void linearSplineTaxpyMany_sub(size_t iStart, size_t iStop, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint, const vector3<>* Tfrac)
+{	THREAD_rLoop(linearSplineTaxpyMany_calc(i, iv, S, nShifts, alpha, x, y, Tint, Tfrac);)
+}
+#ifdef GPU_ENABLED
+void constantSplineTaxpyMany_gpu(const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint);
+void linearSplineTaxpyMany_gpu(const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint, const vector3<>* Tfrac);
+#endif
+//Copy a short table of shift parameters to an array in preferred memory (directly, rather than by
+//allocating on the CPU and moving the array to the GPU, which would be a managed-memory transfer per call):
+template<typename T> void setShiftParams(ManagedArray<T>& dest, const std::vector<T>& src)
+{	dest.init(src.size(), isGpuEnabled());
+	#ifdef GPU_ENABLED
+	cudaMemcpy(dest.dataGpu(), src.data(), sizeof(T)*src.size(), cudaMemcpyHostToDevice);
+	#else
+	std::copy(src.begin(), src.end(), dest.data());
+	#endif
+}
+
+void TranslationOperatorSpline::taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const
+{	if(!shifts.size()) return;
+	if(shifts.size()==1) { taxpy(shifts[0].first, shifts[0].second, x, y); return; }
+	//Convert all the shifts to grid offsets and weights:
+	int nShifts = shifts.size();
+	std::vector<double> alphaArr(nShifts);
+	std::vector<vector3<int>> TintArr(nShifts);
+	std::vector<vector3<>> TfracArr(nShifts);
+	for(int j=0; j<nShifts; j++)
+	{	alphaArr[j] = shifts[j].second * x->scale;
+		TintArr[j] = (splineType==Constant) ? constantShift(shifts[j].first) : linearShift(shifts[j].first, TfracArr[j]);
+	}
+	ManagedArray<double> alpha; setShiftParams(alpha, alphaArr);
+	ManagedArray<vector3<int>> Tint; setShiftParams(Tint, TintArr);
+	ManagedArray<vector3<>> Tfrac; if(splineType==Linear) setShiftParams(Tfrac, TfracArr);
+	//Prepare output:
+	nullToZero(y, gInfo);
+	//Launch threads/gpu kernels (each output point gathers all shifts in one pass):
+	switch(splineType)
+	{	case Constant:
+		{
+			#ifdef GPU_ENABLED
+			constantSplineTaxpyMany_gpu(gInfo.S, nShifts, alpha.dataGpu(), x->dataGpu(false), y->dataGpu(), Tint.dataGpu());
+			#else
+			threadLaunch(constantSplineTaxpyMany_sub, gInfo.nr, gInfo.S, nShifts, alpha.data(), x->data(false), y->data(), Tint.data());
+			#endif
+			break;
+		}
+		case Linear:
+		{
+			#ifdef GPU_ENABLED
+			linearSplineTaxpyMany_gpu(gInfo.S, nShifts, alpha.dataGpu(), x->dataGpu(false), y->dataGpu(), Tint.dataGpu(), Tfrac.dataGpu());
+			#else
+			threadLaunch(linearSplineTaxpyMany_sub, gInfo.nr, gInfo.S, nShifts, alpha.data(), x->data(false), y->data(), Tint.data(), Tfrac.data());
+			#endif
+			break;
+		}
+	}
+}
+
 TranslationOperatorFourier::TranslationOperatorFourier(const GridInfo& gInfo)
 : TranslationOperator(gInfo)
 {
@@ -109,3 +195,29 @@ void TranslationOperatorFourier::taxpy(const vector3<>& t, double alpha, const S
 	#endif
 	y += alpha*I(xTilde);
 }
+
+inline void fourierTranslateMany_sub(size_t iStart, size_t iStop, const vector3<int> S, int nShifts, const double* alpha, const vector3<>* Gt, complex* xTilde)
+{	THREAD_halfGspaceLoop( fourierTranslateMany_calc(i, iG, S, nShifts, alpha, Gt, xTilde); )
+}
+#ifdef GPU_ENABLED //implemented in TranslationOperator.cu
+void fourierTranslateMany_gpu(const vector3<int> S, int nShifts, const double* alpha, const vector3<>* Gt, complex* xTilde);
+#endif
+void TranslationOperatorFourier::taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const
+{	if(!shifts.size()) return;
+	int nShifts = shifts.size();
+	std::vector<double> alphaArr(nShifts);
+	std::vector<vector3<>> GtArr(nShifts);
+	for(int j=0; j<nShifts; j++)
+	{	alphaArr[j] = shifts[j].second;
+		GtArr[j] = gInfo.G * shifts[j].first;
+	}
+	ManagedArray<double> alpha; setShiftParams(alpha, alphaArr);
+	ManagedArray<vector3<>> Gt; setShiftParams(Gt, GtArr);
+	ScalarFieldTilde xTilde = J(x);
+	#ifdef GPU_ENABLED
+	fourierTranslateMany_gpu(gInfo.S, nShifts, alpha.dataGpu(), Gt.dataGpu(), xTilde->dataGpu(false));
+	#else
+	threadLaunch(fourierTranslateMany_sub, gInfo.nG, gInfo.S, nShifts, alpha.data(), Gt.data(), xTilde->data(false));
+	#endif
+	y += I(xTilde);
+}
@@ -48,6 +48,33 @@ void linearSplineTaxpy_gpu(const vector3<int> S,
 		linearSplineTaxpy_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, alpha, x, y, Tint, Tfrac);
 	gpuErrorCheck();
 }
+__global__
+void constantSplineTaxpyMany_kernel(int zBlock, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint)
+{	COMPUTE_rIndices
+	constantSplineTaxpyMany_calc(i, iv, S, nShifts, alpha, x, y, Tint);
+}
+void constantSplineTaxpyMany_gpu(const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint)
+{	GpuLaunchConfig3D glc(constantSplineTaxpyMany_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		constantSplineTaxpyMany_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, nShifts, alpha, x, y, Tint);
+	gpuErrorCheck();
+}
+
+__global__
+void linearSplineTaxpyMany_kernel(int zBlock, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint, const vector3<>* Tfrac)
+{	COMPUTE_rIndices
+	linearSplineTaxpyMany_calc(i, iv, S, nShifts, alpha, x, y, Tint, Tfrac);
+}
+void linearSplineTaxpyMany_gpu(const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint, const vector3<>* Tfrac)
+{	GpuLaunchConfig3D glc(linearSplineTaxpyMany_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		linearSplineTaxpyMany_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, nShifts, alpha, x, y, Tint, Tfrac);
+	gpuErrorCheck();
+}
 
 
 
@@ -61,3 +88,15 @@ void fourierTranslate_gpu(const vector3<int> S, const vector3<> Gt, complex* xTi
 	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
 		fourierTranslate_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, Gt, xTilde);
 }
+
+__global__
+void fourierTranslateMany_kernel(int zBlock, const vector3<int> S, int nShifts, const double* alpha, const vector3<>* Gt, complex* xTilde)
+{	COMPUTE_halfGindices
+	fourierTranslateMany_calc(i, iG, S, nShifts, alpha, Gt, xTilde);
+}
+void fourierTranslateMany_gpu(const vector3<int> S, int nShifts, const double* alpha, const vector3<>* Gt, complex* xTilde)
+{	GpuLaunchConfigHalf3D glc(fourierTranslateMany_kernel, S);
+	for(int zBlock=0; zBlock<glc.zBlockMax; zBlock++)
+		fourierTranslateMany_kernel<<<glc.nBlocks,glc.nPerBlock>>>(zBlock, S, nShifts, alpha, Gt, xTilde);
+	gpuErrorCheck();
+}
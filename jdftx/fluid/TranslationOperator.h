@@ -26,6 +26,7 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <core/GridInfo.h>
 #include <core/ScalarField.h>
+#include <vector>
 
 //! Abstract base class for translation operators
 class TranslationOperator
@@ -41,6 +42,13 @@ public:
 	//! T must conserve integral(x) and satisfy @f$ T^{\dagger}_t = T_{-t} @f$ exactly for gradient correctness
 	//! Note that @f$ T^{-1}_t = T_{-t} @f$ may only be approximately true for some implementations.
 	virtual void taxpy(const vector3<>& t, double alpha, const ScalarField& x, ScalarField& y) const=0;
+
+	typedef std::vector<std::pair<vector3<>,double>> ShiftList; //!< list of translations t_j with weights alpha_j
+
+	//! Compute @f$ y += \sum_j alpha_j T_{t_j}(x) @f$ for a list of (t_j, alpha_j) pairs.
+	//! The default implementation calls taxpy for each pair;
+	//! derived classes override this to accumulate all the translations in a single pass over the grid.
+	virtual void taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const;
 };
 
 //! Translation operator which works in real space using interpolating splines
@@ -55,6 +63,11 @@ public:
 
 	TranslationOperatorSpline(const GridInfo& gInfo, SplineType splineType);
 	void taxpy(const vector3<>& t, double alpha, const ScalarField& x, ScalarField& y) const;
+	void taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const;
+
+private:
+	vector3<int> constantShift(const vector3<>& t) const; //!< nearest grid-point offset (in first unit cell) for gathering with translation t
+	vector3<int> linearShift(const vector3<>& t, vector3<>& Tfrac) const; //!< integer grid-point offset and fractional remainder Tfrac for gathering with translation t
 };
 
 //! The exact translation operator in PW basis, although much slower and with potential ringing issues
@@ -63,6 +76,7 @@ class TranslationOperatorFourier : public TranslationOperator
 public:
 	TranslationOperatorFourier(const GridInfo& gInfo);
 	void taxpy(const vector3<>& t, double alpha, const ScalarField& x, ScalarField& y) const;
+	void taxpyMany(const ShiftList& shifts, const ScalarField& x, ScalarField& y) const; //!< combines the phase factors of all shifts, so that only one pair of FFTs is needed
 };
 
 //! @}
@@ -40,14 +40,22 @@ void constantSplineTaxpy_calc(int yIndex, const vector3<int> iy, const vector3<i
 }
 
 __hostanddev__
-void linearSplineTaxpy_calc(int yIndex, const vector3<int> iy, const vector3<int> S,
-	double alpha, const double* x, double* y, const vector3<int> Tint, const vector3<> Tfrac)
+void constantSplineTaxpyMany_calc(int yIndex, const vector3<int> iy, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint)
+{
+	double result = 0.;
+	for(int j=0; j<nShifts; j++)
+		result += alpha[j] * x[wrappedIndex(iy+Tint[j],S)];
+	y[yIndex] += result;
+}
+
+//! Linear interpolation of x at grid point ix offset by fraction Tfrac
+__hostanddev__ double linearSplineInterp(const vector3<int> ix, const vector3<int> S, const double* x, const vector3<> Tfrac)
 {
 	//Weights for linear interpolation:
 	double w0[] = {1-Tfrac[0], Tfrac[0]};
 	double w1[] = {1-Tfrac[1], Tfrac[1]};
 	double w2[] = {1-Tfrac[2], Tfrac[2]};
-	vector3<int> ix = iy + Tint;
 	//Interpolate:
 	double temp0 = 0.0;
 	for(int i0=0; i0<2; i0++) //loop unrolled by default
@@ -61,7 +69,24 @@ void linearSplineTaxpy_calc(int yIndex, const vector3<int> iy, const vector3<int
 		}
 		temp0 += w0[i0] * temp1;
 	}
-	y[yIndex] += alpha * temp0;
+	return temp0;
+}
+
+__hostanddev__
+void linearSplineTaxpy_calc(int yIndex, const vector3<int> iy, const vector3<int> S,
+	double alpha, const double* x, double* y, const vector3<int> Tint, const vector3<> Tfrac)
+{
+	y[yIndex] += alpha * linearSplineInterp(iy+Tint, S, x, Tfrac);
+}
+
+__hostanddev__
+void linearSplineTaxpyMany_calc(int yIndex, const vector3<int> iy, const vector3<int> S,
+	int nShifts, const double* alpha, const double* x, double* y, const vector3<int>* Tint, const vector3<>* Tfrac)
+{
+	double result = 0.;
+	for(int j=0; j<nShifts; j++)
+		result += alpha[j] * linearSplineInterp(iy+Tint[j], S, x, Tfrac[j]);
+	y[yIndex] += result;
 }
 
 __hostanddev__
@@ -69,5 +94,13 @@ void fourierTranslate_calc(int i, const vector3<int> iG, const vector3<int> S, c
 {	xTilde[i] *= cis(-dot(iG,Gt));
 }
 
+__hostanddev__
+void fourierTranslateMany_calc(int i, const vector3<int> iG, const vector3<int> S, int nShifts, const double* alpha, const vector3<>* Gt, complex* xTilde)
+{	complex phase = 0.;
+	for(int j=0; j<nShifts; j++)
+		phase += alpha[j] * cis(-dot(iG,Gt[j]));
+	xTilde[i] *= phase;
+}
+
 //! @endcond
 #endif // JDFTX_FLUID_TRANSLATIONOPERATORINTERNAL_H
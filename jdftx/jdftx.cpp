@@ -25,32 +25,48 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <electronic/LatticeMinimizer.h>
 #include <electronic/Vibrations.h>
 #include <electronic/IonicDynamics.h>
+#include <electronic/IpiDriver.h>
+#include <electronic/NudgedElasticBand.h>
+#include <electronic/SolvationBatch.h>
+#include <electronic/EcutLadder.h>
+#include <electronic/ElectrodeScan.h>
+#include <electronic/HarrisFoulkes.h>
+#include <electronic/MemoryEstimate.h>
+#include <electronic/StateStore.h>
 #include <fluid/FluidSolver.h>
 #include <core/Util.h>
 #include <commands/parser.h>
 
-//Program entry point
-int main(int argc, char** argv)
-{	//Parse command line, initialize system and logs:
-	Everything e; //the parent data structure for, well, everything
-	InitParams ip("Performs Joint Density Functional Theory calculations.", &e);
-	initSystemCmdline(argc, argv, ip);
-	
-	//Parse input file and setup
+//Run the calculation specified by ip.inputFilename on the processes in mpiWorld
+void runCalculation(Everything& e, const InitParams& ip)
+{	//Parse input file and setup
 	ElecVars& eVars = e.eVars;
-	parse(readInputFile(ip.inputFilename), e, ip.printDefaults);
+	std::vector<std::pair<string,string>> commands = readInputFile(ip.inputFilename);
+	parse(commands, e, ip.printDefaults);
+	if(e.nebParams.nImages and (not ip.dryRun))
+	{	//Nudged elastic band: each image is set up and run in its own Everything
+		NudgedElasticBand neb(e, commands, ip.printDefaults);
+		neb.run();
+		return;
+	}
+	std::shared_ptr<SolvationBatch> solvationBatch;
+	if(eVars.solvationBatch.size()) solvationBatch = std::make_shared<SolvationBatch>(e, commands); //parse fluid variants before setup
 	if(ip.dryRun) eVars.skipWfnsInit = true;
 	e.setup();
 	e.dump(DumpFreq_Init, 0);
 	Citations::print();
 	if(ip.dryRun)
-	{	logPrintf("Dry run successful: commands are valid and initialization succeeded.\n");
-		finalizeSystem();
-		return 0;
+	{	MemoryEstimate(e).print();
+		logPrintf("\nDry run successful: commands are valid and initialization succeeded.\n");
+		return;
 	}
 	else logPrintf("Initialization completed successfully at t[s]: %9.2lf\n\n", clock_sec());
 	logFlush();
 	
+	//Converge at lower cutoffs first, if requested:
+	if(e.cntrl.EcutLadder.size() and not (e.cntrl.dumpOnly or e.cntrl.fixed_H))
+		runEcutLadder(e);
+	
 	if(e.cntrl.dumpOnly)
 	{	//Single energy calculation so that all dependent quantities have been initialized:
 		if(eVars.isRandom) die("Electronic state required for dump-only mode has not been read in (using initial-state or wavefunction).\n\n");
@@ -86,9 +102,17 @@ int main(int argc, char** argv)
 			e.eInfo.smearReport();
 		}
 	}
+	else if(e.cntrl.harrisFoulkes)
+	{	//Non-self-consistent energy and forces from a single band solve:
+		runHarrisFoulkes(e);
+	}
 	else if(e.vibrations) //Bypasses ionic/lattice minimization, calls electron/fluid minimization loops at various ionic configurations
 	{	e.vibrations->calculate();
 	}
+	else if(e.ipiDriver)
+	{	//Energy and force evaluations at configurations sent by an external driver code:
+		e.ipiDriver->run(e);
+	}
 	else if(e.ionicDynParams.nSteps)
 	{	//Born-Oppenheimer molecular dynamics
 		IonicDynamics idyn(e);
@@ -108,6 +132,128 @@ int main(int argc, char** argv)
 	//Final dump:
 	e.dump(DumpFreq_End, 0);
 	
+	//Make the converged state available to later calculations of nearby structures:
+	if(e.stateStore and not (e.cntrl.dumpOnly or e.cntrl.fixed_H or e.cntrl.bandStreaming))
+		e.stateStore->save(e);
+	
+	//Charge-potential scan starting from the final state above:
+	if(e.eInfo.scanValues.size()) runElectrodeScan(e);
+	
+	//Fluid variants starting from the final state above:
+	if(solvationBatch) solvationBatch->run(e);
+}
+
+//Run the calculations in each input file listed in ip.inputFilename, divided over ip.nEnsembleGroups process groups.
+//With more than one group, process 0 only hands out input files to groups as they finish (for load balancing).
+void runEnsemble(const InitParams& ip)
+{	//Read list of input files (one per line, ignoring blank lines and comments):
+	std::vector<string> inputFiles;
+	if(mpiWorld->isHead())
+	{	ifstream ifs(ip.inputFilename.c_str());
+		if(!ifs.is_open()) die_alone("Could not open ensemble list '%s' for reading.\n", ip.inputFilename.c_str());
+		while(!ifs.eof())
+		{	string line; getline(ifs, line);
+			trim(line);
+			if(line.length() && line[0]!='#') inputFiles.push_back(line);
+		}
+	}
+	int nInputs = inputFiles.size();
+	mpiWorld->bcast(nInputs);
+	inputFiles.resize(nInputs);
+	for(string& inputFile: inputFiles) mpiWorld->bcast(inputFile);
+	
+	//Divide processes into groups:
+	int nGroups = ip.nEnsembleGroups;
+	int nProcs = mpiWorld->nProcesses();
+	int iProcStart = (nGroups > 1) ? 1 : 0; //process 0 reserved for dispatch with multiple groups
+	if(nProcs-iProcStart < nGroups)
+		die("Ensemble of %d groups requires at least %d processes (process 0 only dispatches for multiple groups).\n", nGroups, nGroups+iProcStart);
+	logPrintf("\nRunning %d calculations listed in '%s' in %d process groups.\n", nInputs, ip.inputFilename.c_str(), nGroups);
+	std::vector<int> groupStart(nGroups+1);
+	for(int iGroup=0; iGroup<=nGroups; iGroup++)
+		groupStart[iGroup] = iProcStart + (iGroup*(nProcs-iProcStart))/nGroups;
+	const int tag = 0;
+	
+	//Dispatcher: hand out input files to group heads as they become available
+	if(mpiWorld->iProcess() < iProcStart)
+	{	std::vector<MPIUtil::Request> requests(nGroups);
+		std::vector<int> iDone(nGroups); //last completed input of each group (-1 if none)
+		for(int iGroup=0; iGroup<nGroups; iGroup++)
+			mpiWorld->recv(iDone[iGroup], groupStart[iGroup], tag, &requests[iGroup]);
+		int iNext = 0, nActive = nGroups;
+		while(nActive)
+		{	int iGroup = MPIUtil::waitAny(requests);
+			if(iDone[iGroup] >= 0)
+			{	logPrintf("Completed '%s' in group %d at t[s]: %9.2lf\n", inputFiles[iDone[iGroup]].c_str(), iGroup, clock_sec());
+				logFlush();
+			}
+			int iAssign = (iNext < nInputs) ? iNext++ : -1;
+			mpiWorld->send(iAssign, groupStart[iGroup], tag);
+			if(iAssign >= 0) mpiWorld->recv(iDone[iGroup], groupStart[iGroup], tag, &requests[iGroup]);
+			else nActive--;
+		}
+		return;
+	}
+	
+	//Group members: run input files one at a time on the group communicator
+	int iGroup = 0;
+	while(mpiWorld->iProcess() >= groupStart[iGroup+1]) iGroup++;
+	std::vector<int> ranks;
+	for(int iProc=groupStart[iGroup]; iProc<groupStart[iGroup+1]; iProc++)
+		ranks.push_back(iProc);
+	MPIUtil* mpiEnsemble = mpiWorld;
+	mpiWorld = new MPIUtil(mpiEnsemble, ranks); //all calculations below use the group communicator
+	FILE* globalLogEnsemble = globalLog;
+	int iInput = -1;
+	while(true)
+	{	//Get next input file:
+		if(nGroups > 1)
+		{	if(mpiWorld->isHead())
+			{	mpiEnsemble->send(iInput, 0, tag);
+				mpiEnsemble->recv(iInput, 0, tag);
+			}
+			mpiWorld->bcast(iInput);
+		}
+		else iInput++;
+		if(iInput < 0 || iInput >= nInputs) break;
+		
+		//Run calculation with log to <inputBasename>.out:
+		InitParams ipCur(ip);
+		ipCur.inputFilename = inputFiles[iInput];
+		setInputBasename(ipCur.inputFilename);
+		globalLog = nullLog;
+		if(mpiWorld->isHead())
+		{	string logFilename = inputBasename + ".out";
+			globalLog = fopen(logFilename.c_str(), "a");
+			if(!globalLog) die_alone("Could not open log file '%s' for writing.\n", logFilename.c_str());
+		}
+		logPrintf("\nEnsemble calculation '%s' in group %d of %d (%d processes).\n",
+			ipCur.inputFilename.c_str(), iGroup, nGroups, mpiWorld->nProcesses());
+		{	Everything e;
+			runCalculation(e, ipCur);
+		}
+		logPrintf("Finished '%s' at t[s]: %9.2lf\n", ipCur.inputFilename.c_str(), clock_sec());
+		if(mpiWorld->isHead()) fclose(globalLog);
+		globalLog = globalLogEnsemble;
+		if(nGroups == 1)
+		{	logPrintf("Completed '%s' at t[s]: %9.2lf\n", ipCur.inputFilename.c_str(), clock_sec());
+			logFlush();
+		}
+	}
+	delete mpiWorld;
+	mpiWorld = mpiEnsemble;
+}
+
+//Program entry point
+int main(int argc, char** argv)
+{	//Parse command line, initialize system and logs:
+	Everything e; //the parent data structure for, well, everything
+	InitParams ip("Performs Joint Density Functional Theory calculations.", &e);
+	initSystemCmdline(argc, argv, ip);
+	
+	if(ip.nEnsembleGroups) runEnsemble(ip);
+	else runCalculation(e, ip);
+	
 	finalizeSystem();
 	return 0;
 }
@@ -22,8 +22,11 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 #include <fluid/FluidSolver.h>
 #include <commands/parser.h>
 #include <core/Units.h>
+#include <core/LatticeUtils.h>
 
-Everything e;
+//! Persistent solver state (grid, FFT plans, fluid kernels and fluid state) retained across calls from the host code.
+//! This is set up once, and only recreated when the host changes the lattice or grid.
+std::shared_ptr<Everything> ePtr;
 
 //! The vast majority of fortran compilers decorate lower case names with an _
 //! Edit this macro if you are using some other compiler which uses a different convention.
@@ -36,6 +39,8 @@ Everything e;
 //! are in the same order as in Fortran, and specified in Angstroms.
 //! This interface takes care of giving the core of JDFTx reversed lattice directions
 //! and sample counts, and for all unit conversions (energies in eV, distances in Angstrom etc.)
+//! This may be called again (eg. at each ionic step of the host code): the existing solver is then
+//! reused as is if the lattice and grid are unchanged, and set up again (without a warm start) otherwise.
 //! @param Rx (in, 3-vector) First lattice direction
 //! @param Ry (in, 3-vector) Second lattice direction
 //! @param Rz (in, 3-vector) Third lattice direction
@@ -44,16 +49,38 @@ Everything e;
 //! @param Sz (in, integer) Number of FFT points along third lattice direction
 DeclareFortranFunction(initjdftx)(double* Rx, double* Ry, double* Rz, int* Sx, int* Sy, int* Sz)
 {
-	//Open log file
-	globalLog = fopen("FLULOG", "w");
-	if(!globalLog)
-	{	globalLog = stdout;
-		logPrintf("WARNING: Could not open log file 'FLULOG' for writing, using standard output.\n");
+	//Lattice vectors and grid in JDFTx order and units:
+	matrix3<> R;
+	for(int k=0; k<3; k++)
+	{	R(k,0) = Rz[k]*Angstrom;
+		R(k,1) = Ry[k]*Angstrom;
+		R(k,2) = Rx[k]*Angstrom;
 	}
+	vector3<int> S(*Sz, *Sy, *Sx);
 	
-	//Initialize environment and print banner:
-	const char* execName = "N/A (Running as a shared library providing fluid solvers)";
-	initSystem(1, (char**)&execName);
+	if(ePtr)
+	{	//Keep the existing solver if possible:
+		if(S == ePtr->gInfo.S && nrm2(R - ePtr->gInfo.R) < symmThreshold*nrm2(R))
+		{	logPrintf("\nReusing fluid solver (lattice and grid unchanged).\n"); logFlush();
+			return;
+		}
+		logPrintf("\nLattice or grid changed: setting up fluid solver again.\n"); logFlush();
+		ePtr.reset();
+	}
+	else
+	{	//Open log file
+		globalLog = fopen("FLULOG", "w");
+		if(!globalLog)
+		{	globalLog = stdout;
+			logPrintf("WARNING: Could not open log file 'FLULOG' for writing, using standard output.\n");
+		}
+		
+		//Initialize environment and print banner:
+		const char* execName = "N/A (Running as a shared library providing fluid solvers)";
+		initSystem(1, (char**)&execName);
+	}
+	ePtr = std::make_shared<Everything>();
+	Everything& e = *ePtr;
 	
 	//Write a wrapper input file:
 	FILE* fpWrap = fopen("FLUCAR.in", "w");
@@ -67,14 +94,14 @@ DeclareFortranFunction(initjdftx)(double* Rx, double* Ry, double* Rz, int* Sx, i
 		"elec-cutoff 0\n"
 		"symmetries none\n"
 		"include FLUCAR\n",
-		 Rz[0]*Angstrom, Ry[0]*Angstrom, Rx[0]*Angstrom,
-		 Rz[1]*Angstrom, Ry[1]*Angstrom, Rx[1]*Angstrom,
-		 Rz[2]*Angstrom, Ry[2]*Angstrom, Rx[2]*Angstrom,
-		 *Sz, *Sy, *Sx);
+		 R(0,0), R(0,1), R(0,2),
+		 R(1,0), R(1,1), R(1,2),
+		 R(2,0), R(2,1), R(2,2),
+		 S[0], S[1], S[2]);
 	fclose(fpWrap);
 	
 	//Initialize system:
-	parse("FLUCAR.in", e);
+	parse(readInputFile("FLUCAR.in"), e);
 	system("rm FLUCAR.in");
 	if(e.eVars.fluidParams.fluidType == FluidNone) die("No fluid model specified in FLUCAR.\n");
 	if(e.iInfo.ionWidthMethod == IonInfo::IonWidthEcut)
@@ -92,12 +119,14 @@ DeclareFortranFunction(initjdftx)(double* Rx, double* Ry, double* Rz, int* Sx, i
 //! Get the recommended nuclear width for the chosen fluid model
 //! @param sigma (out, scalar) Recommended gaussian width
 DeclareFortranFunction(getionsigma)(double* sigma)
-{
-	*sigma = e.iInfo.ionWidth/Angstrom;
+{	if(!ePtr) die("initjdftx must be called before getionsigma.\n");
+	*sigma = ePtr->iInfo.ionWidth/Angstrom;
 }
 
 
 //! Minimize the fluid and return the free energy and its derivatives.
+//! The input buffers are used in place (without copies), and each solve is warm-started
+//! from the fluid state of the previous call (eg. from the previous SCF or ionic step).
 //! @param Adiel (out, scalar) Fluid free energy
 //! @param nCavity (in, real-space scalar field) Electron density involved in cavity determination
 //! @param rhoExplicit (in, real-space scalar field) Total charge density of electronic system (valence electrons + nuclei)
@@ -105,25 +134,26 @@ DeclareFortranFunction(getionsigma)(double* sigma)
 //! @param Adiel_rhoExplicit (out, real-space scalar field) Functional derivative of Adiel with respect to rhoExplicit
 DeclareFortranFunction(minimizefluid)(double* Adiel,
 	double* nCavity, double* rhoExplicit, double* Adiel_nCavity, double* Adiel_rhoExplicit)
-{
-	//Convert inputs to JDFTx objects:
-	ScalarField n, rho;
-	nullToZero(n, e.gInfo); nullToZero(rho, e.gInfo);
-	eblas_copy(n->data(), nCavity, e.gInfo.nr);
-	eblas_copy(rho->data(), rhoExplicit, e.gInfo.nr);
-	n *= pow(Angstrom,-3); rho *= pow(Angstrom,-3); //convert to atomic units
+{	if(!ePtr) die("initjdftx must be called before minimizefluid.\n");
+	Everything& e = *ePtr;
+	
+	//Wrap inputs as JDFTx objects and convert to atomic units (in reciprocal space, leaving host data unmodified):
+	const double densityUnit = pow(Angstrom,-3);
+	ScalarFieldTilde nTilde = densityUnit * J(ScalarFieldData::borrow(e.gInfo, nCavity));
+	ScalarFieldTilde rhoTilde = densityUnit * J(ScalarFieldData::borrow(e.gInfo, rhoExplicit));
 
-	//Run the fluid solver:
+	//Run the fluid solver (whose state persists between calls, providing the initial guess):
 	logPrintf("\n---------------------- Fluid Minimization -----------------------\n");
-	e.eVars.fluidSolver->set(J(rho), J(n)); n=0; rho=0;
+	e.eVars.fluidSolver->set(rhoTilde, nTilde); nTilde=0; rhoTilde=0;
 	e.eVars.fluidSolver->minimizeFluid();
 	ScalarFieldTilde A_n, A_rho; IonicGradient extraForces;
-	double A = e.eVars.fluidSolver->get_Adiel_and_grad(A_rho, A_n, extraForces);
+	double A = e.eVars.fluidSolver->get_Adiel_and_grad(&A_rho, &A_n, &extraForces);
 	e.dump(DumpFreq_Electronic, -1);
 	
 	//Convert outputs:
 	*Adiel = A/eV;
-	eblas_copy(Adiel_nCavity, I(A_n * (1./eV))->data(), e.gInfo.nr);
-	eblas_copy(Adiel_rhoExplicit, I(A_rho * (1./eV))->data(), e.gInfo.nr);
+	A_n *= 1./eV; A_rho *= 1./eV; //absorbed lazily by the transforms below
+	eblas_copy(Adiel_nCavity, I(std::move(A_n))->data(), e.gInfo.nr);
+	eblas_copy(Adiel_rhoExplicit, I(std::move(A_rho))->data(), e.gInfo.nr);
 }
 
@@ -66,6 +66,12 @@ int main()
 	double A;
 	minimizefluid_(&A, n, rho, A_n, A_rho);
 	printf("Adiel = %lg eV\n", A);
+	
+	//Emulate a subsequent step of the host code: the solver is reused and warm-started
+	initjdftx_(Rx, Ry, Rz, &Sx, &Sy, &Sz);
+	for(int i=0; i<nData; i++) rho[i] += 0.01*(n[i] - rho[i]);
+	minimizefluid_(&A, n, rho, A_n, A_rho);
+	printf("Adiel = %lg eV (perturbed, warm start)\n", A);
 	delete[] n,
 	delete[] rho;
 	delete[] A_n;
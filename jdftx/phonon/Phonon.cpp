@@ -27,31 +27,15 @@ void Phonon::dump()
 	dgrad.assign(modes.size(), zeroForce);
 	dHsub.assign(modes.size(), std::vector<matrix>(nSpins));
 	
-	//Accumulate contributions to force matrix and electron-phonon matrix elements for each irreducible perturbation:
-	unsigned iPertStart = (iPerturbation>=0) ? iPerturbation : 0;
-	unsigned iPertStop  = (iPerturbation>=0) ? iPerturbation+1 : perturbations.size();
-	std::vector<int> nStatesPert(perturbations.size());
-	for(unsigned iPert=iPertStart; iPert<iPertStop; iPert++)
-	{	logPrintf("########### Perturbed supercell calculation %u of %d #############\n", iPert+1, int(perturbations.size()));
-		ostringstream oss; oss << "phonon." << iPert+1 << ".$@#!"; //placeholder for $VAR
-		string fnamePattern = e.dump.getFilename(oss.str()); //(because dump variable name cannot contain $VAR)
-		fnamePattern.replace(fnamePattern.find("$@#!"), 4, "$VAR"); //replace placeholder with $VAR
-		processPerturbation(perturbations[iPert], fnamePattern);
-		nStatesPert[iPert] = eSup->eInfo.nStates;
-		logPrintf("\n"); logFlush();
-	}
-	if(dryRun)
-	{	logPrintf("\nParameter summary for supercell calculations:\n");
-		for(unsigned iPert=iPertStart; iPert<iPertStop; iPert++)
-			logPrintf("\tPerturbation: %u  nStates: %d\n", iPert+1, nStatesPert[iPert]);
-		logPrintf("Use option iPerturbation of command phonon to run each supercell calculation separately.\n");
-		return;
-	}
-	if(iPerturbation>=0)
-	{	logPrintf("Completed supercell calculation for iPerturbation %d.\n", iPerturbation+1);
-		logPrintf("After completing all supercells, rerun with option collectPerturbations in command phonon.\n");
-		return;
+	//Compute force matrix (and optionally electron-phonon matrix elements):
+	if(dfpt)
+	{	if(dryRun)
+		{	logPrintf("\nSkipping linear-response calculation in dry run.\n");
+			return;
+		}
+		dfptForceMatrix();
 	}
+	else if(!runPerturbations()) return;
 	
 	//Process force matrix:
 	//--- refine in reciprocal space
@@ -222,6 +206,93 @@ void Phonon::dump()
 			sqrt(-omegaSqMin), kMin[0], kMin[1], kMin[2]);
 	}
 	logPrintf("\n");
+	
+	//Interpolated dispersion, DOS and thermal properties (if requested):
+	interpolate(omegaSq, cellMap);
+}
+
+bool Phonon::runPerturbations()
+{	//Accumulate contributions to force matrix and electron-phonon matrix elements for each irreducible perturbation:
+	unsigned iPertStart = (iPerturbation>=0) ? iPerturbation : 0;
+	unsigned iPertStop  = (iPerturbation>=0) ? iPerturbation+1 : perturbations.size();
+	std::vector<int> nStatesPert(perturbations.size());
+	
+	//Divide processes into groups that run different perturbations concurrently:
+	int nGroupsPert = std::max(1, std::min(std::min(nGroups, mpiWorld->nProcesses()), int(iPertStop-iPertStart)));
+	MPIUtil* mpiPhonon = mpiWorld;
+	FILE* globalLogPhonon = globalLog;
+	int iGroup = 0;
+	if(nGroupsPert > 1)
+	{	int nProcs = mpiPhonon->nProcesses();
+		iGroup = (nGroupsPert * (mpiPhonon->iProcess()+1) - 1) / nProcs;
+		std::vector<int> ranks;
+		for(int iProc=(iGroup*nProcs)/nGroupsPert; iProc<((iGroup+1)*nProcs)/nGroupsPert; iProc++)
+			ranks.push_back(iProc);
+		logPrintf("Running %d perturbations in %d process groups, with a log for each in the phonon.<iPert>.out dump file.\n\n",
+			iPertStop-iPertStart, nGroupsPert);
+		logFlush();
+		mpiWorld = new MPIUtil(mpiPhonon, ranks); //supercell calculations use the group communicator
+	}
+	
+	for(unsigned iPert=iPertStart; iPert<iPertStop; iPert++)
+	{	if(int((iPert-iPertStart) % nGroupsPert) != iGroup) continue; //handled by another group
+		ostringstream oss; oss << "phonon." << iPert+1 << ".$@#!"; //placeholder for $VAR
+		string fnamePattern = e.dump.getFilename(oss.str()); //(because dump variable name cannot contain $VAR)
+		fnamePattern.replace(fnamePattern.find("$@#!"), 4, "$VAR"); //replace placeholder with $VAR
+		if(nGroupsPert > 1)
+		{	//Separate log for each perturbation:
+			globalLog = nullLog;
+			if(mpiWorld->isHead())
+			{	string logFilename = fnamePattern; logFilename.replace(logFilename.find("$VAR"), 4, "out");
+				globalLog = fopen(logFilename.c_str(), "w");
+				if(!globalLog) die_alone("Could not open log file '%s' for writing.\n", logFilename.c_str());
+			}
+		}
+		logPrintf("########### Perturbed supercell calculation %u of %d #############\n", iPert+1, int(perturbations.size()));
+		processPerturbation(perturbations[iPert], fnamePattern);
+		nStatesPert[iPert] = eSup->eInfo.nStates;
+		logPrintf("\n"); logFlush();
+		if(nGroupsPert > 1)
+		{	if(mpiWorld->isHead()) fclose(globalLog);
+			globalLog = globalLogPhonon;
+		}
+	}
+	
+	//Collect results from all groups:
+	if(nGroupsPert > 1)
+	{	eSup = 0;
+		bool isGroupHead = mpiWorld->isHead();
+		delete mpiWorld;
+		mpiWorld = mpiPhonon;
+		int nBandsSup = e.eInfo.nBands * prodSup;
+		for(size_t iMode=0; iMode<modes.size(); iMode++)
+		{	for(std::vector<vector3<>>& dgradSp: dgrad[iMode])
+			{	if(!isGroupHead) dgradSp.assign(dgradSp.size(), vector3<>());
+				mpiWorld->allReduceData(dgradSp, MPIUtil::ReduceSum);
+			}
+			if(saveHsub)
+				for(matrix& M: dHsub[iMode])
+				{	if((!M) or (!isGroupHead)) M = zeroes(nBandsSup, nBandsSup);
+					mpiWorld->allReduceData(M, MPIUtil::ReduceSum);
+				}
+		}
+		if(!isGroupHead) std::fill(nStatesPert.begin(), nStatesPert.end(), 0);
+		mpiWorld->allReduceData(nStatesPert, MPIUtil::ReduceSum);
+		logPrintf("Collected results of all perturbations from %d process groups.\n", nGroupsPert);
+	}
+	if(dryRun)
+	{	logPrintf("\nParameter summary for supercell calculations:\n");
+		for(unsigned iPert=iPertStart; iPert<iPertStop; iPert++)
+			logPrintf("\tPerturbation: %u  nStates: %d\n", iPert+1, nStatesPert[iPert]);
+		logPrintf("Use option iPerturbation of command phonon to run each supercell calculation separately.\n");
+		return false;
+	}
+	if(iPerturbation>=0)
+	{	logPrintf("Completed supercell calculation for iPerturbation %d.\n", iPerturbation+1);
+		logPrintf("After completing all supercells, rerun with option collectPerturbations in command phonon.\n");
+		return false;
+	}
+	return true;
 }
 
 vector3<int> Phonon::getCell(int unit) const
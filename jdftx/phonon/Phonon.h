@@ -63,6 +63,11 @@ public:
 	int iPerturbation; //!< if >=0, only run one supercell calculation
 	bool collectPerturbations; //!< if true, collect results of previously computed perturbations (skips supercell SCF/Minimize)
 	bool saveHsub; //!< whether to compute / output electron-phonon matrix elements
+	int nGroups; //!< number of process groups that run supercell calculations for different perturbations concurrently
+	bool dfpt; //!< if true, compute force matrix by linear response in the unit cell instead of supercell calculations
+	string qPathFile; //!< if non-empty, file of q-points (lattice coordinates) along which to output interpolated frequencies
+	vector3<int> qMesh; //!< if non-zero, dense q-mesh for interpolated phonon DOS and thermal properties
+	double dosDomega; //!< frequency bin width for phonon DOS
 	
 	Phonon();
 	void setup(bool printDefaults); //!< setup unit cell and basis modes for perturbations
@@ -97,6 +102,12 @@ private:
 	};
 	std::vector<Perturbation> perturbations;
 	
+	//!Run (or collect) supercell calculations for all perturbations into dgrad and dHsub; return false if no further processing is required
+	bool runPerturbations();
+	
+	//!Compute the force matrix into dgrad using density-functional perturbation theory in the unit cell (implemented in Phonon_dfpt.cpp)
+	void dfptForceMatrix();
+	
 	//!Run supercell calculation for specified perturbation (using fnamePattern to load/restore required properties)
 	void processPerturbation(const Perturbation& pert, string fnamePattern);
 	
@@ -130,6 +141,9 @@ private:
 
 	//! Check translational invariance sum rule of force matrix
 	void forceMatrixSumRuleCheck(const std::vector<matrix>& F, const std::map<vector3<int>,matrix>& cellMap) const;
+	
+	//! Fourier interpolate omegaSq to the q-path and dense q-mesh, and output dispersion, DOS and thermal properties (implemented in Phonon_interp.cpp)
+	void interpolate(const std::vector<matrix>& omegaSq, const std::map<vector3<int>,matrix>& cellMap) const;
 };
 
 //! @}
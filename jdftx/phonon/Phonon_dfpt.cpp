@@ -0,0 +1,580 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <phonon/Phonon.h>
+#include <electronic/ColumnBundleTransform.h>
+#include <electronic/Polarizability.h>
+#include <core/Pulay.h>
+
+//Nonlocal projectors of each species with basis and qnum matching C (null for purely local species)
+std::vector< std::shared_ptr<ColumnBundle> > dfptProjectors(const Everything& e, const ColumnBundle& C)
+{	std::vector< std::shared_ptr<ColumnBundle> > V;
+	for(const auto& sp: e.iInfo.species)
+		V.push_back(sp->getV(C));
+	return V;
+}
+
+//Apply the unperturbed unit cell Hamiltonian (in the dual convention of ElecVars::applyHamiltonian)
+//to norm-conserving LDA/GGA states X with specified projectors V
+ColumnBundle dfptApplyH(const Everything& e, const ColumnBundle& X, const std::vector< std::shared_ptr<ColumnBundle> >& V)
+{	ColumnBundle HX = -0.5*L(X);
+	HX += Idag_DiagV_I(X, e.eVars.Vscloc);
+	for(size_t sp=0; sp<V.size(); sp++)
+		if(V[sp])
+		{	matrix MVdagX = zeroes(V[sp]->nCols(), X.nCols());
+			e.iInfo.species[sp]->EnlAndGrad(*(X.qnum), diagMatrix(X.nCols(),1.), (*V[sp])^X, MVdagX);
+			HX += (*V[sp]) * MVdagX;
+		}
+	return HX;
+}
+
+//Occupied unit cell states at a k-point and its partner k+q, along with quantities reused by each perturbation
+struct DfptState
+{	QuantumNumber qnum, qnumQ; //k and k+q
+	Basis basis, basisQ;
+	ColumnBundle C, Cq, OCq; //occupied eigenstates at k and k+q, and overlap applied to the latter
+	diagMatrix eig, KEref; //eigenvalues and kinetic energies of occupied states at k
+	std::vector<matrix> MVdagC; //nonlocal M*(V^C) at k for each species
+	std::vector< std::vector<matrix> > MVdagDC; //nonlocal M*(V^D_i(C)) at k for each species and Cartesian direction
+	std::vector< std::shared_ptr<ColumnBundle> > Vq; //projectors at k+q for each species
+	std::vector< std::vector<ColumnBundle> > DVq; //Cartesian gradients of projectors at k+q for each species
+	ColumnBundle dC; //first-order change of occupied states (at k+q) for current perturbation
+
+	//Initialize states from the reduced unit cell states, and optionally accumulate
+	//the on-site second-order nonlocal contribution to the dynamical matrix (in mode order) into Dnl
+	void setup(const Everything& e, vector3<> k, const Supercell::KmeshTransform& kTransform,
+		vector3<> kq, const Supercell::KmeshTransform& kqTransform, int nV, double weight,
+		matrix* Dnl, const std::vector<int>& spModeStart)
+	{	loadStates(e, k, kTransform, nV, weight, qnum, basis, C);
+		loadStates(e, kq, kqTransform, nV, weight, qnumQ, basisQ, Cq);
+		OCq = O(Cq);
+		//Rotate states at k to the eigenbasis:
+		std::vector< std::shared_ptr<ColumnBundle> > V = dfptProjectors(e, C);
+		matrix Hsub = C ^ dfptApplyH(e, C, V);
+		matrix U; Hsub.diagonalize(U, eig);
+		C = C * U;
+		KEref = diagDot(C, -0.5*L(C));
+		//Nonlocal projections at k:
+		int nSpecies = e.iInfo.species.size();
+		MVdagC.assign(nSpecies, matrix());
+		MVdagDC.assign(nSpecies, std::vector<matrix>(3));
+		diagMatrix Fq(nV, 1.);
+		for(int sp=0; sp<nSpecies; sp++)
+			if(V[sp])
+			{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+				matrix VdagC = (*V[sp]) ^ C;
+				MVdagC[sp] = zeroes(VdagC.nRows(), nV);
+				spInfo.EnlAndGrad(qnum, Fq, VdagC, MVdagC[sp]);
+				std::vector<matrix> VdagDC(3);
+				for(int iDir=0; iDir<3; iDir++)
+				{	VdagDC[iDir] = (*V[sp]) ^ D(C,iDir);
+					MVdagDC[sp][iDir] = zeroes(VdagC.nRows(), nV);
+					spInfo.EnlAndGrad(qnum, Fq, VdagDC[iDir], MVdagDC[sp][iDir]);
+				}
+				if(Dnl)
+				{	//Second derivative of nonlocal energy: 2 Re tr[(V^DD C)^ M V^C] + 2 Re tr[(V^D C)^ M (V^D C)] per atom
+					int nAtoms = spInfo.atpos.size();
+					int nProj = VdagC.nRows() / nAtoms;
+					for(int iDir=0; iDir<3; iDir++)
+						for(int jDir=0; jDir<3; jDir++)
+						{	matrix VdagDDC = (*V[sp]) ^ DD(C,iDir,jDir);
+							for(int at=0; at<nAtoms; at++)
+							{	int pStart = at*nProj, pStop = (at+1)*nProj;
+								double Dij = 2.*weight * trace(
+									dagger(VdagDDC(pStart,pStop, 0,nV)) * MVdagC[sp](pStart,pStop, 0,nV)
+									+ dagger(VdagDC[iDir](pStart,pStop, 0,nV)) * MVdagDC[sp][jDir](pStart,pStop, 0,nV) ).real();
+								int iMode = spModeStart[sp] + 3*at;
+								Dnl->set(iMode+iDir, iMode+jDir, (*Dnl)(iMode+iDir, iMode+jDir) + Dij);
+							}
+						}
+			}
+		}
+		//Projectors at k+q:
+		Vq = dfptProjectors(e, Cq);
+		DVq.assign(nSpecies, std::vector<ColumnBundle>());
+		for(int sp=0; sp<nSpecies; sp++)
+			if(Vq[sp])
+				for(int iDir=0; iDir<3; iDir++)
+					DVq[sp].push_back(D(*Vq[sp], iDir));
+	}
+
+	//Unperturbed Hamiltonian at k+q
+	ColumnBundle H(const Everything& e, const ColumnBundle& X) const { return dfptApplyH(e, X, Vq); }
+
+	//Projection onto unoccupied subspace at k+q, and its adjoint (for dual vectors):
+	ColumnBundle Pc(const ColumnBundle& X) const { ColumnBundle Y = X; Y -= Cq * (OCq ^ X); return Y; }
+	ColumnBundle PcDag(const ColumnBundle& Y) const { ColumnBundle X = Y; X -= OCq * (Cq ^ Y); return X; }
+
+private:
+	//Get occupied states at k on the charge-density grid, mapped from the reduced state by kTransform
+	static void loadStates(const Everything& e, vector3<> k, const Supercell::KmeshTransform& kTransform, int nV, double weight,
+		QuantumNumber& qnum, Basis& basis, ColumnBundle& C)
+	{	qnum.k = k;
+		qnum.spin = 0;
+		qnum.weight = weight;
+		logSuspend();
+		basis.setup(e.gInfo, e.iInfo, e.cntrl.Ecut, k);
+		logResume();
+		const ColumnBundle& Cred = e.eVars.C[kTransform.iReduced];
+		ColumnBundle Cfull(Cred.nCols(), basis.nbasis, &basis, &qnum, isGpuEnabled());
+		Cfull.zero();
+		ColumnBundleTransform(Cred.qnum->k, *(Cred.basis), k, basis, 1,
+			e.symm.getMatrices()[kTransform.iSym], kTransform.invert).scatterAxpy(1., Cred, Cfull, 0, 1);
+		C = Cfull.getSub(0, nV);
+	}
+};
+
+//Hartree kernel, and mixing preconditioner and metric (as in SCF potential mixing) for perturbations at wavevector q
+struct DfptKernels
+{	std::vector<double> coulomb, mix, metric;
+
+	DfptKernels(const Everything& e, const Basis& basisRho, vector3<> q)
+	{	const SCFparams& sp = e.scfParams;
+		//Minimum non-zero |G|^2 (regularizes the preconditioner at G=0):
+		double GminSq = DBL_MAX;
+		vector3<int> iG;
+		for(iG[0]=-1; iG[0]<=1; iG[0]++)
+		for(iG[1]=-1; iG[1]<=1; iG[1]++)
+		for(iG[2]=-1; iG[2]<=1; iG[2]++)
+			if(iG.length_squared())
+				GminSq = std::min(GminSq, e.gInfo.GGT.metric_length_squared(iG));
+		const vector3<int>* iGarr = basisRho.iGarr.data();
+		for(size_t i=0; i<basisRho.nbasis; i++)
+		{	double Ksq = e.gInfo.GGT.metric_length_squared(iGarr[i] + q);
+			double KsqReg = std::max(Ksq, GminSq);
+			coulomb.push_back(Ksq > symmThresholdSq*GminSq ? 4*M_PI/Ksq : 0.);
+			mix.push_back(sp.mixFraction * (sp.qKerker ? KsqReg/(KsqReg + pow(sp.qKerker,2)) : 1.));
+			metric.push_back(sp.qMetric ? KsqReg/(KsqReg + pow(sp.qMetric,2)) : 1.);
+		}
+	}
+};
+
+//Self-consistent first-order response of the unit cell to one atomic displacement pattern at wavevector q,
+//mixing the first-order Hartree + XC potential
+class DfptSCF : public Pulay<ColumnBundle>
+{
+public:
+	ColumnBundle dn; //!< first-order electron density (Fourier coefficients in the perturbation basis) at the latest cycle
+
+	DfptSCF(const Everything& e, const PulayParams& pp, std::vector< std::shared_ptr<DfptState> >& states, double weight,
+		const ColumnBundle& dVloc, int sp, int at, int iDir, const ExCorrKernel& kernelXC, const DfptKernels& kernels)
+	: Pulay<ColumnBundle>(pp), e(e), states(states), weight(weight), dVloc(dVloc), sp(sp), at(at), iDir(iDir),
+		kernelXC(kernelXC), kernels(kernels)
+	{	dVHxc = dVloc.similar();
+		dVHxc.zero();
+	}
+
+	double sync(double x) const { mpiWorld->bcast(x); return x; }
+
+protected:
+	double cycle(double dEprev, std::vector<double>& extraValues)
+	{	//Solve Sternheimer equations in total first-order potential and collect density response:
+		ColumnBundle dV = dVloc; dV += dVHxc;
+		complexScalarField dVr = I(dV.getColumn(0,0));
+		complexScalarField dnR;
+		for(std::shared_ptr<DfptState>& s: states)
+		{	solveSternheimer(*s, dVr);
+			for(int b=0; b<s->C.nCols(); b++)
+				dnR += (2.*weight) * (conj(I(s->C.getColumn(b,0))) * I(s->dC.getColumn(b,0))); //factor of 2 from time-reversal symmetry
+		}
+		dn = dVloc.similar();
+		dn.zero();
+		if(dnR) dn.setColumn(0,0, J(dnR));
+		mpiWorld->allReduceData(dn, MPIUtil::ReduceSum);
+		//Update the first-order Hartree and XC potential:
+		dVHxc = kernelXC(dn);
+		complex* dVHxcData = dVHxc.data();
+		const complex* dnData = dn.data();
+		for(size_t i=0; i<dn.colLength(); i++)
+			dVHxcData[i] += kernels.coulomb[i] * dnData[i];
+		//Local contribution to the diagonal element of the dynamical matrix:
+		return e.gInfo.detR * (dVloc ^ dn)(0,0).real();
+	}
+
+	void axpy(double alpha, const ColumnBundle& X, ColumnBundle& Y) const
+	{	if(!Y) { Y = X.similar(); Y.zero(); }
+		::axpy(alpha, X, Y);
+	}
+	double dot(const ColumnBundle& X, const ColumnBundle& Y) const { return ::dot(X, Y); }
+	size_t variableSize() const { return dVloc.nData() * sizeof(complex); }
+	void readVariable(ColumnBundle& X, FILE* fp) const { X = dVloc.similar(); X.read(fp); }
+	void writeVariable(const ColumnBundle& X, FILE* fp) const { X.write(fp); }
+	ColumnBundle getVariable() const { return dVHxc; }
+	void setVariable(const ColumnBundle& X) { dVHxc = X; }
+	ColumnBundle precondition(const ColumnBundle& X) const { return applyKernel(X, kernels.mix); }
+	ColumnBundle applyMetric(const ColumnBundle& X) const { return applyKernel(X, kernels.metric); }
+
+private:
+	const Everything& e;
+	std::vector< std::shared_ptr<DfptState> >& states;
+	double weight; //spin-degenerate weight of each k-point
+	const ColumnBundle& dVloc; //first-order local potential of the displacement (Fourier coefficients)
+	int sp, at, iDir; //displaced atom and Cartesian direction
+	const ExCorrKernel& kernelXC;
+	const DfptKernels& kernels;
+	ColumnBundle dVHxc; //first-order Hartree + XC potential (mixed variable)
+
+	static ColumnBundle applyKernel(const ColumnBundle& X, const std::vector<double>& kernel)
+	{	ColumnBundle Y = X;
+		complex* Ydata = Y.data();
+		for(size_t i=0; i<Y.colLength(); i++)
+			Ydata[i] *= kernel[i];
+		return Y;
+	}
+
+	//Solve for first-order states s.dC in the unoccupied subspace at k+q, for local first-order potential dVr (real space)
+	//and the nonlocal first-order potential of the displaced atom, using band-by-band preconditioned conjugate gradients
+	void solveSternheimer(DfptState& s, const complexScalarField& dVr) const
+	{	const ColumnBundle& C = s.C;
+		int nV = C.nCols();
+		//First-order potential applied to occupied states (in dual convention):
+		ColumnBundle dVC = s.Cq.similar();
+		for(int b=0; b<nV; b++)
+			dVC.setColumn(b,0, e.gInfo.detR * J(dVr * I(C.getColumn(b,0))));
+		if(s.Vq[sp])
+		{	int nProj = s.Vq[sp]->nCols() / e.iInfo.species[sp]->atpos.size();
+			int pStart = at*nProj, pStop = (at+1)*nProj;
+			dVC -= s.DVq[sp][iDir].getSub(pStart,pStop) * s.MVdagC[sp](pStart,pStop, 0,nV);
+			dVC += s.Vq[sp]->getSub(pStart,pStop) * s.MVdagDC[sp][iDir](pStart,pStop, 0,nV);
+		}
+		ColumnBundle rhs = s.PcDag(dVC); rhs *= -1.;
+		diagMatrix rhsNormSq = diagDot(rhs, rhs);
+
+		//Operator (H - eig O) restricted to unoccupied subspace, and its preconditioner:
+		auto applyA = [&](const ColumnBundle& X)
+		{	ColumnBundle AX = s.H(e, X);
+			AX -= O(X) * s.eig;
+			return s.PcDag(AX);
+		};
+		auto precond = [&](const ColumnBundle& R)
+		{	ColumnBundle Z = R;
+			precond_inv_kinetic_band(Z, s.KEref);
+			return s.Pc(Z);
+		};
+
+		//Preconditioned conjugate gradients (starting from previous cycle's solution, if any):
+		const double tolSq = 1e-14; //relative tolerance on residual norm squared of each band
+		const int nIterations = 100;
+		if(!s.dC) { s.dC = s.Cq.similar(); s.dC.zero(); }
+		ColumnBundle& x = s.dC;
+		x = s.Pc(x);
+		ColumnBundle r = rhs; r -= applyA(x);
+		ColumnBundle z = precond(r), d = z;
+		diagMatrix rz = diagDot(r, z);
+		for(int iter=0; iter<nIterations; iter++)
+		{	//Check convergence:
+			diagMatrix rNormSq = diagDot(r, r);
+			bool converged = true;
+			for(int b=0; b<nV; b++)
+				if(rNormSq[b] > tolSq*rhsNormSq[b] + DBL_MIN)
+					converged = false;
+			if(converged) break;
+			//Step along search direction:
+			ColumnBundle Ad = applyA(d);
+			diagMatrix dAd = diagDot(d, Ad), alpha(nV);
+			for(int b=0; b<nV; b++) alpha[b] = dAd[b] ? rz[b]/dAd[b] : 0.;
+			x += d * alpha;
+			r -= Ad * alpha;
+			//Update search direction:
+			z = precond(r);
+			diagMatrix rzNew = diagDot(r, z), beta(nV);
+			for(int b=0; b<nV; b++) beta[b] = rz[b] ? rzNew[b]/rz[b] : 0.;
+			d = d * beta;
+			d += z;
+			rz = rzNew;
+		}
+	}
+};
+
+//Ion-ion (Ewald) contribution to the dynamical matrix at wavevector q (reciprocal lattice coordinates),
+//for atoms with charges Z and lattice coordinates x (in mode order, three Cartesian directions per atom)
+matrix dfptEwaldMatrix(const GridInfo& gInfo, const std::vector<double>& Z, const std::vector< vector3<> >& x, vector3<> q)
+{	int nAtoms = x.size();
+	double eta = sqrt(M_PI) / pow(gInfo.detR, 1./3); //Ewald splitting parameter
+	double rMax = 6./eta, Gmax = 12.*eta; //real and reciprocal space cutoffs (erfc and gaussian below double precision)
+	vector3<int> Rbox, Gbox;
+	for(int j=0; j<3; j++)
+	{	Rbox[j] = 1 + int(ceil(rMax * gInfo.G.row(j).length() / (2*M_PI)));
+		Gbox[j] = 1 + int(ceil(Gmax * gInfo.R.column(j).length() / (2*M_PI)));
+	}
+
+	//Lattice sums S_ab(q) = sum_R' exp(2 pi i q.R) grad grad (1/r) at r = x_a - x_b - R:
+	auto pairSums = [&](vector3<> q)
+	{	matrix S = zeroes(3*nAtoms, 3*nAtoms);
+		for(int a=0; a<nAtoms; a++)
+			for(int b=0; b<nAtoms; b++)
+			{	matrix3<complex> Sab;
+				vector3<> xab = x[a] - x[b];
+				//Real space sum:
+				vector3<int> iR;
+				for(iR[0]=-Rbox[0]; iR[0]<=Rbox[0]; iR[0]++)
+				for(iR[1]=-Rbox[1]; iR[1]<=Rbox[1]; iR[1]++)
+				for(iR[2]=-Rbox[2]; iR[2]<=Rbox[2]; iR[2]++)
+				{	vector3<> r = gInfo.R * (xab - vector3<>(iR));
+					double rSq = r.length_squared();
+					if(rSq > rMax*rMax || rSq < symmThresholdSq) continue; //self-interaction handled together with reciprocal space below
+					double rMag = sqrt(rSq);
+					double erfcTerm = erfc(eta*rMag);
+					double gaussTerm = (2.*eta/sqrt(M_PI)) * exp(-eta*eta*rSq);
+					double h1 = -erfcTerm/rSq - gaussTerm/rMag; //first radial derivative of erfc(eta r)/r
+					double h2 = 2.*erfcTerm/(rSq*rMag) + gaussTerm*(2./rSq + 2.*eta*eta); //second radial derivative
+					complex phase = cis(2*M_PI*dot(q, iR));
+					for(int i=0; i<3; i++)
+						for(int j=0; j<3; j++)
+							Sab(i,j) += phase * ((h2 - h1/rMag)*r[i]*r[j]/rSq + (i==j ? h1/rMag : 0.));
+				}
+				//Reciprocal space sum:
+				vector3<int> iG;
+				for(iG[0]=-Gbox[0]; iG[0]<=Gbox[0]; iG[0]++)
+				for(iG[1]=-Gbox[1]; iG[1]<=Gbox[1]; iG[1]++)
+				for(iG[2]=-Gbox[2]; iG[2]<=Gbox[2]; iG[2]++)
+				{	vector3<> iGq = iG + q;
+					vector3<> K = iGq * gInfo.G;
+					double Ksq = K.length_squared();
+					if(Ksq > Gmax*Gmax || Ksq < symmThresholdSq) continue; //non-analytic G=0 term is omitted
+					complex prefac = (-4*M_PI/(gInfo.detR*Ksq)) * exp(-0.25*Ksq/(eta*eta)) * cis(2*M_PI*dot(iGq, xab));
+					for(int i=0; i<3; i++)
+						for(int j=0; j<3; j++)
+							Sab(i,j) += prefac * K[i] * K[j];
+				}
+				//Remove self-interaction of the long-ranged part:
+				if(a==b)
+					for(int i=0; i<3; i++)
+						Sab(i,i) += 4.*pow(eta,3)/(3.*sqrt(M_PI));
+				for(int i=0; i<3; i++)
+					for(int j=0; j<3; j++)
+						S.set(3*a+i, 3*b+j, Sab(i,j));
+			}
+		return S;
+	};
+	matrix Sq = pairSums(q), S0 = pairSums(vector3<>());
+
+	//Collect dynamical matrix (including on-site term from displacing each atom against all others):
+	matrix Dion = zeroes(3*nAtoms, 3*nAtoms);
+	for(int a=0; a<nAtoms; a++)
+		for(int i=0; i<3; i++)
+			for(int j=0; j<3; j++)
+			{	for(int b=0; b<nAtoms; b++)
+					Dion.set(3*a+i, 3*b+j, Dion(3*a+i, 3*b+j) - Z[a]*Z[b]*Sq(3*a+i, 3*b+j));
+				complex onSite = 0.;
+				for(int c=0; c<nAtoms; c++)
+					onSite += Z[a]*Z[c]*S0(3*a+i, 3*c+j);
+				Dion.set(3*a+i, 3*a+j, Dion(3*a+i, 3*a+j) + onSite);
+			}
+	return Dion;
+}
+
+
+void Phonon::dfptForceMatrix()
+{	logPrintf("\n------- Linear-response (DFPT) force matrix -------\n"); logFlush();
+
+	//Check that the unit cell calculation is supported:
+	if(nSpins>1 || nSpinor>1)
+		die("phonon dfpt currently requires a spin-unpolarized calculation.\n");
+	int nV = int(round(0.5*e.eInfo.nElectrons));
+	if(e.eInfo.fillingsUpdate==ElecInfo::FillingsHsub || fabs(2*nV-e.eInfo.nElectrons)>1e-8 || nV>e.eInfo.nBands)
+		die("phonon dfpt currently requires an insulator with fixed integer fillings.\n");
+	for(int q=0; q<e.eInfo.nStates; q++)
+		for(int b=0; b<e.eInfo.nBands; b++)
+			if(fabs(e.eVars.F[q][b] - (b<nV ? 1. : 0.)) > 1e-8)
+				die("phonon dfpt currently requires an insulator with fixed integer fillings.\n");
+	if(e.eInfo.hasU || e.exCorr.exxFactor() || e.exCorr.needsKEdensity() || e.exCorr.orbitalDep)
+		die("phonon dfpt currently supports only LDA and GGA functionals (without DFT+U).\n");
+	if(e.eVars.fluidParams.fluidType != FluidNone)
+		die("phonon dfpt does not yet support fluids.\n");
+	if(e.coulombParams.geometry != CoulombParams::Periodic)
+		die("phonon dfpt currently requires periodic boundary conditions.\n");
+	if(e.iInfo.vdWenable)
+		die("phonon dfpt does not yet support pair-potential vdW corrections.\n");
+	for(const auto& sp: e.iInfo.species)
+		if(sp->atpos.size() && (sp->isUltrasoft() || sp->nCoreRadial || sp->Z_chargeball))
+			die("phonon dfpt currently requires norm-conserving pseudopotentials without partial cores or chargeballs (species %s).\n", sp->name.c_str());
+
+	//Atoms and their offsets in mode order:
+	int nSpecies = e.iInfo.species.size();
+	std::vector<int> spModeStart(nSpecies);
+	std::vector<double> Zatoms;
+	std::vector< vector3<> > xAtoms;
+	for(int sp=0; sp<nSpecies; sp++)
+	{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+		spModeStart[sp] = 3*xAtoms.size();
+		xAtoms.insert(xAtoms.end(), spInfo.atpos.begin(), spInfo.atpos.end());
+		Zatoms.insert(Zatoms.end(), spInfo.atpos.size(), spInfo.Z);
+	}
+	int nModes = modes.size();
+	assert(nModes == 3*int(xAtoms.size()));
+
+	//Projectors are stored explicitly below for transiently allocated bases, so bypass the cache:
+	bool cacheProjectors = e.cntrl.cacheProjectors;
+	e.cntrl.cacheProjectors = false;
+
+	const Supercell& supercell = *(e.coulombParams.supercell);
+	int nK = supercell.kmesh.size();
+	double wk = 2./nK; //spin-degenerate weight of each k-point
+	int ikStart, ikStop;
+	TaskDivision(nK, mpiWorld).myRange(ikStart, ikStop);
+	ExCorrKernel kernelXC(e, e.eVars.get_nTot(), e.gInfo);
+	PulayParams pp = e.scfParams;
+	pp.fpLog = globalLog;
+	pp.linePrefix = "DFPT: ";
+	pp.energyLabel = "Dloc";
+
+	//On-site second derivative of the local pseudopotential energy (independent of q):
+	matrix Donsite = zeroes(nModes, nModes);
+	{	Basis basisRho0; QuantumNumber qnum0;
+		logSuspend();
+		basisRho0.setup(e.gInfo, e.iInfo, 4.*e.cntrl.Ecut, vector3<>());
+		logResume();
+		ColumnBundle n0(1, basisRho0.nbasis, &basisRho0, &qnum0);
+		n0.setColumn(0,0, J(Complex(e.eVars.get_nTot())));
+		const complex* n0data = n0.data();
+		const vector3<int>* iGarr = basisRho0.iGarr.data();
+		for(int sp=0; sp<nSpecies; sp++)
+		{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+			for(size_t at=0; at<spInfo.atpos.size(); at++)
+			{	matrix3<> D3;
+				for(size_t i=0; i<basisRho0.nbasis; i++)
+				{	vector3<> K = iGarr[i] * e.gInfo.G;
+					double Ksq = K.length_squared();
+					if(!Ksq) continue;
+					double Vfac = (conj(n0data[i]) * cis(-2*M_PI*dot(iGarr[i], spInfo.atpos[at]))).real()
+						* (spInfo.VlocRadial(sqrt(Ksq)) - 4*M_PI*spInfo.Z/Ksq);
+					D3 -= Vfac * outer(K, K);
+				}
+				int iMode = spModeStart[sp] + 3*at;
+				for(int i=0; i<3; i++)
+					for(int j=0; j<3; j++)
+						Donsite.set(iMode+i, iMode+j, D3(i,j));
+			}
+		}
+	}
+
+	//Dynamical matrix at each wavevector commensurate with the supercell:
+	std::vector<matrix> Dq(prodSup);
+	std::vector< vector3<> > qArr(prodSup);
+	for(int iq=0; iq<prodSup; iq++)
+	{	vector3<int> iqCell = getCell(iq);
+		vector3<>& q = qArr[iq];
+		for(int j=0; j<3; j++) q[j] = double(iqCell[j]) / sup[j];
+		logPrintf("\n########### Linear response at q = [ %+.6lf %+.6lf %+.6lf ] (%d of %d) #############\n", q[0], q[1], q[2], iq+1, prodSup);
+		logFlush();
+
+		//Perturbation basis, kernels and first-order local potential of each displacement:
+		QuantumNumber qnumRho; qnumRho.k = q;
+		Basis basisRho;
+		logSuspend();
+		basisRho.setup(e.gInfo, e.iInfo, 4.*e.cntrl.Ecut, q);
+		logResume();
+		DfptKernels kernels(e, basisRho, q);
+		ColumnBundle dVloc(nModes, basisRho.nbasis, &basisRho, &qnumRho);
+		dVloc.zero();
+		{	complex* dVlocData = dVloc.data();
+			const vector3<int>* iGarr = basisRho.iGarr.data();
+			for(int sp=0; sp<nSpecies; sp++)
+			{	const SpeciesInfo& spInfo = *(e.iInfo.species[sp]);
+				for(size_t at=0; at<spInfo.atpos.size(); at++)
+				{	int iMode = spModeStart[sp] + 3*at;
+					for(size_t i=0; i<basisRho.nbasis; i++)
+					{	vector3<> iGq = iGarr[i] + q;
+						vector3<> K = iGq * e.gInfo.G;
+						double Ksq = K.length_squared();
+						if(Ksq < symmThresholdSq) continue;
+						complex prefac = cis(-2*M_PI*dot(iGq, spInfo.atpos[at]))
+							* ((spInfo.VlocRadial(sqrt(Ksq)) - 4*M_PI*spInfo.Z/Ksq) / e.gInfo.detR);
+						for(int iDir=0; iDir<3; iDir++)
+							dVlocData[dVloc.index(iMode+iDir, i)] = complex(0., -K[iDir]) * prefac; //derivative w.r.t atom position
+					}
+				}
+			}
+		}
+
+		//Initialize states at k and k+q:
+		logPrintf("Initializing states for %d k-points in the full mesh ... ", nK); logFlush();
+		std::vector< std::shared_ptr<DfptState> > states;
+		matrix Dnl = zeroes(nModes, nModes);
+		for(int ik=ikStart; ik<ikStop; ik++)
+		{	vector3<> k = supercell.kmesh[ik], kq = k + q;
+			Supercell::KmeshTransform kqTransform = {0, 0, 0, vector3<int>()};
+			bool foundkq = (supercell.findKpoint(kq, &kqTransform) != string::npos);
+			assert(foundkq); //q is commensurate with the k-point mesh
+			std::shared_ptr<DfptState> s = std::make_shared<DfptState>();
+			s->setup(e, k, supercell.kmeshTransform[ik], kq, kqTransform, nV, wk, iq==0 ? &Dnl : 0, spModeStart);
+			states.push_back(s);
+		}
+		if(iq==0) //on-site nonlocal term is independent of q
+		{	mpiWorld->allReduceData(Dnl, MPIUtil::ReduceSum);
+			Donsite += Dnl;
+		}
+		logPrintf("done.\n"); logFlush();
+
+		//Self-consistent response to each displacement:
+		matrix Del = zeroes(nModes, nModes);
+		ColumnBundle dn = dVloc.similar();
+		for(int iMode=0; iMode<nModes; iMode++)
+		{	const Mode& mode = modes[iMode];
+			int iDir = iMode % 3;
+			logPrintf("\n--- Displacement %d of %d: species %s atom %d direction %d ---\n",
+				iMode+1, nModes, e.iInfo.species[mode.sp]->name.c_str(), mode.at, iDir);
+			for(std::shared_ptr<DfptState>& s: states)
+				s->dC = ColumnBundle();
+			ColumnBundle dVlocMode = dVloc.getSub(iMode, iMode+1);
+			DfptSCF scf(e, pp, states, wk, dVlocMode, mode.sp, mode.at, iDir, kernelXC, kernels);
+			scf.minimize();
+			dn.setSub(iMode, scf.dn);
+			//Nonlocal part of electronic response (local part collected from dn below):
+			for(const std::shared_ptr<DfptState>& s: states)
+				for(int sp=0; sp<nSpecies; sp++)
+					if(s->Vq[sp])
+					{	matrix P = (*s->Vq[sp]) ^ s->dC;
+						int nAtoms = e.iInfo.species[sp]->atpos.size();
+						int nProj = P.nRows() / nAtoms;
+						for(int iDirA=0; iDirA<3; iDirA++)
+						{	matrix PD = s->DVq[sp][iDirA] ^ s->dC;
+							for(int at=0; at<nAtoms; at++)
+							{	int pStart = at*nProj, pStop = (at+1)*nProj;
+								complex Dab = (2.*wk) * trace(
+									dagger(s->MVdagDC[sp][iDirA](pStart,pStop, 0,nV)) * P(pStart,pStop, 0,nV)
+									- dagger(s->MVdagC[sp](pStart,pStop, 0,nV)) * PD(pStart,pStop, 0,nV) );
+								int iModeA = spModeStart[sp] + 3*at + iDirA;
+								Del.set(iModeA, iMode, Del(iModeA, iMode) + Dab);
+							}
+						}
+					}
+		}
+		mpiWorld->allReduceData(Del, MPIUtil::ReduceSum);
+		Del += e.gInfo.detR * (dVloc ^ dn);
+		Dq[iq] = dagger_symmetrize(Del + Donsite + dfptEwaldMatrix(e.gInfo, Zatoms, xAtoms, q));
+	}
+	e.cntrl.cacheProjectors = cacheProjectors;
+
+	//Fourier transform dynamical matrices to real-space force matrix in dgrad format:
+	for(int iModeB=0; iModeB<nModes; iModeB++)
+		for(int iModeA=0; iModeA<nModes; iModeA++)
+		{	const Mode& modeA = modes[iModeA];
+			size_t nAtomsSp = e.iInfo.species[modeA.sp]->atpos.size();
+			for(int iCell=0; iCell<prodSup; iCell++)
+			{	vector3<int> iR = getCell(iCell);
+				double F = 0.;
+				for(int iq=0; iq<prodSup; iq++)
+					F += (cis(-2*M_PI*dot(qArr[iq], iR)) * Dq[iq](iModeB, iModeA)).real();
+				dgrad[iModeB][modeA.sp][modeA.at + iCell*nAtomsSp] += (F/prodSup) * modeA.dir;
+			}
+		}
+	logPrintf("\nCompleted linear-response force matrix.\n"); logFlush();
+}
@@ -28,7 +28,7 @@ PhononEverything::PhononEverything(Phonon& phonon) : phonon(phonon)
 }
 
 Phonon::Phonon()
-: dr(0.1), T(298*Kelvin), Fcut(1e-8), rSmooth(1.), iPerturbation(-1), collectPerturbations(false), saveHsub(true), e(*this), eSupTemplate(*this)
+: dr(0.1), T(298*Kelvin), Fcut(1e-8), rSmooth(1.), iPerturbation(-1), collectPerturbations(false), saveHsub(true), nGroups(1), dfpt(false), qMesh(0,0,0), dosDomega(1e-5), e(*this), eSupTemplate(*this)
 {
 }
 
@@ -99,6 +99,11 @@ void Phonon::setup(bool printDefaults)
 	mpiWorld->allReduce(nBandsOpt, MPIUtil::ReduceMax);
 	logPrintf("Fcut=%lg reduced nBands from %d to %d per unit cell.\n", Fcut, e.eInfo.nBands, nBandsOpt);
 
+	if(dfpt && saveHsub)
+	{	logPrintf("Electron-phonon matrix elements are not computed in dfpt mode: disabling saveHsub.\n");
+		saveHsub = false;
+	}
+	
 	//Write list of commensurate k-points:
 	if(saveHsub and (iPerturbation<0) and mpiWorld->isHead())
 	{	string fname = e.dump.getFilename("phononKpts");
@@ -0,0 +1,198 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <phonon/Phonon.h>
+#include <core/Units.h>
+#include <fstream>
+
+//Fourier interpolation of the real-space omegaSq onto arbitrary q (in reciprocal lattice coordinates).
+//The Fourier sum for a batch of q is a single matrix product of the flattened cell matrices with the
+//phase factors, and the resulting dynamical matrices of the batch are diagonalized together.
+struct PhononInterpolator
+{	int nModes, nCells;
+	std::vector<vector3<int>> cells; //cell offsets of the cell map (lattice coordinates)
+	matrix omegaSqR; //real-space omegaSq flattened into columns (nModes^2 x nCells)
+	
+	PhononInterpolator(const std::vector<matrix>& omegaSq, const std::map<vector3<int>,matrix>& cellMap)
+	: nModes(omegaSq[0].nRows()), nCells(omegaSq.size()), omegaSqR(nModes*nModes, nCells)
+	{	auto iter = cellMap.begin();
+		for(int iCell=0; iCell<nCells; iCell++,iter++)
+		{	cells.push_back(iter->first);
+			matrix M = omegaSq[iCell]; M.reshape(nModes*nModes, 1);
+			omegaSqR.set(0,nModes*nModes, iCell,iCell+1, M);
+		}
+	}
+	
+	//Compute frequencies for nq wavevectors q into omega (nModes per q, ascending),
+	//with imaginary frequencies reported as negative values:
+	void compute(const vector3<>* q, int nq, double* omega) const
+	{	//Phase factors:
+		matrix phase(nCells, nq);
+		complex* phaseData = phase.data();
+		for(int iq=0; iq<nq; iq++)
+			for(int iCell=0; iCell<nCells; iCell++)
+				phaseData[phase.index(iCell,iq)] = cis(2*M_PI*dot(cells[iCell], q[iq]));
+		//Dynamical matrices of entire batch at once:
+		matrix omegaSqQ = omegaSqR * phase;
+		std::vector<matrix> omegaSqBatch(nq);
+		for(int iq=0; iq<nq; iq++)
+		{	matrix M = omegaSqQ(0,nModes*nModes, iq,iq+1); M.reshape(nModes, nModes);
+			omegaSqBatch[iq] = dagger_symmetrize(M);
+		}
+		//Batched diagonalization:
+		std::vector<matrix> evecs(nq); std::vector<diagMatrix> eigs(nq);
+		diagonalize(omegaSqBatch, evecs, eigs);
+		for(int iq=0; iq<nq; iq++)
+			for(int iMode=0; iMode<nModes; iMode++)
+			{	double omegaSq = eigs[iq][iMode];
+				*(omega++) = (omegaSq >= 0.) ? sqrt(omegaSq) : -sqrt(-omegaSq);
+			}
+	}
+};
+
+//Evaluate frequencies for wavevectors q(iq) for iq in [0,nq) divided over MPI, streaming them in batches
+//to a binary file fname (nModes doubles per q, in q order) and passing each batch to process(iqStart, nqBatch, omega)
+template<typename QFunc, typename ProcessFunc>
+void interpolateStream(const PhononInterpolator& interp, size_t nq, const QFunc& q, string fname, const ProcessFunc& process)
+{	const int nqBatch = 256;
+	size_t iqStart, iqStop;
+	TaskDivision(nq, mpiWorld).myRange(iqStart, iqStop);
+	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+	MPIUtil::File fp; mpiWorld->fopenWrite(fp, fname.c_str());
+	mpiWorld->fseek(fp, iqStart*interp.nModes*sizeof(double), SEEK_SET);
+	std::vector<vector3<>> qBatch; std::vector<double> omegaBatch;
+	for(size_t iqBatchStart=iqStart; iqBatchStart<iqStop; iqBatchStart+=nqBatch)
+	{	int nqCur = std::min(size_t(nqBatch), iqStop-iqBatchStart);
+		qBatch.resize(nqCur);
+		omegaBatch.resize(nqCur*interp.nModes);
+		for(int iq=0; iq<nqCur; iq++)
+			qBatch[iq] = q(iqBatchStart+iq);
+		interp.compute(qBatch.data(), nqCur, omegaBatch.data());
+		mpiWorld->fwriteData(omegaBatch, fp);
+		process(iqBatchStart, nqCur, omegaBatch.data());
+	}
+	mpiWorld->fclose(fp);
+	logPrintf("done.\n"); logFlush();
+}
+
+void Phonon::interpolate(const std::vector<matrix>& omegaSq, const std::map<vector3<int>,matrix>& cellMap) const
+{	if(!qPathFile.length() && !qMesh.length_squared()) return; //no interpolated output requested
+	logPrintf("\n---------- Fourier interpolation of phonon frequencies ----------\n");
+	PhononInterpolator interp(omegaSq, cellMap);
+	const int& nModes = interp.nModes;
+	
+	//Dispersion along specified q-points:
+	if(qPathFile.length())
+	{	std::vector<vector3<>> qPath;
+		std::ifstream ifs(qPathFile.c_str());
+		if(!ifs.is_open()) die("Could not open phonon qPath file '%s' for reading.\n", qPathFile.c_str());
+		while(!ifs.eof())
+		{	string line; getline(ifs, line);
+			trim(line);
+			if(!line.length() || line[0]=='#') continue;
+			istringstream iss(line);
+			string key; iss >> key;
+			if(key != "kpoint") { iss.clear(); iss.seekg(0); } //optional kpoint keyword (as in bandstruct files)
+			vector3<> q; iss >> q[0] >> q[1] >> q[2];
+			if(iss.fail()) die("Could not parse q-point from line '%s' in '%s'.\n", line.c_str(), qPathFile.c_str());
+			qPath.push_back(q);
+		}
+		logPrintf("Read %lu q-points along path from '%s'.\n", qPath.size(), qPathFile.c_str());
+		interpolateStream(interp, qPath.size(), [&](size_t iq) { return qPath[iq]; },
+			e.dump.getFilename("phononDispersion"), [](size_t, int, const double*){});
+	}
+	
+	//DOS and thermal properties on dense mesh:
+	if(qMesh.length_squared())
+	{	vector3<int> N = qMesh;
+		vector3<bool> isTruncated = e.coulombParams.isTruncated();
+		for(int dir=0; dir<3; dir++)
+			if(isTruncated[dir] && N[dir]>1)
+			{	logPrintf("Using a single q-point along truncated direction %d of qMesh.\n", dir);
+				N[dir] = 1;
+			}
+		size_t nq = size_t(N[0]) * N[1] * N[2];
+		logPrintf("Interpolating on %d x %d x %d q-mesh (%lu q-points).\n", N[0], N[1], N[2], nq);
+		auto qMeshPoint = [&](size_t iq)
+		{	vector3<> q;
+			for(int dir=2; dir>=0; dir--)
+			{	q[dir] = double(iq % N[dir]) / N[dir];
+				iq /= N[dir];
+			}
+			return q;
+		};
+		//Accumulate DOS histogram and thermal properties per batch:
+		std::vector<double> dos;
+		double ZPE = 0., Evib = 0., Avib = 0., Cv = 0.;
+		double omegaMin = 0.; //most negative (imaginary) frequency, if any
+		size_t nImag = 0;
+		const double w = 1./nq; //integration weight per q
+		auto process = [&](size_t iqStart, int nqBatch, const double* omega)
+		{	for(int i=0; i<nqBatch*nModes; i++)
+			{	if(omega[i] <= 0.)
+				{	if(omega[i] < -dosDomega) nImag++; //ignore round-off near zero of acoustic modes at Gamma
+					omegaMin = std::min(omegaMin, omega[i]);
+					continue;
+				}
+				size_t iBin = size_t(omega[i] / dosDomega);
+				if(iBin >= dos.size()) dos.resize(iBin+1, 0.);
+				dos[iBin] += w / dosDomega;
+				double omegaByT = omega[i]/T, expMomegaByT = exp(-omegaByT);
+				ZPE += w*( 0.5*omega[i] );
+				Evib += w*( 0.5*omega[i] + omega[i] * expMomegaByT / (1.-expMomegaByT) );
+				Avib += w*( 0.5*omega[i] + T * log(1.-expMomegaByT) );
+				Cv += w*( std::pow(omegaByT/(2.*sinh(0.5*omegaByT)), 2) );
+			}
+		};
+		interpolateStream(interp, nq, qMeshPoint, e.dump.getFilename("phononOmegaMesh"), process);
+		mpiWorld->allReduce(ZPE, MPIUtil::ReduceSum);
+		mpiWorld->allReduce(Evib, MPIUtil::ReduceSum);
+		mpiWorld->allReduce(Avib, MPIUtil::ReduceSum);
+		mpiWorld->allReduce(Cv, MPIUtil::ReduceSum);
+		mpiWorld->allReduce(omegaMin, MPIUtil::ReduceMin);
+		mpiWorld->allReduce(nImag, MPIUtil::ReduceSum);
+		size_t nBins = dos.size();
+		mpiWorld->allReduce(nBins, MPIUtil::ReduceMax);
+		dos.resize(nBins, 0.);
+		mpiWorld->allReduceData(dos, MPIUtil::ReduceSum);
+		
+		//Write DOS:
+		if(mpiWorld->isHead())
+		{	string fname = e.dump.getFilename("phononDOS");
+			logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+			FILE* fp = fopen(fname.c_str(), "w");
+			fprintf(fp, "#omega[Eh] g[per Eh per unit cell]\n");
+			for(size_t iBin=0; iBin<nBins; iBin++)
+				fprintf(fp, "%.8le %.8le\n", (iBin+0.5)*dosDomega, dos[iBin]);
+			fclose(fp);
+			logPrintf("done.\n"); logFlush();
+		}
+		
+		//Report thermal properties:
+		logPrintf("\nInterpolated phonon thermal properties (per unit cell) at T = %lg K:\n", T/Kelvin);
+		logPrintf("\tZPE:   %15.6lf\n", ZPE);
+		logPrintf("\tEvib:  %15.6lf\n", Evib);
+		logPrintf("\tTSvib: %15.6lf\n", Evib - Avib);
+		logPrintf("\tAvib:  %15.6lf\n", Avib);
+		logPrintf("\tCv/kB: %15.6lf\n", Cv);
+		if(nImag)
+			logPrintf("\tWARNING: discarded %lu imaginary frequencies on q-mesh (strongest |omega|: %.6lf)\n", nImag, -omegaMin);
+	}
+	logPrintf("\n");
+}
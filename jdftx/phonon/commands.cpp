@@ -30,6 +30,11 @@ enum PhononMember
  	PM_T,
 	PM_Fcut,
 	PM_rSmooth,
+	PM_nGroups,
+	PM_dfpt,
+	PM_qPath,
+	PM_qMesh,
+	PM_dosDomega,
 	PM_delim
 };
 
@@ -41,7 +46,12 @@ EnumStringMap<PhononMember> phononMemberMap
 	PM_saveHsub, "saveHsub",
 	PM_T, "T",
 	PM_Fcut, "Fcut",
-	PM_rSmooth, "rSmooth"
+	PM_rSmooth, "rSmooth",
+	PM_nGroups, "nGroups",
+	PM_dfpt, "dfpt",
+	PM_qPath, "qPath",
+	PM_qMesh, "qMesh",
+	PM_dosDomega, "dosDomega"
 );
 
 struct CommandPhonon : public Command
@@ -78,7 +88,39 @@ struct CommandPhonon : public Command
 			"   are desired; this flag ensures that those extra bands do not affect the\n"
 			"   performance or memory requirements of the supercell calculations.\n"
 			"\n+ rSmooth <rSmooth>\n\n"
-			"   Width in bohrs of the supercell boundary region over which matrix elements are smoothed.";
+			"   Width in bohrs of the supercell boundary region over which matrix elements are smoothed.\n"
+			"\n+ nGroups <nGroups>\n\n"
+			"   Number of process groups that run supercell calculations for different perturbations\n"
+			"   concurrently (default 1). Each group runs every nGroups'th perturbation, logging to\n"
+			"   the phonon.<iPert>.out dump file when nGroups > 1, and the results are collected\n"
+			"   over all groups at the end. Each supercell calculation starts from the unit cell\n"
+			"   state mapped to the supercell (as with a single group). Ignored with iPerturbation.\n"
+			"\n+ dfpt yes|no\n\n"
+			"   Whether to compute the force matrix using density-functional perturbation theory\n"
+			"   (linear response) in the unit cell, solving Sternheimer equations at each wavevector\n"
+			"   commensurate with the supercell, instead of frozen-phonon supercell calculations.\n"
+			"   Currently limited to unpolarized insulators with norm-conserving pseudopotentials\n"
+			"   (without partial core corrections), LDA/GGA functionals and periodic boundaries.\n"
+			"   Electron-phonon matrix elements are not computed in this mode (saveHsub is disabled).\n"
+			"   Default: no.\n"
+			"\n+ qPath <filename>\n\n"
+			"   Fourier interpolate the force matrix to the q-points (in reciprocal lattice coordinates)\n"
+			"   listed one per line in <filename>, optionally preceded by the kpoint keyword and followed\n"
+			"   by further columns (so that bandstruct.kpoints files can be used directly).\n"
+			"   The frequencies (in Hartrees, ascending, with imaginary ones as negative values) are\n"
+			"   written to the binary phononDispersion dump file: nModes doubles per q-point.\n"
+			"\n+ qMesh <N0> <N1> <N2>\n\n"
+			"   Fourier interpolate the force matrix to a Gamma-centered <N0> x <N1> x <N2> q-mesh\n"
+			"   (using a single q-point along truncated directions) and report the vibrational free energy\n"
+			"   components and heat capacity at T from this mesh. Frequencies are written as for qPath\n"
+			"   to phononOmegaMesh, with the q-point index running fastest along N2, and the phonon\n"
+			"   density of states (per unit cell) to phononDOS.\n"
+			"\n+ dosDomega <dOmega>\n\n"
+			"   Frequency bin width (in Hartrees) for phononDOS (default 1e-5).\n"
+			"\n"
+			"Interpolation evaluates the dynamical matrices for batches of q-points together and\n"
+			"diagonalizes them in batches, with q-points divided over MPI processes that each write\n"
+			"their portion of the binary output directly.";
 		
 		forbid("fix-electron-density");
 		forbid("fix-electron-potential");
@@ -108,11 +150,15 @@ struct CommandPhonon : public Command
 						throw string("perturbation number must be positive");
 					if(phonon.collectPerturbations)
 						throw string("cannot use iPerturbation in the same calculation as collectPerturbations");
+					if(phonon.dfpt)
+						throw string("cannot use iPerturbation in the same calculation as dfpt");
 					break;
 				case PM_collectPerturbations:
 					phonon.collectPerturbations = true;
 					if(phonon.iPerturbation>=0)
 						throw string("cannot use iPerturbation in the same calculation as collectPerturbations");
+					if(phonon.dfpt)
+						throw string("cannot use collectPerturbations in the same calculation as dfpt");
 					break;
 				case PM_saveHsub:
 					pl.get(phonon.saveHsub, true, boolMap, "saveHsub", true);
@@ -129,6 +175,32 @@ struct CommandPhonon : public Command
 					pl.get(phonon.rSmooth, 1., "rSmooth", true);
 					if(phonon.rSmooth <= 0.) throw string("<rSmooth> must be positive");
 					break;
+				case PM_nGroups:
+					pl.get(phonon.nGroups, 1, "nGroups", true);
+					if(phonon.nGroups <= 0) throw string("<nGroups> must be positive");
+					break;
+				case PM_dfpt:
+					pl.get(phonon.dfpt, false, boolMap, "dfpt", true);
+					if(phonon.dfpt && phonon.iPerturbation>=0)
+						throw string("cannot use iPerturbation in the same calculation as dfpt");
+					if(phonon.dfpt && phonon.collectPerturbations)
+						throw string("cannot use collectPerturbations in the same calculation as dfpt");
+					break;
+				case PM_qPath:
+					pl.get(phonon.qPathFile, string(), "filename", true);
+					break;
+				case PM_qMesh:
+					for(int j=0; j<3; j++)
+					{	char paramName[8]; sprintf(paramName, "N%d", j);
+						pl.get(phonon.qMesh[j], 0, paramName, true);
+						if(phonon.qMesh[j]<=0)
+							throw string("q-mesh dimensions must be positive");
+					}
+					break;
+				case PM_dosDomega:
+					pl.get(phonon.dosDomega, 0., "dOmega", true);
+					if(phonon.dosDomega <= 0.) throw string("<dOmega> must be positive");
+					break;
 				case PM_delim: //should never be encountered
 					break;
 			}
@@ -145,6 +217,11 @@ struct CommandPhonon : public Command
 		logPrintf(" \\\n\tT %lg", phonon.T/Kelvin);
 		logPrintf(" \\\n\tFcut %lg", phonon.Fcut);
 		logPrintf(" \\\n\trSmooth %lg", phonon.rSmooth);
+		logPrintf(" \\\n\tnGroups %d", phonon.nGroups);
+		logPrintf(" \\\n\tdfpt %s", boolMap.getString(phonon.dfpt));
+		if(phonon.qPathFile.length()) logPrintf(" \\\n\tqPath %s", phonon.qPathFile.c_str());
+		if(phonon.qMesh.length_squared()) logPrintf(" \\\n\tqMesh %d %d %d", phonon.qMesh[0], phonon.qMesh[1], phonon.qMesh[2]);
+		logPrintf(" \\\n\tdosDomega %lg", phonon.dosDomega);
 	}
 }
 commandPhonon;
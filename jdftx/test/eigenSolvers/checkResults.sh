@@ -0,0 +1,18 @@
+#!/bin/bash
+
+algos="LOBPCG Chebyshev"
+echo "$((2*$(echo $algos | wc -w)))" #number of checks
+
+for algo in $algos; do
+	#SCF energy using each eigensolver in the inner loop, compared to Davidson:
+	awk -v algo=$algo '
+		/IonicMinimize: Iter/ { if(FILENAME==ARGV[1]) Eref = $5; else E = $5 }
+		END { printf("%.10f %.10f 1e-6 SCF energy with %s vs Davidson [Eh]\n", E, Eref, algo) }
+	' scfDavidson.out scf$algo.out
+	
+	#Band eigenvalues at fixed density (lowest 8 of 10 bands at each k), compared to Davidson:
+	paste <(od -An -v -t f8 -w8 bandsDavidson.eigenvals) <(od -An -v -t f8 -w8 bands$algo.eigenvals) | awk -v algo=$algo '
+		NF==2 { n++; if((n-1)%10 < 8) { err = $2-$1; if(err<0) err = -err; if(err > errMax) errMax = err } }
+		END { printf("%.3e 0 1e-5 max eigenvalue error of %s vs Davidson (%d values) [Eh]\n", (n ? errMax : 1.), algo, n) }
+	'
+done
@@ -0,0 +1,3 @@
+#!/bin/bash
+export runs="scfDavidson scfLOBPCG scfChebyshev bandsDavidson bandsLOBPCG bandsChebyshev"
+export nProcs="4"
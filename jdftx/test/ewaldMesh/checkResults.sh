@@ -0,0 +1,24 @@
+#!/bin/bash
+
+echo "3" #number of checks
+
+#Particle-mesh Ewald energy and forces compared to the analytic Ewald sum:
+awk '
+	FILENAME==ARGV[1] && $1=="Eewald" { Eref = $3 }
+	FILENAME==ARGV[2] && $1=="Eewald" { E = $3 }
+	END { printf("%.10f %.10f 1e-6 Mesh vs analytic Eewald [Eh]\n", E, Eref) }
+' analytic.out mesh.out
+for prefix in forcePairPot force; do
+	awk -v prefix=$prefix '
+		FILENAME==ARGV[1] && $1==prefix { nRef++; for(k=3; k<=5; k++) fRef[nRef,k] = $k }
+		FILENAME==ARGV[2] && $1==prefix { n++; for(k=3; k<=5; k++) f[n,k] = $k }
+		END {
+			errMax = (n==nRef && n>0) ? 0. : 1.; #fail on a mismatch in number of force lines
+			for(i=1; i<=n; i++) for(k=3; k<=5; k++)
+			{	err = f[i,k] - fRef[i,k]; if(err<0) err = -err;
+				if(err > errMax) errMax = err;
+			}
+			printf("%.3e 0 1e-6 Mesh vs analytic max %s error [Eh/a0]\n", errMax, prefix)
+		}
+	' analytic.out mesh.out
+done
@@ -0,0 +1,3 @@
+#!/bin/bash
+export runs="analytic mesh"
+export nProcs="2"
@@ -0,0 +1,2 @@
+#!/bin/bash
+export perfRuns="perf"
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+echo "2" #number of checks
+
+#Saddle point energy from the climbing-image NEB, compared to the symmetric H3 relaxation:
+awk '
+	FILENAME==ARGV[1] && /IonicMinimize: Iter/ { Esaddle = $5 }
+	FILENAME==ARGV[2] && /NEB: End point energies:/ { E0 = $6 }
+	FILENAME==ARGV[2] && /NEB: Iter:/ { Ebarrier = $5 }
+	END {
+		printf("%.8f %.8f 2e-4 NEB saddle point energy [Eh]\n", E0+Ebarrier, Esaddle);
+		printf("%.8f 0.0056 0.004 H+H2 barrier (PBE ~ 3.5 kcal/mol) [Eh]\n", Ebarrier);
+	}
+' saddle.out neb.out
@@ -0,0 +1,3 @@
+#!/bin/bash
+export runs="saddle neb"
+export nProcs="4"
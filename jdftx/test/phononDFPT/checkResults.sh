@@ -0,0 +1,12 @@
+#!/bin/bash
+
+echo "2" #number of checks
+
+#Vibrational free energy components from DFPT, compared to frozen phonons within 3%:
+for key in ZPE Evib; do
+	awk -v key=$key '
+		FILENAME==ARGV[1] && $1==(key ":") { xRef = $2 }
+		FILENAME==ARGV[2] && $1==(key ":") { x = $2 }
+		END { printf("%.6f %.6f %.6f DFPT vs supercell %s [Eh]\n", x, xRef, 0.03*(xRef<0 ? -xRef : xRef), key) }
+	' supercell.out dfpt.out
+done
@@ -0,0 +1,4 @@
+#!/bin/bash
+export runs="supercell dfpt"
+export nProcs="4"
+export executable="phonon"
@@ -2,14 +2,25 @@
 
 srcDir="$1"
 runDir="$2"
+mode="$3"  #optional: "perf" to print results of performance tests instead
 
 #Get list of test targets from CMakeLists.txt:
 targets=( )
 for target in $(grep '^add_jdftx_test' $srcDir/CMakeLists.txt); do
 	target=${target/add_jdftx_test(/}
 	target=${target/)/}
+	if [ "$mode" == "perf" ]; then
+		[ -f $srcDir/$target/perf.sh ] || continue
+	fi
 	targets+=( $target )
 done
+if [ "$mode" == "perf" ]; then
+	resultsDir="perf"
+	testLabel="Performance test"
+else
+	resultsDir="."
+	testLabel="Test"
+fi
 
 function printPaddedHeader()
 {
@@ -27,18 +38,18 @@ function printPaddedHeader()
 #Print details of each test:
 for target in "${targets[@]}"; do
 	echo
-	printPaddedHeader "Test ${target}"
+	printPaddedHeader "${testLabel} ${target}"
 	echo
-	cat $runDir/$target/results
-	cat $runDir/$target/summary
+	cat $runDir/$target/$resultsDir/results
+	cat $runDir/$target/$resultsDir/summary
 	echo
 done
 
 echo
-printPaddedHeader "Summary of tests"
+printPaddedHeader "Summary of ${testLabel,,}s"
 echo
 for target in "${targets[@]}"; do
 	printf "%30s: " ${target}
-	cat $runDir/$target/summary
+	cat $runDir/$target/$resultsDir/summary
 done
 echo
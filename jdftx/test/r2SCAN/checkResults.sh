@@ -0,0 +1,18 @@
+#!/bin/bash
+
+echo "2" #number of checks
+
+#Internal r2SCAN compared to the LibXC reference implementation:
+if [ -f libxc.out ]; then
+	awk '
+		/IonicMinimize: Iter/ { if(FILENAME==ARGV[1]) Eref = $5; else E = $5 }
+		$1=="Exc" { if(FILENAME==ARGV[1]) ExcRef = $3; else Exc = $3 }
+		END {
+			printf("%.10f %.10f 1e-5 r2SCAN total energy vs LibXC [Eh]\n", E, Eref);
+			printf("%.10f %.10f 1e-5 r2SCAN Exc vs LibXC [Eh]\n", Exc, ExcRef);
+		}
+	' libxc.out internal.out
+else
+	echo "0 0 1 LibXC with r2SCAN not available"
+	echo "0 0 1 LibXC with r2SCAN not available"
+fi
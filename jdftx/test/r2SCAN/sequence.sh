@@ -0,0 +1,8 @@
+#!/bin/bash
+#Compare against the LibXC implementation of r2SCAN, when available in this build:
+if $jdftxBuildDir/jdftx$JDFTX_SUFFIX -t 2>/dev/null | grep -q "mgga-x-r2scan"; then
+	export runs="internal libxc"
+else
+	export runs="internal"
+fi
+export nProcs="4"
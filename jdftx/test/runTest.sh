@@ -8,12 +8,114 @@ jdftxBuildDir="$4"
 testSrcDir="$testsuiteSrcDir/$testName"
 testRunDir="$testsuiteRunDir/$testName"
 
+mode="$5"  #optional: "perf" to run performance tests, or "perfbaseline" to store their results as baselines
+
 mkdir -p $testRunDir
 cd $testRunDir
 export SRCDIR="$testSrcDir"
 
+#Performance mode: time scaled-up runs declared in perf.sh over several process/thread counts
+if [ "$mode" == "perfbaseline" ]; then
+	if [ -f perf/timings ]; then
+		awk '{ print $1, $2, $3 }' perf/timings > $testSrcDir/perfBaseline
+		echo "Stored baseline $testSrcDir/perfBaseline"
+	fi
+	exit 0
+fi
+if [ "$mode" == "perf" ]; then
+	source $testSrcDir/perf.sh
+	perfConfigs="${JDFTX_PERF_CONFIGS:-1x1 2x1 4x1 1x2 1x4}"  #list of <nProcs>x<nThreads>
+	perfTolerance="${JDFTX_PERF_TOLERANCE:-0.2}"  #allowed fractional increase in wall time over baseline
+	mkdir -p perf
+	cd perf
+	rm -f timings phases results summary
+	for config in $perfConfigs; do
+		nProcsPerf="${config%x*}"
+		nThreadsPerf="${config#*x}"
+		if [[ "$JDFTX_LAUNCH" == *'%d'* ]]; then
+			LAUNCH="$(printf "$JDFTX_LAUNCH" "$nProcsPerf")"
+		elif [ "$nProcsPerf" -eq "1" ]; then
+			LAUNCH="$JDFTX_LAUNCH"
+		else
+			echo "Skipping $config: JDFTX_LAUNCH must contain %d for the process count"
+			continue
+		fi
+		for run in $perfRuns; do
+			outFile="$run.$config.out"
+			$LAUNCH $jdftxBuildDir/jdftx$JDFTX_SUFFIX -i $testSrcDir/$run.in -c $nThreadsPerf -d -o $outFile
+			if [ "$?" -ne "0" ]; then
+				echo "FAILED: error running $run with $config" > summary
+				exit 1
+			fi
+			#Wall time from end-of-run duration, and peak memory from MEMUSAGE (profiling builds only):
+			awk -v config=$config -v run=$run '
+				/End date and time:/ {
+					split($NF, dhms, /[-:)]/);
+					wallTime = ((dhms[1]*24 + dhms[2])*60 + dhms[3])*60 + dhms[4];
+				}
+				/^MEMUSAGE: +Total/ { memPeak = $3 }
+				END { printf("%s %s %.2f %s\n", config, run, wallTime, (memPeak=="" ? "NA" : memPeak)) }
+			' $outFile >> timings
+			#Per-phase total times from StopWatch (profiling builds only):
+			awk -v config=$config -v run=$run '
+				/^PROFILER:/ { name = $2; for(k=3; $k!~/^[0-9.]+$/; k++) name = name "_" $k; print config, run, name, $(NF-2) }
+			' $outFile >> phases
+		done
+	done
+	#Parallel efficiency relative to 1x1 and comparison against stored baseline:
+	touch phases
+	awk -v tol=$perfTolerance '
+		FILENAME==ARGV[1] { tBase[$1 " " $2] = $3; next }
+		{	config = $1; run = $2; t[config " " run] = $3; mem[config " " run] = $4;
+			order[++n] = config " " run;
+		}
+		END {
+			printf("%10s %10s %12s %10s %12s %12s Status\n", "Config", "Run", "WallTime[s]", "MemPeak[GB]", "Efficiency", "Baseline[s]");
+			nFail = 0; nCompared = 0;
+			for(i=1; i<=n; i++)
+			{	key = order[i]; split(key, cr, " ");
+				split(cr[1], pt, "x");
+				t1 = t["1x1 " cr[2]];
+				eff = (t1 > 0 && t[key] > 0) ? t1 / (pt[1] * pt[2] * t[key]) : -1;
+				status = "no baseline";
+				if(key in tBase)
+				{	nCompared++;
+					if(t[key] > tBase[key]*(1.+tol)) { status = "FAILED"; nFail++; }
+					else status = "Passed";
+				}
+				printf("%10s %10s %12.2f %10s %12s %12s [%s]\n", cr[1], cr[2], t[key], mem[key],
+					(eff < 0 ? "NA" : sprintf("%.3f", eff)), ((key in tBase) ? sprintf("%.2f", tBase[key]) : "NA"), status);
+			}
+			if(nFail > 0) printf("FAILED: %d of %d runs slower than baseline by more than %g%%.\n", nFail, nCompared, tol*100) > "summary";
+			else if(nCompared) printf("Passed: %d runs within %g%% of baseline.\n", nCompared, tol*100) > "summary";
+			else printf("Done: %d runs timed (no baseline).\n", n) > "summary";
+		}
+	' $( [ -f $testSrcDir/perfBaseline ] && echo $testSrcDir/perfBaseline || echo /dev/null ) timings > results
+	#Per-phase breakdown (one column per configuration):
+	awk '
+		{	if(!($1 in iConfig)) { iConfig[$1] = ++nConfigs; configs[nConfigs] = $1 }
+			key = $2 " " $3; if(!(key in seen)) { seen[key] = 1; keys[++nKeys] = key }
+			t[key, $1] = $4;
+		}
+		END {
+			if(!nKeys) exit;
+			printf("\nPer-phase total times [s]:\n%10s %40s", "Run", "Phase");
+			for(j=1; j<=nConfigs; j++) printf(" %10s", configs[j]);
+			printf("\n");
+			for(i=1; i<=nKeys; i++)
+			{	split(keys[i], rp, " ");
+				printf("%10s %40s", rp[1], rp[2]);
+				for(j=1; j<=nConfigs; j++) printf(" %10s", ((keys[i], configs[j]) in t) ? t[keys[i], configs[j]] : "NA");
+				printf("\n");
+			}
+		}
+	' phases >> results
+	exit 0
+fi
+
 #Run JDFTx on all the runs that belong to this test (don't rerun tests which have succeeded)
 source $testSrcDir/sequence.sh
+executable="${executable:-jdftx}"  #optionally set in sequence.sh to run another executable of the build (eg. phonon)
 if [[ "$JDFTX_LAUNCH" == *'%d'* ]]; then
 	LAUNCH="$(printf "$JDFTX_LAUNCH" "$nProcs")"
 else
@@ -22,7 +124,7 @@ fi
 echo "launch=\"$LAUNCH\""
 for run in $runs; do
 	if [[ ! ( ( -f $run.out ) && ( "$(awk '/End date and time:/ {endLine=NR+1} NR==endLine {print}' $run.out)" == "Done!" ) ) ]]; then
-		$LAUNCH $jdftxBuildDir/jdftx$JDFTX_SUFFIX -i $testSrcDir/$run.in -d -o $run.out
+		$LAUNCH $jdftxBuildDir/$executable$JDFTX_SUFFIX -i $testSrcDir/$run.in -d -o $run.out
 		if [ "$?" -ne "0" ]; then
 			echo "" > results
 			echo "FAILED: error running $run" > summary
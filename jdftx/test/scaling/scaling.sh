@@ -0,0 +1,181 @@
+#!/bin/bash
+#Scaling harness: time synthetic bulk systems over MPI process / thread / GPU layouts (see test/README)
+
+testsuiteSrcDir="$1"
+testsuiteRunDir="$2"
+jdftxBuildDir="$3"
+mode="$4"  #optional: "results" to print results of the previous run
+
+scalingDir="$testsuiteRunDir/scaling"
+if [ "$mode" == "results" ]; then
+	cat $scalingDir/results
+	exit 0
+fi
+
+#Each system is a comma-separated list of key=value pairs, with keys (and defaults):
+#   cells=1x1x1 (replicas of the 8-atom Si cubic cell), kpoints=1x1x1, bands=0 (0 => automatic),
+#   fluid=no (LinearPCM water in a 20 bohr gap between slabs), exx=no (HSE06 hybrid functional)
+systems="${JDFTX_SCALING_SYSTEMS:-cells=1x1x1,kpoints=4x4x4 cells=2x2x2,kpoints=2x2x2 cells=2x2x1,kpoints=2x2x1,fluid=yes cells=1x1x1,kpoints=2x2x2,exx=yes}"
+configs="${JDFTX_SCALING_CONFIGS:-1x1 2x1 4x1 1x2 1x4 2x2}"  #list of <nProcs>x<nThreads>, with suffix g for GPU runs
+scalingModes="${JDFTX_SCALING_MODES:-strong weak}"  #strong: fixed system; weak: k-points along first direction scaled by nProcs
+phaseNames="Setup DensityBuild Hamiltonian SubspaceLinalg ExactExchange FFT FluidSolve Dump" #profiled regions in breakdown
+
+mkdir -p $scalingDir
+cd $scalingDir
+rm -f systems timings phases results efficiency.dat
+
+#Write input file $1 for system spec $2 with k-points along first direction multiplied by $3 (and symmetries disabled if $3 > 0):
+function makeInput()
+{	local inFile="$1" spec="$2" kScale="$3"
+	local cells="1x1x1" kpoints="1x1x1" bands="0" fluid="no" exx="no"
+	local kv
+	for kv in ${spec//,/ }; do
+		case "${kv%%=*}" in
+			cells) cells="${kv#*=}" ;;
+			kpoints) kpoints="${kv#*=}" ;;
+			bands) bands="${kv#*=}" ;;
+			fluid) fluid="${kv#*=}" ;;
+			exx) exx="${kv#*=}" ;;
+			*) echo "Unknown key '${kv%%=*}' in scaling system '$spec'"; return 1 ;;
+		esac
+	done
+	local k=( ${kpoints//x/ } )
+	[ "$kScale" -gt "0" ] && k[0]=$(( ${k[0]} * $kScale ))
+	echo "include $testsuiteSrcDir/scaling/common.in" > $inFile
+	#Lattice and atoms of replicated diamond-structure Si (centered slab with vacuum for fluid):
+	awk -v cells="$cells" -v fluid="$fluid" '
+		BEGIN {
+			a = 10.26; split(cells, n, "x");
+			L[1] = a*n[1]; L[2] = a*n[2]; L[3] = a*n[3] + (fluid=="yes" ? 20. : 0.);
+			z0 = (fluid=="yes" ? -0.5*a*n[3]/L[3] : 0.);
+			printf("lattice \\\n %.6f 0 0 \\\n 0 %.6f 0 \\\n 0 0 %.6f\n", L[1], L[2], L[3]);
+			split("0 0 0  0 0.5 0.5  0.5 0 0.5  0.5 0.5 0", basis, " ");
+			for(i=0; i<n[1]; i++) for(j=0; j<n[2]; j++) for(l=0; l<n[3]; l++)
+				for(b=0; b<4; b++) for(s=0; s<2; s++)
+				{	x = (i + basis[3*b+1] + 0.25*s) / n[1];
+					y = (j + basis[3*b+2] + 0.25*s) / n[2];
+					z = z0 + (l + basis[3*b+3] + 0.25*s)*a/L[3];
+					printf("ion Si %.6f %.6f %.6f 1\n", x, y, z);
+				}
+		}' >> $inFile
+	echo "kpoint-folding ${k[0]} ${k[1]} ${k[2]}" >> $inFile
+	[ "$kScale" -gt "0" ] && echo "symmetries none" >> $inFile
+	[ "$bands" -gt "0" ] && echo "elec-n-bands $bands" >> $inFile
+	[ "$exx" == "yes" ] && echo "elec-ex-corr hyb-HSE06" >> $inFile || echo "elec-ex-corr gga-PBE" >> $inFile
+	if [ "$fluid" == "yes" ]; then
+		echo "coulomb-interaction Slab 001" >> $inFile
+		echo "coulomb-truncation-embed 0 0 0" >> $inFile
+		echo "fluid LinearPCM" >> $inFile
+		echo "fluid-solvent H2O" >> $inFile
+	fi
+	return 0
+}
+
+iSystem=0
+for spec in $systems; do
+	iSystem=$(( $iSystem + 1 ))
+	sysName="sys$iSystem"
+	echo "$sysName $spec" >> systems
+	for scalingMode in $scalingModes; do
+		for config in $configs; do
+			#Parse layout:
+			gpu="no"; suffix="$JDFTX_SUFFIX"
+			if [[ "$config" == *g ]]; then
+				gpu="yes"; suffix="_gpu"
+			fi
+			layout="${config%g}"
+			nProcs="${layout%x*}"
+			nThreads="${layout#*x}"
+			if [[ "$JDFTX_LAUNCH" == *'%d'* ]]; then
+				LAUNCH="$(printf "$JDFTX_LAUNCH" "$nProcs")"
+			elif [ "$nProcs" -eq "1" ]; then
+				LAUNCH="$JDFTX_LAUNCH"
+			else
+				echo "Skipping $config: JDFTX_LAUNCH must contain %d for the process count"
+				continue
+			fi
+			#Work relative to strong scaling (k-points scale work linearly, or quadratically with exact exchange):
+			kScale=0; work=1
+			if [ "$scalingMode" == "weak" ]; then
+				kScale=$nProcs; work=$nProcs
+				[[ "$spec" == *exx=yes* ]] && work=$(( $nProcs * $nProcs ))
+			fi
+			#Run:
+			runName="$sysName.$scalingMode.$config"
+			makeInput $runName.in "$spec" $kScale || exit 1
+			echo "profile-output $runName.trace" >> $runName.in
+			echo "Running $runName ($spec)"
+			$LAUNCH $jdftxBuildDir/jdftx$suffix -i $runName.in -c $nThreads -d -o $runName.out
+			if [ "$?" -ne "0" ]; then
+				echo "FAILED: error running $runName"
+				exit 1
+			fi
+			#Wall time from end-of-run duration:
+			awk -v run="$sysName $scalingMode $config $nProcs $nThreads $gpu $work" '
+				/End date and time:/ {
+					split($NF, dhms, /[-:)]/);
+					wallTime = ((dhms[1]*24 + dhms[2])*60 + dhms[3])*60 + dhms[4];
+				}
+				END { printf("%s %.2f\n", run, wallTime) }
+			' $runName.out >> timings
+			#Per-subsystem times from the profiler call tree (all occurrences of each region, summed over threads):
+			#(fields are "PROFILE-TREE: <name> <time> s <nCalls> calls", optionally followed by bytes and energies)
+			awk -v run="$sysName $scalingMode $config" -v phaseNames="$phaseNames" '
+				BEGIN { nPhases = split(phaseNames, names, " "); for(i=1; i<=nPhases; i++) isPhase[names[i]] = 1 }
+				/^PROFILE-TREE: / && $6=="calls" && ($2 in isPhase) { t[$2] += $3 }
+				END { for(i=1; i<=nPhases; i++) if(names[i] in t) printf("%s %s %.3f\n", run, names[i], t[names[i]]) }
+			' $runName.out >> phases
+		done
+	done
+done
+touch timings phases
+
+#Speedup and parallel efficiency, relative to the first CPU (or GPU) layout of each system and mode:
+#(resources are cores = nProcs*nThreads for CPU runs, and GPUs = nProcs for GPU runs)
+awk '
+	FILENAME==ARGV[1] { spec[$1] = $2; next }
+	{	sys = $1; scalingMode = $2; config = $3; nProcs = $4; nThreads = $5; gpu = $6; work = $7; t = $8;
+		res = (gpu=="yes" ? nProcs : nProcs*nThreads);
+		group = sys " " scalingMode " " gpu;
+		if(!(group in tRef)) { tRef[group] = t; resRef[group] = res; workRef[group] = work; groups[++nGroups] = group }
+		eff = (t > 0) ? (tRef[group]*resRef[group]/workRef[group]) / (t*res/work) : 0;
+		speedup = (t > 0) ? (tRef[group]/workRef[group]) / (t/work) : 0;
+		line[group] = line[group] sprintf("%10s %6d %8d %5s %10d %12.2f %9.2f %10.3f  %s\n",
+			config, nProcs, nThreads, gpu, res, t, speedup, eff, substr("##################################################", 1, int(50*eff+0.5)));
+		printf("%s %s %s %d %.4f %.4f\n", sys, scalingMode, gpu, res, speedup, eff) > "efficiency.dat";
+	}
+	END {
+		for(i=1; i<=nGroups; i++)
+		{	split(groups[i], g, " ");
+			printf("\n%s (%s, %s scaling%s):\n", g[1], spec[g[1]], g[2], (g[3]=="yes" ? ", GPU" : ""));
+			printf("%10s %6s %8s %5s %10s %12s %9s %10s  Efficiency curve\n", "Config", "nProcs", "nThreads", "GPU", "Resources", "WallTime[s]", "Speedup", "Efficiency");
+			printf("%s", line[groups[i]]);
+		}
+	}
+' systems timings > results
+
+#Per-subsystem breakdown (one column per layout):
+awk -v configs="$configs" -v phaseNames="$phaseNames" '
+	{ t[$1 " " $2, $3, $4] = $5; if(!(($1 " " $2) in seen)) { seen[$1 " " $2] = 1; runs[++nRuns] = $1 " " $2 } }
+	END {
+		nConfigs = split(configs, c, " "); nPhases = split(phaseNames, p, " ");
+		for(r=1; r<=nRuns; r++)
+		{	printf("\nPer-subsystem total times [s] for %s (inclusive, summed over threads):\n%16s", runs[r], "Subsystem");
+			for(j=1; j<=nConfigs; j++) printf(" %10s", c[j]);
+			printf("\n");
+			for(i=1; i<=nPhases; i++)
+			{	found = 0;
+				for(j=1; j<=nConfigs; j++) if((runs[r], c[j], p[i]) in t) found = 1;
+				if(!found) continue;
+				printf("%16s", p[i]);
+				for(j=1; j<=nConfigs; j++) printf(" %10s", ((runs[r], c[j], p[i]) in t) ? t[runs[r], c[j], p[i]] : "NA");
+				printf("\n");
+			}
+		}
+	}
+' phases >> results
+
+cat results
+echo
+echo "Efficiency data (system mode gpu resources speedup efficiency) in $scalingDir/efficiency.dat"
+exit 0
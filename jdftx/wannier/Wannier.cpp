@@ -23,10 +23,10 @@ along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
 
 Wannier::Wannier() : needAtomicOrbitals(false), localizationMeasure(LM_FiniteDifference), precond(false),
 	bStart(0), outerWindow(false), innerWindow(false), nFrozen(0),
-	saveWfns(false), saveWfnsRealSpace(false), saveMomenta(false), saveSpin(false),
+	saveWfns(false), saveWfnsRealSpace(false), saveMomenta(false), saveSpin(false), sparseThreshold(0.), blockThreshold(0.), dosBinWidth(0.),
 	zFieldMag(0.),
 	z0(0.), zH(0.), zSigma(0.),
-	loadRotations(false), numericalOrbitalsOffset(0.5,0.5,0.5), rSmooth(1.),
+	loadRotations(false), loadOverlaps(false), symmetricOverlaps(false), numericalOrbitalsOffset(0.5,0.5,0.5), rSmooth(1.), defectKblock(0), transformCacheSize(0.),
 	spinMode(SpinAll), polar(false)
 {
 }
@@ -73,6 +73,9 @@ public:
 	bool saveWfnsRealSpace; //!< whether to output Wannier functions band-by-band in real-space
 	bool saveMomenta; //!< whether to output momentum matrix elements
 	bool saveSpin; //!< whether to output spin matrix elements (non-collinear only)
+	double sparseThreshold; //!< if non-zero, also output the Hamiltonian truncated to elements above this magnitude in sparse form
+	double blockThreshold; //!< if non-zero, output Wannierized matrices block-sparse, retaining only cells (or cell pairs) with an element above this magnitude
+	vector3<int> dosMesh; double dosBinWidth; //!< dense k-mesh and energy bin width for Wannier-interpolated DOS output (none if mesh is zero)
 	
 	string zVfilename; //!< filename for reading Vscloc with an applied electric field for z matrix element output
 	double zFieldMag; //!< magnitude of electric field difference (Eh/a0) between current calculation and the specified Vscloc
@@ -80,6 +83,8 @@ public:
 	double z0, zH, zSigma; //!< center (lattice coords), half-width (lattice coords) and smoothness (bohrs) for slab-weight function
 
 	bool loadRotations; //!< whether to load initial rotations from previous dump
+	bool loadOverlaps; //!< whether to reuse overlap (mlwfM0) and trial projection (mlwfA) matrices from a previous dump, when compatible
+	bool symmetricOverlaps; //!< whether to compute overlaps only for symmetry-inequivalent edges and reconstruct the rest
 	string initFilename, dumpFilename; //!< filename patterns for input and output
 	string eigsFilename; //!< optional override for eigenvals file
 	
@@ -88,6 +93,8 @@ public:
 	
 	vector3<int> phononSup; //!< phonon supercell (process e-ph matrix elements on this supercell if non-zero)
 	double rSmooth; //!< supercell boundary width over which matrix elements are smoothed
+	int defectKblock; //!< if positive, number of commensurate k-points per process whose wavefunctions are held at a time for defect matrix elements
+	double transformCacheSize; //!< if positive, create wavefunction transforms on demand and cache at most this size in MB (else pre-compute all)
 	
 	enum SpinMode
 	{	SpinUp,
@@ -151,6 +151,10 @@ matrix WannierMinimizer::fixUnitary(const matrix& U, bool* isSingular)
 {	return U * invsqrt(dagger(U) * U, 0, 0, isSingular);
 }
 
+std::vector<matrix> WannierMinimizer::fixUnitary(const std::vector<matrix>& U, bool* isSingular)
+{	return multiply(U, invsqrt(multiply(U, U, CblasConjTrans), 0, 0, isSingular));
+}
+
 bool WannierMinimizer::report(int iter)
 {	//Check unitarity:
 	bool needRestart = false;
@@ -164,12 +168,25 @@ bool WannierMinimizer::report(int iter)
 	mpiWorld->allReduce(needRestart, MPIUtil::ReduceLOr);
 	if(needRestart)
 	{	logPrintf("%s\tUpdating rotations to enforce unitarity\n", wannier.minParams.linePrefix);
+		//Orthogonalize all local rotations together (batched):
+		std::vector<matrix> U1(ikStop-ikStart), U2(ikStop-ikStart);
+		for(size_t ik=ikStart; ik<ikStop; ik++)
+		{	U1[ik-ikStart] = kMesh[ik].U1;
+			U2[ik-ikStart] = kMesh[ik].U2;
+		}
+		bool isSingular1 = false, isSingular2 = false;
+		U1 = fixUnitary(U1, &isSingular1);
+		U2 = fixUnitary(U2, &isSingular2);
 		ostringstream ossErr;
 		for(size_t ik=ikStart; ik<ikStop; ik++)
 		{	KmeshEntry& ki = kMesh[ik];
 			bool isSingular = false;
-			ki.U1 = fixUnitary(ki.U1, &isSingular);
-			ki.U2 = fixUnitary(ki.U2, &isSingular);
+			if(isSingular1 or isSingular2) //identify the singular k-point(s)
+			{	fixUnitary(ki.U1, &isSingular);
+				fixUnitary(ki.U2, &isSingular);
+			}
+			ki.U1 = U1[ik-ikStart];
+			ki.U2 = U2[ik-ikStart];
 			if(isSingular)
 			{	ossErr << "Unitary rotations are singular at k = [ "
 					<< ki.point.k[0] << ' ' << ki.point.k[1] << ' ' << ki.point.k[2] << " ]\n";
@@ -207,6 +224,20 @@ bool WannierMinimizer::Kpoint::operator==(const WannierMinimizer::Kpoint& other)
 	return true;
 }
 
+std::shared_ptr<ColumnBundleTransform> WannierMinimizer::getTransform(const WannierMinimizer::Kpoint& kpoint, bool super) const
+{	const auto& tMap = super ? transformMapSuper : transformMap;
+	auto iter = tMap.find(kpoint);
+	if(iter != tMap.end()) return iter->second;
+	//Create / retrieve from budgeted cache (only reached when transforms are not pre-computed):
+	assert(wannier.transformCacheSize > 0.);
+	const Basis& basisC = e.basis[kpoint.iReduced];
+	const vector3<>& kC = e.eInfo.qnums[kpoint.iReduced].k;
+	if(super)
+		return transformCache.get(kC, basisC, qnumSuper.k, *basisSuperWrapper, nSpinor, sym[kpoint.iSym], kpoint.invert, e.coulombParams.supercell->super);
+	else
+		return transformCache.get(kC, basisC, kpoint.k, *basisWrapper, nSpinor, sym[kpoint.iSym], kpoint.invert);
+}
+
 ColumnBundle WannierMinimizer::getWfns(const WannierMinimizer::Kpoint& kpoint, int iSpin, std::vector<matrix>* VdagResult) const
 {	ColumnBundle ret(nBands, basis.nbasis*nSpinor, &basis, &kpoint, isGpuEnabled());
 	ret.zero();
@@ -216,7 +247,8 @@ ColumnBundle WannierMinimizer::getWfns(const WannierMinimizer::Kpoint& kpoint, i
 
 #define axpyWfns_COMMON(result) \
 	/* Pick transform: */ \
-	const ColumnBundleTransform& transform = *(((result.basis==&basisSuper) ? transformMapSuper : transformMap).find(kpoint)->second); \
+	std::shared_ptr<ColumnBundleTransform> transformPtr = getTransform(kpoint, result.basis==&basisSuper); \
+	const ColumnBundleTransform& transform = *transformPtr; \
 	/* Pick source ColumnBundle: */ \
 	int q = kpoint.iReduced + iSpin*qCount; \
 	const ColumnBundle* C = e.eInfo.isMine(q) ? &e.eVars.C[q] : &Cother[q]; \
@@ -388,20 +420,25 @@ matrix WannierMinimizer::overlap(const ColumnBundle& C1, const ColumnBundle& C2,
 
 void WannierMinimizer::dumpWannierized(const matrix& Htilde, const matrix& phase, string varName, bool realPartOnly, int iSpin) const
 {
-	string fname = wannier.getFilename(Wannier::FilenameDump, varName, &iSpin);
-	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
-	FILE* fp = 0;
-	if(mpiWorld->isHead())
-	{	fp = fopen(fname.c_str(), "w");
-		if(!fp) die_alone("could not open file for writing.\n");
+	int nCells = phase.nCols();
+	bool sparse = wannier.blockThreshold;
+	FILE* fp = 0, *fpIndex = 0;
+	if(sparse) openSparseBlocks(varName, iSpin, nCells, Htilde.nRows(), fp, fpIndex);
+	else
+	{	string fname = wannier.getFilename(Wannier::FilenameDump, varName, &iSpin);
+		logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+		if(mpiWorld->isHead())
+		{	fp = fopen(fname.c_str(), "w");
+			if(!fp) die_alone("could not open file for writing.\n");
+		}
 	}
 	//Determine block size:
-	int nCells = phase.nCols();
 	int blockSize = ceildiv(nCells, mpiWorld->nProcesses()); //so that memory before and after FT roughly similar
 	int nBlocks = ceildiv(nCells, blockSize);
 	//Loop over blocks:
 	int iCellStart = 0;
 	double nrm2totSq = 0., nrm2imSq = 0.;
+	size_t nKept = 0;
 	for(int iBlock=0; iBlock<nBlocks; iBlock++)
 	{	int iCellStop = std::min(iCellStart+blockSize, nCells);
 		matrix Hblock = Htilde * phase(0,phase.nRows(), iCellStart,iCellStop);
@@ -411,18 +448,106 @@ void WannierMinimizer::dumpWannierized(const matrix& Htilde, const matrix& phase
 			if(realPartOnly)
 			{	nrm2totSq += std::pow(nrm2(Hblock), 2); 
 				nrm2imSq += std::pow(callPref(eblas_dnrm2)(Hblock.nData(), ((double*)Hblock.dataPref())+1, 2), 2); //imaginary parts with a stride of 2
-				Hblock.write_real(fp);
 			}
+			if(sparse) nKept += writeSparseBlocks(Hblock, realPartOnly, fp, fpIndex, "", iCellStart);
+			else if(realPartOnly) Hblock.write_real(fp);
 			else Hblock.write(fp);
 		}
 		iCellStart = iCellStop;
 	}
-	if(mpiWorld->isHead()) fclose(fp);
+	if(mpiWorld->isHead())
+	{	fclose(fp);
+		if(fpIndex) fclose(fpIndex);
+	}
+	logPrintf("done.");
+	if(sparse)
+	{	mpiWorld->bcast(nKept);
+		logPrintf(" Retained %lu of %d cells.", nKept, nCells);
+	}
 	if(realPartOnly)
 	{	mpiWorld->bcast(nrm2totSq);
 		mpiWorld->bcast(nrm2imSq);
-		logPrintf("done. Relative discarded imaginary part: %le\n", sqrt(nrm2imSq / nrm2totSq));
+		logPrintf(" Relative discarded imaginary part: %le", sqrt(nrm2imSq / nrm2totSq));
 	}
-	else
-		logPrintf("done.\n");
+	logPrintf("\n");
+}
+
+void WannierMinimizer::openSparseBlocks(string varName, int iSpin, int nBlocks, int blockSize, FILE*& fp, FILE*& fpIndex) const
+{	string fname = wannier.getFilename(Wannier::FilenameDump, varName+"Blocks", &iSpin);
+	string fnameIndex = wannier.getFilename(Wannier::FilenameDump, varName+"BlockIndex", &iSpin);
+	logPrintf("Dumping '%s' and '%s' ... ", fname.c_str(), fnameIndex.c_str()); logFlush();
+	fp = 0; fpIndex = 0;
+	if(mpiWorld->isHead())
+	{	fp = fopen(fname.c_str(), "w");
+		if(!fp) die_alone("could not open file for writing.\n");
+		fpIndex = fopen(fnameIndex.c_str(), "w");
+		if(!fpIndex) die_alone("could not open file for writing.\n");
+		fprintf(fpIndex, "#Block-sparse %s: blocks of %s with an element of magnitude > %lg, in the order present in %sBlocks\n",
+			varName.c_str(), varName.c_str(), wannier.blockThreshold, varName.c_str());
+		fprintf(fpIndex, "#nBlocksTotal blockSize\n%d %d\n", nBlocks, blockSize);
+		fprintf(fpIndex, "#Dense block index of each retained block, one per line:\n");
+	}
+}
+
+size_t WannierMinimizer::writeSparseBlocks(const matrix& M, bool realPartOnly, FILE* fp, FILE* fpIndex, string indexPrefix, int iColStart) const
+{	size_t nKept = 0;
+	for(int iCol=0; iCol<M.nCols(); iCol++)
+	{	const complex* Mdata = M.data() + M.index(0,iCol);
+		double Mmax = 0.;
+		for(int iRow=0; iRow<M.nRows(); iRow++)
+			Mmax = std::max(Mmax, realPartOnly ? fabs(Mdata[iRow].real()) : Mdata[iRow].abs());
+		if(Mmax > wannier.blockThreshold)
+		{	matrix Mcol = M(0,M.nRows(), iCol,iCol+1);
+			if(realPartOnly) Mcol.write_real(fp);
+			else Mcol.write(fp);
+			fprintf(fpIndex, "%s%d\n", indexPrefix.c_str(), iColStart+iCol);
+			nKept++;
+		}
+	}
+	return nKept;
+}
+
+void WannierMinimizer::dumpWannierizedSparse(const matrix& Htilde, const matrix& phase, string varName, double threshold, int iSpin) const
+{
+	string fname = wannier.getFilename(Wannier::FilenameDump, varName, &iSpin);
+	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+	FILE* fp = 0;
+	if(mpiWorld->isHead())
+	{	fp = fopen(fname.c_str(), "w");
+		if(!fp) die_alone("could not open file for writing.\n");
+		fprintf(fp, "#iCell iCenter jCenter Re Im  (elements with magnitude > %lg)\n", threshold);
+	}
+	//Loop over blocks of cells (as in dumpWannierized):
+	int nCells = phase.nCols();
+	int nCenterPairs = Htilde.nRows(); //nCenters^2
+	int blockSize = ceildiv(nCells, mpiWorld->nProcesses());
+	int nBlocks = ceildiv(nCells, blockSize);
+	int iCellStart = 0;
+	size_t nKept = 0;
+	std::vector<size_t> nKeptCenter(nCenters, 0); //number of retained (cell, partner) pairs per center
+	for(int iBlock=0; iBlock<nBlocks; iBlock++)
+	{	int iCellStop = std::min(iCellStart+blockSize, nCells);
+		matrix Hblock = Htilde * phase(0,phase.nRows(), iCellStart,iCellStop);
+		mpiWorld->reduceData(Hblock, MPIUtil::ReduceSum);
+		if(mpiWorld->isHead())
+		{	const complex* Hdata = Hblock.data();
+			for(int iCell=iCellStart; iCell<iCellStop; iCell++)
+				for(int jCenter=0; jCenter<nCenters; jCenter++)
+					for(int iCenter=0; iCenter<nCenters; iCenter++)
+					{	const complex& H = Hdata[Hblock.index(iCenter+nCenters*jCenter, iCell-iCellStart)];
+						if(H.abs() > threshold)
+						{	fprintf(fp, "%d %d %d %+.15le %+.15le\n", iCell, iCenter, jCenter, H.real(), H.imag());
+							nKept++;
+							nKeptCenter[iCenter]++;
+						}
+					}
+		}
+		iCellStart = iCellStop;
+	}
+	if(mpiWorld->isHead()) fclose(fp);
+	mpiWorld->bcast(nKept);
+	mpiWorld->bcastData(nKeptCenter);
+	size_t nKeptMax = *std::max_element(nKeptCenter.begin(), nKeptCenter.end());
+	logPrintf("done. Retained %lu of %lu elements (fill fraction %.3le); at most %lu per center.\n",
+		nKept, size_t(nCenterPairs)*nCells, nKept/(double(nCenterPairs)*nCells), nKeptMax);
 }
@@ -131,6 +131,8 @@ protected:
 	std::set<Kpoint> kpoints; //!< list of all k-points that will be in use (including those in FD formulae)
 	std::shared_ptr<ColumnBundleTransform::BasisWrapper> basisWrapper, basisSuperWrapper; //!< look-up tables for initializing transforms
 	std::map<Kpoint, std::shared_ptr<ColumnBundleTransform> > transformMap, transformMapSuper; //!< wave-function transforms for each k-point to the common bases
+	mutable ColumnBundleTransformCache transformCache; //!< transforms created on demand instead, when limited by wannier.transformCacheSize
+	std::shared_ptr<ColumnBundleTransform> getTransform(const Kpoint& kpoint, bool super) const; //!< transform for kpoint to the common (or supercell if super) basis, created on demand if not pre-computed
 	Basis basis; //!< common basis (with indexing into full G-space)
 	
 	//k-mesh MPI division:
@@ -172,12 +174,29 @@ private:
 	//! If isSingular is provided, function will set it to true and return rather than stack-tracing in singular cases.
 	static matrix fixUnitary(const matrix& U, bool* isSingular=0); 
 	
+	//! Batched version of fixUnitary() for several matrices at once (null entries skipped)
+	static std::vector<matrix> fixUnitary(const std::vector<matrix>& U, bool* isSingular=0);
+	
 	//! Load / compute rotations for a given spin channel (used by saveMLWF)
 	void initRotations(int iSpin);
 	
+	//! Projections of Bloch functions on trial orbitals at each k-point of this process (others empty),
+	//! read from a compatible mlwfA dump if wannier.loadOverlaps, and computed and dumped otherwise
+	std::vector<matrix> getTrialProjections(int iSpin);
+	
 	//! Wannierize and dump a Bloch-space matrix to file, optionally zeroing out the real parts
 	void dumpWannierized(const matrix& Htilde, const matrix& phase, string varName, bool realPartOnly, int iSpin) const;
 	
+	//! Wannierize a Bloch-space matrix and dump elements above threshold in magnitude to a sparse text file
+	void dumpWannierizedSparse(const matrix& Htilde, const matrix& phase, string varName, double threshold, int iSpin) const;
+	
+	//! Open the data and index files of a block-sparse dump of varName (on head process only) with nBlocks blocks of blockSize elements each
+	void openSparseBlocks(string varName, int iSpin, int nBlocks, int blockSize, FILE*& fp, FILE*& fpIndex) const;
+	
+	//! Write columns of M (one block per cell or cell pair) with an element above wannier.blockThreshold in magnitude to fp,
+	//! and their labels (indexPrefix followed by iColStart + column index) to fpIndex; return number of retained blocks
+	size_t writeSparseBlocks(const matrix& M, bool realPartOnly, FILE* fp, FILE* fpIndex, string indexPrefix, int iColStart) const;
+	
 	//---- Shared variables and subroutines implementing various Wannier outputs within saveMLWF() ----
 	bool realPartOnly; //whether outputs should have only real part
 	std::vector<vector3<>> xExpect; //converged wannier centers in lattice coordinates
@@ -185,6 +204,7 @@ private:
 	std::vector<matrix> DblochMesh; //gradient matix elements in Bloch basis
 	void saveMLWF_C(int iSpin); //Wavefunctions
 	void saveMLWF_H(int iSpin, const matrix& phase); //Hamiltonian
+	void saveMLWF_DOS(int iSpin, const matrix& HwannierTilde, const matrix& phase); //Wannier-interpolated DOS and band velocities on a dense k-mesh
 	void saveMLWF_P(int iSpin, const matrix& phase); //Momenta
 	void saveMLWF_D(int iSpin, const matrix& phase); //Gradient
 	void saveMLWF_S(int iSpin, const matrix& phase); //Spins
@@ -168,6 +168,8 @@ WannierMinimizerFD::WannierMinimizerFD(const Everything& e, const Wannier& wanni
 		{	Edge& edge = edges[i][j];
 			edge.wb = wb[j];
 			edge.b = b[j];
+			edge.iSource = -1; //computed directly unless found equivalent below
+			edge.direct = true;
 			//Find neighbour:
 			vector3<> kj = kMesh[i].point.k + inv(e.gInfo.GT) * b[j];
 			edge.ik = plook.find(kj);
@@ -182,6 +184,9 @@ WannierMinimizerFD::WannierMinimizerFD(const Everything& e, const Wannier& wanni
 		}
 	}
 	
+	if(wannier.symmetricOverlaps)
+		findSymmetricEdges(plook);
+	
 	//Create MPI communicators for rotations:
 	for(size_t i=0; i<kMesh.size(); i++)
 		if(ranksNeeded[i].size() //some communication is needed
@@ -215,15 +220,112 @@ WannierMinimizerFD::WannierMinimizerFD(const Everything& e, const Wannier& wanni
 	}
 }
 
+void WannierMinimizerFD::findSymmetricEdges(const PeriodicLookup<WannierMinimizer::KmeshEntry>& plook)
+{	if(nSpinor > 1)
+	{	logPrintf("Ignoring symmetricOverlaps: not supported for spinorial wavefunctions.\n");
+		return;
+	}
+	for(const auto& sp: e.iInfo.species)
+		if(sp->isUltrasoft())
+		{	logPrintf("Ignoring symmetricOverlaps: not supported with ultrasoft pseudopotentials.\n");
+			return;
+		}
+	std::vector<vector3<>> bLat; //neighbour displacements in reciprocal lattice coordinates
+	for(const Edge& edge: edges[0])
+		bLat.push_back(inv(e.gInfo.GT) * edge.b);
+	size_t nSource = 0, nImages = 0;
+	for(size_t i=0; i<kMesh.size(); i++)
+		for(size_t j=0; j<edges[i].size(); j++)
+		{	const Edge& edge = edges[i][j];
+			if(edge.iSource >= 0) continue; //already reconstructed from another edge
+			nSource++;
+			for(const SpaceGroupOp& h: sym)
+			{	//Find image of edge (or of its reverse, since only one of each +/-b is in the FD formula):
+				vector3<> kImage = kMesh[i].point.k * h.rot;
+				vector3<> bImage = bLat[j] * h.rot;
+				int jImage = -1; bool reverse = false;
+				for(size_t j2=0; j2<bLat.size(); j2++)
+				{	if((bImage - bLat[j2]).length_squared() < symmThresholdSq) { jImage = j2; break; }
+					if((bImage + bLat[j2]).length_squared() < symmThresholdSq) { jImage = j2; reverse = true; break; }
+				}
+				if(jImage < 0) continue; //FD formula not symmetric under h
+				size_t iImage = plook.find(reverse ? kImage+bImage : kImage);
+				if(iImage == string::npos) continue; //k-mesh not symmetric under h
+				Edge& image = edges[iImage][jImage];
+				if(iImage<i || (iImage==i && jImage<=int(j)) || image.iSource>=0) continue; //already a source or image
+				//Representations relating the end points:
+				const Kpoint& image1 = reverse ? image.point : kMesh[iImage].point;
+				const Kpoint& image2 = reverse ? kMesh[iImage].point : image.point;
+				int iRep1 = getBandRep(kMesh[i].point, image1, h);
+				int iRep2 = getBandRep(edge.point, image2, h);
+				if(iRep1<0 || iRep2<0) continue;
+				image.iSource = i;
+				image.jSource = j;
+				image.iRep1 = iRep1;
+				image.iRep2 = iRep2;
+				image.phase = cis(2*M_PI*dot(bLat[j], h.a));
+				image.reverse = reverse;
+				nImages++;
+			}
+		}
+	logPrintf("Symmetry relates %lu edges to %lu computed ones, using %lu band-space representations.\n",
+		nImages, nSource, bandReps.size());
+}
+
+int WannierMinimizerFD::getBandRep(const Kpoint& src, const Kpoint& image, const SpaceGroupOp& h)
+{	if(src.iReduced != image.iReduced) return -1;
+	//Image wavefunctions are Omega_h Omega_src Omega_rep C_q, where each Omega is a space group operation
+	//(acting as psi(r) -> psi(op r)) with optional time reversal; solve for the one acting on C_q:
+	BandRep rep;
+	rep.iReduced = src.iReduced;
+	rep.op = sym[image.iSym] * (sym[src.iSym] * h).inv();
+	rep.invert = src.invert * image.invert;
+	for(size_t iRep=0; iRep<bandReps.size(); iRep++)
+	{	const BandRep& prev = bandReps[iRep];
+		if(prev.iReduced==rep.iReduced && prev.invert==rep.invert && prev.op.rot==rep.op.rot
+			&& (prev.op.a-rep.op.a).length_squared() < symmThresholdSq)
+			return iRep;
+	}
+	bandReps.push_back(rep);
+	return bandReps.size()-1;
+}
+
+std::vector<matrix> WannierMinimizerFD::getBandReps(int iSpin) const
+{	std::vector<matrix> D(bandReps.size());
+	for(size_t iRep=0; iRep<bandReps.size(); iRep++)
+	{	const BandRep& rep = bandReps[iRep];
+		int q = rep.iReduced + iSpin*qCount;
+		bool closed = true;
+		if(e.eInfo.isMine(q))
+		{	const vector3<>& kq = e.eInfo.qnums[q].k;
+			ColumnBundle Cq(nBands, basis.nbasis*nSpinor, &basis, &e.eInfo.qnums[q], isGpuEnabled());
+			ColumnBundle OmegaCq(nBands, basis.nbasis*nSpinor, &basis, &e.eInfo.qnums[q], isGpuEnabled());
+			Cq.zero(); OmegaCq.zero();
+			ColumnBundleTransform(kq, e.basis[q], kq, *basisWrapper, nSpinor, SpaceGroupOp(), +1).scatterAxpy(1., e.eVars.C[q], Cq,0,1);
+			ColumnBundleTransform(kq, e.basis[q], kq, *basisWrapper, nSpinor, rep.op, rep.invert).scatterAxpy(1., e.eVars.C[q], OmegaCq,0,1);
+			D[iRep] = overlap(Cq, OmegaCq);
+			//Reconstruction requires the bands to span an invariant subspace (D unitary):
+			closed = (nrm2(dagger(D[iRep]) * D[iRep] - eye(nBands)) < 1e-4*sqrt(nBands));
+		}
+		else D[iRep] = zeroes(nBands, nBands);
+		mpiWorld->bcast(closed, e.eInfo.whose(q));
+		if(closed)
+			mpiWorld->bcastData(D[iRep], e.eInfo.whose(q));
+		else
+			D[iRep] = matrix(); //overlaps depending on this representation will be computed directly
+	}
+	return D;
+}
+
 void WannierMinimizerFD::initialize(int iSpin)
 {
 	//Read overlap matrices, if available:
 	string fname = wannier.getFilename(Wannier::FilenameDump, "mlwfM0", &iSpin);
-	bool M0exists = (fileSize(fname.c_str()) > 0);
+	size_t sizePerK = edges[0].size() * nBands*nBands * sizeof(complex);
+	bool M0exists = (fileSize(fname.c_str()) == off_t(kMesh.size()*sizePerK)); //also checks compatibility of band count and FD formula
 	mpiWorld->bcast(M0exists); //Ensure MPI consistency of file check (avoid occassional NFS errors)
-	if(wannier.loadRotations && M0exists)
+	if((wannier.loadRotations || wannier.loadOverlaps) && M0exists)
 	{	logPrintf("Reading initial overlaps from '%s' ... ", fname.c_str()); logFlush();
-		size_t sizePerK = edges[0].size() * nBands*nBands * sizeof(complex);
 		MPIUtil::File fp;
 		mpiWorld->fopenRead(fp, fname.c_str(), kMesh.size()*sizePerK);
 		mpiWorld->fseek(fp, ikStart*sizePerK, SEEK_SET);
@@ -234,10 +336,33 @@ void WannierMinimizerFD::initialize(int iSpin)
 			}
 		mpiWorld->fclose(fp);
 		logPrintf("done.\n"); logFlush();
+		batchOverlaps();
 		return; //read overlaps successfully rom file, so no need to recalculate below
 	}
 	
 	//Compute the overlap matrices for current spin:
+	//--- unfold each mesh point once while it is a neighbour of nearby points in the loop below
+	size_t nEdgesMax = 0;
+	for(const std::vector<Edge>& edgesK: edges) nEdgesMax = std::max(nEdgesMax, edgesK.size());
+	std::vector<matrix> D;
+	if(bandReps.size())
+	{	//Representations of symmetries in band space, and edges that can be reconstructed with them:
+		D = getBandReps(iSpin);
+		size_t nDirect = 0, nEdges = 0;
+		for(std::vector<Edge>& edgesK: edges)
+			for(Edge& edge: edgesK)
+			{	edge.direct = (edge.iSource < 0) || !D[edge.iRep1] || !D[edge.iRep2];
+				if(edge.direct) nDirect++;
+				nEdges++;
+			}
+		logPrintf("Computing %lu of %lu overlaps directly (remaining reconstructed by symmetry).\n", nDirect, nEdges);
+	}
+	UnfoldedWfnsCache<Kpoint> unfoldedCache(nEdgesMax + 2);
+	auto getUnfolded = [&](const Kpoint& kpoint)
+	{	return unfoldedCache.get(kpoint, [&](UnfoldedWfnsCache<Kpoint>::Entry& entry)
+		{	entry.C = getWfns(kpoint, iSpin, &entry.VdagC);
+		});
+	};
 	for(int jProcess=0; jProcess<mpiWorld->nProcesses(); jProcess++)
 	{	//Send/recv wavefunctions to other processes:
 		Cother.assign(e.eInfo.nStates, ColumnBundle());
@@ -267,15 +392,55 @@ void WannierMinimizerFD::initialize(int iSpin)
 		
 		for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,iSpin))
 		{	KmeshEntry& ke = kMesh[ik];
-			std::vector<matrix> VdagCi, VdagCj;
-			ColumnBundle Ci = getWfns(ke.point, iSpin, &VdagCi); //Bloch functions at ik
+			bool needed = false;
+			for(const Edge& edge: edges[ik])
+				if(edge.direct && whose_q(edge.ik,iSpin)==jProcess)
+					needed = true;
+			if(!needed) continue; //remaining overlaps at this k are reconstructed by symmetry
+			auto Ci = getUnfolded(ke.point); //Bloch functions at ik
 			//Overlap with neighbours:
 			for(Edge& edge: edges[ik])
-				if(whose_q(edge.ik,iSpin)==jProcess)
-					edge.M0 = overlap(Ci, getWfns(edge.point, iSpin, &VdagCj), &VdagCi, &VdagCj);
+				if(edge.direct && whose_q(edge.ik,iSpin)==jProcess)
+				{	auto Cj = getUnfolded(edge.point);
+					edge.M0 = overlap(Ci->C, Cj->C, &Ci->VdagC, &Cj->VdagC);
+				}
 		}
 	}
 	Cother.clear();
+	unfoldedCache.clear();
+	
+	if(bandReps.size())
+	{	//Make directly computed overlaps available on all processes:
+		for(size_t ik=0; ik<edges.size(); ik++)
+			for(Edge& edge: edges[ik]) if(edge.direct)
+			{	if(!isMine_q(ik,iSpin)) edge.M0 = zeroes(nBands, nBands);
+				mpiWorld->bcastData(edge.M0, whose_q(ik,iSpin));
+			}
+		//Reconstruct the rest for local k-points:
+		for(size_t ik=ikStart; ik<ikStop; ik++)
+			for(Edge& edge: edges[ik]) if(!edge.direct)
+			{	const Edge& src = edges[edge.iSource][edge.jSource];
+				//Representations act anti-linearly through time-reversed mesh points:
+				matrix D1 = (kMesh[edge.iSource].point.invert<0) ? conj(D[edge.iRep1]) : D[edge.iRep1];
+				matrix D2 = (src.point.invert<0) ? conj(D[edge.iRep2]) : D[edge.iRep2];
+				edge.M0 = edge.phase * (dagger(D1) * src.M0 * D2);
+				if(edge.reverse) edge.M0 = dagger(edge.M0);
+			}
+		//Dump in parallel (each process writes its k-points) and free overlaps not needed any more:
+		logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+		MPIUtil::File fp; mpiWorld->fopenWrite(fp, fname.c_str());
+		mpiWorld->fseek(fp, ikStart*sizePerK, SEEK_SET);
+		for(size_t ik=ikStart; ik<ikStop; ik++)
+			for(const Edge& edge: edges[ik])
+				mpiWorld->fwriteData(edge.M0, fp);
+		mpiWorld->fclose(fp);
+		for(size_t ik=0; ik<edges.size(); ik++) if(!isMine(ik))
+			for(Edge& edge: edges[ik])
+				edge.M0 = matrix();
+		logPrintf("done.\n"); logFlush();
+		batchOverlaps();
+		return;
+	}
 	
 	//Broadcast and dump the overlap matrices:
 	FILE* fp = 0;
@@ -295,6 +460,34 @@ void WannierMinimizerFD::initialize(int iSpin)
 	{	fclose(fp);
 		logPrintf("done.\n"); logFlush();
 	}
+	batchOverlaps();
+}
+
+void WannierMinimizerFD::batchOverlaps()
+{	M0batch.resize(ikStop-ikStart);
+	for(size_t ik=ikStart; ik<ikStop; ik++)
+	{	matrix& M0cat = M0batch[ik-ikStart];
+		M0cat.init(nBands, nBands*edges[ik].size());
+		int colStart = 0;
+		for(Edge& edge: edges[ik])
+		{	M0cat.set(0,nBands, colStart,colStart+nBands, edge.M0);
+			colStart += nBands;
+			edge.M0 = matrix(); //only the batched version is used below
+		}
+	}
+}
+
+std::vector<matrix> WannierMinimizerFD::getRotatedOverlaps() const
+{	std::vector<matrix> M; M.reserve((ikStop-ikStart)*edges[0].size());
+	for(size_t ik=ikStart; ik<ikStop; ik++)
+	{	matrix UdagM0 = dagger(kMesh[ik].U) * M0batch[ik-ikStart]; //one GEMM for all edges of this k-point
+		int colStart = 0;
+		for(const Edge& edge: edges[ik])
+		{	M.push_back(UdagM0(0,UdagM0.nRows(), colStart,colStart+nBands) * kMesh[edge.ik].U);
+			colStart += nBands;
+		}
+	}
+	return M;
 }
 
 
@@ -304,14 +497,12 @@ double WannierMinimizerFD::getOmega(bool grad)
 	//Compute the expectation values of r and rSq for each center (split over processes)
 	rSqExpect.assign(nCenters, 0.);
 	rExpect.assign(nCenters, vector3<>());
-	std::vector<matrix> Mcache((ikStop-ikStart)*edges[0].size());
-	matrix* McachePtr = Mcache.data();
+	std::vector<matrix> Mcache = getRotatedOverlaps();
+	const matrix* McachePtr = Mcache.data();
 	for(size_t ik=ikStart; ik<ikStop; ik++)
 	{	const KmeshEntry& ki = kMesh[ik];
 		for(const Edge& edge: edges[ik])
-		{	const KmeshEntry& kj = kMesh[edge.ik];
-			matrix& M = *(McachePtr++);
-			M = dagger(ki.U) * edge.M0 * kj.U;
+		{	const matrix& M = *(McachePtr++);
 			const complex* Mdata = M.data();
 			for(int n=0; n<nCenters; n++)
 			{	complex Tnn = cis(dot(rPinned[n], edge.b)); //translation phase to rPinned as origin
@@ -369,11 +560,13 @@ double WannierMinimizerFD::getOmega(bool grad)
 double WannierMinimizerFD::getOmegaI(bool grad)
 {	static StopWatch watch("WannierMinimizerFD::getOmegaI"); watch.start();
 	double OmegaI = 0.;
+	std::vector<matrix> Mcache = getRotatedOverlaps();
+	const matrix* McachePtr = Mcache.data();
 	for(size_t ik=ikStart; ik<ikStop; ik++)
 	{	KmeshEntry& ki = kMesh[ik];
 		for(const Edge& edge: edges[ik])
 		{	KmeshEntry& kj = kMesh[edge.ik];
-			const matrix M = dagger(ki.U) * edge.M0 * kj.U;
+			const matrix& M = *(McachePtr++);
 			const auto Msub = M(0,nCenters, 0,nCenters);
 			OmegaI += ki.point.weight * edge.wb * (nCenters - trace(Msub * dagger(Msub)).real());
 			if(grad)
@@ -42,10 +42,32 @@ public:
 		vector3<> b; //!< displacement to neighbour
 		unsigned ik; //!< index of neighbour in kMesh
 		Kpoint point; //!< description of neighbour (source state, rotation, translation etc.)
-		matrix M0; //!< initial overlap matrix for this pair
+		matrix M0; //!< initial overlap matrix for this pair (freed after initialize in favour of M0batch)
+		//Reconstruction from a symmetry-equivalent edge (symmetricOverlaps mode):
+		int iSource, jSource; //!< kMesh and edge index of the equivalent edge whose overlap is transformed (iSource = -1 if none)
+		int iRep1, iRep2; //!< band-space representations (in bandReps) relating the source end points to this edge's end points
+		complex phase; //!< translation phase of the symmetry operation
+		bool reverse; //!< whether the operation maps the source edge to the reverse of this edge (overlap is then the adjoint)
+		bool direct; //!< whether M0 is computed directly for the current spin
 	};
 	std::vector< std::vector<Edge> > edges; //!< set of all edges
+	std::vector<matrix> M0batch; //!< initial overlaps of all edges of each local k-point, concatenated by column (nBands x nEdges*nBands)
 	matrix kHelmholtzInv; //!< inverse Helmholtz preconditioner
+
+private:
+	//! Band-space representation D = C^OmegaC of a symmetry operation Omega (op with optional time reversal) that maps reduced k-point iReduced to itself
+	struct BandRep
+	{	int iReduced; //!< reduced k-point
+		SpaceGroupOp op; //!< space group operation (including exact lattice translation)
+		int invert; //!< -1 if combined with time reversal, +1 otherwise
+	};
+	std::vector<BandRep> bandReps; //!< representations needed to reconstruct symmetry-equivalent edges
+	
+	void findSymmetricEdges(const PeriodicLookup<KmeshEntry>& plook); //!< set source and representations of edges equivalent under unitary symmetries
+	int getBandRep(const Kpoint& src, const Kpoint& image, const SpaceGroupOp& h); //!< index in bandReps relating src mapped by h to image (-1 if not from the same reduced k-point)
+	std::vector<matrix> getBandReps(int iSpin) const; //!< compute bandReps for current spin (null where the bands do not span a closed subspace)
+	void batchOverlaps(); //!< collect edge.M0 of local k-points into M0batch
+	std::vector<matrix> getRotatedOverlaps() const; //!< dagger(U_i) M0 U_j for all edges of local k-points, with the left rotation of each k-point batched over its edges
 };
 
 //! @}
@@ -99,65 +99,89 @@ void WannierMinimizer::saveMLWF_defect(int iSpin, DefectSupercell& ds)
 	//Compute defect matrix elements in reciprocal space:
 	int nPairsMine = std::max(1, iPairStop-iPairStart); //avoid zero size matrices below
 	matrix HDtilde = zeroes(nCenters*nCenters, nPairsMine);
-	//--- get wavefunctions for each commensurate k (split by ikArr as above):
-	std::vector<ColumnBundle> C(prodSup);
-	std::vector<MPIUtil::Request> requests;
-	for(int ikIndex=0; ikIndex<prodSup; ikIndex++)
-	{	int ik = ikArr[ikIndex];
-		ColumnBundle& Ck = C[ikIndex];
-		if(isMine_q(ik, iSpin))
-		{	Ck = getWfns(kMesh[ik].point, iSpin);
-			int dest = ikArrDiv.whose(ikIndex);
-			if(dest != mpiWorld->iProcess())
-			{	requests.push_back(MPIUtil::Request());
-				mpiWorld->sendData(Ck, dest, ikIndex, &requests.back());
-			}
-		}
-		else if(ikArrDiv.isMine(ikIndex))
-		{	int src = whose_q(ik, iSpin);
-			Ck.init(nBands, basis.nbasis*nSpinor, &basis, &kMesh[ik].point, isGpuEnabled());
-			requests.push_back(MPIUtil::Request());
-			mpiWorld->recvData(Ck, src, ikIndex, &requests.back());
-		}
+	//--- divide commensurate k-points of each process into blocks (to limit wavefunction memory, if requested):
+	int kBlock = ikArrStop - ikArrStart;
+	mpiWorld->allReduce(kBlock, MPIUtil::ReduceMax);
+	int nBlocks = 1;
+	if(wannier.defectKblock and wannier.defectKblock < kBlock)
+	{	nBlocks = (kBlock + wannier.defectKblock - 1) / wannier.defectKblock;
+		kBlock = wannier.defectKblock;
 	}
-	mpiWorld->waitAll(requests);
-	std::vector<DefectSupercell::CachedProjections> proj(prodSup);
-	for(int ikIndex=0; ikIndex<prodSup; ikIndex++)
-		if(ikArrDiv.isMine(ikIndex))
-			ds.project(C[ikIndex], proj[ikIndex]); //cache projections
-		else
-			C[ikIndex] = 0; //clean up un-needed
-	//--- loop over all ikIndex2
-	logPrintf("Computing matrix elements for defect '%s' ...  ", ds.name.c_str()); logFlush(); 
+	logPrintf("Computing matrix elements for defect '%s'", ds.name.c_str());
+	if(nBlocks > 1) logPrintf(" in %d blocks of %d k-points per process", nBlocks, kBlock);
+	logPrintf(" ...  "); logFlush();
 	int nPairsInterval = std::max(1, int(round(nPairsMine/20.))); //interval for reporting progress
 	int nPairsDone = 0;
-	for(int ikIndex2=0; ikIndex2<prodSup; ikIndex2++)
-	{	int ik2 = ikArr[ikIndex2];
-		//Make C2 available on all processes:
-		ColumnBundle C2; DefectSupercell::CachedProjections proj2;
-		if(ikArrDiv.isMine(ikIndex2))
-		{	C2 = C[ikIndex2];
-			proj2 = proj[ikIndex2];
+	for(int iBlock=0; iBlock<nBlocks; iBlock++)
+	{	auto inBlock = [&](int ikIndex) { return (ikIndex - int(ikArrDiv.start(ikArrDiv.whose(ikIndex))))/kBlock == iBlock; };
+		int ikBlockStart = std::min(ikArrStart + iBlock*kBlock, ikArrStop);
+		int ikBlockStop = std::min(ikBlockStart + kBlock, ikArrStop);
+		//--- get wavefunctions for each commensurate k in current block (split by ikArr as above):
+		std::vector<ColumnBundle> C(prodSup);
+		std::vector<MPIUtil::Request> requests;
+		for(int ikIndex=0; ikIndex<prodSup; ikIndex++)
+		{	if(not inBlock(ikIndex)) continue;
+			int ik = ikArr[ikIndex];
+			ColumnBundle& Ck = C[ikIndex];
+			if(isMine_q(ik, iSpin))
+			{	Ck = getWfns(kMesh[ik].point, iSpin);
+				int dest = ikArrDiv.whose(ikIndex);
+				if(dest != mpiWorld->iProcess())
+				{	requests.push_back(MPIUtil::Request());
+					mpiWorld->sendData(Ck, dest, ikIndex, &requests.back());
+				}
+			}
+			else if(ikArrDiv.isMine(ikIndex))
+			{	int src = whose_q(ik, iSpin);
+				Ck.init(nBands, basis.nbasis*nSpinor, &basis, &kMesh[ik].point, isGpuEnabled());
+				requests.push_back(MPIUtil::Request());
+				mpiWorld->recvData(Ck, src, ikIndex, &requests.back());
+			}
 		}
-		else C2.init(nBands, basis.nbasis*nSpinor, &basis, &kMesh[ik2].point, isGpuEnabled());
-		mpiWorld->bcastData(C2, ikArrDiv.whose(ikIndex2));
-		ds.bcast(proj2, ikArrDiv.whose(ikIndex2));
-		//Compute matrix element with all local C1:
-		for(int ikIndex1=ikArrStart; ikIndex1<ikArrStop; ikIndex1++)
-		{	int ik1 = ikArr[ikIndex1];
-			//Compute matrix elements in eigenbasis and apply Wannier rotations:
-			const ColumnBundle& C1 = C[ikIndex1];
-			const DefectSupercell::CachedProjections& proj1 = proj[ikIndex1];
-			matrix HDcur = dagger(kMesh[ik1].U) * ds.compute(C1, C2, proj1, proj2) * kMesh[ik2].U;
-			//Store at appropriate location in global array:
-			int iPairMine = (ikIndex1-ikArrStart)*prodSup + ikIndex2;
-			callPref(eblas_copy)(HDtilde.dataPref() + HDtilde.index(0,iPairMine), HDcur.dataPref(), HDcur.nData());
-			//Print progress:
-			nPairsDone++;
-			if(nPairsDone % nPairsInterval == 0)
-			{	logPrintf("%d%% ", int(round(nPairsDone*100./nPairsMine)));
-				logFlush();
-			};
+		mpiWorld->waitAll(requests);
+		std::vector<DefectSupercell::CachedProjections> proj(prodSup);
+		for(int ikIndex=0; ikIndex<prodSup; ikIndex++)
+			if(ikIndex>=ikBlockStart and ikIndex<ikBlockStop)
+				ds.project(C[ikIndex], proj[ikIndex]); //cache projections
+			else
+				C[ikIndex] = 0; //clean up un-needed
+		//--- loop over all ikIndex2
+		for(int ikIndex2=0; ikIndex2<prodSup; ikIndex2++)
+		{	int ik2 = ikArr[ikIndex2];
+			//Make C2 available on all processes (from the block owner if present, else recomputed by the state owner):
+			bool ik2inBlock = inBlock(ikIndex2);
+			int src = ik2inBlock ? ikArrDiv.whose(ikIndex2) : whose_q(ik2, iSpin);
+			ColumnBundle C2; DefectSupercell::CachedProjections proj2;
+			if(src == mpiWorld->iProcess())
+			{	if(ik2inBlock)
+				{	C2 = C[ikIndex2];
+					proj2 = proj[ikIndex2];
+				}
+				else
+				{	C2 = getWfns(kMesh[ik2].point, iSpin);
+					ds.project(C2, proj2);
+				}
+			}
+			else C2.init(nBands, basis.nbasis*nSpinor, &basis, &kMesh[ik2].point, isGpuEnabled());
+			mpiWorld->bcastData(C2, src);
+			ds.bcast(proj2, src);
+			//Compute matrix element with all local C1 in current block:
+			for(int ikIndex1=ikBlockStart; ikIndex1<ikBlockStop; ikIndex1++)
+			{	int ik1 = ikArr[ikIndex1];
+				//Compute matrix elements in eigenbasis and apply Wannier rotations:
+				const ColumnBundle& C1 = C[ikIndex1];
+				const DefectSupercell::CachedProjections& proj1 = proj[ikIndex1];
+				matrix HDcur = dagger(kMesh[ik1].U) * ds.compute(C1, C2, proj1, proj2) * kMesh[ik2].U;
+				//Store at appropriate location in global array:
+				int iPairMine = (ikIndex1-ikArrStart)*prodSup + ikIndex2;
+				callPref(eblas_copy)(HDtilde.dataPref() + HDtilde.index(0,iPairMine), HDcur.dataPref(), HDcur.nData());
+				//Print progress:
+				nPairsDone++;
+				if(nPairsDone % nPairsInterval == 0)
+				{	logPrintf("%d%% ", int(round(nPairsDone*100./nPairsMine)));
+					logFlush();
+				};
+			}
 		}
 	}
 	logPrintf("done.\n"); logFlush();
@@ -185,14 +209,15 @@ void WannierMinimizer::saveMLWF_defect(int iSpin, DefectSupercell& ds)
 		}
 		//convert phononHsub from Bloch to wannier for each nuclear displacement mode:
 		matrix H = HDtilde * phase;
-		mpiWorld->allReduceData(H, MPIUtil::ReduceSum);
+		mpiWorld->reduceData(H, MPIUtil::ReduceSum); //only needed on head, which writes it
 		//write results for unique cells to file:
+		if(not mpiWorld->isHead()) continue;
 		if(realPartOnly)
-		{	if(mpiWorld->isHead()) H.write_real(fp);
+		{	H.write_real(fp);
 			nrm2totSq += std::pow(nrm2(H), 2); 
 			nrm2imSq += std::pow(callPref(eblas_dnrm2)(H.nData(), ((double*)H.dataPref())+1, 2), 2); //look only at imaginary parts with a stride of 2
 		}
-		else { if(mpiWorld->isHead()) H.write(fp); }
+		else H.write(fp);
 	}
 	if(mpiWorld->isHead()) fclose(fp);
 	if(realPartOnly)
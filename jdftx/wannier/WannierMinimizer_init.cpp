@@ -29,7 +29,7 @@ WannierMinimizer::WannierMinimizer(const Everything& e, const Wannier& wannier,
 	nSpinor(e.eInfo.spinorLength()),
 	rSqExpect(nCenters), rExpect(nCenters), pinned(nCenters, false), rPinned(nCenters),
 	needSuper(needSuperOverride || wannier.saveWfns || wannier.saveWfnsRealSpace || wannier.numericalOrbitalsFilename.length()),
-	nPhononModes(0)
+	nPhononModes(0), transformCache(wannier.transformCacheSize)
 {
 	//Create supercell grid:
 	logPrintf("\n---------- Initializing supercell grid for Wannier functions ----------\n");
@@ -162,7 +162,8 @@ void WannierMinimizer::initTransformDependent()
 		basisSuperWrapper = std::make_shared<ColumnBundleTransform::BasisWrapper>(basisSuper);
 	}
 	
-	//Initialize transforms:
+	//Initialize transforms (unless created on demand within a memory budget):
+	if(wannier.transformCacheSize <= 0.)
 	for(const Kpoint& kpoint: kpoints)
 	{	const Basis& basisC = e.basis[kpoint.iReduced];
 		const vector3<>& kC = e.eInfo.qnums[kpoint.iReduced].k;
@@ -242,8 +243,9 @@ void WannierMinimizer::initTransformDependent()
 		logPrintf("Dividing supercell numerical orbitals to k-points ... "); logFlush();
 		for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,0) || isMine_q(ik,1))
 		{	const KmeshEntry& ki = kMesh[ik];
-			const ColumnBundleTransform& transform = *(transformMap.find(ki.point)->second);
-			const ColumnBundleTransform& transformSuper = *(transformMapSuper.find(ki.point)->second);
+			std::shared_ptr<ColumnBundleTransform> transformPtr = getTransform(ki.point, false), transformSuperPtr = getTransform(ki.point, true);
+			const ColumnBundleTransform& transform = *transformPtr;
+			const ColumnBundleTransform& transformSuper = *transformSuperPtr;
 			//Collect in k-dependent unit-cell basis:
 			const Basis& basisC = e.basis[ki.point.iReduced];
 			ColumnBundle temp(nCols, basisC.nbasis*nSpinor, &basisC, 0, isGpuEnabled());
@@ -301,6 +303,10 @@ void WannierMinimizer::initRotations(int iSpin)
 		logPrintf("done.\n"); logFlush();
 	}
 	
+	//Projections on trial orbitals (if needed):
+	std::vector<matrix> CdagGarr;
+	if(not rotationsLoaded) CdagGarr = getTrialProjections(iSpin);
+	
 	//Compute / check the initial rotations:
 	ostringstream ossErr;
 	for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,iSpin))
@@ -443,7 +449,7 @@ void WannierMinimizer::initRotations(int iSpin)
 		}
 		else
 		{	//Determine from trial orbitals:
-			matrix CdagG = getWfns(ke.point, iSpin) ^ O(trialWfns(ke.point));
+			const matrix& CdagG = CdagGarr[ik];
 			int nNew = nCenters - nFrozen; //number of new centers
 			//--- Pick up best linear combination of remaining bands (if any)
 			if(nFree > 0)
@@ -518,3 +524,41 @@ void WannierMinimizer::initRotations(int iSpin)
 		}
 	}
 }
+
+std::vector<matrix> WannierMinimizer::getTrialProjections(int iSpin)
+{	int nNew = nCenters - nFrozen; //number of trial orbitals
+	std::vector<matrix> CdagG(kMesh.size());
+	string fname = wannier.getFilename(Wannier::FilenameDump, "mlwfA", &iSpin);
+	size_t sizePerK = nBands*nNew * sizeof(complex);
+	bool Aexists = (fileSize(fname.c_str()) == off_t(kMesh.size()*sizePerK));
+	mpiWorld->bcast(Aexists); //Ensure MPI consistency of file check (avoid occassional NFS errors)
+	if(wannier.loadOverlaps && Aexists)
+	{	logPrintf("Reading trial orbital projections from '%s' ... ", fname.c_str()); logFlush();
+		MPIUtil::File fp; mpiWorld->fopenRead(fp, fname.c_str(), kMesh.size()*sizePerK);
+		for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,iSpin))
+		{	CdagG[ik].init(nBands, nNew);
+			mpiWorld->fseek(fp, ik*sizePerK, SEEK_SET);
+			mpiWorld->freadData(CdagG[ik], fp);
+		}
+		mpiWorld->fclose(fp);
+		logPrintf("done.\n"); logFlush();
+		return CdagG;
+	}
+	if(wannier.loadOverlaps)
+		logPrintf("NOTE: no compatible trial orbital projections in '%s'; recomputing.\n", fname.c_str());
+	
+	//Compute:
+	for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,iSpin))
+		CdagG[ik] = getWfns(kMesh[ik].point, iSpin) ^ O(trialWfns(kMesh[ik].point));
+	
+	//Dump for subsequent runs (each process writes its own k-points):
+	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+	MPIUtil::File fp; mpiWorld->fopenWrite(fp, fname.c_str());
+	for(size_t ik=0; ik<kMesh.size(); ik++) if(isMine_q(ik,iSpin))
+	{	mpiWorld->fseek(fp, ik*sizePerK, SEEK_SET);
+		mpiWorld->fwriteData(CdagG[ik], fp);
+	}
+	mpiWorld->fclose(fp);
+	logPrintf("done.\n"); logFlush();
+	return CdagG;
+}
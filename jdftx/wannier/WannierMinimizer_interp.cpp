@@ -0,0 +1,144 @@
+/*-------------------------------------------------------------------
+Copyright 2026 Ravishankar Sundararaman
+
+This file is part of JDFTx.
+
+JDFTx is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+JDFTx is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with JDFTx.  If not, see <http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------*/
+
+#include <wannier/WannierMinimizer.h>
+#include <core/BlasExtra.h>
+#include <climits>
+
+//Diagonalize interpolated H(k) for k-points jkStart to jkStop of a batch (columns of HkBatch, followed by its cartesian gradients),
+//and compute the band velocities from the gradients using the corresponding eigenvectors:
+void diagonalizeHk_thread(size_t jkStart, size_t jkStop, int nCenters, const matrix* HkBatch, diagMatrix* E, std::vector<vector3<>>* v)
+{	int nCentersSq = nCenters*nCenters;
+	for(size_t jk=jkStart; jk<jkStop; jk++)
+	{	const complex* HkData = HkBatch->data() + HkBatch->index(0,jk);
+		matrix Hk(nCenters, nCenters), U;
+		eblas_copy(Hk.data(), HkData, nCentersSq);
+		Hk.diagonalize(U, E[jk]);
+		v[jk].assign(nCenters, vector3<>());
+		for(int iDir=0; iDir<3; iDir++)
+		{	matrix dHk(nCenters, nCenters);
+			eblas_copy(dHk.data(), HkData+(iDir+1)*nCentersSq, nCentersSq);
+			diagMatrix vDir = diagDot(U, dHk * U);
+			for(int n=0; n<nCenters; n++)
+				v[jk][n][iDir] = vDir[n];
+		}
+	}
+}
+
+//Wannier-interpolated density of states and band velocities on a dense k-mesh:
+void WannierMinimizer::saveMLWF_DOS(int iSpin, const matrix& HwannierTilde, const matrix& phase)
+{	const vector3<int>& N = wannier.dosMesh;
+	const double dE = wannier.dosBinWidth;
+	size_t nkTot = size_t(N[0]) * N[1] * N[2];
+	logPrintf("Interpolating DOS on "); N.print(globalLog, " %d ");
+	logFlush();
+
+	//Wannierize Hamiltonian on all processes:
+	matrix Hunique = HwannierTilde * phase;
+	mpiWorld->allReduceData(Hunique, MPIUtil::ReduceSum);
+
+	//Collect H(R) with cell weights, and its cartesian k-gradient i R H(R), for each cell in iCellMap:
+	int nCentersSq = nCenters*nCenters;
+	int nCells = iCellMap.size();
+	vector3<int> kfold = e.eInfo.kFoldingCount();
+	vector3<int> stride(kfold[1]*kfold[2], kfold[2], 1); //unique cell order (as in saveMLWF)
+	std::vector<vector3<int>> iRarr; iRarr.reserve(nCells);
+	matrix HR = zeroes(4*nCentersSq, nCells);
+	{	const complex* HuniqueData = Hunique.data();
+		complex* HRdata = HR.data();
+		for(const auto& entry: iCellMap)
+		{	vector3<int> iR = entry.first, iRunique;
+			for(int iDir=0; iDir<3; iDir++)
+				iRunique[iDir] = positiveRemainder(iR[iDir], kfold[iDir]);
+			const complex* Hsrc = HuniqueData + Hunique.index(0, dot(iRunique,stride));
+			const complex* w = entry.second.data();
+			complex* Hdest = HRdata + HR.index(0, iRarr.size());
+			vector3<> Rcart = e.gInfo.R * iR;
+			for(int i=0; i<nCentersSq; i++)
+			{	complex Hi = Hsrc[i] * w[i].real();
+				Hdest[i] = Hi;
+				for(int iDir=0; iDir<3; iDir++)
+					Hdest[(iDir+1)*nCentersSq+i] = complex(0., Rcart[iDir]) * Hi;
+			}
+			iRarr.push_back(iR);
+		}
+	}
+
+	//Loop over dense k-mesh (split over processes) in batches:
+	size_t ikDenseStart, ikDenseStop;
+	TaskDivision(nkTot, mpiWorld).myRange(ikDenseStart, ikDenseStop);
+	const size_t nkBatchMax = 256; //limits phase and H(k) memory to a few multiples of HR
+	std::map<int, std::array<double,4>> histMine; //DOS and DOS-weighted v^2 per direction by energy bin (locally collected)
+	for(size_t ikBatchStart=ikDenseStart; ikBatchStart<ikDenseStop; ikBatchStart+=nkBatchMax)
+	{	int nk = std::min(nkBatchMax, ikDenseStop-ikBatchStart);
+		//Fourier sum for entire batch as a single matrix multiply (cells x k-points phase):
+		matrix phaseK(nCells, nk);
+		complex* phaseKdata = phaseK.data();
+		for(int jk=0; jk<nk; jk++)
+		{	size_t ik = ikBatchStart + jk;
+			vector3<> k(
+				double(ik / (N[1]*N[2])) / N[0],
+				double((ik / N[2]) % N[1]) / N[1],
+				double(ik % N[2]) / N[2] );
+			for(int iCell=0; iCell<nCells; iCell++)
+				phaseKdata[phaseK.index(iCell,jk)] = cis(2*M_PI*dot(k, iRarr[iCell]));
+		}
+		matrix HkBatch = HR * phaseK;
+		//Diagonalize (threaded over k-points within batch):
+		std::vector<diagMatrix> E(nk);
+		std::vector<std::vector<vector3<>>> v(nk);
+		threadLaunch(isGpuEnabled() ? 1 : 0, diagonalizeHk_thread, nk, nCenters, &HkBatch, E.data(), v.data());
+		//Histogram:
+		for(int jk=0; jk<nk; jk++)
+			for(int n=0; n<nCenters; n++)
+			{	std::array<double,4>& h = histMine[int(floor(E[jk][n]/dE))];
+				h[0] += 1.;
+				for(int iDir=0; iDir<3; iDir++)
+					h[iDir+1] += std::pow(v[jk][n][iDir], 2);
+			}
+	}
+
+	//Collect histogram over processes:
+	int iBinMin = histMine.size() ? histMine.begin()->first : INT_MAX;
+	int iBinMax = histMine.size() ? histMine.rbegin()->first : INT_MIN;
+	mpiWorld->allReduce(iBinMin, MPIUtil::ReduceMin);
+	mpiWorld->allReduce(iBinMax, MPIUtil::ReduceMax);
+	int nBins = iBinMax + 1 - iBinMin;
+	std::vector<double> hist(4*nBins);
+	double histScale = e.eInfo.spinWeight / (nkTot * dE); //states per unit energy per unit cell
+	for(const auto& entry: histMine)
+		for(int j=0; j<4; j++)
+			hist[4*(entry.first-iBinMin)+j] = histScale * entry.second[j];
+	mpiWorld->reduceData(hist, MPIUtil::ReduceSum);
+
+	//Write:
+	string fname = wannier.getFilename(Wannier::FilenameDump, "mlwfDOS", &iSpin);
+	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+	if(mpiWorld->isHead())
+	{	FILE* fp = fopen(fname.c_str(), "w");
+		if(!fp) die_alone("could not open file for writing.\n");
+		fprintf(fp, "#Energy[Eh] DOS[1/Eh/unit-cell] DOS*vx^2 DOS*vy^2 DOS*vz^2 [atomic units]\n");
+		for(int iBin=0; iBin<nBins; iBin++)
+		{	const double* h = hist.data() + 4*iBin;
+			fprintf(fp, "%.15le %.15le %.15le %.15le %.15le\n", (iBinMin+iBin+0.5)*dE, h[0], h[1], h[2], h[3]);
+		}
+		fclose(fp);
+	}
+	logPrintf("done.\n"); logFlush();
+}
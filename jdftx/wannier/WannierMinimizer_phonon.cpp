@@ -174,19 +174,34 @@ void WannierMinimizer::saveMLWF_phonon(int iSpin)
 	logPrintf("done.\n"); logFlush();
 	
 	//Wannierize and output one cell fixed at a time to minimize memory usage:
-	string fname = wannier.getFilename(Wannier::FilenameDump, "mlwfHePh", &iSpin);
-	logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
-	FILE* fp = 0;
-	if(mpiWorld->isHead())
-	{	fp = fopen(fname.c_str(), "wb");
-		if(!fp) die_alone("Error opening %s for writing.\n", fname.c_str());
+	//--- each cell1 is reduced onto one process, which writes its blocks and collects its sum rule contributions
+	bool sparse = wannier.blockThreshold;
+	int nDataPerCell = nPhononModes*nCenters*nCenters;
+	size_t blockBytes = nDataPerCell * (realPartOnly ? sizeof(double) : sizeof(complex));
+	MPIUtil::File fp;
+	FILE* fpSparse = 0, *fpIndex = 0;
+	if(sparse) openSparseBlocks("mlwfHePh", iSpin, prodPhononSup*prodPhononSup, nDataPerCell, fpSparse, fpIndex); //written in order by head
+	else
+	{	string fname = wannier.getFilename(Wannier::FilenameDump, "mlwfHePh", &iSpin);
+		logPrintf("Dumping '%s' ... ", fname.c_str()); logFlush();
+		mpiWorld->fopenWrite(fp, fname.c_str());
 	}
+	//--- initialize sum rule for all cell differences (identical on all processes for the final reduction):
+	std::map<vector3<int>, matrix> Hsum;
+	for(const UniqueCell& cell1: uniqueCells)
+		for(const UniqueCell& cell2: uniqueCells)
+			for(const auto& entry1: cell1.cells)
+				for(const auto& entry2: cell2.cells)
+				{	matrix& HsumCur = Hsum[entry2.first - entry1.first];
+					if(not HsumCur) HsumCur = zeroes(nCenters*nCenters, 3);
+				}
+	size_t nKept = 0;
 	matrix phase = zeroes(HePhTilde.nCols(), prodPhononSup);
 	double kPairWeight = 1./prodPhononSup;
 	double nrm2totSq = 0., nrm2imSq = 0.;
-	std::map<vector3<int>, matrix> Hsum;
-	for(const UniqueCell& cell1: uniqueCells)
-	{	//calculate Fourier transform phase (with integration weights):
+	for(int iCell1=0; iCell1<prodPhononSup; iCell1++)
+	{	const UniqueCell& cell1 = uniqueCells[iCell1];
+		//calculate Fourier transform phase (with integration weights):
 		for(int iPair=iPairStart; iPair<iPairStop; iPair++)
 		{	const KpointPair& pair = kpointPairs[iPair];
 			int iCell2 = 0;
@@ -196,17 +211,30 @@ void WannierMinimizer::saveMLWF_phonon(int iSpin)
 		}
 		//convert phononHsub from Bloch to wannier for each nuclear displacement mode:
 		matrix H = HePhTilde * phase;
-		mpiWorld->allReduceData(H, MPIUtil::ReduceSum);
+		int iProcCell = sparse ? 0 : (iCell1 % mpiWorld->nProcesses()); //sparse output must be written sequentially
+		mpiWorld->reduceData(H, MPIUtil::ReduceSum, iProcCell);
+		if(mpiWorld->iProcess() != iProcCell) continue;
 		//write results for unique cells to file:
 		if(realPartOnly)
-		{	if(mpiWorld->isHead()) H.write_real(fp);
-			nrm2totSq += std::pow(nrm2(H), 2); 
+		{	nrm2totSq += std::pow(nrm2(H), 2); 
 			nrm2imSq += std::pow(callPref(eblas_dnrm2)(H.nData(), ((double*)H.dataPref())+1, 2), 2); //look only at imaginary parts with a stride of 2
 		}
-		else { if(mpiWorld->isHead()) H.write(fp); }
+		if(sparse)
+		{	ostringstream indexPrefix; indexPrefix << iCell1 << ' ';
+			nKept += writeSparseBlocks(H, realPartOnly, fpSparse, fpIndex, indexPrefix.str(), 0);
+		}
+		else
+		{	mpiWorld->fseek(fp, long(iCell1) * prodPhononSup * blockBytes, SEEK_SET);
+			if(realPartOnly)
+			{	std::vector<double> Hreal(H.nData());
+				const complex* Hdata = H.data();
+				for(size_t i=0; i<Hreal.size(); i++) Hreal[i] = Hdata[i].real();
+				mpiWorld->fwriteData(Hreal, fp);
+			}
+			else mpiWorld->fwriteData(H, fp);
+		}
 		//collect sum rule, accounting for cell map and weights:
 		const complex* Hdata = H.dataPref();
-		int nDataPerCell = nPhononModes*nCenters*nCenters;
 		for(const UniqueCell& cell2: uniqueCells)
 		{	for(const auto& entry1: cell1.cells)
 			{	for(const auto& entry2: cell2.cells)
@@ -214,9 +242,7 @@ void WannierMinimizer::saveMLWF_phonon(int iSpin)
 					std::vector<complex> HcopyVec(Hdata, Hdata+nDataPerCell);
 					complex* Hcopy = HcopyVec.data();
 					//prepare for sum rule collection:
-					vector3<int> iRdiff = entry2.first - entry1.first;
-					matrix& HsumCur = Hsum[iRdiff];
-					if(not HsumCur) HsumCur = zeroes(nCenters*nCenters, 3);
+					matrix& HsumCur = Hsum[entry2.first - entry1.first];
 					//Loop over atoms and directions:
 					int iMode = 0;
 					for(size_t iAtom=0; iAtom<xAtoms.size(); iAtom++)
@@ -237,11 +263,26 @@ void WannierMinimizer::saveMLWF_phonon(int iSpin)
 			Hdata += nDataPerCell;
 		}
 	}
-	if(mpiWorld->isHead()) fclose(fp);
+	if(sparse)
+	{	if(mpiWorld->isHead())
+		{	fclose(fpSparse);
+			fclose(fpIndex);
+		}
+	}
+	else mpiWorld->fclose(fp);
+	logPrintf("done.");
+	if(sparse)
+	{	mpiWorld->bcast(nKept);
+		logPrintf(" Retained %lu of %d cell pairs.", nKept, prodPhononSup*prodPhononSup);
+	}
 	if(realPartOnly)
-		logPrintf("done. Relative discarded imaginary part: %le\n", sqrt(nrm2imSq / nrm2totSq));
-	else
-		logPrintf("done.\n");
+	{	mpiWorld->allReduce(nrm2totSq, MPIUtil::ReduceSum);
+		mpiWorld->allReduce(nrm2imSq, MPIUtil::ReduceSum);
+		logPrintf(" Relative discarded imaginary part: %le", sqrt(nrm2imSq / nrm2totSq));
+	}
+	logPrintf("\n");
+	for(auto& entry: Hsum)
+		mpiWorld->reduceData(entry.second, MPIUtil::ReduceSum);
 	
 	//Write sum rule matrices and cell map:
 	if(mpiWorld->isHead())
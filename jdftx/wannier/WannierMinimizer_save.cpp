@@ -237,32 +237,46 @@ void WannierMinimizer::saveMLWF_C(int iSpin)
 		logPrintf("done.\n"); logFlush();
 	}
 	
-	//Save supercell wavefunctions in real space:
-	if(mpiWorld->isHead() && wannier.saveWfnsRealSpace) for(int n=0; n<nCenters; n++) for(int s=0; s<nSpinor; s++)
-	{	//Generate filename
-		ostringstream varName;
-		varName << (nSpinor*n+s) << ".mlwf";
-		string fname = wannier.getFilename(Wannier::FilenameDump, varName.str(), &iSpin);
-		logPrintf("Dumping '%s':\n", fname.c_str());
-		//Convert to real space and optionally remove phase:
-		complexScalarField psi = I(Csuper.getColumn(n,s));
-		if(qnumSuper.k.length_squared() > symmThresholdSq)
-			multiplyBlochPhase(psi, qnumSuper.k);
-		if(realPartOnly)
-		{	complex* psiData = psi->data();
-			double meanPhase, sigmaPhase, rmsImagErr;
-			removePhase(gInfoSuper.nr, psiData, meanPhase, sigmaPhase, rmsImagErr);
-			logPrintf("\tPhase = %lf +/- %lf\n", meanPhase, sigmaPhase); logFlush();
-			logPrintf("\tRMS imaginary part = %le (after phase removal)\n", rmsImagErr);
-			logFlush();
-			//Write real part of supercell wavefunction to file:
-			FILE* fp = fopen(fname.c_str(), "wb");
-			if(!fp) die("Failed to open file '%s' for binary write.\n", fname.c_str());
-			for(int i=0; i<gInfoSuper.nr; i++)
-				fwriteLE(psiData+i, sizeof(double), 1, fp);
-			fclose(fp);
+	//Save supercell wavefunctions in real space (columns distributed over processes, since all have Csuper):
+	if(wannier.saveWfnsRealSpace)
+	{	int nColumns = nCenters*nSpinor;
+		std::vector<string> fnames(nColumns);
+		std::vector<double> meanPhase(nColumns), sigmaPhase(nColumns), rmsImagErr(nColumns); //phase statistics (if realPartOnly)
+		for(int n=0; n<nCenters; n++) for(int s=0; s<nSpinor; s++)
+		{	int iColumn = nSpinor*n+s;
+			//Generate filename
+			ostringstream varName;
+			varName << iColumn << ".mlwf";
+			fnames[iColumn] = wannier.getFilename(Wannier::FilenameDump, varName.str(), &iSpin);
+			if(iColumn % mpiWorld->nProcesses() != mpiWorld->iProcess()) continue; //handled by another process
+			//Convert to real space and optionally remove phase:
+			complexScalarField psi = I(Csuper.getColumn(n,s));
+			if(qnumSuper.k.length_squared() > symmThresholdSq)
+				multiplyBlochPhase(psi, qnumSuper.k);
+			if(realPartOnly)
+			{	complex* psiData = psi->data();
+				removePhase(gInfoSuper.nr, psiData, meanPhase[iColumn], sigmaPhase[iColumn], rmsImagErr[iColumn]);
+				//Write real part of supercell wavefunction to file:
+				FILE* fp = fopen(fnames[iColumn].c_str(), "wb");
+				if(!fp) die_alone("Failed to open file '%s' for binary write.\n", fnames[iColumn].c_str());
+				for(int i=0; i<gInfoSuper.nr; i++)
+					fwriteLE(psiData+i, sizeof(double), 1, fp);
+				fclose(fp);
+			}
+			else saveRawBinary(psi, fnames[iColumn].c_str());
+		}
+		//Report in order from head:
+		mpiWorld->allReduceData(meanPhase, MPIUtil::ReduceSum);
+		mpiWorld->allReduceData(sigmaPhase, MPIUtil::ReduceSum);
+		mpiWorld->allReduceData(rmsImagErr, MPIUtil::ReduceSum);
+		for(int iColumn=0; iColumn<nColumns; iColumn++)
+		{	logPrintf("Dumped '%s'", fnames[iColumn].c_str());
+			if(realPartOnly)
+				logPrintf(": phase = %lf +/- %lf, RMS imaginary part = %le (after phase removal)",
+					meanPhase[iColumn], sigmaPhase[iColumn], rmsImagErr[iColumn]);
+			logPrintf("\n");
 		}
-		else saveRawBinary(psi, fname.c_str());
+		logFlush();
 	}
 	
 	suspendOperatorThreading();
@@ -281,6 +295,10 @@ void WannierMinimizer::saveMLWF_H(int iSpin, const matrix& phase)
 	}
 	//Fourier transform to Wannier space and save
 	dumpWannierized(HwannierTilde, phase, "mlwfH", realPartOnly, iSpin);
+	if(wannier.sparseThreshold)
+		dumpWannierizedSparse(HwannierTilde, phase, "mlwfHsparse", wannier.sparseThreshold, iSpin);
+	if(wannier.dosMesh.length_squared())
+		saveMLWF_DOS(iSpin, HwannierTilde, phase);
 }
 
 
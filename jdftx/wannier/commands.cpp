@@ -32,14 +32,21 @@ enum WannierMember
 	WM_saveWfnsRealSpace,
 	WM_saveMomenta,
 	WM_saveSpin,
+	WM_saveSparseH,
+	WM_saveSparseBlocks,
+	WM_saveDOS,
 	WM_saveZ,
 	WM_slabWeight,
 	WM_loadRotations,
+	WM_loadOverlaps,
+	WM_symmetricOverlaps,
 	WM_eigsOverride,
 	WM_numericalOrbitals,
 	WM_numericalOrbitalsOffset,
 	WM_phononSup,
 	WM_rSmooth,
+	WM_defectKblock,
+	WM_transformCacheSize,
 	WM_spinMode,
 	WM_polar,
 	WM_delim
@@ -56,14 +63,21 @@ EnumStringMap<WannierMember> wannierMemberMap
 	WM_saveWfnsRealSpace, "saveWfnsRealSpace",
 	WM_saveMomenta, "saveMomenta",
 	WM_saveSpin, "saveSpin",
+	WM_saveSparseH, "saveSparseH",
+	WM_saveSparseBlocks, "saveSparseBlocks",
+	WM_saveDOS, "saveDOS",
 	WM_saveZ, "saveZ",
 	WM_slabWeight, "slabWeight",
 	WM_loadRotations, "loadRotations",
+	WM_loadOverlaps, "loadOverlaps",
+	WM_symmetricOverlaps, "symmetricOverlaps",
 	WM_eigsOverride, "eigsOverride",
 	WM_numericalOrbitals, "numericalOrbitals",
 	WM_numericalOrbitalsOffset, "numericalOrbitalsOffset",
 	WM_phononSup, "phononSupercell",
 	WM_rSmooth, "rSmooth",
+	WM_defectKblock, "defectKblock",
+	WM_transformCacheSize, "transformCacheSize",
 	WM_spinMode, "spinMode",
 	WM_polar, "polar"
 );
@@ -124,6 +138,7 @@ struct CommandWannier : public Command
 			"   Default: no.\n"
 			"\n+ saveWfnsRealSpace yes|no\n\n"
 			"   Whether to write supercell wavefunctions band-by-band in real space (can be enormous).\n"
+			"   The files are transformed and written concurrently, distributed over processes.\n"
 			"   Default: no.\n"
 			"\n+ saveMomenta yes|no\n\n"
 			"   Whether to write momentum matrix elements in the same format as Hamiltonian.\n"
@@ -132,6 +147,37 @@ struct CommandWannier : public Command
 			"\n+ saveSpin yes|no\n\n"
 			"   Whether to write spin matrix elements (for non-collinear calculations only).\n"
 			"   Default: no.\n"
+			"\n+ saveSparseH <threshold>\n\n"
+			"   If specified, additionally write the Wannier Hamiltonian truncated to elements\n"
+			"   with magnitude above <threshold> (in Hartrees) as a sparse text file (mlwfHsparse),\n"
+			"   with one line per retained element containing the cell index (in the order of\n"
+			"   mlwfCellMap), the pair of center indices and the real and imaginary parts.\n"
+			"   The fill fraction of the truncated matrix is reported, as an estimate of the\n"
+			"   sparsity available to localized-orbital (linear-scaling) methods for this system.\n"
+			"   Default: none.\n"
+			"\n+ saveSparseBlocks <threshold>\n\n"
+			"   If specified, write all Wannierized matrices (mlwfH, mlwfP, mlwfS, mlwfD, mlwfHePh etc.)\n"
+			"   block-sparse instead of dense, retaining only the cells (or cell pairs for mlwfHePh)\n"
+			"   whose matrix contains an element of magnitude above <threshold> (real part alone for\n"
+			"   outputs that are written real). Each <var> is then replaced by binary <var>Blocks,\n"
+			"   containing the retained blocks exactly as in the dense file (same per-block layout\n"
+			"   and precision), and text <var>BlockIndex, containing after its comment lines the total\n"
+			"   number of blocks and the number of elements per block, followed by one line per\n"
+			"   retained block in file order with its index in the dense file: the cell index in\n"
+			"   mlwfCellMap order, or the pair of unique cell indices in mlwfCellMapSqPh order for\n"
+			"   mlwfHePh. A reader can therefore seek directly to block n at offset n*blockSize\n"
+			"   (times 8 bytes when real or 16 bytes when complex). Sum-rule and cell-map outputs\n"
+			"   remain dense. Default: none (dense output).\n"
+			"\n+ saveDOS <N0> <N1> <N2> <dE>\n\n"
+			"   If specified, Wannier-interpolate the Hamiltonian onto a uniform <N0> x <N1> x <N2>\n"
+			"   k-mesh (Gamma-centered, typically much denser than the DFT k-mesh) and write the\n"
+			"   density of states histogrammed in energy bins of width <dE> (in Hartrees) to mlwfDOS.\n"
+			"   Each line contains the bin-center energy, the DOS per unit cell, and the DOS weighted\n"
+			"   by the square of each cartesian component of the band velocity dE/dk, from which\n"
+			"   Fermi velocities and transport DOS may be obtained without a dense-mesh DFT run.\n"
+			"   The Fourier sums over mlwfCellMap are batched over k-points into matrix products\n"
+			"   (on the GPU when available) and the diagonalizations are threaded over k-points.\n"
+			"   Default: none.\n"
 			"\n+ saveZ <Vfilename> <Emag>\n\n"
 			"   If specified, output matrix elements of z for perturbative electric field in post processing.\n"
 			"   <Vfilename> is Vscloc output from a calculation with an applied electric field, and it\n"
@@ -148,6 +194,22 @@ struct CommandWannier : public Command
 			"\n+ loadRotations yes|no\n\n"
 			"   Whether to load rotations (.mlwU) from a previous %Wannier run.\n"
 			"   Default: no.\n"
+			"\n+ loadOverlaps yes|no\n\n"
+			"   Whether to reuse the k-point overlap matrices (mlwfM0, for the FiniteDifference\n"
+			"   localization measure) and trial orbital projections (mlwfA) dumped by a previous\n"
+			"   %Wannier run on the same jdftx state, analogous to Wannier90's .mmn and .amn files.\n"
+			"   Files of incompatible size (eg. different number of bands or centers) are recomputed.\n"
+			"   This skips the wavefunction overlap pass for reruns that change only windows,\n"
+			"   localization settings or saved outputs; disable it when changing trial orbitals.\n"
+			"   Default: no (mlwfM0 is also reused when loadRotations is set).\n"
+			"\n+ symmetricOverlaps yes|no\n\n"
+			"   Whether to compute the k-point overlap matrices (FiniteDifference localization measure)\n"
+			"   only for symmetry-inequivalent pairs of k-points, and reconstruct the rest using the\n"
+			"   representations of the symmetry operations in the space of bands at the reduced k-points.\n"
+			"   Pairs involving k-points where the bands do not span a closed subspace (eg. when the last\n"
+			"   band splits a degenerate multiplet) are still computed directly, so choose nBands to end\n"
+			"   at a gap for best results. Currently limited to norm-conserving pseudopotentials without\n"
+			"   spinorial wavefunctions (ignored otherwise). Default: no.\n"
 			"\n+ eigsOverride <filename>\n\n"
 			"   Optionally read an alternate eigenvalues file to over-ride those from the total\n"
 			"   energy calculation. Useful for generating Wannier Hamiltonians using eigenvalues\n"
@@ -170,6 +232,17 @@ struct CommandWannier : public Command
 			"   Width in bohrs of the supercell boundary region over which matrix elements are smoothed.\n"
 			"   If phononSupercell is specified to process phonon quantities, the rSmooth specified here\n"
 			"   must exactly match the value specified in the calculation in command phonon.\n"
+			"\n+ defectKblock <nK>\n\n"
+			"   If specified, stream defect matrix elements (see command defect-supercell) over blocks\n"
+			"   of at most <nK> commensurate k-points per process, holding only the wavefunctions and\n"
+			"   projections of the current block instead of all the k-points of each process.\n"
+			"   This reduces memory for large defect supercells, at the cost of re-distributing\n"
+			"   the second k-point of each pair once per block. Default: all k-points at once.\n"
+			"\n+ transformCacheSize <MB>\n\n"
+			"   If specified, create the wavefunction transforms from the reduced k-points to the\n"
+			"   full k-mesh on demand, and cache at most <MB> megabytes of them per process (evicting\n"
+			"   the least recently used first), instead of pre-computing transforms for all k-points.\n"
+			"   Default: pre-compute all transforms.\n"
 			"\n+ spinMode" + spinModeMap.optionList() + "\n\n"
 			"   If Up or Dn, only generate Wannier functions for that spin channel, allowing\n"
 			"   different input files for each channel (independent centers, windows etc.).\n"
@@ -228,6 +301,23 @@ struct CommandWannier : public Command
 					if(wannier.saveSpin and not e.eInfo.isNoncollinear())
 						throw string("saveSpin requires noncollinear spin mode");
 					break;
+				case WM_saveSparseH:
+					pl.get(wannier.sparseThreshold, 0., "threshold", true);
+					if(wannier.sparseThreshold <= 0.) throw string("<threshold> must be positive");
+					break;
+				case WM_saveSparseBlocks:
+					pl.get(wannier.blockThreshold, 0., "threshold", true);
+					if(wannier.blockThreshold <= 0.) throw string("<threshold> must be positive");
+					break;
+				case WM_saveDOS:
+					pl.get(wannier.dosMesh[0], 0, "N0", true);
+					pl.get(wannier.dosMesh[1], 0, "N1", true);
+					pl.get(wannier.dosMesh[2], 0, "N2", true);
+					pl.get(wannier.dosBinWidth, 0., "dE", true);
+					for(int iDir=0; iDir<3; iDir++)
+						if(wannier.dosMesh[iDir] <= 0) throw string("<N0>, <N1> and <N2> must be positive");
+					if(wannier.dosBinWidth <= 0.) throw string("<dE> must be positive");
+					break;
 				case WM_saveZ:
 					pl.get(wannier.zVfilename, string(), "Vfilename", true);
 					pl.get(wannier.zFieldMag, 0., "Emag", true);
@@ -250,6 +340,12 @@ struct CommandWannier : public Command
 				case WM_loadRotations:
 					pl.get(wannier.loadRotations, false, boolMap, "loadRotations", true);
 					break;
+				case WM_loadOverlaps:
+					pl.get(wannier.loadOverlaps, false, boolMap, "loadOverlaps", true);
+					break;
+				case WM_symmetricOverlaps:
+					pl.get(wannier.symmetricOverlaps, false, boolMap, "symmetricOverlaps", true);
+					break;
 				case WM_eigsOverride:
 					pl.get(wannier.eigsFilename, string(), "filename", true);
 					break;
@@ -270,6 +366,14 @@ struct CommandWannier : public Command
 					pl.get(wannier.rSmooth, 1., "rSmooth", true);
 					if(wannier.rSmooth <= 0.) throw string("<rSmooth> must be positive");
 					break;
+				case WM_defectKblock:
+					pl.get(wannier.defectKblock, 0, "nK", true);
+					if(wannier.defectKblock <= 0) throw string("<nK> must be positive");
+					break;
+				case WM_transformCacheSize:
+					pl.get(wannier.transformCacheSize, 0., "MB", true);
+					if(wannier.transformCacheSize <= 0.) throw string("<MB> must be positive");
+					break;
 				case WM_spinMode:
 					pl.get(wannier.spinMode, Wannier::SpinAll,  spinModeMap, "spinMode", true);
 					if(e.eInfo.spinType!=SpinZ && wannier.spinMode!=Wannier::SpinAll)
@@ -292,11 +396,19 @@ struct CommandWannier : public Command
 		logPrintf(" \\\n\tsaveWfnsRealSpace %s", boolMap.getString(wannier.saveWfnsRealSpace));
 		logPrintf(" \\\n\tsaveMomenta %s", boolMap.getString(wannier.saveMomenta));
 		logPrintf(" \\\n\tsaveSpin %s", boolMap.getString(wannier.saveSpin));
+		if(wannier.sparseThreshold)
+			logPrintf(" \\\n\tsaveSparseH %lg", wannier.sparseThreshold);
+		if(wannier.blockThreshold)
+			logPrintf(" \\\n\tsaveSparseBlocks %lg", wannier.blockThreshold);
+		if(wannier.dosMesh.length_squared())
+			logPrintf(" \\\n\tsaveDOS %d %d %d %lg", wannier.dosMesh[0], wannier.dosMesh[1], wannier.dosMesh[2], wannier.dosBinWidth);
 		if(wannier.zVfilename.length())
 			logPrintf(" \\\n\tsaveZ %s %lg", wannier.zVfilename.c_str(), wannier.zFieldMag);
 		if(wannier.zH)
 			logPrintf(" \\\n\tslabWeight %lg %lg %lg", wannier.z0, wannier.zH, wannier.zSigma);
 		logPrintf(" \\\n\tloadRotations %s", boolMap.getString(wannier.loadRotations));
+		logPrintf(" \\\n\tloadOverlaps %s", boolMap.getString(wannier.loadOverlaps));
+		logPrintf(" \\\n\tsymmetricOverlaps %s", boolMap.getString(wannier.symmetricOverlaps));
 		if(wannier.eigsFilename.length())
 			logPrintf(" \\\n\teigsFilename %s", wannier.eigsFilename.c_str());
 		if(wannier.outerWindow)
@@ -317,6 +429,10 @@ struct CommandWannier : public Command
 		if(wannier.phononSup.length_squared())
 			logPrintf(" \\\n\tphononSupercell %d %d %d", wannier.phononSup[0], wannier.phononSup[1], wannier.phononSup[2]);
 		logPrintf(" \\\n\trSmooth %lg", wannier.rSmooth);
+		if(wannier.defectKblock)
+			logPrintf(" \\\n\tdefectKblock %d", wannier.defectKblock);
+		if(wannier.transformCacheSize)
+			logPrintf(" \\\n\ttransformCacheSize %lg", wannier.transformCacheSize);
 		logPrintf(" \\\n\tspinMode %s", spinModeMap.getString(wannier.spinMode));
 		logPrintf(" \\\n\tpolar %s", boolMap.getString(wannier.polar));
 	}